@@ -31,6 +31,7 @@ optional<Action> fromString(string const& name)
         mapAction<actions::CancelSelection>("CancelSelection"),
         mapAction<actions::ChangeProfile>("ChangeProfile"),
         mapAction<actions::ClearHistoryAndReset>("ClearHistoryAndReset"),
+        mapAction<actions::CopyCommandOutput>("CopyCommandOutput"),
         mapAction<actions::CopyPreviousMarkRange>("CopyPreviousMarkRange"),
         mapAction<actions::CopySelection>("CopySelection"),
         mapAction<actions::CreateDebugDump>("CreateDebugDump"),
@@ -71,6 +72,7 @@ optional<Action> fromString(string const& name)
         mapAction<actions::ToggleAllKeyMaps>("ToggleAllKeyMaps"),
         mapAction<actions::ToggleFullscreen>("ToggleFullscreen"),
         mapAction<actions::ToggleInputProtection>("ToggleInputProtection"),
+        mapAction<actions::TogglePerformanceHud>("TogglePerformanceHud"),
         mapAction<actions::ToggleStatusLine>("ToggleStatusLine"),
         mapAction<actions::ToggleTitleBar>("ToggleTitleBar"),
         mapAction<actions::TraceBreakAtEmptyQueue>("TraceBreakAtEmptyQueue"),
@@ -31,6 +31,7 @@ enum class CopyFormat : uint8_t
 struct CancelSelection{};
 struct ChangeProfile{ std::string name; };
 struct ClearHistoryAndReset{};
+struct CopyCommandOutput{};
 struct CopyPreviousMarkRange{};
 struct CopySelection{ CopyFormat format = CopyFormat::Text; };
 struct CreateDebugDump{};
@@ -71,6 +72,7 @@ struct SendChars{ std::string chars; };
 struct ToggleAllKeyMaps{};
 struct ToggleFullscreen{};
 struct ToggleInputProtection{};
+struct TogglePerformanceHud{};
 struct ToggleStatusLine{};
 struct ToggleTitleBar{};
 struct TraceBreakAtEmptyQueue{};
@@ -90,6 +92,7 @@ struct SwitchToTabRight{};
 using Action = std::variant<CancelSelection,
                             ChangeProfile,
                             ClearHistoryAndReset,
+                            CopyCommandOutput,
                             CopyPreviousMarkRange,
                             CopySelection,
                             CreateDebugDump,
@@ -130,6 +133,7 @@ using Action = std::variant<CancelSelection,
                             ToggleAllKeyMaps,
                             ToggleFullscreen,
                             ToggleInputProtection,
+                            TogglePerformanceHud,
                             ToggleStatusLine,
                             ToggleTitleBar,
                             TraceBreakAtEmptyQueue,
@@ -155,6 +159,10 @@ namespace documentation
         "Clears the history, performs a terminal hard reset and attempts to force a redraw of the currently "
         "running application."
     };
+    constexpr inline std::string_view CopyCommandOutput {
+        "Copies the output of the most recent shell command into clipboard, as reported by shell "
+        "integration."
+    };
     constexpr inline std::string_view CopyPreviousMarkRange {
         "Copies the most recent range that is delimited by vertical line marks into clipboard."
     };
@@ -172,7 +180,8 @@ namespace documentation
         "Focuses the next previous match (if any)."
     };
     constexpr inline std::string_view FollowHyperlink {
-        "Follows the hyperlink that is exposed via OSC 8 under the current cursor position."
+        "Follows the hyperlink that is exposed via OSC 8, or a URL or file:line path found in the text, "
+        "under the current cursor position."
     };
     constexpr inline std::string_view IncreaseFontSize { "Increases the font size by 1 pixel." };
     constexpr inline std::string_view IncreaseOpacity { "Increases the default-background opacity by 5%." };
@@ -234,6 +243,9 @@ namespace documentation
                                                          "others)." };
     constexpr inline std::string_view ToggleFullscreen { "Enables/disables full screen mode." };
     constexpr inline std::string_view ToggleInputProtection { "Enables/disables terminal input protection." };
+    constexpr inline std::string_view TogglePerformanceHud {
+        "Shows/hides an overlay with runtime performance statistics."
+    };
     constexpr inline std::string_view ToggleStatusLine {
         "Shows/hides the VT320 compatible Indicator status line."
     };
@@ -273,6 +285,7 @@ inline auto getDocumentation()
         std::tuple { Action { CancelSelection {} }, documentation::CancelSelection },
         std::tuple { Action { ChangeProfile {} }, documentation::ChangeProfile },
         std::tuple { Action { ClearHistoryAndReset {} }, documentation::ClearHistoryAndReset },
+        std::tuple { Action { CopyCommandOutput {} }, documentation::CopyCommandOutput },
         std::tuple { Action { CopyPreviousMarkRange {} }, documentation::CopyPreviousMarkRange },
         std::tuple { Action { CopySelection {} }, documentation::CopySelection },
         std::tuple { Action { CreateDebugDump {} }, documentation::CreateDebugDump },
@@ -313,6 +326,7 @@ inline auto getDocumentation()
         std::tuple { Action { ToggleAllKeyMaps {} }, documentation::ToggleAllKeyMaps },
         std::tuple { Action { ToggleFullscreen {} }, documentation::ToggleFullscreen },
         std::tuple { Action { ToggleInputProtection {} }, documentation::ToggleInputProtection },
+        std::tuple { Action { TogglePerformanceHud {} }, documentation::TogglePerformanceHud },
         std::tuple { Action { ToggleStatusLine {} }, documentation::ToggleStatusLine },
         std::tuple { Action { ToggleTitleBar {} }, documentation::ToggleTitleBar },
         std::tuple { Action { TraceBreakAtEmptyQueue {} }, documentation::TraceBreakAtEmptyQueue },
@@ -347,6 +361,7 @@ inline auto getDocumentation()
 DECLARE_ACTION_FMT(CancelSelection)
 DECLARE_ACTION_FMT(ChangeProfile)
 DECLARE_ACTION_FMT(ClearHistoryAndReset)
+DECLARE_ACTION_FMT(CopyCommandOutput)
 DECLARE_ACTION_FMT(CopyPreviousMarkRange)
 DECLARE_ACTION_FMT(CopySelection)
 DECLARE_ACTION_FMT(CreateDebugDump)
@@ -387,6 +402,7 @@ DECLARE_ACTION_FMT(SendChars)
 DECLARE_ACTION_FMT(ToggleAllKeyMaps)
 DECLARE_ACTION_FMT(ToggleFullscreen)
 DECLARE_ACTION_FMT(ToggleInputProtection)
+DECLARE_ACTION_FMT(TogglePerformanceHud)
 DECLARE_ACTION_FMT(ToggleStatusLine)
 DECLARE_ACTION_FMT(ToggleTitleBar)
 DECLARE_ACTION_FMT(TraceBreakAtEmptyQueue)
@@ -428,6 +444,7 @@ struct std::formatter<contour::actions::Action>: std::formatter<std::string>
         HANDLE_ACTION(CancelSelection);
         HANDLE_ACTION(ChangeProfile);
         HANDLE_ACTION(ClearHistoryAndReset);
+        HANDLE_ACTION(CopyCommandOutput);
         HANDLE_ACTION(CopyPreviousMarkRange);
         HANDLE_ACTION(CopySelection);
         HANDLE_ACTION(CreateDebugDump);
@@ -467,6 +484,7 @@ struct std::formatter<contour::actions::Action>: std::formatter<std::string>
         HANDLE_ACTION(ToggleAllKeyMaps);
         HANDLE_ACTION(ToggleFullscreen);
         HANDLE_ACTION(ToggleInputProtection);
+        HANDLE_ACTION(TogglePerformanceHud);
         HANDLE_ACTION(ToggleStatusLine);
         HANDLE_ACTION(ToggleTitleBar);
         HANDLE_ACTION(TraceBreakAtEmptyQueue);
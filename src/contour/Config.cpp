@@ -10,6 +10,7 @@
 
 #include <crispy/StrongHash.h>
 #include <crispy/escape.h>
+#include <crispy/tracing.h>
 
 #include <yaml-cpp/emitter.h>
 
@@ -18,7 +19,9 @@
 
 #include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <mutex>
 
 #if defined(_WIN32)
     #include <Windows.h>
@@ -100,6 +103,79 @@ namespace
         return paths;
     }
 
+    /// Identifies the contents of a file, that a configuration has been loaded from.
+    struct FileFingerprint
+    {
+        fs::path path;
+        bool exists = false;
+        fs::file_time_type lastWriteTime {};
+        uintmax_t size = 0;
+        size_t hash = 0;
+    };
+
+    FileFingerprint fingerprint(fs::path const& path)
+    {
+        auto result = FileFingerprint { .path = path };
+        auto ec = std::error_code {};
+        result.lastWriteTime = fs::last_write_time(path, ec);
+        if (ec)
+            return result;
+        if (auto const text = readFile(path); text.has_value())
+        {
+            result.exists = true;
+            result.size = text->size();
+            result.hash = std::hash<std::string_view> {}(*text);
+        }
+        return result;
+    }
+
+    bool unchanged(FileFingerprint const& previous)
+    {
+        auto ec = std::error_code {};
+        auto const lastWriteTime = fs::last_write_time(previous.path, ec);
+        if (ec)
+            return !previous.exists;
+        if (!previous.exists)
+            return false;
+
+        if (lastWriteTime == previous.lastWriteTime && fs::file_size(previous.path, ec) == previous.size)
+            return true;
+
+        // The file has been touched, but its contents may still be the same.
+        auto const current = fingerprint(previous.path);
+        return current.exists && current.size == previous.size && current.hash == previous.hash;
+    }
+
+    /// The configuration most recently loaded from a file, along with the files it has been loaded from,
+    /// so that reloading an unchanged configuration, e.g. when switching profiles, does not parse it again.
+    struct LoadedConfig
+    {
+        std::vector<FileFingerprint> files;
+        Config config;
+    };
+
+    // NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+    std::mutex loadedConfigMutex;
+    std::optional<LoadedConfig> loadedConfig {};
+    // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+
+    bool loadCachedConfig(Config& config)
+    {
+        auto const lock = std::scoped_lock { loadedConfigMutex };
+        if (!loadedConfig || loadedConfig->config.configFile != config.configFile
+            || !std::ranges::all_of(loadedConfig->files, unchanged))
+            return false;
+
+        config = loadedConfig->config;
+        return true;
+    }
+
+    void storeCachedConfig(std::vector<FileFingerprint> files, Config const& config)
+    {
+        auto const lock = std::scoped_lock { loadedConfigMutex };
+        loadedConfig = LoadedConfig { .files = std::move(files), .config = config };
+    }
+
     void createFileIfNotExists(fs::path const& path)
     {
         if (!fs::is_regular_file(path))
@@ -191,6 +267,20 @@ fs::path configHome()
     return configHome("contour");
 }
 
+fs::path cacheHome()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (auto const* value = getenv("XDG_CACHE_HOME"); value && *value)
+        return fs::path { value } / "contour";
+    else
+        return Process::homeDirectory() / ".cache" / "contour";
+#endif
+
+#if defined(_WIN32)
+    return configHome("contour") / "cache";
+#endif
+}
+
 std::string createString(Config const& c)
 {
     return createString<YAMLConfigWriter>(c);
@@ -285,14 +375,65 @@ void compareEntries(Config& config, auto const& output)
  */
 void loadConfigFromFile(Config& config, fs::path const& fileName)
 {
+    CRISPY_TRACE_ZONE("loadConfigFromFile", "config");
     auto logger = configLog;
     logger()("Loading configuration from file: {} ", fileName.string());
     config.configFile = fileName;
     createFileIfNotExists(config.configFile);
 
+    if (loadCachedConfig(config))
+    {
+        logger()("Configuration file unchanged, using previously loaded configuration.");
+        return;
+    }
+
+    // Fingerprint the file before reading it, so that changes while loading are noticed next time.
+    auto files = std::vector<FileFingerprint> { fingerprint(config.configFile) };
     auto yamlVisitor = YAMLConfigReader(config.configFile.string(), logger);
     yamlVisitor.load(config);
-    compareEntries(config, logger);
+    for (auto const& path: yamlVisitor.includedFiles)
+        files.emplace_back(fingerprint(path));
+    storeCachedConfig(std::move(files), config);
+
+    // Comparing against the default configuration means generating and parsing it, so only do it
+    // if it is going to be logged.
+    if (logger.is_enabled())
+        compareEntries(config, logger);
+}
+
+std::vector<std::string> Config::profileNames() const
+{
+    auto names = std::vector<std::string> {};
+    names.reserve(profiles.value().size() + pendingProfiles.size());
+    for (auto const& [name, _]: profiles.value())
+        names.emplace_back(name);
+    for (auto const& [name, _]: pendingProfiles)
+        names.emplace_back(name);
+    std::ranges::sort(names);
+    return names;
+}
+
+void Config::loadPendingProfile(std::string const& name) const noexcept
+{
+    auto const i = pendingProfiles.find(name);
+    if (i == pendingProfiles.end())
+        return;
+
+    auto const pending = std::move(i->second);
+    pendingProfiles.erase(i);
+
+    configLog()("Loading profile on first use: {}", name);
+    auto& profile = profiles.value()[name];
+    profile = *pending.base; // inherit from default
+    try
+    {
+        auto reader = YAMLConfigReader(configFile, YAML::Node {}, configLog);
+        reader.loadFromEntry(pending.profiles, name, profile);
+    }
+    catch (std::exception const& e)
+    {
+        errorLog()("Failed to load profile {}. {}", name, e.what());
+    }
 }
 
 optional<std::string> readConfigFile(std::string const& filename)
@@ -329,6 +470,8 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
             where = RenderingBackend::OpenGL;
         else if (renderBackendStr == "SOFTWARE")
             where = RenderingBackend::Software;
+        else if (renderBackendStr == "VULKAN")
+            where = RenderingBackend::Vulkan;
 
         logger()("Loading entry: {}, value {}", entry, where);
     }
@@ -350,16 +493,23 @@ void YAMLConfigReader::load(Config& c)
         loadFromEntry("extended_word_delimiters", c.extendedWordDelimiters);
         loadFromEntry("read_buffer_size", c.ptyReadBufferSize);
         loadFromEntry("pty_buffer_size", c.ptyBufferObjectSize);
+        loadFromEntry("pty_buffer_allocation", c.ptyBufferAllocation);
+        loadFromEntry("pty_reader_thread", c.ptyReaderThread);
+        loadFromEntry("shared_input_threads", c.sharedInputThreads);
         loadFromEntry("images", c.images);
         loadFromEntry("live_config", c.live);
         loadFromEntry("early_exit_threshold", c.earlyExitThreshold);
         loadFromEntry("spawn_new_process", c.spawnNewProcess);
+        loadFromEntry("hibernate_after", c.hibernateAfter);
+        loadFromEntry("trim_memory_after", c.trimMemoryAfter);
+        loadFromEntry("memory_budget", c.memoryBudget);
+        loadFromEntry("metrics_socket", c.metricsSocket);
         loadFromEntry("reflow_on_resize", c.reflowOnResize);
         loadFromEntry("experimental", c.experimentalFeatures);
         loadFromEntry("bypass_mouse_protocol_modifier", c.bypassMouseProtocolModifiers);
         loadFromEntry("on_mouse_select", c.onMouseSelection);
         loadFromEntry("mouse_block_selection_modifier", c.mouseBlockSelectionModifiers);
-        loadFromEntry("profiles", c.profiles, c.defaultProfileName.value());
+        loadProfiles(c);
         // loadFromEntry("color_schemes", c.colorschemes); // NB: This is always loaded lazily
         loadFromEntry("input_mapping", c.inputMappings);
     }
@@ -370,6 +520,29 @@ void YAMLConfigReader::load(Config& c)
     }
 }
 
+void YAMLConfigReader::loadProfiles(Config& c)
+{
+    auto const child = doc["profiles"];
+    if (!child || !child.IsMap())
+        return;
+
+    auto const& defaultProfileName = c.defaultProfileName.value();
+    auto& profiles = c.profiles.value();
+    logger()("Loading default profile: {}", defaultProfileName);
+    loadFromEntry(child, defaultProfileName, profiles[defaultProfileName]);
+
+    auto const base = std::make_shared<TerminalProfile const>(profiles[defaultProfileName]);
+    for (auto entry: child)
+    {
+        auto const name = entry.first.as<std::string>();
+        if (name == defaultProfileName)
+            continue;
+        logger()("Deferring loading of profile: {}", name);
+        profiles.erase(name);
+        c.pendingProfiles[name] = PendingProfile { .profiles = child, .base = base };
+    }
+}
+
 void YAMLConfigReader::loadFromEntry(YAML::Node const& node, std::string const& entry, TerminalProfile& where)
 {
     logger()("loading profile {}\n", entry);
@@ -402,8 +575,10 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node, std::string const&
         loadFromEntry(child, "terminal_id", where.terminalId);
         loadFromEntry(child, "frozen_dec_modes", where.frozenModes);
         loadFromEntry(child, "slow_scrolling_time", where.smoothLineScrolling);
+        loadFromEntry(child, "predictive_echo_threshold", where.predictiveEchoThreshold);
         loadFromEntry(child, "terminal_size", where.terminalSize);
         loadFromEntry(child, "history", where.history);
+        loadFromEntry(child, "cell_layout", where.cellLayout);
         loadFromEntry(child, "scrollbar", where.scrollbar);
         loadFromEntry(child, "mouse", where.mouse);
         loadFromEntry(child, "permissions", where.permissions);
@@ -486,6 +661,7 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
             return;
         }
         logger()("color palette loading from file {}", filePath.string());
+        includedFiles.emplace_back(filePath);
         try
         {
             loadFromEntry(YAML::Load(fileContents.value()), where);
@@ -827,6 +1003,10 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
         loadFromEntry(child, "public_key", where.publicKeyFile);
         loadFromEntry(child, "known_hosts", where.publicKeyFile);
         loadFromEntry(child, "forward_agent", where.forwardAgent);
+        loadFromEntry(child, "compression", where.compression);
+        loadFromEntry(child, "window_size", where.windowSize);
+        loadFromEntry(child, "packet_size", where.packetSize);
+        loadFromEntry(child, "share_connection", where.shareConnection);
     }
 }
 
@@ -1084,6 +1264,11 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node, std::string const&
         loadFromEntry(child, "tile_direct_mapping", where.textureAtlasDirectMapping);
         loadFromEntry(child, "tile_hashtable_slots", where.textureAtlasHashtableSlots);
         loadFromEntry(child, "tile_cache_count", where.textureAtlasTileCount);
+        loadFromEntry(child, "glyph_disk_cache", where.glyphDiskCache);
+        loadFromEntry(child, "async_glyph_rasterization", where.asyncGlyphRasterization);
+        loadFromEntry(child, "bulk_output_frame_interval", where.bulkOutputFrameInterval);
+        loadFromEntry(child, "variable_refresh_rate", where.variableRefreshRate);
+        loadFromEntry(child, "render_thread", where.renderThread);
         loadFromEntry(child, "backend", where.renderingBackend);
     }
 }
@@ -1100,6 +1285,8 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node, std::string const&
         uint height = 0;
         loadFromEntry(child, "max_height", height);
         where.maxImageSize = { .width = vtpty::Width { width }, .height = vtpty::Height { height } };
+        loadFromEntry(child, "max_memory", where.maxImageMemory);
+        loadFromEntry(child, "kitty_local_media", where.kittyLocalMedia);
     }
 }
 
@@ -1111,6 +1298,8 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node, std::string const&
         loadFromEntry(child, "limit", where.maxHistoryLineCount);
         loadFromEntry(child, "scroll_multiplier", where.historyScrollMultiplier);
         loadFromEntry(child, "auto_scroll_on_update", where.autoScrollOnUpdate);
+        loadFromEntry(child, "spill_to_disk", where.spillToDisk);
+        loadFromEntry(child, "restore_on_launch", where.restoreOnLaunch);
     }
 }
 
@@ -1130,6 +1319,7 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node, std::string const&
     if (child)
     {
         loadFromEntry(child, "hide_while_typing", where.hideWhileTyping);
+        loadFromEntry(child, "pixel_move_interval", where.pixelMoveInterval);
     }
 }
 
@@ -1350,6 +1540,31 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
     }
 }
 
+void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
+                                     std::string const& entry,
+                                     crispy::buffer_object_allocation& where)
+{
+    auto parseAllocation = [&](std::string const& key) -> std::optional<crispy::buffer_object_allocation> {
+        auto const literal = crispy::toLower(key);
+        logger()("Loading entry: {}, value {}", entry, literal);
+        if (literal == "heap")
+            return crispy::buffer_object_allocation::Heap;
+        if (literal == "transparent_huge_pages")
+            return crispy::buffer_object_allocation::TransparentHugePages;
+        if (literal == "huge_tlb")
+            return crispy::buffer_object_allocation::HugeTLB;
+        return std::nullopt;
+    };
+
+    if (auto const child = node[entry])
+    {
+        if (auto const opt = parseAllocation(child.as<std::string>()); opt.has_value())
+            where = opt.value();
+        else
+            errorLog()("Invalid value for {}: {}", entry, child.as<std::string>());
+    }
+}
+
 void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
                                      std::string const& entry,
                                      ScrollBarPosition& where)
@@ -1396,6 +1611,23 @@ void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
     }
 }
 
+void YAMLConfigReader::loadFromEntry(YAML::Node const& node,
+                                     std::string const& entry,
+                                     vtbackend::CellLayout& where)
+{
+    if (auto const child = node[entry])
+    {
+        auto const literal = crispy::toLower(child.as<std::string>());
+        logger()("Loading entry: {}, value {}", entry, literal);
+        if (literal == "compact")
+            where = vtbackend::CellLayout::Compact;
+        else if (literal == "simple")
+            where = vtbackend::CellLayout::Simple;
+        else
+            errorLog()("Invalid cell layout: {}", literal);
+    }
+}
+
 void YAMLConfigReader::loadFromEntry(YAML::Node const& node, std::string const& entry, std::string& where)
 {
     if (auto const child = node[entry])
@@ -26,6 +26,7 @@
 #include <text_shaper/font.h>
 #include <text_shaper/mock_font_locator.h>
 
+#include <crispy/BufferObject.h>
 #include <crispy/StrongLRUHashtable.h>
 #include <crispy/assert.h>
 #include <crispy/flags.h>
@@ -98,6 +99,23 @@ struct InputMappings
     std::vector<MouseInputMapping> mouseMappings;
 };
 
+/// InputMappings compiled into lookup tables, to be rebuilt whenever the mappings change.
+struct InputMappingIndex
+{
+    InputMappingIndex() = default;
+
+    explicit InputMappingIndex(InputMappings const& mappings):
+        keyMappings { mappings.keyMappings },
+        charMappings { mappings.charMappings },
+        mouseMappings { mappings.mouseMappings }
+    {
+    }
+
+    vtbackend::InputBindingIndex<vtbackend::Key, ActionList> keyMappings;
+    vtbackend::InputBindingIndex<char32_t, ActionList> charMappings;
+    vtbackend::InputBindingIndex<vtbackend::MouseButton, ActionList> mouseMappings;
+};
+
 namespace helper
 {
     inline bool testMatchMode(uint8_t actualModeFlags,
@@ -152,11 +170,22 @@ std::vector<actions::Action> const* apply(
     return nullptr;
 }
 
+template <typename Input>
+std::vector<actions::Action> const* apply(vtbackend::InputBindingIndex<Input, ActionList> const& mappings,
+                                          Input input,
+                                          vtbackend::Modifiers modifiers,
+                                          uint8_t actualModeFlags)
+{
+    return mappings.find(input, modifiers, actualModeFlags);
+}
+
 struct CursorConfig
 {
     vtbackend::CursorShape cursorShape { vtbackend::CursorShape::Block };
     vtbackend::CursorDisplay cursorDisplay { vtbackend::CursorDisplay::Steady };
     std::chrono::milliseconds cursorBlinkInterval;
+
+    bool operator==(CursorConfig const&) const = default;
 };
 
 struct HistoryConfig
@@ -164,6 +193,8 @@ struct HistoryConfig
     vtbackend::MaxHistoryLineCount maxHistoryLineCount { vtbackend::LineCount(1000) };
     vtbackend::LineCount historyScrollMultiplier { vtbackend::LineCount(3) };
     bool autoScrollOnUpdate { true };
+    bool spillToDisk { false };
+    bool restoreOnLaunch { false };
 };
 
 struct ScrollBarConfig
@@ -175,6 +206,7 @@ struct ScrollBarConfig
 struct MouseConfig
 {
     bool hideWhileTyping { true };
+    std::chrono::milliseconds pixelMoveInterval { 8 };
 };
 
 struct IndicatorConfig
@@ -183,7 +215,8 @@ struct IndicatorConfig
                        "{Tabs:ActiveColor=#FFFF00,Left= │ }"
                        "{SearchPrompt:Left= │ }"
                        "{TraceMode:Bold,Color=#FFFF00,Left= │ }"
-                       "{ProtectedMode:Bold,Left= │ }" };
+                       "{ProtectedMode:Bold,Left= │ }"
+                       "{PasteProgress:Bold,Left= │ }" };
     std::string middle { "{Title:Left= « ,Right= » }" };
     std::string right { "{HistoryLineCount:Faint,Color=#c0c0c0} │ {Clock:Bold}" };
 };
@@ -206,6 +239,8 @@ struct HyperlinkDecorationConfig
 {
     vtrasterizer::Decorator normal { vtrasterizer::Decorator::DottedUnderline };
     vtrasterizer::Decorator hover { vtrasterizer::Decorator::Underline };
+
+    bool operator==(HyperlinkDecorationConfig const&) const = default;
 };
 
 struct PermissionsConfig
@@ -241,6 +276,7 @@ enum class RenderingBackend : uint8_t
     Default,
     Software,
     OpenGL,
+    Vulkan,
 };
 
 struct RendererConfig
@@ -249,6 +285,11 @@ struct RendererConfig
     crispy::lru_capacity textureAtlasTileCount { 4000u };
     crispy::strong_hashtable_size textureAtlasHashtableSlots { 4096u };
     bool textureAtlasDirectMapping { false };
+    bool glyphDiskCache { false };
+    bool asyncGlyphRasterization { true };
+    std::chrono::milliseconds bulkOutputFrameInterval { 33 };
+    bool variableRefreshRate { false };
+    bool renderThread { false };
 };
 
 struct ImagesConfig
@@ -256,6 +297,10 @@ struct ImagesConfig
     bool sixelScrolling { true };
     vtbackend::ImageSize maxImageSize { vtpty::Width { 0 }, vtpty::Height { 0 } };
     int maxImageColorRegisters { 4096 };
+    // Megabytes of uncompressed image data kept in memory per session.
+    unsigned maxImageMemory { 256 };
+    // Lets kitty graphics clients have images read from local files and shared memory.
+    bool kittyLocalMedia { false };
 };
 
 struct HorizontalMarginTag
@@ -408,6 +453,9 @@ struct TerminalProfile
     ConfigEntry<vtbackend::VTType, documentation::TerminalId> terminalId { vtbackend::VTType::VT525 };
     ConfigEntry<std::map<vtbackend::DECMode, bool>, documentation::FrozenDecMode> frozenModes {};
     ConfigEntry<std::chrono::milliseconds, documentation::SmoothLineScrolling> smoothLineScrolling { 100 };
+    ConfigEntry<std::chrono::milliseconds, documentation::PredictiveEchoThreshold> predictiveEchoThreshold {
+        0
+    };
     ConfigEntry<vtbackend::PageSize, documentation::TerminalSize> terminalSize { {
         vtbackend::LineCount(25),
         vtbackend::ColumnCount(80),
@@ -415,6 +463,9 @@ struct TerminalProfile
     ConfigEntry<WindowMargins, documentation::Margins> margins { { HorizontalMargin { 0u },
                                                                    VerticalMargin { 0u } } };
     ConfigEntry<HistoryConfig, documentation::History> history {};
+    ConfigEntry<vtbackend::CellLayout, documentation::CellLayout> cellLayout {
+        vtbackend::CellLayout::Compact
+    };
     ConfigEntry<ScrollBarConfig, documentation::Scrollbar> scrollbar {};
     ConfigEntry<MouseConfig, documentation::Mouse> mouse { true };
     ConfigEntry<PermissionsConfig, documentation::Permissions> permissions {};
@@ -736,6 +787,13 @@ const InputMappings defaultInputMappings {
     }
 };
 
+/// A profile whose definition has been read, but not loaded yet.
+struct PendingProfile
+{
+    YAML::Node profiles;                         // the profiles node the profile is defined in
+    std::shared_ptr<TerminalProfile const> base; // the default profile as loaded, to inherit from
+};
+
 struct Config
 {
     std::filesystem::path configFile {};
@@ -749,11 +807,20 @@ struct Config
     };
     ConfigEntry<int, documentation::PTYReadBufferSize> ptyReadBufferSize { 16384 };
     ConfigEntry<int, documentation::PTYBufferObjectSize> ptyBufferObjectSize { 1024 * 1024 };
+    ConfigEntry<crispy::buffer_object_allocation, documentation::PTYBufferAllocation> ptyBufferAllocation {
+        crispy::buffer_object_allocation::Heap
+    };
+    ConfigEntry<bool, documentation::PTYReaderThread> ptyReaderThread { false };
+    ConfigEntry<bool, documentation::SharedInputThreads> sharedInputThreads { false };
     ConfigEntry<std::string, documentation::DefaultProfiles> defaultProfileName { "main" };
     ConfigEntry<unsigned, documentation::EarlyExitThreshold> earlyExitThreshold {
         documentation::DefaultEarlyExitThreshold
     };
     ConfigEntry<bool, documentation::SpawnNewProcess> spawnNewProcess { false };
+    ConfigEntry<unsigned, documentation::HibernateAfter> hibernateAfter { 0 };
+    ConfigEntry<unsigned, documentation::TrimMemoryAfter> trimMemoryAfter { 60 };
+    ConfigEntry<unsigned, documentation::MemoryBudget> memoryBudget { 0 };
+    ConfigEntry<std::string, documentation::MetricsSocket> metricsSocket { "" };
     ConfigEntry<bool, documentation::ReflowOnResize> reflowOnResize { true };
     ConfigEntry<vtbackend::Modifiers, documentation::BypassMouseProtocolModifiers>
         bypassMouseProtocolModifiers { vtbackend::Modifier::Shift };
@@ -766,17 +833,25 @@ struct Config
     ConfigEntry<std::set<std::string>, documentation::ExperimentalFeatures> experimentalFeatures {};
     ConfigEntry<ImagesConfig, documentation::Images> images {};
 
-    ConfigEntry<std::unordered_map<std::string, TerminalProfile>, documentation::Profiles> profiles {
+    // Only the default profile is loaded along with the configuration file, all other profiles are
+    // loaded on first access via profile(). Loading them does not change the configuration as observed
+    // through profile() and profileNames(), hence they are mutable.
+    mutable ConfigEntry<std::unordered_map<std::string, TerminalProfile>, documentation::Profiles> profiles {
         { { "main", TerminalProfile {} } }
     };
+    mutable std::unordered_map<std::string, PendingProfile> pendingProfiles {};
     ConfigEntry<std::unordered_map<std::string, vtbackend::ColorPalette>, documentation::ColorSchemes>
         colorschemes { { { "default", vtbackend::ColorPalette {} } } };
 
     ConfigEntry<InputMappings, documentation::InputMappings> inputMappings { defaultInputMappings };
 
+    /// @returns the names of all profiles, including those that have not been loaded yet, sorted.
+    [[nodiscard]] std::vector<std::string> profileNames() const;
+
     TerminalProfile* profile(std::string const& name) noexcept
     {
         assert(!name.empty());
+        loadPendingProfile(name);
         if (auto i = profiles.value().find(name); i != profiles.value().end())
             return &i->second;
         assert(false && "Profile not found.");
@@ -786,6 +861,7 @@ struct Config
     [[nodiscard]] TerminalProfile const* profile(std::string const& name) const
     {
         assert(!name.empty());
+        loadPendingProfile(name);
         if (auto i = profiles.value().find(name); i != profiles.value().end())
             return &i->second;
         assert(false && "Profile not found.");
@@ -805,6 +881,9 @@ struct Config
             return *prof;
         crispy::unreachable();
     }
+
+    /// Loads the profile of the given name, if it is pending.
+    void loadPendingProfile(std::string const& name) const noexcept;
 };
 
 struct YAMLConfigReader
@@ -812,6 +891,12 @@ struct YAMLConfigReader
     std::filesystem::path configFile;
     YAML::Node doc;
     logstore::category const& logger;
+    std::vector<std::filesystem::path> includedFiles {}; // files read besides the configuration file
+
+    YAMLConfigReader(std::filesystem::path filename, YAML::Node document, logstore::category const& log):
+        configFile(std::move(filename)), doc(std::move(document)), logger { log }
+    {
+    }
 
     YAMLConfigReader(std::string const& filename, logstore::category const& log):
         configFile(filename), logger { log }
@@ -871,26 +956,8 @@ struct YAMLConfigReader
         logger()("Loading entry: {}, value {}", entry, where.template as<V>());
     }
 
-    void loadFromEntry(YAML::Node const& node,
-                       std::string const& entry,
-                       std::unordered_map<std::string, TerminalProfile>& where,
-                       std::string const& defaultProfileName)
-    {
-        if (auto const child = node[entry]; child && child.IsMap())
-        {
-            logger()("Loading default profile: {}", defaultProfileName);
-            loadFromEntry(child, defaultProfileName, where[defaultProfileName]);
-            for (auto entry: child)
-            {
-                auto const name = entry.first.as<std::string>();
-                if (name == defaultProfileName)
-                    continue;
-                logger()("Loading map with entry: {}", name);
-                where[name] = where[defaultProfileName]; // inherit from default
-                loadFromEntry(child, entry.first.as<std::string>(), where[name]);
-            }
-        }
-    }
+    /// Loads the default profile, and defers loading all other profiles until they are accessed.
+    void loadProfiles(Config& c);
 
     // Used for color scheme loading
     template <typename T>
@@ -951,7 +1018,11 @@ struct YAMLConfigReader
     void loadFromEntry(YAML::Node const& node, std::string const& entry, std::set<std::string>& where);
     void loadFromEntry(YAML::Node const& node, std::string const& entry, std::string& where);
     void loadFromEntry(YAML::Node const& node, std::string const& entry, vtbackend::StatusDisplayPosition& where);
+    void loadFromEntry(YAML::Node const& node, std::string const& entry, vtbackend::CellLayout& where);
     void loadFromEntry(YAML::Node const& node, std::string const& entry, ScrollBarPosition& where);
+    void loadFromEntry(YAML::Node const& node,
+                       std::string const& entry,
+                       crispy::buffer_object_allocation& where);
     void loadFromEntry(YAML::Node const& node, std::string const& entry, vtrasterizer::FontDescriptions& where);
     void loadFromEntry(YAML::Node const& node, std::string const& entry, text::render_mode& where);
     void loadFromEntry(YAML::Node const& node, std::string const& entry, vtrasterizer::FontLocatorEngine& where);
@@ -1214,13 +1285,23 @@ struct Writer
                       v.renderingBackend,
                       v.textureAtlasDirectMapping,
                       v.textureAtlasHashtableSlots,
-                      v.textureAtlasTileCount);
+                      v.textureAtlasTileCount,
+                      v.glyphDiskCache,
+                      v.asyncGlyphRasterization,
+                      v.bulkOutputFrameInterval.count(),
+                      v.variableRefreshRate,
+                      v.renderThread);
     }
 
     [[nodiscard]] std::string format(std::string_view doc, ImagesConfig& v)
     {
-        return format(
-            doc, v.sixelScrolling, v.maxImageColorRegisters, v.maxImageSize.width, v.maxImageSize.height);
+        return format(doc,
+                      v.sixelScrolling,
+                      v.maxImageColorRegisters,
+                      v.maxImageSize.width,
+                      v.maxImageSize.height,
+                      v.maxImageMemory,
+                      v.kittyLocalMedia);
     }
 
     [[nodiscard]] std::string format(std::string_view doc, WindowMargins& v)
@@ -1239,7 +1320,9 @@ struct Writer
                 return number;
             }(),
             v.autoScrollOnUpdate,
-            v.historyScrollMultiplier);
+            v.historyScrollMultiplier,
+            v.spillToDisk,
+            v.restoreOnLaunch);
     }
 
     [[nodiscard]] std::string format(std::string_view doc, ScrollBarConfig& v)
@@ -1249,7 +1332,7 @@ struct Writer
 
     [[nodiscard]] std::string format(std::string_view doc, MouseConfig& v)
     {
-        return format(doc, v.hideWhileTyping);
+        return format(doc, v.hideWhileTyping, v.pixelMoveInterval.count());
     }
 
     [[nodiscard]] std::string format(std::string_view doc, StatusLineConfig& v)
@@ -1436,6 +1519,7 @@ struct PlainWriter: Writer
 
 std::filesystem::path configHome();
 std::filesystem::path configHome(std::string const& programName);
+std::filesystem::path cacheHome();
 
 std::optional<std::string> readConfigFile(std::string const& filename);
 
@@ -1504,6 +1588,21 @@ struct std::formatter<vtbackend::StatusDisplayPosition>: formatter<std::string_v
     }
 };
 
+template <>
+struct std::formatter<vtbackend::CellLayout>: formatter<std::string_view>
+{
+    auto format(vtbackend::CellLayout value, auto& ctx) const
+    {
+        string_view name;
+        switch (value)
+        {
+            case vtbackend::CellLayout::Compact: name = "compact"; break;
+            case vtbackend::CellLayout::Simple: name = "simple"; break;
+        }
+        return formatter<string_view>::format(name, ctx);
+    }
+};
+
 template <>
 struct std::formatter<vtbackend::BackgroundImage>: formatter<std::string_view>
 {
@@ -1596,6 +1695,7 @@ struct std::formatter<contour::config::RenderingBackend>: formatter<std::string_
             case contour::config::RenderingBackend::Default: name = "default"; break;
             case contour::config::RenderingBackend::OpenGL: name = "OpenGL"; break;
             case contour::config::RenderingBackend::Software: name = "software"; break;
+            case contour::config::RenderingBackend::Vulkan: name = "Vulkan"; break;
         }
         return formatter<std::string_view>::format(name, ctx);
     }
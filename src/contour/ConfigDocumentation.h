@@ -92,6 +92,24 @@ constexpr StringLiteral SshHostConfigConfig {
     "{comment}     {comment} Default value currently is `false` (agent forwarding disabled),\n"
     "{comment}     {comment} and is for security reasons also the recommended way.\n"
     "{comment}     forward_agent: false\n"
+    "{comment}\n"
+    "{comment}     {comment} Whether or not to compress the SSH connection. This may help on slow links,\n"
+    "{comment}     {comment} but usually costs more than it gains on fast ones. Default value is `false`.\n"
+    "{comment}     compression: false\n"
+    "{comment}\n"
+    "{comment}     {comment} Size of the receive window of the SSH channel, in bytes.\n"
+    "{comment}     {comment} The throughput is at most the window size divided by the round-trip time,\n"
+    "{comment}     {comment} so increase this value for fast links with high latency.\n"
+    "{comment}     window_size: 16777216\n"
+    "{comment}\n"
+    "{comment}     {comment} Maximum size of an SSH channel packet, in bytes.\n"
+    "{comment}     packet_size: 32768\n"
+    "{comment}\n"
+    "{comment}     {comment} Whether or not sessions to the same host, port and user share a single\n"
+    "{comment}     {comment} SSH connection, each session opening a channel of its own, which saves the\n"
+    "{comment}     {comment} key exchange and authentication for every but the first one.\n"
+    "{comment}     {comment} Default value is `true`.\n"
+    "{comment}     share_connection: true\n"
     "\n"
 };
 
@@ -124,6 +142,9 @@ constexpr StringLiteral ShowIndicatorOnResizeConfig {
 constexpr StringLiteral MouseConfig { "mouse:\n"
                                       "    {comment} whether or not to hide mouse when typing\n"
                                       "    hide_while_typing: {}\n"
+                                      "    {comment} minimum time in milliseconds between two reported\n"
+                                      "    {comment} mouse moves in pixel-precise (SGR-Pixels) tracking\n"
+                                      "    pixel_move_interval: {}\n"
                                       "\n" };
 
 constexpr StringLiteral SeachModeSwitchConfig {
@@ -210,10 +231,27 @@ constexpr StringLiteral HistoryConfig {
     "    auto_scroll_on_update: {}\n"
     "    {comment} Number of lines to scroll on ScrollUp & ScrollDown events.\n"
     "    scroll_multiplier: {}\n"
+    "    {comment} Boolean indicating whether or not lines beyond the history limit are kept in a file on\n"
+    "    {comment} disk instead of being discarded, from where they are read back when scrolled to or\n"
+    "    {comment} searched. The file is deleted when the session is closed.\n"
+    "    spill_to_disk: {}\n"
+    "    {comment} Boolean indicating whether or not the history is saved on exit and restored into the\n"
+    "    {comment} first sessions on the next launch.\n"
+    "    restore_on_launch: {}\n"
     "\n"
 
 };
 
+constexpr StringLiteral CellLayoutConfig {
+    "{comment} Selects how the cells of the primary and alternate screen are stored in memory.\n"
+    "{comment} Possible values are:\n"
+    "{comment}   - compact  Rarely used cell data is kept out of line, favoring long histories.\n"
+    "{comment}   - simple   All cell data is kept inline, favoring images and hyperlinks.\n"
+    "{comment} Only applies to newly created terminal sessions.\n"
+    "cell_layout: {}\n"
+    "\n"
+};
+
 constexpr StringLiteral ScrollbarConfig {
 
     "scrollbar:\n"
@@ -415,6 +453,16 @@ constexpr StringLiteral SmoothLineScrollingConfig {
     "\n"
 };
 
+constexpr StringLiteral PredictiveEchoThresholdConfig {
+    "{comment} Echoes typed text and cursor moves locally ahead of the application,\n"
+    "{comment} once the measured latency of key input reaches this number of milliseconds,\n"
+    "{comment} such as over SSH connections to far away hosts. The echo is shown underlined\n"
+    "{comment} until the application's own echo confirms it, and is rolled back otherwise.\n"
+    "{comment} A value of 0 disables predicting the echo.\n"
+    "predictive_echo_threshold: {}\n"
+    "\n"
+};
+
 constexpr StringLiteral HighlightTimeoutConfig {
     "{comment} Time duration in milliseconds for which yank highlight is shown.\n"
     "vi_mode_highlight_timeout: {}\n"
@@ -533,6 +581,7 @@ constexpr StringLiteral RendererConfig {
     "    {comment} - default     Uses the default rendering option as decided by the terminal. \n"
     "    {comment} - software    Uses software-based rendering. \n"
     "    {comment} - OpenGL      Use (possibly) hardware accelerated OpenGL \n"
+    "    {comment} - Vulkan      Use Vulkan, if supported by this build, OpenGL otherwise \n"
     "    backend: {} \n"
     "\n"
     "    {comment} Enables/disables the use of direct-mapped texture atlas tiles for \n"
@@ -557,6 +606,38 @@ constexpr StringLiteral RendererConfig {
     "    {comment} \n"
     "    tile_cache_count: {} \n"
     "\n"
+    "    {comment} Persists text shaping results and rasterized glyphs on disk, \n"
+    "    {comment} speeding up the next start and font size changes with the same fonts. \n"
+    "    {comment} The cache files are stored in the user's cache directory, \n"
+    "    {comment} such as ~/.cache/contour/glyphs. \n"
+    "    {comment} \n"
+    "    glyph_disk_cache: {} \n"
+    "\n"
+    "    {comment} Rasterizes glyphs that are not in the texture atlas yet on a background thread. \n"
+    "    {comment} Such glyphs appear one frame later, rather than delaying the whole frame, \n"
+    "    {comment} e.g. when a screen full of new CJK or emoji glyphs is displayed. \n"
+    "    {comment} \n"
+    "    async_glyph_rasterization: {} \n"
+    "\n"
+    "    {comment} Minimum time in milliseconds between two frames while an application keeps \n"
+    "    {comment} producing bulk output, so that the output is processed rather than rendered \n"
+    "    {comment} into frames nobody gets to see. Output answering keyboard input is always \n"
+    "    {comment} shown right away. \n"
+    "    {comment} \n"
+    "    bulk_output_frame_interval: {} \n"
+    "\n"
+    "    {comment} Set to true if the display has a variable refresh rate (e.g. FreeSync or G-Sync), \n"
+    "    {comment} such that frames are not deferred to the next fixed refresh period. \n"
+    "    {comment} \n"
+    "    variable_refresh_rate: {} \n"
+    "\n"
+    "    {comment} Schedules frames from the render thread rather than from the GUI thread, \n"
+    "    {comment} such that rendering is not delayed while the GUI thread is busy, \n"
+    "    {comment} e.g. with reloading the configuration or creating a tab. \n"
+    "    {comment} This requires Qt's threaded render loop, which is then used if available. \n"
+    "    {comment} \n"
+    "    render_thread: {} \n"
+    "\n"
 };
 
 constexpr StringLiteral PTYReadBufferSizeConfig { "{comment} Default PTY read buffer size. \n"
@@ -573,6 +654,41 @@ constexpr StringLiteral PTYBufferObjectSizeConfig {
     "\n"
 };
 
+constexpr StringLiteral PTYBufferAllocationConfig {
+    "{comment} How the storage of PTY Buffer Objects is allocated. \n"
+    "{comment} \n"
+    "{comment} - heap                    regular heap memory \n"
+    "{comment} - transparent_huge_pages  memory backed by transparent huge pages, where supported \n"
+    "{comment} - huge_tlb                memory from the reserved huge page pool, where available \n"
+    "{comment} \n"
+    "{comment} Huge pages may reduce TLB misses for applications producing a lot of output, \n"
+    "{comment} but round each PTY Buffer Object up to 2 MB. \n"
+    "{comment} \n"
+    "{comment} This is an advanced option of an internal storage. Only change with care! \n"
+    "pty_buffer_allocation: {} \n"
+    "\n"
+};
+
+constexpr StringLiteral PTYReaderThreadConfig {
+    "{comment} Reads from the PTY on a dedicated thread, while the previously read output is being \n"
+    "{comment} parsed. This may improve throughput for applications producing a lot of output. \n"
+    "{comment} \n"
+    "{comment} This is an advanced option. Only change with care! \n"
+    "pty_reader_thread: {} \n"
+    "\n"
+};
+
+constexpr StringLiteral SharedInputThreadsConfig {
+    "{comment} Processes the output of all terminal sessions on a shared pool of threads, sized by the \n"
+    "{comment} number of CPU cores, instead of on a thread of its own each. This saves resources when \n"
+    "{comment} running many sessions. Sessions that can not be processed this way, or that use the \n"
+    "{comment} PTY reader thread, still get a thread of their own. \n"
+    "{comment} \n"
+    "{comment} This is an advanced option. Only change with care! \n"
+    "shared_input_threads: {} \n"
+    "\n"
+};
+
 constexpr StringLiteral ReflowOnResizeConfig {
     "\n"
     "{comment} Whether or not to reflow the lines on terminal resize events. \n"
@@ -726,6 +842,8 @@ constexpr StringLiteral InputMappingsConfig {
     "{comment} - ClearHistoryAndReset    Clears the history, performs a terminal hard reset and attempts "
     "to "
     "force a redraw of the currently running application.\n"
+    "{comment} - CopyCommandOutput       Copies the output of the most recent shell command into "
+    "clipboard, as reported by shell integration.\n"
     "{comment} - CopyPreviousMarkRange   Copies the most recent range that is delimited by vertical line "
     "marks "
     "into clipboard.\n"
@@ -736,9 +854,9 @@ constexpr StringLiteral InputMappingsConfig {
     "{comment} - DecreaseOpacity   Decreases the default-background opacity by 5%.\n"
     "{comment} - FocusNextSearchMatch     Focuses the next search match (if any).\n"
     "{comment} - FocusPreviousSearchMatch Focuses the next previous match (if any).\n"
-    "{comment} - FollowHyperlink   Follows the hyperlink that is exposed via OSC 8 under the current "
-    "cursor "
-    "position.\n"
+    "{comment} - FollowHyperlink   Follows the hyperlink that is exposed via OSC 8, or a URL or file:line "
+    "path found\n"
+    "{comment}                     in the text, under the current cursor position.\n"
     "{comment} - IncreaseFontSize  Increases the font size by 1 pixel.\n"
     "{comment} - IncreaseOpacity   Increases the default-background opacity by 5%.\n"
     "{comment} - NewTerminal       Spawns a new terminal at the current terminals current working "
@@ -792,6 +910,7 @@ constexpr StringLiteral InputMappingsConfig {
     "when disabling all others).\n"
     "{comment} - ToggleFullScreen  Enables/disables full screen mode.\n"
     "{comment} - ToggleInputProtection Enables/disables terminal input protection.\n"
+    "{comment} - TogglePerformanceHud Shows/hides an overlay with runtime performance statistics.\n"
     "{comment} - ToggleStatusLine  Shows/hides the VT320 compatible Indicator status line.\n"
     "{comment} - ToggleTitleBar    Shows/Hides titlebar\n"
     "{comment} - TraceBreakAtEmptyQueue Executes any pending VT sequence from the VT sequence buffer in "
@@ -819,6 +938,39 @@ constexpr StringLiteral SpawnNewProcessConfig {
     "spawn_new_process: {} \n"
 };
 
+constexpr StringLiteral HibernateAfterConfig {
+    "\n"
+    "{comment} Time in minutes after which tabs that have not been visible are hibernated, \n"
+    "{comment} freeing most of the memory they need for being displayed. 0 never hibernates tabs. \n"
+    "{comment} Hibernated tabs keep processing their output and are revived when being activated. \n"
+    "hibernate_after: {} \n"
+};
+
+constexpr StringLiteral TrimMemoryAfterConfig {
+    "\n"
+    "{comment} Time in seconds after which tabs that have not received any output are trimmed, \n"
+    "{comment} compacting their scrollback and returning unused memory to the operating system. \n"
+    "{comment} 0 never trims tabs. \n"
+    "trim_memory_after: {} \n"
+};
+
+constexpr StringLiteral MemoryBudgetConfig {
+    "\n"
+    "{comment} Total memory in MiB all tabs may use together, as accounted per tab, before memory is \n"
+    "{comment} reclaimed from them, the least recently shown tabs first: compressing their scrollback, \n"
+    "{comment} discarding images scrolled out of view, freeing the render caches of hidden windows, \n"
+    "{comment} and at last dropping the oldest scrollback lines. 0 disables the budget. \n"
+    "memory_budget: {} \n"
+};
+
+constexpr StringLiteral MetricsSocketConfig {
+    "\n"
+    "{comment} Local socket to serve performance metrics on, e.g. for scraping by Prometheus. \n"
+    "{comment} Metrics are written in the Prometheus text format, or as JSON if the request asks for \n"
+    "{comment} `json`, e.g. `GET /metrics.json`. No metrics are served if this is empty. \n"
+    "metrics_socket: \"{}\" \n"
+};
+
 constexpr unsigned DefaultEarlyExitThreshold = 5u;
 constexpr StringLiteral EarlyExitThresholdConfig { "\n"
                                                    "{comment} Time in seconds to check for early threshold \n"
@@ -840,6 +992,17 @@ constexpr StringLiteral ImagesConfig {
     "    {comment} maximum height in pixels of an image to be accepted (0 defaults to system screen pixel "
     "height) \n"
     "    max_height: {} \n"
+    "\n"
+    "    {comment} Megabytes of uncompressed image data kept in memory per session. Beyond that, the least \n"
+    "    {comment} recently used images (e.g. the ones scrolled off deep into the history) are kept \n"
+    "    {comment} compressed, and decompressed again when being displayed. \n"
+    "    max_memory: {} \n"
+    "\n"
+    "    {comment} Lets applications using the kitty graphics protocol have images read from files, \n"
+    "    {comment} temporary files and shared memory they name, rather than only transmitted directly. \n"
+    "    {comment} Anything writing to the terminal can name them, including remote hosts, so only \n"
+    "    {comment} enable this if you trust everything run in the terminal. \n"
+    "    kitty_local_media: {} \n"
 };
 
 constexpr StringLiteral ExperimentalFeaturesConfig {
@@ -1077,6 +1240,25 @@ constexpr StringLiteral PTYBufferObjectSizeWeb {
     "should be changed carefully. The default value is `1048576`."
 };
 
+constexpr StringLiteral PTYBufferAllocationWeb {
+    "option sets how the storage of PTY Buffer Objects is allocated, either `heap`, "
+    "`transparent_huge_pages` or `huge_tlb`. Huge pages may reduce TLB misses for applications producing "
+    "a lot of output, but round each PTY Buffer Object up to 2 MB. The default value is `heap`."
+};
+
+constexpr StringLiteral PTYReaderThreadWeb {
+    "option enables reading from the PTY on a dedicated thread, while the previously read output is being "
+    "parsed. This may improve throughput for applications producing a lot of output. The default value is "
+    "`false`."
+};
+
+constexpr StringLiteral SharedInputThreadsWeb {
+    "option enables processing the output of all terminal sessions on a shared pool of threads, sized by "
+    "the number of CPU cores, instead of on a thread of its own each. Sessions that can not be processed "
+    "this way, or that use the PTY reader thread, still get a thread of their own. The default value is "
+    "`false`."
+};
+
 constexpr StringLiteral DefaultProfilesWeb {
     "option determines the default profile to use in the terminal."
 };
@@ -1090,6 +1272,32 @@ constexpr StringLiteral EarlyExitThresholdWeb {
 constexpr StringLiteral SpawnNewProcessWeb { "flag determines whether a new process should be spawned when "
                                              "creating a new terminal. The default value is `false`." };
 
+constexpr StringLiteral HibernateAfterWeb {
+    "option sets the time in minutes after which tabs that have not been visible are hibernated, which frees "
+    "most of the memory they need for being displayed. Hibernated tabs keep processing their output and are "
+    "revived when being activated. The default value is `0`, which never hibernates tabs."
+};
+
+constexpr StringLiteral TrimMemoryAfterWeb {
+    "option sets the time in seconds after which tabs that have not received any output are trimmed, which "
+    "compacts their scrollback, releases unused buffers, and returns free memory to the operating system. "
+    "The default value is `60`. A value of `0` never trims tabs."
+};
+
+constexpr StringLiteral MemoryBudgetWeb {
+    "option sets the total memory in MiB that all tabs may use together before memory is reclaimed from "
+    "them, starting with the tabs shown least recently. Their scrollback is compressed first, then images "
+    "scrolled out of view are discarded, the render caches of hidden windows are freed, and at last the "
+    "oldest scrollback lines are dropped. The default value is `0`, which disables the budget."
+};
+
+constexpr StringLiteral MetricsSocketWeb {
+    "option sets the local socket to serve performance metrics on, such as bytes parsed, VT sequences "
+    "processed, frames rendered and dropped, input latency, and memory per session. Metrics are written in "
+    "the Prometheus text format, or as JSON if the request asks for `json`. The default value is empty, "
+    "which serves no metrics."
+};
+
 constexpr StringLiteral ReflowOnResizeWeb {
     "option controls whether or not the lines in the terminal should be reflowed when a resize event occurs. "
     "The default value is `true`."
@@ -1115,8 +1323,8 @@ constexpr StringLiteral LiveWeb { "option determines whether the instance should
 
 constexpr StringLiteral ImagesWeb {
     "section contains configuration options related to inline images. It includes options like "
-    "`sixel_scrolling`, `sixel_register_count`, `max_width`, and `max_height` to control various aspects of "
-    "image rendering and limits."
+    "`sixel_scrolling`, `sixel_register_count`, `max_width`, `max_height`, `max_memory`, and "
+    "`kitty_local_media` to control various aspects of image rendering and limits."
 };
 
 constexpr StringLiteral ProfilesWeb { "All profiles inside configuration files share parent node `profiles`. "
@@ -1179,6 +1387,10 @@ constexpr StringLiteral SshHostConfigWeb {
     "      public_key: \"path/to/key.pub\"\n"
     "      known_hosts: \"~/.ssh/known_hosts\"\n"
     "      forward_agent: false\n"
+    "      compression: false\n"
+    "      window_size: 16777216\n"
+    "      packet_size: 32768\n"
+    "      share_connection: true\n"
     "```\n"
     "\n"
     "Note, only `host` option is required. Everything else is defaulted.\n"
@@ -1199,6 +1411,16 @@ constexpr StringLiteral SshHostConfigWeb {
     ":octicons-horizontal-rule-16: ==ssh.forward_agent== Boolean, indicating wether or not the local SSH "
     "auth agent should be requested to be forwarded. Note: this is currently not working due to an issue "
     "related to the underlying library being used, but is hopefully resolved soon.\n"
+    ":octicons-horizontal-rule-16: ==ssh.compression== Boolean, indicating whether or not to compress the "
+    "SSH connection (defaults to `false`).\n"
+    ":octicons-horizontal-rule-16: ==ssh.window_size== Size of the receive window of the SSH channel in "
+    "bytes (defaults to `16777216`). The throughput is at most the window size divided by the round-trip "
+    "time, so increase this value for fast links with high latency.\n"
+    ":octicons-horizontal-rule-16: ==ssh.packet_size== Maximum size of an SSH channel packet in bytes "
+    "(defaults to `32768`).\n"
+    ":octicons-horizontal-rule-16: ==ssh.share_connection== Boolean, indicating whether or not sessions to "
+    "the same host, port and user share a single SSH connection, each opening a channel of its own "
+    "(defaults to `true`). This saves the key exchange and authentication for every but the first one.\n"
     "\n"
     "Note, custom environment variables may be passed as well, when connecting to an SSH server using this "
     "builtin-feature. Mind,\n"
@@ -1300,6 +1522,8 @@ constexpr StringLiteral HistoryWeb {
     "      limit: 1000\n"
     "      auto_scroll_on_update: true\n"
     "      scroll_multiplier: 3\n"
+    "      spill_to_disk: false\n"
+    "      restore_on_launch: false\n"
     "```\n"
     ":octicons-horizontal-rule-16: ==limit== This option specifies the number of lines to preserve in the "
     "terminal's history. A value of -1 indicates unlimited history, meaning that all lines are preserved. In "
@@ -1312,6 +1536,26 @@ constexpr StringLiteral HistoryWeb {
     "when the ScrollUp or ScrollDown events occur. By default, scrolling up or down moves three lines at a "
     "time. You can adjust this value as needed. In the provided example, scroll_multiplier is set to 3. "
     "<br/>\n"
+    ":octicons-horizontal-rule-16: ==spill_to_disk== This boolean option determines whether lines that "
+    "exceed the history limit are appended to a per-session file on disk instead of being discarded. "
+    "They are read back into the history when scrolling, searching or moving the vi cursor beyond it. "
+    "The file is deleted when the session is closed. <br/>\n"
+    ":octicons-horizontal-rule-16: ==restore_on_launch== This boolean option determines whether the "
+    "history of the open sessions is saved when contour exits, and pushed into the history of the "
+    "corresponding sessions when contour is launched again. <br/>\n"
+    "\n"
+};
+
+constexpr StringLiteral CellLayoutWeb {
+    "configuration option selects how the cells of the primary and alternate screen are stored in memory. "
+    "With `compact`, rarely used cell data such as hyperlinks and images is kept out of line, which keeps "
+    "long histories small. With `simple`, all cell data is kept inline, which favors contents making heavy "
+    "use of images and hyperlinks. The layout only applies to terminal sessions created afterwards.\n"
+    "``` yaml\n"
+    "profiles:\n"
+    "  profile_name:\n"
+    "    cell_layout: compact\n"
+    "```\n"
     "\n"
 };
 
@@ -1341,10 +1585,15 @@ constexpr StringLiteral MouseWeb {
     "  profile_name:\n"
     "    mouse:\n"
     "      hide_while_typing: true\n"
+    "      pixel_move_interval: 8\n"
     "```\n"
     ":octicons-horizontal-rule-16: ==hide_while_typing== This boolean option determines whether the mouse "
     "cursor should be hidden while typing in the terminal. When set to true, the mouse cursor will be hidden "
     "when you start typing. When set to false, the mouse cursor will remain visible while typing. <br/>\n"
+    ":octicons-horizontal-rule-16: ==pixel_move_interval== This option sets the minimum time in milliseconds "
+    "between two mouse move reports while an application tracks the mouse pixel-precise (SGR-Pixels). "
+    "Moves within that time are merged into the last one. Mouse moves in cell-precise tracking are only "
+    "reported when entering another cell. <br/>\n"
     "\n"
 };
 
@@ -1509,6 +1758,20 @@ constexpr StringLiteral ModeVisualWeb {
     "\n"
 };
 
+constexpr StringLiteral PredictiveEchoThresholdWeb {
+    "option in the configuration lets typed text and cursor moves be echoed locally ahead of the "
+    "application, once the measured latency between key input and the application's answer reaches the "
+    "given number of milliseconds, as over SSH connections to far away hosts. The local echo is shown "
+    "underlined until the application's own echo confirms it, and is rolled back if it does not show up "
+    "in due time. A value of 0 disables predicting the echo.\n"
+    "``` yaml\n"
+    "profiles:\n"
+    "  profile_name:\n"
+    "    predictive_echo_threshold: 100\n"
+    "```\n"
+    "\n"
+};
+
 constexpr StringLiteral HighlightTimeoutWeb {
     "option in the configuration determines the duration in milliseconds for which the yank highlight is "
     "shown in vi mode. After yanking (copying) text in vi mode, the yanked text is typically highlighted "
@@ -1748,6 +2011,7 @@ using Margins = DocumentationEntry<MarginsConfig, MarginsWeb>;
 using TerminalSize = DocumentationEntry<TerminalSizeConfig, TerminalSizeWeb>;
 using TerminalId = DocumentationEntry<TerminalIdConfig, TerminalIdWeb>;
 using History = DocumentationEntry<HistoryConfig, HistoryWeb>;
+using CellLayout = DocumentationEntry<CellLayoutConfig, CellLayoutWeb>;
 using Scrollbar = DocumentationEntry<ScrollbarConfig, ScrollbarWeb>;
 using StatusLine = DocumentationEntry<StatusLineConfig, StatusLineWeb>;
 using OptionKeyAsAlt = DocumentationEntry<OptionKeyAsAltConfig, OptionKeyAsAltWeb>;
@@ -1761,6 +2025,7 @@ using ModeInsert = DocumentationEntry<ModeInsertConfig, ModeInsertWeb>;
 using ModeNormal = DocumentationEntry<ModeNormalConfig, ModeNormalWeb>;
 using ModeVisual = DocumentationEntry<ModeVisualConfig, ModeVisualWeb>;
 using SmoothLineScrolling = DocumentationEntry<SmoothLineScrollingConfig, SmoothLineScrollingWeb>;
+using PredictiveEchoThreshold = DocumentationEntry<PredictiveEchoThresholdConfig, PredictiveEchoThresholdWeb>;
 using HighlightTimeout = DocumentationEntry<HighlightTimeoutConfig, HighlightTimeoutWeb>;
 using HighlightDoubleClickerWord =
     DocumentationEntry<HighlightDoubleClickerWordConfig, HighlightDoubleClickerWordWeb>;
@@ -1772,6 +2037,9 @@ using PlatformPlugin = DocumentationEntry<PlatformPluginConfig, PlatformPluginWe
 using Renderer = DocumentationEntry<RendererConfig, RendererWeb>;
 using PTYReadBufferSize = DocumentationEntry<PTYReadBufferSizeConfig, PTYReadBufferSizeWeb>;
 using PTYBufferObjectSize = DocumentationEntry<PTYBufferObjectSizeConfig, PTYBufferObjectSizeWeb>;
+using PTYBufferAllocation = DocumentationEntry<PTYBufferAllocationConfig, PTYBufferAllocationWeb>;
+using PTYReaderThread = DocumentationEntry<PTYReaderThreadConfig, PTYReaderThreadWeb>;
+using SharedInputThreads = DocumentationEntry<SharedInputThreadsConfig, SharedInputThreadsWeb>;
 using ReflowOnResize = DocumentationEntry<ReflowOnResizeConfig, ReflowOnResizeWeb>;
 using ColorSchemes = DocumentationEntry<ColorSchemesConfig, Dummy>;
 using Profiles = DocumentationEntry<ProfilesConfig, ProfilesWeb>;
@@ -1785,6 +2053,10 @@ using MouseBlockSelectionModifiers =
     DocumentationEntry<MouseBlockSelectionModifiersConfig, MouseBlockSelectionModifiersWeb>;
 using InputMappings = DocumentationEntry<InputMappingsConfig, Dummy>;
 using SpawnNewProcess = DocumentationEntry<SpawnNewProcessConfig, SpawnNewProcessWeb>;
+using HibernateAfter = DocumentationEntry<HibernateAfterConfig, HibernateAfterWeb>;
+using TrimMemoryAfter = DocumentationEntry<TrimMemoryAfterConfig, TrimMemoryAfterWeb>;
+using MemoryBudget = DocumentationEntry<MemoryBudgetConfig, MemoryBudgetWeb>;
+using MetricsSocket = DocumentationEntry<MetricsSocketConfig, MetricsSocketWeb>;
 using EarlyExitThreshold = DocumentationEntry<EarlyExitThresholdConfig, EarlyExitThresholdWeb>;
 using Images = DocumentationEntry<ImagesConfig, ImagesWeb>;
 using ExperimentalFeatures = DocumentationEntry<ExperimentalFeaturesConfig, StringLiteral { "" }>;
@@ -298,11 +298,22 @@ renderer:
     tile_hashtable_slots: 4096
     tile_cache_count: 4000
     tile_direct_mapping: true
+    glyph_disk_cache: false
+    async_glyph_rasterization: true
+    bulk_output_frame_interval: 33
+    variable_refresh_rate: false
+    render_thread: false
 word_delimiters: " /\\()\"'-.,:;<>~!@#$%^&*+=[]{}~?|│"
 read_buffer_size: 16384
 pty_buffer_size: 1048576
+pty_buffer_allocation: heap
+pty_reader_thread: false
+shared_input_threads: false
 default_profile: main
 spawn_new_process: false
+hibernate_after: 0
+trim_memory_after: 60
+metrics_socket: ""
 reflow_on_resize: true
 bypass_mouse_protocol_modifier: Shift
 mouse_block_selection_modifier: Control
@@ -313,6 +324,7 @@ images:
     sixel_register_count: 4096
     max_width: 0
     max_height: 0
+    max_memory: 256
 
 ```
 
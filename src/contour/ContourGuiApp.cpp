@@ -1,17 +1,23 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <contour/Config.h>
 #include <contour/ContourGuiApp.h>
+#include <contour/StartupTimeline.h>
 #include <contour/display/TerminalDisplay.h>
 
 #include <vtpty/Process.h>
+#include <vtpty/RecordingPty.h>
 
 #include <text_shaper/font_locator.h>
 
 #include <crispy/CLI.h>
 #include <crispy/logstore.h>
+#include <crispy/tracing.h>
 #include <crispy/utils.h>
 
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
 #include <QtCore/QProcess>
+#include <QtCore/QTemporaryDir>
 #include <QtQml/qqmlextensionplugin.h>
 #if !defined(__APPLE__) && !defined(_WIN32)
     #include <QtDBus/QDBusConnection>
@@ -25,8 +31,15 @@
 #include <QtQml/QQmlContext>
 #include <QtWidgets/QApplication>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <filesystem>
+#include <format>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 using std::bind;
@@ -55,6 +68,7 @@ ContourGuiApp::ContourGuiApp(): _sessionManager(*this)
 {
     link("contour.terminal", bind(&ContourGuiApp::terminalGuiAction, this));
     link("contour.font-locator", bind(&ContourGuiApp::fontConfigAction, this));
+    link("contour.benchmark.startup", bind(&ContourGuiApp::benchmarkStartupAction, this));
     link("contour.info.config", bind(&ContourGuiApp::checkConfig, this));
 }
 
@@ -85,8 +99,14 @@ crispy::cli::command ContourGuiApp::parameterDefinition() const
                     "profile", CLI::value { ""s }, "Terminal Profile to load (overriding config).", "NAME" },
                 CLI::option { "debug",
                               CLI::value { ""s },
-                              "Enables debug logging, using a comma (,) seperated list of tags.",
+                              "Enables debug logging, using a comma (,) seperated list of tags. Tags may "
+                              "contain wildcards (* and ?), and a leading - excludes matching tags, "
+                              "e.g. vt.*,-vt.renderbuffer.",
                               "TAGS" },
+                CLI::option { "debug-async",
+                              CLI::value { false },
+                              "Writes debug logging from a background thread, dropping messages rather than "
+                              "slowing down the terminal when they are logged faster than written." },
             },
         });
 
@@ -104,9 +124,24 @@ crispy::cli::command ContourGuiApp::parameterDefinition() const
                     "profile", CLI::value { ""s }, "Terminal Profile to load (overriding config).", "NAME" },
                 CLI::option { "debug",
                               CLI::value { ""s },
-                              "Enables debug logging, using a comma (,) seperated list of tags.",
+                              "Enables debug logging, using a comma (,) seperated list of tags. Tags may "
+                              "contain wildcards (* and ?), and a leading - excludes matching tags, "
+                              "e.g. vt.*,-vt.renderbuffer.",
                               "TAGS" },
+                CLI::option { "debug-async",
+                              CLI::value { false },
+                              "Writes debug logging from a background thread, dropping messages rather than "
+                              "slowing down the terminal when they are logged faster than written." },
                 CLI::option { "live-config", CLI::value { false }, "Enables live config reloading." },
+                CLI::option { "measure-startup",
+                              CLI::value { false },
+                              "Exits as soon as the first frame has been presented, printing the time each "
+                              "phase of startup has been reached at, as JSON." },
+                CLI::option { "trace",
+                              CLI::value { ""s },
+                              "Records a trace of startup and rendering into the given file, in Chrome "
+                              "trace event format, viewable in chrome://tracing or ui.perfetto.dev.",
+                              "FILE" },
                 CLI::option {
                     "dump-state-at-exit",
                     CLI::value { ""s },
@@ -131,6 +166,30 @@ crispy::cli::command ContourGuiApp::parameterDefinition() const
                               CLI::value { ""s },
                               "Sets the sessioni ID used for resuming a prior session.",
                               "SESSION_ID" },
+                CLI::option { "record",
+                              CLI::value { ""s },
+                              "Records the PTY of the first terminal session into the given file, "
+                              "with timestamps, to be replayed later.",
+                              "FILE" },
+                CLI::option { "replay",
+                              CLI::value { ""s },
+                              "Replays the given PTY recording instead of running the shell.",
+                              "FILE" },
+                CLI::option { "replay-pacing",
+                              CLI::value { "realtime"s },
+                              "Replays the recorded output as recorded, or as fast as it is processed.",
+                              "realtime|fast" },
+                CLI::option { "view",
+                              CLI::value { ""s },
+                              "Shows the given file, such as a log, in the scrollback to be scrolled through "
+                              "and searched, instead of running the shell. The file is read straight into "
+                              "the terminal, without any program or PTY in between.",
+                              "FILE" },
+                CLI::option { "view-history-limit",
+                              CLI::value { 1000000u },
+                              "Keeps at most the given number of lines of a file shown with --view in the "
+                              "scrollback, its earlier lines being dropped.",
+                              "COUNT" },
 #if defined(__linux__)
                 CLI::option {
                     "display", CLI::value { ""s }, "Sets the X11 display to connect to.", "DISPLAY_ID" },
@@ -148,10 +207,48 @@ crispy::cli::command ContourGuiApp::parameterDefinition() const
             CLI::verbatim { "PROGRAM ARGS...",
                             "Executes given program instead of the one provided in the configuration." } });
 
+    command.children.push_back(CLI::command {
+        "benchmark",
+        "Benchmarks the terminal.",
+        CLI::option_list {},
+        CLI::command_list { CLI::command {
+            "startup",
+            "Starts the terminal repeatedly, until its first frame has been presented, and summarizes the "
+            "time each phase of startup has been reached at.",
+            CLI::option_list {
+                CLI::option { "config",
+                              CLI::value { contour::config::defaultConfigFilePath() },
+                              "Path to configuration file to start the terminal with.",
+                              "FILE" },
+                CLI::option { "profile", CLI::value { ""s }, "Terminal Profile to start.", "NAME" },
+                CLI::option { "iterations", CLI::value { 10u }, "Number of measured runs.", "COUNT" },
+                CLI::option { "cold",
+                              CLI::value { false },
+                              "Starts each run with an empty cache directory (XDG_CACHE_HOME), rather than "
+                              "after a warm-up run that populates the caches." },
+                CLI::option { "json", CLI::value { false }, "Prints the summary as JSON." },
+            },
+            CLI::command_list {},
+            CLI::command_select::Explicit,
+            CLI::verbatim {
+                "PROGRAM ARGS...",
+                "Executes given program, e.g. /bin/true, instead of the configured shell." } } } });
+
     // NOLINTEND
     return command;
 }
 
+vtbackend::InputReactor* ContourGuiApp::inputReactor()
+{
+    if (!config().sharedInputThreads.value())
+        return nullptr;
+
+    if (!_inputReactor)
+        _inputReactor = std::make_unique<vtbackend::InputReactor>();
+
+    return _inputReactor.get();
+}
+
 std::chrono::seconds ContourGuiApp::earlyExitThreshold() const
 {
     auto const configThreshold = config().earlyExitThreshold.value();
@@ -175,8 +272,8 @@ string ContourGuiApp::profileName() const
     if (!_config.defaultProfileName.value().empty())
         return _config.defaultProfileName.value();
 
-    if (_config.profiles.value().size() == 1)
-        return _config.profiles.value().begin()->first;
+    if (auto const names = _config.profileNames(); names.size() == 1)
+        return names.front();
 
     return ""s;
 }
@@ -189,12 +286,19 @@ std::optional<fs::path> ContourGuiApp::dumpStateAtExit() const
     return fs::path(path);
 }
 
+vtpty::ReplayPty::Pacing ContourGuiApp::ptyReplayPacing() const
+{
+    if (parameters().get<std::string>("contour.terminal.replay-pacing") == "fast")
+        return vtpty::ReplayPty::Pacing::Fast;
+    return vtpty::ReplayPty::Pacing::RealTime;
+}
+
 void ContourGuiApp::onExit(TerminalSession& session)
 {
-    if (auto const* localProcess = dynamic_cast<vtpty::Process const*>(&session.terminal().device()))
+    if (auto const* localProcess = vtpty::ptyAs<vtpty::Process>(session.terminal().device()))
         _exitStatus = localProcess->checkStatus();
 #if defined(VTPTY_LIBSSH2)
-    else if (auto const* sshSession = dynamic_cast<vtpty::SshSession const*>(&session.terminal().device()))
+    else if (auto const* sshSession = vtpty::ptyAs<vtpty::SshSession>(session.terminal().device()))
         _exitStatus = sshSession->exitStatus();
 #endif
 }
@@ -242,6 +346,8 @@ bool ContourGuiApp::loadConfig(string const& target)
     if (auto const filterString = flags.get<string>(prefix + "debug"); !filterString.empty())
     {
         logstore::configure(filterString);
+        if (flags.boolean(prefix + "debug-async"))
+            logstore::sink::console().set_async(true);
     }
 
     auto const configPath = QString::fromStdString(flags.get<string>(prefix + "config"));
@@ -253,13 +359,11 @@ bool ContourGuiApp::loadConfig(string const& target)
 
     if (!_config.profile(profileName()))
     {
-        auto const s =
-            accumulate(begin(_config.profiles.value()),
-                       end(_config.profiles.value()),
-                       ""s,
-                       [](string const& acc, auto const& profile) -> string {
-                           return acc.empty() ? profile.first : std::format("{}, {}", acc, profile.first);
-                       });
+        auto const names = _config.profileNames();
+        auto const s = accumulate(
+            begin(names), end(names), ""s, [](string const& acc, string const& name) -> string {
+                return acc.empty() ? name : std::format("{}, {}", acc, name);
+            });
         configLogger(
             std::format("No profile with name '{}' found. Available profiles: {}", profileName(), s));
     }
@@ -340,10 +444,172 @@ int ContourGuiApp::fontConfigAction()
     return EXIT_SUCCESS;
 }
 
+namespace
+{
+    /// The time each phase of startup has been reached at in one run, in milliseconds since the start
+    /// of the process, and the time until the process has exited, as seen by its parent.
+    struct StartupSample
+    {
+        std::array<std::optional<double>, startup::PhaseCount> phases {};
+        double exited = 0.0;
+    };
+
+    struct StartupStatistics
+    {
+        double min = 0.0;
+        double median = 0.0;
+        double max = 0.0;
+    };
+
+    std::optional<StartupStatistics> statisticsOf(vector<double> values)
+    {
+        if (values.empty())
+            return std::nullopt;
+        std::ranges::sort(values);
+        auto const middle = values.size() / 2;
+        auto const median = values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+        return StartupStatistics { .min = values.front(), .median = median, .max = values.back() };
+    }
+
+    /// Runs `contour terminal measure-startup` with the given arguments once, and reads back the
+    /// startup timeline it prints as the last line of its standard output.
+    std::optional<StartupSample> measureStartup(QStringList const& arguments, QTemporaryDir const* cacheHome)
+    {
+        auto process = QProcess {};
+        if (cacheHome)
+        {
+            auto environment = QProcessEnvironment::systemEnvironment();
+            environment.insert("XDG_CACHE_HOME", cacheHome->path());
+            process.setProcessEnvironment(environment);
+        }
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+        auto const start = std::chrono::steady_clock::now();
+        process.start(QCoreApplication::applicationFilePath(), arguments);
+        if (!process.waitForFinished(60'000))
+        {
+            errorLog()("Terminal did not finish starting up: {}", process.errorString().toStdString());
+            process.kill();
+            process.waitForFinished();
+            return std::nullopt;
+        }
+        auto const exited =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+        auto const output = process.readAllStandardOutput().trimmed().split('\n');
+        auto const document = QJsonDocument::fromJson(output.last());
+        if (!document.isObject())
+        {
+            errorLog()("Terminal did not print its startup timeline (exit code {}).", process.exitCode());
+            return std::nullopt;
+        }
+
+        auto sample = StartupSample { .exited = exited.count() };
+        for (auto const phase: startup::Phases)
+        {
+            auto const phaseName = startup::name(phase);
+            auto const key = QLatin1String(phaseName.data(), static_cast<int>(phaseName.size()));
+            if (auto const value = document.object().value(key); value.isDouble())
+                sample.phases[static_cast<size_t>(phase)] = value.toDouble();
+        }
+        return sample;
+    }
+} // namespace
+
+int ContourGuiApp::benchmarkStartupAction()
+{
+    auto const& flags = parameters();
+    auto const iterations = std::max(flags.get<unsigned>("contour.benchmark.startup.iterations"), 1u);
+    auto const cold = flags.get<bool>("contour.benchmark.startup.cold");
+
+    // QProcess requires an application instance, though not its event loop.
+    auto argc = _argc;
+    QCoreApplication const app(argc, (char**) _argv);
+
+    auto arguments = QStringList { "terminal", "measure-startup" };
+    arguments << "config" << QString::fromStdString(flags.get<string>("contour.benchmark.startup.config"));
+    if (auto const& profile = flags.get<string>("contour.benchmark.startup.profile"); !profile.empty())
+        arguments << "profile" << QString::fromStdString(profile);
+    if (!flags.verbatim.empty())
+    {
+        arguments << "--";
+        for (auto const argument: flags.verbatim)
+            arguments << QString::fromUtf8(argument.data(), static_cast<int>(argument.size()));
+    }
+
+    // Warm runs are preceded by one that populates the caches, such as those of fontconfig and glyphs,
+    // while cold runs start off empty caches of their own.
+    if (!cold && !measureStartup(arguments, nullptr))
+        return EXIT_FAILURE;
+
+    auto samples = vector<StartupSample> {};
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        auto const cacheHome = cold ? make_unique<QTemporaryDir>() : nullptr;
+        if (auto sample = measureStartup(arguments, cacheHome.get()))
+            samples.emplace_back(*sample);
+    }
+    if (samples.empty())
+        return EXIT_FAILURE;
+
+    auto rows = vector<std::pair<string_view, StartupStatistics>> {};
+    for (auto const phase: startup::Phases)
+    {
+        auto values = vector<double> {};
+        for (auto const& sample: samples)
+            if (auto const value = sample.phases[static_cast<size_t>(phase)])
+                values.push_back(*value);
+        if (auto const statistics = statisticsOf(std::move(values)))
+            rows.emplace_back(startup::name(phase), *statistics);
+    }
+    auto exitTimes = vector<double> {};
+    for (auto const& sample: samples)
+        exitTimes.push_back(sample.exited);
+    rows.emplace_back("exited", *statisticsOf(std::move(exitTimes)));
+
+    auto const cache = string_view(cold ? "cold" : "warm");
+    if (flags.get<bool>("contour.benchmark.startup.json"))
+    {
+        auto json = std::format(R"({{"cache":"{}","iterations":{},"failures":{},"phases":{{)",
+                                cache,
+                                samples.size(),
+                                iterations - samples.size());
+        auto separator = string_view {};
+        for (auto const& [phaseName, statistics]: rows)
+        {
+            json += std::format(R"({}"{}":{{"min":{:.3f},"median":{:.3f},"max":{:.3f}}})",
+                                std::exchange(separator, ","),
+                                phaseName,
+                                statistics.min,
+                                statistics.median,
+                                statistics.max);
+        }
+        std::cout << json << "}}\n";
+    }
+    else
+    {
+        std::cout << std::format(
+            "Startup over {} {} runs, in milliseconds since process start:\n\n", samples.size(), cache);
+        std::cout << std::format("{:<20} {:>10} {:>10} {:>10}\n", "phase", "min", "median", "max");
+        for (auto const& [phaseName, statistics]: rows)
+            std::cout << std::format("{:<20} {:>10.2f} {:>10.2f} {:>10.2f}\n",
+                                     phaseName,
+                                     statistics.min,
+                                     statistics.median,
+                                     statistics.max);
+    }
+
+    return samples.size() == iterations ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int ContourGuiApp::terminalGuiAction()
 {
+    if (auto const tracePath = parameters().get<string>("contour.terminal.trace"); !tracePath.empty())
+        crispy::tracing::start(tracePath);
+
     if (!loadConfig("terminal"))
         return EXIT_FAILURE;
+    startup::mark(startup::Phase::ConfigLoaded);
 
 #if defined(__APPLE__)
     QGuiApplication::setAttribute(Qt::AA_MacDontSwapCtrlAndMeta, true);
@@ -357,17 +623,49 @@ int ContourGuiApp::terminalGuiAction()
         case config::RenderingBackend::Software:
             QGuiApplication::setAttribute(Qt::AA_UseSoftwareOpenGL, true);
             break;
+        case config::RenderingBackend::Vulkan:
+#if !defined(CONTOUR_RHI_RENDERER)
+            errorLog()("Vulkan rendering is not supported by this build. Falling back to OpenGL.");
+#endif
+            break;
         case config::RenderingBackend::Default:
             // Don't do anything.
             break;
     }
 
+    // Only the threaded render loop has a render thread to schedule frames from.
+    if (_config.renderer.value().renderThread && qEnvironmentVariableIsEmpty("QSG_RENDER_LOOP"))
+        qputenv("QSG_RENDER_LOOP", "threaded");
+
     auto const* profile = _config.profile(profileName());
     if (!profile)
     {
         errorLog()("Could not access configuration profile.");
         return EXIT_FAILURE;
     }
+
+    try
+    {
+        if (auto const path = parameters().get<string>("contour.terminal.replay"); !path.empty())
+            _ptyReplay = vtpty::PtyRecording::load(path);
+        if (auto const path = parameters().get<string>("contour.terminal.view"); !path.empty())
+        {
+            if (!fs::is_regular_file(path))
+                throw std::runtime_error(std::format("Cannot view {}, as it is not a file.", path));
+            _viewedFile = fs::path(path);
+            // Much more of the file than of a shell's output is kept in the scrollback, though bounded.
+            auto const historyLimit = parameters().get<unsigned>("contour.terminal.view-history-limit");
+            _config.profile(profileName())->history.value().maxHistoryLineCount =
+                vtbackend::LineCount::cast_from(historyLimit);
+        }
+        if (auto const path = parameters().get<string>("contour.terminal.record"); !path.empty())
+            _ptyRecorder = make_unique<vtpty::PtyRecorder>(path);
+    }
+    catch (std::exception const& e)
+    {
+        errorLog()("{}", e.what());
+        return EXIT_FAILURE;
+    }
     auto appName = QString::fromStdString(profile->wmClass.value());
     QCoreApplication::setApplicationName(appName);
     QCoreApplication::setOrganizationName("contour");
@@ -409,6 +707,7 @@ int ContourGuiApp::terminalGuiAction()
 
     // NB: We use QApplication over QGuiApplication because we want to use SystemTrayIcon.
     QApplication const app(qtArgsCount, (char**) qtArgsPtr.data());
+    startup::mark(startup::Phase::ApplicationCreated);
 
     setupQCoreApplication();
 
@@ -431,10 +730,14 @@ int ContourGuiApp::terminalGuiAction()
     });
 #endif
 
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    // Enforce OpenGL over any other. As much as I'd love to provide other backends, too.
-    // We currently only support OpenGL.
-    // If anyone feels happy about it, I'd love to at least provide Vulkan. ;-)
+#if defined(CONTOUR_RHI_RENDERER)
+    // Vulkan is rendered onto through Qt's RHI (see RhiRenderer), anything else through OpenGL.
+    if (_config.renderer.value().renderingBackend == config::RenderingBackend::Vulkan)
+        QQuickWindow::setGraphicsApi(QSGRendererInterface::Vulkan);
+    else
+        QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
+#elif QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    // Enforce OpenGL over any other, as other graphics APIs require Qt's RHI, see CONTOUR_RHI_RENDERER.
     QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
 #endif
 
@@ -463,21 +766,33 @@ int ContourGuiApp::terminalGuiAction()
     // Spawn initial window.
     newWindow();
 
-    if (auto const& bell = config().profile().bell.value().sound; bell == "off")
+    // The bell's sound itself is loaded when first played, see TerminalSession::getBellSource().
+    if (config().profile().bell.value().sound == "off")
     {
         if (auto* bellAudioOutput = _qmlEngine->rootObjects().first()->findChild<QObject*>("BellAudioOutput");
             bellAudioOutput)
             bellAudioOutput->setProperty("muted", true);
     }
-    else if (bell != "default")
+
+    if (auto const& socket = config().metricsSocket.value(); !socket.empty())
     {
-        QUrl const path(bell.c_str());
-        if (auto* bellObject = _qmlEngine->rootObjects().first()->findChild<QObject*>("Bell"); bellObject)
-            bellObject->setProperty("source", path);
+        _metricsServer = make_unique<MetricsServer>(_metrics);
+        if (!_metricsServer->listen(socket))
+            _metricsServer.reset();
     }
 
     auto rv = QApplication::exec();
 
+    _metricsServer.reset();
+
+    if (measuresStartup())
+        std::cout << startup::toJson() << '\n' << std::flush;
+
+    if (crispy::tracing::enabled() && !crispy::tracing::stop())
+        errorLog()("Failed to write trace file.");
+
+    _sessionManager.saveSessionHistories();
+
     if (_exitStatus.has_value())
     {
 #if defined(VTPTY_LIBSSH2)
@@ -3,12 +3,19 @@
 
 #include <contour/Config.h>
 #include <contour/ContourApp.h>
+#include <contour/MetricsServer.h>
 #include <contour/TerminalSessionManager.h>
 #include <contour/helper.h>
 
+#include <vtbackend/InputReactor.h>
+
 #include <vtpty/Process.h>
+#include <vtpty/PtyRecording.h>
+#include <vtpty/ReplayPty.h>
 #include <vtpty/SshSession.h>
 
+#include <crispy/metrics.h>
+
 #include <QtDBus/QDBusVariant>
 #include <QtQml/QQmlApplicationEngine>
 
@@ -50,6 +57,22 @@ class ContourGuiApp: public QObject, public ContourApp
 
     [[nodiscard]] std::optional<std::filesystem::path> dumpStateAtExit() const;
 
+    /// @returns the PTY recording new sessions replay instead of running their shell, if requested.
+    [[nodiscard]] std::optional<vtpty::PtyRecording> const& ptyReplay() const noexcept { return _ptyReplay; }
+    [[nodiscard]] vtpty::ReplayPty::Pacing ptyReplayPacing() const;
+
+    /// @returns the file new sessions show instead of running their shell, if requested.
+    [[nodiscard]] std::optional<std::filesystem::path> const& viewedFile() const noexcept
+    {
+        return _viewedFile;
+    }
+
+    /// Hands out the recorder for the PTY of the first session, if recording has been requested.
+    [[nodiscard]] std::unique_ptr<vtpty::PtyRecorder> takePtyRecorder() noexcept
+    {
+        return std::move(_ptyRecorder);
+    }
+
     void onExit(TerminalSession& session);
 
     config::Config& config() noexcept { return _config; }
@@ -66,10 +89,24 @@ class ContourGuiApp: public QObject, public ContourApp
 
     TerminalSessionManager& sessionsManager() noexcept { return _sessionManager; }
 
+    /// @returns the reactor processing the output of all terminal sessions on shared threads,
+    ///          or nullptr if sessions are to be processed on a thread of their own each.
+    [[nodiscard]] vtbackend::InputReactor* inputReactor();
+
+    /// @returns the registry all metrics are exported from.
+    [[nodiscard]] crispy::metrics::registry& metrics() noexcept { return _metrics; }
+
     [[nodiscard]] std::chrono::seconds earlyExitThreshold() const;
 
     [[nodiscard]] std::string programPath() const { return _argv[0]; }
 
+    /// @returns true if the terminal is to exit once its first frame has been presented, printing the
+    ///          startup timeline, see StartupTimeline.h.
+    [[nodiscard]] bool measuresStartup() const
+    {
+        return parameters().get<bool>("contour.terminal.measure-startup");
+    }
+
     [[nodiscard]] static QUrl resolveResource(std::string_view path);
 
     [[nodiscard]] vtbackend::ColorPreference colorPreference() const noexcept { return _colorPreference; }
@@ -81,14 +118,22 @@ class ContourGuiApp: public QObject, public ContourApp
     int terminalGuiAction();
     int fontConfigAction();
     int checkConfig();
+    int benchmarkStartupAction();
 
     config::Config _config;
+    std::unique_ptr<vtbackend::InputReactor> _inputReactor; // created on first use, outlives all sessions
+    crispy::metrics::registry _metrics; // outlives the registrations of its collectors
     TerminalSessionManager _sessionManager;
+    std::unique_ptr<MetricsServer> _metricsServer;
 
     int _argc = 0;
     char const** _argv = nullptr;
     ExitStatus _exitStatus;
 
+    std::optional<vtpty::PtyRecording> _ptyReplay;
+    std::optional<std::filesystem::path> _viewedFile;
+    std::unique_ptr<vtpty::PtyRecorder> _ptyRecorder;
+
     vtbackend::ColorPreference _colorPreference = vtbackend::ColorPreference::Dark;
 
     std::unique_ptr<QQmlApplicationEngine> _qmlEngine;
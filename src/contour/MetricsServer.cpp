@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <contour/MetricsServer.h>
+#include <contour/helper.h>
+
+#include <QtCore/QTimer>
+
+#include <chrono>
+#include <format>
+
+using namespace std::chrono_literals;
+
+namespace contour
+{
+
+namespace
+{
+    constexpr auto MaxRequestSize = 4096;
+
+    // Clients that send no request at all are answered after this time.
+    constexpr auto RequestTimeout = 200ms;
+
+    constexpr auto AnsweredProperty = "contourMetricsAnswered";
+} // namespace
+
+MetricsServer::MetricsServer(crispy::metrics::registry const& metrics, QObject* parent):
+    QObject(parent), _metrics { metrics }
+{
+    _server.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&_server, &QLocalServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+bool MetricsServer::listen(std::string const& name)
+{
+    auto const serverName = QString::fromStdString(name);
+    QLocalServer::removeServer(serverName);
+    if (!_server.listen(serverName))
+    {
+        errorLog()("Failed to listen for metrics requests on {}: {}",
+                   name,
+                   _server.errorString().toStdString());
+        return false;
+    }
+    managerLog()("Serving metrics on {}.", _server.fullServerName().toStdString());
+    return true;
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (auto* socket = _server.nextPendingConnection())
+    {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, socket, [this, socket]() {
+            if (socket->canReadLine() || socket->bytesAvailable() >= MaxRequestSize)
+                respond(*socket);
+        });
+        QTimer::singleShot(RequestTimeout, socket, [this, socket]() { respond(*socket); });
+    }
+}
+
+void MetricsServer::respond(QLocalSocket& socket)
+{
+    if (socket.property(AnsweredProperty).toBool())
+        return;
+    socket.setProperty(AnsweredProperty, true);
+
+    auto const request = socket.readLine(MaxRequestSize).toStdString();
+    auto const json = request.find("json") != std::string::npos;
+    auto const metrics = _metrics.collect();
+    auto const body = json ? metrics.json() : metrics.prometheus();
+
+    if (request.starts_with("GET ") || request.starts_with("HEAD "))
+    {
+        auto const header = std::format("HTTP/1.0 200 OK\r\n"
+                                        "Content-Type: {}\r\n"
+                                        "Content-Length: {}\r\n"
+                                        "Connection: close\r\n"
+                                        "\r\n",
+                                        json ? "application/json" : "text/plain; version=0.0.4",
+                                        body.size());
+        socket.write(header.data(), static_cast<qint64>(header.size()));
+        if (request.starts_with("HEAD "))
+        {
+            socket.disconnectFromServer();
+            return;
+        }
+    }
+
+    socket.write(body.data(), static_cast<qint64>(body.size()));
+    socket.disconnectFromServer();
+}
+
+} // namespace contour
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <crispy/metrics.h>
+
+#include <QtCore/QObject>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include <string>
+
+namespace contour
+{
+
+/// Serves the metrics of a registry on a local socket (a named pipe on Windows).
+///
+/// Each connection is answered with the current metrics and closed. The request, if any, is
+/// the first line sent: if it mentions "json", the metrics are sent as JSON, and if it is an
+/// HTTP request, the answer is an HTTP response, so that e.g. `curl --unix-socket` can be used.
+class MetricsServer: public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit MetricsServer(crispy::metrics::registry const& metrics, QObject* parent = nullptr);
+
+    /// Starts listening on the socket of the given name or path, replacing any stale one.
+    bool listen(std::string const& name);
+
+  private:
+    void onNewConnection();
+    void respond(QLocalSocket& socket);
+
+    crispy::metrics::registry const& _metrics;
+    QLocalServer _server;
+};
+
+} // namespace contour
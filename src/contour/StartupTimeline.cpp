@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <contour/StartupTimeline.h>
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+namespace contour::startup
+{
+
+namespace
+{
+    // As close to the start of the process as we get without asking the operating system, as the
+    // static initialization of the executable happens right after it has been loaded.
+    auto const processStart = steady_clock::now(); // NOLINT(cert-err58-cpp)
+
+    // Microseconds since the start of the process, or 0 if the phase has not been reached yet.
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+    std::array<std::atomic<int64_t>, PhaseCount> reachedAt {};
+} // namespace
+
+std::string_view name(Phase phase) noexcept
+{
+    switch (phase)
+    {
+        case Phase::ConfigLoaded: return "configLoaded";
+        case Phase::ApplicationCreated: return "applicationCreated";
+        case Phase::ShellSpawned: return "shellSpawned";
+        case Phase::FontsLoaded: return "fontsLoaded";
+        case Phase::ShadersCompiled: return "shadersCompiled";
+        case Phase::FirstFrameRendered: return "firstFrameRendered";
+        case Phase::FirstFramePresented: return "firstFramePresented";
+    }
+    return "unknown";
+}
+
+bool mark(Phase phase) noexcept
+{
+    auto& slot = reachedAt[static_cast<size_t>(phase)];
+    if (slot.load(std::memory_order_relaxed) != 0)
+        return false;
+
+    // Never 0, so that a phase reached within the first microsecond still counts as reached.
+    auto const sinceStart = duration_cast<microseconds>(steady_clock::now() - processStart);
+    auto const now = std::max<int64_t>(sinceStart.count(), 1);
+    auto expected = int64_t { 0 };
+    return slot.compare_exchange_strong(expected, now, std::memory_order_relaxed);
+}
+
+std::optional<microseconds> elapsed(Phase phase) noexcept
+{
+    if (auto const value = reachedAt[static_cast<size_t>(phase)].load(std::memory_order_relaxed); value != 0)
+        return microseconds(value);
+    return std::nullopt;
+}
+
+std::string toJson()
+{
+    auto json = std::string { "{" };
+    for (auto const phase: Phases)
+    {
+        if (auto const time = elapsed(phase))
+        {
+            if (json.size() > 1)
+                json += ',';
+            json += std::format("\"{}\":{:.3f}", name(phase), static_cast<double>(time->count()) / 1000.0);
+        }
+    }
+    json += '}';
+    return json;
+}
+
+} // namespace contour::startup
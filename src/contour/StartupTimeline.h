@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/// Records when the phases of starting up the terminal have been reached the first time, relative to
+/// the start of the process, e.g. for `contour benchmark startup`.
+///
+/// Phases may be marked from any thread. Marking a phase that has been reached already costs a single
+/// relaxed atomic load.
+namespace contour::startup
+{
+
+/// The phases of startup, in the order they are usually reached.
+enum class Phase : uint8_t
+{
+    ConfigLoaded,        // the configuration has been read and parsed
+    ApplicationCreated,  // the Qt application, and thus the connection to the display server, exists
+    ShellSpawned,        // the shell, or the given program, has been started
+    FontsLoaded,         // the primary fonts have been located and loaded, creating the renderer
+    ShadersCompiled,     // the render target has been initialized, compiling and linking its shaders
+    FirstFrameRendered,  // the first render buffer has been filled and rendered
+    FirstFramePresented, // the first frame has been swapped onto the screen
+};
+
+constexpr inline auto PhaseCount = static_cast<size_t>(Phase::FirstFramePresented) + 1;
+
+constexpr inline auto Phases = std::array {
+    Phase::ConfigLoaded,    Phase::ApplicationCreated, Phase::ShellSpawned,        Phase::FontsLoaded,
+    Phase::ShadersCompiled, Phase::FirstFrameRendered, Phase::FirstFramePresented,
+};
+
+/// @returns the name of the given phase, as used in the JSON of toJson().
+[[nodiscard]] std::string_view name(Phase phase) noexcept;
+
+/// Records the given phase as reached now, unless it has been reached before.
+///
+/// @returns true if the phase has been reached the first time.
+bool mark(Phase phase) noexcept;
+
+/// @returns the time from the start of the process to when the given phase has been reached, if at all.
+[[nodiscard]] std::optional<std::chrono::microseconds> elapsed(Phase phase) noexcept;
+
+/// @returns the phases reached so far as a JSON object, mapping their names to milliseconds since
+///          the start of the process, e.g. {"configLoaded":12.5,"applicationCreated":40.1}.
+[[nodiscard]] std::string toJson();
+
+} // namespace contour::startup
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <contour/Actions.h>
 #include <contour/ContourGuiApp.h>
+#include <contour/StartupTimeline.h>
 #include <contour/TerminalSession.h>
 #include <contour/display/TerminalDisplay.h>
 #include <contour/helper.h>
@@ -11,6 +12,8 @@
 
 #include <vtpty/Process.h>
 #include <vtpty/Pty.h>
+#include <vtpty/RecordingPty.h>
+#include <vtpty/ReplayPty.h>
 #include <vtpty/SshSession.h>
 
 #include <crispy/StackTrace.h>
@@ -24,6 +27,7 @@
 #include <QtCore/QProcess>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QTimer>
+#include <QtCore/QUrl>
 #include <QtGui/QClipboard>
 #include <QtGui/QDesktopServices>
 #include <QtGui/QGuiApplication>
@@ -35,7 +39,9 @@
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <limits>
+#include <type_traits>
 
 #if defined(__OpenBSD__)
     #include <pthread_np.h>
@@ -70,6 +76,9 @@ namespace
         return std::format("{}: Unhandled exception caught ({}). {}", where, typeid(e).name(), e.what());
     }
 
+    /// Number of selected lines from which on copying them to the clipboard is announced.
+    constexpr size_t LargeClipboardCopyLineCount = 100'000;
+
     void setThreadName(char const* name)
     {
 #if defined(__APPLE__)
@@ -106,22 +115,63 @@ namespace
 #endif
     }
 
-    string strip_if(string input, bool shouldStrip)
+    /// Collapses every run of spaces, tabs, and newlines into a single space.
+    ///
+    /// @p inRun  whether the text before @p input ended in such a run, updated for the text after.
+    string collapse_whitespace(string_view input, bool& inRun)
     {
-        if (!shouldStrip)
-            return input;
+        auto output = string {};
+        output.reserve(input.size());
+        for (auto const ch: input)
+        {
+            auto const isWhitespace = ch == ' ' || ch == '\t' || ch == '\n';
+            if (!isWhitespace)
+                output += ch;
+            else if (!inRun)
+                output += ' ';
+            inRun = isWhitespace;
+        }
+        return output;
+    }
 
-        string output = input;
+    /// Streams @p text, repeated @p count times, in UTF-8 chunks with normalized line endings,
+    /// and with runs of whitespace collapsed if @p strip is set.
+    ///
+    /// Chunks are produced on demand, so that large clipboard contents are never copied as a whole.
+    vtbackend::PtyWriter::PasteSource clipboardPasteSource(QString text, unsigned count, bool strip)
+    {
+        constexpr auto ChunkSize = qsizetype { 16 * 1024 };
 
-        do
-        {
-            std::swap(input, output);
-            output = crispy::replace(input, "  ", " ");
-            output = crispy::replace(output, "\t", " ");
-            output = crispy::replace(output, "\n", " ");
-        } while (input != output);
+        auto repetition = 0u;
+        auto offset = qsizetype { 0 };
+        auto inRun = false;
+        return [text = std::move(text), count, strip, repetition, offset, inRun]() mutable -> string {
+            for (;;)
+            {
+                if (offset == text.size())
+                {
+                    if (++repetition >= count)
+                        return {};
+                    offset = 0;
+                }
 
-        return output;
+                // Neither split surrogate pairs nor CRLF line endings.
+                auto length = std::min(ChunkSize, text.size() - offset);
+                if (offset + length < text.size())
+                {
+                    auto const last = text.at(offset + length - 1);
+                    if (last.isHighSurrogate() || last == '\r')
+                        ++length;
+                }
+
+                auto chunk = normalize_crlf(text.mid(offset, length));
+                offset += length;
+                if (strip)
+                    chunk = collapse_whitespace(chunk, inRun);
+                if (!chunk.empty())
+                    return chunk;
+            }
+        };
     }
 
     vtbackend::Settings createSettingsFromConfig(config::Config const& config,
@@ -132,17 +182,27 @@ namespace
 
         settings.pageSize = profile.terminalSize.value();
         settings.ptyBufferObjectSize = config.ptyBufferObjectSize.value();
+        settings.ptyBufferObjectAllocation = config.ptyBufferAllocation.value();
         settings.ptyReadBufferSize = config.ptyReadBufferSize.value();
+        settings.ptyReaderThread = config.ptyReaderThread.value();
+        settings.bulkOutputFrameInterval = config.renderer.value().bulkOutputFrameInterval;
+        settings.variableRefreshRate = config.renderer.value().variableRefreshRate;
+        settings.cellLayout = profile.cellLayout.value();
         settings.maxHistoryLineCount = profile.history.value().maxHistoryLineCount;
+        settings.spillHistoryToDisk = profile.history.value().spillToDisk;
         settings.copyLastMarkRangeOffset = profile.copyLastMarkRangeOffset.value();
         settings.cursorBlinkInterval = profile.modeInsert.value().cursor.cursorBlinkInterval;
         settings.cursorShape = profile.modeInsert.value().cursor.cursorShape;
         settings.cursorDisplay = profile.modeInsert.value().cursor.cursorDisplay;
         settings.smoothLineScrolling = profile.smoothLineScrolling.value();
+        settings.predictiveEchoThreshold = profile.predictiveEchoThreshold.value();
         settings.wordDelimiters = unicode::from_utf8(config.wordDelimiters.value());
         settings.mouseProtocolBypassModifiers = config.bypassMouseProtocolModifiers.value();
+        settings.pixelMouseMoveInterval = profile.mouse.value().pixelMoveInterval;
         settings.maxImageSize = config.images.value().maxImageSize;
         settings.maxImageRegisterCount = config.images.value().maxImageColorRegisters;
+        settings.imageMemoryBudget = size_t { config.images.value().maxImageMemory } * 1024 * 1024;
+        settings.kittyGraphicsLocalMedia = config.images.value().kittyLocalMedia;
         settings.statusDisplayType = profile.statusLine.value().initialType;
         settings.statusDisplayPosition = profile.statusLine.value().position;
         settings.indicatorStatusLine.left = profile.statusLine.value().indicator.left;
@@ -189,6 +249,7 @@ TerminalSession::TerminalSession(unique_ptr<vtpty::Pty> pty, ContourGuiApp& app)
     _id { createSessionId() },
     _startTime { steady_clock::now() },
     _config { app.config() },
+    _inputMappings { _config.inputMappings.value() },
     _profileName { app.profileName() },
     _profile { *_config.profile(_profileName) },
     _app { app },
@@ -214,6 +275,15 @@ TerminalSession::TerminalSession(unique_ptr<vtpty::Pty> pty, ContourGuiApp& app)
     _musicalNotesBuffer.reserve(16);
     _profile = *_config.profile(_profileName); // XXX do it again. but we've to be more efficient here
     configureTerminal();
+
+    // A replay is processed at the sizes the recorded session had, whatever size the window has,
+    // and the window is asked to follow.
+    if (auto* replay = dynamic_cast<vtpty::ReplayPty*>(&_terminal.device()))
+        replay->setResizeHandler([this](vtpty::PageSize pageSize) {
+            auto const _ = std::scoped_lock { _terminal };
+            _terminal.resizeScreen(pageSize + _terminal.statusLineHeight());
+            _terminal.requestWindowResize(pageSize);
+        });
 }
 
 TerminalSession::~TerminalSession()
@@ -223,8 +293,11 @@ TerminalSession::~TerminalSession()
     _terminal.device().wakeupReader();
     if (_exitWatcherThread->isRunning())
         _exitWatcherThread->terminate();
+    if (_inputReactor)
+        _inputReactor->remove(_terminal);
     if (_screenUpdateThread)
         _screenUpdateThread->join();
+    cancelClipboardCopy();
 }
 
 void TerminalSession::detachDisplay(display::TerminalDisplay& display)
@@ -265,11 +338,22 @@ void TerminalSession::scheduleRedraw()
 void TerminalSession::start()
 {
     // ensure that we start only once
-    if (!_screenUpdateThread)
+    if (!_screenUpdateThread && !_inputReactor)
     {
         sessionLog()("Starting terminal session.");
         _terminal.device().start();
-        _screenUpdateThread = make_unique<std::thread>(bind(&TerminalSession::mainLoop, this));
+        startup::mark(startup::Phase::ShellSpawned);
+
+        auto* reactor = _app.inputReactor();
+        auto const onClosed = [this]() {
+            sessionLog()("Input processing terminating (PTY {}).",
+                         _terminal.device().isClosed() ? "closed" : "open");
+        };
+        if (reactor && reactor->add(_terminal, onClosed))
+            _inputReactor = reactor;
+        else
+            _screenUpdateThread = make_unique<std::thread>(bind(&TerminalSession::mainLoop, this));
+
         _exitWatcherThread->start(QThread::LowPriority);
     }
 }
@@ -417,14 +501,59 @@ void TerminalSession::updateColorPreference(vtbackend::ColorPreference preferenc
         return;
 
     _currentColorPreference = preference;
-    if (auto const* colorPalette = preferredColorPalette(_profile.colors.value(), preference))
+    applyColorPalette();
+}
+
+void TerminalSession::applyColorPalette()
+{
+    auto const* colorPalette = preferredColorPalette(_profile.colors.value(), _currentColorPreference);
+    if (!colorPalette)
+        return;
+
+    auto previousBackgroundImage = std::shared_ptr<vtbackend::BackgroundImage> {};
     {
+        auto const _ = scoped_lock { _terminal };
+        previousBackgroundImage = _terminal.colorPalette().backgroundImage;
         _terminal.resetColorPalette(*colorPalette);
+    }
 
-        emit backgroundColorChanged();
+    // Only the colors changed, so redrawing is all it takes.
+    scheduleRedraw();
+    emit backgroundColorChanged();
+
+    if (previousBackgroundImage != colorPalette->backgroundImage)
+    {
+        emit pathToBackgroundChanged();
+        emit opacityBackgroundChanged();
+        emit isImageBackgroundChanged();
+        emit isBlurBackgroundChanged();
     }
 }
 
+/// @returns the URL the background image is loaded from by the QML frontend, or an empty string if none.
+///
+/// QML decodes the image and shares the decoded image across all windows by this URL, so it carries
+/// the file's modification time and size as well, for an updated image to be decoded again.
+QString TerminalSession::pathToBackground() const
+{
+    auto const& backgroundImage = _terminal.colorPalette().backgroundImage;
+    auto const* path = backgroundImage ? std::get_if<fs::path>(&backgroundImage->location) : nullptr;
+    if (!path)
+        return QString();
+
+    auto url = QUrl::fromLocalFile(QString::fromStdString(path->string()));
+    auto ec = std::error_code {};
+    auto const lastWriteTime = fs::last_write_time(*path, ec);
+    if (!ec)
+    {
+        auto const fileSize = fs::file_size(*path, ec);
+        if (!ec)
+            url.setQuery(QString::fromStdString(
+                std::format("mtime={}&size={}", lastWriteTime.time_since_epoch().count(), fileSize)));
+    }
+    return url.toString();
+}
+
 void TerminalSession::requestCaptureBuffer(LineCount lines, bool logical)
 {
     if (!_display)
@@ -451,7 +580,7 @@ void TerminalSession::executePendingBufferCapture(bool allow, bool remember)
     if (!allow)
         return;
 
-    _terminal.primaryScreen().captureBuffer(capture.lines, capture.logical);
+    _terminal.visitPrimaryScreen([&](auto& screen) { screen.captureBuffer(capture.lines, capture.logical); });
 
     displayLog()("requestCaptureBuffer: Finished. Waking up I/O thread.");
     flushInput();
@@ -550,6 +679,75 @@ void TerminalSession::copyToClipboard(std::string_view data)
     _display->post([data = string(data)]() { display::TerminalDisplay::copyToClipboard(data); });
 }
 
+void TerminalSession::copySelectionToClipboard(bool selectionClipboard)
+{
+    auto snapshot = terminal().selectionTextSnapshot();
+    if (!snapshot.nextChunk)
+        return;
+
+    // A new copy supersedes the one that may still be in progress.
+    cancelClipboardCopy();
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    _clipboardCopyCancelled = cancelled;
+
+    // Large copies are announced, as it may take a moment until their text is in the clipboard.
+    // The clipboard and the notifications are handled on the GUI thread, which this session is destroyed on,
+    // and which the copy is cancelled on then. Thus checking for that there keeps them from outliving it.
+    auto const lineCount = snapshot.lineCount;
+    auto const isLarge = lineCount >= LargeClipboardCopyLineCount;
+    if (isLarge)
+        postToObject(QCoreApplication::instance(), [this, cancelled, lineCount]() {
+            if (*cancelled)
+                return;
+            emit showNotification("Copy", QString::fromStdString(std::format("Copying {} lines", lineCount)));
+        });
+
+    // The text is extracted from the snapshot without holding the terminal lock.
+    auto nextChunk = std::move(snapshot.nextChunk);
+    _clipboardCopyThread = std::thread([this,
+                                        nextChunk = std::move(nextChunk),
+                                        cancelled,
+                                        selectionClipboard,
+                                        isLarge,
+                                        lineCount]() {
+        setThreadName("Terminal.Copy");
+        auto text = QString {};
+        for (auto chunk = nextChunk(); !chunk.empty(); chunk = nextChunk())
+        {
+            if (*cancelled)
+                return;
+            // Chunks end at cell boundaries, so that each one can be converted on its own.
+            text += QString::fromUtf8(chunk.data(), static_cast<int>(chunk.size()));
+        }
+        if (*cancelled)
+            return;
+
+        postToObject(QCoreApplication::instance(),
+                     [this, text = std::move(text), cancelled, selectionClipboard, isLarge, lineCount]() {
+                         if (*cancelled)
+                             return;
+                         if (QClipboard* clipboard = QGuiApplication::clipboard(); clipboard != nullptr)
+                             clipboard->setText(text,
+                                                selectionClipboard ? QClipboard::Selection
+                                                                   : QClipboard::Clipboard);
+                         if (isLarge)
+                             emit showNotification(
+                                 "Copy", QString::fromStdString(std::format("Copied {} lines", lineCount)));
+                     });
+    });
+}
+
+void TerminalSession::cancelClipboardCopy()
+{
+    if (_clipboardCopyCancelled)
+        *_clipboardCopyCancelled = true;
+
+    // The worker only touches its own snapshot and flag, so it is left to wind down on its own, rather
+    // than waiting for it with the terminal locked.
+    if (_clipboardCopyThread.joinable())
+        _clipboardCopyThread.detach();
+}
+
 void TerminalSession::openDocument(std::string_view fileOrUrl)
 {
     sessionLog()("openDocument: {}\n", fileOrUrl);
@@ -586,7 +784,7 @@ void TerminalSession::onClosed()
     auto const now = steady_clock::now();
     auto const diff = std::chrono::duration_cast<std::chrono::seconds>(now - _startTime);
 
-    if (auto* localProcess = dynamic_cast<vtpty::Process*>(&_terminal.device()))
+    if (auto* localProcess = vtpty::ptyAs<vtpty::Process>(_terminal.device()))
     {
         auto const exitStatus = localProcess->checkStatus();
         if (exitStatus)
@@ -596,7 +794,7 @@ void TerminalSession::onClosed()
             sessionLog()("Process terminated after {} seconds.", diff.count());
     }
 #if defined(VTPTY_LIBSSH2)
-    else if (auto* sshSession = dynamic_cast<vtpty::SshSession*>(&_terminal.device()))
+    else if (auto* sshSession = vtpty::ptyAs<vtpty::SshSession>(_terminal.device()))
     {
         auto const exitStatus = sshSession->exitStatus();
         if (exitStatus)
@@ -654,39 +852,25 @@ void TerminalSession::pasteFromClipboard(unsigned count, bool strip)
         for (int i = 0; i < md->formats().size(); ++i)
             sessionLog()("pasteFromClipboard[{}]: {}\n", i, md->formats().at(i).toStdString());
 
-        auto const text = clipboard->text(QClipboard::Clipboard);
-
-        // 1 MB hard limit
-        if (text.size() > 1024 * 1024)
+        auto text = clipboard->text(QClipboard::Clipboard);
+        sessionLog()("Size of text: {}", text.size());
+        if (text.isEmpty())
         {
-            sessionLog()("Clipboard contains huge text. Ignoring.");
-            _display->post([this]() {
-                emit showNotification("Screenshot", QString::fromStdString("Paste is too big"));
-            });
+            sessionLog()("Clipboard does not contain text.");
             return;
         }
-        // 512 KB soft limit to ask user for permission
+
+        // 512 KB soft limit to ask user for permission.
+        // Pastes are streamed to the application, so there is no need for a hard limit.
         if (text.size() > 1024 * 512)
         {
-            _pendingBigPaste = clipboard;
+            _pendingBigPaste = PendingPaste { .text = std::move(text), .count = count, .strip = strip };
             emit requestPermissionForPasteLargeFile();
             sessionLog()("Clipboard contains huge text. Requesting permission.");
             return;
         }
 
-        string const strippedText = strip_if(normalize_crlf(clipboard->text(QClipboard::Clipboard)), strip);
-        sessionLog()("Size of text: {}", strippedText.size());
-        if (strippedText.empty())
-            sessionLog()("Clipboard does not contain text.");
-        else if (count == 1)
-            terminal().sendPaste(string_view { strippedText });
-        else
-        {
-            string fullPaste;
-            for (unsigned i = 0; i < count; ++i)
-                fullPaste += strippedText;
-            terminal().sendPaste(string_view { fullPaste });
-        }
+        terminal().sendPasteStream(clipboardPasteSource(std::move(text), count, strip));
     }
     else
         sessionLog()("Could not access clipboard.");
@@ -707,9 +891,9 @@ void TerminalSession::applyPendingPaste(bool allow, bool remember)
         return;
     }
 
-    auto* clipboard = _pendingBigPaste.value();
-    auto text = clipboard->text(QClipboard::Clipboard);
-    terminal().sendPaste(string_view { text.toStdString() });
+    auto paste = std::move(_pendingBigPaste.value());
+    _pendingBigPaste = std::nullopt;
+    terminal().sendPasteStream(clipboardPasteSource(std::move(paste.text), paste.count, paste.strip));
 }
 
 void TerminalSession::onSelectionCompleted()
@@ -719,20 +903,9 @@ void TerminalSession::onSelectionCompleted()
         case config::SelectionAction::CopyToSelectionClipboard:
             if (QClipboard* clipboard = QGuiApplication::clipboard();
                 clipboard != nullptr && clipboard->supportsSelection())
-            {
-                string const text = terminal().extractSelectionText();
-                clipboard->setText(QString::fromUtf8(text.c_str(), static_cast<int>(text.size())),
-                                   QClipboard::Selection);
-            }
-            break;
-        case config::SelectionAction::CopyToClipboard:
-            if (QClipboard* clipboard = QGuiApplication::clipboard(); clipboard != nullptr)
-            {
-                string const text = terminal().extractSelectionText();
-                clipboard->setText(QString::fromUtf8(text.c_str(), static_cast<int>(text.size())),
-                                   QClipboard::Clipboard);
-            }
+                copySelectionToClipboard(true);
             break;
+        case config::SelectionAction::CopyToClipboard: copySelectionToClipboard(false); break;
         case config::SelectionAction::Nothing: break;
     }
 }
@@ -826,8 +999,7 @@ void TerminalSession::sendKeyEvent(Key key, Modifiers modifiers, KeyboardEventTy
 
     if (eventType != KeyboardEventType::Release)
     {
-        if (auto const* actions =
-                config::apply(_config.inputMappings.value().keyMappings, key, modifiers, matchModeFlags()))
+        if (auto const* actions = config::apply(_inputMappings.keyMappings, key, modifiers, matchModeFlags()))
         {
             executeAllActions(*actions);
             return;
@@ -839,10 +1011,11 @@ void TerminalSession::sendKeyEvent(Key key, Modifiers modifiers, KeyboardEventTy
 void TerminalSession::sendCharEvent(
     char32_t value, uint32_t physicalKey, Modifiers modifiers, KeyboardEventType eventType, Timestamp now)
 {
-    inputLog()("Character {} event received: {} '{}'",
-               eventType,
-               modifiers,
-               crispy::escape(unicode::convert_to<char>(value)));
+    LOGSTORE_LOG(inputLog,
+                 "Character {} event received: {} '{}'",
+                 eventType,
+                 modifiers,
+                 crispy::escape(unicode::convert_to<char>(value)));
 
     if (_display)
     {
@@ -861,7 +1034,7 @@ void TerminalSession::sendCharEvent(
     {
         // find if action exist for the given key, and ignore if editing search prompt
         if (auto const* actions =
-                config::apply(_config.inputMappings.value().charMappings, value, modifiers, matchModeFlags());
+                config::apply(_inputMappings.charMappings, value, modifiers, matchModeFlags());
             actions && !_terminal.inputHandler().isEditingSearch())
         {
             executeAllActions(*actions);
@@ -889,8 +1062,8 @@ void TerminalSession::sendMousePressEvent(Modifiers modifiers,
                                        ? modifiers.without(_config.bypassMouseProtocolModifiers.value())
                                        : modifiers;
 
-    if (auto const* actions = config::apply(
-            _config.inputMappings.value().mouseMappings, button, sanitizedModifier, matchModeFlags()))
+    if (auto const* actions =
+            config::apply(_inputMappings.mouseMappings, button, sanitizedModifier, matchModeFlags()))
         executeAllActions(*actions);
 }
 
@@ -969,9 +1142,19 @@ void TerminalSession::onHighlightUpdate()
 void TerminalSession::playSound(vtbackend::Sequence::Parameters const& params)
 {
     auto range = params.range();
-    _musicalNotesBuffer.clear();
-    _musicalNotesBuffer.insert(_musicalNotesBuffer.begin(), range.begin() + 2, range.end());
-    emit _audio.play(params.at(0), params.at(1), _musicalNotesBuffer);
+    auto notes = std::vector<int>(range.begin() + 2, range.end());
+    int const volume = params.at(0);
+    int const duration = params.at(1);
+
+    // Setting up the audio output takes a while, so it is only done once needed, on the GUI thread.
+    QMetaObject::invokeMethod(
+        this,
+        [this, volume, duration, notes = std::move(notes)]() {
+            if (!_audio)
+                _audio = std::make_unique<Audio>();
+            emit _audio->play(volume, duration, notes);
+        },
+        Qt::QueuedConnection);
 }
 
 void TerminalSession::cursorPositionChanged()
@@ -1004,6 +1187,12 @@ bool TerminalSession::operator()(actions::ClearHistoryAndReset)
     return true;
 }
 
+bool TerminalSession::operator()(actions::CopyCommandOutput)
+{
+    crispy::locked(_terminal, [&]() { copyToClipboard(terminal().extractCommandOutput()); });
+    return true;
+}
+
 bool TerminalSession::operator()(actions::CopyPreviousMarkRange)
 {
     crispy::locked(_terminal, [&]() { copyToClipboard(terminal().extractLastMarkRange()); });
@@ -1017,7 +1206,7 @@ bool TerminalSession::operator()(actions::CopySelection copySelection)
     {
         case actions::CopyFormat::Text:
             // Copy the selection in pure text, plus whitespaces and newline.
-            crispy::locked(_terminal, [&]() { copyToClipboard(terminal().extractSelectionText()); });
+            crispy::locked(_terminal, [&]() { copySelectionToClipboard(false); });
             break;
         case actions::CopyFormat::HTML:
             // TODO: This requires walking through each selected cell and construct HTML+CSS for it.
@@ -1153,7 +1342,7 @@ bool TerminalSession::operator()(actions::OpenConfiguration) const
 
 bool TerminalSession::operator()(actions::OpenFileManager)
 {
-    auto const l = scoped_lock { terminal() };
+    auto const l = std::shared_lock { terminal() };
     auto const& cwd = terminal().currentWorkingDirectory();
     if (!QDesktopServices::openUrl(QUrl(QString::fromUtf8(cwd.c_str()))))
         errorLog()("Could not open file \"{}\".", cwd);
@@ -1179,11 +1368,10 @@ bool TerminalSession::operator()(actions::PasteSelection paste)
 {
     if (QClipboard* clipboard = QGuiApplication::clipboard(); clipboard != nullptr)
     {
-        string const text = normalize_crlf(clipboard->text(QClipboard::Selection));
         if (paste.evaluateInShell)
-            terminal().sendRawInput(string_view { text + "\n" });
-        else
-            terminal().sendPaste(string_view { text });
+            terminal().sendRawInput(normalize_crlf(clipboard->text(QClipboard::Selection)) + "\n");
+        else if (auto text = clipboard->text(QClipboard::Selection); !text.isEmpty())
+            terminal().sendPasteStream(clipboardPasteSource(std::move(text), 1, false));
     }
 
     return true;
@@ -1221,9 +1409,22 @@ bool TerminalSession::operator()(actions::ResetFontSize)
 
 bool TerminalSession::operator()(actions::ScreenshotVT)
 {
-    auto l = lock_guard { terminal() };
-    auto const screenshot = terminal().isPrimaryScreen() ? terminal().primaryScreen().screenshot()
-                                                         : terminal().alternateScreen().screenshot();
+    // Only hold the terminal lock for taking the snapshot, not while serializing it.
+    auto serializeSnapshot = std::function<std::string()> {};
+    {
+        auto l = lock_guard { terminal() };
+        auto const takeSnapshot = [&](auto const& screen) {
+            using VisitedScreen = std::remove_cvref_t<decltype(screen)>;
+            serializeSnapshot = [snapshot = screen.grid().snapshot()]() {
+                return VisitedScreen::screenshot(snapshot);
+            };
+        };
+        if (terminal().isPrimaryScreen())
+            terminal().visitPrimaryScreen(takeSnapshot);
+        else
+            terminal().visitAlternateScreen(takeSnapshot);
+    }
+    auto const screenshot = serializeSnapshot();
     ofstream ofs { "screenshot.vt", ios::trunc | ios::binary };
     ofs << screenshot;
     return true;
@@ -1363,6 +1564,13 @@ bool TerminalSession::operator()(actions::ToggleInputProtection)
     return true;
 }
 
+bool TerminalSession::operator()(actions::TogglePerformanceHud)
+{
+    if (_display)
+        _display->togglePerformanceHud();
+    return true;
+}
+
 bool TerminalSession::operator()(actions::ToggleStatusLine)
 {
     auto const l = scoped_lock { _terminal };
@@ -1487,6 +1695,7 @@ bool TerminalSession::reloadConfig(config::Config newConfig, string const& profi
     // clang-format on
 
     _config = std::move(newConfig);
+    _inputMappings = config::InputMappingIndex { _config.inputMappings.value() };
     activateProfile(profileName);
 
     return true;
@@ -1538,10 +1747,10 @@ void TerminalSession::spawnNewTerminal(string const& profileName)
 {
     auto const wd = [this]() -> string {
 #if !defined(_WIN32)
-        if (auto const* ptyProcess = dynamic_cast<vtpty::Process const*>(&_terminal.device()))
+        if (auto const* ptyProcess = vtpty::ptyAs<vtpty::Process>(_terminal.device()))
             return ptyProcess->workingDirectory();
 #else
-        auto const _l = scoped_lock { _terminal };
+        auto const _l = std::shared_lock { _terminal };
         return _terminal.currentWorkingDirectory();
 #endif
         return "."s;
@@ -1571,37 +1780,83 @@ void TerminalSession::activateProfile(string const& newProfileName)
 
     sessionLog()("Changing profile to {}.", newProfileName);
     _profileName = newProfileName;
-    _profile = *newProfile;
-    configureTerminal();
+    auto const previousProfile = std::exchange(_profile, *newProfile);
+    reconfigure(previousProfile);
 }
 
 void TerminalSession::configureTerminal()
 {
-    auto const l = scoped_lock { _terminal };
-    sessionLog()("Configuring terminal.");
+    {
+        auto const l = scoped_lock { _terminal };
+        sessionLog()("Configuring terminal.");
+
+        applyTerminalSettings();
+        _terminal.setStatusDisplay(_profile.statusLine.value().initialType);
+        configureCursor(_profile.modeInsert.value().cursor);
+    }
+    updateColorPreference(_app.colorPreference());
+}
+
+/// Applies the changes from @p previousProfile to the current profile and configuration, e.g. after
+/// reloading the configuration, leaving state that depends on unchanged entries untouched.
+///
+/// In particular, the fonts are only reloaded, which discards all rasterized glyphs, if they changed.
+/// Input mappings are looked up in the configuration on each event, so they need no reconfiguration.
+void TerminalSession::reconfigure(config::TerminalProfile const& previousProfile)
+{
+    {
+        auto const l = scoped_lock { _terminal };
+        sessionLog()("Reconfiguring terminal.");
+
+        applyTerminalSettings();
+        if (_profile.statusLine.value().initialType != previousProfile.statusLine.value().initialType)
+            _terminal.setStatusDisplay(_profile.statusLine.value().initialType);
+        if (_profile.modeInsert.value().cursor != previousProfile.modeInsert.value().cursor)
+            configureCursor(_profile.modeInsert.value().cursor);
+    }
+    applyColorPalette();
 
+    if (!_display)
+        return;
+
+    if (_profile.background.value().blur != previousProfile.background.value().blur)
+        _display->setBlurBehind(_profile.background.value().blur);
+
+    if (_profile.hyperlinkDecoration.value() != previousProfile.hyperlinkDecoration.value())
+        _display->setHyperlinkDecoration(_profile.hyperlinkDecoration.value().normal,
+                                         _profile.hyperlinkDecoration.value().hover);
+
+    if (_profile.fonts.value() != previousProfile.fonts.value())
+    {
+        sessionLog()("Fonts changed, reloading them.");
+        _display->setFonts(_profile.fonts.value());
+    }
+    else if (unbox(_profile.margins.value().horizontal) != unbox(previousProfile.margins.value().horizontal)
+             || unbox(_profile.margins.value().vertical) != unbox(previousProfile.margins.value().vertical))
+        resizeTerminalToDisplaySize();
+}
+
+void TerminalSession::applyTerminalSettings()
+{
     _terminal.setWordDelimiters(_config.wordDelimiters.value());
     _terminal.setExtendedWordDelimiters(_config.extendedWordDelimiters.value());
     _terminal.setMouseProtocolBypassModifiers(_config.bypassMouseProtocolModifiers.value());
     _terminal.setMouseBlockSelectionModifiers(_config.mouseBlockSelectionModifiers.value());
+    _terminal.setPixelMouseMoveInterval(_profile.mouse.value().pixelMoveInterval);
+    _terminal.setPredictiveEchoThreshold(_profile.predictiveEchoThreshold.value());
     _terminal.setLastMarkRangeOffset(_profile.copyLastMarkRangeOffset.value());
 
     sessionLog()("Setting terminal ID to {}.", _profile.terminalId.value());
     _terminal.setTerminalId(_profile.terminalId.value());
     _terminal.setMaxSixelColorRegisters(_config.images.value().maxImageColorRegisters);
     _terminal.setMaxImageSize(_config.images.value().maxImageSize);
+    _terminal.imagePool().setMemoryBudget(size_t { _config.images.value().maxImageMemory } * 1024 * 1024);
+    _terminal.settings().kittyGraphicsLocalMedia = _config.images.value().kittyLocalMedia;
     _terminal.setMode(vtbackend::DECMode::NoSixelScrolling, !_config.images.value().sixelScrolling);
-    _terminal.setStatusDisplay(_profile.statusLine.value().initialType);
     sessionLog()("maxImageSize={}, sixelScrolling={}",
                  _config.images.value().maxImageSize,
                  _config.images.value().sixelScrolling);
 
-    // XXX
-    // if (!terminalView.renderer().renderTargetAvailable())
-    //     return;
-
-    configureCursor(_profile.modeInsert.value().cursor);
-    updateColorPreference(_app.colorPreference());
     _terminal.setMaxHistoryLineCount(_profile.history.value().maxHistoryLineCount);
     _terminal.setHighlightTimeout(_profile.highlightTimeout.value());
     _terminal.viewport().setScrollOff(_profile.modalCursorScrollOff.value());
@@ -6,6 +6,7 @@
 #include <contour/Config.h>
 #include <contour/helper.h>
 
+#include <vtbackend/InputReactor.h>
 #include <vtbackend/Terminal.h>
 
 #include <vtrasterizer/Renderer.h>
@@ -17,8 +18,10 @@
 #include <QtCore/QThread>
 #include <QtQml/QJSValue>
 
+#include <atomic>
 #include <cstdint>
 #include <format>
+#include <memory>
 #include <thread>
 
 #include <qcolor.h>
@@ -111,16 +114,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     {
         return static_cast<float>(_profile.background.value().opacity) / std::numeric_limits<uint8_t>::max();
     }
-    QString pathToBackground() const
-    {
-        if (const auto& p =
-                std::get_if<std::filesystem::path>(&(_terminal.colorPalette().backgroundImage->location)))
-        {
-            return QString("file:") + QString(p->string().c_str());
-        }
-        else
-            return QString();
-    }
+    QString pathToBackground() const;
     QColor getBackgroundColor() const noexcept
     {
         auto color = terminal().isModeEnabled(vtbackend::DECMode::ReverseVideo)
@@ -306,6 +300,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     bool operator()(actions::CancelSelection);
     bool operator()(actions::ChangeProfile const&);
     bool operator()(actions::ClearHistoryAndReset);
+    bool operator()(actions::CopyCommandOutput);
     bool operator()(actions::CopyPreviousMarkRange);
     bool operator()(actions::CopySelection);
     bool operator()(actions::CreateDebugDump);
@@ -346,6 +341,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     bool operator()(actions::ToggleAllKeyMaps);
     bool operator()(actions::ToggleFullscreen);
     bool operator()(actions::ToggleInputProtection);
+    bool operator()(actions::TogglePerformanceHud);
     bool operator()(actions::ToggleStatusLine);
     bool operator()(actions::ToggleTitleBar);
     bool operator()(actions::TraceBreakAtEmptyQueue);
@@ -430,7 +426,20 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     void setFontSize(text::font_size size);
     void setDefaultCursor();
     void configureTerminal();
+    void applyTerminalSettings();
+    void reconfigure(config::TerminalProfile const& previousProfile);
+    void applyColorPalette();
     void configureCursor(config::CursorConfig const& cursorConfig);
+
+    /// Copies the text of the current selection to the clipboard, or to the selection clipboard.
+    ///
+    /// The text is extracted from a snapshot of the selection on a worker thread, and handed to the
+    /// clipboard once it is complete, such that copying a huge selection does not block the GUI.
+    /// Must be invoked with the terminal locked.
+    void copySelectionToClipboard(bool selectionClipboard);
+
+    /// Cancels the copy to the clipboard that may still be in progress, without waiting for it.
+    void cancelClipboardCopy();
     uint8_t matchModeFlags() const;
     void flushInput();
     void mainLoop();
@@ -440,6 +449,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     int _id;
     std::chrono::steady_clock::time_point _startTime;
     config::Config _config;
+    config::InputMappingIndex _inputMappings; // of _config, looked up on every input event
     std::string _profileName;
     config::TerminalProfile _profile;
     ContourGuiApp& _app;
@@ -457,14 +467,18 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     bool _terminating = false;
     std::thread::id _mainLoopThreadID {};
     std::unique_ptr<std::thread> _screenUpdateThread;
+    vtbackend::InputReactor* _inputReactor = nullptr; // processes the input instead of the thread, if set
+
+    // Extracts the text of a selection for the clipboard, see copySelectionToClipboard().
+    std::thread _clipboardCopyThread;
+    std::shared_ptr<std::atomic<bool>> _clipboardCopyCancelled;
 
     // state vars
     //
     vtbackend::ScreenType _currentScreenType = vtbackend::ScreenType::Primary;
     vtbackend::CellLocation _currentMousePosition = vtbackend::CellLocation {};
     bool _allowKeyMappings = true;
-    Audio _audio;
-    std::vector<int> _musicalNotesBuffer;
+    std::unique_ptr<Audio> _audio; // created on the first DECPS, as most sessions never play any
 
     vtbackend::LineCount _lastHistoryLineCount;
 
@@ -475,7 +489,13 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     };
     std::optional<CaptureBufferRequest> _pendingBufferCapture;
     std::optional<vtbackend::FontDef> _pendingFontChange;
-    std::optional<QClipboard*> _pendingBigPaste;
+    struct PendingPaste
+    {
+        QString text;
+        unsigned count;
+        bool strip;
+    };
+    std::optional<PendingPaste> _pendingBigPaste;
     PermissionCache _rememberedPermissions;
     std::unique_ptr<QThread> _exitWatcherThread;
 
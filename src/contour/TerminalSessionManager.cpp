@@ -3,17 +3,29 @@
 #include <contour/TerminalSession.h>
 #include <contour/TerminalSessionManager.h>
 
+#include <vtbackend/SessionSnapshot.h>
 #include <vtbackend/primitives.h>
 
+#include <vtpty/FileViewPty.h>
 #include <vtpty/Process.h>
+#include <vtpty/RecordingPty.h>
+#include <vtpty/ReplayPty.h>
 #if defined(VTPTY_LIBSSH2)
     #include <vtpty/SshSession.h>
 #endif
 
+#include <crispy/utils.h>
+
 #include <QtQml/QQmlEngine>
 
 #include <algorithm>
+#include <array>
 #include <filesystem>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <shared_mutex>
 #include <string>
 
 using namespace std::string_literals;
@@ -26,9 +38,126 @@ namespace contour
 
 TerminalSessionManager::TerminalSessionManager(ContourGuiApp& app): _app { app }, _earlyExitThreshold {}
 {
+    connect(&_hibernationTimer, &QTimer::timeout, this, &TerminalSessionManager::hibernateHiddenSessions);
+    connect(&_memoryTrimTimer, &QTimer::timeout, this, &TerminalSessionManager::trimIdleSessions);
+    connect(&_memoryBudgetTimer, &QTimer::timeout, this, &TerminalSessionManager::enforceMemoryBudget);
+    connect(&_activityTimer, &QTimer::timeout, this, &TerminalSessionManager::sampleActivity);
+    _activityTimer.start(ActivitySampleInterval);
+
+    // Metrics are served on the GUI thread, which the sessions are managed on.
+    _metricsRegistration =
+        _app.metrics().add([this](crispy::metrics::sink& output) { collectMetrics(output); });
+}
+
+void TerminalSessionManager::collectMetrics(crispy::metrics::sink& output) const
+{
+    using crispy::metrics::labels;
+
+    output.gauge("contour_sessions", "Open terminal sessions.", static_cast<double>(_sessions.size()));
+
+    for (auto const* session: _sessions)
+    {
+        auto const& terminal = session->terminal();
+        auto const sessionLabels = labels { { "session", std::to_string(session->id()) } };
+
+        output.counter("contour_parsed_bytes_total",
+                       "Bytes read from the PTY and parsed.",
+                       static_cast<double>(terminal.parsedBytes()),
+                       sessionLabels);
+
+        auto const sequenceCounts = [&]() {
+            auto const _ = std::shared_lock { terminal };
+            return terminal.sequenceCounts();
+        }();
+        constexpr auto CategoryNames = std::array { "C0", "ESC", "CSI", "OSC", "DCS" };
+        static_assert(CategoryNames.size() == std::tuple_size_v<vtbackend::Terminal::SequenceCounts>);
+        for (size_t i = 0; i < CategoryNames.size(); ++i)
+        {
+            auto categoryLabels = sessionLabels;
+            categoryLabels.emplace_back("category", CategoryNames[i]);
+            output.counter("contour_sequences_total",
+                           "Control functions processed, by category.",
+                           static_cast<double>(sequenceCounts[i]),
+                           std::move(categoryLabels));
+        }
+
+        auto const cpuTimes = terminal.cpuTimes();
+        for (auto const& [stage, cpuTime]: { std::pair { "pty_read", cpuTimes.ptyRead },
+                                             std::pair { "parse", cpuTimes.parse },
+                                             std::pair { "render_buffer_fill", cpuTimes.renderBufferFill } })
+        {
+            auto stageLabels = sessionLabels;
+            stageLabels.emplace_back("stage", stage);
+            output.counter("contour_cpu_seconds_total",
+                           "CPU time spent on processing PTY output, by stage.",
+                           std::chrono::duration<double>(cpuTime).count(),
+                           std::move(stageLabels));
+        }
+        if (auto const i = _activities.find(session); i != _activities.end())
+        {
+            output.gauge("contour_cpu_load",
+                         "Fraction of a CPU core spent on processing PTY output, as of the last sample.",
+                         i->second.cpuLoad,
+                         sessionLabels);
+            output.gauge("contour_parse_rate_bytes_per_second",
+                         "Bytes of PTY output parsed per second, as of the last sample.",
+                         i->second.parseRate,
+                         sessionLabels);
+        }
+
+        output.gauge("contour_pending_input_bytes",
+                     "Bytes of input waiting to be written to the PTY.",
+                     static_cast<double>(terminal.pendingInputBytes()),
+                     sessionLabels);
+        terminal.memoryUsage().visit([&](std::string_view kind, size_t bytes) {
+            auto kindLabels = sessionLabels;
+            kindLabels.emplace_back("kind", kind);
+            output.gauge("contour_memory_bytes",
+                         "Approximate memory used by a session, by what it is used for.",
+                         static_cast<double>(bytes),
+                         std::move(kindLabels));
+        });
+    }
+
+    if (auto const* renderer = display ? display->renderer() : nullptr)
+    {
+        auto const& stats = renderer->frameStats();
+        output.counter(
+            "contour_frames_rendered_total", "Frames rendered.", static_cast<double>(stats.rendered));
+        output.counter("contour_frames_dropped_total",
+                       "Frames refreshed, but replaced by a newer one before being rendered.",
+                       static_cast<double>(stats.dropped));
+        output.counter("contour_frames_cursor_only_total",
+                       "Frames rendered by only drawing the cursor on top of the previous frame's contents.",
+                       static_cast<double>(stats.cursorOnly));
+        output.histogram("contour_input_answer_latency_seconds",
+                         "Time from key input until PTY output following it has been parsed.",
+                         stats.inputAnswerLatency.read());
+        output.histogram("contour_input_latency_seconds",
+                         "Time from key input until its answer has been presented on screen.",
+                         stats.inputLatency.read());
+        output.gauge("contour_gpu_memory_bytes",
+                     "Texture memory allocated for the glyph and image atlases.",
+                     static_cast<double>(renderer->gpuMemoryUsage()));
+    }
 }
 
 std::unique_ptr<vtpty::Pty> TerminalSessionManager::createPty(std::optional<std::string> cwd)
+{
+    if (auto const& recording = _app.ptyReplay())
+        return make_unique<vtpty::ReplayPty>(*recording, _app.ptyReplayPacing());
+
+    if (auto const& file = _app.viewedFile())
+        return make_unique<vtpty::FileViewPty>(
+            *file, _app.config().profile(_app.profileName())->terminalSize.value());
+
+    auto pty = createShellPty(std::move(cwd));
+    if (auto recorder = _app.takePtyRecorder())
+        return make_unique<vtpty::RecordingPty>(std::move(pty), std::move(recorder));
+    return pty;
+}
+
+std::unique_ptr<vtpty::Pty> TerminalSessionManager::createShellPty(std::optional<std::string> cwd)
 {
     auto const& profile = _app.config().profile(_app.profileName());
 #if defined(VTPTY_LIBSSH2)
@@ -59,7 +188,7 @@ TerminalSession* TerminalSessionManager::createSessionInBackground()
         if (_activeSession)
         {
             auto& terminal = _activeSession->terminal();
-            if (auto const* ptyProcess = dynamic_cast<vtpty::Process const*>(&terminal.device()))
+            if (auto const* ptyProcess = vtpty::ptyAs<vtpty::Process>(terminal.device()))
                 return ptyProcess->workingDirectory();
         }
         return std::nullopt;
@@ -70,7 +199,7 @@ TerminalSession* TerminalSessionManager::createSessionInBackground()
     {
         auto& terminal = _activeSession->terminal();
         {
-            auto _l = std::scoped_lock { terminal };
+            auto _l = std::shared_lock { terminal };
             ptyPath = terminal.currentWorkingDirectory();
         }
     }
@@ -79,7 +208,23 @@ TerminalSession* TerminalSessionManager::createSessionInBackground()
     auto* session = new TerminalSession(createPty(ptyPath), _app);
     managerLog()("Create new session with ID {} at index {}", session->id(), _sessions.size());
 
+    if (isSessionRestoreEnabled())
+        restoreSessionHistory(*session, _sessions.size());
+
     _sessions.push_back(session);
+    _hiddenSince[session] = std::chrono::steady_clock::now();
+    session->terminal().setVisible(false);
+
+    if (_app.config().hibernateAfter.value() != 0 && !_hibernationTimer.isActive())
+        _hibernationTimer.start(std::chrono::minutes(1));
+
+    // Sessions are trimmed after being idle for one to two timer intervals.
+    auto const trimAfter = std::chrono::seconds(_app.config().trimMemoryAfter.value());
+    if (trimAfter.count() != 0 && !_memoryTrimTimer.isActive())
+        _memoryTrimTimer.start(trimAfter);
+
+    if (_app.config().memoryBudget.value() != 0 && !_memoryBudgetTimer.isActive())
+        _memoryBudgetTimer.start(MemoryBudgetCheckInterval);
 
     connect(session, &TerminalSession::sessionClosed, [this, session]() { removeSession(*session); });
 
@@ -122,6 +267,21 @@ TerminalSession* TerminalSessionManager::activateSession(TerminalSession* sessio
     _lastTabChange = std::chrono::steady_clock::now();
     updateStatusLine();
 
+    // Hidden sessions only parse their output, until shown again.
+    if (_previousActiveSession)
+    {
+        _hiddenSince[_previousActiveSession] = _lastTabChange;
+        _previousActiveSession->terminal().setVisible(false);
+    }
+    _hiddenSince.erase(session);
+    session->terminal().setVisible(true);
+
+    if (session->terminal().hibernated())
+    {
+        managerLog()("Reviving hibernated session ID {}.", session->id());
+        session->terminal().revive();
+    }
+
     if (display)
     {
         managerLog()("Attaching display to session.");
@@ -233,8 +393,18 @@ void TerminalSessionManager::removeSession(TerminalSession& thatSession)
         return;
     }
     _sessions.erase(i);
+    _hiddenSince.erase(&thatSession);
+    _idleStates.erase(&thatSession);
+    _activities.erase(&thatSession);
     _app.onExit(thatSession); // TODO: the logic behind that impl could probably be moved here.
 
+    // Destroying a large history takes long, which is done in the background instead.
+    {
+        auto& terminal = thatSession.terminal();
+        auto _l = std::scoped_lock { terminal };
+        terminal.releaseGrids();
+    }
+
     _previousActiveSession = [&]() -> TerminalSession* {
         auto const currentIndex = getSessionIndexOf(_activeSession).value_or(0);
         if (currentIndex + 1 < _sessions.size())
@@ -256,15 +426,261 @@ void TerminalSessionManager::updateColorPreference(vtbackend::ColorPreference co
         session->updateColorPreference(preference);
 }
 
+void TerminalSessionManager::hibernateHiddenSessions()
+{
+    auto const hibernateAfter = std::chrono::minutes(_app.config().hibernateAfter.value());
+    if (hibernateAfter.count() == 0)
+        return;
+
+    auto const now = std::chrono::steady_clock::now();
+    for (auto* session: _sessions)
+    {
+        if (session == _activeSession || session->terminal().hibernated())
+            continue;
+
+        auto const i = _hiddenSince.find(session);
+        if (i == _hiddenSince.end() || now - i->second < hibernateAfter)
+            continue;
+
+        managerLog()("Hibernating session ID {}.", session->id());
+        auto& terminal = session->terminal();
+        auto _l = std::scoped_lock { terminal };
+        terminal.hibernate();
+    }
+}
+
+void TerminalSessionManager::trimIdleSessions()
+{
+    auto trimmed = false;
+    for (auto* session: _sessions)
+    {
+        auto& terminal = session->terminal();
+        auto const parsedBytes = terminal.parsedBytes();
+        auto const [i, inserted] = _idleStates.try_emplace(session, IdleState { .parsedBytes = parsedBytes });
+        auto& state = i->second;
+        if (inserted || state.parsedBytes != parsedBytes)
+        {
+            // Not idle for a whole interval yet.
+            state = IdleState { .parsedBytes = parsedBytes };
+            continue;
+        }
+
+        if (state.trimmed || terminal.hibernated())
+            continue;
+
+        managerLog()("Trimming memory of idle session ID {}.", session->id());
+        auto _l = std::scoped_lock { terminal };
+        terminal.trimMemory();
+        state.trimmed = true;
+        trimmed = true;
+    }
+
+    // Only now is most of the memory freed, which can be returned to the operating system.
+    if (trimmed)
+        crispy::trimHeap();
+}
+
+void TerminalSessionManager::enforceMemoryBudget()
+{
+    auto const budget = size_t { _app.config().memoryBudget.value() } * 1024 * 1024;
+    if (budget == 0 || _sessions.empty())
+        return;
+
+    // Least recently shown sessions first, and the active session, which is not hidden, last.
+    auto sessions = _sessions;
+    std::ranges::stable_sort(sessions, {}, [this](TerminalSession const* session) {
+        auto const i = _hiddenSince.find(session);
+        return i != _hiddenSince.end() ? i->second : std::chrono::steady_clock::time_point::max();
+    });
+
+    auto usages = std::vector<size_t>(sessions.size());
+    std::ranges::transform(sessions, usages.begin(), [](TerminalSession const* session) {
+        return session->terminal().memoryUsage().total();
+    });
+    auto const totalUsage = [&]() {
+        auto const* renderer = display ? display->renderer() : nullptr;
+        return std::accumulate(usages.begin(), usages.end(), size_t { 0 })
+               + (renderer ? renderer->gpuMemoryUsage() : 0);
+    };
+    if (totalUsage() <= budget)
+        return;
+
+    managerLog()("Memory usage of {} exceeds the budget of {}.",
+                 crispy::humanReadableBytes(totalUsage()),
+                 crispy::humanReadableBytes(budget));
+
+    // Applies the policy to one session after another, until usage fits the budget.
+    auto const reclaim = [&](std::string_view what, auto&& policy) {
+        for (size_t i = 0; i < sessions.size(); ++i)
+        {
+            auto& terminal = sessions[i]->terminal();
+            {
+                auto _l = std::scoped_lock { terminal };
+                policy(terminal);
+            }
+            usages[i] = terminal.memoryUsage().total();
+            if (totalUsage() <= budget)
+            {
+                managerLog()("{} of {} sessions made the memory usage fit the budget.", what, i + 1);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto const fits = [&]() {
+        if (reclaim("Compressing the history", [](vtbackend::Terminal& terminal) { terminal.trimMemory(); }))
+            return true;
+
+        if (reclaim("Discarding off-screen images",
+                    [](vtbackend::Terminal& terminal) { terminal.discardOffscreenImages(); }))
+            return true;
+
+        if (display && display->releaseCachesIfHidden() && totalUsage() <= budget)
+            return true;
+
+        // Halving the history of each session in turn drops the oldest lines of all sessions first.
+        return reclaim("Trimming the history", [](vtbackend::Terminal& terminal) {
+            terminal.trimHistory(
+                vtbackend::LineCount::cast_from(unbox(terminal.primaryScreenBase().historyLineCount()) / 2));
+        });
+    }();
+
+    if (!fits)
+        managerLog()("Memory usage of {} still exceeds the budget.",
+                     crispy::humanReadableBytes(totalUsage()));
+
+    crispy::trimHeap();
+}
+
+void TerminalSessionManager::sampleActivity()
+{
+    auto const now = std::chrono::steady_clock::now();
+    for (auto const* session: _sessions)
+    {
+        auto const& terminal = session->terminal();
+        auto const parsedBytes = terminal.parsedBytes();
+        auto const cpuTime = terminal.cpuTimes().total();
+        auto const [i, inserted] = _activities.try_emplace(
+            session, Activity { .sampleTime = now, .parsedBytes = parsedBytes, .cpuTime = cpuTime });
+        auto& activity = i->second;
+        auto const elapsed = std::chrono::duration<double>(now - activity.sampleTime).count();
+        if (inserted || elapsed <= 0.0)
+            continue;
+
+        activity.cpuLoad = std::chrono::duration<double>(cpuTime - activity.cpuTime).count() / elapsed;
+        activity.parseRate = static_cast<double>(parsedBytes - activity.parsedBytes) / elapsed;
+        activity.sampleTime = now;
+        activity.parsedBytes = parsedBytes;
+        activity.cpuTime = cpuTime;
+    }
+
+    if (!_sessions.empty())
+        emit dataChanged(index(0), index(count() - 1), { CpuLoadRole, ParseRateRole });
+}
+
+bool TerminalSessionManager::isSessionRestoreEnabled() const
+{
+    auto const* profile = _app.config().profile(_app.profileName());
+    return profile && profile->history.value().restoreOnLaunch;
+}
+
+std::filesystem::path TerminalSessionManager::sessionHistoryDirectory()
+{
+    return config::configHome("contour") / "sessions";
+}
+
+void TerminalSessionManager::saveSessionHistories()
+{
+    if (!isSessionRestoreEnabled())
+        return;
+
+    auto const directory = sessionHistoryDirectory();
+    auto errorCode = std::error_code {};
+    std::filesystem::remove_all(directory, errorCode);
+    std::filesystem::create_directories(directory, errorCode);
+    // The scrollback is only for the user to read.
+    if (!errorCode)
+        std::filesystem::permissions(directory, std::filesystem::perms::owner_all, errorCode);
+    if (errorCode)
+    {
+        errorLog()(
+            "Could not create session history directory {}. {}", directory.string(), errorCode.message());
+        return;
+    }
+
+    for (size_t index = 0; index < _sessions.size(); ++index)
+    {
+        auto& terminal = _sessions[index]->terminal();
+        auto const snapshot = [&]() {
+            auto _l = std::scoped_lock { terminal };
+            return terminal.sessionSnapshot();
+        }();
+
+        auto const path = directory / std::format("{}.bin", index);
+        auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+        std::filesystem::permissions(
+            path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write, errorCode);
+        if (errorCode || !vtbackend::writeSessionSnapshot(file, snapshot))
+            errorLog()("Could not save session history to {}.", path.string());
+        else
+            managerLog()("Saved {} history lines to {}.", snapshot.lines.size(), path.string());
+    }
+}
+
+void TerminalSessionManager::restoreSessionHistory(TerminalSession& session, size_t index)
+{
+    auto const path = sessionHistoryDirectory() / std::format("{}.bin", index);
+    if (!std::filesystem::is_regular_file(path))
+        return;
+
+    auto snapshot = [&]() {
+        auto file = std::ifstream(path, std::ios::binary);
+        return vtbackend::readSessionSnapshot(file);
+    }();
+
+    // Each saved history is restored only once.
+    auto errorCode = std::error_code {};
+    std::filesystem::remove(path, errorCode);
+
+    if (!snapshot)
+    {
+        errorLog()("Ignoring invalid session history file {}.", path.string());
+        return;
+    }
+
+    auto& terminal = session.terminal();
+    auto _l = std::scoped_lock { terminal };
+    terminal.restoreSessionSnapshot(*snapshot);
+    managerLog()("Restored {} history lines from {}.", snapshot->lines.size(), path.string());
+}
+
 // {{{ QAbstractListModel
 QVariant TerminalSessionManager::data(const QModelIndex& index, int role) const
 {
-    crispy::ignore_unused(role);
+    if (index.row() < 0 || index.row() >= static_cast<int>(_sessions.size()))
+        return QVariant();
 
-    if (index.row() < static_cast<int>(_sessions.size()))
-        return QVariant(_sessions.at(static_cast<size_t>(index.row()))->id());
+    auto const* session = _sessions.at(static_cast<size_t>(index.row()));
+    switch (role)
+    {
+        case CpuLoadRole:
+        case ParseRateRole: {
+            auto const i = _activities.find(session);
+            if (i == _activities.end())
+                return QVariant(0.0);
+            return QVariant(role == CpuLoadRole ? i->second.cpuLoad : i->second.parseRate);
+        }
+        default: return QVariant(session->id());
+    }
+}
 
-    return QVariant();
+QHash<int, QByteArray> TerminalSessionManager::roleNames() const
+{
+    auto names = QAbstractListModel::roleNames();
+    names[CpuLoadRole] = "cpuLoad";
+    names[ParseRateRole] = "parseRate";
+    return names;
 }
 
 int TerminalSessionManager::rowCount(const QModelIndex& parent) const
@@ -4,10 +4,15 @@
 #include <contour/display/TerminalDisplay.h>
 #include <contour/helper.h>
 
+#include <crispy/metrics.h>
+
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QTimer>
 #include <QtQml/QQmlEngine>
 
 #include <chrono>
+#include <filesystem>
+#include <unordered_map>
 #include <vector>
 
 namespace contour
@@ -25,6 +30,19 @@ class TerminalSessionManager: public QAbstractListModel
 #endif
 
   public:
+    /// Roles of the data of each session, whose ID is its Qt::DisplayRole.
+    enum Role : int
+    {
+        CpuLoadRole = Qt::UserRole + 1, ///< Fraction of a CPU core spent on the session's output.
+        ParseRateRole,                  ///< Bytes of PTY output parsed per second.
+    };
+
+    /// Interval the CPU load and parse rate of the sessions are sampled in.
+    static constexpr inline std::chrono::seconds ActivitySampleInterval { 1 };
+
+    /// Interval the memory usage of all sessions is checked against the memory budget in.
+    static constexpr inline std::chrono::seconds MemoryBudgetCheckInterval { 10 };
+
     TerminalSessionManager(ContourGuiApp& app);
 
     contour::TerminalSession* createSessionInBackground();
@@ -46,15 +64,45 @@ class TerminalSessionManager: public QAbstractListModel
     Q_INVOKABLE [[nodiscard]] QVariant data(const QModelIndex& index,
                                             int role = Qt::DisplayRole) const override;
     Q_INVOKABLE [[nodiscard]] int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    [[nodiscard]] QHash<int, QByteArray> roleNames() const override;
 
     [[nodiscard]] int count() const noexcept { return static_cast<int>(_sessions.size()); }
 
     void updateColorPreference(vtbackend::ColorPreference const& preference);
+
+    /// Saves the history of all open sessions, if enabled, so that it is restored on the next launch.
+    void saveSessionHistories();
+
     display::TerminalDisplay* display = nullptr;
     TerminalSession* getSession() { return _sessions[0]; }
 
   private:
+    /// Creates the PTY of a new session, which replays, records, or shows a file instead if requested.
     std::unique_ptr<vtpty::Pty> createPty(std::optional<std::string> cwd);
+    std::unique_ptr<vtpty::Pty> createShellPty(std::optional<std::string> cwd);
+
+    /// Hibernates all sessions that have not been visible for the configured time.
+    void hibernateHiddenSessions();
+
+    /// Trims the memory of all sessions that have not received any output for the configured time,
+    /// once per idle period.
+    void trimIdleSessions();
+
+    /// Reclaims memory from the sessions, the least recently shown ones first, for as long as all
+    /// of them together exceed the configured memory budget.
+    void enforceMemoryBudget();
+
+    /// Samples the CPU load and parse rate of all sessions since the previous sample.
+    void sampleActivity();
+
+    /// Reports the metrics of all sessions and of the display. Must be called on the GUI thread.
+    void collectMetrics(crispy::metrics::sink& output) const;
+
+    [[nodiscard]] bool isSessionRestoreEnabled() const;
+    [[nodiscard]] static std::filesystem::path sessionHistoryDirectory();
+
+    /// Restores the history saved for the session at the given index, if any, into @p session.
+    void restoreSessionHistory(TerminalSession& session, size_t index);
 
     [[nodiscard]] std::optional<std::size_t> getSessionIndexOf(TerminalSession* session) const noexcept
     {
@@ -98,6 +146,29 @@ class TerminalSessionManager: public QAbstractListModel
     std::vector<TerminalSession*> _sessions;
     std::chrono::time_point<std::chrono::steady_clock> _lastTabChange;
     std::chrono::milliseconds _timeBetweenTabSwitches { 50 };
+    QTimer _hibernationTimer;
+    std::unordered_map<TerminalSession const*, std::chrono::steady_clock::time_point> _hiddenSince;
+
+    struct IdleState
+    {
+        uint64_t parsedBytes = 0; // as of the previous check
+        bool trimmed = false;     // whether trimmed since last receiving output
+    };
+    QTimer _memoryTrimTimer;
+    std::unordered_map<TerminalSession const*, IdleState> _idleStates;
+    QTimer _memoryBudgetTimer;
+
+    struct Activity
+    {
+        std::chrono::steady_clock::time_point sampleTime; // of the previous sample
+        uint64_t parsedBytes = 0;                         // as of the previous sample
+        std::chrono::nanoseconds cpuTime {};              // as of the previous sample
+        double cpuLoad = 0.0;                             // between the two previous samples
+        double parseRate = 0.0;                           // between the two previous samples
+    };
+    QTimer _activityTimer;
+    std::unordered_map<TerminalSession const*, Activity> _activities;
+    crispy::metrics::registry::registration _metricsRegistration;
 };
 
 } // namespace contour
@@ -64,19 +64,19 @@ Blur::Blur():
     // clang-format off
 
     // {{{ gaussian
-    _gaussianBlur->addShaderFromSourceCode(QOpenGLShader::Vertex, loadShaderSource(":/contour/display/shaders/simple.vert"));
-    _gaussianBlur->addShaderFromSourceCode(QOpenGLShader::Fragment, loadShaderSource(":/contour/display/shaders/blur_gaussian.frag"));
+    _gaussianBlur->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, loadShaderSource(":/contour/display/shaders/simple.vert"));
+    _gaussianBlur->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, loadShaderSource(":/contour/display/shaders/blur_gaussian.frag"));
     _gaussianBlur->link();
     Guarantee(_gaussianBlur->isLinked());
     // }}}
 
     // {{{ dual kawase
-    _shaderKawaseUp->addShaderFromSourceCode(QOpenGLShader::Vertex, loadShaderSource(":/contour/display/shaders/simple.vert"));
-    _shaderKawaseUp->addShaderFromSourceCode(QOpenGLShader::Fragment, loadShaderSource(":/contour/display/shaders/dual_kawase_up.frag"));
+    _shaderKawaseUp->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, loadShaderSource(":/contour/display/shaders/simple.vert"));
+    _shaderKawaseUp->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, loadShaderSource(":/contour/display/shaders/dual_kawase_up.frag"));
     _shaderKawaseUp->link();
 
-    _shaderKawaseDown->addShaderFromSourceCode(QOpenGLShader::Vertex, loadShaderSource(":/contour/display/shaders/simple.vert"));
-    _shaderKawaseDown->addShaderFromSourceCode(QOpenGLShader::Fragment, loadShaderSource(":/contour/display/shaders/dual_kawase_down.frag"));
+    _shaderKawaseDown->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, loadShaderSource(":/contour/display/shaders/simple.vert"));
+    _shaderKawaseDown->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, loadShaderSource(":/contour/display/shaders/dual_kawase_down.frag"));
     _shaderKawaseDown->link();
     // }}}
 
@@ -113,14 +113,19 @@ Blur::~Blur()
     delete _textureToBlur;
 }
 
-QImage Blur::blurGaussian(QImage imageToBlur)
+QImage Blur::blurGaussian(QImage imageToBlur, qreal resolution)
 {
+    if (_blurred && _blurred->offset == -1 && _blurred->resolution == resolution
+        && imageToBlur == _imageToBlur)
+        return _blurred->image;
+
     _context->makeCurrent(_surface);
     Require(_context->isValid());
 
-    if (imageToBlur != _imageToBlur)
+    if (imageToBlur != _imageToBlur || resolution != _resolution || _iterations != 1)
     {
         _iterations = 1;
+        _resolution = resolution;
         _imageToBlur = std::move(imageToBlur);
         initFBOTextures();
         Require(_gaussianBlur->isLinked());
@@ -155,6 +160,7 @@ QImage Blur::blurGaussian(QImage imageToBlur)
 
     auto image = _vectorFBO[0]->toImage();
     _context->doneCurrent();
+    _blurred = BlurredImage { .image = image, .offset = -1, .iterations = 1, .resolution = resolution };
 
 #if defined(CONTOUR_GPU_TIMERS)
     displayLog()("Blur: Gaussian run performance: {:.3}s CPU, {:.3}s GPU.", getCPUTime(), getGPUTime());
@@ -164,14 +170,19 @@ QImage Blur::blurGaussian(QImage imageToBlur)
     return image;
 }
 
-QImage Blur::blurDualKawase(QImage imageToBlur, int offset, int iterations)
+QImage Blur::blurDualKawase(QImage imageToBlur, int offset, int iterations, qreal resolution)
 {
+    if (_blurred && _blurred->offset == offset && _blurred->iterations == iterations
+        && _blurred->resolution == resolution && imageToBlur == _imageToBlur)
+        return _blurred->image;
+
     _context->makeCurrent(_surface);
 
     // Check to avoid unnecessary texture reallocation
-    if (iterations != _iterations || imageToBlur != _imageToBlur)
+    if (iterations != _iterations || resolution != _resolution || imageToBlur != _imageToBlur)
     {
         _iterations = iterations;
+        _resolution = resolution;
         _imageToBlur = std::move(imageToBlur);
 
         initFBOTextures();
@@ -222,6 +233,9 @@ QImage Blur::blurDualKawase(QImage imageToBlur, int offset, int iterations)
 
     auto image = _vectorFBO[0]->toImage();
     _context->doneCurrent();
+    _blurred = BlurredImage {
+        .image = image, .offset = offset, .iterations = iterations, .resolution = resolution
+    };
     return image;
 }
 
@@ -249,14 +263,16 @@ void Blur::initFBOTextures()
     for (auto& i: _vectorFBO)
         delete i;
 
+    // The whole chain runs at the reduced resolution, only the initial downsample reads the full image.
+    auto const size = (_imageToBlur.size() * _resolution).expandedTo(QSize(1, 1));
     _vectorFBO.clear();
-    _vectorFBO.append(new QOpenGLFramebufferObject(
-        _imageToBlur.size(), QOpenGLFramebufferObject::CombinedDepthStencil, GL_TEXTURE_2D));
+    _vectorFBO.append(
+        new QOpenGLFramebufferObject(size, QOpenGLFramebufferObject::CombinedDepthStencil, GL_TEXTURE_2D));
 
     for (int i = 1; i <= _iterations; i++)
     {
         _vectorFBO.append(new QOpenGLFramebufferObject(
-            _imageToBlur.size() / qPow(2, i), QOpenGLFramebufferObject::CombinedDepthStencil, GL_TEXTURE_2D));
+            size / qPow(2, i), QOpenGLFramebufferObject::CombinedDepthStencil, GL_TEXTURE_2D));
 
         CHECKED_GL(glBindTexture(GL_TEXTURE_2D, _vectorFBO.last()->texture()));
         CHECKED_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
@@ -29,6 +29,8 @@
     #include <QtGui/QOpenGLVertexArrayObject>
 #endif
 
+#include <optional>
+
 namespace contour::display
 {
 
@@ -43,8 +45,12 @@ class Blur: protected QOpenGLExtraFunctions
     Blur();
     ~Blur();
 
-    QImage blurDualKawase(QImage imageToBlur, int offset, int iterations);
-    QImage blurGaussian(QImage imageToBlur);
+    /// Blurs the given image, unless it has been blurred with the same parameters just before.
+    ///
+    /// @param resolution  fraction of the image's resolution the blur is computed at, and which the
+    ///                    resulting image is of, as it is to be stretched over the original anyway.
+    QImage blurDualKawase(QImage imageToBlur, int offset, int iterations, qreal resolution = 1.0);
+    QImage blurGaussian(QImage imageToBlur, qreal resolution = 1.0);
 
     [[nodiscard]] float getGPUTime() const noexcept;
     [[nodiscard]] float getCPUTime() const noexcept;
@@ -68,8 +74,19 @@ class Blur: protected QOpenGLExtraFunctions
     QOpenGLBuffer _vertexBuffer;
 
     int _iterations = -1;
+    qreal _resolution = 1.0;
     QImage _imageToBlur;
 
+    // Most recent result, returned again for as long as neither the image nor the parameters change.
+    struct BlurredImage
+    {
+        QImage image;
+        int offset = -1; // -1 for the gaussian blur
+        int iterations = -1;
+        qreal resolution = 1.0;
+    };
+    std::optional<BlurredImage> _blurred;
+
     // GPU timer
     GLuint64 _timerGPUElapsedTime {};
 
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/primitives.h>
+
+#include <vtrasterizer/RenderTarget.h>
+#include <vtrasterizer/TextureAtlas.h>
+
+#include <QtGui/QMatrix4x4>
+#include <QtQuick/QQuickWindow>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace contour::display
+{
+
+/**
+ * Render target of a TerminalDisplay, rendering onto the window of the display's scene graph.
+ *
+ * @see OpenGLRenderer, RhiRenderer
+ */
+class DisplayRenderTarget: public vtrasterizer::RenderTarget, public vtrasterizer::atlas::AtlasBackend
+{
+  public:
+    virtual void setWindow(QQuickWindow* window) = 0;
+    virtual void setTranslation(float x, float y, float z) noexcept = 0;
+    virtual void setViewSize(vtbackend::ImageSize size) noexcept = 0;
+    virtual void setModelMatrix(QMatrix4x4 matrix) noexcept = 0;
+
+    [[nodiscard]] virtual bool initialized() const noexcept = 0;
+
+    /// Initializes the graphics resources, from within the scene graph's render thread.
+    virtual void initialize() = 0;
+
+    /// Whether executed frames are drawn by recordRenderPass() within the window's render pass,
+    /// which requires them to be executed before that pass begins.
+    /// Otherwise they are drawn right away by RenderTarget::execute(), after the window has been rendered.
+    [[nodiscard]] virtual bool recordsRenderPass() const noexcept { return false; }
+
+    /// Records the draws of the most recently executed frame into the window's current render pass.
+    virtual void recordRenderPass() {}
+
+    /// Completes the most recently executed frame after the window's render pass ended.
+    virtual void finishFrame() {}
+
+    /// @returns the pixels of the window's most recently rendered frame, bottom row first.
+    virtual std::pair<vtbackend::ImageSize, std::vector<uint8_t>> takeScreenshot() = 0;
+};
+
+} // namespace contour::display
@@ -11,17 +11,18 @@
 #include <crispy/algorithm.h>
 #include <crispy/assert.h>
 #include <crispy/defines.h>
+#include <crispy/tracing.h>
 #include <crispy/utils.h>
 
 #include <range/v3/all.hpp>
 
 #include <QtCore/QtGlobal>
 #include <QtGui/QGuiApplication>
-#include <QtGui/QImage>
 
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
 #include <memory>
 #include <optional>
 #include <utility>
@@ -53,14 +54,16 @@ namespace atlas = vtrasterizer::atlas;
 namespace contour::display
 {
 
-namespace ZAxisDepths
-{
-    constexpr GLfloat BackgroundSGR = 0.0f;
-    constexpr GLfloat Text = 0.0f;
-} // namespace ZAxisDepths
-
 namespace
 {
+    // Number of floats per instance record of a texture tile: target rectangle (XYWH),
+    // normalized atlas rectangle (XYWH), atlas layer and userdata (IU), color (RGBA).
+    constexpr size_t TileInstanceSize = 4 + 4 + 2 + 4;
+
+    // Number of floats per instance record of a filled rectangle:
+    // target rectangle (XYWH), color (RGBA).
+    constexpr size_t RectInstanceSize = 4 + 4;
+
     struct CRISPY_PACKED vec2 // NOLINT
     {
         float x;
@@ -125,6 +128,33 @@ namespace
         crispy::unreachable();
     }
 
+    // Maps a texture atlas format to the matching OpenGL texture and pixel formats.
+    struct GLAtlasFormat
+    {
+        QOpenGLTexture::TextureFormat textureFormat;
+        QOpenGLTexture::PixelFormat pixelFormat;
+        GLenum sourceFormat;
+    };
+
+    GLAtlasFormat glAtlasFormat(atlas::Format format)
+    {
+        switch (format)
+        {
+            case atlas::Format::Red:
+                return { QOpenGLTexture::TextureFormat::R8_UNorm, QOpenGLTexture::PixelFormat::Red, GL_RED };
+            case atlas::Format::RGB:
+                return { QOpenGLTexture::TextureFormat::RGB8_UNorm,
+                         QOpenGLTexture::PixelFormat::RGB,
+                         GL_RGB };
+            case atlas::Format::RGBA:
+                return { QOpenGLTexture::TextureFormat::RGBA8_UNorm,
+                         QOpenGLTexture::PixelFormat::RGBA,
+                         GL_RGBA };
+        }
+        Guarantee(false);
+        crispy::unreachable();
+    }
+
     struct OpenGLContextGuard
     {
         QOpenGLContext* context;
@@ -160,11 +190,14 @@ namespace
 } // namespace
 
 /**
- * Text rendering input:
- *  - vec3 screenCoord    (x/y/z)
- *  - vec4 textureCoord   (x/y and w/h)
+ * Text rendering input, per instance (tile):
+ *  - vec4 targetRect     (x/y and w/h)
+ *  - vec4 textureRect    (x/y and w/h)
+ *  - vec2 tileInfo       (atlas layer, fragment shader selector)
  *  - vec4 textColor      (r/g/b/a)
  *
+ * Each instance is drawn as a quad (triangle strip of 4 vertices),
+ * whose corners are derived from gl_VertexID in the vertex shader.
  */
 
 OpenGLRenderer::OpenGLRenderer(ShaderConfig textShaderConfig,
@@ -189,6 +222,8 @@ void OpenGLRenderer::setRenderSize(vtbackend::ImageSize targetSurfaceSize)
         return;
 
     _renderTargetSize = targetSurfaceSize;
+    _retainedContents.valid = false;
+    _offscreen.valid = false;
     _projectionMatrix = ortho(/* left */ 0.0f,
                               /* right */ unbox<float>(_renderTargetSize.width),
                               /* bottom */ unbox<float>(_renderTargetSize.height),
@@ -199,18 +234,25 @@ void OpenGLRenderer::setRenderSize(vtbackend::ImageSize targetSurfaceSize)
 
 void OpenGLRenderer::setTranslation(float x, float y, float z) noexcept
 {
-    _viewMatrix.setToIdentity();
-    _viewMatrix.translate(x, y, z);
+    auto viewMatrix = QMatrix4x4 {};
+    viewMatrix.translate(x, y, z);
+    if (viewMatrix != _viewMatrix)
+        _offscreen.valid = false;
+    _viewMatrix = viewMatrix;
 }
 
 void OpenGLRenderer::setModelMatrix(QMatrix4x4 matrix) noexcept
 {
+    if (matrix != _modelMatrix)
+        _offscreen.valid = false;
     _modelMatrix = matrix;
 }
 
 void OpenGLRenderer::setMargin(vtrasterizer::PageMargin margin) noexcept
 {
     _margin = margin;
+    _retainedContents.valid = false;
+    _offscreen.valid = false;
 }
 
 atlas::AtlasBackend& OpenGLRenderer::textureScheduler()
@@ -220,70 +262,99 @@ atlas::AtlasBackend& OpenGLRenderer::textureScheduler()
 
 void OpenGLRenderer::initializeRectRendering()
 {
-    CHECKED_GL(glGenVertexArrays(1, &_rectVAO));
-    CHECKED_GL(glBindVertexArray(_rectVAO));
+    CHECKED_GL(glGenVertexArrays(InstanceBufferCount, _rectInstances.vertexArrays.data()));
+    CHECKED_GL(glGenBuffers(InstanceBufferCount, _rectInstances.buffers.data()));
 
-    CHECKED_GL(glGenBuffers(1, &_rectVBO));
-    CHECKED_GL(glBindBuffer(GL_ARRAY_BUFFER, _rectVBO));
-    CHECKED_GL(glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW));
+    constexpr auto const BufferStride = RectInstanceSize * sizeof(GLfloat);
+    const auto* const RectOffset = (void const*) (0 * sizeof(GLfloat));  // NOLINT
+    const auto* const ColorOffset = (void const*) (4 * sizeof(GLfloat)); // NOLINT
 
-    constexpr auto const BufferStride = 7 * sizeof(GLfloat);
-    const auto* const VertexOffset = (void const*) (0 * sizeof(GLfloat)); // NOLINT
-    const auto* const ColorOffset = (void const*) (3 * sizeof(GLfloat));  // NOLINT
-
-    // 0 (vec3): vertex buffer
-    CHECKED_GL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, BufferStride, VertexOffset));
-    CHECKED_GL(glEnableVertexAttribArray(0));
-
-    // 1 (vec4): color buffer
-    CHECKED_GL(glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, BufferStride, ColorOffset));
-    CHECKED_GL(glEnableVertexAttribArray(1));
+    for (size_t i = 0; i < InstanceBufferCount; ++i)
+    {
+        CHECKED_GL(glBindVertexArray(_rectInstances.vertexArrays[i]));
+        CHECKED_GL(glBindBuffer(GL_ARRAY_BUFFER, _rectInstances.buffers[i]));
+        CHECKED_GL(glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW));
+
+        // 0 (vec4): target rectangle
+        CHECKED_GL(glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, BufferStride, RectOffset));
+        CHECKED_GL(glVertexAttribDivisor(0, 1));
+        CHECKED_GL(glEnableVertexAttribArray(0));
+
+        // 1 (vec4): color
+        CHECKED_GL(glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, BufferStride, ColorOffset));
+        CHECKED_GL(glVertexAttribDivisor(1, 1));
+        CHECKED_GL(glEnableVertexAttribArray(1));
+    }
 
     CHECKED_GL(glBindVertexArray(0));
 }
 
 void OpenGLRenderer::initializeTextureRendering()
 {
-    CHECKED_GL(glGenVertexArrays(1, &_textVAO));
-    CHECKED_GL(glBindVertexArray(_textVAO));
+    CHECKED_GL(glGenVertexArrays(InstanceBufferCount, _textInstances.vertexArrays.data()));
+    CHECKED_GL(glGenBuffers(InstanceBufferCount, _textInstances.buffers.data()));
+    CHECKED_GL(glGenBuffers(1, &_uploadBuffer));
 
-    constexpr auto const BufferStride = (3 + 4 + 4) * sizeof(GLfloat);
-    constexpr auto const* const VertexOffset = (void const*) nullptr;
-    const auto* const TexCoordOffset = (void const*) (3 * sizeof(GLfloat)); // NOLINT
-    const auto* const ColorOffset = (void const*) (7 * sizeof(GLfloat));    // NOLINT
+    constexpr auto const BufferStride = TileInstanceSize * sizeof(GLfloat);
+    constexpr auto const* const RectOffset = (void const*) nullptr;
+    const auto* const TexCoordOffset = (void const*) (4 * sizeof(GLfloat)); // NOLINT
+    const auto* const TileInfoOffset = (void const*) (8 * sizeof(GLfloat)); // NOLINT
+    const auto* const ColorOffset = (void const*) (10 * sizeof(GLfloat));   // NOLINT
 
-    CHECKED_GL(glGenBuffers(1, &_textVBO));
-    CHECKED_GL(glBindBuffer(GL_ARRAY_BUFFER, _textVBO));
-    CHECKED_GL(glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW));
-
-    // 0 (vec3): vertex buffer
-    CHECKED_GL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, BufferStride, VertexOffset));
-    CHECKED_GL(glEnableVertexAttribArray(0));
-
-    // 1 (vec4): texture coordinates buffer
-    CHECKED_GL(glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, BufferStride, TexCoordOffset));
-    CHECKED_GL(glEnableVertexAttribArray(1));
-
-    // 2 (vec4): color buffer
-    CHECKED_GL(glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, BufferStride, ColorOffset));
-    CHECKED_GL(glEnableVertexAttribArray(2));
-
-    // setup EBO
-    // glGenBuffers(1, &_ebo);
-    // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
-    // static const GLuint indices[6] = { 0, 1, 3, 1, 2, 3 };
-    // glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // glVertexAttribDivisor(0, 1); // TODO: later for instanced rendering
+    for (size_t i = 0; i < InstanceBufferCount; ++i)
+    {
+        CHECKED_GL(glBindVertexArray(_textInstances.vertexArrays[i]));
+        CHECKED_GL(glBindBuffer(GL_ARRAY_BUFFER, _textInstances.buffers[i]));
+        CHECKED_GL(glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW));
+
+        // 0 (vec4): target rectangle
+        CHECKED_GL(glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, BufferStride, RectOffset));
+        CHECKED_GL(glVertexAttribDivisor(0, 1));
+        CHECKED_GL(glEnableVertexAttribArray(0));
+
+        // 1 (vec4): normalized texture atlas rectangle
+        CHECKED_GL(glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, BufferStride, TexCoordOffset));
+        CHECKED_GL(glVertexAttribDivisor(1, 1));
+        CHECKED_GL(glEnableVertexAttribArray(1));
+
+        // 2 (vec2): texture atlas layer and fragment shader selector
+        CHECKED_GL(glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, BufferStride, TileInfoOffset));
+        CHECKED_GL(glVertexAttribDivisor(2, 1));
+        CHECKED_GL(glEnableVertexAttribArray(2));
+
+        // 3 (vec4): color
+        CHECKED_GL(glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, BufferStride, ColorOffset));
+        CHECKED_GL(glVertexAttribDivisor(3, 1));
+        CHECKED_GL(glEnableVertexAttribArray(3));
+    }
 
     CHECKED_GL(glBindVertexArray(0));
 }
 
+void OpenGLRenderer::initializeCompositing()
+{
+    CHECKED_GL(_compositeShader = createShader(builtinShaderConfig(ShaderClass::Composite)));
+    CHECKED_GL(_compositeTextureLocation = _compositeShader->uniformLocation("u_texture"));
+    CHECKED_GL(glGenVertexArrays(1, &_compositeVertexArray));
+    CHECKED_GL(glGenFramebuffers(1, &_offscreen.framebuffer));
+    CHECKED_GL(glGenTextures(1, &_offscreen.texture));
+}
+
 OpenGLRenderer::~OpenGLRenderer()
 {
     displayLog()("~OpenGLRenderer");
-    CHECKED_GL(glDeleteVertexArrays(1, &_rectVAO));
-    CHECKED_GL(glDeleteBuffers(1, &_rectVBO));
+    if (_screenshotReadback.fence && !finishScreenshotReadback(true))
+        glDeleteSync(_screenshotReadback.fence);
+    CHECKED_GL(glDeleteBuffers(1, &_screenshotReadback.buffer));
+    for (auto* draw: { &_rectInstances, &_textInstances })
+    {
+        CHECKED_GL(glDeleteVertexArrays(InstanceBufferCount, draw->vertexArrays.data()));
+        CHECKED_GL(glDeleteBuffers(InstanceBufferCount, draw->buffers.data()));
+    }
+    CHECKED_GL(glDeleteBuffers(1, &_uploadBuffer));
+    CHECKED_GL(glDeleteVertexArrays(1, &_compositeVertexArray));
+    CHECKED_GL(glDeleteFramebuffers(1, &_offscreen.framebuffer));
+    CHECKED_GL(glDeleteTextures(1, &_offscreen.texture));
 }
 
 void OpenGLRenderer::initialize()
@@ -303,7 +374,10 @@ void OpenGLRenderer::initialize()
     // clang-format off
     CHECKED_GL(_textShader = createShader(_textShaderConfig));
     CHECKED_GL(_textProjectionLocation = _textShader->uniformLocation("vs_projection")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
-    CHECKED_GL(_textTextureAtlasLocation = _textShader->uniformLocation("fs_textureAtlas"));
+    CHECKED_GL(_textMonochromeAtlasLocation = _textShader->uniformLocation("fs_monochromeAtlas")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
+    CHECKED_GL(_textLcdAtlasLocation = _textShader->uniformLocation("fs_lcdAtlas")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
+    CHECKED_GL(_textColorAtlasLocation = _textShader->uniformLocation("fs_colorAtlas")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
+    CHECKED_GL(_textImageAtlasLocation = _textShader->uniformLocation("fs_imageAtlas")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
     CHECKED_GL(_textTimeLocation = _textShader->uniformLocation("u_time")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
     CHECKED_GL(_rectShader = createShader(_rectShaderConfig));
     CHECKED_GL(_rectProjectionLocation = _rectShader->uniformLocation("u_projection")); // NOLINT(cppcoreguidelines-prefer-member-initializer)
@@ -318,13 +392,20 @@ void OpenGLRenderer::initialize()
     assert(_textProjectionLocation != -1);
 
     bound(*_textShader, [&]() {
-        auto const textureAtlasWidth = unbox<GLfloat>(_textureAtlas.textureSize.width);
-        CHECKED_GL(_textShader->setUniformValue("pixel_x", 1.0f / textureAtlasWidth));
-        CHECKED_GL(_textShader->setUniformValue(_textTextureAtlasLocation, 0)); // GL_TEXTURE0?
+        // Each atlas is bound to the texture unit of its index.
+        auto const unit = [](atlas::Format format) {
+            return static_cast<GLint>(atlas::formatIndex(format));
+        };
+        auto const imageUnit = static_cast<GLint>(atlas::ImageAtlasIndex);
+        CHECKED_GL(_textShader->setUniformValue(_textMonochromeAtlasLocation, unit(atlas::Format::Red)));
+        CHECKED_GL(_textShader->setUniformValue(_textLcdAtlasLocation, unit(atlas::Format::RGB)));
+        CHECKED_GL(_textShader->setUniformValue(_textColorAtlasLocation, unit(atlas::Format::RGBA)));
+        CHECKED_GL(_textShader->setUniformValue(_textImageAtlasLocation, imageUnit));
     });
 
     initializeRectRendering();
     initializeTextureRendering();
+    initializeCompositing();
 
     logInfo();
 }
@@ -369,6 +450,8 @@ void OpenGLRenderer::logInfo()
 
 void OpenGLRenderer::clearCache()
 {
+    _retainedContents.valid = false;
+    _offscreen.valid = false;
 }
 
 int OpenGLRenderer::maxTextureDepth()
@@ -386,19 +469,18 @@ int OpenGLRenderer::maxTextureSize()
 }
 
 // {{{ AtlasBackend impl
-ImageSize OpenGLRenderer::atlasSize() const noexcept
-{
-    return _textureAtlas.textureSize;
-}
-
 void OpenGLRenderer::configureAtlas(atlas::ConfigureAtlas atlas)
 {
     // schedule atlas creation
-    _scheduledExecutions.configureAtlas.emplace(atlas);
-    _textureAtlas.textureSize = atlas.size;
-    _textureAtlas.properties = atlas.properties;
-
-    displayLog()("configureAtlas: {} {}", atlas.size, atlas.properties.format);
+    _scheduledExecutions.configureAtlases.emplace_back(atlas);
+    _retainedContents.valid = false;
+    _offscreen.valid = false;
+    auto& textureAtlas = _textureAtlases.at(atlas.properties.atlasIndex);
+    textureAtlas.textureSize = atlas.size;
+    textureAtlas.layerCount = atlas.layerCount;
+    textureAtlas.properties = atlas.properties;
+
+    displayLog()("configureAtlas: {} x {} layers {}", atlas.size, atlas.layerCount, atlas.properties.format);
 }
 
 void OpenGLRenderer::uploadTile(atlas::UploadTile tile)
@@ -408,14 +490,17 @@ void OpenGLRenderer::uploadTile(atlas::UploadTile tile)
     //              tile.location.atlasID.value,
     //              tile.location.x.value,
     //              tile.location.y.value);
-    if (!(tile.bitmapSize.width <= _textureAtlas.properties.tileSize.width))
-        errorLog()("uploadTile assertion alert: width {} <= {} failed.", tile.bitmapSize.width, _textureAtlas.properties.tileSize.width);
-    if (!(tile.bitmapSize.height <= _textureAtlas.properties.tileSize.height))
-        errorLog()("uploadTile assertion alert: height {} <= {} failed.", tile.bitmapSize.height, _textureAtlas.properties.tileSize.height);
+    // The widest tiles are the extra wide ones.
+    auto const& properties = _textureAtlases.at(tile.atlasIndex).properties;
+    auto const maxTileWidth = properties.tileSize.width * Width::cast_from(atlas::widthFactor(atlas::TileSizeClass::ExtraWide));
+    if (!(tile.bitmapSize.width <= maxTileWidth))
+        errorLog()("uploadTile assertion alert: width {} <= {} failed.", tile.bitmapSize.width, maxTileWidth);
+    if (!(tile.bitmapSize.height <= properties.tileSize.height))
+        errorLog()("uploadTile assertion alert: height {} <= {} failed.", tile.bitmapSize.height, properties.tileSize.height);
     // clang-format on
 
-    // Require(tile.bitmapSize.width <= _textureAtlas.properties.tileSize.width);
-    // Require(tile.bitmapSize.height <= _textureAtlas.properties.tileSize.height);
+    // Require(tile.bitmapSize.width <= maxTileWidth);
+    // Require(tile.bitmapSize.height <= properties.tileSize.height);
 
     _scheduledExecutions.uploadTiles.emplace_back(std::move(tile));
 }
@@ -424,10 +509,9 @@ void OpenGLRenderer::renderTile(atlas::RenderTile tile)
 {
     RenderBatch& batch = _scheduledExecutions.renderBatch;
 
-    // atlas texture Vertices to locate the tile
+    // target position of the tile on the render surface
     auto const x = static_cast<GLfloat>(tile.x.value);
     auto const y = static_cast<GLfloat>(tile.y.value);
-    auto const z = ZAxisDepths::Text;
 
     // tile bitmap size on target render surface
     GLfloat const r = unbox<GLfloat>(firstNonZero(tile.targetSize.width, tile.bitmapSize.width));
@@ -439,10 +523,8 @@ void OpenGLRenderer::renderTile(atlas::RenderTile tile)
     GLfloat const nw = tile.normalizedLocation.width;
     GLfloat const nh = tile.normalizedLocation.height;
 
-    // These two are currently not used.
-    // This used to be used for the z-plane into the 3D texture,
-    // but I've reverted back to a 2D texture atlas for now.
-    GLfloat const i = 0;
+    // Layer of the texture array the tile is stored in.
+    auto const i = static_cast<GLfloat>(tile.tileLocation.layer.value);
 
     // Tile dependant userdata.
     // This is current the fragment shader's selector that
@@ -457,27 +539,19 @@ void OpenGLRenderer::renderTile(atlas::RenderTile tile)
     GLfloat const ca = tile.color[3];
 
     // clang-format off
-    GLfloat const vertices[6 * 11] = {
-        // first triangle
-    // <X      Y      Z> <X        Y        I  U>  <R   G   B   A>
-        x,     y + s, z,  nx,      ny + nh, i, u,  cr, cg, cb, ca, // left top
-        x,     y,     z,  nx,      ny,      i, u,  cr, cg, cb, ca, // left bottom
-        x + r, y,     z,  nx + nw, ny,      i, u,  cr, cg, cb, ca, // right bottom
-
-        // second triangle
-        x,     y + s, z,  nx,      ny + nh, i, u,  cr, cg, cb, ca, // left top
-        x + r, y,     z,  nx + nw, ny,      i, u,  cr, cg, cb, ca, // right bottom
-        x + r, y + s, z,  nx + nw, ny + nh, i, u,  cr, cg, cb, ca, // right top
-
-        // buffer contains
-        // - 3 vertex coordinates (XYZ)
-        // - 4 texture coordinates (XYIU), I is unused currently, U selects which texture to use
+    GLfloat const instance[TileInstanceSize] = {
+    // <X  Y  W  H>  <X   Y   W   H>   <I  U>  <R   G   B   A>
+        x, y, r, s,   nx, ny, nw, nh,   i, u,   cr, cg, cb, ca,
+
+        // instance record contains
+        // - target rectangle (XYWH) on the render surface
+        // - normalized texture atlas rectangle (XYWH)
+        // - texture atlas layer (I) and userdata (U), the latter selects how to render the tile
         // - 4 color values (RGBA)
     };
     // clang-format on
 
-    batch.renderTiles.emplace_back(tile);
-    crispy::copy(vertices, back_inserter(batch.buffer));
+    crispy::copy(instance, back_inserter(batch.instances));
 }
 // }}}
 
@@ -538,53 +612,53 @@ struct ScopedRenderEnvironment
 void OpenGLRenderer::execute(std::chrono::steady_clock::time_point now)
 {
     Require(_initialized);
+    CRISPY_TRACE_ZONE("OpenGLRenderer::execute", "render");
 
     auto const _ = ScopedRenderEnvironment { *this };
 
     auto const timeValue = uptime(now);
 
     // displayLog()("execute {} rects, {} uploads, {} renders\n",
-    //              _rectBuffer.size() / 7,
+    //              _rectBuffer.size() / RectInstanceSize,
     //              _scheduledExecutions.uploadTiles.size(),
-    //              _scheduledExecutions.renderBatch.renderTiles.size());
+    //              _scheduledExecutions.renderBatch.instances.size() / TileInstanceSize);
 
     auto const mvp = _projectionMatrix * _viewMatrix * _modelMatrix;
 
+    // potentially (re-)configure atlases
+    //
+    for (auto const& params: _scheduledExecutions.configureAtlases)
+        executeConfigureAtlas(params);
+
+    // potentially upload any new textures, each into its own atlas
+    //
+    if (!_scheduledExecutions.uploadTiles.empty())
+        executeUploadTiles();
+
+    auto const target = beginOffscreenPass(mvp);
+
     // render filled rects
     //
-    if (!_rectBuffer.empty())
+    auto& retained = _retainedContents;
+    auto const replayRects = retained.replay && !retained.rects.empty();
+    if (replayRects || !_rectBuffer.empty())
     {
         bound(*_rectShader, [&]() {
             _rectShader->setUniformValue(_rectProjectionLocation, mvp);
             _rectShader->setUniformValue(_rectTimeLocation, timeValue);
-
-            glBindVertexArray(_rectVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, _rectVBO);
-            glBufferData(GL_ARRAY_BUFFER,
-                         static_cast<GLsizeiptr>(_rectBuffer.size() * sizeof(GLfloat)),
-                         _rectBuffer.data(),
-                         GL_STREAM_DRAW);
-
-            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_rectBuffer.size() / 7));
-            glBindVertexArray(0);
+            if (replayRects)
+                drawInstances(_rectInstances, retained.rects, RectInstanceSize);
+            if (!_rectBuffer.empty())
+                drawInstances(_rectInstances, _rectBuffer, RectInstanceSize);
         });
-        _rectBuffer.clear();
     }
-
-    // potentially (re-)configure atlas
-    //
-    if (_scheduledExecutions.configureAtlas)
-        executeConfigureAtlas(*_scheduledExecutions.configureAtlas);
-
-    // potentially upload any new textures
-    //
-    if (!_scheduledExecutions.uploadTiles.empty())
+    if (retained.mark)
     {
-        _textureAtlas.gpuTexture.bind();
-        for (auto const& params: _scheduledExecutions.uploadTiles)
-            executeUploadTile(params);
-        _textureAtlas.gpuTexture.release();
+        // Taking over the buffer, rather than copying it, as it is about to be cleared anyway.
+        std::swap(retained.rects, _rectBuffer);
+        retained.rects.resize(retained.mark->rects);
     }
+    _rectBuffer.clear();
 
     // render textures
     //
@@ -595,186 +669,367 @@ void OpenGLRenderer::execute(std::chrono::steady_clock::time_point now)
         executeRenderTextures();
     });
 
-    if (_pendingScreenshotCallback)
+    composeOffscreenPass(target);
+
+    if (_screenshotReadback.fence)
+        finishScreenshotReadback(false);
+    if (_pendingScreenshotCallback && !_screenshotReadback.fence)
     {
-        auto result = takeScreenshot();
-        _pendingScreenshotCallback.value()(result.second, result.first);
+        beginScreenshotReadback(std::move(*_pendingScreenshotCallback));
         _pendingScreenshotCallback.reset();
     }
+
+    // Another frame picks up the screenshot, even if nothing else is to be rendered.
+    if ((_screenshotReadback.fence || _pendingScreenshotCallback) && _window)
+        QMetaObject::invokeMethod(_window, &QQuickWindow::update, Qt::QueuedConnection);
 }
 
 void OpenGLRenderer::executeRenderTextures()
 {
-    // upload vertices and render
+    // upload instances and render
     RenderBatch& batch = _scheduledExecutions.renderBatch;
-    if (!batch.renderTiles.empty())
+    auto& retained = _retainedContents;
+    auto const replayTiles = retained.replay && !retained.tiles.empty();
+    if (replayTiles || !batch.instances.empty())
     {
-        _textureAtlas.gpuTexture.bind();
-        glBindVertexArray(_textVAO);
+        // The fragment shader samples each tile from the atlas of its type.
+        for (size_t atlasIndex = 0; atlasIndex < atlas::AtlasCount; ++atlasIndex)
+            _textureAtlases[atlasIndex].gpuTexture.bind(static_cast<uint>(atlasIndex));
+        if (replayTiles)
+            drawInstances(_textInstances, retained.tiles, TileInstanceSize);
+        if (!batch.instances.empty())
+            drawInstances(_textInstances, batch.instances, TileInstanceSize);
+        for (size_t atlasIndex = 0; atlasIndex < atlas::AtlasCount; ++atlasIndex)
+            _textureAtlases[atlasIndex].gpuTexture.release(static_cast<uint>(atlasIndex));
+        glActiveTexture(GL_TEXTURE0);
+    }
 
-        // upload buffer
-        glBindBuffer(GL_ARRAY_BUFFER, _textVBO);
-        glBufferData(GL_ARRAY_BUFFER,
-                     static_cast<GLsizei>(batch.buffer.size() * sizeof(GLfloat)),
-                     batch.buffer.data(),
-                     GL_STREAM_DRAW);
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(batch.renderTiles.size() * 6));
+    if (retained.mark)
+    {
+        std::swap(retained.tiles, batch.instances);
+        retained.tiles.resize(retained.mark->tiles);
+        retained.valid = true;
+        retained.mark.reset();
+    }
+    retained.replay = false;
+
+    _scheduledExecutions.clear();
+}
 
+void OpenGLRenderer::retainContents()
+{
+    _retainedContents.mark = RetainedContents::Mark {
+        .rects = _rectBuffer.size(),
+        .tiles = _scheduledExecutions.renderBatch.instances.size(),
+    };
+}
+
+bool OpenGLRenderer::replayContents()
+{
+    if (!_retainedContents.valid)
+        return false;
+
+    _retainedContents.replay = true;
+    return true;
+}
+
+void OpenGLRenderer::setDamage(vtrasterizer::FrameDamage const& damage)
+{
+    _damage.full = damage.full;
+    _damage.bands.assign(damage.bands.begin(), damage.bands.end());
+}
+
+OpenGLRenderer::RenderPassTarget OpenGLRenderer::beginOffscreenPass(QMatrix4x4 const& mvp)
+{
+    auto target = RenderPassTarget {};
+    CHECKED_GL(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target.framebuffer));
+    CHECKED_GL(glGetIntegerv(GL_VIEWPORT, target.viewport.data()));
+
+    auto const width = unbox<GLsizei>(_renderTargetSize.width);
+    auto const height = unbox<GLsizei>(_renderTargetSize.height);
+    CHECKED_GL(glBindFramebuffer(GL_FRAMEBUFFER, _offscreen.framebuffer));
+    if (_offscreen.size != _renderTargetSize)
+    {
+        CHECKED_GL(glBindTexture(GL_TEXTURE_2D, _offscreen.texture));
+        CHECKED_GL(glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        CHECKED_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+        CHECKED_GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+        CHECKED_GL(glBindTexture(GL_TEXTURE_2D, 0));
+        CHECKED_GL(glFramebufferTexture2D(
+            GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _offscreen.texture, 0));
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            errorLog()("Offscreen framebuffer of size {} is incomplete.", _renderTargetSize);
+        _offscreen.size = _renderTargetSize;
+        _offscreen.valid = false;
+    }
+    CHECKED_GL(glViewport(0, 0, width, height));
+
+    // Blending into the offscreen framebuffer keeps its colors premultiplied by alpha.
+    CHECKED_GL(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+
+    // Each band of damage is mapped onto the rows of window pixels it spans.
+    _repaintDamageOnly = _offscreen.valid && !_damage.full;
+    _damageRects.clear();
+    if (_repaintDamageOnly)
+    {
+        auto const windowY = [&](int y) {
+            auto const normalizedY = mvp.map(QPointF(0.0, static_cast<qreal>(y))).y();
+            return (normalizedY + 1.0) / 2.0 * static_cast<qreal>(height);
+        };
+        for (auto const& band: _damage.bands)
+        {
+            auto const bottom = std::clamp(static_cast<GLint>(std::floor(windowY(band.bottom))), 0, height);
+            auto const top = std::clamp(static_cast<GLint>(std::ceil(windowY(band.top))), 0, height);
+            if (bottom < top)
+                _damageRects.push_back({ 0, bottom, width, top - bottom });
+        }
+    }
+
+    CHECKED_GL(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+    if (!_repaintDamageOnly)
+        CHECKED_GL(glClear(GL_COLOR_BUFFER_BIT));
+    else
+    {
+        CHECKED_GL(glEnable(GL_SCISSOR_TEST));
+        for (auto const& [x, y, rectWidth, rectHeight]: _damageRects)
+        {
+            CHECKED_GL(glScissor(x, y, rectWidth, rectHeight));
+            CHECKED_GL(glClear(GL_COLOR_BUFFER_BIT));
+        }
+        CHECKED_GL(glDisable(GL_SCISSOR_TEST));
+    }
+    _offscreen.valid = true;
+    _damage.full = true;
+
+    return target;
+}
+
+void OpenGLRenderer::composeOffscreenPass(RenderPassTarget const& target)
+{
+    CHECKED_GL(glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(target.framebuffer)));
+    auto const& [x, y, width, height] = target.viewport;
+    CHECKED_GL(glViewport(x, y, width, height));
+
+    auto const depthTest = glIsEnabled(GL_DEPTH_TEST) != GL_FALSE;
+    CHECKED_GL(glDisable(GL_DEPTH_TEST));
+    CHECKED_GL(glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE));
+    bound(*_compositeShader, [&]() {
+        _compositeShader->setUniformValue(_compositeTextureLocation, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, _offscreen.texture);
+        glBindVertexArray(_compositeVertexArray);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
         glBindVertexArray(0);
-        _textureAtlas.gpuTexture.release();
+        glBindTexture(GL_TEXTURE_2D, 0);
+    });
+    if (depthTest)
+        CHECKED_GL(glEnable(GL_DEPTH_TEST));
+}
+
+void OpenGLRenderer::drawInstances(InstancedDraw& draw, vector<GLfloat> const& instances, size_t instanceSize)
+{
+    // Cycle to the least recently used buffer, which the GPU is most likely done drawing from.
+    draw.current = (draw.current + 1) % InstanceBufferCount;
+    auto const byteCount = instances.size() * sizeof(GLfloat);
+    auto& capacity = draw.capacities[draw.current];
+
+    glBindVertexArray(draw.vertexArrays[draw.current]);
+    glBindBuffer(GL_ARRAY_BUFFER, draw.buffers[draw.current]);
+
+    // Only (re-)allocate buffer storage when it grows, otherwise the contents are merely replaced.
+    if (byteCount > capacity)
+    {
+        capacity = std::max(byteCount, 2 * capacity);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity), nullptr, GL_STREAM_DRAW);
     }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(byteCount), instances.data());
 
-    _scheduledExecutions.clear();
+    // One quad per instance, drawn as triangle strip of 4 vertices.
+    auto const instanceCount = static_cast<GLsizei>(instances.size() / instanceSize);
+    if (!_repaintDamageOnly)
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+    else
+    {
+        // Only the damaged areas are painted over, the instances outside of them are clipped away.
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& [x, y, width, height]: _damageRects)
+        {
+            glScissor(x, y, width, height);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instanceCount);
+        }
+        glDisable(GL_SCISSOR_TEST);
+    }
+    glBindVertexArray(0);
 }
 
 void OpenGLRenderer::executeConfigureAtlas(atlas::ConfigureAtlas const& param)
 {
     Require(isPowerOfTwo(unbox(param.size.width)));
     Require(isPowerOfTwo(unbox(param.size.height)));
-    Require(param.properties.format == atlas::Format::RGBA);
 
     // Already initialized.
-    // _textureAtlas.textureSize = param.size;
-    // _textureAtlas.properties = param.properties;
-
-    if (_textureAtlas.gpuTexture.isCreated())
-        _textureAtlas.gpuTexture.destroy();
-
-    _textureAtlas.gpuTexture.setMipLevels(0);
-    _textureAtlas.gpuTexture.setAutoMipMapGenerationEnabled(false);
-    _textureAtlas.gpuTexture.setFormat(QOpenGLTexture::TextureFormat::RGBA8_UNorm);
-    _textureAtlas.gpuTexture.setSize(unbox<int>(param.size.width), unbox<int>(param.size.height));
-    _textureAtlas.gpuTexture.setMagnificationFilter(QOpenGLTexture::Filter::Nearest);
-    _textureAtlas.gpuTexture.setMinificationFilter(QOpenGLTexture::Filter::Nearest);
-    _textureAtlas.gpuTexture.setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
-    _textureAtlas.gpuTexture.create();
-    Require(_textureAtlas.gpuTexture.isCreated());
-
-    QImage stubData(QSize(unbox<int>(param.size.width), unbox<int>(param.size.height)),
-                    QImage::Format::Format_RGBA8888);
-    stubData.fill(qRgba(0x00, 0xA0, 0x00, 0xC0));
-    _textureAtlas.gpuTexture.setData(stubData);
+    // textureAtlas.textureSize = param.size;
+    // textureAtlas.properties = param.properties;
+
+    auto& textureAtlas = _textureAtlases.at(param.properties.atlasIndex);
+    auto const glFormat = glAtlasFormat(param.properties.format);
+
+    if (textureAtlas.gpuTexture.isCreated())
+        textureAtlas.gpuTexture.destroy();
+
+    textureAtlas.gpuTexture.setMipLevels(0);
+    textureAtlas.gpuTexture.setAutoMipMapGenerationEnabled(false);
+    textureAtlas.gpuTexture.setFormat(glFormat.textureFormat);
+    textureAtlas.gpuTexture.setSize(unbox<int>(param.size.width), unbox<int>(param.size.height));
+    textureAtlas.gpuTexture.setLayers(static_cast<int>(param.layerCount));
+    textureAtlas.gpuTexture.setMagnificationFilter(QOpenGLTexture::Filter::Nearest);
+    textureAtlas.gpuTexture.setMinificationFilter(QOpenGLTexture::Filter::Nearest);
+    textureAtlas.gpuTexture.setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
+    textureAtlas.gpuTexture.create();
+    Require(textureAtlas.gpuTexture.isCreated());
+    textureAtlas.gpuTexture.allocateStorage(glFormat.pixelFormat, QOpenGLTexture::PixelType::UInt8);
+
+    auto const stubData =
+        atlas::Buffer(param.size.area() * element_count(param.properties.format), uint8_t { 0x00 });
+    for (auto layer = 0; layer < static_cast<int>(param.layerCount); ++layer)
+        textureAtlas.gpuTexture.setData(0, // mip level
+                                        layer,
+                                        glFormat.pixelFormat,
+                                        QOpenGLTexture::PixelType::UInt8,
+                                        stubData.data(),
+                                        &_transferOptions);
+
+    if (param.properties.format == atlas::Format::RGB)
+    {
+        // Used for LCD subpixel filtering.
+        bound(*_textShader, [&]() {
+            auto const textureAtlasWidth = unbox<GLfloat>(param.size.width);
+            CHECKED_GL(_textShader->setUniformValue("pixel_x", 1.0f / textureAtlasWidth));
+        });
+    }
 
-    displayLog()(
-        "GL configure atlas: {} {} GL texture Id {}", param.size, param.properties.format, textureAtlasId());
+    displayLog()("GL configure atlas: {} x {} layers {} GL texture Id {}",
+                 param.size,
+                 param.layerCount,
+                 param.properties.format,
+                 textureAtlasId(param.properties.atlasIndex));
 }
 
-void OpenGLRenderer::executeUploadTile(atlas::UploadTile const& param)
+void OpenGLRenderer::executeUploadTiles()
 {
-    Require(textureAtlasId() != 0);
-
-    // clang-format off
-    // displayLog()("-> uploadTile: tex {} location {} format {} size {}",
-    //              textureId, param.location, param.bitmapFormat, param.bitmapSize);
-    // clang-format on
+    auto const& uploadTiles = _scheduledExecutions.uploadTiles;
+
+    // All tiles of the frame are staged in one pixel buffer, which the driver copies them into the
+    // atlases from asynchronously. Mapping it invalidates (orphans) its previous contents, so that
+    // the CPU never waits for the GPU to finish reading the tiles of a previous frame.
+    auto byteCount = size_t { 0 };
+    _uploadOffsets.clear();
+    for (auto const& tile: uploadTiles)
+    {
+        _uploadOffsets.push_back(byteCount);
+        byteCount += tile.bitmap.size();
+    }
+    if (!byteCount)
+        return;
 
-    // {{{ Force RGBA as OpenGL ES cannot implicitly convert on the driver-side.
-    auto const* bitmapData = (void const*) param.bitmap.data();
-    auto bitmapConverted = atlas::Buffer();
-    switch (param.bitmapFormat)
-    {
-        case atlas::Format::Red: {
-            bitmapConverted.resize(param.bitmapSize.area() * 4);
-            bitmapData = bitmapConverted.data();
-            auto const* s = param.bitmap.data();
-            auto const* const e = param.bitmap.data() + param.bitmap.size();
-            auto* t = bitmapConverted.data();
-            while (s != e)
-            {
-                *t++ = *s++; // red
-                *t++ = 0x00; // green
-                *t++ = 0x00; // blue
-                *t++ = 0xFF; // alpha
-            }
-            break;
+    CHECKED_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _uploadBuffer));
+    if (byteCount > _uploadBufferCapacity)
+    {
+        _uploadBufferCapacity = std::max(byteCount, 2 * _uploadBufferCapacity);
+        CHECKED_GL(glBufferData(
+            GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(_uploadBufferCapacity), nullptr, GL_STREAM_DRAW));
+    }
+    auto constexpr MapAccess = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+    auto* const staging = static_cast<uint8_t*>(
+        glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(byteCount), MapAccess));
+    if (staging)
+    {
+        for (size_t i = 0; i < uploadTiles.size(); ++i)
+        {
+            auto const& bitmap = uploadTiles[i].bitmap;
+            std::copy(bitmap.begin(), bitmap.end(), staging + _uploadOffsets[i]);
         }
-        case atlas::Format::RGB: {
-            bitmapConverted.resize(param.bitmapSize.area() * 4);
-            bitmapData = bitmapConverted.data();
-            auto const* s = param.bitmap.data();
-            auto const* const e = param.bitmap.data() + param.bitmap.size();
-            auto* t = bitmapConverted.data();
-            while (s != e)
-            {
-                *t++ = *s++; // red
-                *t++ = *s++; // green
-                *t++ = *s++; // blue
-                *t++ = 0xFF; // alpha
-            }
-            break;
+        if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+            errorLog()("Unmapping the tile upload buffer failed, its tiles may show up garbled.");
+    }
+    else
+    {
+        // Uploading straight from the tiles' bitmaps then, as the buffer could not be mapped.
+        errorLog()("Mapping the tile upload buffer of {} bytes failed.", byteCount);
+        CHECKED_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    }
+
+    auto savedUnpackAlignment = GLint {};
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &savedUnpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t atlasIndex = 0; atlasIndex < atlas::AtlasCount; ++atlasIndex)
+    {
+        auto const isOfAtlas = [atlasIndex](atlas::UploadTile const& params) {
+            return params.atlasIndex == atlasIndex;
+        };
+        if (std::none_of(uploadTiles.begin(), uploadTiles.end(), isOfAtlas))
+            continue;
+
+        auto& textureAtlas = _textureAtlases[atlasIndex];
+        textureAtlas.gpuTexture.bind();
+        for (size_t i = 0; i < uploadTiles.size(); ++i)
+        {
+            auto const& tile = uploadTiles[i];
+            if (!isOfAtlas(tile))
+                continue;
+
+            // Pixel data is read from the offset into the staging buffer, while one is bound.
+            auto const* const pixels = staging ? reinterpret_cast<void const*>(_uploadOffsets[i])
+                                               : static_cast<void const*>(tile.bitmap.data());
+            Require(textureAtlasId(tile.atlasIndex) != 0);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                            0, // level of detail
+                            tile.location.x.value,
+                            tile.location.y.value,
+                            tile.location.layer.value,
+                            unbox<GLsizei>(tile.bitmapSize.width),
+                            unbox<GLsizei>(tile.bitmapSize.height),
+                            1, // depth
+                            glAtlasFormat(tile.bitmapFormat).sourceFormat,
+                            GL_UNSIGNED_BYTE,
+                            pixels);
         }
-        case atlas::Format::RGBA:
-            // Already in expected format
-            break;
+        textureAtlas.gpuTexture.release();
     }
-        // }}}
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-    _textureAtlas.gpuTexture.setData(param.location.x.value,
-                                     param.location.y.value,
-                                     0, // z
-                                     unbox<int>(param.bitmapSize.width),
-                                     unbox<int>(param.bitmapSize.height),
-                                     0, // depth
-                                     QOpenGLTexture::PixelFormat::RGBA,
-                                     QOpenGLTexture::PixelType::UInt8,
-                                     bitmapData,
-                                     &_transferOptions);
-#else
-    glTexSubImage2D(GL_TEXTURE_2D,
-                    0, // level of detail
-                    param.location.x.value,
-                    param.location.y.value,
-                    unbox<GLsizei>(param.bitmapSize.width),
-                    unbox<GLsizei>(param.bitmapSize.height),
-                    GL_RGBA,          // source format
-                    GL_UNSIGNED_BYTE, // source type
-                    bitmapData);
-#endif
+    glPixelStorei(GL_UNPACK_ALIGNMENT, savedUnpackAlignment);
+    CHECKED_GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
 }
 
 void OpenGLRenderer::renderRectangle(int ix, int iy, Width width, Height height, RGBAColor color)
 {
     auto const x = static_cast<GLfloat>(ix);
     auto const y = static_cast<GLfloat>(iy);
-    auto const z = ZAxisDepths::BackgroundSGR;
     auto const r = unbox<GLfloat>(width);
     auto const s = unbox<GLfloat>(height);
     auto const [cr, cg, cb, ca] = atlas::normalize(color);
 
-    // clang-format off
-    GLfloat const vertices[6 * 7] = {
-        // first triangle
-        x,     y + s, z, cr, cg, cb, ca,
-        x,     y,     z, cr, cg, cb, ca,
-        x + r, y,     z, cr, cg, cb, ca,
-
-        // second triangle
-        x,     y + s, z, cr, cg, cb, ca,
-        x + r, y,     z, cr, cg, cb, ca,
-        x + r, y + s, z, cr, cg, cb, ca
-    };
-    // clang-format on
+    GLfloat const instance[RectInstanceSize] = { x, y, r, s, cr, cg, cb, ca };
 
-    crispy::copy(vertices, back_inserter(_rectBuffer));
+    crispy::copy(instance, back_inserter(_rectBuffer));
 }
 
 optional<vtrasterizer::AtlasTextureScreenshot> OpenGLRenderer::readAtlas()
 {
-    // NB: to get all atlas pages, call this from instance base id up to and including current
-    // instance id of the given allocator.
+    // NB: This only reads the first layer of the color (RGBA) texture atlas.
+    auto const& textureAtlas = _textureAtlases[atlas::formatIndex(atlas::Format::RGBA)];
     auto output = vtrasterizer::AtlasTextureScreenshot {};
-    output.atlasInstanceId = 0;
-    output.size = _textureAtlas.textureSize;
-    output.format = _textureAtlas.properties.format;
-    output.buffer.resize(_textureAtlas.textureSize.area() * element_count(_textureAtlas.properties.format));
+    output.atlasInstanceId = static_cast<int>(atlas::formatIndex(atlas::Format::RGBA));
+    output.size = textureAtlas.textureSize;
+    output.format = textureAtlas.properties.format;
+    output.buffer.resize(textureAtlas.textureSize.area() * element_count(textureAtlas.properties.format));
 
     // Reading texture data to host CPU (including for RGB textures) only works via framebuffers
     auto fbo = GLuint {};
     CHECKED_GL(glGenFramebuffers(1, &fbo));
     CHECKED_GL(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
-    CHECKED_GL(
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureAtlasId(), 0));
+    CHECKED_GL(glFramebufferTextureLayer(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureAtlasId(atlas::formatIndex(atlas::Format::RGBA)), 0, 0));
     CHECKED_GL(glReadPixels(0,
                             0,
                             unbox<GLsizei>(output.size.width),
@@ -793,6 +1048,70 @@ void OpenGLRenderer::scheduleScreenshot(ScreenshotCallback callback)
     _pendingScreenshotCallback = std::move(callback);
 }
 
+void OpenGLRenderer::beginScreenshotReadback(ScreenshotCallback callback)
+{
+    auto& readback = _screenshotReadback;
+    readback.size = renderBufferSize();
+    readback.callback = std::move(callback);
+    displayLog()("Capture screenshot ({}/{}).", readback.size, _renderTargetSize);
+
+    auto const byteCount = readback.size.area() * 4; // 4 because RGBA
+    if (!readback.buffer)
+        CHECKED_GL(glGenBuffers(1, &readback.buffer));
+    CHECKED_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer));
+    if (byteCount > readback.capacity)
+    {
+        readback.capacity = byteCount;
+        CHECKED_GL(glBufferData(
+            GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(readback.capacity), nullptr, GL_STREAM_READ));
+    }
+
+    // Reading into the bound pixel buffer only queues the copy, which the fence tells the completion of.
+    CHECKED_GL(glReadPixels(0,
+                            0,
+                            unbox<GLsizei>(readback.size.width),
+                            unbox<GLsizei>(readback.size.height),
+                            GL_RGBA,
+                            GL_UNSIGNED_BYTE,
+                            nullptr));
+    CHECKED_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool OpenGLRenderer::finishScreenshotReadback(bool wait)
+{
+    using namespace std::chrono;
+
+    auto& readback = _screenshotReadback;
+    auto const timeout = wait ? static_cast<GLuint64>(nanoseconds(seconds(1)).count()) : GLuint64 { 0 };
+    auto const status = glClientWaitSync(readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+    if (status == GL_TIMEOUT_EXPIRED)
+        return false;
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+
+    auto buffer = vector<uint8_t>(readback.size.area() * 4);
+    auto const* pixels = static_cast<uint8_t const*>(nullptr);
+    if (status != GL_WAIT_FAILED)
+    {
+        CHECKED_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer));
+        pixels = static_cast<uint8_t const*>(glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(buffer.size()), GL_MAP_READ_BIT));
+    }
+    if (pixels)
+    {
+        std::copy_n(pixels, buffer.size(), buffer.data());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+        errorLog()("Reading back the screenshot of size {} failed.", readback.size);
+    CHECKED_GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    auto const callback = std::exchange(readback.callback, {});
+    callback(buffer, readback.size);
+    return true;
+}
+
 pair<ImageSize, vector<uint8_t>> OpenGLRenderer::takeScreenshot()
 {
     ImageSize const imageSize = renderBufferSize();
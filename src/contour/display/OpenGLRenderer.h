@@ -2,6 +2,7 @@
 #pragma once
 
 #include <contour/display/Blur.h>
+#include <contour/display/DisplayRenderTarget.h>
 #include <contour/display/ShaderConfig.h>
 
 #include <vtbackend/Image.h>
@@ -26,6 +27,7 @@
 
 #include <QtQuick/QQuickWindow>
 
+#include <array>
 #include <chrono>
 #include <memory>
 #include <optional>
@@ -34,10 +36,7 @@
 namespace contour::display
 {
 
-class OpenGLRenderer final:
-    public vtrasterizer::RenderTarget,
-    public vtrasterizer::atlas::AtlasBackend,
-    public QOpenGLExtraFunctions
+class OpenGLRenderer final: public DisplayRenderTarget, public QOpenGLExtraFunctions
 {
     using ImageSize = vtbackend::ImageSize;
 
@@ -65,27 +64,29 @@ class OpenGLRenderer final:
 
     ~OpenGLRenderer() override;
 
-    void setWindow(QQuickWindow* window) { _window = window; }
+    void setWindow(QQuickWindow* window) override { _window = window; }
 
     // AtlasBackend implementation
-    [[nodiscard]] ImageSize atlasSize() const noexcept override;
     void configureAtlas(ConfigureAtlas atlas) override;
     void uploadTile(UploadTile tile) override;
     void renderTile(RenderTile tile) override;
 
     // RenderTarget implementation
     void setRenderSize(vtbackend::ImageSize targetSurfaceSize) override;
-    void setTranslation(float x, float y, float z) noexcept;
-    void setViewSize(vtbackend::ImageSize size) noexcept { _viewSize = size; }
-    void setModelMatrix(QMatrix4x4 matrix) noexcept;
+    void setTranslation(float x, float y, float z) noexcept override;
+    void setViewSize(vtbackend::ImageSize size) noexcept override { _viewSize = size; }
+    void setModelMatrix(QMatrix4x4 matrix) noexcept override;
     void setMargin(vtrasterizer::PageMargin margin) noexcept override;
     std::optional<AtlasTextureScreenshot> readAtlas() override;
     AtlasBackend& textureScheduler() override;
     void scheduleScreenshot(ScreenshotCallback callback) override;
     void renderRectangle(int x, int y, Width, Height, RGBAColor color) override;
+    void retainContents() override;
+    [[nodiscard]] bool replayContents() override;
+    void setDamage(vtrasterizer::FrameDamage const& damage) override;
     void execute(std::chrono::steady_clock::time_point now) override;
 
-    std::pair<vtbackend::ImageSize, std::vector<uint8_t>> takeScreenshot();
+    std::pair<vtbackend::ImageSize, std::vector<uint8_t>> takeScreenshot() override;
 
     void clearCache() override;
 
@@ -99,18 +100,31 @@ class OpenGLRenderer final:
         return uptimeSecs;
     }
 
-    [[nodiscard]] constexpr bool initialized() const noexcept { return _initialized; }
+    [[nodiscard]] bool initialized() const noexcept override { return _initialized; }
 
   public slots:
-    void initialize();
+    void initialize() override;
 
   private:
+    // Number of instance buffers per instanced draw call that are cycled through frame by frame,
+    // so that filling one does not need to wait for the GPU to finish drawing from the others.
+    static constexpr size_t InstanceBufferCount = 3;
+
+    struct InstancedDraw
+    {
+        std::array<GLuint, InstanceBufferCount> vertexArrays {};
+        std::array<GLuint, InstanceBufferCount> buffers {};
+        std::array<size_t, InstanceBufferCount> capacities {}; // allocated size of each buffer in bytes
+        size_t current = 0;
+    };
+
     // private helper methods
     //
     void logInfo();
     void initializeBackgroundRendering();
     void initializeTextureRendering();
     void initializeRectRendering();
+    void initializeCompositing();
     int maxTextureDepth();
     int maxTextureSize();
     int maxTextureUnits();
@@ -123,9 +137,37 @@ class OpenGLRenderer final:
 
     void executeRenderTextures();
     void executeConfigureAtlas(ConfigureAtlas const& param);
-    void executeUploadTile(UploadTile const& param);
+    void executeUploadTiles();
     void executeRenderTile(RenderTile const& param);
 
+    /// Uploads the given instance records into the next instance buffer of @p draw
+    /// and draws a quad for each of them, within each damaged area if only those are repainted.
+    void drawInstances(InstancedDraw& draw, std::vector<GLfloat> const& instances, size_t instanceSize);
+
+    // Framebuffer and viewport that were bound before rendering into the offscreen framebuffer.
+    struct RenderPassTarget
+    {
+        GLint framebuffer = 0;
+        std::array<GLint, 4> viewport {};
+    };
+
+    /// Directs rendering into the offscreen framebuffer and clears what is to be repainted of it.
+    ///
+    /// @returns what was bound before, which the offscreen contents are to be composed onto.
+    RenderPassTarget beginOffscreenPass(QMatrix4x4 const& mvp);
+
+    /// Composes the offscreen framebuffer onto the given target, binding it again.
+    void composeOffscreenPass(RenderPassTarget const& target);
+
+    /// Starts reading the composed frame back into the screenshot pixel buffer, without waiting for it.
+    void beginScreenshotReadback(ScreenshotCallback callback);
+
+    /// Hands the screenshot being read back to its callback, once the GPU has written it.
+    ///
+    /// @param wait whether to wait for the GPU, rather than to return if it has not finished yet.
+    /// @returns false if the readback is still in flight.
+    bool finishScreenshotReadback(bool wait);
+
     //? void renderRectangle(int _x, int _y, int width, int height, QVector4D const& color);
 
     // -------------------------------------------------------------------------------------------
@@ -135,26 +177,21 @@ class OpenGLRenderer final:
     // {{{ scheduling data
     struct RenderBatch
     {
-        std::vector<vtrasterizer::atlas::RenderTile> renderTiles;
-        std::vector<GLfloat> buffer;
+        std::vector<GLfloat> instances; // one record of TileInstanceSize floats per tile
         uint32_t userdata = 0;
 
-        void clear()
-        {
-            renderTiles.clear();
-            buffer.clear();
-        }
+        void clear() { instances.clear(); }
     };
 
     struct Scheduler
     {
-        std::optional<vtrasterizer::atlas::ConfigureAtlas> configureAtlas = std::nullopt;
+        std::vector<vtrasterizer::atlas::ConfigureAtlas> configureAtlases {};
         std::vector<vtrasterizer::atlas::UploadTile> uploadTiles {};
         RenderBatch renderBatch {};
 
         void clear()
         {
-            configureAtlas.reset();
+            configureAtlases.clear();
             uploadTiles.clear();
             renderBatch.clear();
         }
@@ -176,28 +213,37 @@ class OpenGLRenderer final:
 
     std::unique_ptr<QOpenGLShaderProgram> _textShader;
     int _textProjectionLocation = -1;
-    int _textTextureAtlasLocation = -1;
+    int _textMonochromeAtlasLocation = -1;
+    int _textLcdAtlasLocation = -1;
+    int _textColorAtlasLocation = -1;
+    int _textImageAtlasLocation = -1;
     int _textTimeLocation = -1;
 
     // private data members for rendering textures
     //
-    GLuint _textVAO {}; // Vertex Array Object, covering all buffer objects
-    GLuint _textVBO {}; // Buffer containing the vertex coordinates
-    // TODO: GLuint ebo_{};
+    InstancedDraw _textInstances;
 
-    // index equals AtlasID
+    // Texture atlases, indexed by their vtrasterizer::atlas::AtlasProperties::atlasIndex.
+    // The atlas index is also the texture unit it is bound to when rendering.
     struct AtlasAttributes
     {
-        QOpenGLTexture gpuTexture { QOpenGLTexture::Target::Target2D };
-        ImageSize textureSize {};
+        QOpenGLTexture gpuTexture { QOpenGLTexture::Target::Target2DArray };
+        ImageSize textureSize {}; // size of each layer
+        uint32_t layerCount = 1;
         vtrasterizer::atlas::AtlasProperties properties {};
     };
-    AtlasAttributes _textureAtlas {};
+    std::array<AtlasAttributes, vtrasterizer::atlas::AtlasCount> _textureAtlases {};
+
+    // Pixel buffer the tiles of a frame are staged in, see executeUploadTiles().
+    GLuint _uploadBuffer = 0;
+    size_t _uploadBufferCapacity = 0; // in bytes
+    std::vector<size_t> _uploadOffsets; // of each tile's bitmap in the buffer
 
-    [[nodiscard]] GLuint textureAtlasId() const noexcept
+    [[nodiscard]] GLuint textureAtlasId(size_t atlasIndex) const noexcept
     {
-        assert(_textureAtlas.gpuTexture.textureId() != 0);
-        return _textureAtlas.gpuTexture.textureId();
+        auto const& textureAtlas = _textureAtlases.at(atlasIndex);
+        assert(textureAtlas.gpuTexture.textureId() != 0);
+        return textureAtlas.gpuTexture.textureId();
     }
 
     // private data members for rendering filled rectangles
@@ -205,15 +251,61 @@ class OpenGLRenderer final:
     ShaderConfig _textShaderConfig;
     ShaderConfig _rectShaderConfig;
 
-    std::vector<GLfloat> _rectBuffer;
+    std::vector<GLfloat> _rectBuffer; // one record of RectInstanceSize floats per rectangle
     std::unique_ptr<QOpenGLShaderProgram> _rectShader;
     int _rectProjectionLocation = -1;
     int _rectTimeLocation = -1;
-    GLuint _rectVAO {};
-    GLuint _rectVBO {};
+    InstancedDraw _rectInstances;
+
+    // Instance records of the most recently retained frame contents, see retainContents().
+    struct RetainedContents
+    {
+        struct Mark
+        {
+            size_t rects = 0; // number of floats in _rectBuffer
+            size_t tiles = 0; // number of floats in the render batch
+        };
+
+        std::vector<GLfloat> rects;
+        std::vector<GLfloat> tiles;
+        bool valid = false;          // whether the above still apply
+        bool replay = false;         // whether they are rendered again in the current frame
+        std::optional<Mark> mark {}; // where the current frame's contents end, if they are to be retained
+    };
+    RetainedContents _retainedContents;
+
+    // Framebuffer all frames are rendered into, in order to only repaint their damage, see setDamage().
+    // Its colors are premultiplied by alpha, as they are composed onto the window's framebuffer.
+    struct Offscreen
+    {
+        GLuint framebuffer = 0;
+        GLuint texture = 0;
+        ImageSize size {};
+        bool valid = false; // whether it holds the pixels of the previously executed frame
+    };
+    Offscreen _offscreen;
+    vtrasterizer::FrameDamage _damage;
+    bool _repaintDamageOnly = false;                // whether the current pass only repaints _damageRects
+    std::vector<std::array<GLint, 4>> _damageRects; // x, y, width, height in window coordinates
+
+    std::unique_ptr<QOpenGLShaderProgram> _compositeShader;
+    int _compositeTextureLocation = -1;
+    GLuint _compositeVertexArray = 0; // draws without any vertex attributes
 
     std::optional<ScreenshotCallback> _pendingScreenshotCallback;
 
+    // Screenshot being read back into a pixel buffer, which is mapped once its fence is signaled,
+    // so that taking a screenshot never stalls the frame it is taken of.
+    struct ScreenshotReadback
+    {
+        GLuint buffer = 0;
+        size_t capacity = 0; // in bytes
+        GLsync fence = nullptr;
+        ImageSize size {};
+        ScreenshotCallback callback {};
+    };
+    ScreenshotReadback _screenshotReadback;
+
     QQuickWindow* _window = nullptr;
 
     // render state cache
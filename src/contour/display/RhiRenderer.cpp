@@ -0,0 +1,646 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <contour/display/RhiRenderer.h>
+#include <contour/display/ShaderConfig.h>
+#include <contour/helper.h>
+
+#include <vtbackend/primitives.h>
+
+#include <vtrasterizer/TextureAtlas.h>
+
+#include <crispy/algorithm.h>
+#include <crispy/assert.h>
+#include <crispy/tracing.h>
+
+#include <rhi/qshaderbaker.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+using std::nullopt;
+using std::optional;
+using std::pair;
+using std::unique_ptr;
+using std::vector;
+
+using vtbackend::Height;
+using vtbackend::ImageSize;
+using vtbackend::RGBAColor;
+using vtbackend::Width;
+
+namespace chrono = std::chrono;
+namespace atlas = vtrasterizer::atlas;
+
+namespace contour::display
+{
+
+namespace
+{
+    // Number of floats per instance record of a texture tile: target rectangle (XYWH),
+    // normalized atlas rectangle (XYWH), atlas layer and userdata (IU), color (RGBA).
+    constexpr size_t TileInstanceSize = 4 + 4 + 2 + 4;
+
+    // Number of floats per instance record of a filled rectangle:
+    // target rectangle (XYWH), color (RGBA).
+    constexpr size_t RectInstanceSize = 4 + 4;
+
+    // Number of floats of the uniform block shared by all shaders, laid out as std140:
+    // projection matrix, pixel_x, time, and padding up to the next vec4.
+    constexpr size_t UniformsSize = 16 + 4;
+
+    // Initial size in bytes of each instance buffer, which grows along with the frames drawn.
+    constexpr quint32 InitialInstanceBufferSize = 64 * 1024;
+
+    QMatrix4x4 ortho(float left, float right, float bottom, float top)
+    {
+        constexpr float NearPlane = -1.0f;
+        constexpr float FarPlane = 1.0f;
+
+        QMatrix4x4 mat;
+        mat.ortho(left, right, bottom, top, NearPlane, FarPlane);
+        return mat;
+    }
+
+    // RGB has no texture format of its own, such tiles are expanded to RGBA when uploaded.
+    QRhiTexture::Format rhiAtlasFormat(atlas::Format format)
+    {
+        switch (format)
+        {
+            case atlas::Format::Red: return QRhiTexture::R8;
+            case atlas::Format::RGB: return QRhiTexture::RGBA8;
+            case atlas::Format::RGBA: return QRhiTexture::RGBA8;
+        }
+        Guarantee(false);
+        crispy::unreachable();
+    }
+
+    QByteArray rhiPixels(atlas::UploadTile const& tile)
+    {
+        auto const* const data = reinterpret_cast<char const*>(tile.bitmap.data());
+        if (tile.bitmapFormat != atlas::Format::RGB)
+            return QByteArray(data, static_cast<qsizetype>(tile.bitmap.size()));
+
+        auto const pixelCount = tile.bitmap.size() / 3;
+        auto pixels = QByteArray(static_cast<qsizetype>(pixelCount * 4), char(0xFF));
+        for (size_t i = 0; i < pixelCount; ++i)
+            std::copy_n(data + (i * 3), 3, pixels.data() + (i * 4));
+        return pixels;
+    }
+
+    // Shader language and version the shaders are translated into for the given graphics API.
+    QShaderBaker::GeneratedShader generatedShader(QRhi::Implementation backend)
+    {
+        switch (backend)
+        {
+            case QRhi::D3D11:
+            case QRhi::D3D12: return { QShader::HlslShader, QShaderVersion(50) };
+            case QRhi::Metal: return { QShader::MslShader, QShaderVersion(12) };
+            case QRhi::OpenGLES2: return { QShader::GlslShader, QShaderVersion(330) };
+            case QRhi::Null:
+            case QRhi::Vulkan: break;
+        }
+        return { QShader::SpirvShader, QShaderVersion(100) };
+    }
+
+    QShader bakeShader(ShaderSource const& source, QShader::Stage stage, QRhi::Implementation backend)
+    {
+        auto baker = QShaderBaker {};
+        baker.setGeneratedShaders({ generatedShader(backend) });
+        baker.setGeneratedShaderVariants({ QShader::StandardShader });
+        baker.setSourceString(source.contents.toUtf8(), stage, source.location);
+        auto shader = baker.bake();
+        if (!shader.isValid())
+            errorLog()("Compiling shader {} failed. {}",
+                       source.location.toStdString(),
+                       baker.errorMessage().toStdString());
+        return shader;
+    }
+
+    // Returns first non-zero argument.
+    template <typename T, typename... More>
+    constexpr T firstNonZero(T a, More... more) noexcept
+    {
+        if constexpr (sizeof...(More) == 0)
+            return a;
+        else
+        {
+            if (a != T(0))
+                return a;
+            else
+                return firstNonZero<More...>(std::forward<More>(more)...);
+        }
+    }
+} // namespace
+
+RhiRenderer::RhiRenderer(ShaderConfig textShaderConfig,
+                         ShaderConfig rectShaderConfig,
+                         vtbackend::ImageSize viewSize,
+                         vtbackend::ImageSize targetSurfaceSize,
+                         vtrasterizer::PageMargin margin):
+    _startTime { chrono::steady_clock::now() },
+    _viewSize { viewSize },
+    _margin { margin },
+    _textShaderConfig { std::move(textShaderConfig) },
+    _rectShaderConfig { std::move(rectShaderConfig) }
+{
+    displayLog()("RhiRenderer: Constructing with render size {}.", targetSurfaceSize);
+    setRenderSize(targetSurfaceSize);
+}
+
+RhiRenderer::~RhiRenderer()
+{
+    displayLog()("~RhiRenderer");
+}
+
+void RhiRenderer::setRenderSize(vtbackend::ImageSize targetSurfaceSize)
+{
+    if (_renderTargetSize == targetSurfaceSize)
+        return;
+
+    _renderTargetSize = targetSurfaceSize;
+    _retainedContents.valid = false;
+    _projectionMatrix = ortho(/* left */ 0.0f,
+                              /* right */ unbox<float>(_renderTargetSize.width),
+                              /* bottom */ unbox<float>(_renderTargetSize.height),
+                              /* top */ 0.0f);
+
+    displayLog()("Setting render target size to {}.", _renderTargetSize);
+}
+
+void RhiRenderer::setTranslation(float x, float y, float z) noexcept
+{
+    _viewMatrix = QMatrix4x4 {};
+    _viewMatrix.translate(x, y, z);
+}
+
+void RhiRenderer::setMargin(vtrasterizer::PageMargin margin) noexcept
+{
+    _margin = margin;
+    _retainedContents.valid = false;
+}
+
+atlas::AtlasBackend& RhiRenderer::textureScheduler()
+{
+    return *this;
+}
+
+QRhiCommandBuffer* RhiRenderer::commandBuffer() const
+{
+    Require(_window->swapChain() != nullptr);
+    return _window->swapChain()->currentFrameCommandBuffer();
+}
+
+QRhiRenderTarget* RhiRenderer::renderTarget() const
+{
+    Require(_window->swapChain() != nullptr);
+    return _window->swapChain()->currentFrameRenderTarget();
+}
+
+void RhiRenderer::initialize()
+{
+    if (_initialized)
+        return;
+
+    Require(_window != nullptr);
+    _rhi = _window->rhi();
+    Require(_rhi != nullptr);
+
+    _initialized = true;
+
+    displayLog()("[FYI] RHI backend         : {}", _rhi->backendName());
+    displayLog()("[FYI] RHI device          : {}", _rhi->driverInfo().deviceName.toStdString());
+    displayLog()("[FYI] Widget size         : {} ({})", _renderTargetSize, _viewSize);
+
+    _sampler.reset(_rhi->newSampler(QRhiSampler::Nearest,
+                                    QRhiSampler::Nearest,
+                                    QRhiSampler::None,
+                                    QRhiSampler::ClampToEdge,
+                                    QRhiSampler::ClampToEdge));
+    _sampler->create();
+
+    // Placeholders, until the atlases are configured.
+    for (auto& textureAtlas: _textureAtlases)
+    {
+        textureAtlas.gpuTexture.reset(_rhi->newTextureArray(QRhiTexture::RGBA8, 1, QSize(1, 1)));
+        textureAtlas.gpuTexture->create();
+    }
+
+    for (auto* draw: { &_rectDraw, &_textDraw })
+    {
+        draw->uniforms.reset(_rhi->newBuffer(
+            QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, quint32(UniformsSize * sizeof(float))));
+        draw->uniforms->create();
+        draw->instances.reset(
+            _rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, InitialInstanceBufferSize));
+        draw->instances->create();
+    }
+
+    _rectDraw.bindings.reset(_rhi->newShaderResourceBindings());
+    _rectDraw.bindings->setBindings({ QRhiShaderResourceBinding::uniformBuffer(
+        0, QRhiShaderResourceBinding::VertexStage, _rectDraw.uniforms.get()) });
+    _rectDraw.bindings->create();
+    createTextBindings();
+
+    auto rectLayout = QRhiVertexInputLayout {};
+    rectLayout.setBindings({ { quint32(RectInstanceSize * sizeof(float)),
+                               QRhiVertexInputBinding::PerInstance } });
+    rectLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float4, 0 },                 // target rectangle
+        { 0, 1, QRhiVertexInputAttribute::Float4, 4 * sizeof(float) }, // color
+    });
+    _rectDraw.pipeline = createPipeline(_rectShaderConfig, rectLayout, *_rectDraw.bindings);
+
+    auto textLayout = QRhiVertexInputLayout {};
+    textLayout.setBindings({ { quint32(TileInstanceSize * sizeof(float)),
+                               QRhiVertexInputBinding::PerInstance } });
+    textLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float4, 0 },                  // target rectangle
+        { 0, 1, QRhiVertexInputAttribute::Float4, 4 * sizeof(float) },  // normalized atlas rectangle
+        { 0, 2, QRhiVertexInputAttribute::Float2, 8 * sizeof(float) },  // atlas layer and selector
+        { 0, 3, QRhiVertexInputAttribute::Float4, 10 * sizeof(float) }, // color
+    });
+    _textDraw.pipeline = createPipeline(_textShaderConfig, textLayout, *_textDraw.bindings);
+}
+
+unique_ptr<QRhiGraphicsPipeline> RhiRenderer::createPipeline(ShaderConfig const& shaderConfig,
+                                                             QRhiVertexInputLayout const& inputLayout,
+                                                             QRhiShaderResourceBindings& bindings)
+{
+    auto const vertexShader = bakeShader(shaderConfig.vertexShader, QShader::VertexStage, _rhi->backend());
+    auto const fragmentShader =
+        bakeShader(shaderConfig.fragmentShader, QShader::FragmentStage, _rhi->backend());
+    if (!vertexShader.isValid() || !fragmentShader.isValid())
+        return {};
+
+    // Same blending as the OpenGLRenderer, drawing text and images on top of the background.
+    auto blend = QRhiGraphicsPipeline::TargetBlend {};
+    blend.enable = true;
+    blend.srcColor = QRhiGraphicsPipeline::SrcAlpha;
+    blend.dstColor = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+    blend.srcAlpha = QRhiGraphicsPipeline::One;
+    blend.dstAlpha = QRhiGraphicsPipeline::One;
+
+    auto pipeline = unique_ptr<QRhiGraphicsPipeline>(_rhi->newGraphicsPipeline());
+    pipeline->setTopology(QRhiGraphicsPipeline::TriangleStrip);
+    pipeline->setTargetBlends({ blend });
+    pipeline->setSampleCount(renderTarget()->sampleCount());
+    pipeline->setShaderStages({ { QRhiShaderStage::Vertex, vertexShader },
+                                { QRhiShaderStage::Fragment, fragmentShader } });
+    pipeline->setVertexInputLayout(inputLayout);
+    pipeline->setShaderResourceBindings(&bindings);
+    pipeline->setRenderPassDescriptor(renderTarget()->renderPassDescriptor());
+    if (!pipeline->create())
+    {
+        errorLog()("Creating the graphics pipeline for shader {} failed.",
+                   shaderConfig.vertexShader.location.toStdString());
+        return {};
+    }
+    return pipeline;
+}
+
+void RhiRenderer::createTextBindings()
+{
+    // Each atlas is bound to the binding following the uniform block, in the order of its index.
+    auto bindings = QList<QRhiShaderResourceBinding> { QRhiShaderResourceBinding::uniformBuffer(
+        0,
+        QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
+        _textDraw.uniforms.get()) };
+    for (size_t atlasIndex = 0; atlasIndex < atlas::AtlasCount; ++atlasIndex)
+        bindings.append(
+            QRhiShaderResourceBinding::sampledTexture(static_cast<int>(1 + atlasIndex),
+                                                      QRhiShaderResourceBinding::FragmentStage,
+                                                      _textureAtlases[atlasIndex].gpuTexture.get(),
+                                                      _sampler.get()));
+
+    _textDraw.bindings.reset(_rhi->newShaderResourceBindings());
+    _textDraw.bindings->setBindings(bindings.cbegin(), bindings.cend());
+    _textDraw.bindings->create();
+}
+
+void RhiRenderer::clearCache()
+{
+    _retainedContents.valid = false;
+}
+
+// {{{ AtlasBackend impl
+void RhiRenderer::configureAtlas(atlas::ConfigureAtlas atlas)
+{
+    _configureAtlases.emplace_back(atlas);
+    _retainedContents.valid = false;
+    auto& textureAtlas = _textureAtlases.at(atlas.properties.atlasIndex);
+    textureAtlas.textureSize = atlas.size;
+    textureAtlas.layerCount = atlas.layerCount;
+    textureAtlas.properties = atlas.properties;
+
+    displayLog()("configureAtlas: {} x {} layers {}", atlas.size, atlas.layerCount, atlas.properties.format);
+}
+
+void RhiRenderer::uploadTile(atlas::UploadTile tile)
+{
+    _uploadTiles.emplace_back(std::move(tile));
+}
+
+void RhiRenderer::renderTile(atlas::RenderTile tile)
+{
+    // target position and size of the tile on the render surface
+    auto const x = static_cast<float>(tile.x.value);
+    auto const y = static_cast<float>(tile.y.value);
+    auto const r = unbox<float>(firstNonZero(tile.targetSize.width, tile.bitmapSize.width));
+    auto const s = unbox<float>(firstNonZero(tile.targetSize.height, tile.bitmapSize.height));
+
+    // normalized TexCoords
+    auto const& [nx, ny, nw, nh] = tile.normalizedLocation;
+
+    // texture array layer and fragment shader selector
+    auto const i = static_cast<float>(tile.tileLocation.layer.value);
+    auto const u = static_cast<float>(tile.fragmentShaderSelector);
+
+    auto const& [cr, cg, cb, ca] = tile.color;
+
+    // clang-format off
+    float const instance[TileInstanceSize] = {
+    // <X  Y  W  H>  <X   Y   W   H>   <I  U>  <R   G   B   A>
+        x, y, r, s,   nx, ny, nw, nh,   i, u,   cr, cg, cb, ca,
+    };
+    // clang-format on
+
+    crispy::copy(instance, back_inserter(_tileBuffer));
+}
+// }}}
+
+// {{{ executor impl
+void RhiRenderer::execute(std::chrono::steady_clock::time_point now)
+{
+    Require(_initialized);
+    CRISPY_TRACE_ZONE("RhiRenderer::execute", "render");
+
+    auto* const updates = _rhi->nextResourceUpdateBatch();
+
+    for (auto const& params: _configureAtlases)
+        executeConfigureAtlas(params, *updates);
+
+    if (!_uploadTiles.empty())
+        executeUploadTiles(*updates);
+
+    auto const mvp = _rhi->clipSpaceCorrMatrix() * _projectionMatrix * _viewMatrix * _modelMatrix;
+    auto uniforms = std::array<float, UniformsSize> {};
+    std::copy_n(mvp.constData(), 16, uniforms.begin());
+    uniforms[16] = _lcdPixelWidth;
+    uniforms[17] = chrono::duration<float>(now - _startTime).count();
+    for (auto* draw: { &_rectDraw, &_textDraw })
+        updates->updateDynamicBuffer(draw->uniforms.get(), 0, sizeof(uniforms), uniforms.data());
+
+    auto& retained = _retainedContents;
+    prepareDraw(_rectDraw, retained.rects, _rectBuffer, RectInstanceSize, *updates);
+    prepareDraw(_textDraw, retained.tiles, _tileBuffer, TileInstanceSize, *updates);
+    if (retained.mark)
+    {
+        // Taking over the buffers, rather than copying them, as they are about to be cleared anyway.
+        std::swap(retained.rects, _rectBuffer);
+        retained.rects.resize(retained.mark->rects);
+        std::swap(retained.tiles, _tileBuffer);
+        retained.tiles.resize(retained.mark->tiles);
+        retained.valid = true;
+        retained.mark.reset();
+    }
+    retained.replay = false;
+
+    _configureAtlases.clear();
+    _uploadTiles.clear();
+    _rectBuffer.clear();
+    _tileBuffer.clear();
+
+    commandBuffer()->resourceUpdate(updates);
+}
+
+void RhiRenderer::prepareDraw(InstancedDraw& draw,
+                              vector<float> const& retained,
+                              vector<float>& scheduled,
+                              size_t instanceSize,
+                              QRhiResourceUpdateBatch& updates)
+{
+    // Replayed and newly scheduled instances are drawn together, with a single draw call.
+    draw.records.clear();
+    if (_retainedContents.replay)
+        draw.records.insert(draw.records.end(), retained.begin(), retained.end());
+    draw.records.insert(draw.records.end(), scheduled.begin(), scheduled.end());
+    draw.instanceCount = static_cast<uint32_t>(draw.records.size() / instanceSize);
+
+    auto const byteCount = static_cast<quint32>(draw.records.size() * sizeof(float));
+    if (!byteCount)
+        return;
+
+    // Only (re-)allocate buffer storage when it grows. The RHI releases the previous one
+    // once no frame in flight refers to it anymore.
+    if (byteCount > draw.instances->size())
+    {
+        draw.instances->setSize(std::max(byteCount, 2 * draw.instances->size()));
+        draw.instances->create();
+    }
+    updates.updateDynamicBuffer(draw.instances.get(), 0, byteCount, draw.records.data());
+}
+
+void RhiRenderer::recordRenderPass()
+{
+    if (!_initialized)
+        return;
+
+    CRISPY_TRACE_ZONE("RhiRenderer::recordRenderPass", "render");
+    recordDraw(_rectDraw);
+    recordDraw(_textDraw);
+}
+
+void RhiRenderer::recordDraw(InstancedDraw const& draw)
+{
+    if (!draw.pipeline || !draw.instanceCount)
+        return;
+
+    auto* const cb = commandBuffer();
+    auto const outputSize = renderTarget()->pixelSize();
+    cb->setGraphicsPipeline(draw.pipeline.get());
+    cb->setViewport(QRhiViewport(
+        0.0f, 0.0f, static_cast<float>(outputSize.width()), static_cast<float>(outputSize.height())));
+    cb->setShaderResources(draw.bindings.get());
+    auto const input = QRhiCommandBuffer::VertexInput { draw.instances.get(), 0 };
+    cb->setVertexInput(0, 1, &input);
+
+    // One quad per instance, drawn as triangle strip of 4 vertices.
+    cb->draw(4, draw.instanceCount);
+}
+
+void RhiRenderer::finishFrame()
+{
+    if (!_pendingScreenshotCallback)
+        return;
+
+    auto result = takeScreenshot();
+    _pendingScreenshotCallback.value()(result.second, result.first);
+    _pendingScreenshotCallback.reset();
+}
+
+void RhiRenderer::executeConfigureAtlas(atlas::ConfigureAtlas const& param, QRhiResourceUpdateBatch& updates)
+{
+    auto& textureAtlas = _textureAtlases.at(param.properties.atlasIndex);
+    auto const pixelSize = QSize(unbox<int>(param.size.width), unbox<int>(param.size.height));
+    auto const format = rhiAtlasFormat(param.properties.format);
+
+    // The previous texture is released by the RHI once no frame in flight samples from it anymore.
+    textureAtlas.gpuTexture.reset(_rhi->newTextureArray(
+        format, static_cast<int>(param.layerCount), pixelSize, 1, QRhiTexture::UsedAsTransferSource));
+    if (!textureAtlas.gpuTexture->create())
+        errorLog()("Creating texture atlas of {} x {} layers failed.", param.size, param.layerCount);
+
+    auto const elementCount = format == QRhiTexture::R8 ? 1 : 4;
+    auto const stubData = QByteArray(static_cast<qsizetype>(param.size.area() * elementCount), '\0');
+    auto entries = vector<QRhiTextureUploadEntry> {};
+    for (auto layer = 0; layer < static_cast<int>(param.layerCount); ++layer)
+        entries.emplace_back(layer, 0, QRhiTextureSubresourceUploadDescription(stubData));
+    auto description = QRhiTextureUploadDescription {};
+    description.setEntries(entries.cbegin(), entries.cend());
+    updates.uploadTexture(textureAtlas.gpuTexture.get(), description);
+
+    if (param.properties.format == atlas::Format::RGB)
+        // Used for LCD subpixel filtering.
+        _lcdPixelWidth = 1.0f / unbox<float>(param.size.width);
+
+    createTextBindings();
+
+    displayLog()(
+        "RHI configure atlas: {} x {} layers {}", param.size, param.layerCount, param.properties.format);
+}
+
+void RhiRenderer::executeUploadTiles(QRhiResourceUpdateBatch& updates)
+{
+    // All tiles of an atlas are uploaded at once, which the RHI stages in a single buffer per frame.
+    for (size_t atlasIndex = 0; atlasIndex < atlas::AtlasCount; ++atlasIndex)
+    {
+        auto entries = vector<QRhiTextureUploadEntry> {};
+        for (auto const& tile: _uploadTiles)
+        {
+            if (tile.atlasIndex != atlasIndex)
+                continue;
+
+            auto subresource = QRhiTextureSubresourceUploadDescription(rhiPixels(tile));
+            subresource.setDestinationTopLeft(QPoint(tile.location.x.value, tile.location.y.value));
+            subresource.setSourceSize(
+                QSize(unbox<int>(tile.bitmapSize.width), unbox<int>(tile.bitmapSize.height)));
+            entries.emplace_back(static_cast<int>(tile.location.layer.value), 0, subresource);
+        }
+        if (entries.empty())
+            continue;
+
+        auto description = QRhiTextureUploadDescription {};
+        description.setEntries(entries.cbegin(), entries.cend());
+        updates.uploadTexture(_textureAtlases[atlasIndex].gpuTexture.get(), description);
+    }
+}
+
+void RhiRenderer::renderRectangle(int ix, int iy, Width width, Height height, RGBAColor color)
+{
+    auto const x = static_cast<float>(ix);
+    auto const y = static_cast<float>(iy);
+    auto const r = unbox<float>(width);
+    auto const s = unbox<float>(height);
+    auto const [cr, cg, cb, ca] = atlas::normalize(color);
+
+    float const instance[RectInstanceSize] = { x, y, r, s, cr, cg, cb, ca };
+
+    crispy::copy(instance, back_inserter(_rectBuffer));
+}
+
+void RhiRenderer::retainContents()
+{
+    _retainedContents.mark = RetainedContents::Mark {
+        .rects = _rectBuffer.size(),
+        .tiles = _tileBuffer.size(),
+    };
+}
+
+bool RhiRenderer::replayContents()
+{
+    if (!_retainedContents.valid)
+        return false;
+
+    _retainedContents.replay = true;
+    return true;
+}
+
+void RhiRenderer::setDamage(vtrasterizer::FrameDamage const& /*damage*/)
+{
+    // The window's render pass always redraws the whole window, so the damage cannot be made use of.
+}
+
+optional<vtrasterizer::AtlasTextureScreenshot> RhiRenderer::readAtlas()
+{
+    // NB: This only reads the first layer of the color (RGBA) texture atlas.
+    auto const atlasIndex = atlas::formatIndex(atlas::Format::RGBA);
+    auto const& textureAtlas = _textureAtlases[atlasIndex];
+
+    auto readback = QRhiReadbackResult {};
+    auto description = QRhiReadbackDescription(textureAtlas.gpuTexture.get());
+    description.setLayer(0);
+    auto* const updates = _rhi->nextResourceUpdateBatch();
+    updates->readBackTexture(description, &readback);
+    commandBuffer()->resourceUpdate(updates);
+    _rhi->finish(); // Completes the readback.
+    if (readback.data.isEmpty())
+        return nullopt;
+
+    auto output = vtrasterizer::AtlasTextureScreenshot {};
+    output.atlasInstanceId = static_cast<int>(atlasIndex);
+    output.size = textureAtlas.textureSize;
+    output.format = textureAtlas.properties.format;
+    output.buffer.assign(readback.data.begin(), readback.data.end());
+    return { std::move(output) };
+}
+
+void RhiRenderer::scheduleScreenshot(ScreenshotCallback callback)
+{
+    _pendingScreenshotCallback = std::move(callback);
+}
+
+pair<ImageSize, vector<uint8_t>> RhiRenderer::takeScreenshot()
+{
+    // Reads back the window's current back buffer, as rendered by the render pass that just ended.
+    auto readback = QRhiReadbackResult {};
+    auto* const updates = _rhi->nextResourceUpdateBatch();
+    updates->readBackTexture(QRhiReadbackDescription {}, &readback);
+    commandBuffer()->resourceUpdate(updates);
+    _rhi->finish(); // Completes the readback.
+
+    auto const imageSize = ImageSize { Width::cast_from(readback.pixelSize.width()),
+                                       Height::cast_from(readback.pixelSize.height()) };
+    displayLog()("Capture screenshot ({}/{}).", imageSize, _renderTargetSize);
+    if (readback.data.size() != static_cast<qsizetype>(imageSize.area() * 4))
+    {
+        errorLog()("Reading back the window's contents failed.");
+        return { ImageSize {}, {} };
+    }
+
+    // Screenshots are RGBA, with the bottom row first, just like OpenGL reads them.
+    auto const stride = unbox<size_t>(imageSize.width) * 4;
+    auto const rowCount = unbox<size_t>(imageSize.height);
+    auto buffer = vector<uint8_t>(readback.data.size());
+    for (size_t row = 0; row < rowCount; ++row)
+    {
+        auto const sourceRow = _rhi->isYUpInFramebuffer() ? row : rowCount - 1 - row;
+        std::copy_n(readback.data.constData() + (sourceRow * stride), stride, buffer.data() + (row * stride));
+    }
+    if (readback.format == QRhiTexture::BGRA8)
+        for (size_t i = 0; i < buffer.size(); i += 4)
+            std::swap(buffer[i], buffer[i + 2]);
+
+    return { imageSize, std::move(buffer) };
+}
+// }}}
+
+void RhiRenderer::inspect(std::ostream& output) const
+{
+    output << std::format("RHI backend: {}\n", _rhi ? _rhi->backendName() : "(uninitialized)");
+}
+
+} // namespace contour::display
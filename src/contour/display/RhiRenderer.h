@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <contour/display/DisplayRenderTarget.h>
+#include <contour/display/ShaderConfig.h>
+
+#include <vtbackend/primitives.h>
+
+#include <vtrasterizer/RenderTarget.h>
+#include <vtrasterizer/TextureAtlas.h>
+
+#include <QtGui/QMatrix4x4>
+#include <QtQuick/QQuickWindow>
+
+#include <rhi/qrhi.h>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace contour::display
+{
+
+/**
+ * Renders the terminal through Qt's RHI, onto the graphics API the scene graph uses, such as Vulkan.
+ *
+ * Executing a frame only prepares its resources: atlas textures, tile uploads, and instance buffers
+ * are updated ahead of the window's render pass, which the frame is then drawn into by
+ * recordRenderPass() with one instanced draw call for all rectangles and one for all tiles.
+ *
+ * Instance buffers are dynamic buffers, which the RHI keeps persistently mapped,
+ * one copy per frame in flight, so that filling one never waits for the GPU to draw from another.
+ * Texture atlases are texture arrays, just like those of the OpenGLRenderer.
+ *
+ * Unlike the OpenGLRenderer, damage is not taken into account, as the window's render pass
+ * always redraws the whole window.
+ */
+class RhiRenderer final: public DisplayRenderTarget
+{
+    using ImageSize = vtbackend::ImageSize;
+
+    using AtlasTextureScreenshot = vtrasterizer::AtlasTextureScreenshot;
+
+    using ConfigureAtlas = vtrasterizer::atlas::ConfigureAtlas;
+    using UploadTile = vtrasterizer::atlas::UploadTile;
+    using RenderTile = vtrasterizer::atlas::RenderTile;
+
+  public:
+    RhiRenderer(ShaderConfig textShaderConfig,
+                ShaderConfig rectShaderConfig,
+                vtbackend::ImageSize viewSize,
+                vtbackend::ImageSize targetSurfaceSize,
+                vtrasterizer::PageMargin margin);
+
+    ~RhiRenderer() override;
+
+    void setWindow(QQuickWindow* window) override { _window = window; }
+
+    // AtlasBackend implementation
+    void configureAtlas(ConfigureAtlas atlas) override;
+    void uploadTile(UploadTile tile) override;
+    void renderTile(RenderTile tile) override;
+
+    // RenderTarget implementation
+    void setRenderSize(vtbackend::ImageSize targetSurfaceSize) override;
+    void setMargin(vtrasterizer::PageMargin margin) noexcept override;
+    std::optional<AtlasTextureScreenshot> readAtlas() override;
+    AtlasBackend& textureScheduler() override;
+    void scheduleScreenshot(ScreenshotCallback callback) override;
+    void renderRectangle(int x, int y, Width, Height, RGBAColor color) override;
+    void retainContents() override;
+    [[nodiscard]] bool replayContents() override;
+    void setDamage(vtrasterizer::FrameDamage const& damage) override;
+    void execute(std::chrono::steady_clock::time_point now) override;
+    void clearCache() override;
+    void inspect(std::ostream& output) const override;
+
+    // DisplayRenderTarget implementation
+    void setTranslation(float x, float y, float z) noexcept override;
+    void setViewSize(vtbackend::ImageSize size) noexcept override { _viewSize = size; }
+    void setModelMatrix(QMatrix4x4 matrix) noexcept override { _modelMatrix = matrix; }
+    [[nodiscard]] bool initialized() const noexcept override { return _initialized; }
+    void initialize() override;
+    [[nodiscard]] bool recordsRenderPass() const noexcept override { return true; }
+    void recordRenderPass() override;
+    void finishFrame() override;
+    std::pair<vtbackend::ImageSize, std::vector<uint8_t>> takeScreenshot() override;
+
+  private:
+    // One instanced draw call of a frame, along with the buffer its instance records are uploaded to.
+    struct InstancedDraw
+    {
+        std::unique_ptr<QRhiGraphicsPipeline> pipeline;
+        std::unique_ptr<QRhiShaderResourceBindings> bindings;
+        std::unique_ptr<QRhiBuffer> uniforms;
+        std::unique_ptr<QRhiBuffer> instances;
+        std::vector<float> records; // of the current frame, including any replayed ones
+        uint32_t instanceCount = 0; // number of instances drawn in the current frame
+    };
+
+    struct AtlasAttributes
+    {
+        std::unique_ptr<QRhiTexture> gpuTexture;
+        ImageSize textureSize {}; // size of each layer
+        uint32_t layerCount = 1;
+        vtrasterizer::atlas::AtlasProperties properties {};
+    };
+
+    [[nodiscard]] QRhiCommandBuffer* commandBuffer() const;
+    [[nodiscard]] QRhiRenderTarget* renderTarget() const;
+
+    std::unique_ptr<QRhiGraphicsPipeline> createPipeline(ShaderConfig const& shaderConfig,
+                                                         QRhiVertexInputLayout const& inputLayout,
+                                                         QRhiShaderResourceBindings& bindings);
+    void createTextBindings();
+    void executeConfigureAtlas(ConfigureAtlas const& param, QRhiResourceUpdateBatch& updates);
+    void executeUploadTiles(QRhiResourceUpdateBatch& updates);
+    void prepareDraw(InstancedDraw& draw,
+                     std::vector<float> const& retained,
+                     std::vector<float>& scheduled,
+                     size_t instanceSize,
+                     QRhiResourceUpdateBatch& updates);
+    void recordDraw(InstancedDraw const& draw);
+
+    struct RetainedContents
+    {
+        struct Mark
+        {
+            size_t rects = 0; // number of floats in _rectBuffer
+            size_t tiles = 0; // number of floats in _tileBuffer
+        };
+
+        std::vector<float> rects;
+        std::vector<float> tiles;
+        bool valid = false;          // whether the above still apply
+        bool replay = false;         // whether they are rendered again in the current frame
+        std::optional<Mark> mark {}; // where the current frame's contents end, if they are to be retained
+    };
+
+    bool _initialized = false;
+    std::chrono::steady_clock::time_point _startTime;
+    vtbackend::ImageSize _viewSize;
+    vtbackend::ImageSize _renderTargetSize;
+    QMatrix4x4 _projectionMatrix;
+    QMatrix4x4 _viewMatrix;
+    QMatrix4x4 _modelMatrix;
+    vtrasterizer::PageMargin _margin {};
+
+    ShaderConfig _textShaderConfig;
+    ShaderConfig _rectShaderConfig;
+
+    QQuickWindow* _window = nullptr;
+    QRhi* _rhi = nullptr;
+
+    std::vector<ConfigureAtlas> _configureAtlases;
+    std::vector<UploadTile> _uploadTiles;
+    std::vector<float> _rectBuffer; // one record of RectInstanceSize floats per rectangle
+    std::vector<float> _tileBuffer; // one record of TileInstanceSize floats per tile
+    RetainedContents _retainedContents;
+
+    std::array<AtlasAttributes, vtrasterizer::atlas::AtlasCount> _textureAtlases {};
+    std::unique_ptr<QRhiSampler> _sampler;
+    float _lcdPixelWidth = 0.0f; // 1.0 / width of the LCD atlas
+
+    InstancedDraw _rectDraw;
+    InstancedDraw _textDraw;
+
+    std::optional<ScreenshotCallback> _pendingScreenshotCallback;
+};
+
+} // namespace contour::display
@@ -62,18 +62,20 @@ QSurfaceFormat createSurfaceFormat()
     return format;
 }
 
-ShaderConfig builtinShaderConfig(ShaderClass shaderClass)
+namespace
 {
-    using namespace std::string_view_literals;
-    auto const makeConfig = [](ShaderClass shaderClass) -> ShaderConfig {
-        auto const makeSource = [](QString const& filename) -> ShaderSource {
+    ShaderConfig loadShaderConfig(ShaderClass shaderClass,
+                                  QString const& directory,
+                                  std::string const& version)
+    {
+        auto const makeSource = [&](QString const& filename) -> ShaderSource {
             QFile sharedDefinesFile(":/contour/vtrasterizer/shared_defines.h");
             sharedDefinesFile.open(QFile::ReadOnly);
             Require(sharedDefinesFile.isOpen());
             auto const sharedDefines = sharedDefinesFile.readAll().toStdString() + "\n#line 1\n";
-            auto const versionHeader = std::format("#version {}\n", useOpenGLES() ? "300 es" : "330");
+            auto const versionHeader = std::format("#version {}\n", version);
 
-            auto const shaderFilePath = ":/contour/display/shaders/" + filename;
+            auto const shaderFilePath = directory + filename;
 
             QFile file(shaderFilePath);
             file.open(QFile::ReadOnly);
@@ -87,8 +89,18 @@ ShaderConfig builtinShaderConfig(ShaderClass shaderClass)
         QString const basename = QString::fromStdString(to_string(shaderClass));
         return ShaderConfig { .vertexShader = makeSource(basename + ".vert"),
                               .fragmentShader = makeSource(basename + ".frag") };
-    };
-    return makeConfig(shaderClass);
+    }
+} // namespace
+
+ShaderConfig builtinShaderConfig(ShaderClass shaderClass)
+{
+    return loadShaderConfig(shaderClass, ":/contour/display/shaders/", useOpenGLES() ? "300 es" : "330");
+}
+
+ShaderConfig builtinRhiShaderConfig(ShaderClass shaderClass)
+{
+    // Vulkan flavored GLSL, which Qt's shader baker translates for the graphics API in use.
+    return loadShaderConfig(shaderClass, ":/contour/display/shaders/rhi/", "440");
 }
 
 std::unique_ptr<QOpenGLShaderProgram> createShader(ShaderConfig const& shaderConfig)
@@ -99,8 +111,10 @@ std::unique_ptr<QOpenGLShaderProgram> createShader(ShaderConfig const& shaderCon
         return { source.location.toStdString(), source.contents.toStdString() };
     };
 
+    // Cacheable shaders are linked from the program binary that Qt keeps on disk for the same sources,
+    // driver and version, if any, and only compiled when linking otherwise.
     auto [vertexLocation, vertexSource] = extractShaderSource(shaderConfig.vertexShader);
-    if (!shader->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexSource.c_str()))
+    if (!shader->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, vertexSource.c_str()))
     {
         errorLog()("Compiling vertex shader {} failed.", vertexLocation);
         errorLog()("Shader source: {}", vertexSource);
@@ -110,7 +124,7 @@ std::unique_ptr<QOpenGLShaderProgram> createShader(ShaderConfig const& shaderCon
     }
 
     auto [fragmentLocation, fragmentSource] = extractShaderSource(shaderConfig.fragmentShader);
-    if (!shader->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource.c_str()))
+    if (!shader->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource.c_str()))
     {
         errorLog()("Compiling fragment shader {} failed. {}", fragmentLocation, shader->log().toStdString());
         qDebug() << shader->log();
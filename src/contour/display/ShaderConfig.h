@@ -26,7 +26,8 @@ namespace contour::display
 enum class ShaderClass : uint8_t
 {
     Background,
-    Text
+    Text,
+    Composite,
 };
 
 struct ShaderSource
@@ -50,6 +51,7 @@ inline std::string to_string(ShaderClass shaderClass)
     {
         case ShaderClass::Background: return "background";
         case ShaderClass::Text: return "text";
+        case ShaderClass::Composite: return "composite";
     }
 
     crispy::unreachable();
@@ -57,6 +59,10 @@ inline std::string to_string(ShaderClass shaderClass)
 
 ShaderConfig builtinShaderConfig(ShaderClass shaderClass);
 
+/// @returns the sources of the given shader class for rendering through Qt's RHI (see RhiRenderer).
+/// The composite shader is not available, as RhiRenderer does not compose.
+ShaderConfig builtinRhiShaderConfig(ShaderClass shaderClass);
+
 std::unique_ptr<QOpenGLShaderProgram> createShader(ShaderConfig const& shaderConfig);
 
 } // namespace contour::display
@@ -2,8 +2,12 @@
 #include <contour/Actions.h>
 #include <contour/BlurBehind.h>
 #include <contour/ContourGuiApp.h>
+#include <contour/StartupTimeline.h>
 #include <contour/display/OpenGLRenderer.h>
 #include <contour/display/TerminalDisplay.h>
+#if defined(CONTOUR_RHI_RENDERER)
+    #include <contour/display/RhiRenderer.h>
+#endif
 #include <contour/helper.h>
 
 #include <vtbackend/Color.h>
@@ -23,6 +27,7 @@
 #include <QtCore/QProcess>
 #include <QtCore/QRunnable>
 #include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
 #include <QtCore/QTimer>
 #include <QtGui/QClipboard>
 #include <QtGui/QDesktopServices>
@@ -86,6 +91,9 @@ using actions::Action;
 // {{{ helper
 namespace
 {
+    // Minimum time between two resizes applied while the view's size keeps changing.
+    constexpr auto ResizeInterval = std::chrono::milliseconds(50);
+
 #if !defined(NDEBUG) && defined(GL_DEBUG_OUTPUT) && defined(CONTOUR_DEBUG_OPENGL)
     void glMessageCallback(GLenum _source,
                            GLenum _type,
@@ -267,6 +275,10 @@ TerminalDisplay::TerminalDisplay(QQuickItem* parent):
 
     _updateTimer.setSingleShot(true);
     connect(&_updateTimer, &QTimer::timeout, this, &TerminalDisplay::scheduleRedraw, Qt::QueuedConnection);
+
+    _resizeTimer.setSingleShot(true);
+    _resizeTimer.setInterval(ResizeInterval);
+    connect(&_resizeTimer, &QTimer::timeout, this, &TerminalDisplay::applyPendingResize);
 }
 
 TerminalDisplay::~TerminalDisplay()
@@ -320,10 +332,16 @@ void TerminalDisplay::setSession(TerminalSession* newSession)
             _session->config().renderer.value().textureAtlasHashtableSlots,
             _session->config().renderer.value().textureAtlasTileCount,
             _session->config().renderer.value().textureAtlasDirectMapping,
+            _session->config().renderer.value().glyphDiskCache ? config::cacheHome() / "glyphs"
+                                                               : std::filesystem::path {},
             _session->profile().hyperlinkDecoration.value().normal,
             _session->profile().hyperlinkDecoration.value().hover
             // TODO: , WindowMargin(windowMargin_.left, windowMargin_.bottom);
         );
+        startup::mark(startup::Phase::FontsLoaded);
+
+        if (_session->config().renderer.value().asyncGlyphRasterization)
+            _renderer->enableAsyncRasterization([this]() { post([this]() { scheduleRedraw(); }); });
 
         // setup once with the renderer creation
         applyFontDPI();
@@ -357,12 +375,35 @@ void TerminalDisplay::sizeChanged()
 
     auto const virtualSize = vtbackend::ImageSize { Width::cast_from(width()), Height::cast_from(height()) };
     auto const actualPixelSize = virtualSize * contentScale();
+
+    // Every resize reflows the grid, reallocates the render buffers, and makes the shell redraw its prompt,
+    // so while the size keeps changing, the view keeps its previous size until the interval has passed.
+    if (_resizeTimer.isActive())
+    {
+        _pendingResize = actualPixelSize;
+        return;
+    }
+
     displayLog()("Resizing view to {} virtual ({} actual).", virtualSize, actualPixelSize);
     applyResize(actualPixelSize, *_session, *_renderer);
+    _resizeTimer.start();
+}
+
+void TerminalDisplay::applyPendingResize()
+{
+    if (!_pendingResize || !_session || !_renderTarget)
+        return;
+
+    auto const pixelSize = *_pendingResize;
+    _pendingResize.reset();
+    displayLog()("Applying pending resize of view to {}.", pixelSize);
+    applyResize(pixelSize, *_session, *_renderer);
+    _resizeTimer.start(); // the size may still be changing
 }
 
 void TerminalDisplay::handleWindowChanged(QQuickWindow* newWindow)
 {
+    _blurBehind.reset();
     if (newWindow)
     {
         displayLog()("Attaching widget {} to window {}.", (void*) this, (void*) newWindow);
@@ -394,7 +435,7 @@ void TerminalDisplay::handleWindowChanged(QQuickWindow* newWindow)
 class CleanupJob: public QRunnable
 {
   public:
-    explicit CleanupJob(OpenGLRenderer* renderer): _renderer { renderer } {}
+    explicit CleanupJob(DisplayRenderTarget* renderer): _renderer { renderer } {}
 
     void run() override
     {
@@ -403,7 +444,7 @@ class CleanupJob: public QRunnable
     }
 
   private:
-    OpenGLRenderer* _renderer;
+    DisplayRenderTarget* _renderer;
 };
 
 void TerminalDisplay::releaseResources()
@@ -413,11 +454,27 @@ void TerminalDisplay::releaseResources()
     _renderTarget = nullptr;
 }
 
+bool TerminalDisplay::releaseCachesIfHidden()
+{
+    if (!_renderer || !_renderTarget || (window() && window()->isExposed()))
+        return false;
+
+    displayLog()("Releasing render caches of hidden window.");
+    _renderer->clearCache();
+    _renderer->releaseRecentGlyphCaches();
+    return true;
+}
+
 void TerminalDisplay::cleanup()
 {
     displayLog()("Cleaning up.");
     delete _renderTarget;
     _renderTarget = nullptr;
+
+    // Invoked on the render thread, which the timer lives on, and which discards any events posted to it.
+    auto const _ = std::scoped_lock { _renderThreadTimerMutex };
+    delete _renderThreadTimer;
+    _renderThreadTimer = nullptr;
 }
 
 void TerminalDisplay::onRefreshRateChanged()
@@ -540,6 +597,22 @@ void TerminalDisplay::onSceneGrapheInitialized()
     CHECKED_GL(glEnable(GL_DEBUG_OUTPUT));
     CHECKED_GL(glDebugMessageCallback(&glMessageCallback, this));
 #endif
+
+    // The threaded render loop renders the frames requested by its own thread right away, without
+    // synchronizing with the GUI thread first, which is only needed once the scene itself changes.
+    auto const _ = std::scoped_lock { _renderThreadTimerMutex };
+    if (_session && _session->config().renderer.value().renderThread && QThread::currentThread() != thread()
+        && !_renderThreadTimer)
+    {
+        displayLog()("Scheduling frames from the render thread.");
+        auto* timer = new QTimer();
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, timer, [this]() {
+            if (window())
+                window()->update();
+        });
+        _renderThreadTimer = timer;
+    }
 }
 
 void TerminalDisplay::onBeforeSynchronize()
@@ -618,12 +691,30 @@ void TerminalDisplay::createRenderer()
                      windowSize.height());
     }
 
-    _renderTarget = new OpenGLRenderer(builtinShaderConfig(ShaderClass::Text),
-                                       builtinShaderConfig(ShaderClass::Background),
-                                       precalculatedViewSize,
-                                       precalculatedTargetSize,
-                                       textureTileSize,
-                                       viewportMargin);
+#if defined(CONTOUR_RHI_RENDERER)
+    if (window()->rendererInterface()->graphicsApi() != QSGRendererInterface::OpenGL)
+    {
+        _renderTarget = new RhiRenderer(builtinRhiShaderConfig(ShaderClass::Text),
+                                        builtinRhiShaderConfig(ShaderClass::Background),
+                                        precalculatedViewSize,
+                                        precalculatedTargetSize,
+                                        viewportMargin);
+
+        // Frames are drawn into the window's render pass, on top of the scene graph's contents.
+        connect(window(),
+                &QQuickWindow::afterRenderPassRecording,
+                this,
+                &TerminalDisplay::onAfterRenderPassRecording,
+                Qt::DirectConnection);
+    }
+    else
+#endif
+        _renderTarget = new OpenGLRenderer(builtinShaderConfig(ShaderClass::Text),
+                                           builtinShaderConfig(ShaderClass::Background),
+                                           precalculatedViewSize,
+                                           precalculatedTargetSize,
+                                           textureTileSize,
+                                           viewportMargin);
     _renderTarget->setWindow(window());
     _renderer->setRenderTarget(*_renderTarget);
 
@@ -645,6 +736,12 @@ void TerminalDisplay::createRenderer()
             &TerminalDisplay::onAfterRendering,
             Qt::DirectConnection);
 
+    connect(window(),
+            &QQuickWindow::frameSwapped,
+            this,
+            &TerminalDisplay::onFrameSwapped,
+            Qt::DirectConnection);
+
     configureScreenHooks();
     watchKdeDpiSetting();
 
@@ -673,11 +770,22 @@ QMatrix4x4 TerminalDisplay::createModelMatrix() const
 
 void TerminalDisplay::onBeforeRendering()
 {
-    if (_renderTarget->initialized())
-        return;
+    if (!_renderTarget->initialized())
+    {
+        logDisplayInfo();
+        _renderTarget->initialize();
+        startup::mark(startup::Phase::ShadersCompiled);
+    }
 
-    logDisplayInfo();
-    _renderTarget->initialize();
+    // Frames drawn within the window's render pass must be executed before that pass begins.
+    if (_renderTarget->recordsRenderPass())
+        paint();
+}
+
+void TerminalDisplay::onAfterRenderPassRecording()
+{
+    if (_renderTarget)
+        _renderTarget->recordRenderPass();
 }
 
 void TerminalDisplay::paint()
@@ -694,8 +802,14 @@ void TerminalDisplay::paint()
     try
     {
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-        window()->beginExternalCommands();
-        auto const _ = gsl::finally([this]() { window()->endExternalCommands(); });
+        // Only OpenGL commands are issued directly, in between those of the scene graph.
+        auto const externalCommands = !_renderTarget->recordsRenderPass();
+        if (externalCommands)
+            window()->beginExternalCommands();
+        auto const _ = gsl::finally([this, externalCommands]() {
+            if (externalCommands)
+                window()->endExternalCommands();
+        });
 #endif
 
         [[maybe_unused]] auto const lastState = _state.fetchAndClear();
@@ -717,6 +831,7 @@ void TerminalDisplay::paint()
 
         terminal().tick(steady_clock::now());
         _renderer->render(terminal(), _renderingPressure);
+        startup::mark(startup::Phase::FirstFrameRendered);
         if (_doDumpState)
         {
             doDumpStateInternal();
@@ -743,7 +858,10 @@ void TerminalDisplay::onAfterRendering()
     // This method is called after the QML scene has been rendered.
     // We use this to schedule the next rendering frame, if needed.
     // This signal is emitted from the scene graph rendering thread
-    paint();
+    if (!_renderTarget || !_renderTarget->recordsRenderPass())
+        paint();
+    else
+        _renderTarget->finishFrame();
     if (_saveScreenshot)
     {
         std::visit(crispy::overloaded { [&](const std::filesystem::path& path) {
@@ -769,6 +887,12 @@ void TerminalDisplay::onAfterRendering()
     terminal().tick(steady_clock::now());
 
     auto timeoutOpt = terminal().nextRender();
+
+    // Keep the performance HUD up to date, even while the terminal is idle.
+    if (_renderer && _renderer->performanceHudVisible())
+        timeoutOpt = std::min(timeoutOpt.value_or(vtrasterizer::PerformanceHud::SampleInterval),
+                              chrono::milliseconds(vtrasterizer::PerformanceHud::SampleInterval));
+
     if (!timeoutOpt.has_value())
         return;
 
@@ -780,9 +904,51 @@ void TerminalDisplay::onAfterRendering()
     }
     else
     {
-        post([this, timeout]() { _updateTimer.start(timeout); });
+        requestFrame(timeout);
     }
 }
+
+void TerminalDisplay::onFrameSwapped()
+{
+    // This signal is emitted from the scene graph rendering thread, just as the frame has been presented.
+    if (_renderer)
+        _renderer->framePresented(steady_clock::now());
+
+    if (startup::mark(startup::Phase::FirstFramePresented) && _session && _session->app().measuresStartup())
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(), []() { QCoreApplication::quit(); }, Qt::QueuedConnection);
+}
+
+void TerminalDisplay::startUpdateTimer(chrono::milliseconds timeout)
+{
+    if (!_updateTimer.isActive() || _updateTimer.remainingTime() > static_cast<int>(timeout.count()))
+        _updateTimer.start(timeout);
+}
+
+void TerminalDisplay::requestFrame(chrono::milliseconds delay)
+{
+    // The timer is kept alive while posting to it, the event being discarded if it is deleted afterwards.
+    auto lock = std::unique_lock { _renderThreadTimerMutex };
+    if (auto* timer = _renderThreadTimer)
+    {
+        postToObject(timer, [this, timer, delay]() {
+            if (delay.count() == 0)
+            {
+                if (window())
+                    window()->update();
+            }
+            else if (!timer->isActive() || timer->remainingTime() > static_cast<int>(delay.count()))
+                timer->start(delay);
+        });
+        return;
+    }
+    lock.unlock();
+
+    if (delay.count() != 0)
+        post([this, delay]() { startUpdateTimer(delay); });
+    else
+        post([this]() { window()->update(); });
+}
 // }}}
 
 // {{{ Qt Display Input Event handling & forwarding
@@ -862,7 +1028,7 @@ QVariant TerminalDisplay::inputMethodQuery(Qt::InputMethodQuery query) const
         if (terminal().isCursorInViewport())
         {
             auto const dpr = contentScale();
-            auto const gridCursorPos = terminal().currentScreen().cursor().position;
+            auto const gridCursorPos = terminal().publishedCursorPosition();
             cursorPos.setX(int(unbox<double>(gridCursorPos.column)
                                * unbox<double>(_renderer->gridMetrics().cellSize.width)));
             cursorPos.setY(int(unbox<double>(gridCursorPos.line)
@@ -1120,7 +1286,9 @@ void TerminalDisplay::doDumpState()
 
 QImage TerminalDisplay::screenshot()
 {
-    _renderer->render(terminal(), _renderingPressure);
+    // Render targets drawing within the window's render pass have already drawn the current frame.
+    if (!_renderTarget->recordsRenderPass())
+        _renderer->render(terminal(), _renderingPressure);
     auto [size, image] = _renderTarget->takeScreenshot();
 
     return QImage(image.data(),
@@ -1342,6 +1510,11 @@ void TerminalDisplay::setWindowNormal()
 
 void TerminalDisplay::setBlurBehind(bool enable)
 {
+    // Sessions request it again whenever they gain focus, which the compositor is not bothered with.
+    if (_blurBehind == enable)
+        return;
+
+    _blurBehind = enable;
     BlurBehind::setEnabled(window(), enable);
 }
 
@@ -1366,6 +1539,15 @@ void TerminalDisplay::toggleTitleBar()
     window()->setFlag(Qt::FramelessWindowHint, !currentlyFrameless);
 }
 
+void TerminalDisplay::togglePerformanceHud()
+{
+    if (!_renderer)
+        return;
+
+    _renderer->setPerformanceHudVisible(!_renderer->performanceHudVisible());
+    scheduleRedraw();
+}
+
 void TerminalDisplay::setHyperlinkDecoration(vtrasterizer::Decorator normal, vtrasterizer::Decorator hover)
 {
     _renderer->setHyperlinkDecoration(normal, hover);
@@ -1382,9 +1564,11 @@ void TerminalDisplay::scheduleRedraw()
         _lastHistoryLineCount = currentHistoryLineCount;
     }
 
-    // QCoreApplication::postEvent(this, new QEvent(QEvent::UpdateRequest));
-    if (window())
-        post([this]() { window()->update(); });
+    if (!window())
+        return;
+
+    // Frames not due yet, e.g. during bulk output, are deferred rather than rendered right away.
+    requestFrame(terminal().nextFrameDelay(steady_clock::now()));
 }
 
 void TerminalDisplay::renderBufferUpdated()
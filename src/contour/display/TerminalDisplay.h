@@ -23,18 +23,17 @@
 #include <QtQml/QtQml>
 #include <QtQuick/QQuickItem>
 
+#include <atomic>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <variant>
-#if defined(CONTOUR_PERF_STATS)
-    #include <atomic>
-#endif
 
 namespace contour::display
 {
 
-class OpenGLRenderer;
+class DisplayRenderTarget;
 
 // It currently just handles one terminal inside, but ideally later it can handle
 // multiple terminals in tabbed views as well tiled.
@@ -143,6 +142,7 @@ class TerminalDisplay: public QQuickItem
     void setBlurBehind(bool enable);
     void toggleFullScreen();
     void toggleTitleBar();
+    void togglePerformanceHud();
     void setHyperlinkDecoration(vtrasterizer::Decorator normal, vtrasterizer::Decorator hover);
 
     // terminal events
@@ -172,9 +172,12 @@ class TerminalDisplay: public QQuickItem
 
     void handleWindowChanged(QQuickWindow* newWindow);
     void sizeChanged();
+    void applyPendingResize();
     void cleanup();
 
+    void onAfterRenderPassRecording();
     void onAfterRendering();
+    void onFrameSwapped();
     void onScrollBarValueChanged(int value);
     void onRefreshRateChanged();
     void applyFontDPI();
@@ -205,6 +208,15 @@ class TerminalDisplay: public QQuickItem
         return unbox(terminal().currentScreen().historyLineCount());
     }
 
+    /// @returns the renderer, which is created along with the first session, or nullptr before.
+    [[nodiscard]] vtrasterizer::Renderer const* renderer() const noexcept { return _renderer.get(); }
+
+    /// Frees the glyph and image caches of the renderer, if the window is not exposed,
+    /// e.g. while minimized. They are rebuilt on demand once the window is shown again.
+    ///
+    /// @returns whether the caches have been freed.
+    bool releaseCachesIfHidden();
+
     [[nodiscard]] vtbackend::PageSize calculatePageSize() const
     {
         assert(_renderer);
@@ -230,6 +242,13 @@ class TerminalDisplay: public QQuickItem
 
     void updateMinimumSize();
 
+    /// Starts the update timer with the given timeout, unless it already times out earlier.
+    void startUpdateTimer(std::chrono::milliseconds timeout);
+
+    /// Requests a frame to be rendered after the given delay, from the render thread if frames are
+    /// scheduled from there, or from the GUI thread otherwise. May be invoked from any thread.
+    void requestFrame(std::chrono::milliseconds delay);
+
     // Updates the recommended size in (virtual pixels) based on:
     // - the grid cell size (based on the current font size and DPI),
     // - configured window margins, and
@@ -268,12 +287,25 @@ class TerminalDisplay: public QQuickItem
 #endif
     std::unique_ptr<vtrasterizer::Renderer> _renderer;
     bool _renderingPressure = false;
-    display::OpenGLRenderer* _renderTarget = nullptr;
+    display::DisplayRenderTarget* _renderTarget = nullptr;
     bool _maximizedState = false;
+    std::optional<bool> _blurBehind; // as last requested from the window's compositor
     bool _sessionChanged = false;
     // update() timer used to animate the blinking cursor.
     QTimer _updateTimer;
 
+    // The render thread's counterpart of the update timer, which lives on the render thread,
+    // if frames are scheduled from there. See RendererConfig::renderThread.
+    // It is guarded by the mutex, as frames are requested from the terminal thread, whereas the timer
+    // is deleted on the render thread.
+    QTimer* _renderThreadTimer = nullptr;
+    std::mutex _renderThreadTimerMutex;
+
+    // Size changes, e.g. while the window is being dragged, are applied at most once per interval
+    // of this timer, the newest pending one when it times out.
+    QTimer _resizeTimer;
+    std::optional<vtbackend::ImageSize> _pendingResize;
+
     RenderStateManager _state;
     bool _doDumpState = false;
     std::optional<std::variant<std::filesystem::path, std::monostate>> _saveScreenshot { std::nullopt };
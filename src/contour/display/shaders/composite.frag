@@ -0,0 +1,8 @@
+uniform highp sampler2D u_texture; // offscreen framebuffer, with colors premultiplied by alpha
+
+out highp vec4 fragColor;
+
+void main()
+{
+    fragColor = texelFetch(u_texture, ivec2(gl_FragCoord.xy), 0);
+}
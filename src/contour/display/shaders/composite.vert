@@ -0,0 +1,7 @@
+// Full-viewport quad, drawn as triangle strip of 4 vertices without any vertex attributes.
+void main()
+{
+    highp vec2 corner = vec2(float(gl_VertexID / 2), float(gl_VertexID % 2));
+
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
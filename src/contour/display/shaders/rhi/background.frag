@@ -0,0 +1,7 @@
+layout (location = 0) in highp vec4 fs_textColor;
+layout (location = 0) out highp vec4 outColor;
+
+void main()
+{
+    outColor = fs_textColor;
+}
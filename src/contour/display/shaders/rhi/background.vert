@@ -0,0 +1,20 @@
+layout (std140, binding = 0) uniform Uniforms
+{
+    highp mat4 projection; // projection matrix, including the clip space correction of the graphics API
+    highp float pixel_x;
+    highp float time;
+} u;
+
+layout (location = 0) in highp vec4 vs_rect;      // target rectangle (x, y, width, height), per instance
+layout (location = 1) in highp vec4 vs_colors;    // custom foreground colors
+
+layout (location = 0) out mediump vec4 fs_textColor;
+
+void main()
+{
+    // Corner of the rectangle's quad, drawn as triangle strip.
+    highp vec2 corner = vec2(float(gl_VertexIndex / 2), float(1 - gl_VertexIndex % 2));
+
+    gl_Position = u.projection * vec4(vs_rect.xy + corner * vs_rect.zw, 0.0, 1.0);
+    fs_textColor = vs_colors;
+}
@@ -0,0 +1,26 @@
+layout (std140, binding = 0) uniform Uniforms
+{
+    highp mat4 projection; // projection matrix, including the clip space correction of the graphics API
+    highp float pixel_x;   // 1.0 / lcdAtlas.width
+    highp float time;
+} u;
+
+layout (location = 0) in highp vec4 vs_rect;      // target rectangle (x, y, width, height), per instance
+layout (location = 1) in highp vec4 vs_texRect;   // normalized 2D-atlas rectangle (x, y, width, height)
+layout (location = 2) in highp vec2 vs_tileInfo;  // atlas layer and fragment shader selector
+layout (location = 3) in highp vec4 vs_colors;    // custom foreground colors
+
+layout (location = 0) out highp vec4 fs_TexCoord;
+layout (location = 1) out highp vec4 fs_textColor;
+
+void main()
+{
+    // Corner of the tile's quad, drawn as triangle strip:
+    // left top, left bottom, right top, right bottom.
+    highp vec2 corner = vec2(float(gl_VertexIndex / 2), float(1 - gl_VertexIndex % 2));
+
+    gl_Position = u.projection * vec4(vs_rect.xy + corner * vs_rect.zw, 0.0, 1.0);
+
+    fs_TexCoord = vec4(vs_texRect.xy + corner * vs_texRect.zw, vs_tileInfo);
+    fs_textColor = vs_colors;
+}
@@ -1,5 +1,8 @@
-uniform highp float pixel_x;                  // 1.0 / lcdAtlas.width
-uniform highp sampler2D fs_textureAtlas;      // RGBA
+uniform highp float pixel_x;                     // 1.0 / lcdAtlas.width
+uniform highp sampler2DArray fs_monochromeAtlas; // RED, alpha masks of grayscale glyphs
+uniform highp sampler2DArray fs_lcdAtlas;        // RGB, LCD subpixel glyphs
+uniform highp sampler2DArray fs_colorAtlas;      // RGBA, colored glyphs (e.g. Emoji)
+uniform highp sampler2DArray fs_imageAtlas;      // RGBA, image tiles (e.g. Sixel graphics)
 uniform highp float u_time;
 
 in highp vec4 fs_TexCoord;
@@ -20,26 +23,32 @@ void renderGrayscaleGlyph()
     //colorMask = alphaMap;
 
     // Using the RED-channel as alpha-mask of an anti-aliases glyph.
-    highp vec4 pixel = texture(fs_textureAtlas, fs_TexCoord.xy);
+    highp vec4 pixel = texture(fs_monochromeAtlas, fs_TexCoord.xyz);
     highp vec4 sampled = vec4(1.0, 1.0, 1.0, pixel.r);
     fragColor = sampled * fs_textColor;
 }
 
-// Renders an RGBA texture. This is used to render images (such as Sixel graphics or Emoji).
+// Renders an RGBA texture. This is used to render colored glyphs (such as Emoji).
 void renderColoredRGBA()
 {
     // colored image (RGBA)
-    highp vec4 v = texture(fs_textureAtlas, fs_TexCoord.xy);
+    highp vec4 v = texture(fs_colorAtlas, fs_TexCoord.xyz);
     //v = TEST_PIXEL;
     fragColor = v;
 }
 
+// Renders an RGBA image tile (such as Sixel graphics).
+void renderImageTile()
+{
+    fragColor = texture(fs_imageAtlas, fs_TexCoord.xyz);
+}
+
 // Simple LCD subpixel rendering will cause color fringes on the left/right side of the glyph
 // shapes. People may be used to this already?
 void renderLcdGlyphSimple()
 {
     // LCD glyph (RGB)
-    highp vec4 v = texture(fs_textureAtlas, fs_TexCoord.xy); // .rgb ?
+    highp vec4 v = texture(fs_lcdAtlas, fs_TexCoord.xyz); // .rgb ?
 
     // float a = min(v.r, min(v.g, v.b));
     highp float a = (v.r + v.g + v.b) / 3.0;
@@ -106,8 +115,8 @@ void renderLcdGlyph()
     //highp vec3 pixelOffset = vec3(1.0, 0.0, 0.0) * px;
 
     // LCD glyph (RGB)
-    highp vec4 current  = texture(fs_textureAtlas, fs_TexCoord.xy);
-    highp vec4 previous = texture(fs_textureAtlas, fs_TexCoord.xy - pixelOffset);
+    highp vec4 current  = texture(fs_lcdAtlas, fs_TexCoord.xyz);
+    highp vec4 previous = texture(fs_lcdAtlas, vec3(fs_TexCoord.xy - pixelOffset, fs_TexCoord.z));
 
     // The text in a terminal does enforce fixed-width advances, and therefore
     // rendering a glyph should always start at a full pixel with no shift.
@@ -149,6 +158,9 @@ void main()
         case FRAGMENT_SELECTOR_IMAGE_BGRA:
             renderColoredRGBA();
             break;
+        case FRAGMENT_SELECTOR_IMAGE_TILE:
+            renderImageTile();
+            break;
         case FRAGMENT_SELECTOR_GLYPH_ALPHA:
         default:
             renderGrayscaleGlyph();
@@ -1,16 +1,21 @@
 uniform highp mat4 vs_projection;                 // projection matrix (flips around the coordinate system)
 
-layout (location = 0) in highp vec3 vs_vertex;    // target vertex coordinates
-layout (location = 1) in highp vec4 vs_texCoords; // 2D-atlas texture coordinates
-layout (location = 2) in highp vec4 vs_colors;    // custom foreground colors
+layout (location = 0) in highp vec4 vs_rect;      // target rectangle (x, y, width, height), per instance
+layout (location = 1) in highp vec4 vs_texRect;   // normalized 2D-atlas rectangle (x, y, width, height)
+layout (location = 2) in highp vec2 vs_tileInfo;  // atlas layer and fragment shader selector
+layout (location = 3) in highp vec4 vs_colors;    // custom foreground colors
 
 out highp vec4 fs_TexCoord;
 out highp vec4 fs_textColor;
 
 void main()
 {
-    gl_Position = vs_projection * vec4(vs_vertex.xyz, 1.0);
+    // Corner of the tile's quad, drawn as triangle strip:
+    // left top, left bottom, right top, right bottom.
+    highp vec2 corner = vec2(float(gl_VertexID / 2), float(1 - gl_VertexID % 2));
 
-    fs_TexCoord = vs_texCoords;
+    gl_Position = vs_projection * vec4(vs_rect.xy + corner * vs_rect.zw, 0.0, 1.0);
+
+    fs_TexCoord = vec4(vs_texRect.xy + corner * vs_texRect.zw, vs_tileInfo);
     fs_textColor = vs_colors;
 }
@@ -594,11 +594,12 @@ bool applyFontDescription(text::DPI dpi,
                           vtrasterizer::Renderer& renderer,
                           vtrasterizer::FontDescriptions fontDescriptions)
 {
+    // Compare what the renderer would be given, as it only knows sanitized font descriptions.
+    fontDescriptions = sanitizeFontDescription(std::move(fontDescriptions), dpi);
     if (renderer.fontDescriptions() == fontDescriptions)
         return false;
 
-    renderer.setFonts(sanitizeFontDescription(std::move(fontDescriptions), dpi));
-    renderer.updateFontMetrics();
+    renderer.setFonts(std::move(fontDescriptions)); // also updates the font metrics
 
     return true;
 }
@@ -382,8 +382,9 @@ fi;
 # Actual customized code (for Contour) starts here:
 
 preexec() {
-    printf "\\e[?2028h";
+    printf "\\e[?2028h\\e]133;C\\e\\\\";
 }
 precmd() {
+    printf "\\e]133;D;%s\\e\\\\" "$?";
     printf "\\e[?2028l\\e[>M\\e]7;$PWD\\e\\\\";
 }
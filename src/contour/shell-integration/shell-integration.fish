@@ -16,6 +16,9 @@
 
 
 function precmd_hook_contour -d "Shell Integration hook to be invoked before each prompt" -e fish_prompt
+    # Marks the end of the previous command's output, along with its exit status.
+    printf "\e]133;D;$status\e\\"
+
     # Disable text reflow for the command prompt (and below).
     printf '\e[?2028l'
 
@@ -33,4 +36,7 @@ end
 function preexec_hook_contour -d "Run after printing prompt" -e fish_preexec
     # Enables text reflow for the main page area again, so that a window resize will reflow again.
     printf "\e[?2028h"
+
+    # Marks the start of the command's output.
+    printf "\e]133;C\e\\"
 end
@@ -1,9 +1,112 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <crispy/BufferObject.h>
+#include <crispy/utils.h>
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+#endif
 
 namespace crispy
 {
 
+namespace detail
+{
+    namespace
+    {
+        void* allocateHeap(size_t& size) noexcept
+        {
+            size = nextPowerOfTwo(static_cast<uint32_t>(size));
+            return malloc(size);
+        }
+
+#if defined(__linux__)
+        constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+        size_t roundUpToHugePage(size_t size) noexcept
+        {
+            return (size + HugePageSize - 1) & ~(HugePageSize - 1);
+        }
+
+        void* allocateTransparentHugePages(size_t size) noexcept
+        {
+            // Over-allocate by one huge page, so that the mapping can be trimmed to be huge page aligned,
+            // which is required for the kernel to back it by huge pages at all.
+            auto const mappedSize = size + HugePageSize;
+            auto* const mapped =
+                mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapped == MAP_FAILED)
+                return nullptr;
+
+            auto const base = reinterpret_cast<uintptr_t>(mapped);
+            auto const aligned = (base + HugePageSize - 1) & ~(HugePageSize - 1);
+            if (aligned != base)
+                munmap(mapped, aligned - base);
+            if (auto const tail = (base + mappedSize) - (aligned + size); tail != 0)
+                munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+            auto* const ptr = reinterpret_cast<void*>(aligned);
+            if (madvise(ptr, size, MADV_HUGEPAGE) != 0)
+                bufferObjectLog()("Advising transparent huge pages failed. {}", strerror(errno));
+            return ptr;
+        }
+
+        void* allocateHugeTLB(size_t size) noexcept
+        {
+            auto* const ptr = mmap(
+                nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            return ptr != MAP_FAILED ? ptr : nullptr;
+        }
+#endif
+    } // namespace
+
+    void* allocateBufferObjectStorage(size_t& size, buffer_object_allocation& allocation) noexcept
+    {
+#if defined(__linux__)
+        if (allocation == buffer_object_allocation::HugeTLB)
+        {
+            if (auto* ptr = allocateHugeTLB(roundUpToHugePage(size)))
+            {
+                size = roundUpToHugePage(size);
+                return ptr;
+            }
+            bufferObjectLog()("Allocating from huge page pool failed. {}", strerror(errno));
+            allocation = buffer_object_allocation::TransparentHugePages;
+        }
+
+        if (allocation == buffer_object_allocation::TransparentHugePages)
+        {
+            if (auto* ptr = allocateTransparentHugePages(roundUpToHugePage(size)))
+            {
+                size = roundUpToHugePage(size);
+                return ptr;
+            }
+            bufferObjectLog()("Allocating transparent huge pages failed. {}", strerror(errno));
+        }
+#endif
+
+        allocation = buffer_object_allocation::Heap;
+        return allocateHeap(size);
+    }
+
+    void freeBufferObjectStorage(void* ptr, size_t size, buffer_object_allocation allocation) noexcept
+    {
+#if defined(__linux__)
+        if (allocation != buffer_object_allocation::Heap)
+        {
+            munmap(ptr, size);
+            return;
+        }
+#else
+        (void) size;
+        (void) allocation;
+#endif
+        free(ptr);
+    }
+} // namespace detail
+
 template class buffer_object<char>;
 template class buffer_fragment<char>;
 template class buffer_object_pool<char>;
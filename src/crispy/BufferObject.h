@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <format>
 #include <functional>
 #include <iterator>
 #include <list>
@@ -43,6 +44,35 @@ using buffer_object_release = std::function<void(buffer_object<T>*)>;
 template <BufferObjectElementType T>
 using buffer_object_ptr = std::shared_ptr<buffer_object<T>>;
 
+/// Describes how the storage of a buffer object is allocated.
+enum class buffer_object_allocation : uint8_t
+{
+    /// Regular heap memory, with the total size rounded up to the next power of two.
+    Heap,
+
+    /// Anonymous memory mapping aligned to and rounded up to 2 MiB, advised to be backed by
+    /// transparent huge pages. Falls back to Heap where not supported.
+    TransparentHugePages,
+
+    /// Anonymous memory mapping from the reserved huge page pool (MAP_HUGETLB).
+    /// Falls back to TransparentHugePages if no huge pages are available.
+    HugeTLB,
+};
+
+namespace detail
+{
+    /// Allocates storage of at least @p size bytes.
+    ///
+    /// @p size        updated to the number of bytes actually allocated.
+    /// @p allocation  updated to the allocation mode actually used, when falling back.
+    ///
+    /// @returns the storage, or nullptr on failure.
+    void* allocateBufferObjectStorage(size_t& size, buffer_object_allocation& allocation) noexcept;
+
+    /// Frees storage previously allocated by allocateBufferObjectStorage().
+    void freeBufferObjectStorage(void* ptr, size_t size, buffer_object_allocation allocation) noexcept;
+} // namespace detail
+
 auto const inline bufferObjectLog = logstore::category("BufferObject",
                                                        "Logs buffer object pool activity.",
                                                        logstore::category::state::Disabled,
@@ -70,7 +100,22 @@ class buffer_object: public std::enable_shared_from_this<buffer_object<T>>
     explicit buffer_object(size_t capacity) noexcept;
     ~buffer_object();
 
-    static buffer_object_ptr<T> create(size_t capacity, buffer_object_release<T> release = {});
+    /// Creates a buffer object of at least @p capacity elements.
+    ///
+    /// @p release     invoked once the last reference is dropped, destroy() if empty.
+    /// @p allocation  how the storage is allocated.
+    static buffer_object_ptr<T> create(size_t capacity,
+                                       buffer_object_release<T> release = {},
+                                       buffer_object_allocation allocation = buffer_object_allocation::Heap);
+
+    /// Destroys a buffer object created by create() and frees its storage.
+    static void destroy(buffer_object* ptr) noexcept;
+
+    /// Returns how the storage of this buffer object has actually been allocated.
+    [[nodiscard]] buffer_object_allocation allocation() const noexcept { return _allocation; }
+
+    /// Returns the number of bytes of storage allocated, including the buffer object itself.
+    [[nodiscard]] std::size_t storageSize() const noexcept { return _storageSize; }
 
     void reset() noexcept;
 
@@ -128,6 +173,8 @@ class buffer_object: public std::enable_shared_from_this<buffer_object<T>>
 #endif
     T* _hotEnd;
     T* _end;
+    size_t _storageSize = 0;
+    buffer_object_allocation _allocation = buffer_object_allocation::Heap;
 
     friend class buffer_fragment<T>;
 
@@ -145,19 +192,45 @@ template <BufferObjectElementType T>
 class buffer_object_pool
 {
   public:
-    explicit buffer_object_pool(size_t bufferSize = 4096);
+    /// Counters for monitoring a buffer_object_pool.
+    struct stats
+    {
+        size_t allocated = 0;   // number of buffer objects newly allocated
+        size_t recycled = 0;    // number of buffer objects handed out again from the unused list
+        size_t liveBytes = 0;   // bytes of storage of all buffer objects currently handed out
+        size_t unusedBytes = 0; // bytes of storage of all buffer objects waiting to be recycled
+    };
+
+    explicit buffer_object_pool(size_t bufferSize = 4096,
+                                buffer_object_allocation allocation = buffer_object_allocation::Heap);
+    buffer_object_pool(buffer_object_pool const&) = delete;
+    buffer_object_pool& operator=(buffer_object_pool const&) = delete;
     ~buffer_object_pool();
 
     void releaseUnusedBuffers();
     [[nodiscard]] size_t unusedBuffers() const noexcept;
     [[nodiscard]] buffer_object_ptr<T> allocateBufferObject();
 
+    [[nodiscard]] stats statistics() const noexcept;
+    [[nodiscard]] buffer_object_allocation allocation() const noexcept { return _allocation; }
+
   private:
-    void release(buffer_object<T>* ptr);
+    /// State shared with the buffer objects handed out, which may be released on any thread,
+    /// even after the pool has been destroyed, destroying them then rather than recycling them.
+    struct shared_state
+    {
+        std::mutex mutex;
+        bool reuseBuffers = true;
+        std::list<buffer_object<T>*> unusedBuffers;
+        stats statistics;
+    };
+
+    static void release(std::shared_ptr<shared_state> const& state, buffer_object<T>* ptr);
+    [[nodiscard]] buffer_object_release<T> releaser() const;
 
-    bool _reuseBuffers = true;
     size_t _bufferSize;
-    std::list<buffer_object_ptr<T>> _unusedBuffers;
+    buffer_object_allocation _allocation;
+    std::shared_ptr<shared_state> _state;
 };
 
 /**
@@ -221,7 +294,8 @@ buffer_object<T>::buffer_object(size_t capacity) noexcept:
     data_ { new T[capacity] },
 #endif
     _hotEnd { data() },
-    _end { data() + capacity }
+    _end { data() + capacity },
+    _storageSize { sizeof(buffer_object) + (capacity * sizeof(T)) }
 {
 #if defined(BUFFER_OBJECT_INLINE)
     new (data()) T[capacity];
@@ -243,19 +317,43 @@ buffer_object<T>::~buffer_object()
 }
 
 template <BufferObjectElementType T>
-buffer_object_ptr<T> buffer_object<T>::create(size_t capacity, buffer_object_release<T> release)
+buffer_object_ptr<T> buffer_object<T>::create(size_t capacity,
+                                              buffer_object_release<T> release,
+                                              buffer_object_allocation allocation)
 {
+    if (!release)
+        release = [](buffer_object* p) {
+            destroy(p);
+        };
+
 #if defined(BUFFER_OBJECT_INLINE)
-    auto const totalCapacity = nextPowerOfTwo(static_cast<uint32_t>(sizeof(buffer_object) + capacity));
-    auto const nettoCapacity = totalCapacity - sizeof(buffer_object);
-    auto ptr = (buffer_object*) malloc(totalCapacity);
-    new (ptr) buffer_object(nettoCapacity);
+    auto totalCapacity = sizeof(buffer_object) + (capacity * sizeof(T));
+    auto ptr = (buffer_object*) detail::allocateBufferObjectStorage(totalCapacity, allocation);
+    if (!ptr)
+        throw std::bad_alloc();
+    new (ptr) buffer_object((totalCapacity - sizeof(buffer_object)) / sizeof(T));
+    ptr->_storageSize = totalCapacity;
+    ptr->_allocation = allocation;
     return buffer_object_ptr<T>(ptr, std::move(release));
 #else
+    (void) allocation;
     return buffer_object_ptr<T>(new buffer_object<T>(nextPowerOfTwo(capacity)), std::move(release));
 #endif
 }
 
+template <BufferObjectElementType T>
+void buffer_object<T>::destroy(buffer_object* ptr) noexcept
+{
+#if defined(BUFFER_OBJECT_INLINE)
+    auto const storageSize = ptr->_storageSize;
+    auto const allocation = ptr->_allocation;
+    std::destroy_n(ptr, 1);
+    detail::freeBufferObjectStorage(ptr, storageSize, allocation);
+#else
+    delete ptr;
+#endif
+}
+
 template <BufferObjectElementType T>
 gsl::span<T const> buffer_object<T>::writeAtEnd(gsl::span<T const> data) noexcept
 {
@@ -342,65 +440,124 @@ inline std::size_t buffer_fragment<T>::endOffset() const noexcept
 
 // {{{ BufferObjectPool implementation
 template <BufferObjectElementType T>
-buffer_object_pool<T>::buffer_object_pool(size_t bufferSize): _bufferSize { bufferSize }
+buffer_object_pool<T>::buffer_object_pool(size_t bufferSize, buffer_object_allocation allocation):
+    _bufferSize { bufferSize }, _allocation { allocation }, _state { std::make_shared<shared_state>() }
 {
-    bufferObjectLog()("Creating BufferObject pool with chunk size {}",
-                      crispy::humanReadableBytes(bufferSize));
+    bufferObjectLog()("Creating BufferObject pool with chunk size {} ({})",
+                      crispy::humanReadableBytes(bufferSize),
+                      allocation);
 }
 
 template <BufferObjectElementType T>
 buffer_object_pool<T>::~buffer_object_pool()
 {
-    _reuseBuffers = false;
+    // Buffer objects still referred to are destroyed once released, wherever that happens.
+    auto unused = std::list<buffer_object<T>*> {};
+    {
+        auto const _ = std::scoped_lock { _state->mutex };
+        _state->reuseBuffers = false;
+        unused.swap(_state->unusedBuffers);
+    }
+    for (auto* ptr: unused)
+        buffer_object<T>::destroy(ptr);
 }
 
 template <BufferObjectElementType T>
 size_t buffer_object_pool<T>::unusedBuffers() const noexcept
 {
-    return _unusedBuffers.size();
+    auto const _ = std::scoped_lock { _state->mutex };
+    return _state->unusedBuffers.size();
+}
+
+template <BufferObjectElementType T>
+typename buffer_object_pool<T>::stats buffer_object_pool<T>::statistics() const noexcept
+{
+    auto const _ = std::scoped_lock { _state->mutex };
+    return _state->statistics;
 }
 
 template <BufferObjectElementType T>
 void buffer_object_pool<T>::releaseUnusedBuffers()
 {
-    _reuseBuffers = false;
-    _unusedBuffers.clear();
-    _reuseBuffers = true;
+    auto unused = std::list<buffer_object<T>*> {};
+    {
+        auto const _ = std::scoped_lock { _state->mutex };
+        unused.swap(_state->unusedBuffers);
+        _state->statistics.unusedBytes = 0;
+    }
+    for (auto* ptr: unused)
+        buffer_object<T>::destroy(ptr);
+}
+
+template <BufferObjectElementType T>
+buffer_object_release<T> buffer_object_pool<T>::releaser() const
+{
+    return [state = _state](buffer_object<T>* ptr) {
+        release(state, ptr);
+    };
 }
 
 template <BufferObjectElementType T>
 buffer_object_ptr<T> buffer_object_pool<T>::allocateBufferObject()
 {
-    if (_unusedBuffers.empty())
-        return buffer_object<T>::create(_bufferSize, [this](auto p) { release(p); });
+    auto lock = std::unique_lock { _state->mutex };
+    if (_state->unusedBuffers.empty())
+    {
+        lock.unlock();
+        auto buffer = buffer_object<T>::create(_bufferSize, releaser(), _allocation);
+        lock.lock();
+        ++_state->statistics.allocated;
+        _state->statistics.liveBytes += buffer->storageSize();
+        return buffer;
+    }
 
-    buffer_object_ptr<T> buffer = std::move(_unusedBuffers.front());
+    auto* const ptr = _state->unusedBuffers.front();
     if (bufferObjectLog)
-        bufferObjectLog()("Recycling BufferObject from pool: @{}.", (void*) buffer.get());
-    _unusedBuffers.pop_front();
-    return buffer;
+        bufferObjectLog()("Recycling BufferObject from pool: @{}.", (void*) ptr);
+    _state->unusedBuffers.pop_front();
+    ++_state->statistics.recycled;
+    _state->statistics.unusedBytes -= ptr->storageSize();
+    _state->statistics.liveBytes += ptr->storageSize();
+    lock.unlock();
+    return buffer_object_ptr<T>(ptr, releaser());
 }
 
 template <BufferObjectElementType T>
-void buffer_object_pool<T>::release(buffer_object<T>* ptr)
+void buffer_object_pool<T>::release(std::shared_ptr<shared_state> const& state, buffer_object<T>* ptr)
 {
-    if (_reuseBuffers)
-    {
-        if (bufferObjectLog)
-            bufferObjectLog()("Releasing BufferObject from pool: @{}", (void*) ptr);
-        ptr->reset();
-        _unusedBuffers.emplace_back(ptr, [this](auto p) { release(p); });
-    }
-    else
     {
-#if defined(BUFFER_OBJECT_INLINE)
-        std::destroy_n(ptr, 1);
-        free(ptr);
-#else
-        delete ptr;
-#endif
+        auto const _ = std::scoped_lock { state->mutex };
+        state->statistics.liveBytes -= ptr->storageSize();
+        if (state->reuseBuffers)
+        {
+            if (bufferObjectLog)
+                bufferObjectLog()("Releasing BufferObject from pool: @{}", (void*) ptr);
+            ptr->reset();
+            state->statistics.unusedBytes += ptr->storageSize();
+            state->unusedBuffers.emplace_back(ptr);
+            return;
+        }
     }
+    buffer_object<T>::destroy(ptr);
 }
 // }}}
 
 } // namespace crispy
+
+template <>
+struct std::formatter<crispy::buffer_object_allocation>: std::formatter<std::string_view>
+{
+    auto format(crispy::buffer_object_allocation value, auto& ctx) const
+    {
+        std::string_view name;
+        switch (value)
+        {
+            case crispy::buffer_object_allocation::Heap: name = "heap"; break;
+            case crispy::buffer_object_allocation::TransparentHugePages:
+                name = "transparent_huge_pages";
+                break;
+            case crispy::buffer_object_allocation::HugeTLB: name = "huge_tlb"; break;
+        }
+        return formatter<std::string_view>::format(name, ctx);
+    }
+};
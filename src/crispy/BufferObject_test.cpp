@@ -3,7 +3,89 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace crispy;
+
 TEST_CASE("buffer_object", "[buffer_object]")
 {
-    // TODO
+    auto buffer = buffer_object<char>::create(100);
+    CHECK(buffer->capacity() >= 100);
+    CHECK(buffer->bytesUsed() == 0);
+    CHECK(buffer->allocation() == buffer_object_allocation::Heap);
+
+    buffer->advance(10);
+    CHECK(buffer->bytesUsed() == 10);
+    CHECK(buffer->bytesAvailable() == buffer->capacity() - 10);
+}
+
+TEST_CASE("buffer_object.huge_pages", "[buffer_object]")
+{
+    // Whatever the platform supports, the allocation falls back to something usable.
+    auto buffer = buffer_object<char>::create(100, {}, buffer_object_allocation::HugeTLB);
+    REQUIRE(buffer->capacity() >= 100);
+    std::memset(buffer->data(), 'x', buffer->capacity());
+    if (buffer->allocation() != buffer_object_allocation::Heap)
+        CHECK(buffer->storageSize() % (2 * 1024 * 1024) == 0);
+}
+
+TEST_CASE("buffer_object_pool.outlived", "[buffer_object]")
+{
+    auto buffer = buffer_object_ptr<char> {};
+    {
+        auto pool = buffer_object_pool<char>(64);
+        buffer = pool.allocateBufferObject();
+        buffer->advance(10);
+    }
+
+    // Released from another thread after the pool is gone, the buffer is destroyed rather than recycled.
+    std::thread([buffer = std::exchange(buffer, {})]() mutable { buffer.reset(); }).join();
+    CHECK(!buffer);
+}
+
+TEST_CASE("buffer_object_pool.release_from_threads", "[buffer_object]")
+{
+    auto pool = buffer_object_pool<char>(64);
+    auto threads = std::vector<std::thread> {};
+    for (auto i = 0; i < 8; ++i)
+        threads.emplace_back([buffer = pool.allocateBufferObject()]() mutable { buffer.reset(); });
+    for (auto& thread: threads)
+        thread.join();
+
+    CHECK(pool.unusedBuffers() == 8);
+    CHECK(pool.statistics().liveBytes == 0);
+}
+
+TEST_CASE("buffer_object_pool.recycle", "[buffer_object]")
+{
+    auto pool = buffer_object_pool<char>(64);
+
+    auto first = pool.allocateBufferObject();
+    auto const storageSize = first->storageSize();
+    CHECK(pool.statistics().allocated == 1);
+    CHECK(pool.statistics().recycled == 0);
+    CHECK(pool.statistics().liveBytes == storageSize);
+
+    auto const* const address = first.get();
+    first->advance(10);
+    first.reset();
+    CHECK(pool.unusedBuffers() == 1);
+    CHECK(pool.statistics().liveBytes == 0);
+    CHECK(pool.statistics().unusedBytes == storageSize);
+
+    auto second = pool.allocateBufferObject();
+    CHECK(second.get() == address);
+    CHECK(second->bytesUsed() == 0);
+    CHECK(pool.unusedBuffers() == 0);
+    CHECK(pool.statistics().allocated == 1);
+    CHECK(pool.statistics().recycled == 1);
+    CHECK(pool.statistics().liveBytes == storageSize);
+    CHECK(pool.statistics().unusedBytes == 0);
+
+    second.reset();
+    pool.releaseUnusedBuffers();
+    CHECK(pool.unusedBuffers() == 0);
+    CHECK(pool.statistics().unusedBytes == 0);
 }
@@ -0,0 +1,299 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <crispy/StrongHash.h>
+#include <crispy/StrongLRUHashtable.h>
+#include <crispy/assert.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+
+namespace crispy
+{
+
+/**
+ * LRU hashtable that may be accessed by multiple threads at the same time.
+ *
+ * Entries are spread over a number of shards, each a strong_lru_hashtable guarded by a lock of its own,
+ * so that threads only contend when accessing the same shard.
+ *
+ * Lookups take their shard's lock shared, so that any number of threads can look up entries of a shard
+ * at the same time. As moving an entry to the front of the LRU chain would change the shard,
+ * lookups merely record the hash into a small buffer of the shard, and the recorded entries are
+ * touched in one batch by the next thread holding the shard's lock exclusively.
+ * Lookups are dropped from the LRU order once that buffer is full, which only makes eviction
+ * less precise.
+ *
+ * Values are handed out as copies or to a visitor only, as they may be evicted by other threads
+ * at any time.
+ */
+template <typename Value>
+class concurrent_strong_lru_hashtable
+{
+  public:
+    /// Number of lookups per shard whose LRU touches are buffered until the shard is locked exclusively.
+    static constexpr inline uint32_t TouchBufferSize = 64;
+
+    /// Default number of shards, which should be at least the number of threads accessing the table.
+    static constexpr inline uint32_t DefaultShardCount = 16;
+
+    /// Constructs a hashtable of the given total hash and entry counts, spread evenly across
+    /// @p shardCount shards, which must be a power of two.
+    concurrent_strong_lru_hashtable(strong_hashtable_size hashCount,
+                                    lru_capacity entryCount,
+                                    uint32_t shardCount = DefaultShardCount,
+                                    std::string const& name = "");
+
+    /// Returns the actual number of entries currently hold in this hashtable.
+    [[nodiscard]] size_t size() const;
+
+    /// Returns the maximum number of entries that can be stored in this hashtable.
+    [[nodiscard]] size_t capacity() const noexcept;
+
+    /// Returns gathered stats and clears the local stats state to start
+    /// counting from zero again.
+    lru_hashtable_stats fetchAndClearStats();
+
+    /// Clears all entries from the hashtable.
+    void clear();
+
+    // Deletes the hash entry and its associated value from the LRU hashtable
+    void remove(strong_hash const& hash);
+
+    /// Tests for the exitence of the given hash key in this hash table, without touching it.
+    [[nodiscard]] bool contains(strong_hash const& hash) const;
+
+    /// Invokes @p visitor with the value for the given hash key, if found,
+    /// while no other thread may change it.
+    ///
+    /// @returns whether the hash key was found.
+    template <typename Visitor>
+    bool visit(strong_hash const& hash, Visitor&& visitor) const;
+
+    /// Returns a copy of the value for the given hash key if found, std::nullopt otherwise.
+    [[nodiscard]] std::optional<Value> try_get(strong_hash const& hash) const;
+
+    /// Assigns the given value to the given hash key, creating its entry if not present yet.
+    void emplace(strong_hash const& hash, Value value);
+
+    /// Returns a copy of the existing value for the given hash key, if found, or otherwise of a newly
+    /// created one by invoking constructValue() outside of any lock.
+    ///
+    /// If another thread stores a value for the same hash key in the meantime, that one is kept.
+    template <typename ValueConstructFn>
+    [[nodiscard]] Value get_or_emplace(strong_hash const& hash, ValueConstructFn constructValue);
+
+  private:
+    using table = strong_lru_hashtable<Value>;
+
+    struct shard
+    {
+        mutable std::shared_mutex mutex;
+        typename table::ptr entries;
+
+        // Lookups since the shard was last locked exclusively, to be touched in the LRU chain then.
+        mutable std::array<strong_hash, TouchBufferSize> touches {};
+        mutable std::atomic<uint32_t> touchCount = 0;
+
+        mutable std::atomic<uint32_t> hits = 0;
+        mutable std::atomic<uint32_t> misses = 0;
+    };
+
+    [[nodiscard]] shard& shardOf(strong_hash const& hash) const noexcept
+    {
+        // The lowest bits select the slot within the shard's hash table, so use the highest ones here.
+        return _shards[static_cast<uint64_t>(hash.d()) >> _shardShift];
+    }
+
+    // Records a lookup, while holding the shard's lock shared.
+    // @returns whether the buffer has filled up and should be applied.
+    static bool recordTouch(shard const& s, strong_hash const& hash) noexcept;
+
+    // Touches all recorded lookups, while holding the shard's lock exclusively.
+    static void applyTouches(shard& s) noexcept;
+
+    // Applies the recorded lookups if no other thread holds the shard's lock.
+    static void tryApplyTouches(shard& s) noexcept;
+
+    std::unique_ptr<shard[]> _shards;
+    uint32_t _shardCount;
+    uint32_t _shardShift; // number of bits to shift a hash's d() by to get its shard index
+};
+
+// {{{ implementation
+template <typename Value>
+concurrent_strong_lru_hashtable<Value>::concurrent_strong_lru_hashtable(strong_hashtable_size hashCount,
+                                                                        lru_capacity entryCount,
+                                                                        uint32_t shardCount,
+                                                                        std::string const& name):
+    _shards { std::make_unique<shard[]>(shardCount) },
+    _shardCount { shardCount },
+    _shardShift { 32 - static_cast<uint32_t>(std::countr_zero(shardCount)) }
+{
+    Require(detail::isPowerOfTwo(shardCount));
+    Require(hashCount.value >= shardCount);
+
+    auto const shardHashCount = strong_hashtable_size { hashCount.value / shardCount };
+    auto const shardEntryCount = lru_capacity { std::max(entryCount.value / shardCount, uint32_t { 2 }) };
+    for (uint32_t i = 0; i < shardCount; ++i)
+        _shards[i].entries = table::create(shardHashCount, shardEntryCount, name);
+}
+
+template <typename Value>
+size_t concurrent_strong_lru_hashtable<Value>::size() const
+{
+    auto result = size_t { 0 };
+    for (uint32_t i = 0; i < _shardCount; ++i)
+    {
+        auto const lock = std::shared_lock { _shards[i].mutex };
+        result += _shards[i].entries->size();
+    }
+    return result;
+}
+
+template <typename Value>
+size_t concurrent_strong_lru_hashtable<Value>::capacity() const noexcept
+{
+    return _shardCount * _shards[0].entries->capacity();
+}
+
+template <typename Value>
+lru_hashtable_stats concurrent_strong_lru_hashtable<Value>::fetchAndClearStats()
+{
+    auto result = lru_hashtable_stats {};
+    for (uint32_t i = 0; i < _shardCount; ++i)
+    {
+        auto& s = _shards[i];
+        auto const lock = std::scoped_lock { s.mutex };
+        result.hits += s.hits.exchange(0, std::memory_order_relaxed);
+        result.misses += s.misses.exchange(0, std::memory_order_relaxed);
+        // Hits and misses of the shard's own table are internal lookups of the touches and writes.
+        result.recycles += s.entries->fetchAndClearStats().recycles;
+    }
+    return result;
+}
+
+template <typename Value>
+void concurrent_strong_lru_hashtable<Value>::clear()
+{
+    for (uint32_t i = 0; i < _shardCount; ++i)
+    {
+        auto& s = _shards[i];
+        auto const lock = std::scoped_lock { s.mutex };
+        s.touchCount.store(0, std::memory_order_relaxed);
+        s.entries->clear();
+    }
+}
+
+template <typename Value>
+void concurrent_strong_lru_hashtable<Value>::remove(strong_hash const& hash)
+{
+    auto& s = shardOf(hash);
+    auto const lock = std::scoped_lock { s.mutex };
+    applyTouches(s);
+    s.entries->remove(hash);
+}
+
+template <typename Value>
+bool concurrent_strong_lru_hashtable<Value>::contains(strong_hash const& hash) const
+{
+    auto const& s = shardOf(hash);
+    auto const lock = std::shared_lock { s.mutex };
+    return s.entries->try_peek(hash) != nullptr;
+}
+
+template <typename Value>
+template <typename Visitor>
+bool concurrent_strong_lru_hashtable<Value>::visit(strong_hash const& hash, Visitor&& visitor) const
+{
+    auto& s = shardOf(hash);
+    auto bufferFull = false;
+    {
+        auto const lock = std::shared_lock { s.mutex };
+        Value const* value = s.entries->try_peek(hash);
+        if (!value)
+        {
+            s.misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        s.hits.fetch_add(1, std::memory_order_relaxed);
+        bufferFull = recordTouch(s, hash);
+        visitor(*value);
+    }
+
+    if (bufferFull)
+        tryApplyTouches(s);
+    return true;
+}
+
+template <typename Value>
+std::optional<Value> concurrent_strong_lru_hashtable<Value>::try_get(strong_hash const& hash) const
+{
+    auto result = std::optional<Value> {};
+    visit(hash, [&](Value const& value) { result.emplace(value); });
+    return result;
+}
+
+template <typename Value>
+void concurrent_strong_lru_hashtable<Value>::emplace(strong_hash const& hash, Value value)
+{
+    auto& s = shardOf(hash);
+    auto const lock = std::scoped_lock { s.mutex };
+    applyTouches(s);
+    (void) s.entries->emplace(hash, std::move(value));
+}
+
+template <typename Value>
+template <typename ValueConstructFn>
+Value concurrent_strong_lru_hashtable<Value>::get_or_emplace(strong_hash const& hash,
+                                                             ValueConstructFn constructValue)
+{
+    if (auto existing = try_get(hash); existing)
+        return std::move(*existing);
+
+    auto value = constructValue();
+
+    auto& s = shardOf(hash);
+    auto const lock = std::scoped_lock { s.mutex };
+    applyTouches(s);
+    return s.entries->get_or_emplace(hash, [&](uint32_t /*entryIndex*/) { return std::move(value); });
+}
+
+template <typename Value>
+bool concurrent_strong_lru_hashtable<Value>::recordTouch(shard const& s, strong_hash const& hash) noexcept
+{
+    // Checking first keeps the counter from ever wrapping around while the buffer stays full.
+    if (s.touchCount.load(std::memory_order_relaxed) >= TouchBufferSize)
+        return true;
+    auto const index = s.touchCount.fetch_add(1, std::memory_order_relaxed);
+    if (index < TouchBufferSize)
+        s.touches[index] = hash; // each thread writes a slot of its own, read with the lock held exclusively
+    return index + 1 >= TouchBufferSize;
+}
+
+template <typename Value>
+void concurrent_strong_lru_hashtable<Value>::applyTouches(shard& s) noexcept
+{
+    auto const count = std::min(s.touchCount.exchange(0, std::memory_order_relaxed), TouchBufferSize);
+    for (uint32_t i = 0; i < count; ++i)
+        s.entries->touch(s.touches[i]);
+}
+
+template <typename Value>
+void concurrent_strong_lru_hashtable<Value>::tryApplyTouches(shard& s) noexcept
+{
+    if (!s.mutex.try_lock())
+        return;
+    applyTouches(s);
+    s.mutex.unlock();
+}
+// }}}
+
+} // namespace crispy
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/ConcurrentStrongLRUHashtable.h>
+#include <crispy/StrongHash.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace crispy;
+using namespace std;
+
+namespace
+{
+// Spreads the keys across all bits of d(), as its highest ones select the shard.
+inline strong_hash h(uint32_t value)
+{
+    return strong_hash(0, 0, value, value * 0x9E3779B1U);
+}
+} // namespace
+
+// NOLINTBEGIN(misc-const-correctness,readability-function-cognitive-complexity)
+TEST_CASE("concurrent_strong_lru_hashtable.emplace_and_get", "")
+{
+    auto table = concurrent_strong_lru_hashtable<int>(strong_hashtable_size { 64 }, lru_capacity { 32 }, 4);
+    CHECK(table.capacity() == 32);
+    CHECK(table.size() == 0);
+
+    table.emplace(h(1), 1);
+    table.emplace(h(2), 2);
+    table.emplace(h(3), 3);
+    CHECK(table.size() == 3);
+
+    CHECK(table.try_get(h(1)) == 1);
+    CHECK(table.try_get(h(2)) == 2);
+    CHECK(table.try_get(h(3)) == 3);
+    CHECK_FALSE(table.try_get(h(4)).has_value());
+    CHECK(table.contains(h(1)));
+    CHECK_FALSE(table.contains(h(4)));
+
+    auto const stats = table.fetchAndClearStats();
+    CHECK(stats.hits == 3);
+    CHECK(stats.misses == 1);
+
+    table.remove(h(1));
+    CHECK_FALSE(table.contains(h(1)));
+    CHECK(table.size() == 2);
+
+    table.clear();
+    CHECK(table.size() == 0);
+}
+
+TEST_CASE("concurrent_strong_lru_hashtable.get_or_emplace", "")
+{
+    auto table = concurrent_strong_lru_hashtable<int>(strong_hashtable_size { 64 }, lru_capacity { 32 }, 4);
+    auto constructed = 0;
+    auto const construct = [&]() {
+        ++constructed;
+        return 42;
+    };
+
+    CHECK(table.get_or_emplace(h(1), construct) == 42);
+    CHECK(table.get_or_emplace(h(1), construct) == 42);
+    CHECK(constructed == 1);
+}
+
+TEST_CASE("concurrent_strong_lru_hashtable.batched_touches", "")
+{
+    // Single shard of four entries, so that the LRU order is observable through evictions.
+    auto table = concurrent_strong_lru_hashtable<int>(strong_hashtable_size { 8 }, lru_capacity { 4 }, 1);
+    for (uint32_t i = 1; i <= 4; ++i)
+        table.emplace(h(i), static_cast<int>(i));
+
+    // The lookup of the least recently used entry is applied by the next write, before evicting.
+    CHECK(table.try_get(h(1)) == 1);
+    table.emplace(h(5), 5);
+
+    CHECK(table.contains(h(1)));
+    CHECK_FALSE(table.contains(h(2)));
+    CHECK(table.size() == 4);
+}
+
+TEST_CASE("concurrent_strong_lru_hashtable.concurrent_lookups", "")
+{
+    auto constexpr ThreadCount = 4;
+    auto constexpr KeyCount = uint32_t { 256 };
+    auto constexpr Rounds = 200;
+
+    auto table = concurrent_strong_lru_hashtable<uint32_t>(strong_hashtable_size { 1024 },
+                                                           lru_capacity { 512 });
+    for (uint32_t i = 0; i < KeyCount; ++i)
+        table.emplace(h(i), i);
+
+    auto mismatches = std::atomic<int> { 0 };
+    auto threads = std::vector<std::thread> {};
+    for (auto t = 0; t < ThreadCount; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            for (auto round = 0; round < Rounds; ++round)
+            {
+                for (uint32_t i = 0; i < KeyCount; ++i)
+                {
+                    auto const value = table.get_or_emplace(h(i), [&]() { return i; });
+                    if (value != i)
+                        ++mismatches;
+                }
+                // Keep writing while the other threads are reading.
+                if (t == 0)
+                    table.emplace(h(KeyCount + static_cast<uint32_t>(round)), 0);
+            }
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+
+    CHECK(mismatches == 0);
+    auto const stats = table.fetchAndClearStats();
+    CHECK(stats.hits + stats.misses == ThreadCount * Rounds * KeyCount);
+    CHECK(table.size() <= table.capacity());
+}
+// NOLINTEND(misc-const-correctness,readability-function-cognitive-complexity)
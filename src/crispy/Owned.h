@@ -19,7 +19,8 @@ struct CRISPY_PACKED owned
     owned(owned&& v) noexcept: _ptr { v.release() } {}
     owned& operator=(owned&& v) noexcept
     {
-        _ptr = v.release();
+        if (this != &v)
+            reset(v.release());
         return *this;
     }
 
@@ -125,6 +125,47 @@ inline strong_hash operator*(strong_hash a, uint32_t b) noexcept
     return a * strong_hash(0, 0, 0, b);
 }
 
+/// Computes a strong_hash over a sequence of values as they are visited one at a time,
+/// e.g. over the codepoints of grid cells while walking them,
+/// so that they need not be gathered into a string just to be hashed.
+///
+/// The result also covers the number of values added, but is not the same as strong_hash::compute()
+/// over the same values, as that one starts off with the length instead.
+class strong_hash_builder // NOLINT(readability-identifier-naming)
+{
+  public:
+    strong_hash_builder& add(uint32_t value) noexcept
+    {
+        _hash = _hash * value;
+        ++_count;
+        return *this;
+    }
+
+    template <typename T>
+    strong_hash_builder& add(std::basic_string_view<T> text) noexcept
+    {
+        for (T const value: text)
+            add(static_cast<uint32_t>(value));
+        return *this;
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return _count == 0; }
+    [[nodiscard]] uint32_t count() const noexcept { return _count; }
+
+    /// @returns the hash over all values added so far.
+    [[nodiscard]] strong_hash finish() const noexcept { return _hash * _count; }
+
+    void reset() noexcept
+    {
+        _hash = strong_hash(0, 0, 0, 0);
+        _count = 0;
+    }
+
+  private:
+    strong_hash _hash = strong_hash(0, 0, 0, 0);
+    uint32_t _count = 0;
+};
+
 template <typename T>
 strong_hash strong_hash::compute(std::basic_string_view<T> text) noexcept
 {
@@ -299,6 +340,15 @@ struct strong_hasher<std::basic_string_view<U>>
 
 } // namespace crispy
 
+template <>
+struct std::hash<crispy::strong_hash>
+{
+    size_t operator()(crispy::strong_hash const& hash) const noexcept
+    {
+        return static_cast<size_t>(crispy::to_integer(hash));
+    }
+};
+
 template <>
 struct std::formatter<crispy::strong_hash>
 {
@@ -142,6 +142,10 @@ class strong_lru_hashtable
     [[nodiscard]] Value& peek(strong_hash const& hash);
     [[nodiscard]] Value const& peek(strong_hash const& hash) const;
 
+    /// like try_get() but changes neither the LRU order nor the stats,
+    /// so that it may be invoked by multiple threads at the same time.
+    [[nodiscard]] Value const* try_peek(strong_hash const& hash) const noexcept;
+
     /// Returns the value for the given hash key, default-constructing it in case
     /// if it wasn't in the hashtable just yet.
     [[nodiscard]] Value& operator[](strong_hash const& hash) noexcept;
@@ -530,6 +534,20 @@ inline Value const& strong_lru_hashtable<Value>::peek(strong_hash const& hash) c
     return const_cast<strong_lru_hashtable*>(this)->peek(hash);
 }
 
+template <typename Value>
+inline Value const* strong_lru_hashtable<Value>::try_peek(strong_hash const& hash) const noexcept
+{
+    auto entryIndex = _hashTable[hash.d() & _hashMask];
+    while (entryIndex)
+    {
+        entry const& entry = _entries[entryIndex];
+        if (entry.hashValue == hash)
+            return &*entry.value;
+        entryIndex = entry.nextWithSameHash;
+    }
+    return nullptr;
+}
+
 template <typename Value>
 inline Value& strong_lru_hashtable<Value>::operator[](strong_hash const& hash) noexcept
 {
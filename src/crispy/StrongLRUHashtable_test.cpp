@@ -75,6 +75,27 @@ TEST_CASE("strong_hash", "")
     REQUIRE(a != f);
 }
 
+TEST_CASE("strong_hash_builder", "")
+{
+    auto const hashOf = [](std::u32string_view text) {
+        return strong_hash_builder {}.add(text).finish();
+    };
+
+    auto builder = strong_hash_builder {};
+    CHECK(builder.empty());
+    builder.add(U'A').add(std::u32string_view(U"BC"));
+    CHECK(builder.count() == 3);
+    CHECK(builder.finish() == hashOf(U"ABC"));
+
+    CHECK(hashOf(U"ABC") != hashOf(U"CBA"));
+    CHECK(hashOf(U"ABC") != hashOf(U"AB"));
+    CHECK(hashOf(U"") != hashOf(std::u32string_view(U"\0", 1)));
+
+    builder.reset();
+    CHECK(builder.empty());
+    CHECK(builder.finish() == hashOf(U""));
+}
+
 TEST_CASE("strong_lru_hashtable.operator_index", "")
 {
     auto cachePtr = strong_lru_hashtable<int>::create(strong_hashtable_size { 8 }, lru_capacity { 4 });
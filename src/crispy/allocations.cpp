@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/allocations.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace crispy::allocations
+{
+
+namespace
+{
+    // NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+    std::atomic<uint64_t> totalCount = 0;
+    std::atomic<uint64_t> totalBytes = 0;
+    // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
+
+    std::vector<counter*>& registry() noexcept
+    {
+        static auto instance = std::vector<counter*> {};
+        return instance;
+    }
+
+#if defined(CONTOUR_ALLOCATION_ACCOUNTING)
+    void* countedAllocate(size_t size)
+    {
+        totalCount.fetch_add(1, std::memory_order_relaxed);
+        totalBytes.fetch_add(size, std::memory_order_relaxed);
+        if (auto* target = detail::current)
+            target->add(size);
+        if (void* p = std::malloc(size != 0 ? size : 1))
+            return p;
+        throw std::bad_alloc();
+    }
+#endif
+} // namespace
+
+counter::counter(char const* name): _name { name }
+{
+    registry().push_back(this);
+}
+
+counts total() noexcept
+{
+    return counts { .count = totalCount.load(std::memory_order_relaxed),
+                    .bytes = totalBytes.load(std::memory_order_relaxed) };
+}
+
+std::vector<counter*> const& counters() noexcept
+{
+    return registry();
+}
+
+} // namespace crispy::allocations
+
+#if defined(CONTOUR_ALLOCATION_ACCOUNTING)
+using crispy::allocations::countedAllocate;
+
+// The nothrow variants default to these, and the aligned ones are left alone,
+// as they neither allocate nor free through these.
+void* operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+#endif
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Accounts heap allocations to the subsystems that make them, so that it can be told which stage
+/// of processing a frame allocates how much.
+///
+/// Accounting is opt-in at build time, by defining CONTOUR_ALLOCATION_ACCOUNTING, which replaces
+/// the global operator new. Every allocation is counted in total, and in the counter of the
+/// innermost allocation scope of its thread, if any. Without it, scopes compile to nothing
+/// and all counts stay zero.
+namespace crispy::allocations
+{
+
+struct counts
+{
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+
+    [[nodiscard]] counts operator-(counts const& other) const noexcept
+    {
+        return counts { .count = count - other.count, .bytes = bytes - other.bytes };
+    }
+};
+
+/// Counts the allocations made within the allocation scopes given it.
+///
+/// Counters register themselves for counters() to enumerate them, and are meant to be
+/// globals that live as long as the process does. The name must outlive the counter,
+/// e.g. by being a string literal.
+class counter
+{
+  public:
+    explicit counter(char const* name);
+
+    counter(counter const&) = delete;
+    counter(counter&&) = delete;
+    counter& operator=(counter const&) = delete;
+    counter& operator=(counter&&) = delete;
+    ~counter() = default;
+
+    [[nodiscard]] char const* name() const noexcept { return _name; }
+
+    [[nodiscard]] counts read() const noexcept
+    {
+        return counts { .count = _count.load(std::memory_order_relaxed),
+                        .bytes = _bytes.load(std::memory_order_relaxed) };
+    }
+
+    void add(size_t bytes) noexcept
+    {
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+  private:
+    char const* _name;
+    std::atomic<uint64_t> _count = 0;
+    std::atomic<uint64_t> _bytes = 0;
+};
+
+namespace detail
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+    inline thread_local counter* current = nullptr;
+} // namespace detail
+
+/// @returns whether allocations are being accounted in this build.
+[[nodiscard]] constexpr bool enabled() noexcept
+{
+#if defined(CONTOUR_ALLOCATION_ACCOUNTING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// @returns all allocations made so far, in or outside of any scope.
+[[nodiscard]] counts total() noexcept;
+
+/// @returns all counters, in the order they have been constructed in.
+[[nodiscard]] std::vector<counter*> const& counters() noexcept;
+
+/// Accounts the allocations of its thread to the given counter, from its construction
+/// to its destruction, unless a nested scope accounts them to another one meanwhile.
+class scope
+{
+  public:
+    explicit scope(counter& target) noexcept: _previous { detail::current } { detail::current = &target; }
+
+    scope(scope const&) = delete;
+    scope(scope&&) = delete;
+    scope& operator=(scope const&) = delete;
+    scope& operator=(scope&&) = delete;
+
+    ~scope() { detail::current = _previous; }
+
+  private:
+    counter* _previous;
+};
+
+} // namespace crispy::allocations
+
+#define CRISPY_ALLOCATION_CONCAT_(a, b) a##b
+#define CRISPY_ALLOCATION_CONCAT(a, b)  CRISPY_ALLOCATION_CONCAT_(a, b)
+
+/// Accounts the allocations of the enclosing scope to the given counter.
+#if defined(CONTOUR_ALLOCATION_ACCOUNTING)
+    #define CRISPY_ALLOCATION_SCOPE(counter)                                                         \
+        ::crispy::allocations::scope const CRISPY_ALLOCATION_CONCAT(crispyAllocationScope, __LINE__) \
+        {                                                                                            \
+            counter                                                                                  \
+        }
+#else
+    #define CRISPY_ALLOCATION_SCOPE(counter)
+#endif
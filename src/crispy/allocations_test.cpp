@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/allocations.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <new>
+#include <string_view>
+
+namespace
+{
+
+auto outerAllocations = crispy::allocations::counter { "test.outer" };
+auto innerAllocations = crispy::allocations::counter { "test.inner" };
+
+// Allocates through the global operator new, which new-expressions may be optimized away from.
+void allocate(size_t size)
+{
+    ::operator delete(::operator new(size));
+}
+
+} // namespace
+
+TEST_CASE("allocations.counters")
+{
+    auto const& counters = crispy::allocations::counters();
+    CHECK(std::ranges::find(counters, &outerAllocations) != counters.end());
+    CHECK(std::ranges::find(counters, &innerAllocations) != counters.end());
+    CHECK(outerAllocations.name() == std::string_view("test.outer"));
+}
+
+TEST_CASE("allocations.scope")
+{
+    auto const totalBefore = crispy::allocations::total();
+    auto const outerBefore = outerAllocations.read();
+    auto const innerBefore = innerAllocations.read();
+    {
+        CRISPY_ALLOCATION_SCOPE(outerAllocations);
+        allocate(16);
+        {
+            CRISPY_ALLOCATION_SCOPE(innerAllocations);
+            allocate(32);
+        }
+        allocate(64);
+    }
+    allocate(128);
+
+    auto const total = crispy::allocations::total() - totalBefore;
+    auto const outer = outerAllocations.read() - outerBefore;
+    auto const inner = innerAllocations.read() - innerBefore;
+    if constexpr (crispy::allocations::enabled())
+    {
+        CHECK(total.count >= 4);
+        CHECK(total.bytes >= 16 + 32 + 64 + 128);
+        CHECK(outer.count == 2);
+        CHECK(outer.bytes == 16 + 64);
+        CHECK(inner.count == 1);
+        CHECK(inner.bytes == 32);
+    }
+    else
+    {
+        CHECK(total.count == 0);
+        CHECK(outer.count == 0);
+        CHECK(inner.count == 0);
+    }
+}
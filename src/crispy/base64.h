@@ -3,9 +3,18 @@
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <string_view>
 
+#if defined(__x86_64__) || defined(_M_AMD64)
+    #include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+#endif
+
 namespace crispy::base64
 {
 
@@ -45,6 +54,165 @@ namespace detail
             s += c;
         return s;
     }
+
+#if defined(__x86_64__) || defined(_M_AMD64) // {{{
+    /// Translates 16 characters into their 6-bit values, clearing @p valid for any that is none.
+    inline __m128i translateSse(__m128i chars, __m128i& valid) noexcept
+    {
+        // Signed comparison: bytes >= 0x80 are negative and thus never within any of the ranges.
+        auto const within = [chars](char first, char last) {
+            return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(first - 1))),
+                                 _mm_cmplt_epi8(chars, _mm_set1_epi8(static_cast<char>(last + 1))));
+        };
+        auto const upper = within('A', 'Z');
+        auto const lower = within('a', 'z');
+        auto const digit = within('0', '9');
+        auto const plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+        auto const slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+        valid = _mm_and_si128(
+            valid, _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash)));
+
+        auto const offset = [](__m128i mask, int value) {
+            return _mm_and_si128(mask, _mm_set1_epi8(static_cast<char>(value)));
+        };
+        auto const offsets =
+            _mm_or_si128(_mm_or_si128(offset(upper, 0 - 'A'), offset(lower, 26 - 'a')),
+                         _mm_or_si128(offset(digit, 52 - '0'),
+                                      _mm_or_si128(offset(plus, 62 - '+'), offset(slash, 63 - '/'))));
+        return _mm_add_epi8(chars, offsets);
+    }
+
+    #if defined(__SSSE3__)
+    /// Packs 16 6-bit values into the 12 bytes they encode, followed by 4 zero bytes.
+    inline __m128i packSsse3(__m128i values) noexcept
+    {
+        auto const merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        auto const packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        return _mm_shuffle_epi8(packed,
+                                _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    }
+    #else
+    /// Packs 16 6-bit values into the 3 bytes each 4 of them encode, at the start of each 32-bit lane.
+    inline __m128i packSse2(__m128i values) noexcept
+    {
+        auto const bits = [values](int mask) {
+            return _mm_and_si128(values, _mm_set1_epi32(mask));
+        };
+        auto const byte0 =
+            _mm_or_si128(_mm_slli_epi32(bits(0x0000003F), 2), _mm_srli_epi32(bits(0x00003000), 12));
+        auto const byte1 =
+            _mm_or_si128(_mm_slli_epi32(bits(0x00000F00), 4), _mm_srli_epi32(bits(0x003C0000), 10));
+        auto const byte2 =
+            _mm_or_si128(_mm_slli_epi32(bits(0x00030000), 6), _mm_srli_epi32(bits(0x3F000000), 8));
+        return _mm_or_si128(byte0, _mm_or_si128(byte1, byte2));
+    }
+    #endif
+#endif // }}}
+
+#if defined(__aarch64__) || defined(_M_ARM64) // {{{
+    /// Translates 16 characters into their 6-bit values, clearing @p valid for any that is none.
+    inline uint8x16_t translateNeon(uint8x16_t chars, uint8x16_t& valid) noexcept
+    {
+        auto const within = [chars](char first, char last) {
+            return vandq_u8(vcgeq_u8(chars, vdupq_n_u8(static_cast<uint8_t>(first))),
+                            vcleq_u8(chars, vdupq_n_u8(static_cast<uint8_t>(last))));
+        };
+        auto const upper = within('A', 'Z');
+        auto const lower = within('a', 'z');
+        auto const digit = within('0', '9');
+        auto const plus = vceqq_u8(chars, vdupq_n_u8('+'));
+        auto const slash = vceqq_u8(chars, vdupq_n_u8('/'));
+        valid = vandq_u8(valid, vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(vorrq_u8(digit, plus), slash)));
+
+        auto const offset = [](uint8x16_t mask, int value) {
+            return vandq_u8(mask, vdupq_n_u8(static_cast<uint8_t>(value)));
+        };
+        auto const offsets = vorrq_u8(
+            vorrq_u8(offset(upper, 0 - 'A'), offset(lower, 26 - 'a')),
+            vorrq_u8(offset(digit, 52 - '0'), vorrq_u8(offset(plus, 62 - '+'), offset(slash, 63 - '/'))));
+        return vaddq_u8(chars, offsets);
+    }
+#endif // }}}
+
+    /// Decodes the longest run of whole blocks of base64 characters at @p input that SIMD instructions
+    /// can decode at once, advancing @p input and @p output past them.
+    ///
+    /// The input is decoded in blocks of 32 characters (AVX2), 16 characters (SSE2),
+    /// 64 characters (NEON), or not at all if no SIMD instruction set is available.
+    /// A block containing padding or any other character not in the alphabet is left to the caller.
+    inline void decodeBlocks(char const*& input, char const* end, char*& output) noexcept
+    {
+#if defined(__AVX2__)
+        // The shuffle below works on either 128-bit lane, the permutation then joins their 12 bytes each.
+        auto const merge = _mm256_set1_epi32(0x01400140);
+        auto const join = _mm256_set1_epi32(0x00011000);
+        auto const shuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        auto const permutation = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+        while (end - input >= 32)
+        {
+            auto const chars = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input));
+            auto validLow = _mm_set1_epi8(-1);
+            auto validHigh = _mm_set1_epi8(-1);
+            auto const values = _mm256_set_m128i(translateSse(_mm256_extracti128_si256(chars, 1), validHigh),
+                                                 translateSse(_mm256_castsi256_si128(chars), validLow));
+            if (_mm_movemask_epi8(_mm_and_si128(validLow, validHigh)) != 0xFFFF)
+                return;
+            auto const packed = _mm256_madd_epi16(_mm256_maddubs_epi16(values, merge), join);
+            auto const bytes = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(packed, shuffle), permutation);
+            char block[32];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(block), bytes);
+            std::memcpy(output, block, 24);
+            input += 32;
+            output += 24;
+        }
+#endif
+
+#if defined(__x86_64__) || defined(_M_AMD64)
+        while (end - input >= 16)
+        {
+            auto valid = _mm_set1_epi8(-1);
+            auto const values = translateSse(_mm_loadu_si128(reinterpret_cast<__m128i const*>(input)), valid);
+            if (_mm_movemask_epi8(valid) != 0xFFFF)
+                return;
+            char block[16];
+    #if defined(__SSSE3__)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(block), packSsse3(values));
+            std::memcpy(output, block, 12);
+    #else
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(block), packSse2(values));
+            for (auto i = 0; i < 4; ++i)
+                std::memcpy(output + (i * 3), block + (i * 4), 3);
+    #endif
+            input += 16;
+            output += 12;
+        }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        while (end - input >= 64)
+        {
+            // Deinterleaves the characters, such that each vector holds the same one of every 4.
+            auto const chars = vld4q_u8(reinterpret_cast<uint8_t const*>(input));
+            auto valid = vdupq_n_u8(0xFF);
+            auto const a = translateNeon(chars.val[0], valid);
+            auto const b = translateNeon(chars.val[1], valid);
+            auto const c = translateNeon(chars.val[2], valid);
+            auto const d = translateNeon(chars.val[3], valid);
+            if (vminvq_u8(valid) == 0)
+                return;
+            auto bytes = uint8x16x3_t {};
+            bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+            bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+            bytes.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+            vst3q_u8(reinterpret_cast<uint8_t*>(output), bytes);
+            input += 64;
+            output += 48;
+        }
+#else
+        (void) input;
+        (void) end;
+        (void) output;
+#endif
+    }
 } // namespace detail
 
 struct encoder_state
@@ -232,11 +400,82 @@ size_t decode(std::string_view input, Output output)
     return decode(input.begin(), input.end(), output);
 }
 
+/// State of decoding a base64 encoded stream that is handed over in chunks.
+struct decoder_state
+{
+    uint8_t modulo = 0; // number of pending values
+    uint8_t pending[4] {};
+    bool finished = false; // padding, or any other character not in the alphabet, ends the stream
+};
+
+/// Decodes the next chunk of a base64 encoded stream straight into @p output.
+///
+/// Whole blocks are decoded with SIMD instructions where available, any others byte-wise.
+/// Characters of an incomplete block at the end of the chunk are kept in @p state for the next chunk.
+///
+/// @param output buffer with room for at least (state.modulo + chunk.size()) / 4 * 3 bytes.
+///
+/// @returns the number of bytes written to @p output.
+inline size_t decode(std::string_view chunk, decoder_state& state, char* output) noexcept
+{
+    auto const* input = chunk.data();
+    auto const* const end = input + chunk.size();
+    auto* out = output;
+
+    while (!state.finished && input != end)
+    {
+        if (state.modulo == 0)
+        {
+            detail::decodeBlocks(input, end, out);
+            if (input == end)
+                break;
+        }
+
+        auto const value = detail::IndexMap[static_cast<uint8_t>(*input++)];
+        if (value > 63)
+        {
+            state.finished = true;
+            break;
+        }
+
+        state.pending[state.modulo++] = value;
+        if (state.modulo == 4)
+        {
+            auto const* p = state.pending;
+            *out++ = static_cast<char>(p[0] << 2 | p[1] >> 4);
+            *out++ = static_cast<char>(p[1] << 4 | p[2] >> 2);
+            *out++ = static_cast<char>(p[2] << 6 | p[3]);
+            state.modulo = 0;
+        }
+    }
+
+    return static_cast<size_t>(out - output);
+}
+
+/// Decodes what is left of an incomplete final block in @p state into @p output, which must have
+/// room for 2 bytes, and resets @p state for the next stream.
+///
+/// @returns the number of bytes written to @p output.
+inline size_t finish(decoder_state& state, char* output) noexcept
+{
+    auto const* p = state.pending;
+    auto* out = output;
+    if (state.modulo >= 2)
+        *out++ = static_cast<char>(p[0] << 2 | p[1] >> 4);
+    if (state.modulo >= 3)
+        *out++ = static_cast<char>(p[1] << 4 | p[2] >> 2);
+    state = {};
+    return static_cast<size_t>(out - output);
+}
+
 inline std::string decode(std::string_view input)
 {
     std::string output;
-    output.resize(decodeLength(input));
-    output.resize(decode(input, output.data()));
+    output.resize((input.size() + 3) / 4 * 3);
+    auto state = decoder_state {};
+    auto count = decode(input, state, output.data());
+    count += finish(state, output.data() + count);
+    output.resize(count);
     return output;
 }
 
@@ -22,3 +22,49 @@ TEST_CASE("base64.decode", "[base64]")
     CHECK("abcd" == base64::decode("YWJjZA=="));
     CHECK("foo:bar" == base64::decode("Zm9vOmJhcg=="));
 }
+
+TEST_CASE("base64.decode.blocks", "[base64]")
+{
+    // Long enough for every SIMD code path, and for the byte-wise one to decode what is left.
+    auto text = std::string {};
+    for (auto i = 0; i < 1000; ++i)
+        text += static_cast<char>((i * 7) % 256);
+
+    for (auto const size: { 47, 48, 49, 95, 96, 97, 191, 192, 1000 })
+    {
+        INFO("size: " << size);
+        auto const original = text.substr(0, static_cast<size_t>(size));
+        CHECK(original == base64::decode(base64::encode(original)));
+    }
+}
+
+TEST_CASE("base64.decode.stops_at_invalid_character", "[base64]")
+{
+    auto const original = std::string(100, 'x');
+    auto encoded = base64::encode(original);
+    encoded[80] = '!';
+    CHECK(original.substr(0, 60) == base64::decode(encoded));
+}
+
+TEST_CASE("base64.decode.chunked", "[base64]")
+{
+    auto const original =
+        std::string { "The quick brown fox jumps over the lazy dog, twice over, and then some." };
+    auto const encoded = base64::encode(original);
+
+    for (auto const chunkSize: { 1, 3, 5, 16, 50 })
+    {
+        INFO("chunk size: " << chunkSize);
+        auto output = std::string(encoded.size(), '\0');
+        auto state = base64::decoder_state {};
+        auto count = size_t { 0 };
+        for (auto i = size_t { 0 }; i < encoded.size(); i += static_cast<size_t>(chunkSize))
+        {
+            auto const chunk = std::string_view(encoded).substr(i, static_cast<size_t>(chunkSize));
+            count += base64::decode(chunk, state, output.data() + count);
+        }
+        count += base64::finish(state, output.data() + count);
+        output.resize(count);
+        CHECK(original == output);
+    }
+}
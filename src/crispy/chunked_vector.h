@@ -0,0 +1,328 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace crispy
+{
+
+/**
+ * Sequence container storing its elements in fixed-size chunks, rather than in one contiguous block.
+ *
+ * Elements never move in memory once constructed, so that growing the container is amortized O(1)
+ * without relocating any of them, and its peak memory use never doubles as a vector's does.
+ * Removing the first element is O(1) as well, as the head merely advances within the first chunk,
+ * which is released once all of its elements are gone.
+ *
+ * The interface mirrors the subset of std::vector that crispy::ring uses of its storage.
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class chunked_vector // NOLINT(readability-identifier-naming)
+{
+    template <bool Const>
+    class basic_iterator;
+
+    using allocator_traits = std::allocator_traits<Allocator>;
+
+  public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = T const&;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    /// Number of elements per chunk, such that a chunk takes about 16 KiB.
+    static constexpr size_type ChunkSize = std::bit_floor(std::max(size_type { 16 }, 16384 / sizeof(T)));
+
+    chunked_vector() = default;
+
+    chunked_vector(size_type count, T const& value)
+    {
+        reserve(count);
+        for (size_type i = 0; i < count; ++i)
+            emplace_back(value);
+    }
+
+    chunked_vector(chunked_vector const& other): _allocator { other._allocator }
+    {
+        reserve(other.size());
+        for (auto const& value: other)
+            emplace_back(value);
+    }
+
+    chunked_vector(chunked_vector&& other) noexcept:
+        _allocator { std::move(other._allocator) },
+        _chunks { std::move(other._chunks) },
+        _head { std::exchange(other._head, 0) },
+        _size { std::exchange(other._size, 0) }
+    {
+        other._chunks.clear();
+    }
+
+    chunked_vector& operator=(chunked_vector const& other)
+    {
+        if (this != &other)
+        {
+            auto copy = chunked_vector(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    chunked_vector& operator=(chunked_vector&& other) noexcept
+    {
+        if (this != &other)
+        {
+            auto moved = chunked_vector(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    ~chunked_vector()
+    {
+        clear();
+        releaseChunks(0);
+    }
+
+    void swap(chunked_vector& other) noexcept
+    {
+        using std::swap;
+        swap(_allocator, other._allocator);
+        swap(_chunks, other._chunks);
+        swap(_head, other._head);
+        swap(_size, other._size);
+    }
+
+    [[nodiscard]] size_type size() const noexcept { return _size; }
+    [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+    [[nodiscard]] size_type capacity() const noexcept { return (_chunks.size() * ChunkSize) - _head; }
+
+    [[nodiscard]] T& operator[](size_type i) noexcept { return slot(i); }
+    [[nodiscard]] T const& operator[](size_type i) const noexcept { return slot(i); }
+
+    [[nodiscard]] T& front() noexcept { return slot(0); }
+    [[nodiscard]] T const& front() const noexcept { return slot(0); }
+    [[nodiscard]] T& back() noexcept { return slot(_size - 1); }
+    [[nodiscard]] T const& back() const noexcept { return slot(_size - 1); }
+
+    [[nodiscard]] iterator begin() noexcept { return iterator { this, 0 }; }
+    [[nodiscard]] iterator end() noexcept { return iterator { this, static_cast<difference_type>(_size) }; }
+    [[nodiscard]] const_iterator begin() const noexcept { return const_iterator { this, 0 }; }
+    [[nodiscard]] const_iterator end() const noexcept
+    {
+        return const_iterator { this, static_cast<difference_type>(_size) };
+    }
+
+    /// Allocates chunks for up to @p count elements, without moving any existing one.
+    void reserve(size_type count)
+    {
+        while (capacity() < count)
+            _chunks.push_back(allocator_traits::allocate(_allocator, ChunkSize));
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        reserve(_size + 1);
+        T* const target = &slot(_size);
+        allocator_traits::construct(_allocator, target, std::forward<Args>(args)...);
+        ++_size;
+        return *target;
+    }
+
+    void push_back(T const& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void pop_back() noexcept
+    {
+        assert(_size > 0);
+        --_size;
+        allocator_traits::destroy(_allocator, &slot(_size));
+    }
+
+    void pop_front() noexcept
+    {
+        assert(_size > 0);
+        allocator_traits::destroy(_allocator, &slot(0));
+        --_size;
+        if (++_head == ChunkSize)
+        {
+            allocator_traits::deallocate(_allocator, _chunks.front(), ChunkSize);
+            _chunks.erase(_chunks.begin());
+            _head = 0;
+        }
+    }
+
+    void resize(size_type count)
+    {
+        while (_size > count)
+            pop_back();
+        reserve(count);
+        while (_size < count)
+            emplace_back();
+    }
+
+    void resize(size_type count, T const& value)
+    {
+        while (_size > count)
+            pop_back();
+        reserve(count);
+        while (_size < count)
+            emplace_back(value);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        auto const from = first.index();
+        auto const count = static_cast<size_type>(last.index() - from);
+        if (count == 0)
+            return iterator { this, from };
+
+        if (from == 0)
+        {
+            for (size_type i = 0; i < count; ++i)
+                pop_front();
+            return begin();
+        }
+
+        std::move(std::next(begin(), last.index()), end(), std::next(begin(), from));
+        for (size_type i = 0; i < count; ++i)
+            pop_back();
+        return iterator { this, from };
+    }
+
+    iterator erase(const_iterator position) { return erase(position, std::next(position)); }
+
+    void clear() noexcept
+    {
+        while (_size > 0)
+            pop_back();
+        _head = 0;
+    }
+
+    /// Releases all chunks not holding any element.
+    void shrink_to_fit()
+    {
+        if (_size == 0)
+            _head = 0;
+        releaseChunks((_head + _size + ChunkSize - 1) / ChunkSize);
+        _chunks.shrink_to_fit();
+    }
+
+  private:
+    [[nodiscard]] T& slot(size_type i) const noexcept
+    {
+        auto const position = _head + i;
+        return _chunks[position / ChunkSize][position % ChunkSize];
+    }
+
+    void releaseChunks(size_type keep) noexcept
+    {
+        while (_chunks.size() > keep)
+        {
+            allocator_traits::deallocate(_allocator, _chunks.back(), ChunkSize);
+            _chunks.pop_back();
+        }
+    }
+
+    [[no_unique_address]] Allocator _allocator {};
+    std::vector<T*> _chunks;
+    size_type _head = 0; // index of the first element within the first chunk
+    size_type _size = 0;
+};
+
+template <typename T, typename Allocator>
+template <bool Const>
+class chunked_vector<T, Allocator>::basic_iterator
+{
+    using container = std::conditional_t<Const, chunked_vector const, chunked_vector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, T const*, T*>;
+    using reference = std::conditional_t<Const, T const&, T&>;
+
+    basic_iterator() = default;
+    basic_iterator(container* owner, difference_type index) noexcept: _owner { owner }, _index { index } {}
+
+    template <bool OtherConst>
+        requires(Const && !OtherConst)
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    basic_iterator(basic_iterator<OtherConst> const& other) noexcept:
+        _owner { other._owner }, _index { other._index }
+    {
+    }
+
+    [[nodiscard]] difference_type index() const noexcept { return _index; }
+
+    reference operator*() const noexcept { return (*_owner)[static_cast<size_type>(_index)]; }
+    pointer operator->() const noexcept { return &**this; }
+    reference operator[](difference_type n) const noexcept
+    {
+        return (*_owner)[static_cast<size_type>(_index + n)];
+    }
+
+    basic_iterator& operator++() noexcept
+    {
+        ++_index;
+        return *this;
+    }
+    basic_iterator operator++(int) noexcept { return basic_iterator { _owner, _index++ }; }
+    basic_iterator& operator--() noexcept
+    {
+        --_index;
+        return *this;
+    }
+    basic_iterator operator--(int) noexcept { return basic_iterator { _owner, _index-- }; }
+
+    basic_iterator& operator+=(difference_type n) noexcept
+    {
+        _index += n;
+        return *this;
+    }
+    basic_iterator& operator-=(difference_type n) noexcept
+    {
+        _index -= n;
+        return *this;
+    }
+
+    friend basic_iterator operator+(basic_iterator i, difference_type n) noexcept { return i += n; }
+    friend basic_iterator operator+(difference_type n, basic_iterator i) noexcept { return i += n; }
+    friend basic_iterator operator-(basic_iterator i, difference_type n) noexcept { return i -= n; }
+    friend difference_type operator-(basic_iterator const& a, basic_iterator const& b) noexcept
+    {
+        return a._index - b._index;
+    }
+
+    friend bool operator==(basic_iterator const& a, basic_iterator const& b) noexcept
+    {
+        return a._index == b._index;
+    }
+    friend auto operator<=>(basic_iterator const& a, basic_iterator const& b) noexcept
+    {
+        return a._index <=> b._index;
+    }
+
+  private:
+    friend class basic_iterator<!Const>;
+
+    container* _owner = nullptr;
+    difference_type _index = 0;
+};
+
+} // namespace crispy
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/chunked_vector.h>
+#include <crispy/ring.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+using crispy::chunked_ring;
+using crispy::chunked_vector;
+
+namespace
+{
+
+constexpr auto ChunkSize = chunked_vector<std::string>::ChunkSize;
+
+} // namespace
+
+TEST_CASE("chunked_vector.emplace_back")
+{
+    auto v = chunked_vector<std::string> {};
+    for (size_t i = 0; i < 3 * ChunkSize; ++i)
+        v.emplace_back(std::to_string(i));
+
+    REQUIRE(v.size() == 3 * ChunkSize);
+    CHECK(v.front() == "0");
+    CHECK(v[ChunkSize] == std::to_string(ChunkSize));
+    CHECK(v.back() == std::to_string((3 * ChunkSize) - 1));
+}
+
+TEST_CASE("chunked_vector.stable_addresses")
+{
+    auto v = chunked_vector<std::string> {};
+    auto const* const first = &v.emplace_back("first");
+    for (size_t i = 0; i < 4 * ChunkSize; ++i)
+        v.emplace_back();
+    CHECK(&v.front() == first);
+    CHECK(v.front() == "first");
+}
+
+TEST_CASE("chunked_vector.pop_front")
+{
+    auto v = chunked_vector<std::string> {};
+    for (size_t i = 0; i < 2 * ChunkSize; ++i)
+        v.emplace_back(std::to_string(i));
+
+    // Popping a whole chunk releases it.
+    auto const capacity = v.capacity();
+    for (size_t i = 0; i < ChunkSize; ++i)
+        v.pop_front();
+    CHECK(v.size() == ChunkSize);
+    CHECK(v.capacity() == capacity - ChunkSize);
+    CHECK(v.front() == std::to_string(ChunkSize));
+
+    // Appending after popping reuses the room left in the last chunk first.
+    v.pop_front();
+    v.emplace_back("last");
+    CHECK(v.size() == ChunkSize);
+    CHECK(v.back() == "last");
+    CHECK(v.front() == std::to_string(ChunkSize + 1));
+}
+
+TEST_CASE("chunked_vector.erase")
+{
+    auto v = chunked_vector<int> {};
+    for (auto i = 0; i < 10; ++i)
+        v.push_back(i);
+
+    v.erase(std::next(v.begin(), 2), std::next(v.begin(), 5));
+    CHECK(std::vector<int>(v.begin(), v.end()) == std::vector { 0, 1, 5, 6, 7, 8, 9 });
+
+    v.erase(v.begin());
+    CHECK(std::vector<int>(v.begin(), v.end()) == std::vector { 1, 5, 6, 7, 8, 9 });
+}
+
+TEST_CASE("chunked_vector.resize")
+{
+    auto v = chunked_vector<int>(3, 7);
+    v.resize(ChunkSize + 1);
+    CHECK(v.size() == ChunkSize + 1);
+    CHECK(v[2] == 7);
+    CHECK(v[3] == 0);
+
+    v.resize(2);
+    v.shrink_to_fit();
+    CHECK(v.size() == 2);
+    CHECK(v.capacity() == chunked_vector<int>::ChunkSize);
+}
+
+TEST_CASE("chunked_vector.copy_and_move")
+{
+    auto v = chunked_vector<std::string> {};
+    v.emplace_back("a");
+    v.emplace_back("b");
+
+    auto copy = v;
+    CHECK(copy.size() == 2);
+    CHECK(copy[1] == "b");
+
+    auto moved = std::move(copy);
+    CHECK(moved.size() == 2);
+    CHECK(copy.empty()); // NOLINT(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+}
+
+TEST_CASE("chunked_ring.rotate")
+{
+    auto r = chunked_ring<int> {};
+    for (auto i = 0; i < 5; ++i)
+        r.push_back(i);
+
+    r.rotate_left(2);
+    CHECK(r[0] == 2);
+    CHECK(r[-1] == 1);
+
+    r.rotate_right(3);
+    CHECK(r[0] == 4);
+
+    r.rezero();
+    CHECK(r.zero_index() == 0);
+    CHECK(std::vector<int>(r.begin(), r.end()) == std::vector { 4, 0, 1, 2, 3 });
+
+    r.pop_front();
+    r.emplace_back(5);
+    CHECK(std::vector<int>(r.begin(), r.end()) == std::vector { 0, 1, 2, 3, 5 });
+}
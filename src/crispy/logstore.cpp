@@ -1,9 +1,177 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <crispy/logstore.h>
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <thread>
+
 namespace logstore
 {
 
+namespace detail
+{
+    /// Writes the messages of an asynchronous sink from a background thread.
+    ///
+    /// Messages are copied into a bounded queue of preallocated slots, which any number of threads
+    /// may push to without locking, and which only the background thread pops from.
+    /// Each slot carries a sequence number, telling whether it is free to be written for a given
+    /// queue position, or ready to be read for it.
+    class async_writer
+    {
+      public:
+        async_writer(sink::writer const& writer, size_t capacity):
+            _writer { writer },
+            _mask { std::bit_ceil(std::max(capacity, size_t { 2 })) - 1 },
+            _slots { std::make_unique<slot[]>(_mask + 1) }
+        {
+            for (size_t i = 0; i <= _mask; ++i)
+                _slots[i].sequence.store(i, std::memory_order_relaxed);
+            _thread = std::thread { [this]() { run(); } };
+        }
+
+        async_writer(async_writer const&) = delete;
+        async_writer(async_writer&&) = delete;
+        async_writer& operator=(async_writer const&) = delete;
+        async_writer& operator=(async_writer&&) = delete;
+
+        ~async_writer()
+        {
+            _stopping.store(true, std::memory_order_release);
+            signal();
+            _thread.join();
+        }
+
+        [[nodiscard]] size_t capacity() const noexcept { return _mask + 1; }
+        [[nodiscard]] uint64_t dropped() const noexcept { return _dropped.load(std::memory_order_relaxed); }
+
+        void push(std::string_view text) noexcept
+        {
+            auto position = _head.load(std::memory_order_relaxed);
+            slot* target = nullptr;
+            while (!target)
+            {
+                auto& candidate = _slots[position & _mask];
+                auto const sequence = candidate.sequence.load(std::memory_order_acquire);
+                if (sequence == position)
+                {
+                    if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        target = &candidate;
+                }
+                else if (sequence < position)
+                {
+                    // The slot still holds the message of the previous round, so the queue is full.
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                else
+                    position = _head.load(std::memory_order_relaxed);
+            }
+
+            target->length = copyTruncated(text, target->text);
+            target->sequence.store(position + 1, std::memory_order_release);
+            signal();
+        }
+
+        void flush()
+        {
+            auto const target = _head.load(std::memory_order_acquire);
+            for (auto written = _written.load(std::memory_order_acquire); written < target;
+                 written = _written.load(std::memory_order_acquire))
+                _written.wait(written, std::memory_order_acquire);
+        }
+
+      private:
+        struct slot
+        {
+            std::atomic<size_t> sequence;
+            size_t length = 0;
+            std::array<char, sink::AsyncMessageCapacity> text;
+        };
+
+        // Copies as much of the given text as fits into the slot, without splitting a UTF-8 sequence,
+        // marking truncated messages with an ellipsis and a line break.
+        static size_t copyTruncated(std::string_view text, std::array<char, sink::AsyncMessageCapacity>& out)
+        {
+            if (text.size() <= out.size())
+            {
+                std::memcpy(out.data(), text.data(), text.size());
+                return text.size();
+            }
+
+            constexpr auto Ellipsis = std::string_view { "...\n" };
+            auto length = out.size() - Ellipsis.size();
+            while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80)
+                --length;
+            std::memcpy(out.data(), text.data(), length);
+            std::memcpy(out.data() + length, Ellipsis.data(), Ellipsis.size());
+            return length + Ellipsis.size();
+        }
+
+        void signal() noexcept
+        {
+            _signal.fetch_add(1, std::memory_order_release);
+            _signal.notify_one();
+        }
+
+        // Writes all messages that are ready, in queue order.
+        bool drain()
+        {
+            auto const start = _tail;
+            for (;;)
+            {
+                auto& next = _slots[_tail & _mask];
+                if (next.sequence.load(std::memory_order_acquire) != _tail + 1)
+                    break;
+                _writer(std::string_view(next.text.data(), next.length));
+                next.sequence.store(_tail + _mask + 1, std::memory_order_release);
+                ++_tail;
+            }
+
+            if (auto const dropped = _dropped.load(std::memory_order_relaxed); dropped != _reportedDrops)
+            {
+                _writer(std::format("[logstore] Dropped {} messages logged faster than written.\n",
+                                    dropped - _reportedDrops));
+                _reportedDrops = dropped;
+            }
+
+            if (_tail == start)
+                return false;
+            _written.store(_tail, std::memory_order_release);
+            _written.notify_all();
+            return true;
+        }
+
+        void run()
+        {
+            for (;;)
+            {
+                auto const signalled = _signal.load(std::memory_order_acquire);
+                if (drain())
+                    continue;
+                if (_stopping.load(std::memory_order_acquire))
+                    break;
+                _signal.wait(signalled, std::memory_order_acquire);
+            }
+            drain();
+        }
+
+        sink::writer const& _writer;
+        size_t const _mask;
+        std::unique_ptr<slot[]> _slots;
+
+        alignas(64) std::atomic<size_t> _head = 0; // next position to push to
+        alignas(64) std::atomic<uint32_t> _signal = 0;
+        std::atomic<uint64_t> _dropped = 0;
+        alignas(64) std::atomic<size_t> _written = 0; // positions up to which messages have been written
+        std::atomic<bool> _stopping = false;
+        size_t _tail = 0; // next position to pop from, owned by the background thread
+        uint64_t _reportedDrops = 0;
+        std::thread _thread;
+    };
+} // namespace detail
+
 sink::sink(bool enabled, writer wr): _enabled { enabled }, _writer { std::move(wr) }
 {
 }
@@ -24,6 +192,40 @@ sink::sink(bool enabled, std::shared_ptr<std::ostream> f):
 {
 }
 
+sink::~sink() = default;
+
+void sink::set_writer(writer writer)
+{
+    auto const asyncCapacity = _async ? _async->capacity() : 0;
+    _async.reset();
+    _writer = std::move(writer);
+    if (asyncCapacity)
+        _async = std::make_unique<detail::async_writer>(_writer, asyncCapacity);
+}
+
+void sink::set_async(bool enabled, size_t capacity)
+{
+    _async.reset();
+    if (enabled)
+        _async = std::make_unique<detail::async_writer>(_writer, capacity);
+}
+
+uint64_t sink::dropped_messages() const noexcept
+{
+    return _async ? _async->dropped() : 0;
+}
+
+void sink::flush()
+{
+    if (_async)
+        _async->flush();
+}
+
+void sink::write_async(std::string_view text)
+{
+    _async->push(text);
+}
+
 sink& sink::console()
 {
     static auto instance = sink(false, std::cout);
@@ -7,7 +7,9 @@
 #include <gsl/pointers>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <format>
 #include <functional>
 #include <iostream>
@@ -40,6 +42,11 @@ namespace logstore
 class category;
 class sink;
 
+namespace detail
+{
+    class async_writer;
+}
+
 class source_location_custom
 {
   public:
@@ -93,11 +100,7 @@ class message_builder
     }
 
     template <typename... Ts>
-    message_builder& append(std::string_view fmt, Ts const&... args)
-    {
-        _buffer += std::vformat(fmt, std::make_format_args(args...));
-        return *this;
-    }
+    message_builder& append(std::string_view fmt, Ts const&... args);
 
     message_builder& operator()(std::string const& msg)
     {
@@ -105,12 +108,11 @@ class message_builder
         return *this;
     }
 
+    /// Appends the formatted message, unless the category is disabled.
+    ///
+    /// The arguments are evaluated regardless, which LOGSTORE_LOG() avoids.
     template <typename... Ts>
-    message_builder& operator()(std::string_view fmt, Ts const&... args)
-    {
-        _buffer += std::vformat(fmt, std::make_format_args(args...));
-        return *this;
-    }
+    message_builder& operator()(std::string_view fmt, Ts const&... args);
 
     [[nodiscard]] std::string message() const;
 
@@ -145,9 +147,16 @@ class category
     [[nodiscard]] std::string_view name() const noexcept { return _name; }
     [[nodiscard]] std::string_view description() const noexcept { return _description; }
 
-    [[nodiscard]] bool is_enabled() const noexcept { return _state == state::Enabled; }
-    void enable(bool enabled = true) noexcept { _state = enabled ? state::Enabled : state::Disabled; }
-    void disable() noexcept { _state = state::Disabled; }
+    // The state is atomic, so that categories can be toggled at runtime while other threads log.
+    [[nodiscard]] bool is_enabled() const noexcept
+    {
+        return _state.load(std::memory_order_relaxed) == state::Enabled;
+    }
+    void enable(bool enabled = true) noexcept
+    {
+        _state.store(enabled ? state::Enabled : state::Disabled, std::memory_order_relaxed);
+    }
+    void disable() noexcept { enable(false); }
 
     [[nodiscard]] bool visible() const noexcept { return _visibility == visibility::Public; }
     void set_visible(bool visible) { _visibility = visible ? visibility::Public : visibility::Hidden; }
@@ -175,7 +184,7 @@ class category
   private:
     std::string_view _name;
     std::string_view _description;
-    state _state;
+    std::atomic<state> _state;
     visibility _visibility;
     formatter _formatter;
     std::reference_wrapper<logstore::sink> _sink;
@@ -184,14 +193,28 @@ class category
 /// Logging sink API.
 ///
 /// Such as the console, a log file, or UDP endpoint.
+///
+/// A sink writes messages synchronously from the logging thread, unless it is made asynchronous,
+/// in which case they are queued without locking and written from a background thread instead.
 class sink
 {
   public:
     using writer = std::function<void(std::string_view const&)>;
 
+    /// Number of messages an asynchronous sink queues by default, before dropping further ones.
+    static constexpr size_t DefaultAsyncCapacity = 4096;
+
+    /// Number of bytes of a message an asynchronous sink queues at most, truncating longer ones.
+    static constexpr size_t AsyncMessageCapacity = 1024;
+
     sink(bool enabled, writer writer);
     sink(bool enabled, std::ostream& output);
     sink(bool enabled, std::shared_ptr<std::ostream> f);
+    sink(sink const&) = delete;
+    sink(sink&&) = delete;
+    sink& operator=(sink const&) = delete;
+    sink& operator=(sink&&) = delete;
+    ~sink();
 
     void set_writer(writer writer);
 
@@ -200,13 +223,31 @@ class sink
 
     void set_enabled(bool enabled) { _enabled = enabled; }
 
+    /// Makes this sink write messages from a background thread, queuing up to @p capacity
+    /// messages (rounded up to a power of two), and dropping any further ones rather than waiting.
+    ///
+    /// Disabling it writes all queued messages before returning.
+    /// This must not be called while messages are written to this sink by other threads.
+    void set_async(bool enabled, size_t capacity = DefaultAsyncCapacity);
+
+    [[nodiscard]] bool is_async() const noexcept { return _async != nullptr; }
+
+    /// @returns the number of messages dropped so far, because the queue of this asynchronous sink was full.
+    [[nodiscard]] uint64_t dropped_messages() const noexcept;
+
+    /// Waits until all messages queued so far have been written, if this sink is asynchronous.
+    void flush();
+
     /// Retrieves reference to standard debug-logging sink.
     static sink& console();
     static sink& error_console(); // NOLINT(readability-identifier-naming)
 
   private:
+    void write_async(std::string_view text);
+
     bool _enabled;
     writer _writer;
+    std::unique_ptr<detail::async_writer> _async; // must be destroyed before _writer
 };
 
 std::vector<std::reference_wrapper<category>>& get();
@@ -215,6 +256,16 @@ void set_sink(sink& sink);
 void set_formatter(category::formatter const& f);
 void enable(std::string_view categoryName, bool enabled = true);
 void disable(std::string_view categoryName);
+
+/// Tests whether the given category name matches a glob pattern, in which '*' matches any sequence
+/// of characters and '?' matches any single character.
+[[nodiscard]] bool glob_match(std::string_view pattern, std::string_view name) noexcept;
+
+/// Enables exactly those categories matching the given comma separated list of glob patterns,
+/// except for those matching a pattern prefixed with '-', such as "vt.*,-vt.renderbuffer".
+/// A list of only excluding patterns enables all other categories, and "all" enables all of them.
+///
+/// This may be called at any time, also while other threads are logging.
 void configure(std::string_view filterString);
 
 // {{{ implementation
@@ -268,27 +319,66 @@ inline void disable(std::string_view categoryName)
     enable(categoryName, false);
 }
 
+inline bool glob_match(std::string_view pattern, std::string_view name) noexcept
+{
+    // Backtracks to the most recent '*' on mismatch, letting it match one more character.
+    auto p = size_t { 0 };
+    auto n = size_t { 0 };
+    auto star = std::string_view::npos;
+    auto starMatchEnd = size_t { 0 };
+    while (n < name.size())
+    {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+        {
+            ++p;
+            ++n;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            starMatchEnd = n;
+        }
+        else if (star != std::string_view::npos)
+        {
+            p = star + 1;
+            n = ++starMatchEnd;
+        }
+        else
+            return false;
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+    return p == pattern.size();
+}
+
 inline void configure(std::string_view filterString)
 {
     if (filterString == "all")
     {
         for (auto& category: logstore::get())
             category.get().enable();
+        return;
     }
-    else
+
+    auto const filters = crispy::split(filterString, ',');
+    auto const isExclusion = [](std::string_view filter) {
+        return filter.starts_with('-');
+    };
+    auto const hasInclusions = crispy::any_of(
+        filters, [&](std::string_view filter) { return !filter.empty() && !isExclusion(filter); });
+    for (auto& category: logstore::get())
     {
-        auto const filters = crispy::split(filterString, ',');
-        for (auto& category: logstore::get())
+        auto const name = category.get().name();
+        auto included = !hasInclusions;
+        auto excluded = false;
+        for (std::string_view const filter: filters)
         {
-            category.get().enable(crispy::any_of(filters, [&](std::string_view filterPattern) -> bool {
-                if (filterPattern.back() != '*')
-                    return category.get().name() == filterPattern;
-                // TODO: '*' excludes hidden categories
-                return std::equal(std::begin(filterPattern),
-                                  std::prev(end(filterPattern)),
-                                  std::begin(category.get().name()));
-            }));
+            if (isExclusion(filter))
+                excluded = excluded || glob_match(filter.substr(1), name);
+            else if (!filter.empty()) // TODO: '*' excludes hidden categories
+                included = included || glob_match(filter, name);
         }
+        category.get().enable(included && !excluded);
     }
 }
 
@@ -297,6 +387,22 @@ inline message_builder::message_builder(logstore::category const& cat, source_lo
 {
 }
 
+template <typename... Ts>
+message_builder& message_builder::append(std::string_view fmt, Ts const&... args)
+{
+    if (_category->is_enabled())
+        _buffer += std::vformat(fmt, std::make_format_args(args...));
+    return *this;
+}
+
+template <typename... Ts>
+message_builder& message_builder::operator()(std::string_view fmt, Ts const&... args)
+{
+    if (_category->is_enabled())
+        _buffer += std::vformat(fmt, std::make_format_args(args...));
+    return *this;
+}
+
 inline message_builder::~message_builder()
 {
     _category->sink().write(*this);
@@ -339,13 +445,13 @@ inline std::string category::defaultFormatter(message_builder const& message)
 
 inline void sink::write(message_builder const& message)
 {
-    if (_enabled && message.get_category().is_enabled())
-        _writer(message.message());
-}
+    if (!_enabled || !message.get_category().is_enabled())
+        return;
 
-inline void sink::set_writer(writer writer)
-{
-    _writer = std::move(writer);
+    if (_async)
+        write_async(message.message());
+    else
+        _writer(message.message());
 }
 // }}}
 
@@ -354,3 +460,15 @@ auto inline errorLog = logstore::category("error", "Error Logger", category::sta
 #define errorLog() (::logstore::errorLog())
 
 } // namespace logstore
+
+/// Logs a message to the given category, such as
+/// `LOGSTORE_LOG(inputLog, "Sending raw input: {}", crispy::escape(text))`.
+///
+/// Unlike `category()(...)`, the message arguments are not evaluated at all unless the category
+/// is enabled, so that logging to a disabled category costs a single relaxed atomic load.
+#define LOGSTORE_LOG(category, ...)                                                                \
+    do                                                                                             \
+    {                                                                                              \
+        if (auto const& logstoreCategory = (category); logstoreCategory.is_enabled()) [[unlikely]] \
+            logstoreCategory()(__VA_ARGS__);                                                       \
+    } while (false)
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/logstore.h>
+#include <crispy/utils.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <format>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST_CASE("logstore.async_sink")
+{
+    auto written = std::vector<std::string> {};
+    auto sink = logstore::sink(true, [&](std::string_view text) { written.emplace_back(text); });
+    auto category = logstore::category("test.async", "Test", logstore::category::state::Enabled);
+    category.set_sink(sink);
+
+    sink.set_async(true);
+    CHECK(sink.is_async());
+
+    auto threads = std::vector<std::thread> {};
+    for (auto t = 0; t < 4; ++t)
+        threads.emplace_back([&category, t]() {
+            for (auto i = 0; i < 100; ++i)
+                category()("{}:{}", t, i);
+        });
+    for (auto& thread: threads)
+        thread.join();
+
+    sink.flush();
+    CHECK(written.size() == 400);
+    CHECK(sink.dropped_messages() == 0);
+
+    // Messages of each thread are written in the order they were logged.
+    auto next = std::vector<int>(4, 0);
+    for (auto const& text: written)
+    {
+        auto const t = text[0] - '0';
+        CHECK(text == std::format("{}:{}\n", t, next.at(t)++));
+    }
+
+    // Messages longer than a slot get truncated.
+    written.clear();
+    category()(std::string(2 * logstore::sink::AsyncMessageCapacity, 'x'));
+    sink.set_async(false);
+    REQUIRE(written.size() == 1);
+    CHECK(written[0].size() == logstore::sink::AsyncMessageCapacity);
+    CHECK(written[0].ends_with("...\n"));
+}
+
+TEST_CASE("logstore.async_sink.overflow")
+{
+    auto released = std::atomic<bool> { false };
+    auto written = std::vector<std::string> {};
+    auto sink = logstore::sink(true, [&](std::string_view text) {
+        released.wait(false);
+        written.emplace_back(text);
+    });
+    auto category = logstore::category("test.async.overflow", "Test", logstore::category::state::Enabled);
+    category.set_sink(sink);
+    sink.set_async(true, 4);
+
+    // The writer is blocked while at most one message is taken out of the queue, so the queue is full
+    // with the next four of them and all others get dropped.
+    for (auto i = 0; i < 10; ++i)
+        category()("message {}", i);
+    auto const dropped = sink.dropped_messages();
+    CHECK((dropped == 5 || dropped == 6));
+
+    released = true;
+    released.notify_all();
+    sink.flush();
+    sink.set_async(false);
+    REQUIRE(written.size() == 10 - dropped + 1);
+    CHECK(written.front() == "message 0\n");
+    CHECK(written.back() == std::format("[logstore] Dropped {} messages logged faster than written.\n",
+                                        dropped));
+}
+
+TEST_CASE("logstore.glob_match")
+{
+    CHECK(logstore::glob_match("vt.*", "vt.session"));
+    CHECK(logstore::glob_match("vt*", "vt"));
+    CHECK(logstore::glob_match("*.input", "pty.input"));
+    CHECK(logstore::glob_match("p?y.*", "pty.output"));
+    CHECK(logstore::glob_match("gui.*.x", "gui.a.b.x"));
+    CHECK_FALSE(logstore::glob_match("vt.*", "vtx"));
+    CHECK_FALSE(logstore::glob_match("*.input", "pty.inputs"));
+    CHECK_FALSE(logstore::glob_match("pty", "pty.input"));
+}
+
+TEST_CASE("logstore.configure")
+{
+    auto const first = logstore::category("test.configure.first", "Test");
+    auto const second = logstore::category("test.configure.second", "Test");
+    auto const other = logstore::category("test.other", "Test");
+
+    // Configuring applies to all categories, so restore theirs afterwards.
+    auto saved = std::vector<std::pair<logstore::category*, bool>> {};
+    for (auto& category: logstore::get())
+        saved.emplace_back(&category.get(), category.get().is_enabled());
+    auto const _ = crispy::finally { [&]() {
+        for (auto const& [category, enabled]: saved)
+            category->enable(enabled);
+    } };
+
+    logstore::configure("test.configure.*");
+    CHECK(first.is_enabled());
+    CHECK(second.is_enabled());
+    CHECK_FALSE(other.is_enabled());
+
+    logstore::configure("test.*,-*.second");
+    CHECK(first.is_enabled());
+    CHECK_FALSE(second.is_enabled());
+    CHECK(other.is_enabled());
+
+    logstore::configure("-test.configure.*");
+    CHECK_FALSE(first.is_enabled());
+    CHECK(other.is_enabled());
+
+    logstore::configure("test.other");
+    CHECK_FALSE(first.is_enabled());
+    CHECK(other.is_enabled());
+}
+
+TEST_CASE("logstore.LOGSTORE_LOG")
+{
+    auto written = std::vector<std::string> {};
+    auto sink = logstore::sink(true, [&](std::string_view text) { written.emplace_back(text); });
+    auto category = logstore::category("test.macro", "Test");
+    category.set_sink(sink);
+
+    auto evaluations = 0;
+    auto const argument = [&]() {
+        ++evaluations;
+        return 42;
+    };
+
+    LOGSTORE_LOG(category, "value {}", argument());
+    CHECK(evaluations == 0);
+    CHECK(written.empty());
+
+    category.enable();
+    LOGSTORE_LOG(category, "value {}", argument());
+    CHECK(evaluations == 1);
+    REQUIRE(written.size() == 1);
+    CHECK(written[0] == "value 42\n");
+}
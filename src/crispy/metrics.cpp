@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/metrics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+namespace crispy::metrics
+{
+
+namespace
+{
+    std::string formatNumber(double value)
+    {
+        if (std::isnan(value))
+            return "NaN";
+        if (std::isinf(value))
+            return value > 0 ? "+Inf" : "-Inf";
+        // Integral values, such as counters, are written without exponent.
+        if (value == std::trunc(value) && std::abs(value) < 9007199254740992.0)
+            return std::format("{}", static_cast<int64_t>(value));
+        return std::format("{}", value);
+    }
+
+    std::string formatJsonNumber(double value)
+    {
+        return std::isfinite(value) ? formatNumber(value) : "null";
+    }
+
+    enum class escaping
+    {
+        help,  // Prometheus help text
+        label, // Prometheus label value
+        json,  // JSON string
+    };
+
+    void appendEscaped(std::string& output, std::string_view text, escaping mode)
+    {
+        for (auto const ch: text)
+        {
+            switch (ch)
+            {
+                case '\\': output += "\\\\"; break;
+                case '\n': output += "\\n"; break;
+                case '"': output += mode == escaping::help ? "\"" : "\\\""; break;
+                default:
+                    if (mode == escaping::json && static_cast<unsigned char>(ch) < 0x20)
+                        output += std::format("\\u{:04x}", static_cast<unsigned>(ch));
+                    else
+                        output += ch;
+                    break;
+            }
+        }
+    }
+
+    // Writes the labels in Prometheus syntax, including the braces, if there are any.
+    void appendLabels(std::string& output, labels const& sampleLabels, std::string_view le = {})
+    {
+        if (sampleLabels.empty() && le.empty())
+            return;
+
+        output += '{';
+        auto first = true;
+        for (auto const& [name, value]: sampleLabels)
+        {
+            if (!first)
+                output += ',';
+            first = false;
+            output += name;
+            output += "=\"";
+            appendEscaped(output, value, escaping::label);
+            output += '"';
+        }
+        if (!le.empty())
+        {
+            if (!first)
+                output += ',';
+            output += "le=\"";
+            output += le;
+            output += '"';
+        }
+        output += '}';
+    }
+} // namespace
+
+// {{{ histogram
+histogram::histogram(std::vector<double> upperBounds):
+    _upperBounds { std::move(upperBounds) },
+    _counts { std::make_unique<std::atomic<uint64_t>[]>(_upperBounds.size() + 1) }
+{
+}
+
+void histogram::observe(double value) noexcept
+{
+    auto const bucket = std::ranges::lower_bound(_upperBounds, value) - _upperBounds.begin();
+    _counts[static_cast<size_t>(bucket)].fetch_add(1, std::memory_order_relaxed);
+
+    auto sum = _sum.load(std::memory_order_relaxed);
+    while (!_sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+        ;
+}
+
+histogram::values histogram::read() const
+{
+    auto result = values { .upperBounds = _upperBounds, .counts = {}, .sum = _sum.load() };
+    result.counts.reserve(_upperBounds.size() + 1);
+    auto total = uint64_t { 0 };
+    for (size_t i = 0; i <= _upperBounds.size(); ++i)
+    {
+        total += _counts[i].load(std::memory_order_relaxed);
+        result.counts.push_back(total);
+    }
+    return result;
+}
+// }}}
+
+// {{{ sink
+void sink::counter(std::string_view name, std::string_view help, double value, labels sampleLabels)
+{
+    add(name, help, type::counter, sample { .sampleLabels = std::move(sampleLabels), .value = value });
+}
+
+void sink::gauge(std::string_view name, std::string_view help, double value, labels sampleLabels)
+{
+    add(name, help, type::gauge, sample { .sampleLabels = std::move(sampleLabels), .value = value });
+}
+
+void sink::histogram(std::string_view name,
+                     std::string_view help,
+                     metrics::histogram::values values,
+                     labels sampleLabels)
+{
+    add(name,
+        help,
+        type::histogram,
+        sample {
+            .sampleLabels = std::move(sampleLabels),
+            .value = 0.0,
+            .histogramValues = std::move(values),
+        });
+}
+
+void sink::add(std::string_view name, std::string_view help, type metricType, sample value)
+{
+    auto i = std::ranges::find(_metrics, name, &metric::name);
+    if (i == _metrics.end())
+        i = _metrics.insert(_metrics.end(),
+                            metric {
+                                .name = std::string(name),
+                                .help = std::string(help),
+                                .metricType = metricType,
+                                .samples = {},
+                            });
+    i->samples.emplace_back(std::move(value));
+}
+
+std::string sink::prometheus() const
+{
+    auto output = std::string {};
+    for (auto const& metric: _metrics)
+    {
+        output += std::format("# HELP {} ", metric.name);
+        appendEscaped(output, metric.help, escaping::help);
+        output += '\n';
+
+        switch (metric.metricType)
+        {
+            case type::counter: output += std::format("# TYPE {} counter\n", metric.name); break;
+            case type::gauge: output += std::format("# TYPE {} gauge\n", metric.name); break;
+            case type::histogram: output += std::format("# TYPE {} histogram\n", metric.name); break;
+        }
+
+        for (auto const& sample: metric.samples)
+        {
+            if (metric.metricType != type::histogram)
+            {
+                output += metric.name;
+                appendLabels(output, sample.sampleLabels);
+                output += std::format(" {}\n", formatNumber(sample.value));
+                continue;
+            }
+
+            auto const& values = sample.histogramValues;
+            for (size_t i = 0; i < values.counts.size(); ++i)
+            {
+                output += metric.name;
+                output += "_bucket";
+                appendLabels(output,
+                             sample.sampleLabels,
+                             i < values.upperBounds.size() ? formatNumber(values.upperBounds[i]) : "+Inf");
+                output += std::format(" {}\n", values.counts[i]);
+            }
+            output += metric.name + "_sum";
+            appendLabels(output, sample.sampleLabels);
+            output += std::format(" {}\n", formatNumber(values.sum));
+            output += metric.name + "_count";
+            appendLabels(output, sample.sampleLabels);
+            output += std::format(" {}\n", values.counts.empty() ? 0 : values.counts.back());
+        }
+    }
+    return output;
+}
+
+std::string sink::json() const
+{
+    auto output = std::string { "{\"metrics\":[" };
+    for (auto const& metric: _metrics)
+    {
+        if (&metric != &_metrics.front())
+            output += ',';
+        output += std::format("{{\"name\":\"{}\",\"help\":\"", metric.name);
+        appendEscaped(output, metric.help, escaping::json);
+        switch (metric.metricType)
+        {
+            case type::counter: output += "\",\"type\":\"counter\",\"samples\":["; break;
+            case type::gauge: output += "\",\"type\":\"gauge\",\"samples\":["; break;
+            case type::histogram: output += "\",\"type\":\"histogram\",\"samples\":["; break;
+        }
+
+        for (auto const& sample: metric.samples)
+        {
+            if (&sample != &metric.samples.front())
+                output += ',';
+            output += "{\"labels\":{";
+            for (auto const& [name, value]: sample.sampleLabels)
+            {
+                if (&name != &sample.sampleLabels.front().first)
+                    output += ',';
+                output += '"';
+                appendEscaped(output, name, escaping::json);
+                output += "\":\"";
+                appendEscaped(output, value, escaping::json);
+                output += '"';
+            }
+            output += '}';
+
+            if (metric.metricType != type::histogram)
+            {
+                output += std::format(",\"value\":{}}}", formatJsonNumber(sample.value));
+                continue;
+            }
+
+            auto const& values = sample.histogramValues;
+            output += ",\"buckets\":[";
+            for (size_t i = 0; i < values.counts.size(); ++i)
+            {
+                if (i)
+                    output += ',';
+                output += std::format("{{\"le\":{},\"count\":{}}}",
+                                      i < values.upperBounds.size() ? formatJsonNumber(values.upperBounds[i])
+                                                                    : "\"+Inf\"",
+                                      values.counts[i]);
+            }
+            output += std::format("],\"sum\":{},\"count\":{}}}",
+                                  formatJsonNumber(values.sum),
+                                  values.counts.empty() ? 0 : values.counts.back());
+        }
+        output += "]}";
+    }
+    output += "]}";
+    return output;
+}
+// }}}
+
+// {{{ registry
+void registry::registration::reset() noexcept
+{
+    if (!_owner)
+        return;
+
+    auto const lock = std::scoped_lock { _owner->_mutex };
+    _owner->_collectors.erase(_id);
+    _owner = nullptr;
+}
+
+registry::registration registry::add(collector newCollector)
+{
+    auto const lock = std::scoped_lock { _mutex };
+    auto const id = _nextId++;
+    _collectors.emplace(id, std::move(newCollector));
+    return registration { *this, id };
+}
+
+sink registry::collect() const
+{
+    // The mutex is held while collecting, so that no collector is unregistered while running.
+    auto const lock = std::scoped_lock { _mutex };
+    auto output = sink {};
+    for (auto const& [id, collector]: _collectors)
+        collector(output);
+    return output;
+}
+// }}}
+
+} // namespace crispy::metrics
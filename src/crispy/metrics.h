@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Registry of metrics, to be exported in the Prometheus text format or as JSON on demand.
+///
+/// Metrics are not stored in the registry, but gathered from its collectors whenever they are
+/// exported, so that the counters they are read from need not be more than plain members
+/// of whatever they count, and nothing is computed unless someone asks for it.
+namespace crispy::metrics
+{
+
+/// Label names and values of a sample, e.g. {{"session", "1"}}.
+using labels = std::vector<std::pair<std::string, std::string>>;
+
+/// Histogram with fixed bucket bounds, which may be observed into from any thread without locking.
+class histogram
+{
+  public:
+    /// Bucket counts and totals of a histogram at one point in time.
+    struct values
+    {
+        std::vector<double> upperBounds; ///< Upper bounds of all buckets but the last, in ascending order.
+        std::vector<uint64_t> counts;    ///< Cumulative counts by bucket, the last one counting all.
+        double sum = 0.0;
+    };
+
+    /// @p upperBounds  upper bounds (inclusive) of all buckets but the last, in ascending order.
+    ///                 The last bucket counts everything greater.
+    explicit histogram(std::vector<double> upperBounds);
+
+    void observe(double value) noexcept;
+
+    [[nodiscard]] values read() const;
+
+  private:
+    std::vector<double> _upperBounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> _counts; // by bucket, not cumulative
+    std::atomic<double> _sum = 0.0;
+};
+
+/// Receives the values of all metrics while they are being exported.
+///
+/// Samples of the same name form one metric, of which only the first help text and type are kept.
+class sink
+{
+  public:
+    void counter(std::string_view name, std::string_view help, double value, labels sampleLabels = {});
+    void gauge(std::string_view name, std::string_view help, double value, labels sampleLabels = {});
+    void histogram(std::string_view name,
+                   std::string_view help,
+                   metrics::histogram::values values,
+                   labels sampleLabels = {});
+
+    /// @returns the metrics in the Prometheus text exposition format.
+    [[nodiscard]] std::string prometheus() const;
+
+    /// @returns the metrics as a JSON object.
+    [[nodiscard]] std::string json() const;
+
+  private:
+    enum class type
+    {
+        counter,
+        gauge,
+        histogram,
+    };
+
+    struct sample
+    {
+        labels sampleLabels;
+        double value = 0.0;
+        metrics::histogram::values histogramValues {}; // only for histograms
+    };
+
+    struct metric
+    {
+        std::string name;
+        std::string help;
+        type metricType;
+        std::vector<sample> samples;
+    };
+
+    void add(std::string_view name, std::string_view help, type metricType, sample value);
+
+    std::vector<metric> _metrics; // in order of their first sample
+};
+
+/// Set of collectors, each contributing metrics whenever they are exported.
+///
+/// All members may be invoked from any thread.
+class registry
+{
+  public:
+    using collector = std::function<void(sink&)>;
+
+    /// Keeps a collector registered for as long as it lives.
+    ///
+    /// It must not be destroyed while holding any lock the collector acquires, as it waits for
+    /// the collecting of metrics to finish.
+    class registration
+    {
+      public:
+        registration() = default;
+        registration(registry& owner, uint64_t id) noexcept: _owner { &owner }, _id { id } {}
+        registration(registration const&) = delete;
+        registration(registration&& other) noexcept:
+            _owner { std::exchange(other._owner, nullptr) }, _id { other._id }
+        {
+        }
+        registration& operator=(registration const&) = delete;
+        registration& operator=(registration&& other) noexcept
+        {
+            reset();
+            _owner = std::exchange(other._owner, nullptr);
+            _id = other._id;
+            return *this;
+        }
+        ~registration() { reset(); }
+
+        /// Unregisters the collector.
+        void reset() noexcept;
+
+      private:
+        registry* _owner = nullptr;
+        uint64_t _id = 0;
+    };
+
+    [[nodiscard]] registration add(collector newCollector);
+
+    /// Gathers the current values of all metrics.
+    [[nodiscard]] sink collect() const;
+
+  private:
+    mutable std::mutex _mutex;
+    std::map<uint64_t, collector> _collectors; // by registration ID, i.e. in order of registration
+    uint64_t _nextId = 1;
+};
+
+} // namespace crispy::metrics
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/metrics.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+using namespace crispy::metrics;
+
+TEST_CASE("metrics.histogram")
+{
+    auto h = histogram { { 1.0, 10.0 } };
+    h.observe(0.5);
+    h.observe(1.0);
+    h.observe(5.0);
+    h.observe(100.0);
+
+    auto const values = h.read();
+    CHECK(values.upperBounds == std::vector<double> { 1.0, 10.0 });
+    CHECK(values.counts == std::vector<uint64_t> { 2, 3, 4 });
+    CHECK(values.sum == 106.5);
+}
+
+TEST_CASE("metrics.prometheus")
+{
+    auto output = sink {};
+    output.counter("parsed_bytes_total", "Bytes parsed.", 42, { { "session", "1" } });
+    output.gauge("sessions", "Open sessions.", 2);
+    output.counter("parsed_bytes_total", "Ignored.", 7, { { "session", "a\"b" } });
+
+    CHECK(output.prometheus()
+          == "# HELP parsed_bytes_total Bytes parsed.\n"
+             "# TYPE parsed_bytes_total counter\n"
+             "parsed_bytes_total{session=\"1\"} 42\n"
+             "parsed_bytes_total{session=\"a\\\"b\"} 7\n"
+             "# HELP sessions Open sessions.\n"
+             "# TYPE sessions gauge\n"
+             "sessions 2\n");
+}
+
+TEST_CASE("metrics.prometheus_histogram")
+{
+    auto h = histogram { { 0.5 } };
+    h.observe(0.25);
+    h.observe(2);
+
+    auto output = sink {};
+    output.histogram("latency_seconds", "Latency.", h.read(), { { "display", "0" } });
+    CHECK(output.prometheus()
+          == "# HELP latency_seconds Latency.\n"
+             "# TYPE latency_seconds histogram\n"
+             "latency_seconds_bucket{display=\"0\",le=\"0.5\"} 1\n"
+             "latency_seconds_bucket{display=\"0\",le=\"+Inf\"} 2\n"
+             "latency_seconds_sum{display=\"0\"} 2.25\n"
+             "latency_seconds_count{display=\"0\"} 2\n");
+}
+
+TEST_CASE("metrics.json")
+{
+    auto h = histogram { { 0.5 } };
+    h.observe(1);
+
+    auto output = sink {};
+    output.gauge("memory_bytes", "Memory \"used\".", 1024, { { "session", "1" } });
+    output.histogram("latency_seconds", "Latency.", h.read());
+    CHECK(output.json()
+          == "{\"metrics\":["
+             "{\"name\":\"memory_bytes\",\"help\":\"Memory \\\"used\\\".\",\"type\":\"gauge\",\"samples\":["
+             "{\"labels\":{\"session\":\"1\"},\"value\":1024}]},"
+             "{\"name\":\"latency_seconds\",\"help\":\"Latency.\",\"type\":\"histogram\",\"samples\":["
+             "{\"labels\":{},\"buckets\":[{\"le\":0.5,\"count\":0},{\"le\":\"+Inf\",\"count\":1}],"
+             "\"sum\":1,\"count\":1}]}"
+             "]}");
+}
+
+TEST_CASE("metrics.registry")
+{
+    auto metrics = registry {};
+    auto counter = 0;
+    auto first = metrics.add([&](sink& output) { output.counter("first_total", "First.", ++counter); });
+    {
+        auto second = metrics.add([](sink& output) { output.gauge("second", "Second.", 1); });
+        CHECK(metrics.collect().prometheus().find("second 1\n") != std::string::npos);
+    }
+
+    auto const output = metrics.collect().prometheus();
+    CHECK(output.find("first_total 2\n") != std::string::npos);
+    CHECK(output.find("second") == std::string::npos);
+
+    first.reset();
+    CHECK(metrics.collect().prometheus().empty());
+}
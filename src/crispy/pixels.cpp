@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/pixels.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_AMD64)
+    #include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+#endif
+
+namespace crispy::pixels
+{
+
+namespace
+{
+    /// Adds the @p count bytes at @p row to the sums at @p sums.
+    void accumulate(uint8_t const* row, uint32_t* sums, size_t count) noexcept
+    {
+        size_t i = 0;
+#if defined(__x86_64__) || defined(_M_AMD64)
+        auto const zero = _mm_setzero_si128();
+        auto const add = [](uint32_t* s, __m128i values) {
+            auto* const p = reinterpret_cast<__m128i*>(s);
+            _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), values));
+        };
+        for (; i + 16 <= count; i += 16)
+        {
+            auto const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + i));
+            auto const low = _mm_unpacklo_epi8(bytes, zero);
+            auto const high = _mm_unpackhi_epi8(bytes, zero);
+            add(sums + i, _mm_unpacklo_epi16(low, zero));
+            add(sums + i + 4, _mm_unpackhi_epi16(low, zero));
+            add(sums + i + 8, _mm_unpacklo_epi16(high, zero));
+            add(sums + i + 12, _mm_unpackhi_epi16(high, zero));
+        }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        for (; i + 16 <= count; i += 16)
+        {
+            auto const bytes = vld1q_u8(row + i);
+            auto const low = vmovl_u8(vget_low_u8(bytes));
+            auto const high = vmovl_u8(vget_high_u8(bytes));
+            vst1q_u32(sums + i, vaddw_u16(vld1q_u32(sums + i), vget_low_u16(low)));
+            vst1q_u32(sums + i + 4, vaddw_u16(vld1q_u32(sums + i + 4), vget_high_u16(low)));
+            vst1q_u32(sums + i + 8, vaddw_u16(vld1q_u32(sums + i + 8), vget_low_u16(high)));
+            vst1q_u32(sums + i + 12, vaddw_u16(vld1q_u32(sums + i + 12), vget_high_u16(high)));
+        }
+#endif
+        for (; i < count; ++i)
+            sums[i] += row[i];
+    }
+} // namespace
+
+void swapRedBlue(uint8_t const* source, uint8_t* target, size_t count) noexcept
+{
+    size_t i = 0;
+#if defined(__x86_64__) || defined(_M_AMD64)
+    // Each pixel read as little endian 32-bit integer, the first and third components are swapped
+    // by shifting them into each other's place.
+    auto const keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+    auto const lowest = _mm_set1_epi32(0xFF);
+    for (; i + 4 <= count; i += 4)
+    {
+        auto const values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + (i * 4)));
+        auto const swapped = _mm_or_si128(
+            _mm_and_si128(values, keep),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(values, 16), lowest),
+                         _mm_slli_epi32(_mm_and_si128(values, lowest), 16)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + (i * 4)), swapped);
+    }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    for (; i + 16 <= count; i += 16)
+    {
+        auto values = vld4q_u8(source + (i * 4));
+        std::swap(values.val[0], values.val[2]);
+        vst4q_u8(target + (i * 4), values);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        auto const* s = source + (i * 4);
+        auto* t = target + (i * 4);
+        auto const first = s[0];
+        t[0] = s[2];
+        t[1] = s[1];
+        t[2] = first;
+        t[3] = s[3];
+    }
+}
+
+void downsampleBox(uint8_t const* source,
+                   size_t sourceWidth,
+                   size_t sourceHeight,
+                   size_t components,
+                   uint8_t* target,
+                   size_t targetWidth,
+                   size_t targetHeight,
+                   size_t factor)
+{
+    auto const sourcePitch = sourceWidth * components;
+    auto const targetPitch = targetWidth * components;
+
+    // The rows of a block are summed up column by column first, then each block's columns.
+    auto columnSums = std::vector<uint32_t>(sourcePitch);
+    for (size_t y = 0; y < targetHeight; ++y)
+    {
+        auto* const targetRow = target + (y * targetPitch);
+        auto const firstRow = std::min(y * factor, sourceHeight);
+        auto const lastRow = std::min(firstRow + factor, sourceHeight);
+
+        std::ranges::fill(columnSums, 0);
+        for (auto row = firstRow; row < lastRow; ++row)
+            accumulate(source + (row * sourcePitch), columnSums.data(), sourcePitch);
+
+        for (size_t x = 0; x < targetWidth; ++x)
+        {
+            auto const firstColumn = std::min(x * factor, sourceWidth);
+            auto const lastColumn = std::min(firstColumn + factor, sourceWidth);
+            auto const count = static_cast<uint32_t>((lastRow - firstRow) * (lastColumn - firstColumn));
+            for (size_t k = 0; k < components; ++k)
+            {
+                auto total = uint32_t { 0 };
+                for (auto column = firstColumn; column < lastColumn; ++column)
+                    total += columnSums[(column * components) + k];
+                targetRow[(x * components) + k] = count ? static_cast<uint8_t>(total / count) : 0;
+            }
+        }
+    }
+}
+
+} // namespace crispy::pixels
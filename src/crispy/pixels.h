@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Kernels for post-processing rasterized glyph and image bitmaps, whose pixels are stored
+/// row by row without padding, each of one or more 8-bit components.
+///
+/// The kernels use SSE2 (x86-64) resp. NEON (ARM64) instructions for the bulk of the pixels.
+namespace crispy::pixels
+{
+
+/// Copies @p count pixels of four components each from @p source to @p target,
+/// swapping their first and third components, e.g. converting BGRA to RGBA.
+///
+/// @p source and @p target may be the same, but must not overlap otherwise.
+void swapRedBlue(uint8_t const* source, uint8_t* target, size_t count) noexcept;
+
+/// Downsamples the bitmap at @p source into the one at @p target, each target pixel being the
+/// average of the block of @p factor x @p factor source pixels at the same position times @p factor.
+///
+/// Blocks reaching beyond the source bitmap are averaged over the pixels within it,
+/// and target pixels whose block is entirely outside of it are set to zero.
+void downsampleBox(uint8_t const* source,
+                   size_t sourceWidth,
+                   size_t sourceHeight,
+                   size_t components,
+                   uint8_t* target,
+                   size_t targetWidth,
+                   size_t targetHeight,
+                   size_t factor);
+
+} // namespace crispy::pixels
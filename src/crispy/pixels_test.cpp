@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/pixels.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace crispy;
+
+namespace
+{
+
+std::vector<uint8_t> makeBitmap(size_t size)
+{
+    auto bitmap = std::vector<uint8_t>(size);
+    for (size_t i = 0; i < size; ++i)
+        bitmap[i] = static_cast<uint8_t>((i * 37) % 256);
+    return bitmap;
+}
+
+// Straightforward area average of each block, for comparison.
+std::vector<uint8_t> downsampleNaively(std::vector<uint8_t> const& source,
+                                       size_t width,
+                                       size_t height,
+                                       size_t components,
+                                       size_t targetWidth,
+                                       size_t targetHeight,
+                                       size_t factor)
+{
+    auto target = std::vector<uint8_t>(targetWidth * targetHeight * components);
+    for (size_t y = 0; y < targetHeight; ++y)
+        for (size_t x = 0; x < targetWidth; ++x)
+            for (size_t k = 0; k < components; ++k)
+            {
+                auto total = 0u;
+                auto count = 0u;
+                for (auto sy = y * factor; sy < std::min((y + 1) * factor, height); ++sy)
+                    for (auto sx = x * factor; sx < std::min((x + 1) * factor, width); ++sx, ++count)
+                        total += source[(((sy * width) + sx) * components) + k];
+                target[(((y * targetWidth) + x) * components) + k] =
+                    count ? static_cast<uint8_t>(total / count) : 0;
+            }
+    return target;
+}
+
+} // namespace
+
+TEST_CASE("pixels.swapRedBlue", "[pixels]")
+{
+    // Long enough for every SIMD code path, and for the pixel-wise one to convert what is left.
+    for (auto const count: { 1, 4, 15, 16, 17, 37 })
+    {
+        INFO("count: " << count);
+        auto const source = makeBitmap(static_cast<size_t>(count) * 4);
+        auto target = std::vector<uint8_t>(source.size());
+        pixels::swapRedBlue(source.data(), target.data(), static_cast<size_t>(count));
+        for (size_t i = 0; i < source.size(); i += 4)
+        {
+            CHECK(target[i] == source[i + 2]);
+            CHECK(target[i + 1] == source[i + 1]);
+            CHECK(target[i + 2] == source[i]);
+            CHECK(target[i + 3] == source[i + 3]);
+        }
+
+        // In place.
+        auto inPlace = source;
+        pixels::swapRedBlue(inPlace.data(), inPlace.data(), static_cast<size_t>(count));
+        CHECK(inPlace == target);
+    }
+}
+
+TEST_CASE("pixels.downsampleBox", "[pixels]")
+{
+    auto const source = std::vector<uint8_t> { 0, 10, 20, 30, 40, 50, 60, 70, //
+                                               0, 10, 20, 30, 40, 50, 60, 70 };
+    auto target = std::vector<uint8_t>(2);
+    pixels::downsampleBox(source.data(), 4, 2, 2, target.data(), 1, 1, 2);
+    CHECK(target == std::vector<uint8_t> { 10, 20 });
+
+    // A color emoji of 136x128 pixels fit into a cell of 20 pixels.
+    for (auto const components: { 1u, 3u, 4u })
+    {
+        INFO("components: " << components);
+        auto const bitmap = makeBitmap(136 * 128 * components);
+        auto scaled = std::vector<uint8_t>(19 * 18 * components);
+        pixels::downsampleBox(bitmap.data(), 136, 128, components, scaled.data(), 19, 18, 7);
+        CHECK(scaled == downsampleNaively(bitmap, 136, 128, components, 19, 18, 7));
+    }
+}
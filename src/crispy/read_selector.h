@@ -172,6 +172,10 @@ class epoll_read_selector
     [[nodiscard]] size_t size() const noexcept;
 
     void wakeup() const noexcept;
+
+    /// @returns the epoll file descriptor, which is readable whenever any of the file descriptors is.
+    [[nodiscard]] int native_handle() const noexcept { return _epollFd.get(); }
+
     std::optional<int> wait_one(std::optional<std::chrono::milliseconds> timeout = std::nullopt) noexcept;
 
   private:
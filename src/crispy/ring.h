@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <crispy/chunked_vector.h>
+
 #include <gsl/span>
 #include <gsl/span_ext>
 
@@ -176,12 +178,29 @@ class ring: public basic_ring<T, Container<T, Allocator>> // NOLINT(readability-
     }
 
     void pop_front() { this->_storage.erase(this->_storage.begin()); }
+
+    /// Removes the elements at the offsets [first, last), keeping all others in order.
+    ///
+    /// The ring is rezeroed, so that these offsets are those of the storage.
+    void erase(size_t first, size_t last)
+    {
+        this->rezero();
+        this->_storage.erase(std::next(this->_storage.begin(), static_cast<std::ptrdiff_t>(first)),
+                             std::next(this->_storage.begin(), static_cast<std::ptrdiff_t>(last)));
+    }
+
+    void shrink_to_fit() { this->_storage.shrink_to_fit(); }
 };
 
 /// Fixed-size basic_ring<T> implementation
 template <typename T, std::size_t N>
 using fixed_size_ring = basic_ring<T, std::array<T, N>>;
 
+/// ring<T> over chunked storage, which grows without moving any of its elements in memory,
+/// and whose pop_front() is O(1).
+template <typename T>
+using chunked_ring = ring<T, chunked_vector>;
+
 // {{{ iterator
 template <typename T, typename Vector>
 struct ring_iterator
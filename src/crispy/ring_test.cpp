@@ -162,3 +162,19 @@ TEST_CASE("ring.offset_negative")
     REQUIRE(r[-2] == 'b');
     REQUIRE(r[-3] == 'a');
 }
+
+TEST_CASE("ring.erase")
+{
+    ring<char> r;
+    for (auto const c: { 'a', 'b', 'c', 'd', 'e' })
+        r.emplace_back(c);
+    r.rotate_left(2);
+    REQUIRE(r[0] == 'c');
+
+    r.erase(1, 3);
+    REQUIRE(r.size() == 3);
+    CHECK(r[0] == 'c');
+    CHECK(r[1] == 'a');
+    CHECK(r[2] == 'b');
+    CHECK(r[-1] == 'b');
+}
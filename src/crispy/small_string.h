@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace crispy
+{
+
+/**
+ * String with an inline storage of N bytes, spilling over to the heap only beyond that.
+ *
+ * Once spilled, the heap storage is kept across clear() calls, so that a long-lived
+ * instance being refilled over and over again does not repeatedly allocate.
+ * Copies only allocate if the copied contents do not fit into the inline storage.
+ */
+template <size_t N>
+class small_string // NOLINT(readability-identifier-naming)
+{
+  public:
+    using value_type = char;
+    using size_type = size_t;
+    using iterator = char*;
+    using const_iterator = char const*;
+
+    static constexpr size_type npos = std::string_view::npos; // NOLINT(readability-identifier-naming)
+
+    small_string() noexcept = default;
+    small_string(std::string_view text) { append(text); } // NOLINT(google-explicit-constructor)
+
+    small_string(small_string const& other) { append(other.view()); }
+    small_string(small_string&& other) noexcept:
+        _inline { other._inline },
+        _size { other._size },
+        _spilled { other._spilled },
+        _heap { std::move(other._heap) }
+    {
+        other.clear();
+    }
+
+    small_string& operator=(small_string const& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            append(other.view());
+        }
+        return *this;
+    }
+
+    small_string& operator=(small_string&& other) noexcept
+    {
+        if (this != &other)
+        {
+            _inline = other._inline;
+            _size = other._size;
+            _spilled = other._spilled;
+            _heap = std::move(other._heap);
+            other.clear();
+        }
+        return *this;
+    }
+
+    ~small_string() = default;
+
+    [[nodiscard]] constexpr static size_type inlineCapacity() noexcept { return N; }
+    [[nodiscard]] bool isInline() const noexcept { return !_spilled; }
+
+    /// @returns the number of bytes of heap storage held, which is retained across clear().
+    [[nodiscard]] size_type heapCapacity() const noexcept { return _heap.capacity(); }
+
+    [[nodiscard]] size_type size() const noexcept { return _spilled ? _heap.size() : _size; }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    [[nodiscard]] char* data() noexcept { return _spilled ? _heap.data() : _inline.data(); }
+    [[nodiscard]] char const* data() const noexcept { return _spilled ? _heap.data() : _inline.data(); }
+
+    [[nodiscard]] iterator begin() noexcept { return data(); }
+    [[nodiscard]] iterator end() noexcept { return data() + size(); }
+    [[nodiscard]] const_iterator begin() const noexcept { return data(); }
+    [[nodiscard]] const_iterator end() const noexcept { return data() + size(); }
+
+    [[nodiscard]] char& operator[](size_type i) noexcept
+    {
+        assert(i < size());
+        return data()[i];
+    }
+
+    [[nodiscard]] char operator[](size_type i) const noexcept
+    {
+        assert(i < size());
+        return data()[i];
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept { return { data(), size() }; }
+    operator std::string_view() const noexcept { return view(); } // NOLINT(google-explicit-constructor)
+
+    [[nodiscard]] bool operator==(std::string_view other) const noexcept { return view() == other; }
+
+    /// Clears the contents but retains any heap storage for later reuse.
+    void clear() noexcept
+    {
+        _size = 0;
+        _spilled = false;
+        _heap.clear();
+    }
+
+    void push_back(char ch) // NOLINT(readability-identifier-naming)
+    {
+        if (!_spilled && _size < N)
+            _inline[_size++] = ch;
+        else
+        {
+            spill();
+            _heap.push_back(ch);
+        }
+    }
+
+    void append(std::string_view text)
+    {
+        if (!_spilled && _size + text.size() <= N)
+        {
+            std::copy(text.begin(), text.end(), _inline.data() + _size);
+            _size += text.size();
+        }
+        else
+        {
+            spill();
+            _heap.append(text);
+        }
+    }
+
+    /// Erases up to @p count characters starting at @p pos.
+    void erase(size_type pos, size_type count = npos) noexcept
+    {
+        auto const currentSize = size();
+        assert(pos <= currentSize);
+        count = std::min(count, currentSize - pos);
+        if (_spilled)
+            _heap.erase(pos, count);
+        else
+        {
+            std::memmove(_inline.data() + pos, _inline.data() + pos + count, currentSize - pos - count);
+            _size -= count;
+        }
+    }
+
+  private:
+    void spill()
+    {
+        if (_spilled)
+            return;
+        _heap.assign(_inline.data(), _size);
+        _spilled = true;
+    }
+
+    std::array<char, N> _inline {};
+    size_type _size = 0;
+    bool _spilled = false;
+    std::string _heap;
+};
+
+} // namespace crispy
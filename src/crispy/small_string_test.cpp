@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/small_string.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+using namespace std::string_view_literals;
+
+TEST_CASE("small_string.inline")
+{
+    auto s = crispy::small_string<8> {};
+    CHECK(s.empty());
+    s.push_back('?');
+    s.append("1;2"sv);
+    CHECK(s.isInline());
+    CHECK(s == "?1;2"sv);
+    CHECK(s.size() == 4);
+    CHECK(s[0] == '?');
+
+    s.erase(0, 1);
+    CHECK(s == "1;2"sv);
+    CHECK(s.view().find(';') == 1);
+}
+
+TEST_CASE("small_string.spill")
+{
+    auto s = crispy::small_string<4> { "abc"sv };
+    REQUIRE(s.isInline());
+    s.append("defgh"sv);
+    CHECK_FALSE(s.isInline());
+    CHECK(s == "abcdefgh"sv);
+
+    s.erase(0, 3);
+    CHECK(s == "defgh"sv);
+
+    // Clearing returns to inline storage.
+    s.clear();
+    CHECK(s.empty());
+    CHECK(s.isInline());
+    s.push_back('x');
+    CHECK(s == "x"sv);
+}
+
+TEST_CASE("small_string.copy_and_move")
+{
+    auto const longText = std::string(32, 'A');
+    auto a = crispy::small_string<4> { longText };
+    auto b = a;
+    CHECK(b == longText);
+
+    auto c = std::move(b);
+    CHECK(c == longText);
+    CHECK(b.empty()); // NOLINT(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+
+    auto d = crispy::small_string<4> { "ab"sv };
+    d = a;
+    CHECK(d == longText);
+    d = crispy::small_string<4> { "xy"sv };
+    CHECK(d == "xy"sv);
+    CHECK(d.isInline());
+}
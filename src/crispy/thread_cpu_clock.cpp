@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/thread_cpu_clock.h>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+namespace crispy
+{
+
+thread_cpu_clock::time_point thread_cpu_clock::now() noexcept
+{
+#if defined(_WIN32)
+    auto creationTime = FILETIME {};
+    auto exitTime = FILETIME {};
+    auto kernelTime = FILETIME {};
+    auto userTime = FILETIME {};
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return time_point {};
+    auto const ticks = [](FILETIME const& t) {
+        return (static_cast<int64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    // FILETIME counts in units of 100 nanoseconds.
+    return time_point(duration((ticks(kernelTime) + ticks(userTime)) * 100));
+#else
+    auto value = timespec {};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &value) != 0)
+        return time_point {};
+    return time_point(std::chrono::seconds(value.tv_sec) + std::chrono::nanoseconds(value.tv_nsec));
+#endif
+}
+
+} // namespace crispy
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace crispy
+{
+
+/// Clock measuring the CPU time the calling thread has consumed, so that work can be accounted
+/// for by the CPU it takes, rather than by the time passing while it is done.
+struct thread_cpu_clock
+{
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<thread_cpu_clock>;
+    static constexpr bool is_steady = true;
+
+    /// @returns the CPU time consumed by the calling thread, or the epoch if it cannot be told.
+    [[nodiscard]] static time_point now() noexcept;
+};
+
+/// Adds the CPU time its thread consumes from its construction to its destruction to a total,
+/// in nanoseconds.
+class cpu_time_accumulator
+{
+  public:
+    explicit cpu_time_accumulator(std::atomic<int64_t>& total) noexcept:
+        _total { total }, _start { thread_cpu_clock::now() }
+    {
+    }
+
+    cpu_time_accumulator(cpu_time_accumulator const&) = delete;
+    cpu_time_accumulator(cpu_time_accumulator&&) = delete;
+    cpu_time_accumulator& operator=(cpu_time_accumulator const&) = delete;
+    cpu_time_accumulator& operator=(cpu_time_accumulator&&) = delete;
+
+    ~cpu_time_accumulator()
+    {
+        _total.fetch_add((thread_cpu_clock::now() - _start).count(), std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<int64_t>& _total;
+    thread_cpu_clock::time_point _start;
+};
+
+} // namespace crispy
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/thread_cpu_clock.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+void spin(std::chrono::steady_clock::duration duration)
+{
+    auto const end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+} // namespace
+
+TEST_CASE("thread_cpu_clock.now")
+{
+    auto const start = crispy::thread_cpu_clock::now();
+    spin(20ms);
+    auto const spun = crispy::thread_cpu_clock::now() - start;
+    CHECK(spun >= 5ms);
+
+    // Time spent waiting is no CPU time.
+    auto const beforeSleep = crispy::thread_cpu_clock::now();
+    std::this_thread::sleep_for(50ms);
+    CHECK(crispy::thread_cpu_clock::now() - beforeSleep < 25ms);
+}
+
+TEST_CASE("thread_cpu_clock.cpu_time_accumulator")
+{
+    auto total = std::atomic<int64_t> { 0 };
+    {
+        auto const _ = crispy::cpu_time_accumulator { total };
+        spin(10ms);
+    }
+    auto const first = total.load();
+    CHECK(first > 0);
+
+    {
+        auto const _ = crispy::cpu_time_accumulator { total };
+        spin(10ms);
+    }
+    CHECK(total.load() > first);
+}
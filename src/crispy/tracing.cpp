@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/tracing.h>
+
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace crispy::tracing
+{
+
+namespace
+{
+    struct event
+    {
+        char const* name;
+        char const* category;
+        clock::time_point start;
+        clock::time_point end;
+        std::optional<double> counterValue = std::nullopt; // set for counters, which are no zones
+    };
+
+    struct thread_buffer
+    {
+        uint64_t threadId;
+        std::mutex mutex; // only ever contended while tracing is being stopped
+        std::vector<event> events {};
+    };
+
+    struct session
+    {
+        std::mutex mutex;
+        std::filesystem::path path;
+        clock::time_point origin;
+        std::vector<std::shared_ptr<thread_buffer>> buffers;
+        uint64_t nextThreadId = 1;
+        std::atomic<uint64_t> generation = 0; // incremented with each start and stop
+    };
+
+    session& globalSession()
+    {
+        static auto instance = session {};
+        return instance;
+    }
+
+    thread_buffer* currentThreadBuffer()
+    {
+        thread_local auto buffer = std::shared_ptr<thread_buffer> {};
+        thread_local auto generation = uint64_t { 0 };
+
+        auto& s = globalSession();
+        if (generation != s.generation.load(std::memory_order_acquire))
+        {
+            auto const lock = std::scoped_lock { s.mutex };
+            if (!detail::enabled)
+                return nullptr;
+            buffer = std::make_shared<thread_buffer>(s.nextThreadId++);
+            s.buffers.emplace_back(buffer);
+            generation = s.generation;
+        }
+        return buffer.get();
+    }
+
+    void writeString(std::ostream& output, std::string_view text)
+    {
+        output << '"';
+        for (auto const ch: text)
+        {
+            if (ch == '"' || ch == '\\')
+                output << '\\';
+            output << ch;
+        }
+        output << '"';
+    }
+
+    double microseconds(clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    void recordEvent(event const& e) noexcept
+    {
+        try
+        {
+            auto* buffer = currentThreadBuffer();
+            if (!buffer)
+                return;
+
+            auto const lock = std::scoped_lock { buffer->mutex };
+            if (buffer->events.size() < MaxEventsPerThread)
+                buffer->events.emplace_back(e);
+        }
+        catch (...)
+        {
+            // Dropping an event is preferable to failing whatever is being traced.
+        }
+    }
+} // namespace
+
+void detail::record(char const* name,
+                    char const* category,
+                    clock::time_point start,
+                    clock::time_point end) noexcept
+{
+    recordEvent(event { .name = name, .category = category, .start = start, .end = end });
+}
+
+void detail::recordCounter(char const* name,
+                           char const* category,
+                           clock::time_point time,
+                           double value) noexcept
+{
+    recordEvent(
+        event { .name = name, .category = category, .start = time, .end = time, .counterValue = value });
+}
+
+bool start(std::filesystem::path path)
+{
+    auto& s = globalSession();
+    auto const lock = std::scoped_lock { s.mutex };
+    if (detail::enabled)
+        return false;
+
+    s.path = std::move(path);
+    s.origin = clock::now();
+    s.buffers.clear();
+    s.nextThreadId = 1;
+    ++s.generation;
+    detail::enabled = true;
+    return true;
+}
+
+bool stop()
+{
+    auto& s = globalSession();
+    auto buffers = std::vector<std::shared_ptr<thread_buffer>> {};
+    {
+        auto const lock = std::scoped_lock { s.mutex };
+        if (!detail::enabled)
+            return false;
+        detail::enabled = false;
+        ++s.generation;
+        buffers = std::move(s.buffers);
+    }
+
+    auto output = std::ofstream(s.path, std::ios::binary | std::ios::trunc);
+    if (!output.good())
+        return false;
+
+    output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    auto first = true;
+    for (auto const& buffer: buffers)
+    {
+        auto const lock = std::scoped_lock { buffer->mutex };
+        for (auto const& e: buffer->events)
+        {
+            output << (first ? "\n" : ",\n") << "{\"name\":";
+            writeString(output, e.name);
+            output << ",\"cat\":";
+            writeString(output, e.category);
+            if (e.counterValue)
+                output << std::format(
+                    ",\"ph\":\"C\",\"ts\":{:.3f},\"pid\":1,\"tid\":{},\"args\":{{\"value\":{}}}}}",
+                    microseconds(e.start - s.origin),
+                    buffer->threadId,
+                    *e.counterValue);
+            else
+                output << std::format(",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}",
+                                      microseconds(e.start - s.origin),
+                                      microseconds(e.end - e.start),
+                                      buffer->threadId);
+            first = false;
+        }
+    }
+    output << "\n]}\n";
+    output.close();
+    return output.good();
+}
+
+} // namespace crispy::tracing
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+/// Records timed zones of code, to be written as Chrome trace event JSON, which can be viewed
+/// in chrome://tracing or https://ui.perfetto.dev.
+///
+/// Tracing is started and stopped at runtime. While it is not started, a zone costs a single
+/// relaxed atomic load. Zones are recorded into buffers of their thread, so that recording does
+/// not contend across threads.
+namespace crispy::tracing
+{
+
+using clock = std::chrono::steady_clock;
+
+namespace detail
+{
+    inline std::atomic<bool> enabled = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+    void record(char const* name,
+                char const* category,
+                clock::time_point start,
+                clock::time_point end) noexcept;
+
+    void recordCounter(char const* name, char const* category, clock::time_point time, double value) noexcept;
+} // namespace detail
+
+/// Maximum number of zones recorded per thread, to bound the memory used by long traces.
+constexpr inline size_t MaxEventsPerThread = 1'000'000;
+
+[[nodiscard]] inline bool enabled() noexcept
+{
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+/// Starts recording zones, to be written to @p path once tracing is stopped.
+///
+/// @returns false if tracing has been started already.
+bool start(std::filesystem::path path);
+
+/// Stops recording zones and writes all recorded ones to the path given to start().
+///
+/// @returns false if tracing has not been started, or if the trace could not be written.
+bool stop();
+
+/// Records the value of a counter at this point in time, if tracing has been started, to be shown
+/// as a graph along the zones.
+///
+/// The name and category must outlive tracing, e.g. by being string literals.
+inline void counter(char const* name, double value, char const* category = "contour") noexcept
+{
+    if (enabled())
+        detail::recordCounter(name, category, clock::now(), value);
+}
+
+/// Records the time from its construction to its destruction as a zone, if tracing was started
+/// at construction.
+///
+/// The name and category must outlive tracing, e.g. by being string literals.
+class zone
+{
+  public:
+    explicit zone(char const* name, char const* category = "contour") noexcept:
+        _name { name }, _category { category }
+    {
+        if (enabled())
+            _start = clock::now();
+    }
+
+    zone(zone const&) = delete;
+    zone(zone&&) = delete;
+    zone& operator=(zone const&) = delete;
+    zone& operator=(zone&&) = delete;
+
+    ~zone()
+    {
+        if (_start != clock::time_point {})
+            detail::record(_name, _category, _start, clock::now());
+    }
+
+  private:
+    char const* _name;
+    char const* _category;
+    clock::time_point _start {};
+};
+
+} // namespace crispy::tracing
+
+#define CRISPY_TRACE_CONCAT_(a, b) a##b
+#define CRISPY_TRACE_CONCAT(a, b)  CRISPY_TRACE_CONCAT_(a, b)
+
+/// Traces the enclosing scope as a zone, given its name and optionally its category.
+#define CRISPY_TRACE_ZONE(...) \
+    ::crispy::tracing::zone const CRISPY_TRACE_CONCAT(crispyTraceZone, __LINE__) { __VA_ARGS__ }
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/tracing.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+std::string readTrace(std::filesystem::path const& path)
+{
+    auto input = std::ifstream(path);
+    auto text = std::stringstream {};
+    text << input.rdbuf();
+    return text.str();
+}
+
+size_t countOf(std::string const& text, std::string const& what)
+{
+    auto count = size_t { 0 };
+    for (auto i = text.find(what); i != std::string::npos; i = text.find(what, i + what.size()))
+        ++count;
+    return count;
+}
+
+} // namespace
+
+TEST_CASE("tracing.disabled")
+{
+    CHECK_FALSE(crispy::tracing::enabled());
+    CHECK_FALSE(crispy::tracing::stop());
+    {
+        CRISPY_TRACE_ZONE("ignored");
+    }
+    CHECK_FALSE(crispy::tracing::enabled());
+}
+
+TEST_CASE("tracing.zones")
+{
+    auto const path = std::filesystem::temp_directory_path() / "crispy_tracing_test.json";
+    REQUIRE(crispy::tracing::start(path));
+    CHECK(crispy::tracing::enabled());
+    CHECK_FALSE(crispy::tracing::start(path));
+
+    {
+        CRISPY_TRACE_ZONE("outer");
+        CRISPY_TRACE_ZONE("inner", "test");
+    }
+    std::thread { []() {
+        CRISPY_TRACE_ZONE("other \"thread\"");
+    } }.join();
+
+    REQUIRE(crispy::tracing::stop());
+    CHECK_FALSE(crispy::tracing::enabled());
+
+    {
+        CRISPY_TRACE_ZONE("after");
+    }
+
+    auto const trace = readTrace(path);
+    std::filesystem::remove(path);
+
+    CHECK(trace.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    CHECK(countOf(trace, "\"ph\":\"X\"") == 3);
+    CHECK(countOf(trace, "\"name\":\"outer\",\"cat\":\"contour\"") == 1);
+    CHECK(countOf(trace, "\"name\":\"inner\",\"cat\":\"test\"") == 1);
+    CHECK(countOf(trace, "\"name\":\"other \\\"thread\\\"\"") == 1);
+    CHECK(countOf(trace, "\"tid\":2") == 1);
+    CHECK(countOf(trace, "after") == 0);
+}
+
+TEST_CASE("tracing.counters")
+{
+    crispy::tracing::counter("ignored", 1.0);
+
+    auto const path = std::filesystem::temp_directory_path() / "crispy_tracing_counters_test.json";
+    REQUIRE(crispy::tracing::start(path));
+    crispy::tracing::counter("allocations", 42);
+    crispy::tracing::counter("bytes", 1.5, "test");
+    REQUIRE(crispy::tracing::stop());
+
+    auto const trace = readTrace(path);
+    std::filesystem::remove(path);
+
+    CHECK(countOf(trace, "\"ph\":\"C\"") == 2);
+    CHECK(countOf(trace, "\"name\":\"allocations\",\"cat\":\"contour\"") == 1);
+    CHECK(countOf(trace, "\"args\":{\"value\":42}") == 1);
+    CHECK(countOf(trace, "\"name\":\"bytes\",\"cat\":\"test\"") == 1);
+    CHECK(countOf(trace, "\"args\":{\"value\":1.5}") == 1);
+    CHECK(countOf(trace, "ignored") == 0);
+}
@@ -10,6 +10,16 @@
     #include <pthread.h>
 #endif
 
+#if defined(CONTOUR_BUILD_WITH_MIMALLOC) && __has_include(<mimalloc.h>)
+    #include <mimalloc.h>
+#elif defined(_WIN32)
+    #include <malloc.h>
+#elif defined(__APPLE__)
+    #include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+    #include <malloc.h>
+#endif
+
 #include <crispy/utils.h>
 
 namespace crispy
@@ -40,4 +50,17 @@ std::string threadName()
 #endif
 }
 
+void trimHeap() noexcept
+{
+#if defined(CONTOUR_BUILD_WITH_MIMALLOC) && __has_include(<mimalloc.h>)
+    mi_collect(true);
+#elif defined(_WIN32)
+    _heapmin();
+#elif defined(__APPLE__)
+    malloc_zone_pressure_relief(nullptr, 0);
+#elif defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
 } // namespace crispy
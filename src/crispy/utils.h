@@ -551,6 +551,12 @@ constexpr void ignore_unused(Ts... /*values*/) noexcept
 
 std::string threadName();
 
+/// Returns free heap memory to the operating system, as far as the allocator supports it.
+///
+/// Allocators keep freed memory around for reuse, so that the memory usage of a process
+/// otherwise stays at its peak, e.g. after a burst of output has been cleared.
+void trimHeap() noexcept;
+
 template <class... Ts>
 struct overloaded: Ts...
 {
@@ -3,7 +3,10 @@
 #include <text_shaper/font_locator.h>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <string>
+#include <unordered_map>
 
 // {{{ TODO: replace with libunicode
 #include <codecvt>
@@ -98,6 +101,13 @@ namespace
     {
         return pt * (96.0 / 72.0);
     }
+
+    // Number of glyphs rasterized at most by a single glyph run analysis.
+    constexpr size_t MaxGlyphRunLength = 64;
+
+    // Width of the tile each glyph of a batched glyph run is drawn into, in ems,
+    // which is wide enough for glyphs not to touch their neighbours.
+    constexpr double GlyphTileWidth = 3.0;
 } // namespace
 
 struct DxFontInfo
@@ -107,6 +117,9 @@ struct DxFontInfo
     font_metrics metrics;
     int fontUnitsPerEm;
 
+    // The file and face within it the font has been loaded from.
+    font_path source;
+
     // Owning pointer
     IDWriteFontFace5* fontFace;
 };
@@ -122,6 +135,11 @@ struct directwrite_shaper::Private
     std::unordered_map<font_key, DxFontInfo> fonts;
     std::unordered_map<font_key, bool> fontsHasColor;
 
+    // Rasterization state, created once rather than for every glyph.
+    ComPtr<IDWriteFactory2> factory2;
+    ComPtr<IDWriteRenderingParams> renderingParams;
+    std::unordered_map<font_key, DWRITE_RENDERING_MODE> renderingModes;
+
     font_key nextFontKey;
 
     Private(DPI dpi, font_locator& _locator): dpi_ { dpi }, locator_ { &_locator }
@@ -136,6 +154,125 @@ struct directwrite_shaper::Private
         wchar_t locale[LOCALE_NAME_MAX_LENGTH];
         GetUserDefaultLocaleName(locale, sizeof(locale));
         userLocale = locale;
+
+        factory.As(&factory2);
+        factory->CreateRenderingParams(&renderingParams);
+    }
+
+    DWRITE_RENDERING_MODE renderingMode(font_key _font, float _fontEmSize)
+    {
+        if (auto const i = renderingModes.find(_font); i != renderingModes.end())
+            return i->second;
+
+        auto mode = DWRITE_RENDERING_MODE {};
+        if (FAILED(fonts.at(_font).fontFace->GetRecommendedRenderingMode(
+                _fontEmSize,
+                pixelPerDip(),
+                DWRITE_MEASURING_MODE::DWRITE_MEASURING_MODE_NATURAL,
+                renderingParams.Get(),
+                &mode)))
+            mode = DWRITE_RENDERING_MODE_NATURAL_SYMMETRIC;
+        renderingModes.emplace(_font, mode);
+        return mode;
+    }
+
+    /// Rasterizes the monochrome glyphs at @p _indices of @p _glyphs, all of the same font,
+    /// by a single glyph run analysis and alpha texture, which is then sliced into one tile per glyph.
+    void rasterizeRun(gsl::span<glyph_key const> _glyphs,
+                      gsl::span<size_t const> _indices,
+                      vector<optional<rasterized_glyph>>& _results)
+    {
+        auto const& first = _glyphs[_indices[0]];
+        auto const fontEmSize = static_cast<float>(ptToEm(first.size.pt));
+        auto const tileWidth = static_cast<int>(std::ceil(fontEmSize * pixelPerDip() * GlyphTileWidth));
+
+        auto glyphIndices = vector<UINT16>(_indices.size());
+        for (size_t i = 0; i < _indices.size(); ++i)
+            glyphIndices[i] = static_cast<UINT16>(_glyphs[_indices[i]].index.value);
+        auto const glyphAdvance = static_cast<float>(tileWidth) / pixelPerDip();
+        auto const glyphAdvances = vector<float>(_indices.size(), glyphAdvance);
+        auto const glyphOffsets = vector<DWRITE_GLYPH_OFFSET>(_indices.size());
+
+        DWRITE_GLYPH_RUN glyphRun {};
+        glyphRun.fontEmSize = fontEmSize;
+        glyphRun.fontFace = fonts.at(first.font).fontFace;
+        glyphRun.glyphAdvances = glyphAdvances.data();
+        glyphRun.glyphCount = static_cast<UINT32>(_indices.size());
+        glyphRun.glyphIndices = glyphIndices.data();
+        glyphRun.glyphOffsets = glyphOffsets.data();
+        glyphRun.isSideways = false;
+        glyphRun.bidiLevel = 0;
+
+        // The run's origin is placed a third into the first tile, leaving room for negative bearings.
+        auto const originX = tileWidth / 3;
+        ComPtr<IDWriteGlyphRunAnalysis> glyphAnalysis;
+        if (FAILED(factory->CreateGlyphRunAnalysis(&glyphRun,
+                                                   pixelPerDip(),
+                                                   nullptr,
+                                                   renderingMode(first.font, fontEmSize),
+                                                   DWRITE_MEASURING_MODE::DWRITE_MEASURING_MODE_NATURAL,
+                                                   static_cast<float>(originX) / pixelPerDip(),
+                                                   0.0f,
+                                                   &glyphAnalysis)))
+            return;
+
+        RECT textureBounds {};
+        glyphAnalysis->GetAlphaTextureBounds(DWRITE_TEXTURE_CLEARTYPE_3x1, &textureBounds);
+        auto const textureWidth = static_cast<int>(textureBounds.right - textureBounds.left);
+        auto const textureHeight = static_cast<int>(textureBounds.bottom - textureBounds.top);
+
+        auto texture = vector<uint8_t>(static_cast<size_t>(std::max(textureWidth * textureHeight, 0)) * 3);
+        if (!texture.empty()
+            && FAILED(glyphAnalysis->CreateAlphaTexture(DWRITE_TEXTURE_CLEARTYPE_3x1,
+                                                        &textureBounds,
+                                                        texture.data(),
+                                                        static_cast<UINT32>(texture.size()))))
+            return;
+
+        auto const coverage = [&](int x, int y) {
+            auto const* pixel = &texture[static_cast<size_t>((y * textureWidth) + x) * 3];
+            return pixel[0] | pixel[1] | pixel[2];
+        };
+
+        for (size_t i = 0; i < _indices.size(); ++i)
+        {
+            // The tile of the glyph, in texture coordinates.
+            auto const glyphOriginX = originX + (static_cast<int>(i) * tileWidth);
+            auto const tileStart = glyphOriginX - originX - static_cast<int>(textureBounds.left);
+            auto const tileLeft = std::max(tileStart, 0);
+            auto const tileRight = std::min(tileStart + tileWidth, textureWidth);
+
+            auto left = tileRight;
+            auto right = tileLeft;
+            auto top = textureHeight;
+            auto bottom = 0;
+            for (auto y = 0; y < textureHeight; ++y)
+                for (auto x = tileLeft; x < tileRight; ++x)
+                    if (coverage(x, y))
+                    {
+                        left = std::min(left, x);
+                        right = std::max(right, x + 1);
+                        top = std::min(top, y);
+                        bottom = std::max(bottom, y + 1);
+                    }
+
+            auto output = rasterized_glyph {};
+            output.format = bitmap_format::rgb;
+            if (left < right)
+            {
+                output.bitmapSize.width = vtbackend::Width(right - left);
+                output.bitmapSize.height = vtbackend::Height(bottom - top);
+                output.position.x = left + static_cast<int>(textureBounds.left) - glyphOriginX;
+                output.position.y = -(top + static_cast<int>(textureBounds.top));
+                output.bitmap.reserve(static_cast<size_t>((right - left) * (bottom - top)) * 3);
+                for (auto y = top; y < bottom; ++y)
+                {
+                    auto const row = texture.begin() + (((y * textureWidth) + left) * 3);
+                    output.bitmap.insert(output.bitmap.end(), row, row + ((right - left) * 3));
+                }
+            }
+            _results[_indices[i]] = std::move(output);
+        }
     }
 
     font_key create_font_key()
@@ -172,8 +309,17 @@ struct directwrite_shaper::Private
         UINT32 numFaces {};
         IDWriteFontFace* fontFace {};
         fontFile->Analyze(&isSupported, &fileType, &fontFaceType, &numFaces);
-        hr = factory->CreateFontFace(
-            fontFaceType, 1, fontFile.GetAddressOf(), 0, DWRITE_FONT_SIMULATIONS_NONE, &fontFace);
+        if (sourcePath.collectionIndex < 0 || static_cast<UINT32>(sourcePath.collectionIndex) >= numFaces)
+        {
+            errorLog()("Font file {} has no face {}.", sourcePath.value, sourcePath.collectionIndex);
+            return nullopt;
+        }
+        hr = factory->CreateFontFace(fontFaceType,
+                                     1,
+                                     fontFile.GetAddressOf(),
+                                     static_cast<UINT32>(sourcePath.collectionIndex),
+                                     DWRITE_FONT_SIMULATIONS_NONE,
+                                     &fontFace);
         if (FAILED(hr))
         {
             return nullopt;
@@ -239,6 +385,7 @@ struct directwrite_shaper::Private
         fontInfo.metrics.advance = int(ceil(computeAverageAdvance(fontFace) * dipScalar));
 
         fontFace->QueryInterface(&fontInfo.fontFace);
+        fontInfo.source = sourcePath;
 
         auto key = create_font_key();
         fonts.emplace(pair { key, std::move(fontInfo) });
@@ -296,6 +443,66 @@ font_metrics directwrite_shaper::metrics(font_key _key) const
     return fontInfo.metrics;
 }
 
+std::optional<font_source> directwrite_shaper::source(font_key _key) const
+{
+    if (auto const i = d->fonts.find(_key); i != d->fonts.end())
+        return font_source { i->second.source };
+    return nullopt;
+}
+
+bool directwrite_shaper::has_ligatures(font_key _key) const
+{
+    auto const i = d->fonts.find(_key);
+    if (i == d->fonts.end())
+        return true;
+
+    // GSUB features substituting glyphs of adjacent codepoints that DirectWrite shapes with by default,
+    // which are the only ones applied, as text is shaped without any features of its own.
+    auto constexpr LigatureFeatures = std::array {
+        DWRITE_MAKE_OPENTYPE_TAG('l', 'i', 'g', 'a'),
+        DWRITE_MAKE_OPENTYPE_TAG('c', 'l', 'i', 'g'),
+        DWRITE_MAKE_OPENTYPE_TAG('c', 'a', 'l', 't'),
+        DWRITE_MAKE_OPENTYPE_TAG('r', 'l', 'i', 'g'),
+    };
+
+    void const* tableData {};
+    UINT32 tableSize {};
+    void* tableContext {};
+    BOOL exists {};
+    auto const hr = i->second.fontFace->TryGetFontTable(
+        DWRITE_MAKE_OPENTYPE_TAG('G', 'S', 'U', 'B'), &tableData, &tableSize, &tableContext, &exists);
+    if (FAILED(hr))
+        return true;
+    if (!exists)
+        return false;
+
+    // The table holds big-endian values, with the offset of its feature list at byte 6,
+    // which is its count of 6-byte records each starting with the feature's tag.
+    auto const* table = static_cast<uint8_t const*>(tableData);
+    auto const readU16 = [&](size_t offset) -> size_t {
+        return (size_t(table[offset]) << 8) | table[offset + 1];
+    };
+
+    auto result = false;
+    if (tableSize >= 8)
+    {
+        auto const featureList = readU16(6);
+        auto const featureCount = featureList + 2 <= tableSize ? readU16(featureList) : 0;
+        for (size_t k = 0; k < featureCount && !result; ++k)
+        {
+            auto const record = featureList + 2 + k * 6;
+            if (record + 6 > tableSize)
+                break;
+            auto const tag = DWRITE_MAKE_OPENTYPE_TAG(
+                table[record], table[record + 1], table[record + 2], table[record + 3]);
+            result = std::ranges::find(LigatureFeatures, tag) != LigatureFeatures.end();
+        }
+    }
+
+    i->second.fontFace->ReleaseFontTable(tableContext);
+    return result;
+}
+
 void directwrite_shaper::shape(font_key _font,
                                std::u32string_view _text,
                                gsl::span<unsigned> _clusters,
@@ -480,19 +687,7 @@ std::optional<rasterized_glyph> directwrite_shaper::rasterize(glyph_key _glyph,
     glyphRun.isSideways = false;
     glyphRun.bidiLevel = 0;
 
-    ComPtr<IDWriteRenderingParams> renderingParams;
-    d->factory->CreateRenderingParams(&renderingParams);
-
-    DWRITE_RENDERING_MODE renderingMode;
-    auto hr = fontFace->GetRecommendedRenderingMode(fontEmSize,
-                                                    d->pixelPerDip(),
-                                                    DWRITE_MEASURING_MODE::DWRITE_MEASURING_MODE_NATURAL,
-                                                    renderingParams.Get(),
-                                                    &renderingMode);
-    if (FAILED(hr))
-    {
-        renderingMode = DWRITE_RENDERING_MODE_NATURAL_SYMMETRIC;
-    }
+    auto const renderingMode = d->renderingMode(_glyph.font, fontEmSize);
 
     ComPtr<IDWriteGlyphRunAnalysis> glyphAnalysis;
     rasterized_glyph output {};
@@ -516,18 +711,17 @@ std::optional<rasterized_glyph> directwrite_shaper::rasterize(glyph_key _glyph,
 
     auto const [width, height] = output.bitmapSize;
 
-    IDWriteFactory2* factory2;
-    IDWriteColorGlyphRunEnumerator* glyphRunEnumerator;
-    if (SUCCEEDED(d->factory->QueryInterface(IID_PPV_ARGS(&factory2))))
+    ComPtr<IDWriteColorGlyphRunEnumerator> glyphRunEnumerator;
+    if (d->factory2)
     {
-        hr = factory2->TranslateColorGlyphRun(0.0f,
-                                              0.0f,
-                                              &glyphRun,
-                                              nullptr,
-                                              DWRITE_MEASURING_MODE::DWRITE_MEASURING_MODE_NATURAL,
-                                              nullptr,
-                                              0,
-                                              &glyphRunEnumerator);
+        auto hr = d->factory2->TranslateColorGlyphRun(0.0f,
+                                                      0.0f,
+                                                      &glyphRun,
+                                                      nullptr,
+                                                      DWRITE_MEASURING_MODE::DWRITE_MEASURING_MODE_NATURAL,
+                                                      nullptr,
+                                                      0,
+                                                      &glyphRunEnumerator);
 
         if (hr == DWRITE_E_NOCOLOR)
         {
@@ -583,6 +777,31 @@ std::optional<rasterized_glyph> directwrite_shaper::rasterize(glyph_key _glyph,
     return nullopt;
 }
 
+std::vector<std::optional<rasterized_glyph>> directwrite_shaper::rasterize_many(
+    gsl::span<glyph_key const> _glyphs, render_mode _mode)
+{
+    auto results = vector<optional<rasterized_glyph>>(_glyphs.size());
+
+    // Glyphs of color fonts are made of layers of runs of their own, and are thus rasterized one by one.
+    auto runs = std::unordered_map<font_key, vector<size_t>> {};
+    for (size_t i = 0; i < _glyphs.size(); ++i)
+    {
+        if (d->fonts.at(_glyphs[i].font).fontFace->IsColorFont())
+            results[i] = rasterize(_glyphs[i], _mode);
+        else
+            runs[_glyphs[i].font].emplace_back(i);
+    }
+
+    for (auto const& [font, indices]: runs)
+        for (size_t offset = 0; offset < indices.size(); offset += MaxGlyphRunLength)
+        {
+            auto const count = std::min(MaxGlyphRunLength, indices.size() - offset);
+            d->rasterizeRun(_glyphs, gsl::span(indices).subspan(offset, count), results);
+        }
+
+    return results;
+}
+
 void directwrite_shaper::set_dpi(DPI dpi)
 {
     d->dpi_ = dpi;
@@ -596,7 +815,7 @@ void directwrite_shaper::set_locator(font_locator& _locator)
 
 void directwrite_shaper::clear_cache()
 {
-    // TODO: clear the cache
+    d->renderingModes.clear();
 }
 
 optional<glyph_position> directwrite_shaper::shape(font_key _font, char32_t _codepoint)
@@ -5,6 +5,8 @@
 #include <text_shaper/shaper.h>
 
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace text
 {
@@ -26,6 +28,10 @@ class directwrite_shaper: public shaper
 
     font_metrics metrics(font_key _key) const override;
 
+    std::optional<font_source> source(font_key _key) const override;
+
+    bool has_ligatures(font_key _key) const override;
+
     void shape(font_key _font,
                std::u32string_view _text,
                gsl::span<unsigned> _clusters,
@@ -37,6 +43,9 @@ class directwrite_shaper: public shaper
 
     std::optional<rasterized_glyph> rasterize(glyph_key _glyph, render_mode _mode) override;
 
+    std::vector<std::optional<rasterized_glyph>> rasterize_many(gsl::span<glyph_key const> _glyphs,
+                                                                render_mode _mode) override;
+
   private:
     struct Private;
     std::unique_ptr<Private, void (*)(Private*)> d;
@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <text_shaper/font.h>
+#include <text_shaper/font_coverage.h>
+
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <variant>
+
+using std::nullopt;
+using std::optional;
+using std::string;
+using std::string_view;
+
+using namespace std::string_view_literals;
+
+namespace text
+{
+
+namespace
+{
+    auto constexpr FontCoverageCacheMagic = "contour-font-coverage-v1"sv;
+
+    string keyOf(font_source const& source)
+    {
+        if (auto const* path = std::get_if<font_path>(&source))
+            return std::format("file\t{}\t{}", path->collectionIndex, path->value);
+        return std::format("memory\t{}", std::get<font_memory_ref>(source).identifier);
+    }
+
+    // The size and modification time of the given font file, or nullopt if it cannot be read.
+    optional<std::pair<uintmax_t, int64_t>> fileStatusOf(string const& path)
+    {
+        auto ec = std::error_code {};
+        auto const fileSize = std::filesystem::file_size(path, ec);
+        if (ec)
+            return nullopt;
+        auto const lastWriteTime = std::filesystem::last_write_time(path, ec);
+        if (ec)
+            return nullopt;
+        return std::pair { fileSize, static_cast<int64_t>(lastWriteTime.time_since_epoch().count()) };
+    }
+
+    bool hasLineBreak(string_view text) noexcept
+    {
+        return text.find('\n') != string_view::npos;
+    }
+
+    template <typename T>
+    optional<T> parseNumber(string_view text, int base = 10)
+    {
+        auto value = T {};
+        auto const* const end = text.data() + text.size();
+        auto const [ptr, ec] = std::from_chars(text.data(), end, value, base);
+        if (ec != std::errc {} || ptr != end || text.empty())
+            return nullopt;
+        return value;
+    }
+
+    // Parses "first-last" (or just "first") in hexadecimal, as written by save().
+    optional<font_coverage::range> parseRange(string_view text)
+    {
+        auto const dash = text.find('-');
+        auto const first = parseNumber<uint32_t>(text.substr(0, dash), 16);
+        auto const last =
+            dash == string_view::npos ? first : parseNumber<uint32_t>(text.substr(dash + 1), 16);
+        if (!first || !last || *last < *first)
+            return nullopt;
+        return font_coverage::range { static_cast<char32_t>(*first), static_cast<char32_t>(*last) };
+    }
+
+    optional<font_coverage> parseRanges(string_view text)
+    {
+        auto coverage = font_coverage {};
+        while (!text.empty())
+        {
+            auto const space = text.find(' ');
+            auto const range = parseRange(text.substr(0, space));
+            if (!range)
+                return nullopt;
+            coverage.add(*range);
+            text.remove_prefix(space == string_view::npos ? text.size() : space + 1);
+        }
+        return coverage;
+    }
+} // namespace
+
+// {{{ font_coverage
+void font_coverage::add(char32_t codepoint)
+{
+    if (codepoint >= MaxCodepoint)
+        return;
+
+    if (_pageIndex.empty())
+        _pageIndex.resize(MaxCodepoint / PageSize, NoPage);
+
+    auto& page = _pageIndex[codepoint / PageSize];
+    if (page == NoPage)
+    {
+        page = static_cast<uint16_t>(_pages.size());
+        _pages.emplace_back();
+    }
+
+    auto const bit = codepoint % PageSize;
+    _pages[page][bit / 64] |= uint64_t { 1 } << (bit % 64);
+}
+
+void font_coverage::add(range codepoints)
+{
+    for (auto codepoint = codepoints.first; codepoint <= codepoints.second && codepoint < MaxCodepoint;
+         ++codepoint)
+        add(codepoint);
+}
+
+std::vector<font_coverage::range> font_coverage::ranges() const
+{
+    auto output = std::vector<range> {};
+    if (_pageIndex.empty())
+        return output;
+
+    for (char32_t block = 0; block < MaxCodepoint / PageSize; ++block)
+    {
+        if (_pageIndex[block] == NoPage)
+            continue;
+        for (char32_t codepoint = block * PageSize; codepoint < (block + 1) * PageSize; ++codepoint)
+        {
+            if (!contains(codepoint))
+                continue;
+            if (!output.empty() && output.back().second + 1 == codepoint)
+                output.back().second = codepoint;
+            else
+                output.emplace_back(codepoint, codepoint);
+        }
+    }
+    return output;
+}
+// }}}
+
+// {{{ font_coverage_cache
+font_coverage_cache::font_coverage_cache(std::filesystem::path cacheDirectory)
+{
+    if (!cacheDirectory.empty())
+        _cacheFilePath = std::move(cacheDirectory) / "font-coverage.cache";
+}
+
+font_coverage const* font_coverage_cache::find(font_source const& source)
+{
+    if (!_loaded)
+    {
+        _loaded = true;
+        load();
+    }
+
+    auto const i = _entries.find(keyOf(source));
+    if (i == _entries.end())
+        return nullptr;
+
+    // Revalidate lazily, i.e. only when the coverage is actually used.
+    if (auto const* path = std::get_if<font_path>(&source); path && !i->second.validated)
+    {
+        if (fileStatusOf(path->value) != std::pair { i->second.fileSize, i->second.fileTime })
+        {
+            locatorLog()("Dropping cached font coverage, as the font file has changed: {}", path->value);
+            _entries.erase(i);
+            return nullptr;
+        }
+        i->second.validated = true;
+    }
+
+    return &i->second.coverage;
+}
+
+font_coverage const& font_coverage_cache::insert(font_source const& source, font_coverage coverage)
+{
+    auto& cached = _entries[keyOf(source)];
+    cached = entry {};
+    cached.coverage = std::move(coverage);
+    cached.validated = true;
+
+    if (auto const* path = std::get_if<font_path>(&source))
+    {
+        if (auto const status = fileStatusOf(path->value))
+        {
+            cached.file = *path;
+            std::tie(cached.fileSize, cached.fileTime) = *status;
+            save();
+        }
+    }
+
+    return cached.coverage;
+}
+
+void font_coverage_cache::load()
+{
+    if (_cacheFilePath.empty())
+        return;
+
+    auto file = std::ifstream { _cacheFilePath };
+    if (!file.good())
+        return;
+
+    auto line = string {};
+    if (!std::getline(file, line) || line != FontCoverageCacheMagic)
+    {
+        locatorLog()("Ignoring outdated font coverage cache: {}", _cacheFilePath.string());
+        return;
+    }
+
+    // Each font is stored as two lines:
+    //     font <TAB> collection index <TAB> file size <TAB> modification time <TAB> path
+    //     ranges <TAB> first-last first-last ...
+    auto loaded = std::unordered_map<string, entry> {};
+    auto ranges = string {};
+    while (std::getline(file, line))
+    {
+        auto const malformed = [&]() {
+            errorLog()("Ignoring malformed font coverage cache: {}", _cacheFilePath.string());
+        };
+
+        auto fields = std::array<string_view, 4> {};
+        auto rest = string_view { line };
+        for (auto& field: fields)
+        {
+            auto const tab = rest.find('\t');
+            if (tab == string_view::npos)
+                return malformed();
+            field = rest.substr(0, tab);
+            rest.remove_prefix(tab + 1);
+        }
+
+        auto const collectionIndex = parseNumber<int>(fields[1]);
+        auto const fileSize = parseNumber<uintmax_t>(fields[2]);
+        auto const fileTime = parseNumber<int64_t>(fields[3]);
+        if (fields[0] != "font"sv || !collectionIndex || !fileSize || !fileTime
+            || !std::getline(file, ranges) || !ranges.starts_with("ranges\t"sv))
+            return malformed();
+
+        auto coverage = parseRanges(string_view { ranges }.substr(7));
+        if (!coverage)
+            return malformed();
+
+        auto path = font_path { .value = string(rest), .collectionIndex = *collectionIndex };
+        auto key = keyOf(path);
+        loaded[std::move(key)] = entry {
+            .coverage = std::move(*coverage),
+            .file = std::move(path),
+            .fileSize = *fileSize,
+            .fileTime = *fileTime,
+        };
+    }
+
+    locatorLog()("Loaded {} font coverages from cache: {}", loaded.size(), _cacheFilePath.string());
+
+    // Coverages recorded before loading take precedence, as they are up to date.
+    _entries.merge(loaded);
+}
+
+void font_coverage_cache::save() const
+{
+    if (_cacheFilePath.empty())
+        return;
+
+    auto ec = std::error_code {};
+    std::filesystem::create_directories(_cacheFilePath.parent_path(), ec);
+
+    // Write to a temporary file first, so that concurrently starting instances
+    // never read a partially written cache file.
+    auto const temporaryFilePath = std::filesystem::path { _cacheFilePath.string() + ".tmp" };
+    {
+        auto file = std::ofstream { temporaryFilePath, std::ios::trunc };
+        if (!file.good())
+            return;
+
+        file << FontCoverageCacheMagic << '\n';
+        for (auto const& [key, entry]: _entries)
+        {
+            if (!entry.file || hasLineBreak(entry.file->value))
+                continue;
+            file << std::format("font\t{}\t{}\t{}\t{}\n",
+                                entry.file->collectionIndex,
+                                entry.fileSize,
+                                entry.fileTime,
+                                entry.file->value);
+            file << "ranges\t";
+            auto separator = ""sv;
+            for (auto const& [first, last]: entry.coverage.ranges())
+            {
+                file << separator << std::format("{:x}", static_cast<uint32_t>(first));
+                if (last != first)
+                    file << std::format("-{:x}", static_cast<uint32_t>(last));
+                separator = " "sv;
+            }
+            file << '\n';
+        }
+
+        if (!file.good())
+            return;
+    }
+
+    std::filesystem::rename(temporaryFilePath, _cacheFilePath, ec);
+    if (ec)
+        errorLog()("Failed to write font coverage cache {}: {}", _cacheFilePath.string(), ec.message());
+}
+// }}}
+
+} // namespace text
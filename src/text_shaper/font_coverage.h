@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <text_shaper/font_locator.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace text
+{
+
+/**
+ * Set of the codepoints a font has glyphs for, as read from its character map.
+ *
+ * Codepoints are stored in bitmaps of 256 codepoints each, which are only allocated
+ * for the blocks the font has any glyph in, so that testing for a codepoint takes
+ * constant time while even large CJK fonts take a few kilobytes only.
+ */
+class font_coverage
+{
+  public:
+    using range = std::pair<char32_t, char32_t>; // first and last codepoint, inclusive
+
+    void add(char32_t codepoint);
+    void add(range codepoints);
+
+    [[nodiscard]] bool contains(char32_t codepoint) const noexcept
+    {
+        if (codepoint >= MaxCodepoint || _pageIndex.empty())
+            return false;
+        auto const page = _pageIndex[codepoint / PageSize];
+        if (page == NoPage)
+            return false;
+        auto const bit = codepoint % PageSize;
+        return (_pages[page][bit / 64] >> (bit % 64)) & 1;
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return _pages.empty(); }
+
+    /// @returns the ranges of consecutive codepoints contained, in ascending order.
+    [[nodiscard]] std::vector<range> ranges() const;
+
+  private:
+    static constexpr char32_t MaxCodepoint = 0x110000;
+    static constexpr char32_t PageSize = 256;
+    static constexpr uint16_t NoPage = 0xFFFF;
+
+    using page = std::array<uint64_t, PageSize / 64>;
+
+    std::vector<uint16_t> _pageIndex; // page of each block of codepoints, empty until anything is added
+    std::vector<page> _pages;
+};
+
+/**
+ * Coverages of the fonts loaded so far, by font source.
+ *
+ * The coverages of font files are also persisted in @p cacheDirectory (if not empty),
+ * so that later launches do not need to load fallback fonts only to learn that they
+ * do not have the glyphs looked for. Persisted coverages are only used as long as
+ * the size and modification time of their font file remain unchanged.
+ */
+class font_coverage_cache
+{
+  public:
+    explicit font_coverage_cache(std::filesystem::path cacheDirectory = {});
+
+    /// @returns the coverage of the given font, or nullptr if not known (anymore).
+    [[nodiscard]] font_coverage const* find(font_source const& source);
+
+    /// Records the coverage of the given font, persisting it if the font is a file.
+    font_coverage const& insert(font_source const& source, font_coverage coverage);
+
+  private:
+    struct entry
+    {
+        font_coverage coverage;
+        std::optional<font_path> file; // the font file covered, if not loaded from memory
+        uintmax_t fileSize = 0;
+        int64_t fileTime = 0;
+        bool validated = false; // whether the file's status has been compared since loading
+    };
+
+    void load();
+    void save() const;
+
+    std::filesystem::path _cacheFilePath;
+    std::unordered_map<std::string, entry> _entries;
+    bool _loaded = false;
+};
+
+} // namespace text
@@ -62,6 +62,14 @@ class font_locator
      */
     [[nodiscard]] virtual font_source_list locate(font_description const& description) = 0;
 
+    /**
+     * Hints that the given font descriptions are about to be located.
+     *
+     * Implementations may start locating them concurrently in the background,
+     * so that a subsequent locate() call only needs to wait for its result.
+     */
+    virtual void prefetch(gsl::span<font_description const> descriptions) { (void) descriptions; }
+
     /**
      * Resolves the given codepoint sequence into an ordered list of
      * possible fonts that can be used for text shaping the given
@@ -6,6 +6,7 @@
 #include <text_shaper/mock_font_locator.h>
 
 #include <memory>
+#include <utility>
 
 namespace text
 {
@@ -18,6 +19,11 @@ font_locator_provider& font_locator_provider::get()
     return instance;
 }
 
+void font_locator_provider::set_cache_directory(std::filesystem::path directory)
+{
+    _cacheDirectory = std::move(directory);
+}
+
 font_locator& font_locator_provider::native()
 {
     if (!_native)
@@ -27,7 +33,7 @@ font_locator& font_locator_provider::native()
 #elif defined(_WIN32)
         _native = make_unique<directwrite_locator>();
 #else
-        _native = make_unique<fontconfig_locator>();
+        _native = make_unique<fontconfig_locator>(_cacheDirectory);
 #endif
     }
 
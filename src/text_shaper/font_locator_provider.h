@@ -3,6 +3,7 @@
 
 #include <text_shaper/font_locator.h>
 
+#include <filesystem>
 #include <memory>
 
 namespace text
@@ -13,11 +14,17 @@ class font_locator_provider
   public:
     static font_locator_provider& get();
 
+    /// Sets the directory the native font locator may persist its caches in.
+    ///
+    /// This only takes effect if called before the native font locator is first used.
+    void set_cache_directory(std::filesystem::path directory);
+
     font_locator& native();
 
     font_locator& mock();
 
   private:
+    std::filesystem::path _cacheDirectory {};
     std::unique_ptr<font_locator> _native {};
     std::unique_ptr<font_locator> _mock {};
 };
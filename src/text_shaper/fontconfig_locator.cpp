@@ -2,6 +2,7 @@
 #include <text_shaper/font.h>
 #include <text_shaper/fontconfig_locator.h>
 
+#include <crispy/StrongHash.h>
 #include <crispy/assert.h>
 #include <crispy/utils.h>
 
@@ -10,7 +11,14 @@
 
 #include <fontconfig/fontconfig.h>
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
 #include <string_view>
+#include <system_error>
+#include <unordered_map>
 #include <variant>
 
 using std::nullopt;
@@ -128,35 +136,320 @@ namespace
         }
     }
 
+    // Identifies a font chain by everything in the font description that affects locating fonts.
+    string fontChainKey(font_description const& description)
+    {
+        auto key = std::format("{}\t{}\t{}\t{}\t{}\t{}",
+                               description.familyName,
+                               static_cast<unsigned>(description.weight),
+                               static_cast<unsigned>(description.slant),
+                               static_cast<unsigned>(description.spacing),
+                               description.strictSpacing ? 1 : 0,
+                               description.fontFallback.index());
+        if (auto const* list = std::get_if<font_fallback_list>(&description.fontFallback))
+            for (auto const& fallbackFont: list->fallbackFonts)
+                key += std::format("\t{}", fallbackFont);
+        return key;
+    }
+
+    void hashFileStatus(crispy::strong_hash& hash, FcStrList* list)
+    {
+        if (!list)
+            return;
+        while (FcChar8* entry = FcStrListNext(list))
+        {
+            auto const path = std::filesystem::path { (char const*) entry };
+            auto ec = std::error_code {};
+            auto const lastWriteTime = std::filesystem::last_write_time(path, ec);
+            hash = hash * crispy::strong_hash::compute(path.string())
+                   * static_cast<uint32_t>(lastWriteTime.time_since_epoch().count());
+        }
+        FcStrListDone(list);
+    }
+
+    // Fingerprints the state of fontconfig by its version, configuration files, and font directories
+    // (which also includes their subdirectories), so that installing or removing fonts, as well as
+    // changing the fontconfig configuration, invalidates the persisted font chains.
+    string fontconfigFingerprint(FcConfig* config)
+    {
+        auto hash = crispy::strong_hash::compute(FcGetVersion());
+        hashFileStatus(hash, FcConfigGetConfigFiles(config));
+        hashFileStatus(hash, FcConfigGetFontDirs(config));
+        return to_string(hash);
+    }
+
+    auto constexpr FontChainCacheMagic = "contour-fontconfig-chains-v1"sv;
+
+    bool hasLineBreak(string_view text) noexcept
+    {
+        return text.find('\n') != string_view::npos;
+    }
+
+    vector<string_view> splitFields(string_view line)
+    {
+        auto fields = vector<string_view> {};
+        for (;;)
+        {
+            auto const i = line.find('\t');
+            fields.emplace_back(line.substr(0, i));
+            if (i == string_view::npos)
+                return fields;
+            line.remove_prefix(i + 1);
+        }
+    }
+
+    optional<int> parseInt(string_view text)
+    {
+        if (text.empty())
+            return nullopt;
+        auto value = 0;
+        auto const sign = text.front() == '-' ? -1 : 1;
+        if (sign < 0)
+            text.remove_prefix(1);
+        if (text.empty())
+            return nullopt;
+        for (char const ch: text)
+        {
+            if (ch < '0' || ch > '9')
+                return nullopt;
+            value = value * 10 + (ch - '0');
+        }
+        return sign * value;
+    }
+
 } // namespace
 
 struct fontconfig_locator::private_tag
 {
-    // currently empty, maybe later something (such as caching)?
     FcConfig* ftConfig = nullptr;
+    std::once_flag ftConfigLoaded;
+
+    // Guards all members below.
+    std::mutex mutex;
+
+    // Font chains located so far, and those loaded from the cache file, by fontChainKey().
+    std::filesystem::path cacheFilePath;
+    std::unordered_map<string, font_source_list> fontChains;
+    bool fontChainsLoaded = false;
+
+    // Font chains being located on worker threads, by fontChainKey().
+    std::unordered_map<string, std::shared_future<font_source_list>> prefetchedFontChains;
 
-    private_tag()
+    explicit private_tag(std::filesystem::path cacheDirectory)
     {
         FcInit();
-        ftConfig = FcInitLoadConfigAndFonts(); // Most convenient of all the alternatives
+        if (!cacheDirectory.empty())
+            cacheFilePath = std::move(cacheDirectory) / "fontconfig-chains.cache";
     }
 
     ~private_tag()
     {
         locatorLog()("~fontconfig_locator.dtor");
-        FcConfigDestroy(ftConfig);
+        for (auto const& [key, fontChain]: prefetchedFontChains)
+            fontChain.wait();
+        if (ftConfig)
+            FcConfigDestroy(ftConfig);
         FcFini();
     }
+
+    private_tag(private_tag const&) = delete;
+    private_tag(private_tag&&) = delete;
+    private_tag& operator=(private_tag const&) = delete;
+    private_tag& operator=(private_tag&&) = delete;
+
+    // Loads the fonts lazily, as located font chains may all be served from the cache.
+    // Once loaded, the configuration may be queried from multiple threads.
+    FcConfig* config()
+    {
+        std::call_once(ftConfigLoaded, [this]() {
+            ftConfig = FcInitLoadConfigAndFonts(); // Most convenient of all the alternatives
+        });
+        return ftConfig;
+    }
+
+    font_source_list locate(font_description const& description);
+    font_source_list const* cachedFontChain(string const& key); // requires mutex to be locked
+    void loadFontChains();
+    void saveFontChains() const;
 };
 
-fontconfig_locator::fontconfig_locator():
-    _d { new private_tag(), [](private_tag* p) {
+fontconfig_locator::fontconfig_locator(std::filesystem::path cacheDirectory):
+    _d { new private_tag(std::move(cacheDirectory)), [](private_tag* p) {
             delete p;
         } }
 {
 }
 
 font_source_list fontconfig_locator::locate(font_description const& description)
+{
+    auto const key = fontChainKey(description);
+    auto prefetched = std::shared_future<font_source_list> {};
+    {
+        auto const lock = std::scoped_lock { _d->mutex };
+        if (auto const* fontChain = _d->cachedFontChain(key))
+        {
+            locatorLog()("Using cached font chain for: {}", description);
+            return *fontChain;
+        }
+        if (auto const i = _d->prefetchedFontChains.find(key); i != _d->prefetchedFontChains.end())
+        {
+            prefetched = std::move(i->second);
+            _d->prefetchedFontChains.erase(i);
+        }
+    }
+
+    auto output = prefetched.valid() ? prefetched.get() : _d->locate(description);
+    if (!output.empty())
+    {
+        auto const lock = std::scoped_lock { _d->mutex };
+        _d->fontChains[key] = output;
+        _d->saveFontChains();
+    }
+    return output;
+}
+
+void fontconfig_locator::prefetch(gsl::span<font_description const> descriptions)
+{
+    auto const lock = std::scoped_lock { _d->mutex };
+    for (font_description const& description: descriptions)
+    {
+        auto key = fontChainKey(description);
+        if (_d->cachedFontChain(key) || _d->prefetchedFontChains.count(key))
+            continue;
+
+        locatorLog()("Prefetching font chain for: {}", description);
+        auto* d = _d.get();
+        auto fontChain = std::async(std::launch::async, [d, description]() { return d->locate(description); });
+        _d->prefetchedFontChains.emplace(std::move(key), fontChain.share());
+    }
+}
+
+font_source_list const* fontconfig_locator::private_tag::cachedFontChain(string const& key)
+{
+    if (!fontChainsLoaded)
+    {
+        fontChainsLoaded = true;
+        loadFontChains();
+    }
+
+    auto const i = fontChains.find(key);
+    if (i == fontChains.end())
+        return nullptr;
+
+    // Revalidate lazily, i.e. only when the chain is actually used.
+    auto const fileExists = [](font_source const& source) {
+        auto ec = std::error_code {};
+        auto const* path = std::get_if<font_path>(&source);
+        return path && std::filesystem::exists(path->value, ec);
+    };
+    if (!std::all_of(i->second.begin(), i->second.end(), fileExists))
+    {
+        locatorLog()("Dropping cached font chain, as some of its font files are gone.");
+        fontChains.erase(i);
+        return nullptr;
+    }
+
+    return &i->second;
+}
+
+void fontconfig_locator::private_tag::loadFontChains()
+{
+    if (cacheFilePath.empty())
+        return;
+
+    auto file = std::ifstream { cacheFilePath };
+    if (!file.good())
+        return;
+
+    auto line = string {};
+    if (!std::getline(file, line)
+        || line != std::format("{}\t{}", FontChainCacheMagic, fontconfigFingerprint(FcConfigGetCurrent())))
+    {
+        locatorLog()("Ignoring outdated font chain cache: {}", cacheFilePath.string());
+        return;
+    }
+
+    auto loaded = std::unordered_map<string, font_source_list> {};
+    auto* current = (font_source_list*) nullptr;
+    while (std::getline(file, line))
+    {
+        auto const fields = splitFields(line);
+        if (fields.size() >= 2 && fields[0] == "chain")
+        {
+            current = &loaded[line.substr(fields[0].size() + 1)];
+            continue;
+        }
+
+        // The font path is last, and may contain tabs itself.
+        auto const index = fields.size() >= 5 ? parseInt(fields[1]) : nullopt;
+        auto const weight = index ? parseInt(fields[2]) : nullopt;
+        auto const slant = index ? parseInt(fields[3]) : nullopt;
+        if (!current || fields[0] != "font" || !index || !weight || !slant)
+        {
+            errorLog()("Ignoring malformed font chain cache: {}", cacheFilePath.string());
+            return;
+        }
+
+        auto const pathOffset = fields[0].size() + fields[1].size() + fields[2].size() + fields[3].size() + 4;
+        auto fontPath = font_path { .value = line.substr(pathOffset), .collectionIndex = *index };
+        if (*weight >= 0)
+            fontPath.weight = static_cast<font_weight>(*weight);
+        if (*slant >= 0)
+            fontPath.slant = static_cast<font_slant>(*slant);
+        current->emplace_back(std::move(fontPath));
+    }
+
+    locatorLog()("Loaded {} font chains from cache: {}", loaded.size(), cacheFilePath.string());
+    fontChains = std::move(loaded);
+}
+
+void fontconfig_locator::private_tag::saveFontChains() const
+{
+    if (cacheFilePath.empty())
+        return;
+
+    auto ec = std::error_code {};
+    std::filesystem::create_directories(cacheFilePath.parent_path(), ec);
+
+    // Write to a temporary file first, so that concurrently starting instances
+    // never read a partially written cache file.
+    auto const temporaryFilePath = std::filesystem::path { cacheFilePath.string() + ".tmp" };
+    {
+        auto file = std::ofstream { temporaryFilePath, std::ios::trunc };
+        if (!file.good())
+            return;
+
+        file << FontChainCacheMagic << '\t' << fontconfigFingerprint(FcConfigGetCurrent()) << '\n';
+        auto const isStorable = [](font_source const& source) {
+            auto const* path = std::get_if<font_path>(&source);
+            return path && !hasLineBreak(path->value);
+        };
+        for (auto const& [key, fontChain]: fontChains)
+        {
+            if (hasLineBreak(key) || !std::all_of(fontChain.begin(), fontChain.end(), isStorable))
+                continue;
+            file << "chain\t" << key << '\n';
+            for (auto const& source: fontChain)
+            {
+                auto const& path = std::get<font_path>(source);
+                file << std::format("font\t{}\t{}\t{}\t{}\n",
+                                    path.collectionIndex,
+                                    path.weight ? static_cast<int>(*path.weight) : -1,
+                                    path.slant ? static_cast<int>(*path.slant) : -1,
+                                    path.value);
+            }
+        }
+
+        if (!file.good())
+            return;
+    }
+
+    std::filesystem::rename(temporaryFilePath, cacheFilePath, ec);
+    if (ec)
+        errorLog()("Failed to write font chain cache {}: {}", cacheFilePath.string(), ec.message());
+}
+
+font_source_list fontconfig_locator::private_tag::locate(font_description const& description)
 {
     locatorLog()("Locating font chain for: {}", description);
     auto pat =
@@ -198,12 +491,12 @@ font_source_list fontconfig_locator::locate(font_description const& description)
     if (description.slant != font_slant::normal)
         FcPatternAddInteger(pat.get(), FC_SLANT, fcSlant(description.slant));
 
-    FcConfigSubstitute(_d->ftConfig, pat.get(), FcMatchPattern);
+    FcConfigSubstitute(config(), pat.get(), FcMatchPattern);
     FcDefaultSubstitute(pat.get());
 
     FcResult result = FcResultNoMatch;
     auto fs = unique_ptr<FcFontSet, void (*)(FcFontSet*)>(
-        FcFontSort(_d->ftConfig, pat.get(), /*unicode-trim*/ FcTrue, /*FcCharSet***/ nullptr, &result),
+        FcFontSort(config(), pat.get(), /*unicode-trim*/ FcTrue, /*FcCharSet***/ nullptr, &result),
         [](auto p) { FcFontSetDestroy(p); });
 
     if (!fs || result != FcResultMatch)
@@ -364,7 +657,7 @@ font_source_list fontconfig_locator::all()
         FC_WEIGHT,
         FC_WIDTH,
         NULL);
-    FcFontSet* fs = FcFontList(_d->ftConfig, pat, os);
+    FcFontSet* fs = FcFontList(_d->config(), pat, os);
 
     font_source_list output;
 
@@ -4,6 +4,8 @@
 #include <text_shaper/font.h>
 #include <text_shaper/font_locator.h>
 
+#include <filesystem>
+
 namespace text
 {
 
@@ -12,14 +14,23 @@ namespace text
  *
  * This should be available on all platforms.
  *
+ * Located font chains are cached, and persisted in @p cacheDirectory (if not empty),
+ * so that later launches do not need to query fontconfig again. The persisted chains
+ * are only used as long as fontconfig's configuration files and font directories
+ * remain unchanged, and each chain is dropped as soon as one of its font files is gone.
+ *
+ * Font chains that are not cached yet can be prefetched, in which case they are located
+ * concurrently on worker threads.
+ *
  * @note on Windows, fontconfig still can NOT find user installed fonts.
  */
 class fontconfig_locator: public font_locator
 {
   public:
-    fontconfig_locator();
+    explicit fontconfig_locator(std::filesystem::path cacheDirectory = {});
 
     [[nodiscard]] font_source_list locate(font_description const& description) override;
+    void prefetch(gsl::span<font_description const> descriptions) override;
     [[nodiscard]] font_source_list all() override;
     [[nodiscard]] font_source_list resolve(gsl::span<const char32_t> codepoints) override;
 
@@ -1,13 +1,16 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <text_shaper/font.h>
+#include <text_shaper/font_coverage.h>
 #include <text_shaper/font_locator.h>
 #include <text_shaper/open_shaper.h>
 
 #include <crispy/algorithm.h>
 #include <crispy/assert.h>
+#include <crispy/pixels.h>
 #include <crispy/times.h>
 
 #include <libunicode/convert.h>
+#include <libunicode/ucd.h>
 #include <libunicode/ucd_fmt.h>
 
 #include <range/v3/algorithm/any_of.hpp>
@@ -31,9 +34,11 @@
 #endif
 
 #include <harfbuzz/hb-ft.h>
+#include <harfbuzz/hb-ot.h>
 #include <harfbuzz/hb.h>
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <sstream>
 #include <stdexcept>
@@ -102,6 +107,7 @@ namespace text
 
 using hb_buffer_ptr = unique_ptr<hb_buffer_t, void (*)(hb_buffer_t*)>;
 using hb_font_ptr = unique_ptr<hb_font_t, void (*)(hb_font_t*)>;
+using hb_shape_plan_ptr = unique_ptr<hb_shape_plan_t, void (*)(hb_shape_plan_t*)>;
 using ft_face_ptr = unique_ptr<FT_FaceRec_, void (*)(FT_FaceRec_*)>;
 
 auto constexpr MissingGlyphId = 0xFFFDu;
@@ -115,6 +121,13 @@ struct HbFontInfo // NOLINT(readability-identifier-naming)
     hb_font_ptr hbFont;
     std::optional<font_metrics> metrics {};
     font_description description {};
+
+    // Derived from the font description's features, so they are not rebuilt for every text run.
+    std::vector<hb_feature_t> hbFeatures {};
+
+    // Shape plans for the features above, by script. Buffer direction and language are always
+    // the same (LTR, default language), which is why the script is all that varies.
+    std::unordered_map<hb_script_t, hb_shape_plan_ptr> hbShapePlans {};
 };
 
 namespace
@@ -145,6 +158,32 @@ namespace
         return gp.glyph.index.value == 0;
     }
 
+    font_coverage coverageOf(FT_Face face)
+    {
+        auto coverage = font_coverage {};
+        FT_UInt glyphIndex = 0;
+        for (auto codepoint = FT_Get_First_Char(face, &glyphIndex); glyphIndex != 0;
+             codepoint = FT_Get_Next_Char(face, codepoint, &glyphIndex))
+            coverage.add(static_cast<char32_t>(codepoint));
+        return coverage;
+    }
+
+    // Marks and format characters (such as ZWJ and variation selectors) may be shaped by fonts
+    // without glyphs of their own, as they are composed with their base character or ignored.
+    bool needsGlyph(char32_t codepoint) noexcept
+    {
+        namespace gc = unicode::general_category;
+        return !(gc::nonspacing_mark(codepoint) || gc::spacing_mark(codepoint)
+                 || gc::enclosing_mark(codepoint) || gc::format(codepoint));
+    }
+
+    bool covers(font_coverage const& coverage, u32string_view codepoints) noexcept
+    {
+        return std::all_of(codepoints.begin(), codepoints.end(), [&](char32_t codepoint) {
+            return !needsGlyph(codepoint) || coverage.contains(codepoint);
+        });
+    }
+
     constexpr int ftRenderFlag(render_mode mode) noexcept
     {
         switch (mode)
@@ -338,6 +377,42 @@ namespace
         hb_buffer_guess_segment_properties(hbBuf);
     }
 
+    vector<hb_feature_t> toHbFeatures(std::vector<font_feature> const& features)
+    {
+        vector<hb_feature_t> hbFeatures;
+        hbFeatures.reserve(features.size());
+        for (font_feature const feature: features)
+        {
+            hb_feature_t hbFeature;
+            hbFeature.tag = HB_TAG(feature.name[0], feature.name[1], feature.name[2], feature.name[3]);
+            hbFeature.value = feature.enabled ? 1 : 0;
+            hbFeature.start = 0;
+            hbFeature.end = std::numeric_limits<decltype(hbFeature.end)>::max();
+            hbFeatures.emplace_back(hbFeature);
+        }
+        return hbFeatures;
+    }
+
+    hb_shape_plan_t* getOrCreateShapePlan(HbFontInfo& fontInfo, hb_buffer_t* hbBuf, hb_font_t* hbFont)
+    {
+        auto props = hb_segment_properties_t {};
+        hb_buffer_get_segment_properties(hbBuf, &props);
+
+        if (auto const i = fontInfo.hbShapePlans.find(props.script); i != fontInfo.hbShapePlans.end())
+            return i->second.get();
+
+        auto hbShapePlan = hb_shape_plan_ptr(
+            hb_shape_plan_create_cached(hb_font_get_face(hbFont),
+                                        &props,
+                                        fontInfo.hbFeatures.data(),
+                                        static_cast<unsigned int>(fontInfo.hbFeatures.size()),
+                                        nullptr),
+            [](auto p) { hb_shape_plan_destroy(p); });
+        auto* result = hbShapePlan.get();
+        fontInfo.hbShapePlans.emplace(props.script, std::move(hbShapePlan));
+        return result;
+    }
+
     bool tryShape(font_key font,
                   HbFontInfo& fontInfo,
                   hb_buffer_t* hbBuf,
@@ -353,18 +428,11 @@ namespace
 
         prepareBuffer(hbBuf, codepoints, clusters, script);
 
-        vector<hb_feature_t> hbFeatures;
-        for (font_feature const feature: fontInfo.description.features)
-        {
-            hb_feature_t hbFeature;
-            hbFeature.tag = HB_TAG(feature.name[0], feature.name[1], feature.name[2], feature.name[3]);
-            hbFeature.value = feature.enabled ? 1 : 0;
-            hbFeature.start = 0;
-            hbFeature.end = std::numeric_limits<decltype(hbFeature.end)>::max();
-            hbFeatures.emplace_back(hbFeature);
-        }
-
-        hb_shape(hbFont, hbBuf, hbFeatures.data(), static_cast<unsigned int>(hbFeatures.size()));
+        auto const& hbFeatures = fontInfo.hbFeatures;
+        auto const hbFeatureCount = static_cast<unsigned int>(hbFeatures.size());
+        hb_shape_plan_t* hbShapePlan = getOrCreateShapePlan(fontInfo, hbBuf, hbFont);
+        if (!hb_shape_plan_execute(hbShapePlan, hbFont, hbBuf, hbFeatures.data(), hbFeatureCount))
+            hb_shape(hbFont, hbBuf, hbFeatures.data(), hbFeatureCount);
         hb_buffer_normalize_glyphs(hbBuf); // TODO: lookup again what this one does
 
         auto const glyphCount = hb_buffer_get_length(hbBuf);
@@ -409,10 +477,12 @@ struct open_shaper::private_open_shaper // {{{
     // Blacklisted font files as we tried them already and failed.
     std::vector<std::string> blacklistedSources;
 
-    // The key (for caching) should be composed out of:
-    // (file_path, file_mtime, font_weight, font_slant, pixel_size)
+    // Codepoints covered by the fonts loaded so far, by font source, regardless of their size.
+    font_coverage_cache coverages;
+
+    // Rasterized glyphs are not cached here: the renderer keeps them in its texture atlas
+    // and, beyond that, in the on-disk glyph cache.
 
-    unordered_map<glyph_key, rasterized_glyph> glyphs;
     hb_buffer_ptr hbBuf;
     font_key nextFontKey;
 
@@ -449,6 +519,9 @@ struct open_shaper::private_open_shaper // {{{
         }
 
         auto ftFacePtr = std::move(ftFacePtrOpt.value());
+        if (!coverages.find(source))
+            coverages.insert(source, coverageOf(ftFacePtr.get()));
+
         auto hbFontPtr =
             hb_font_ptr(hb_ft_font_create_referenced(ftFacePtr.get()), [](auto p) { hb_font_destroy(p); });
 
@@ -486,12 +559,13 @@ struct open_shaper::private_open_shaper // {{{
         return output;
     }
 
-    private_open_shaper(DPI dpi, font_locator& locator):
+    private_open_shaper(DPI dpi, font_locator& locator, std::filesystem::path cacheDirectory):
         ftCleanup { [this]() {
             FT_Done_FreeType(ft);
         } },
         locator { &locator },
         dpi { dpi },
+        coverages { std::move(cacheDirectory) },
         hbBuf(hb_buffer_create(), [](auto p) { hb_buffer_destroy(p); }),
         nextFontKey {}
     {
@@ -502,6 +576,30 @@ struct open_shaper::private_open_shaper // {{{
             errorLog()("freetype: Failed to set LCD filter. {}", ftErrorStr(ec));
     }
 
+    /// @returns the key of the given fallback font of @p fontInfo, if it covers the given codepoints.
+    ///
+    /// Fallback fonts are only loaded if their coverage is not known yet.
+    optional<font_key> getFallbackKeyCovering(font_source const& fallbackFont,
+                                              HbFontInfo const& fontInfo,
+                                              u32string_view codepoints)
+    {
+        auto const* coverage = coverages.find(fallbackFont);
+        if (coverage && !covers(*coverage, codepoints))
+            return nullopt;
+
+        auto fallbackKeyOpt = getOrCreateKeyForFont(fallbackFont, fontInfo.size, fontInfo.description.weight);
+        if (!fallbackKeyOpt.has_value())
+            return nullopt;
+
+        // Loading the font has recorded its coverage.
+        if (!coverage)
+            coverage = coverages.find(fallbackFont);
+        if (coverage && !covers(*coverage, codepoints))
+            return nullopt;
+
+        return fallbackKeyOpt;
+    }
+
     bool tryShapeWithFallback(font_key font,
                               HbFontInfo& fontInfo,
                               hb_buffer_t* hbBuf,
@@ -521,8 +619,7 @@ struct open_shaper::private_open_shaper // {{{
         {
             result.resize(initialResultOffset); // rollback to initial size
 
-            optional<font_key> fallbackKeyOpt =
-                getOrCreateKeyForFont(fallbackFont, fontInfo.size, fontInfo.description.weight);
+            optional<font_key> fallbackKeyOpt = getFallbackKeyCovering(fallbackFont, fontInfo, codepoints);
             if (!fallbackKeyOpt.has_value())
                 continue;
 
@@ -560,8 +657,9 @@ struct open_shaper::private_open_shaper // {{{
     }
 }; // }}}
 
-open_shaper::open_shaper(DPI dpi, font_locator& locator):
-    _d(new private_open_shaper(dpi, locator), [](private_open_shaper* p) { delete p; })
+open_shaper::open_shaper(DPI dpi, font_locator& locator, std::filesystem::path cacheDirectory):
+    _d(new private_open_shaper(dpi, locator, std::move(cacheDirectory)),
+       [](private_open_shaper* p) { delete p; })
 {
 }
 
@@ -602,6 +700,8 @@ optional<font_key> open_shaper::load_font(font_description const& description, f
     HbFontInfo& fontInfo = _d->fontKeyToHbFontInfoMapping.at(*fontKeyOpt);
     fontInfo.fallbacks = std::move(sources);
     fontInfo.description = description;
+    fontInfo.hbFeatures = toHbFeatures(description.features);
+    fontInfo.hbShapePlans.clear(); // They were created for the previous features.
 
     return fontKeyOpt;
 }
@@ -618,32 +718,79 @@ font_metrics open_shaper::metrics(font_key key) const
     return fontInfo.metrics.value();
 }
 
+optional<font_source> open_shaper::source(font_key key) const
+{
+    if (auto const i = _d->fontKeyToHbFontInfoMapping.find(key); i != _d->fontKeyToHbFontInfoMapping.end())
+        return i->second.primary;
+    return nullopt;
+}
+
+bool open_shaper::has_ligatures(font_key key) const
+{
+    auto const i = _d->fontKeyToHbFontInfoMapping.find(key);
+    if (i == _d->fontKeyToHbFontInfoMapping.end())
+        return true;
+
+    HbFontInfo const& fontInfo = i->second;
+
+    // GSUB features substituting glyphs of adjacent codepoints, and whether HarfBuzz enables them by default.
+    auto constexpr LigatureFeatures = std::array {
+        pair { HB_TAG('l', 'i', 'g', 'a'), true },  pair { HB_TAG('c', 'l', 'i', 'g'), true },
+        pair { HB_TAG('c', 'a', 'l', 't'), true },  pair { HB_TAG('r', 'l', 'i', 'g'), true },
+        pair { HB_TAG('d', 'l', 'i', 'g'), false },
+    };
+
+    auto const isEnabled = [&](hb_tag_t tag, bool enabledByDefault) {
+        auto enabled = enabledByDefault;
+        for (font_feature const& feature: fontInfo.description.features)
+            if (HB_TAG(feature.name[0], feature.name[1], feature.name[2], feature.name[3]) == tag)
+                enabled = feature.enabled;
+        return enabled;
+    };
+
+    hb_face_t* hbFace = hb_font_get_face(fontInfo.hbFont.get());
+    auto featureCount = hb_ot_layout_table_get_feature_tags(hbFace, HB_OT_TAG_GSUB, 0, nullptr, nullptr);
+    auto featureTags = vector<hb_tag_t>(featureCount);
+    hb_ot_layout_table_get_feature_tags(hbFace, HB_OT_TAG_GSUB, 0, &featureCount, featureTags.data());
+
+    return std::any_of(featureTags.begin(), featureTags.end(), [&](hb_tag_t tag) {
+        return std::any_of(LigatureFeatures.begin(), LigatureFeatures.end(), [&](auto const& feature) {
+            return feature.first == tag && isEnabled(feature.first, feature.second);
+        });
+    });
+}
+
 optional<glyph_position> open_shaper::shape(font_key font, char32_t codepoint)
 {
     Require(_d->fontKeyToHbFontInfoMapping.count(font) == 1);
     HbFontInfo const& fontInfo = _d->fontKeyToHbFontInfoMapping.at(font);
 
+    auto glyphFont = font;
     glyph_index glyphIndex { FT_Get_Char_Index(fontInfo.ftFace.get(), codepoint) };
     if (!glyphIndex.value)
     {
         for (font_source const& fallbackFont: fontInfo.fallbacks)
         {
             optional<font_key> fallbackKeyOpt =
-                _d->getOrCreateKeyForFont(fallbackFont, fontInfo.size, fontInfo.description.weight);
+                _d->getFallbackKeyCovering(fallbackFont, fontInfo, u32string_view(&codepoint, 1));
             if (!fallbackKeyOpt.has_value())
                 continue;
             Require(_d->fontKeyToHbFontInfoMapping.count(fallbackKeyOpt.value()) == 1);
             HbFontInfo const& fallbackFontInfo = _d->fontKeyToHbFontInfoMapping.at(fallbackKeyOpt.value());
             glyphIndex = glyph_index { FT_Get_Char_Index(fallbackFontInfo.ftFace.get(), codepoint) };
             if (glyphIndex.value)
+            {
+                // The glyph index refers to the fallback font's glyphs.
+                glyphFont = fallbackKeyOpt.value();
                 break;
+            }
         }
     }
     if (!glyphIndex.value)
         return nullopt;
 
     glyph_position gpos {};
-    gpos.glyph = glyph_key { .size = fontInfo.size, .font = font, .index = glyphIndex };
+    gpos.glyph = glyph_key { .size = fontInfo.size, .font = glyphFont, .index = glyphIndex };
 #if defined(GLYPH_KEY_DEBUG)
     gpos.glyph.text = std::u32string(1, codepoint);
 #endif
@@ -852,23 +999,15 @@ optional<rasterized_glyph> open_shaper::rasterize(glyph_key glyph, render_mode m
 
             output.format = bitmap_format::rgba;
             output.bitmap.resize(output.bitmapSize.area() * 4);
-            auto t = output.bitmap.begin();
+            auto* t = output.bitmap.data();
 
+            // BGRA -> RGBA
             auto const pitch = static_cast<unsigned>(ftFace->glyph->bitmap.pitch);
             for (auto const i: iota(0u, height.as<size_t>()))
             {
-                for (auto const j: iota(0u, width.as<size_t>()))
-                {
-                    auto const* s =
-                        &ftFace->glyph->bitmap
-                             .buffer[(static_cast<size_t>(i) * pitch) + (static_cast<size_t>(j) * 4u)];
-
-                    // BGRA -> RGBA
-                    *t++ = s[2];
-                    *t++ = s[1];
-                    *t++ = s[0];
-                    *t++ = s[3];
-                }
+                crispy::pixels::swapRedBlue(
+                    ftFace->glyph->bitmap.buffer + (i * pitch), t, width.as<size_t>());
+                t += width.as<size_t>() * 4;
             }
             break;
         }
@@ -4,6 +4,7 @@
 #include <text_shaper/font.h>
 #include <text_shaper/shaper.h>
 
+#include <filesystem>
 #include <memory>
 
 namespace text
@@ -14,11 +15,15 @@ class font_locator;
 /**
  * Text shaping and rendering engine using open source technologies,
  * fontconfig + harfbuzz + freetype.
+ *
+ * Fallback fonts are only tried for codepoints their character map covers. These coverages
+ * are persisted in @p cacheDirectory (if not empty), so that fallback fonts not covering
+ * a codepoint need not even be loaded.
  */
 class open_shaper: public shaper
 {
   public:
-    explicit open_shaper(DPI dpi, font_locator& locator);
+    explicit open_shaper(DPI dpi, font_locator& locator, std::filesystem::path cacheDirectory = {});
 
     void set_dpi(DPI dpi) override;
 
@@ -31,6 +36,10 @@ class open_shaper: public shaper
 
     [[nodiscard]] font_metrics metrics(font_key key) const override;
 
+    [[nodiscard]] std::optional<font_source> source(font_key key) const override;
+
+    [[nodiscard]] bool has_ligatures(font_key key) const override;
+
     void shape(font_key font,
                std::u32string_view codepoints,
                gsl::span<unsigned> clusters,
@@ -4,62 +4,18 @@
 #include <text_shaper/shaper.h>
 
 #include <crispy/logstore.h>
-
-#include <range/v3/view/iota.hpp>
+#include <crispy/pixels.h>
 
 #include <utility>
 #include <vector>
 
 using std::max;
-using std::min;
 using std::tuple;
 using std::vector;
 
-using ranges::views::iota;
-
 namespace text
 {
 
-namespace
-{
-    template <std::size_t NumComponents>
-    constexpr void scaleDownExplicit(vector<uint8_t> const& inputBitmap,
-                                     vtbackend::ImageSize inputSize,
-                                     vtbackend::ImageSize outputSize,
-                                     size_t factor,
-                                     vector<uint8_t>& outputBitmap) noexcept
-    {
-        outputBitmap.resize(outputSize.area() * NumComponents);
-        uint8_t* d = outputBitmap.data();
-        for (size_t i = 0, sr = 0; i < *outputSize.height; i++, sr += factor)
-        {
-            for (size_t j = 0, sc = 0; j < *outputSize.width; j++, sc += factor, d += 4)
-            {
-                // calculate area average
-                std::array<unsigned int, NumComponents> components { {} };
-                unsigned int count = 0;
-                for (size_t y = sr; y < min(sr + factor, unbox<size_t>(inputSize.height)); y++)
-                {
-                    uint8_t const* p =
-                        inputBitmap.data() + (y * unbox<size_t>(inputSize.width) * 4) + (sc * 4);
-                    for (auto x = sc; x < min(sc + factor, unbox<size_t>(inputSize.width)); x++, count++)
-                    {
-                        for (size_t i = 0; i < NumComponents; ++i)
-                            components[i] += *(p++);
-                    }
-                }
-
-                if (count)
-                {
-                    for (size_t i = 0; i < NumComponents; ++i)
-                        d[i] = static_cast<uint8_t>(components[i] / count);
-                }
-            }
-        }
-    }
-
-} // namespace
-
 tuple<rasterized_glyph, float> scale(rasterized_glyph const& bitmap, vtbackend::ImageSize boundingBox)
 {
     // NB: We're only supporting down-scaling.
@@ -85,48 +41,16 @@ tuple<rasterized_glyph, float> scale(rasterized_glyph const& bitmap, vtbackend::
                     ratio,
                     factor);
 
-    vector<uint8_t> dest;
-    switch (bitmap.format)
-    {
-        case bitmap_format::rgba:
-            scaleDownExplicit<4>(bitmap.bitmap, bitmap.bitmapSize, newSize, factor, dest);
-            break;
-        case bitmap_format::rgb:
-            scaleDownExplicit<3>(bitmap.bitmap, bitmap.bitmapSize, newSize, factor, dest);
-            break;
-        case bitmap_format::alpha_mask:
-            scaleDownExplicit<1>(bitmap.bitmap, bitmap.bitmapSize, newSize, factor, dest);
-            break;
-    }
-
-    // for (unsigned i = 0, sr = 0; i < *newSize.height; i++, sr += factor)
-    // {
-    //     for (unsigned j = 0, sc = 0; j < *newSize.width; j++, sc += factor, d += 4)
-    //     {
-    //         // calculate area average
-    //         unsigned int r = 0, g = 0, b = 0, a = 0, count = 0;
-    //         for (unsigned y = sr; y < min(sr + factor, bitmap.bitmapSize.height.as<unsigned>()); y++)
-    //         {
-    //             uint8_t const* p = bitmap.bitmap.data() + (y * *bitmap.bitmapSize.width * 4) + sc * 4;
-    //             for (unsigned x = sc; x < min(sc + factor, bitmap.bitmapSize.width.as<unsigned>());
-    //                  x++, count++)
-    //             {
-    //                 b += *(p++);
-    //                 g += *(p++);
-    //                 r += *(p++);
-    //                 a += *(p++);
-    //             }
-    //         }
-    //
-    //         if (count)
-    //         {
-    //             d[0] = static_cast<uint8_t>(b / count);
-    //             d[1] = static_cast<uint8_t>(g / count);
-    //             d[2] = static_cast<uint8_t>(r / count);
-    //             d[3] = static_cast<uint8_t>(a / count);
-    //         }
-    //     }
-    // }
+    auto const components = pixel_size(bitmap.format);
+    auto dest = vector<uint8_t>(newSize.area() * components);
+    crispy::pixels::downsampleBox(bitmap.bitmap.data(),
+                                  unbox<size_t>(bitmap.bitmapSize.width),
+                                  unbox<size_t>(bitmap.bitmapSize.height),
+                                  components,
+                                  dest.data(),
+                                  unbox<size_t>(newSize.width),
+                                  unbox<size_t>(newSize.height),
+                                  factor);
 
     auto output = rasterized_glyph {};
     output.format = bitmap.format;
@@ -140,4 +64,14 @@ tuple<rasterized_glyph, float> scale(rasterized_glyph const& bitmap, vtbackend::
     return { output, factor };
 }
 
+vector<std::optional<rasterized_glyph>> shaper::rasterize_many(gsl::span<glyph_key const> glyphs,
+                                                               render_mode mode)
+{
+    auto results = vector<std::optional<rasterized_glyph>> {};
+    results.reserve(glyphs.size());
+    for (auto const& glyph: glyphs)
+        results.emplace_back(rasterize(glyph, mode));
+    return results;
+}
+
 } // namespace text
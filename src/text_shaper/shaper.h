@@ -4,6 +4,7 @@
 #include <vtbackend/primitives.h>
 
 #include <text_shaper/font.h>
+#include <text_shaper/font_locator.h>
 
 #include <crispy/logstore.h>
 #include <crispy/point.h>
@@ -80,8 +81,6 @@ struct glyph_position
 
 using shape_result = std::vector<glyph_position>;
 
-class font_locator;
-
 /**
  * Platform-independent font loading, text shaping, and glyph rendering API.
  */
@@ -120,6 +119,23 @@ class shaper
      */
     [[nodiscard]] virtual font_metrics metrics(font_key key) const = 0;
 
+    /**
+     * Retrieves the source (file or memory) the font identified by @p key has been loaded from.
+     *
+     * @returns the font source or std::nullopt if unknown.
+     */
+    [[nodiscard]] virtual std::optional<font_source> source(font_key key) const = 0;
+
+    /**
+     * Tests whether shaping text with the font identified by @p key may substitute glyphs
+     * of adjacent codepoints, e.g. due to (contextual) ligatures, with the configured font features.
+     *
+     * If not, text can be mapped to glyphs codepoint by codepoint, without shaping.
+     *
+     * @returns true if ligatures may be applied, or if this is unknown.
+     */
+    [[nodiscard]] virtual bool has_ligatures(font_key key) const = 0;
+
     /**
      * Shapes the given text @p text using the font face @p font.
      *
@@ -150,6 +166,15 @@ class shaper
      * @param mode  render technique to use.
      */
     [[nodiscard]] virtual std::optional<rasterized_glyph> rasterize(glyph_key glyph, render_mode mode) = 0;
+
+    /**
+     * Rasterizes many glyphs at once, which shapers whose per-call overhead dominates may do
+     * faster than one glyph at a time. By default, the glyphs are rasterized one by one.
+     *
+     * @returns the rasterized glyphs in the order of @p glyphs, std::nullopt for those that failed.
+     */
+    [[nodiscard]] virtual std::vector<std::optional<rasterized_glyph>> rasterize_many(
+        gsl::span<glyph_key const> glyphs, render_mode mode);
 };
 
 } // end namespace text
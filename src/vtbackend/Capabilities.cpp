@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/Capabilities.h>
 
+#include <crispy/FNV.h>
 #include <crispy/escape.h>
 
 #include <range/v3/action/sort.hpp>
@@ -9,6 +10,10 @@
 #include <range/v3/view/concat.hpp>
 #include <range/v3/view/transform.hpp>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
 #include <sstream>
 
 using std::nullopt;
@@ -396,83 +401,323 @@ namespace
         String { Undefined, "Sync"sv, "Sync=\033[?2026%?%p1%{1}%-%tl%eh"sv }
     ); // }}}
     // clang-format on
+
+    // {{{ capability index
+    constexpr auto CapabilityCount = BooleanCaps.size() + NumericalCaps.size() + StringCaps.size();
+
+    /// @returns the code and name of the given capability, numbering the boolean, numeric, and string
+    ///          capabilities one after another.
+    constexpr Def capabilityAt(size_t number) noexcept
+    {
+        if (number < BooleanCaps.size())
+            return Def { .code = BooleanCaps[number].code, .name = BooleanCaps[number].name };
+        number -= BooleanCaps.size();
+        if (number < NumericalCaps.size())
+            return Def { .code = NumericalCaps[number].code, .name = NumericalCaps[number].name };
+        number -= NumericalCaps.size();
+        return Def { .code = StringCaps[number].code, .name = StringCaps[number].name };
+    }
+
+    /// The name or the termcap code of a capability, by which it can be looked up.
+    struct IndexKey
+    {
+        uint16_t number = 0; // of the capability, see capabilityAt()
+        bool isCode = false;
+    };
+
+    /// @returns the given key's text, spelling out codes into the given buffer.
+    constexpr string_view textOf(IndexKey key, std::array<char, 2>& buffer) noexcept
+    {
+        auto const def = capabilityAt(key.number);
+        if (!key.isCode)
+            return def.name;
+        buffer = { static_cast<char>(def.code.code >> 8), static_cast<char>(def.code.code & 0xFF) };
+        return string_view(buffer.data(), buffer.size());
+    }
+
+    constexpr uint32_t hashOf(string_view key) noexcept
+    {
+        auto const fnv = crispy::fnv<char, uint32_t> {};
+        return fnv(fnv.basis(), key);
+    }
+
+    constexpr uint32_t hashOf(Code code) noexcept
+    {
+        auto const buffer =
+            std::array { static_cast<char>(code.code >> 8), static_cast<char>(code.code & 0xFF) };
+        return hashOf(string_view(buffer.data(), buffer.size()));
+    }
+
+    constexpr uint32_t hashOf(IndexKey key) noexcept
+    {
+        auto buffer = std::array<char, 2> {};
+        return hashOf(textOf(key, buffer));
+    }
+
+    /// Scrambles a key's hash with the seed of its bucket, picking its slot.
+    constexpr uint32_t rehash(uint32_t hash, uint32_t seed) noexcept
+    {
+        hash ^= seed * 0x9E3779B9u;
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6Bu;
+        hash ^= hash >> 13;
+        return hash;
+    }
+
+    /// Which keys of the capabilities an index maps.
+    enum class IndexKeys : uint8_t
+    {
+        NamesAndCodes,
+        Codes,
+    };
+
+    /// @returns the number of keys of the given kind, including those shared by several capabilities.
+    constexpr size_t keyCountOf(IndexKeys kind) noexcept
+    {
+        auto count = size_t { 0 };
+        for (size_t number = 0; number < CapabilityCount; ++number)
+        {
+            auto const def = capabilityAt(number);
+            count += kind == IndexKeys::NamesAndCodes && !def.name.empty() ? 1 : 0;
+            count += def.code != Undefined ? 1 : 0;
+        }
+        return count;
+    }
+
+    /// Perfect hash table over the names and/or the termcap codes of all capabilities, mapping each
+    /// one to the number of the first capability that has it (see capabilityAt()), built at compile time.
+    ///
+    /// Keys are hashed into buckets first, each with a seed of its own that has been chosen such that
+    /// no two keys share a slot, unless they belong to the same capability. Looking up any key thus
+    /// takes a single probe, to be compared against the capability found.
+    template <IndexKeys Kind>
+    struct CapabilityIndex
+    {
+        static_assert(CapabilityCount < 0xFFFF);
+
+        constexpr static inline size_t KeyCount = keyCountOf(Kind);
+        constexpr static inline size_t BucketCount = KeyCount / 2;
+        constexpr static inline size_t SlotCount = std::bit_ceil(2 * KeyCount);
+        constexpr static inline uint16_t Empty = 0xFFFF;
+
+        std::array<uint16_t, BucketCount> seeds {};
+        std::array<uint16_t, SlotCount> slots {};
+
+        [[nodiscard]] constexpr static size_t bucketOf(uint32_t hash) noexcept { return hash % BucketCount; }
+
+        [[nodiscard]] constexpr static size_t slotOf(uint32_t hash, uint32_t seed) noexcept
+        {
+            return rehash(hash, seed) & (SlotCount - 1);
+        }
+
+        /// @returns the number of the capability in the given key's slot, which may be another key's.
+        [[nodiscard]] constexpr optional<size_t> probe(auto key) const noexcept
+        {
+            auto const hash = hashOf(key);
+            auto const number = slots[slotOf(hash, seeds[bucketOf(hash)])];
+            if (number == Empty)
+                return nullopt;
+            return number;
+        }
+    };
+
+    /// @returns the capability index, or nothing if no seeds could be found to place all keys.
+    template <IndexKeys Kind>
+    constexpr optional<CapabilityIndex<Kind>> buildCapabilityIndex() noexcept
+    {
+        using Index = CapabilityIndex<Kind>;
+        constexpr auto MaxSeed = uint32_t { 0xFFFF };
+        constexpr auto MaxBucketSize = size_t { 16 };
+
+        // The keys and their hashes, ordered by their bucket, and within each bucket by their capability.
+        auto hashOfKey = std::array<uint32_t, Index::KeyCount> {};
+        auto bucketSizes = std::array<size_t, Index::BucketCount> {};
+        auto keyCount = size_t { 0 };
+        auto const forEachKey = [](auto callback) {
+            for (size_t number = 0; number < CapabilityCount; ++number)
+            {
+                if (Kind == IndexKeys::NamesAndCodes && !capabilityAt(number).name.empty())
+                    callback(IndexKey { .number = static_cast<uint16_t>(number), .isCode = false });
+                if (capabilityAt(number).code != Undefined)
+                    callback(IndexKey { .number = static_cast<uint16_t>(number), .isCode = true });
+            }
+        };
+        forEachKey([&](IndexKey key) {
+            hashOfKey[keyCount] = hashOf(key);
+            ++bucketSizes[Index::bucketOf(hashOfKey[keyCount++])];
+        });
+        auto bucketStarts = std::array<size_t, Index::BucketCount + 1> {};
+        for (size_t bucket = 0; bucket < Index::BucketCount; ++bucket)
+            bucketStarts[bucket + 1] = bucketStarts[bucket] + bucketSizes[bucket];
+        auto keys = std::array<IndexKey, Index::KeyCount> {};
+        auto hashes = std::array<uint32_t, Index::KeyCount> {};
+        auto bucketEnds = bucketStarts;
+        keyCount = 0;
+        forEachKey([&](IndexKey key) {
+            auto const hash = hashOfKey[keyCount++];
+            auto const position = bucketEnds[Index::bucketOf(hash)]++;
+            keys[position] = key;
+            hashes[position] = hash;
+        });
+
+        // Buckets with the most keys are placed first, while most slots are still free.
+        auto buckets = std::array<size_t, Index::BucketCount> {};
+        auto bucketCount = size_t { 0 };
+        for (auto size = MaxBucketSize; size > 0; --size)
+            for (size_t bucket = 0; bucket < Index::BucketCount; ++bucket)
+                if (bucketSizes[bucket] == size)
+                    buckets[bucketCount++] = bucket;
+        if (bucketCount + static_cast<size_t>(std::ranges::count(bucketSizes, 0)) != Index::BucketCount)
+            return nullopt; // Some bucket has more keys than MaxBucketSize.
+
+        // Whether the given key is had by the given prior capability, too, which it thus belongs to.
+        auto const isPriorKey = [](IndexKey key, size_t number) {
+            if (number > key.number)
+                return false;
+            auto buffer = std::array<char, 2> {};
+            auto const text = textOf(key, buffer);
+            auto const def = capabilityAt(number);
+            return def.code == text || (Kind == IndexKeys::NamesAndCodes && def.name == text);
+        };
+
+        auto index = Index {};
+        index.slots.fill(Index::Empty);
+        for (auto const bucket: std::span(buckets).first(bucketCount))
+        {
+            auto const first = bucketStarts[bucket];
+            auto const last = first + bucketSizes[bucket];
+
+            auto const tryPlace = [&](uint32_t seed) {
+                // The slots taken by this bucket so far, to be freed again if some key cannot be placed.
+                auto taken = std::array<size_t, MaxBucketSize> {};
+                auto takenCount = size_t { 0 };
+                for (auto i = first; i < last; ++i)
+                {
+                    auto const key = keys[i];
+                    auto const slot = Index::slotOf(hashes[i], seed);
+                    if (index.slots[slot] == key.number || isPriorKey(key, index.slots[slot]))
+                        continue; // The slot is taken by this key's capability, or by a prior one sharing it.
+                    if (index.slots[slot] != Index::Empty)
+                    {
+                        for (auto const takenSlot: std::span(taken).first(takenCount))
+                            index.slots[takenSlot] = Index::Empty;
+                        return false;
+                    }
+                    index.slots[slot] = key.number;
+                    taken[takenCount++] = slot;
+                }
+                return true;
+            };
+
+            auto seed = uint32_t { 0 };
+            while (seed <= MaxSeed && !tryPlace(seed))
+                ++seed;
+            if (seed > MaxSeed)
+                return nullopt;
+            index.seeds[bucket] = static_cast<uint16_t>(seed);
+        }
+        return index;
+    }
+
+    constexpr auto NameIndex = buildCapabilityIndex<IndexKeys::NamesAndCodes>();
+    constexpr auto CodeIndex = buildCapabilityIndex<IndexKeys::Codes>();
+    static_assert(NameIndex.has_value() && CodeIndex.has_value());
+
+    /// @returns the number of the first capability with the given name or termcap code, if any.
+    constexpr optional<size_t> findCapability(string_view key) noexcept
+    {
+        auto const number = NameIndex->probe(key);
+        if (!number)
+            return nullopt;
+        auto const def = capabilityAt(*number);
+        if ((!def.name.empty() && def.name == key) || (def.code != Undefined && def.code == key))
+            return number;
+        return nullopt;
+    }
+
+    /// @returns the number of the first capability with the given termcap code, if any.
+    constexpr optional<size_t> findCapability(Code code) noexcept
+    {
+        auto const number = CodeIndex->probe(code);
+        if (!number || code == Undefined || capabilityAt(*number).code != code)
+            return nullopt;
+        return number;
+    }
+
+    template <typename T, size_t N>
+    constexpr T const* capabilityOf(std::array<T, N> const& caps,
+                                    size_t offset,
+                                    optional<size_t> number) noexcept
+    {
+        if (!number || *number < offset || *number - offset >= N)
+            return nullptr;
+        return &caps[*number - offset];
+    }
+
+    constexpr Boolean const* booleanOf(optional<size_t> number) noexcept
+    {
+        return capabilityOf(BooleanCaps, 0, number);
+    }
+
+    constexpr Numeric const* numericOf(optional<size_t> number) noexcept
+    {
+        return capabilityOf(NumericalCaps, BooleanCaps.size(), number);
+    }
+
+    constexpr String const* stringOf(optional<size_t> number) noexcept
+    {
+        return capabilityOf(StringCaps, BooleanCaps.size() + NumericalCaps.size(), number);
+    }
+
+    static_assert(numericOf(findCapability("colors"sv))->value == 256);
+    static_assert(booleanOf(findCapability("xn"_tcap))->name == "xenl"sv);
+    static_assert(stringOf(findCapability("dl"sv))->code == "DL"_tcap);
+    static_assert(stringOf(findCapability("dl"_tcap))->name == "dl1"sv);
+    static_assert(!findCapability("zz"sv) && !findCapability("zz"_tcap));
+    // }}}
 } // namespace
 
 bool StaticDatabase::booleanCapability(Code code) const
 {
-    for (auto const& cap: BooleanCaps)
-        if (cap.code.code == code.code)
-            return cap.value;
-
-    return false;
+    auto const* cap = booleanOf(findCapability(code));
+    return cap && cap->value;
 }
 
 unsigned StaticDatabase::numericCapability(Code code) const
 {
-    for (auto const& cap: NumericalCaps)
-        if (cap.code.code == code.code)
-            return cap.value;
-
-    return Npos;
+    auto const* cap = numericOf(findCapability(code));
+    return cap ? cap->value : Npos;
 }
 
 string_view StaticDatabase::stringCapability(Code code) const
 {
-    for (auto const& cap: StringCaps)
-        if (cap.code.code == code.code)
-            return cap.value;
-
-    return {};
+    auto const* cap = stringOf(findCapability(code));
+    return cap ? cap->value : string_view {};
 }
 
 bool StaticDatabase::booleanCapability(string_view name) const
 {
-    for (auto const tcap: BooleanCaps)
-        if (tcap.name == name || tcap.code == name)
-            return tcap.value;
-
-    return false;
+    auto const* cap = booleanOf(findCapability(name));
+    return cap && cap->value;
 }
 
 unsigned StaticDatabase::numericCapability(string_view name) const
 {
-    for (auto const tcap: NumericalCaps)
-        if (tcap.name == name || tcap.code == name)
-            return tcap.value;
-
-    return Npos;
+    auto const* cap = numericOf(findCapability(name));
+    return cap ? cap->value : Npos;
 }
 
 string_view StaticDatabase::stringCapability(string_view name) const
 {
-    for (auto const tcap: StringCaps)
-        if (tcap.name == name || tcap.code == name)
-            return tcap.value;
-
-    return {};
+    auto const* cap = stringOf(findCapability(name));
+    return cap ? cap->value : string_view {};
 }
 
 optional<Code> StaticDatabase::codeFromName(string_view name) const
 {
-    for (auto const& cap: NumericalCaps)
-        if (cap.name == name)
-            return cap.code;
-
-    for (auto const& cap: BooleanCaps)
-        if (cap.name == name)
-            return cap.code;
-
-    for (auto const& cap: StringCaps)
-        if (cap.name == name)
-            return cap.code;
-
-    // using ranges::views::concat;
-    // using ranges::views::transform;
-    // auto const tr = transform([](auto cap) { return std::pair { cap.name, cap.code }; });
-    // for (auto const cap: concat(numericalCaps | tr, booleanCaps | tr, stringCaps | tr))
-    //     if (cap.first == name)
-    //         return cap.second;
-
+    // NB: This misses names that a prior capability has as its code, of which there are none.
+    if (auto const number = findCapability(name); number && capabilityAt(*number).name == name)
+        return capabilityAt(*number).code;
     return nullopt;
 }
 
@@ -32,3 +32,31 @@ TEST_CASE("Capabilities.get")
     auto const bce = tcap.numericCapability("bce");
     REQUIRE(bce);
 }
+
+TEST_CASE("Capabilities.lookup")
+{
+    using vtbackend::capabilities::Code;
+    vtbackend::capabilities::StaticDatabase const tcap;
+
+    // Capabilities are found by their terminfo names and by their termcap codes.
+    CHECK(tcap.numericCapability("cols") == 80);
+    CHECK(tcap.numericCapability("co") == 80);
+    CHECK(tcap.numericCapability(Code { "co" }) == 80);
+    CHECK(tcap.booleanCapability("xenl"));
+    CHECK(tcap.booleanCapability(Code { "xn" }));
+    CHECK(tcap.stringCapability(Code { "kB" }) == "\033[Z");
+
+    // ... but only among those of the requested type.
+    CHECK(tcap.numericCapability("xenl") == vtbackend::capabilities::Database::Npos);
+    CHECK(tcap.stringCapability("cols").empty());
+    CHECK(!tcap.booleanCapability("nope"));
+    CHECK(!tcap.booleanCapability(Code { "zz" }));
+
+    // Keys had by several capabilities belong to the first of them.
+    CHECK(tcap.stringCapability("dl") == "\033[%p1%dM");
+    CHECK(tcap.stringCapability(Code { "dl" }) == "\033[M");
+
+    // Termcap codes are no names.
+    CHECK(tcap.codeFromName("dl1") == Code { "dl" });
+    CHECK(!tcap.codeFromName("co").has_value());
+}
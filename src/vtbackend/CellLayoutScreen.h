@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Screen.h>
+#include <vtbackend/cell/CompactCell.h>
+#include <vtbackend/cell/SimpleCell.h>
+#include <vtbackend/primitives.h>
+
+#include <crispy/assert.h>
+
+#include <gsl/pointers>
+
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+namespace vtbackend
+{
+
+/// Screen whose cell type is selected at runtime by a CellLayout.
+///
+/// Screen<Cell> is instantiated for each cell type, so that code agnostic of the cell type
+/// uses the screen through ScreenBase, and code depending on it visits the screen of the actual type.
+class CellLayoutScreen
+{
+  public:
+    CellLayoutScreen(CellLayout layout,
+                     Terminal& terminal,
+                     gsl::not_null<Margin*> margin,
+                     PageSize pageSize,
+                     bool reflowOnResize,
+                     MaxHistoryLineCount maxHistoryLineCount,
+                     std::string_view name):
+        _screen { create(layout, terminal, margin, pageSize, reflowOnResize, maxHistoryLineCount, name) }
+    {
+    }
+
+    [[nodiscard]] CellLayout layout() const noexcept { return static_cast<CellLayout>(_screen.index()); }
+
+    [[nodiscard]] ScreenBase& base() noexcept
+    {
+        return visit([](ScreenBase& screen) -> ScreenBase& { return screen; });
+    }
+
+    [[nodiscard]] ScreenBase const& base() const noexcept
+    {
+        return visit([](ScreenBase const& screen) -> ScreenBase const& { return screen; });
+    }
+
+    /// @returns the screen, which must be of the given cell type.
+    template <CellConcept Cell>
+    [[nodiscard]] Screen<Cell>& as() noexcept
+    {
+        Require(std::holds_alternative<std::unique_ptr<Screen<Cell>>>(_screen));
+        return *std::get<std::unique_ptr<Screen<Cell>>>(_screen);
+    }
+
+    template <CellConcept Cell>
+    [[nodiscard]] Screen<Cell> const& as() const noexcept
+    {
+        Require(std::holds_alternative<std::unique_ptr<Screen<Cell>>>(_screen));
+        return *std::get<std::unique_ptr<Screen<Cell>>>(_screen);
+    }
+
+    /// Invokes @p visitor with the screen of the actual cell type.
+    template <typename Visitor>
+    decltype(auto) visit(Visitor&& visitor)
+    {
+        return std::visit([&](auto& screen) -> decltype(auto) { return visitor(*screen); }, _screen);
+    }
+
+    template <typename Visitor>
+    decltype(auto) visit(Visitor&& visitor) const
+    {
+        return std::visit(
+            [&](auto const& screen) -> decltype(auto) { return visitor(std::as_const(*screen)); }, _screen);
+    }
+
+  private:
+    // Alternatives are in the order of CellLayout.
+    using ScreenVariant =
+        std::variant<std::unique_ptr<Screen<CompactCell>>, std::unique_ptr<Screen<SimpleCell>>>;
+
+    static ScreenVariant create(CellLayout layout,
+                                Terminal& terminal,
+                                gsl::not_null<Margin*> margin,
+                                PageSize pageSize,
+                                bool reflowOnResize,
+                                MaxHistoryLineCount maxHistoryLineCount,
+                                std::string_view name)
+    {
+        switch (layout)
+        {
+            case CellLayout::Compact:
+                return std::make_unique<Screen<CompactCell>>(
+                    terminal, margin, pageSize, reflowOnResize, maxHistoryLineCount, name);
+            case CellLayout::Simple:
+                return std::make_unique<Screen<SimpleCell>>(
+                    terminal, margin, pageSize, reflowOnResize, maxHistoryLineCount, name);
+        }
+        crispy::unreachable();
+    }
+
+    ScreenVariant _screen;
+};
+
+} // namespace vtbackend
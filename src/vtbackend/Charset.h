@@ -2,7 +2,9 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <string_view>
 
 namespace vtbackend
 {
@@ -77,6 +79,34 @@ class CharsetMapping
         return (*_tables[static_cast<std::size_t>(table)])[static_cast<std::uint8_t>(code)];
     }
 
+    /// Maps a run of printable US-ASCII characters (SP to '~') into @p output at once,
+    /// just like mapping each of them by map() would.
+    ///
+    /// Only the first character is subject to a pending single shift, so the remaining ones are
+    /// looked up in the selected table without any per character bookkeeping.
+    void map(std::string_view text, char32_t* output) noexcept
+    {
+        if (text.empty())
+            return;
+
+        output[0] = map(_tableForNextGraphic, text[0]);
+        auto const& table = *_tables[static_cast<std::size_t>(_selectedTable)];
+        for (std::size_t i = 1; i < text.size(); ++i)
+            output[i] = table[static_cast<std::uint8_t>(text[i])];
+        _tableForNextGraphic = _selectedTable;
+    }
+
+    /// @returns what map() maps @p code to next, without consuming a pending single shift.
+    [[nodiscard]] char32_t peek(char code) const noexcept { return map(_tableForNextGraphic, code); }
+
+    /// Tests whether the next and all following graphic characters map onto themselves, as they do
+    /// with US-ASCII designated, such that text may be written without being mapped at all.
+    [[nodiscard]] bool isIdentity() const noexcept
+    {
+        return _identityTables[static_cast<std::size_t>(_tableForNextGraphic)]
+               && _identityTables[static_cast<std::size_t>(_selectedTable)];
+    }
+
     constexpr void singleShift(CharsetTable table) noexcept { _tableForNextGraphic = table; }
 
     constexpr void lockingShift(CharsetTable table) noexcept
@@ -99,6 +129,7 @@ class CharsetMapping
     void select(CharsetTable table, CharsetId id) noexcept
     {
         _tables[static_cast<std::size_t>(table)] = charsetMap(id);
+        _identityTables[static_cast<std::size_t>(table)] = id == CharsetId::USASCII;
     }
 
   private:
@@ -107,6 +138,7 @@ class CharsetMapping
 
     using Tables = std::array<CharsetMap const*, 4>;
     Tables _tables;
+    std::array<bool, 4> _identityTables { true, true, true, true };
 };
 
 } // namespace vtbackend
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/CommandIndex.h>
+
+#include <algorithm>
+
+namespace vtbackend
+{
+
+void CommandIndex::startPrompt(int64_t line)
+{
+    // The same prompt may be reported twice, e.g. by OSC 133 as well as by SETMARK.
+    if (!_records.empty() && _records.back().prompt == line && !_records.back().output)
+        return;
+
+    while (!_records.empty() && _records.back().prompt >= line)
+        _records.pop_back();
+
+    _records.push_back(CommandRecord { .prompt = line });
+}
+
+void CommandIndex::startInput(int64_t line)
+{
+    if (!_records.empty() && !_records.back().output && !_records.back().finished())
+        _records.back().input = line;
+}
+
+void CommandIndex::startOutput(int64_t line)
+{
+    if (!_records.empty() && !_records.back().finished())
+        _records.back().output = line;
+}
+
+void CommandIndex::finish(int64_t lastOutputLine, std::optional<int> exitStatus)
+{
+    if (_records.empty() || _records.back().finished())
+        return;
+
+    auto& record = _records.back();
+    record.outputEnd = lastOutputLine;
+    record.exitStatus = exitStatus;
+}
+
+void CommandIndex::dropAbove(int64_t line) noexcept
+{
+    while (!_records.empty() && _records.front().prompt < line)
+        _records.pop_front();
+}
+
+void CommandIndex::reanchor(std::vector<int64_t> const& oldPromptLines,
+                            std::vector<int64_t> const& newPromptLines)
+{
+    // The oldest marked lines may have been dropped, so the most recent ones are matched up.
+    auto const shift =
+        static_cast<ptrdiff_t>(newPromptLines.size()) - static_cast<ptrdiff_t>(oldPromptLines.size());
+
+    auto records = std::deque<CommandRecord> {};
+    for (auto record: _records)
+    {
+        auto const i = std::ranges::lower_bound(oldPromptLines, record.prompt);
+        if (i == oldPromptLines.end() || *i != record.prompt)
+            continue;
+
+        auto const j = std::distance(oldPromptLines.begin(), i) + shift;
+        if (j < 0 || j >= static_cast<ptrdiff_t>(newPromptLines.size()))
+            continue;
+
+        auto const delta = newPromptLines[static_cast<size_t>(j)] - record.prompt;
+        auto const move = [delta](std::optional<int64_t>& line) {
+            if (line)
+                *line += delta;
+        };
+        record.prompt += delta;
+        move(record.input);
+        move(record.output);
+        move(record.outputEnd);
+
+        // Lines below the prompt reflow on their own, so the output is kept from running into
+        // the next prompt.
+        if (!records.empty() && records.back().outputEnd)
+            records.back().outputEnd = std::min(*records.back().outputEnd, record.prompt - 1);
+        records.push_back(record);
+    }
+    _records = std::move(records);
+}
+
+std::optional<size_t> CommandIndex::findAt(int64_t line) const noexcept
+{
+    auto const i = std::ranges::upper_bound(_records, line, {}, &CommandRecord::prompt);
+    if (i == _records.begin())
+        return std::nullopt;
+    return static_cast<size_t>(std::distance(i, _records.end()));
+}
+
+CommandIndex::OutputRange CommandIndex::outputOf(size_t n, int64_t currentLine) const noexcept
+{
+    auto const& record = fromNewest(n);
+    auto const top = record.output.value_or(record.input.value_or(record.prompt) + 1);
+
+    if (record.outputEnd)
+        return { .top = top, .bottom = *record.outputEnd };
+
+    if (n != 0)
+        return { .top = top, .bottom = fromNewest(n - 1).prompt - 1 };
+
+    return { .top = top, .bottom = currentLine - 1 };
+}
+
+} // namespace vtbackend
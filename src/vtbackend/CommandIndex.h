@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/primitives.h>
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace vtbackend
+{
+
+/// Shell command as reported by shell integration, i.e. OSC 133 or just a prompt mark (SETMARK).
+///
+/// Lines are numbered by the Grid's running line counter (see Grid::scrolledLineCount()),
+/// so that records need not be touched while the grid scrolls.
+struct CommandRecord
+{
+    int64_t prompt;                      // line the prompt starts at
+    std::optional<int64_t> input {};     // line the command is typed at (OSC 133 ; B)
+    std::optional<int64_t> output {};    // first output line (OSC 133 ; C)
+    std::optional<int64_t> outputEnd {}; // last output line, once finished (OSC 133 ; D)
+    std::optional<int> exitStatus {};    // as reported with OSC 133 ; D
+
+    [[nodiscard]] bool finished() const noexcept { return outputEnd.has_value(); }
+};
+
+/// Lines of an indexed shell command, as offsets into its Grid.
+struct CommandLines
+{
+    LineOffset prompt;
+    LineOffset outputTop;    // first output line
+    LineOffset outputBottom; // last output line, or the one above outputTop if there is no output
+    std::optional<int> exitStatus;
+
+    /// Whether the output is complete, i.e. the command has finished or another prompt followed.
+    bool complete = false;
+
+    [[nodiscard]] bool hasOutput() const noexcept { return outputTop <= outputBottom; }
+};
+
+/**
+ * Shell commands of a Grid in the order they have been run, maintained while the shell writes,
+ * so that e.g. the output of the n-th previous command is found without scanning the scrollback.
+ *
+ * Lines not reported by the shell are inferred: the output starts below the command line
+ * or prompt, and ends above the next prompt.
+ */
+class CommandIndex
+{
+  public:
+    /// Output lines of a record, numbered like the records themselves. See outputOf().
+    struct OutputRange
+    {
+        int64_t top;
+        int64_t bottom; // less than top if there is no output
+    };
+
+    /// Starts a new record at the given prompt line.
+    ///
+    /// Records at or below that line are dropped, as their lines have been overwritten,
+    /// e.g. after clearing the screen.
+    void startPrompt(int64_t line);
+
+    /// Notes the line the command of the most recent record is typed at.
+    void startInput(int64_t line);
+
+    /// Notes the first output line of the most recent record.
+    void startOutput(int64_t line);
+
+    /// Finishes the most recent record, with @p lastOutputLine being its last output line.
+    void finish(int64_t lastOutputLine, std::optional<int> exitStatus);
+
+    /// Drops the records whose prompt is above the given line, e.g. as it left the history.
+    void dropAbove(int64_t line) noexcept;
+
+    /// Moves the records along with their marked prompt lines, e.g. after the grid has been reflowed.
+    ///
+    /// Reflowing keeps the order of marked lines, so that the prompt line at the n-th most recent
+    /// position in @p oldPromptLines moves to that position in @p newPromptLines, both ascending.
+    /// Records whose prompt line is not marked anymore are dropped.
+    void reanchor(std::vector<int64_t> const& oldPromptLines,
+                  std::vector<int64_t> const& newPromptLines);
+
+    void clear() noexcept { _records.clear(); }
+
+    [[nodiscard]] bool empty() const noexcept { return _records.empty(); }
+    [[nodiscard]] size_t size() const noexcept { return _records.size(); }
+
+    /// @returns the n-th most recent record, 0 being the most recent one.
+    [[nodiscard]] CommandRecord const& fromNewest(size_t n) const noexcept
+    {
+        return _records[_records.size() - 1 - n];
+    }
+
+    /// @returns the position from the most recent record of the one the given line belongs to,
+    ///          i.e. the most recent one whose prompt is at or above that line.
+    [[nodiscard]] std::optional<size_t> findAt(int64_t line) const noexcept;
+
+    /// @returns the output lines of the n-th most recent record.
+    ///
+    /// @p currentLine  line the output of a command that has not finished yet extends to, exclusively.
+    [[nodiscard]] OutputRange outputOf(size_t n, int64_t currentLine) const noexcept;
+
+  private:
+    std::deque<CommandRecord> _records; // ascending prompt lines
+};
+
+} // namespace vtbackend
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/CommandIndex.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+
+TEST_CASE("CommandIndex.outputOf", "[CommandIndex]")
+{
+    auto index = CommandIndex {};
+    index.startPrompt(10);
+    index.startOutput(11);
+    index.finish(14, 0);
+
+    // Neither the output nor its end is reported, so both are inferred.
+    index.startPrompt(15);
+
+    // Still running.
+    index.startPrompt(20);
+    index.startInput(21);
+    index.startOutput(22);
+    index.startInput(22); // ignored, as the output has started already.
+
+    REQUIRE(index.size() == 3);
+    CHECK(index.fromNewest(2).exitStatus == 0);
+    CHECK(!index.fromNewest(1).finished());
+    CHECK(!index.fromNewest(0).finished());
+
+    auto const oldest = index.outputOf(2, 30);
+    CHECK(oldest.top == 11);
+    CHECK(oldest.bottom == 14);
+
+    auto const middle = index.outputOf(1, 30);
+    CHECK(middle.top == 16);
+    CHECK(middle.bottom == 19);
+
+    auto const newest = index.outputOf(0, 30);
+    CHECK(newest.top == 22);
+    CHECK(newest.bottom == 29);
+
+    index.finish(25, 1);
+    CHECK(index.fromNewest(0).exitStatus == 1);
+    CHECK(index.outputOf(0, 30).bottom == 25);
+}
+
+TEST_CASE("CommandIndex.startPrompt", "[CommandIndex]")
+{
+    auto index = CommandIndex {};
+    index.startPrompt(10);
+    index.startPrompt(10); // reported twice
+    CHECK(index.size() == 1);
+
+    index.startPrompt(20);
+    index.startPrompt(30);
+    REQUIRE(index.size() == 3);
+
+    // The screen has been cleared, so the prompt is written above the previous ones.
+    index.startPrompt(20);
+    REQUIRE(index.size() == 2);
+    CHECK(index.fromNewest(0).prompt == 20);
+    CHECK(index.fromNewest(1).prompt == 10);
+}
+
+TEST_CASE("CommandIndex.findAt", "[CommandIndex]")
+{
+    auto index = CommandIndex {};
+    index.startPrompt(10);
+    index.startPrompt(20);
+    index.startPrompt(30);
+
+    CHECK(!index.findAt(9).has_value());
+    CHECK(index.findAt(10) == 2);
+    CHECK(index.findAt(19) == 2);
+    CHECK(index.findAt(20) == 1);
+    CHECK(index.findAt(30) == 0);
+    CHECK(index.findAt(100) == 0);
+}
+
+TEST_CASE("CommandIndex.dropAbove", "[CommandIndex]")
+{
+    auto index = CommandIndex {};
+    index.startPrompt(10);
+    index.startPrompt(20);
+    index.startPrompt(30);
+
+    index.dropAbove(20);
+    REQUIRE(index.size() == 2);
+    CHECK(index.fromNewest(1).prompt == 20);
+
+    index.dropAbove(100);
+    CHECK(index.empty());
+}
+
+TEST_CASE("CommandIndex.reanchor", "[CommandIndex]")
+{
+    auto index = CommandIndex {};
+    index.startPrompt(10);
+    index.startOutput(11);
+    index.finish(19, 0);
+    index.startPrompt(20);
+    index.startOutput(21);
+    index.finish(29, 0);
+    index.startPrompt(30);
+
+    // The oldest mark has been pushed out, and the lines in between got wrapped or unwrapped.
+    index.reanchor({ 5, 10, 20, 30 }, { 12, 18, 24 });
+
+    REQUIRE(index.size() == 3);
+    CHECK(index.fromNewest(2).prompt == 12);
+    CHECK(index.fromNewest(2).output == 13);
+    CHECK(index.fromNewest(2).outputEnd == 17); // clamped above the next prompt
+    CHECK(index.fromNewest(1).prompt == 18);
+    CHECK(index.fromNewest(1).output == 19);
+    CHECK(index.fromNewest(1).outputEnd == 23); // clamped above the next prompt
+    CHECK(index.fromNewest(0).prompt == 24);
+
+    // Records whose prompt is not marked anymore are dropped.
+    index.reanchor({ 18, 24 }, { 18 });
+    REQUIRE(index.size() == 1);
+    CHECK(index.fromNewest(0).prompt == 18);
+}
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/FramePacer.h>
+
+#include <algorithm>
+
+using std::chrono::nanoseconds;
+
+namespace vtbackend
+{
+
+namespace
+{
+    int64_t refreshPeriodOf(RefreshRate refreshRate) noexcept
+    {
+        if (refreshRate.value <= 0.0)
+            return 0;
+        return std::chrono::duration_cast<nanoseconds>(RefreshInterval { refreshRate }.value).count();
+    }
+} // namespace
+
+FramePacer::FramePacer(RefreshRate refreshRate,
+                       std::chrono::milliseconds bulkOutputInterval,
+                       bool variableRefreshRate) noexcept:
+    _refreshPeriod { refreshPeriodOf(refreshRate) },
+    _bulkOutputInterval { std::chrono::duration_cast<nanoseconds>(bulkOutputInterval).count() },
+    _variableRefreshRate { variableRefreshRate }
+{
+}
+
+void FramePacer::setRefreshRate(RefreshRate refreshRate) noexcept
+{
+    _refreshPeriod = refreshPeriodOf(refreshRate);
+}
+
+void FramePacer::noteOutput(size_t bytes) noexcept
+{
+    _outputBytes += bytes;
+    if (_userInputPending.load())
+        _userInputAnswered = true;
+}
+
+void FramePacer::noteUserInput() noexcept
+{
+    _userInputPending = true;
+}
+
+void FramePacer::recordRenderTime(nanoseconds renderTime) noexcept
+{
+    // Exponential moving average over roughly the last eight frames, taking the first one as is.
+    auto const average = _averageRenderTime.load();
+    _averageRenderTime = average ? average + (renderTime.count() - average) / 8 : renderTime.count();
+}
+
+void FramePacer::frameRefreshed() noexcept
+{
+    _outputBytes = 0;
+    if (_userInputAnswered.exchange(false))
+        _userInputPending = false;
+}
+
+nanoseconds FramePacer::interval() const noexcept
+{
+    if (_userInputAnswered.load())
+        return nanoseconds(0);
+
+    auto const refreshPeriod = _refreshPeriod.load();
+    auto const renderTime = _averageRenderTime.load();
+    auto result = std::max(refreshPeriod, renderTime);
+
+    // Leave the render thread at least as much time idle as it spends rendering.
+    if (bulkOutput() || _ptyBacklog.load())
+        result = std::max({ result, _bulkOutputInterval, 2 * renderTime });
+
+    if (!_variableRefreshRate && refreshPeriod > 0)
+        result = (result + refreshPeriod - 1) / refreshPeriod * refreshPeriod;
+
+    return nanoseconds(result);
+}
+
+} // namespace vtbackend
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Settings.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace vtbackend
+{
+
+/**
+ * Decides how long to wait at least between two refreshes of the render buffer, i.e. two frames.
+ *
+ * Frames are refreshed at most at the display's refresh rate, and never more often than the render
+ * thread manages to render them. While the application keeps producing bulk output, frames are only
+ * refreshed every bulk output interval, so that the CPU is spent on parsing rather than on frames
+ * nobody gets to see. The same holds while more output is already pending on the PTY, however little
+ * arrived since the previous frame, as the next read would change the frame anyway; the bulk output
+ * interval thus bounds how stale the screen gets. Output answering user input is to be shown right away.
+ *
+ * Unless the display has a variable refresh rate, intervals are rounded up to whole refresh periods,
+ * as a frame missing a refresh is shown no earlier than the next one anyway.
+ *
+ * Output, user input, and render times may be reported from any thread.
+ */
+class FramePacer
+{
+  public:
+    /// Number of bytes of output between two frames from which on output is considered bulk output.
+    static constexpr inline size_t BulkOutputThreshold = 16 * 1024;
+
+    explicit FramePacer(RefreshRate refreshRate = {},
+                        std::chrono::milliseconds bulkOutputInterval = {},
+                        bool variableRefreshRate = false) noexcept;
+
+    void setRefreshRate(RefreshRate refreshRate) noexcept;
+
+    /// Remembers the given number of bytes of output having been parsed.
+    void noteOutput(size_t bytes) noexcept;
+
+    /// Remembers whether more PTY output is known to be pending right after the output parsed last.
+    void notePtyBacklog(bool backlog) noexcept { _ptyBacklog = backlog; }
+
+    /// Remembers input of the user, whose answer is to be shown as soon as it has been parsed.
+    void noteUserInput() noexcept;
+
+    /// Remembers the time it took to render a frame.
+    void recordRenderTime(std::chrono::nanoseconds renderTime) noexcept;
+
+    /// Must be invoked whenever the render buffer has been refreshed.
+    void frameRefreshed() noexcept;
+
+    /// @returns the minimum time from the previous frame to the next one.
+    [[nodiscard]] std::chrono::nanoseconds interval() const noexcept;
+
+    /// @returns whether more than BulkOutputThreshold bytes of output arrived since the previous frame.
+    [[nodiscard]] bool bulkOutput() const noexcept { return _outputBytes.load() >= BulkOutputThreshold; }
+
+    /// @returns the moving average of the time it took to render recent frames.
+    [[nodiscard]] std::chrono::nanoseconds averageRenderTime() const noexcept
+    {
+        return std::chrono::nanoseconds(_averageRenderTime.load());
+    }
+
+  private:
+    std::atomic<int64_t> _refreshPeriod; // in nanoseconds
+    int64_t _bulkOutputInterval;         // in nanoseconds
+    bool _variableRefreshRate;
+
+    std::atomic<size_t> _outputBytes = 0; // since the previous frame
+    std::atomic<bool> _ptyBacklog = false;
+    std::atomic<bool> _userInputPending = false;
+    std::atomic<bool> _userInputAnswered = false; // by output since the user input
+    std::atomic<int64_t> _averageRenderTime = 0;  // in nanoseconds
+};
+
+} // namespace vtbackend
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/FramePacer.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+using namespace std::chrono_literals;
+
+TEST_CASE("FramePacer.refreshRate")
+{
+    auto pacer = FramePacer { RefreshRate { 50.0 }, 100ms };
+    CHECK(pacer.interval() == 20ms);
+
+    // Frames are not rendered faster than they can be, and wait for the next refresh period.
+    pacer.recordRenderTime(30ms);
+    CHECK(pacer.averageRenderTime() == 30ms);
+    CHECK(pacer.interval() == 40ms);
+
+    pacer.recordRenderTime(38ms);
+    CHECK(pacer.averageRenderTime() == 31ms);
+}
+
+TEST_CASE("FramePacer.variableRefreshRate")
+{
+    auto pacer = FramePacer { RefreshRate { 50.0 }, 100ms, true };
+    pacer.recordRenderTime(30ms);
+    CHECK(pacer.interval() == 30ms);
+}
+
+TEST_CASE("FramePacer.bulkOutput")
+{
+    auto pacer = FramePacer { RefreshRate { 50.0 }, 100ms };
+    pacer.noteOutput(FramePacer::BulkOutputThreshold - 1);
+    CHECK_FALSE(pacer.bulkOutput());
+    CHECK(pacer.interval() == 20ms);
+
+    pacer.noteOutput(1);
+    CHECK(pacer.bulkOutput());
+    CHECK(pacer.interval() == 100ms);
+
+    pacer.frameRefreshed();
+    CHECK_FALSE(pacer.bulkOutput());
+    CHECK(pacer.interval() == 20ms);
+}
+
+TEST_CASE("FramePacer.userInput")
+{
+    auto pacer = FramePacer { RefreshRate { 50.0 }, 100ms };
+    pacer.noteUserInput();
+    CHECK(pacer.interval() == 20ms);
+
+    // The answer to the input is shown right away, even amidst bulk output.
+    pacer.noteOutput(FramePacer::BulkOutputThreshold);
+    CHECK(pacer.interval() == 0ms);
+
+    pacer.frameRefreshed();
+    pacer.noteOutput(FramePacer::BulkOutputThreshold);
+    CHECK(pacer.interval() == 100ms);
+}
+
+TEST_CASE("FramePacer.ptyBacklog")
+{
+    auto pacer = FramePacer { RefreshRate { 50.0 }, 100ms };
+    pacer.noteOutput(4096);
+    pacer.notePtyBacklog(true);
+    CHECK_FALSE(pacer.bulkOutput());
+    CHECK(pacer.interval() == 100ms);
+
+    // Once the backlog has been parsed, the frame is due at the refresh rate again.
+    pacer.notePtyBacklog(false);
+    CHECK(pacer.interval() == 20ms);
+
+    // The answer to user input is shown right away, even with more output pending.
+    pacer.noteUserInput();
+    pacer.noteOutput(1);
+    pacer.notePtyBacklog(true);
+    CHECK(pacer.interval() == 0ms);
+}
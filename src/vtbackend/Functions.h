@@ -150,6 +150,7 @@ constexpr inline auto RCOLORHIGHLIGHTFG = FunctionDocumentation { .mnemonic = "R
 constexpr inline auto RCOLORMOUSEBG = FunctionDocumentation { .mnemonic = "RCOLORMOUSEBG", .comment = "Reset mouse background color." };
 constexpr inline auto RCOLORMOUSEFG = FunctionDocumentation { .mnemonic = "RCOLORMOUSEFG", .comment = "Reset mouse foreground color." };
 constexpr inline auto RCOLPAL = FunctionDocumentation { .mnemonic = "RCOLPAL", .comment = "Reset color full palette or entry" };
+constexpr inline auto SEMANTICPROMPT = FunctionDocumentation { .mnemonic = "SEMANTICPROMPT", .comment = "Marks shell prompt, command, and output" };
 constexpr inline auto SETCOLPAL = FunctionDocumentation { .mnemonic = "SETCOLPAL", .comment = "Set/Query color palette" };
 constexpr inline auto SETCWD = FunctionDocumentation { .mnemonic = "SETCWD", .comment = "Set current working directory" };
 constexpr inline auto SETFONT = FunctionDocumentation { .mnemonic = "SETFONT", .comment = "Get or set font." };
@@ -613,6 +614,7 @@ constexpr inline auto RCOLORHIGHLIGHTFG = detail::OSC(119, VTExtension::XTerm, d
 constexpr inline auto RCOLORMOUSEBG     = detail::OSC(114, VTExtension::XTerm, documentation::RCOLORMOUSEBG);
 constexpr inline auto RCOLORMOUSEFG     = detail::OSC(113, VTExtension::XTerm, documentation::RCOLORMOUSEFG);
 constexpr inline auto RCOLPAL           = detail::OSC(104, VTExtension::XTerm, documentation::RCOLPAL);
+constexpr inline auto SEMANTICPROMPT    = detail::OSC(133, VTExtension::Unknown, documentation::SEMANTICPROMPT);
 constexpr inline auto SETCOLPAL         = detail::OSC(4, VTExtension::XTerm, documentation::SETCOLPAL);
 constexpr inline auto SETCWD            = detail::OSC(7, VTExtension::XTerm, documentation::SETCWD);
 constexpr inline auto SETFONT           = detail::OSC(50, VTExtension::XTerm, documentation::SETFONT);
@@ -775,6 +777,7 @@ constexpr static auto allFunctionsArray() noexcept
         RCOLORHIGHLIGHTFG,
         RCOLORHIGHLIGHTBG,
         NOTIFY,
+        SEMANTICPROMPT,
         DUMPSTATE,
     };
     return funcs;
@@ -791,10 +794,20 @@ inline auto allFunctions() noexcept
     return funcs;
 }
 
+/// Selects a FunctionDefinition based on a FunctionSelector.
+///
+/// @return the matching FunctionDefinition or nullptr if none matched.
+Function const* select(FunctionSelector const& selector,
+                       gsl::span<Function const> availableDefinition) noexcept;
+
 // Class to store all supported VT sequence and support properly enabling/disabling them
 // The storage stores all available definition at all time and is partitioned into
 // two parts first part contains all active sequences and last part contains all
 // disabled sequences
+//
+// The active sequences are additionally indexed by (category, final symbol) into a dense
+// jump table, such that selecting a function only needs to look at the very few
+// candidates sharing the same final symbol (usually one, at most a handful).
 class SupportedSequences
 {
 
@@ -831,6 +844,7 @@ class SupportedSequences
         gsl::span<Function> availableDefinition(begin(), _lastIndex);
         crispy::sort(availableDefinition,
                      [](Function const& a, Function const& b) constexpr { return compare(a, b); });
+        _buckets = buildIndex(activeSequences());
     }
 
     CRISPY_CONSTEXPR void disableSequence(Function seq) noexcept
@@ -841,6 +855,7 @@ class SupportedSequences
             // Move the disabled sequence to the end of array, keep the rest of active sequences sorted
             std::rotate(seqIter, seqIter + 1, _supportedSequences.data() + _supportedSequences.size());
             --_lastIndex;
+            _buckets = buildIndex(activeSequences());
         }
     }
 
@@ -855,20 +870,60 @@ class SupportedSequences
             ++_lastIndex;
             gsl::span<Function> arr(begin(), end());
             crispy::sort(arr, [](Function const& a, Function const& b) constexpr { return compare(a, b); });
+            _buckets = buildIndex(activeSequences());
         }
     }
 
+    /// Selects the active FunctionDefinition matching the given selector.
+    ///
+    /// @return the matching FunctionDefinition or nullptr if none matched.
+    [[nodiscard]] Function const* select(FunctionSelector const& selector) const noexcept
+    {
+        auto const bucket = _buckets[bucketIndex(selector.category, selector.finalSymbol)];
+        if (bucket.first == bucket.last)
+            return nullptr;
+        auto const candidates = activeSequences().subspan(bucket.first, bucket.last - bucket.first);
+        return vtbackend::select(selector, candidates);
+    }
+
   private:
+    // Range [first, last) of the sorted active sequences sharing the same category and final symbol.
+    struct Bucket
+    {
+        uint16_t first = 0;
+        uint16_t last = 0;
+    };
+
+    static constexpr size_t FinalSymbolCount = 128;
+    static constexpr size_t CategoryCount = 5;
+    using BucketTable = std::array<Bucket, CategoryCount * FinalSymbolCount>;
+
+    [[nodiscard]] static constexpr size_t bucketIndex(FunctionCategory category, char finalSymbol) noexcept
+    {
+        // Final symbols beyond 0x7F alias into a lower bucket, where select() then rejects them.
+        return (static_cast<size_t>(category) * FinalSymbolCount)
+               + (static_cast<uint8_t>(finalSymbol) % FinalSymbolCount);
+    }
+
+    // Relies on the active sequences being sorted by category first, and final symbol second.
+    [[nodiscard]] static constexpr BucketTable buildIndex(gsl::span<Function const> sequences) noexcept
+    {
+        auto buckets = BucketTable {};
+        for (size_t i = 0; i < sequences.size(); ++i)
+        {
+            auto& bucket = buckets[bucketIndex(sequences[i].category, sequences[i].finalSymbol)];
+            if (bucket.first == bucket.last)
+                bucket.first = static_cast<uint16_t>(i);
+            bucket.last = static_cast<uint16_t>(i + 1);
+        }
+        return buckets;
+    }
+
     std::array<Function, allFunctionsArray().size()> _supportedSequences = allFunctions();
     size_t _lastIndex = allFunctions().size(); // No of total active sequences
+    BucketTable _buckets = buildIndex(activeSequences());
 };
 
-/// Selects a FunctionDefinition based on a FunctionSelector.
-///
-/// @return the matching FunctionDefinition or nullptr if none matched.
-Function const* select(FunctionSelector const& selector,
-                       gsl::span<Function const> availableDefinition) noexcept;
-
 /// Selects a FunctionDefinition based on given input Escape sequence fields.
 ///
 /// @p intermediate an optional intermediate character between (0x20 .. 0x2F)
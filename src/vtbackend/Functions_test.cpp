@@ -92,3 +92,36 @@ TEST_CASE("Functions.EnableAndDisable", "[Functions]")
     REQUIRE(f);
     CHECK(*f == DECSLRM);
 }
+
+TEST_CASE("Functions.SelectMatchesBinarySearch", "[Functions]")
+{
+    SupportedSequences availableSequences;
+    availableSequences.disableSequence(DECSLRM);
+
+    for (auto const& fn: allFunctions())
+    {
+        for (auto const argc: { 0, 1, 2, 4, int(fn.minimumParameters), int(fn.maximumParameters) })
+        {
+            auto const selector = FunctionSelector { .category = fn.category,
+                                                     .leader = fn.leader,
+                                                     .argc = argc,
+                                                     .intermediate = fn.intermediate,
+                                                     .finalSymbol = fn.finalSymbol };
+            INFO(std::format("function: {}, argc: {}", fn, argc));
+            CHECK(availableSequences.select(selector)
+                  == vtbackend::select(selector, availableSequences.activeSequences()));
+        }
+    }
+}
+
+TEST_CASE("Functions.SelectUnknown", "[Functions]")
+{
+    SupportedSequences const availableSequences;
+    auto const selector = FunctionSelector { .category = FunctionCategory::CSI,
+                                             .leader = '?',
+                                             .argc = 1,
+                                             .intermediate = 0,
+                                             .finalSymbol = 'Z' };
+    CHECK(availableSequences.select(selector) == nullptr);
+    CHECK(availableSequences.select(FunctionSelector { FunctionCategory::CSI, 0, 0, 0, '\xC1' }) == nullptr);
+}
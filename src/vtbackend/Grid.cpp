@@ -6,8 +6,13 @@
 #include <crispy/logstore.h>
 
 #include <algorithm>
+#include <cctype>
 #include <format>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <thread>
 
 using std::max;
 using std::min;
@@ -97,6 +102,39 @@ namespace detail
         return LineCount::cast_from(i);
     }
 
+    /// Appends the cells of @p line to @p output, without inflating the line itself.
+    template <CellConcept Cell>
+    void appendCells(typename Line<Cell>::InflatedBuffer& output, Line<Cell> const& line)
+    {
+        if (line.isInflatedBuffer())
+        {
+            auto const cells = line.cells();
+            output.insert(output.end(), cells.begin(), cells.end());
+            return;
+        }
+
+        auto const cells = line.isTrivialBuffer()  ? inflate<Cell>(line.trivialBuffer())
+                           : line.isPackedBuffer() ? inflate<Cell>(unpack(line.toPackedBuffer()))
+                                                   : inflate<Cell>(line.attributedBuffer());
+        output.insert(output.end(), cells.begin(), cells.end());
+    }
+
+    /// Invokes @p scan with the first codepoint of each column of the given line, or 0 for empty columns.
+    ///
+    /// Plain ASCII text of trivial lines is handed over in place, as it maps to one column per character.
+    template <CellConcept Cell, typename F>
+    auto scanLeadingCodepoints(Line<Cell> const& line, F&& scan)
+    {
+        if (line.isTrivialBuffer())
+        {
+            auto const text = line.trivialBuffer().text.view();
+            if (std::ranges::all_of(text, [](char ch) { return static_cast<unsigned char>(ch) < 0x80; }))
+                return scan(text);
+        }
+        auto const codepoints = line.leadingCodepoints();
+        return scan(std::u32string_view(codepoints));
+    }
+
 } // namespace detail
 // {{{ Grid impl
 template <CellConcept Cell>
@@ -114,7 +152,9 @@ Grid<Cell>::Grid(PageSize pageSize, bool reflowOnResize, MaxHistoryLineCount max
         }(),
         reflowOnResize,
         GraphicsAttributes {}) },
-    _linesUsed { pageSize.lines }
+    _linesUsed { pageSize.lines },
+    _lineBufferPool { std::make_shared<LineBufferPool<Cell>>(pageSize.columns) },
+    _lineDamageStamps(unbox<size_t>(pageSize.lines), 0)
 {
     verifyState();
 }
@@ -122,21 +162,651 @@ Grid<Cell>::Grid(PageSize pageSize, bool reflowOnResize, MaxHistoryLineCount max
 template <CellConcept Cell>
 void Grid<Cell>::setMaxHistoryLineCount(MaxHistoryLineCount maxHistoryLineCount)
 {
+    refreshStaleLines();
     verifyState();
+    reflowPendingHistory();
+
+    // The oldest lines beyond the new limit fall off the history, as if they had been scrolled out.
+    if (auto const* maxLineCount = std::get_if<LineCount>(&maxHistoryLineCount))
+        trimHistory(*maxLineCount);
+
+    // The history lies at the end of the ring, where it has to be again once the ring is resized.
+    // It is hence moved right below the page for resizing the unused lines behind it.
     rezeroBuffers();
+    auto const pageLines = unbox<long>(_pageSize.lines);
+    auto const historyLines = unbox<long>(historyLineCount());
+    std::rotate(_lines.storage().begin() + pageLines,
+                _lines.storage().end() - historyLines,
+                _lines.storage().end());
+
+    markPageDamaged();
     _historyLimit = maxHistoryLineCount;
+    _pagedInLineCount = LineCount(0);
     _lines.resize(unbox<size_t>(_pageSize.lines + this->maxHistoryLineCount()));
+    std::rotate(_lines.storage().begin() + pageLines,
+                _lines.storage().begin() + pageLines + historyLines,
+                _lines.storage().end());
     _linesUsed = min(_linesUsed, _pageSize.lines + this->maxHistoryLineCount());
+    if (_searchIndex)
+        _searchIndex->limit(unbox<size_t>(historyLineCount()));
+    _markerIndex.limit(unbox<size_t>(historyLineCount()));
+    _wrapIndex.limit(unbox<size_t>(historyLineCount()));
+    verifyState();
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::packColdHistory()
+{
+    auto const top = std::max(_touchedColdLineTop,
+                              absoluteLineOf(-boxed_cast<LineOffset>(historyLineCount())));
+    auto const bottom = std::min(_touchedColdLineBottom,
+                                 absoluteLineOf(-boxed_cast<LineOffset>(_coldHistoryThreshold + 1)));
+    for (auto line = top; line <= bottom; ++line)
+        _lines[unbox(lineOffsetOf(line))].packIntoColdBuffer();
+
+    _touchedColdLineTop = std::numeric_limits<int64_t>::max();
+    _touchedColdLineBottom = std::numeric_limits<int64_t>::min();
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::unpackColdLines(LineOffset top, LineCount count)
+{
+    auto const first = std::max(top, -boxed_cast<LineOffset>(historyLineCount()));
+    auto const coldEnd = -boxed_cast<LineOffset>(_coldHistoryThreshold);
+    for (auto line = first; line < std::min(top + boxed_cast<LineOffset>(count), coldEnd); ++line)
+        lineAt(line).unpackColdBuffer();
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::compact()
+{
+    refreshStaleLines();
+    auto const shrink = [](Line<Cell>& line) {
+        if (line.isInflatedBuffer())
+            line.inflatedBuffer().shrink_to_fit();
+    };
+
+    for (auto i = LineOffset(1); i <= boxed_cast<LineOffset>(historyLineCount()); ++i)
+        if (!lineAt(-i).packIntoColdBuffer())
+            shrink(lineAt(-i));
+
+    for (auto i = LineOffset(0); i < boxed_cast<LineOffset>(_pageSize.lines); ++i)
+        if (!lineAt(i).compactIntoAttributedBuffer())
+            shrink(lineAt(i));
+
+    // The lines not in use lie between the page and the oldest history line, and still hold
+    // whatever they have been holding before.
+    auto const unusedBegin = unbox<size_t>(_pageSize.lines);
+    auto const unusedEnd = _lines.size() - unbox<size_t>(historyLineCount());
+    if (std::holds_alternative<Infinite>(_historyLimit))
+    {
+        // An unlimited history only ever grows the ring, which is hence shrunk to the lines in use.
+        _lines.erase(unusedBegin, unusedEnd);
+        _lines.shrink_to_fit();
+    }
+    else
+        resetUnusedLines();
+
+    _lineBufferPool->clear();
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::resetUnusedLines()
+{
+    auto const unusedBegin = unbox<size_t>(_pageSize.lines);
+    auto const unusedEnd = _lines.size() - unbox<size_t>(historyLineCount());
+    for (auto i = unusedBegin; i < unusedEnd; ++i)
+        _lines[static_cast<long>(i)] =
+            Line<Cell> { defaultLineFlags(),
+                         TrivialLineBuffer { .displayWidth = _pageSize.columns,
+                                             .textAttributes = GraphicsAttributes() } };
+}
+
+template <CellConcept Cell>
+size_t Grid<Cell>::discardImagesAbove(LineOffset line)
+{
+    refreshStaleLines();
+    auto discarded = size_t { 0 };
+    auto const oldest = -boxed_cast<LineOffset>(historyLineCount());
+    for (auto i = std::min(line, boxed_cast<LineOffset>(_pageSize.lines)) - LineOffset(1); i >= oldest; --i)
+    {
+        // Only inflated lines can hold image fragments, as no other buffer can encode them.
+        auto& lineAbove = lineAt(i);
+        if (!lineAbove.isInflatedBuffer())
+            continue;
+
+        auto found = false;
+        for (Cell& cell: lineAbove.inflatedBuffer())
+        {
+            if (cell.imageFragment())
+            {
+                cell.discardImageFragment();
+                found = true;
+            }
+        }
+        discarded += found ? 1 : 0;
+    }
+    return discarded;
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::trimHistory(LineCount keep)
+{
+    if (historyLineCount() <= keep)
+        return;
+
+    refreshStaleLines();
+    auto const count = historyLineCount() - keep;
+    spillOldestLines(count);
+    droppedOldestLines(count);
+    _linesUsed -= count;
+    resetUnusedLines();
+
+    if (_searchIndex)
+        _searchIndex->limit(unbox<size_t>(historyLineCount()));
+    _markerIndex.limit(unbox<size_t>(historyLineCount()));
+    _wrapIndex.limit(unbox<size_t>(historyLineCount()));
+    _commandIndex.dropAbove(absoluteLineOf(-boxed_cast<LineOffset>(historyLineCount())));
     verifyState();
 }
 
+template <CellConcept Cell>
+Lines<Cell> Grid<Cell>::releaseLines()
+{
+    discardImagesAbove(boxed_cast<LineOffset>(_pageSize.lines));
+    clearHistory();
+
+    // Without history, the ring only needs to hold the page, which a limited history preallocates.
+    _historyLimit = LineCount(0);
+    _pagedInLineCount = LineCount(0);
+    _linesUsed = _pageSize.lines;
+    markPageDamaged();
+    auto lines = std::exchange(
+        _lines, detail::createLines<Cell>(_pageSize, LineCount(0), _reflowOnResize, GraphicsAttributes {}));
+    verifyState();
+    return lines;
+}
+
+template <CellConcept Cell>
+std::optional<Line<Cell>> Grid<Cell>::spilledLine(LineCount n) const
+{
+    if (n < LineCount(1) || n > spilledLineCount())
+        return std::nullopt;
+
+    auto spilled = _historySpillFile->read(unbox<size_t>(spilledLineCount() - n));
+    if (!spilled)
+        return std::nullopt;
+
+    return Line<Cell>(spilled->flags, std::move(spilled->buffer));
+}
+
+template <CellConcept Cell>
+LineCount Grid<Cell>::pageInSpilledLines(LineCount count)
+{
+    auto const n = std::min(count, spilledLineCount());
+    if (!*n)
+        return LineCount(0);
+
+    // The lines are read oldest first, and only taken off the spill file once all could be read.
+    auto pagedInLines = std::vector<Line<Cell>> {};
+    pagedInLines.reserve(unbox<size_t>(n));
+    for (auto i = n; i >= LineCount(1); --i)
+    {
+        auto line = spilledLine(i);
+        if (!line)
+        {
+            errorLog()("Failed to read from history spill file: {}", _historySpillFile->path().string());
+            return LineCount(0);
+        }
+        pagedInLines.emplace_back(std::move(*line));
+    }
+    _historySpillFile->truncate(spilledLineCount() - n);
+
+    refreshStaleLines();
+    gridLog()("Paging in {} spilled history lines.", n);
+
+    // Grows the ring by as many lines right above the oldest history line, at the end of the ring.
+    auto const oldHistoryLineCount = historyLineCount();
+    auto const newLines = unbox<long>(n);
+    auto const historyLines = unbox<long>(oldHistoryLineCount);
+    rezeroBuffers();
+    _lines.resize(_lines.size() + unbox<size_t>(n));
+    auto& storage = _lines.storage();
+    std::rotate(storage.end() - historyLines - newLines, storage.end() - newLines, storage.end());
+
+    // Lines spilled at another width are reflowed, or resized as the page's lines have been.
+    auto widthDiffers = false;
+    auto target = storage.end() - historyLines - newLines;
+    for (auto& line: pagedInLines)
+    {
+        widthDiffers = widthDiffers || line.size() != _pageSize.columns;
+        if (!_reflowOnResize && line.size() != _pageSize.columns)
+        {
+            line.resize(_pageSize.columns);
+            line.packIntoColdBuffer();
+        }
+        *target++ = std::move(line);
+    }
+    if (_reflowOnResize && widthDiffers)
+        _pendingReflowLineCount += n;
+
+    _pagedInLineCount += n;
+    _linesUsed += n;
+
+    // The indexes covering the whole history are extended by the lines above it.
+    auto const extendIndex = [&](HistoryLineIndex& index, auto included) {
+        if (index.size() != unbox<size_t>(oldHistoryLineCount))
+            return;
+        for (auto i = boxed_cast<LineOffset>(oldHistoryLineCount) + 1;
+             i <= boxed_cast<LineOffset>(historyLineCount());
+             ++i)
+            index.pushOldest(included(_lines[unbox(-i)]));
+    };
+    extendIndex(_markerIndex, [](Line<Cell> const& line) { return line.marked(); });
+    extendIndex(_wrapIndex, [](Line<Cell> const& line) { return line.wrapped(); });
+
+    verifyState();
+    return n;
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::spillPagedInLines()
+{
+    if (*_pagedInLineCount)
+        setMaxHistoryLineCount(_historyLimit);
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::spillOldestLines(LineCount count) noexcept
+{
+    if (!_historySpillFile)
+        return;
+
+    auto const oldest = boxed_cast<LineOffset>(-historyLineCount());
+    auto const n = std::min(count, _linesUsed);
+    for (auto i = LineOffset(0); i < boxed_cast<LineOffset>(n); ++i)
+    {
+        auto const& line = lineAt(oldest + i);
+        if (!_historySpillFile->append(line.flags(), line.toPackedBuffer()))
+        {
+            errorLog()("Failed to write to history spill file: {}", _historySpillFile->path().string());
+            _historySpillFile.reset();
+            return;
+        }
+    }
+}
+
 template <CellConcept Cell>
 void Grid<Cell>::clearHistory()
 {
     _linesUsed = _pageSize.lines;
+    _pendingReflowLineCount = LineCount(0);
+    markPageDamaged();
+    if (_historySpillFile)
+        _historySpillFile->clear();
+    if (_historyTextCache)
+        _historyTextCache->clear();
+    if (_searchIndex)
+        _searchIndex->clear();
+    _markerIndex.clear();
+    _wrapIndex.clear();
+    _commandIndex.dropAbove(absoluteLineOf(LineOffset(0)));
     verifyState();
 }
 
+template <CellConcept Cell>
+void Grid<Cell>::clearLines(LineOffset from,
+                            LineOffset to,
+                            LineFlags flags,
+                            GraphicsAttributes attributes) noexcept
+{
+    markLinesStale(from, to, flags, attributes);
+    if (from <= LineOffset(0) && boxed_cast<LineCount>(to) >= _pageSize.lines)
+        markPageDamaged();
+    else
+        for (auto line = from; line < to; ++line)
+            markLineDamaged(line);
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::markLinesStale(LineOffset from,
+                                LineOffset to,
+                                LineFlags flags,
+                                GraphicsAttributes attributes) noexcept
+{
+    refreshStaleLines();
+    from = std::max(from, LineOffset(0));
+    to = std::min(to, boxed_cast<LineOffset>(_pageSize.lines));
+    if (from >= to)
+        return;
+
+    ++_clearGeneration;
+    _staleLines = StaleLines { .from = from, .to = to, .flags = flags, .attributes = attributes };
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::refreshStaleLines() const noexcept
+{
+    if (!_staleLines)
+        return;
+
+    for (auto line = _staleLines->from; line < _staleLines->to; ++line)
+        if (isStaleLine(line))
+            resetStaleLine(_lines[unbox(line)]);
+    _staleLines.reset();
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::setHistoryDeduplicationEnabled(bool enabled)
+{
+    if (!enabled)
+        _historyTextCache.reset();
+    else if (!_historyTextCache)
+        _historyTextCache.emplace();
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::setSearchIndexEnabled(bool enabled)
+{
+    if (!enabled)
+        _searchIndex.reset();
+    else if (!_searchIndex)
+        _searchIndex.emplace();
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::updateSearchIndex()
+{
+    if (!_searchIndex)
+        return;
+
+    for (auto i = LineOffset::cast_from(_searchIndex->size()) + 1;
+         i <= boxed_cast<LineOffset>(historyLineCount());
+         ++i)
+        _searchIndex->pushOldest(_lines[unbox(-i)].searchSignature());
+}
+
+namespace
+{
+    /// Tests whether @p text occurs in @p codepoints, comparing each search text character against the
+    /// leading codepoint of a cell the same way CellUtil::beginsWith() does.
+    bool containsSearchText(std::u32string_view codepoints,
+                            std::u32string_view text,
+                            bool isCaseSensitive) noexcept
+    {
+        auto const matches = [isCaseSensitive](char32_t codepoint, char32_t ch) {
+            if (isCaseSensitive)
+                return codepoint == ch;
+            return static_cast<char32_t>(std::tolower(static_cast<int>(codepoint))) == ch;
+        };
+
+        for (size_t start = 0; start + text.size() <= codepoints.size(); ++start)
+        {
+            auto i = size_t { 0 };
+            while (i < text.size() && codepoints[start + i] != 0 && matches(codepoints[start + i], text[i]))
+                ++i;
+            if (i == text.size())
+                return true;
+        }
+        return false;
+    }
+} // namespace
+
+template <CellConcept Cell>
+std::vector<uint8_t> Grid<Cell>::findCandidateLines(std::u32string_view text,
+                                                    bool isCaseSensitive,
+                                                    LineOffset top,
+                                                    LineOffset bottom) const
+{
+    auto const lineCount = bottom >= top ? unbox<size_t>(bottom - top) + 1 : size_t { 0 };
+    if (text.empty() || lineCount < unbox<size_t>(ParallelSearchMinLineCount))
+        return {};
+
+    // Chunks are scanned in parallel, so lines must not be reset on their first access.
+    refreshStaleLines();
+
+    auto const query = TrigramSignature::of(text);
+    auto const pageBottom = boxed_cast<LineOffset>(_pageSize.lines) - 1;
+    auto candidates = std::vector<uint8_t>(lineCount, 0);
+
+    // Each chunk only writes its own (byte sized) entries, and only reads lines.
+    auto const scanChunk = [&](size_t first, size_t last) {
+        for (auto index = first; index != last; ++index)
+        {
+            auto const y = top + static_cast<int>(index);
+            auto const& line = _lines[unbox(y)];
+            if (line.wrapped() || (y < pageBottom && _lines[unbox(y) + 1].wrapped()))
+                candidates[index] = 1;
+            else if (_searchIndex && !_searchIndex->mayContain(y, query))
+                candidates[index] = 0;
+            else
+                candidates[index] = containsSearchText(line.leadingCodepoints(), text, isCaseSensitive);
+        }
+    };
+
+    auto const minChunkSize = unbox<size_t>(ParallelSearchMinLineCount) / 4;
+    auto const workerCount =
+        std::clamp(size_t { std::thread::hardware_concurrency() }, size_t { 1 }, lineCount / minChunkSize);
+    auto const chunkSize = (lineCount + workerCount - 1) / workerCount;
+
+    auto workers = std::vector<std::future<void>> {};
+    workers.reserve(workerCount - 1);
+    for (auto chunk = size_t { 1 }; chunk < workerCount; ++chunk)
+        workers.emplace_back(std::async(std::launch::async,
+                                        scanChunk,
+                                        chunk * chunkSize,
+                                        std::min((chunk + 1) * chunkSize, lineCount)));
+    scanChunk(0, std::min(chunkSize, lineCount));
+    for (auto& worker: workers)
+        worker.get();
+
+    return candidates;
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::rebuildHistoryLineIndexes()
+{
+    _markerIndex.clear();
+    _wrapIndex.clear();
+    for (auto i = LineOffset(1); i <= boxed_cast<LineOffset>(historyLineCount()); ++i)
+    {
+        _markerIndex.pushOldest(_lines[unbox(-i)].marked());
+        _wrapIndex.pushOldest(_lines[unbox(-i)].wrapped());
+    }
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::enableLineFlags(LineOffset line, LineFlags flags, bool enable) noexcept
+{
+    lineAt(line).setFlag(flags, enable);
+    if (flags.contains(LineFlag::Marked))
+        _markerIndex.set(line, enable);
+    if (flags.contains(LineFlag::Wrapped))
+        _wrapIndex.set(line, enable);
+}
+
+template <CellConcept Cell>
+std::optional<LineOffset> Grid<Cell>::findMarkedLineAbove(LineOffset line) const noexcept
+{
+    refreshStaleLines();
+    // Lines of the main page are not indexed, as they may still change at any time.
+    for (auto y = std::min(line, boxed_cast<LineOffset>(_pageSize.lines)) - 1; y >= LineOffset(0); --y)
+        if (_lines[unbox(y)].marked())
+            return y;
+
+    if (auto const marker = _markerIndex.findAbove(std::min(line, LineOffset(0))))
+        return marker;
+
+    // History lines above those covered by the index.
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+    auto const oldestIndexed = -LineOffset::cast_from(_markerIndex.size());
+    for (auto y = std::min(line, oldestIndexed) - 1; y >= top; --y)
+        if (_lines[unbox(y)].marked())
+            return y;
+
+    return std::nullopt;
+}
+
+template <CellConcept Cell>
+std::optional<LineOffset> Grid<Cell>::findMarkedLineBelow(LineOffset line, LineOffset bottom) const noexcept
+{
+    refreshStaleLines();
+    auto const oldestIndexed = -LineOffset::cast_from(_markerIndex.size());
+    auto y = std::max(line + 1, -boxed_cast<LineOffset>(historyLineCount()));
+
+    // History lines above those covered by the index.
+    for (; y < oldestIndexed && y <= bottom; ++y)
+        if (_lines[unbox(y)].marked())
+            return y;
+
+    if (y < LineOffset(0))
+    {
+        if (auto const marker = _markerIndex.findBelow(y - 1))
+            return *marker <= bottom ? marker : std::nullopt;
+        y = LineOffset(0);
+    }
+
+    for (; y <= bottom; ++y)
+        if (_lines[unbox(y)].marked())
+            return y;
+
+    return std::nullopt;
+}
+
+template <CellConcept Cell>
+std::optional<LineOffset> Grid<Cell>::findParagraphBoundaryAbove(LineOffset line) const noexcept
+{
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+    auto const start = std::min(line, boxed_cast<LineOffset>(_pageSize.lines) - 1);
+    auto belowEmpty = start < top || lineAt(start).empty();
+    for (auto y = start - 1; y >= top; --y)
+    {
+        auto const empty = lineAt(y).empty();
+        if (empty && !belowEmpty)
+            return y;
+        belowEmpty = empty;
+    }
+    return std::nullopt;
+}
+
+template <CellConcept Cell>
+std::optional<LineOffset> Grid<Cell>::findParagraphBoundaryBelow(LineOffset line,
+                                                                 LineOffset bottom) const noexcept
+{
+    auto const start = std::max(line, -boxed_cast<LineOffset>(historyLineCount()));
+    auto aboveEmpty = start > bottom || lineAt(start).empty();
+    for (auto y = start + 1; y <= bottom; ++y)
+    {
+        auto const empty = lineAt(y).empty();
+        if (empty && !aboveEmpty)
+            return y;
+        aboveEmpty = empty;
+    }
+    return std::nullopt;
+}
+
+template <CellConcept Cell>
+std::optional<CellLocation> Grid<Cell>::findPairLeft(CellLocation from,
+                                                     char32_t left,
+                                                     char32_t right,
+                                                     int initialDepth) const
+{
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+    auto depth = initialDepth;
+    auto startColumn = from.column.as<ptrdiff_t>();
+    for (auto y = from.line; y >= top; --y)
+    {
+        auto const column = detail::scanLeadingCodepoints(lineAt(y), [&](auto text) -> ptrdiff_t {
+            for (auto x = std::min(startColumn, std::ssize(text) - 1); x >= 0; --x)
+            {
+                auto const ch = static_cast<char32_t>(text[static_cast<size_t>(x)]);
+                if (ch == right)
+                    ++depth;
+                else if (ch == left)
+                    --depth;
+                else
+                    continue;
+                if (depth == 0)
+                    return x;
+            }
+            return -1;
+        });
+        if (column >= 0)
+            return CellLocation { .line = y, .column = ColumnOffset::cast_from(column) };
+        startColumn = std::numeric_limits<ptrdiff_t>::max();
+    }
+    return std::nullopt;
+}
+
+template <CellConcept Cell>
+std::optional<CellLocation> Grid<Cell>::findPairRight(
+    CellLocation from, char32_t left, char32_t right, int initialDepth, LineOffset bottom) const
+{
+    auto depth = initialDepth;
+    auto startColumn = from.column.as<ptrdiff_t>();
+    for (auto y = from.line; y <= bottom; ++y)
+    {
+        auto const column = detail::scanLeadingCodepoints(lineAt(y), [&](auto text) -> ptrdiff_t {
+            for (auto x = startColumn; x < std::ssize(text); ++x)
+            {
+                auto const ch = static_cast<char32_t>(text[static_cast<size_t>(x)]);
+                if (ch == left)
+                    ++depth;
+                else if (ch == right)
+                    --depth;
+                else
+                    continue;
+                if (depth == 0)
+                    return x;
+            }
+            return -1;
+        });
+        if (column >= 0)
+            return CellLocation { .line = y, .column = ColumnOffset::cast_from(column) };
+        startColumn = 0;
+    }
+    return std::nullopt;
+}
+
+template <CellConcept Cell>
+std::vector<int64_t> Grid<Cell>::markedAbsoluteLines() const
+{
+    auto lines = std::vector<int64_t> {};
+    auto const pageEnd = boxed_cast<LineOffset>(_pageSize.lines);
+    for (auto line = findMarkedLineAbove(pageEnd); line.has_value(); line = findMarkedLineAbove(*line))
+        if (!lineAt(*line).wrapped()) // lines wrapped by reflow inherit the mark of the line they continue
+            lines.push_back(absoluteLineOf(*line));
+    std::ranges::reverse(lines);
+    return lines;
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::startCommandPrompt(LineOffset line)
+{
+    _commandIndex.dropAbove(absoluteLineOf(-boxed_cast<LineOffset>(historyLineCount())));
+    _commandIndex.startPrompt(absoluteLineOf(line));
+}
+
+template <CellConcept Cell>
+std::optional<CommandLines> Grid<Cell>::command(size_t n, LineOffset currentLine) const noexcept
+{
+    if (n >= _commandIndex.size())
+        return std::nullopt;
+
+    auto const& record = _commandIndex.fromNewest(n);
+    auto const prompt = lineOffsetOf(record.prompt);
+    if (prompt < -boxed_cast<LineOffset>(historyLineCount()))
+        return std::nullopt;
+
+    auto const output = _commandIndex.outputOf(n, absoluteLineOf(currentLine));
+    auto const pageBottom = boxed_cast<LineOffset>(_pageSize.lines) - 1;
+    return CommandLines { .prompt = prompt,
+                          .outputTop = lineOffsetOf(output.top),
+                          .outputBottom = std::min(lineOffsetOf(output.bottom), pageBottom),
+                          .exitStatus = record.exitStatus,
+                          .complete = record.finished() || n != 0 };
+}
+
 template <CellConcept Cell>
 void Grid<Cell>::verifyState() const noexcept
 {
@@ -156,7 +826,7 @@ std::string Grid<Cell>::renderAllText() const
 
     for (auto y = LineOffset(0); y < LineOffset::cast_from(_lines.size()); ++y)
     {
-        text += lineText(y);
+        lineAt(y).appendText(text, false);
         text += '\n';
     }
 
@@ -168,9 +838,10 @@ std::string Grid<Cell>::renderMainPageText() const
 {
     std::string text;
 
+    text.reserve(unbox<size_t>(_pageSize.lines) * unbox<size_t>(_pageSize.columns + 1));
     for (auto line = LineOffset(0); line < unbox<LineOffset>(_pageSize.lines); ++line)
     {
-        text += lineText(line);
+        lineAt(line).appendText(text, false);
         text += '\n';
     }
 
@@ -181,14 +852,23 @@ template <CellConcept Cell>
 Line<Cell>& Grid<Cell>::lineAt(LineOffset line) noexcept
 {
     // Require(*line < *_pageSize.lines);
-    return _lines[unbox<long>(line)];
+    auto& result = _lines[unbox<long>(line)];
+    if (isStaleLine(line))
+        resetStaleLine(result);
+    result.setBufferPool(_lineBufferPool.get());
+    touchLine(line);
+    markLineDamaged(line);
+    return result;
 }
 
 template <CellConcept Cell>
 Line<Cell> const& Grid<Cell>::lineAt(LineOffset line) const noexcept
 {
     // Require(*line < *_pageSize.lines);
-    return const_cast<Grid&>(*this).lineAt(line);
+    auto const& result = _lines[unbox<long>(line)];
+    if (isStaleLine(line))
+        resetStaleLine(result);
+    return result;
 }
 
 template <CellConcept Cell>
@@ -206,12 +886,15 @@ Cell& Grid<Cell>::useCellAt(LineOffset line, ColumnOffset column) noexcept
 template <CellConcept Cell>
 Cell const& Grid<Cell>::at(LineOffset line, ColumnOffset column) const noexcept
 {
-    return const_cast<Grid&>(*this).at(line, column);
+    // Not going through the non-const lineAt(), as reading a cell must not mark its line as damaged.
+    return const_cast<Line<Cell>&>(lineAt(line)).useCellAt(column);
 }
 
 template <CellConcept Cell>
 gsl::span<Line<Cell>> Grid<Cell>::pageAtScrollOffset(ScrollOffset scrollOffset)
 {
+    refreshStaleLines();
+    markPageDamaged();
     Require(unbox<LineCount>(scrollOffset) <= historyLineCount());
 
     int const offset = -*scrollOffset;
@@ -224,6 +907,7 @@ gsl::span<Line<Cell>> Grid<Cell>::pageAtScrollOffset(ScrollOffset scrollOffset)
 template <CellConcept Cell>
 gsl::span<Line<Cell> const> Grid<Cell>::pageAtScrollOffset(ScrollOffset scrollOffset) const
 {
+    refreshStaleLines();
     Require(unbox<LineCount>(scrollOffset) <= historyLineCount());
 
     int const offset = -*scrollOffset;
@@ -257,53 +941,54 @@ std::string Grid<Cell>::lineText(LineOffset lineOffset) const
 {
     std::string line;
     line.reserve(unbox<size_t>(_pageSize.columns));
-
-    int skipCount = 0;
-    for (Cell const& cell: lineBuffer(lineOffset))
-    {
-        if (skipCount > 0)
-        {
-            skipCount--;
-            continue;
-        }
-        if (cell.codepointCount())
-            line += cell.toUtf8();
-        else
-            line += ' '; // fill character
-        skipCount = cell.width() - 1;
-    }
-
+    lineAt(lineOffset).appendText(line, false);
     return line;
 }
 
 template <CellConcept Cell>
 std::string Grid<Cell>::lineTextTrimmed(LineOffset lineOffset) const
 {
-    std::string output = lineText(lineOffset);
-    while (!output.empty() && isspace(output.back()))
-        output.pop_back();
+    std::string output;
+    lineAt(lineOffset).appendText(output, true);
     return output;
 }
 
 template <CellConcept Cell>
-std::string Grid<Cell>::lineText(Line<Cell> const& line) const
+GridSnapshot<Cell> Grid<Cell>::snapshot(LineCount historyLineCount) const
 {
-    std::stringstream sstr;
-    int skipCount = 0;
-    for (Cell const& cell: line.inflatedBuffer())
+    refreshStaleLines();
+    auto const count = std::min(historyLineCount, this->historyLineCount());
+    auto lines = std::vector<Line<Cell>> {};
+    lines.reserve(unbox<size_t>(count + _pageSize.lines));
+    for (auto i = -boxed_cast<LineOffset>(count); i < boxed_cast<LineOffset>(_pageSize.lines); ++i)
     {
-        if (skipCount > 0)
+        auto const& line = _lines[unbox(i)];
+        if (line.isTrivialBuffer())
         {
-            skipCount--;
+            // Trivial lines reference this grid's text buffer pool, which must not be released into
+            // from another thread, so they are handed out packed instead.
+            lines.emplace_back(line.flags(), line.toPackedBuffer());
             continue;
         }
-        if (cell.codepointCount() == 0)
-            sstr << ' ';
-        else
-            sstr << cell.toUtf8();
-        skipCount = cell.width() - 1;
+        lines.emplace_back(line);
+        lines.back().setBufferPool(nullptr);
+
+        // Image fragments are discarded as with releaseLines(), as the snapshot may be destroyed on
+        // another thread than this grid is used on, and outlive the images otherwise.
+        if (lines.back().isInflatedBuffer())
+            for (Cell& cell: lines.back().inflatedBuffer())
+                if (cell.imageFragment())
+                    cell.discardImageFragment();
     }
-    return sstr.str();
+    return GridSnapshot<Cell>(_pageSize, count, std::move(lines));
+}
+
+template <CellConcept Cell>
+std::string Grid<Cell>::lineText(Line<Cell> const& line) const
+{
+    std::string text;
+    line.appendText(text, false);
+    return text;
 }
 
 template <CellConcept Cell>
@@ -331,42 +1016,93 @@ bool Grid<Cell>::isLineBlank(LineOffset line) const noexcept
 template <CellConcept Cell>
 int Grid<Cell>::computeLogicalLineNumberFromBottom(LineCount n) const noexcept
 {
-    int logicalLineCount = 0;
-    auto outputRelativePhysicalLine = *_pageSize.lines - 1;
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+    auto line = boxed_cast<LineOffset>(_pageSize.lines) - 1;
 
-    auto i = _lines.rbegin();
-    while (i != _lines.rend())
-    {
-        if (!i->wrapped())
-            logicalLineCount++;
-        outputRelativePhysicalLine--;
-        ++i;
-        if (logicalLineCount == *n)
-            break;
-    }
+    // Skip the bottom-most n logical lines, and then continue up to the beginning
+    // of the logical line right above them.
+    for (auto i = 0; i < unbox(n) && line >= top; ++i)
+        line = logicalLineTop(line) - 1;
+    if (line >= top)
+        line = logicalLineTop(line);
 
-    // XXX If the top-most logical line is reached, we still need to traverse upwards until the
-    // beginning of the top-most logical line (the one that does not have the wrapped-flag set).
-    while (i != _lines.rend() && i->wrapped())
-    {
-        // printf("further upwards: l %d, p %d\n", logicalLineCount, outputRelativePhysicalLine);
-        outputRelativePhysicalLine--;
-        ++i;
-    }
+    return unbox(line);
+}
+
+template <CellConcept Cell>
+LineOffset Grid<Cell>::logicalLineTop(LineOffset line) const noexcept
+{
+    refreshStaleLines();
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+
+    // Lines of the main page are not indexed, as they may still change at any time.
+    while (line >= LineOffset(0) && line > top && _lines[unbox(line)].wrapped())
+        --line;
+
+    if (line < LineOffset(0) && unbox<size_t>(-line) <= _wrapIndex.size() && _wrapIndex.contains(line))
+        line = _wrapIndex.runTop(line) - 1;
+
+    // History lines above those covered by the index.
+    while (line > top && _lines[unbox(line)].wrapped())
+        --line;
 
-    return outputRelativePhysicalLine;
+    return std::max(line, top);
+}
+
+template <CellConcept Cell>
+LineOffset Grid<Cell>::logicalLineBottom(LineOffset line) const noexcept
+{
+    refreshStaleLines();
+    auto const bottom = boxed_cast<LineOffset>(_pageSize.lines) - 1;
+    auto const oldestIndexed = -LineOffset::cast_from(_wrapIndex.size());
+
+    // History lines above those covered by the index.
+    while (line < oldestIndexed - 1 && _lines[unbox(line) + 1].wrapped())
+        ++line;
+
+    if (line + 1 < LineOffset(0) && _wrapIndex.contains(line + 1))
+        line = _wrapIndex.runBottom(line + 1);
+
+    while (line < bottom && _lines[unbox(line) + 1].wrapped())
+        ++line;
+
+    return line;
 }
 // }}}
 // {{{ Grid impl: scrolling
+template <CellConcept Cell>
+void Grid<Cell>::markPageScrolledUp(LineCount n) noexcept
+{
+    auto const count = std::min(unbox<size_t>(n), _lineDamageStamps.size());
+    auto const leaving = std::next(_lineDamageStamps.begin(), static_cast<ptrdiff_t>(count));
+    auto const stamp = ++_damageStamp;
+
+    // The lines leaving the page for the history take their damage along, and so do new lines
+    // that are scrolled right through to the history.
+    if (count < unbox<size_t>(n))
+        _historyDamageStamp = stamp;
+    else if (count)
+        _historyDamageStamp =
+            std::max(_historyDamageStamp, *std::max_element(_lineDamageStamps.begin(), leaving));
+
+    auto const newLines =
+        std::shift_left(_lineDamageStamps.begin(), _lineDamageStamps.end(), static_cast<ptrdiff_t>(count));
+    std::fill(newLines, _lineDamageStamps.end(), stamp);
+    _scrolledLineCount += unbox<int64_t>(n);
+}
+
 template <CellConcept Cell>
 LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttributes defaultAttributes) noexcept
 {
+    refreshStaleLines();
     verifyState();
     // Number of lines in the ring buffer that are not yet
     // used by the grid system.
     auto const linesAvailable = LineCount::cast_from(_lines.size() - unbox<size_t>(_linesUsed));
     if (std::holds_alternative<Infinite>(_historyLimit) && linesAvailable < linesCountToScrollUp)
     {
+        // Growing the ring shifts the lines behind its zero index, so their damage stamps no longer apply.
+        markPageDamaged();
         auto const linesToAllocate = unbox(linesCountToScrollUp - linesAvailable);
 
         for ([[maybe_unused]] auto const _: ranges::views::iota(0, linesToAllocate))
@@ -377,16 +1113,16 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
         }
         return scrollUp(linesCountToScrollUp, defaultAttributes);
     }
+    markPageScrolledUp(linesCountToScrollUp);
     if (unbox<size_t>(_linesUsed) == _lines.size()) // with all grid lines in-use
     {
         // TODO: ensure explicit test for this case
+        spillOldestLines(linesCountToScrollUp);
+        droppedOldestLines(linesCountToScrollUp);
         rotateBuffersLeft(linesCountToScrollUp);
+        compactNewHistoryLines(linesCountToScrollUp);
 
-        // Initialize (/reset) new lines.
-        for (auto y = boxed_cast<LineOffset>(_pageSize.lines - linesCountToScrollUp);
-             y < boxed_cast<LineOffset>(_pageSize.lines);
-             ++y)
-            lineAt(y).reset(defaultLineFlags(), defaultAttributes);
+        resetNewLines(linesCountToScrollUp, defaultAttributes);
 
         return linesCountToScrollUp;
     }
@@ -411,14 +1147,13 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
         if (linesAppendCount < linesCountToScrollUp)
         {
             auto const incrementCount = linesCountToScrollUp - linesAppendCount;
+            spillOldestLines(incrementCount);
+            droppedOldestLines(incrementCount);
             rotateBuffersLeft(incrementCount);
 
-            // Initialize (/reset) new lines.
-            for (auto y = boxed_cast<LineOffset>(_pageSize.lines - linesCountToScrollUp);
-                 y < boxed_cast<LineOffset>(_pageSize.lines);
-                 ++y)
-                lineAt(y).reset(defaultLineFlags(), defaultAttributes);
+            resetNewLines(linesCountToScrollUp, defaultAttributes);
         }
+        compactNewHistoryLines(linesCountToScrollUp);
         return LineCount::cast_from(linesAppendCount);
     }
 }
@@ -426,6 +1161,7 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
 template <CellConcept Cell>
 LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes, Margin margin) noexcept
 {
+    refreshStaleLines();
     verifyState();
     Require(0 <= *margin.horizontal.from && *margin.horizontal.to < *_pageSize.columns);
     Require(0 <= *margin.vertical.from && *margin.vertical.to < *_pageSize.lines);
@@ -439,6 +1175,10 @@ LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes
         margin.vertical
         == Margin::Vertical { .from = LineOffset(0), .to = unbox<LineOffset>(_pageSize.lines) - 1 };
 
+    // Full-screen scrolling keeps track of the lines as they move.
+    if (!fullHorizontal || !fullVertical)
+        markPageDamaged();
+
     if (fullHorizontal)
     {
         if (fullVertical) // full-screen scroll-up
@@ -447,7 +1187,9 @@ LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes
         // scroll up only inside vertical margin with full horizontal extend
         auto const marginHeight = LineCount(margin.vertical.length());
         auto const n2 = std::min(n, marginHeight);
-        if (*n2 && n2 < marginHeight)
+        if (*n2 && n2 < marginHeight && canRotateMarginLines(margin.vertical, n2))
+            rotateMarginLines(margin.vertical, n2, true);
+        else if (*n2 && n2 < marginHeight)
         {
             // rotate line attribs
             for (auto topLineOffset = *margin.vertical.from; topLineOffset <= *margin.vertical.to - *n2;
@@ -496,9 +1238,46 @@ LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes
     return LineCount(0); // No full-margin lines scrolled up.
 }
 
+template <CellConcept Cell>
+void Grid<Cell>::rotateMarginLines(Margin::Vertical margin, LineCount n, bool up) noexcept
+{
+    // After rotating the ring, the lines within the margin are in place already. The lines outside
+    // the margin, together with the n lines scrolled out, form one circular segment right below the margin,
+    // which just needs to be rotated back by n lines.
+    //
+    // Scrolling up, the segment starts with the n bottom lines of the margin,
+    // and scrolling down, it starts right below the margin.
+    auto const segmentLength = *(_pageSize.lines - margin.length() + n);
+    auto const segmentStart = up ? *margin.to + 1 - *n : *margin.to + 1;
+
+    auto const reverseSegment = [&](int first, int last) noexcept {
+        while (first < last)
+            std::swap(_lines[segmentStart + first++], _lines[segmentStart + last--]);
+    };
+
+    if (up)
+    {
+        _lines.rotate_left(unbox<size_t>(n));
+        // rotate segment right by n
+        reverseSegment(0, segmentLength - 1);
+        reverseSegment(0, *n - 1);
+        reverseSegment(*n, segmentLength - 1);
+    }
+    else
+    {
+        _lines.rotate_right(unbox<size_t>(n));
+        // rotate segment left by n
+        reverseSegment(0, *n - 1);
+        reverseSegment(*n, segmentLength - 1);
+        reverseSegment(0, segmentLength - 1);
+    }
+}
+
 template <CellConcept Cell>
 void Grid<Cell>::scrollDown(LineCount vN, GraphicsAttributes const& defaultAttributes, Margin const& margin)
 {
+    refreshStaleLines();
+    markPageDamaged();
     verifyState();
     Require(vN >= LineCount(0));
 
@@ -523,7 +1302,12 @@ void Grid<Cell>::scrollDown(LineCount vN, GraphicsAttributes const& defaultAttri
         // move all lines up by N lines
         // bottom N lines are wiped out
 
+        // The most recent history lines are pulled into the page and wiped.
         rotateBuffersRight(n);
+        if (_searchIndex)
+            _searchIndex->dropNewest(unbox<size_t>(n));
+        _markerIndex.dropNewest(unbox<size_t>(n));
+        _wrapIndex.dropNewest(unbox<size_t>(n));
 
         for (Line<Cell>& line: mainPage().subspan(0, unbox<size_t>(n)))
             line.reset(defaultLineFlags(), defaultAttributes);
@@ -533,10 +1317,15 @@ void Grid<Cell>::scrollDown(LineCount vN, GraphicsAttributes const& defaultAttri
     if (fullHorizontal) // => but ont fully vertical
     {
         // scroll down only inside vertical margin with full horizontal extend
-        auto a = std::next(begin(_lines), *margin.vertical.from);
-        auto b = std::next(begin(_lines), *margin.vertical.to + 1 - *n);
-        auto c = std::next(begin(_lines), *margin.vertical.to + 1);
-        std::rotate(a, b, c);
+        if (canRotateMarginLines(margin.vertical, n))
+            rotateMarginLines(margin.vertical, n, false);
+        else
+        {
+            auto a = std::next(begin(_lines), *margin.vertical.from);
+            auto b = std::next(begin(_lines), *margin.vertical.to + 1 - *n);
+            auto c = std::next(begin(_lines), *margin.vertical.to + 1);
+            std::rotate(a, b, c);
+        }
         for (auto const i: ranges::views::iota(*margin.vertical.from, *margin.vertical.from + *n))
             _lines[i].reset(defaultLineFlags(), defaultAttributes);
     }
@@ -569,6 +1358,7 @@ void Grid<Cell>::scrollDown(LineCount vN, GraphicsAttributes const& defaultAttri
 template <CellConcept Cell>
 void Grid<Cell>::scrollLeft(GraphicsAttributes defaultAttributes, Margin margin) noexcept
 {
+    markPageDamaged();
     for (LineOffset lineNo = margin.vertical.from; lineNo <= margin.vertical.to; ++lineNo)
     {
         auto& line = lineAt(lineNo);
@@ -588,13 +1378,52 @@ void Grid<Cell>::scrollLeft(GraphicsAttributes defaultAttributes, Margin margin)
 template <CellConcept Cell>
 void Grid<Cell>::reset()
 {
+    refreshStaleLines();
+    markPageDamaged();
     _linesUsed = _pageSize.lines;
+    _pendingReflowLineCount = LineCount(0);
+    if (_historyTextCache)
+        _historyTextCache->clear();
+    if (_searchIndex)
+        _searchIndex->clear();
+    _markerIndex.clear();
+    _wrapIndex.clear();
+    _commandIndex.clear();
     _lines.rotate_right(_lines.zero_index());
     for (int i = 0; i < unbox(_pageSize.lines); ++i)
         _lines[i].reset(defaultLineFlags(), GraphicsAttributes {});
     verifyState();
 }
 
+template <CellConcept Cell>
+void Grid<Cell>::reset(PageSize newSize)
+{
+    // The lines still pending from the last clear are discarded along with all others.
+    _staleLines.reset();
+    if (newSize.columns != _pageSize.columns)
+        _lineBufferPool->setColumns(newSize.columns);
+    _lineDamageStamps.assign(unbox<size_t>(newSize.lines), 0);
+    markPageDamaged();
+    _pendingReflowLineCount = LineCount(0);
+    if (_historyTextCache)
+        _historyTextCache->clear();
+    if (_searchIndex)
+        _searchIndex->clear();
+    _markerIndex.clear();
+    _wrapIndex.clear();
+    _commandIndex.clear();
+
+    // Each line is reset to the new page width on its first access.
+    rezeroBuffers();
+    if (newSize.lines != _pageSize.lines)
+        _lines.resize(_lines.size() - unbox<size_t>(_pageSize.lines) + unbox<size_t>(newSize.lines));
+    _pageSize = newSize;
+    _linesUsed = newSize.lines;
+    markLinesStale(
+        LineOffset(0), boxed_cast<LineOffset>(newSize.lines), defaultLineFlags(), GraphicsAttributes {});
+    verifyState();
+}
+
 template <CellConcept Cell>
 CellLocation Grid<Cell>::growLines(LineCount newHeight, CellLocation cursor)
 {
@@ -648,8 +1477,20 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
     if (_pageSize == newSize)
         return currentCursorPos;
 
+    refreshStaleLines();
+
     gridLog()("resize {} -> {} (cursor {})", _pageSize, newSize, currentCursorPos);
 
+    _lineDamageStamps.assign(unbox<size_t>(newSize.lines), 0);
+    markPageDamaged();
+
+    // Resizing moves lines between page and history and may reflow them, see updateSearchIndex().
+    if (_searchIndex)
+        _searchIndex->clear();
+
+    if (newSize.columns != _pageSize.columns)
+        _lineBufferPool->setColumns(newSize.columns);
+
     // Growing in line count with scrollback lines present will move
     // the scrollback lines into the visible area.
     //
@@ -755,7 +1596,13 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
                     gridLog()("{} |> \"{}\"", msg, Line<Cell>(lineFlags, logicalLineBuffer).toUtf8());
                 };
 
-            for (int i = -*historyLineCount(); i < *_pageSize.lines; ++i)
+            // Lines above reflowStart keep their width for now and are reflowed lazily.
+            auto const reflowStart = eagerReflowStart();
+            auto const pendingReflowLineCount = boxed_cast<LineCount>(reflowStart) + historyLineCount();
+            for (int i = -*historyLineCount(); i < *reflowStart; ++i)
+                grownLines.emplace_back(std::move(_lines[i]));
+
+            for (int i = *reflowStart; i < *_pageSize.lines; ++i)
             {
                 auto& line = _lines[i];
                 // logLogicalLine(line.flags(), std::format("Line[{:>2}]: next line: \"{}\"", i,
@@ -816,6 +1663,7 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
 
             _lines = std::move(grownLines);
             _pageSize.columns = newColumnCount;
+            _pendingReflowLineCount = pendingReflowLineCount;
 
             auto const newHistoryLineCount = _linesUsed - _pageSize.lines;
             rotateBuffersLeft(newHistoryLineCount);
@@ -875,8 +1723,14 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
             shrinkedLines.reserve(totalLineCount);
             Require(totalLineCount == unbox<size_t>(this->totalLineCount()));
 
-            auto numLinesWritten = LineCount(0);
-            for (auto i = -*historyLineCount(); i < *_pageSize.lines; ++i)
+            // Lines above reflowStart keep their width for now and are reflowed lazily.
+            auto const reflowStart = eagerReflowStart();
+            auto const pendingReflowLineCount = boxed_cast<LineCount>(reflowStart) + historyLineCount();
+            for (auto i = -*historyLineCount(); i < *reflowStart; ++i)
+                shrinkedLines.emplace_back(std::move(_lines[i]));
+
+            auto numLinesWritten = pendingReflowLineCount;
+            for (auto i = *reflowStart; i < *_pageSize.lines; ++i)
             {
                 auto& line = _lines[i];
 
@@ -934,6 +1788,7 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
 
             _lines = std::move(shrinkedLines);
             _pageSize.columns = newColumnCount;
+            _pendingReflowLineCount = pendingReflowLineCount;
 
             verifyState();
             return cursor; // TODO
@@ -943,6 +1798,14 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
 
     CellLocation cursor = currentCursorPos;
 
+    // Lines pending reflow must not be pulled into the main page, nor be resized without reflow.
+    if (*_pendingReflowLineCount
+        && (!_reflowOnResize
+            || newSize.lines - _pageSize.lines > historyLineCount() - _pendingReflowLineCount))
+        reflowPendingHistory();
+
+    auto const promptLines = markedAbsoluteLines();
+
     // grow/shrink columns
     using crispy::comparison;
     switch (crispy::strongCompare(newSize.columns, _pageSize.columns))
@@ -961,11 +1824,206 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
     }
 
     Ensures(_pageSize == newSize);
+    rebuildHistoryLineIndexes();
+    _commandIndex.reanchor(promptLines, markedAbsoluteLines());
+
+    // The history lines resized or reflowed have not been packed.
+    touchHistory();
     verifyState();
 
     return cursor;
 }
 
+template <CellConcept Cell>
+std::vector<Line<Cell>> Grid<Cell>::reflowedLines(std::vector<Line<Cell>> lines) const
+{
+    auto const newColumnCount = _pageSize.columns;
+    auto const fitting =
+        std::ranges::all_of(lines, [&](auto const& line) { return line.size() == newColumnCount; });
+    if (!_reflowOnResize || fitting)
+    {
+        for (auto& line: lines)
+            if (line.size() != newColumnCount)
+                line.resize(newColumnCount);
+        return lines;
+    }
+
+    Lines<Cell> reflowed;
+    typename Line<Cell>::InflatedBuffer logicalLineBuffer;
+    LineFlags logicalLineFlags = LineFlag::None;
+    auto const flushLogicalLine = [&]() {
+        while (!logicalLineBuffer.empty() && logicalLineBuffer.back().empty())
+            logicalLineBuffer.pop_back();
+        if (logicalLineBuffer.empty())
+            reflowed.emplace_back(logicalLineFlags,
+                                  TrivialLineBuffer { .displayWidth = newColumnCount,
+                                                      .textAttributes = GraphicsAttributes {},
+                                                      .fillAttributes = GraphicsAttributes {} });
+        else
+            detail::addNewWrappedLines(
+                reflowed, newColumnCount, std::move(logicalLineBuffer), logicalLineFlags, true);
+        logicalLineBuffer.clear();
+    };
+
+    for (auto i = size_t { 0 }; i < lines.size(); ++i)
+    {
+        if (i == 0 || !lines[i].wrapped())
+        {
+            if (i != 0)
+                flushLogicalLine();
+            logicalLineFlags = lines[i].flags().without(LineFlag::Wrapped);
+        }
+        detail::appendCells(logicalLineBuffer, lines[i]);
+    }
+    if (!lines.empty())
+        flushLogicalLine();
+
+    auto result = std::vector<Line<Cell>> {};
+    result.reserve(reflowed.size());
+    for (auto& line: reflowed)
+    {
+        line.compactIntoAttributedBuffer();
+        result.emplace_back(std::move(line));
+    }
+    return result;
+}
+
+template <CellConcept Cell>
+void Grid<Cell>::reflowPendingHistory()
+{
+    if (!*_pendingReflowLineCount)
+        return;
+
+    gridLog()("reflow {} pending history lines to {} columns", _pendingReflowLineCount, _pageSize.columns);
+
+    auto const promptLines = markedAbsoluteLines();
+
+    using LineBuffer = typename Line<Cell>::InflatedBuffer;
+
+    auto const newColumnCount = _pageSize.columns;
+    auto const totalLineCount = unbox<size_t>(this->totalLineCount());
+
+    // The pending lines may have been left at different widths by multiple resizes,
+    // so each logical line is joined and then split again at the current page width.
+    //
+    // Chunks of whole logical lines are reflowed in parallel, each into its own list of lines.
+    // The lines are only read or moved, but never inflated in place, as inflating draws from
+    // (and resetting returns to) buffer pools that are not shared between threads.
+    auto const reflowChunk = [&](int first, int last, Lines<Cell>& reflowedLines) {
+        LineBuffer logicalLineBuffer;
+        LineFlags logicalLineFlags = LineFlag::None;
+
+        auto const flushLogicalLine = [&]() {
+            while (!logicalLineBuffer.empty() && logicalLineBuffer.back().empty())
+                logicalLineBuffer.pop_back();
+            if (logicalLineBuffer.empty())
+                reflowedLines.emplace_back(logicalLineFlags,
+                                           TrivialLineBuffer { .displayWidth = newColumnCount,
+                                                               .textAttributes = GraphicsAttributes {},
+                                                               .fillAttributes = GraphicsAttributes {} });
+            else
+                detail::addNewWrappedLines(
+                    reflowedLines, newColumnCount, std::move(logicalLineBuffer), logicalLineFlags, true);
+            logicalLineBuffer.clear();
+        };
+
+        auto pendingLogicalLine = false;
+        for (int i = first; i < last; ++i)
+        {
+            auto& line = _lines[i];
+            if (pendingLogicalLine && line.wrapped())
+            {
+                detail::appendCells(logicalLineBuffer, line);
+                continue;
+            }
+
+            if (pendingLogicalLine)
+                flushLogicalLine();
+            pendingLogicalLine = false;
+
+            if (line.isTrivialBuffer() && line.trivialBuffer().usedColumns <= newColumnCount
+                && (i + 1 == last || !_lines[i + 1].wrapped()))
+            {
+                line.trivialBuffer().displayWidth = newColumnCount;
+                reflowedLines.emplace_back(std::move(line));
+            }
+            else
+            {
+                logicalLineBuffer.clear();
+                detail::appendCells(logicalLineBuffer, line);
+                logicalLineFlags = line.flags().without(LineFlag::Wrapped);
+                pendingLogicalLine = true;
+            }
+        }
+        if (pendingLogicalLine)
+            flushLogicalLine();
+
+        for (auto& line: reflowedLines)
+            line.compactIntoAttributedBuffer();
+    };
+
+    auto const oldestLine = -*historyLineCount();
+    auto const pendingEnd = oldestLine + *_pendingReflowLineCount;
+
+    // Chunks begin at the next logical line after an even split of the pending lines.
+    auto const pendingLineCount = unbox<size_t>(_pendingReflowLineCount);
+    auto const workerCount = std::clamp(size_t { std::thread::hardware_concurrency() },
+                                        size_t { 1 },
+                                        pendingLineCount / unbox<size_t>(ParallelReflowMinLineCount) + 1);
+    auto chunkStarts = std::vector<int> { oldestLine };
+    for (auto chunk = size_t { 1 }; chunk < workerCount; ++chunk)
+    {
+        auto start = oldestLine + static_cast<int>(chunk * pendingLineCount / workerCount);
+        while (start < pendingEnd && _lines[start].wrapped())
+            ++start;
+        if (start < pendingEnd && start > chunkStarts.back())
+            chunkStarts.push_back(start);
+    }
+    chunkStarts.push_back(pendingEnd);
+
+    auto chunks = std::vector<Lines<Cell>>(chunkStarts.size() - 1);
+    auto workers = std::vector<std::future<void>> {};
+    workers.reserve(chunks.size() - 1);
+    for (auto chunk = size_t { 1 }; chunk < chunks.size(); ++chunk)
+        workers.emplace_back(std::async(std::launch::async,
+                                        reflowChunk,
+                                        chunkStarts[chunk],
+                                        chunkStarts[chunk + 1],
+                                        std::ref(chunks[chunk])));
+    reflowChunk(chunkStarts[0], chunkStarts[1], chunks[0]);
+    for (auto& worker: workers)
+        worker.get();
+
+    Lines<Cell> reflowedLines;
+    reflowedLines.reserve(totalLineCount);
+    for (auto& chunk: chunks)
+        for (auto& line: chunk)
+            reflowedLines.emplace_back(std::move(line));
+
+    for (int i = pendingEnd; i < *_pageSize.lines; ++i)
+        reflowedLines.emplace_back(std::move(_lines[i]));
+
+    _linesUsed = LineCount::cast_from(reflowedLines.size());
+    while (reflowedLines.size() < totalLineCount)
+        reflowedLines.emplace_back(defaultLineFlags(),
+                                   TrivialLineBuffer { .displayWidth = newColumnCount,
+                                                       .textAttributes = GraphicsAttributes {},
+                                                       .fillAttributes = GraphicsAttributes {} });
+
+    _lines = std::move(reflowedLines);
+    rotateBuffersLeft(_linesUsed - _pageSize.lines);
+    markPageDamaged();
+    _pendingReflowLineCount = LineCount(0);
+    if (_searchIndex)
+        _searchIndex->clear();
+    rebuildHistoryLineIndexes();
+    _commandIndex.reanchor(promptLines, markedAbsoluteLines());
+    touchHistory();
+    packColdHistory();
+
+    verifyState();
+}
+
 template <CellConcept Cell>
 void Grid<Cell>::clampHistory()
 {
@@ -1041,9 +2099,9 @@ std::string dumpGrid(Grid<Cell> const& grid)
 
 template <CellConcept Cell>
 CellLocationRange Grid<Cell>::wordRangeUnderCursor(CellLocation position,
-                                                   u32string_view wordDelimiters) const noexcept
+                                                   WordDelimiters const& wordDelimiters) const noexcept
 {
-    auto const left = [this, wordDelimiters, position]() {
+    auto const left = [this, &wordDelimiters, position]() {
         auto last = position;
         auto current = last;
 
@@ -1068,7 +2126,7 @@ CellLocationRange Grid<Cell>::wordRangeUnderCursor(CellLocation position,
         return last;
     }();
 
-    auto const right = [this, wordDelimiters, position]() {
+    auto const right = [this, &wordDelimiters, position]() {
         auto last = position;
         auto current = last;
 
@@ -1108,13 +2166,14 @@ CellLocationRange Grid<Cell>::wordRangeUnderCursor(CellLocation position,
 }
 
 template <CellConcept Cell>
-bool Grid<Cell>::cellEmptyOrContainsOneOf(CellLocation position, u32string_view delimiters) const noexcept
+bool Grid<Cell>::cellEmptyOrContainsOneOf(CellLocation position,
+                                          WordDelimiters const& delimiters) const noexcept
 {
     // Word selection may be off by one
     position.column = min(position.column, boxed_cast<ColumnOffset>(pageSize().columns - 1));
 
     auto const& cell = at(position.line, position.column);
-    return CellUtil::empty(cell) || delimiters.find(cell.codepoint(0)) != std::u32string_view::npos;
+    return CellUtil::empty(cell) || delimiters.contains(cell.codepoint(0));
 }
 
 template <CellConcept Cell>
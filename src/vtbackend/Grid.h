@@ -1,11 +1,19 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <vtbackend/CommandIndex.h>
 #include <vtbackend/GraphicsAttributes.h>
+#include <vtbackend/HistoryLineIndex.h>
+#include <vtbackend/HistoryTextCache.h>
+#include <vtbackend/HistorySpillFile.h>
 #include <vtbackend/Line.h>
+#include <vtbackend/MemoryUsage.h>
+#include <vtbackend/SearchIndex.h>
+#include <vtbackend/WordDelimiters.h>
 #include <vtbackend/cell/CellConcept.h>
 #include <vtbackend/primitives.h>
 
+#include <crispy/BufferObject.h>
 #include <crispy/algorithm.h>
 #include <crispy/assert.h>
 #include <crispy/defines.h>
@@ -21,8 +29,12 @@
 #include <gsl/span_ext>
 
 #include <algorithm>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace vtbackend
 {
@@ -101,8 +113,16 @@ constexpr bool operator!=(Margin const& a, PageSize b) noexcept
 }
 // }}}
 
+// Chunked, so that growing the history neither reallocates nor moves the lines already stored.
 template <CellConcept Cell>
-using Lines = crispy::ring<Line<Cell>>;
+using Lines = crispy::chunked_ring<Line<Cell>>;
+
+/// Default number of most recent history lines that are kept unpacked, see Grid::coldHistoryThreshold().
+constexpr auto DefaultColdHistoryThreshold = LineCount(10'000);
+
+/// Number of history lines right above the main page that are reflowed immediately on resize.
+/// Any history lines beyond that are reflowed lazily, see Grid::reflowPendingHistory().
+constexpr auto EagerReflowHistoryLineCount = LineCount(1'000);
 
 struct RenderPassHints
 {
@@ -566,6 +586,38 @@ struct ReverseLogicalLines
     }
 };
 
+/**
+ * Copy of a Grid's main page and most recent history lines, taken at one point in time.
+ *
+ * Cold history lines share their packed storage with the Grid, so that snapshotting deep history
+ * mostly copies reference counts. Readers such as screenshots can then work on the snapshot
+ * without holding the terminal lock while the Grid moves on.
+ */
+template <CellConcept Cell>
+class GridSnapshot
+{
+  public:
+    GridSnapshot(PageSize pageSize, LineCount historyLineCount, std::vector<Line<Cell>> lines):
+        _pageSize { pageSize }, _historyLineCount { historyLineCount }, _lines { std::move(lines) }
+    {
+        Require(_lines.size() == unbox<size_t>(_pageSize.lines + _historyLineCount));
+    }
+
+    [[nodiscard]] PageSize pageSize() const noexcept { return _pageSize; }
+    [[nodiscard]] LineCount historyLineCount() const noexcept { return _historyLineCount; }
+
+    /// @returns the line at the given offset, ranging from -historyLineCount() to the page bottom.
+    [[nodiscard]] Line<Cell> const& lineAt(LineOffset line) const noexcept
+    {
+        return _lines[unbox<size_t>(line + boxed_cast<LineOffset>(_historyLineCount))];
+    }
+
+  private:
+    PageSize _pageSize;
+    LineCount _historyLineCount;
+    std::vector<Line<Cell>> _lines;
+};
+
 /**
  * Manages the screen grid buffer (main screen + scrollback history).
  *
@@ -603,17 +655,145 @@ class Grid
 
     void reset();
 
+    /// Resets the grid to empty lines of the given page size, discarding history and main page contents.
+    ///
+    /// Unlike resize(), the lines are neither reshaped nor reflowed. They are reset lazily instead,
+    /// just like with clearLines(), which is cheap for a page that is to be cleared anyway,
+    /// such as the alternate screen when switched to via DECSET 1049.
+    void reset(PageSize newSize);
+
     // {{{ grid global properties
     [[nodiscard]] LineCount maxHistoryLineCount() const noexcept
     {
         if (auto const* maxLineCount = std::get_if<LineCount>(&_historyLimit))
-            return *maxLineCount;
+            return *maxLineCount + _pagedInLineCount;
         else
             return LineCount::cast_from(_lines.size()) - _pageSize.lines;
     }
 
+    /// Sets the history limit, spilling the oldest history lines beyond it to disk if a spill file is set.
     void setMaxHistoryLineCount(MaxHistoryLineCount maxHistoryLineCount);
 
+    /// Number of most recent history lines that are kept unpacked.
+    ///
+    /// History lines beyond that are serialized into a PackedLineBuffer and only unpacked again
+    /// explicitly, see unpackColdLines(), or when being inflated, e.g. by searching.
+    [[nodiscard]] LineCount coldHistoryThreshold() const noexcept { return _coldHistoryThreshold; }
+    void setColdHistoryThreshold(LineCount threshold) noexcept
+    {
+        _coldHistoryThreshold = threshold;
+        touchHistory();
+    }
+
+    /// Enables or disables identical trivial lines scrolling into history sharing their text.
+    /// See HistoryTextCache.
+    void setHistoryDeduplicationEnabled(bool enabled);
+    [[nodiscard]] bool historyDeduplicationEnabled() const noexcept { return _historyTextCache.has_value(); }
+
+    /// @returns the number of history lines that have been found to share the text of a previous line.
+    [[nodiscard]] size_t deduplicatedHistoryLineCount() const noexcept
+    {
+        return _historyTextCache ? _historyTextCache->hitCount() : 0;
+    }
+
+    /// Pool of cell buffers shared by all lines of this grid, sized by the page column count.
+    [[nodiscard]] LineBufferPool<Cell> const& lineBufferPool() const noexcept { return *_lineBufferPool; }
+
+    /// @returns the approximate number of bytes of memory taken by the lines of this grid,
+    ///          including the recycled cell buffers, but not the history spilled to disk.
+    ///
+    /// Only the line related parts of the result are filled in.
+    [[nodiscard]] MemoryUsage memoryUsage() const noexcept
+    {
+        auto result = MemoryUsage {};
+        result.inflatedLines =
+            _lineBufferPool->size() * unbox<size_t>(_lineBufferPool->columns()) * sizeof(Cell);
+        result.trivialLines = _historyTextBuffer ? _historyTextBuffer->capacity() : 0;
+        for (auto const& line: _lines)
+        {
+            (line.isInflatedBuffer() ? result.inflatedLines : result.trivialLines) += line.memoryUsage();
+            result.cellExtras += line.cellExtrasMemoryUsage();
+        }
+        return result;
+    }
+
+    /// Packs the history lines beyond the cold history threshold that may have been unpacked since
+    /// the last time, i.e. the lines accessed for modification or by unpackColdLines() meanwhile,
+    /// or any of them after touchHistory().
+    void packColdHistory();
+
+    /// Unpacks the cold history lines among the @p count lines from @p top on, e.g. while they are
+    /// viewed, so that reading them does not unpack them over and over again until packColdHistory().
+    void unpackColdLines(LineOffset top, LineCount count);
+
+    /// Records that any of the history lines may have been unpacked, e.g. by searching through them,
+    /// for packColdHistory() to walk all of them again.
+    void touchHistory() noexcept
+    {
+        _touchedColdLineTop = absoluteLineOf(-boxed_cast<LineOffset>(historyLineCount()));
+        _touchedColdLineBottom = absoluteLineOf(LineOffset(-1));
+    }
+
+    /// Compacts all lines as far as possible, e.g. while the terminal is not being shown.
+    ///
+    /// History lines are packed regardless of the cold history threshold and page lines are compacted.
+    /// Lines that can be neither have their excess capacity released, and so does the line buffer pool.
+    /// Lines are inflated or unpacked again as soon as they are written to or accessed.
+    ///
+    /// Lines not in use, e.g. since the history has been cleared, are emptied,
+    /// and with an unlimited history, removed altogether.
+    void compact();
+
+    /// Discards the image fragments of all lines above @p line, e.g. as they are not in view,
+    /// which frees the images no other cell refers to.
+    ///
+    /// @returns the number of lines that an image fragment has been discarded from.
+    size_t discardImagesAbove(LineOffset line);
+
+    /// Drops all but the @p keep most recent history lines, spilling them to disk if a spill file is set.
+    void trimHistory(LineCount keep);
+
+    /// Hands out all lines, leaving an empty page without any history behind, e.g. for destroying
+    /// the lines of a closed session on another thread.
+    ///
+    /// The image fragments of the lines are discarded beforehand, as freeing an image notifies
+    /// its pool and renderer, which must happen on the thread the grid is used on.
+    [[nodiscard]] Lines<Cell> releaseLines();
+
+    /// Sets the file that history lines falling off the in-memory history are appended to,
+    /// or nullptr to discard them instead, which is the default.
+    void setHistorySpillFile(std::shared_ptr<HistorySpillFile> file) noexcept
+    {
+        _historySpillFile = std::move(file);
+    }
+    [[nodiscard]] HistorySpillFile const* historySpillFile() const noexcept
+    {
+        return _historySpillFile.get();
+    }
+
+    /// Number of history lines that have been spilled to disk, beyond historyLineCount().
+    [[nodiscard]] LineCount spilledLineCount() const noexcept
+    {
+        return _historySpillFile ? _historySpillFile->lineCount() : LineCount(0);
+    }
+
+    /// Reads back a spilled history line, with 1 being the most recently spilled one.
+    [[nodiscard]] std::optional<Line<Cell>> spilledLine(LineCount n) const;
+
+    /// Moves up to @p count of the most recently spilled lines back into the history, above its oldest
+    /// line, e.g. for scrolling, searching or moving the vi cursor beyond it.
+    ///
+    /// The history limit is raised by as many lines, until spillPagedInLines().
+    ///
+    /// @returns the number of lines paged in.
+    LineCount pageInSpilledLines(LineCount count);
+
+    /// Number of lines paged in by pageInSpilledLines() the history limit has been raised by.
+    [[nodiscard]] LineCount pagedInLineCount() const noexcept { return _pagedInLineCount; }
+
+    /// Restores the history limit raised by pageInSpilledLines(), spilling the oldest lines beyond it again.
+    void spillPagedInLines();
+
     [[nodiscard]] LineCount totalLineCount() const noexcept
     {
         return maxHistoryLineCount() + _pageSize.lines;
@@ -634,6 +814,28 @@ class Grid
     ///
     /// @returns updated cursor position.
     [[nodiscard]] CellLocation resize(PageSize newSize, CellLocation currentCursorPos, bool wrapPending);
+
+    /// Number of oldest history lines that have not yet been reflowed to the current page width.
+    ///
+    /// On resize, only the main page and the EagerReflowHistoryLineCount lines above it are reflowed
+    /// right away. The remaining (older) lines keep their previous width until reflowPendingHistory()
+    /// is called, so that a quick succession of resizes only reflows them once.
+    [[nodiscard]] LineCount pendingReflowLineCount() const noexcept { return _pendingReflowLineCount; }
+
+    /// Reflows all history lines that are still pending from previous resizes to the current page width.
+    ///
+    /// The pending lines are split into chunks of whole logical lines, which are reflowed in parallel
+    /// by up to one worker thread per ParallelReflowMinLineCount lines.
+    void reflowPendingHistory();
+
+    /// Reflows @p lines, e.g. of a saved session, to the current page width as resizing would,
+    /// joining each logical line and splitting it again, or resizes them if reflow is disabled.
+    ///
+    /// @returns the lines at the current page width, oldest first.
+    [[nodiscard]] std::vector<Line<Cell>> reflowedLines(std::vector<Line<Cell>> lines) const;
+
+    /// Minimum number of pending history lines for each worker thread of reflowPendingHistory().
+    static constexpr auto ParallelReflowMinLineCount = LineCount(16'384);
     // }}}
 
     // {{{ Line API
@@ -648,6 +850,20 @@ class Grid
     [[nodiscard]] gsl::span<Cell const> lineBufferRightTrimmed(LineOffset line) const noexcept;
 
     [[nodiscard]] std::string lineText(LineOffset line) const;
+
+    /// Invokes @p sink with the text of the given line, as lineText() returns it, in one or more
+    /// std::string_view pieces, without copying the text of trivial lines nor inflating any line.
+    template <typename Sink>
+    void visitLineText(LineOffset line, Sink&& sink) const
+    {
+        lineAt(line).visitText(std::forward<Sink>(sink));
+    }
+
+    /// Copies the main page and up to @p historyLineCount of the most recent history lines.
+    ///
+    /// The copies are detached from this grid's line buffer pool and do not hold any image fragments,
+    /// so they may be read and destroyed on another thread while this grid is being written to.
+    [[nodiscard]] GridSnapshot<Cell> snapshot(LineCount historyLineCount = LineCount(0)) const;
     [[nodiscard]] std::string lineTextTrimmed(LineOffset line) const;
     [[nodiscard]] std::string lineText(Line<Cell> const& line) const;
 
@@ -662,6 +878,12 @@ class Grid
 
     [[nodiscard]] int computeLogicalLineNumberFromBottom(LineCount n) const noexcept;
 
+    /// @returns the first line of the logical line that @p line is part of.
+    [[nodiscard]] LineOffset logicalLineTop(LineOffset line) const noexcept;
+
+    /// @returns the last line of the logical line that @p line is part of.
+    [[nodiscard]] LineOffset logicalLineBottom(LineOffset line) const noexcept;
+
     [[nodiscard]] size_t zero_index() const noexcept { return _lines.zero_index(); }
     // }}}
 
@@ -678,6 +900,7 @@ class Grid
 
     [[nodiscard]] LogicalLines<Cell> logicalLines()
     {
+        refreshStaleLines();
         return LogicalLines<Cell> { boxed_cast<LineOffset>(-historyLineCount()),
                                     boxed_cast<LineOffset>(_pageSize.lines - 1),
                                     _lines };
@@ -685,11 +908,13 @@ class Grid
 
     [[nodiscard]] LogicalLines<Cell> logicalLinesFrom(LineOffset offset)
     {
+        refreshStaleLines();
         return LogicalLines<Cell> { offset, boxed_cast<LineOffset>(_pageSize.lines - 1), _lines };
     }
 
     [[nodiscard]] ReverseLogicalLines<Cell> logicalLinesReverse()
     {
+        refreshStaleLines();
         return ReverseLogicalLines<Cell> { boxed_cast<LineOffset>(-historyLineCount()),
                                            boxed_cast<LineOffset>(_pageSize.lines - 1),
                                            _lines };
@@ -697,6 +922,7 @@ class Grid
 
     [[nodiscard]] ReverseLogicalLines<Cell> logicalLinesReverseFrom(LineOffset offset)
     {
+        refreshStaleLines();
         return ReverseLogicalLines<Cell> { boxed_cast<LineOffset>(-historyLineCount()), offset, _lines };
     }
 
@@ -705,6 +931,18 @@ class Grid
     /// Completely deletes all scrollback lines.
     void clearHistory();
 
+    /// Resets the main page lines [@p from, @p to) to empty lines with the given flags and attributes.
+    ///
+    /// The lines are not reset right away. Bumping the clear generation marks them stale instead,
+    /// and each one is reset on its next access, which makes clearing cost O(1) in the number of cells.
+    void clearLines(LineOffset from, LineOffset to, LineFlags flags, GraphicsAttributes attributes) noexcept;
+
+    /// Resets the lines still pending from the last clearLines() right away.
+    ///
+    /// Needed before reading lines from multiple threads at once, as the first access of a stale line
+    /// resets it, even through const access.
+    void refreshStaleLines() const noexcept;
+
     /// Scrolls up by @p n lines within the given margin.
     ///
     /// @param n number of lines to scroll up within the given margin.
@@ -734,7 +972,26 @@ class Grid
     [[nodiscard]] RenderPassHints render(
         RendererT&& render,
         ScrollOffset scrollOffset = {},
-        HighlightSearchMatches highlightSearchMatches = HighlightSearchMatches::Yes) const;
+        HighlightSearchMatches highlightSearchMatches = HighlightSearchMatches::Yes) const
+    {
+        refreshStaleLines();
+        return renderLines(std::forward<RendererT>(render),
+                           LineOffset(0),
+                           boxed_cast<LineOffset>(_pageSize.lines),
+                           scrollOffset,
+                           highlightSearchMatches);
+    }
+
+    /// Renders only the visible lines in the range [firstLine, endLine) of the page.
+    ///
+    /// This does not modify the grid, so that distinct line ranges can be rendered concurrently,
+    /// once refreshStaleLines() has been called.
+    template <typename RendererT>
+    [[nodiscard]] RenderPassHints renderLines(RendererT&& render,
+                                              LineOffset firstLine,
+                                              LineOffset endLine,
+                                              ScrollOffset scrollOffset,
+                                              HighlightSearchMatches highlightSearchMatches) const;
 
     /// Takes text-screenshot of the main page.
     [[nodiscard]] std::string renderMainPageText() const;
@@ -745,6 +1002,166 @@ class Grid
     [[nodiscard]] std::string renderAllText() const;
     // }}}
 
+    // {{{ Damage tracking API
+    /// Monotonic stamp, increased with every change to the lines of the main page.
+    [[nodiscard]] uint64_t damageStamp() const noexcept { return _damageStamp; }
+
+    /// Number of lines the full page has been scrolled up by in total.
+    ///
+    /// A line's offset plus this count identifies the line across scrolling, until the page is
+    /// damaged as a whole.
+    [[nodiscard]] int64_t scrolledLineCount() const noexcept { return _scrolledLineCount; }
+
+    /// Tests whether the given line may have been changed after the given damage stamp.
+    ///
+    /// The lines of the main page keep their stamps while scrolling up, and all history lines share one.
+    [[nodiscard]] bool isLineDamagedSince(LineOffset line, uint64_t stamp) const noexcept
+    {
+        if (_pageDamageStamp > stamp)
+            return true;
+        if (line < LineOffset(0))
+            return _historyDamageStamp > stamp;
+        auto const index = unbox<size_t>(line);
+        return index >= _lineDamageStamps.size() || _lineDamageStamps[index] > stamp;
+    }
+
+    /// Marks the given line as changed.
+    void markLineDamaged(LineOffset line) noexcept
+    {
+        if (line < LineOffset(0))
+            _historyDamageStamp = ++_damageStamp;
+        else if (unbox<size_t>(line) < _lineDamageStamps.size())
+            _lineDamageStamps[unbox<size_t>(line)] = ++_damageStamp;
+    }
+
+    /// Marks all lines, including the history, as changed, e.g. because they have been moved around.
+    void markPageDamaged() noexcept { _pageDamageStamp = ++_damageStamp; }
+
+    /// Moves the damage stamps of the main page up along with its lines, stamping the new lines.
+    void markPageScrolledUp(LineCount n) noexcept;
+    // }}}
+
+    // {{{ Search index API
+    /// Enables or disables the trigram index over the history lines, which lets searches
+    /// skip history lines that cannot contain the search text.
+    void setSearchIndexEnabled(bool enabled);
+    [[nodiscard]] bool searchIndexEnabled() const noexcept { return _searchIndex.has_value(); }
+
+    /// @returns the number of most recent history lines covered by the search index.
+    [[nodiscard]] LineCount indexedHistoryLineCount() const noexcept
+    {
+        return _searchIndex ? LineCount::cast_from(_searchIndex->size()) : LineCount(0);
+    }
+
+    /// Indexes the history lines not yet covered by the search index, e.g. after a resize.
+    void updateSearchIndex();
+
+    /// @returns false if the given logical line is known to not contain any text with the given signature.
+    ///
+    /// Logical lines spanning multiple lines are always considered candidates,
+    /// as the search text may wrap around between them.
+    [[nodiscard]] bool mayContain(LogicalLine<Cell> const& line, TrigramSignature const& query) const noexcept
+    {
+        if (!_searchIndex || line.top != line.bottom)
+            return true;
+        return _searchIndex->mayContain(line.top, query);
+    }
+
+    /// Minimum number of lines for findCandidateLines() to be worth scanning upfront.
+    static constexpr auto ParallelSearchMinLineCount = LineCount(4096);
+
+    /// Scans the lines from @p top to @p bottom for the given search text, split across worker threads.
+    ///
+    /// This only reads the lines, without inflating them, and can thus run the chunks
+    /// of the range concurrently.
+    ///
+    /// @returns one entry per line of the range, non-zero if the line may contain a match, that is,
+    ///          if its leading codepoints contain the search text, or if it is part of a logical line
+    ///          spanning multiple lines. The result is empty if the range is too small to be scanned
+    ///          upfront, see ParallelSearchMinLineCount.
+    [[nodiscard]] std::vector<uint8_t> findCandidateLines(std::u32string_view text,
+                                                          bool isCaseSensitive,
+                                                          LineOffset top,
+                                                          LineOffset bottom) const;
+    // }}}
+
+    // {{{ Marker API
+    /// Enables or disables the given flags on the given line, keeping the marker index up to date.
+    void enableLineFlags(LineOffset line, LineFlags flags, bool enable) noexcept;
+
+    /// @returns the nearest marked line above @p line, up to the oldest history line.
+    [[nodiscard]] std::optional<LineOffset> findMarkedLineAbove(LineOffset line) const noexcept;
+
+    /// @returns the nearest marked line below @p line, down to @p bottom.
+    [[nodiscard]] std::optional<LineOffset> findMarkedLineBelow(LineOffset line,
+                                                                LineOffset bottom) const noexcept;
+
+    /// @returns the number of most recent history lines covered by the marker index.
+    [[nodiscard]] LineCount markerIndexedHistoryLineCount() const noexcept
+    {
+        return LineCount::cast_from(_markerIndex.size());
+    }
+    // }}}
+
+    // {{{ Text scanning API
+    // These scan the grid's lines in bulk, without inflating any of them.
+
+    /// @returns the nearest empty line above @p line that precedes a non-empty line,
+    ///          i.e. the one a backward paragraph motion stops at, up to the oldest history line.
+    [[nodiscard]] std::optional<LineOffset> findParagraphBoundaryAbove(LineOffset line) const noexcept;
+
+    /// @returns the nearest empty line below @p line that follows a non-empty line,
+    ///          i.e. the one a forward paragraph motion stops at, down to @p bottom.
+    [[nodiscard]] std::optional<LineOffset> findParagraphBoundaryBelow(LineOffset line,
+                                                                       LineOffset bottom) const noexcept;
+
+    /// Scans from @p from backwards, up to the oldest history line, for the @p left character
+    /// pairing up with the cells scanned so far.
+    ///
+    /// Each @p right character scanned increments the nesting depth and each @p left one decrements it,
+    /// starting at @p initialDepth, until it reaches zero.
+    [[nodiscard]] std::optional<CellLocation> findPairLeft(CellLocation from,
+                                                           char32_t left,
+                                                           char32_t right,
+                                                           int initialDepth) const;
+
+    /// Scans from @p from forwards, down to @p bottom, for the @p right character
+    /// pairing up with the cells scanned so far, like findPairLeft() the other way around.
+    [[nodiscard]] std::optional<CellLocation> findPairRight(
+        CellLocation from, char32_t left, char32_t right, int initialDepth, LineOffset bottom) const;
+    // }}}
+
+    // {{{ Shell integration API
+    /// Notes that a shell prompt starts at the given line, see CommandIndex::startPrompt().
+    void startCommandPrompt(LineOffset line);
+
+    /// Notes that the command of the current prompt is typed at the given line.
+    void startCommandInput(LineOffset line) { _commandIndex.startInput(absoluteLineOf(line)); }
+
+    /// Notes that the output of the current command starts at the given line.
+    void startCommandOutput(LineOffset line) { _commandIndex.startOutput(absoluteLineOf(line)); }
+
+    /// Notes that the current command has finished, with its output ending at the given line.
+    void finishCommand(LineOffset lastOutputLine, std::optional<int> exitStatus)
+    {
+        _commandIndex.finish(absoluteLineOf(lastOutputLine), exitStatus);
+    }
+
+    [[nodiscard]] CommandIndex const& commandIndex() const noexcept { return _commandIndex; }
+
+    /// @returns the lines of the n-th most recent command, 0 being the most recent one,
+    ///          if its prompt is still within this grid.
+    ///
+    /// @p currentLine  line the output of a command that has not finished yet extends to, exclusively.
+    [[nodiscard]] std::optional<CommandLines> command(size_t n, LineOffset currentLine) const noexcept;
+
+    /// @returns the position from the most recent command of the one the given line belongs to.
+    [[nodiscard]] std::optional<size_t> commandAt(LineOffset line) const noexcept
+    {
+        return _commandIndex.findAt(absoluteLineOf(line));
+    }
+    // }}}
+
     [[nodiscard]] constexpr LineFlags defaultLineFlags() const noexcept;
 
     [[nodiscard]] constexpr LineCount linesUsed() const noexcept;
@@ -753,10 +1170,10 @@ class Grid
 
     // Retrieves the cell location range of the underlying word at the given cursor position.
     [[nodiscard]] CellLocationRange wordRangeUnderCursor(CellLocation position,
-                                                         std::u32string_view delimiters) const noexcept;
+                                                         WordDelimiters const& delimiters) const noexcept;
 
     [[nodiscard]] bool cellEmptyOrContainsOneOf(CellLocation position,
-                                                std::u32string_view delimiters) const noexcept;
+                                                WordDelimiters const& delimiters) const noexcept;
 
     // Lineary extracts the text of a given grid cell range.
     [[nodiscard]] std::u32string extractText(CellLocationRange range) const noexcept;
@@ -802,6 +1219,35 @@ class Grid
     }
 
   private:
+    /// Lines of the main page pending to be reset by clearLines().
+    struct StaleLines
+    {
+        LineOffset from;
+        LineOffset to;
+        LineFlags flags;
+        GraphicsAttributes attributes;
+    };
+
+    void markLinesStale(LineOffset from,
+                        LineOffset to,
+                        LineFlags flags,
+                        GraphicsAttributes attributes) noexcept;
+
+    [[nodiscard]] bool isStaleLine(LineOffset line) const noexcept
+    {
+        return _staleLines && _staleLines->from <= line && line < _staleLines->to
+               && _lines[unbox(line)].generation() != _clearGeneration;
+    }
+
+    void resetStaleLine(Line<Cell> const& line) const noexcept
+    {
+        // The line has logically been cleared already, so resetting it does not change the grid.
+        auto& staleLine = const_cast<Line<Cell>&>(line);
+        staleLine.setBufferPool(_lineBufferPool.get());
+        staleLine.reset(_staleLines->flags, _staleLines->attributes, _pageSize.columns);
+        staleLine.setGeneration(_clearGeneration);
+    }
+
     CellLocation growLines(LineCount newHeight, CellLocation cursor);
     void appendNewLines(LineCount count, GraphicsAttributes attr);
     void clampHistory();
@@ -820,7 +1266,126 @@ class Grid
 
     void rotateBuffersLeft(LineCount count) noexcept { _lines.rotate_left(unbox<size_t>(count)); }
 
+    /// Initializes (/resets) the given number of main page lines at the bottom, that just scrolled in.
+    ///
+    /// Scrolling in a whole page, as clearing the screen does, resets them lazily. See clearLines().
+    void resetNewLines(LineCount count, GraphicsAttributes attributes) noexcept
+    {
+        auto const top = boxed_cast<LineOffset>(_pageSize.lines - count);
+        auto const bottom = boxed_cast<LineOffset>(_pageSize.lines);
+        if (count >= _pageSize.lines)
+            markLinesStale(top, bottom, defaultLineFlags(), attributes);
+        else
+            for (auto y = top; y < bottom; ++y)
+                lineAt(y).reset(defaultLineFlags(), attributes);
+    }
+
+    /// Compacts the given number of lines right above the main page, that just went into history.
+    ///
+    /// Inflated lines are turned back into trivial lines where possible, and into attributed lines
+    /// otherwise. Lines that thereby crossed the cold history threshold are packed.
+    /// Trivial lines share their text with identical recent ones, if history deduplication is enabled.
+    void compactNewHistoryLines(LineCount count)
+    {
+        auto const n = std::min(count, historyLineCount());
+        for (auto i = LineOffset(1); i <= boxed_cast<LineOffset>(n); ++i)
+            if (!lineAt(-i).compactIntoTrivialBuffer(_historyTextBuffer,
+                                                     _historyTextCache ? &*_historyTextCache : nullptr))
+                lineAt(-i).compactIntoAttributedBuffer();
+
+        auto const coldEnd = std::min(_coldHistoryThreshold + count, historyLineCount());
+        for (auto i = boxed_cast<LineOffset>(_coldHistoryThreshold + 1); i <= boxed_cast<LineOffset>(coldEnd);
+             ++i)
+            lineAt(-i).packIntoColdBuffer();
+
+        if (_searchIndex)
+        {
+            for (auto i = boxed_cast<LineOffset>(n); i >= LineOffset(1); --i)
+                _searchIndex->push(_lines[unbox(-i)].searchSignature());
+            _searchIndex->limit(unbox<size_t>(historyLineCount()));
+        }
+
+        for (auto i = boxed_cast<LineOffset>(n); i >= LineOffset(1); --i)
+        {
+            _markerIndex.push(_lines[unbox(-i)].marked());
+            _wrapIndex.push(_lines[unbox(-i)].wrapped());
+        }
+        _markerIndex.limit(unbox<size_t>(historyLineCount()));
+        _wrapIndex.limit(unbox<size_t>(historyLineCount()));
+    }
+
+    /// Re-indexes the marked and wrapped lines of the whole history, e.g. after it has been reflowed.
+    void rebuildHistoryLineIndexes();
+
+    /// @returns the given line's number in the running line counter, see scrolledLineCount().
+    [[nodiscard]] int64_t absoluteLineOf(LineOffset line) const noexcept
+    {
+        return _scrolledLineCount + unbox<int64_t>(line);
+    }
+
+    [[nodiscard]] LineOffset lineOffsetOf(int64_t absoluteLine) const noexcept
+    {
+        return LineOffset::cast_from(absoluteLine - _scrolledLineCount);
+    }
+
+    /// Records that the given line may be unpacked from now on, if it is a cold history line.
+    void touchLine(LineOffset line) noexcept
+    {
+        if (line >= -boxed_cast<LineOffset>(_coldHistoryThreshold))
+            return;
+        _touchedColdLineTop = std::min(_touchedColdLineTop, absoluteLineOf(line));
+        _touchedColdLineBottom = std::max(_touchedColdLineBottom, absoluteLineOf(line));
+    }
+
+    /// @returns the running line numbers of all marked lines that start a logical line, ascending.
+    ///
+    /// See CommandIndex::reanchor().
+    [[nodiscard]] std::vector<int64_t> markedAbsoluteLines() const;
+
     void rotateBuffersRight(LineCount count) noexcept { _lines.rotate_right(unbox<size_t>(count)); }
+
+    /// @returns the offset of the oldest line to be reflowed right away on resize.
+    ///
+    /// This is the beginning of the logical line at EagerReflowHistoryLineCount lines above the main page,
+    /// but never above lines that are still pending reflow from a previous resize.
+    [[nodiscard]] LineOffset eagerReflowStart() const noexcept
+    {
+        auto const pendingEnd = boxed_cast<LineOffset>(_pendingReflowLineCount - historyLineCount());
+        auto start = std::max(pendingEnd, -boxed_cast<LineOffset>(EagerReflowHistoryLineCount));
+        while (start > pendingEnd && lineAt(start).wrapped())
+            --start;
+        return start;
+    }
+
+    /// Tests if scrolling @p n lines within the given vertical margin is cheaper done via
+    /// rotateMarginLines() than by moving each line within the margin.
+    [[nodiscard]] bool canRotateMarginLines(Margin::Vertical margin, LineCount n) const noexcept
+    {
+        auto const linesOutsideMargin = _pageSize.lines - margin.length();
+        return _lines.size() == unbox<size_t>(_pageSize.lines) && linesOutsideMargin + n < margin.length();
+    }
+
+    /// Scrolls the lines within the given vertical margin up (or down) by @p n lines.
+    ///
+    /// This rotates the whole ring buffer and then moves back only the lines outside the margin,
+    /// so that it costs O(n + lines outside the margin) line swaps, rather than O(margin height).
+    /// The @p n lines scrolled out of the margin end up at the margin's other end, not yet reset.
+    ///
+    /// Only valid if the ring buffer consists of the main page only, see canRotateMarginLines().
+    void rotateMarginLines(Margin::Vertical margin, LineCount n, bool up) noexcept;
+
+    /// Accounts for the given number of oldest lines being dropped from the history.
+    void droppedOldestLines(LineCount count) noexcept
+    {
+        _pendingReflowLineCount -= std::min(count, _pendingReflowLineCount);
+    }
+
+    /// Appends the given number of oldest lines to the history spill file, if any,
+    /// right before they are dropped from the in-memory history.
+    void spillOldestLines(LineCount count) noexcept;
+
+    /// Empties the lines not in use, which lie between the page and the oldest history line.
+    void resetUnusedLines();
     // }}}
 
     // private fields
@@ -836,6 +1401,57 @@ class Grid
 
     // Number of lines used in the Lines buffer.
     LineCount _linesUsed;
+
+    // Number of most recent history lines that are kept unpacked.
+    LineCount _coldHistoryThreshold = DefaultColdHistoryThreshold;
+
+    // Absolute line numbers of the oldest and most recent cold history line that may have been
+    // unpacked since the last packColdHistory(), which does not walk any lines beyond them.
+    // No line has been if the top is below the bottom.
+    int64_t _touchedColdLineTop = std::numeric_limits<int64_t>::max();
+    int64_t _touchedColdLineBottom = std::numeric_limits<int64_t>::min();
+
+    // Disk-backed continuation of the history, receiving lines dropped from the Lines buffer.
+    std::shared_ptr<HistorySpillFile> _historySpillFile;
+
+    // Number of lines the history limit is raised by, for the lines paged back in from the spill file.
+    LineCount _pagedInLineCount = LineCount(0);
+
+    // Number of oldest history lines not yet reflowed to the current page width.
+    LineCount _pendingReflowLineCount;
+
+    // Buffer the text of history lines compacted back into trivial lines is appended to.
+    crispy::buffer_object_ptr<char> _historyTextBuffer;
+
+    // Texts of recent history lines, shared by identical lines, if enabled.
+    // See setHistoryDeduplicationEnabled().
+    std::optional<HistoryTextCache> _historyTextCache;
+
+    // Recycled cell buffers of this grid's lines. Held by pointer, as lines refer to it.
+    std::shared_ptr<LineBufferPool<Cell>> _lineBufferPool;
+
+    // Damage stamps of the whole grid, the history, and of each main page line. See damageStamp().
+    uint64_t _damageStamp = 0;
+    uint64_t _pageDamageStamp = 0;
+    uint64_t _historyDamageStamp = 0;
+    std::vector<uint64_t> _lineDamageStamps;
+    int64_t _scrolledLineCount = 0;
+
+    // Trigram signatures of the most recent history lines, if enabled. See setSearchIndexEnabled().
+    std::optional<HistorySearchIndex> _searchIndex;
+
+    // Marked history lines, for logarithmic prompt jumps. See findMarkedLineAbove().
+    HistoryLineIndex _markerIndex;
+
+    // Wrapped history lines, for finding logical line boundaries. See logicalLineTop().
+    HistoryLineIndex _wrapIndex;
+
+    // Shell commands reported by shell integration. See command().
+    CommandIndex _commandIndex;
+
+    // Generation of the last clearLines(), which the lines it has been resetting lazily are stamped with.
+    uint32_t _clearGeneration = 0;
+    mutable std::optional<StaleLines> _staleLines;
 };
 
 template <CellConcept Cell>
@@ -866,17 +1482,26 @@ bool Grid<Cell>::isLineWrapped(LineOffset line) const noexcept
 
 template <CellConcept Cell>
 template <typename RendererT>
-[[nodiscard]] RenderPassHints Grid<Cell>::render(
+[[nodiscard]] RenderPassHints Grid<Cell>::renderLines(
     RendererT&& render, // NOLINT(cppcoreguidelines-missing-std-forward)
+    LineOffset firstLine,
+    LineOffset endLine,
     ScrollOffset scrollOffset,
     HighlightSearchMatches highlightSearchMatches) const
 {
     assert(!scrollOffset || unbox<LineCount>(scrollOffset) <= historyLineCount());
+    assert(LineOffset(0) <= firstLine && firstLine <= endLine);
+    assert(endLine <= boxed_cast<LineOffset>(_pageSize.lines));
+    assert(!_staleLines);
 
-    auto y = LineOffset(0);
+    auto y = firstLine;
     auto hints = RenderPassHints {};
-    for (int i = -*scrollOffset, e = i + *_pageSize.lines; i != e; ++i, ++y)
+    for (int i = unbox(firstLine) - *scrollOffset, e = unbox(endLine) - *scrollOffset; i != e; ++i, ++y)
     {
+        if constexpr (requires { render.reuseUndamagedLine(y); })
+            if (render.reuseUndamagedLine(y))
+                continue;
+
         auto x = ColumnOffset(0);
         Line<Cell> const& line = _lines[i];
         // NB: trivial liner rendering only works trivially if we don't do cell-based operations
@@ -889,6 +1514,18 @@ template <typename RendererT>
                                           || (cellFlags & CellFlag::RapidBlinking);
             render.renderTrivialLine(line.trivialBuffer(), y);
         }
+        else if (line.isAttributedBuffer() || line.isPackedBuffer())
+        {
+            // Render history lines straight from their attribute runs, without inflating them again.
+            render.startLine(y);
+            line.forEachAttributedCell([&](Cell const& cell) {
+                hints.containsBlinkingCells = hints.containsBlinkingCells
+                                              || (cell.flags() & CellFlag::Blinking)
+                                              || (cell.flags() & CellFlag::RapidBlinking);
+                render.renderCell(cell, y, x++);
+            });
+            render.endLine();
+        }
         else
         {
             render.startLine(y);
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/Grid.h>
+#include <vtbackend/cell/CompactCell.h>
+#include <vtbackend/cell/SimpleCell.h>
+#include <vtbackend/primitives.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+
+using namespace vtbackend;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+auto constexpr Size = PageSize { LineCount(50), ColumnCount(160) };
+auto constexpr HistoryLineCount = LineCount(1000);
+
+// Fills the whole page and history, so that scrolling recycles lines just like in a long session.
+template <typename Cell>
+Grid<Cell> filledGrid(PageSize pageSize, bool reflowOnResize)
+{
+    auto constexpr Sentence = "The quick brown fox jumps over the lazy dog. "sv;
+    auto text = std::string {};
+    while (text.size() < pageSize.columns.as<size_t>())
+        text += Sentence;
+    text.resize(pageSize.columns.as<size_t>());
+
+    auto grid = Grid<Cell>(pageSize, reflowOnResize, HistoryLineCount);
+    for (int i = 0; i < (pageSize.lines + HistoryLineCount).as<int>(); ++i)
+    {
+        grid.scrollUp(LineCount(1));
+        grid.setLineText(pageSize.lines.as<LineOffset>() - 1, text);
+        grid.lineAt(pageSize.lines.as<LineOffset>() - 1).setWrappable(true);
+    }
+    return grid;
+}
+
+constexpr Margin pageMargin(PageSize pageSize, LineOffset top, ColumnOffset left, ColumnOffset right)
+{
+    return Margin { .vertical = Margin::Vertical { .from = top, .to = pageSize.lines.as<LineOffset>() - 1 },
+                    .horizontal = Margin::Horizontal { .from = left, .to = right } };
+}
+
+} // namespace
+
+TEMPLATE_TEST_CASE("Grid.scrollUp", "[grid]", SimpleCell, CompactCell)
+{
+    auto grid = filledGrid<TestType>(Size, false);
+    auto const sgr = GraphicsAttributes {};
+    auto const lastColumn = Size.columns.as<ColumnOffset>() - 1;
+
+    BENCHMARK("full page")
+    {
+        return grid.scrollUp(LineCount(1), sgr);
+    };
+
+    auto const verticalMargin = pageMargin(Size, LineOffset(5), ColumnOffset(0), lastColumn);
+    BENCHMARK("vertical margin")
+    {
+        return grid.scrollUp(LineCount(1), sgr, verticalMargin);
+    };
+
+    auto const verticalAndHorizontalMargin =
+        pageMargin(Size, LineOffset(5), ColumnOffset(10), lastColumn - 10);
+    BENCHMARK("vertical and horizontal margin")
+    {
+        return grid.scrollUp(LineCount(1), sgr, verticalAndHorizontalMargin);
+    };
+}
+
+TEMPLATE_TEST_CASE("Grid.resize", "[grid]", SimpleCell, CompactCell)
+{
+    auto const narrow = PageSize { Size.lines, ColumnCount(80) };
+    auto const cursor = CellLocation { .line = Size.lines.as<LineOffset>() - 1, .column = ColumnOffset(0) };
+
+    // Each run resizes the grid back and forth, so that every run has the same amount of work to do.
+    BENCHMARK_ADVANCED("without reflow")(Catch::Benchmark::Chronometer meter)
+    {
+        auto grid = filledGrid<TestType>(Size, false);
+        meter.measure([&](int i) { return grid.resize(i % 2 ? Size : narrow, cursor, false); });
+    };
+
+    BENCHMARK_ADVANCED("with reflow")(Catch::Benchmark::Chronometer meter)
+    {
+        auto grid = filledGrid<TestType>(Size, true);
+        meter.measure([&](int i) { return grid.resize(i % 2 ? Size : narrow, cursor, false); });
+    };
+}
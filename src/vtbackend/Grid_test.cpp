@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/Grid.h>
+#include <vtbackend/Image.h>
 #include <vtbackend/cell/CellConfig.h>
 #include <vtbackend/primitives.h>
 
@@ -7,7 +8,12 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
+#include <filesystem>
 #include <format>
+#include <memory>
+#include <optional>
+#include <utility>
 
 using namespace vtbackend;
 using namespace std::string_literals;
@@ -956,3 +962,743 @@ TEST_CASE("Grid resize with wrap and spaces", "[grid]")
 
 // }}}
 // NOLINTEND(misc-const-correctness)
+
+TEST_CASE("Grid.scrollUp.compacts_history_lines", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(5), { "ABCD", "EFGH" });
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = Color::Indexed(IndexedColor::Blue);
+    grid.useCellAt(LineOffset(0), ColumnOffset(1)).setForegroundColor(sgr.foregroundColor);
+    REQUIRE(grid.lineAt(LineOffset(0)).isInflatedBuffer());
+
+    grid.scrollUp(LineCount(1));
+    logGridText(grid, "after scroll");
+
+    CHECK(grid.historyLineCount() == LineCount(1));
+    CHECK(grid.lineAt(LineOffset(-1)).isAttributedBuffer());
+    CHECK(grid.lineText(LineOffset(-1)) == "ABCD");
+    CHECK(grid.lineAt(LineOffset(-1)).inflatedBuffer()[1].foregroundColor() == sgr.foregroundColor);
+    CHECK(grid.lineText(LineOffset(0)) == "EFGH");
+}
+
+TEST_CASE("Grid.scrollUp.deflates_uniform_history_lines", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(6) }, false, LineCount(5), { "AB", "EFGH" });
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = Color::Indexed(IndexedColor::Blue);
+    for (auto i = ColumnOffset(0); i < ColumnOffset(6); ++i)
+        grid.useCellAt(LineOffset(0), i).setForegroundColor(sgr.foregroundColor);
+    grid.useCellAt(LineOffset(0), ColumnOffset(2)).write(sgr, U'中', 2);
+    grid.useCellAt(LineOffset(0), ColumnOffset(3)).reset(sgr.with(CellFlag::WideCharContinuation));
+    grid.useCellAt(LineOffset(0), ColumnOffset(4)).write(sgr, U'C', 1);
+    REQUIRE(grid.lineAt(LineOffset(0)).isInflatedBuffer());
+    grid.useCellAt(LineOffset(1), ColumnOffset(3)).setForegroundColor(sgr.foregroundColor);
+
+    grid.scrollUp(LineCount(2));
+    logGridText(grid, "after scroll");
+
+    // The line of uniform attributes goes back to being trivial, without changing its contents.
+    REQUIRE(grid.lineAt(LineOffset(-2)).isTrivialBuffer());
+    auto const& trivial = grid.lineAt(LineOffset(-2)).trivialBuffer();
+    CHECK(trivial.text.view() == "AB中C"sv);
+    CHECK(trivial.usedColumns == ColumnCount(5));
+    CHECK(trivial.textAttributes == sgr);
+    CHECK(trivial.fillAttributes == sgr);
+    CHECK(grid.lineText(LineOffset(-2)) == "AB中C ");
+    CHECK(grid.lineAt(LineOffset(-2)).inflatedBuffer()[3].isFlagEnabled(CellFlag::WideCharContinuation));
+    CHECK(grid.lineAt(LineOffset(-2)).inflatedBuffer()[5].foregroundColor() == sgr.foregroundColor);
+
+    // The line of mixed attributes does not qualify.
+    CHECK(grid.lineAt(LineOffset(-1)).isAttributedBuffer());
+}
+
+TEST_CASE("Grid.scrollUp.packs_cold_history_lines", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(5), { "ABCD", "EFGH" });
+    grid.setColdHistoryThreshold(LineCount(1));
+    // Lines of mixed attributes, as uniformly attributed ones go into history as trivial lines.
+    grid.useCellAt(LineOffset(0), ColumnOffset(1)).setForegroundColor(Color::Indexed(IndexedColor::Blue));
+    grid.useCellAt(LineOffset(1), ColumnOffset(1)).setForegroundColor(Color::Indexed(IndexedColor::Blue));
+
+    grid.scrollUp(LineCount(1));
+    CHECK(grid.lineAt(LineOffset(-1)).isAttributedBuffer());
+
+    grid.scrollUp(LineCount(1));
+    logGridText(grid, "after scroll");
+    CHECK(grid.historyLineCount() == LineCount(2));
+    CHECK(grid.lineAt(LineOffset(-2)).isPackedBuffer());
+    CHECK(grid.lineAt(LineOffset(-1)).isAttributedBuffer());
+
+    // Reading a cold line leaves it packed.
+    CHECK(grid.lineText(LineOffset(-2)) == "ABCD");
+    CHECK(std::as_const(grid).lineAt(LineOffset(-2)).isPackedBuffer());
+
+    // Viewing cold lines unpacks them, until the cold history is packed again.
+    grid.unpackColdLines(LineOffset(-2), LineCount(2));
+    CHECK(std::as_const(grid).lineAt(LineOffset(-2)).isAttributedBuffer());
+    CHECK(grid.lineText(LineOffset(-2)) == "ABCD");
+    grid.packColdHistory();
+    CHECK(std::as_const(grid).lineAt(LineOffset(-2)).isPackedBuffer());
+    CHECK(std::as_const(grid).lineAt(LineOffset(-1)).isAttributedBuffer());
+}
+
+TEST_CASE("Grid.compact", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(5), { "ABCD", "EFGH" });
+    grid.useCellAt(LineOffset(0), ColumnOffset(1)).setForegroundColor(Color::Indexed(IndexedColor::Blue));
+    (void) grid.lineAt(LineOffset(1)).inflatedBuffer();
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(1), "IJKL");
+    CHECK(grid.lineAt(LineOffset(-1)).isAttributedBuffer());
+    CHECK(grid.lineAt(LineOffset(1)).isInflatedBuffer());
+
+    // History is packed regardless of the cold history threshold, and page lines are compacted.
+    grid.compact();
+    CHECK(grid.lineAt(LineOffset(-1)).isPackedBuffer());
+    CHECK(grid.lineAt(LineOffset(0)).isAttributedBuffer());
+    CHECK(grid.lineAt(LineOffset(1)).isAttributedBuffer());
+    CHECK(grid.lineBufferPool().size() == 0);
+
+    // Lines are transparently restored on access.
+    CHECK(grid.lineText(LineOffset(-1)) == "ABCD");
+    CHECK(grid.lineText(LineOffset(0)) == "EFGH");
+    grid.setLineText(LineOffset(1), "MNOP");
+    CHECK(grid.lineText(LineOffset(1)) == "MNOP");
+}
+
+TEST_CASE("Grid.compact.releases_unused_lines", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(8) }, false, Infinite());
+    grid.setLineText(LineOffset(0), "ABCDEFGH"sv);
+    grid.setLineText(LineOffset(1), "abcdefgh"sv);
+    grid.scrollUp(LineCount(20));
+    grid.setLineText(LineOffset(0), "IJKLMNOP"sv);
+    REQUIRE(grid.historyLineCount() == LineCount(20));
+
+    // Clearing the history keeps the lines of the ring, which compacting releases.
+    grid.clearHistory();
+    CHECK(grid.maxHistoryLineCount() == LineCount(20));
+    grid.compact();
+    CHECK(grid.maxHistoryLineCount() == LineCount(0));
+    CHECK(grid.lineText(LineOffset(0)) == "IJKLMNOP");
+
+    // The history grows again as needed.
+    grid.scrollUp(LineCount(1));
+    CHECK(grid.historyLineCount() == LineCount(1));
+    CHECK(grid.lineText(LineOffset(-1)) == "IJKLMNOP");
+}
+
+TEST_CASE("Grid.trimHistory", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(5), { "AAAA", "BBBB" });
+    for (auto const* text: { "CCCC", "DDDD", "EEEE" })
+    {
+        grid.scrollUp(LineCount(1));
+        grid.setLineText(LineOffset(1), std::string_view(text));
+    }
+    REQUIRE(grid.historyLineCount() == LineCount(3));
+
+    // Trimming to more lines than there are keeps the history as is.
+    grid.trimHistory(LineCount(4));
+    CHECK(grid.historyLineCount() == LineCount(3));
+
+    grid.trimHistory(LineCount(1));
+    CHECK(grid.historyLineCount() == LineCount(1));
+    CHECK(grid.lineText(LineOffset(-1)) == "CCCC");
+    CHECK(grid.lineText(LineOffset(0)) == "DDDD");
+    CHECK(grid.lineText(LineOffset(1)) == "EEEE");
+
+    // The history grows again up to its limit.
+    for (auto i = 0; i < 6; ++i)
+        grid.scrollUp(LineCount(1));
+    CHECK(grid.historyLineCount() == LineCount(5));
+    CHECK(grid.lineText(LineOffset(-5)) == "EEEE");
+}
+
+TEST_CASE("Grid.releaseLines", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(5), { "AAAA", "BBBB" });
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(1), "CCCC"sv);
+    REQUIRE(grid.historyLineCount() == LineCount(1));
+
+    auto const lines = grid.releaseLines();
+    CHECK(lines.size() == 7);
+
+    // An empty page without history is left behind, which can still be written to.
+    CHECK(grid.historyLineCount() == LineCount(0));
+    CHECK(grid.maxHistoryLineCount() == LineCount(0));
+    CHECK(grid.lineText(LineOffset(0)) == "    ");
+    grid.setLineText(LineOffset(0), "DDDD"sv);
+    grid.scrollUp(LineCount(1));
+    CHECK(grid.historyLineCount() == LineCount(0));
+    CHECK(grid.lineText(LineOffset(0)) == "    ");
+}
+
+TEST_CASE("Grid.scrollUp.recycles_line_buffers", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(0), { "ABCD", "EFGH" });
+    auto const* const cellStorage = grid.lineAt(LineOffset(0)).inflatedBuffer().data();
+    CHECK(grid.lineBufferPool().size() == 0);
+
+    // The top line is dropped and reset to become the new bottom line, returning its cells to the pool.
+    grid.scrollUp(LineCount(1));
+    CHECK(grid.lineAt(LineOffset(1)).isTrivialBuffer());
+    CHECK(grid.lineBufferPool().size() == 1);
+
+    // Inflating the line again draws the very same storage from the pool.
+    grid.setLineText(LineOffset(1), "IJKL");
+    CHECK(grid.lineBufferPool().size() == 0);
+    CHECK(grid.lineAt(LineOffset(1)).inflatedBuffer().data() == cellStorage);
+    CHECK(grid.lineText(LineOffset(0)) == "EFGH");
+    CHECK(grid.lineText(LineOffset(1)) == "IJKL");
+}
+
+TEST_CASE("Grid.scrollUp.spills_dropped_lines_to_disk", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(1), { "ABCD", "EFGH" });
+    auto spillFile = std::shared_ptr<HistorySpillFile>(HistorySpillFile::create());
+    REQUIRE(spillFile);
+    grid.setHistorySpillFile(spillFile);
+    grid.lineAt(LineOffset(0)).setWrapped(true);
+
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(1), "IJKL");
+    CHECK(grid.spilledLineCount() == LineCount(0));
+
+    grid.scrollUp(LineCount(2));
+    logGridText(grid, "after scroll");
+    CHECK(grid.historyLineCount() == LineCount(1));
+    REQUIRE(grid.spilledLineCount() == LineCount(2));
+
+    auto const oldest = grid.spilledLine(LineCount(2));
+    REQUIRE(oldest.has_value());
+    CHECK(oldest->toUtf8() == "ABCD");
+    CHECK(oldest->wrapped());
+    CHECK(grid.spilledLine(LineCount(1))->toUtf8() == "EFGH");
+    CHECK(grid.lineText(LineOffset(-1)) == "IJKL");
+    CHECK(!grid.spilledLine(LineCount(3)).has_value());
+
+    // The file is not found by its name while in use, where the platform allows for it.
+    auto const path = spillFile->path();
+#if !defined(_WIN32)
+    CHECK(!std::filesystem::exists(path));
+#endif
+    grid.setHistorySpillFile(nullptr);
+    spillFile.reset();
+    CHECK(!std::filesystem::exists(path));
+}
+
+TEST_CASE("Grid.resize.reflow.lazy_history", "[grid]")
+{
+    auto constexpr PendingLineCount = 10;
+    auto const historyLineCount = *EagerReflowHistoryLineCount + PendingLineCount;
+
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(4) }, true, LineCount(5000));
+    for (auto i = 0; i < historyLineCount; ++i)
+    {
+        grid.setLineText(LineOffset(1), i < PendingLineCount ? "ABCD" : "abcd");
+        grid.scrollUp(LineCount(1));
+    }
+    REQUIRE(grid.historyLineCount() == LineCount(historyLineCount));
+
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(2) }, CellLocation {}, false);
+
+    // Only the lines close to the main page are reflowed right away.
+    CHECK(grid.pendingReflowLineCount() == LineCount(PendingLineCount));
+    auto const oldest = -boxed_cast<LineOffset>(grid.historyLineCount());
+    CHECK(grid.lineAt(oldest).size() == ColumnCount(4));
+    CHECK(grid.lineText(oldest + LineOffset(PendingLineCount)) == "ab");
+    CHECK(grid.lineText(oldest + LineOffset(PendingLineCount + 1)) == "cd");
+    CHECK(grid.lineAt(oldest + LineOffset(PendingLineCount + 1)).wrapped());
+
+    // Resizing again in a row only adds to the pending lines, but does not reflow them.
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(3) }, CellLocation {}, false);
+    CHECK(grid.pendingReflowLineCount() >= LineCount(PendingLineCount));
+    CHECK(grid.lineAt(-boxed_cast<LineOffset>(grid.historyLineCount())).size() == ColumnCount(4));
+
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(2) }, CellLocation {}, false);
+    auto const historyBeforeReflow = grid.historyLineCount();
+    grid.reflowPendingHistory();
+    CHECK(grid.pendingReflowLineCount() == LineCount(0));
+    CHECK(grid.historyLineCount() == historyBeforeReflow + LineCount(PendingLineCount));
+
+    auto const reflowedOldest = -boxed_cast<LineOffset>(grid.historyLineCount());
+    CHECK(grid.lineAt(reflowedOldest).size() == ColumnCount(2));
+    CHECK(grid.lineText(reflowedOldest) == "AB");
+    CHECK(grid.lineText(reflowedOldest + LineOffset(1)) == "CD");
+    CHECK(grid.lineAt(reflowedOldest + LineOffset(1)).wrapped());
+}
+
+TEST_CASE("Grid.resize.reflow.parallel_history", "[grid]")
+{
+    auto const lineCount = 4 * unbox(Grid<Cell>::ParallelReflowMinLineCount) + *EagerReflowHistoryLineCount;
+
+    // The history has room for all lines once they have been reflowed to two columns.
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(4) }, true, LineCount(3 * lineCount));
+    for (auto i = 0; i < lineCount; ++i)
+    {
+        grid.setLineText(LineOffset(1), std::format("{:04}", i % 10'000));
+        grid.scrollUp(LineCount(1));
+    }
+
+    // Logical lines span multiple lines, including across the chunks reflowed in parallel.
+    auto const oldest = -boxed_cast<LineOffset>(grid.historyLineCount());
+    for (auto i = 1; i < unbox(grid.historyLineCount()); i += 3)
+        grid.enableLineFlags(oldest + LineOffset(i), LineFlag::Wrapped, true);
+
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(2) }, CellLocation {}, false);
+    auto const pendingLineCount = unbox(grid.pendingReflowLineCount());
+    REQUIRE(pendingLineCount > unbox(Grid<Cell>::ParallelReflowMinLineCount));
+
+    auto const pendingOldest = -boxed_cast<LineOffset>(grid.historyLineCount());
+    auto pendingText = std::string {};
+    auto pendingWrapped = std::vector<bool> {};
+    for (auto i = 0; i < pendingLineCount; ++i)
+    {
+        pendingText += grid.lineText(pendingOldest + LineOffset(i));
+        pendingWrapped.push_back(grid.lineAt(pendingOldest + LineOffset(i)).wrapped());
+    }
+
+    grid.reflowPendingHistory();
+    CHECK(grid.pendingReflowLineCount() == LineCount(0));
+
+    // Each pending line of four columns is split into two lines, the second continuing the first.
+    auto const reflowedOldest = -boxed_cast<LineOffset>(grid.historyLineCount());
+    auto reflowedText = std::string {};
+    auto mismatchedFlags = 0;
+    for (auto i = 0; i < 2 * pendingLineCount; ++i)
+    {
+        auto const& line = grid.lineAt(reflowedOldest + LineOffset(i));
+        reflowedText += grid.lineText(line);
+        auto const wrapped = i % 2 == 1 || pendingWrapped[static_cast<size_t>(i / 2)];
+        if (line.wrapped() != wrapped)
+            ++mismatchedFlags;
+    }
+    CHECK(reflowedText == pendingText);
+    CHECK(mismatchedFlags == 0);
+}
+
+TEST_CASE("Grid.scroll.within_vertical_margin_without_history", "[grid]")
+{
+    auto const pageSize = PageSize { LineCount(5), ColumnCount(2) };
+    auto grid = setupGrid(pageSize, false, LineCount(0), { "AA", "BB", "CC", "DD", "SS" });
+    auto margin = fullPageMargin(pageSize);
+    margin.vertical.to = LineOffset(3); // bottom line acts as status line
+
+    grid.scrollUp(LineCount(1), GraphicsAttributes {}, margin);
+    logGridText(grid, "after scroll up");
+    CHECK(grid.lineText(LineOffset(0)) == "BB");
+    CHECK(grid.lineText(LineOffset(1)) == "CC");
+    CHECK(grid.lineText(LineOffset(2)) == "DD");
+    CHECK(grid.lineText(LineOffset(3)) == "  ");
+    CHECK(grid.lineText(LineOffset(4)) == "SS");
+
+    grid.scrollDown(LineCount(1), GraphicsAttributes {}, margin);
+    logGridText(grid, "after scroll down");
+    CHECK(grid.lineText(LineOffset(0)) == "  ");
+    CHECK(grid.lineText(LineOffset(1)) == "BB");
+    CHECK(grid.lineText(LineOffset(2)) == "CC");
+    CHECK(grid.lineText(LineOffset(3)) == "DD");
+    CHECK(grid.lineText(LineOffset(4)) == "SS");
+}
+
+TEST_CASE("Grid.damage", "[grid]")
+{
+    auto grid =
+        setupGrid(PageSize { LineCount(3), ColumnCount(4) }, false, LineCount(5), { "ABCD", "EFGH", "IJKL" });
+    auto const initialStamp = grid.damageStamp();
+
+    // Reading does not damage any line.
+    CHECK(std::as_const(grid).at(LineOffset(1), ColumnOffset(0)).codepoint(0) == U'E');
+    CHECK(std::as_const(grid).lineText(LineOffset(2)) == "IJKL");
+    CHECK(grid.damageStamp() == initialStamp);
+
+    grid.useCellAt(LineOffset(1), ColumnOffset(0)).setCharacter(U'X');
+    CHECK(!grid.isLineDamagedSince(LineOffset(0), initialStamp));
+    CHECK(grid.isLineDamagedSince(LineOffset(1), initialStamp));
+    CHECK(!grid.isLineDamagedSince(LineOffset(2), initialStamp));
+
+    auto const writeStamp = grid.damageStamp();
+    CHECK(!grid.isLineDamagedSince(LineOffset(1), writeStamp));
+
+    // Scrolling up moves the lines of the page along with their damage.
+    auto const scrolledLineCount = grid.scrolledLineCount();
+    grid.scrollUp(LineCount(1));
+    CHECK(grid.scrolledLineCount() == scrolledLineCount + 1);
+    CHECK(!grid.isLineDamagedSince(LineOffset(-1), writeStamp));
+    CHECK(!grid.isLineDamagedSince(LineOffset(0), writeStamp));
+    CHECK(!grid.isLineDamagedSince(LineOffset(1), writeStamp));
+    CHECK(grid.isLineDamagedSince(LineOffset(2), writeStamp));
+    CHECK(grid.isLineDamagedSince(LineOffset(0), initialStamp));
+    CHECK(!grid.isLineDamagedSince(LineOffset(-1), initialStamp));
+
+    // Scrolling within margins moves lines in ways not tracked.
+    auto const scrollStamp = grid.damageStamp();
+    grid.scrollUp(LineCount(1),
+                  GraphicsAttributes {},
+                  Margin { .vertical = { .from = LineOffset(1), .to = LineOffset(2) },
+                           .horizontal = { .from = ColumnOffset(0), .to = ColumnOffset(3) } });
+    CHECK(grid.isLineDamagedSince(LineOffset(-1), scrollStamp));
+    CHECK(grid.isLineDamagedSince(LineOffset(0), scrollStamp));
+}
+
+TEST_CASE("Grid.searchIndex", "[grid]")
+{
+    auto grid =
+        setupGrid(PageSize { LineCount(2), ColumnCount(6) }, false, LineCount(2), { "needle", "hay" });
+    grid.setSearchIndexEnabled(true);
+    auto const query = TrigramSignature::of(U"needle");
+    auto const historyLine = [](int line) {
+        return LogicalLine<Cell> { .top = LineOffset(line), .bottom = LineOffset(line), .lines = {} };
+    };
+
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(1), "straw");
+    grid.scrollUp(LineCount(1));
+    CHECK(grid.indexedHistoryLineCount() == LineCount(2));
+    CHECK(grid.mayContain(historyLine(-2), query));
+    CHECK(!grid.mayContain(historyLine(-1), query));
+
+    // The oldest line falls off the history, and with it its signature.
+    grid.scrollUp(LineCount(1));
+    CHECK(grid.indexedHistoryLineCount() == LineCount(2));
+    CHECK(!grid.mayContain(historyLine(-2), query));
+    CHECK(!grid.mayContain(historyLine(-1), query));
+
+    // Clearing the index makes every line a candidate again, until it is rebuilt.
+    grid.clearHistory();
+    CHECK(grid.indexedHistoryLineCount() == LineCount(0));
+    grid.scrollUp(LineCount(1));
+    grid.resize(PageSize { LineCount(2), ColumnCount(5) }, CellLocation {}, false);
+    CHECK(grid.indexedHistoryLineCount() == LineCount(0));
+    CHECK(grid.mayContain(historyLine(-1), query));
+    grid.updateSearchIndex();
+    CHECK(grid.indexedHistoryLineCount() == grid.historyLineCount());
+}
+
+TEST_CASE("Grid.markerIndex", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(6));
+
+    // Compares the indexed lookups against walking all lines one by one.
+    auto const checkLookups = [&]() {
+        auto const top = -boxed_cast<LineOffset>(grid.historyLineCount());
+        auto const bottom = boxed_cast<LineOffset>(grid.pageSize().lines) - 1;
+        for (auto line = top - 1; line <= bottom + 1; ++line)
+        {
+            auto expectedAbove = std::optional<LineOffset> {};
+            for (auto y = std::min(line, bottom + 1) - 1; y >= top && !expectedAbove; --y)
+                if (grid.lineAt(y).marked())
+                    expectedAbove = y;
+            auto expectedBelow = std::optional<LineOffset> {};
+            for (auto y = std::max(line + 1, top); y <= bottom && !expectedBelow; ++y)
+                if (grid.lineAt(y).marked())
+                    expectedBelow = y;
+            CHECK(grid.findMarkedLineAbove(line) == expectedAbove);
+            CHECK(grid.findMarkedLineBelow(line, bottom) == expectedBelow);
+        }
+    };
+
+    for (auto i = 0; i < 9; ++i)
+    {
+        grid.enableLineFlags(LineOffset(1), LineFlag::Marked, i % 3 == 0);
+        grid.scrollUp(LineCount(1));
+        checkLookups();
+    }
+    CHECK(grid.markerIndexedHistoryLineCount() == grid.historyLineCount());
+
+    // Toggling the mark of a history line is reflected in the index.
+    grid.enableLineFlags(LineOffset(-2), LineFlag::Marked, !grid.lineAt(LineOffset(-2)).marked());
+    checkLookups();
+
+    // Pulling history lines back into the page drops them from the index.
+    grid.scrollDown(LineCount(2), GraphicsAttributes {}, fullPageMargin(grid.pageSize()));
+    checkLookups();
+
+    grid.resize(PageSize { LineCount(3), ColumnCount(4) }, CellLocation {}, false);
+    CHECK(grid.markerIndexedHistoryLineCount() == grid.historyLineCount());
+    checkLookups();
+}
+
+TEST_CASE("Grid.logicalLineBoundaries", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(4) }, false, LineCount(12));
+
+    // Compares the indexed lookups against walking all lines one by one.
+    auto const checkBoundaries = [&]() {
+        auto const top = -boxed_cast<LineOffset>(grid.historyLineCount());
+        auto const bottom = boxed_cast<LineOffset>(grid.pageSize().lines) - 1;
+        for (auto line = top; line <= bottom; ++line)
+        {
+            auto expectedTop = line;
+            while (expectedTop > top && grid.lineAt(expectedTop).wrapped())
+                --expectedTop;
+            auto expectedBottom = line;
+            while (expectedBottom < bottom && grid.lineAt(expectedBottom + 1).wrapped())
+                ++expectedBottom;
+            CHECK(grid.logicalLineTop(line) == expectedTop);
+            CHECK(grid.logicalLineBottom(line) == expectedBottom);
+        }
+    };
+
+    for (auto const wrapped: { false, true, true, false, true, false, false, true, true, true, false })
+    {
+        grid.enableLineFlags(LineOffset(2), LineFlag::Wrapped, wrapped);
+        grid.scrollUp(LineCount(1));
+        checkBoundaries();
+    }
+
+    // The bottom-most three logical lines are 2, 1 and the one from -3 to 0,
+    // and the logical line right above them starts at -4.
+    CHECK(grid.computeLogicalLineNumberFromBottom(LineCount(3)) == -4);
+
+    grid.resize(PageSize { LineCount(4), ColumnCount(4) }, CellLocation {}, false);
+    checkBoundaries();
+}
+
+TEST_CASE("Grid.findParagraphBoundary", "[grid]")
+{
+    auto const grid = setupGrid(PageSize { LineCount(3), ColumnCount(6) },
+                                false,
+                                LineCount(5),
+                                { "x(y", "", "[(z", "w)", "", "", "q)]", "end" });
+    REQUIRE(grid.historyLineCount() == LineCount(5));
+    auto const bottom = LineOffset(2);
+
+    CHECK(grid.findParagraphBoundaryAbove(LineOffset(2)) == LineOffset(0));
+    CHECK(grid.findParagraphBoundaryAbove(LineOffset(0)) == LineOffset(-4)); // skips the empty lines first
+    CHECK(grid.findParagraphBoundaryAbove(LineOffset(-3)) == LineOffset(-4));
+    CHECK(!grid.findParagraphBoundaryAbove(LineOffset(-4)).has_value());
+
+    CHECK(grid.findParagraphBoundaryBelow(LineOffset(-5), bottom) == LineOffset(-4));
+    CHECK(grid.findParagraphBoundaryBelow(LineOffset(-4), bottom) == LineOffset(-1));
+    CHECK(!grid.findParagraphBoundaryBelow(LineOffset(-1), bottom).has_value());
+}
+
+TEST_CASE("Grid.findPair", "[grid]")
+{
+    auto const grid = setupGrid(PageSize { LineCount(3), ColumnCount(6) },
+                                false,
+                                LineCount(5),
+                                { "x(y", "", "[(z", "w)", "", "", "q)]", "end" });
+    auto const bottom = LineOffset(2);
+    auto const at = [](int line, int column) {
+        return CellLocation { .line = LineOffset(line), .column = ColumnOffset(column) };
+    };
+
+    // Nested pairs spanning history and main page.
+    CHECK(grid.findPairRight(at(-5, 1), '(', ')', 0, bottom) == at(1, 1));
+    CHECK(grid.findPairLeft(at(1, 1), '(', ')', 0) == at(-5, 1));
+    CHECK(grid.findPairRight(at(-3, 1), '(', ')', 0, bottom) == at(-2, 1));
+    CHECK(grid.findPairLeft(at(1, 2), '[', ']', 0) == at(-3, 0));
+
+    // Starting inside of a pair, as text objects do.
+    CHECK(grid.findPairLeft(at(-1, 0), '(', ')', 1) == at(-5, 1));
+
+    CHECK(!grid.findPairRight(at(2, 0), '(', ')', 0, bottom).has_value());
+    CHECK(!grid.findPairLeft(at(-5, 0), '(', ')', 0).has_value());
+}
+
+TEST_CASE("Grid.clearLines", "[grid]")
+{
+    auto grid = setupGrid(
+        PageSize { LineCount(4), ColumnCount(4) }, false, LineCount(5), { "ABCD", "EFGH", "IJKL", "MNOP" });
+    auto const stamp = grid.damageStamp();
+
+    grid.clearLines(LineOffset(1), LineOffset(3), LineFlag::None, GraphicsAttributes {});
+    CHECK(!grid.isLineDamagedSince(LineOffset(0), stamp));
+    CHECK(grid.isLineDamagedSince(LineOffset(1), stamp));
+    CHECK(grid.isLineDamagedSince(LineOffset(2), stamp));
+    CHECK(!grid.isLineDamagedSince(LineOffset(3), stamp));
+
+    // Lines written to after being cleared are not cleared again later.
+    grid.setLineText(LineOffset(1), "XY");
+    CHECK(grid.lineText(LineOffset(0)) == "ABCD");
+    CHECK(grid.lineText(LineOffset(1)) == "XY  ");
+    CHECK(grid.lineText(LineOffset(3)) == "MNOP");
+    grid.refreshStaleLines();
+    CHECK(grid.lineText(LineOffset(1)) == "XY  ");
+    CHECK(grid.lineText(LineOffset(2)) == "    ");
+
+    // A subsequent clear resets the lines still pending from the previous one first.
+    grid.clearLines(LineOffset(1), LineOffset(3), LineFlag::None, GraphicsAttributes {});
+    grid.clearLines(LineOffset(3), LineOffset(4), LineFlag::None, GraphicsAttributes {});
+    CHECK(grid.renderMainPageText() == "ABCD\n    \n    \n    \n");
+}
+
+TEST_CASE("Grid.reset.page_size", "[grid]")
+{
+    auto grid = setupGrid(
+        PageSize { LineCount(3), ColumnCount(4) }, false, LineCount(5), { "ABCD", "EFGH", "IJKL" });
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(2), "MNOP");
+
+    grid.reset(PageSize { LineCount(2), ColumnCount(5) });
+    CHECK(grid.pageSize() == PageSize { LineCount(2), ColumnCount(5) });
+    CHECK(grid.historyLineCount() == LineCount(0));
+    CHECK(grid.renderMainPageText() == "     \n     \n");
+
+    grid.setLineText(LineOffset(1), "QRSTU");
+    grid.scrollUp(LineCount(1));
+    CHECK(grid.lineText(LineOffset(-1)) == "     ");
+    CHECK(grid.renderMainPageText() == "QRSTU\n     \n");
+}
+
+TEST_CASE("Grid.scrollUp.page_clears_lazily", "[grid]")
+{
+    auto grid = setupGrid(
+        PageSize { LineCount(3), ColumnCount(4) }, false, LineCount(5), { "ABCD", "EFGH", "IJKL" });
+    grid.scrollUp(LineCount(3));
+    grid.setLineText(LineOffset(0), "XYZ");
+    grid.scrollUp(LineCount(1));
+
+    CHECK(grid.historyLineCount() == LineCount(4));
+    CHECK(grid.lineText(LineOffset(-4)) == "ABCD");
+    CHECK(grid.lineText(LineOffset(-2)) == "IJKL");
+    CHECK(grid.lineText(LineOffset(-1)) == "XYZ ");
+    CHECK(grid.renderMainPageText() == "    \n    \n    \n");
+}
+
+TEST_CASE("Grid.scrollUp.deduplicates_history_lines", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(6) }, false, LineCount(10));
+    grid.setHistoryDeduplicationEnabled(true);
+    for (auto const text: { "-----"sv, "build"sv, "-----"sv, "-----"sv })
+    {
+        grid.setLineText(LineOffset(0), text);
+        grid.scrollUp(LineCount(1));
+    }
+
+    CHECK(grid.deduplicatedHistoryLineCount() == 2);
+    auto const& oldest = grid.lineAt(LineOffset(-4));
+    auto const& newest = grid.lineAt(LineOffset(-1));
+    REQUIRE(oldest.isTrivialBuffer());
+    REQUIRE(newest.isTrivialBuffer());
+    CHECK(newest.trivialBuffer().text.data() == oldest.trivialBuffer().text.data());
+    CHECK(grid.lineText(LineOffset(-1)) == "----- ");
+    CHECK(grid.lineText(LineOffset(-3)) == "build ");
+
+    // Modifying a history line only changes that line.
+    grid.setLineText(LineOffset(-1), "=");
+    CHECK(grid.lineText(LineOffset(-1)) == "=---- ");
+    CHECK(grid.lineText(LineOffset(-4)) == "----- ");
+}
+
+TEST_CASE("Grid.snapshot", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(4), { "abcd", "efgh" });
+    grid.setColdHistoryThreshold(LineCount(0));
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(1), "ijkl");
+
+    auto const snapshot = grid.snapshot(LineCount(1));
+    CHECK(snapshot.pageSize() == grid.pageSize());
+    CHECK(snapshot.historyLineCount() == LineCount(1));
+    CHECK(snapshot.lineAt(LineOffset(-1)).isPackedBuffer());
+    CHECK(snapshot.lineAt(LineOffset(-1)).toUtf8() == "abcd");
+    CHECK(snapshot.lineAt(LineOffset(0)).toUtf8() == "efgh");
+    CHECK(snapshot.lineAt(LineOffset(1)).toUtf8() == "ijkl");
+
+    // Further changes to the grid do not show up in the snapshot.
+    grid.setLineText(LineOffset(0), "mnop");
+    grid.scrollUp(LineCount(1));
+    grid.clearHistory();
+    CHECK(snapshot.lineAt(LineOffset(-1)).toUtf8() == "abcd");
+    CHECK(snapshot.lineAt(LineOffset(0)).toUtf8() == "efgh");
+    CHECK(snapshot.lineAt(LineOffset(1)).toUtf8() == "ijkl");
+}
+
+TEST_CASE("Grid.snapshot.drops_image_fragments", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(4), { "abcd", "efgh" });
+    auto const cellSpan = GridSize { .lines = LineCount(1), .columns = ColumnCount(1) };
+    auto const image = std::make_shared<RasterizedImage>(
+        nullptr, ImageAlignment::TopStart, ImageResize::NoResize, RGBAColor {}, cellSpan, ImageSize {});
+    grid.useCellAt(LineOffset(0), ColumnOffset(1)).setImageFragment(image, CellLocation {});
+    auto const fragment = grid.lineAt(LineOffset(0)).inflatedBuffer()[1].imageFragment();
+    auto const useCount = fragment.use_count();
+
+    // The snapshot holds no references to images, which could otherwise be freed along with it.
+    auto const snapshot = grid.snapshot();
+    CHECK(fragment.use_count() == useCount);
+    CHECK(!snapshot.lineAt(LineOffset(0)).cells()[1].imageFragment());
+    CHECK(snapshot.lineAt(LineOffset(0)).toUtf8() == "abcd");
+    CHECK(grid.lineAt(LineOffset(0)).inflatedBuffer()[1].imageFragment() == fragment);
+}
+
+TEST_CASE("Grid.findCandidateLines", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(8) }, false, LineCount(5000));
+    for (auto i = 0; i < 5000; ++i)
+    {
+        grid.setLineText(LineOffset(1), i == 1234 ? "a Needle" : "haystack");
+        grid.scrollUp(LineCount(1));
+    }
+
+    auto const top = boxed_cast<LineOffset>(-grid.historyLineCount());
+    auto const bottom = LineOffset(1);
+    auto const candidates = grid.findCandidateLines(U"needle", false, top, bottom);
+    REQUIRE(candidates.size() == unbox<size_t>(bottom - top) + 1);
+    REQUIRE(std::ranges::count(candidates, 1) == 1);
+    auto const index = std::ranges::find(candidates, 1) - candidates.begin();
+    CHECK(grid.lineText(top + static_cast<int>(index)) == "a Needle");
+
+    CHECK(std::ranges::count(grid.findCandidateLines(U"Needle", true, top, bottom), 1) == 1);
+    CHECK(std::ranges::count(grid.findCandidateLines(U"needle", true, top, bottom), 1) == 0);
+
+    // Small ranges are not worth scanning upfront.
+    CHECK(grid.findCandidateLines(U"needle", false, LineOffset(0), bottom).empty());
+}
+
+TEST_CASE("Grid.pageInSpilledLines", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(1), { "ABCD", "EFGH" });
+    auto spillFile = std::shared_ptr<HistorySpillFile>(HistorySpillFile::create());
+    REQUIRE(spillFile);
+    grid.setHistorySpillFile(spillFile);
+    grid.scrollUp(LineCount(1));
+    grid.setLineText(LineOffset(1), "IJKL");
+    grid.scrollUp(LineCount(2));
+    REQUIRE(grid.spilledLineCount() == LineCount(2));
+
+    CHECK(grid.pageInSpilledLines(LineCount(1)) == LineCount(1));
+    CHECK(grid.historyLineCount() == LineCount(2));
+    CHECK(grid.spilledLineCount() == LineCount(1));
+    CHECK(grid.lineText(LineOffset(-2)) == "EFGH");
+    CHECK(grid.lineText(LineOffset(-1)) == "IJKL");
+
+    CHECK(grid.pageInSpilledLines(LineCount(5)) == LineCount(1));
+    CHECK(grid.pagedInLineCount() == LineCount(2));
+    CHECK(grid.spilledLineCount() == LineCount(0));
+    CHECK(grid.lineText(LineOffset(-3)) == "ABCD");
+
+    grid.spillPagedInLines();
+    CHECK(grid.pagedInLineCount() == LineCount(0));
+    CHECK(grid.historyLineCount() == LineCount(1));
+    CHECK(grid.lineText(LineOffset(-1)) == "IJKL");
+    REQUIRE(grid.spilledLineCount() == LineCount(2));
+    CHECK(grid.spilledLine(LineCount(2))->toUtf8() == "ABCD");
+    CHECK(grid.spilledLine(LineCount(1))->toUtf8() == "EFGH");
+}
+
+TEST_CASE("Grid.setMaxHistoryLineCount.spills_dropped_lines", "[grid]")
+{
+    auto grid = setupGrid(PageSize { LineCount(2), ColumnCount(4) }, false, LineCount(3), { "ABCD", "EFGH" });
+    auto spillFile = std::shared_ptr<HistorySpillFile>(HistorySpillFile::create());
+    REQUIRE(spillFile);
+    grid.setHistorySpillFile(spillFile);
+    grid.scrollUp(LineCount(2));
+    REQUIRE(grid.historyLineCount() == LineCount(2));
+
+    grid.setMaxHistoryLineCount(LineCount(1));
+    CHECK(grid.historyLineCount() == LineCount(1));
+    CHECK(grid.lineText(LineOffset(-1)) == "EFGH");
+    REQUIRE(grid.spilledLineCount() == LineCount(1));
+    CHECK(grid.spilledLine(LineCount(1))->toUtf8() == "ABCD");
+
+    // Growing the limit keeps the history in place.
+    grid.setMaxHistoryLineCount(LineCount(3));
+    CHECK(grid.historyLineCount() == LineCount(1));
+    CHECK(grid.lineText(LineOffset(-1)) == "EFGH");
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HistoryLineIndex.h>
+
+#include <algorithm>
+
+namespace vtbackend
+{
+
+void HistoryLineIndex::push(bool included)
+{
+    if (included)
+        _lines.push_back(_nextLine);
+    ++_nextLine;
+    ++_lineCount;
+}
+
+void HistoryLineIndex::pushOldest(bool included)
+{
+    ++_lineCount;
+    if (included)
+        _lines.push_front(_nextLine - static_cast<int64_t>(_lineCount));
+}
+
+void HistoryLineIndex::dropNewest(size_t count) noexcept
+{
+    count = std::min(count, _lineCount);
+    _nextLine -= static_cast<int64_t>(count);
+    _lineCount -= count;
+    while (!_lines.empty() && _lines.back() >= _nextLine)
+        _lines.pop_back();
+}
+
+void HistoryLineIndex::limit(size_t historyLineCount) noexcept
+{
+    if (_lineCount <= historyLineCount)
+        return;
+
+    _lineCount = historyLineCount;
+    auto const oldest = _nextLine - static_cast<int64_t>(_lineCount);
+    while (!_lines.empty() && _lines.front() < oldest)
+        _lines.pop_front();
+}
+
+void HistoryLineIndex::clear() noexcept
+{
+    _lineCount = 0;
+    _lines.clear();
+}
+
+void HistoryLineIndex::set(LineOffset line, bool included)
+{
+    if (line >= LineOffset(0) || static_cast<size_t>(-unbox(line)) > _lineCount)
+        return;
+
+    auto const number = numberOf(line);
+    auto const i = std::ranges::lower_bound(_lines, number);
+    auto const present = i != _lines.end() && *i == number;
+    if (included && !present)
+        _lines.insert(i, number);
+    else if (!included && present)
+        _lines.erase(i);
+}
+
+bool HistoryLineIndex::contains(LineOffset line) const noexcept
+{
+    return std::ranges::binary_search(_lines, numberOf(line));
+}
+
+std::optional<LineOffset> HistoryLineIndex::findAbove(LineOffset line) const noexcept
+{
+    auto const i = std::ranges::lower_bound(_lines, std::min(numberOf(line), _nextLine));
+    if (i == _lines.begin())
+        return std::nullopt;
+    return lineOf(*std::prev(i));
+}
+
+std::optional<LineOffset> HistoryLineIndex::findBelow(LineOffset line) const noexcept
+{
+    auto const i = std::ranges::upper_bound(_lines, numberOf(line));
+    if (i == _lines.end())
+        return std::nullopt;
+    return lineOf(*i);
+}
+
+LineOffset HistoryLineIndex::runTop(LineOffset line) const noexcept
+{
+    auto const number = numberOf(line);
+    auto const i = std::ranges::lower_bound(_lines, number);
+    if (i == _lines.end() || *i != number)
+        return line;
+
+    // Within a run, entries are as far apart in the index as their line numbers are,
+    // so the beginning of the run can be found by bisection.
+    auto const last = static_cast<size_t>(std::distance(_lines.begin(), i));
+    auto low = size_t { 0 };
+    auto high = last;
+    while (low < high)
+    {
+        auto const mid = low + (high - low) / 2;
+        if (number - _lines[mid] == static_cast<int64_t>(last - mid))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return lineOf(_lines[low]);
+}
+
+LineOffset HistoryLineIndex::runBottom(LineOffset line) const noexcept
+{
+    auto const number = numberOf(line);
+    auto const i = std::ranges::lower_bound(_lines, number);
+    if (i == _lines.end() || *i != number)
+        return line;
+
+    auto const first = static_cast<size_t>(std::distance(_lines.begin(), i));
+    auto low = first;
+    auto high = _lines.size() - 1;
+    while (low < high)
+    {
+        auto const mid = low + (high - low + 1) / 2;
+        if (_lines[mid] - number == static_cast<int64_t>(mid - first))
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    return lineOf(_lines[low]);
+}
+
+} // namespace vtbackend
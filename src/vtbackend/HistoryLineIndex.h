@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/primitives.h>
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace vtbackend
+{
+
+/**
+ * Sorted positions of those of a Grid's most recent history lines that have a certain property,
+ * such as being marked (e.g. shell prompts) or being wrapped.
+ *
+ * Lines are numbered by a running counter that advances as they scroll into history,
+ * so that the entries need not be touched when the history rotates: the n-th line from the back
+ * always carries the number of the next line to be pushed minus n, and thus is history line -n.
+ * Looking up the nearest such line is a binary search away.
+ */
+class HistoryLineIndex
+{
+  public:
+    /// Appends the line that just became history line -1.
+    void push(bool included);
+
+    /// Prepends the history line right above the oldest covered one.
+    void pushOldest(bool included);
+
+    /// Drops the given number of most recent history lines.
+    void dropNewest(size_t count) noexcept;
+
+    /// Drops the oldest lines beyond the given history line count.
+    void limit(size_t historyLineCount) noexcept;
+
+    void clear() noexcept;
+
+    /// Updates whether the covered history line @p line is included.
+    void set(LineOffset line, bool included);
+
+    /// @returns the number of most recent history lines that are covered by the index.
+    [[nodiscard]] size_t size() const noexcept { return _lineCount; }
+
+    /// @returns the number of covered lines that are included.
+    [[nodiscard]] size_t count() const noexcept { return _lines.size(); }
+
+    [[nodiscard]] bool contains(LineOffset line) const noexcept;
+
+    /// @returns the nearest included history line above @p line.
+    [[nodiscard]] std::optional<LineOffset> findAbove(LineOffset line) const noexcept;
+
+    /// @returns the nearest included history line below @p line.
+    [[nodiscard]] std::optional<LineOffset> findBelow(LineOffset line) const noexcept;
+
+    /// @returns the top-most line of the run of consecutive included lines that contains @p line,
+    ///          or @p line itself if it is not included.
+    [[nodiscard]] LineOffset runTop(LineOffset line) const noexcept;
+
+    /// @returns the bottom-most line of the run of consecutive included lines that contains @p line,
+    ///          or @p line itself if it is not included.
+    [[nodiscard]] LineOffset runBottom(LineOffset line) const noexcept;
+
+  private:
+    [[nodiscard]] int64_t numberOf(LineOffset line) const noexcept
+    {
+        return _nextLine + unbox<int64_t>(line);
+    }
+
+    [[nodiscard]] LineOffset lineOf(int64_t number) const noexcept
+    {
+        return LineOffset::cast_from(number - _nextLine);
+    }
+
+    int64_t _nextLine = 0;
+    size_t _lineCount = 0;
+    std::deque<int64_t> _lines; // ascending line numbers
+};
+
+} // namespace vtbackend
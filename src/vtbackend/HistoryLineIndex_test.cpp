@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HistoryLineIndex.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+
+TEST_CASE("HistoryLineIndex.find", "[history]")
+{
+    auto index = HistoryLineIndex {};
+    index.push(true);  // becomes -4
+    index.push(false); // becomes -3
+    index.push(true);  // becomes -2
+    index.push(false); // becomes -1
+    REQUIRE(index.size() == 4);
+    REQUIRE(index.count() == 2);
+
+    CHECK(index.findAbove(LineOffset(5)) == LineOffset(-2));
+    CHECK(index.findAbove(LineOffset(-2)) == LineOffset(-4));
+    CHECK(!index.findAbove(LineOffset(-4)).has_value());
+
+    CHECK(index.findBelow(LineOffset(-5)) == LineOffset(-4));
+    CHECK(index.findBelow(LineOffset(-4)) == LineOffset(-2));
+    CHECK(!index.findBelow(LineOffset(-2)).has_value());
+
+    // Scrolling further keeps the positions relative to the newest history line.
+    index.push(false);
+    CHECK(index.findAbove(LineOffset(0)) == LineOffset(-3));
+    CHECK(index.findBelow(LineOffset(-4)) == LineOffset(-3));
+}
+
+TEST_CASE("HistoryLineIndex.limit_and_dropNewest", "[history]")
+{
+    auto index = HistoryLineIndex {};
+    index.push(true);  // -3
+    index.push(false); // -2
+    index.push(true);  // -1
+
+    index.limit(2);
+    CHECK(index.size() == 2);
+    CHECK(index.count() == 1);
+    CHECK(!index.findAbove(LineOffset(-1)).has_value());
+
+    index.dropNewest(1);
+    CHECK(index.size() == 1);
+    CHECK(index.count() == 0);
+    CHECK(!index.findAbove(LineOffset(0)).has_value());
+
+    index.push(true);
+    CHECK(index.findAbove(LineOffset(0)) == LineOffset(-1));
+}
+
+TEST_CASE("HistoryLineIndex.pushOldest_and_set", "[history]")
+{
+    auto index = HistoryLineIndex {};
+    index.pushOldest(false); // -1
+    index.pushOldest(true);  // -2
+    index.pushOldest(false); // -3
+    CHECK(index.findAbove(LineOffset(0)) == LineOffset(-2));
+
+    index.set(LineOffset(-3), true);
+    index.set(LineOffset(-2), false);
+    index.set(LineOffset(-7), true); // not covered, ignored
+    CHECK(index.count() == 1);
+    CHECK(index.contains(LineOffset(-3)));
+    CHECK(!index.contains(LineOffset(-2)));
+    CHECK(index.findAbove(LineOffset(0)) == LineOffset(-3));
+    CHECK(index.findBelow(LineOffset(-3)) == std::nullopt);
+}
+
+TEST_CASE("HistoryLineIndex.runs", "[history]")
+{
+    auto index = HistoryLineIndex {};
+    for (auto const included: { true, false, true, true, true, false, true, true })
+        index.push(included); // -8 .. -1
+
+    CHECK(index.runTop(LineOffset(-8)) == LineOffset(-8));
+    CHECK(index.runBottom(LineOffset(-8)) == LineOffset(-8));
+
+    CHECK(index.runTop(LineOffset(-4)) == LineOffset(-6));
+    CHECK(index.runTop(LineOffset(-6)) == LineOffset(-6));
+    CHECK(index.runBottom(LineOffset(-6)) == LineOffset(-4));
+    CHECK(index.runBottom(LineOffset(-5)) == LineOffset(-4));
+
+    CHECK(index.runTop(LineOffset(-1)) == LineOffset(-2));
+    CHECK(index.runBottom(LineOffset(-2)) == LineOffset(-1));
+
+    // Lines that are not included form no run.
+    CHECK(index.runTop(LineOffset(-3)) == LineOffset(-3));
+    CHECK(index.runBottom(LineOffset(-7)) == LineOffset(-7));
+}
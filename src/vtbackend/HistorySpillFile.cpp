@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HistorySpillFile.h>
+#include <vtbackend/logging.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <memory>
+#include <string_view>
+#include <system_error>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace vtbackend
+{
+
+namespace
+{
+    /// @returns the directory spill files are created in by default, being private to the user if possible.
+    std::filesystem::path defaultDirectory(std::error_code& errorCode)
+    {
+        auto const* runtimeDirectory = std::getenv("XDG_RUNTIME_DIR");
+        if (runtimeDirectory && *runtimeDirectory)
+            return runtimeDirectory;
+        return std::filesystem::temp_directory_path(errorCode);
+    }
+
+    /// Creates a file in the directory @p path that did not exist before, only accessible by the user,
+    /// and removed once closed, setting @p path to the file's path.
+    crispy::file_descriptor createPrivateFile(std::filesystem::path& path)
+    {
+#if defined(_WIN32)
+        static std::atomic<unsigned> nextFileId = 0;
+        auto const timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        path /= std::format("contour-history-{}-{}.bin", timestamp, nextFileId++);
+        auto const handle = CreateFileW(path.c_str(),
+                                        GENERIC_READ | GENERIC_WRITE,
+                                        0, // not shared
+                                        nullptr,
+                                        CREATE_NEW,
+                                        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                                        nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            return {};
+        return crispy::file_descriptor::from_native(handle);
+#else
+        // mkstemp() creates the file exclusively and with permissions 0600, not following any symlinks.
+        auto pathTemplate = (path / "contour-history-XXXXXX").string();
+        auto const fd = mkstemp(pathTemplate.data());
+        if (fd < 0)
+            return {};
+        path = pathTemplate;
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        // Nobody else opens the file, so it need not have a name while in use.
+        unlink(pathTemplate.c_str());
+        return crispy::file_descriptor::from_native(fd);
+#endif
+    }
+
+    bool writeAt(crispy::file_descriptor const& file, std::string_view bytes, uint64_t offset) noexcept
+    {
+        while (!bytes.empty())
+        {
+#if defined(_WIN32)
+            auto overlapped = OVERLAPPED {};
+            overlapped.Offset = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            auto written = DWORD {};
+            if (!WriteFile(file, bytes.data(), static_cast<DWORD>(bytes.size()), &written, &overlapped))
+                return false;
+#else
+            auto const written = pwrite(file, bytes.data(), bytes.size(), static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+#endif
+            bytes.remove_prefix(static_cast<size_t>(written));
+            offset += static_cast<uint64_t>(written);
+        }
+        return true;
+    }
+
+    bool readAt(crispy::file_descriptor const& file, std::string& bytes, uint64_t offset) noexcept
+    {
+        auto readCount = size_t { 0 };
+        while (readCount < bytes.size())
+        {
+            auto const position = offset + readCount;
+#if defined(_WIN32)
+            auto overlapped = OVERLAPPED {};
+            overlapped.Offset = static_cast<DWORD>(position);
+            overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+            auto count = DWORD {};
+            if (!ReadFile(file,
+                          bytes.data() + readCount,
+                          static_cast<DWORD>(bytes.size() - readCount),
+                          &count,
+                          &overlapped))
+                return false;
+#else
+            auto const count =
+                pread(file, bytes.data() + readCount, bytes.size() - readCount, static_cast<off_t>(position));
+            if (count < 0 && errno == EINTR)
+                continue;
+#endif
+            if (count <= 0)
+                return false;
+            readCount += static_cast<size_t>(count);
+        }
+        return true;
+    }
+} // namespace
+
+std::unique_ptr<HistorySpillFile> HistorySpillFile::create(std::filesystem::path directory)
+{
+    auto errorCode = std::error_code {};
+    if (directory.empty())
+        directory = defaultDirectory(errorCode);
+    if (errorCode)
+    {
+        errorLog()("Could not determine directory for history spill file. {}", errorCode.message());
+        return nullptr;
+    }
+
+    auto path = std::move(directory);
+    auto file = createPrivateFile(path);
+    if (file.is_closed())
+    {
+        errorLog()("Could not create history spill file in: {}", path.string());
+        return nullptr;
+    }
+
+    terminalLog()("Spilling history lines to: {}", path.string());
+    return std::make_unique<HistorySpillFile>(std::move(path), std::move(file));
+}
+
+HistorySpillFile::HistorySpillFile(std::filesystem::path path, crispy::file_descriptor file):
+    _path { std::move(path) }, _file { std::move(file) }
+{
+}
+
+bool HistorySpillFile::append(LineFlags flags, PackedLineBuffer const& buffer) noexcept
+{
+    auto const bytes = buffer.view();
+    if (!writeAt(_file, bytes, _fileSize))
+        return false;
+
+    _index.emplace_back(Entry { .offset = _fileSize,
+                                .size = static_cast<uint32_t>(bytes.size()),
+                                .columns = buffer.columns,
+                                .flags = flags });
+    _fileSize += bytes.size();
+    return true;
+}
+
+std::optional<HistorySpillFile::SpilledLine> HistorySpillFile::read(size_t index) const
+{
+    if (index >= _index.size())
+        return std::nullopt;
+
+    auto const& entry = _index[index];
+    auto bytes = std::string(entry.size, '\0');
+
+    if (!readAt(_file, bytes, entry.offset))
+        return std::nullopt;
+
+    return SpilledLine { .flags = entry.flags,
+                         .buffer = PackedLineBuffer { .bytes = std::make_shared<std::string const>(
+                                                          std::move(bytes)),
+                                                      .columns = entry.columns } };
+}
+
+void HistorySpillFile::truncate(LineCount count) noexcept
+{
+    auto const keep = unbox<size_t>(count);
+    if (keep >= _index.size())
+        return;
+
+    // The discarded lines are overwritten by the next ones appended.
+    _fileSize = _index[keep].offset;
+    _index.erase(_index.begin() + static_cast<std::ptrdiff_t>(keep), _index.end());
+}
+
+void HistorySpillFile::clear()
+{
+    _index.clear();
+    _fileSize = 0;
+#if defined(_WIN32)
+    auto start = LARGE_INTEGER {};
+    if (SetFilePointerEx(_file, start, nullptr, FILE_BEGIN))
+        SetEndOfFile(_file);
+#else
+    (void) ftruncate(_file, 0);
+#endif
+}
+
+} // namespace vtbackend
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Line.h>
+#include <vtbackend/primitives.h>
+
+#include <crispy/file_descriptor.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Append-only, disk-backed store for history lines that fell off the Grid's in-memory ring.
+ *
+ * Lines are stored in their packed form (see PackedLineBuffer) into a per-session file,
+ * while only a small index entry per line is kept in memory.
+ * The file is created exclusively and only accessible by the user. It is unlinked right after
+ * being created where possible, and removed once closed otherwise.
+ */
+class HistorySpillFile
+{
+  public:
+    struct SpilledLine
+    {
+        LineFlags flags;
+        PackedLineBuffer buffer;
+    };
+
+    /// Creates a new spill file in the given directory, or if none given, $XDG_RUNTIME_DIR
+    /// or else the system's temporary directory.
+    ///
+    /// @returns nullptr if the file could not be created.
+    static std::unique_ptr<HistorySpillFile> create(std::filesystem::path directory = {});
+
+    HistorySpillFile(std::filesystem::path path, crispy::file_descriptor file);
+    HistorySpillFile(HistorySpillFile const&) = delete;
+    HistorySpillFile(HistorySpillFile&&) = delete;
+    HistorySpillFile& operator=(HistorySpillFile const&) = delete;
+    HistorySpillFile& operator=(HistorySpillFile&&) = delete;
+    ~HistorySpillFile() = default;
+
+    /// Path the file has been created at, which it need not be found at anymore.
+    [[nodiscard]] std::filesystem::path const& path() const noexcept { return _path; }
+
+    /// Number of lines stored in this spill file.
+    [[nodiscard]] LineCount lineCount() const noexcept { return LineCount::cast_from(_index.size()); }
+
+    /// Appends the given line to the end of the spill file.
+    ///
+    /// @returns false if the line could not be written.
+    bool append(LineFlags flags, PackedLineBuffer const& buffer) noexcept;
+
+    /// Reads back the line at the given index, with 0 being the oldest line.
+    [[nodiscard]] std::optional<SpilledLine> read(size_t index) const;
+
+    /// Discards all but the @p count oldest lines, e.g. once the more recent ones have been read back.
+    void truncate(LineCount count) noexcept;
+
+    /// Discards all lines.
+    void clear();
+
+  private:
+    struct Entry
+    {
+        uint64_t offset;
+        uint32_t size;
+        ColumnCount columns;
+        LineFlags flags;
+    };
+
+    std::filesystem::path _path;
+    crispy::file_descriptor _file;
+    std::vector<Entry> _index;
+    uint64_t _fileSize = 0;
+};
+
+} // namespace vtbackend
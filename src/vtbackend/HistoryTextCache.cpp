@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HistoryTextCache.h>
+
+#include <functional>
+#include <utility>
+
+namespace vtbackend
+{
+
+size_t HistoryTextCache::slotOf(std::string_view text) const noexcept
+{
+    return std::hash<std::string_view> {}(text) % _entries.size();
+}
+
+crispy::buffer_fragment<char> const* HistoryTextCache::find(std::string_view text) const noexcept
+{
+    if (text.empty() || _entries.empty())
+        return nullptr;
+
+    auto const& entry = _entries[slotOf(text)];
+    if (!entry.owner() || entry.view() != text)
+        return nullptr;
+
+    ++_hitCount;
+    return &entry;
+}
+
+void HistoryTextCache::insert(crispy::buffer_fragment<char> fragment)
+{
+    if (fragment.empty() || _entries.empty())
+        return;
+
+    auto& entry = _entries[slotOf(fragment.view())];
+    entry = std::move(fragment);
+}
+
+crispy::buffer_fragment<char> HistoryTextCache::share(crispy::buffer_fragment<char> fragment)
+{
+    if (auto const* shared = find(fragment.view()))
+        return *shared;
+    insert(fragment);
+    return fragment;
+}
+
+void HistoryTextCache::clear() noexcept
+{
+    for (auto& entry: _entries)
+        entry = {};
+}
+
+} // namespace vtbackend
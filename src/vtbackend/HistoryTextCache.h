@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <crispy/BufferObject.h>
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Texts of the most recent trivial history lines, for identical lines to share one copy of their text.
+ *
+ * Logs tend to repeat lines (blank lines, separators, the same warnings), which would otherwise each
+ * keep their own copy of the text alive, be it in the grid's history text buffer or in the PTY buffer
+ * they were emplaced from. Lines referring to a shared text are copied on write as usual, as writing
+ * to a trivial line either inflates it or replaces its text fragment.
+ *
+ * The cache is direct-mapped by the hash of the text, so looking a text up is O(1) and the cache
+ * never holds more than its capacity of texts.
+ */
+class HistoryTextCache
+{
+  public:
+    static constexpr inline size_t DefaultCapacity = 256;
+
+    explicit HistoryTextCache(size_t capacity = DefaultCapacity): _entries(capacity) {}
+
+    /// @returns the recently seen fragment holding the same text as @p text, if any.
+    [[nodiscard]] crispy::buffer_fragment<char> const* find(std::string_view text) const noexcept;
+
+    /// Remembers @p fragment, evicting whatever text it collides with.
+    void insert(crispy::buffer_fragment<char> fragment);
+
+    /// @returns the recently seen fragment holding the same text as @p fragment,
+    ///          or @p fragment itself, after remembering it.
+    [[nodiscard]] crispy::buffer_fragment<char> share(crispy::buffer_fragment<char> fragment);
+
+    /// Forgets all texts, releasing the buffers holding them.
+    void clear() noexcept;
+
+    /// @returns the number of texts found to be shared so far.
+    [[nodiscard]] size_t hitCount() const noexcept { return _hitCount; }
+
+  private:
+    [[nodiscard]] size_t slotOf(std::string_view text) const noexcept;
+
+    std::vector<crispy::buffer_fragment<char>> _entries;
+    mutable size_t _hitCount = 0;
+};
+
+} // namespace vtbackend
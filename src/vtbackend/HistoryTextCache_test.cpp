@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HistoryTextCache.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string_view>
+
+using namespace vtbackend;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+crispy::buffer_fragment<char> fragmentOf(std::string_view text)
+{
+    auto buffer = crispy::buffer_object<char>::create(text.size());
+    auto const region = buffer->writeAtEnd(text);
+    buffer->advance(text.size());
+    return crispy::buffer_fragment<char> { buffer, region };
+}
+
+} // namespace
+
+TEST_CASE("HistoryTextCache.share", "[history]")
+{
+    auto cache = HistoryTextCache {};
+    auto const first = cache.share(fragmentOf("warning: unused variable"));
+    auto const second = cache.share(fragmentOf("warning: unused variable"));
+    CHECK(second.owner() == first.owner());
+    CHECK(second.view() == "warning: unused variable"sv);
+    CHECK(cache.hitCount() == 1);
+
+    auto const other = cache.share(fragmentOf("error: expected ';'"));
+    CHECK(other.owner() != first.owner());
+    CHECK(cache.find("error: expected ';'"sv)->owner() == other.owner());
+    CHECK(cache.find("note: declared here"sv) == nullptr);
+    CHECK(cache.find(""sv) == nullptr);
+
+    cache.clear();
+    CHECK(cache.find("warning: unused variable"sv) == nullptr);
+}
+
+TEST_CASE("HistoryTextCache.evicts_colliding_texts", "[history]")
+{
+    auto cache = HistoryTextCache { 1 };
+    (void) cache.share(fragmentOf("a"));
+    (void) cache.share(fragmentOf("b"));
+    CHECK(cache.find("a"sv) == nullptr);
+    CHECK(cache.find("b"sv) != nullptr);
+}
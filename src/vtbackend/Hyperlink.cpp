@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/Hyperlink.h>
+
+#include <crispy/assert.h>
+
+#include <utility>
+
+namespace vtbackend
+{
+
+namespace
+{
+    constexpr auto IndexMask = (uint32_t { 1 } << HyperlinkIndexBits) - 1;
+    constexpr auto GenerationMask = (uint32_t { 1 } << (32 - HyperlinkIndexBits)) - 1;
+} // namespace
+
+HyperlinkStorage::HyperlinkStorage(size_t capacity): _capacity { capacity }
+{
+    Require(capacity > 0 && capacity < IndexMask);
+    _slots.reserve(capacity);
+}
+
+HyperlinkId HyperlinkStorage::idOf(uint32_t index) const noexcept
+{
+    return HyperlinkId((_slots[index].generation << HyperlinkIndexBits) | (index + 1));
+}
+
+uint32_t HyperlinkStorage::allocateSlot()
+{
+    if (_slots.size() < _capacity)
+    {
+        _slots.emplace_back();
+        return static_cast<uint32_t>(_slots.size() - 1);
+    }
+
+    // Clock sweep: give every recently looked up hyperlink a second chance.
+    // This terminates within two rounds, as each visited slot loses its referenced mark.
+    for (;;)
+    {
+        auto const index = static_cast<uint32_t>(_clockHand);
+        _clockHand = (_clockHand + 1) % _slots.size();
+
+        Slot& slot = _slots[index];
+        if (!slot.used)
+            return index;
+
+        if (slot.referenced)
+        {
+            slot.referenced = false;
+            continue;
+        }
+
+        if (auto const i = _slotByUserId.find(slot.hyperlink.userId);
+            i != _slotByUserId.end() && i->second == index)
+            _slotByUserId.erase(i);
+        slot.used = false;
+        --_size;
+        return index;
+    }
+}
+
+HyperlinkId HyperlinkStorage::add(HyperlinkInfo hyperlink)
+{
+    auto const index = allocateSlot();
+    Slot& slot = _slots[index];
+    slot.hyperlink = std::move(hyperlink);
+    slot.generation = (slot.generation + 1) & GenerationMask;
+    slot.used = true;
+    slot.referenced = true;
+    ++_size;
+
+    if (!slot.hyperlink.userId.empty())
+        _slotByUserId[slot.hyperlink.userId] = index;
+
+    return idOf(index);
+}
+
+HyperlinkInfo const* HyperlinkStorage::hyperlinkById(HyperlinkId id) const noexcept
+{
+    auto const index = (id.value & IndexMask);
+    if (index == 0 || index > _slots.size())
+        return nullptr;
+
+    Slot const& slot = _slots[index - 1];
+    if (!slot.used || slot.generation != (id.value >> HyperlinkIndexBits))
+        return nullptr;
+
+    slot.referenced = true;
+    return &slot.hyperlink;
+}
+
+HyperlinkInfo* HyperlinkStorage::hyperlinkById(HyperlinkId id) noexcept
+{
+    return const_cast<HyperlinkInfo*>(std::as_const(*this).hyperlinkById(id));
+}
+
+HyperlinkId HyperlinkStorage::hyperlinkIdByUserId(std::string const& id) const noexcept
+{
+    auto const i = _slotByUserId.find(id);
+    if (i == _slotByUserId.end())
+        return HyperlinkId {};
+
+    _slots[i->second].referenced = true;
+    return idOf(i->second);
+}
+
+size_t HyperlinkStorage::memoryUsage() const noexcept
+{
+    auto result = _slots.capacity() * sizeof(Slot);
+    for (Slot const& slot: _slots)
+        result += slot.hyperlink.userId.capacity() + slot.hyperlink.uri.capacity();
+
+    // Each entry of the user ID index is a node holding a copy of the user ID.
+    for (auto const& [userId, index]: _slotByUserId)
+        result += sizeof(void*) * 2 + sizeof(std::pair<std::string const, uint32_t>) + userId.capacity();
+    return result;
+}
+
+void HyperlinkStorage::clear()
+{
+    // Slots (and their generations) are kept, so that IDs still stored in cells do not resolve anymore.
+    for (Slot& slot: _slots)
+    {
+        slot.hyperlink = {};
+        slot.used = false;
+        slot.referenced = false;
+    }
+    _slotByUserId.clear();
+    _size = 0;
+}
+
+} // namespace vtbackend
@@ -1,10 +1,10 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
-#include <crispy/LRUCache.h>
-
-#include <memory>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <boxed-cpp/boxed.hpp>
 
@@ -66,45 +66,64 @@ namespace detail
     {
     };
 } // namespace detail
-using HyperlinkId = boxed::boxed<uint16_t, detail::HyperlinkTag>;
 
-bool is_local(HyperlinkInfo const& hyperlink);
+/// Identifies a hyperlink in the HyperlinkStorage.
+///
+/// The lower HyperlinkIndexBits hold the storage slot index plus one (so that 0 means no hyperlink),
+/// and the upper bits the generation of that slot, as of when the hyperlink was stored.
+using HyperlinkId = boxed::boxed<uint32_t, detail::HyperlinkTag>;
 
-using HyperlinkCache = crispy::lru_cache<HyperlinkId, std::shared_ptr<HyperlinkInfo>>;
+constexpr auto HyperlinkIndexBits = 20u;
 
-struct HyperlinkStorage
+bool is_local(HyperlinkInfo const& hyperlink);
+
+/// Interned, generation-checked storage of all hyperlinks (OSC 8) referenced by cells.
+///
+/// Lookups are O(1) by slot index. Slots are reused once the storage is full, picking
+/// the first hyperlink not looked up since the last sweep over all slots (clock eviction).
+/// Because a reused slot gets a new generation, IDs of the evicted hyperlink that are still
+/// stored in cells simply resolve to nothing, rather than to an unrelated hyperlink.
+class HyperlinkStorage
 {
-    mutable HyperlinkCache cache { 1024 };
-    HyperlinkId nextHyperlinkId = HyperlinkId(1);
+  public:
+    static constexpr size_t DefaultCapacity = 1024;
 
-    std::shared_ptr<HyperlinkInfo> hyperlinkById(HyperlinkId id) noexcept
-    {
-        if (!!id)
-            if (auto* href = cache.try_get(id))
-                return *href;
-        return {};
-    }
+    explicit HyperlinkStorage(size_t capacity = DefaultCapacity);
 
-    [[nodiscard]] std::shared_ptr<HyperlinkInfo const> hyperlinkById(HyperlinkId id) const noexcept
-    {
-        if (!!id)
-            if (auto* href = cache.try_get(id))
-                return *href;
-        return {};
-    }
+    [[nodiscard]] size_t size() const noexcept { return _size; }
+    [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+
+    /// @returns the approximate number of bytes of memory taken by the stored hyperlinks.
+    [[nodiscard]] size_t memoryUsage() const noexcept;
 
-    HyperlinkId hyperlinkIdByUserId(std::string const& id) const noexcept
+    /// Stores the given hyperlink. If it carries a user ID, it can be found again via hyperlinkIdByUserId().
+    [[nodiscard]] HyperlinkId add(HyperlinkInfo hyperlink);
+
+    [[nodiscard]] HyperlinkInfo* hyperlinkById(HyperlinkId id) noexcept;
+    [[nodiscard]] HyperlinkInfo const* hyperlinkById(HyperlinkId id) const noexcept;
+
+    /// @returns the ID of the hyperlink with the given user ID, or an empty ID if none.
+    [[nodiscard]] HyperlinkId hyperlinkIdByUserId(std::string const& id) const noexcept;
+
+    void clear();
+
+  private:
+    struct Slot
     {
-        for (auto& href: cache)
-        {
-            if (href.value->userId == id)
-            {
-                cache.touch(href.key);
-                return href.key;
-            }
-        }
-        return HyperlinkId {};
-    }
+        HyperlinkInfo hyperlink;
+        uint32_t generation = 0;
+        bool used = false;
+        mutable bool referenced = false;
+    };
+
+    [[nodiscard]] HyperlinkId idOf(uint32_t index) const noexcept;
+    [[nodiscard]] uint32_t allocateSlot();
+
+    size_t _capacity;
+    size_t _size = 0;
+    size_t _clockHand = 0;
+    std::vector<Slot> _slots;
+    std::unordered_map<std::string, uint32_t> _slotByUserId;
 };
 
 } // namespace vtbackend
@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HyperlinkDetector.h>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+
+using std::optional;
+using std::string_view;
+
+namespace vtbackend
+{
+
+namespace
+{
+    constexpr auto UrlSchemes = std::array<string_view, 4> { "http", "https", "ftp", "file" };
+
+    constexpr bool isDigit(char ch) noexcept
+    {
+        return ch >= '0' && ch <= '9';
+    }
+
+    constexpr bool isAlpha(char ch) noexcept
+    {
+        return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+    }
+
+    constexpr bool isAlnum(char ch) noexcept
+    {
+        return isAlpha(ch) || isDigit(ch);
+    }
+
+    constexpr bool isUrlChar(char ch) noexcept
+    {
+        return ch > 0x20 && ch < 0x7F && string_view("<>\"`{}|\\^").find(ch) == string_view::npos;
+    }
+
+    constexpr bool isPathChar(char ch) noexcept
+    {
+        return isAlnum(ch) || string_view("._-/~+@").find(ch) != string_view::npos;
+    }
+
+    bool isUrlScheme(string_view scheme) noexcept
+    {
+        return std::ranges::any_of(UrlSchemes, [&](string_view known) {
+            return std::ranges::equal(scheme, known, [](char a, char b) {
+                return (a >= 'A' && a <= 'Z' ? char(a - 'A' + 'a') : a) == b;
+            });
+        });
+    }
+
+    /// Drops punctuation and unbalanced closing brackets that rather belong to the text around a URL.
+    size_t trimUrlEnd(string_view text, size_t start, size_t end) noexcept
+    {
+        while (end > start)
+        {
+            auto const last = text[end - 1];
+            auto const isUnbalanced = [&](char open, char close) {
+                auto const url = text.substr(start, end - start);
+                return last == close && std::ranges::count(url, open) < std::ranges::count(url, close);
+            };
+            if (string_view(".,;:!?'").find(last) != string_view::npos || isUnbalanced('(', ')')
+                || isUnbalanced('[', ']'))
+                --end;
+            else
+                break;
+        }
+        return end;
+    }
+
+    optional<DetectedHyperlink> matchUrl(string_view text, size_t start)
+    {
+        auto schemeEnd = start;
+        while (schemeEnd < text.size() && isAlpha(text[schemeEnd]))
+            ++schemeEnd;
+        if (!isUrlScheme(text.substr(start, schemeEnd - start)) || text.substr(schemeEnd, 3) != "://")
+            return std::nullopt;
+
+        auto const authority = schemeEnd + 3;
+        auto end = authority;
+        while (end < text.size() && isUrlChar(text[end]))
+            ++end;
+        end = trimUrlEnd(text, authority, end);
+        if (end == authority)
+            return std::nullopt;
+
+        return DetectedHyperlink { .start = ColumnOffset::cast_from(start),
+                                   .end = ColumnOffset::cast_from(end),
+                                   .uri = URI(text.substr(start, end - start)) };
+    }
+
+    /// @returns the host part of the given file URL, as in "file://host/path".
+    string_view hostOf(string_view url) noexcept
+    {
+        if (!url.starts_with("file://"))
+            return {};
+        url.remove_prefix(7);
+        return url.substr(0, url.find('/'));
+    }
+
+    optional<DetectedHyperlink> matchPath(string_view text, size_t start, string_view workingDirectory)
+    {
+        auto pathEnd = start;
+        while (pathEnd < text.size() && isPathChar(text[pathEnd]))
+            ++pathEnd;
+
+        // A line number needs to follow, and the path needs to look like one rather than a time of day.
+        auto const path = text.substr(start, pathEnd - start);
+        if (path.find_first_of("./") == string_view::npos || !std::ranges::any_of(path, isAlpha)
+            || path.ends_with('/') || path.starts_with('~'))
+            return std::nullopt;
+        if (pathEnd + 1 >= text.size() || text[pathEnd] != ':' || !isDigit(text[pathEnd + 1]))
+            return std::nullopt;
+
+        auto end = pathEnd + 1;
+        while (end < text.size() && isDigit(text[end]))
+            ++end;
+        if (end + 1 < text.size() && text[end] == ':' && isDigit(text[end + 1]))
+        {
+            end += 1;
+            while (end < text.size() && isDigit(text[end]))
+                ++end;
+        }
+        if (end < text.size() && isAlpha(text[end]))
+            return std::nullopt;
+
+        auto uri = URI {};
+        if (path.starts_with('/'))
+        {
+            uri = "file://";
+            uri += hostOf(workingDirectory);
+            uri += path;
+        }
+        else if (!workingDirectory.empty())
+        {
+            auto const relativePath = path.starts_with("./") ? path.substr(2) : path;
+            uri = workingDirectory;
+            if (!uri.ends_with('/'))
+                uri += '/';
+            uri += relativePath;
+        }
+        else
+            return std::nullopt;
+
+        return DetectedHyperlink { .start = ColumnOffset::cast_from(start),
+                                   .end = ColumnOffset::cast_from(end),
+                                   .uri = std::move(uri) };
+    }
+} // namespace
+
+std::vector<DetectedHyperlink> detectHyperlinks(string_view text, string_view workingDirectory)
+{
+    auto result = std::vector<DetectedHyperlink> {};
+
+    // Both URLs and paths with a line number contain a colon, which most lines do not.
+    if (text.find(':') == string_view::npos)
+        return result;
+
+    auto i = size_t { 0 };
+    while (i < text.size())
+    {
+        // Hyperlinks only start at word boundaries.
+        if (i > 0 && isPathChar(text[i - 1]))
+        {
+            ++i;
+            continue;
+        }
+
+        auto hyperlink = matchUrl(text, i);
+        if (!hyperlink)
+            hyperlink = matchPath(text, i, workingDirectory);
+        if (!hyperlink)
+        {
+            ++i;
+            continue;
+        }
+
+        i = unbox<size_t>(hyperlink->end);
+        result.emplace_back(std::move(*hyperlink));
+    }
+
+    return result;
+}
+
+void HyperlinkDetector::setWorkingDirectory(string_view url)
+{
+    if (url == _workingDirectory)
+        return;
+
+    // The relative paths detected so far would now resolve to other files.
+    _workingDirectory = url;
+    _lines.clear();
+}
+
+std::vector<DetectedHyperlink>& HyperlinkDetector::hyperlinksOf(string_view text)
+{
+    auto const hash = std::hash<string_view> {}(text);
+    if (auto i = _lines.find(hash); i != _lines.end() && i->second.text == text)
+        return i->second.hyperlinks;
+
+    if (_lines.size() >= _capacity)
+        _lines.clear();
+
+    auto& entry = _lines[hash];
+    entry.text = text;
+    entry.hyperlinks = detectHyperlinks(text, _workingDirectory);
+    return entry.hyperlinks;
+}
+
+optional<DetectedHyperlink> HyperlinkDetector::hyperlinkAt(string_view text,
+                                                           ColumnOffset column,
+                                                           HyperlinkStorage& storage)
+{
+    if (text.find(':') == string_view::npos)
+        return std::nullopt;
+
+    for (auto& hyperlink: hyperlinksOf(text))
+    {
+        if (column < hyperlink.start || hyperlink.end <= column)
+            continue;
+
+        // The storage may have reused the hyperlink's slot meanwhile, in which case it is stored again.
+        if (!storage.hyperlinkById(hyperlink.id))
+            hyperlink.id = storage.add(HyperlinkInfo { .userId = {}, .uri = hyperlink.uri });
+        return hyperlink;
+    }
+
+    return std::nullopt;
+}
+
+} // namespace vtbackend
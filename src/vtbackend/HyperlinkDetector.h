@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Hyperlink.h>
+#include <vtbackend/primitives.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace vtbackend
+{
+
+/// A hyperlink found in the plain text of a line, spanning the columns [start, end).
+struct DetectedHyperlink
+{
+    ColumnOffset start;
+    ColumnOffset end;
+    URI uri;
+    HyperlinkId id {}; //!< ID of the hyperlink in the HyperlinkStorage, once it has been stored there.
+};
+
+/// Finds URLs (http, https, ftp, file) and file paths followed by a line number (path:line[:column])
+/// in the text of a line.
+///
+/// @param text                 one character per column, as returned by Line::toColumnText().
+/// @param workingDirectory     URL of the shell's working directory (OSC 7) to resolve relative paths
+///                             against. Relative paths are not detected if it is empty.
+[[nodiscard]] std::vector<DetectedHyperlink> detectHyperlinks(std::string_view text,
+                                                              std::string_view workingDirectory);
+
+/// Hyperlinks detected in plain text, for text that has not been linked via OSC 8.
+///
+/// The hyperlinks are detected once per line of text and kept until that text changes,
+/// which is when a line no longer hashes to the same text, so lines that did not change
+/// are not scanned again. The detected hyperlinks are stored in the terminal's HyperlinkStorage
+/// when first looked up, such that hovering and following them works just like with OSC 8.
+class HyperlinkDetector
+{
+  public:
+    static constexpr size_t DefaultCapacity = 256;
+
+    explicit HyperlinkDetector(size_t capacity = DefaultCapacity): _capacity { capacity } {}
+
+    /// Sets the URL of the working directory that relative paths are resolved against.
+    void setWorkingDirectory(std::string_view url);
+
+    /// @returns the hyperlink detected at @p column in the line of the given @p text, if any.
+    [[nodiscard]] std::optional<DetectedHyperlink> hyperlinkAt(std::string_view text,
+                                                               ColumnOffset column,
+                                                               HyperlinkStorage& storage);
+
+    /// @returns the number of lines whose hyperlinks are kept.
+    [[nodiscard]] size_t size() const noexcept { return _lines.size(); }
+
+    void clear() noexcept { _lines.clear(); }
+
+  private:
+    struct Entry
+    {
+        std::string text;
+        std::vector<DetectedHyperlink> hyperlinks;
+    };
+
+    [[nodiscard]] std::vector<DetectedHyperlink>& hyperlinksOf(std::string_view text);
+
+    size_t _capacity;
+    std::string _workingDirectory;
+    std::unordered_map<size_t, Entry> _lines;
+};
+
+} // namespace vtbackend
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HyperlinkDetector.h>
+#include <vtbackend/MockTerm.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+std::vector<std::string> detectedUris(std::string_view text, std::string_view workingDirectory = {})
+{
+    auto uris = std::vector<std::string> {};
+    for (auto const& hyperlink: detectHyperlinks(text, workingDirectory))
+        uris.emplace_back(hyperlink.uri);
+    return uris;
+}
+
+} // namespace
+
+TEST_CASE("HyperlinkDetector.urls", "[hyperlink]")
+{
+    auto const hyperlinks = detectHyperlinks("see https://contour-terminal.org/docs, or so"sv, {});
+    REQUIRE(hyperlinks.size() == 1);
+    CHECK(hyperlinks[0].uri == "https://contour-terminal.org/docs");
+    CHECK(hyperlinks[0].start == ColumnOffset(4));
+    CHECK(hyperlinks[0].end == ColumnOffset(37));
+
+    CHECK(detectedUris("(http://a.b/c_(d)) [ftp://e/f]")
+          == std::vector<std::string> { "http://a.b/c_(d)", "ftp://e/f" });
+    CHECK(detectedUris("HTTPS://A/B.") == std::vector<std::string> { "HTTPS://A/B" });
+    CHECK(detectedUris("https:// xhttps://a gopher://b").empty());
+}
+
+TEST_CASE("HyperlinkDetector.paths", "[hyperlink]")
+{
+    auto const hyperlinks = detectHyperlinks("src/main.cpp:12:5: error: oops"sv, "file://host/home/user"sv);
+    REQUIRE(hyperlinks.size() == 1);
+    CHECK(hyperlinks[0].uri == "file://host/home/user/src/main.cpp");
+    CHECK(hyperlinks[0].start == ColumnOffset(0));
+    CHECK(hyperlinks[0].end == ColumnOffset(17));
+
+    CHECK(detectedUris("at /usr/include/stdio.h:3", "file://host/tmp/")
+          == std::vector<std::string> { "file://host/usr/include/stdio.h" });
+    CHECK(detectedUris("./a.c:1", "file://host/tmp/") == std::vector<std::string> { "file://host/tmp/a.c" });
+    CHECK(detectedUris("/etc/hosts:2") == std::vector<std::string> { "file:///etc/hosts" });
+
+    // Relative paths need a working directory, and line numbers that are not followed by letters.
+    CHECK(detectedUris("main.cpp:12").empty());
+    CHECK(detectedUris("at 12:30, main.cpp:, main.cpp:1a ~/a.c:1 a/:1", "file://host/tmp").empty());
+}
+
+TEST_CASE("HyperlinkDetector.hyperlinkAt", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage(2);
+    auto detector = HyperlinkDetector(2);
+    auto const text = "go to https://a/ now"sv;
+
+    CHECK(!detector.hyperlinkAt(text, ColumnOffset(5), storage));
+    auto const hyperlink = detector.hyperlinkAt(text, ColumnOffset(6), storage);
+    REQUIRE(hyperlink.has_value());
+    CHECK(hyperlink->end == ColumnOffset(16));
+    REQUIRE(storage.hyperlinkById(hyperlink->id) != nullptr);
+    CHECK(storage.hyperlinkById(hyperlink->id)->uri == "https://a/");
+    CHECK(detector.size() == 1);
+
+    // The line's hyperlinks are detected and stored only once.
+    CHECK(detector.hyperlinkAt(text, ColumnOffset(15), storage)->id == hyperlink->id);
+    CHECK(storage.size() == 1);
+
+    // ... unless the storage has evicted them meanwhile.
+    storage.clear();
+    auto const restored = detector.hyperlinkAt(text, ColumnOffset(6), storage);
+    REQUIRE(restored.has_value());
+    CHECK(restored->id != hyperlink->id);
+    CHECK(storage.hyperlinkById(restored->id) != nullptr);
+
+    // Lines without a colon cannot contain any hyperlink and are not kept.
+    CHECK(!detector.hyperlinkAt("plain text"sv, ColumnOffset(0), storage));
+    CHECK(detector.size() == 1);
+}
+
+TEST_CASE("HyperlinkDetector.screen", "[hyperlink]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(30) }, LineCount(10) };
+    auto const& screen = mock.terminal.primaryScreen();
+
+    mock.writeToScreen("\033]7;file://host/src\033\\");
+    mock.writeToScreen("a.cpp:3 \033]8;;https://osc8/\033\\b.cpp:4\033]8;;\033\\ https://c/");
+
+    auto const detected = screen.hyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(2) });
+    REQUIRE(detected);
+    CHECK(detected->uri == "file://host/src/a.cpp");
+
+    // Text linked via OSC 8 keeps its hyperlink.
+    auto const linked = screen.hyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(9) });
+    REQUIRE(linked);
+    CHECK(linked->uri == "https://osc8/");
+    CHECK(!screen.detectedHyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(9) }));
+
+    auto const url = screen.detectedHyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(20) });
+    REQUIRE(url);
+    CHECK(url->uri == "https://c/");
+    CHECK(url->start == ColumnOffset(16));
+    CHECK(!screen.hyperlinkAt(CellLocation { LineOffset(0), ColumnOffset(7) }));
+}
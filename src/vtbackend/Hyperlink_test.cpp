@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/Hyperlink.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+
+TEST_CASE("HyperlinkStorage.add", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage(4);
+    auto const anonymous = storage.add(HyperlinkInfo { .userId = "", .uri = "https://contour-terminal.org/" });
+    auto const named = storage.add(HyperlinkInfo { .userId = "idfile:///tmp", .uri = "file:///tmp" });
+    CHECK(storage.size() == 2);
+
+    REQUIRE(storage.hyperlinkById(anonymous) != nullptr);
+    CHECK(storage.hyperlinkById(anonymous)->uri == "https://contour-terminal.org/");
+    CHECK(storage.hyperlinkById(named)->isLocal());
+    CHECK(storage.hyperlinkById(HyperlinkId {}) == nullptr);
+
+    CHECK(storage.hyperlinkIdByUserId("idfile:///tmp") == named);
+    CHECK(storage.hyperlinkIdByUserId("") == HyperlinkId {});
+}
+
+TEST_CASE("HyperlinkStorage.evicted_ids_do_not_alias", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage(2);
+    auto const a = storage.add(HyperlinkInfo { .userId = "a", .uri = "https://a/" });
+    auto const b = storage.add(HyperlinkInfo { .userId = "b", .uri = "https://b/" });
+
+    // Both hyperlinks have been used recently, so they first lose their mark in the sweep,
+    // and then the oldest one, "a", is evicted.
+    auto const c = storage.add(HyperlinkInfo { .userId = "c", .uri = "https://c/" });
+    CHECK(storage.size() == 2);
+
+    CHECK(storage.hyperlinkById(a) == nullptr);
+    CHECK(storage.hyperlinkIdByUserId("a") == HyperlinkId {});
+    REQUIRE(storage.hyperlinkById(b) != nullptr);
+    CHECK(storage.hyperlinkById(b)->uri == "https://b/");
+    REQUIRE(storage.hyperlinkById(c) != nullptr);
+    CHECK(storage.hyperlinkById(c)->uri == "https://c/");
+    CHECK(c != a);
+}
+
+TEST_CASE("HyperlinkStorage.clear", "[hyperlink]")
+{
+    auto storage = HyperlinkStorage(2);
+    auto const a = storage.add(HyperlinkInfo { .userId = "a", .uri = "https://a/" });
+    storage.clear();
+    CHECK(storage.size() == 0);
+    CHECK(storage.hyperlinkById(a) == nullptr);
+
+    auto const b = storage.add(HyperlinkInfo { .userId = "b", .uri = "https://b/" });
+    CHECK(storage.hyperlinkById(a) == nullptr);
+    CHECK(storage.hyperlinkById(b)->uri == "https://b/");
+}
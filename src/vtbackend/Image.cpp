@@ -4,7 +4,10 @@
 #include <crispy/StrongLRUHashtable.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
+#include <unordered_map>
 
 using std::copy;
 using std::make_shared;
@@ -17,6 +20,169 @@ using std::string;
 namespace vtbackend
 {
 
+namespace
+{
+    uint64_t nextUseTick() noexcept
+    {
+        static std::atomic<uint64_t> tick = 0;
+        return ++tick;
+    }
+
+    // Image IDs are unique across all image pools, as these share their images.
+    ImageId nextImageId() noexcept
+    {
+        static std::atomic<uint32_t> id = 0;
+        return ImageId(++id);
+    }
+
+    /// All images of the process, by their content hash.
+    struct SharedImages
+    {
+        std::mutex mutex;
+        std::unordered_map<crispy::strong_hash, std::weak_ptr<Image const>> images;
+
+        static SharedImages& get()
+        {
+            static SharedImages instance {};
+            return instance;
+        }
+    };
+
+    // {{{ QOI encoding of RGBA pixel data, see https://qoiformat.org/qoi-specification.pdf
+    // The header is omitted, as the pixel count is known from the image size.
+    using Pixel = std::array<uint8_t, 4>;
+
+    constexpr uint8_t QoiOpIndex = 0x00;
+    constexpr uint8_t QoiOpDiff = 0x40;
+    constexpr uint8_t QoiOpLuma = 0x80;
+    constexpr uint8_t QoiOpRun = 0xC0;
+    constexpr uint8_t QoiOpRGB = 0xFE;
+    constexpr uint8_t QoiOpRGBA = 0xFF;
+    constexpr uint8_t QoiMask = 0xC0;
+
+    constexpr size_t qoiHash(Pixel const& px) noexcept
+    {
+        return static_cast<size_t>(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+    }
+
+    Image::Data qoiEncode(Image::Data const& data)
+    {
+        auto output = Image::Data {};
+        output.reserve(data.size() / 4);
+
+        auto index = std::array<Pixel, 64> {};
+        auto previous = Pixel { 0, 0, 0, 255 };
+        auto run = 0;
+        auto const pixelCount = data.size() / 4;
+
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            auto const px = Pixel { data[i * 4], data[i * 4 + 1], data[i * 4 + 2], data[i * 4 + 3] };
+            if (px == previous)
+            {
+                ++run;
+                if (run == 62 || i + 1 == pixelCount)
+                {
+                    output.push_back(static_cast<uint8_t>(QoiOpRun | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0)
+            {
+                output.push_back(static_cast<uint8_t>(QoiOpRun | (run - 1)));
+                run = 0;
+            }
+
+            auto const hash = qoiHash(px);
+            if (index[hash] == px)
+                output.push_back(static_cast<uint8_t>(QoiOpIndex | hash));
+            else
+            {
+                index[hash] = px;
+                auto const dr = static_cast<int8_t>(px[0] - previous[0]);
+                auto const dg = static_cast<int8_t>(px[1] - previous[1]);
+                auto const db = static_cast<int8_t>(px[2] - previous[2]);
+                auto const drDg = dr - dg;
+                auto const dbDg = db - dg;
+                if (px[3] != previous[3])
+                    output.insert(output.end(), { QoiOpRGBA, px[0], px[1], px[2], px[3] });
+                else if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                    output.push_back(
+                        static_cast<uint8_t>(QoiOpDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                else if (dg >= -32 && dg <= 31 && drDg >= -8 && drDg <= 7 && dbDg >= -8 && dbDg <= 7)
+                {
+                    output.push_back(static_cast<uint8_t>(QoiOpLuma | (dg + 32)));
+                    output.push_back(static_cast<uint8_t>((drDg + 8) << 4 | (dbDg + 8)));
+                }
+                else
+                    output.insert(output.end(), { QoiOpRGB, px[0], px[1], px[2] });
+            }
+            previous = px;
+        }
+
+        return output;
+    }
+
+    Image::Data qoiDecode(Image::Data const& input, size_t pixelCount)
+    {
+        auto output = Image::Data(pixelCount * 4);
+
+        auto index = std::array<Pixel, 64> {};
+        auto px = Pixel { 0, 0, 0, 255 };
+        auto run = 0;
+        auto pos = size_t { 0 };
+        auto const next = [&]() -> uint8_t { return pos < input.size() ? input[pos++] : 0; };
+
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            if (run > 0)
+                --run;
+            else
+            {
+                auto const op = next();
+                if (op == QoiOpRGB)
+                {
+                    px[0] = next();
+                    px[1] = next();
+                    px[2] = next();
+                }
+                else if (op == QoiOpRGBA)
+                {
+                    px[0] = next();
+                    px[1] = next();
+                    px[2] = next();
+                    px[3] = next();
+                }
+                else if ((op & QoiMask) == QoiOpIndex)
+                    px = index[op];
+                else if ((op & QoiMask) == QoiOpDiff)
+                {
+                    px[0] = static_cast<uint8_t>(px[0] + ((op >> 4) & 0x03) - 2);
+                    px[1] = static_cast<uint8_t>(px[1] + ((op >> 2) & 0x03) - 2);
+                    px[2] = static_cast<uint8_t>(px[2] + (op & 0x03) - 2);
+                }
+                else if ((op & QoiMask) == QoiOpLuma)
+                {
+                    auto const op2 = next();
+                    auto const dg = (op & 0x3F) - 32;
+                    px[0] = static_cast<uint8_t>(px[0] + dg - 8 + ((op2 >> 4) & 0x0F));
+                    px[1] = static_cast<uint8_t>(px[1] + dg);
+                    px[2] = static_cast<uint8_t>(px[2] + dg - 8 + (op2 & 0x0F));
+                }
+                else
+                    run = op & 0x3F;
+                index[qoiHash(px)] = px;
+            }
+            std::copy(px.begin(), px.end(), output.begin() + static_cast<ptrdiff_t>(i * 4));
+        }
+
+        return output;
+    }
+    // }}}
+} // namespace
+
 ImageStats& ImageStats::get()
 {
     static ImageStats stats {};
@@ -26,7 +192,114 @@ ImageStats& ImageStats::get()
 Image::~Image()
 {
     --ImageStats::get().instances;
-    _onImageRemove(this);
+    if (!_compressedData.empty())
+    {
+        --ImageStats::get().compressed;
+        ImageStats::get().compressedBytes -= _compressedData.size();
+    }
+
+    {
+        auto& shared = SharedImages::get();
+        auto const lock = std::scoped_lock { shared.mutex };
+        // The entry may refer to a newer image of equal contents already.
+        if (auto const i = shared.images.find(_contentHash); i != shared.images.end() && i->second.expired())
+            shared.images.erase(i);
+    }
+
+    for (auto const& [owner, onImageRemove]: _removeListeners)
+        onImageRemove(this);
+}
+
+crispy::strong_hash Image::contentHash(ImageFormat format, ImageSize pixelSize, Data const& data) noexcept
+{
+    return crispy::strong_hash::compute(data.data(), data.size())
+           * crispy::strong_hash(
+               unbox(pixelSize.width), unbox(pixelSize.height), static_cast<uint32_t>(format), 0);
+}
+
+bool Image::addRemoveListener(void const* owner, OnImageRemove onImageRemove) const
+{
+    auto const isOwner = [owner](auto const& listener) { return listener.first == owner; };
+    auto const lock = std::scoped_lock { _mutex };
+    if (std::ranges::any_of(_removeListeners, isOwner))
+        return false;
+    _removeListeners.emplace_back(owner, std::move(onImageRemove));
+    return true;
+}
+
+void Image::removeRemoveListener(void const* owner) const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    std::erase_if(_removeListeners, [owner](auto const& listener) { return listener.first == owner; });
+}
+
+std::unique_lock<std::mutex> Image::lockData() const
+{
+    auto lock = std::unique_lock { _mutex };
+    _lastUse = nextUseTick();
+    if (!_compressedData.empty())
+    {
+        _data = qoiDecode(_compressedData, _size.area());
+        --ImageStats::get().compressed;
+        ImageStats::get().compressedBytes -= _compressedData.size();
+        _compressedData = {};
+    }
+    return lock;
+}
+
+size_t Image::compress() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    if (!_compressedData.empty() || _incompressible || _data.size() != _size.area() * 4)
+        return 0;
+
+    auto compressedData = qoiEncode(_data);
+    if (compressedData.size() >= _data.size())
+    {
+        // Retrying would only yield the same result, as the pixel data never changes.
+        _incompressible = true;
+        return 0;
+    }
+
+    auto const freed = _data.size();
+    compressedData.shrink_to_fit();
+    _compressedData = std::move(compressedData);
+    _data = {};
+    ++ImageStats::get().compressed;
+    ImageStats::get().compressedBytes += _compressedData.size();
+    return freed;
+}
+
+size_t Image::residentSize() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _data.size();
+}
+
+size_t Image::memoryUsage() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _data.capacity() + _compressedData.capacity();
+}
+
+bool Image::decoded() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _decoded;
+}
+
+void Image::setDecodedData(Data data) const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    _data = std::move(data);
+    _decoded = true;
+    _lastUse = nextUseTick();
+}
+
+uint64_t Image::lastUse() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _lastUse;
 }
 
 RasterizedImage::~RasterizedImage()
@@ -39,16 +312,24 @@ ImageFragment::~ImageFragment()
     --ImageStats::get().fragments;
 }
 
-ImagePool::ImagePool(OnImageRemove onImageRemove, ImageId nextImageId):
-    _nextImageId { nextImageId },
+ImagePool::ImagePool(OnImageRemove onImageRemove, size_t memoryBudget):
     _imageNameToImageCache { crispy::strong_hashtable_size { 1024 },
                              crispy::lru_capacity { 100 },
                              "ImagePool name-to-image mappings" },
-    _onImageRemove { std::move(onImageRemove) }
+    _onImageRemove { std::move(onImageRemove) },
+    _memoryBudget { memoryBudget }
 {
 }
 
-Image::Data RasterizedImage::fragment(CellLocation pos) const
+ImagePool::~ImagePool()
+{
+    // Images may outlive this pool when shared with other pools.
+    for (auto const& weakImage: _images)
+        if (auto const image = weakImage.lock())
+            image->removeRemoveListener(this);
+}
+
+Image::Data RasterizedImage::fragment(CellLocation pos, ColumnCount columns) const
 {
     // TODO: respect alignment hint
     // TODO: respect resize hint
@@ -56,13 +337,18 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
     auto const xOffset = pos.column * unbox<int>(_cellSize.width);
     auto const yOffset = pos.line * unbox<int>(_cellSize.height);
     auto const pixelOffset = CellLocation { .line = yOffset, .column = xOffset };
+    auto const fragmentWidth = unbox<int>(columns) * unbox<int>(_cellSize.width);
 
     Image::Data fragData;
-    fragData.resize(_cellSize.area() * 4); // RGBA
+    fragData.resize(_cellSize.area() * unbox<size_t>(columns) * 4); // RGBA
+    auto const dataLock = _image->lockData();
     auto const availableWidth =
-        min(unbox<int>(_image->width()) - unbox(pixelOffset.column), unbox<int>(_cellSize.width));
+        min(unbox<int>(_image->width()) - unbox(pixelOffset.column), fragmentWidth);
+    // Images still being decoded are filled with the default color entirely.
     auto const availableHeight =
-        min(unbox<int>(_image->height()) - unbox(pixelOffset.line), unbox<int>(_cellSize.height));
+        _image->data().empty()
+            ? 0
+            : min(unbox<int>(_image->height()) - unbox(pixelOffset.line), unbox<int>(_cellSize.height));
 
     // auto const availableSize = Size{availableWidth, availableHeight};
     // std::cout << std::format(
@@ -95,7 +381,7 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
         target = copy(source, source + (static_cast<ptrdiff_t>(availableWidth) * 4), target);
 
         // fill vertical gap on right
-        for (int x = availableWidth; x < unbox<int>(_cellSize.width); ++x)
+        for (int x = availableWidth; x < fragmentWidth; ++x)
         {
             *target++ = _defaultColor.red();
             *target++ = _defaultColor.green();
@@ -105,7 +391,7 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
     }
 
     // fill horizontal gap at the bottom
-    for (auto y = availableHeight * unbox<int>(_cellSize.width); y < int(_cellSize.area()); ++y)
+    for (auto y = availableHeight * fragmentWidth; y < fragmentWidth * unbox<int>(_cellSize.height); ++y)
     {
         *target++ = _defaultColor.red();
         *target++ = _defaultColor.green();
@@ -118,10 +404,82 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
 
 shared_ptr<Image const> ImagePool::create(ImageFormat format, ImageSize size, Image::Data&& data)
 {
-    // TODO: This operation should be idempotent, i.e. if that image has been created already, return a
-    // reference to that.
-    auto const id = _nextImageId++;
-    return make_shared<Image>(id, format, std::move(data), size, _onImageRemove);
+    auto const contentHash = Image::contentHash(format, size, data);
+
+    auto image = shared_ptr<Image const> {};
+    {
+        auto& shared = SharedImages::get();
+        auto const lock = std::scoped_lock { shared.mutex };
+        auto& sharedImage = shared.images[contentHash];
+        image = sharedImage.lock();
+        if (!image)
+        {
+            image = make_shared<Image>(nextImageId(), format, std::move(data), size, contentHash);
+            sharedImage = image;
+        }
+    }
+
+    if (image->addRemoveListener(this, _onImageRemove))
+        _images.emplace_back(image);
+
+    {
+        auto const dataLock = image->lockData(); // marks the image as most recently used
+    }
+    enforceMemoryBudget();
+    return image;
+}
+
+shared_ptr<Image const> ImagePool::createPending(ImageFormat format, ImageSize size)
+{
+    auto image = shared_ptr<Image const> { make_shared<Image>(nextImageId(), format, size) };
+    image->addRemoveListener(this, _onImageRemove);
+    _images.emplace_back(image);
+    return image;
+}
+
+void ImagePool::setMemoryBudget(size_t bytes)
+{
+    _memoryBudget = bytes;
+    enforceMemoryBudget();
+}
+
+void ImagePool::enforceMemoryBudget()
+{
+    std::erase_if(_images, [](auto const& image) { return image.expired(); });
+
+    auto images = std::vector<std::pair<uint64_t, shared_ptr<Image const>>> {};
+    images.reserve(_images.size());
+    auto residentSize = size_t { 0 };
+    for (auto const& weakImage: _images)
+    {
+        if (auto image = weakImage.lock())
+        {
+            residentSize += image->residentSize();
+            images.emplace_back(image->lastUse(), std::move(image));
+        }
+    }
+
+    if (residentSize <= _memoryBudget || images.size() < 2)
+        return;
+
+    std::sort(images.begin(), images.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+    images.pop_back();
+
+    for (auto const& [lastUse, image]: images)
+    {
+        residentSize -= min(residentSize, image->compress());
+        if (residentSize <= _memoryBudget)
+            break;
+    }
+}
+
+size_t ImagePool::memoryUsage() const
+{
+    auto result = size_t { 0 };
+    for (auto const& weakImage: _images)
+        if (auto const image = weakImage.lock())
+            result += image->memoryUsage();
+    return result;
 }
 
 shared_ptr<RasterizedImage> rasterize(shared_ptr<Image const> image,
@@ -11,6 +11,8 @@
 #include <format>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 namespace vtbackend
@@ -38,6 +40,8 @@ struct ImageStats
     uint32_t instances = 0;
     uint32_t rasterized = 0;
     uint32_t fragments = 0;
+    uint32_t compressed = 0;     //!< Number of images whose pixel data is currently stored compressed.
+    size_t compressedBytes = 0;  //!< Total size of the compressed pixel data.
 
     static ImageStats& get();
 };
@@ -52,14 +56,28 @@ class Image: public std::enable_shared_from_this<Image>
     using OnImageRemove = std::function<void(Image const*)>;
     /// Constructs an RGBA image.
     ///
-    /// @param data      RGBA buffer data
-    /// @param pixelSize image dimensionss in pixels
-    Image(ImageId id, ImageFormat format, Data data, ImageSize pixelSize, OnImageRemove remover) noexcept:
+    /// @param data        RGBA buffer data
+    /// @param pixelSize   image dimensionss in pixels
+    /// @param contentHash hash of the format, size, and data, see contentHash()
+    Image(ImageId id,
+          ImageFormat format,
+          Data data,
+          ImageSize pixelSize,
+          crispy::strong_hash contentHash) noexcept:
         _id { id },
         _format { format },
-        _data { std::move(data) },
         _size { pixelSize },
-        _onImageRemove { std::move(remover) }
+        _contentHash { contentHash },
+        _data { std::move(data) }
+    {
+        ++ImageStats::get().instances;
+    }
+
+    /// Constructs an RGBA image whose pixel data is still to be decoded, see setDecodedData().
+    ///
+    /// Such an image is not shared with images of equal contents, as these are not known yet.
+    Image(ImageId id, ImageFormat format, ImageSize pixelSize) noexcept:
+        _id { id }, _format { format }, _size { pixelSize }, _contentHash {}, _decoded { false }
     {
         ++ImageStats::get().instances;
     }
@@ -68,22 +86,77 @@ class Image: public std::enable_shared_from_this<Image>
 
     Image(Image const&) = delete;
     Image& operator=(Image const&) = delete;
-    Image(Image&&) noexcept = default;
-    Image& operator=(Image&&) noexcept = default;
+    Image(Image&&) = delete;
+    Image& operator=(Image&&) = delete;
 
     constexpr ImageId id() const noexcept { return _id; }
     constexpr ImageFormat format() const noexcept { return _format; }
-    Data const& data() const noexcept { return _data; }
     constexpr ImageSize size() const noexcept { return _size; }
     constexpr Width width() const noexcept { return _size.width; }
     constexpr Height height() const noexcept { return _size.height; }
+    crispy::strong_hash const& contentHash() const noexcept { return _contentHash; }
+
+    /// Computes the hash identifying images of equal contents.
+    [[nodiscard]] static crispy::strong_hash contentHash(ImageFormat format,
+                                                         ImageSize pixelSize,
+                                                         Data const& data) noexcept;
+
+    /// Registers @p onImageRemove to be invoked on behalf of @p owner when the image is destroyed.
+    ///
+    /// Images are shared by all image pools that got them created, which is why each of them
+    /// registers a listener of its own.
+    ///
+    /// @returns false if @p owner has registered a listener already.
+    bool addRemoveListener(void const* owner, OnImageRemove onImageRemove) const;
+
+    /// Unregisters the listener of @p owner, e.g. when the owner is destroyed before the image.
+    void removeRemoveListener(void const* owner) const;
+
+    /// Locks the pixel data, decompressing it first if it is stored compressed,
+    /// and marks the image as most recently used.
+    ///
+    /// The pixel data may only be accessed while holding the returned lock.
+    [[nodiscard]] std::unique_lock<std::mutex> lockData() const;
+
+    /// @returns the uncompressed pixel data. Requires the lock returned by lockData().
+    ///
+    /// It is empty as long as the image has not been decoded.
+    Data const& data() const noexcept { return _data; }
+
+    /// @returns whether the pixel data is available, i.e. not still being decoded.
+    [[nodiscard]] bool decoded() const;
+
+    /// Hands over the pixel data of an image constructed without, once it has been decoded.
+    void setDecodedData(Data data) const;
+
+    /// Compresses the pixel data in memory, unless that would not save any memory.
+    ///
+    /// @returns the number of bytes of uncompressed pixel data released.
+    size_t compress() const;
+
+    /// @returns the number of bytes the uncompressed pixel data occupies, or 0 if it is stored compressed.
+    [[nodiscard]] size_t residentSize() const;
+
+    /// @returns the number of bytes the pixel data occupies, compressed or not.
+    [[nodiscard]] size_t memoryUsage() const;
+
+    /// @returns a number that increases with every use of the pixel data, across all images.
+    [[nodiscard]] uint64_t lastUse() const;
 
   private:
     ImageId _id;
     ImageFormat _format;
-    Data _data;
     ImageSize _size;
-    OnImageRemove _onImageRemove;
+    crispy::strong_hash _contentHash;
+
+    // Guards all members below, which may be accessed by the terminal and the render thread.
+    mutable std::mutex _mutex;
+    mutable std::vector<std::pair<void const*, OnImageRemove>> _removeListeners;
+    mutable Data _data;
+    mutable Data _compressedData; //!< Non-empty if and only if the pixel data is stored compressed.
+    mutable bool _incompressible = false;
+    mutable bool _decoded = true;
+    mutable uint64_t _lastUse = 0;
 };
 
 /// Image resize hints are used to properly fit/fill the area to place the image onto.
@@ -151,7 +224,11 @@ class RasterizedImage: public std::enable_shared_from_this<RasterizedImage>
     ImageSize cellSize() const noexcept { return _cellSize; }
 
     /// @returns an RGBA buffer for a grid cell at given coordinate @p pos of the rasterized image.
-    Image::Data fragment(CellLocation pos) const;
+    Image::Data fragment(CellLocation pos) const { return fragment(pos, ColumnCount(1)); }
+
+    /// @returns an RGBA buffer for the @p columns grid cells starting at coordinate @p pos of the
+    ///          rasterized image, as one bitmap of their combined width.
+    Image::Data fragment(CellLocation pos, ColumnCount columns) const;
 
   private:
     std::shared_ptr<Image const> _image; //!< Reference to the Image to be rasterized.
@@ -185,6 +262,10 @@ class ImageFragment
     ~ImageFragment();
 
     [[nodiscard]] RasterizedImage const& rasterizedImage() const noexcept { return *_rasterizedImage; }
+    [[nodiscard]] std::shared_ptr<RasterizedImage const> const& rasterizedImagePointer() const noexcept
+    {
+        return _rasterizedImage;
+    }
 
     /// @returns offset of this image fragment in pixels into the underlying image.
     CellLocation offset() const noexcept { return _offset; }
@@ -223,16 +304,48 @@ inline bool operator<(ImageFragment const& a, ImageFragment const& b) noexcept
 /// Highlevel Image Storage Pool.
 ///
 /// Stores RGBA images in host memory, also taking care of eviction.
+///
+/// Images of equal contents are created only once per process, and are shared by all pools,
+/// e.g. when the same plot is shown repeatedly or in multiple sessions. This also makes the renderer
+/// reuse the image's texture atlas tiles, as these are keyed by the image ID.
+///
+/// Images stay alive for as long as any grid cell refers to them, which includes cells deep in the
+/// scrollback. To bound the memory this takes, the pixel data of the least recently used images is
+/// compressed whenever the uncompressed pixel data of all images exceeds the memory budget.
+/// It gets decompressed again the next time it is rendered, e.g. when being scrolled back into view.
 class ImagePool
 {
   public:
     using OnImageRemove = std::function<void(Image const*)>;
 
-    ImagePool(OnImageRemove onImageRemove = [](auto) {}, ImageId nextImageId = ImageId(1));
+    /// Default number of bytes of uncompressed pixel data kept in memory.
+    static constexpr inline size_t DefaultMemoryBudget = 256 * 1024 * 1024;
 
-    /// Creates an RGBA image of given size in pixels.
+    ImagePool(OnImageRemove onImageRemove = [](auto) {}, size_t memoryBudget = DefaultMemoryBudget);
+    ImagePool(ImagePool const&) = delete;
+    ImagePool(ImagePool&&) = delete;
+    ImagePool& operator=(ImagePool const&) = delete;
+    ImagePool& operator=(ImagePool&&) = delete;
+    ~ImagePool();
+
+    /// Creates an RGBA image of given size in pixels, or returns the existing image of equal contents.
     std::shared_ptr<Image const> create(ImageFormat format, ImageSize pixelSize, Image::Data&& data);
 
+    /// Creates an RGBA image of given size in pixels whose pixel data is still to be decoded,
+    /// e.g. by an ImageDecoder, so that grid cells can refer to it in the meantime.
+    std::shared_ptr<Image const> createPending(ImageFormat format, ImageSize pixelSize);
+
+    [[nodiscard]] size_t memoryBudget() const noexcept { return _memoryBudget; }
+    void setMemoryBudget(size_t bytes);
+
+    /// Compresses the least recently used images until their uncompressed pixel data fits the budget.
+    ///
+    /// The most recently used image is never compressed.
+    void enforceMemoryBudget();
+
+    /// @returns the number of bytes the pixel data of all images handed out by this pool occupies.
+    [[nodiscard]] size_t memoryUsage() const;
+
     // named image access
     //
     void link(std::string const& name, std::shared_ptr<Image const> imageRef);
@@ -250,9 +363,10 @@ class ImagePool
 
     // data members
     //
-    ImageId _nextImageId;                      //!< ID for next image to be put into the pool
     NameToImageIdCache _imageNameToImageCache; //!< keeps mapping from name to raw image
     OnImageRemove _onImageRemove;              //!< Callback to be invoked when image gets removed from pool.
+    size_t _memoryBudget;                      //!< Maximum size of uncompressed pixel data of all images.
+    std::vector<std::weak_ptr<Image const>> _images; //!< All images handed out by this pool.
 };
 
 } // namespace vtbackend
@@ -279,8 +393,12 @@ struct std::formatter<vtbackend::ImageStats>: formatter<std::string>
     auto format(vtbackend::ImageStats stats, auto& ctx) const
     {
         return formatter<std::string>::format(
-            std::format(
-                "{} instances, {} raster, {} fragments", stats.instances, stats.rasterized, stats.fragments),
+            std::format("{} instances, {} raster, {} fragments, {} compressed ({} bytes)",
+                        stats.instances,
+                        stats.rasterized,
+                        stats.fragments,
+                        stats.compressed,
+                        stats.compressedBytes),
             ctx);
     }
 };
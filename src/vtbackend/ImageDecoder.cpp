@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/ImageDecoder.h>
+
+#include <crispy/tracing.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace vtbackend
+{
+
+ImageDecoder::~ImageDecoder()
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        _stopping = true;
+        _jobs.clear();
+    }
+    _jobQueued.notify_all();
+    for (auto& worker: _workers)
+        worker.join();
+}
+
+void ImageDecoder::decode(std::shared_ptr<Image const> image, Decode decode, Completion completion)
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        _jobs.emplace_back(Job {
+            .image = std::move(image), .decode = std::move(decode), .completion = std::move(completion) });
+
+        auto const workerCount = std::min(_jobs.size() + _busyCount, MaxWorkerCount);
+        while (_workers.size() < workerCount)
+            _workers.emplace_back([this]() { run(); });
+    }
+    _jobQueued.notify_one();
+}
+
+size_t ImageDecoder::pendingCount() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _jobs.size() + _busyCount;
+}
+
+void ImageDecoder::waitForIdle() const
+{
+    auto lock = std::unique_lock { _mutex };
+    _idle.wait(lock, [this]() { return _jobs.empty() && _busyCount == 0; });
+}
+
+void ImageDecoder::run()
+{
+    auto lock = std::unique_lock { _mutex };
+    while (true)
+    {
+        _jobQueued.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+        if (_stopping)
+            return;
+
+        auto job = std::move(_jobs.front());
+        _jobs.pop_front();
+        ++_busyCount;
+        lock.unlock();
+
+        {
+            CRISPY_TRACE_ZONE("decodeImage", "vt");
+            auto result = job.decode();
+            if (result)
+                job.image->setDecodedData(std::move(result.value()));
+            job.completion(result ? std::nullopt : std::optional { result.error() });
+        }
+        job = {}; // releases the image and whatever the callbacks hold before reporting being idle
+
+        lock.lock();
+        --_busyCount;
+        if (_jobs.empty() && _busyCount == 0)
+            _idle.notify_all();
+    }
+}
+
+} // namespace vtbackend
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Image.h>
+
+#include <crispy/result.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Decodes the pixel data of images on worker threads of its own, such that large images do not
+ * stall the terminal thread parsing everything else.
+ *
+ * The images are created up front without pixel data (see ImagePool::createPending()), so that
+ * grid cells can refer to them right away. The renderer leaves them out until they are decoded.
+ *
+ * Workers are only started once the first image is to be decoded.
+ */
+class ImageDecoder
+{
+  public:
+    /// Maximum number of images decoded at once.
+    static constexpr inline size_t MaxWorkerCount = 2;
+
+    /// Yields the RGBA pixel data of an image, or the message describing why it cannot.
+    ///
+    /// It is invoked on a worker thread.
+    using Decode = std::function<crispy::result<Image::Data, std::string>()>;
+
+    /// Invoked on the worker thread once an image has been decoded, along with the error message
+    /// if decoding failed, in which case the image is left without pixel data.
+    using Completion = std::function<void(std::optional<std::string> const& error)>;
+
+    ImageDecoder() = default;
+    ImageDecoder(ImageDecoder const&) = delete;
+    ImageDecoder(ImageDecoder&&) = delete;
+    ImageDecoder& operator=(ImageDecoder const&) = delete;
+    ImageDecoder& operator=(ImageDecoder&&) = delete;
+
+    /// Stops all workers, discarding images that have not started being decoded yet.
+    ~ImageDecoder();
+
+    /// Decodes the pixel data of @p image, which must have been created without, by @p decode.
+    void decode(std::shared_ptr<Image const> image, Decode decode, Completion completion);
+
+    /// @returns the number of images queued or being decoded.
+    [[nodiscard]] size_t pendingCount() const;
+
+    /// Waits for all queued images to be decoded and their completion to have returned.
+    void waitForIdle() const;
+
+  private:
+    struct Job
+    {
+        std::shared_ptr<Image const> image;
+        Decode decode;
+        Completion completion;
+    };
+
+    void run();
+
+    // Guards all members below.
+    mutable std::mutex _mutex;
+    std::condition_variable _jobQueued;
+    mutable std::condition_variable _idle;
+    std::deque<Job> _jobs;
+    size_t _busyCount = 0;
+    bool _stopping = false;
+
+    std::vector<std::thread> _workers; // started on demand
+};
+
+} // namespace vtbackend
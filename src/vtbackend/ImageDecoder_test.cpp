@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/ImageDecoder.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace vtbackend;
+
+namespace
+{
+
+auto const PixelSize = ImageSize { Width(2), Height(2) };
+
+} // namespace
+
+TEST_CASE("ImageDecoder.decode")
+{
+    auto pool = ImagePool {};
+    auto decoder = ImageDecoder {};
+    auto completed = std::atomic<int> { 0 };
+
+    auto const image = pool.createPending(ImageFormat::RGBA, PixelSize);
+    decoder.decode(
+        image,
+        []() -> crispy::result<Image::Data, std::string> { return Image::Data(PixelSize.area() * 4, 0x7F); },
+        [&](std::optional<std::string> const& error) {
+            CHECK(!error);
+            ++completed;
+        });
+    decoder.waitForIdle();
+
+    CHECK(completed == 1);
+    CHECK(decoder.pendingCount() == 0);
+    REQUIRE(image->decoded());
+    auto const lock = image->lockData();
+    CHECK(image->data() == Image::Data(PixelSize.area() * 4, 0x7F));
+}
+
+TEST_CASE("ImageDecoder.error")
+{
+    auto pool = ImagePool {};
+    auto decoder = ImageDecoder {};
+    auto reported = std::optional<std::string> {};
+
+    auto const image = pool.createPending(ImageFormat::RGBA, PixelSize);
+    decoder.decode(
+        image,
+        []() -> crispy::result<Image::Data, std::string> { return crispy::failure { std::string("EBADF") }; },
+        [&](std::optional<std::string> const& error) { reported = error; });
+    decoder.waitForIdle();
+
+    CHECK(reported == "EBADF");
+    CHECK(!image->decoded());
+}
+
+TEST_CASE("ImageDecoder.many")
+{
+    auto pool = ImagePool {};
+    auto decoder = ImageDecoder {};
+    auto completed = std::atomic<int> { 0 };
+
+    auto images = std::vector<std::shared_ptr<Image const>> {};
+    for (auto i = 0; i < 16; ++i)
+    {
+        images.emplace_back(pool.createPending(ImageFormat::RGBA, PixelSize));
+        decoder.decode(
+            images.back(),
+            [i]() -> crispy::result<Image::Data, std::string> {
+                return Image::Data(PixelSize.area() * 4, static_cast<uint8_t>(i));
+            },
+            [&](auto const&) { ++completed; });
+    }
+    decoder.waitForIdle();
+
+    CHECK(completed == 16);
+    for (auto const& image: images)
+        CHECK(image->decoded());
+}
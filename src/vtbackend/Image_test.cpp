@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/Image.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace vtbackend;
+
+namespace
+{
+
+auto const PixelSize = ImageSize { Width(16), Height(16) };
+auto const ImageBytes = PixelSize.area() * 4;
+
+Image::Data makePixels(uint8_t seed)
+{
+    auto data = Image::Data(ImageBytes);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i % 4 == 3 ? 0xFF : (i / 64 + seed) % 3 * 0x40);
+    return data;
+}
+
+} // namespace
+
+TEST_CASE("ImagePool.memory_budget")
+{
+    auto pool = ImagePool { [](auto) {}, 2 * ImageBytes };
+
+    auto const first = pool.create(ImageFormat::RGBA, PixelSize, makePixels(1));
+    auto const second = pool.create(ImageFormat::RGBA, PixelSize, makePixels(2));
+    CHECK(first->residentSize() == ImageBytes);
+    CHECK(second->residentSize() == ImageBytes);
+
+    // Exceeding the budget compresses the least recently used image.
+    auto const third = pool.create(ImageFormat::RGBA, PixelSize, makePixels(3));
+    CHECK(first->residentSize() == 0);
+    CHECK(second->residentSize() == ImageBytes);
+    CHECK(third->residentSize() == ImageBytes);
+
+    // Using the image again decompresses it.
+    {
+        auto const lock = first->lockData();
+        CHECK(first->data() == makePixels(1));
+    }
+    CHECK(first->residentSize() == ImageBytes);
+
+    pool.enforceMemoryBudget();
+    CHECK(second->residentSize() == 0);
+    CHECK(third->residentSize() == ImageBytes);
+}
+
+TEST_CASE("ImagePool.memory_budget_fragments")
+{
+    auto pool = ImagePool { [](auto) {}, 0 };
+
+    auto const image = pool.create(ImageFormat::RGBA, PixelSize, makePixels(1));
+    auto const other = pool.create(ImageFormat::RGBA, PixelSize, makePixels(2));
+    REQUIRE(image->residentSize() == 0);
+
+    auto const cellSpan = GridSize { .lines = LineCount(1), .columns = ColumnCount(1) };
+    auto const rasterized = std::make_shared<RasterizedImage>(
+        image, ImageAlignment::TopStart, ImageResize::NoResize, RGBAColor {}, cellSpan, PixelSize);
+    CHECK(ImageFragment(rasterized, CellLocation {}).data() == makePixels(1));
+}
+
+TEST_CASE("RasterizedImage.fragment.columns")
+{
+    auto pool = ImagePool {};
+    auto const image = pool.create(ImageFormat::RGBA, PixelSize, makePixels(1));
+    auto const cellSize = ImageSize { Width(8), Height(16) };
+    auto const cellSpan = GridSize { .lines = LineCount(1), .columns = ColumnCount(3) };
+    auto const rasterized = std::make_shared<RasterizedImage>(
+        image, ImageAlignment::TopStart, ImageResize::NoResize, RGBAColor {}, cellSpan, cellSize);
+
+    // Fragments of adjacent cells are cut off as one bitmap of their combined width.
+    auto const both = rasterized->fragment(CellLocation {}, ColumnCount(2));
+    REQUIRE(both.size() == ImageBytes);
+    CHECK(both == makePixels(1));
+
+    auto const second = rasterized->fragment(CellLocation { .line = {}, .column = ColumnOffset(1) });
+    REQUIRE(second.size() == ImageBytes / 2);
+    CHECK(std::equal(second.begin(), second.begin() + 32, both.begin() + 32));
+
+    // Cells beyond the image's width are filled with the default color.
+    auto const beyond = rasterized->fragment(CellLocation { .line = {}, .column = ColumnOffset(1) },
+                                             ColumnCount(2));
+    REQUIRE(beyond.size() == ImageBytes);
+    CHECK(std::equal(beyond.begin(), beyond.begin() + 32, both.begin() + 32));
+    CHECK(std::all_of(beyond.begin() + 32, beyond.begin() + 64, [](auto value) { return value == 0; }));
+}
+
+TEST_CASE("ImagePool.deduplicate")
+{
+    auto removed = std::vector<ImageId> {};
+    auto pool = ImagePool { [&](Image const* image) { removed.emplace_back(image->id()); } };
+
+    auto first = pool.create(ImageFormat::RGBA, PixelSize, makePixels(1));
+    auto second = pool.create(ImageFormat::RGBA, PixelSize, makePixels(1));
+    auto const other = pool.create(ImageFormat::RGBA, PixelSize, makePixels(2));
+    CHECK(first == second);
+    CHECK(first != other);
+
+    auto const id = first->id();
+    first.reset();
+    CHECK(removed.empty());
+
+    auto otherPool = std::make_unique<ImagePool>();
+    auto shared = otherPool->create(ImageFormat::RGBA, PixelSize, makePixels(1));
+    CHECK(shared == second);
+
+    // The image outlives the pool it has been shared with.
+    otherPool.reset();
+    shared.reset();
+    CHECK(removed.empty());
+    second.reset();
+    REQUIRE(removed.size() == 1);
+    CHECK(removed.front() == id);
+}
+
+TEST_CASE("ImagePool.pending")
+{
+    auto pool = ImagePool {};
+
+    auto const image = pool.createPending(ImageFormat::RGBA, PixelSize);
+    CHECK(!image->decoded());
+    CHECK(image->residentSize() == 0);
+    CHECK(image != pool.create(ImageFormat::RGBA, PixelSize, Image::Data(ImageBytes)));
+
+    // Fragments of images still being decoded hold the default color.
+    auto const cellSpan = GridSize { .lines = LineCount(1), .columns = ColumnCount(1) };
+    auto const gapColor = RGBAColor { 0x10, 0x20, 0x30, 0x40 };
+    auto const rasterized = std::make_shared<RasterizedImage>(
+        image, ImageAlignment::TopStart, ImageResize::NoResize, gapColor, cellSpan, PixelSize);
+    auto const placeholder = ImageFragment(rasterized, CellLocation {}).data();
+    REQUIRE(placeholder.size() == ImageBytes);
+    CHECK(placeholder[0] == 0x10);
+    CHECK(placeholder[ImageBytes - 1] == 0x40);
+
+    image->setDecodedData(makePixels(1));
+    CHECK(image->decoded());
+    CHECK(ImageFragment(rasterized, CellLocation {}).data() == makePixels(1));
+}
@@ -4,7 +4,10 @@
 #include <vtbackend/InputGenerator.h>
 #include <vtbackend/MatchModes.h>
 
+#include <cstdint>
 #include <format>
+#include <unordered_map>
+#include <vector>
 
 namespace vtbackend
 {
@@ -55,6 +58,64 @@ bool operator<(InputBinding<I, O> const& a, InputBinding<I, O> const& b) noexcep
     return false;
 }
 
+/**
+ * Lookup table over a list of input bindings, finding the binding for an input event
+ * without scanning the whole list.
+ *
+ * Bindings are grouped by their input and modifiers, keeping their order within the list,
+ * so that the first binding whose modes match wins, just as when scanning the list.
+ *
+ * The table refers to the bindings of the list it was built from
+ * and must be rebuilt whenever that list changes.
+ */
+template <typename Input, typename Binding>
+class InputBindingIndex
+{
+  public:
+    InputBindingIndex() = default;
+
+    explicit InputBindingIndex(std::vector<InputBinding<Input, Binding>> const& bindings)
+    {
+        for (InputBinding<Input, Binding> const& binding: bindings)
+        {
+            _candidates[keyOf(binding.input, binding.modifiers)].emplace_back(
+                Candidate { .enabled = static_cast<uint8_t>(binding.modes.enabled()),
+                            .disabled = static_cast<uint8_t>(binding.modes.disabled()),
+                            .binding = &binding.binding });
+        }
+    }
+
+    /// @returns the first binding for the given input and modifiers whose modes all apply
+    ///          to @p modeFlags, a combination of MatchModes::Flag, or nullptr if there is none.
+    [[nodiscard]] Binding const* find(Input input, Modifiers modifiers, uint8_t modeFlags) const noexcept
+    {
+        auto const i = _candidates.find(keyOf(input, modifiers));
+        if (i == _candidates.end())
+            return nullptr;
+
+        for (Candidate const& candidate: i->second)
+            if ((modeFlags & candidate.enabled) == candidate.enabled && !(modeFlags & candidate.disabled))
+                return candidate.binding;
+
+        return nullptr;
+    }
+
+  private:
+    struct Candidate
+    {
+        uint8_t enabled;  // modes that must be active
+        uint8_t disabled; // modes that must not be active
+        Binding const* binding;
+    };
+
+    static uint64_t keyOf(Input input, Modifiers modifiers) noexcept
+    {
+        return (static_cast<uint64_t>(input) << 8) | static_cast<uint64_t>(modifiers.value());
+    }
+
+    std::unordered_map<uint64_t, std::vector<Candidate>> _candidates;
+};
+
 } // namespace vtbackend
 
 template <typename I, typename O>
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/InputBinding.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+using namespace vtbackend;
+
+namespace
+{
+MatchModes modes(MatchModes::Flag enabled, MatchModes::Flag disabled = MatchModes::Default)
+{
+    auto result = MatchModes {};
+    if (enabled != MatchModes::Default)
+        result.enable(enabled);
+    if (disabled != MatchModes::Default)
+        result.disable(disabled);
+    return result;
+}
+} // namespace
+
+TEST_CASE("InputBindingIndex.find")
+{
+    using Flag = MatchModes::Flag;
+    auto constexpr Control = Modifiers { Modifier::Control };
+    auto constexpr Shift = Modifiers { Modifier::Shift };
+
+    auto const bindings = std::vector<InputBinding<char32_t, int>> {
+        { .modes = modes(Flag::AlternateScreen), .modifiers = Control, .input = 'C', .binding = 1 },
+        { .modes = modes(Flag::Default, Flag::Select), .modifiers = Control, .input = 'C', .binding = 2 },
+        { .modes = MatchModes {}, .modifiers = Control, .input = 'C', .binding = 3 },
+        { .modes = MatchModes {}, .modifiers = Shift, .input = 'C', .binding = 4 },
+    };
+    auto const index = InputBindingIndex<char32_t, int> { bindings };
+
+    // The first binding whose modes match wins.
+    CHECK(*index.find('C', Control, uint8_t { Flag::AlternateScreen | Flag::Select }) == 1);
+    CHECK(*index.find('C', Control, Flag::AppCursor) == 2);
+    CHECK(*index.find('C', Control, Flag::Select) == 3);
+    CHECK(*index.find('C', Shift, Flag::Select) == 4);
+
+    CHECK(index.find('C', Modifiers {}, Flag::Default) == nullptr);
+    CHECK(index.find('D', Control, Flag::Default) == nullptr);
+    CHECK(InputBindingIndex<char32_t, int> {}.find('C', Control, Flag::Default) == nullptr);
+}
@@ -9,6 +9,7 @@
 #include <libunicode/convert.h>
 
 #include <array>
+#include <charconv>
 #include <format>
 #include <iterator>
 #include <string_view>
@@ -111,24 +112,38 @@ bool StandardKeyboardInputGenerator::generateChar(char32_t characterEvent,
     else
         append(unicode::convert_to<char>(characterEvent));
 
-    inputLog()("Sending {} \"{}\".", modifiers, crispy::escape(unicode::convert_to<char>(characterEvent)));
+    LOGSTORE_LOG(
+        inputLog, "Sending {} \"{}\".", modifiers, crispy::escape(unicode::convert_to<char>(characterEvent)));
     return true;
 }
 
-std::string StandardKeyboardInputGenerator::select(Modifiers modifiers, FunctionKeyMapping mapping) const
+void StandardKeyboardInputGenerator::appendMapped(Modifiers modifiers, FunctionKeyMapping mapping)
 {
     if (modifiers && !mapping.mods.empty())
-        return crispy::replace(mapping.mods, "{}"sv, makeVirtualTerminalParam(modifiers));
+    {
+        auto const placeholder = mapping.mods.find("{}"sv);
+        append(mapping.mods.substr(0, placeholder));
+        appendNumber(makeVirtualTerminalParam(modifiers));
+        append(mapping.mods.substr(placeholder + 2));
+        return;
+    }
 
-    auto const prefix = modifiers.contains(Modifier::Alt) ? "\033" : ""s;
+    if (modifiers.contains(Modifier::Alt))
+        append('\033');
 
     if (applicationCursorKeys() && !mapping.appCursor.empty())
-        return prefix + std::string(mapping.appCursor);
-
-    if (applicationKeypad() && !mapping.appKeypad.empty())
-        return prefix + std::string(mapping.appKeypad);
+        append(mapping.appCursor);
+    else if (applicationKeypad() && !mapping.appKeypad.empty())
+        append(mapping.appKeypad);
+    else
+        append(mapping.std);
+}
 
-    return prefix + std::string(mapping.std);
+void StandardKeyboardInputGenerator::appendNumber(size_t value)
+{
+    auto buffer = std::array<char, 20> {};
+    auto const result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+    append(std::string_view(buffer.data(), result.ptr));
 }
 
 bool StandardKeyboardInputGenerator::generateKey(Key key, Modifiers modifiers, KeyboardEventType eventType)
@@ -139,76 +154,76 @@ bool StandardKeyboardInputGenerator::generateKey(Key key, Modifiers modifiers, K
     // clang-format off
     switch (key)
     {
-        case Key::F1: append(select(modifiers, { .std = ESC "OP", .mods = ESC "O{}P" })); break;
-        case Key::F2: append(select(modifiers, { .std = ESC "OQ", .mods = ESC "O{}Q" })); break;
-        case Key::F3: append(select(modifiers, { .std = ESC "OR", .mods = ESC "O{}R" })); break;
-        case Key::F4: append(select(modifiers, { .std = ESC "OS", .mods = ESC "O{}S" })); break;
-        case Key::F5: append(select(modifiers, { .std = CSI "15~", .mods = CSI "15;{}~" })); break;
-        case Key::F6: append(select(modifiers, { .std = CSI "17~", .mods = CSI "17;{}~" })); break;
-        case Key::F7: append(select(modifiers, { .std = CSI "18~", .mods = CSI "18;{}~" })); break;
-        case Key::F8: append(select(modifiers, { .std = CSI "19~", .mods = CSI "19;{}~" })); break;
-        case Key::F9: append(select(modifiers, { .std = CSI "20~", .mods = CSI "20;{}~" })); break;
-        case Key::F10: append(select(modifiers, { .std = CSI "21~", .mods = CSI "21;{}~" })); break;
-        case Key::F11: append(select(modifiers, { .std = CSI "23~", .mods = CSI "23;{}~" })); break;
-        case Key::F12: append(select(modifiers, { .std = CSI "24~", .mods = CSI "24;{}~" })); break;
-        case Key::F13: append(select(modifiers, { .std = CSI "25~", .mods = CSI "25;{}~" })); break;
-        case Key::F14: append(select(modifiers, { .std = CSI "26~", .mods = CSI "26;{}~" })); break;
-        case Key::F15: append(select(modifiers, { .std = CSI "28~", .mods = CSI "28;{}~" })); break;
-        case Key::F16: append(select(modifiers, { .std = CSI "29~", .mods = CSI "29;{}~" })); break;
-        case Key::F17: append(select(modifiers, { .std = CSI "31~", .mods = CSI "31;{}~" })); break;
-        case Key::F18: append(select(modifiers, { .std = CSI "32~", .mods = CSI "32;{}~" })); break;
-        case Key::F19: append(select(modifiers, { .std = CSI "33~", .mods = CSI "33;{}~" })); break;
-        case Key::F20: append(select(modifiers, { .std = CSI "34~", .mods = CSI "34;{}~" })); break;
-        case Key::F21: append(select(modifiers, { .std = CSI "35~", .mods = CSI "35;{}~" })); break;
-        case Key::F22: append(select(modifiers, { .std = CSI "36~", .mods = CSI "36;{}~" })); break;
-        case Key::F23: append(select(modifiers, { .std = CSI "37~", .mods = CSI "37;{}~" })); break;
-        case Key::F24: append(select(modifiers, { .std = CSI "38~", .mods = CSI "38;{}~" })); break;
-        case Key::F25: append(select(modifiers, { .std = CSI "39~", .mods = CSI "39;{}~" })); break;
-        case Key::F26: append(select(modifiers, { .std = CSI "40~", .mods = CSI "40;{}~" })); break;
-        case Key::F27: append(select(modifiers, { .std = CSI "41~", .mods = CSI "41;{}~" })); break;
-        case Key::F28: append(select(modifiers, { .std = CSI "42~", .mods = CSI "42;{}~" })); break;
-        case Key::F29: append(select(modifiers, { .std = CSI "43~", .mods = CSI "43;{}~" })); break;
-        case Key::F30: append(select(modifiers, { .std = CSI "44~", .mods = CSI "44;{}~" })); break;
-        case Key::F31: append(select(modifiers, { .std = CSI "45~", .mods = CSI "45;{}~" })); break;
-        case Key::F32: append(select(modifiers, { .std = CSI "46~", .mods = CSI "46;{}~" })); break;
-        case Key::F33: append(select(modifiers, { .std = CSI "47~", .mods = CSI "47;{}~" })); break;
-        case Key::F34: append(select(modifiers, { .std = CSI "48~", .mods = CSI "48;{}~" })); break;
-        case Key::F35: append(select(modifiers, { .std = CSI "49~", .mods = CSI "49;{}~" })); break;
+        case Key::F1: appendMapped(modifiers, { .std = ESC "OP", .mods = ESC "O{}P" }); break;
+        case Key::F2: appendMapped(modifiers, { .std = ESC "OQ", .mods = ESC "O{}Q" }); break;
+        case Key::F3: appendMapped(modifiers, { .std = ESC "OR", .mods = ESC "O{}R" }); break;
+        case Key::F4: appendMapped(modifiers, { .std = ESC "OS", .mods = ESC "O{}S" }); break;
+        case Key::F5: appendMapped(modifiers, { .std = CSI "15~", .mods = CSI "15;{}~" }); break;
+        case Key::F6: appendMapped(modifiers, { .std = CSI "17~", .mods = CSI "17;{}~" }); break;
+        case Key::F7: appendMapped(modifiers, { .std = CSI "18~", .mods = CSI "18;{}~" }); break;
+        case Key::F8: appendMapped(modifiers, { .std = CSI "19~", .mods = CSI "19;{}~" }); break;
+        case Key::F9: appendMapped(modifiers, { .std = CSI "20~", .mods = CSI "20;{}~" }); break;
+        case Key::F10: appendMapped(modifiers, { .std = CSI "21~", .mods = CSI "21;{}~" }); break;
+        case Key::F11: appendMapped(modifiers, { .std = CSI "23~", .mods = CSI "23;{}~" }); break;
+        case Key::F12: appendMapped(modifiers, { .std = CSI "24~", .mods = CSI "24;{}~" }); break;
+        case Key::F13: appendMapped(modifiers, { .std = CSI "25~", .mods = CSI "25;{}~" }); break;
+        case Key::F14: appendMapped(modifiers, { .std = CSI "26~", .mods = CSI "26;{}~" }); break;
+        case Key::F15: appendMapped(modifiers, { .std = CSI "28~", .mods = CSI "28;{}~" }); break;
+        case Key::F16: appendMapped(modifiers, { .std = CSI "29~", .mods = CSI "29;{}~" }); break;
+        case Key::F17: appendMapped(modifiers, { .std = CSI "31~", .mods = CSI "31;{}~" }); break;
+        case Key::F18: appendMapped(modifiers, { .std = CSI "32~", .mods = CSI "32;{}~" }); break;
+        case Key::F19: appendMapped(modifiers, { .std = CSI "33~", .mods = CSI "33;{}~" }); break;
+        case Key::F20: appendMapped(modifiers, { .std = CSI "34~", .mods = CSI "34;{}~" }); break;
+        case Key::F21: appendMapped(modifiers, { .std = CSI "35~", .mods = CSI "35;{}~" }); break;
+        case Key::F22: appendMapped(modifiers, { .std = CSI "36~", .mods = CSI "36;{}~" }); break;
+        case Key::F23: appendMapped(modifiers, { .std = CSI "37~", .mods = CSI "37;{}~" }); break;
+        case Key::F24: appendMapped(modifiers, { .std = CSI "38~", .mods = CSI "38;{}~" }); break;
+        case Key::F25: appendMapped(modifiers, { .std = CSI "39~", .mods = CSI "39;{}~" }); break;
+        case Key::F26: appendMapped(modifiers, { .std = CSI "40~", .mods = CSI "40;{}~" }); break;
+        case Key::F27: appendMapped(modifiers, { .std = CSI "41~", .mods = CSI "41;{}~" }); break;
+        case Key::F28: appendMapped(modifiers, { .std = CSI "42~", .mods = CSI "42;{}~" }); break;
+        case Key::F29: appendMapped(modifiers, { .std = CSI "43~", .mods = CSI "43;{}~" }); break;
+        case Key::F30: appendMapped(modifiers, { .std = CSI "44~", .mods = CSI "44;{}~" }); break;
+        case Key::F31: appendMapped(modifiers, { .std = CSI "45~", .mods = CSI "45;{}~" }); break;
+        case Key::F32: appendMapped(modifiers, { .std = CSI "46~", .mods = CSI "46;{}~" }); break;
+        case Key::F33: appendMapped(modifiers, { .std = CSI "47~", .mods = CSI "47;{}~" }); break;
+        case Key::F34: appendMapped(modifiers, { .std = CSI "48~", .mods = CSI "48;{}~" }); break;
+        case Key::F35: appendMapped(modifiers, { .std = CSI "49~", .mods = CSI "49;{}~" }); break;
         case Key::Escape: append("\033"); break;
-        case Key::Enter: append(select(modifiers, { .std = "\r" })); break;
+        case Key::Enter: appendMapped(modifiers, { .std = "\r" }); break;
         case Key::Tab: generateChar('\t', 0, modifiers, eventType); break;
         case Key::Backspace:
             // Well accepted hack to distinguish between Backspace nad Ctrl+Backspace,
             // - Backspace is emitting 0x7f,
             // - Ctrl+Backspace is emitting 0x08
-            append(select(modifiers, { .std = modifiers & Modifier::Control ? "\x08" : "\x7F" })); break;
-        case Key::UpArrow: append(select(modifiers, { .std = CSI "A", .mods = CSI "1;{}A", .appCursor = SS3 "A" })); break;
-        case Key::DownArrow: append(select(modifiers, { .std = CSI "B", .mods = CSI "1;{}B", .appCursor = SS3 "B" })); break;
-        case Key::RightArrow: append(select(modifiers, { .std = CSI "C", .mods = CSI "1;{}C", .appCursor = SS3 "C" })); break;
-        case Key::LeftArrow: append(select(modifiers, { .std = CSI "D", .mods = CSI "1;{}D", .appCursor = SS3 "D" })); break;
-        case Key::Home: append(select(modifiers, { .std = CSI "H", .mods = CSI "1;{}H", .appCursor = SS3 "H" })); break;
-        case Key::End: append(select(modifiers, { .std = CSI "F", .mods = CSI "1;{}F", .appCursor = SS3 "F" })); break;
-        case Key::PageUp: append(select(modifiers, { .std = CSI "5~", .mods = CSI "5;{}~", .appKeypad = CSI "5~" })); break;
-        case Key::PageDown: append(select(modifiers, { .std = CSI "6~", .mods = CSI "6;{}~", .appKeypad = CSI "6~" })); break;
-        case Key::Insert: append(select(modifiers, { .std = CSI "2~", .mods = CSI "2;{}~" })); break;
-        case Key::Delete: append(select(modifiers, { .std = CSI "3~", .mods = CSI "3;{}~" })); break;
-        case Key::Numpad_Enter:    append(select(modifiers, { .std = "\r", .appKeypad = SS3 "M" })); break;
-        case Key::Numpad_Multiply: append(select(modifiers, { .std = "*",  .appKeypad = SS3 "j" })); break;
-        case Key::Numpad_Add:      append(select(modifiers, { .std = "+",  .appKeypad = SS3 "k" })); break;
-        case Key::Numpad_Subtract: append(select(modifiers, { .std = "-",  .appKeypad = SS3 "m" })); break;
-        case Key::Numpad_Decimal:  append(select(modifiers, { .std = ".",  .appKeypad = CSI "3~" })); break;
-        case Key::Numpad_Divide:   append(select(modifiers, { .std = "/",  .appKeypad = SS3 "o" })); break;
-        case Key::Numpad_0:        append(select(modifiers, { .std = "0",  .appKeypad = CSI "2~" })); break;
-        case Key::Numpad_1:        append(select(modifiers, { .std = "1",  .appKeypad = SS3 "F" })); break;
-        case Key::Numpad_2:        append(select(modifiers, { .std = "2",  .appKeypad = CSI "B" })); break;
-        case Key::Numpad_3:        append(select(modifiers, { .std = "3",  .appKeypad = CSI "6~" })); break;
-        case Key::Numpad_4:        append(select(modifiers, { .std = "4",  .appKeypad = CSI "D" })); break;
-        case Key::Numpad_5:        append(select(modifiers, { .std = "5",  .appKeypad = CSI "E" })); break;
-        case Key::Numpad_6:        append(select(modifiers, { .std = "6",  .appKeypad = CSI "C" })); break;
-        case Key::Numpad_7:        append(select(modifiers, { .std = "7",  .appKeypad = SS3 "H" })); break;
-        case Key::Numpad_8:        append(select(modifiers, { .std = "8",  .appKeypad = CSI "A" })); break;
-        case Key::Numpad_9:        append(select(modifiers, { .std = "9",  .appKeypad = CSI "5~" })); break;
-        case Key::Numpad_Equal:    append(select(modifiers, { .std = "=",  .appKeypad = SS3 "X" })); break;
+            appendMapped(modifiers, { .std = modifiers & Modifier::Control ? "\x08" : "\x7F" }); break;
+        case Key::UpArrow: appendMapped(modifiers, { .std = CSI "A", .mods = CSI "1;{}A", .appCursor = SS3 "A" }); break;
+        case Key::DownArrow: appendMapped(modifiers, { .std = CSI "B", .mods = CSI "1;{}B", .appCursor = SS3 "B" }); break;
+        case Key::RightArrow: appendMapped(modifiers, { .std = CSI "C", .mods = CSI "1;{}C", .appCursor = SS3 "C" }); break;
+        case Key::LeftArrow: appendMapped(modifiers, { .std = CSI "D", .mods = CSI "1;{}D", .appCursor = SS3 "D" }); break;
+        case Key::Home: appendMapped(modifiers, { .std = CSI "H", .mods = CSI "1;{}H", .appCursor = SS3 "H" }); break;
+        case Key::End: appendMapped(modifiers, { .std = CSI "F", .mods = CSI "1;{}F", .appCursor = SS3 "F" }); break;
+        case Key::PageUp: appendMapped(modifiers, { .std = CSI "5~", .mods = CSI "5;{}~", .appKeypad = CSI "5~" }); break;
+        case Key::PageDown: appendMapped(modifiers, { .std = CSI "6~", .mods = CSI "6;{}~", .appKeypad = CSI "6~" }); break;
+        case Key::Insert: appendMapped(modifiers, { .std = CSI "2~", .mods = CSI "2;{}~" }); break;
+        case Key::Delete: appendMapped(modifiers, { .std = CSI "3~", .mods = CSI "3;{}~" }); break;
+        case Key::Numpad_Enter:    appendMapped(modifiers, { .std = "\r", .appKeypad = SS3 "M" }); break;
+        case Key::Numpad_Multiply: appendMapped(modifiers, { .std = "*",  .appKeypad = SS3 "j" }); break;
+        case Key::Numpad_Add:      appendMapped(modifiers, { .std = "+",  .appKeypad = SS3 "k" }); break;
+        case Key::Numpad_Subtract: appendMapped(modifiers, { .std = "-",  .appKeypad = SS3 "m" }); break;
+        case Key::Numpad_Decimal:  appendMapped(modifiers, { .std = ".",  .appKeypad = CSI "3~" }); break;
+        case Key::Numpad_Divide:   appendMapped(modifiers, { .std = "/",  .appKeypad = SS3 "o" }); break;
+        case Key::Numpad_0:        appendMapped(modifiers, { .std = "0",  .appKeypad = CSI "2~" }); break;
+        case Key::Numpad_1:        appendMapped(modifiers, { .std = "1",  .appKeypad = SS3 "F" }); break;
+        case Key::Numpad_2:        appendMapped(modifiers, { .std = "2",  .appKeypad = CSI "B" }); break;
+        case Key::Numpad_3:        appendMapped(modifiers, { .std = "3",  .appKeypad = CSI "6~" }); break;
+        case Key::Numpad_4:        appendMapped(modifiers, { .std = "4",  .appKeypad = CSI "D" }); break;
+        case Key::Numpad_5:        appendMapped(modifiers, { .std = "5",  .appKeypad = CSI "E" }); break;
+        case Key::Numpad_6:        appendMapped(modifiers, { .std = "6",  .appKeypad = CSI "C" }); break;
+        case Key::Numpad_7:        appendMapped(modifiers, { .std = "7",  .appKeypad = SS3 "H" }); break;
+        case Key::Numpad_8:        appendMapped(modifiers, { .std = "8",  .appKeypad = CSI "A" }); break;
+        case Key::Numpad_9:        appendMapped(modifiers, { .std = "9",  .appKeypad = CSI "5~" }); break;
+        case Key::Numpad_Equal:    appendMapped(modifiers, { .std = "=",  .appKeypad = SS3 "X" }); break;
         // {{{ unsupported keys in legacy input protocol
         case Key::MediaPlay:
         case Key::MediaStop:
@@ -260,9 +275,11 @@ bool ExtendedKeyboardInputGenerator::generateChar(char32_t characterEvent,
             && (modifiers.without(Modifier::Shift).any()
                 || enabled(KeyboardEventFlag::ReportAllKeysAsEscapeCodes)))
         {
-            append("\033[{};{}u",
-                   encodeCharacter(characterEvent, physicalKey, modifiers),
-                   encodeModifiers(modifiers, eventType));
+            append("\033["sv);
+            appendEncodedCharacter(characterEvent, physicalKey, modifiers);
+            append(';');
+            appendEncodedModifiers(modifiers, eventType);
+            append('u');
             return true;
         }
     }
@@ -275,27 +292,31 @@ constexpr unsigned encodeEventType(KeyboardEventType eventType) noexcept
     return static_cast<unsigned>(eventType);
 }
 
-std::string ExtendedKeyboardInputGenerator::encodeModifiers(Modifiers modifiers,
-                                                            KeyboardEventType eventType) const
+bool ExtendedKeyboardInputGenerator::hasEncodedModifiers(Modifiers modifiers) const noexcept
 {
-    if (enabled(KeyboardEventFlag::ReportEventTypes))
-        return std::format("{}:{}", modifiers.value(), encodeEventType(eventType));
-
-    if (modifiers.value() != 0)
-        return std::to_string(1 + modifiers.value());
+    return enabled(KeyboardEventFlag::ReportEventTypes) || modifiers.value() != 0;
+}
 
-    return "";
+void ExtendedKeyboardInputGenerator::appendEncodedModifiers(Modifiers modifiers, KeyboardEventType eventType)
+{
+    if (enabled(KeyboardEventFlag::ReportEventTypes))
+    {
+        appendNumber(modifiers.value());
+        append(':');
+        appendNumber(encodeEventType(eventType));
+    }
+    else if (modifiers.value() != 0)
+        appendNumber(1 + modifiers.value());
 }
 
-std::string ExtendedKeyboardInputGenerator::encodeCharacter(char32_t ch,
+void ExtendedKeyboardInputGenerator::appendEncodedCharacter(char32_t ch,
                                                             uint32_t physicalKey,
-                                                            Modifiers modifiers) const
+                                                            Modifiers modifiers)
 {
     // The codepoint is always the lower-case form
     // TODO: use libunicode for down-shifting
-    auto unshiftedKey = ch < 0x80 ? std::format("{}", std::tolower(static_cast<char>(ch))) : ""s;
-
-    auto result = std::move(unshiftedKey);
+    if (ch < 0x80)
+        appendNumber(static_cast<size_t>(std::tolower(static_cast<char>(ch))));
 
     if (enabled(KeyboardEventFlag::ReportAlternateKeys))
     {
@@ -307,19 +328,17 @@ std::string ExtendedKeyboardInputGenerator::encodeCharacter(char32_t ch,
 
         bool const showPhysicalKey = physicalKey && physicalKey != ch && physicalKey != shiftedKey;
         if (shiftedKey || showPhysicalKey)
-            result += ':';
+            append(':');
         if (shiftedKey)
-            result += std::to_string(shiftedKey);
+            appendNumber(shiftedKey);
 
         // The base layout key is the key corresponding to the physical key in the standard PC-101 key layout
         if (showPhysicalKey)
         {
-            result += ':';
-            result += std::to_string(physicalKey);
+            append(':');
+            appendNumber(physicalKey);
         }
     }
-
-    return result;
 }
 
 constexpr pair<unsigned, char> mapKey(Key key) noexcept
@@ -495,12 +514,14 @@ bool ExtendedKeyboardInputGenerator::generateKey(Key key, Modifiers modifiers, K
         return false;
 
     auto const [code, function] = mapKey(key);
-    auto const encodedModifiers = encodeModifiers(modifiers, eventType);
-    auto controlSequence = std::format("\033[{}", code);
-    if (!encodedModifiers.empty())
-        controlSequence += std::format(";{}", encodedModifiers);
-    controlSequence += function;
-    append(controlSequence);
+    append("\033["sv);
+    appendNumber(code);
+    if (hasEncodedModifiers(modifiers))
+    {
+        append(';');
+        appendEncodedModifiers(modifiers, eventType);
+    }
+    append(function);
 
     return true;
 }
@@ -514,6 +535,7 @@ void InputGenerator::reset()
     _mouseProtocol = std::nullopt;
     _mouseTransport = MouseTransport::Default;
     _mouseWheelMode = MouseWheelMode::Default;
+    _pendingMouseMove = std::nullopt;
 
     // _pendingSequence = {};
     // _currentMousePosition = {0, 0}; // current mouse position
@@ -548,11 +570,12 @@ bool InputGenerator::generate(char32_t characterEvent,
 
     if (success)
     {
-        _pendingSequence += _keyboardInputGenerator.take();
-        inputLog()("Sending {} \"{}\" {}.",
-                   modifiers,
-                   crispy::escape(unicode::convert_to<char>(characterEvent)),
-                   eventType);
+        _keyboardInputGenerator.flushTo(_pendingSequence);
+        LOGSTORE_LOG(inputLog,
+                     "Sending {} \"{}\" {}.",
+                     modifiers,
+                     crispy::escape(unicode::convert_to<char>(characterEvent)),
+                     eventType);
     }
 
     return success;
@@ -564,7 +587,7 @@ bool InputGenerator::generate(Key key, Modifiers modifiers, KeyboardEventType ev
 
     if (success)
     {
-        _pendingSequence += _keyboardInputGenerator.take();
+        _keyboardInputGenerator.flushTo(_pendingSequence);
         inputLog()("Sending {} \"{}\" {}.", modifiers, key, eventType);
     }
 
@@ -643,6 +666,8 @@ bool InputGenerator::generateRaw(std::string_view const& raw)
 // {{{ mouse handling
 void InputGenerator::setMouseProtocol(MouseProtocol mouseProtocol, bool enabled)
 {
+    // A move coalesced under the previous protocol is not to be reported in the new one.
+    _pendingMouseMove = std::nullopt;
     if (enabled)
     {
         _mouseWheelMode = MouseWheelMode::Default;
@@ -655,6 +680,7 @@ void InputGenerator::setMouseProtocol(MouseProtocol mouseProtocol, bool enabled)
 void InputGenerator::setMouseTransport(MouseTransport mouseTransport)
 {
     _mouseTransport = mouseTransport;
+    _pendingMouseMove = std::nullopt;
 }
 
 void InputGenerator::setMouseWheelMode(MouseWheelMode mode) noexcept
@@ -904,6 +930,9 @@ bool InputGenerator::generateMousePress(
     if (!_mouseProtocol.has_value())
         return false;
 
+    // Moves are reported in the order they happened, even when coalesced.
+    reportPendingMouseMove();
+
     switch (mouseWheelMode())
     {
         case MouseWheelMode::NormalCursorKeys:
@@ -947,6 +976,7 @@ bool InputGenerator::generateMouseRelease(
     };
 
     _currentMousePosition = pos;
+    reportPendingMouseMove();
 
     if (auto i = _currentlyPressedMouseButtons.find(button); i != _currentlyPressedMouseButtons.end())
         _currentlyPressedMouseButtons.erase(i);
@@ -958,25 +988,13 @@ bool InputGenerator::generateMouseRelease(
 bool InputGenerator::generateMouseMove(Modifiers modifiers,
                                        CellLocation pos,
                                        PixelCoordinate pixelPosition,
-                                       bool uiHandled)
+                                       bool uiHandled,
+                                       std::chrono::steady_clock::time_point now)
 {
     if (pos == _currentMousePosition && _mouseTransport != MouseTransport::SGRPixels)
         // Only generate a mouse move event if the coordinate of interest(!) has actually changed.
         return false;
 
-    auto const logged = [&](bool success) -> bool {
-        if (success)
-        {
-            inputLog()("[{}:{}] Sending mouse move at {} ({}:{}).",
-                       _mouseProtocol.value(),
-                       _mouseTransport,
-                       pos,
-                       pixelPosition.x.value,
-                       pixelPosition.y.value);
-        }
-        return success;
-    };
-
     _currentMousePosition = pos;
 
     if (!_mouseProtocol.has_value())
@@ -987,17 +1005,63 @@ bool InputGenerator::generateMouseMove(Modifiers modifiers,
     bool const report = (_mouseProtocol.value() == MouseProtocol::ButtonTracking && buttonsPressed)
                         || _mouseProtocol.value() == MouseProtocol::AnyEventTracking;
 
-    if (report)
-        return logged(generateMouse(
-            MouseEventType::Drag,
-            modifiers,
-            buttonsPressed ? *_currentlyPressedMouseButtons.begin() // what if multiple are pressed?
-                           : MouseButton::Release,
-            pos,
-            pixelPosition,
-            uiHandled));
+    if (!report)
+        return false;
 
-    return false;
+    auto const move = MouseMove {
+        .modifiers = modifiers,
+        .button = buttonsPressed ? *_currentlyPressedMouseButtons.begin() // what if multiple are pressed?
+                                 : MouseButton::Release,
+        .pos = pos,
+        .pixelPosition = pixelPosition,
+        .uiHandled = uiHandled,
+    };
+
+    // Pixel-precise moves arrive at the rate of the pointing device, which may well exceed
+    // what the application can consume, so only the last one per interval is reported.
+    if (_mouseTransport == MouseTransport::SGRPixels && now < _lastMouseMoveReport + _pixelMouseMoveInterval)
+    {
+        _pendingMouseMove = move;
+        return false;
+    }
+
+    _pendingMouseMove = std::nullopt;
+    _lastMouseMoveReport = now;
+    return reportMouseMove(move);
+}
+
+bool InputGenerator::flushPendingMouseMove(std::chrono::steady_clock::time_point now)
+{
+    if (!_pendingMouseMove || now < _lastMouseMoveReport + _pixelMouseMoveInterval)
+        return false;
+
+    _lastMouseMoveReport = now;
+    return reportPendingMouseMove();
+}
+
+bool InputGenerator::reportPendingMouseMove()
+{
+    if (!_pendingMouseMove)
+        return false;
+
+    auto const move = *_pendingMouseMove;
+    _pendingMouseMove = std::nullopt;
+    return reportMouseMove(move);
+}
+
+bool InputGenerator::reportMouseMove(MouseMove const& move)
+{
+    if (!generateMouse(
+            MouseEventType::Drag, move.modifiers, move.button, move.pos, move.pixelPosition, move.uiHandled))
+        return false;
+
+    inputLog()("[{}:{}] Sending mouse move at {} ({}:{}).",
+               _mouseProtocol.value(),
+               _mouseTransport,
+               move.pos,
+               move.pixelPosition.x.value,
+               move.pixelPosition.y.value);
+    return true;
 }
 // }}}
 
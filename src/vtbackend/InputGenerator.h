@@ -9,7 +9,9 @@
 
 #include <libunicode/convert.h>
 
+#include <chrono>
 #include <format>
+#include <iterator>
 #include <optional>
 #include <set>
 #include <string>
@@ -271,6 +273,13 @@ class StandardKeyboardInputGenerator: public KeyboardInputGenerator
         return result;
     }
 
+    /// Appends the pending sequence to @p output and clears it, keeping its buffer for the next event.
+    void flushTo(std::string& output)
+    {
+        output += _pendingSequence;
+        _pendingSequence.clear();
+    }
+
     void reset()
     {
         _cursorKeysMode = KeyMode::Normal;
@@ -286,15 +295,11 @@ class StandardKeyboardInputGenerator: public KeyboardInputGenerator
         std::string_view appKeypad {};
     };
 
-    [[nodiscard]] std::string select(Modifiers modifier, FunctionKeyMapping mapping) const;
+    /// Appends the sequence of @p mapping that applies to the given modifiers and the current modes.
+    void appendMapped(Modifiers modifier, FunctionKeyMapping mapping);
     void append(char ch) { _pendingSequence += ch; }
     void append(std::string_view sequence) { _pendingSequence += sequence; }
-
-    template <typename... Args>
-    void append(std::string_view const& text, Args... args)
-    {
-        append(std::vformat(text, std::make_format_args(args...)));
-    }
+    void appendNumber(size_t value);
 
     KeyMode _cursorKeysMode = KeyMode::Normal;
     KeyMode _numpadKeysMode = KeyMode::Normal;
@@ -361,8 +366,9 @@ class ExtendedKeyboardInputGenerator final: public StandardKeyboardInputGenerato
     // }}}
 
   private:
-    [[nodiscard]] std::string encodeCharacter(char32_t ch, uint32_t physicalKey, Modifiers modifier) const;
-    [[nodiscard]] std::string encodeModifiers(Modifiers modifier, KeyboardEventType eventType) const;
+    void appendEncodedCharacter(char32_t ch, uint32_t physicalKey, Modifiers modifier);
+    [[nodiscard]] bool hasEncodedModifiers(Modifiers modifier) const noexcept;
+    void appendEncodedModifiers(Modifiers modifier, KeyboardEventType eventType);
 
     std::array<KeyboardEventFlags, MaxStackDepth> _flags = { KeyboardEventFlag::None };
     size_t _currentStackTop = 0;
@@ -425,6 +431,24 @@ class InputGenerator
     void setPassiveMouseTracking(bool v) noexcept { _passiveMouseTracking = v; }
     [[nodiscard]] bool passiveMouseTracking() const noexcept { return _passiveMouseTracking; }
 
+    /// Sets the minimum time between two mouse move reports in pixel-precise (SGR-Pixels) transport.
+    ///
+    /// Moves within that interval are coalesced into the last one, which is reported by
+    /// flushPendingMouseMove() once the interval has passed, or right before the next press or release.
+    void setPixelMouseMoveInterval(std::chrono::steady_clock::duration interval) noexcept
+    {
+        _pixelMouseMoveInterval = interval;
+    }
+
+    /// Returns the time at which the coalesced mouse move is due to be reported, if any.
+    [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> pendingMouseMoveDeadline()
+        const noexcept
+    {
+        if (!_pendingMouseMove)
+            return std::nullopt;
+        return _lastMouseMoveReport + _pixelMouseMoveInterval;
+    }
+
     bool generate(char32_t characterEvent,
                   uint32_t physicalKey,
                   Modifiers modifier,
@@ -445,7 +469,11 @@ class InputGenerator
     bool generateMouseMove(Modifiers modifier,
                            CellLocation pos,
                            PixelCoordinate pixelPosition,
-                           bool uiHandled);
+                           bool uiHandled,
+                           std::chrono::steady_clock::time_point now);
+
+    /// Reports the coalesced mouse move, if any, once its interval has passed.
+    bool flushPendingMouseMove(std::chrono::steady_clock::time_point now);
     bool generateMouseRelease(Modifiers modifier,
                               MouseButton button,
                               CellLocation pos,
@@ -458,6 +486,12 @@ class InputGenerator
     /// Generates raw input, usually used for sending reply VT sequences.
     bool generateRaw(std::string_view const& raw);
 
+    /// Generates raw input formatted from @p message and @p args, straight into the pending input.
+    void generateFormatted(std::string_view message, std::format_args args)
+    {
+        std::vformat_to(std::back_inserter(_pendingSequence), message, args);
+    }
+
     /// Peeks into the generated output, returning it as string view.
     ///
     /// @return a view into the generated buffer sequence.
@@ -498,6 +532,18 @@ class InputGenerator
     }
 
   private:
+    struct MouseMove
+    {
+        Modifiers modifiers;
+        MouseButton button;
+        CellLocation pos;
+        PixelCoordinate pixelPosition;
+        bool uiHandled;
+    };
+
+    bool reportMouseMove(MouseMove const& move);
+    bool reportPendingMouseMove();
+
     bool generateMouse(MouseEventType eventType,
                        Modifiers modifier,
                        MouseButton button,
@@ -538,6 +584,9 @@ class InputGenerator
 
     std::set<MouseButton> _currentlyPressedMouseButtons {};
     CellLocation _currentMousePosition {}; // current mouse position
+    std::chrono::steady_clock::duration _pixelMouseMoveInterval {};
+    std::chrono::steady_clock::time_point _lastMouseMoveReport {};
+    std::optional<MouseMove> _pendingMouseMove = std::nullopt; // coalesced move in SGR-Pixels transport
     ExtendedKeyboardInputGenerator _keyboardInputGenerator {};
 };
 
@@ -7,6 +7,7 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <chrono>
 #include <string>
 
 using namespace std;
@@ -57,6 +58,58 @@ TEST_CASE("InputGenerator.consume")
     REQUIRE(input.peek().empty());
 }
 
+TEST_CASE("InputGenerator.generateFormatted")
+{
+    auto input = InputGenerator {};
+    auto const line = 3;
+    auto const column = 14;
+    input.generateRaw("\033[0n"sv);
+    input.generateFormatted("\033[{};{}R", std::make_format_args(line, column));
+    CHECK(escape(input.peek()) == escape("\033[0n\033[3;14R"sv));
+}
+
+TEST_CASE("InputGenerator.mouse.coalesced_pixel_moves", "[terminal,input]")
+{
+    using namespace std::chrono_literals;
+
+    auto input = InputGenerator {};
+    input.setMouseProtocol(MouseProtocol::AnyEventTracking, true);
+    input.setMouseTransport(MouseTransport::SGRPixels);
+    input.setPixelMouseMoveInterval(10ms);
+
+    auto const start = chrono::steady_clock::time_point {} + 1s;
+    auto const cell = CellLocation {};
+    auto const at = [](int x) {
+        return PixelCoordinate { .x = PixelCoordinate::X { x }, .y = PixelCoordinate::Y { 5 } };
+    };
+    auto const flush = [&]() {
+        auto result = string(input.peek());
+        input.consume(static_cast<int>(result.size()));
+        return result;
+    };
+
+    REQUIRE(input.generateMouseMove(Modifier::None, cell, at(1), false, start));
+    CHECK(flush().ends_with(";1;5M"));
+
+    // Moves within the interval are held back, and only the last one of them is reported.
+    CHECK_FALSE(input.generateMouseMove(Modifier::None, cell, at(2), false, start + 2ms));
+    CHECK_FALSE(input.generateMouseMove(Modifier::None, cell, at(3), false, start + 4ms));
+    CHECK(input.peek().empty());
+    REQUIRE(input.pendingMouseMoveDeadline() == start + 10ms);
+    CHECK_FALSE(input.flushPendingMouseMove(start + 9ms));
+    REQUIRE(input.flushPendingMouseMove(start + 10ms));
+    CHECK(flush().ends_with(";3;5M"));
+    CHECK_FALSE(input.pendingMouseMoveDeadline().has_value());
+
+    // A press reports the held back move first.
+    CHECK_FALSE(input.generateMouseMove(Modifier::None, cell, at(4), false, start + 12ms));
+    REQUIRE(input.generateMousePress(Modifier::None, MouseButton::Left, cell, at(4), false));
+    auto const sequence = flush();
+    CHECK(sequence.starts_with("\033[<35;4;5M"));
+    CHECK(sequence.ends_with("\033[<0;4;5M"));
+    CHECK_FALSE(input.pendingMouseMoveDeadline().has_value());
+}
+
 TEST_CASE("InputGenerator.Ctrl+Space", "[terminal,input]")
 {
     auto input = InputGenerator {};
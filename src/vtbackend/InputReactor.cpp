@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/InputReactor.h>
+#include <vtbackend/Terminal.h>
+#include <vtbackend/logging.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <span>
+
+#if defined(__linux__)
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+namespace vtbackend
+{
+
+size_t InputReactor::defaultWorkerCount() noexcept
+{
+    return std::clamp(static_cast<size_t>(std::thread::hardware_concurrency()), size_t { 2 }, size_t { 8 });
+}
+
+InputReactor::InputReactor(size_t workerCount)
+{
+#if defined(__linux__)
+    _epollFd = crispy::file_descriptor::from_native(epoll_create1(EPOLL_CLOEXEC));
+    _wakeupFd = crispy::file_descriptor::from_native(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    if (_epollFd.is_closed() || _wakeupFd.is_closed())
+    {
+        errorLog()("Failed to create input reactor. {}", strerror(errno));
+        _epollFd.close();
+        return;
+    }
+
+    auto event = epoll_event {};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeupFd, &event) != 0)
+    {
+        errorLog()("Failed to watch input reactor wakeup descriptor. {}", strerror(errno));
+        _epollFd.close();
+        return;
+    }
+
+    _workers = std::vector<Worker>(std::max(workerCount, size_t { 1 }));
+    for (size_t i = 0; i < _workers.size(); ++i)
+        _workers[i].thread = std::thread { [this, i]() {
+            runWorker(i);
+        } };
+    _reactor = std::thread { [this]() {
+        runReactor();
+    } };
+#else
+    (void) workerCount;
+#endif
+}
+
+InputReactor::~InputReactor()
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        _stopping = true;
+        if (!_entries.empty())
+            terminalLog()("Destroying input reactor with {} terminals still added.", _entries.size());
+    }
+    _queued.notify_all();
+
+#if defined(__linux__)
+    if (_wakeupFd.is_open())
+    {
+        auto const value = uint64_t { 1 };
+        [[maybe_unused]] auto const _ = ::write(_wakeupFd, &value, sizeof(value));
+    }
+#endif
+
+    if (_reactor.joinable())
+        _reactor.join();
+    for (auto& worker: _workers)
+        if (worker.thread.joinable())
+            worker.thread.join();
+}
+
+bool InputReactor::add(Terminal& terminal, OnClosed onClosed)
+{
+#if defined(__linux__) && !defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
+    // The PTY reader thread reads the PTY on its own already, and the passive render buffer update
+    // relies on the input processing to time out periodically, neither of which fits a reactor.
+    if (_epollFd.is_closed() || terminal.settings().ptyReaderThread)
+        return false;
+
+    auto const fd = terminal.device().readinessDescriptor();
+    if (!fd)
+        return false;
+
+    auto const lock = std::scoped_lock { _mutex };
+    auto const id = _nextId++;
+    auto entry = std::make_unique<Entry>(Entry {
+        .id = id,
+        .terminal = &terminal,
+        .onClosed = std::move(onClosed),
+        .fd = *fd,
+    });
+
+    auto event = epoll_event {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = id;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, *fd, &event) != 0)
+    {
+        errorLog()("Failed to add PTY to input reactor. {}", strerror(errno));
+        return false;
+    }
+
+    _entries.emplace(id, std::move(entry));
+    return true;
+#else
+    (void) terminal;
+    (void) onClosed;
+    return false;
+#endif
+}
+
+bool InputReactor::remove(Terminal& terminal)
+{
+    auto lock = std::unique_lock { _mutex };
+    auto const i = std::find_if(
+        _entries.begin(), _entries.end(), [&](auto const& e) { return e.second->terminal == &terminal; });
+    if (i == _entries.end())
+        return false;
+
+    auto& entry = *i->second;
+    auto const id = entry.id;
+    entry.removed = true;
+
+#if defined(__linux__)
+    if (entry.state != State::Closed)
+        epoll_ctl(_epollFd, EPOLL_CTL_DEL, entry.fd, nullptr);
+#endif
+
+    for (auto& worker: _workers)
+        std::erase(worker.queue, &entry);
+
+    _idle.wait(lock, [&]() { return entry.state != State::Processing; });
+
+    // Look the entry up again, as other entries may have been added meanwhile.
+    _entries.erase(id);
+    return true;
+}
+
+size_t InputReactor::size() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _entries.size();
+}
+
+void InputReactor::runReactor()
+{
+#if defined(__linux__)
+    auto events = std::array<epoll_event, 64> {};
+    for (;;)
+    {
+        auto const count = epoll_wait(_epollFd, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            errorLog()("Input reactor failed waiting for PTYs. {}", strerror(errno));
+            return;
+        }
+
+        {
+            auto const lock = std::scoped_lock { _mutex };
+            if (_stopping)
+                return;
+
+            auto const now = std::chrono::steady_clock::now();
+
+            for (auto const& event: std::span(events.data(), static_cast<size_t>(count)))
+            {
+                // Entries may have been removed after epoll_wait() returned, so they are looked up by ID.
+                auto const i = _entries.find(event.data.u64);
+                if (i == _entries.end())
+                    continue;
+
+                auto& entry = *i->second;
+                if (entry.removed || entry.state != State::Waiting)
+                    continue;
+
+                entry.state = State::Queued;
+                auto& queue = _workers[_nextWorker].queue;
+                if (now - entry.terminal->lastKeyInputTime() < InteractiveInterval)
+                    queue.push_front(&entry);
+                else
+                    queue.push_back(&entry);
+                _nextWorker = (_nextWorker + 1) % _workers.size();
+            }
+        }
+        _queued.notify_all();
+    }
+#endif
+}
+
+void InputReactor::runWorker(size_t index)
+{
+    auto lock = std::unique_lock { _mutex };
+    for (;;)
+    {
+        Entry* entry = nullptr;
+        _queued.wait(lock, [&]() { return _stopping || (entry = takeQueued(index)) != nullptr; });
+        if (_stopping)
+            return;
+
+        entry->state = State::Processing;
+        lock.unlock();
+
+        auto const open = process(*entry);
+        if (!open && entry->onClosed)
+            entry->onClosed();
+
+        lock.lock();
+        if (open)
+        {
+            entry->state = State::Waiting;
+            if (!entry->removed)
+                rearm(*entry);
+        }
+        else
+        {
+            entry->state = State::Closed;
+#if defined(__linux__)
+            if (!entry->removed)
+                epoll_ctl(_epollFd, EPOLL_CTL_DEL, entry->fd, nullptr);
+#endif
+        }
+        _idle.notify_all();
+    }
+}
+
+bool InputReactor::process(Entry& entry)
+{
+    auto const deadline = std::chrono::steady_clock::now() + TimeQuantum;
+    for (size_t i = 0; i < BatchSize; ++i)
+    {
+        if (!entry.terminal->processInputOnce(std::chrono::milliseconds(0)))
+            return false;
+
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+
+#if defined(__linux__)
+        // Keep processing while more input is pending, saving the round trip through the reactor.
+        auto pfd = pollfd { .fd = entry.fd, .events = POLLIN, .revents = 0 };
+        if (poll(&pfd, 1, 0) <= 0)
+            break;
+#endif
+    }
+    return true;
+}
+
+InputReactor::Entry* InputReactor::takeQueued(size_t index)
+{
+    if (auto& own = _workers[index].queue; !own.empty())
+    {
+        auto* entry = own.front();
+        own.pop_front();
+        return entry;
+    }
+
+    // Steal the most recently queued entry of another worker, which that one would have come to last.
+    for (size_t i = 1; i < _workers.size(); ++i)
+    {
+        auto& other = _workers[(index + i) % _workers.size()].queue;
+        if (!other.empty())
+        {
+            auto* entry = other.back();
+            other.pop_back();
+            return entry;
+        }
+    }
+
+    return nullptr;
+}
+
+void InputReactor::rearm(Entry& entry)
+{
+#if defined(__linux__)
+    auto event = epoll_event {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = entry.id;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_MOD, entry.fd, &event) != 0)
+        errorLog()("Failed to rearm PTY in input reactor. {}", strerror(errno));
+#else
+    (void) entry;
+#endif
+}
+
+} // namespace vtbackend
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <crispy/file_descriptor.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vtbackend
+{
+
+class Terminal;
+
+/**
+ * Processes the PTY input of many terminals on a shared pool of worker threads,
+ * instead of on a thread of their own each.
+ *
+ * A single reactor thread waits for the PTYs of all terminals at once, and queues each terminal
+ * whose PTY became readable to a worker, which then processes its input without blocking.
+ * Idle workers steal queued terminals from the other workers.
+ *
+ * Each terminal gets a quantum of input chunks and time per turn, and terminals having received
+ * key input recently are queued ahead of the others, so that interactive terminals stay responsive
+ * while others are flooded with output.
+ *
+ * A terminal is processed by at most one worker at a time, and its PTY is only waited for again
+ * once it has been processed, so that its input is processed in order and under its own lock,
+ * just like on a thread of its own.
+ *
+ * Only PTYs providing a readiness descriptor can be processed this way, and only on Linux.
+ */
+class InputReactor
+{
+  public:
+    /// Invoked on a worker thread once the terminal's PTY has been closed.
+    using OnClosed = std::function<void()>;
+
+    /// Number of input chunks a worker processes at most at once for a terminal,
+    /// before giving the other terminals their turn.
+    static constexpr inline size_t BatchSize = 16;
+
+    /// Time a worker spends at most at once on processing the input of a terminal, before giving
+    /// the other terminals their turn, so that one flooding its PTY does not hold up the others.
+    static constexpr inline std::chrono::microseconds TimeQuantum { 2000 };
+
+    /// Time since the most recent key input during which a terminal is considered interactive.
+    /// Interactive terminals whose PTY became readable are processed ahead of all other ones.
+    static constexpr inline std::chrono::milliseconds InteractiveInterval { 500 };
+
+    /// @returns the default number of worker threads, depending on the number of CPU cores.
+    [[nodiscard]] static size_t defaultWorkerCount() noexcept;
+
+    explicit InputReactor(size_t workerCount = defaultWorkerCount());
+
+    InputReactor(InputReactor const&) = delete;
+    InputReactor(InputReactor&&) = delete;
+    InputReactor& operator=(InputReactor const&) = delete;
+    InputReactor& operator=(InputReactor&&) = delete;
+    ~InputReactor();
+
+    /// Starts processing the input of @p terminal, whose PTY must have been started already.
+    ///
+    /// @returns false if the terminal's input can not be processed by this reactor, e.g. because its
+    ///          PTY does not provide a readiness descriptor. It must then be processed otherwise.
+    [[nodiscard]] bool add(Terminal& terminal, OnClosed onClosed);
+
+    /// Stops processing the input of @p terminal, waiting for a worker that is currently processing it.
+    /// It must be invoked before the terminal is destroyed, but not from within its OnClosed handler.
+    ///
+    /// @returns false if the terminal has not been added.
+    bool remove(Terminal& terminal);
+
+    /// @returns the number of terminals whose input is being processed.
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] size_t workerCount() const noexcept { return _workers.size(); }
+
+  private:
+    enum class State : uint8_t
+    {
+        Waiting,    // for the PTY to become readable
+        Queued,     // to be processed by a worker
+        Processing, // by a worker
+        Closed,     // as the PTY has been closed
+    };
+
+    struct Entry
+    {
+        uint64_t id; // identifies the entry in epoll events, which may outlive the entry itself
+        Terminal* terminal;
+        OnClosed onClosed;
+        int fd;
+        State state = State::Waiting;
+        bool removed = false;
+    };
+
+    struct Worker
+    {
+        std::deque<Entry*> queue; // guarded by InputReactor::_mutex
+        std::thread thread;
+    };
+
+    void runReactor();
+    void runWorker(size_t index);
+    [[nodiscard]] bool process(Entry& entry);
+
+    // The following require the mutex to be locked.
+    [[nodiscard]] Entry* takeQueued(size_t index);
+    void rearm(Entry& entry);
+
+    crispy::file_descriptor _epollFd;
+    crispy::file_descriptor _wakeupFd;
+
+    // Guards all members below.
+    mutable std::mutex _mutex;
+    std::condition_variable _queued; // notified whenever an entry has been queued, or when stopping
+    std::condition_variable _idle;   // notified whenever an entry stopped being processed
+    std::unordered_map<uint64_t, std::unique_ptr<Entry>> _entries;
+    uint64_t _nextId = 1; // 0 identifies the wakeup descriptor
+    std::vector<Worker> _workers;
+    size_t _nextWorker = 0;
+    bool _stopping = false;
+
+    std::thread _reactor;
+};
+
+} // namespace vtbackend
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/InputReactor.h>
+#include <vtbackend/MockTerm.h>
+#include <vtbackend/test_helpers.h>
+
+#include <vtpty/MockPty.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace vtbackend;
+
+#if defined(__linux__)
+
+namespace
+{
+
+/// Mock PTY whose output is fed through a pipe, so that it provides a readiness descriptor.
+class PipePty: public vtpty::MockPty
+{
+  public:
+    explicit PipePty(PageSize pageSize): MockPty { pageSize }
+    {
+        REQUIRE(pipe2(_pipe.data(), O_NONBLOCK | O_CLOEXEC) == 0);
+    }
+
+    ~PipePty() override
+    {
+        for (auto const fd: _pipe)
+            if (fd != -1)
+                ::close(fd);
+    }
+
+    [[nodiscard]] std::optional<int> readinessDescriptor() const noexcept override { return _pipe[0]; }
+
+    [[nodiscard]] std::optional<ReadResult> read(crispy::buffer_object<char>& storage,
+                                                 std::optional<std::chrono::milliseconds> /*timeout*/,
+                                                 size_t size) override
+    {
+        auto buffer = std::array<char, 4096> {};
+        auto const n =
+            ::read(_pipe[0], buffer.data(), std::min({ size, buffer.size(), storage.bytesAvailable() }));
+        if (n < 0)
+            return std::nullopt;
+        auto const pooled = storage.writeAtEnd(std::string_view(buffer.data(), static_cast<size_t>(n)));
+        return ReadResult { .data = std::string_view(pooled.data(), pooled.size()),
+                            .fromStdoutFastPipe = false };
+    }
+
+    void feed(std::string_view data)
+    {
+        REQUIRE(::write(_pipe[1], data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    }
+
+    /// Writes as much of @p data as fits into the pipe, without waiting for it to be read.
+    void tryFeed(std::string_view data)
+    {
+        [[maybe_unused]] auto const _ = ::write(_pipe[1], data.data(), data.size());
+    }
+
+    void closeWriter()
+    {
+        ::close(_pipe[1]);
+        _pipe[1] = -1;
+    }
+
+  private:
+    std::array<int, 2> _pipe { -1, -1 };
+};
+
+template <typename Predicate>
+bool waitUntil(Predicate predicate)
+{
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!predicate() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return predicate();
+}
+
+std::string screenText(MockTerm<PipePty>& mock)
+{
+    auto const _ = std::scoped_lock { mock.terminal };
+    return trimmedTextScreenshot(mock);
+}
+
+} // namespace
+
+TEST_CASE("InputReactor.process_until_closed")
+{
+    auto reactor = InputReactor { 2 };
+    auto mock = MockTerm<PipePty> { PageSize { LineCount(2), ColumnCount(10) } };
+    auto closed = std::atomic<bool> { false };
+    REQUIRE(reactor.add(mock.terminal, [&]() { closed = true; }));
+    CHECK(reactor.size() == 1);
+
+    mock.mockPty().feed("Hello");
+    CHECK(waitUntil([&]() { return screenText(mock) == "Hello"; }));
+
+    mock.mockPty().feed("\r\nWorld");
+    CHECK(waitUntil([&]() { return screenText(mock) == "Hello\nWorld"; }));
+
+    mock.mockPty().closeWriter();
+    CHECK(waitUntil([&]() { return closed.load(); }));
+
+    CHECK(reactor.remove(mock.terminal));
+    CHECK_FALSE(reactor.remove(mock.terminal));
+    CHECK(reactor.size() == 0);
+}
+
+TEST_CASE("InputReactor.many_terminals")
+{
+    auto reactor = InputReactor { 2 };
+    auto terminals = std::vector<std::unique_ptr<MockTerm<PipePty>>> {};
+    for (int i = 0; i < 8; ++i)
+    {
+        terminals.emplace_back(
+            std::make_unique<MockTerm<PipePty>>(PageSize { LineCount(2), ColumnCount(10) }));
+        REQUIRE(reactor.add(terminals.back()->terminal, {}));
+    }
+
+    for (size_t i = 0; i < terminals.size(); ++i)
+        terminals[i]->mockPty().feed(std::to_string(i));
+
+    for (size_t i = 0; i < terminals.size(); ++i)
+        CHECK(waitUntil([&]() { return screenText(*terminals[i]) == std::to_string(i); }));
+
+    // Removing terminals that are still open stops processing their input.
+    for (auto& terminal: terminals)
+        CHECK(reactor.remove(terminal->terminal));
+    CHECK(reactor.size() == 0);
+}
+
+TEST_CASE("InputReactor.flood_does_not_starve_others")
+{
+    // A single worker has to take turns between the terminals.
+    auto reactor = InputReactor { 1 };
+    auto flooded = MockTerm<PipePty> { PageSize { LineCount(2), ColumnCount(10) } };
+    auto interactive = MockTerm<PipePty> { PageSize { LineCount(2), ColumnCount(10) } };
+    REQUIRE(reactor.add(flooded.terminal, {}));
+    REQUIRE(reactor.add(interactive.terminal, {}));
+
+    auto flooding = std::atomic<bool> { true };
+    auto flood = std::thread { [&]() {
+        auto const line = std::string(4096, 'y') + "\r\n";
+        while (flooding)
+            flooded.mockPty().tryFeed(line);
+    } };
+
+    interactive.mockPty().feed("Hello");
+    CHECK(waitUntil([&]() { return screenText(interactive) == "Hello"; }));
+
+    flooding = false;
+    flood.join();
+    CHECK(reactor.remove(flooded.terminal));
+    CHECK(reactor.remove(interactive.terminal));
+}
+
+TEST_CASE("InputReactor.reject_without_readiness_descriptor")
+{
+    auto reactor = InputReactor { 1 };
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(10) } };
+    CHECK_FALSE(reactor.add(mock.terminal, {}));
+    CHECK_FALSE(reactor.remove(mock.terminal));
+}
+
+#endif
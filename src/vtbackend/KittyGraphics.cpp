@@ -0,0 +1,375 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/KittyGraphics.h>
+
+#include <crispy/assert.h>
+#include <crispy/file_descriptor.h>
+#include <crispy/utils.h>
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <system_error>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+
+    #include <fcntl.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace vtbackend
+{
+
+namespace
+{
+    using LoadResult = crispy::result<Image::Data, std::string>;
+
+    [[nodiscard]] LoadResult fail(std::string message)
+    {
+        return crispy::failure { std::move(message) };
+    }
+
+    [[nodiscard]] std::optional<uint32_t> parseNumber(std::string_view text) noexcept
+    {
+        auto value = uint32_t {};
+        auto const [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc {} || end != text.data() + text.size())
+            return std::nullopt;
+        return value;
+    }
+
+    /// @returns the range [offset, offset + size) of @p totalSize bytes, size 0 standing for all from offset.
+    [[nodiscard]] std::optional<std::pair<size_t, size_t>> dataRange(KittyGraphicsCommand const& command,
+                                                                     size_t totalSize) noexcept
+    {
+        if (command.dataOffset > totalSize)
+            return std::nullopt;
+        auto const size = command.dataSize ? command.dataSize : totalSize - command.dataOffset;
+        if (size > totalSize - command.dataOffset)
+            return std::nullopt;
+        return std::pair { command.dataOffset, size };
+    }
+
+    /// Tells whether @p name marks a file or shared memory object as meant for the graphics protocol.
+    [[nodiscard]] bool isProtocolName(std::string_view name) noexcept
+    {
+        return name.find("tty-graphics-protocol") != std::string_view::npos;
+    }
+
+    /// Tells whether the client may have the file at @p path deleted, which kitty limits to files in
+    /// a temporary directory whose name marks them as meant for this.
+    [[nodiscard]] bool isDeletableTemporaryFile(fs::path const& path)
+    {
+        if (!isProtocolName(path.filename().string()))
+            return false;
+
+        auto ec = std::error_code {};
+        auto const directory = fs::weakly_canonical(path, ec).parent_path();
+        if (ec)
+            return false;
+        auto const candidates = { fs::temp_directory_path(ec), fs::path("/tmp"), fs::path("/dev/shm") };
+        for (auto const& temporaryDirectory: candidates)
+            if (!temporaryDirectory.empty() && directory == fs::weakly_canonical(temporaryDirectory, ec))
+                return true;
+        return false;
+    }
+
+    /// @returns the number of bytes of image data @p command is to transmit, in its format.
+    [[nodiscard]] size_t expectedSizeOf(KittyGraphicsCommand const& command) noexcept
+    {
+        return command.pixelSize.area() * (command.format / 8);
+    }
+
+    /// @returns the error to fail with if the @p size bytes of @p command do not hold the image exactly.
+    [[nodiscard]] std::optional<std::string> checkDataSize(KittyGraphicsCommand const& command, size_t size)
+    {
+        if (size == expectedSizeOf(command))
+            return std::nullopt;
+        return "ENODATA:image data does not match the image size";
+    }
+
+    /// Error for any file or shared memory object that cannot be read, whatever the reason, so that
+    /// clients cannot tell from it whether or how large it is.
+    [[nodiscard]] LoadResult failReading()
+    {
+        return fail("EBADF:failed to read the image data");
+    }
+
+    [[nodiscard]] LoadResult loadFile(KittyGraphicsCommand const& command, fs::path const& path)
+    {
+        // Checked ahead of looking the file up, as it only depends on the name.
+        if (command.medium == KittyGraphicsCommand::Medium::TemporaryFile && !isDeletableTemporaryFile(path))
+            return fail("EPERM:no temporary file of the graphics protocol");
+
+        auto ec = std::error_code {};
+        if (!fs::is_regular_file(path, ec))
+            return failReading();
+        auto const range = dataRange(command, static_cast<size_t>(fs::file_size(path, ec)));
+        // Checked before reading anything, as the file may be of any size.
+        if (ec || !range || checkDataSize(command, range->second))
+            return failReading();
+
+        auto data = Image::Data(range->second);
+        auto file = std::ifstream(path, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(range->first));
+        file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file)
+            return failReading();
+        file.close();
+
+        if (command.medium == KittyGraphicsCommand::Medium::TemporaryFile)
+            fs::remove(path, ec);
+        return data;
+    }
+
+    [[nodiscard]] LoadResult loadSharedMemory(KittyGraphicsCommand const& command, std::string const& name)
+    {
+#if !defined(_WIN32)
+        // Objects of any other name may belong to unrelated processes, and are neither read nor unlinked.
+        if (!isProtocolName(name))
+            return fail("EPERM:no shared memory of the graphics protocol");
+
+        auto const fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return failReading();
+        auto const file = crispy::file_descriptor::from_native(fd);
+
+        struct stat status {};
+        if (fstat(file, &status) != 0)
+            return failReading();
+        auto const range = dataRange(command, static_cast<size_t>(status.st_size));
+        if (!range || range->second == 0 || checkDataSize(command, range->second))
+            return failReading();
+
+        auto const mappedSize = range->first + range->second;
+        auto* const mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, file, 0);
+        if (mapping == MAP_FAILED)
+            return failReading();
+        auto const* const bytes = static_cast<uint8_t const*>(mapping) + range->first;
+        auto data = Image::Data(bytes, bytes + range->second);
+        munmap(mapping, mappedSize);
+
+        // The client hands the shared memory over once it has been read.
+        shm_unlink(name.c_str());
+        return data;
+#else
+        (void) command;
+        (void) name;
+        return fail("EINVAL:shared memory is not supported on this platform");
+#endif
+    }
+
+    /// Converts RGB image data to RGBA in place, being the only format images are rendered from.
+    void convertToRGBA(Image::Data& data)
+    {
+        auto const pixelCount = data.size() / 3;
+        data.resize(pixelCount * 4);
+        for (auto i = pixelCount; i-- > 0;)
+        {
+            data[(i * 4) + 3] = 0xFF;
+            data[(i * 4) + 2] = data[(i * 3) + 2];
+            data[(i * 4) + 1] = data[(i * 3) + 1];
+            data[(i * 4) + 0] = data[(i * 3) + 0];
+        }
+    }
+} // namespace
+
+std::optional<KittyGraphicsCommand> KittyGraphicsCommand::parse(std::string_view text)
+{
+    auto command = KittyGraphicsCommand {};
+    auto const separator = text.find(';');
+    if (separator != std::string_view::npos)
+        command.payload = text.substr(separator + 1);
+
+    auto const valid = crispy::split(text.substr(0, separator), ',', [&](std::string_view keyValue) {
+        if (keyValue.size() < 3 || keyValue[1] != '=')
+            return false;
+        auto const value = keyValue.substr(2);
+        auto const number = parseNumber(value);
+        switch (keyValue[0])
+        {
+            case 'a':
+                if (value.size() != 1 || std::string_view("tTpdq").find(value[0]) == std::string_view::npos)
+                    return false;
+                command.action = static_cast<Action>(value[0]);
+                return true;
+            case 't':
+                if (value.size() != 1 || std::string_view("dfts").find(value[0]) == std::string_view::npos)
+                    return false;
+                command.medium = static_cast<Medium>(value[0]);
+                return true;
+            case 'o':
+                command.compression = value[0];
+                return true;
+            case 'd':
+                command.deleteTarget = value[0];
+                return true;
+            case 'f': command.format = number.value_or(0); break;
+            case 'i': command.imageId = number.value_or(0); break;
+            case 'p': command.placementId = number.value_or(0); break;
+            case 's': command.pixelSize.width = Width(number.value_or(0)); break;
+            case 'v': command.pixelSize.height = Height(number.value_or(0)); break;
+            case 'S': command.dataSize = number.value_or(0); break;
+            case 'O': command.dataOffset = number.value_or(0); break;
+            case 'c': command.cellSpan.columns = ColumnCount::cast_from(number.value_or(0)); break;
+            case 'r': command.cellSpan.lines = LineCount::cast_from(number.value_or(0)); break;
+            case 'm': command.more = number.value_or(0) == 1; break;
+            case 'q': command.quiet = static_cast<uint8_t>(std::min(number.value_or(0), 2u)); break;
+            case 'C': command.keepCursor = number.value_or(0) == 1; break;
+            default: return true; // keys of features not supported, such as animation frames
+        }
+        return number.has_value();
+    });
+
+    if (!valid)
+        return std::nullopt;
+    return command;
+}
+
+std::optional<std::string> checkKittyGraphicsImage(KittyGraphicsCommand const& command,
+                                                   bool localMediaAllowed)
+{
+    if (command.medium != KittyGraphicsCommand::Medium::Direct && !localMediaAllowed)
+        return "EPERM:transmission media other than direct are disabled";
+    if (command.format != 24 && command.format != 32)
+        return std::format("EINVAL:unsupported format {}", command.format);
+    if (command.compression)
+        return std::format("EINVAL:unsupported compression {}", command.compression);
+    if (command.pixelSize.area() == 0)
+        return "EINVAL:image width and height are required";
+    if (command.pixelSize.area() * 4 > KittyGraphics::StorageQuota)
+        return "EFBIG:image exceeds the storage quota";
+    return std::nullopt;
+}
+
+crispy::result<Image::Data, std::string> loadKittyGraphicsImage(KittyGraphicsCommand const& command,
+                                                                 std::string const& payload,
+                                                                 bool localMediaAllowed)
+{
+    if (auto error = checkKittyGraphicsImage(command, localMediaAllowed))
+        return fail(std::move(*error));
+
+    auto result = [&]() -> LoadResult {
+        switch (command.medium)
+        {
+            case KittyGraphicsCommand::Medium::Direct: return Image::Data(payload.begin(), payload.end());
+            case KittyGraphicsCommand::Medium::File:
+            case KittyGraphicsCommand::Medium::TemporaryFile: return loadFile(command, fs::path(payload));
+            case KittyGraphicsCommand::Medium::SharedMemory: return loadSharedMemory(command, payload);
+        }
+        crispy::unreachable();
+    }();
+    if (!result)
+        return result;
+
+    auto& data = result.value();
+    if (auto error = checkDataSize(command, data.size()))
+        return fail(std::move(*error));
+    if (command.format == 24)
+        convertToRGBA(data);
+    return result;
+}
+
+std::optional<KittyGraphics::Transmission> KittyGraphics::collect(KittyGraphicsCommand const& command)
+{
+    if (!_pending)
+    {
+        // Direct image data cannot be any larger than the image, whereas other media only transmit a name.
+        auto const isDirect = command.medium == KittyGraphicsCommand::Medium::Direct;
+        auto const limit = isDirect && command.pixelSize.area() != 0
+                               ? std::min(expectedSizeOf(command), StorageQuota)
+                               : StorageQuota;
+        _pending.emplace(
+            PendingTransmission { .command = command, .data = {}, .decoder = {}, .limit = limit });
+        _pending->command.payload = {};
+    }
+
+    if (!_pending->dropped)
+    {
+        auto& data = _pending->data;
+        auto const offset = data.size();
+        data.resize(offset + ((_pending->decoder.modulo + command.payload.size() + 3) / 4 * 3));
+        auto count = crispy::base64::decode(command.payload, _pending->decoder, data.data() + offset);
+        if (!command.more)
+            count += crispy::base64::finish(_pending->decoder, data.data() + offset + count);
+        data.resize(offset + count);
+
+        if (data.size() > _pending->limit)
+        {
+            _pending->dropped = true;
+            std::string().swap(data);
+        }
+    }
+
+    if (command.more)
+        return std::nullopt;
+
+    auto result =
+        Transmission { .command = _pending->command, .payload = std::move(_pending->data), .error = {} };
+    if (_pending->dropped)
+        result.error = std::format("EFBIG:image data exceeds {} bytes", _pending->limit);
+    _pending.reset();
+    return result;
+}
+
+std::shared_ptr<Image const> KittyGraphics::findImage(uint32_t imageId) const
+{
+    if (auto const i = _images.find(imageId); i != _images.end())
+        return i->second.image;
+    return nullptr;
+}
+
+void KittyGraphics::storeImage(uint32_t imageId, std::shared_ptr<Image const> image)
+{
+    _images[imageId] = StoredImage { .image = std::move(image), .sequence = _nextSequence++ };
+
+    auto const storedSize = [this]() {
+        auto total = size_t { 0 };
+        for (auto const& [_, stored]: _images)
+            total += stored.image->size().area() * 4;
+        return total;
+    };
+    while (_images.size() > 1 && storedSize() > StorageQuota)
+        _images.erase(std::ranges::min_element(_images, {}, [](auto const& entry) {
+            return entry.second.sequence;
+        }));
+}
+
+void KittyGraphics::eraseImage(uint32_t imageId)
+{
+    _images.erase(imageId);
+}
+
+KittyGraphics::Placement const* KittyGraphics::findPlacement(uint32_t imageId,
+                                                             uint32_t placementId) const noexcept
+{
+    if (placementId == 0)
+        return nullptr;
+    auto const i = std::ranges::find_if(_placements, [&](Placement const& placement) {
+        return placement.imageId == imageId && placement.placementId == placementId;
+    });
+    return i != _placements.end() ? &*i : nullptr;
+}
+
+void KittyGraphics::storePlacement(Placement placement)
+{
+    std::erase_if(_placements, [&](Placement const& existing) {
+        return existing.image.expired()
+               || (placement.placementId != 0 && existing.imageId == placement.imageId
+                   && existing.placementId == placement.placementId);
+    });
+    _placements.emplace_back(std::move(placement));
+}
+
+void KittyGraphics::clear()
+{
+    _pending.reset();
+    _images.clear();
+    _placements.clear();
+}
+
+} // namespace vtbackend
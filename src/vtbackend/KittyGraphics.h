@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Image.h>
+#include <vtbackend/primitives.h>
+
+#include <crispy/base64.h>
+#include <crispy/result.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vtbackend
+{
+
+/// A command of the kitty graphics protocol, as sent in an APC: ESC _ G <control data> ; <payload> ST
+///
+/// The control data is a comma separated list of key=value pairs, and the payload either the base64
+/// encoded image data itself, or the base64 encoded path or name of where to read it from.
+///
+/// See https://sw.kovidgoyal.net/kitty/graphics-protocol/
+struct KittyGraphicsCommand
+{
+    enum class Action : char
+    {
+        Transmit = 't',           ///< Transmits an image.
+        TransmitAndDisplay = 'T', ///< Transmits an image and displays it at the cursor.
+        Display = 'p',            ///< Displays a previously transmitted image at the cursor.
+        Delete = 'd',             ///< Deletes placements, and possibly their images.
+        Query = 'q',              ///< Checks whether an image could be transmitted, without storing it.
+    };
+
+    enum class Medium : char
+    {
+        Direct = 'd',        ///< The payload is the image data.
+        File = 'f',          ///< The payload is the path of a file holding the image data.
+        TemporaryFile = 't', ///< Like File, but the file is deleted once it has been read.
+        SharedMemory = 's',  ///< The payload is the name of a POSIX shared memory object, unlinked once read.
+    };
+
+    Action action = Action::Transmit;
+    Medium medium = Medium::Direct;
+    unsigned format = 32;     ///< 24 for RGB, 32 for RGBA, or 100 for PNG.
+    char compression = 0;     ///< 'z' for zlib compressed image data, or 0 for none.
+    uint32_t imageId = 0;     ///< Image ID chosen by the client, or 0 if none.
+    uint32_t placementId = 0; ///< Placement ID chosen by the client, or 0 if none.
+    ImageSize pixelSize {};   ///< Size of the image in pixels.
+    size_t dataSize = 0;      ///< Number of bytes to read from a file or shared memory, or 0 for all.
+    size_t dataOffset = 0;    ///< Offset into a file or shared memory to start reading at.
+    GridSize cellSpan {};     ///< Number of cells to display the image in, or 0 for as many as it takes.
+    bool more = false;        ///< Whether more chunks of direct image data are to follow.
+    uint8_t quiet = 0;        ///< 1 suppresses OK responses, 2 suppresses error responses as well.
+    bool keepCursor = false;  ///< Whether the cursor stays where it is when displaying an image.
+    char deleteTarget = 'a';  ///< What to delete, lowercase keeping the images, uppercase freeing them.
+    std::string_view payload; ///< The payload, still base64 encoded.
+
+    /// Parses the APC string following its leading 'G'.
+    ///
+    /// @returns the command, or nullopt if the control data is malformed.
+    [[nodiscard]] static std::optional<KittyGraphicsCommand> parse(std::string_view text);
+};
+
+/// Checks whether the image of @p command can be loaded at all, without reading its image data.
+///
+/// @param localMediaAllowed whether images may be read from files, temporary files and shared memory
+///                          named by the client, rather than only be transmitted directly.
+///
+/// @returns the error message to respond with, or nullopt if the image may be loaded.
+[[nodiscard]] std::optional<std::string> checkKittyGraphicsImage(KittyGraphicsCommand const& command,
+                                                                 bool localMediaAllowed);
+
+/// Reads the image data of @p command from its transmission medium.
+///
+/// @param payload the decoded payload of the command.
+/// @param localMediaAllowed see checkKittyGraphicsImage().
+///
+/// @returns the RGBA image data, or the error message to respond with, such as "EBADF:...".
+[[nodiscard]] crispy::result<Image::Data, std::string> loadKittyGraphicsImage(
+    KittyGraphicsCommand const& command, std::string const& payload, bool localMediaAllowed);
+
+/// Images and placements of the kitty graphics protocol, shared by all screens of a terminal.
+///
+/// Images are kept by the IDs their clients chose, until deleted or evicted by later ones
+/// exceeding the storage quota. Placements remember where an image has been displayed, such that
+/// displaying an image at an existing placement replaces it in place. Applications animate images that way.
+class KittyGraphics
+{
+  public:
+    /// Maximum number of bytes of pixel data of stored images, as with kitty itself.
+    static constexpr inline size_t StorageQuota = 320 * 1024 * 1024;
+
+    struct Placement
+    {
+        uint32_t imageId = 0;
+        uint32_t placementId = 0;
+        std::weak_ptr<RasterizedImage const> image; //!< Expires once none of its cells is left.
+        CellLocation topLeft {};
+        GridSize cellSpan {};
+    };
+
+    struct Transmission
+    {
+        KittyGraphicsCommand command;     //!< The control data of the first chunk.
+        std::string payload;              //!< The decoded payload of all chunks.
+        std::optional<std::string> error; //!< The error message to respond with instead, if any.
+    };
+
+    /// Collects the image data of @p command, decoding it from base64.
+    ///
+    /// Direct image data may be split into chunks across several commands, each but the last one
+    /// of which has more() set. The control data of the first one applies to all of them.
+    /// A payload growing beyond the size of the image it is to hold, or beyond the storage quota,
+    /// is dropped, and the remaining chunks are only waited for in order to fail the transmission.
+    ///
+    /// @returns the command along with its entire decoded payload, or nullopt if more is to follow.
+    [[nodiscard]] std::optional<Transmission> collect(KittyGraphicsCommand const& command);
+
+    [[nodiscard]] std::shared_ptr<Image const> findImage(uint32_t imageId) const;
+    void storeImage(uint32_t imageId, std::shared_ptr<Image const> image);
+    void eraseImage(uint32_t imageId);
+
+    /// @returns the placement of @p imageId by @p placementId, if any, but never anonymous ones.
+    [[nodiscard]] Placement const* findPlacement(uint32_t imageId, uint32_t placementId) const noexcept;
+    void storePlacement(Placement placement);
+
+    /// Removes the placements @p matches holds for.
+    ///
+    /// @returns the removed placements.
+    template <typename Predicate>
+    std::vector<Placement> takePlacements(Predicate&& matches)
+    {
+        auto taken = std::vector<Placement> {};
+        std::erase_if(_placements, [&](Placement const& placement) {
+            if (!matches(placement))
+                return false;
+            taken.emplace_back(placement);
+            return true;
+        });
+        return taken;
+    }
+
+    /// @returns the number of bytes taken by image data still being received.
+    [[nodiscard]] size_t pendingMemoryUsage() const noexcept
+    {
+        return _pending ? _pending->data.capacity() : 0;
+    }
+
+    void clear();
+
+  private:
+    struct PendingTransmission
+    {
+        KittyGraphicsCommand command;
+        std::string data;
+        crispy::base64::decoder_state decoder;
+        size_t limit = 0;     //!< Maximum number of bytes of the decoded payload.
+        bool dropped = false; //!< Whether the payload has exceeded the limit.
+    };
+
+    struct StoredImage
+    {
+        std::shared_ptr<Image const> image;
+        uint64_t sequence; //!< Order of storing, evicting the least recently stored images first.
+    };
+
+    std::optional<PendingTransmission> _pending;
+    std::map<uint32_t, StoredImage> _images;
+    uint64_t _nextSequence = 0;
+    std::vector<Placement> _placements;
+};
+
+} // namespace vtbackend
@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/KittyGraphics.h>
+
+#include <crispy/base64.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace vtbackend;
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+auto const RGBPixels = "\x10\x20\x30\x40\x50\x60"s;
+auto const RGBAPixels = Image::Data { 0x10, 0x20, 0x30, 0xFF, 0x40, 0x50, 0x60, 0xFF };
+
+KittyGraphicsCommand parse(std::string_view text)
+{
+    auto command = KittyGraphicsCommand::parse(text);
+    REQUIRE(command.has_value());
+    return *command;
+}
+
+} // namespace
+
+TEST_CASE("KittyGraphicsCommand.parse")
+{
+    auto const command = parse("a=T,t=s,f=24,i=7,p=3,s=2,v=1,S=6,O=4,c=5,r=2,m=1,q=2,C=1,z=9;AAAA");
+    CHECK(command.action == KittyGraphicsCommand::Action::TransmitAndDisplay);
+    CHECK(command.medium == KittyGraphicsCommand::Medium::SharedMemory);
+    CHECK(command.format == 24);
+    CHECK(command.imageId == 7);
+    CHECK(command.placementId == 3);
+    CHECK(command.pixelSize == ImageSize { Width(2), Height(1) });
+    CHECK(command.dataSize == 6);
+    CHECK(command.dataOffset == 4);
+    CHECK(command.cellSpan.lines == LineCount(2));
+    CHECK(command.cellSpan.columns == ColumnCount(5));
+    CHECK(command.more);
+    CHECK(command.quiet == 2);
+    CHECK(command.keepCursor);
+    CHECK(command.payload == "AAAA"sv);
+
+    CHECK(!KittyGraphicsCommand::parse("a=x"));
+    CHECK(!KittyGraphicsCommand::parse("i=abc"));
+    CHECK(!KittyGraphicsCommand::parse("i"));
+}
+
+TEST_CASE("KittyGraphics.collect_chunks")
+{
+    auto const encoded = crispy::base64::encode(RGBPixels);
+    auto graphics = KittyGraphics {};
+
+    auto first = parse("a=t,f=24,s=2,v=1,m=1");
+    first.payload = std::string_view(encoded).substr(0, 3); // not on a boundary of 4 characters
+    CHECK(!graphics.collect(first));
+
+    auto last = parse("m=0");
+    last.payload = std::string_view(encoded).substr(3);
+    auto const transmission = graphics.collect(last);
+    REQUIRE(transmission.has_value());
+    CHECK(transmission->command.format == 24); // the control data of the first chunk
+    CHECK(transmission->payload == RGBPixels);
+    CHECK(!transmission->error);
+    CHECK(graphics.pendingMemoryUsage() == 0);
+
+    auto const data = loadKittyGraphicsImage(transmission->command, transmission->payload, false);
+    REQUIRE(data.has_value());
+    CHECK(data.value() == RGBAPixels);
+}
+
+TEST_CASE("KittyGraphics.collect_drops_oversized_payload")
+{
+    auto const encoded = crispy::base64::encode(RGBPixels);
+    auto graphics = KittyGraphics {};
+
+    // The chunks carry twice as much as the 1x1 image they are for.
+    auto first = parse("a=t,f=24,s=1,v=1,m=1");
+    first.payload = encoded;
+    CHECK(!graphics.collect(first));
+
+    auto last = parse("m=0");
+    last.payload = encoded;
+    auto const transmission = graphics.collect(last);
+    REQUIRE(transmission.has_value());
+    REQUIRE(transmission->error.has_value());
+    CHECK(transmission->error->starts_with("EFBIG:"));
+    CHECK(transmission->payload.empty());
+}
+
+TEST_CASE("KittyGraphics.load_errors")
+{
+    auto const missingSize = loadKittyGraphicsImage(parse("f=32"), "", false);
+    REQUIRE(!missingSize);
+    CHECK(missingSize.error().starts_with("EINVAL:"));
+
+    auto const png = loadKittyGraphicsImage(parse("f=100,s=1,v=1"), "", false);
+    REQUIRE(!png);
+    CHECK(png.error().starts_with("EINVAL:"));
+
+    auto const truncated = loadKittyGraphicsImage(parse("f=24,s=2,v=1"), RGBPixels.substr(0, 5), false);
+    REQUIRE(!truncated);
+    CHECK(truncated.error().starts_with("ENODATA:"));
+}
+
+TEST_CASE("KittyGraphics.load_local_media_disabled")
+{
+    auto const path = fs::temp_directory_path() / "contour-tty-graphics-protocol-disabled-test.rgb";
+    std::ofstream(path, std::ios::binary) << RGBPixels;
+
+    auto const data = loadKittyGraphicsImage(parse("t=t,f=24,s=2,v=1"), path.string(), false);
+    REQUIRE(!data);
+    CHECK(data.error().starts_with("EPERM:"));
+    CHECK(fs::exists(path));
+    fs::remove(path);
+}
+
+TEST_CASE("KittyGraphics.load_temporary_file")
+{
+    auto const path = fs::temp_directory_path() / "contour-tty-graphics-protocol-test.rgb";
+    std::ofstream(path, std::ios::binary) << "skip" << RGBPixels;
+
+    auto const data = loadKittyGraphicsImage(parse("t=t,f=24,s=2,v=1,O=4"), path.string(), true);
+    REQUIRE(data.has_value());
+    CHECK(data.value() == RGBAPixels);
+    CHECK(!fs::exists(path));
+}
+
+TEST_CASE("KittyGraphics.load_file_checks_size_first")
+{
+    auto const path = fs::temp_directory_path() / "contour-kitty-graphics-size-test.rgb";
+    std::ofstream(path, std::ios::binary) << RGBPixels << RGBPixels;
+
+    auto const data = loadKittyGraphicsImage(parse("t=f,f=24,s=2,v=1"), path.string(), true);
+    REQUIRE(!data);
+    CHECK(data.error() == "EBADF:failed to read the image data"); // telling nothing about the file
+
+    auto const range = loadKittyGraphicsImage(parse("t=f,f=24,s=2,v=1,S=6"), path.string(), true);
+    REQUIRE(range.has_value());
+    CHECK(range.value() == RGBAPixels);
+    fs::remove(path);
+}
+
+TEST_CASE("KittyGraphics.load_file_refuses_deleting_others")
+{
+    auto const path = fs::temp_directory_path() / "contour-kitty-graphics-test.rgb";
+    std::ofstream(path, std::ios::binary) << RGBPixels;
+
+    auto const data = loadKittyGraphicsImage(parse("t=t,f=24,s=2,v=1"), path.string(), true);
+    REQUIRE(!data);
+    CHECK(data.error().starts_with("EPERM:"));
+    CHECK(fs::exists(path));
+    fs::remove(path);
+}
+
+#if !defined(_WIN32)
+TEST_CASE("KittyGraphics.load_shared_memory")
+{
+    auto const name = "/contour-tty-graphics-protocol-test"s;
+    auto const fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    REQUIRE(fd >= 0);
+    REQUIRE(ftruncate(fd, static_cast<off_t>(RGBPixels.size())) == 0);
+    REQUIRE(write(fd, RGBPixels.data(), RGBPixels.size()) == static_cast<ssize_t>(RGBPixels.size()));
+    close(fd);
+
+    auto const data = loadKittyGraphicsImage(parse("t=s,f=24,s=2,v=1"), name, true);
+    REQUIRE(data.has_value());
+    CHECK(data.value() == RGBAPixels);
+    CHECK(shm_open(name.c_str(), O_RDONLY, 0) < 0); // unlinked once read
+}
+
+TEST_CASE("KittyGraphics.load_shared_memory_leaves_others")
+{
+    auto const name = "/contour-kitty-graphics-test"s;
+    auto const fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    REQUIRE(fd >= 0);
+    REQUIRE(ftruncate(fd, static_cast<off_t>(RGBPixels.size())) == 0);
+    close(fd);
+
+    auto const data = loadKittyGraphicsImage(parse("t=s,f=24,s=2,v=1"), name, true);
+    REQUIRE(!data);
+    CHECK(data.error().starts_with("EPERM:"));
+    auto const other = shm_open(name.c_str(), O_RDONLY, 0);
+    CHECK(other >= 0);
+    close(other);
+    shm_unlink(name.c_str());
+}
+#endif
+
+TEST_CASE("KittyGraphics.placements")
+{
+    auto graphics = KittyGraphics {};
+    auto const image = std::make_shared<RasterizedImage const>(nullptr,
+                                                               ImageAlignment::TopStart,
+                                                               ImageResize::NoResize,
+                                                               RGBAColor {},
+                                                               GridSize {},
+                                                               ImageSize {});
+    auto const placement = [&](uint32_t imageId, uint32_t placementId) {
+        return KittyGraphics::Placement {
+            .imageId = imageId, .placementId = placementId, .image = image, .topLeft = {}, .cellSpan = {}
+        };
+    };
+    graphics.storePlacement(placement(1, 2));
+    graphics.storePlacement(placement(1, 2));
+    graphics.storePlacement(placement(3, 0));
+
+    CHECK(graphics.findPlacement(1, 2));
+    CHECK(!graphics.findPlacement(3, 0));
+
+    auto const taken = graphics.takePlacements([](auto const& placement) { return placement.imageId == 1; });
+    CHECK(taken.size() == 1);
+    CHECK(!graphics.findPlacement(1, 2));
+}
@@ -7,6 +7,8 @@
 #include <libunicode/utf8.h>
 #include <libunicode/width.h>
 
+#include <algorithm>
+
 using std::get;
 using std::holds_alternative;
 using std::min;
@@ -14,6 +16,27 @@ using std::min;
 namespace vtbackend
 {
 
+namespace
+{
+    // Mixes whole words rather than bytes, as lines are hashed for each rendered frame.
+    struct ContentHasher
+    {
+        uint64_t value = 0xcbf29ce484222325ULL;
+
+        void add(uint64_t word) noexcept
+        {
+            value = (value ^ word) * 0x9E3779B97F4A7C15ULL;
+            value ^= value >> 29;
+        }
+
+        void add(GraphicsAttributes const& attributes) noexcept
+        {
+            add((uint64_t { attributes.foregroundColor.content } << 32) | attributes.backgroundColor.content);
+            add((uint64_t { attributes.underlineColor.content } << 32) | attributes.flags.value());
+        }
+    };
+} // namespace
+
 template <CellConcept Cell>
 typename Line<Cell>::InflatedBuffer Line<Cell>::reflow(ColumnCount newColumnCount)
 {
@@ -127,6 +150,34 @@ std::string Line<Cell>::toUtf8() const
     return str;
 }
 
+template <CellConcept Cell>
+std::string Line<Cell>::toColumnText() const
+{
+    auto str = std::string(unbox<size_t>(size()), ' ');
+    if (isTrivialBuffer())
+    {
+        auto const text = trivialBuffer().text.view();
+        if (std::ranges::all_of(text, [](char ch) { return ch >= 0x20 && ch < 0x7F; }))
+        {
+            std::ranges::copy(text.substr(0, str.size()), str.begin());
+            return str;
+        }
+    }
+
+    auto const& cells = inflatedBuffer();
+    for (size_t i = 0; i < cells.size() && i < str.size(); ++i)
+    {
+        auto const& cell = cells[i];
+        if (cell.codepointCount() == 0)
+            continue;
+        auto const codepoint = cell.codepoint(0);
+        str[i] = cell.codepointCount() == 1 && codepoint >= 0x20 && codepoint < 0x7F
+                     ? static_cast<char>(codepoint)
+                     : '\0';
+    }
+    return str;
+}
+
 template <CellConcept Cell>
 std::string Line<Cell>::toUtf8Trimmed() const
 {
@@ -136,29 +187,53 @@ std::string Line<Cell>::toUtf8Trimmed() const
 template <CellConcept Cell>
 std::string Line<Cell>::toUtf8Trimmed(bool stripLeadingSpaces, bool stripTrailingSpaces) const
 {
+    auto const isSpace = [](char ch) {
+        return std::isspace(static_cast<unsigned char>(ch)) != 0;
+    };
+
+    // Trivial lines are trimmed on their own text, to only copy what is left of it.
+    if (isTrivialBuffer())
+    {
+        auto const& buffer = trivialBuffer();
+        auto text = buffer.text.view();
+        if (stripTrailingSpaces)
+            while (!text.empty() && isSpace(text.back()))
+                text.remove_suffix(1);
+        if (stripLeadingSpaces)
+            while (!text.empty() && isSpace(text.front()))
+                text.remove_prefix(1);
+
+        // The blank columns following the text are trimmed along with it if the text is all blank.
+        auto output = std::string(text);
+        if (!stripTrailingSpaces && buffer.usedColumns < buffer.displayWidth
+            && !(stripLeadingSpaces && text.empty()))
+            output.append(unbox<size_t>(buffer.displayWidth - buffer.usedColumns), ' ');
+        return output;
+    }
+
     std::string output = toUtf8();
 
     if (stripTrailingSpaces)
-        while (!output.empty() && isspace(output.back()))
+        while (!output.empty() && isSpace(output.back()))
             output.pop_back();
 
     if (stripLeadingSpaces)
     {
         size_t frontGap = 0;
-        while (frontGap < output.size() && std::isspace(output[frontGap]))
+        while (frontGap < output.size() && isSpace(output[frontGap]))
             frontGap++;
-        output = output.substr(frontGap);
+        output.erase(0, frontGap);
     }
 
     return output;
 }
 
 template <CellConcept Cell>
-InflatedLineBuffer<Cell> inflate(TrivialLineBuffer const& input)
+InflatedLineBuffer<Cell> inflate(TrivialLineBuffer const& input, InflatedLineBuffer<Cell> columns)
 {
     static constexpr char32_t ReplacementCharacter { 0xFFFD };
 
-    auto columns = InflatedLineBuffer<Cell> {};
+    columns.clear();
     columns.reserve(unbox<size_t>(input.displayWidth));
 
     auto lastChar = char32_t { 0 };
@@ -220,6 +295,414 @@ InflatedLineBuffer<Cell> inflate(TrivialLineBuffer const& input)
 
     return columns;
 }
+
+template <CellConcept Cell>
+InflatedLineBuffer<Cell> inflate(AttributedLineBuffer const& input, InflatedLineBuffer<Cell> columns)
+{
+    columns.clear();
+    columns.reserve(input.codepoints.size());
+
+    for (LineAttributeSpan const& span: input.spans)
+    {
+        for (auto i = 0; i < unbox(span.length); ++i)
+        {
+            auto const codepoint = input.codepoints[columns.size()];
+            columns.emplace_back(span.attributes, span.hyperlink);
+            if (codepoint != 0)
+                columns.back().write(span.attributes,
+                                     codepoint,
+                                     static_cast<uint8_t>(unicode::width(codepoint)),
+                                     span.hyperlink);
+        }
+    }
+
+    assert(columns.size() == input.codepoints.size());
+    return columns;
+}
+
+template <CellConcept Cell>
+std::optional<AttributedLineBuffer> toAttributedLineBuffer(InflatedLineBuffer<Cell> const& input, bool lossy)
+{
+    auto output = AttributedLineBuffer {};
+    output.codepoints.reserve(input.size());
+
+    for (Cell const& cell: input)
+    {
+        if (!lossy && (cell.codepointCount() > 1 || cell.imageFragment()))
+            return std::nullopt;
+
+        auto const codepoint = cell.codepointCount() ? cell.codepoint(0) : char32_t { 0 };
+        auto const expectedWidth = codepoint ? static_cast<uint8_t>(unicode::width(codepoint)) : uint8_t(1);
+        if (!lossy && static_cast<uint8_t>(cell.width()) != expectedWidth)
+            return std::nullopt;
+
+        auto const attributes = GraphicsAttributes { .foregroundColor = cell.foregroundColor(),
+                                                     .backgroundColor = cell.backgroundColor(),
+                                                     .underlineColor = cell.underlineColor(),
+                                                     .flags = cell.flags() };
+
+        if (!output.spans.empty() && output.spans.back().attributes == attributes
+            && output.spans.back().hyperlink == cell.hyperlink())
+            ++output.spans.back().length;
+        else
+            output.spans.emplace_back(LineAttributeSpan {
+                .length = ColumnCount(1), .attributes = attributes, .hyperlink = cell.hyperlink() });
+
+        output.codepoints.push_back(codepoint);
+    }
+
+    output.spans.shrink_to_fit();
+    return output;
+}
+
+namespace
+{
+    // Size of the buffer objects the text of lines that have been compacted back into trivial lines
+    // is appended to. Such a buffer object is freed once the last line referring to it is gone.
+    constexpr size_t TrivialTextBufferSize = 64 * 1024;
+
+    void packVarUInt(std::string& output, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            output.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<char>(value));
+    }
+
+    uint32_t unpackVarUInt(std::string_view input, size_t& offset) noexcept
+    {
+        auto value = uint32_t { 0 };
+        for (auto shift = 0; offset < input.size(); shift += 7)
+        {
+            auto const byte = static_cast<uint8_t>(input[offset++]);
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        return value;
+    }
+
+    Color unpackColor(std::string_view input, size_t& offset) noexcept
+    {
+        auto color = Color {};
+        color.content = unpackVarUInt(input, offset);
+        return color;
+    }
+} // namespace
+
+PackedLineBuffer pack(AttributedLineBuffer const& input)
+{
+    auto const& codepoints = input.codepoints;
+    auto usedColumns = codepoints.size();
+    while (usedColumns != 0 && codepoints[usedColumns - 1] == 0)
+        --usedColumns;
+
+    auto bytes = std::string {};
+    bytes.reserve(usedColumns + (input.spans.size() * 8) + 4);
+
+    packVarUInt(bytes, static_cast<uint32_t>(usedColumns));
+    packVarUInt(bytes, static_cast<uint32_t>(input.spans.size()));
+    for (LineAttributeSpan const& span: input.spans)
+    {
+        packVarUInt(bytes, unbox<uint32_t>(span.length));
+        packVarUInt(bytes, span.attributes.foregroundColor.content);
+        packVarUInt(bytes, span.attributes.backgroundColor.content);
+        packVarUInt(bytes, span.attributes.underlineColor.content);
+        packVarUInt(bytes, static_cast<uint32_t>(span.attributes.flags.value()));
+        packVarUInt(bytes, unbox<uint32_t>(span.hyperlink));
+    }
+    for (auto i = size_t { 0 }; i < usedColumns; ++i)
+        packVarUInt(bytes, static_cast<uint32_t>(codepoints[i]));
+
+    bytes.shrink_to_fit();
+    return PackedLineBuffer { .bytes = std::make_shared<std::string const>(std::move(bytes)),
+                              .columns = input.displayWidth() };
+}
+
+AttributedLineBuffer unpack(PackedLineBuffer const& input)
+{
+    auto const bytes = input.view();
+    auto offset = size_t { 0 };
+
+    auto output = AttributedLineBuffer {};
+    auto const usedColumns = unpackVarUInt(bytes, offset);
+
+    output.spans.resize(unpackVarUInt(bytes, offset));
+    for (LineAttributeSpan& span: output.spans)
+    {
+        span.length = ColumnCount::cast_from(unpackVarUInt(bytes, offset));
+        span.attributes.foregroundColor = unpackColor(bytes, offset);
+        span.attributes.backgroundColor = unpackColor(bytes, offset);
+        span.attributes.underlineColor = unpackColor(bytes, offset);
+        span.attributes.flags = CellFlags::from_value(unpackVarUInt(bytes, offset));
+        span.hyperlink = HyperlinkId::cast_from(unpackVarUInt(bytes, offset));
+    }
+
+    output.codepoints.reserve(unbox<size_t>(input.columns));
+    for (auto i = uint32_t { 0 }; i < usedColumns; ++i)
+        output.codepoints.push_back(static_cast<char32_t>(unpackVarUInt(bytes, offset)));
+    output.codepoints.resize(unbox<size_t>(input.columns), char32_t { 0 });
+
+    return output;
+}
+
+template <CellConcept Cell>
+bool Line<Cell>::compactIntoTrivialBuffer(crispy::buffer_object_ptr<char>& textBuffer,
+                                          HistoryTextCache* textCache)
+{
+    if (auto* trivial = std::get_if<TrivialBuffer>(&_storage))
+    {
+        if (textCache)
+            trivial->text = textCache->share(std::move(trivial->text));
+        return true;
+    }
+
+    if (!isInflatedBuffer())
+        return false;
+
+    auto const& cells = inflatedBuffer();
+    if (cells.empty())
+        return false;
+
+    auto const attributesOf = [](Cell const& cell) {
+        return GraphicsAttributes { .foregroundColor = cell.foregroundColor(),
+                                    .backgroundColor = cell.backgroundColor(),
+                                    .underlineColor = cell.underlineColor(),
+                                    .flags = cell.flags() };
+    };
+
+    auto usedColumns = cells.size();
+    while (usedColumns > 0 && cells[usedColumns - 1].empty())
+        --usedColumns;
+
+    // Trailing empty cells are restored from the fill attributes, without any hyperlink.
+    auto const fillAttributes =
+        usedColumns < cells.size() ? attributesOf(cells[usedColumns]) : attributesOf(cells.back());
+    for (auto i = usedColumns; i < cells.size(); ++i)
+        if (attributesOf(cells[i]) != fillAttributes || cells[i].hyperlink() != HyperlinkId {})
+            return false;
+
+    auto const textAttributes = usedColumns > 0 ? attributesOf(cells.front()) : fillAttributes;
+    auto const hyperlink = usedColumns > 0 ? cells.front().hyperlink() : HyperlinkId {};
+    auto const continuationAttributes = textAttributes.with(CellFlag::WideCharContinuation);
+
+    // Each used cell must hold a single codepoint that inflate() puts into a cell of its own,
+    // followed by as many continuation cells as the codepoint is wide. A wide character at the end
+    // of the text is rejected, as inflate() pads it without marking the padding as continuation.
+    auto text = std::string {};
+    auto lastChar = char32_t { 0 };
+    for (auto i = size_t { 0 }; i < usedColumns;)
+    {
+        Cell const& cell = cells[i];
+        if (cell.codepointCount() != 1 || cell.imageFragment() || cell.hyperlink() != hyperlink
+            || attributesOf(cell) != textAttributes)
+            return false;
+
+        auto const codepoint = cell.codepoint(0);
+        auto const width = static_cast<size_t>(unicode::width(codepoint));
+        if (width == 0 || static_cast<size_t>(cell.width()) != width || i + width > usedColumns
+            || !unicode::grapheme_segmenter::breakable(lastChar, codepoint))
+            return false;
+
+        for (auto k = i + 1; k < i + width; ++k)
+            if (!cells[k].empty() || cells[k].hyperlink() != hyperlink
+                || attributesOf(cells[k]) != continuationAttributes)
+                return false;
+
+        text += cell.toUtf8();
+        lastChar = codepoint;
+        i += width;
+    }
+
+    auto fragment = crispy::buffer_fragment<char> {};
+    if (auto const* shared = textCache ? textCache->find(text) : nullptr)
+        fragment = *shared;
+    else if (!text.empty())
+    {
+        if (!textBuffer || textBuffer->bytesAvailable() < text.size())
+            textBuffer = crispy::buffer_object<char>::create(std::max(TrivialTextBufferSize, text.size()));
+        auto const region = textBuffer->writeAtEnd(gsl::span<char const>(text.data(), text.size()));
+        textBuffer->advance(text.size());
+        fragment = crispy::buffer_fragment<char> { textBuffer, region };
+        if (textCache)
+            textCache->insert(fragment);
+    }
+
+    auto const displayWidth = ColumnCount::cast_from(cells.size());
+    setBuffer(TrivialBuffer { .displayWidth = displayWidth,
+                              .textAttributes = textAttributes,
+                              .fillAttributes = fillAttributes,
+                              .hyperlink = hyperlink,
+                              .usedColumns = ColumnCount::cast_from(usedColumns),
+                              .text = std::move(fragment) });
+    return true;
+}
+
+template <CellConcept Cell>
+bool Line<Cell>::compactIntoAttributedBuffer()
+{
+    if (isAttributedBuffer())
+        return true;
+
+    if (!isInflatedBuffer())
+        return false;
+
+    auto attributed = toAttributedLineBuffer<Cell>(inflatedBuffer());
+    if (!attributed)
+        return false;
+
+    setBuffer(std::move(*attributed));
+    return true;
+}
+
+template <CellConcept Cell>
+bool Line<Cell>::packIntoColdBuffer()
+{
+    if (isPackedBuffer())
+        return true;
+
+    if (!compactIntoAttributedBuffer())
+        return false;
+
+    _storage = pack(std::get<AttributedLineBuffer>(_storage));
+    return true;
+}
+
+template <CellConcept Cell>
+bool Line<Cell>::unpackColdBuffer()
+{
+    auto const* packed = std::get_if<PackedLineBuffer>(&_storage);
+    if (!packed)
+        return false;
+
+    _storage = unpack(*packed);
+    return true;
+}
+
+template <CellConcept Cell>
+PackedLineBuffer Line<Cell>::toPackedBuffer() const
+{
+    if (auto const* packed = std::get_if<PackedLineBuffer>(&_storage))
+        return *packed;
+
+    if (auto const* attributed = std::get_if<AttributedLineBuffer>(&_storage))
+        return pack(*attributed);
+
+    if (auto const* trivial = std::get_if<TrivialBuffer>(&_storage))
+        return pack(*toAttributedLineBuffer<Cell>(inflate<Cell>(*trivial), true));
+
+    return pack(*toAttributedLineBuffer<Cell>(std::get<InflatedBuffer>(_storage), true));
+}
+
+template <CellConcept Cell>
+uint64_t Line<Cell>::contentHash() const
+{
+    auto hasher = ContentHasher {};
+    hasher.add(_flags.value());
+
+    if (auto const* trivial = std::get_if<TrivialBuffer>(&_storage))
+    {
+        hasher.add((unbox<uint64_t>(trivial->displayWidth) << 32) | unbox<uint64_t>(trivial->usedColumns));
+        hasher.add(trivial->textAttributes);
+        hasher.add(trivial->fillAttributes);
+        hasher.add(unbox<uint64_t>(trivial->hyperlink));
+        for (char const ch: trivial->text.view())
+            hasher.add(static_cast<unsigned char>(ch));
+        return hasher.value;
+    }
+
+    if (auto const* cells = std::get_if<InflatedBuffer>(&_storage))
+    {
+        for (Cell const& cell: *cells)
+        {
+            hasher.add((static_cast<uint64_t>(cell.width()) << 32) | cell.codepointCount());
+            for (size_t i = 0; i < cell.codepointCount(); ++i)
+                hasher.add(cell.codepoint(i));
+            hasher.add(GraphicsAttributes { .foregroundColor = cell.foregroundColor(),
+                                            .backgroundColor = cell.backgroundColor(),
+                                            .underlineColor = cell.underlineColor(),
+                                            .flags = cell.flags() });
+            hasher.add(unbox<uint64_t>(cell.hyperlink()));
+            if (auto const& fragment = cell.imageFragment())
+                hasher.add(reinterpret_cast<uintptr_t>(fragment.get()));
+        }
+        return hasher.value;
+    }
+
+    // Attributed and packed lines hash alike, as they only differ in how they are encoded.
+    auto const hashAttributed = [&](AttributedLineBuffer const& buffer) {
+        for (char32_t const codepoint: buffer.codepoints)
+            hasher.add(codepoint);
+        for (LineAttributeSpan const& span: buffer.spans)
+        {
+            hasher.add((unbox<uint64_t>(span.length) << 32) | unbox<uint64_t>(span.hyperlink));
+            hasher.add(span.attributes);
+        }
+        return hasher.value;
+    };
+
+    if (auto const* packed = std::get_if<PackedLineBuffer>(&_storage))
+        return hashAttributed(unpack(*packed));
+
+    return hashAttributed(std::get<AttributedLineBuffer>(_storage));
+}
+
+template <CellConcept Cell>
+TrigramSignature Line<Cell>::searchSignature() const
+{
+    if (auto const* attributed = std::get_if<AttributedLineBuffer>(&_storage))
+        return TrigramSignature::of(attributed->codepoints);
+
+    return TrigramSignature::of(leadingCodepoints());
+}
+
+template <CellConcept Cell>
+std::u32string Line<Cell>::leadingCodepoints() const
+{
+    if (auto const* attributed = std::get_if<AttributedLineBuffer>(&_storage))
+        return attributed->codepoints;
+
+    if (auto const* packed = std::get_if<PackedLineBuffer>(&_storage))
+        return unpack(*packed).codepoints;
+
+    auto const codepointsOfCells = [](InflatedBuffer const& cells) {
+        auto codepoints = std::u32string {};
+        codepoints.reserve(cells.size());
+        for (Cell const& cell: cells)
+            codepoints.push_back(cell.codepointCount() != 0 ? cell.codepoint(0) : char32_t { 0 });
+        return codepoints;
+    };
+
+    if (auto const* trivial = std::get_if<TrivialBuffer>(&_storage))
+    {
+        // Plain ASCII text maps to one cell per character, anything else needs proper segmentation.
+        auto const text = trivial->text.view();
+        if (std::ranges::all_of(text, [](char ch) { return static_cast<unsigned char>(ch) < 0x80; }))
+            return std::u32string(text.begin(), text.end());
+        return codepointsOfCells(inflate<Cell>(*trivial));
+    }
+
+    return codepointsOfCells(std::get<InflatedBuffer>(_storage));
+}
+
+template <CellConcept Cell>
+void Line<Cell>::appendText(std::string& output, bool trimTrailingSpaces) const
+{
+    auto const start = output.size();
+
+    // The trailing blanks of trivial lines are not even appended if they are to be trimmed anyway.
+    if (auto const* trivial = std::get_if<TrivialBuffer>(&_storage); trivial && trimTrailingSpaces)
+        output += trivial->text.view();
+    else
+        visitText([&](std::string_view text) { output += text; });
+
+    if (trimTrailingSpaces)
+        while (output.size() > start && output.back() == ' ')
+            output.pop_back();
+}
+
 } // end namespace vtbackend
 
 #include <vtbackend/cell/CompactCell.h>
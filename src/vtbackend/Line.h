@@ -3,7 +3,9 @@
 
 #include <vtbackend/CellUtil.h>
 #include <vtbackend/GraphicsAttributes.h>
+#include <vtbackend/HistoryTextCache.h>
 #include <vtbackend/Hyperlink.h>
+#include <vtbackend/SearchIndex.h>
 #include <vtbackend/cell/CellConcept.h>
 #include <vtbackend/primitives.h>
 
@@ -13,11 +15,16 @@
 #include <crispy/flags.h>
 
 #include <libunicode/convert.h>
+#include <libunicode/width.h>
 
 #include <gsl/span>
 #include <gsl/span_ext>
 
+#include <algorithm>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -65,15 +72,153 @@ struct TrivialLineBuffer
     }
 };
 
+/// Run of consecutive columns sharing the same SGR attributes and hyperlink.
+struct LineAttributeSpan
+{
+    ColumnCount length;
+    GraphicsAttributes attributes;
+    HyperlinkId hyperlink {};
+};
+
+/**
+ * Line storage with one codepoint per column and run-length encoded SGR attributes.
+ *
+ * This sits in between TrivialLineBuffer and a fully inflated line: it can represent
+ * any number of differently attributed runs, but only cells that consist of at most
+ * one codepoint and carry no per-cell data, such as images.
+ *
+ * Used for lines that went into history, as most of them only consist of a few SGR runs.
+ */
+struct AttributedLineBuffer
+{
+    /// One codepoint per column, 0 for empty cells (including wide char continuation cells).
+    std::u32string codepoints;
+
+    /// Attribute runs, ordered from left to right and covering all columns.
+    std::vector<LineAttributeSpan> spans;
+
+    [[nodiscard]] ColumnCount displayWidth() const noexcept
+    {
+        return ColumnCount::cast_from(codepoints.size());
+    }
+};
+
+/**
+ * Serialized form of an AttributedLineBuffer, used for lines deep in history.
+ *
+ * Codepoints and attribute runs are stored as variable-length integers in a single byte string,
+ * and trailing empty columns are not stored at all. Most lines thus take about one byte per
+ * used column, plus a few bytes per attribute run.
+ */
+struct PackedLineBuffer
+{
+    /// The serialized line, never modified once packed, and thus shared between copies of the line.
+    std::shared_ptr<std::string const> bytes;
+    ColumnCount columns;
+
+    [[nodiscard]] ColumnCount displayWidth() const noexcept { return columns; }
+    [[nodiscard]] std::string_view view() const noexcept
+    {
+        return bytes ? std::string_view(*bytes) : std::string_view {};
+    }
+};
+
+/// Serializes the given line into its packed form.
+[[nodiscard]] PackedLineBuffer pack(AttributedLineBuffer const& input);
+
+/// Restores a line from its packed form.
+[[nodiscard]] AttributedLineBuffer unpack(PackedLineBuffer const& input);
+
 template <CellConcept Cell>
 using InflatedLineBuffer = std::vector<Cell>;
 
+/// Pool of inflated cell buffers, recycled between the lines of a Grid.
+///
+/// Lines that are being reset or compacted return their cell buffer to the pool,
+/// and lines that are being inflated draw from it, so that steady-state scrolling
+/// does not need to go through the allocator for each line.
+template <CellConcept Cell>
+class LineBufferPool
+{
+  public:
+    static constexpr size_t DefaultCapacity = 256;
+
+    explicit LineBufferPool(ColumnCount columns, size_t capacity = DefaultCapacity) noexcept:
+        _columns { columns }, _capacity { capacity }
+    {
+    }
+
+    [[nodiscard]] ColumnCount columns() const noexcept { return _columns; }
+    [[nodiscard]] size_t size() const noexcept { return _buffers.size(); }
+
+    /// Changes the column count of the buffers to pool, dropping all buffers currently held.
+    void setColumns(ColumnCount columns) noexcept
+    {
+        _columns = columns;
+        _buffers.clear();
+    }
+
+    /// Drops all buffers currently held.
+    void clear() noexcept { _buffers.clear(); }
+
+    /// @returns an empty buffer, with capacity for at least columns() cells if it was recycled.
+    [[nodiscard]] InflatedLineBuffer<Cell> acquire() noexcept
+    {
+        if (_buffers.empty())
+            return {};
+        auto buffer = std::move(_buffers.back());
+        _buffers.pop_back();
+        return buffer;
+    }
+
+    /// Takes back the given buffer, unless the pool is full or the buffer is too small to be reused.
+    void release(InflatedLineBuffer<Cell>&& buffer) noexcept
+    {
+        if (_buffers.size() >= _capacity || buffer.capacity() < unbox<size_t>(_columns))
+            return;
+        buffer.clear();
+        try
+        {
+            _buffers.emplace_back(std::move(buffer));
+        }
+        catch (std::bad_alloc const&)
+        {
+            ; // The buffer is simply freed then.
+        }
+    }
+
+  private:
+    ColumnCount _columns;
+    size_t _capacity;
+    std::vector<InflatedLineBuffer<Cell>> _buffers;
+};
+
 /// Unpacks a TrivialLineBuffer into an InflatedLineBuffer<Cell>.
+///
+/// @param columns buffer to reuse for the output, e.g. as drawn from a LineBufferPool.
 template <CellConcept Cell>
-InflatedLineBuffer<Cell> inflate(TrivialLineBuffer const& input);
+InflatedLineBuffer<Cell> inflate(TrivialLineBuffer const& input, InflatedLineBuffer<Cell> columns = {});
 
+/// Unpacks an AttributedLineBuffer into an InflatedLineBuffer<Cell>.
+///
+/// @param columns buffer to reuse for the output, e.g. as drawn from a LineBufferPool.
 template <CellConcept Cell>
-using LineStorage = std::variant<TrivialLineBuffer, InflatedLineBuffer<Cell>>;
+InflatedLineBuffer<Cell> inflate(AttributedLineBuffer const& input, InflatedLineBuffer<Cell> columns = {});
+
+/// Packs the given cells into an AttributedLineBuffer.
+///
+/// @param lossy if true, cells are approximated by their first codepoint and without any image,
+///              in case they can not be represented exactly.
+///
+/// @returns std::nullopt if any cell carries information that can not be represented,
+///          such as multiple codepoints or an image fragment, unless @p lossy is set.
+template <CellConcept Cell>
+std::optional<AttributedLineBuffer> toAttributedLineBuffer(InflatedLineBuffer<Cell> const& input,
+                                                           bool lossy = false);
+
+template <CellConcept Cell>
+using LineStorage =
+    std::variant<TrivialLineBuffer, InflatedLineBuffer<Cell>, AttributedLineBuffer, PackedLineBuffer>;
 
 /**
  * Line<Cell> API.
@@ -103,13 +248,15 @@ class Line
 
     Line(LineFlags flags, InflatedBuffer buffer): _storage { std::move(buffer) }, _flags { flags } {}
 
+    Line(LineFlags flags, PackedLineBuffer buffer): _storage { std::move(buffer) }, _flags { flags } {}
+
     void reset(LineFlags flags, GraphicsAttributes attributes) noexcept
     {
         _flags = flags;
         if (isTrivialBuffer())
             trivialBuffer().reset(attributes);
         else
-            setBuffer(TrivialBuffer { ColumnCount::cast_from(inflatedBuffer().size()), attributes });
+            setBuffer(TrivialBuffer { size(), attributes });
     }
 
     void reset(LineFlags flags, GraphicsAttributes attributes, ColumnCount count) noexcept
@@ -142,6 +289,12 @@ class Line
         if (isTrivialBuffer())
             return trivialBuffer().text.empty();
 
+        if (auto const* packed = std::get_if<PackedLineBuffer>(&_storage))
+            return std::ranges::all_of(unpack(*packed).codepoints, [](char32_t ch) { return ch == 0; });
+
+        if (isAttributedBuffer())
+            return std::ranges::all_of(attributedBuffer().codepoints, [](char32_t ch) { return ch == 0; });
+
         for (auto const& cell: inflatedBuffer())
             if (!cell.empty())
                 return false;
@@ -174,16 +327,119 @@ class Line
             (i++)->reset();
     }
 
+    /**
+     * Writes the given US-ASCII characters into the cells starting at @p start,
+     * all using the same graphics rendition and hyperlink.
+     *
+     * Other than fill(), the cells right to the written text are left untouched.
+     */
+    void write(ColumnOffset start,
+               GraphicsAttributes const& sgr,
+               HyperlinkId hyperlink,
+               std::string_view ascii) noexcept
+    {
+        auto constexpr ASCII_Width = 1; // NOLINT
+        auto const* s = ascii.data();
+        for (Cell& cell: useRange(start, ColumnCount::cast_from(ascii.size())))
+            cell.write(sgr, static_cast<char32_t>(*s++), ASCII_Width, hyperlink);
+    }
+
+    /// Writes codepoints that each take a single column, such as US-ASCII mapped by a charset.
+    void write(ColumnOffset start,
+               GraphicsAttributes const& sgr,
+               HyperlinkId hyperlink,
+               std::u32string_view narrow) noexcept
+    {
+        auto const* s = narrow.data();
+        for (Cell& cell: useRange(start, ColumnCount::cast_from(narrow.size())))
+            cell.write(sgr, *s++, 1, hyperlink);
+    }
+
+    /**
+     * Copies @p count cells of @p source starting at @p sourceStart into this line at @p start.
+     *
+     * The source may be this very line, in which case overlapping ranges are handled like memmove().
+     */
+    void copyRange(ColumnOffset start, Line const& source, ColumnOffset sourceStart, ColumnCount count)
+    {
+        auto const target = useRange(start, count);
+        auto const cells = source.cells().subspan(unbox<size_t>(sourceStart), unbox<size_t>(count));
+        if (&source == this && start > sourceStart)
+            std::copy_backward(cells.begin(), cells.end(), target.end());
+        else
+            std::copy(cells.begin(), cells.end(), target.begin());
+    }
+
+    /// Writes @p codepoint with the given graphics rendition into @p count cells starting at @p start.
+    void fillRange(ColumnOffset start,
+                   ColumnCount count,
+                   GraphicsAttributes const& attributes,
+                   char32_t codepoint,
+                   uint8_t width) noexcept
+    {
+        for (Cell& cell: useRange(start, count))
+            cell.write(attributes, codepoint, width);
+    }
+
+    /// Blanks out the text of @p count cells starting at @p start, skipping protected characters.
+    void eraseUnprotectedRange(ColumnOffset start, ColumnCount count) noexcept
+    {
+        for (Cell& cell: useRange(start, count))
+        {
+            if (!cell.isFlagEnabled(CellFlag::CharacterProtected))
+            {
+                cell.writeTextOnly(L' ', 1);
+                cell.setHyperlink(HyperlinkId(0));
+            }
+        }
+    }
+
     [[nodiscard]] ColumnCount size() const noexcept
     {
         if (isTrivialBuffer())
             return trivialBuffer().displayWidth;
+        else if (isAttributedBuffer())
+            return attributedBuffer().displayWidth();
+        else if (auto const* packed = std::get_if<PackedLineBuffer>(&_storage))
+            return packed->displayWidth();
         else
             return ColumnCount::cast_from(inflatedBuffer().size());
     }
 
     void resize(ColumnCount count);
 
+    /// @returns the approximate number of bytes of memory this line takes, excluding the text
+    ///          of a trivial line, which is held by the PTY buffers, and any per-cell extra data.
+    [[nodiscard]] size_t memoryUsage() const noexcept
+    {
+        auto result = sizeof(Line);
+        if (isAttributedBuffer())
+        {
+            auto const& buffer = attributedBuffer();
+            result += buffer.codepoints.capacity() * sizeof(char32_t)
+                      + buffer.spans.capacity() * sizeof(LineAttributeSpan);
+        }
+        else if (auto const* packed = std::get_if<PackedLineBuffer>(&_storage))
+            result += packed->bytes ? packed->bytes->capacity() : 0;
+        else if (isInflatedBuffer())
+            result += inflatedBuffer().capacity() * sizeof(Cell);
+        return result;
+    }
+
+    /// @returns the approximate number of bytes of memory taken by the extra data of the cells
+    ///          of an inflated line, e.g. combining characters or image fragments.
+    [[nodiscard]] size_t cellExtrasMemoryUsage() const noexcept
+    {
+        auto result = size_t { 0 };
+        if constexpr (requires(Cell const& cell) { cell.extraMemoryUsage(); })
+        {
+            if (isInflatedBuffer())
+                for (auto const& cell: inflatedBuffer())
+                    result += cell.extraMemoryUsage();
+        }
+        return result;
+    }
+
     [[nodiscard]] gsl::span<Cell const> trim_blank_right() const noexcept;
 
     [[nodiscard]] gsl::span<Cell const> cells() const noexcept { return inflatedBuffer(); }
@@ -277,6 +533,10 @@ class Line
     [[nodiscard]] std::string toUtf8Trimmed() const;
     [[nodiscard]] std::string toUtf8Trimmed(bool stripLeadingSpaces, bool stripTrailingSpaces) const;
 
+    /// @returns the line's text with one character per column, where empty cells are represented
+    /// by a space and cells not holding a single printable ASCII character by a NUL character.
+    [[nodiscard]] std::string toColumnText() const;
+
     // Returns a reference to this mutable grid-line buffer.
     //
     // If this line has been stored in an optimized state, then
@@ -290,13 +550,115 @@ class Line
         return std::get<TrivialBuffer>(_storage);
     }
 
+    // Returns the attributed buffer of this line, which must be stored as such.
+    // Lines stored packed have to be unpacked first, see unpackColdBuffer().
+    [[nodiscard]] AttributedLineBuffer const& attributedBuffer() const
+    {
+        return std::get<AttributedLineBuffer>(_storage);
+    }
+
     [[nodiscard]] bool isTrivialBuffer() const noexcept
     {
         return std::holds_alternative<TrivialBuffer>(_storage);
     }
-    [[nodiscard]] bool isInflatedBuffer() const noexcept { return !isTrivialBuffer(); }
+    [[nodiscard]] bool isInflatedBuffer() const noexcept
+    {
+        return std::holds_alternative<InflatedBuffer>(_storage);
+    }
+    [[nodiscard]] bool isAttributedBuffer() const noexcept
+    {
+        return std::holds_alternative<AttributedLineBuffer>(_storage);
+    }
+    [[nodiscard]] bool isPackedBuffer() const noexcept
+    {
+        return std::holds_alternative<PackedLineBuffer>(_storage);
+    }
 
-    void setBuffer(Storage buffer) noexcept { _storage = std::move(buffer); }
+    void setBuffer(Storage buffer) noexcept
+    {
+        recycleInflatedBuffer();
+        _storage = std::move(buffer);
+    }
+
+    /// Sets the pool to draw cell buffers from on inflation, and to return them to when no longer used.
+    void setBufferPool(LineBufferPool<Cell>* pool) noexcept { _bufferPool = pool; }
+
+    /// Generation of the grid clear this line has last been reset by. See Grid::clearLines().
+    [[nodiscard]] uint32_t generation() const noexcept { return _generation; }
+    void setGeneration(uint32_t generation) noexcept { _generation = generation; }
+
+    /// Converts an inflated line back into a TrivialLineBuffer, if all of its used cells share the same
+    /// SGR attributes and hyperlink, and its cells inflate back exactly as they are.
+    ///
+    /// The line's text is appended to @p textBuffer, which is replaced by a newly created
+    /// buffer object if it has not enough space left.
+    ///
+    /// With a @p textCache, the text of a trivial line is shared with a recently compacted line
+    /// of the same text, if any, instead of being copied or keeping its own fragment alive.
+    ///
+    /// @returns true if this line is now stored as TrivialLineBuffer.
+    bool compactIntoTrivialBuffer(crispy::buffer_object_ptr<char>& textBuffer,
+                                  HistoryTextCache* textCache = nullptr);
+
+    /// Converts an inflated line into an AttributedLineBuffer, if all of its cells can be represented
+    /// that way. Trivial lines are left as is, as they are already even more compact.
+    ///
+    /// @returns true if this line is now stored as AttributedLineBuffer.
+    bool compactIntoAttributedBuffer();
+
+    /// Serializes this line into a PackedLineBuffer, if it can be represented as AttributedLineBuffer.
+    /// The line is inflated again as soon as its cells are accessed for modification, while reading
+    /// its text or attributes leaves it packed.
+    ///
+    /// @returns true if this line is now stored as PackedLineBuffer.
+    bool packIntoColdBuffer();
+
+    /// Turns a line stored as PackedLineBuffer back into an AttributedLineBuffer, e.g. while it is viewed,
+    /// so that it is not unpacked over and over again for reading it.
+    ///
+    /// @returns true if this line has been stored packed.
+    bool unpackColdBuffer();
+
+    /// @returns a packed copy of this line, leaving this line's storage untouched.
+    ///
+    /// Cells that can not be represented in packed form, such as grapheme clusters or images,
+    /// are approximated by their first codepoint.
+    [[nodiscard]] PackedLineBuffer toPackedBuffer() const;
+
+    /// @returns the trigram signature of this line's text, leaving this line's storage untouched.
+    [[nodiscard]] TrigramSignature searchSignature() const;
+
+    /// @returns a hash over everything this line is rendered from, i.e. its flags, text and attributes,
+    ///          leaving this line's storage untouched.
+    ///
+    /// Lines that look the same may still hash differently if they are stored differently.
+    [[nodiscard]] uint64_t contentHash() const;
+
+    /// @returns the first codepoint of each column, or 0 for empty columns.
+    ///
+    /// This leaves this line's storage untouched, and can thus be called for distinct lines
+    /// from multiple threads at once.
+    [[nodiscard]] std::u32string leadingCodepoints() const;
+
+    /// Appends this line's text to @p output, with empty columns as spaces.
+    ///
+    /// @p trimTrailingSpaces  whether spaces at the end of the line are omitted.
+    ///
+    /// Like leadingCodepoints(), this leaves this line's storage untouched.
+    /// Cells stored inflated contribute all of their codepoints though.
+    void appendText(std::string& output, bool trimTrailingSpaces) const;
+
+    /// Invokes @p sink with this line's text, as appendText() appends it, in one or more pieces
+    /// of UTF-8 text passed as std::string_view, which are only valid during the call.
+    ///
+    /// Trivial lines pass a view of their own text, so that their text is never copied.
+    /// Like appendText(), this leaves this line's storage untouched.
+    template <typename Sink>
+    void visitText(Sink&& sink) const;
+
+    /// Invokes @p callback with each column's cell, without inflating this line.
+    template <typename F>
+    void forEachAttributedCell(F&& callback) const;
 
     // Tests if the given text can be matched in this line at the exact given start column, in sensetive
     // or insensitive mode.
@@ -443,18 +805,111 @@ class Line
     }
 
   private:
+    [[nodiscard]] InflatedBuffer acquireInflatedBuffer() noexcept
+    {
+        return _bufferPool ? _bufferPool->acquire() : InflatedBuffer {};
+    }
+
+    void recycleInflatedBuffer() noexcept
+    {
+        if (_bufferPool)
+            if (auto* buffer = std::get_if<InflatedBuffer>(&_storage))
+                _bufferPool->release(std::move(*buffer));
+    }
+
     Storage _storage;
     LineFlags _flags;
+    uint32_t _generation = 0;
+    LineBufferPool<Cell>* _bufferPool = nullptr;
 };
 
 template <CellConcept Cell>
 inline typename Line<Cell>::InflatedBuffer& Line<Cell>::inflatedBuffer()
 {
     if (auto trivialbuffer = std::get_if<TrivialBuffer>(&_storage))
-        _storage = inflate<Cell>(*trivialbuffer);
+        _storage = inflate<Cell>(*trivialbuffer, acquireInflatedBuffer());
+    else if (auto attributedBuffer = std::get_if<AttributedLineBuffer>(&_storage))
+        _storage = inflate<Cell>(*attributedBuffer, acquireInflatedBuffer());
+    else if (auto packedBuffer = std::get_if<PackedLineBuffer>(&_storage))
+        _storage = inflate<Cell>(unpack(*packedBuffer), acquireInflatedBuffer());
     return std::get<InflatedBuffer>(_storage);
 }
 
+template <CellConcept Cell>
+template <typename F>
+void Line<Cell>::forEachAttributedCell(F&& callback) const // NOLINT(cppcoreguidelines-missing-std-forward)
+{
+    // Packed lines are unpacked into a temporary buffer, leaving this line's storage untouched.
+    auto const* packed = std::get_if<PackedLineBuffer>(&_storage);
+    auto const unpacked = packed ? unpack(*packed) : AttributedLineBuffer {};
+    auto const& buffer = packed ? unpacked : attributedBuffer();
+    auto column = size_t { 0 };
+    for (LineAttributeSpan const& span: buffer.spans)
+    {
+        for (auto const end = column + unbox<size_t>(span.length); column != end; ++column)
+        {
+            auto cell = Cell { span.attributes, span.hyperlink };
+            if (auto const codepoint = buffer.codepoints[column]; codepoint != 0)
+                cell.write(span.attributes,
+                           codepoint,
+                           static_cast<uint8_t>(unicode::width(codepoint)),
+                           span.hyperlink);
+            callback(static_cast<Cell const&>(cell));
+        }
+    }
+}
+
+template <CellConcept Cell>
+template <typename Sink>
+void Line<Cell>::visitText(Sink&& sink) const // NOLINT(cppcoreguidelines-missing-std-forward)
+{
+    if (auto const* trivial = std::get_if<TrivialBuffer>(&_storage))
+    {
+        static constexpr auto Blanks = std::string_view("                                ");
+
+        sink(trivial->text.view());
+        auto blankCount = size_t { 0 };
+        if (trivial->usedColumns < trivial->displayWidth)
+            blankCount = unbox<size_t>(trivial->displayWidth - trivial->usedColumns);
+        for (; blankCount > Blanks.size(); blankCount -= Blanks.size())
+            sink(Blanks);
+        if (blankCount)
+            sink(Blanks.substr(0, blankCount));
+    }
+    else if (auto const* cells = std::get_if<InflatedBuffer>(&_storage))
+    {
+        for (Cell const& cell: *cells)
+        {
+            if (cell.isFlagEnabled(CellFlag::WideCharContinuation))
+                continue;
+            if (cell.codepointCount() == 0)
+                sink(std::string_view(" "));
+            else
+                sink(std::string_view(cell.toUtf8()));
+        }
+    }
+    else
+    {
+        // Wide characters are followed by empty columns, which are continuations rather than spaces.
+        auto const codepoints = leadingCodepoints();
+        auto continuations = size_t { 0 };
+        for (char32_t const codepoint: codepoints)
+        {
+            if (codepoint == 0 && continuations != 0)
+            {
+                --continuations;
+                continue;
+            }
+            auto const width = codepoint ? static_cast<size_t>(unicode::width(codepoint)) : size_t { 1 };
+            continuations = std::max(width, size_t { 1 }) - 1;
+            if (codepoint == 0)
+                sink(std::string_view(" "));
+            else
+                sink(std::string_view(unicode::convert_to<char>(codepoint)));
+        }
+    }
+}
+
 template <CellConcept Cell>
 inline typename Line<Cell>::InflatedBuffer const& Line<Cell>::inflatedBuffer() const
 {
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/Line.h>
+#include <vtbackend/cell/CompactCell.h>
+#include <vtbackend/cell/SimpleCell.h>
+
+#include <crispy/BufferObject.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace vtbackend;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+auto constexpr Columns = ColumnCount(200);
+auto constexpr FewerColumns = ColumnCount(80);
+auto constexpr MoreColumns = ColumnCount(300);
+
+std::string asciiText(ColumnCount columns)
+{
+    auto constexpr Sentence = "The quick brown fox jumps over the lazy dog. "sv;
+    auto text = std::string {};
+    while (text.size() < columns.as<size_t>())
+        text += Sentence;
+    text.resize(columns.as<size_t>());
+    return text;
+}
+
+GraphicsAttributes coloredAttributes()
+{
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+    sgr.backgroundColor = Color::Indexed(IndexedColor::Blue);
+    return sgr;
+}
+
+template <typename Cell>
+Line<Cell> inflatedLine(std::string_view text)
+{
+    auto line = Line<Cell>(LineFlag::Wrappable,
+                           InflatedLineBuffer<Cell>(text.size(), Cell { GraphicsAttributes {} }));
+    line.fill(ColumnOffset(0), coloredAttributes(), text);
+    return line;
+}
+
+TrivialLineBuffer trivialLine(crispy::buffer_object_ptr<char> const& buffer, std::string_view text)
+{
+    auto const columns = ColumnCount::cast_from(text.size());
+    return TrivialLineBuffer { .displayWidth = columns,
+                               .textAttributes = coloredAttributes(),
+                               .fillAttributes = GraphicsAttributes {},
+                               .hyperlink = HyperlinkId {},
+                               .usedColumns = columns,
+                               .text = buffer->ref(0, text.size()) };
+}
+
+} // namespace
+
+TEMPLATE_TEST_CASE("Line.fill", "[Line]", SimpleCell, CompactCell)
+{
+    auto const text = asciiText(Columns);
+    auto const sgr = coloredAttributes();
+    auto line = inflatedLine<TestType>(text);
+
+    BENCHMARK("codepoint")
+    {
+        line.fill(LineFlag::None, sgr, U'x', 1);
+        return line.size();
+    };
+
+    BENCHMARK("ascii")
+    {
+        line.fill(ColumnOffset(0), sgr, text);
+        return line.size();
+    };
+}
+
+TEMPLATE_TEST_CASE("Line.resize", "[Line]", SimpleCell, CompactCell)
+{
+    auto const line = inflatedLine<TestType>(asciiText(Columns));
+
+    BENCHMARK_ADVANCED("shrink")(Catch::Benchmark::Chronometer meter)
+    {
+        auto lines = std::vector<Line<TestType>>(static_cast<size_t>(meter.runs()), line);
+        meter.measure([&](int i) { lines[static_cast<size_t>(i)].resize(FewerColumns); });
+    };
+
+    BENCHMARK_ADVANCED("grow")(Catch::Benchmark::Chronometer meter)
+    {
+        auto lines = std::vector<Line<TestType>>(static_cast<size_t>(meter.runs()), line);
+        meter.measure([&](int i) { lines[static_cast<size_t>(i)].resize(MoreColumns); });
+    };
+}
+
+TEMPLATE_TEST_CASE("Line.reflow", "[Line]", SimpleCell, CompactCell)
+{
+    auto const line = inflatedLine<TestType>(asciiText(Columns));
+
+    BENCHMARK_ADVANCED("shrink")(Catch::Benchmark::Chronometer meter)
+    {
+        auto lines = std::vector<Line<TestType>>(static_cast<size_t>(meter.runs()), line);
+        meter.measure([&](int i) { return lines[static_cast<size_t>(i)].reflow(FewerColumns).size(); });
+    };
+
+    BENCHMARK_ADVANCED("grow")(Catch::Benchmark::Chronometer meter)
+    {
+        auto lines = std::vector<Line<TestType>>(static_cast<size_t>(meter.runs()), line);
+        meter.measure([&](int i) { return lines[static_cast<size_t>(i)].reflow(MoreColumns).size(); });
+    };
+}
+
+TEMPLATE_TEST_CASE("TrivialLineBuffer", "[Line]", SimpleCell, CompactCell)
+{
+    auto const text = asciiText(Columns);
+    auto pool = crispy::buffer_object_pool<char>(4096);
+    auto const buffer = pool.allocateBufferObject();
+    buffer->writeAtEnd(text);
+    auto const trivial = trivialLine(buffer, text);
+
+    BENCHMARK("inflate")
+    {
+        return inflate<TestType>(trivial);
+    };
+
+    BENCHMARK_ADVANCED("deflate")(Catch::Benchmark::Chronometer meter)
+    {
+        auto lines =
+            std::vector<Line<TestType>>(static_cast<size_t>(meter.runs()), inflatedLine<TestType>(text));
+        auto textBuffer = crispy::buffer_object_ptr<char> {};
+        meter.measure(
+            [&](int i) { return lines[static_cast<size_t>(i)].compactIntoTrivialBuffer(textBuffer); });
+    };
+}
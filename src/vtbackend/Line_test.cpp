@@ -58,6 +58,44 @@ TEST_CASE("Line.resize", "[Line]")
     CHECK(lineTrivial.isTrivialBuffer());
 }
 
+TEST_CASE("Line.visitText", "[Line]")
+{
+    auto text = "  ab  "sv;
+    auto pool = buffer_object_pool<char>(32);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd(text);
+
+    auto const trivial = TrivialLineBuffer { .displayWidth = ColumnCount(40),
+                                             .textAttributes = GraphicsAttributes {},
+                                             .fillAttributes = GraphicsAttributes {},
+                                             .hyperlink = HyperlinkId {},
+                                             .usedColumns = ColumnCount(6),
+                                             .text = bufferObject->ref(0, 6) };
+    auto const line = Line<Cell>(LineFlag::None, trivial);
+
+    // The text is passed as view into the line's own storage, followed by the blank columns.
+    auto pieces = std::vector<std::string_view> {};
+    line.visitText([&](std::string_view piece) { pieces.emplace_back(piece); });
+    REQUIRE(pieces.size() >= 2);
+    CHECK(pieces[0].data() == line.trivialBuffer().text.data());
+    auto visited = std::string {};
+    for (auto const piece: pieces)
+        visited += piece;
+    CHECK(visited == std::string(text) + std::string(34, ' '));
+    CHECK(line.isTrivialBuffer());
+
+    CHECK(line.toUtf8Trimmed() == "ab");
+    CHECK(line.toUtf8Trimmed(false, true) == "  ab");
+    CHECK(line.toUtf8Trimmed(true, false) == "ab  " + std::string(34, ' '));
+    CHECK(line.toUtf8Trimmed(false, false) == line.toUtf8());
+
+    auto inflated = Line<Cell>(LineFlag::None, trivial);
+    [[maybe_unused]] auto const& cells = inflated.inflatedBuffer();
+    auto inflatedText = std::string {};
+    inflated.visitText([&](std::string_view piece) { inflatedText += piece; });
+    CHECK(inflatedText == visited);
+}
+
 TEST_CASE("Line.reflow", "[Line]")
 {
     auto constexpr DisplayWidth = ColumnCount(4);
@@ -121,6 +159,19 @@ TEST_CASE("Line.inflate", "[Line]")
     }
 }
 
+TEST_CASE("Line.cellExtrasMemoryUsage", "[Line]")
+{
+    auto line = Line<Cell>(LineFlag::None, Line<Cell>::InflatedBuffer(4));
+    CHECK(line.cellExtrasMemoryUsage() == 0);
+
+    line.useCellAt(ColumnOffset(1)).setCharacter(U'e');
+    CHECK(line.cellExtrasMemoryUsage() == 0);
+
+    (void) line.useCellAt(ColumnOffset(1)).appendCharacter(0x0301); // COMBINING ACUTE ACCENT
+    CHECK(line.cellExtrasMemoryUsage() >= sizeof(CellExtra));
+    CHECK(line.memoryUsage() >= sizeof(Line<Cell>) + 4 * sizeof(Cell));
+}
+
 TEST_CASE("Line.inflate.Unicode", "[Line]")
 {
     auto constexpr DisplayWidth = ColumnCount(10);
@@ -235,3 +286,261 @@ TEST_CASE("Line.inflate.Unicode.FamilyEmoji", "[Line]")
     REQUIRE(cell.backgroundColor() == fillSGR.backgroundColor);
     REQUIRE(cell.underlineColor() == fillSGR.underlineColor);
 }
+
+TEST_CASE("Line.AttributedLineBuffer", "[Line]")
+{
+    auto red = GraphicsAttributes {};
+    red.foregroundColor = Color::Indexed(IndexedColor::Red);
+    red.flags |= CellFlag::Bold;
+
+    auto cells = InflatedLineBuffer<Cell>(6, Cell {});
+    cells[0].write(red, U'a', 1);
+    cells[1].write(red, U'b', 1);
+    cells[2].write(GraphicsAttributes {}, U'中', 2); // wide char
+    cells[3].reset(GraphicsAttributes {}.with(CellFlag::WideCharContinuation));
+    cells[4].write(GraphicsAttributes {}, U'c', 1, HyperlinkId(1));
+
+    auto line = Line<Cell>(LineFlag::None, cells);
+    REQUIRE(line.compactIntoAttributedBuffer());
+    CHECK(line.isAttributedBuffer());
+    CHECK(line.size() == ColumnCount(6));
+    CHECK(!line.empty());
+
+    auto const& attributed = line.attributedBuffer();
+    CHECK(attributed.codepoints == U"ab中\0c\0"sv);
+    REQUIRE(attributed.spans.size() == 5);
+    CHECK(attributed.spans[0].length == ColumnCount(2));
+    CHECK(attributed.spans[0].attributes == red);
+
+    // Iterating the cells does not inflate the line.
+    auto text = std::u32string {};
+    line.forEachAttributedCell(
+        [&](Cell const& cell) { text += cell.codepointCount() ? cell.codepoint(0) : U' '; });
+    CHECK(text == U"ab中 c "sv);
+    CHECK(line.isAttributedBuffer());
+
+    // Accessing the cells inflates the line back into its original state.
+    auto const& inflated = line.inflatedBuffer();
+    CHECK(line.isInflatedBuffer());
+    REQUIRE(inflated.size() == 6);
+    CHECK(inflated[0].foregroundColor() == red.foregroundColor);
+    CHECK(inflated[1].isFlagEnabled(CellFlag::Bold));
+    CHECK(inflated[2].width() == 2);
+    CHECK(inflated[3].isFlagEnabled(CellFlag::WideCharContinuation));
+    CHECK(inflated[4].hyperlink() == HyperlinkId(1));
+    CHECK(inflated[5].empty());
+}
+
+TEST_CASE("Line.PackedLineBuffer", "[Line]")
+{
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor { 0x12, 0x34, 0x56 };
+    sgr.underlineColor = Color::Bright(3);
+    sgr.flags |= CellFlag::Italic;
+
+    auto cells = InflatedLineBuffer<Cell>(8, Cell {});
+    cells[0].write(sgr, U'x', 1);
+    cells[1].write(GraphicsAttributes {}, U'中', 2); // wide char
+    cells[2].reset(GraphicsAttributes {}.with(CellFlag::WideCharContinuation));
+    cells[3].write(GraphicsAttributes {}, U'y', 1, HyperlinkId(300));
+
+    auto line = Line<Cell>(LineFlag::None, cells);
+    REQUIRE(line.packIntoColdBuffer());
+    CHECK(line.isPackedBuffer());
+    CHECK(line.size() == ColumnCount(8));
+
+    // Unpacking the line restores its original state.
+    REQUIRE(line.unpackColdBuffer());
+    CHECK(!line.unpackColdBuffer());
+    auto const& attributed = line.attributedBuffer();
+    CHECK(line.isAttributedBuffer());
+    CHECK(attributed.codepoints == U"x中\0y\0\0\0\0"sv);
+    REQUIRE(attributed.spans.size() == 5);
+    CHECK(attributed.spans[0].attributes == sgr);
+    CHECK(attributed.spans[3].hyperlink == HyperlinkId(300));
+    CHECK(attributed.spans[4].length == ColumnCount(4));
+
+    REQUIRE(line.packIntoColdBuffer());
+    CHECK(line.toUtf8() == "x中 y    ");
+    CHECK(line.isInflatedBuffer());
+}
+
+TEST_CASE("Line.contentHash", "[Line]")
+{
+    auto red = GraphicsAttributes {};
+    red.foregroundColor = Color::Indexed(IndexedColor::Red);
+
+    auto cells = InflatedLineBuffer<Cell>(4, Cell {});
+    cells[0].write(red, U'a', 1);
+    cells[1].write(GraphicsAttributes {}, U'b', 1);
+
+    auto const line = Line<Cell>(LineFlag::None, cells);
+    CHECK(line.contentHash() == Line<Cell>(LineFlag::None, cells).contentHash());
+    CHECK(line.contentHash() != Line<Cell>(LineFlag::Marked, cells).contentHash());
+
+    auto recolored = cells;
+    recolored[1].write(red, U'b', 1);
+    CHECK(line.contentHash() != Line<Cell>(LineFlag::None, recolored).contentHash());
+
+    auto rewritten = cells;
+    rewritten[1].write(GraphicsAttributes {}, U'c', 1);
+    CHECK(line.contentHash() != Line<Cell>(LineFlag::None, rewritten).contentHash());
+
+    // Attributed and packed lines hash alike, without being unpacked for it.
+    auto attributed = Line<Cell>(LineFlag::None, cells);
+    REQUIRE(attributed.compactIntoAttributedBuffer());
+    auto packed = Line<Cell>(LineFlag::None, cells);
+    REQUIRE(packed.packIntoColdBuffer());
+    CHECK(attributed.contentHash() == packed.contentHash());
+    CHECK(packed.isPackedBuffer());
+}
+
+TEST_CASE("Line.AttributedLineBuffer.rejects_grapheme_clusters", "[Line]")
+{
+    auto cells = InflatedLineBuffer<Cell>(3, Cell {});
+    cells[0].write(GraphicsAttributes {}, U'e', 1);
+    (void) cells[0].appendCharacter(U'\u0301'); // combining acute accent
+    auto line = Line<Cell>(LineFlag::None, cells);
+    CHECK(!line.compactIntoAttributedBuffer());
+    CHECK(line.isInflatedBuffer());
+}
+
+TEST_CASE("Line.compactIntoTrivialBuffer", "[Line]")
+{
+    auto sgr = GraphicsAttributes {};
+    sgr.backgroundColor = Color::Indexed(IndexedColor::Green);
+
+    auto cells = InflatedLineBuffer<Cell>(5, Cell { sgr });
+    cells[0].write(sgr, U'a', 1, HyperlinkId(7));
+    cells[1].write(sgr, U'中', 2, HyperlinkId(7));
+    cells[2].reset(sgr.with(CellFlag::WideCharContinuation), HyperlinkId(7));
+    cells[3].write(sgr, U'b', 1, HyperlinkId(7));
+
+    auto textBuffer = buffer_object_ptr<char> {};
+    auto line = Line<Cell>(LineFlag::None, cells);
+    REQUIRE(line.compactIntoTrivialBuffer(textBuffer));
+    CHECK(line.isTrivialBuffer());
+    CHECK(line.size() == ColumnCount(5));
+    CHECK(line.trivialBuffer().text.view() == "a中b"sv);
+    CHECK(line.trivialBuffer().usedColumns == ColumnCount(4));
+    CHECK(line.trivialBuffer().hyperlink == HyperlinkId(7));
+    REQUIRE(textBuffer);
+    CHECK(textBuffer->bytesUsed() == "a中b"sv.size());
+
+    // Accessing the cells inflates the line back into its original state.
+    auto const& inflated = line.inflatedBuffer();
+    REQUIRE(inflated.size() == 5);
+    CHECK(inflated[1].width() == 2);
+    CHECK(inflated[2].isFlagEnabled(CellFlag::WideCharContinuation));
+    CHECK(inflated[3].hyperlink() == HyperlinkId(7));
+    CHECK(inflated[4].empty());
+    CHECK(inflated[4].backgroundColor() == sgr.backgroundColor);
+
+    // Further lines share the text buffer.
+    auto other = Line<Cell>(LineFlag::None, InflatedLineBuffer<Cell>(2, Cell {}));
+    other.useCellAt(ColumnOffset(0)).write(GraphicsAttributes {}, U'x', 1);
+    REQUIRE(other.compactIntoTrivialBuffer(textBuffer));
+    CHECK(other.trivialBuffer().text.owner() == line.trivialBuffer().text.owner());
+}
+
+TEST_CASE("Line.compactIntoTrivialBuffer.shares_text", "[Line]")
+{
+    auto textBuffer = buffer_object_ptr<char> {};
+    auto textCache = HistoryTextCache {};
+    auto const compacted = [&]() {
+        auto line = Line<Cell>(LineFlag::None, InflatedLineBuffer<Cell>(4, Cell {}));
+        line.useCellAt(ColumnOffset(0)).write(GraphicsAttributes {}, U'-', 1);
+        line.useCellAt(ColumnOffset(1)).write(GraphicsAttributes {}, U'-', 1);
+        REQUIRE(line.compactIntoTrivialBuffer(textBuffer, &textCache));
+        return line;
+    };
+
+    auto const first = compacted();
+    auto const second = compacted();
+    CHECK(second.trivialBuffer().text.data() == first.trivialBuffer().text.data());
+    CHECK(textBuffer->bytesUsed() == 2);
+    CHECK(textCache.hitCount() == 1);
+
+    // Writing to a line sharing its text leaves the other one untouched.
+    auto third = compacted();
+    third.useCellAt(ColumnOffset(0)).write(GraphicsAttributes {}, U'=', 1);
+    CHECK(third.toUtf8() == "=-  ");
+    CHECK(first.toUtf8() == "--  ");
+}
+
+TEST_CASE("Line.compactIntoTrivialBuffer.rejects_non_uniform_lines", "[Line]")
+{
+    auto textBuffer = buffer_object_ptr<char> {};
+    auto bold = GraphicsAttributes {}.with(CellFlag::Bold);
+
+    auto mixedAttributes = InflatedLineBuffer<Cell>(3, Cell {});
+    mixedAttributes[0].write(GraphicsAttributes {}, U'a', 1);
+    mixedAttributes[1].write(bold, U'b', 1);
+    auto line = Line<Cell>(LineFlag::None, mixedAttributes);
+    CHECK(!line.compactIntoTrivialBuffer(textBuffer));
+    CHECK(line.isInflatedBuffer());
+
+    // Empty cells in between text would be inflated into spaces.
+    auto gap = InflatedLineBuffer<Cell>(3, Cell {});
+    gap[0].write(GraphicsAttributes {}, U'a', 1);
+    gap[2].write(GraphicsAttributes {}, U'b', 1);
+    line = Line<Cell>(LineFlag::None, gap);
+    CHECK(!line.compactIntoTrivialBuffer(textBuffer));
+
+    // The padding of a wide character at the end of the text is not restored as continuation cell.
+    auto trailingWideChar = InflatedLineBuffer<Cell>(3, Cell {});
+    trailingWideChar[0].write(GraphicsAttributes {}, U'中', 2);
+    trailingWideChar[1].reset(GraphicsAttributes {}.with(CellFlag::WideCharContinuation));
+    line = Line<Cell>(LineFlag::None, trailingWideChar);
+    CHECK(!line.compactIntoTrivialBuffer(textBuffer));
+
+    auto cluster = InflatedLineBuffer<Cell>(2, Cell {});
+    cluster[0].write(GraphicsAttributes {}, U'e', 1);
+    (void) cluster[0].appendCharacter(U'\u0301'); // combining acute accent
+    line = Line<Cell>(LineFlag::None, cluster);
+    CHECK(!line.compactIntoTrivialBuffer(textBuffer));
+    CHECK(!textBuffer);
+}
+
+TEST_CASE("Line.rangeOperations", "[Line]")
+{
+    auto cells = InflatedLineBuffer<Cell>(8, Cell {});
+    for (auto i = 0; i < 8; ++i)
+        cells[static_cast<size_t>(i)].write(GraphicsAttributes {}, static_cast<char32_t>('a' + i), 1);
+    auto line = Line<Cell>(LineFlag::None, cells);
+    REQUIRE(line.toUtf8() == "abcdefgh");
+
+    // Overlapping copies within the same line behave like memmove, in either direction.
+    line.copyRange(ColumnOffset(2), line, ColumnOffset(0), ColumnCount(4));
+    CHECK(line.toUtf8() == "ababcdgh");
+    line.copyRange(ColumnOffset(0), line, ColumnOffset(1), ColumnCount(4));
+    CHECK(line.toUtf8() == "babccdgh");
+
+    line.fillRange(ColumnOffset(5), ColumnCount(2), GraphicsAttributes {}, U'x', 1);
+    CHECK(line.toUtf8() == "babccxxh");
+
+    line.useCellAt(ColumnOffset(1)).resetFlags(CellFlag::CharacterProtected);
+    line.eraseUnprotectedRange(ColumnOffset(0), ColumnCount(3));
+    CHECK(line.toUtf8() == " a ccxxh");
+}
+
+TEST_CASE("CompactCell.copy_assign_drops_stale_extra", "[Line]")
+{
+    auto sgr = GraphicsAttributes {};
+    sgr.flags = CellFlag::Bold;
+
+    auto source = CompactCell {};
+    source.write(sgr, U'A', 2);
+    CHECK(source.flags() == CellFlag::Bold);
+    CHECK(source.width() == 2);
+
+    auto target = CompactCell {};
+    target.setHyperlink(HyperlinkId(42));
+    REQUIRE(target.hyperlink() == HyperlinkId(42));
+
+    target = source;
+    CHECK(target.codepoint(0) == U'A');
+    CHECK(target.width() == 2);
+    CHECK(target.flags() == CellFlag::Bold);
+    CHECK(target.hyperlink() == HyperlinkId());
+}
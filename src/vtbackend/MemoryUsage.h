@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <cstddef>
+
+namespace vtbackend
+{
+
+/// Approximate memory taken by a terminal, in bytes, broken down by what it is taken by.
+struct MemoryUsage
+{
+    size_t trivialLines = 0;  ///< Lines stored as text with uniform attributes, or packed.
+    size_t inflatedLines = 0; ///< Lines stored as one cell per column, including recycled cell buffers.
+    size_t cellExtras = 0;    ///< Per-cell extra data, e.g. combining characters or image fragments.
+    size_t hyperlinks = 0;
+    size_t images = 0; ///< Pixel data of all images, compressed or not.
+    size_t renderBuffers = 0;
+    size_t parser = 0;     ///< Parser state, and the payload of sequences and images being received.
+    size_t ptyBuffers = 0; ///< Buffers the PTY output is read into, in use or pooled.
+
+    [[nodiscard]] size_t lines() const noexcept { return trivialLines + inflatedLines + cellExtras; }
+
+    [[nodiscard]] size_t total() const noexcept
+    {
+        return lines() + hyperlinks + images + renderBuffers + parser + ptyBuffers;
+    }
+
+    /// Invokes @p visitor with the name and number of bytes of each part.
+    template <typename Visitor>
+    void visit(Visitor&& visitor) const
+    {
+        visitor("trivial_lines", trivialLines);
+        visitor("inflated_lines", inflatedLines);
+        visitor("cell_extras", cellExtras);
+        visitor("hyperlinks", hyperlinks);
+        visitor("images", images);
+        visitor("render_buffers", renderBuffers);
+        visitor("parser", parser);
+        visitor("pty_buffers", ptyBuffers);
+    }
+
+    MemoryUsage& operator+=(MemoryUsage const& other) noexcept
+    {
+        trivialLines += other.trivialLines;
+        inflatedLines += other.inflatedLines;
+        cellExtras += other.cellExtras;
+        hyperlinks += other.hyperlinks;
+        images += other.images;
+        renderBuffers += other.renderBuffers;
+        parser += other.parser;
+        ptyBuffers += other.ptyBuffers;
+        return *this;
+    }
+};
+
+} // namespace vtbackend
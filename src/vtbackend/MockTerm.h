@@ -18,7 +18,10 @@ class MockTerm: public Terminal::NullEvents
   public:
     MockTerm(ColumnCount columns, LineCount lines): MockTerm { PageSize { lines, columns } } {}
 
-    explicit MockTerm(PageSize size, LineCount maxHistoryLineCount = {}, size_t ptyReadBufferSize = 1024);
+    explicit MockTerm(PageSize size,
+                      LineCount maxHistoryLineCount = {},
+                      size_t ptyReadBufferSize = 1024,
+                      CellLayout cellLayout = CellLayout::Compact);
 
     template <typename Init>
     MockTerm(
@@ -74,9 +77,11 @@ class MockTerm: public Terminal::NullEvents
 
     static vtbackend::Settings createSettings(PageSize pageSize,
                                               LineCount maxHistoryLineCount,
-                                              size_t ptyReadBufferSize)
+                                              size_t ptyReadBufferSize,
+                                              CellLayout cellLayout)
     {
         auto settings = vtbackend::Settings {};
+        settings.cellLayout = cellLayout;
         settings.pageSize = pageSize;
         settings.maxHistoryLineCount = maxHistoryLineCount;
         settings.ptyReadBufferSize = ptyReadBufferSize;
@@ -88,17 +93,18 @@ class MockTerm: public Terminal::NullEvents
 
     void requestCaptureBuffer(LineCount lines, bool logical) override
     {
-        terminal.primaryScreen().captureBuffer(lines, logical);
+        terminal.visitPrimaryScreen([&](auto& screen) { screen.captureBuffer(lines, logical); });
     }
 };
 
 template <typename PtyDevice>
 inline MockTerm<PtyDevice>::MockTerm(PageSize pageSize,
                                      LineCount maxHistoryLineCount,
-                                     size_t ptyReadBufferSize):
+                                     size_t ptyReadBufferSize,
+                                     CellLayout cellLayout):
     terminal { *this,
                std::make_unique<PtyDevice>(pageSize),
-               createSettings(pageSize, maxHistoryLineCount, ptyReadBufferSize),
+               createSettings(pageSize, maxHistoryLineCount, ptyReadBufferSize, cellLayout),
                std::chrono::steady_clock::time_point() } // explicitly start with empty timepoint
 {
     char const* logFilterString = getenv("LOG");
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/PredictiveEcho.h>
+#include <vtbackend/ScreenBase.h>
+
+#include <algorithm>
+
+namespace vtbackend
+{
+
+namespace
+{
+    // Time on top of twice the measured latency to wait for the echo of a prediction, for jitter.
+    constexpr auto GracePeriod = std::chrono::milliseconds(100);
+} // namespace
+
+void PredictiveEcho::setThreshold(std::chrono::milliseconds threshold) noexcept
+{
+    _threshold = threshold;
+    if (_threshold.count() == 0)
+        reset();
+}
+
+void PredictiveEcho::noteLatency(Clock::duration latency) noexcept
+{
+    // Exponential moving average over roughly the last eight key inputs, taking the first one as is.
+    _latency = _latencyMeasured ? _latency + (latency - _latency) / 8 : latency;
+    _latencyMeasured = true;
+}
+
+bool PredictiveEcho::active() const noexcept
+{
+    return _threshold.count() != 0 && _latencyMeasured && _latency >= _threshold;
+}
+
+bool PredictiveEcho::canPredict(CellLocation cursor) const noexcept
+{
+    if (!active() || _awaitingOutput || _mispredictedLine == cursor.line)
+        return false;
+
+    // All predictions are made on one line, which the application's cursor needs to stay on.
+    return (_predictions.empty() || _predictions.front().position.line == cursor.line)
+           && (!_cursor || _cursor->line == cursor.line);
+}
+
+bool PredictiveEcho::predictText(char32_t codepoint,
+                                 CellLocation cursor,
+                                 ColumnCount pageColumns,
+                                 Clock::time_point now)
+{
+    if (!canPredict(cursor))
+        return false;
+
+    // Text reaching the last column would wrap with the next character, which is not predicted.
+    auto const position = _cursor.value_or(cursor);
+    if (position.column.value + 1 >= pageColumns.value)
+        return false;
+
+    auto const existing = std::ranges::find(_predictions, position, &Prediction::position);
+    if (existing != _predictions.end())
+        *existing = Prediction { .position = position, .codepoint = codepoint, .time = now };
+    else
+        _predictions.emplace_back(Prediction { .position = position, .codepoint = codepoint, .time = now });
+
+    _cursor = CellLocation { .line = position.line, .column = position.column + ColumnOffset(1) };
+    _cursorTime = now;
+    return true;
+}
+
+bool PredictiveEcho::predictCursorMove(int columns,
+                                       CellLocation cursor,
+                                       ColumnCount pageColumns,
+                                       Clock::time_point now)
+{
+    if (!canPredict(cursor))
+        return false;
+
+    auto const position = _cursor.value_or(cursor);
+    auto const column = std::clamp(position.column.value + columns, 0, pageColumns.value - 1);
+    _cursor = CellLocation { .line = position.line, .column = ColumnOffset(column) };
+    _cursorTime = now;
+    return true;
+}
+
+void PredictiveEcho::interrupt() noexcept
+{
+    reset();
+    _awaitingOutput = true;
+}
+
+void PredictiveEcho::reset() noexcept
+{
+    _predictions.clear();
+    _cursor.reset();
+    _cursorTime.reset();
+}
+
+void PredictiveEcho::rollback() noexcept
+{
+    if (!_predictions.empty())
+        _mispredictedLine = _predictions.front().position.line;
+    else if (_cursor)
+        _mispredictedLine = _cursor->line;
+    reset();
+}
+
+bool PredictiveEcho::verify(ScreenBase const& screen, CellLocation cursor, Clock::time_point now)
+{
+    _awaitingOutput = false;
+    if (_mispredictedLine && *_mispredictedLine != cursor.line)
+        _mispredictedLine.reset();
+
+    if (empty())
+        return false;
+
+    // Leaving the line, e.g. by Enter, leaves nothing to compare the predictions with.
+    auto const line = !_predictions.empty() ? _predictions.front().position.line : _cursor->line;
+    if (line != cursor.line)
+    {
+        reset();
+        return true;
+    }
+
+    auto const predictionCount = _predictions.size();
+    std::erase_if(_predictions, [&](Prediction const& prediction) {
+        return screen.compareCellTextAt(prediction.position, prediction.codepoint)
+               || (prediction.codepoint == U' ' && screen.isCellEmpty(prediction.position));
+    });
+    auto changed = _predictions.size() != predictionCount;
+
+    if (_predictions.empty() && _cursor == cursor)
+    {
+        _cursor.reset();
+        _cursorTime.reset();
+        changed = true;
+    }
+
+    return expire(now) || changed;
+}
+
+bool PredictiveEcho::expire(Clock::time_point now) noexcept
+{
+    auto const due = deadline();
+    if (!due || now < *due)
+        return false;
+
+    rollback();
+    return true;
+}
+
+PredictiveEcho::Clock::duration PredictiveEcho::timeout() const noexcept
+{
+    return 2 * _latency + GracePeriod;
+}
+
+std::optional<PredictiveEcho::Clock::time_point> PredictiveEcho::deadline() const noexcept
+{
+    // The cursor is waited for on its own once all characters typed have been confirmed.
+    auto oldest = _predictions.empty() ? _cursorTime : std::nullopt;
+    for (auto const& prediction: _predictions)
+        oldest = oldest ? std::min(*oldest, prediction.time) : prediction.time;
+
+    if (!oldest)
+        return std::nullopt;
+    return *oldest + timeout();
+}
+
+} // namespace vtbackend
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/primitives.h>
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+namespace vtbackend
+{
+
+class ScreenBase;
+
+/**
+ * Echoes typed input locally ahead of the application, for sessions whose PTY output takes long
+ * to answer key input, such as SSH connections to far away hosts.
+ *
+ * Printable characters and moving the cursor left and right are predicted on the cursor's line.
+ * The predictions are drawn on top of the page until the application's own echo has been parsed,
+ * which either confirms them or, if it does not show what was predicted, rolls them all back.
+ *
+ * Predicting only takes place while the measured latency of key input is at least the threshold.
+ */
+class PredictiveEcho
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /// A character predicted to be shown at a cell of the page.
+    struct Prediction
+    {
+        CellLocation position;
+        char32_t codepoint;
+        Clock::time_point time;
+    };
+
+    /// Sets the latency needed to start predicting, or disables predicting if it is zero.
+    void setThreshold(std::chrono::milliseconds threshold) noexcept;
+    [[nodiscard]] std::chrono::milliseconds threshold() const noexcept { return _threshold; }
+
+    /// Accounts the time it took the PTY output to answer a key input.
+    void noteLatency(Clock::duration latency) noexcept;
+    [[nodiscard]] Clock::duration latency() const noexcept { return _latency; }
+
+    /// Tells whether typed input is currently predicted.
+    [[nodiscard]] bool active() const noexcept;
+
+    /// Predicts typing @p codepoint with the application's cursor at @p cursor.
+    ///
+    /// @returns whether the character was predicted.
+    bool predictText(char32_t codepoint, CellLocation cursor, ColumnCount pageColumns, Clock::time_point now);
+
+    /// Predicts moving the cursor by @p columns (to the left if negative) within its line.
+    ///
+    /// @returns whether the cursor move was predicted.
+    bool predictCursorMove(int columns, CellLocation cursor, ColumnCount pageColumns, Clock::time_point now);
+
+    /// Drops all predictions, as input has been sent that cannot be predicted.
+    ///
+    /// Predicting resumes once PTY output has been verified, as the cursor may be moved by then.
+    void interrupt() noexcept;
+
+    /// Drops all predictions, e.g. when the page has been switched or resized.
+    void reset() noexcept;
+
+    /// Confirms or rolls back the predictions against the PTY output just parsed into @p screen.
+    ///
+    /// @returns whether any prediction has been dropped.
+    bool verify(ScreenBase const& screen, CellLocation cursor, Clock::time_point now);
+
+    /// Rolls back all predictions if the oldest of them has not been confirmed in due time.
+    ///
+    /// @returns whether the predictions have been rolled back.
+    bool expire(Clock::time_point now) noexcept;
+
+    /// @returns the time until which the oldest prediction waits for confirmation, if any.
+    [[nodiscard]] std::optional<Clock::time_point> deadline() const noexcept;
+
+    [[nodiscard]] std::vector<Prediction> const& predictions() const noexcept { return _predictions; }
+
+    /// @returns the predicted cursor position, if it differs from the application's cursor.
+    [[nodiscard]] std::optional<CellLocation> cursor() const noexcept { return _cursor; }
+
+    [[nodiscard]] bool empty() const noexcept { return _predictions.empty() && !_cursor; }
+
+  private:
+    [[nodiscard]] bool canPredict(CellLocation cursor) const noexcept;
+    [[nodiscard]] Clock::duration timeout() const noexcept;
+    void rollback() noexcept;
+
+    std::chrono::milliseconds _threshold {};
+    Clock::duration _latency {};
+    bool _latencyMeasured = false;
+
+    std::vector<Prediction> _predictions;
+    std::optional<CellLocation> _cursor;
+    std::optional<Clock::time_point> _cursorTime; // of the most recent prediction
+
+    // Predicting is suspended until PTY output has been verified after input that was not predicted,
+    // resp. as long as the cursor stays on the line a misprediction has been made on.
+    bool _awaitingOutput = false;
+    std::optional<LineOffset> _mispredictedLine;
+};
+
+} // namespace vtbackend
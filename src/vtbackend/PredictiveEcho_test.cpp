@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/MockTerm.h>
+#include <vtbackend/PredictiveEcho.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+auto const PageColumns = ColumnCount(10);
+
+PredictiveEcho makePredictiveEcho()
+{
+    auto echo = PredictiveEcho {};
+    echo.setThreshold(100ms);
+    echo.noteLatency(200ms);
+    return echo;
+}
+
+} // namespace
+
+TEST_CASE("PredictiveEcho.threshold")
+{
+    auto echo = PredictiveEcho {};
+    auto const now = PredictiveEcho::Clock::now();
+    CHECK(!echo.predictText(U'a', CellLocation {}, PageColumns, now));
+
+    echo.setThreshold(100ms);
+    echo.noteLatency(50ms);
+    CHECK(!echo.active());
+    CHECK(!echo.predictText(U'a', CellLocation {}, PageColumns, now));
+
+    echo.noteLatency(1s);
+    CHECK(echo.active());
+    CHECK(echo.predictText(U'a', CellLocation {}, PageColumns, now));
+}
+
+TEST_CASE("PredictiveEcho.confirm")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), PageColumns }, LineCount(10) };
+    auto const& screen = mock.terminal.primaryScreen();
+    auto echo = makePredictiveEcho();
+    auto const now = PredictiveEcho::Clock::now();
+
+    mock.writeToScreen("$ ");
+    REQUIRE(echo.predictText(U'l', screen.cursor().position, PageColumns, now));
+    REQUIRE(echo.predictText(U's', screen.cursor().position, PageColumns, now));
+    CHECK(echo.predictions().size() == 2);
+    CHECK(echo.cursor() == CellLocation { LineOffset(0), ColumnOffset(4) });
+
+    mock.writeToScreen("l");
+    CHECK(echo.verify(screen, screen.cursor().position, now));
+    REQUIRE(echo.predictions().size() == 1);
+    CHECK(echo.predictions().front().codepoint == U's');
+
+    mock.writeToScreen("s");
+    CHECK(echo.verify(screen, screen.cursor().position, now));
+    CHECK(echo.empty());
+}
+
+TEST_CASE("PredictiveEcho.cursor_move")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), PageColumns }, LineCount(10) };
+    auto const& screen = mock.terminal.primaryScreen();
+    auto echo = makePredictiveEcho();
+    auto const now = PredictiveEcho::Clock::now();
+
+    mock.writeToScreen("abc");
+    REQUIRE(echo.predictCursorMove(-1, screen.cursor().position, PageColumns, now));
+    REQUIRE(echo.predictText(U'x', screen.cursor().position, PageColumns, now));
+    CHECK(echo.predictions().front().position == CellLocation { LineOffset(0), ColumnOffset(2) });
+    CHECK(echo.cursor() == CellLocation { LineOffset(0), ColumnOffset(3) });
+
+    // The application's echo has not arrived yet.
+    CHECK(!echo.verify(screen, screen.cursor().position, now));
+    CHECK(!echo.empty());
+
+    mock.writeToScreen("\bx");
+    CHECK(echo.verify(screen, screen.cursor().position, now));
+    CHECK(echo.empty());
+}
+
+TEST_CASE("PredictiveEcho.rollback")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), PageColumns }, LineCount(10) };
+    auto const& screen = mock.terminal.primaryScreen();
+    auto echo = makePredictiveEcho();
+    auto const now = PredictiveEcho::Clock::now();
+
+    // Password prompts do not echo.
+    mock.writeToScreen("Password: ");
+    REQUIRE(echo.predictText(U's', screen.cursor().position, PageColumns, now));
+    REQUIRE(echo.deadline().has_value());
+    CHECK(!echo.expire(*echo.deadline() - 1ms));
+    CHECK(echo.expire(*echo.deadline()));
+    CHECK(echo.empty());
+
+    // Predicting stays off on the line that has been mispredicted.
+    CHECK(!echo.predictText(U'e', screen.cursor().position, PageColumns, now));
+    mock.writeToScreen("\r\n$ ");
+    CHECK(!echo.verify(screen, screen.cursor().position, now));
+    CHECK(echo.predictText(U'e', screen.cursor().position, PageColumns, now));
+}
+
+TEST_CASE("PredictiveEcho.interrupt")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), PageColumns }, LineCount(10) };
+    auto const& screen = mock.terminal.primaryScreen();
+    auto echo = makePredictiveEcho();
+    auto const now = PredictiveEcho::Clock::now();
+
+    REQUIRE(echo.predictText(U'a', screen.cursor().position, PageColumns, now));
+    echo.interrupt();
+    CHECK(echo.empty());
+
+    // The cursor may be anywhere until the application has answered the input not predicted.
+    CHECK(!echo.predictText(U'b', screen.cursor().position, PageColumns, now));
+    mock.writeToScreen("a");
+    CHECK(!echo.verify(screen, screen.cursor().position, now));
+    CHECK(echo.predictText(U'b', screen.cursor().position, PageColumns, now));
+}
+
+TEST_CASE("PredictiveEcho.last_column")
+{
+    auto echo = makePredictiveEcho();
+    auto const now = PredictiveEcho::Clock::now();
+    auto const lastColumn = CellLocation { LineOffset(0), ColumnOffset(9) };
+    CHECK(!echo.predictText(U'a', lastColumn, PageColumns, now));
+    CHECK(echo.empty());
+}
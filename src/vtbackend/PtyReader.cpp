@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/PtyReader.h>
+#include <vtbackend/logging.h>
+
+#include <crispy/thread_cpu_clock.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace vtbackend
+{
+
+PtyReader::PtyReader(vtpty::Pty& pty, size_t readSize): _pty { pty }, _readSize { readSize }
+{
+    for (auto& slot: _slots)
+        slot.buffer = crispy::buffer_object<char>::create(_readSize);
+}
+
+PtyReader::~PtyReader()
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        _stopping = true;
+    }
+    _condition.notify_all();
+    if (!_thread.joinable())
+        return;
+    _pty.wakeupReader();
+    _thread.join();
+}
+
+bool PtyReader::wait(std::optional<std::chrono::milliseconds> timeout)
+{
+    if (!_thread.joinable())
+        _thread = std::thread { [this]() {
+            run();
+        } };
+
+    auto lock = std::unique_lock { _mutex };
+    auto const ready = [this]() {
+        return _count != 0 || _ptyClosed || _woken;
+    };
+    if (timeout)
+        _condition.wait_for(lock, *timeout, ready);
+    else
+        _condition.wait(lock, ready);
+    _woken = false;
+    return _count != 0;
+}
+
+size_t PtyReader::consume(std::function<void(Chunk const&)> const& consume)
+{
+    auto head = size_t { 0 };
+    auto count = size_t { 0 };
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        head = _head;
+        count = _count;
+    }
+
+    // The reader thread never touches filled slots, so they can be consumed without holding the lock.
+    for (size_t i = 0; i < count; ++i)
+        consume(_slots[(head + i) % SlotCount].chunk);
+
+    if (count != 0)
+    {
+        {
+            auto const lock = std::scoped_lock { _mutex };
+            _head = (_head + count) % SlotCount;
+            _count -= count;
+        }
+        _condition.notify_all();
+    }
+
+    return count;
+}
+
+bool PtyReader::pending() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _count != 0;
+}
+
+void PtyReader::wakeup()
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        _woken = true;
+    }
+    _condition.notify_all();
+}
+
+bool PtyReader::closed() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _ptyClosed && _count == 0;
+}
+
+void PtyReader::run()
+{
+    for (;;)
+    {
+        auto index = size_t { 0 };
+        {
+            auto lock = std::unique_lock { _mutex };
+            _condition.wait(lock, [this]() { return _stopping || _count < SlotCount; });
+            if (_stopping)
+                return;
+            index = (_head + _count) % SlotCount;
+        }
+
+        auto& slot = _slots[index];
+        slot.buffer->clear();
+        auto const result = [&]() {
+            auto const _ = crispy::cpu_time_accumulator { _readCpuTime };
+            return _pty.read(*slot.buffer, std::nullopt, _readSize);
+        }();
+
+        if (!result && (errno == EINTR || errno == EAGAIN))
+            continue; // Interrupted, e.g. by the destructor.
+
+        if (!result || result->data.empty())
+        {
+            if (!result)
+                terminalLog()("PTY read failed. {}", strerror(errno));
+            else
+                terminalLog()("PTY read returned with zero bytes.");
+            {
+                auto const lock = std::scoped_lock { _mutex };
+                _ptyClosed = true;
+            }
+            _condition.notify_all();
+            return;
+        }
+
+        slot.chunk = *result;
+        {
+            auto const lock = std::scoped_lock { _mutex };
+            ++_count;
+        }
+        _condition.notify_all();
+    }
+}
+
+} // namespace vtbackend
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtpty/Pty.h>
+
+#include <crispy/BufferObject.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+namespace vtbackend
+{
+
+/**
+ * Reads from the PTY on a thread of its own, so that the next chunk of output is read
+ * while the previous one is still being parsed.
+ *
+ * Chunks are passed to the consumer through a small bounded ring of read buffers.
+ * If the consumer falls behind, the reader blocks once all buffers are filled,
+ * which in turn makes the application block on writing to the PTY.
+ *
+ * The reader thread is started by the first call to wait(), so that the reader may be
+ * constructed before the PTY is started. Only a single thread may consume chunks.
+ */
+class PtyReader
+{
+  public:
+    static constexpr inline size_t SlotCount = 8;
+
+    /// A chunk of PTY output, valid until the consume() callback it is passed to returns.
+    using Chunk = vtpty::Pty::ReadResult;
+
+    /// @p pty       the PTY to read from. It must outlive this reader.
+    /// @p readSize  the number of bytes to read at most at once.
+    PtyReader(vtpty::Pty& pty, size_t readSize);
+
+    PtyReader(PtyReader const&) = delete;
+    PtyReader(PtyReader&&) = delete;
+    PtyReader& operator=(PtyReader const&) = delete;
+    PtyReader& operator=(PtyReader&&) = delete;
+    ~PtyReader();
+
+    /// Waits for up to @p timeout (or indefinitely) for PTY output, until woken up, or until
+    /// the PTY is closed.
+    ///
+    /// @returns true if there is PTY output to be consumed.
+    bool wait(std::optional<std::chrono::milliseconds> timeout);
+
+    /// Passes all chunks read so far to @p consume, in order, without waiting for more.
+    ///
+    /// @returns the number of chunks consumed.
+    size_t consume(std::function<void(Chunk const&)> const& consume);
+
+    /// @returns true if chunks have been read that are not consumed yet.
+    [[nodiscard]] bool pending() const;
+
+    /// Interrupts a wait() call that is currently waiting for PTY output.
+    void wakeup();
+
+    /// @returns true once the PTY has been closed and all chunks read before have been consumed.
+    [[nodiscard]] bool closed() const;
+
+    /// @returns the CPU time the reader thread has spent reading from the PTY so far.
+    [[nodiscard]] std::chrono::nanoseconds readCpuTime() const noexcept
+    {
+        return std::chrono::nanoseconds(_readCpuTime.load(std::memory_order_relaxed));
+    }
+
+  private:
+    struct Slot
+    {
+        crispy::buffer_object_ptr<char> buffer;
+        Chunk chunk {};
+    };
+
+    void run();
+
+    vtpty::Pty& _pty;
+    size_t _readSize;
+
+    std::array<Slot, SlotCount> _slots;
+    std::atomic<int64_t> _readCpuTime = 0; // in nanoseconds
+
+    // Guards all members below.
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    size_t _head = 0;  // index of the next slot to be consumed
+    size_t _count = 0; // number of slots filled, but not yet consumed
+    bool _woken = false;
+    bool _ptyClosed = false;
+    bool _stopping = false;
+
+    std::thread _thread;
+};
+
+} // namespace vtbackend
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/PtyReader.h>
+
+#include <vtpty/MockPty.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+using namespace vtbackend;
+
+TEST_CASE("PtyReader.read_until_closed")
+{
+    auto pty = vtpty::MockPty { PageSize { LineCount(5), ColumnCount(10) } };
+
+    // More chunks than there are read buffers, so that the reader has to wait for the consumer.
+    auto expected = std::string {};
+    for (int i = 0; i < 100; ++i)
+        expected += std::to_string(i) + ' ';
+    pty.appendStdOutBuffer(expected);
+
+    auto reader = PtyReader { pty, 16 };
+    auto received = std::string {};
+    auto chunkCount = size_t { 0 };
+    while (reader.wait(std::nullopt))
+    {
+        chunkCount += reader.consume([&](PtyReader::Chunk const& chunk) {
+            CHECK(chunk.data.size() <= 16);
+            received += chunk.data;
+        });
+    }
+
+    CHECK(received == expected);
+    CHECK(chunkCount >= expected.size() / 16);
+    CHECK(reader.closed());
+    CHECK(reader.consume([](PtyReader::Chunk const&) {}) == 0);
+}
@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/PtyWriter.h>
+#include <vtbackend/logging.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace vtbackend
+{
+
+namespace
+{
+    // Bounds how long the writer thread waits for the PTY, so that it notices being stopped.
+    constexpr auto WritableTimeout = std::chrono::milliseconds(100);
+} // namespace
+
+PtyWriter::PtyWriter(vtpty::Pty& pty, size_t pasteCapacity, std::function<void()> pasteChanged):
+    _pty { pty }, _pasteCapacity { pasteCapacity }, _pasteChanged { std::move(pasteChanged) }
+{
+}
+
+PtyWriter::~PtyWriter()
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        _stopping = true;
+    }
+    _condition.notify_all();
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void PtyWriter::writeInput(std::string_view data)
+{
+    enqueue(data, false, false);
+}
+
+bool PtyWriter::writePaste(std::string_view data, bool atomic)
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        if (_pasteBytes + data.size() > _pasteCapacity)
+        {
+            inputLog()(
+                "Rejecting paste of {} bytes, as {} bytes are still pending.", data.size(), _pasteBytes);
+            return false;
+        }
+    }
+    enqueue(data, true, atomic);
+    return true;
+}
+
+void PtyWriter::writePaste(PasteSource source, bool atomic)
+{
+    auto lock = std::unique_lock { _mutex };
+    auto const pasteStarted = _pastes.empty();
+    if (pasteStarted)
+        _pastedBytes = 0;
+    _pastes.emplace_back(
+        Paste { .data = {}, .offset = 0, .atomic = atomic, .started = false, .source = std::move(source) });
+    startWriter(lock, pasteStarted);
+}
+
+bool PtyWriter::pasting() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return !_pastes.empty();
+}
+
+size_t PtyWriter::pastedBytes() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _pastedBytes;
+}
+
+size_t PtyWriter::pendingPasteBytes() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _pasteBytes;
+}
+
+size_t PtyWriter::pendingBytes() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _input.size() - _inputOffset + _pasteBytes;
+}
+
+void PtyWriter::enqueue(std::string_view data, bool paste, bool atomic)
+{
+    if (data.empty())
+        return;
+
+    auto lock = std::unique_lock { _mutex };
+
+    // Write right away if nothing else is queued. This does not block, unless the PTY blocks on writing.
+    auto written = size_t { 0 };
+    if (!_writing && !hasPending())
+    {
+        _writing = true;
+        lock.unlock();
+        auto const rv = _pty.write(data);
+        lock.lock();
+        _writing = false;
+        if (rv > 0)
+            written = static_cast<size_t>(rv);
+        if (written == data.size())
+            return;
+    }
+
+    auto const pasteStarted = paste && _pastes.empty();
+    if (paste)
+    {
+        if (pasteStarted)
+            _pastedBytes = written;
+        _pastes.emplace_back(Paste {
+            .data = std::string(data), .offset = written, .atomic = atomic, .started = written != 0 });
+        _pasteBytes += data.size() - written;
+    }
+    else
+        _input += data.substr(written);
+
+    startWriter(lock, pasteStarted);
+}
+
+void PtyWriter::startWriter(std::unique_lock<std::mutex>& lock, bool pasteStarted)
+{
+    if (!_thread.joinable())
+        _thread = std::thread { [this]() {
+            run();
+        } };
+
+    lock.unlock();
+    _condition.notify_all();
+
+    if (pasteStarted && _pasteChanged)
+        _pasteChanged();
+}
+
+bool PtyWriter::nextFromPaste() const noexcept
+{
+    if (_pastes.empty())
+        return false;
+
+    // A started atomic paste must be finished before any other input.
+    auto const& paste = _pastes.front();
+    if (paste.atomic && paste.started)
+        return true;
+
+    return _inputOffset == _input.size();
+}
+
+void PtyWriter::consume(bool fromPaste, size_t n)
+{
+    if (!fromPaste)
+    {
+        _inputOffset += n;
+        if (_inputOffset == _input.size())
+        {
+            _input.clear();
+            _inputOffset = 0;
+        }
+        return;
+    }
+
+    auto& paste = _pastes.front();
+    paste.offset += n;
+    paste.started = true;
+    _pasteBytes -= n;
+    _pastedBytes += n;
+    if (paste.offset == paste.data.size() && !paste.source)
+        _pastes.pop_front();
+}
+
+void PtyWriter::discardPending()
+{
+    _input.clear();
+    _inputOffset = 0;
+    _pastes.clear();
+    _pasteBytes = 0;
+}
+
+void PtyWriter::run()
+{
+    auto chunk = std::string {};
+    for (;;)
+    {
+        auto fromPaste = false;
+        {
+            auto lock = std::unique_lock { _mutex };
+            _condition.wait(lock, [this]() { return _stopping || (!_writing && hasPending()); });
+            if (_stopping)
+                return;
+
+            // Queued input may be appended to while writing, which is why the chunk is copied.
+            fromPaste = nextFromPaste();
+            if (fromPaste && _pastes.front().offset == _pastes.front().data.size())
+            {
+                // Only this thread removes pastes, so the front one stays valid while unlocked.
+                auto& paste = _pastes.front();
+                lock.unlock();
+                auto data = paste.source();
+                lock.lock();
+                if (data.empty())
+                {
+                    _pastes.pop_front();
+                    auto const pasteFinished = _pastes.empty();
+                    lock.unlock();
+                    if (pasteFinished && _pasteChanged)
+                        _pasteChanged();
+                    continue;
+                }
+                _pasteBytes += data.size();
+                paste.data = std::move(data);
+                paste.offset = 0;
+            }
+
+            auto const source = fromPaste
+                                    ? std::string_view(_pastes.front().data).substr(_pastes.front().offset)
+                                    : std::string_view(_input).substr(_inputOffset);
+            chunk = source.substr(0, MaxWriteSize);
+            _writing = true;
+        }
+
+        auto const rv = _pty.write(chunk);
+        auto const failed = rv < 0 && errno != EAGAIN && errno != EINTR;
+        if (failed)
+            inputLog()("PTY write failed. {}", strerror(errno));
+
+        auto pasteFinished = false;
+        {
+            auto const lock = std::scoped_lock { _mutex };
+            auto const hadPastes = !_pastes.empty();
+            _writing = false;
+            if (rv > 0)
+                consume(fromPaste, static_cast<size_t>(rv));
+            if (failed)
+                discardPending();
+            pasteFinished = hadPastes && _pastes.empty();
+        }
+
+        if (pasteFinished && _pasteChanged)
+            _pasteChanged();
+
+        if (rv <= 0 && !failed)
+            (void) _pty.waitForWritable(WritableTimeout);
+    }
+}
+
+} // namespace vtbackend
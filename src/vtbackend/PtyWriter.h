@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtpty/Pty.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace vtbackend
+{
+
+/**
+ * Queues input to the PTY, so that writing never blocks the caller when the application
+ * is not reading its input, e.g. while pasting a large clipboard.
+ *
+ * Input is written right away if nothing is queued and the PTY accepts it. Whatever it does
+ * not accept is queued and written by a thread of its own once the PTY becomes writable.
+ *
+ * Input, such as keystrokes, jumps ahead of queued pastes. Pastes that must not be interleaved
+ * with other input (i.e. bracketed pastes) are written in one piece once they have been started.
+ *
+ * Pastes may also be streamed from a PasteSource, which is only asked for the next chunk once
+ * the previous one has been written, so that arbitrarily large pastes take bounded memory.
+ */
+class PtyWriter
+{
+  public:
+    /// Default maximum number of paste bytes to be queued at once.
+    static constexpr inline size_t DefaultPasteCapacity = 64 * 1024 * 1024;
+
+    /// Number of bytes written at most at once, which bounds how long input waits behind a paste.
+    static constexpr inline size_t MaxWriteSize = 4096;
+
+    /// Yields the next chunk of a streamed paste, or an empty string at its end.
+    ///
+    /// It is invoked on the writer thread.
+    using PasteSource = std::function<std::string()>;
+
+    /// @p pty            the PTY to write to. It must outlive this writer.
+    /// @p pasteCapacity  the maximum number of paste bytes to be queued at once.
+    /// @p pasteChanged   invoked whenever a paste starts or finishes being written, possibly on the
+    ///                   writer thread.
+    PtyWriter(vtpty::Pty& pty, size_t pasteCapacity, std::function<void()> pasteChanged);
+
+    PtyWriter(PtyWriter const&) = delete;
+    PtyWriter(PtyWriter&&) = delete;
+    PtyWriter& operator=(PtyWriter const&) = delete;
+    PtyWriter& operator=(PtyWriter&&) = delete;
+    ~PtyWriter();
+
+    /// Writes input (e.g. keystrokes or replies to the application) ahead of queued pastes.
+    void writeInput(std::string_view data);
+
+    /// Writes a paste after all previously queued pastes.
+    ///
+    /// @p atomic  whether the paste must not be interleaved with other input once started.
+    ///
+    /// @returns false if the paste was rejected, because it exceeds the paste capacity.
+    [[nodiscard]] bool writePaste(std::string_view data, bool atomic);
+
+    /// Writes a paste streamed from @p source after all previously queued pastes.
+    ///
+    /// @p atomic  whether the paste must not be interleaved with other input once started.
+    void writePaste(PasteSource source, bool atomic);
+
+    /// @returns whether any paste has not been written completely yet.
+    [[nodiscard]] bool pasting() const;
+
+    /// @returns the number of paste bytes written since the last time no paste was queued.
+    [[nodiscard]] size_t pastedBytes() const;
+
+    /// @returns the number of paste bytes that have not been written yet, excluding those that
+    ///          a paste source has not yielded yet.
+    [[nodiscard]] size_t pendingPasteBytes() const;
+
+    /// @returns the total number of bytes that have not been written yet.
+    [[nodiscard]] size_t pendingBytes() const;
+
+  private:
+    struct Paste
+    {
+        std::string data;
+        size_t offset = 0;
+        bool atomic = false;
+        bool started = false;
+        PasteSource source {}; // yields more data once data has been written, if set
+    };
+
+    void enqueue(std::string_view data, bool paste, bool atomic);
+    void startWriter(std::unique_lock<std::mutex>& lock, bool pasteStarted);
+    void run();
+
+    // The following require the mutex to be locked.
+    [[nodiscard]] bool hasPending() const noexcept
+    {
+        return _inputOffset < _input.size() || !_pastes.empty();
+    }
+    [[nodiscard]] bool nextFromPaste() const noexcept;
+    void consume(bool fromPaste, size_t n);
+    void discardPending();
+
+    vtpty::Pty& _pty;
+    size_t _pasteCapacity;
+    std::function<void()> _pasteChanged;
+
+    // Guards all members below.
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::string _input;
+    size_t _inputOffset = 0;
+    std::deque<Paste> _pastes;
+    size_t _pasteBytes = 0;
+    size_t _pastedBytes = 0;
+    bool _writing = false; // whether a write to the PTY is in progress, on any thread
+    bool _stopping = false;
+
+    std::thread _thread; // started on first use
+};
+
+} // namespace vtbackend
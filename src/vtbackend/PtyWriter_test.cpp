@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/PtyWriter.h>
+
+#include <vtpty/MockPty.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace vtbackend;
+
+namespace
+{
+
+/// Mock PTY that only accepts as many bytes as it has been granted.
+class ThrottledPty: public vtpty::MockPty
+{
+  public:
+    ThrottledPty(): MockPty { PageSize { LineCount(5), ColumnCount(10) } } {}
+
+    int write(std::string_view data) override
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        ++_attempts;
+        auto const n = std::min(data.size(), _budget);
+        if (!n)
+        {
+            errno = EAGAIN;
+            return -1;
+        }
+        _budget -= n;
+        return MockPty::write(data.substr(0, n));
+    }
+
+    bool waitForWritable(std::chrono::milliseconds timeout) override
+    {
+        auto lock = std::unique_lock { _mutex };
+        return _condition.wait_for(lock, timeout, [this]() { return _budget != 0; });
+    }
+
+    void grant(size_t n)
+    {
+        {
+            auto const lock = std::scoped_lock { _mutex };
+            _budget += n;
+        }
+        _condition.notify_all();
+    }
+
+    std::string written()
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        return stdinBuffer();
+    }
+
+    size_t attempts()
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        return _attempts;
+    }
+
+  private:
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    size_t _budget = 0;
+    size_t _attempts = 0;
+};
+
+template <typename Predicate>
+void waitUntil(Predicate predicate)
+{
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!predicate() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void waitUntilWritten(PtyWriter const& writer)
+{
+    waitUntil([&]() { return writer.pendingBytes() == 0; });
+}
+
+} // namespace
+
+TEST_CASE("PtyWriter.write_through")
+{
+    auto pty = ThrottledPty {};
+    pty.grant(100);
+    auto writer = PtyWriter { pty, 1024, {} };
+    writer.writeInput("abc");
+    CHECK(writer.pendingBytes() == 0);
+    CHECK(pty.written() == "abc");
+}
+
+TEST_CASE("PtyWriter.input_jumps_ahead_of_paste")
+{
+    auto pty = ThrottledPty {};
+    auto pasteChanges = std::atomic<int> { 0 };
+    auto writer = PtyWriter { pty, 1024, [&]() { ++pasteChanges; } };
+
+    REQUIRE(writer.writePaste("PASTE", false));
+    writer.writeInput("k");
+    CHECK(writer.pendingPasteBytes() == 5);
+    CHECK(writer.pendingBytes() == 6);
+
+    // Make sure the writer thread has seen the input before the PTY accepts anything.
+    auto const attempts = pty.attempts();
+    waitUntil([&]() { return pty.attempts() > attempts; });
+
+    pty.grant(6);
+    waitUntilWritten(writer);
+    waitUntil([&]() { return pasteChanges == 2; });
+    CHECK(pty.written() == "kPASTE");
+    CHECK(pasteChanges == 2);
+}
+
+TEST_CASE("PtyWriter.atomic_paste")
+{
+    auto pty = ThrottledPty {};
+    pty.grant(2);
+    auto writer = PtyWriter { pty, 1024, {} };
+
+    // The paste has been started already, so it is finished before any other input.
+    REQUIRE(writer.writePaste("PASTE", true));
+    writer.writeInput("k");
+    pty.grant(4);
+    waitUntilWritten(writer);
+    CHECK(pty.written() == "PASTEk");
+}
+
+TEST_CASE("PtyWriter.paste_capacity")
+{
+    auto pty = ThrottledPty {};
+    auto writer = PtyWriter { pty, 8, {} };
+
+    CHECK(writer.writePaste("12345", false));
+    CHECK_FALSE(writer.writePaste("6789", false));
+    CHECK(writer.pendingPasteBytes() == 5);
+
+    pty.grant(5);
+    waitUntilWritten(writer);
+    CHECK(pty.written() == "12345");
+}
+
+TEST_CASE("PtyWriter.streamed_paste")
+{
+    auto pty = ThrottledPty {};
+    pty.grant(100);
+    auto writer = PtyWriter { pty, 1024, {} };
+
+    auto chunks = std::vector<std::string> { "ab", "cd" };
+    auto source = [chunks, i = size_t { 0 }]() mutable -> std::string {
+        return i < chunks.size() ? chunks[i++] : std::string {};
+    };
+    writer.writePaste(std::move(source), false);
+    waitUntil([&]() { return !writer.pasting(); });
+    CHECK(pty.written() == "abcd");
+    CHECK(writer.pastedBytes() == 4);
+    CHECK(writer.pendingBytes() == 0);
+}
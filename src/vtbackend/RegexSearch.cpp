@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/RegexSearch.h>
+
+#include <libunicode/convert.h>
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
+namespace vtbackend
+{
+
+namespace
+{
+    char toLowerAscii(char ch) noexcept
+    {
+        return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+    }
+
+    bool isQuantifier(char ch) noexcept
+    {
+        return ch == '*' || ch == '+' || ch == '?' || ch == '{';
+    }
+
+    /// @returns the offset right past the group or character class starting at @p i.
+    size_t skipBracketed(std::string_view pattern, size_t i) noexcept
+    {
+        auto const open = pattern[i];
+        auto const close = open == '(' ? ')' : ']';
+        auto depth = 0;
+        auto inClass = false;
+        for (; i < pattern.size(); ++i)
+        {
+            auto const ch = pattern[i];
+            if (ch == '\\')
+                ++i;
+            else if (inClass)
+                inClass = ch != ']';
+            else if (ch == '[' && open == '(')
+                inClass = true;
+            else if (ch == open)
+                ++depth;
+            else if (ch == close && --depth == 0)
+                return i + 1;
+        }
+        return pattern.size();
+    }
+
+    /// @returns the offset right past the quantifier starting at @p i, including a lazy modifier.
+    size_t skipQuantifier(std::string_view pattern, size_t i) noexcept
+    {
+        if (pattern[i] == '{')
+            while (i < pattern.size() && pattern[i] != '}')
+                ++i;
+        ++i;
+        if (i < pattern.size() && pattern[i] == '?')
+            ++i;
+        return i;
+    }
+} // namespace
+
+std::string requiredLiteralOf(std::string_view pattern)
+{
+    auto best = std::string {};
+    auto current = std::string {};
+    auto const flush = [&]() {
+        if (current.size() > best.size())
+            best = current;
+        current.clear();
+    };
+
+    auto i = size_t { 0 };
+    while (i < pattern.size())
+    {
+        auto const ch = pattern[i];
+        switch (ch)
+        {
+            case '|':
+                // Literals of one alternative are not required by the others.
+                return {};
+            case '(':
+            case '[':
+                flush();
+                i = skipBracketed(pattern, i);
+                if (i < pattern.size() && isQuantifier(pattern[i]))
+                    i = skipQuantifier(pattern, i);
+                continue;
+            case '.':
+            case '^':
+            case '$':
+                flush();
+                ++i;
+                continue;
+            case '*':
+            case '?':
+            case '{':
+                // The character in front is optional.
+                while (!current.empty() && (static_cast<unsigned char>(current.back()) & 0xC0) == 0x80)
+                    current.pop_back();
+                if (!current.empty())
+                    current.pop_back();
+                flush();
+                i = skipQuantifier(pattern, i);
+                continue;
+            case '+':
+                // The character in front is required, but may be repeated.
+                flush();
+                i = skipQuantifier(pattern, i);
+                continue;
+            case '\\': {
+                if (i + 1 == pattern.size())
+                    return {};
+                auto const escaped = pattern[i + 1];
+                i += 2;
+                if (std::isalnum(static_cast<unsigned char>(escaped)))
+                {
+                    // Character class, assertion, back reference or encoded character.
+                    if (escaped == 'x')
+                        i += 2;
+                    else if (escaped == 'u')
+                        i += 4;
+                    else if (escaped == 'c')
+                        i += 1;
+                    flush();
+                    if (i < pattern.size() && isQuantifier(pattern[i]))
+                        i = skipQuantifier(pattern, i);
+                    continue;
+                }
+                current += escaped;
+                continue;
+            }
+            default:
+                current += ch;
+                ++i;
+                continue;
+        }
+    }
+    flush();
+    return best;
+}
+
+std::optional<RegexSearchPattern> RegexSearchPattern::compile(std::u32string_view pattern)
+{
+    auto const text = unicode::convert_to<char>(pattern);
+
+    // Smart case, as for literal search, but escape sequences like \W or \S do not count.
+    auto caseSensitive = false;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] == '\\')
+            ++i;
+        else if (std::isupper(static_cast<unsigned char>(text[i])))
+            caseSensitive = true;
+    }
+
+    auto flags = std::regex::ECMAScript | std::regex::optimize;
+    if (!caseSensitive)
+        flags |= std::regex::icase;
+
+    try
+    {
+        auto literal = requiredLiteralOf(text);
+        if (!caseSensitive)
+            std::ranges::transform(literal, literal.begin(), toLowerAscii);
+        return RegexSearchPattern(std::regex(text, flags), std::move(literal), caseSensitive);
+    }
+    catch (std::regex_error const&)
+    {
+        return std::nullopt;
+    }
+}
+
+RegexSearchPattern::RegexSearchPattern(std::regex regex, std::string literal, bool caseSensitive):
+    _regex { std::move(regex) }, _literal { std::move(literal) }, _caseSensitive { caseSensitive }
+{
+}
+
+bool RegexSearchPattern::mayMatch(std::string_view text) const noexcept
+{
+    if (_literal.empty())
+        return true;
+
+    if (_caseSensitive)
+        return text.find(_literal) != std::string_view::npos;
+
+    auto const match = std::ranges::search(
+        text, _literal, [](char a, char b) { return toLowerAscii(a) == b; });
+    return !match.empty();
+}
+
+std::optional<RegexMatch> RegexSearchPattern::findFirst(std::string_view text, size_t startOffset) const
+{
+    if (startOffset > text.size())
+        return std::nullopt;
+
+    auto const flags = startOffset != 0 ? std::regex_constants::match_prev_avail
+                                        : std::regex_constants::match_default;
+    auto const end = std::cregex_iterator();
+    for (auto i = std::cregex_iterator(text.data() + startOffset, text.data() + text.size(), _regex, flags);
+         i != end;
+         ++i)
+        if (i->length() != 0)
+            return RegexMatch { .offset = startOffset + static_cast<size_t>(i->position()),
+                                .length = static_cast<size_t>(i->length()) };
+
+    return std::nullopt;
+}
+
+std::optional<RegexMatch> RegexSearchPattern::findLast(std::string_view text, size_t startOffset) const
+{
+    auto result = std::optional<RegexMatch> {};
+    auto const end = std::cregex_iterator();
+    for (auto i = std::cregex_iterator(text.data(), text.data() + text.size(), _regex); i != end; ++i)
+    {
+        if (static_cast<size_t>(i->position()) > startOffset)
+            break;
+        if (i->length() != 0)
+            result = RegexMatch { .offset = static_cast<size_t>(i->position()),
+                                  .length = static_cast<size_t>(i->length()) };
+    }
+    return result;
+}
+
+} // namespace vtbackend
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+
+namespace vtbackend
+{
+
+/// Byte range of a regular expression match within a line's UTF-8 text.
+struct RegexMatch
+{
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+/**
+ * Regular expression search term (ECMAScript syntax), matched against the UTF-8 text of one line at a time.
+ *
+ * Running the regex engine on every line of a deep history is slow, so the pattern is analyzed for a literal
+ * that every match must contain. Lines not containing that literal are rejected by a plain substring scan,
+ * and the regex engine only runs on the remaining candidate lines.
+ *
+ * Like literal search, matching is case insensitive unless the pattern contains upper case letters.
+ */
+class RegexSearchPattern
+{
+  public:
+    /// @returns the compiled pattern, or std::nullopt if @p pattern is not a valid regular expression.
+    [[nodiscard]] static std::optional<RegexSearchPattern> compile(std::u32string_view pattern);
+
+    /// @returns the literal every match contains, lower-cased if matching case insensitively.
+    [[nodiscard]] std::string const& requiredLiteral() const noexcept { return _literal; }
+    [[nodiscard]] bool isCaseSensitive() const noexcept { return _caseSensitive; }
+
+    /// Tests whether the given line text may contain a match, i.e. whether it contains the required literal.
+    [[nodiscard]] bool mayMatch(std::string_view text) const noexcept;
+
+    /// @returns the first non-empty match starting at or after byte offset @p startOffset.
+    [[nodiscard]] std::optional<RegexMatch> findFirst(std::string_view text, size_t startOffset = 0) const;
+
+    /// @returns the last non-empty match starting at or before byte offset @p startOffset.
+    [[nodiscard]] std::optional<RegexMatch> findLast(std::string_view text, size_t startOffset) const;
+
+  private:
+    RegexSearchPattern(std::regex regex, std::string literal, bool caseSensitive);
+
+    std::regex _regex;
+    std::string _literal;
+    bool _caseSensitive;
+};
+
+/// @returns the longest literal that every match of the given ECMAScript pattern must contain,
+///          or an empty string if none can be determined.
+[[nodiscard]] std::string requiredLiteralOf(std::string_view pattern);
+
+} // namespace vtbackend
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/RegexSearch.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+
+TEST_CASE("RegexSearch.requiredLiteralOf", "[regex]")
+{
+    CHECK(requiredLiteralOf("error") == "error");
+    CHECK(requiredLiteralOf("E[0-9]+: failed") == ": failed");
+    CHECK(requiredLiteralOf("colou?r") == "colo");
+    CHECK(requiredLiteralOf("ab+c") == "ab");
+    CHECK(requiredLiteralOf(R"(\d+\.\d+\.\d+\.\d+)") == ".");
+    CHECK(requiredLiteralOf(R"(at (\w+)\.java:\d+)") == ".java:");
+    CHECK(requiredLiteralOf("(foo)?bar") == "bar");
+    CHECK(requiredLiteralOf("foo|bar").empty());
+    CHECK(requiredLiteralOf(".*").empty());
+}
+
+TEST_CASE("RegexSearch.compile", "[regex]")
+{
+    CHECK(!RegexSearchPattern::compile(U"(unbalanced").has_value());
+
+    auto const smartCase = RegexSearchPattern::compile(U"\\Wfoo");
+    REQUIRE(smartCase.has_value());
+    CHECK(!smartCase->isCaseSensitive());
+
+    auto const caseSensitive = RegexSearchPattern::compile(U"Foo");
+    REQUIRE(caseSensitive.has_value());
+    CHECK(caseSensitive->isCaseSensitive());
+    CHECK(!caseSensitive->mayMatch("foo"));
+}
+
+TEST_CASE("RegexSearch.mayMatch", "[regex]")
+{
+    auto const pattern = RegexSearchPattern::compile(U"timeout after \\d+ms");
+    REQUIRE(pattern.has_value());
+    CHECK(pattern->requiredLiteral() == "timeout after ");
+    CHECK(pattern->mayMatch("request TIMEOUT AFTER 30ms"));
+    CHECK(!pattern->mayMatch("request completed"));
+}
+
+TEST_CASE("RegexSearch.find", "[regex]")
+{
+    auto const pattern = RegexSearchPattern::compile(U"[0-9]+");
+    REQUIRE(pattern.has_value());
+
+    auto const text = std::string_view("a1 b22 c333");
+    auto const first = pattern->findFirst(text);
+    REQUIRE(first.has_value());
+    CHECK(first->offset == 1);
+    CHECK(first->length == 1);
+
+    auto const next = pattern->findFirst(text, 2);
+    REQUIRE(next.has_value());
+    CHECK(next->offset == 4);
+    CHECK(next->length == 2);
+
+    auto const last = pattern->findLast(text, text.size());
+    REQUIRE(last.has_value());
+    CHECK(last->offset == 8);
+
+    auto const previous = pattern->findLast(text, 7);
+    REQUIRE(previous.has_value());
+    CHECK(previous->offset == 4);
+
+    CHECK(!pattern->findLast(text, 0).has_value());
+}
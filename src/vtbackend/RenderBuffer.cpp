@@ -1,35 +1,96 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/RenderBuffer.h>
 
-#include <format>
-#include <mutex>
+#include <algorithm>
+#include <iterator>
 
 namespace vtbackend
 {
 
-bool RenderDoubleBuffer::swapBuffers(std::chrono::steady_clock::time_point now) noexcept
+void RenderCells::appendRange(RenderCells const& other, size_t begin, size_t end, LineOffset lineShift)
 {
-    // If the terminal thread (writer) cannot try_lock (w/o wait time)
-    // the front buffer, it'll just flush back buffer instead of swapping
-    // buffers as the front buffer is apparently still in use by the
-    // renderer thread and we want to avoid render-thread imposed
-    // wait times in the terminal thread as much as possible.
+    if (begin == end)
+        return;
 
-    if (!readerLock.try_lock())
-        return false;
+    auto const cellBase = positions.size();
+    auto const appendColumn = [&](auto& to, auto const& from) {
+        to.insert(to.end(),
+                  std::next(from.begin(), static_cast<ptrdiff_t>(begin)),
+                  std::next(from.begin(), static_cast<ptrdiff_t>(end)));
+    };
+    appendColumn(positions, other.positions);
+    if (lineShift != LineOffset(0))
+        for (auto i = cellBase; i < positions.size(); ++i)
+            positions[i].line += lineShift;
+    appendColumn(attributes, other.attributes);
+    appendColumn(widths, other.widths);
+    appendColumn(groupMarks, other.groupMarks);
 
-    auto const _ = std::lock_guard<decltype(readerLock)>(readerLock, std::adopt_lock);
+    // The codepoints of consecutive cells are consecutive in the arena, too.
+    auto const arenaBegin = other.codepointRanges[begin].offset;
+    auto const arenaEnd = other.codepointRanges[end - 1].offset + other.codepointRanges[end - 1].count;
+    auto const arenaBase = static_cast<uint32_t>(codepointArena.size());
+    codepointArena.insert(codepointArena.end(),
+                          std::next(other.codepointArena.begin(), static_cast<ptrdiff_t>(arenaBegin)),
+                          std::next(other.codepointArena.begin(), static_cast<ptrdiff_t>(arenaEnd)));
+    for (auto i = begin; i < end; ++i)
+        codepointRanges.push_back(
+            CodepointRange { .offset = other.codepointRanges[i].offset - arenaBegin + arenaBase,
+                             .count = other.codepointRanges[i].count });
 
-    for (;;)
+    // Image runs are sorted by cell index and do not overlap. Runs crossing the range are clipped to it.
+    auto const endsAfter = [](RenderImage const& image, size_t cell) {
+        return image.cell + image.span <= cell;
+    };
+    auto const first = std::lower_bound(other.images.begin(), other.images.end(), begin, endsAfter);
+    for (auto image = first; image != other.images.end() && image->cell < end; ++image)
     {
-        auto current = currentBackBufferIndex.load();
-        if (currentBackBufferIndex.compare_exchange_weak(current, (current + 1) % 2))
-            break;
+        auto const runBegin = std::max<size_t>(image->cell, begin);
+        auto const runEnd = std::min<size_t>(image->cell + image->span, end);
+        auto offset = image->offset;
+        offset.column += ColumnOffset::cast_from(runBegin - image->cell);
+        images.push_back(RenderImage { .cell = static_cast<uint32_t>(runBegin - begin + cellBase),
+                                       .span = static_cast<uint32_t>(runEnd - runBegin),
+                                       .offset = offset,
+                                       .image = image->image });
     }
+}
+
+void RenderCells::appendImageFragment(size_t index, ImageFragment const& fragment)
+{
+    if (!images.empty())
+    {
+        auto& run = images.back();
+        auto const span = static_cast<int>(run.span);
+        auto const& runStart = positions[run.cell];
+        auto const continuesRun =
+            run.image.get() == &fragment.rasterizedImage() && run.cell + run.span == index
+            && positions[index].line == runStart.line
+            && positions[index].column == runStart.column + ColumnOffset(span)
+            && fragment.offset().line == run.offset.line
+            && fragment.offset().column == run.offset.column + ColumnOffset(span);
+        if (continuesRun)
+        {
+            ++run.span;
+            return;
+        }
+    }
+
+    images.push_back(RenderImage { .cell = static_cast<uint32_t>(index),
+                                   .span = 1,
+                                   .offset = fragment.offset(),
+                                   .image = fragment.rasterizedImagePointer() });
+}
+
+void RenderTripleBuffer::swapBuffers(std::chrono::steady_clock::time_point now) noexcept
+{
+    // The former middle buffer is either one the reader never picked up, or the one it just let go of
+    // by acquiring a newer one. Either way, it is no longer in use and can be filled next.
+    _backIndex = _middle.exchange(static_cast<uint8_t>(_backIndex | FreshBit), std::memory_order_acq_rel)
+                 & IndexMask;
 
     lastUpdate = now;
     state = RenderBufferState::WaitingForRefresh;
-    return true;
 }
 
 } // namespace vtbackend
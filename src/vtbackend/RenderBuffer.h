@@ -3,7 +3,9 @@
 
 #include <vtbackend/CellFlags.h>
 #include <vtbackend/Color.h>
+#include <vtbackend/ColorPalette.h>
 #include <vtbackend/Grid.h>
+#include <vtbackend/Hyperlink.h>
 #include <vtbackend/Image.h>
 #include <vtbackend/primitives.h>
 
@@ -11,10 +13,12 @@
 
 #include <gsl/pointers>
 
+#include <array>
 #include <atomic>
 #include <chrono>
-#include <mutex>
+#include <memory>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 namespace vtbackend
@@ -26,22 +30,143 @@ struct RenderAttributes
     RGBColor backgroundColor {};
     RGBColor decorationColor {};
     CellFlags flags {};
+
+    bool operator==(RenderAttributes const&) const noexcept = default;
+};
+
+/**
+ * Run of image fragments to be drawn into consecutive render cells of a line.
+ *
+ * Only very few cells carry an image, so these are kept in a sparse list next to the cells.
+ * An image covers many cells in a row though, so each row of it is kept as a single run,
+ * which the renderer computes the fragments of, rather than one entry per cell.
+ */
+struct RenderImage
+{
+    uint32_t cell = 0;      ///< Index of the first cell the run is drawn into.
+    uint32_t span = 1;      ///< Number of cells the run spans.
+    CellLocation offset {}; ///< Grid offset of the run's first fragment into the rasterized image.
+    std::shared_ptr<RasterizedImage const> image;
+
+    bool operator==(RenderImage const&) const noexcept = default;
 };
 
 /**
- * Renderable representation of a grid cell with color-altering pre-applied and
+ * Renderable representation of the grid cells with color-altering pre-applied and
  * additional information for cell ranges that can be text-shaped together.
+ *
+ * The cells are stored column-wise, so that each renderer only walks the columns it needs,
+ * and the codepoints of all cells are kept in a single arena that is reused across frames.
  */
-struct RenderCell
+struct RenderCells
 {
-    std::u32string codepoints;
-    std::shared_ptr<ImageFragment> image;
-    CellLocation position;
-    RenderAttributes attributes;
-    uint8_t width = 1;
+    /// Range of a cell's codepoints within the codepoint arena.
+    struct CodepointRange
+    {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+
+        bool operator==(CodepointRange const&) const noexcept = default;
+    };
 
-    bool groupStart = false;
-    bool groupEnd = false;
+    enum GroupMark : uint8_t
+    {
+        GroupStart = 0x01,
+        GroupEnd = 0x02,
+    };
+
+    std::vector<CellLocation> positions {};
+    std::vector<RenderAttributes> attributes {};
+    std::vector<uint8_t> widths {};
+    std::vector<uint8_t> groupMarks {};
+    std::vector<CodepointRange> codepointRanges {};
+    std::vector<char32_t> codepointArena {};
+    std::vector<RenderImage> images {};
+
+    [[nodiscard]] size_t size() const noexcept { return positions.size(); }
+    [[nodiscard]] bool empty() const noexcept { return positions.empty(); }
+
+    bool operator==(RenderCells const&) const noexcept = default;
+
+    /// Clears all cells but retains the allocated storage for the next frame.
+    void clear() noexcept
+    {
+        positions.clear();
+        attributes.clear();
+        widths.clear();
+        groupMarks.clear();
+        codepointRanges.clear();
+        codepointArena.clear();
+        images.clear();
+    }
+
+    /// Appends a cell without any codepoints.
+    ///
+    /// @returns the index of the new cell.
+    size_t append(CellLocation position, RenderAttributes const& cellAttributes, uint8_t width)
+    {
+        auto const index = positions.size();
+        positions.push_back(position);
+        attributes.push_back(cellAttributes);
+        widths.push_back(width);
+        groupMarks.push_back(0);
+        codepointRanges.push_back(CodepointRange { .offset = static_cast<uint32_t>(codepointArena.size()),
+                                                   .count = 0 });
+        return index;
+    }
+
+    /// Appends the given codepoint to the most recently appended cell.
+    void appendCodepoint(char32_t codepoint)
+    {
+        codepointArena.push_back(codepoint);
+        ++codepointRanges.back().count;
+    }
+
+    /// Appends a cell with the given codepoints.
+    ///
+    /// @returns the index of the new cell.
+    size_t append(CellLocation position,
+                  RenderAttributes const& cellAttributes,
+                  uint8_t width,
+                  std::u32string_view codepoints)
+    {
+        auto const index = append(position, cellAttributes, width);
+        codepointArena.insert(codepointArena.end(), codepoints.begin(), codepoints.end());
+        codepointRanges.back().count = static_cast<uint32_t>(codepoints.size());
+        return index;
+    }
+
+    /// Appends the given image fragment to be drawn into the cell at @p index, which is the most
+    /// recently appended one, extending the most recent image run if the fragment continues it.
+    void appendImageFragment(size_t index, ImageFragment const& fragment);
+
+    /// Appends the cells [begin, end) of @p other, including their codepoints and images,
+    /// moving them down by @p lineShift lines.
+    void appendRange(RenderCells const& other,
+                     size_t begin,
+                     size_t end,
+                     LineOffset lineShift = LineOffset(0));
+
+    [[nodiscard]] std::u32string_view codepoints(size_t index) const noexcept
+    {
+        auto const range = codepointRanges[index];
+        return { codepointArena.data() + range.offset, range.count };
+    }
+
+    void markGroupStart(size_t index) noexcept { groupMarks[index] |= GroupStart; }
+    void markGroupEnd(size_t index) noexcept { groupMarks[index] |= GroupEnd; }
+
+    [[nodiscard]] bool isGroupStart(size_t index) const noexcept { return groupMarks[index] & GroupStart; }
+    [[nodiscard]] bool isGroupEnd(size_t index) const noexcept { return groupMarks[index] & GroupEnd; }
+
+    /// @returns the number of bytes of memory allocated for the cells.
+    [[nodiscard]] size_t memoryUsage() const noexcept
+    {
+        return positions.capacity() * sizeof(CellLocation) + attributes.capacity() * sizeof(RenderAttributes)
+               + widths.capacity() + groupMarks.capacity()
+               + codepointRanges.capacity() * sizeof(CodepointRange)
+               + codepointArena.capacity() * sizeof(char32_t) + images.capacity() * sizeof(RenderImage);
+    }
 };
 
 /**
@@ -55,6 +180,8 @@ struct RenderLine
     ColumnCount displayWidth;
     RenderAttributes textAttributes;
     RenderAttributes fillAttributes;
+
+    bool operator==(RenderLine const&) const noexcept = default;
 };
 
 struct RenderCursor
@@ -64,46 +191,129 @@ struct RenderCursor
     int width = 1;
 };
 
+/// Times at which key input has been received and answered, to measure its latency by.
+struct InputTiming
+{
+    std::chrono::steady_clock::time_point input;    ///< The key input was received.
+    std::chrono::steady_clock::time_point answered; ///< PTY output following it was parsed.
+};
+
+/**
+ * Describes how the main page of a RenderBuffer was rendered, so that a later refresh
+ * of the same buffer can take over all lines that have not been damaged since,
+ * even if they have been scrolled to another line of the page since.
+ */
+struct RenderDamageState
+{
+    /// Everything apart from the grid lines themselves that affects the rendered main page.
+    ///
+    /// Undamaged lines are only taken over if the key did not change in between.
+    struct Key
+    {
+        ScreenType screenType = ScreenType::Primary;
+        PageSize pageSize {};
+        LineOffset baseLine {};
+        bool reverseVideo = false;
+        HyperlinkId hoveringHyperlink {};
+        ColorPalette::Palette palette {};
+        RGBColor defaultForeground {};
+        RGBColor defaultBackground {};
+        RGBColor defaultForegroundBright {};
+        RGBColor defaultForegroundDimmed {};
+        bool useBrightColors = false;
+
+        /// Set if the page was rendered with state that may alter any line, such as a
+        /// selection, search highlighting, or blinking cells.
+        bool volatileState = false;
+
+        bool operator==(Key const&) const noexcept = default;
+    };
+
+    /// Range of cells and trivial lines in the RenderBuffer that a main page line was rendered into.
+    struct LineRange
+    {
+        size_t cellsBegin = 0;
+        size_t cellsEnd = 0;
+        size_t linesBegin = 0;
+        size_t linesEnd = 0;
+
+        /// Whether the line was taken over from the same line of the previous render buffer,
+        /// i.e. looks exactly as it did in the frame before.
+        bool unmoved = false;
+
+        /// Hash of the grid line's contents as rendered, if computed (see Line::contentHash()).
+        std::optional<uint64_t> contentHash {};
+    };
+
+    bool valid = false;
+    Key key {};
+    uint64_t damageStamp = 0;
+
+    /// Grid lines shown on top of the page and holding the cursor, each identified by its
+    /// offset plus the grid's scrolled line count (see Grid::scrolledLineCount()).
+    int64_t topLine = 0;
+    int64_t cursorLine = 0;
+
+    std::vector<LineRange> lineRanges {};
+
+    [[nodiscard]] bool canReuseLinesFor(Key const& newKey) const noexcept
+    {
+        return valid && !key.volatileState && key == newKey;
+    }
+};
+
 struct RenderBuffer
 {
-    std::vector<RenderCell> cells {};
+    RenderCells cells {};
     std::vector<RenderLine> lines {};
     std::optional<RenderCursor> cursor {};
     uint64_t frameID {};
 
+    /// ID of the first frame of the consecutive frames up to this one that all have equal cells and
+    /// lines, i.e. that only differ in their cursor.
+    uint64_t contentFrameID {};
+
+    RenderDamageState damage {};
+
+    /// Timing of the oldest key input that this buffer is the first to show the answer of, if any.
+    std::optional<InputTiming> inputTiming {};
+
     void clear()
     {
         cells.clear();
         lines.clear();
         cursor.reset();
+        damage.valid = false;
+        inputTiming.reset();
+    }
+
+    /// @returns the number of bytes of memory allocated for the contents of this buffer.
+    [[nodiscard]] size_t memoryUsage() const noexcept
+    {
+        return sizeof(RenderBuffer) + cells.memoryUsage() + lines.capacity() * sizeof(RenderLine)
+               + damage.lineRanges.capacity() * sizeof(RenderDamageState::LineRange);
     }
 };
 
-/// Lock-guarded handle to a read-only RenderBuffer object.
+/// Handle to the read-only RenderBuffer object that the reader most recently acquired.
 ///
 /// @see RenderBuffer
+/// @see RenderTripleBuffer::frontBuffer()
 struct RenderBufferRef
 {
     gsl::not_null<RenderBuffer const*> buffer;
-    gsl::not_null<std::mutex*> guard;
 
     [[nodiscard]] RenderBuffer const& get() const noexcept { return *buffer; }
 
-    RenderBufferRef(RenderBuffer const& buf, std::mutex& lock): buffer { &buf }, guard { &lock }
-    {
-        guard->lock();
-    }
-
-    ~RenderBufferRef() { guard->unlock(); }
+    explicit RenderBufferRef(RenderBuffer const& buf): buffer { &buf } {}
 };
 
-/// Reflects the current state of a RenderDoubleBuffer object.
+/// Reflects the current state of a RenderTripleBuffer object.
 ///
 enum class RenderBufferState : uint8_t
 {
     WaitingForRefresh,
     RefreshBuffersAndTrySwap,
-    TrySwapBuffers
 };
 
 constexpr std::string_view to_string(RenderBufferState state) noexcept
@@ -112,33 +322,58 @@ constexpr std::string_view to_string(RenderBufferState state) noexcept
     {
         case RenderBufferState::WaitingForRefresh: return "WaitingForRefresh";
         case RenderBufferState::RefreshBuffersAndTrySwap: return "RefreshBuffersAndTrySwap";
-        case RenderBufferState::TrySwapBuffers: return "TrySwapBuffers";
     }
     return "INVALID";
 }
 
-struct RenderDoubleBuffer
+/**
+ * Hands completed render buffers from the terminal thread (writer) to the render thread (reader).
+ *
+ * Of the three buffers, the writer exclusively owns the back buffer and the reader the front buffer.
+ * The third one is exchanged atomically with either side: the writer publishes a completed back
+ * buffer by swapping it into the middle, and the reader takes over the middle buffer as its new
+ * front buffer if it has been published since. Neither side ever waits for the other, the writer
+ * always has a buffer to fill, and the reader always gets the most recently completed frame.
+ */
+struct RenderTripleBuffer
 {
-    std::mutex mutable readerLock;
-    std::atomic<size_t> currentBackBufferIndex = 0;
-    std::array<RenderBuffer, 2> buffers {};
+    std::array<RenderBuffer, 3> buffers {};
     std::atomic<RenderBufferState> state = RenderBufferState::WaitingForRefresh;
     std::chrono::steady_clock::time_point lastUpdate {};
 
-    RenderBuffer& backBuffer() noexcept { return buffers[currentBackBufferIndex]; }
+    RenderBuffer& backBuffer() noexcept { return buffers[_backIndex]; }
 
-    RenderBufferRef frontBuffer() const
+    /// Acquires the most recently completed buffer. May only be invoked by the reader thread.
+    ///
+    /// The returned buffer remains valid until the next call to frontBuffer().
+    RenderBufferRef frontBuffer() const noexcept
     {
-        // if (state == RenderBufferState::TrySwapBuffers)
-        //     const_cast<RenderDoubleBuffer*>(this)->swapBuffers(lastUpdate);
-        RenderBuffer const& frontBuffer = buffers.at((currentBackBufferIndex + 1) % 2);
-        return RenderBufferRef(frontBuffer, readerLock);
+        if (_middle.load(std::memory_order_relaxed) & FreshBit)
+            _frontIndex = _middle.exchange(_frontIndex, std::memory_order_acq_rel) & IndexMask;
+        return RenderBufferRef(buffers[_frontIndex]);
     }
 
     void clear() { backBuffer().clear(); }
 
-    // Swaps front with back buffer. May only be invoked by the writer thread.
-    bool swapBuffers(std::chrono::steady_clock::time_point now) noexcept;
+    /// Frees the storage of all three buffers.
+    ///
+    /// Neither the writer nor the reader may access the buffers meanwhile.
+    void releaseStorage()
+    {
+        for (auto& buffer: buffers)
+            buffer = RenderBuffer {};
+    }
+
+    // Publishes the back buffer to the reader. May only be invoked by the writer thread.
+    void swapBuffers(std::chrono::steady_clock::time_point now) noexcept;
+
+  private:
+    static constexpr uint8_t IndexMask = 0x03;
+    static constexpr uint8_t FreshBit = 0x04;
+
+    uint8_t _backIndex = 0;
+    std::atomic<uint8_t> mutable _middle = 1;
+    uint8_t mutable _frontIndex = 2;
 };
 
 } // namespace vtbackend
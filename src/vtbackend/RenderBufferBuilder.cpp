@@ -99,6 +99,18 @@ namespace
         return mix(cursorColor, selectionColors, 0.25f).distinct();
     }
 
+    // Cell flags that affect the colors a cell is rendered with (see CellUtil::makeColors()).
+    constexpr auto ColorAffectingFlags = CellFlags { CellFlag::Bold,     CellFlag::Faint,
+                                                     CellFlag::Inverse,  CellFlag::Hidden,
+                                                     CellFlag::Blinking, CellFlag::RapidBlinking };
+
+    // Highlighting state of a cell, stored next to the color-affecting cell flags.
+    constexpr uint32_t StateSelected = 1u << 27;
+    constexpr uint32_t StateCursor = 1u << 28;
+    constexpr uint32_t StateCursorLine = 1u << 29;
+    constexpr uint32_t StateHighlighted = 1u << 30;
+    constexpr uint32_t StateUsed = 1u << 31;
+
 } // namespace
 
 template <CellConcept Cell>
@@ -121,10 +133,117 @@ RenderBufferBuilder<Cell>::RenderBufferBuilder(Terminal const& terminal,
 {
     output.frameID = terminal.lastFrameID();
 
+    auto const topLine = terminal.viewport().translateScreenToGridCoordinate(LineOffset(0));
+    auto const bottomLine = topLine + boxed_cast<LineOffset>(terminal.pageSize().lines) - 1;
+    if (_includeSelection && terminal.isSelectionAvailable())
+        _selectedRanges = terminal.selector()->ranges(topLine, bottomLine);
+    _highlightedRanges = terminal.highlightedRanges(topLine, bottomLine);
+    _hoveringDetectedHyperlink = terminal.hoveringDetectedHyperlink();
+
     if (_cursorPosition)
         output.cursor = renderCursor();
 }
 
+template <CellConcept Cell>
+void RenderBufferBuilder<Cell>::trackDamage(RenderBuffer& previous,
+                                            Grid<Cell> const& grid,
+                                            RenderDamageState::Key const& key,
+                                            LineOffset cursorLine,
+                                            ScrollOffset scrollOffset,
+                                            bool compareDamagedLines)
+{
+    auto const pageLineCount = unbox<size_t>(grid.pageSize().lines);
+
+    _previous = &previous;
+    _grid = &grid;
+    _scrollOffset = scrollOffset;
+    _damage.key = key;
+    _damage.topLine = grid.scrolledLineCount() - unbox<int64_t>(scrollOffset);
+    _damage.cursorLine = grid.scrolledLineCount() + unbox<int64_t>(cursorLine);
+    _damage.lineRanges.assign(pageLineCount, RenderDamageState::LineRange {});
+    _reuseLines =
+        previous.damage.canReuseLinesFor(key) && previous.damage.lineRanges.size() == pageLineCount;
+    _compareDamagedLines = compareDamagedLines;
+}
+
+template <CellConcept Cell>
+void RenderBufferBuilder<Cell>::closeLineRange() noexcept
+{
+    if (!_openLineRange)
+        return;
+
+    auto& range = _damage.lineRanges[unbox<size_t>(*_openLineRange)];
+    range.cellsEnd = _output->cells.size();
+    range.linesEnd = _output->lines.size();
+    _openLineRange.reset();
+}
+
+template <CellConcept Cell>
+bool RenderBufferBuilder<Cell>::reuseUndamagedLine(LineOffset line)
+{
+    if (!_grid)
+        return false;
+
+    closeLineRange();
+
+    auto& range = _damage.lineRanges.at(unbox<size_t>(line));
+    range.cellsBegin = _output->cells.size();
+    range.linesBegin = _output->lines.size();
+    _openLineRange = line;
+
+    // Lines rendered now are hashed for the next refresh to compare against.
+    auto const gridOffset = line - boxed_cast<LineOffset>(_scrollOffset);
+    if (_compareDamagedLines)
+        range.contentHash = _grid->lineAt(gridOffset).contentHash();
+
+    // The grid line is taken over from wherever the page or viewport has scrolled it from.
+    auto const& previousDamage = _previous->damage;
+    auto const gridLine = _damage.topLine + unbox<int64_t>(line);
+    auto const previousLine = gridLine - previousDamage.topLine;
+    auto const previousLineCount = static_cast<int64_t>(previousDamage.lineRanges.size());
+    if (!_reuseLines || previousLine < 0 || previousLine >= previousLineCount)
+        return false;
+
+    // The cursor line is always rendered, as it may have been written to via the screen's
+    // cached current line, which bypasses the grid's damage tracking.
+    if (gridLine == _damage.cursorLine || gridLine == previousDamage.cursorLine)
+        return false;
+
+    // Damaged lines are often rewritten with the very same contents, e.g. by applications redrawing
+    // their whole page, which is why they are compared by their contents if requested.
+    auto const& previousRange = previousDamage.lineRanges[static_cast<size_t>(previousLine)];
+    if (_grid->isLineDamagedSince(gridOffset, previousDamage.damageStamp))
+    {
+        if (!range.contentHash || range.contentHash != previousRange.contentHash)
+            return false;
+    }
+    else if (!range.contentHash)
+        range.contentHash = previousRange.contentHash;
+
+    auto const lineShift = line - LineOffset::cast_from(previousLine);
+    _output->cells.appendRange(_previous->cells, previousRange.cellsBegin, previousRange.cellsEnd, lineShift);
+    auto const linesBegin = _output->lines.size();
+    _output->lines.insert(_output->lines.end(),
+                          next(_previous->lines.begin(), static_cast<ptrdiff_t>(previousRange.linesBegin)),
+                          next(_previous->lines.begin(), static_cast<ptrdiff_t>(previousRange.linesEnd)));
+    for (auto i = linesBegin; i < _output->lines.size(); ++i)
+        _output->lines[i].lineOffset += lineShift;
+    range.unmoved = lineShift == LineOffset(0);
+    return true;
+}
+
+template <CellConcept Cell>
+void RenderBufferBuilder<Cell>::finish() noexcept
+{
+    if (!_grid)
+        return;
+
+    closeLineRange();
+    _damage.valid = true;
+    _damage.damageStamp = _grid->damageStamp();
+    _output->damage = std::move(_damage);
+}
+
 template <CellConcept Cell>
 optional<RenderCursor> RenderBufferBuilder<Cell>::renderCursor() const
 {
@@ -148,91 +267,80 @@ optional<RenderCursor> RenderBufferBuilder<Cell>::renderCursor() const
 }
 
 template <CellConcept Cell>
-RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const& colorPalette,
-                                                             u32string graphemeCluster,
-                                                             ColumnCount width,
-                                                             CellFlags flags,
-                                                             RGBColor fg,
-                                                             RGBColor bg,
-                                                             Color ul,
-                                                             LineOffset line,
-                                                             ColumnOffset column)
+void RenderBufferBuilder<Cell>::decorateDetectedHyperlink(RenderAttributes& attributes,
+                                                          LineOffset line,
+                                                          ColumnOffset column) const noexcept
 {
-    auto renderCell = RenderCell {};
-    renderCell.attributes.backgroundColor = bg;
-    renderCell.attributes.foregroundColor = fg;
-    renderCell.attributes.decorationColor = CellUtil::makeUnderlineColor(colorPalette, fg, ul, flags);
-    renderCell.attributes.flags = flags;
-    renderCell.position.line = line;
-    renderCell.position.column = column;
-    renderCell.width = unbox<uint8_t>(width);
-    renderCell.codepoints = std::move(graphemeCluster);
-    return renderCell;
+    if (!_hoveringDetectedHyperlink)
+        return;
+
+    auto const gridLine = _terminal->viewport().translateScreenToGridCoordinate(line - _baseLine);
+    if (!_hoveringDetectedHyperlink->contains(CellLocation { .line = gridLine, .column = column }))
+        return;
+
+    // Detected hyperlinks are only decorated while hovered, as they are just plain text otherwise.
+    attributes.flags |= CellFlag::Underline;
+    attributes.decorationColor = _terminal->colorPalette().hyperlinkDecoration.hover;
 }
 
 template <CellConcept Cell>
-RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const& colorPalette,
-                                                             char32_t codepoint,
-                                                             CellFlags flags,
-                                                             RGBColor fg,
-                                                             RGBColor bg,
-                                                             Color ul,
-                                                             LineOffset line,
-                                                             ColumnOffset column)
+void RenderBufferBuilder<Cell>::appendRenderCellExplicit(u32string_view graphemeCluster,
+                                                         ColumnCount width,
+                                                         CellFlags flags,
+                                                         RGBColor fg,
+                                                         RGBColor bg,
+                                                         Color ul,
+                                                         LineOffset line,
+                                                         ColumnOffset column)
 {
-    RenderCell renderCell;
-    renderCell.attributes.backgroundColor = bg;
-    renderCell.attributes.foregroundColor = fg;
-    renderCell.attributes.decorationColor = CellUtil::makeUnderlineColor(colorPalette, fg, ul, flags);
-    renderCell.attributes.flags = flags;
-    renderCell.position.line = line;
-    renderCell.position.column = column;
-    renderCell.width = 1;
-    if (codepoint)
-        renderCell.codepoints.push_back(codepoint);
-    return renderCell;
+    auto attributes = RenderAttributes {};
+    attributes.backgroundColor = bg;
+    attributes.foregroundColor = fg;
+    attributes.decorationColor = CellUtil::makeUnderlineColor(_terminal->colorPalette(), fg, ul, flags);
+    attributes.flags = flags;
+    decorateDetectedHyperlink(attributes, line, column);
+    _output->cells.append(
+        CellLocation { .line = line, .column = column }, attributes, unbox<uint8_t>(width), graphemeCluster);
 }
 
 template <CellConcept Cell>
-RenderCell RenderBufferBuilder<Cell>::makeRenderCell(ColorPalette const& colorPalette,
-                                                     HyperlinkStorage const& hyperlinks,
-                                                     Cell const& screenCell,
-                                                     RGBColor fg,
-                                                     RGBColor bg,
-                                                     LineOffset line,
-                                                     ColumnOffset column)
+void RenderBufferBuilder<Cell>::appendRenderCell(Cell const& screenCell,
+                                                 RGBColor fg,
+                                                 RGBColor bg,
+                                                 LineOffset line,
+                                                 ColumnOffset column)
 {
-    RenderCell renderCell;
-    renderCell.attributes.backgroundColor = bg;
-    renderCell.attributes.foregroundColor = fg;
-    renderCell.attributes.decorationColor = CellUtil::makeUnderlineColor(colorPalette, fg, screenCell);
-    renderCell.attributes.flags = screenCell.flags();
-    renderCell.position.line = line;
-    renderCell.position.column = column;
-    renderCell.width = screenCell.width();
-
-    if (screenCell.codepointCount() != 0)
-    {
-        for (size_t i = 0; i < screenCell.codepointCount(); ++i)
-            renderCell.codepoints.push_back(screenCell.codepoint(i));
-    }
+    auto const& colorPalette = _terminal->colorPalette();
 
-    renderCell.image = screenCell.imageFragment();
+    auto attributes = RenderAttributes {};
+    attributes.backgroundColor = bg;
+    attributes.foregroundColor = fg;
+    attributes.decorationColor = CellUtil::makeUnderlineColor(colorPalette, fg, screenCell);
+    attributes.flags = screenCell.flags();
 
-    if (auto href = hyperlinks.hyperlinkById(screenCell.hyperlink()))
+    if (auto href = _terminal->hyperlinks().hyperlinkById(screenCell.hyperlink()))
     {
         auto const& color = href->state == HyperlinkState::Hover ? colorPalette.hyperlinkDecoration.hover
                                                                  : colorPalette.hyperlinkDecoration.normal;
         // TODO(decoration): Move property into Terminal.
         auto const decoration =
             href->state == HyperlinkState::Hover
-                ? CellFlag::Underline              // TODO: decorationRenderer_.hyperlinkHover()
-                : CellFlag::DottedUnderline;       // TODO: decorationRenderer_.hyperlinkNormal();
-        renderCell.attributes.flags |= decoration; // toCellStyle(decoration);
-        renderCell.attributes.decorationColor = color;
+                ? CellFlag::Underline        // TODO: decorationRenderer_.hyperlinkHover()
+                : CellFlag::DottedUnderline; // TODO: decorationRenderer_.hyperlinkNormal();
+        attributes.flags |= decoration;      // toCellStyle(decoration);
+        attributes.decorationColor = color;
     }
+    else
+        decorateDetectedHyperlink(attributes, line, column);
+
+    auto& cells = _output->cells;
+    auto const index =
+        cells.append(CellLocation { .line = line, .column = column }, attributes, screenCell.width());
+    for (size_t i = 0; i < screenCell.codepointCount(); ++i)
+        cells.appendCodepoint(screenCell.codepoint(i));
 
-    return renderCell;
+    if (auto const& fragment = screenCell.imageFragment())
+        cells.appendImageFragment(index, *fragment);
 }
 
 template <CellConcept Cell>
@@ -250,25 +358,32 @@ RGBColorPair RenderBufferBuilder<Cell>::makeColorsForCell(CellLocation gridPosit
             && _output->cursor->shape == CursorShape::Block;
     // clang-format on
 
-    auto const selected =
-        _includeSelection
-        && _terminal->isSelected(CellLocation { .line = gridPosition.line, .column = gridPosition.column });
-    auto const highlighted =
-        _terminal->isHighlighted(CellLocation { .line = gridPosition.line, .column = gridPosition.column });
-    auto const blink = _terminal->blinkState();
-    auto const rapidBlink = _terminal->rapidBlinkState();
-
-    return makeColors(_terminal->colorPalette(),
-                      cellFlags,
-                      _reverseVideo,
-                      foregroundColor,
-                      backgroundColor,
-                      selected,
-                      paintCursor,
-                      _useCursorlineColoring,
-                      highlighted,
-                      blink,
-                      rapidBlink);
+    auto const selected = isSelected(gridPosition);
+    auto const highlighted = isHighlighted(gridPosition);
+
+    auto const colors = (uint64_t { foregroundColor.content } << 32) | backgroundColor.content;
+    auto const state = (cellFlags & ColorAffectingFlags).value() | (selected ? StateSelected : 0)
+                       | (paintCursor ? StateCursor : 0) | (_useCursorlineColoring ? StateCursorLine : 0)
+                       | (highlighted ? StateHighlighted : 0) | StateUsed;
+
+    auto const hash = (colors * 0x9E37'79B9'7F4A'7C15ull) ^ (uint64_t { state } * 0xC2B2'AE3D'27D4'EB4Full);
+    auto& cached = _colorCache[static_cast<size_t>(hash >> 56) % ColorCacheSize];
+    if (cached.colors == colors && cached.state == state)
+        return cached.rgb;
+
+    auto const rgb = makeColors(_terminal->colorPalette(),
+                                cellFlags,
+                                _reverseVideo,
+                                foregroundColor,
+                                backgroundColor,
+                                selected,
+                                paintCursor,
+                                _useCursorlineColoring,
+                                highlighted,
+                                _terminal->blinkState(),
+                                _terminal->rapidBlinkState());
+    cached = ResolvedColors { .colors = colors, .state = state, .rgb = rgb };
+    return rgb;
 }
 
 template <CellConcept Cell>
@@ -345,8 +460,10 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TrivialLineBuffer const& lineB
     // which affects background/foreground color again.
     // We're not testing for cursor shape (which should be done in order to be 100% correct)
     // because it's not really draining performance.
+    auto const gridLine = _terminal->viewport().translateScreenToGridCoordinate(lineOffset);
     bool const canRenderViaSimpleLine =
-        (!_terminal->isSelected(lineOffset) || !_includeSelection) && !gridLineContainsCursor(lineOffset);
+        !selectedColumns(gridLine) && !gridLineContainsCursor(lineOffset)
+        && !(_hoveringDetectedHyperlink && _hoveringDetectedHyperlink->line == gridLine);
 
     if (canRenderViaSimpleLine)
     {
@@ -375,21 +492,21 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TrivialLineBuffer const& lineB
         auto const gridPosition = _terminal->viewport().translateScreenToGridCoordinate(pos);
         auto renderAttributes = createRenderAttributes(gridPosition, lineBuffer.fillAttributes);
 
-        _output->cells.emplace_back(makeRenderCellExplicit(_terminal->colorPalette(),
-                                                           char32_t { 0 },
-                                                           lineBuffer.fillAttributes.flags,
-                                                           renderAttributes.foregroundColor,
-                                                           renderAttributes.backgroundColor,
-                                                           lineBuffer.fillAttributes.underlineColor,
-                                                           _baseLine + lineOffset,
-                                                           columnOffset));
+        appendRenderCellExplicit(u32string_view {},
+                                 ColumnCount(1),
+                                 lineBuffer.fillAttributes.flags,
+                                 renderAttributes.foregroundColor,
+                                 renderAttributes.backgroundColor,
+                                 lineBuffer.fillAttributes.underlineColor,
+                                 _baseLine + lineOffset,
+                                 columnOffset);
     }
     // }}}
 
     auto const backIndex = _output->cells.size() - 1;
 
-    _output->cells[frontIndex].groupStart = true;
-    _output->cells[backIndex].groupEnd = true;
+    _output->cells.markGroupStart(frontIndex);
+    _output->cells.markGroupEnd(backIndex);
 }
 
 template <CellConcept Cell>
@@ -400,7 +517,7 @@ void RenderBufferBuilder<Cell>::matchSearchPattern(T const& cellText)
         return;
 
     auto const& search = _terminal->search();
-    if (search.pattern.empty())
+    if (search.pattern.empty() || search.mode != SearchMode::Literal)
         return;
 
     auto const searchText = u32string_view(search.pattern.data() + _searchPatternOffset,
@@ -433,8 +550,8 @@ void RenderBufferBuilder<Cell>::matchSearchPattern(T const& cellText)
 
     auto const isFocusedMatch =
         CellLocationRange {
-            .first = _output->cells[offsetIntoFront].position,
-            .second = _output->cells.back().position,
+            .first = _output->cells.positions[offsetIntoFront],
+            .second = _output->cells.positions.back(),
         }
             .contains(
                 _terminal->viewport().translateGridToScreenCoordinate(_terminal->normalModeCursorPosition()));
@@ -459,7 +576,7 @@ void RenderBufferBuilder<Cell>::matchSearchPattern(T const& cellText)
 
     for (size_t i = offsetIntoFront; i < _output->cells.size(); ++i)
     {
-        auto& cellAttributes = _output->cells[i].attributes;
+        auto& cellAttributes = _output->cells.attributes[i];
         auto const actualColors = RGBColorPair { .foreground = cellAttributes.foregroundColor,
                                                  .background = cellAttributes.backgroundColor };
         auto const searchMatchColors = makeRGBColorPair(actualColors, highlightColors);
@@ -496,7 +613,7 @@ void RenderBufferBuilder<Cell>::endLine() noexcept
 {
     if (!_output->cells.empty())
     {
-        _output->cells.back().groupEnd = true;
+        _output->cells.markGroupEnd(_output->cells.size() - 1);
     }
 }
 
@@ -524,22 +641,19 @@ ColumnCount RenderBufferBuilder<Cell>::renderUtf8Text(CellLocation screenPositio
         //            unicode::convert_to<char>(u32string_view(graphemeCluster)).size(),
         //            unicode::convert_to<char>(u32string_view(graphemeCluster)));
 
-        _output->cells.emplace_back(
-            makeRenderCellExplicit(_terminal->colorPalette(),
-                                   graphemeCluster,
-                                   width,
-                                   textAttributes.flags,
-                                   fg,
-                                   bg,
-                                   textAttributes.underlineColor,
-                                   _baseLine + screenPosition.line,
-                                   screenPosition.column + ColumnOffset::cast_from(columnCountRendered)));
+        appendRenderCellExplicit(graphemeCluster,
+                                 width,
+                                 textAttributes.flags,
+                                 fg,
+                                 bg,
+                                 textAttributes.underlineColor,
+                                 _baseLine + screenPosition.line,
+                                 screenPosition.column + ColumnOffset::cast_from(columnCountRendered));
 
         // Span filling cells for preciding wide glyphs to get the background color properly painted.
         for (auto i = ColumnCount(1); i < width; ++i)
         {
-            _output->cells.emplace_back(makeRenderCellExplicit(
-                _terminal->colorPalette(),
+            appendRenderCellExplicit(
                 U" ", // {}
                 ColumnCount(1),
                 textAttributes.flags,
@@ -547,7 +661,7 @@ ColumnCount RenderBufferBuilder<Cell>::renderUtf8Text(CellLocation screenPositio
                 bg,
                 textAttributes.underlineColor,
                 _baseLine + screenPosition.line,
-                screenPosition.column + ColumnOffset::cast_from(columnCountRendered + i)));
+                screenPosition.column + ColumnOffset::cast_from(columnCountRendered + i));
         }
 
         columnCountRendered += ColumnCount::cast_from(width);
@@ -575,16 +689,15 @@ bool RenderBufferBuilder<Cell>::tryRenderInputMethodEditor(CellLocation screenPo
         textAttributes.flags.enable({ CellFlag::Bold, CellFlag::Underline });
 
         if (!_output->cells.empty())
-            _output->cells.back().groupEnd = true;
+            _output->cells.markGroupEnd(_output->cells.size() - 1);
 
         _inputMethodSkipColumns =
             renderUtf8Text(screenPosition, textAttributes, _inputMethodData.preeditString, false);
         if (_inputMethodSkipColumns > ColumnCount(0))
         {
             _output->cursor->position.column += ColumnOffset::cast_from(_inputMethodSkipColumns);
-            _output->cells.at(_output->cells.size() - unbox<size_t>(_inputMethodSkipColumns)).groupStart =
-                true;
-            _output->cells.back().groupEnd = true;
+            _output->cells.markGroupStart(_output->cells.size() - unbox<size_t>(_inputMethodSkipColumns));
+            _output->cells.markGroupEnd(_output->cells.size() - 1);
         }
     }
 
@@ -611,11 +724,10 @@ void RenderBufferBuilder<Cell>::renderCell(Cell const& screenCell, LineOffset li
     _prevWidth = screenCell.width();
     _prevHasCursor = _cursorPosition && gridPosition == *_cursorPosition;
 
-    _output->cells.emplace_back(makeRenderCell(
-        _terminal->colorPalette(), _terminal->hyperlinks(), screenCell, fg, bg, _baseLine + line, column));
+    appendRenderCell(screenCell, fg, bg, _baseLine + line, column);
 
     if (column == ColumnOffset(0))
-        _output->cells.back().groupStart = true;
+        _output->cells.markGroupStart(_output->cells.size() - 1);
 
     matchSearchPattern(screenCell);
 }
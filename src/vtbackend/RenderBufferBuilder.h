@@ -9,7 +9,9 @@
 
 #include <gsl/pointers>
 
+#include <array>
 #include <optional>
+#include <vector>
 
 namespace vtbackend
 {
@@ -52,40 +54,87 @@ class RenderBufferBuilder
     void renderTrivialLine(TrivialLineBuffer const& lineBuffer, LineOffset lineOffset);
 
     /// This call is guaranteed to be invoked when the the full page has been rendered.
-    void finish() noexcept {}
+    void finish() noexcept;
+
+    /// Enables taking over undamaged lines from the previous contents of the render buffer.
+    ///
+    /// @param previous   the render buffer's contents as of its previous refresh
+    /// @param grid       the grid of the page being rendered
+    /// @param key        the state the page is going to be rendered with
+    /// @param cursorLine   the line the screen's cursor is currently on
+    /// @param scrollOffset the viewport's scroll offset the page is rendered at
+    /// @param compareDamagedLines whether damaged lines are compared by their contents, and taken over
+    ///                            as well if unchanged, e.g. as applications rewrite whole pages
+    ///                            with synchronized output
+    void trackDamage(RenderBuffer& previous,
+                     Grid<Cell> const& grid,
+                     RenderDamageState::Key const& key,
+                     LineOffset cursorLine,
+                     ScrollOffset scrollOffset,
+                     bool compareDamagedLines = false);
+
+    /// Invoked before rendering each line of the page, in order.
+    ///
+    /// Moves the line's cells over from the previous contents of the render buffer, from wherever
+    /// the line was shown before scrolling, unless the line has been damaged since (and, if comparing
+    /// damaged lines, its contents differ from what has been rendered), contains the cursor,
+    /// or has not been shown at all.
+    ///
+    /// @returns true if the line has been taken over and must not be rendered again.
+    [[nodiscard]] bool reuseUndamagedLine(LineOffset line);
 
   private:
+    void closeLineRange() noexcept;
+
     [[nodiscard]] bool isCursorLine(LineOffset line) const noexcept;
 
+    /// Returns the range of the given grid line within @p ranges, holding one range for each line
+    /// of a contiguous block of lines, or nullptr if the line is not covered.
+    [[nodiscard]] static ColumnRange const* rangeOfLine(std::vector<ColumnRange> const& ranges,
+                                                        LineOffset gridLine) noexcept
+    {
+        if (ranges.empty() || gridLine < ranges.front().line || gridLine > ranges.back().line)
+            return nullptr;
+        return &ranges[unbox<size_t>(gridLine - ranges.front().line)];
+    }
+
+    /// Returns the selected columns of the given grid line, if any are to be rendered as selected.
+    [[nodiscard]] ColumnRange const* selectedColumns(LineOffset gridLine) const noexcept
+    {
+        return rangeOfLine(_selectedRanges, gridLine);
+    }
+
+    [[nodiscard]] bool isSelected(CellLocation gridPosition) const noexcept
+    {
+        auto const* range = selectedColumns(gridPosition.line);
+        return range && range->contains(gridPosition);
+    }
+
+    [[nodiscard]] bool isHighlighted(CellLocation gridPosition) const noexcept
+    {
+        auto const* range = rangeOfLine(_highlightedRanges, gridPosition.line);
+        return range && range->contains(gridPosition);
+    }
+
     [[nodiscard]] std::optional<RenderCursor> renderCursor() const;
 
-    [[nodiscard]] static RenderCell makeRenderCellExplicit(ColorPalette const& colorPalette,
-                                                           std::u32string graphemeCluster,
-                                                           ColumnCount width,
-                                                           CellFlags flags,
-                                                           RGBColor fg,
-                                                           RGBColor bg,
-                                                           Color ul,
-                                                           LineOffset line,
-                                                           ColumnOffset column);
-
-    [[nodiscard]] static RenderCell makeRenderCellExplicit(ColorPalette const& colorPalette,
-                                                           char32_t codepoint,
-                                                           CellFlags flags,
-                                                           RGBColor fg,
-                                                           RGBColor bg,
-                                                           Color ul,
-                                                           LineOffset line,
-                                                           ColumnOffset column);
-
-    /// Constructs a RenderCell for the given screen Cell.
-    [[nodiscard]] static RenderCell makeRenderCell(ColorPalette const& colorPalette,
-                                                   HyperlinkStorage const& hyperlinks,
-                                                   Cell const& cell,
-                                                   RGBColor fg,
-                                                   RGBColor bg,
-                                                   LineOffset line,
-                                                   ColumnOffset column);
+    /// Underlines the cell at the given output position if it is part of the hovered detected hyperlink.
+    void decorateDetectedHyperlink(RenderAttributes& attributes,
+                                   LineOffset line,
+                                   ColumnOffset column) const noexcept;
+
+    /// Appends a render cell with the given grapheme cluster and attributes to the output.
+    void appendRenderCellExplicit(std::u32string_view graphemeCluster,
+                                  ColumnCount width,
+                                  CellFlags flags,
+                                  RGBColor fg,
+                                  RGBColor bg,
+                                  Color ul,
+                                  LineOffset line,
+                                  ColumnOffset column);
+
+    /// Appends the render cell for the given screen Cell to the output.
+    void appendRenderCell(Cell const& cell, RGBColor fg, RGBColor bg, LineOffset line, ColumnOffset column);
 
     /// Constructs the final foreground/background colors to be displayed on the screen.
     ///
@@ -128,6 +177,11 @@ class RenderBufferBuilder
     HighlightSearchMatches _highlightSearchMatches;
     InputMethodData _inputMethodData;
     bool _includeSelection;
+    // The selected and highlighted columns on each of the page's grid lines they cover, taken once
+    // per frame, rather than asking the selection and highlight about every single cell.
+    std::vector<ColumnRange> _selectedRanges;
+    std::vector<ColumnRange> _highlightedRanges;
+    std::optional<ColumnRange> _hoveringDetectedHyperlink;
     ColumnCount _inputMethodSkipColumns = ColumnCount(0);
 
     int _prevWidth = 0;
@@ -137,6 +191,27 @@ class RenderBufferBuilder
 
     // Offset into the search pattern that has been already matched.
     size_t _searchPatternOffset = 0;
+
+    // Colors resolved by makeColorsForCell() so far. Within a frame, these only depend on the cell's
+    // SGR colors and flags as well as its highlighting state, so that a builder (living for a single
+    // frame) never needs to invalidate them on palette, blink, or focus changes.
+    struct ResolvedColors
+    {
+        uint64_t colors = 0; // SGR foreground and background color
+        uint32_t state = 0;  // color-affecting cell flags and highlighting state, 0 if unused
+        RGBColorPair rgb {};
+    };
+    static constexpr size_t ColorCacheSize = 256;
+    mutable std::array<ResolvedColors, ColorCacheSize> _colorCache {};
+
+    // Damage tracking state, only set for builders of the main page (see trackDamage()).
+    RenderBuffer* _previous = nullptr;
+    Grid<Cell> const* _grid = nullptr;
+    ScrollOffset _scrollOffset {};
+    RenderDamageState _damage;
+    bool _reuseLines = false;
+    bool _compareDamagedLines = false;
+    std::optional<LineOffset> _openLineRange;
 };
 
 } // namespace vtbackend
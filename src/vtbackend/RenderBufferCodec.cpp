@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/RenderBufferCodec.h>
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+using std::string;
+using std::string_view;
+
+namespace vtbackend
+{
+
+namespace
+{
+    // Message magic, including the format version in its last byte.
+    constexpr auto Magic = string_view("CTRB\1", 5);
+
+    enum class LineTag : uint8_t
+    {
+        Unchanged = 0, ///< Same as the line at the same offset of the previous frame.
+        Moved = 1,     ///< Same as the line at the given offset of the previous frame.
+        Encoded = 2,   ///< Followed by the encoded line.
+    };
+
+    enum CellHeader : uint8_t
+    {
+        GroupMarkMask = 0x03,    ///< RenderCells::GroupMark bits of the cell.
+        AttributesFollow = 0x04, ///< The cell's attributes differ from the previous cell's in its line.
+    };
+
+    void writeVarUInt(string& output, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            output += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        output += static_cast<char>(value);
+    }
+
+    void writeColor(string& output, RGBColor color)
+    {
+        output += static_cast<char>(color.red);
+        output += static_cast<char>(color.green);
+        output += static_cast<char>(color.blue);
+    }
+
+    void writeAttributes(string& output, RenderAttributes const& attributes)
+    {
+        writeColor(output, attributes.foregroundColor);
+        writeColor(output, attributes.backgroundColor);
+        writeColor(output, attributes.decorationColor);
+        writeVarUInt(output, attributes.flags.value());
+    }
+
+    class Reader
+    {
+      public:
+        explicit Reader(string_view input) noexcept: _input { input } {}
+
+        [[nodiscard]] bool atEnd() const noexcept { return _offset == _input.size(); }
+
+        [[nodiscard]] std::optional<uint8_t> byte() noexcept
+        {
+            if (atEnd())
+                return std::nullopt;
+            return static_cast<uint8_t>(_input[_offset++]);
+        }
+
+        [[nodiscard]] std::optional<uint64_t> varUInt() noexcept
+        {
+            auto value = uint64_t { 0 };
+            for (auto shift = 0; shift < 64; shift += 7)
+            {
+                auto const next = byte();
+                if (!next)
+                    return std::nullopt;
+                value |= static_cast<uint64_t>(*next & 0x7F) << shift;
+                if (!(*next & 0x80))
+                    return value;
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] std::optional<string_view> bytes(uint64_t count) noexcept
+        {
+            if (_input.size() - _offset < count)
+                return std::nullopt;
+            auto const result = _input.substr(_offset, count);
+            _offset += count;
+            return result;
+        }
+
+        [[nodiscard]] std::optional<RGBColor> color() noexcept
+        {
+            auto const data = bytes(3);
+            if (!data)
+                return std::nullopt;
+            return RGBColor(static_cast<uint8_t>((*data)[0]),
+                            static_cast<uint8_t>((*data)[1]),
+                            static_cast<uint8_t>((*data)[2]));
+        }
+
+        [[nodiscard]] std::optional<RenderAttributes> attributes() noexcept
+        {
+            auto const foreground = color();
+            auto const background = color();
+            auto const decoration = color();
+            auto const flags = varUInt();
+            if (!foreground || !background || !decoration || !flags)
+                return std::nullopt;
+            return RenderAttributes {
+                .foregroundColor = *foreground,
+                .backgroundColor = *background,
+                .decorationColor = *decoration,
+                .flags = CellFlags::from_value(static_cast<CellFlags::value_type>(*flags)),
+            };
+        }
+
+      private:
+        string_view _input;
+        size_t _offset = 0;
+    };
+
+    /// Encoding of a single page line, while being collected from the render buffer.
+    struct LineEncoding
+    {
+        string cells;
+        uint64_t cellCount = 0;
+        RenderAttributes attributes {};
+        string trivialLines;
+        uint64_t trivialLineCount = 0;
+    };
+
+    [[nodiscard]] std::vector<string> encodeLines(RenderBuffer const& buffer)
+    {
+        auto encodings = std::vector<LineEncoding> {};
+        auto const lineAt = [&](LineOffset line) -> LineEncoding& {
+            auto const index = static_cast<size_t>(std::max(unbox(line), 0));
+            if (index >= encodings.size())
+                encodings.resize(index + 1);
+            return encodings[index];
+        };
+
+        auto const& cells = buffer.cells;
+        for (auto i = size_t { 0 }; i < cells.size(); ++i)
+        {
+            auto& line = lineAt(cells.positions[i].line);
+            auto const& attributes = cells.attributes[i];
+            auto const attributesFollow = line.cellCount == 0 || attributes != line.attributes;
+            line.cells += static_cast<char>((cells.groupMarks[i] & GroupMarkMask)
+                                            | (attributesFollow ? AttributesFollow : 0));
+            writeVarUInt(line.cells, static_cast<uint64_t>(std::max(unbox(cells.positions[i].column), 0)));
+            line.cells += static_cast<char>(cells.widths[i]);
+            if (attributesFollow)
+                writeAttributes(line.cells, attributes);
+            auto const codepoints = cells.codepoints(i);
+            writeVarUInt(line.cells, codepoints.size());
+            for (auto const codepoint: codepoints)
+                writeVarUInt(line.cells, codepoint);
+            line.attributes = attributes;
+            ++line.cellCount;
+        }
+
+        for (auto const& trivialLine: buffer.lines)
+        {
+            auto& line = lineAt(trivialLine.lineOffset);
+            writeVarUInt(line.trivialLines, unbox<uint64_t>(trivialLine.usedColumns));
+            writeVarUInt(line.trivialLines, unbox<uint64_t>(trivialLine.displayWidth));
+            writeAttributes(line.trivialLines, trivialLine.textAttributes);
+            writeAttributes(line.trivialLines, trivialLine.fillAttributes);
+            writeVarUInt(line.trivialLines, trivialLine.text.size());
+            line.trivialLines += trivialLine.text;
+            ++line.trivialLineCount;
+        }
+
+        auto lines = std::vector<string>(encodings.size());
+        for (auto i = size_t { 0 }; i < encodings.size(); ++i)
+        {
+            auto& encoded = lines[i];
+            writeVarUInt(encoded, encodings[i].cellCount);
+            encoded += encodings[i].cells;
+            writeVarUInt(encoded, encodings[i].trivialLineCount);
+            encoded += encodings[i].trivialLines;
+        }
+        return lines;
+    }
+
+    [[nodiscard]] bool decodeLine(string_view encoded, LineOffset lineOffset, RenderBuffer& buffer)
+    {
+        auto input = Reader(encoded);
+
+        auto const cellCount = input.varUInt();
+        if (!cellCount)
+            return false;
+        auto attributes = RenderAttributes {};
+        for (auto i = uint64_t { 0 }; i < *cellCount; ++i)
+        {
+            auto const header = input.byte();
+            auto const column = input.varUInt();
+            auto const width = input.byte();
+            if (!header || !column || !width)
+                return false;
+            if (*header & AttributesFollow)
+            {
+                auto const cellAttributes = input.attributes();
+                if (!cellAttributes)
+                    return false;
+                attributes = *cellAttributes;
+            }
+            auto const codepointCount = input.varUInt();
+            if (!codepointCount)
+                return false;
+
+            auto const index = buffer.cells.append(
+                CellLocation { .line = lineOffset, .column = ColumnOffset::cast_from(*column) },
+                attributes,
+                *width);
+            buffer.cells.groupMarks[index] = *header & GroupMarkMask;
+            for (auto k = uint64_t { 0 }; k < *codepointCount; ++k)
+            {
+                auto const codepoint = input.varUInt();
+                if (!codepoint)
+                    return false;
+                buffer.cells.appendCodepoint(static_cast<char32_t>(*codepoint));
+            }
+        }
+
+        auto const trivialLineCount = input.varUInt();
+        if (!trivialLineCount)
+            return false;
+        for (auto i = uint64_t { 0 }; i < *trivialLineCount; ++i)
+        {
+            auto const usedColumns = input.varUInt();
+            auto const displayWidth = input.varUInt();
+            auto const textAttributes = input.attributes();
+            auto const fillAttributes = input.attributes();
+            auto const textSize = input.varUInt();
+            if (!textSize)
+                return false;
+            auto const text = input.bytes(*textSize);
+            if (!text || !usedColumns || !displayWidth || !textAttributes || !fillAttributes)
+                return false;
+            buffer.lines.emplace_back(RenderLine {
+                .text = *text,
+                .lineOffset = lineOffset,
+                .usedColumns = ColumnCount::cast_from(*usedColumns),
+                .displayWidth = ColumnCount::cast_from(*displayWidth),
+                .textAttributes = *textAttributes,
+                .fillAttributes = *fillAttributes,
+            });
+        }
+
+        return input.atEnd();
+    }
+} // namespace
+
+string RenderBufferEncoder::encode(RenderBuffer const& buffer)
+{
+    auto lines = encodeLines(buffer);
+
+    auto message = string(Magic);
+    writeVarUInt(message, buffer.frameID);
+    message += static_cast<char>(buffer.cursor.has_value());
+    if (buffer.cursor)
+    {
+        writeVarUInt(message, static_cast<uint64_t>(std::max(unbox(buffer.cursor->position.line), 0)));
+        writeVarUInt(message, static_cast<uint64_t>(std::max(unbox(buffer.cursor->position.column), 0)));
+        message += static_cast<char>(buffer.cursor->shape);
+        writeVarUInt(message, static_cast<uint64_t>(std::max(buffer.cursor->width, 0)));
+    }
+
+    auto previousLines = std::unordered_map<string_view, size_t> {};
+    for (auto i = _lines.size(); i-- > 0;)
+        previousLines[_lines[i]] = i;
+
+    writeVarUInt(message, lines.size());
+    for (auto i = size_t { 0 }; i < lines.size(); ++i)
+    {
+        if (i < _lines.size() && _lines[i] == lines[i])
+            message += static_cast<char>(LineTag::Unchanged);
+        else if (auto const previous = previousLines.find(lines[i]); previous != previousLines.end())
+        {
+            message += static_cast<char>(LineTag::Moved);
+            writeVarUInt(message, previous->second);
+        }
+        else
+        {
+            message += static_cast<char>(LineTag::Encoded);
+            writeVarUInt(message, lines[i].size());
+            message += lines[i];
+        }
+    }
+
+    _lines = std::move(lines);
+    return message;
+}
+
+bool RenderBufferDecoder::decode(string_view message, RenderBuffer& buffer)
+{
+    if (!message.starts_with(Magic))
+        return false;
+    auto input = Reader(message.substr(Magic.size()));
+
+    auto const frameID = input.varUInt();
+    auto const hasCursor = input.byte();
+    if (!frameID || !hasCursor)
+        return false;
+
+    auto cursor = std::optional<RenderCursor> {};
+    if (*hasCursor)
+    {
+        auto const line = input.varUInt();
+        auto const column = input.varUInt();
+        auto const shape = input.byte();
+        auto const width = input.varUInt();
+        if (!line || !column || !shape || !width || *shape > static_cast<uint8_t>(CursorShape::Bar))
+            return false;
+        cursor = RenderCursor {
+            .position = CellLocation { .line = LineOffset::cast_from(*line),
+                                       .column = ColumnOffset::cast_from(*column) },
+            .shape = static_cast<CursorShape>(*shape),
+            .width = static_cast<int>(*width),
+        };
+    }
+
+    auto const lineCount = input.varUInt();
+    if (!lineCount)
+        return false;
+    auto contentChanged = *lineCount != _lines.size();
+    auto lines = std::vector<string> {};
+    for (auto i = uint64_t { 0 }; i < *lineCount; ++i)
+    {
+        auto const tag = input.byte();
+        if (!tag)
+            return false;
+        switch (static_cast<LineTag>(*tag))
+        {
+            case LineTag::Unchanged:
+                if (i >= _lines.size())
+                    return false;
+                lines.emplace_back(_lines[i]);
+                break;
+            case LineTag::Moved: {
+                auto const previous = input.varUInt();
+                if (!previous || *previous >= _lines.size())
+                    return false;
+                lines.emplace_back(_lines[*previous]);
+                contentChanged = true;
+                break;
+            }
+            case LineTag::Encoded: {
+                auto const size = input.varUInt();
+                if (!size)
+                    return false;
+                auto const encoded = input.bytes(*size);
+                if (!encoded)
+                    return false;
+                lines.emplace_back(*encoded);
+                contentChanged = true;
+                break;
+            }
+            default: return false;
+        }
+    }
+    if (!input.atEnd())
+        return false;
+
+    _lines = std::move(lines);
+    if (contentChanged)
+        _contentFrameID = *frameID;
+
+    buffer.clear();
+    for (auto i = size_t { 0 }; i < _lines.size(); ++i)
+        if (!decodeLine(_lines[i], LineOffset::cast_from(i), buffer))
+            return false;
+    buffer.cursor = cursor;
+    buffer.frameID = *frameID;
+    buffer.contentFrameID = _contentFrameID;
+    return true;
+}
+
+} // namespace vtbackend
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/RenderBuffer.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Encodes consecutive render buffers into compact messages, such that a remote client can draw
+ * them with a Renderer of its own, without parsing any VT sequences.
+ *
+ * Each page line is encoded on its own. Lines that look as they did in the previously encoded frame
+ * are only referred to, even if they were shown on another line of the page, so that neither
+ * repainting the same page nor scrolling it resends lines the client already has.
+ *
+ * Image fragments are not transmitted.
+ *
+ * @see RenderBufferDecoder
+ */
+class RenderBufferEncoder
+{
+  public:
+    /// Encodes @p buffer relative to the buffer encoded before.
+    [[nodiscard]] std::string encode(RenderBuffer const& buffer);
+
+    /// Makes the next frame be encoded in full, e.g. when a client (re)attaches.
+    void reset() noexcept { _lines.clear(); }
+
+  private:
+    std::vector<std::string> _lines; // encoded lines of the most recent frame, by page line
+};
+
+/**
+ * Decodes the messages of a RenderBufferEncoder back into render buffers.
+ */
+class RenderBufferDecoder
+{
+  public:
+    /// Decodes @p message into @p buffer, reusing the lines decoded from the previous message.
+    ///
+    /// The texts of the trivial lines in @p buffer refer to the decoder's storage and remain valid
+    /// until the next call.
+    ///
+    /// @returns false if @p message is malformed, in which case the encoder needs to be reset.
+    [[nodiscard]] bool decode(std::string_view message, RenderBuffer& buffer);
+
+  private:
+    std::vector<std::string> _lines; // encoded lines of the most recent frame, by page line
+    uint64_t _contentFrameID = 0;
+};
+
+} // namespace vtbackend
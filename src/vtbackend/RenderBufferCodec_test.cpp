@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/RenderBufferCodec.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+
+using namespace vtbackend;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+auto const Red = RenderAttributes { .foregroundColor = RGBColor(0xFF, 0, 0),
+                                    .backgroundColor = {},
+                                    .decorationColor = {},
+                                    .flags = CellFlag::Bold };
+
+CellLocation at(int line, int column)
+{
+    return CellLocation { .line = LineOffset(line), .column = ColumnOffset(column) };
+}
+
+RenderLine trivialLine(std::string_view text, int line)
+{
+    return RenderLine { .text = text,
+                        .lineOffset = LineOffset(line),
+                        .usedColumns = ColumnCount::cast_from(text.size()),
+                        .displayWidth = ColumnCount(80),
+                        .textAttributes = Red,
+                        .fillAttributes = {} };
+}
+
+void requireEqual(RenderBuffer const& decoded, RenderBuffer const& expected)
+{
+    CHECK(decoded.cells == expected.cells);
+    CHECK(decoded.lines == expected.lines);
+    REQUIRE(decoded.cursor.has_value() == expected.cursor.has_value());
+    if (expected.cursor)
+    {
+        CHECK(decoded.cursor->position == expected.cursor->position);
+        CHECK(decoded.cursor->shape == expected.cursor->shape);
+        CHECK(decoded.cursor->width == expected.cursor->width);
+    }
+    CHECK(decoded.frameID == expected.frameID);
+}
+
+} // namespace
+
+TEST_CASE("RenderBufferCodec.roundtrip", "[RenderBuffer]")
+{
+    auto buffer = RenderBuffer {};
+    buffer.frameID = 7;
+    buffer.cells.append(at(0, 0), Red, 1, U"a");
+    buffer.cells.append(at(0, 1), Red, 2, U"❤️");
+    buffer.cells.append(at(0, 3), RenderAttributes {}, 1);
+    buffer.cells.markGroupStart(0);
+    buffer.cells.markGroupEnd(1);
+    buffer.lines.push_back(trivialLine("hello", 1));
+    buffer.cursor = RenderCursor { .position = at(1, 5), .shape = CursorShape::Bar, .width = 1 };
+
+    auto encoder = RenderBufferEncoder {};
+    auto decoder = RenderBufferDecoder {};
+    auto decoded = RenderBuffer {};
+    REQUIRE(decoder.decode(encoder.encode(buffer), decoded));
+    requireEqual(decoded, buffer);
+    CHECK(decoded.contentFrameID == 7);
+
+    // Only the cursor moved.
+    buffer.frameID = 8;
+    buffer.cursor->position = at(0, 0);
+    REQUIRE(decoder.decode(encoder.encode(buffer), decoded));
+    requireEqual(decoded, buffer);
+    CHECK(decoded.contentFrameID == 7);
+
+    CHECK(!decoder.decode("CTRB"sv, decoded));
+}
+
+TEST_CASE("RenderBufferCodec.scrolled_lines_are_referenced", "[RenderBuffer]")
+{
+    auto const page = [](std::string_view const (&texts)[3], uint64_t frameID) {
+        auto buffer = RenderBuffer {};
+        buffer.frameID = frameID;
+        for (auto i = 0; i < 3; ++i)
+            buffer.lines.push_back(trivialLine(texts[i], i));
+        return buffer;
+    };
+    auto const longText = std::string(200, 'x');
+    std::string_view const first[3] = { "first line", longText, "third line" };
+    std::string_view const scrolled[3] = { longText, "third line", "fourth line" };
+
+    auto encoder = RenderBufferEncoder {};
+    auto decoder = RenderBufferDecoder {};
+    auto decoded = RenderBuffer {};
+    auto const full = encoder.encode(page(first, 1));
+    REQUIRE(decoder.decode(full, decoded));
+
+    auto const delta = encoder.encode(page(scrolled, 2));
+    CHECK(delta.size() < longText.size() / 2);
+    REQUIRE(decoder.decode(delta, decoded));
+    requireEqual(decoded, page(scrolled, 2));
+    CHECK(decoded.contentFrameID == 2);
+
+    // A client attaching anew gets the frame in full.
+    encoder.reset();
+    auto const reattached = encoder.encode(page(scrolled, 3));
+    CHECK(reattached.size() > full.size() / 2);
+    auto freshDecoder = RenderBufferDecoder {};
+    REQUIRE(freshDecoder.decode(reattached, decoded));
+    requireEqual(decoded, page(scrolled, 3));
+}
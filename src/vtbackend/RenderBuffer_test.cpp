@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/RenderBuffer.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+
+using namespace vtbackend;
+
+TEST_CASE("RenderTripleBuffer.handoff", "[RenderBuffer]")
+{
+    auto constexpr Now = std::chrono::steady_clock::time_point();
+    auto tripleBuffer = RenderTripleBuffer {};
+
+    auto const publish = [&](uint64_t frameID) {
+        tripleBuffer.backBuffer().frameID = frameID;
+        tripleBuffer.swapBuffers(Now);
+    };
+
+    publish(1);
+    auto const first = tripleBuffer.frontBuffer();
+    CHECK(first.get().frameID == 1);
+
+    // The writer keeps going while the reader still holds on to its buffer,
+    // never being handed the buffer in use by the reader.
+    publish(2);
+    CHECK(&tripleBuffer.backBuffer() != &first.get());
+    publish(3);
+    CHECK(&tripleBuffer.backBuffer() != &first.get());
+    CHECK(first.get().frameID == 1);
+
+    // The reader skips frame 2 and gets the latest completed one.
+    CHECK(tripleBuffer.frontBuffer().get().frameID == 3);
+
+    // Without any new frame, the reader keeps the current one.
+    CHECK(tripleBuffer.frontBuffer().get().frameID == 3);
+}
+
+TEST_CASE("RenderCells.appendRange", "[RenderBuffer]")
+{
+    auto const at = [](int column) {
+        return CellLocation { .line = LineOffset(0), .column = ColumnOffset(column) };
+    };
+
+    auto previous = RenderCells {};
+    previous.append(at(0), RenderAttributes {}, 1, U"a");
+    previous.append(at(1), RenderAttributes {}, 2, U"b️");
+    previous.append(at(3), RenderAttributes {}, 1);
+    previous.append(at(4), RenderAttributes {}, 1, U"c");
+    previous.markGroupEnd(3);
+    previous.images.push_back(RenderImage { .cell = 2 });
+
+    auto cells = RenderCells {};
+    cells.append(at(0), RenderAttributes {}, 1, U"x");
+    cells.appendRange(previous, 1, 4);
+
+    REQUIRE(cells.size() == 4);
+    CHECK(cells.codepoints(0) == U"x");
+    CHECK(cells.codepoints(1) == U"b️");
+    CHECK(cells.codepoints(2).empty());
+    CHECK(cells.codepoints(3) == U"c");
+    CHECK(cells.positions[2] == at(3));
+    CHECK(cells.widths[1] == 2);
+    CHECK(!cells.isGroupEnd(2));
+    CHECK(cells.isGroupEnd(3));
+    REQUIRE(cells.images.size() == 1);
+    CHECK(cells.images[0].cell == 3);
+}
+
+TEST_CASE("RenderCells.imageRuns", "[RenderBuffer]")
+{
+    auto const at = [](int line, int column) {
+        return CellLocation { .line = LineOffset(line), .column = ColumnOffset(column) };
+    };
+
+    auto pool = ImagePool {};
+    auto const image = pool.create(ImageFormat::RGBA, ImageSize { Width(4), Height(2) }, Image::Data(32));
+    auto const rasterized =
+        std::make_shared<RasterizedImage>(image,
+                                          ImageAlignment::TopStart,
+                                          ImageResize::NoResize,
+                                          RGBAColor {},
+                                          GridSize { .lines = LineCount(2), .columns = ColumnCount(4) },
+                                          ImageSize { Width(1), Height(1) });
+    auto cells = RenderCells {};
+    auto const appendImageCell = [&](CellLocation position, CellLocation offset) {
+        auto const index = cells.append(position, RenderAttributes {}, 1);
+        cells.appendImageFragment(index, ImageFragment(rasterized, offset));
+    };
+
+    // Each row of the image is a run of its own, and so is each part of a row interrupted by text.
+    for (auto column = 0; column < 4; ++column)
+        appendImageCell(at(0, column), at(0, column));
+    appendImageCell(at(1, 0), at(1, 0));
+    appendImageCell(at(1, 1), at(1, 1));
+    cells.append(at(1, 2), RenderAttributes {}, 1, U"x");
+    appendImageCell(at(1, 3), at(1, 3));
+
+    REQUIRE(cells.images.size() == 3);
+    CHECK(cells.images[0] == RenderImage { .cell = 0, .span = 4, .offset = at(0, 0), .image = rasterized });
+    CHECK(cells.images[1] == RenderImage { .cell = 4, .span = 2, .offset = at(1, 0), .image = rasterized });
+    CHECK(cells.images[2] == RenderImage { .cell = 7, .span = 1, .offset = at(1, 3), .image = rasterized });
+
+    // Runs crossing the bounds of the range are clipped to it.
+    auto other = RenderCells {};
+    other.appendRange(cells, 2, 5);
+    REQUIRE(other.images.size() == 2);
+    CHECK(other.images[0] == RenderImage { .cell = 0, .span = 2, .offset = at(0, 2), .image = rasterized });
+    CHECK(other.images[1] == RenderImage { .cell = 2, .span = 1, .offset = at(1, 0), .image = rasterized });
+}
@@ -8,6 +8,8 @@
 #include <vtbackend/VTWriter.h>
 #include <vtbackend/logging.h>
 
+#include <vtparser/ControlByteScanner.h>
+
 #include <crispy/App.h>
 #include <crispy/Comparison.h>
 #include <crispy/algorithm.h>
@@ -28,10 +30,12 @@
 #include <cassert>
 #include <iostream>
 #include <iterator>
+#include <numeric>
 #include <sstream>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <variant>
 
 #if defined(_WIN32)
@@ -265,6 +269,171 @@ namespace // {{{ helper
     //             return nullopt;
     //     }
     // }
+
+    /// UTF-8 text of a line up to its last non-blank column, as matched by regular expression search.
+    struct RegexSearchLineText
+    {
+        std::string text;
+        std::vector<size_t> columnOffsets; // byte offset at which each column starts
+
+        template <CellConcept Cell>
+        [[nodiscard]] static RegexSearchLineText of(Line<Cell> const& line)
+        {
+            auto result = RegexSearchLineText {};
+            if (line.isTrivialBuffer())
+            {
+                auto const text = line.trivialBuffer().text.view();
+                if (std::ranges::all_of(text, [](char ch) { return static_cast<unsigned char>(ch) < 0x80; }))
+                {
+                    result.text = text;
+                    result.columnOffsets.resize(text.size());
+                    std::iota(result.columnOffsets.begin(), result.columnOffsets.end(), size_t { 0 });
+                    return result;
+                }
+            }
+
+            for (Cell const& cell: line.trim_blank_right())
+            {
+                result.columnOffsets.push_back(result.text.size());
+                if (cell.codepointCount() == 0)
+                    result.text += ' ';
+                else
+                    result.text += cell.toUtf8();
+            }
+            return result;
+        }
+
+        [[nodiscard]] size_t byteOffsetOf(ColumnOffset column) const noexcept
+        {
+            auto const index = static_cast<size_t>(std::max(0, unbox(column)));
+            return index < columnOffsets.size() ? columnOffsets[index] : text.size();
+        }
+
+        [[nodiscard]] ColumnOffset columnAt(size_t byteOffset) const noexcept
+        {
+            auto const i = std::ranges::upper_bound(columnOffsets, byteOffset);
+            return ColumnOffset::cast_from(std::distance(columnOffsets.begin(), i) - 1);
+        }
+    };
+
+    /// @returns the text of the given line, if it passes the literal prefilter of the given pattern.
+    template <CellConcept Cell>
+    std::optional<RegexSearchLineText> regexSearchCandidate(Line<Cell> const& line,
+                                                            RegexSearchPattern const& pattern)
+    {
+        // Trivial lines are checked before building their text, and without inflating them.
+        if (line.isTrivialBuffer())
+        {
+            if (!pattern.mayMatch(line.trivialBuffer().text.view()))
+                return std::nullopt;
+            return RegexSearchLineText::of(line);
+        }
+
+        auto text = RegexSearchLineText::of(line);
+        if (!pattern.mayMatch(text.text))
+            return std::nullopt;
+        return text;
+    }
+
+    /// Tests whether the given codepoint is a wide CJK character that never joins its neighbours.
+    ///
+    /// All of these are encoded in three UTF-8 bytes, are two columns wide (East Asian Wide or
+    /// Fullwidth), and have the grapheme cluster break property Other, so that there is always
+    /// a grapheme cluster break before them unless they follow a Prepend character,
+    /// and after them.
+    constexpr bool isSimpleWideCharacter(char32_t codepoint) noexcept
+    {
+        // clang-format off
+        return (0x3001 <= codepoint && codepoint <= 0x3003)  // ideographic comma, full stop, ditto mark
+            || (0x3008 <= codepoint && codepoint <= 0x3011)  // CJK brackets
+            || (0x3041 <= codepoint && codepoint <= 0x3096)  // Hiragana
+            || (0x30A1 <= codepoint && codepoint <= 0x30FA)  // Katakana
+            || (0x30FC <= codepoint && codepoint <= 0x30FE)  // Katakana prolonged sound and iteration marks
+            || (0x3400 <= codepoint && codepoint <= 0x4DBF)  // CJK Unified Ideographs Extension A
+            || (0x4E00 <= codepoint && codepoint <= 0x9FFF)  // CJK Unified Ideographs
+            || (0xFF01 <= codepoint && codepoint <= 0xFF60); // Fullwidth forms
+        // clang-format on
+    }
+
+    /// Decodes the three UTF-8 bytes at @p text, if these encode a simple wide character.
+    ///
+    /// @returns the decoded character, or 0 if these bytes encode anything else.
+    constexpr char32_t decodeSimpleWideCharacter(std::string_view text) noexcept
+    {
+        auto const b0 = static_cast<uint8_t>(text[0]);
+        auto const b1 = static_cast<uint8_t>(text[1]);
+        auto const b2 = static_cast<uint8_t>(text[2]);
+        if ((b0 & 0xF0) != 0xE0 || (b1 & 0xC0) != 0x80 || (b2 & 0xC0) != 0x80)
+            return 0;
+        auto const codepoint = (char32_t(b0 & 0x0F) << 12) | (char32_t(b1 & 0x3F) << 6) | char32_t(b2 & 0x3F);
+        return isSimpleWideCharacter(codepoint) ? codepoint : 0;
+    }
+
+    /// @returns whether the given text consists of simple wide characters only.
+    constexpr bool isSimpleWideText(std::string_view text) noexcept
+    {
+        if (text.empty() || text.size() % 3 != 0)
+            return false;
+        for (size_t i = 0; i < text.size(); i += 3)
+            if (!decodeSimpleWideCharacter(text.substr(i, 3)))
+                return false;
+        return true;
+    }
+
+    /// Number of capture buffer bytes replied right away, before the rest of a capture is streamed.
+    constexpr size_t MaxSynchronousCaptureSize = 64 * 1024;
+
+    /// Yields the text of a grid snapshot's lines as capture buffer replies, one per invocation,
+    /// followed by the empty reply that marks the end of the capture, and then an empty string.
+    ///
+    /// Each reply holds whole lines of about MaxChunkSize bytes in total, so that capturing
+    /// a large scrollback never needs more than one chunk at a time.
+    template <CellConcept Cell>
+    class CaptureBufferSource
+    {
+      public:
+        static constexpr size_t MaxChunkSize = 4096;
+
+        CaptureBufferSource(std::shared_ptr<GridSnapshot<Cell> const> snapshot,
+                            LineOffset top,
+                            bool logicalLines):
+            _snapshot { std::move(snapshot) }, _line { top }, _logicalLines { logicalLines }
+        {
+        }
+
+        std::string operator()()
+        {
+            auto const bottom = boxed_cast<LineOffset>(_snapshot->pageSize().lines) - 1;
+            auto text = std::string {};
+            for (; _line <= bottom && text.size() < MaxChunkSize; ++_line)
+            {
+                // Wrapped lines are joined with the line above when capturing logical lines.
+                auto const& line = _snapshot->lineAt(_line);
+                auto const joined = _logicalLines && _line < bottom && _snapshot->lineAt(_line + 1).wrapped();
+                auto const start = text.size();
+                line.appendText(text, !joined);
+                if (joined)
+                    continue;
+                if (text.size() == start && !(_logicalLines && line.wrapped()))
+                    continue; // blank lines are skipped
+                text += '\n';
+            }
+
+            if (!text.empty())
+                return std::format("\033^{};{}\033\\", CaptureBufferCode, text);
+
+            if (_finished)
+                return {};
+            _finished = true;
+            return std::format("\033^{};\033\\", CaptureBufferCode);
+        }
+
+      private:
+        std::shared_ptr<GridSnapshot<Cell> const> _snapshot;
+        LineOffset _line;
+        bool _logicalLines;
+        bool _finished = false;
+    };
 } // namespace
 // }}}
 
@@ -361,6 +530,13 @@ void Screen<Cell>::applyPageSizeToMainDisplay(PageSize mainDisplayPageSize)
     verifyState();
 }
 
+template <CellConcept Cell>
+void Screen<Cell>::discardPageAndResize(PageSize mainDisplayPageSize)
+{
+    _grid.reset(mainDisplayPageSize);
+    applyPageSizeToMainDisplay(mainDisplayPageSize);
+}
+
 template <CellConcept Cell>
 string_view Screen<Cell>::tryEmplaceChars(string_view chars, size_t cellCount) noexcept
 {
@@ -371,7 +547,7 @@ string_view Screen<Cell>::tryEmplaceChars(string_view chars, size_t cellCount) n
     // optimization can be applied.
     // Unless we're storing the charset in the TrivialLineBuffer, too.
     // But for now that's too rare to be beneficial.
-    if (!_cursor.charsets.isSelected(CharsetId::USASCII))
+    if (!_cursor.charsets.isIdentity())
         return chars;
 
     crlfIfWrapPending();
@@ -385,7 +561,7 @@ string_view Screen<Cell>::tryEmplaceChars(string_view chars, size_t cellCount) n
 
     if (_cursor.position.column.value == 0)
     {
-        if (currentLine().empty())
+        if (currentLine().empty() || isTriviallyOverwritable(currentLine(), cellCount))
         {
             auto const numberOfBytesEmplaced = emplaceCharsIntoCurrentLine(chars, cellCount);
             _terminal->currentPtyBuffer()->advanceHotEndUntil(chars.data() + numberOfBytesEmplaced);
@@ -419,10 +595,13 @@ size_t Screen<Cell>::emplaceCharsIntoCurrentLine(string_view chars, size_t cellC
     assert(cellCount <= static_cast<size_t>(columnsAvailable));
 
     Line<Cell>& line = currentLine();
-    if (line.isTrivialBuffer() && line.empty())
+    if ((line.isTrivialBuffer() && line.empty()) || isTriviallyOverwritable(line, cellCount))
     {
         // Only use fastpath if the currently line hasn't been inflated already.
         // Because we might lose prior-written textual/SGR information otherwise.
+        // Text replacing all of a trivial line's text, such as a progress bar redrawn after a carriage
+        // return, does not lose anything either.
+        _grid.markLineDamaged(_cursor.position.line);
         line.setBuffer(
             TrivialLineBuffer { line.trivialBuffer().displayWidth,
                                 _cursor.graphicsRendition,
@@ -432,7 +611,7 @@ size_t Screen<Cell>::emplaceCharsIntoCurrentLine(string_view chars, size_t cellC
                                 crispy::buffer_fragment { _terminal->currentPtyBuffer(), chars } });
         advanceCursorAfterWrite(ColumnCount::cast_from(cellCount));
     }
-    else
+    else if (!tryWriteASCII(chars))
     {
         // Transforming chars input from UTF-8 to UTF-32 even though right now it should only
         // be containing US-ASCII, but soon it'll be any arbitrary textual Unicode codepoints.
@@ -444,6 +623,92 @@ size_t Screen<Cell>::emplaceCharsIntoCurrentLine(string_view chars, size_t cellC
     return chars.size();
 }
 
+template <CellConcept Cell>
+bool Screen<Cell>::isTriviallyOverwritable(Line<Cell> const& line, size_t cellCount) const noexcept
+{
+    return _cursor.position.column == ColumnOffset(0) && line.isTrivialBuffer()
+           && ColumnCount::cast_from(cellCount) >= line.trivialBuffer().usedColumns;
+}
+
+template <CellConcept Cell>
+bool Screen<Cell>::tryWriteASCII(string_view text) noexcept
+{
+    if (text.empty() || !isFullHorizontalMargins())
+        return false;
+
+    if (vtparser::findNextControlByte(text.data(), text.data() + text.size()) != text.data() + text.size())
+        return false;
+
+    // US-ASCII characters never join each other, but the first one may still join the preceding one.
+    // The same holds for what the national and DEC Special Graphics charsets map them to.
+    if (!unicode::grapheme_segmenter::breakable(_terminal->parser().precedingGraphicCharacter(),
+                                                _cursor.charsets.peek(text.front())))
+        return false;
+
+    crlfIfWrapPending();
+
+    auto const columnsAvailable = pageSize().columns.value - _cursor.position.column.value;
+    if (text.size() > static_cast<size_t>(columnsAvailable))
+        return false;
+
+    Line<Cell>& line = currentLine();
+    auto const start = _cursor.position.column;
+    auto const last = start + ColumnOffset::cast_from(text.size() - 1);
+
+    // Erase the left half of a wide char whose right half is about to be overwritten.
+    if (start > ColumnOffset(0) && line.useCellAt(start).isFlagEnabled(CellFlag::WideCharContinuation))
+        line.useCellAt(start - 1).reset(_cursor.graphicsRendition);
+
+    auto const lastOldWidth = line.useCellAt(last).width();
+
+    if (_cursor.charsets.isIdentity())
+        line.write(start, _cursor.graphicsRendition, _cursor.hyperlink, text);
+    else
+    {
+        // Map the whole run at once, e.g. line drawing in DEC Special Graphics.
+        _charsetMappedText.resize(text.size());
+        _cursor.charsets.map(text, _charsetMappedText.data());
+        line.write(
+            start, _cursor.graphicsRendition, _cursor.hyperlink, std::u32string_view(_charsetMappedText));
+    }
+
+    // Advance the cursor just like writing the last character individually would have done.
+    _cursor.position.column = last;
+    _lastCursorPosition = _cursor.position;
+    clearAndAdvance(lastOldWidth, 1);
+
+    _terminal->markCellDirty(_cursor.position);
+    _terminal->resetInstructionCounter();
+    return true;
+}
+
+template <CellConcept Cell>
+bool Screen<Cell>::tryWriteWideText(string_view text) noexcept
+{
+    if (!_cursor.charsets.isSelected(CharsetId::USASCII))
+        return false;
+
+    if (!isSimpleWideText(text))
+        return false;
+
+    // The characters never join each other, but the first one may still join the preceding one.
+    if (!unicode::grapheme_segmenter::breakable(_terminal->parser().precedingGraphicCharacter(),
+                                                decodeSimpleWideCharacter(text)))
+        return false;
+
+    crlfIfWrapPending();
+
+    auto const columnsAvailable = pageSize().columns.value - _cursor.position.column.value;
+    if (2 * (text.size() / 3) > static_cast<size_t>(columnsAvailable))
+        return false;
+
+    for (size_t i = 0; i < text.size(); i += 3)
+        writeCharToCurrentAndAdvance(decodeSimpleWideCharacter(text.substr(i, 3)), 2);
+
+    _terminal->resetInstructionCounter();
+    return true;
+}
+
 template <CellConcept Cell>
 void Screen<Cell>::advanceCursorAfterWrite(ColumnCount n) noexcept
 {
@@ -463,9 +728,12 @@ template <CellConcept Cell>
 void Screen<Cell>::writeText(string_view text, size_t cellCount)
 {
 #if defined(LIBTERMINAL_LOG_TRACE)
-    if (vtTraceSequenceLog)
-        vtTraceSequenceLog()(
-            "[{}] text: ({} bytes, {} cells): \"{}\"", _name, text.size(), cellCount, escape(text));
+    LOGSTORE_LOG(vtTraceSequenceLog,
+                 "[{}] text: ({} bytes, {} cells): \"{}\"",
+                 _name,
+                 text.size(),
+                 cellCount,
+                 escape(text));
 
     // Do not log individual characters, as we already logged the whole string above
     _logCharTrace = false;
@@ -477,7 +745,7 @@ void Screen<Cell>::writeText(string_view text, size_t cellCount)
     assert(cellCount <= static_cast<size_t>(pageSize().columns.value - _cursor.position.column.value));
 
     text = tryEmplaceChars(text, cellCount);
-    if (text.empty())
+    if (text.empty() || tryWriteASCII(text) || tryWriteWideText(text))
         return;
 
     // Making use of the optimized code path for the input characters did NOT work, so we need to first
@@ -488,6 +756,85 @@ void Screen<Cell>::writeText(string_view text, size_t cellCount)
         _terminal->parser().printUtf8Byte(ch);
 }
 
+template <CellConcept Cell>
+size_t Screen<Cell>::writeTextLines(string_view text)
+{
+    auto const pageMargin = margin();
+    if (pageMargin.horizontal.from != ColumnOffset(0)
+        || pageMargin.horizontal.to != boxed_cast<ColumnOffset>(pageSize().columns) - 1
+        || pageMargin.vertical.from != LineOffset(0)
+        || pageMargin.vertical.to != boxed_cast<LineOffset>(pageSize().lines) - 1)
+        return 0;
+
+    if (_terminal->isModeEnabled(DECMode::SmoothScroll)
+        && _terminal->settings().smoothLineScrolling.count() != 0)
+        return 0;
+
+    bool const linefeedReturns =
+        _terminal->usingStdoutFastPipe() || _terminal->isModeEnabled(AnsiMode::AutomaticNewLine);
+
+    // The topmost line of a batch is the one the cursor is on, which ends up just above the first line
+    // scrolled in. Thus a batch covers at most all lines of the page but the bottom one.
+    auto const batchCapacity = unbox<size_t>(pageSize().lines) - 1;
+    auto const* const end = text.data() + text.size();
+    auto const* input = text.data();
+
+    while (_cursor.position.line == pageMargin.vertical.to && !_cursor.wrapPending)
+    {
+        // Pre-scan the lines that can be written without wrapping, i.e. without scrolling in between.
+        _bulkLines.clear();
+        auto column = _cursor.position.column;
+        auto const* next = input;
+        while (_bulkLines.size() < batchCapacity)
+        {
+            auto const* const textEnd = vtparser::findNextControlByte(next, end);
+            bool const carriageReturn = textEnd != end && *textEnd == '\r';
+            auto const* const lineEnd = textEnd + (carriageReturn ? 1 : 0);
+            if (lineEnd == end || *lineEnd != '\n')
+                break;
+
+            auto const width = static_cast<int>(std::distance(next, textEnd));
+            if (column.value + width > pageMargin.horizontal.to.value)
+                break;
+
+            _bulkLines.emplace_back(next, static_cast<size_t>(std::distance(next, lineEnd)));
+            column = carriageReturn || linefeedReturns ? ColumnOffset(0) : ColumnOffset(column.value + width);
+            next = lineEnd + 1;
+        }
+        if (_bulkLines.size() < 2)
+            break;
+
+        auto const lineCount = LineCount::cast_from(_bulkLines.size());
+        scrollUp(lineCount, _cursor.graphicsRendition, pageMargin);
+        if (unbox(historyLineCount()) > 0)
+            _terminal->addLineOffsetToJumpHistory(boxed_cast<LineOffset>(lineCount));
+
+        // Write the lines straight into the places the scrolling moved them to.
+        auto line = pageMargin.vertical.to - boxed_cast<LineOffset>(lineCount);
+        for (auto lineText: _bulkLines)
+        {
+            _cursor.position.line = line++;
+            updateCursorIterator();
+
+            bool const carriageReturn = lineText.ends_with('\r');
+            if (carriageReturn)
+                lineText.remove_suffix(1);
+            if (!lineText.empty())
+                writeText(lineText, lineText.size());
+
+            _terminal->incrementInstructionCounter(carriageReturn ? 2 : 1);
+            _cursor.wrapPending = false;
+            if (carriageReturn || linefeedReturns)
+                _cursor.position.column = ColumnOffset(0);
+        }
+        _cursor.position.line = pageMargin.vertical.to;
+        updateCursorIterator();
+        input = next;
+    }
+
+    return static_cast<size_t>(std::distance(text.data(), input));
+}
+
 template <CellConcept Cell>
 void Screen<Cell>::writeTextEnd()
 {
@@ -496,8 +843,7 @@ void Screen<Cell>::writeTextEnd()
     if (_pendingCharTraceLog.empty())
         return;
 
-    if (vtTraceSequenceLog)
-        vtTraceSequenceLog()("[{}] text: \"{}\"", _name, _pendingCharTraceLog);
+    LOGSTORE_LOG(vtTraceSequenceLog, "[{}] text: \"{}\"", _name, _pendingCharTraceLog);
 
     _pendingCharTraceLog.clear();
 #endif
@@ -507,8 +853,7 @@ template <CellConcept Cell>
 void Screen<Cell>::writeTextFromExternal(std::string_view text)
 {
 #if defined(LIBTERMINAL_LOG_TRACE)
-    if (vtTraceSequenceLog)
-        vtTraceSequenceLog()("external text: \"{}\"", text);
+    LOGSTORE_LOG(vtTraceSequenceLog, "external text: \"{}\"", text);
 #endif
 
     for (char32_t const ch: unicode::convert_to<char32_t>(text))
@@ -561,6 +906,12 @@ void Screen<Cell>::writeTextInternal(char32_t sourceCodepoint)
 
 template <CellConcept Cell>
 void Screen<Cell>::writeCharToCurrentAndAdvance(char32_t codepoint) noexcept
+{
+    writeCharToCurrentAndAdvance(codepoint, static_cast<uint8_t>(unicode::width(codepoint)));
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::writeCharToCurrentAndAdvance(char32_t codepoint, uint8_t width) noexcept
 {
     Line<Cell>& line = currentLine();
 
@@ -581,10 +932,7 @@ void Screen<Cell>::writeCharToCurrentAndAdvance(char32_t codepoint) noexcept
 
     auto const oldWidth = cell.width();
 
-    cell.write(_cursor.graphicsRendition,
-               codepoint,
-               static_cast<uint8_t>(unicode::width(codepoint)),
-               _cursor.hyperlink);
+    cell.write(_cursor.graphicsRendition, codepoint, width, _cursor.hyperlink);
 
     _lastCursorPosition = _cursor.position;
 
@@ -628,9 +976,31 @@ std::string Screen<Cell>::screenshot(function<string(LineOffset)> const& postLin
     {
         writer.write(_grid.lineAt(LineOffset(line)));
         if (postLine)
+        {
+            writer.resetAttributes();
             writer.write(postLine(LineOffset(line)));
+        }
         writer.crlf();
     }
+    writer.resetAttributes();
+    writer.flush();
+
+    return result.str();
+}
+
+template <CellConcept Cell>
+std::string Screen<Cell>::screenshot(GridSnapshot<Cell> const& snapshot)
+{
+    auto result = std::stringstream {};
+    auto writer = VTWriter(result);
+
+    for (int const line: ::ranges::views::iota(0, *snapshot.pageSize().lines))
+    {
+        writer.write(snapshot.lineAt(LineOffset(line)));
+        writer.crlf();
+    }
+    writer.resetAttributes();
+    writer.flush();
 
     return result.str();
 }
@@ -644,13 +1014,7 @@ optional<LineOffset> Screen<Cell>::findMarkerUpwards(LineOffset startLine) const
     if (*startLine <= -*historyLineCount())
         return nullopt;
 
-    startLine = std::min(startLine, boxed_cast<LineOffset>(pageSize().lines - 1));
-
-    for (LineOffset i = startLine - 1; i >= -boxed_cast<LineOffset>(historyLineCount()); --i)
-        if (_grid.lineAt(i).marked())
-            return { i };
-
-    return nullopt;
+    return _grid.findMarkedLineAbove(std::min(startLine, boxed_cast<LineOffset>(pageSize().lines - 1)));
 }
 
 template <CellConcept Cell>
@@ -663,13 +1027,7 @@ optional<LineOffset> Screen<Cell>::findMarkerDownwards(LineOffset startLine) con
                                 -boxed_cast<LineOffset>(historyLineCount()),
                                 +boxed_cast<LineOffset>(pageSize().lines) - 1);
 
-    auto const bottom = LineOffset(0);
-
-    for (LineOffset i = top + 1; i <= bottom; ++i)
-        if (_grid.lineAt(i).marked())
-            return { i };
-
-    return nullopt;
+    return _grid.findMarkedLineBelow(top, LineOffset(0));
 }
 
 // {{{ tabs related
@@ -953,25 +1311,18 @@ template <CellConcept Cell>
 void Screen<Cell>::clearToEndOfScreen()
 {
     clearToEndOfLine();
-
-    for (auto const lineOffset:
-         ::ranges::views::iota(unbox(_cursor.position.line) + 1, unbox(pageSize().lines)))
-    {
-        Line<Cell>& line = _grid.lineAt(LineOffset::cast_from(lineOffset));
-        line.reset(_grid.defaultLineFlags(), _cursor.graphicsRendition);
-    }
+    _grid.clearLines(_cursor.position.line + 1,
+                     boxed_cast<LineOffset>(pageSize().lines),
+                     _grid.defaultLineFlags(),
+                     _cursor.graphicsRendition);
 }
 
 template <CellConcept Cell>
 void Screen<Cell>::clearToBeginOfScreen()
 {
     clearToBeginOfLine();
-
-    for (auto const lineOffset: ::ranges::views::iota(0, *_cursor.position.line))
-    {
-        Line<Cell>& line = _grid.lineAt(LineOffset::cast_from(lineOffset));
-        line.reset(_grid.defaultLineFlags(), _cursor.graphicsRendition);
-    }
+    _grid.clearLines(
+        LineOffset(0), _cursor.position.line, _grid.defaultLineFlags(), _cursor.graphicsRendition);
 }
 
 template <CellConcept Cell>
@@ -1121,19 +1472,10 @@ void Screen<Cell>::selectiveEraseArea(Rect area)
         return;
 
     for (int y = top.value; y <= bottom.value; ++y)
-    {
-        for (Cell& cell: grid()
-                             .lineAt(LineOffset::cast_from(y))
-                             .useRange(ColumnOffset::cast_from(left),
-                                       ColumnCount::cast_from(right.value - left.value + 1)))
-        {
-            if (!cell.isFlagEnabled(CellFlag::CharacterProtected))
-            {
-                cell.writeTextOnly(L' ', 1);
-                cell.setHyperlink(HyperlinkId(0));
-            }
-        }
-    }
+        grid()
+            .lineAt(LineOffset::cast_from(y))
+            .eraseUnprotectedRange(ColumnOffset::cast_from(left),
+                                   ColumnCount::cast_from(right.value - left.value + 1));
 }
 // }}}
 
@@ -1275,13 +1617,6 @@ void Screen<Cell>::copyArea(Rect sourceArea, int page, CellLocation targetTopLef
         // Copy to its own location => no-op.
         return;
 
-    auto const [x0, xInc, xEnd] = [&]() {
-        if (*targetTopLeft.column > *sourceArea.left) // moving right
-            return std::tuple { *sourceArea.right - *sourceArea.left, -1, -1 };
-        else
-            return std::tuple { 0, +1, *sourceArea.right - *sourceArea.left + 1 };
-    }();
-
     auto const [y0, yInc, yEnd] = [&]() {
         if (*targetTopLeft.line > *sourceArea.top) // moving down
             return std::tuple { *sourceArea.bottom - *sourceArea.top, -1, -1 };
@@ -1289,16 +1624,23 @@ void Screen<Cell>::copyArea(Rect sourceArea, int page, CellLocation targetTopLef
             return std::tuple { 0, +1, *sourceArea.bottom - *sourceArea.top + 1 };
     }();
 
+    // Copy whole row spans, cut off where either the source or the target leaves the page.
+    auto const columns = unbox(pageSize().columns);
+    auto const width = std::min({ *sourceArea.right - *sourceArea.left + 1,
+                                  columns - *sourceArea.left,
+                                  columns - *targetTopLeft.column });
+    if (width <= 0)
+        return;
+
     for (auto y = y0; y != yEnd; y += yInc)
     {
-        for (auto x = x0; x != xEnd; x += xInc)
-        {
-            Cell const& sourceCell =
-                at(LineOffset::cast_from(*sourceArea.top + y), ColumnOffset::cast_from(sourceArea.left + x));
-            Cell& targetCell = at(LineOffset::cast_from(targetTopLeft.line + y),
-                                  ColumnOffset::cast_from(targetTopLeft.column + x));
-            targetCell = sourceCell;
-        }
+        auto const& sourceLine = std::as_const(grid()).lineAt(LineOffset::cast_from(*sourceArea.top + y));
+        grid()
+            .lineAt(LineOffset::cast_from(targetTopLeft.line + y))
+            .copyRange(targetTopLeft.column,
+                       sourceLine,
+                       ColumnOffset::cast_from(sourceArea.left),
+                       ColumnCount::cast_from(width));
     }
 }
 
@@ -1312,14 +1654,9 @@ void Screen<Cell>::eraseArea(int top, int left, int bottom, int right)
         return;
 
     for (int y = top; y <= bottom; ++y)
-    {
-        for (Cell& cell: grid()
-                             .lineAt(LineOffset::cast_from(y))
-                             .useRange(ColumnOffset(left), ColumnCount(right - left + 1)))
-        {
-            cell.write(_cursor.graphicsRendition, L' ', 1);
-        }
-    }
+        grid()
+            .lineAt(LineOffset::cast_from(y))
+            .fillRange(ColumnOffset(left), ColumnCount(right - left + 1), _cursor.graphicsRendition, L' ', 1);
 }
 
 template <CellConcept Cell>
@@ -1331,15 +1668,13 @@ void Screen<Cell>::fillArea(char32_t ch, int top, int left, int bottom, int righ
 
     auto const w = static_cast<uint8_t>(unicode::width(ch));
     for (int y = top; y <= bottom; ++y)
-    {
-        for (Cell& cell:
-             grid()
-                 .lineAt(LineOffset::cast_from(y))
-                 .useRange(ColumnOffset::cast_from(left), ColumnCount::cast_from(right - left + 1)))
-        {
-            cell.write(cursor().graphicsRendition, ch, w);
-        }
-    }
+        grid()
+            .lineAt(LineOffset::cast_from(y))
+            .fillRange(ColumnOffset::cast_from(left),
+                       ColumnCount::cast_from(right - left + 1),
+                       cursor().graphicsRendition,
+                       ch,
+                       w);
 }
 
 template <CellConcept Cell>
@@ -1425,21 +1760,46 @@ void Screen<Cell>::hyperlink(string id, string uri)
                 return;
         }
         // We ignore the user id since we need to ensure it's unique. We generate our own.
-        _cursor.hyperlink = _terminal->hyperlinks().nextHyperlinkId++;
-        _terminal->hyperlinks().cache.emplace(_cursor.hyperlink,
-                                              make_shared<HyperlinkInfo>(HyperlinkInfo {
-                                                  .userId = std::move(cacheId), .uri = std::move(uri) }));
+        _cursor.hyperlink = _terminal->hyperlinks().add(
+            HyperlinkInfo { .userId = std::move(cacheId), .uri = std::move(uri) });
     }
     // TODO:
-    // Care about eviction.
     // Move hyperlink store into ScreenBuffer, so it gets reset upon every switch into
     // alternate screen (not for main screen!)
 }
 
+template <CellConcept Cell>
+HyperlinkId Screen<Cell>::hyperlinkIdAt(CellLocation position) const noexcept
+{
+    auto const& line = _grid.lineAt(position.line);
+    auto const id = line.isTrivialBuffer() ? line.trivialBuffer().hyperlink : at(position).hyperlink();
+    if (id.value != 0)
+        return id;
+
+    if (auto const detected = detectedHyperlinkAt(position))
+        return detected->id;
+    return {};
+}
+
+template <CellConcept Cell>
+std::optional<DetectedHyperlink> Screen<Cell>::detectedHyperlinkAt(CellLocation position) const noexcept
+{
+    // Text linked via OSC 8 is taken as is.
+    auto const& line = _grid.lineAt(position.line);
+    auto const id = line.isTrivialBuffer() ? line.trivialBuffer().hyperlink : at(position).hyperlink();
+    if (id.value != 0)
+        return std::nullopt;
+
+    return _terminal->hyperlinkDetector().hyperlinkAt(
+        line.toColumnText(), position.column, _terminal->hyperlinks());
+}
+
 template <CellConcept Cell>
 std::shared_ptr<HyperlinkInfo const> Screen<Cell>::hyperlinkAt(CellLocation pos) const noexcept
 {
-    return _terminal->hyperlinks().hyperlinkById(hyperlinkIdAt(pos));
+    if (auto const* href = _terminal->hyperlinks().hyperlinkById(hyperlinkIdAt(pos)))
+        return make_shared<HyperlinkInfo const>(*href);
+    return {};
 }
 
 template <CellConcept Cell>
@@ -1544,10 +1904,6 @@ void Screen<Cell>::notify(string const& title, string const& content)
 template <CellConcept Cell>
 void Screen<Cell>::captureBuffer(LineCount lineCount, bool logicalLines)
 {
-    // TODO: Unit test case! (for ensuring line numbering and limits are working as expected)
-
-    auto capturedBuffer = std::string();
-
     // TODO: when capturing lineCount < screenSize.lines, start at the lowest non-empty line.
     auto const relativeStartLine =
         logicalLines ? _grid.computeLogicalLineNumberFromBottom(LineCount::cast_from(lineCount))
@@ -1557,56 +1913,27 @@ void Screen<Cell>::captureBuffer(LineCount lineCount, bool logicalLines)
 
     vtCaptureBufferLog()("Capture buffer: {} lines {}", lineCount, logicalLines ? "logical" : "actual");
 
-    size_t constexpr MaxChunkSize = 4096;
-    size_t currentChunkSize = 0;
-    auto const pushContent = [&](auto const& data) -> void {
-        if (data.empty())
-            return;
-        if (currentChunkSize == 0) // initiate chunk
-            reply("\033^{};", CaptureBufferCode);
-        else if (currentChunkSize + data.size() >= MaxChunkSize)
-        {
-            vtCaptureBufferLog()("Transferred chunk of {} bytes.", currentChunkSize);
-            reply("\033\\"); // ST
-            reply("\033^{};", CaptureBufferCode);
-            currentChunkSize = 0;
-        }
-        reply(data);
-        currentChunkSize += data.size();
-    };
-    LineOffset const bottomLine = boxed_cast<LineOffset>(pageSize().lines - 1);
-    vtCaptureBufferLog()("Capturing buffer. top: {}, bottom: {}", relativeStartLine, bottomLine);
+    // Capturing from a snapshot lets the remainder of a large capture be streamed while the grid moves on.
+    auto const historyLines = LineCount::cast_from(-std::min(unbox(startLine), 0));
+    auto nextChunk = CaptureBufferSource<Cell>(
+        make_shared<GridSnapshot<Cell> const>(_grid.snapshot(historyLines)), startLine, logicalLines);
 
-    for (LineOffset line = startLine; line <= bottomLine; ++line)
+    auto repliedBytes = size_t { 0 };
+    while (repliedBytes < MaxSynchronousCaptureSize)
     {
-        if (logicalLines && _grid.lineAt(line).wrapped() && !capturedBuffer.empty())
-            capturedBuffer.pop_back();
-
-        auto const& lineBuffer = _grid.lineAt(line);
-        auto lineCellsTrimmed = lineBuffer.trim_blank_right();
-        if (lineCellsTrimmed.empty())
-        {
-            vtCaptureBufferLog()("Skipping blank line {}", line);
-            continue;
-        }
-        auto const tl = lineCellsTrimmed.size();
-        while (!lineCellsTrimmed.empty())
+        auto const chunk = nextChunk();
+        if (chunk.empty())
         {
-            auto const available = MaxChunkSize - currentChunkSize;
-            auto const n = std::min(available, lineCellsTrimmed.size());
-            for (auto const& cell: lineCellsTrimmed.subspan(0, n))
-                pushContent(cell.toUtf8());
-            lineCellsTrimmed = lineCellsTrimmed.subspan(n);
+            vtCaptureBufferLog()("Capturing buffer finished.");
+            return;
         }
-        vtCaptureBufferLog()("NL ({} len)", tl);
-        pushContent("\n"sv);
+        reply(chunk);
+        repliedBytes += chunk.size();
     }
 
-    if (currentChunkSize != 0)
-        reply("\033\\"); // ST
-
-    vtCaptureBufferLog()("Capturing buffer finished.");
-    reply("\033^{};\033\\", CaptureBufferCode); // mark the end
+    // The rest is only captured as the application reads, rather than queueing it all up at once.
+    vtCaptureBufferLog()("Streaming capture buffer after {} bytes.", repliedBytes);
+    _terminal->replyStreamed(std::move(nextChunk));
 }
 
 template <CellConcept Cell>
@@ -1728,6 +2055,27 @@ template <CellConcept Cell>
 void Screen<Cell>::setMark()
 {
     currentLine().setMarked(true);
+    _grid.startCommandPrompt(_cursor.position.line);
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::markCommandInput()
+{
+    _grid.startCommandInput(_cursor.position.line);
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::markCommandOutput()
+{
+    _grid.startCommandOutput(_cursor.position.line);
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::markCommandFinished(std::optional<int> exitStatus)
+{
+    // The output usually ends with a newline, leaving the cursor at the start of the line below it.
+    auto const atLineStart = _cursor.position.column == ColumnOffset(0) && !_cursor.wrapPending;
+    _grid.finishCommand(_cursor.position.line - LineOffset(atLineStart ? 1 : 0), exitStatus);
 }
 
 enum class ModeResponse : uint8_t
@@ -1826,7 +2174,7 @@ void Screen<Cell>::sixelImage(ImageSize pixelSize, Image::Data&& rgbaData)
         ceil(pixelSize.height.as<double>() / _terminal->cellPixelSize().height.as<double>()));
     auto const extent = GridSize { .lines = lineCount, .columns = columnCount };
     auto const autoScrollAtBottomMargin = !_terminal->isModeEnabled(DECMode::NoSixelScrolling);
-    auto const topLeft = autoScrollAtBottomMargin ? logicalCursorPosition() : CellLocation {};
+    auto const topLeft = sixelImageTopLeft();
 
     auto const alignmentPolicy = ImageAlignment::TopStart;
     auto const resizePolicy = ImageResize::NoResize;
@@ -1848,6 +2196,55 @@ void Screen<Cell>::sixelImage(ImageSize pixelSize, Image::Data&& rgbaData)
         linefeed(topLeft.column);
 }
 
+template <CellConcept Cell>
+CellLocation Screen<Cell>::sixelImageTopLeft() const noexcept
+{
+    return _terminal->isModeEnabled(DECMode::NoSixelScrolling) ? CellLocation {} : logicalCursorPosition();
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::publishImagePreview()
+{
+    if (!_sixelPreview || !contains(_sixelPreview->topLeft))
+        return;
+
+    auto const pixelSize = _sixelImageBuilder->completedSize();
+    auto const now = std::chrono::steady_clock::now();
+    if (pixelSize.height <= _sixelPreview->height
+        || now - _sixelPreview->time < _terminal->framePacer().interval())
+        return;
+
+    _sixelPreview->height = pixelSize.height;
+    _sixelPreview->time = now;
+
+    // Only the lines that are on the page already are shown, as the screen is not to be scrolled
+    // before the image is complete.
+    auto const topLeft = _sixelPreview->topLeft;
+    auto const extent = GridSize {
+        .lines = LineCount::cast_from(
+            ceil(pixelSize.height.as<double>() / _terminal->cellPixelSize().height.as<double>())),
+        .columns = ColumnCount::cast_from(
+            ceil(pixelSize.width.as<double>() / _terminal->cellPixelSize().width.as<double>())),
+    };
+    auto const linesToBeRendered = std::min(extent.lines, pageSize().lines - topLeft.line.as<LineCount>());
+    auto const columnsAvailable = pageSize().columns - topLeft.column;
+    auto const columnsToBeRendered = ColumnCount(std::min(columnsAvailable, extent.columns));
+
+    auto image = uploadImage(ImageFormat::RGBA, pixelSize, _sixelImageBuilder->completedData());
+    auto const rasterizedImage = make_shared<RasterizedImage>(std::move(image),
+                                                              ImageAlignment::TopStart,
+                                                              ImageResize::NoResize,
+                                                              RGBAColor {},
+                                                              extent,
+                                                              _terminal->cellPixelSize());
+    for (GridSize::Offset const offset: GridSize { linesToBeRendered, columnsToBeRendered })
+    {
+        Cell& cell = at(topLeft + offset);
+        cell.setImageFragment(rasterizedImage, CellLocation { .line = offset.line, .column = offset.column });
+        cell.setHyperlink(_cursor.hyperlink);
+    }
+}
+
 template <CellConcept Cell>
 shared_ptr<Image const> Screen<Cell>::uploadImage(ImageFormat format,
                                                   ImageSize imageSize,
@@ -2249,7 +2646,7 @@ void Screen<Cell>::inspect(std::string const& message, std::ostream& os) const
     os << std::format("Rendered screen at the time of failure\n");
     os << std::format("main page size       : {}\n", _settings->pageSize);
     os << std::format("history line count   : {} (max {})\n",
-                      _terminal->primaryScreen().historyLineCount(),
+                      _terminal->primaryScreenBase().historyLineCount(),
                       _terminal->maxHistoryLineCount());
     os << std::format("cursor position      : {}\n", _cursor.position);
     os << std::format("vertical margins     : {}\n", margin().vertical);
@@ -2265,6 +2662,19 @@ void Screen<Cell>::inspect(std::string const& message, std::ostream& os) const
                            _grid.lineAt(lineNo).flags());
     });
     hline();
+    auto const& ptyReadStats = _terminal->ptyReadStats();
+    os << std::format("PTY read size        : {}\n", ptyReadStats.readSize);
+    for (size_t i = 1; i < ptyReadStats.histogram.size(); ++i)
+        if (ptyReadStats.histogram[i] != 0)
+            os << std::format("PTY reads < {:<9}: {}\n", size_t { 1 } << i, ptyReadStats.histogram[i]);
+    auto const& ptyBufferPool = _terminal->ptyBufferPool();
+    auto const& ptyBufferStats = ptyBufferPool.statistics();
+    os << std::format("PTY buffer allocation: {}\n", ptyBufferPool.allocation());
+    os << std::format("PTY buffers allocated: {}\n", ptyBufferStats.allocated);
+    os << std::format("PTY buffers recycled : {}\n", ptyBufferStats.recycled);
+    os << std::format("PTY buffers live     : {}\n", crispy::humanReadableBytes(ptyBufferStats.liveBytes));
+    os << std::format("PTY buffers unused   : {}\n", crispy::humanReadableBytes(ptyBufferStats.unusedBytes));
+    hline();
     _terminal->imagePool().inspect(os);
     hline();
 
@@ -2969,11 +3379,37 @@ namespace impl
                 return ApplyResult::Unsupported;
         }
 
+        template <CellConcept Cell>
+        ApplyResult SEMANTICPROMPT(Sequence const& seq, Screen<Cell>& screen)
+        {
+            // OSC 133 ; A ST               prompt start
+            // OSC 133 ; B ST               command start
+            // OSC 133 ; C ST               output start
+            // OSC 133 ; D [; exit code] ST command finished
+            //
+            // Further key=value parameters, as used by some shell integrations, are ignored.
+            auto const splits = crispy::split(seq.intermediateCharacters(), ';');
+            if (splits.empty() || splits[0].size() != 1)
+                return ApplyResult::Invalid;
+
+            switch (splits[0][0])
+            {
+                case 'A': screen.setMark(); break;
+                case 'B': screen.markCommandInput(); break;
+                case 'C': screen.markCommandOutput(); break;
+                case 'D':
+                    screen.markCommandFinished(splits.size() > 1 ? crispy::to_integer<10, int>(splits[1])
+                                                                 : std::nullopt);
+                    break;
+                default: return ApplyResult::Unsupported;
+            }
+            return ApplyResult::Ok;
+        }
+
         template <CellConcept Cell>
         ApplyResult SETCWD(Sequence const& seq, Screen<Cell>& screen)
         {
-            string const& url = seq.intermediateCharacters();
-            screen.setCurrentWorkingDirectory(url);
+            screen.setCurrentWorkingDirectory(string(seq.intermediateCharacters()));
             return ApplyResult::Ok;
         }
 
@@ -3005,7 +3441,7 @@ namespace impl
             // hyperlink_OSC ::= OSC '8' ';' params ';' URI
             // params := pair (':' pair)*
             // pair := TEXT '=' TEXT
-            if (auto const pos = value.find(';'); pos != Sequence::Intermediaries::npos)
+            if (auto const pos = value.find(';'); pos != string_view::npos)
             {
                 auto const paramsStr = value.substr(0, pos);
                 auto const params = parseSubParamKeyValuePairs(paramsStr);
@@ -3049,6 +3485,13 @@ namespace impl
 
         ApplyResult WINDOWMANIP(Sequence const& seq, Terminal& terminal)
         {
+            auto const requestPrimaryScreenPixelSize = [&](RequestPixelSize area) {
+                terminal.visitPrimaryScreen([&](auto& screen) { screen.requestPixelSize(area); });
+            };
+            auto const requestPrimaryScreenCharacterSize = [&](RequestPixelSize area) {
+                terminal.visitPrimaryScreen([&](auto& screen) { screen.requestCharacterSize(area); });
+            };
+
             if (seq.parameterCount() == 3)
             {
                 switch (seq.param(0))
@@ -3078,19 +3521,18 @@ namespace impl
                         return ApplyResult::Ok;
                     case 14:
                         if (seq.parameterCount() == 2 && seq.param(1) == 2)
-                            terminal.primaryScreen().requestPixelSize(
-                                RequestPixelSize::WindowArea); // CSI 14 ; 2 t
+                            requestPrimaryScreenPixelSize(RequestPixelSize::WindowArea); // CSI 14 ; 2 t
                         else
-                            terminal.primaryScreen().requestPixelSize(RequestPixelSize::TextArea); // CSI 14 t
+                            requestPrimaryScreenPixelSize(RequestPixelSize::TextArea); // CSI 14 t
                         return ApplyResult::Ok;
                     case 16:
-                        terminal.primaryScreen().requestPixelSize(RequestPixelSize::CellArea);
+                        requestPrimaryScreenPixelSize(RequestPixelSize::CellArea);
                         return ApplyResult::Ok;
                     case 18:
-                        terminal.primaryScreen().requestCharacterSize(RequestPixelSize::TextArea);
+                        requestPrimaryScreenCharacterSize(RequestPixelSize::TextArea);
                         return ApplyResult::Ok;
                     case 19:
-                        terminal.primaryScreen().requestCharacterSize(RequestPixelSize::WindowArea);
+                        requestPrimaryScreenCharacterSize(RequestPixelSize::WindowArea);
                         return ApplyResult::Ok;
                     case 22: {
                         switch (seq.param_or(1, 0))
@@ -3192,9 +3634,10 @@ template <CellConcept Cell>
 void Screen<Cell>::executeControlCode(char controlCode)
 {
 #if defined(LIBTERMINAL_LOG_TRACE)
-    if (vtTraceSequenceLog)
-        vtTraceSequenceLog()(
-            "control U+{:02X} ({})", controlCode, to_string(static_cast<ControlCode::C0>(controlCode)));
+    LOGSTORE_LOG(vtTraceSequenceLog,
+                 "control U+{:02X} ({})",
+                 controlCode,
+                 to_string(static_cast<ControlCode::C0>(controlCode)));
 #endif
 
     _terminal->incrementInstructionCounter();
@@ -3262,13 +3705,19 @@ void Screen<Cell>::reply(std::string_view text)
     _terminal->reply(text);
 }
 
+template <CellConcept Cell>
+void Screen<Cell>::replyFormatted(std::string_view message, std::format_args args)
+{
+    _terminal->replyFormatted(message, args);
+}
+
 template <CellConcept Cell>
 void Screen<Cell>::processSequence(Sequence const& seq)
 {
 #if defined(LIBTERMINAL_LOG_TRACE)
     if (vtTraceSequenceLog)
     {
-        if (auto const* fd = seq.functionDefinition(_terminal->activeSequences()))
+        if (auto const* fd = seq.functionDefinition(_terminal->supportedSequences()))
         {
             vtTraceSequenceLog()("[{}] Processing {:<14} {}", _name, fd->documentation.mnemonic, seq.text());
         }
@@ -3281,12 +3730,259 @@ void Screen<Cell>::processSequence(Sequence const& seq)
     //         seq.functionDefinition() ? seq.functionDefinition()->comment : ""sv);
 
     _terminal->incrementInstructionCounter();
-    if (Function const* funcSpec = seq.functionDefinition(_terminal->activeSequences()); funcSpec != nullptr)
+    if (Function const* funcSpec = seq.functionDefinition(_terminal->supportedSequences());
+        funcSpec != nullptr)
         applyAndLog(*funcSpec, seq);
-    else if (vtParserLog)
-        vtParserLog()("Unknown VT sequence: {}", seq);
+    else
+        LOGSTORE_LOG(vtParserLog, "Unknown VT sequence: {}", seq);
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::processGraphicsRendition(Sequence const& seq)
+{
+#if defined(LIBTERMINAL_LOG_TRACE)
+    LOGSTORE_LOG(vtTraceSequenceLog, "[{}] Processing {:<14} {}", _name, "SGR", seq.text());
+#endif
+
+    // The function is known up front, but invalid or unsupported parameters are reported all the same.
+    _terminal->incrementInstructionCounter();
+    applyAndLog(SGR, seq);
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::processApplicationProgramCommand(std::string_view command)
+{
+    if (command.starts_with('G'))
+        kittyGraphics(command.substr(1));
+    else
+        LOGSTORE_LOG(vtParserLog, "Unknown APC: {}", crispy::escape(command));
+}
+
+// {{{ kitty graphics protocol
+template <CellConcept Cell>
+void Screen<Cell>::kittyGraphics(std::string_view text)
+{
+    using Action = KittyGraphicsCommand::Action;
+
+    auto const command = KittyGraphicsCommand::parse(text);
+    if (!command)
+    {
+        LOGSTORE_LOG(vtParserLog, "Malformed kitty graphics command: {}", crispy::escape(text));
+        return;
+    }
+
+    auto& graphics = _terminal->kittyGraphics();
+    switch (command->action)
+    {
+        case Action::Transmit:
+        case Action::TransmitAndDisplay:
+        case Action::Query: {
+            auto transmission = graphics.collect(*command);
+            if (!transmission)
+                return; // more chunks of image data to follow
+
+            auto [transmitted, payload, collectError] = std::move(*transmission);
+            if (collectError)
+            {
+                replyKittyGraphics(transmitted, *collectError);
+                return;
+            }
+            auto const localMediaAllowed = _terminal->settings().kittyGraphicsLocalMedia;
+            if (transmitted.action == Action::Query)
+            {
+                auto const data = loadKittyGraphicsImage(transmitted, payload, localMediaAllowed);
+                replyKittyGraphics(transmitted, data ? "OK" : data.error());
+                return;
+            }
+            if (auto const error = checkKittyGraphicsImage(transmitted, localMediaAllowed))
+            {
+                replyKittyGraphics(transmitted, *error);
+                return;
+            }
+
+            // The image data is read and converted on a worker thread, whereas the image is
+            // stored and displayed right away, its cells being left blank until then.
+            auto image = _terminal->imagePool().createPending(ImageFormat::RGBA, transmitted.pixelSize);
+            if (transmitted.imageId)
+                graphics.storeImage(transmitted.imageId, image);
+            if (transmitted.action == Action::TransmitAndDisplay)
+                displayKittyImage(transmitted, image);
+            _terminal->decodeImage(
+                image,
+                [transmitted, payload = std::move(payload), localMediaAllowed]() {
+                    return loadKittyGraphicsImage(transmitted, payload, localMediaAllowed);
+                },
+                [this, transmitted, image](std::optional<std::string> const& error) {
+                    auto& graphics = _terminal->kittyGraphics();
+                    if (error && transmitted.imageId && graphics.findImage(transmitted.imageId) == image)
+                        graphics.eraseImage(transmitted.imageId);
+                    replyKittyGraphics(transmitted, error.value_or("OK"));
+                });
+            break;
+        }
+        case Action::Display: {
+            auto image = graphics.findImage(command->imageId);
+            if (!image)
+            {
+                replyKittyGraphics(*command, "ENOENT:no such image");
+                return;
+            }
+            displayKittyImage(*command, std::move(image));
+            replyKittyGraphics(*command, "OK");
+            break;
+        }
+        case Action::Delete: deleteKittyImages(*command); break;
+    }
 }
 
+template <CellConcept Cell>
+void Screen<Cell>::displayKittyImage(KittyGraphicsCommand const& command, shared_ptr<Image const> image)
+{
+    auto& graphics = _terminal->kittyGraphics();
+
+    // The cell size is zero until a display reported it, and the spans the client asks for, or that
+    // a huge image has, are cut down to the page rather than scrolling it by as much.
+    auto const cellPixelSize = ImageSize { std::max(_terminal->cellPixelSize().width, Width(1)),
+                                           std::max(_terminal->cellPixelSize().height, Height(1)) };
+    auto const cellSpan = GridSize {
+        .lines = clamp(*command.cellSpan.lines
+                           ? command.cellSpan.lines
+                           : LineCount::cast_from(
+                                 ceil(image->height().as<double>() / cellPixelSize.height.as<double>())),
+                       LineCount(1),
+                       pageSize().lines),
+        .columns = clamp(*command.cellSpan.columns
+                             ? command.cellSpan.columns
+                             : ColumnCount::cast_from(
+                                   ceil(image->width().as<double>() / cellPixelSize.width.as<double>())),
+                         ColumnCount(1),
+                         pageSize().columns),
+    };
+
+    // Displaying an image at a placement still being shown replaces it in place, which is how
+    // applications animate images, whereas any other placement is displayed at the cursor.
+    auto topLeft = realCursorPosition();
+    auto const* const placement = graphics.findPlacement(command.imageId, command.placementId);
+    auto const replacing = placement && isShowingKittyPlacement(*placement);
+    if (replacing)
+    {
+        topLeft = placement->topLeft;
+        clearKittyPlacement(*placement);
+    }
+    else if (auto const overflow = *topLeft.line + *cellSpan.lines - *pageSize().lines; overflow > 0)
+    {
+        // Scrolls up as far as needed for the image to fit onto the page beneath the cursor.
+        scrollUp(LineCount::cast_from(overflow));
+        topLeft.line = std::max(LineOffset(0), topLeft.line - LineOffset::cast_from(overflow));
+    }
+
+    auto const visibleSpan = GridSize {
+        .lines = std::min(cellSpan.lines, pageSize().lines - topLeft.line.as<LineCount>()),
+        .columns = std::min(cellSpan.columns, pageSize().columns - topLeft.column.as<ColumnCount>()),
+    };
+    auto const resizePolicy = *command.cellSpan.lines || *command.cellSpan.columns ? ImageResize::ResizeToFit
+                                                                                    : ImageResize::NoResize;
+    auto const rasterizedImage = make_shared<RasterizedImage>(
+        std::move(image), ImageAlignment::TopStart, resizePolicy, RGBAColor {}, cellSpan, cellPixelSize);
+    for (GridSize::Offset const offset: visibleSpan)
+    {
+        Cell& cell = at(topLeft + offset);
+        cell.setImageFragment(rasterizedImage, CellLocation { .line = offset.line, .column = offset.column });
+        cell.setHyperlink(_cursor.hyperlink);
+    }
+    graphics.storePlacement(KittyGraphics::Placement { .imageId = command.imageId,
+                                                       .placementId = command.placementId,
+                                                       .image = rasterizedImage,
+                                                       .topLeft = topLeft,
+                                                       .cellSpan = visibleSpan });
+
+    // The cursor moves past the image's right edge, on its bottom line.
+    if (!replacing && !command.keepCursor)
+    {
+        _cursor.wrapPending = false;
+        _cursor.position = clampToScreen(
+            CellLocation { .line = topLeft.line + visibleSpan.lines.as<LineOffset>() - 1,
+                           .column = topLeft.column + visibleSpan.columns.as<ColumnOffset>() });
+        updateCursorIterator();
+    }
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::deleteKittyImages(KittyGraphicsCommand const& command)
+{
+    auto& graphics = _terminal->kittyGraphics();
+    auto const target = command.deleteTarget;
+    auto const matches = [&](KittyGraphics::Placement const& placement) {
+        switch (target)
+        {
+            case 'a':
+            case 'A': return true;
+            case 'i':
+            case 'I':
+                return placement.imageId == command.imageId
+                       && (!command.placementId || placement.placementId == command.placementId);
+            default: return false;
+        }
+    };
+    if (std::string_view("aAiI").find(target) == std::string_view::npos)
+    {
+        LOGSTORE_LOG(vtParserLog, "Unsupported kitty graphics deletion: {}", target);
+        return;
+    }
+
+    for (auto const& placement: graphics.takePlacements(matches))
+    {
+        clearKittyPlacement(placement);
+        if (target == 'A')
+            graphics.eraseImage(placement.imageId);
+    }
+    if (target == 'I')
+        graphics.eraseImage(command.imageId);
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::replyKittyGraphics(KittyGraphicsCommand const& command, std::string_view message)
+{
+    // Only commands identifying their image get a response, and quiet ones only if it is an error.
+    auto const isError = message != "OK";
+    if (!command.imageId || command.quiet >= (isError ? 2 : 1))
+        return;
+
+    if (command.placementId)
+        reply("\033_Gi={},p={};{}\033\\", command.imageId, command.placementId, message);
+    else
+        reply("\033_Gi={};{}\033\\", command.imageId, message);
+}
+
+template <CellConcept Cell>
+bool Screen<Cell>::isShowingKittyPlacement(KittyGraphics::Placement const& placement) const
+{
+    auto const image = placement.image.lock();
+    if (!image || !contains(placement.topLeft))
+        return false;
+    auto const fragment = at(placement.topLeft).imageFragment();
+    return fragment && &fragment->rasterizedImage() == image.get() && fragment->offset() == CellLocation {};
+}
+
+template <CellConcept Cell>
+void Screen<Cell>::clearKittyPlacement(KittyGraphics::Placement const& placement)
+{
+    auto const image = placement.image.lock();
+    if (!image)
+        return;
+    for (GridSize::Offset const offset: placement.cellSpan)
+    {
+        auto const position = placement.topLeft + offset;
+        if (!contains(position))
+            continue;
+        Cell& cell = at(position);
+        auto const fragment = cell.imageFragment();
+        if (fragment && &fragment->rasterizedImage() == image.get())
+            cell.reset();
+    }
+}
+// }}}
+
 template <CellConcept Cell>
 void Screen<Cell>::applyAndLog(Function const& function, Sequence const& seq)
 {
@@ -3688,16 +4384,22 @@ ApplyResult Screen<Cell>::apply(Function const& function, Sequence const& seq)
         case DECPS: _terminal->playSound(seq.parameters()); break;
         case CSIUENTER: {
             auto const flags = KeyboardEventFlags::from_value(seq.param_or(0, 1));
+            auto const _ = _terminal->lockInput();
             _terminal->keyboardProtocol().enter(flags);
             return ApplyResult::Ok;
         }
         case CSIUQUERY: {
-            reply("\033[?{}u", _terminal->keyboardProtocol().flags().value());
+            auto const flags = [&]() {
+                auto const _ = _terminal->lockInput();
+                return _terminal->keyboardProtocol().flags().value();
+            }();
+            reply("\033[?{}u", flags);
             return ApplyResult::Ok;
         }
         case CSIUENHCE: {
             auto const flags = KeyboardEventFlags::from_value(seq.param_or(0, 1));
             auto const mode = seq.param_or(1, 1);
+            auto const _ = _terminal->lockInput();
             if (_terminal->keyboardProtocol().stackDepth() <= 1)
                 return ApplyResult::Invalid;
             switch (mode)
@@ -3711,6 +4413,7 @@ ApplyResult Screen<Cell>::apply(Function const& function, Sequence const& seq)
         }
         case CSIULEAVE: {
             auto const count = seq.param_or<size_t>(0, 1);
+            auto const _ = _terminal->lockInput();
             _terminal->keyboardProtocol().leave(count);
             return ApplyResult::Ok;
         }
@@ -3725,6 +4428,7 @@ ApplyResult Screen<Cell>::apply(Function const& function, Sequence const& seq)
         case SETCOLPAL: return impl::SETCOLPAL(seq, *_terminal);
         case RCOLPAL: return impl::RCOLPAL(seq, *_terminal);
         case SETCWD: return impl::SETCWD(seq, *this);
+        case SEMANTICPROMPT: return impl::SEMANTICPROMPT(seq, *this);
         case HYPERLINK: return impl::HYPERLINK(seq, *this);
         case XTCAPTURE: return impl::CAPTURE(seq, *_terminal);
         case COLORFG:
@@ -3799,18 +4503,29 @@ unique_ptr<ParserExtension> Screen<Cell>::hookSixel(Sequence const& seq)
                                              std::clamp(_terminal->maxSixelColorRegisters(), 0u, 16384u))
             : _terminal->sixelColorPalette());
 
+    _sixelPreview = SixelPreview { .topLeft = sixelImageTopLeft(), .height = Height(0), .time = {} };
+
     return make_unique<SixelParser>(*_sixelImageBuilder, [this]() {
         {
+            _sixelPreview.reset();
             sixelImage(_sixelImageBuilder->size(), std::move(_sixelImageBuilder->data()));
         }
     });
 }
 
+template <CellConcept Cell>
+size_t Screen<Cell>::sixelImageMemoryUsage() const noexcept
+{
+    // The pixel data is moved out once the image is complete, leaving the builder's buffer empty.
+    return _sixelImageBuilder ? _sixelImageBuilder->data().capacity() : 0;
+}
+
 template <CellConcept Cell>
 unique_ptr<ParserExtension> Screen<Cell>::hookSTP(Sequence const& /*seq*/)
 {
     return make_unique<SimpleStringCollector>(
-        [this](string_view const& data) { _terminal->setTerminalProfile(unicode::convert_to<char>(data)); });
+        [this](string_view const& data) { _terminal->setTerminalProfile(unicode::convert_to<char>(data)); },
+        [this]() { return _terminal->currentPtyBuffer(); });
 }
 
 template <CellConcept Cell>
@@ -3894,12 +4609,26 @@ optional<CellLocation> Screen<Cell>::search(std::u32string_view searchText, Cell
         return startPosition;
 
     // Search reverse until found or exhausted.
+    _grid.updateSearchIndex();
+    auto const query = TrigramSignature::of(searchText);
+    auto const firstLine = startPosition.line;
+    auto const candidates = _grid.findCandidateLines(
+        searchText, isCaseSensitive, firstLine, boxed_cast<LineOffset>(pageSize().lines) - 1);
+    auto const mayMatch = [&](LogicalLine<Cell> const& line) {
+        if (candidates.empty())
+            return _grid.mayContain(line, query);
+        auto const index = unbox<size_t>(line.top - firstLine);
+        return index >= candidates.size() || candidates[index] != 0;
+    };
     auto const lines = _grid.logicalLinesFrom(startPosition.line);
     for (auto const& line: lines)
     {
-        auto const result = line.search(searchText, startPosition.column, isCaseSensitive);
-        if (result.has_value())
-            return result; // new match found
+        if (mayMatch(line))
+        {
+            auto const result = line.search(searchText, startPosition.column, isCaseSensitive);
+            if (result.has_value())
+                return result; // new match found
+        }
         startPosition.column = ColumnOffset(0);
     }
     return nullopt;
@@ -3921,17 +4650,66 @@ optional<CellLocation> Screen<Cell>::searchReverse(std::u32string_view searchTex
         return startPosition;
 
     // Search reverse until found or exhausted.
+    _grid.updateSearchIndex();
+    auto const query = TrigramSignature::of(searchText);
+    auto const firstLine = boxed_cast<LineOffset>(-_grid.historyLineCount());
+    auto const candidates =
+        _grid.findCandidateLines(searchText, isCaseSensitive, firstLine, startPosition.line);
+    auto const mayMatch = [&](LogicalLine<Cell> const& line) {
+        if (candidates.empty())
+            return _grid.mayContain(line, query);
+        auto const index = unbox<size_t>(line.top - firstLine);
+        return index >= candidates.size() || candidates[index] != 0;
+    };
     auto const lines = _grid.logicalLinesReverseFrom(startPosition.line);
     for (auto const& line: lines)
     {
-        auto const result = line.searchReverse(searchText, startPosition.column, isCaseSensitive);
-        if (result.has_value())
-            return result; // new match found
+        if (mayMatch(line))
+        {
+            auto const result = line.searchReverse(searchText, startPosition.column, isCaseSensitive);
+            if (result.has_value())
+                return result; // new match found
+        }
         startPosition.column = boxed_cast<ColumnOffset>(pageSize().columns) - 1;
     }
     return nullopt;
 }
 
+template <CellConcept Cell>
+optional<CellLocation> Screen<Cell>::searchRegex(RegexSearchPattern const& pattern,
+                                                 CellLocation startPosition)
+{
+    auto const bottomLine = boxed_cast<LineOffset>(pageSize().lines) - 1;
+    for (auto line = startPosition.line; line <= bottomLine; ++line)
+    {
+        auto const text = regexSearchCandidate(std::as_const(_grid).lineAt(line), pattern);
+        if (!text)
+            continue;
+        auto const startOffset = line == startPosition.line ? text->byteOffsetOf(startPosition.column) : 0;
+        if (auto const match = pattern.findFirst(text->text, startOffset))
+            return CellLocation { .line = line, .column = text->columnAt(match->offset) };
+    }
+    return nullopt;
+}
+
+template <CellConcept Cell>
+optional<CellLocation> Screen<Cell>::searchRegexReverse(RegexSearchPattern const& pattern,
+                                                        CellLocation startPosition)
+{
+    auto const topLine = boxed_cast<LineOffset>(-_grid.historyLineCount());
+    for (auto line = startPosition.line; line >= topLine; --line)
+    {
+        auto const text = regexSearchCandidate(std::as_const(_grid).lineAt(line), pattern);
+        if (!text)
+            continue;
+        auto const startOffset =
+            line == startPosition.line ? text->byteOffsetOf(startPosition.column) : text->text.size();
+        if (auto const match = pattern.findLast(text->text, startOffset))
+            return CellLocation { .line = line, .column = text->columnAt(match->offset) };
+    }
+    return nullopt;
+}
+
 template <CellConcept Cell>
 bool Screen<Cell>::isCursorInsideMargins() const noexcept
 {
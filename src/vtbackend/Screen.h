@@ -8,6 +8,7 @@
 #include <vtbackend/Grid.h>
 #include <vtbackend/Hyperlink.h>
 #include <vtbackend/Image.h>
+#include <vtbackend/KittyGraphics.h>
 #include <vtbackend/ScreenBase.h>
 #include <vtbackend/VTType.h>
 #include <vtbackend/cell/CellConcept.h>
@@ -26,12 +27,14 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <format>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace vtbackend
 {
@@ -161,10 +164,19 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     void writeTextEnd() override;
     void executeControlCode(char controlCode) override;
     void processSequence(Sequence const& seq) override;
+    void processGraphicsRendition(Sequence const& seq) override;
+    void processApplicationProgramCommand(std::string_view command) override;
     // }}}
 
     void writeTextFromExternal(std::string_view text);
 
+    /// Writes the complete lines (US-ASCII text, each terminated by LF or CR LF) at the beginning of
+    /// @p text, as if written and executed one after the other, but scrolling the page once per batch.
+    ///
+    /// @returns the number of leading bytes of @p text processed, which is 0 if the lines cannot be
+    ///          batched (e.g. due to margins or smooth scrolling), or if there are less than two of them.
+    [[nodiscard]] size_t writeTextLines(std::string_view text);
+
     /// Renders the full screen by passing every grid cell to the callback.
     template <typename Renderer>
     RenderPassHints render(Renderer&& render,
@@ -174,6 +186,18 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
         return _grid.render(std::forward<Renderer>(render), scrollOffset, highlightSearchMatches);
     }
 
+    /// Renders only the lines [firstLine, endLine) of the page, see Grid::renderLines().
+    template <typename Renderer>
+    RenderPassHints renderLines(Renderer&& render,
+                                LineOffset firstLine,
+                                LineOffset endLine,
+                                ScrollOffset scrollOffset,
+                                HighlightSearchMatches highlightSearchMatches) const
+    {
+        return _grid.renderLines(
+            std::forward<Renderer>(render), firstLine, endLine, scrollOffset, highlightSearchMatches);
+    }
+
     /// Renders the full screen as text into the given string. Each line will be terminated by LF.
     [[nodiscard]] std::string renderMainPageText() const;
 
@@ -185,6 +209,12 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     ///          including initial clear screen, and initial cursor hide.
     [[nodiscard]] std::string screenshot(std::function<std::string(LineOffset)> const& postLine = {}) const;
 
+    /// Takes a screenshot of the main page of a previously taken grid snapshot.
+    ///
+    /// This does not access any live screen state and can therefore be run without holding the
+    /// terminal lock.
+    [[nodiscard]] static std::string screenshot(GridSnapshot<Cell> const& snapshot);
+
     void crlf() { linefeed(margin().horizontal.from); }
     void crlfIfWrapPending();
 
@@ -255,7 +285,10 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     void index();        // IND
     void reverseIndex(); // RI
 
-    void setMark();
+    void setMark();                                          // SETMARK, OSC 133 ; A
+    void markCommandInput();                                 // OSC 133 ; B
+    void markCommandOutput();                                // OSC 133 ; C
+    void markCommandFinished(std::optional<int> exitStatus); // OSC 133 ; D
     void setScrollSpeed(int speed);      // DECSSCLS
     void deviceStatusReport();           // DSR
     void reportCursorPosition();         // CPR
@@ -446,6 +479,13 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     [[nodiscard]] std::optional<CellLocation> searchReverse(std::u32string_view searchText,
                                                             CellLocation startPosition) override;
 
+    // Searches line by line for a regular expression match, see RegexSearchPattern.
+    // Matches do not span across wrapped lines.
+    [[nodiscard]] std::optional<CellLocation> searchRegex(RegexSearchPattern const& pattern,
+                                                          CellLocation startPosition) override;
+    [[nodiscard]] std::optional<CellLocation> searchRegexReverse(RegexSearchPattern const& pattern,
+                                                                 CellLocation startPosition) override;
+
     [[nodiscard]] Cell& usePreviousCell() noexcept
     {
         return useCellAt(_lastCursorPosition.line, _lastCursorPosition.column);
@@ -503,6 +543,14 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     [[nodiscard]] Grid<Cell> const& grid() const noexcept { return _grid; }
     [[nodiscard]] Grid<Cell>& grid() noexcept { return _grid; }
 
+    /// @returns the number of bytes of the pixel buffer of the Sixel image most recently received, if any.
+    [[nodiscard]] size_t sixelImageMemoryUsage() const noexcept;
+
+    /// Shows the sixel bands completed so far of the Sixel image being received, unless none have been
+    /// completed since they have been shown last, or that was less than a frame interval ago.
+    /// The preview is replaced by the image itself once that is complete.
+    void publishImagePreview() override;
+
     /// @returns true iff given absolute line number is wrapped, false otherwise.
     [[nodiscard]] bool isLineWrapped(LineOffset lineNumber) const noexcept
     {
@@ -539,9 +587,31 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
 
     void enableLineFlags(LineOffset lineOffset, LineFlags flags, bool enable) noexcept override
     {
-        _grid.lineAt(lineOffset).setFlag(flags, enable);
+        _grid.enableLineFlags(lineOffset, flags, enable);
     }
 
+    [[nodiscard]] std::optional<LineOffset> findMarkedLineAbove(LineOffset line) const noexcept override
+    {
+        return _grid.findMarkedLineAbove(line);
+    }
+
+    [[nodiscard]] std::optional<LineOffset> findMarkedLineBelow(LineOffset line) const noexcept override
+    {
+        return _grid.findMarkedLineBelow(line, boxed_cast<LineOffset>(pageSize().lines) - 1);
+    }
+
+    [[nodiscard]] std::optional<CommandLines> command(size_t n) const noexcept override
+    {
+        return _grid.command(n, _cursor.position.line);
+    }
+
+    [[nodiscard]] std::optional<size_t> commandAt(LineOffset line) const noexcept override
+    {
+        return _grid.commandAt(line);
+    }
+
+    [[nodiscard]] size_t commandCount() const noexcept override { return _grid.commandIndex().size(); }
+
     [[nodiscard]] bool isLineFlagEnabledAt(LineOffset line, LineFlags flags) const noexcept override
     {
         return _grid.lineAt(line).isFlagEnabled(flags);
@@ -559,6 +629,35 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
         return _grid.lineAt(line).empty();
     }
 
+    [[nodiscard]] std::optional<LineOffset> findParagraphBoundaryAbove(
+        LineOffset line) const noexcept override
+    {
+        return _grid.findParagraphBoundaryAbove(line);
+    }
+
+    [[nodiscard]] std::optional<LineOffset> findParagraphBoundaryBelow(
+        LineOffset line) const noexcept override
+    {
+        return _grid.findParagraphBoundaryBelow(line, boxed_cast<LineOffset>(pageSize().lines) - 1);
+    }
+
+    [[nodiscard]] std::optional<CellLocation> findPairLeft(CellLocation from,
+                                                           char32_t left,
+                                                           char32_t right,
+                                                           int initialDepth) const override
+    {
+        return _grid.findPairLeft(from, left, right, initialDepth);
+    }
+
+    [[nodiscard]] std::optional<CellLocation> findPairRight(CellLocation from,
+                                                            char32_t left,
+                                                            char32_t right,
+                                                            int initialDepth) const override
+    {
+        return _grid.findPairRight(
+            from, left, right, initialDepth, boxed_cast<LineOffset>(pageSize().lines) - 1);
+    }
+
     [[nodiscard]] uint8_t cellWidthAt(CellLocation position) const noexcept override
     {
         return _grid.lineAt(position.line).cellWidthAt(position.column);
@@ -566,16 +665,9 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
 
     [[nodiscard]] LineCount historyLineCount() const noexcept override { return _grid.historyLineCount(); }
 
-    [[nodiscard]] HyperlinkId hyperlinkIdAt(CellLocation position) const noexcept override
-    {
-        auto const& line = _grid.lineAt(position.line);
-        if (line.isTrivialBuffer())
-        {
-            TrivialLineBuffer const& lineBuffer = line.trivialBuffer();
-            return lineBuffer.hyperlink;
-        }
-        return at(position).hyperlink();
-    }
+    [[nodiscard]] HyperlinkId hyperlinkIdAt(CellLocation position) const noexcept override;
+    [[nodiscard]] std::optional<DetectedHyperlink> detectedHyperlinkAt(
+        CellLocation position) const noexcept override;
 
     [[nodiscard]] std::shared_ptr<HyperlinkInfo const> hyperlinkAt(CellLocation pos) const noexcept override;
 
@@ -587,6 +679,10 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     void hardReset();
     void applyPageSizeToMainDisplay(PageSize pageSize);
 
+    /// Applies the page size like applyPageSizeToMainDisplay(), but discards the page contents
+    /// instead of reshaping them, for a page that is to be cleared right after.
+    void discardPageAndResize(PageSize pageSize);
+
     void saveCursor() override;
     void restoreCursor() override;
     void restoreCursor(Cursor const& savedCursor);
@@ -599,9 +695,11 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     template <typename... Ts>
     void reply(std::string_view message, Ts const&... args)
     {
-        reply(std::vformat(message, std::make_format_args(args...)));
+        replyFormatted(message, std::make_format_args(args...));
     }
 
+    void replyFormatted(std::string_view message, std::format_args args);
+
   private:
     void writeTextInternal(char32_t codepoint);
 
@@ -611,6 +709,26 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     /// @returns the string view of the UTF-8 text that could not be emplaced.
     std::string_view tryEmplaceChars(std::string_view chars, size_t cellCount) noexcept;
     size_t emplaceCharsIntoCurrentLine(std::string_view chars, size_t cellCount) noexcept;
+
+    /// Tests whether @p cellCount columns of text written from the beginning of the trivial @p line
+    /// replace all of its text, so that the line need not be inflated to write it.
+    [[nodiscard]] bool isTriviallyOverwritable(Line<Cell> const& line, size_t cellCount) const noexcept;
+
+    /// Writes US-ASCII text directly into the cells of the current line, bypassing UTF-8 decoding
+    /// and grapheme cluster segmentation on a per-character basis.
+    ///
+    /// Text in charsets other than US-ASCII is mapped as a whole, in a single table driven loop.
+    ///
+    /// @returns false if the text could not be written this way (e.g. it contains non US-ASCII
+    ///          characters), in which nothing has been written.
+    bool tryWriteASCII(std::string_view text) noexcept;
+
+    /// Writes text of wide CJK characters, that never join each other, directly into the cells of the
+    /// current line, bypassing UTF-8 decoding and grapheme cluster segmentation in the VT parser and
+    /// looking up neither their width nor grapheme cluster break properties.
+    ///
+    /// @returns false if the text could not be written this way, in which nothing has been written.
+    bool tryWriteWideText(std::string_view text) noexcept;
     [[nodiscard]] bool isContiguousToCurrentLine(std::string_view continuationChars) const noexcept;
     void advanceCursorAfterWrite(ColumnCount n) noexcept;
 
@@ -622,6 +740,7 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     void linefeed(ColumnOffset column);
 
     void writeCharToCurrentAndAdvance(char32_t codepoint) noexcept;
+    void writeCharToCurrentAndAdvance(char32_t codepoint, uint8_t width) noexcept;
     void clearAndAdvance(int oldWidth, int newWidth) noexcept;
 
     void scrollUp(LineCount n, GraphicsAttributes sgr, Margin margin);
@@ -635,9 +754,24 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
 
     [[nodiscard]] std::unique_ptr<ParserExtension> hookSTP(Sequence const& seq);
     [[nodiscard]] std::unique_ptr<ParserExtension> hookSixel(Sequence const& seq);
+    /// @returns where a Sixel image received now is going to be shown.
+    [[nodiscard]] CellLocation sixelImageTopLeft() const noexcept;
     [[nodiscard]] std::unique_ptr<ParserExtension> hookDECRQSS(Sequence const& seq);
     [[nodiscard]] std::unique_ptr<ParserExtension> hookXTGETTCAP(Sequence const& seq);
 
+    // {{{ kitty graphics protocol
+    void kittyGraphics(std::string_view text);
+    void displayKittyImage(KittyGraphicsCommand const& command, std::shared_ptr<Image const> image);
+    void deleteKittyImages(KittyGraphicsCommand const& command);
+    void replyKittyGraphics(KittyGraphicsCommand const& command, std::string_view message);
+
+    /// @returns true if the cells of @p placement still show it where it has been displayed.
+    [[nodiscard]] bool isShowingKittyPlacement(KittyGraphics::Placement const& placement) const;
+
+    /// Clears the cells of @p placement that still show it.
+    void clearKittyPlacement(KittyGraphics::Placement const& placement);
+    // }}}
+
     gsl::not_null<Terminal*> _terminal;
     gsl::not_null<Settings*> _settings;
     gsl::not_null<Margin*> _margin;
@@ -650,6 +784,20 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     Line<Cell>* _currentLine = nullptr;
     std::unique_ptr<SixelImageBuilder> _sixelImageBuilder;
 
+    struct SixelPreview
+    {
+        CellLocation topLeft;                        // where the image is going to be shown
+        Height height;                               // of the image shown so far
+        std::chrono::steady_clock::time_point time; // when the image has been shown last
+    };
+    std::optional<SixelPreview> _sixelPreview; // of the Sixel image being received, if any
+
+    // Text written by tryWriteASCII() as mapped by a charset other than US-ASCII, reused across calls.
+    std::u32string _charsetMappedText;
+
+    // Lines (with their trailing CR, if any) to be written by the current batch of writeTextLines().
+    std::vector<std::string_view> _bulkLines;
+
 #if defined(LIBTERMINAL_LOG_TRACE)
     std::atomic<bool> _logCharTrace = true;
     std::string _pendingCharTraceLog;
@@ -2,9 +2,12 @@
 #pragma once
 
 #include <vtbackend/Color.h>
+#include <vtbackend/CommandIndex.h>
 #include <vtbackend/Cursor.h>
 #include <vtbackend/Hyperlink.h>
+#include <vtbackend/HyperlinkDetector.h>
 #include <vtbackend/Line.h>
+#include <vtbackend/RegexSearch.h>
 #include <vtbackend/Sequence.h>
 
 #include <crispy/algorithm.h>
@@ -44,24 +47,60 @@ class ScreenBase: public SequenceHandler
     [[nodiscard]] virtual CellFlags cellFlagsAt(CellLocation position) const noexcept = 0;
     [[nodiscard]] virtual LineFlags lineFlagsAt(LineOffset line) const noexcept = 0;
     virtual void enableLineFlags(LineOffset lineOffset, LineFlags flags, bool enable) noexcept = 0;
+    /// @returns the nearest marked line above @p line, if any.
+    [[nodiscard]] virtual std::optional<LineOffset> findMarkedLineAbove(LineOffset line) const noexcept = 0;
+    /// @returns the nearest marked line below @p line within the main page, if any.
+    [[nodiscard]] virtual std::optional<LineOffset> findMarkedLineBelow(LineOffset line) const noexcept = 0;
+    /// @returns the lines of the n-th most recent shell command, 0 being the most recent one, if any.
+    [[nodiscard]] virtual std::optional<CommandLines> command(size_t n) const noexcept = 0;
+    /// @returns the position from the most recent shell command of the one @p line belongs to, if any.
+    [[nodiscard]] virtual std::optional<size_t> commandAt(LineOffset line) const noexcept = 0;
+    /// @returns the number of shell commands indexed.
+    [[nodiscard]] virtual size_t commandCount() const noexcept = 0;
     [[nodiscard]] virtual bool isLineFlagEnabledAt(LineOffset line, LineFlags flags) const noexcept = 0;
     [[nodiscard]] virtual std::string lineTextAt(LineOffset line,
                                                  bool stripLeadingSpaces = true,
                                                  bool stripTrailingSpaces = true) const noexcept = 0;
     [[nodiscard]] virtual bool isLineEmpty(LineOffset line) const noexcept = 0;
+    /// @returns the nearest empty line above @p line that precedes a non-empty one, if any.
+    [[nodiscard]] virtual std::optional<LineOffset> findParagraphBoundaryAbove(
+        LineOffset line) const noexcept = 0;
+    /// @returns the nearest empty line below @p line that follows a non-empty one within the main page.
+    [[nodiscard]] virtual std::optional<LineOffset> findParagraphBoundaryBelow(
+        LineOffset line) const noexcept = 0;
+    /// @returns the @p left character pairing up with the cells from @p from backwards, if any.
+    [[nodiscard]] virtual std::optional<CellLocation> findPairLeft(CellLocation from,
+                                                                   char32_t left,
+                                                                   char32_t right,
+                                                                   int initialDepth) const = 0;
+    /// @returns the @p right character pairing up with the cells from @p from forwards, if any.
+    [[nodiscard]] virtual std::optional<CellLocation> findPairRight(CellLocation from,
+                                                                    char32_t left,
+                                                                    char32_t right,
+                                                                    int initialDepth) const = 0;
     [[nodiscard]] virtual uint8_t cellWidthAt(CellLocation position) const noexcept = 0;
     [[nodiscard]] virtual LineCount historyLineCount() const noexcept = 0;
+    /// @returns the ID of the hyperlink at @p position, be it set via OSC 8 or detected in the text.
     [[nodiscard]] virtual HyperlinkId hyperlinkIdAt(CellLocation position) const noexcept = 0;
+    /// @returns the hyperlink detected in the text at @p position, if it is not linked via OSC 8.
+    [[nodiscard]] virtual std::optional<DetectedHyperlink> detectedHyperlinkAt(
+        CellLocation position) const noexcept = 0;
     [[nodiscard]] virtual std::shared_ptr<HyperlinkInfo const> hyperlinkAt(
         CellLocation pos) const noexcept = 0;
     virtual void inspect(std::string const& message, std::ostream& os) const = 0;
     virtual void moveCursorTo(LineOffset line, ColumnOffset column) = 0; // CUP
     virtual void updateCursorIterator() noexcept = 0;
+    /// Shows the part of the image currently being received that is complete so far, if any.
+    virtual void publishImagePreview() = 0;
 
     [[nodiscard]] virtual std::optional<CellLocation> search(std::u32string_view searchText,
                                                              CellLocation startPosition) = 0;
     [[nodiscard]] virtual std::optional<CellLocation> searchReverse(std::u32string_view searchText,
                                                                     CellLocation startPosition) = 0;
+    [[nodiscard]] virtual std::optional<CellLocation> searchRegex(RegexSearchPattern const& pattern,
+                                                                  CellLocation startPosition) = 0;
+    [[nodiscard]] virtual std::optional<CellLocation> searchRegexReverse(RegexSearchPattern const& pattern,
+                                                                         CellLocation startPosition) = 0;
 
   protected:
     Cursor _cursor {};
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/MockTerm.h>
+#include <vtbackend/Screen.h>
+#include <vtbackend/cell/CompactCell.h>
+#include <vtbackend/cell/SimpleCell.h>
+#include <vtbackend/primitives.h>
+
+#include <vtpty/MockPty.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+using namespace vtbackend;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+auto constexpr Size = PageSize { LineCount(50), ColumnCount(160) };
+
+template <typename Cell>
+auto constexpr LayoutOf = std::is_same_v<Cell, SimpleCell> ? CellLayout::Simple : CellLayout::Compact;
+
+// Writes a page worth of lines to the screen of the given cell type, line by line,
+// just like the parser does it, scrolling the page into the history.
+template <typename Cell>
+void writePage(Screen<Cell>& screen, auto&& writeLine)
+{
+    for (int line = 0; line < Size.lines.as<int>(); ++line)
+    {
+        writeLine(screen);
+        screen.writeTextEnd();
+        screen.crlf();
+    }
+}
+
+template <typename Cell>
+void benchmarkWriteText(auto&& writeLine)
+{
+    auto mock = MockTerm<vtpty::MockPty>(Size, LineCount(1000), 1024, LayoutOf<Cell>);
+    mock.terminal.visitPrimaryScreen([&](auto& screen) {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(screen)>, Screen<Cell>>)
+        {
+            BENCHMARK("page")
+            {
+                writePage(screen, writeLine);
+                return screen.realCursorPosition().line;
+            };
+        }
+    });
+}
+
+} // namespace
+
+TEMPLATE_TEST_CASE("Screen.writeText.ASCII", "[screen]", SimpleCell, CompactCell)
+{
+    auto constexpr Sentence = "The quick brown fox jumps over the lazy dog. "sv;
+    auto text = std::string {};
+    while (text.size() < Size.columns.as<size_t>())
+        text += Sentence;
+    text.resize(Size.columns.as<size_t>());
+
+    benchmarkWriteText<TestType>(
+        [&](auto& screen) { screen.writeText(std::string_view { text }, Size.columns.as<size_t>()); });
+}
+
+TEMPLATE_TEST_CASE("Screen.writeText.CJK", "[screen]", SimpleCell, CompactCell)
+{
+    auto constexpr Text = U"漢字仮名交じり文한국어中文字符"sv;
+
+    benchmarkWriteText<TestType>([&](auto& screen) {
+        for (size_t column = 0; column + 2 <= Size.columns.as<size_t>(); column += 2)
+            screen.writeText(Text[(column / 2) % Text.size()]);
+    });
+}
+
+TEMPLATE_TEST_CASE("Screen.writeText.Emoji", "[screen]", SimpleCell, CompactCell)
+{
+    // Emoji presentation sequences, skin tone modifiers, and ZWJ sequences, two columns each.
+    auto constexpr Sequences = std::array {
+        U"😀"sv, U"❤️"sv, U"👍🏽"sv, U"👨‍👩‍👧‍👦"sv, U"🏳️‍🌈"sv,
+    };
+
+    benchmarkWriteText<TestType>([&](auto& screen) {
+        for (size_t column = 0; column + 2 <= Size.columns.as<size_t>(); column += 2)
+            for (char32_t const codepoint: Sequences[(column / 2) % Sequences.size()])
+                screen.writeText(codepoint);
+    });
+}
@@ -6,6 +6,7 @@
 #include <vtbackend/primitives.h>
 #include <vtbackend/test_helpers.h>
 
+#include <crispy/base64.h>
 #include <crispy/escape.h>
 #include <crispy/utils.h>
 
@@ -290,6 +291,103 @@ TEST_CASE("writeText.bulk.H", "[screen]")
     CHECK(screen.cursor().position == CellLocation { LineOffset(1), ColumnOffset(9) });
 }
 
+// Text overwrites cells of an already inflated line, including half of a wide character.
+TEST_CASE("writeText.bulk.I", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(6) }, LineCount(1) };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("A\xE4\xB8\xAD" "BC"); // U+4E2D takes two columns
+    REQUIRE(screen.grid().lineText(LineOffset(0)) == "A\xE4\xB8\xAD" "BC ");
+
+    mock.writeToScreen("\r\033[31mxy");
+    logScreenText(screen, "final state");
+    CHECK(screen.grid().lineText(LineOffset(0)) == "xy BC ");
+    CHECK(screen.at(LineOffset(0), ColumnOffset(0)).foregroundColor() == IndexedColor::Red);
+    CHECK(screen.at(LineOffset(0), ColumnOffset(1)).foregroundColor() == IndexedColor::Red);
+    CHECK(!screen.at(LineOffset(0), ColumnOffset(2)).isFlagEnabled(CellFlag::WideCharContinuation));
+    CHECK(screen.at(LineOffset(0), ColumnOffset(3)).foregroundColor() == DefaultColor());
+    CHECK(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(2) });
+
+    // Overwriting the right half of a wide character erases its left half, too.
+    mock.writeToScreen("\r\033[m\xE4\xB8\xAD\033[D" "z");
+    CHECK(screen.grid().lineText(LineOffset(0)) == " z BC ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(2) });
+}
+
+// Text of wide CJK characters is written into an already inflated line.
+TEST_CASE("writeText.bulk.wide", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(10) }, LineCount(1) };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("A\033[31m\xE6\x97\xA5\xE6\x9C\xAC\xE3\x83\x86"); // U+65E5 U+672C U+30C6
+    CHECK(screen.grid().lineText(LineOffset(0)) == "A\xE6\x97\xA5\xE6\x9C\xAC\xE3\x83\x86   ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(7) });
+    for (auto const column: { 1, 3, 5 })
+    {
+        auto const& cell = screen.at(LineOffset(0), ColumnOffset(column));
+        CHECK(cell.width() == 2);
+        CHECK(cell.foregroundColor() == IndexedColor::Red);
+        auto const& continuation = screen.at(LineOffset(0), ColumnOffset(column + 1));
+        CHECK(continuation.isFlagEnabled(CellFlag::WideCharContinuation));
+    }
+
+    // A combining character still joins the last wide character.
+    mock.writeToScreen("\xE3\x82\x99"); // U+3099 COMBINING KATAKANA-HIRAGANA VOICED SOUND MARK
+    CHECK(screen.at(LineOffset(0), ColumnOffset(5)).codepointCount() == 2);
+    CHECK(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(7) });
+}
+
+// Text in DEC Special Graphics, as used for line drawing, is mapped as a whole.
+TEST_CASE("writeText.bulk.charset", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(6) }, LineCount(1) };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("\033(0lqqqk\033(B");
+    CHECK(screen.grid().lineText(LineOffset(0)) == "┌───┐ ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(5) });
+
+    // A single shift (here into US-ASCII in G2) only applies to the first character of the run.
+    mock.writeToScreen("\r\n\033(0\033Nqqq\033(B");
+    CHECK(screen.grid().lineText(LineOffset(1)) == "q──   ");
+}
+
+// Progress bars redrawing their line after a carriage return keep it trivial.
+TEST_CASE("writeText.bulk.carriage_return_overwrite", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(10) }, LineCount(1) };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("10% [#  ]");
+    mock.writeToScreen("\r20% [## ]");
+    CHECK(screen.grid().lineAt(LineOffset(0)).isTrivialBuffer());
+    CHECK(screen.grid().lineText(LineOffset(0)) == "20% [## ] ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(0), ColumnOffset(9) });
+
+    // Shorter text leaves the remainder of the previous text in place.
+    mock.writeToScreen("\rdone");
+    CHECK(screen.grid().lineText(LineOffset(0)) == "done[## ] ");
+}
+
+// Lines scrolled in by batches read the same as lines scrolled in one by one.
+TEST_CASE("writeText.bulk.lines", "[screen]")
+{
+    auto const text = std::string_view { "one\r\ntwo\r\n\r\nfour\r\nfive\nsix\r\nseven\r\neight\r\n" };
+    auto batched = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    auto single = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    batched.writeToScreen(text);
+    for (char const ch: text)
+        single.writeToScreen(std::string_view { &ch, 1 });
+
+    auto const& screen = batched.terminal.primaryScreen();
+    auto const& reference = single.terminal.primaryScreen();
+    CHECK(screen.renderMainPageText() == "seven     \neight     \n          \n");
+    CHECK(screen.grid().lineText(LineOffset(-1)) == "    six   ");
+    REQUIRE(screen.historyLineCount() == reference.historyLineCount());
+    for (auto line = -unbox(screen.historyLineCount()); line < 3; ++line)
+        CHECK(screen.grid().lineText(LineOffset(line)) == reference.grid().lineText(LineOffset(line)));
+    CHECK(screen.cursor().position == reference.cursor().position);
+    CHECK(screen.cursor().position == CellLocation { LineOffset(2), ColumnOffset(0) });
+}
+
 // TODO: Test spanning writes over all history and then reusing old lines.
 // Verify we do not leak any old cell attribs.
 
@@ -2737,6 +2835,26 @@ TEST_CASE("captureBuffer", "[screen]")
     }
 }
 
+TEST_CASE("captureBuffer.logicalLines", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(4), ColumnCount(5) }, LineCount { 5 } };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("ABCDEFGHIJKL\r\nM N\r\n\r\nOP");
+    REQUIRE(screen.historyLineCount() == LineCount { 2 });
+
+    SECTION("actual")
+    {
+        screen.captureBuffer(LineCount(6), false);
+        CHECK(e(mock.terminal.peekInput()) == e("\033^314;ABCDE\nFGHIJ\nKL\nM N\nOP\n\033\\\033^314;\033\\"));
+    }
+    SECTION("logical")
+    {
+        // Wrapped lines are joined, regardless of whether they are in history or on the main page.
+        screen.captureBuffer(LineCount(6), true);
+        CHECK(e(mock.terminal.peekInput()) == e("\033^314;ABCDEFGHIJKL\nM N\nOP\n\033\\\033^314;\033\\"));
+    }
+}
+
 TEST_CASE("render into history", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(5) }, LineCount { 5 } };
@@ -3046,6 +3164,36 @@ TEST_CASE("searchReverse", "[screen]")
     }
 }
 
+TEST_CASE("searchRegexReverse", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(8) }, LineCount(10) };
+    mock.writeToScreen("E1234 ok\r\n"); // -2
+    mock.writeToScreen("fine\r\n");     // -1
+    mock.writeToScreen("err E42\r\n");  //  0
+    mock.writeToScreen("E7 E8\r\n");    //  1
+    auto& screen = mock.terminal.primaryScreen();
+    auto const cursorPosition = screen.cursor().position;
+
+    auto const pattern = RegexSearchPattern::compile(U"E[0-9]+");
+    REQUIRE(pattern.has_value());
+    CHECK(pattern->requiredLiteral() == "E");
+
+    auto const e8 = screen.searchRegexReverse(*pattern, cursorPosition);
+    REQUIRE(e8.value() == CellLocation { LineOffset(1), ColumnOffset(3) });
+
+    auto const e7 = screen.searchRegexReverse(*pattern, CellLocation { LineOffset(1), ColumnOffset(2) });
+    REQUIRE(e7.value() == CellLocation { LineOffset(1), ColumnOffset(0) });
+
+    auto const e42 = screen.searchRegexReverse(*pattern, CellLocation { LineOffset(0), ColumnOffset(7) });
+    REQUIRE(e42.value() == CellLocation { LineOffset(0), ColumnOffset(4) });
+
+    auto const e1234 = screen.searchRegexReverse(*pattern, CellLocation { LineOffset(-1), ColumnOffset(7) });
+    REQUIRE(e1234.value() == CellLocation { LineOffset(-2), ColumnOffset(0) });
+
+    auto const forward = screen.searchRegex(*pattern, CellLocation { LineOffset(-2), ColumnOffset(1) });
+    REQUIRE(forward.value() == CellLocation { LineOffset(0), ColumnOffset(4) });
+}
+
 TEST_CASE("findMarkerDownwards", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(4) }, LineCount(10) };
@@ -3458,6 +3606,25 @@ TEST_CASE("resize", "[screen]")
     // TODO: what do we want to do when re resize to {0, y}, {x, 0}, {0, 0}?
 }
 
+TEST_CASE("resize.alternate_screen", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(3) }, LineCount(10) };
+    auto const& screen = mock.terminal.alternateScreen();
+    mock.writeToScreen("\033[?1049hAB\r\nCD\033[?1049l");
+
+    // The inactive alternate screen keeps its size until it is switched to.
+    mock.terminal.resizeScreen({ LineCount(3), ColumnCount(4) });
+    CHECK(screen.pageSize() == PageSize { LineCount(2), ColumnCount(3) });
+
+    mock.writeToScreen("\033[?1049h");
+    CHECK(screen.pageSize() == PageSize { LineCount(3), ColumnCount(4) });
+    CHECK("    \n    \n    \n" == screen.renderMainPageText());
+    CHECK(screen.logicalCursorPosition() == CellLocation { LineOffset(1), ColumnOffset(2) });
+
+    mock.writeToScreen("\033[HWXYZ");
+    CHECK("WXYZ\n    \n    \n" == screen.renderMainPageText());
+}
+
 // {{{ DECCRA
 // TODO: also verify attributes have been copied
 // TODO: also test with: DECOM enabled
@@ -3706,6 +3873,34 @@ TEST_CASE("Sixel.status_line", "[screen]")
     }
 }
 
+TEST_CASE("Sixel.progressive", "[screen]")
+{
+    auto const pageSize = PageSize { LineCount(5), ColumnCount(5) };
+    auto mock = MockTerm { pageSize, LineCount(5) };
+    mock.terminal.setCellPixelSize(ImageSize { Width(10), Height(10) });
+    auto const& screen = mock.terminal.primaryScreen();
+
+    auto const imageAt = [&](LineOffset line) -> Image const* {
+        auto const fragment = screen.at(line, ColumnOffset(0)).imageFragment();
+        return fragment ? &fragment->rasterizedImage().image() : nullptr;
+    };
+
+    // The first band of a 10x12 image (at aspect ratio 1:1) is shown while the second one is received.
+    mock.writeToScreen("\033P9q!10~-!10~");
+    auto const* preview = imageAt(LineOffset(0));
+    REQUIRE(preview);
+    CHECK(preview->size() == ImageSize { Width(10), Height(6) });
+    CHECK(!imageAt(LineOffset(1)));
+    CHECK(screen.cursor().position == CellLocation {});
+
+    // The complete image replaces the preview.
+    mock.writeToScreen("\033\\");
+    auto const* image = imageAt(LineOffset(0));
+    REQUIRE(image);
+    CHECK(image->size() == ImageSize { Width(10), Height(12) });
+    CHECK(imageAt(LineOffset(1)) == image);
+}
+
 TEST_CASE("DECSTR", "[screen]")
 {
     // Create a 10x3x5 grid and render a 7x5 image causing one a line-scroll by one.
@@ -3744,6 +3939,32 @@ TEST_CASE("SGRSAVE and SGRRESTORE", "[screen]")
     REQUIRE(cursor.graphicsRendition.flags.contains(CellFlag::Underline));
 }
 
+TEST_CASE("SGR fast path", "[screen]")
+{
+    auto mock = MockTerm { ColumnCount(8), LineCount(2) };
+    auto& screen = mock.terminal.primaryScreen();
+
+    // Complete SGR sequences interleaved with text, including sub-parameters.
+    mock.writeToScreen("A\033[1;31mB\033[38:2::10:20:30;4:3mC\033[mD");
+    CHECK(screen.at(LineOffset(0), ColumnOffset(0)).foregroundColor() == DefaultColor());
+    CHECK(screen.at(LineOffset(0), ColumnOffset(1)).foregroundColor() == IndexedColor::Red);
+    CHECK(screen.at(LineOffset(0), ColumnOffset(1)).isFlagEnabled(CellFlag::Bold));
+    CHECK(screen.at(LineOffset(0), ColumnOffset(2)).foregroundColor() == Color { RGBColor { 10, 20, 30 } });
+    CHECK(screen.at(LineOffset(0), ColumnOffset(2)).isFlagEnabled(CellFlag::CurlyUnderlined));
+    CHECK(screen.at(LineOffset(0), ColumnOffset(3)).foregroundColor() == DefaultColor());
+    CHECK(!screen.at(LineOffset(0), ColumnOffset(3)).isFlagEnabled(CellFlag::Bold));
+
+    // SGR split across fragments must still be handled by the state machine.
+    mock.writeToScreen("\033[4");
+    mock.writeToScreen("2mE");
+    CHECK(screen.at(LineOffset(0), ColumnOffset(4)).backgroundColor() == IndexedColor::Green);
+
+    // Private or intermediate-bearing sequences ending in 'm' must not be taken as SGR.
+    mock.writeToScreen("\033[0m\033[?1mF");
+    CHECK(screen.at(LineOffset(0), ColumnOffset(5)).backgroundColor() == DefaultColor());
+    CHECK(mainPageText(screen) == "ABCDEF  \n        \n");
+}
+
 TEST_CASE("LS1 and LS0", "[screen]")
 {
     auto mock = MockTerm { ColumnCount(8), LineCount(4) };
@@ -3781,6 +4002,139 @@ TEST_CASE("LS1 and LS0", "[screen]")
 
 // TODO: Sixel: image that exceeds available lines
 
+namespace
+{
+/// @returns a kitty graphics command transmitting an opaque red 20x10 RGBA image, given additional keys.
+std::string kittyRedImage(std::string_view keys)
+{
+    auto pixels = std::string {};
+    for (auto i = 0; i < 20 * 10; ++i)
+        pixels += "\xFF\x00\x00\xFF"s;
+    return std::format("\033_Gf=32,s=20,v=10,{};{}\033\\", keys, crispy::base64::encode(pixels));
+}
+} // namespace
+
+TEST_CASE("KittyGraphics.transmit_and_display", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(2) };
+    mock.terminal.setCellPixelSize(ImageSize { Width(10), Height(10) });
+
+    mock.writeToScreen(kittyRedImage("a=T,i=1"));
+
+    auto const& screen = mock.terminal.primaryScreen();
+    CHECK(screen.cursor().position == CellLocation { .line = LineOffset(0), .column = ColumnOffset(2) });
+    for (auto const column: { ColumnOffset(0), ColumnOffset(1) })
+    {
+        auto const fragment = screen.at(LineOffset(0), column).imageFragment();
+        REQUIRE(fragment);
+        CHECK(fragment->offset() == CellLocation { .line = LineOffset(0), .column = column });
+    }
+    CHECK(!screen.at(LineOffset(0), ColumnOffset(2)).imageFragment());
+
+    // The image data is decoded asynchronously, answering once done.
+    mock.terminal.waitForImageDecoding();
+    CHECK(e(mock.terminal.peekInput()) == e("\033_Gi=1;OK\033\\"));
+    auto const fragment = screen.at(LineOffset(0), ColumnOffset(1)).imageFragment();
+    REQUIRE(fragment->rasterizedImage().image().decoded());
+    auto const pixels = fragment->data();
+    REQUIRE(pixels.size() == 10 * 10 * 4);
+    CHECK(pixels[0] == 0xFF);
+    CHECK(pixels[1] == 0x00);
+}
+
+TEST_CASE("KittyGraphics.display_clamps_cell_span", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(2) };
+    auto const& screen = mock.terminal.primaryScreen();
+
+    // Neither an unknown cell size nor a span far beyond the page scroll the page by more than it has.
+    mock.writeToScreen(kittyRedImage("a=T,i=1,q=1,c=1000000,r=1000000"));
+    CHECK(screen.cursor().position == CellLocation { .line = LineOffset(2), .column = ColumnOffset(4) });
+    CHECK(screen.at(LineOffset(0), ColumnOffset(0)).imageFragment());
+    CHECK(screen.at(LineOffset(2), ColumnOffset(4)).imageFragment());
+}
+
+TEST_CASE("KittyGraphics.overlong_command_dropped", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(2) };
+    mock.terminal.setCellPixelSize(ImageSize { Width(10), Height(10) });
+
+    mock.writeToScreen("\033_Ga=q,i=3;" + std::string(10000, 'A') + "\033\\");
+    mock.terminal.waitForImageDecoding();
+    CHECK(mock.terminal.peekInput().empty());
+    CHECK(!mock.terminal.kittyGraphics().findImage(3));
+
+    // Commands following it are processed again.
+    mock.writeToScreen(kittyRedImage("a=t,i=1"));
+    mock.terminal.waitForImageDecoding();
+    CHECK(e(mock.terminal.peekInput()) == e("\033_Gi=1;OK\033\\"));
+}
+
+TEST_CASE("KittyGraphics.display_replaces_placement", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(2) };
+    mock.terminal.setCellPixelSize(ImageSize { Width(10), Height(10) });
+    auto const& screen = mock.terminal.primaryScreen();
+
+    mock.writeToScreen(kittyRedImage("a=t,i=1,q=1"));
+    CHECK(!screen.at(LineOffset(0), ColumnOffset(0)).imageFragment());
+
+    mock.writeToScreen("\033_Ga=p,i=1,p=7,q=1\033\\");
+    REQUIRE(screen.at(LineOffset(0), ColumnOffset(0)).imageFragment());
+
+    // Displaying to the same placement again replaces it where it is, leaving the cursor alone.
+    mock.writeToScreen("\033[3;1H\033_Ga=p,i=1,p=7,q=1\033\\");
+    CHECK(screen.cursor().position == CellLocation { .line = LineOffset(2), .column = ColumnOffset(0) });
+    CHECK(screen.at(LineOffset(0), ColumnOffset(0)).imageFragment());
+    CHECK(!screen.at(LineOffset(2), ColumnOffset(0)).imageFragment());
+    mock.terminal.waitForImageDecoding();
+    CHECK(mock.terminal.peekInput().empty());
+}
+
+TEST_CASE("KittyGraphics.decoding_error", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(2) };
+    mock.terminal.setCellPixelSize(ImageSize { Width(10), Height(10) });
+    mock.terminal.settings().kittyGraphicsLocalMedia = true;
+
+    // The image data is found missing only once being decoded, forgetting the image then.
+    mock.writeToScreen("\033_Ga=t,t=f,f=32,s=20,v=10,i=2;"
+                       + crispy::base64::encode("/nonexistent/contour-kitty-image") + "\033\\");
+    mock.terminal.waitForImageDecoding();
+    CHECK(e(mock.terminal.peekInput()).starts_with(e("\033_Gi=2;EBADF:")));
+    CHECK(!mock.terminal.kittyGraphics().findImage(2));
+}
+
+TEST_CASE("KittyGraphics.local_media_disabled", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(2) };
+    mock.terminal.setCellPixelSize(ImageSize { Width(10), Height(10) });
+
+    // Files are not even looked up by default.
+    mock.writeToScreen("\033_Ga=t,t=f,f=32,s=20,v=10,i=2;" + crispy::base64::encode("/etc/hostname")
+                       + "\033\\");
+    CHECK(e(mock.terminal.peekInput()).starts_with(e("\033_Gi=2;EPERM:")));
+    CHECK(!mock.terminal.kittyGraphics().findImage(2));
+}
+
+TEST_CASE("KittyGraphics.delete", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(2) };
+    mock.terminal.setCellPixelSize(ImageSize { Width(10), Height(10) });
+    auto const& screen = mock.terminal.primaryScreen();
+
+    mock.writeToScreen(kittyRedImage("a=T,i=1,q=1"));
+    REQUIRE(screen.at(LineOffset(0), ColumnOffset(0)).imageFragment());
+
+    mock.writeToScreen("\033_Ga=d,d=I,i=1\033\\");
+    CHECK(!screen.at(LineOffset(0), ColumnOffset(0)).imageFragment());
+    CHECK(!screen.at(LineOffset(0), ColumnOffset(1)).imageFragment());
+
+    mock.writeToScreen("\033_Ga=p,i=1\033\\");
+    mock.terminal.waitForImageDecoding();
+    CHECK(e(mock.terminal.peekInput()) == e("\033_Gi=1;ENOENT:no such image\033\\"));
+}
+
 // TODO: SetForegroundColor
 // TODO: SetBackgroundColor
 // TODO: SetGraphicsRendition
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/SearchIndex.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace vtbackend
+{
+
+TrigramSignature TrigramSignature::of(std::u32string_view text) noexcept
+{
+    auto signature = TrigramSignature {};
+    auto run = size_t { 0 };
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] == 0)
+        {
+            run = 0;
+            continue;
+        }
+        if (++run >= 3)
+            signature.add(text[i - 2], text[i - 1], text[i]);
+    }
+    return signature;
+}
+
+void TrigramSignature::add(char32_t a, char32_t b, char32_t c) noexcept
+{
+    auto hash = (uint64_t { fold(a) } * 0x9E3779B97F4A7C15ull) ^ (uint64_t { fold(b) } * 0xC2B2AE3D27D4EB4Full)
+                ^ (uint64_t { fold(c) } * 0x165667B19E3779F9ull);
+    hash ^= hash >> 32;
+    auto const bit = hash % BitCount;
+    _bits[bit / 64] |= uint64_t { 1 } << (bit % 64);
+}
+
+bool TrigramSignature::contains(TrigramSignature const& other) const noexcept
+{
+    for (size_t i = 0; i < _bits.size(); ++i)
+        if ((_bits[i] & other._bits[i]) != other._bits[i])
+            return false;
+    return true;
+}
+
+void HistorySearchIndex::dropNewest(size_t count) noexcept
+{
+    _signatures.erase(std::prev(_signatures.end(), static_cast<ptrdiff_t>(std::min(count, size()))),
+                      _signatures.end());
+}
+
+void HistorySearchIndex::limit(size_t historyLineCount) noexcept
+{
+    if (size() > historyLineCount)
+        _signatures.erase(_signatures.begin(),
+                          std::next(_signatures.begin(), static_cast<ptrdiff_t>(size() - historyLineCount)));
+}
+
+bool HistorySearchIndex::mayContain(LineOffset line, TrigramSignature const& query) const noexcept
+{
+    if (line >= LineOffset(0))
+        return true;
+
+    auto const distance = static_cast<size_t>(-unbox(line));
+    if (distance > size())
+        return true;
+
+    return _signatures[size() - distance].contains(query);
+}
+
+} // namespace vtbackend
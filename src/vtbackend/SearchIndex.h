@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/primitives.h>
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string_view>
+
+namespace vtbackend
+{
+
+/**
+ * Compact set of the character trigrams occurring in a line of text.
+ *
+ * Codepoints are case-folded before hashing, so that the same signature serves both case sensitive
+ * and case insensitive searches. Like a Bloom filter, a signature may claim trigrams that do not occur
+ * in the text, but never misses one that does.
+ */
+class TrigramSignature
+{
+  public:
+    static constexpr size_t BitCount = 256;
+
+    /// Builds the signature of the given text, with each codepoint occupying one column.
+    ///
+    /// A zero codepoint denotes an empty cell, which no search text can match,
+    /// so no trigram spans over it.
+    [[nodiscard]] static TrigramSignature of(std::u32string_view text) noexcept;
+
+    /// Folds the given codepoint the same way case insensitive cell matching does.
+    [[nodiscard]] static constexpr char32_t fold(char32_t codepoint) noexcept
+    {
+        return codepoint >= U'A' && codepoint <= U'Z' ? codepoint - U'A' + U'a' : codepoint;
+    }
+
+    void add(char32_t a, char32_t b, char32_t c) noexcept;
+
+    /// @returns true if all trigrams of @p other are (possibly) contained in this signature.
+    [[nodiscard]] bool contains(TrigramSignature const& other) const noexcept;
+
+    [[nodiscard]] bool operator==(TrigramSignature const&) const noexcept = default;
+
+  private:
+    std::array<uint64_t, BitCount / 64> _bits {};
+};
+
+/**
+ * Trigram signatures of a Grid's most recent history lines.
+ *
+ * Lines are appended as they scroll into history and dropped as they fall off its far end,
+ * so that a search can skip lines that cannot possibly contain the search text without looking
+ * at their cells. The n-th signature from the back belongs to history line -n.
+ * History lines that are not covered by the index are always considered candidates.
+ */
+class HistorySearchIndex
+{
+  public:
+    /// Appends the signature of the line that just became history line -1.
+    void push(TrigramSignature signature) { _signatures.push_back(signature); }
+
+    /// Prepends the signature of the history line right above the oldest indexed one.
+    void pushOldest(TrigramSignature signature) { _signatures.push_front(signature); }
+
+    /// Drops the signatures of the given number of most recent history lines.
+    void dropNewest(size_t count) noexcept;
+
+    /// Drops the oldest signatures beyond the given history line count.
+    void limit(size_t historyLineCount) noexcept;
+
+    void clear() noexcept { _signatures.clear(); }
+
+    /// @returns the number of most recent history lines that are indexed.
+    [[nodiscard]] size_t size() const noexcept { return _signatures.size(); }
+
+    /// @returns false if @p line is an indexed history line that cannot contain text with signature @p query.
+    [[nodiscard]] bool mayContain(LineOffset line, TrigramSignature const& query) const noexcept;
+
+  private:
+    std::deque<TrigramSignature> _signatures;
+};
+
+} // namespace vtbackend
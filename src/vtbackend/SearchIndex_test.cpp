@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/SearchIndex.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+
+TEST_CASE("TrigramSignature.of", "[search]")
+{
+    auto const line = TrigramSignature::of(U"Hello, World");
+    CHECK(line.contains(TrigramSignature::of(U"World")));
+    CHECK(line.contains(TrigramSignature::of(U"hello")));
+    CHECK(line.contains(TrigramSignature::of(U"lo,")));
+
+    // Search texts shorter than a trigram do not narrow anything down.
+    CHECK(line.contains(TrigramSignature::of(U"xy")));
+    CHECK(TrigramSignature::of(U"xy") == TrigramSignature {});
+}
+
+TEST_CASE("TrigramSignature.empty_cells_break_trigrams", "[search]")
+{
+    auto const wide = std::u32string { U'a', U'b', 0, U'c', U'd' };
+    auto const signature = TrigramSignature::of(wide);
+    CHECK(signature == TrigramSignature {});
+    CHECK(TrigramSignature::of(U"abcd").contains(signature));
+}
+
+TEST_CASE("HistorySearchIndex.mayContain", "[search]")
+{
+    auto const query = TrigramSignature::of(U"needle");
+    auto index = HistorySearchIndex {};
+    index.push(TrigramSignature::of(U"haystack with a needle")); // becomes -3
+    index.push(TrigramSignature::of(U"just hay"));               // becomes -2
+    index.push(TrigramSignature::of(U"more hay"));               // becomes -1
+    REQUIRE(index.size() == 3);
+
+    CHECK(index.mayContain(LineOffset(-3), query));
+    CHECK(!index.mayContain(LineOffset(-2), query));
+    CHECK(!index.mayContain(LineOffset(-1), query));
+
+    // Lines not covered by the index are always candidates.
+    CHECK(index.mayContain(LineOffset(-4), query));
+    CHECK(index.mayContain(LineOffset(0), query));
+
+    index.dropNewest(1);
+    CHECK(index.size() == 2);
+    CHECK(index.mayContain(LineOffset(-2), query));
+    CHECK(!index.mayContain(LineOffset(-1), query));
+
+    index.limit(1);
+    CHECK(index.size() == 1);
+    CHECK(!index.mayContain(LineOffset(-1), query));
+    CHECK(index.mayContain(LineOffset(-2), query));
+
+    index.pushOldest(TrigramSignature::of(U"needle in history"));
+    CHECK(index.mayContain(LineOffset(-2), query));
+    CHECK(!index.mayContain(LineOffset(-1), query));
+}
@@ -99,7 +99,11 @@ class Selection
     [[nodiscard]] virtual bool extend(CellLocation to);
 
     /// Constructs a vector of ranges for this selection.
-    [[nodiscard]] virtual std::vector<Range> ranges() const;
+    [[nodiscard]] std::vector<Range> ranges() const;
+
+    /// Constructs the ranges of this selection within the given lines (inclusive),
+    /// one for each selected line, in ascending line order.
+    [[nodiscard]] virtual std::vector<Range> ranges(LineOffset top, LineOffset bottom) const;
 
     /// Marks the selection as completed.
     void complete();
@@ -126,7 +130,9 @@ class RectangularSelection: public Selection
                          OnSelectionUpdated onSelectionUpdated);
     [[nodiscard]] bool contains(CellLocation coord) const noexcept override;
     [[nodiscard]] bool intersects(Rect area) const noexcept override;
-    [[nodiscard]] std::vector<Range> ranges() const override;
+
+    using Selection::ranges;
+    [[nodiscard]] std::vector<Range> ranges(LineOffset top, LineOffset bottom) const override;
 };
 
 class LinearSelection final: public Selection
@@ -238,6 +238,31 @@ TEST_CASE("Selector.Linear", "[selector]")
         renderSelection(selector, selectedText);
         CHECK(selectedText.text == ",hi\n12345,67890\nfo");
     }
+
+    SECTION("ranges within lines")
+    {
+        auto selector = LinearSelection(
+            selectionHelper, CellLocation { .line = LineOffset(0), .column = ColumnOffset(8) }, []() {});
+        (void) selector.extend(CellLocation { .line = LineOffset(2), .column = ColumnOffset(1) });
+        selector.complete();
+
+        vector<Selection::Range> const bottom = selector.ranges(LineOffset(1), LineOffset(5));
+        REQUIRE(bottom.size() == 2);
+        CHECK(bottom[0].line == LineOffset(1));
+        CHECK(bottom[0].fromColumn == ColumnOffset(0));
+        CHECK(bottom[0].toColumn == ColumnOffset(10));
+        CHECK(bottom[1].line == LineOffset(2));
+        CHECK(bottom[1].fromColumn == ColumnOffset(0));
+        CHECK(bottom[1].toColumn == ColumnOffset(1));
+
+        vector<Selection::Range> const top = selector.ranges(LineOffset(-5), LineOffset(0));
+        REQUIRE(top.size() == 1);
+        CHECK(top[0].line == LineOffset(0));
+        CHECK(top[0].fromColumn == ColumnOffset(8));
+        CHECK(top[0].toColumn == ColumnOffset(10));
+
+        CHECK(selector.ranges(LineOffset(3), LineOffset(5)).empty());
+    }
 }
 
 TEST_CASE("Selector.LinearWordWise", "[selector]")
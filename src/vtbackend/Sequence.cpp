@@ -46,7 +46,7 @@ std::string Sequence::raw() const
         sstr << _finalChar;
 
     if (!_dataString.empty())
-        sstr << _dataString << "\033\\";
+        sstr << _dataString.view() << "\033\\";
 
     return sstr.str();
 }
@@ -76,7 +76,7 @@ string Sequence::text() const
         sstr << ' ' << _finalChar;
 
     if (!_dataString.empty())
-        sstr << " \"" << crispy::escape(_dataString) << "\" ST";
+        sstr << " \"" << crispy::escape(_dataString.view()) << "\" ST";
 
     return sstr.str();
 }
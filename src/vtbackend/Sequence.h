@@ -3,6 +3,8 @@
 
 #include <vtbackend/Functions.h>
 
+#include <crispy/small_string.h>
+
 #include <gsl/pointers>
 #include <gsl/span>
 
@@ -196,9 +198,15 @@ class Sequence
   public:
     size_t constexpr static MaxOscLength = 512; // NOLINT(readability-identifier-naming)
 
+    /// Number of bytes of intermediate characters (or OSC payload) stored without heap allocation.
+    size_t constexpr static InlineIntermediatesLength = 32; // NOLINT(readability-identifier-naming)
+
+    /// Number of bytes of the data string stored without heap allocation.
+    size_t constexpr static InlineDataLength = 32; // NOLINT(readability-identifier-naming)
+
     using Parameter = uint16_t;
-    using Intermediaries = std::string;
-    using DataString = std::string;
+    using Intermediaries = crispy::small_string<InlineIntermediatesLength>;
+    using DataString = crispy::small_string<InlineDataLength>;
     using Parameters = SequenceParameters;
 
   private:
@@ -244,9 +252,15 @@ class Sequence
     [[nodiscard]] Intermediaries& intermediateCharacters() noexcept { return _intermediateCharacters; }
     void setFinalChar(char ch) noexcept { _finalChar = ch; }
 
-    [[nodiscard]] DataString const& dataString() const noexcept { return _dataString; }
+    [[nodiscard]] std::string_view dataString() const noexcept { return _dataString; }
     [[nodiscard]] DataString& dataString() noexcept { return _dataString; }
 
+    /// @returns the number of bytes of heap memory held by the intermediate characters and the data string.
+    [[nodiscard]] size_t memoryUsage() const noexcept
+    {
+        return _intermediateCharacters.heapCapacity() + _dataString.heapCapacity();
+    }
+
     /// @returns this VT-sequence into a human readable string form.
     [[nodiscard]] std::string text() const;
 
@@ -259,6 +273,12 @@ class Sequence
         return select(selector(), availableDefinitions);
     }
 
+    [[nodiscard]] Function const* functionDefinition(
+        SupportedSequences const& supportedSequences) const noexcept
+    {
+        return supportedSequences.select(selector());
+    }
+
     /// Converts a FunctionSpinto a FunctionSelector, applicable for finding the corresponding
     /// FunctionDefinition.
     [[nodiscard]] FunctionSelector selector() const noexcept
@@ -285,10 +305,7 @@ class Sequence
     // accessors
     //
     [[nodiscard]] FunctionCategory category() const noexcept { return _category; }
-    [[nodiscard]] Intermediaries const& intermediateCharacters() const noexcept
-    {
-        return _intermediateCharacters;
-    }
+    [[nodiscard]] std::string_view intermediateCharacters() const noexcept { return _intermediateCharacters; }
     [[nodiscard]] char leaderSymbol() const noexcept { return _leaderSymbol; }
     [[nodiscard]] char finalChar() const noexcept { return _finalChar; }
 
@@ -358,6 +375,14 @@ class SequenceHandler
 
     virtual void executeControlCode(char controlCode) = 0;
     virtual void processSequence(Sequence const& sequence) = 0;
+
+    /// Processes an SGR sequence (CSI ... m) that is already known to be one,
+    /// so that no function definition lookup is required.
+    virtual void processGraphicsRendition(Sequence const& sequence) { processSequence(sequence); }
+
+    /// Processes the string of an APC (ESC _ ... ST), such as a kitty graphics command.
+    virtual void processApplicationProgramCommand(std::string_view command) { (void) command; }
+
     virtual void writeText(char32_t codepoint) = 0;
     virtual void writeText(std::string_view codepoints, size_t cellCount) = 0;
     virtual void writeTextEnd() = 0;
@@ -10,6 +10,7 @@
 
 #include <concepts>
 #include <memory>
+#include <string>
 #include <string_view>
 
 namespace vtbackend
@@ -63,6 +64,14 @@ class SequenceBuilder
         return _handler.maxBulkTextSequenceWidth();
     }
 
+    size_t printLines(std::string_view text)
+    {
+        if constexpr (requires { _handler.writeTextLines(text); })
+            return _handler.writeTextLines(text);
+        else
+            return 0;
+    }
+
     void printEnd() { _handler.writeTextEnd(); }
 
     void execute(char controlCode) { _handler.executeControlCode(controlCode); }
@@ -119,6 +128,24 @@ class SequenceBuilder
         handleSequence();
     }
 
+    /// Fast path for SGR sequences, bypassing the parser's state machine and function selection.
+    ///
+    /// @param parameters the SGR's parameter string, consisting only of digits, ';' and ':'.
+    void dispatchSGR(std::string_view parameters)
+    {
+        clear();
+        for (char const ch: parameters)
+            param(ch);
+        _sequence.setCategory(FunctionCategory::CSI);
+        _sequence.setFinalChar('m');
+        _parameterBuilder.fixiate();
+
+        if constexpr (requires { _handler.processGraphicsRendition(_sequence); })
+            _handler.processGraphicsRendition(_sequence);
+        else
+            _handler.processSequence(_sequence);
+    }
+
     void startOSC() { _sequence.setCategory(FunctionCategory::OSC); }
 
     void putOSC(char ch)
@@ -127,6 +154,13 @@ class SequenceBuilder
             _sequence.intermediateCharacters().push_back(ch);
     }
 
+    void putOSC(std::string_view chars)
+    {
+        auto& payload = _sequence.intermediateCharacters();
+        if (payload.size() + 1 < Sequence::MaxOscLength)
+            payload.append(chars.substr(0, Sequence::MaxOscLength - 1 - payload.size()));
+    }
+
     void dispatchOSC()
     {
         auto const [code, skipCount] = vtparser::extractCodePrefix(_sequence.intermediateCharacters());
@@ -149,6 +183,11 @@ class SequenceBuilder
         if (_hookedParser)
             _hookedParser->pass(ch);
     }
+    void put(std::string_view chars)
+    {
+        if (_hookedParser)
+            _hookedParser->pass(chars);
+    }
     void unhook()
     {
         if (_hookedParser)
@@ -157,9 +196,31 @@ class SequenceBuilder
             _hookedParser.reset();
         }
     }
-    void startAPC() {}
-    void putAPC(char) {}
-    void dispatchAPC() {}
+    void startAPC()
+    {
+        _applicationProgramCommand.clear();
+        _applicationProgramCommandTooLong = false;
+    }
+
+    void putAPC(char ch)
+    {
+        if (_applicationProgramCommand.size() < MaxApcLength)
+            _applicationProgramCommand.push_back(ch);
+        else
+            _applicationProgramCommandTooLong = true;
+    }
+
+    void dispatchAPC()
+    {
+        _incrementInstructionCounter();
+        // An APC cut off at the maximum length would be mistaken for a whole one, so it is dropped.
+        if constexpr (requires { _handler.processApplicationProgramCommand(std::string_view {}); })
+            if (!_applicationProgramCommandTooLong)
+                _handler.processApplicationProgramCommand(_applicationProgramCommand);
+        _applicationProgramCommand.clear();
+        _applicationProgramCommandTooLong = false;
+    }
+
     void startPM() {}
     void putPM(char) {}
     void dispatchPM() {}
@@ -173,9 +234,20 @@ class SequenceBuilder
     {
         return _handler.maxBulkTextSequenceWidth();
     }
+
+    /// @returns the approximate number of bytes of memory taken by the sequence being built,
+    ///          including the payload received so far by a hooked parser.
+    [[nodiscard]] size_t memoryUsage() const noexcept
+    {
+        return sizeof(*this) + _sequence.memoryUsage() + _applicationProgramCommand.capacity()
+               + (_hookedParser ? _hookedParser->memoryUsage() : 0);
+    }
     // }}}
 
   private:
+    /// Maximum length of an APC, fitting a kitty graphics command carrying a chunk of image data.
+    static constexpr size_t MaxApcLength = 8192;
+
     void handleSequence()
     {
         _parameterBuilder.fixiate();
@@ -188,6 +260,8 @@ class SequenceBuilder
     Handler _handler;
 
     std::unique_ptr<ParserExtension> _hookedParser {};
+    std::string _applicationProgramCommand;
+    bool _applicationProgramCommandTooLong = false;
 };
 
 template <SequenceHandlerConcept Handler, InstructionCounterConcept IncrementInstructionCounter>
@@ -3,6 +3,7 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <string>
 #include <string_view>
 
 using vtbackend::SequenceParameterBuilder;
@@ -124,3 +125,25 @@ TEST_CASE("SequenceParameterBuilder.complex.2")
     INFO(parameters.subParameterBitString());
     CHECK(parameters.str() == "0;12::34:56;7;89");
 }
+
+TEST_CASE("Sequence.inline_intermediates")
+{
+    auto seq = vtbackend::Sequence {};
+    seq.setCategory(vtbackend::FunctionCategory::CSI);
+    seq.intermediateCharacters().push_back('$');
+    seq.setFinalChar('p');
+    CHECK(seq.intermediateCharacters() == "$"sv);
+
+    // Copies of short sequences stay within inline storage.
+    auto const copy = seq;
+    CHECK(copy.intermediateCharacters() == "$"sv);
+    CHECK(copy.selector().intermediate == '$');
+
+    // Long payloads spill over and are dropped on clear.
+    auto const longPayload = std::string(vtbackend::Sequence::InlineIntermediatesLength * 4, 'x');
+    seq.clear();
+    seq.intermediateCharacters().append(longPayload);
+    CHECK(seq.intermediateCharacters() == longPayload);
+    seq.clear();
+    CHECK(seq.intermediateCharacters().empty());
+}
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/SessionSnapshot.h>
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+namespace vtbackend
+{
+
+namespace
+{
+    // File magic, including the format version in its last byte.
+    constexpr auto Magic = string_view("CTSNAP\0\2", 8);
+
+    // Magic of the first version, which did not store the main page and cursor yet.
+    constexpr auto MagicV1 = string_view("CTSNAP\0\1", 8);
+
+    void writeUInt32(string& output, uint32_t value)
+    {
+        for (auto i = 0; i < 4; ++i)
+            output += static_cast<char>((value >> (i * 8)) & 0xFF);
+    }
+
+    bool readUInt32(string_view input, size_t& offset, uint32_t& value) noexcept
+    {
+        if (input.size() - offset < 4)
+            return false;
+        value = 0;
+        for (auto i = 0; i < 4; ++i)
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(input[offset++])) << (i * 8);
+        return true;
+    }
+} // namespace
+
+bool writeSessionSnapshot(std::ostream& output, SessionSnapshot const& snapshot)
+{
+    // Line headers are collected in front of the line data, so that the whole snapshot
+    // is written in a few large chunks.
+    auto header = string(Magic);
+    writeUInt32(header, static_cast<uint32_t>(snapshot.lines.size()));
+    writeUInt32(header, unbox<uint32_t>(snapshot.pageLineCount));
+    writeUInt32(header, static_cast<uint32_t>(unbox(snapshot.cursor.line)));
+    writeUInt32(header, static_cast<uint32_t>(unbox(snapshot.cursor.column)));
+    for (auto const& line: snapshot.lines)
+    {
+        writeUInt32(header, static_cast<uint32_t>(line.flags.value()));
+        writeUInt32(header, unbox<uint32_t>(line.buffer.columns));
+        writeUInt32(header, static_cast<uint32_t>(line.buffer.view().size()));
+    }
+
+    output.write(header.data(), static_cast<std::streamsize>(header.size()));
+    for (auto const& line: snapshot.lines)
+    {
+        auto const bytes = line.buffer.view();
+        output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    output.flush();
+    return output.good();
+}
+
+std::optional<SessionSnapshot> readSessionSnapshot(std::istream& input)
+{
+    auto const data = string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    auto const bytes = string_view(data);
+    auto const hasPage = bytes.starts_with(Magic);
+    if (!hasPage && !bytes.starts_with(MagicV1))
+        return std::nullopt;
+
+    auto offset = Magic.size();
+    auto lineCount = uint32_t {};
+    auto pageLineCount = uint32_t {};
+    auto cursorLine = uint32_t {};
+    auto cursorColumn = uint32_t {};
+    if (!readUInt32(bytes, offset, lineCount))
+        return std::nullopt;
+    if (hasPage
+        && !(readUInt32(bytes, offset, pageLineCount) && readUInt32(bytes, offset, cursorLine)
+             && readUInt32(bytes, offset, cursorColumn)))
+        return std::nullopt;
+    if ((bytes.size() - offset) / 12 < lineCount)
+        return std::nullopt;
+
+    auto snapshot = SessionSnapshot {};
+    snapshot.pageLineCount = LineCount::cast_from(pageLineCount);
+    snapshot.cursor = CellLocation { .line = LineOffset::cast_from(cursorLine),
+                                     .column = ColumnOffset::cast_from(cursorColumn) };
+    snapshot.lines.resize(lineCount);
+    auto sizes = std::vector<uint32_t>(lineCount);
+    for (auto i = size_t { 0 }; i < lineCount; ++i)
+    {
+        auto flags = uint32_t {};
+        auto columns = uint32_t {};
+        readUInt32(bytes, offset, flags);
+        readUInt32(bytes, offset, columns);
+        readUInt32(bytes, offset, sizes[i]);
+        snapshot.lines[i].flags = LineFlags::from_value(static_cast<LineFlags::value_type>(flags));
+        snapshot.lines[i].buffer.columns = ColumnCount::cast_from(columns);
+    }
+
+    for (auto i = size_t { 0 }; i < lineCount; ++i)
+    {
+        if (bytes.size() - offset < sizes[i])
+            return std::nullopt;
+        snapshot.lines[i].buffer.bytes = std::make_shared<string const>(bytes.substr(offset, sizes[i]));
+        offset += sizes[i];
+    }
+
+    return snapshot;
+}
+
+} // namespace vtbackend
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Line.h>
+#include <vtbackend/primitives.h>
+
+#include <algorithm>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Scrollback and main page contents of a terminal session, as saved on exit and restored on the
+ * next launch, or handed over to a window attaching to a running session.
+ *
+ * Lines are kept in their packed form (see PackedLineBuffer), the same as cold history lines,
+ * so that neither saving nor restoring a session needs to inflate them.
+ */
+struct SessionSnapshot
+{
+    struct SnapshotLine
+    {
+        LineFlags flags;
+        PackedLineBuffer buffer;
+    };
+
+    /// The saved lines, oldest first.
+    std::vector<SnapshotLine> lines;
+
+    /// Number of trailing lines that made up the main page.
+    LineCount pageLineCount {};
+
+    /// Cursor position on the main page.
+    CellLocation cursor {};
+
+    /// @returns the number of lines down to the cursor line, leaving out the page lines below.
+    [[nodiscard]] size_t linesToCursor() const noexcept
+    {
+        auto const pageLines = std::min(unbox<size_t>(pageLineCount), lines.size());
+        if (pageLines == 0)
+            return lines.size();
+        return lines.size() - pageLines + std::min(unbox<size_t>(cursor.line) + 1, pageLines);
+    }
+};
+
+/// Writes the given snapshot in its binary form.
+///
+/// @returns false if the snapshot could not be written.
+bool writeSessionSnapshot(std::ostream& output, SessionSnapshot const& snapshot);
+
+/// Reads back a snapshot previously written by writeSessionSnapshot().
+///
+/// @returns std::nullopt if the input is not a session snapshot of a compatible version.
+///          Snapshots of the first version carry no page, their lines all being history lines.
+[[nodiscard]] std::optional<SessionSnapshot> readSessionSnapshot(std::istream& input);
+
+} // namespace vtbackend
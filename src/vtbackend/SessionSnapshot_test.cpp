@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/MockTerm.h>
+#include <vtbackend/SessionSnapshot.h>
+#include <vtbackend/Terminal.h>
+#include <vtbackend/primitives.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace vtbackend;
+
+TEST_CASE("SessionSnapshot.roundtrip", "[SessionSnapshot]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10) };
+    mock.writeToScreen("one\r\ntwo\r\n\033[1mthree\033[m\r\nfour\r\nfive");
+
+    auto stream = stringstream {};
+    REQUIRE(writeSessionSnapshot(stream, mock.terminal.sessionSnapshot()));
+
+    auto const snapshot = readSessionSnapshot(stream);
+    REQUIRE(snapshot.has_value());
+    CHECK(snapshot->lines.size() == 5);
+
+    // The saved lines end up in the history of the new session, the oldest on top.
+    auto restored = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10) };
+    restored.terminal.restoreSessionSnapshot(*snapshot);
+    auto const& grid = restored.terminal.primaryScreen().grid();
+    REQUIRE(grid.historyLineCount() == LineCount(5));
+    CHECK(grid.lineTextTrimmed(LineOffset(-5)) == "one");
+    CHECK(grid.lineTextTrimmed(LineOffset(-3)) == "three");
+    CHECK(grid.lineAt(LineOffset(-3)).inflatedBuffer()[0].flags() & CellFlag::Bold);
+    CHECK(grid.lineTextTrimmed(LineOffset(-1)) == "five");
+}
+
+TEST_CASE("SessionSnapshot.attach", "[SessionSnapshot]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10) };
+    mock.writeToScreen("one\r\ntwo\r\nthree\r\nfour\r\nfive\033[2;3H");
+
+    auto stream = stringstream {};
+    REQUIRE(writeSessionSnapshot(stream, mock.terminal.sessionSnapshot()));
+    auto const snapshot = readSessionSnapshot(stream);
+    REQUIRE(snapshot.has_value());
+    CHECK(snapshot->pageLineCount == LineCount(3));
+    CHECK(snapshot->cursor == CellLocation { .line = LineOffset(1), .column = ColumnOffset(2) });
+
+    // An attaching window shows the page as it was.
+    auto attached = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10) };
+    attached.terminal.attachSessionSnapshot(*snapshot);
+    auto const& grid = attached.terminal.primaryScreen().grid();
+    REQUIRE(grid.historyLineCount() == LineCount(2));
+    CHECK(grid.lineTextTrimmed(LineOffset(-2)) == "one");
+    CHECK(grid.lineTextTrimmed(LineOffset(0)) == "three");
+    CHECK(grid.lineTextTrimmed(LineOffset(2)) == "five");
+    CHECK(attached.terminal.primaryScreen().realCursorPosition() == snapshot->cursor);
+
+    // A new session only takes over the lines down to the cursor line.
+    auto restored = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10) };
+    restored.terminal.restoreSessionSnapshot(*snapshot);
+    CHECK(restored.terminal.primaryScreen().grid().historyLineCount() == LineCount(4));
+    CHECK(restored.terminal.primaryScreen().grid().lineTextTrimmed(LineOffset(-1)) == "four");
+}
+
+TEST_CASE("SessionSnapshot.reflows_wider_lines", "[SessionSnapshot]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    mock.writeToScreen("abcdefghij\r\nshort\r\nend");
+    auto const snapshot = mock.terminal.sessionSnapshot();
+
+    // Lines wider than the page of the new session wrap rather than being cut off.
+    auto restored = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10) };
+    restored.terminal.restoreSessionSnapshot(snapshot);
+    auto const& grid = restored.terminal.primaryScreen().grid();
+    REQUIRE(grid.historyLineCount() == LineCount(4));
+    CHECK(grid.lineTextTrimmed(LineOffset(-4)) == "abcde");
+    CHECK(grid.lineTextTrimmed(LineOffset(-3)) == "fghij");
+    CHECK(grid.lineAt(LineOffset(-3)).wrapped());
+    CHECK(grid.lineTextTrimmed(LineOffset(-2)) == "short");
+    CHECK(grid.lineTextTrimmed(LineOffset(-1)) == "end");
+}
+
+TEST_CASE("SessionSnapshot.drops_hyperlinks", "[SessionSnapshot]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    mock.writeToScreen("\033]8;;https://example.com/\033\\link\033]8;;\033\\");
+    REQUIRE(*mock.terminal.primaryScreen().at(LineOffset(0), ColumnOffset(0)).hyperlink() != 0);
+
+    // Hyperlink IDs would refer to unrelated hyperlinks of the session restoring the lines.
+    auto const snapshot = mock.terminal.sessionSnapshot();
+    REQUIRE(!snapshot.lines.empty());
+    for (auto const& line: snapshot.lines)
+        for (auto const& span: unpack(line.buffer).spans)
+            CHECK(*span.hyperlink == 0);
+}
+
+TEST_CASE("SessionSnapshot.invalid_input", "[SessionSnapshot]")
+{
+    auto garbage = stringstream { "not a session snapshot" };
+    CHECK(!readSessionSnapshot(garbage).has_value());
+
+    // Truncated snapshots are rejected as a whole.
+    auto stream = stringstream {};
+    auto snapshot = SessionSnapshot {};
+    auto const line = Line<PrimaryScreenCell>(LineFlag::None,
+                                              TrivialLineBuffer { .displayWidth = ColumnCount(4),
+                                                                  .textAttributes = GraphicsAttributes {} });
+    snapshot.lines.push_back(SessionSnapshot::SnapshotLine { .flags = LineFlag::Wrapped,
+                                                             .buffer = line.toPackedBuffer() });
+    REQUIRE(writeSessionSnapshot(stream, snapshot));
+    auto const data = stream.str();
+    auto truncated = stringstream { data.substr(0, data.size() - 1) };
+    CHECK(!readSessionSnapshot(truncated).has_value());
+}
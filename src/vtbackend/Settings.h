@@ -1,10 +1,13 @@
 #pragma once
 
 #include <vtbackend/ColorPalette.h>
+#include <vtbackend/Image.h>
 #include <vtbackend/InputGenerator.h> // Modifier
 #include <vtbackend/VTType.h>
 #include <vtbackend/primitives.h>
 
+#include <crispy/BufferObject.h>
+
 #include <chrono>
 #include <map>
 
@@ -38,15 +41,31 @@ struct Settings
     // some other display is shown along with it (e.g. below the main display).
     PageSize pageSize = PageSize { LineCount(25), ColumnCount(80) };
 
+    // Cell type the primary and alternate screens are created with.
+    CellLayout cellLayout = CellLayout::Compact;
     MaxHistoryLineCount maxHistoryLineCount;
+    // Number of most recent history lines kept unpacked in memory, older ones are stored packed.
+    LineCount coldHistoryThreshold = LineCount(10'000);
+    // Appends lines falling off the in-memory history to a per-session file on disk.
+    bool spillHistoryToDisk = false;
+    // Maintains a trigram index over the history lines to speed up searching deep scrollback.
+    bool historySearchIndex = true;
+    // Lets identical lines scrolling into history share their text, e.g. repeated lines of build logs.
+    bool historyDeduplication = true;
     ImageSize maxImageSize { Width(800), Height(600) };
     unsigned maxImageRegisterCount = 256;
+    // Number of bytes of uncompressed image pixel data kept in memory, beyond which
+    // the least recently used images are compressed.
+    size_t imageMemoryBudget = ImagePool::DefaultMemoryBudget;
+    // Lets kitty graphics clients have images read from local files and shared memory they name.
+    bool kittyGraphicsLocalMedia = false;
     StatusDisplayType statusDisplayType = StatusDisplayType::None;
     StatusDisplayPosition statusDisplayPosition = StatusDisplayPosition::Bottom;
     struct
     {
         std::string left { "{VTType} │ {InputMode:Bold,Color=#C0C030}{SearchPrompt:Left= │ }"
-                           "{TraceMode:Bold,Color=#FFFF00,Left= │ }{ProtectedMode:Bold,Left= │ }" };
+                           "{TraceMode:Bold,Color=#FFFF00,Left= │ }{ProtectedMode:Bold,Left= │ }"
+                           "{PasteProgress:Bold,Left= │ }" };
         std::string middle { "{Title:Left= « ,Right= » ,Color=#20c0c0}" };
         std::string right { "{HistoryLineCount:Faint,Color=#c0c0c0} │ {Clock:Bold} " };
     } indicatorStatusLine;
@@ -58,6 +77,11 @@ struct Settings
 
     std::chrono::milliseconds cursorBlinkInterval = std::chrono::milliseconds { 500 };
     RefreshRate refreshRate = { 30.0 };
+    // Minimum time between two frames while the application keeps producing bulk output.
+    std::chrono::milliseconds bulkOutputFrameInterval { 33 };
+    // Whether the display adapts its refresh rate to the frames being rendered,
+    // such that frames need not be aligned to a fixed refresh period.
+    bool variableRefreshRate = false;
 
     // Defines the time to wait before the terminal executes the line feed (LF) command.
     // This is used to implement the DECSCLM (slow scroll) mode.
@@ -67,15 +91,27 @@ struct Settings
     //
     // Defaults to 1 MB, that's roughly 10k lines when column count is 100.
     size_t ptyBufferObjectSize = 1024lu * 1024lu;
+    // How the storage of PTY Buffer Objects is allocated.
+    //
+    // Huge pages reduce TLB misses for high-throughput sessions, at the cost of PTY Buffer Objects
+    // being rounded up to 2 MB.
+    crispy::buffer_object_allocation ptyBufferObjectAllocation = crispy::buffer_object_allocation::Heap;
     // Configures the size of the PTY read buffer.
     // Changing this value may result in better or worse throughput performance.
     //
     // This value must be integer-devisable by 16.
     size_t ptyReadBufferSize = 4096;
+    // Reads from the PTY on a thread of its own, while the previously read output is being parsed.
+    bool ptyReaderThread = false;
     std::u32string wordDelimiters;
     std::u32string extendedWordDelimiters;
     Modifiers mouseProtocolBypassModifiers = Modifier::Shift;
     Modifiers mouseBlockSelectionModifiers = Modifier::Control;
+    // Minimum time between two mouse move reports in pixel-precise (SGR-Pixels) mouse transport.
+    std::chrono::milliseconds pixelMouseMoveInterval = std::chrono::milliseconds { 8 };
+    // Latency of key input from which on typed text is echoed locally ahead of the application,
+    // or zero to never do so.
+    std::chrono::milliseconds predictiveEchoThreshold {};
     LineOffset copyLastMarkRangeOffset = LineOffset(0);
     bool visualizeSelectedWord = true;
     std::chrono::milliseconds highlightTimeout = std::chrono::milliseconds { 150 };
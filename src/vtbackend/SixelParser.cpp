@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 
 using std::clamp;
 using std::fill;
@@ -147,6 +148,22 @@ SixelParser::SixelParser(Events& events, OnFinalize finalizer):
 {
 }
 
+void SixelParser::parseFragment(iterator begin, iterator end)
+{
+    while (begin != end)
+    {
+        if (_state == State::Ground && isSixel(*begin))
+        {
+            auto const value = *begin;
+            auto const runEnd = std::find_if(begin, end, [value](char ch) { return ch != value; });
+            _events.render(toSixel(value), static_cast<unsigned>(runEnd - begin));
+            begin = runEnd;
+        }
+        else
+            parse(*begin++);
+    }
+}
+
 void SixelParser::parse(char value)
 {
     switch (_state)
@@ -159,9 +176,7 @@ void SixelParser::parse(char value)
                 paramShiftAndAddDigit(toDigit(value));
             else if (isSixel(value))
             {
-                auto const sixel = toSixel(value);
-                for (unsigned i = 0; i < _params[0]; ++i)
-                    _events.render(sixel);
+                _events.render(toSixel(value), _params[0]);
                 transitionTo(State::Ground);
             }
             else
@@ -222,7 +237,7 @@ void SixelParser::fallback(char value)
             transitionTo(State::Ground);
 
         if (isSixel(value))
-            _events.render(toSixel(value));
+            _events.render(toSixel(value), 1);
     }
 
     // ignore any other input value
@@ -363,6 +378,8 @@ SixelImageBuilder::SixelImageBuilder(ImageSize maxSize,
         std::ceil(static_cast<float>(aspectVertical) / static_cast<float>(aspectHorizontal)))),
     _sixelBandHeight(6 * _aspectRatio)
 {
+    if (_colors->size() != 0)
+        useColor(0);
     clear(backgroundColor);
 }
 
@@ -390,40 +407,52 @@ RGBAColor SixelImageBuilder::at(CellLocation coord) const noexcept
     return RGBAColor { color[0], color[1], color[2], color[3] };
 }
 
-void SixelImageBuilder::write(CellLocation const& coord, RGBColor const& value) noexcept
+ImageSize SixelImageBuilder::completedSize() const noexcept
 {
-    if (unbox(coord.line) >= 0 && unbox(coord.line) < unbox<int>(_maxSize.height) && unbox(coord.column) >= 0
-        && unbox(coord.column) < unbox<int>(_maxSize.width))
-    {
-        if (!_explicitSize)
-        {
-            if (unbox(coord.line) >= unbox<int>(_size.height))
-                _size.height = Height::cast_from(coord.line.as<unsigned int>() + _aspectRatio);
-            if (unbox(coord.column) >= unbox<int>(_size.width))
-                _size.width = Width::cast_from(coord.column + 1);
-        }
+    auto const height = min(_sixelCursor.line.as<unsigned int>(), unbox(_size.height));
+    return ImageSize { _size.width, Height::cast_from(height) };
+}
 
-        for (unsigned int i = 0; i < _aspectRatio; ++i)
-        {
-            auto const base = ((coord.line.as<unsigned int>() + i)
-                               * unbox((_explicitSize ? _size.width : _maxSize.width)) * 4u)
-                              + (unbox<unsigned int>(coord.column) * 4u);
-            _buffer[base + 0] = value.red;
-            _buffer[base + 1] = value.green;
-            _buffer[base + 2] = value.blue;
-            _buffer[base + 3] = 0xFF;
-        }
+SixelImageBuilder::Buffer SixelImageBuilder::completedData() const
+{
+    auto const size = completedSize();
+    auto const stride = unbox<size_t>(_explicitSize ? _size.width : _maxSize.width) * 4;
+    auto const lineSize = unbox<size_t>(size.width) * 4;
+
+    auto output = Buffer(size.area() * 4);
+    for (size_t line = 0; line < unbox<size_t>(size.height); ++line)
+        std::copy_n(_buffer.begin() + static_cast<long>(line * stride),
+                    lineSize,
+                    output.begin() + static_cast<long>(line * lineSize));
+    return output;
+}
+
+void SixelImageBuilder::fill(unsigned line, unsigned column, unsigned count) noexcept
+{
+    auto const stride = unbox(_explicitSize ? _size.width : _maxSize.width);
+    auto* const target = _buffer.data() + ((static_cast<size_t>(line) * stride + column) * 4);
+
+    // Doubling the filled range with each copy lets memcpy do the wide stores.
+    std::memcpy(target, _currentPixel.data(), _currentPixel.size());
+    for (size_t filled = 1; filled < count;)
+    {
+        auto const n = min(filled, count - filled);
+        std::memcpy(target + (filled * 4), target, n * 4);
+        filled += n;
     }
 }
 
 void SixelImageBuilder::setColor(unsigned index, RGBColor const& color)
 {
     _colors->setColor(index, color);
+    useColor(_currentColor);
 }
 
 void SixelImageBuilder::useColor(unsigned index)
 {
     _currentColor = index % _colors->size();
+    auto const color = currentColor();
+    _currentPixel = Pixel { color.red, color.green, color.blue, 0xFF };
 }
 
 void SixelImageBuilder::rewind()
@@ -455,23 +484,38 @@ void SixelImageBuilder::setRaster(unsigned int pan, unsigned int pad, optional<I
     }
 }
 
-void SixelImageBuilder::render(int8_t sixel)
+void SixelImageBuilder::render(int8_t sixel, unsigned count)
 {
-    // TODO: respect aspect ratio!
-    auto const x = _sixelCursor.column;
-    if (unbox(x) < unbox<int>((_explicitSize ? _size.width : _maxSize.width)))
+    auto const width = unbox(_explicitSize ? _size.width : _maxSize.width);
+    auto const height = unbox(_explicitSize ? _size.height : _maxSize.height);
+    auto const x = unbox<unsigned int>(_sixelCursor.column);
+    if (x >= width || count == 0)
+        return;
+
+    count = min(count, width - x);
+
+    // Each set bit of the sixel paints a column of aspect ratio many pixels, for all repeated sixels.
+    for (unsigned int i = 0; i < 6; ++i)
     {
-        for (unsigned int i = 0; i < 6; ++i)
+        if ((sixel & (1 << i)) == 0)
+            continue;
+
+        auto const y = _sixelCursor.line.as<unsigned int>() + (i * _aspectRatio);
+        if (y >= height)
+            break;
+
+        auto const lineCount = min(_aspectRatio, height - y);
+        for (unsigned int line = y; line < y + lineCount; ++line)
+            fill(line, x, count);
+
+        if (!_explicitSize)
         {
-            auto const y = _sixelCursor.line + static_cast<int>(i * _aspectRatio);
-            auto const pos = CellLocation { .line = y, .column = x };
-            auto const pin = 1 << i;
-            auto const pinned = (sixel & pin) != 0;
-            if (pinned)
-                write(pos, currentColor());
+            _size.height = max(_size.height, Height::cast_from(y + lineCount));
+            _size.width = max(_size.width, Width::cast_from(x + count));
         }
-        _sixelCursor.column++;
     }
+
+    _sixelCursor.column = ColumnOffset::cast_from(x + count);
 }
 
 void SixelImageBuilder::finalize()
@@ -486,14 +530,9 @@ void SixelImageBuilder::finalize()
     {
         Buffer tempBuffer(static_cast<size_t>(_size.height.value * _size.width.value) * 4);
         for (auto i = 0u; i < unbox(_size.height); ++i)
-        {
-            for (auto j = 0u; j < unbox(_size.width); ++j)
-            {
-                std::copy_n(_buffer.begin() + i * unbox<long>(_maxSize.width) * 4,
-                            _size.width.value * 4,
-                            tempBuffer.begin() + i * unbox<long>(_size.width) * 4);
-            }
-        }
+            std::copy_n(_buffer.begin() + i * unbox<long>(_maxSize.width) * 4,
+                        _size.width.value * 4,
+                        tempBuffer.begin() + i * unbox<long>(_size.width) * 4);
         _buffer.swap(tempBuffer);
         _explicitSize = false;
     }
@@ -6,8 +6,7 @@
 
 #include <vtparser/ParserExtension.h>
 
-#include <crispy/range.h>
-
+#include <array>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -62,8 +61,8 @@ class SixelParser: public ParserExtension
         /// the upcoming pixel data.
         virtual void setRaster(unsigned int pan, unsigned int pad, std::optional<ImageSize> imageSize) = 0;
 
-        /// renders a given sixel at the current sixel-cursor position.
-        virtual void render(int8_t sixel) = 0;
+        /// renders a given sixel @p count times, starting at the current sixel-cursor position.
+        virtual void render(int8_t sixel, unsigned count) = 0;
 
         /// Finalizes the image by optimizing the underlying storage to its minimal dimension in storage.
         virtual void finalize() = 0;
@@ -74,11 +73,8 @@ class SixelParser: public ParserExtension
 
     using iterator = char const*;
 
-    void parseFragment(iterator begin, iterator end)
-    {
-        for (auto const ch: crispy::range(begin, end))
-            parse(ch);
-    }
+    /// Parses the given range, rendering each run of equal sixels with a single render event.
+    void parseFragment(iterator begin, iterator end);
 
     void parseFragment(std::string_view range) { parseFragment(range.data(), range.data() + range.size()); }
 
@@ -94,7 +90,12 @@ class SixelParser: public ParserExtension
 
     // ParserExtension overrides
     void pass(char ch) override;
+    void pass(std::string_view chars) override { parseFragment(chars); }
     void finalize() override;
+    [[nodiscard]] size_t memoryUsage() const noexcept override
+    {
+        return _params.capacity() * sizeof(unsigned);
+    }
 
   private:
     void paramShiftAndAddDigit(unsigned value);
@@ -156,6 +157,13 @@ class SixelImageBuilder: public SixelParser::Events
     [[nodiscard]] Buffer const& data() const noexcept { return _buffer; }
     [[nodiscard]] Buffer& data() noexcept { return _buffer; }
 
+    /// @returns the size of the part of the image whose sixel bands are complete, i.e. above the
+    ///          band currently being received.
+    [[nodiscard]] ImageSize completedSize() const noexcept;
+
+    /// @returns the RGBA pixels of completedSize(), packed line by line.
+    [[nodiscard]] Buffer completedData() const;
+
     void clear(RGBAColor fillColor);
 
     void setColor(unsigned index, RGBColor const& color) override;
@@ -163,13 +171,16 @@ class SixelImageBuilder: public SixelParser::Events
     void rewind() override;
     void newline() override;
     void setRaster(unsigned int pan, unsigned int pad, std::optional<ImageSize> imageSize) override;
-    void render(int8_t sixel) override;
+    void render(int8_t sixel, unsigned count) override;
     void finalize() override;
 
     [[nodiscard]] CellLocation const& sixelCursor() const noexcept { return _sixelCursor; }
 
   private:
-    void write(CellLocation const& coord, RGBColor const& value) noexcept;
+    using Pixel = std::array<uint8_t, 4>;
+
+    /// Fills the given number of pixels of the given line, starting at the given column.
+    void fill(unsigned line, unsigned column, unsigned count) noexcept;
 
   private:
     ImageSize const _maxSize;
@@ -178,6 +189,7 @@ class SixelImageBuilder: public SixelParser::Events
     Buffer _buffer; /// RGBA buffer
     CellLocation _sixelCursor {};
     unsigned _currentColor = 0;
+    Pixel _currentPixel { 0, 0, 0, 0xFF }; // RGBA value of the current color, resolved on use
     bool _explicitSize = false;
     // This is an int because vt3xx takes the given ratio pan/pad and rounds up the ratio
     // to nearest integers. So 1:3 = 0.33 and it  becomes 1;
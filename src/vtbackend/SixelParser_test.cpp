@@ -243,6 +243,35 @@ TEST_CASE("SixelParser.rep", "[sixel]")
     }
 }
 
+TEST_CASE("SixelParser.rep_clipped", "[sixel]")
+{
+    auto constexpr DefaultColor = RGBAColor { 0, 0, 0, 0xFF };
+    auto constexpr PinColor = RGBColor { 0x10, 0x20, 0x30 };
+    auto ib = sixelImageBuilder(ImageSize { Width(4), Height(12) }, DefaultColor);
+    auto sp = SixelParser { ib };
+
+    ib.setColor(0, PinColor);
+
+    // Repeated sixels beyond the raster width are clipped, and so are runs of equal sixels.
+    sp.parseFragment("!10A-CCCCCC");
+
+    CHECK(ib.sixelCursor() == CellLocation { LineOffset(6), ColumnOffset(4) });
+
+    for (int x = 0; x < ib.size().width.as<int>(); ++x)
+    {
+        for (int y = 0; y < ib.size().height.as<int>(); ++y)
+        {
+            auto const& actualColor =
+                ib.at(CellLocation { .line = LineOffset(y), .column = ColumnOffset(x) });
+            auto const pinned = y == 1 || y == 8;
+            if (pinned)
+                CHECK(actualColor.rgb() == PinColor);
+            else
+                CHECK(actualColor == DefaultColor);
+        }
+    }
+}
+
 TEST_CASE("SixelParser.setAndUseColor", "[sixel]")
 {
     auto constexpr PinColors = std::array<RGBAColor, 5> { RGBAColor { 255, 255, 255, 255 },
@@ -7,11 +7,14 @@
 #include <crispy/utils.h>
 
 #include <libunicode/convert.h>
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/width.h>
 
 #include <range/v3/range/conversion.hpp>
 #include <range/v3/view/join.hpp>
 #include <range/v3/view/transform.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
 #include <format>
@@ -40,6 +43,54 @@ namespace // helper functions
         }
         crispy::unreachable();
     }
+
+    std::string makeTextColor(std::optional<RGBColor> const& color)
+    {
+        if (!color)
+            return {};
+
+        return std::format("\033[38:2:{}:{}:{}m", color->red, color->green, color->blue);
+    }
+
+    std::string makeBackgroundColor(std::optional<RGBColor> const& color)
+    {
+        if (!color)
+            return {};
+
+        return std::format("\033[48:2:{}:{}:{}m", color->red, color->green, color->blue);
+    }
+
+    std::string makeStyles(StatusLineRun const& run) // {{{
+    {
+        auto result = makeTextColor(run.foregroundColor);
+        result += makeBackgroundColor(run.backgroundColor);
+
+        result += run.flags.reduce(std::string {}, [](std::string&& result, CellFlag flag) -> std::string {
+            switch (flag)
+            {
+                case CellFlag::None: return result;
+                case CellFlag::Bold: return std::move(result) + "\033[1m";
+                case CellFlag::Italic: return std::move(result) + "\033[3m";
+                case CellFlag::Underline: return std::move(result) + "\033[4m";
+                case CellFlag::DottedUnderline: return std::move(result) + "\033[4:1m";
+                case CellFlag::CurlyUnderlined: return std::move(result) + "\033[4:3m";
+                case CellFlag::DoublyUnderlined: return std::move(result) + "\033[4:4m";
+                case CellFlag::DashedUnderline: return std::move(result) + "\033[4:5m";
+                case CellFlag::Blinking: return std::move(result) + "\033[5m";
+                case CellFlag::RapidBlinking: return std::move(result) + "\033[6m";
+                case CellFlag::Inverse: return std::move(result) + "\033[7m";
+                case CellFlag::Hidden: return std::move(result) + "\033[8m";
+                case CellFlag::CrossedOut: return std::move(result) + "\033[9m";
+                case CellFlag::Framed: return std::move(result) + "\033[51m";
+                case CellFlag::Encircled: return std::move(result) + "\033[52m";
+                case CellFlag::Overline: return std::move(result) + "\033[53m";
+                case CellFlag::Faint: return std::move(result) + "\033[2m";
+                case CellFlag::CharacterProtected:
+                default: return result;
+            }
+        });
+        return result;
+    } // }}}
 } // namespace
 
 std::optional<RGBColor> tryParseColorAttribute(crispy::string_interpolation const& interpolation,
@@ -125,6 +176,9 @@ std::optional<StatusLineDefinitions::Item> makeStatusLineItem(
     if (interpolation.name == "InputMode")
         return StatusLineDefinitions::InputMode { styles };
 
+    if (interpolation.name == "PasteProgress")
+        return StatusLineDefinitions::PasteProgress { styles };
+
     if (interpolation.name == "ProtectedMode")
         return StatusLineDefinitions::ProtectedMode { styles };
 
@@ -198,96 +252,64 @@ StatusLineDefinition parseStatusLineDefinition(std::string_view left,
     };
 }
 
-struct VTSerializer
+/// Evaluates status line items into runs of styled text.
+struct StatusLineEvaluator
 {
     Terminal const& vt;
-    StatusLineStyling styling;
-    std::string result {};
+    StatusLineRuns runs {};
 
-    std::string makeTextColor(std::optional<RGBColor> const& color, std::string_view defaultSequence = {})
+    void appendRun(std::string text, StatusLineDefinitions::Styles const& styles)
     {
-        if (!color)
-            return std::string(defaultSequence);
+        if (text.empty())
+            return;
 
-        return std::format("\033[38:2:{}:{}:{}m", color->red, color->green, color->blue);
+        if (!runs.empty() && runs.back().foregroundColor == styles.foregroundColor
+            && runs.back().backgroundColor == styles.backgroundColor && runs.back().flags == styles.flags)
+        {
+            runs.back().text += text;
+            return;
+        }
+
+        runs.emplace_back(StatusLineRun { .text = std::move(text),
+                                          .foregroundColor = styles.foregroundColor,
+                                          .backgroundColor = styles.backgroundColor,
+                                          .flags = styles.flags });
     }
 
-    std::string makeBackgroundColor(std::optional<RGBColor> const& color,
-                                    std::string_view defaultSequence = {})
+    void operator()(StatusLineDefinitions::Item const& item)
     {
-        if (!color)
-            return std::string(defaultSequence);
+        std::visit([this](auto const& item) { append(item); }, item);
+    }
 
-        return std::format("\033[48:2:{}:{}:{}m", color->red, color->green, color->blue);
+    template <typename Item>
+    void append(Item const& item)
+    {
+        if (auto const text = visit(item); !text.empty())
+            appendRun(item.textLeft + text + item.textRight, item);
     }
 
-    void applyStyles(StatusLineDefinitions::Styles const& styles) // {{{
+    void append(StatusLineDefinitions::Tabs const& tabs)
     {
-        if (styling == StatusLineStyling::Disabled)
+        auto const tabsInfo = vt.guiTabsInfoForStatusLine();
+        if (tabsInfo.tabCount == 0)
             return;
 
-        result += makeTextColor(styles.foregroundColor);
-        result += makeBackgroundColor(styles.backgroundColor);
-
-        result += styles.flags.reduce(std::string {}, [](std::string&& result, CellFlag flag) -> std::string {
-            switch (flag)
-            {
-                case CellFlag::None: return result;
-                case CellFlag::Bold: return std::move(result) + "\033[1m";
-                case CellFlag::Italic: return std::move(result) + "\033[3m";
-                case CellFlag::Underline: return std::move(result) + "\033[4m";
-                case CellFlag::DottedUnderline: return std::move(result) + "\033[4:1m";
-                case CellFlag::CurlyUnderlined: return std::move(result) + "\033[4:3m";
-                case CellFlag::DoublyUnderlined: return std::move(result) + "\033[4:4m";
-                case CellFlag::DashedUnderline: return std::move(result) + "\033[4:5m";
-                case CellFlag::Blinking: return std::move(result) + "\033[5m";
-                case CellFlag::RapidBlinking: return std::move(result) + "\033[6m";
-                case CellFlag::Inverse: return std::move(result) + "\033[7m";
-                case CellFlag::Hidden: return std::move(result) + "\033[8m";
-                case CellFlag::CrossedOut: return std::move(result) + "\033[9m";
-                case CellFlag::Framed: return std::move(result) + "\033[51m";
-                case CellFlag::Encircled: return std::move(result) + "\033[52m";
-                case CellFlag::Overline: return std::move(result) + "\033[53m";
-                case CellFlag::Faint: return std::move(result) + "\033[2m";
-                case CellFlag::CharacterProtected:
-                default: return result;
-            }
-        });
-    } // }}}
-
-    std::string operator()(StatusLineDefinitions::Item const& item)
-    {
-        std::visit(
-            [this](auto const& item) {
-                if (auto const text = visit(item); !text.empty())
-                {
-                    if constexpr (std::is_same_v<decltype(item), StatusLineDefinitions::Text>)
-                        result += text;
-                    else
-                    {
-                        if (styling == StatusLineStyling::Enabled)
-                        {
-                            result += SGRSAVE();
-                            applyStyles(item);
-                        }
-                        result += item.textLeft;
-                        result += text;
-                        result += item.textRight;
-                        if (styling == StatusLineStyling::Enabled)
-                            result += SGRRESTORE();
-                    }
-                }
-            },
-            item);
-        return result;
-    }
+        StatusLineDefinitions::Styles const& styles = tabs;
+        auto activeStyles = styles;
+        if (tabs.activeColor)
+            activeStyles.foregroundColor = tabs.activeColor;
+        if (tabs.activeBackground)
+            activeStyles.backgroundColor = tabs.activeBackground;
 
-    std::string operator()(StatusLineSegment const& segment)
-    {
-        std::string result;
-        for (auto const& item: segment)
-            result += std::visit(*this, item);
-        return result;
+        appendRun(tabs.textLeft, styles);
+        for (const auto position: std::views::iota(size_t { 1 }, tabsInfo.tabCount + 1))
+        {
+            if (position > 1)
+                appendRun(" ", styles);
+            auto const isActivePosition = position == tabsInfo.activeTabPosition;
+            appendRun(std::to_string(position), isActivePosition ? activeStyles : styles);
+        }
+        appendRun(tabs.textRight, styles);
     }
 
     // {{{
@@ -346,14 +368,14 @@ struct VTSerializer
         if (vt.viewport().scrollOffset().value)
         {
             auto const pct =
-                double(vt.viewport().scrollOffset()) / double(vt.primaryScreen().historyLineCount());
+                double(vt.viewport().scrollOffset()) / double(vt.primaryScreenBase().historyLineCount());
             return std::format("{}/{} {:3}%",
                                vt.viewport().scrollOffset(),
-                               vt.primaryScreen().historyLineCount(),
+                               vt.primaryScreenBase().historyLineCount(),
                                int(pct * 100));
         }
         else
-            return std::format("{}", vt.primaryScreen().historyLineCount());
+            return std::format("{}", vt.primaryScreenBase().historyLineCount());
     }
 
     std::string visit(StatusLineDefinitions::Hyperlink const&)
@@ -369,6 +391,14 @@ struct VTSerializer
         return std::string(modeString(vt.inputHandler().mode()));
     }
 
+    std::string visit(StatusLineDefinitions::PasteProgress const&)
+    {
+        if (!vt.pasteInProgress())
+            return {};
+
+        return std::format("PASTING ({} sent)", crispy::humanReadableBytes(vt.pastedBytes()));
+    }
+
     std::string visit(StatusLineDefinitions::ProtectedMode const&)
     {
         if (vt.allowInput())
@@ -438,43 +468,58 @@ struct VTSerializer
 
     std::string visit(StatusLineDefinitions::VTType const&) { return std::format("{}", vt.terminalId()); }
 
-    std::string visit(StatusLineDefinitions::Tabs const& tabs)
-    {
-        auto const tabsInfo = vt.guiTabsInfoForStatusLine();
-
-        std::string fragment;
-        for (const auto position: std::views::iota(1u, tabsInfo.tabCount + 1))
-        {
-            if (!fragment.empty())
-                fragment += ' ';
-
-            auto const isActivePosition = position == tabsInfo.activeTabPosition;
-            auto const activePositionStylized =
-                isActivePosition && (tabs.activeColor || tabs.activeBackground);
+    // }}}
+};
 
-            if (activePositionStylized)
-            {
-                fragment += SGRSAVE();
-                fragment += makeTextColor(tabs.activeColor);
-                fragment += makeBackgroundColor(tabs.activeBackground);
-            }
+StatusLineRuns renderStatusLineSegment(Terminal const& vt, StatusLineSegment const& segment)
+{
+    auto evaluator = StatusLineEvaluator { .vt = vt };
+    for (auto const& item: segment)
+        evaluator(item);
+    return std::move(evaluator.runs);
+}
 
-            fragment += std::to_string(position);
+StatusLineContent renderStatusLine(Terminal const& vt, StatusLineDefinition const& definition)
+{
+    return StatusLineContent {
+        .left = renderStatusLineSegment(vt, definition.left),
+        .middle = renderStatusLineSegment(vt, definition.middle),
+        .right = renderStatusLineSegment(vt, definition.right),
+    };
+}
 
-            if (activePositionStylized)
-                fragment += SGRRESTORE();
+ColumnCount displayWidth(StatusLineRuns const& runs)
+{
+    auto width = size_t { 0 };
+    auto lastChar = char32_t { 0 };
+    for (auto const& run: runs)
+    {
+        for (char32_t const ch: unicode::convert_to<char32_t>(std::string_view(run.text)))
+        {
+            if (unicode::grapheme_segmenter::breakable(lastChar, ch))
+                width += std::max<size_t>(unicode::width(ch), 1);
+            lastChar = ch;
         }
-        return fragment;
     }
-    // }}}
-};
+    return ColumnCount::cast_from(width);
+}
 
 std::string serializeToVT(Terminal const& vt, StatusLineSegment const& segment, StatusLineStyling styling)
 {
-    auto serializer = VTSerializer { .vt = vt, .styling = styling };
-    for (auto const& item: segment)
-        serializer(item);
-    return serializer.result;
+    auto result = std::string {};
+    for (auto const& run: renderStatusLineSegment(vt, segment))
+    {
+        if (styling == StatusLineStyling::Disabled)
+        {
+            result += run.text;
+            continue;
+        }
+        result += SGRSAVE();
+        result += makeStyles(run);
+        result += run.text;
+        result += SGRRESTORE();
+    }
+    return result;
 }
 
 } // namespace vtbackend
@@ -3,7 +3,9 @@
 
 #include <vtbackend/CellFlags.h>
 #include <vtbackend/Color.h>
+#include <vtbackend/primitives.h>
 
+#include <optional>
 #include <string>
 #include <variant>
 #include <vector>
@@ -32,6 +34,7 @@ namespace StatusLineDefinitions
     struct HistoryLineCount: Styles {};
     struct Hyperlink: Styles {};
     struct InputMode: Styles {};
+    struct PasteProgress: Styles {};
     struct ProtectedMode: Styles {};
     struct SearchMode: Styles {};
     struct SearchPrompt: Styles {};
@@ -54,6 +57,7 @@ namespace StatusLineDefinitions
         HistoryLineCount,
         Hyperlink,
         InputMode,
+        PasteProgress,
         ProtectedMode,
         SearchMode,
         SearchPrompt,
@@ -88,7 +92,40 @@ enum class StatusLineStyling : uint8_t
     Enabled
 };
 
+/// Text of an evaluated status line segment that shares the same styles.
+struct StatusLineRun
+{
+    std::string text;
+    std::optional<RGBColor> foregroundColor;
+    std::optional<RGBColor> backgroundColor;
+    CellFlags flags;
+
+    bool operator==(StatusLineRun const&) const = default;
+};
+
+using StatusLineRuns = std::vector<StatusLineRun>;
+
+/// Evaluated status line, ready to be written into the cells of the status line.
+struct StatusLineContent
+{
+    StatusLineRuns left;
+    StatusLineRuns middle;
+    StatusLineRuns right;
+
+    bool operator==(StatusLineContent const&) const = default;
+};
+
 class Terminal;
+
+/// Evaluates the items of the given segment into runs of styled text.
+StatusLineRuns renderStatusLineSegment(Terminal const& vt, StatusLineSegment const& segment);
+
+/// Evaluates all segments of the given status line definition.
+StatusLineContent renderStatusLine(Terminal const& vt, StatusLineDefinition const& definition);
+
+/// @returns the number of columns the text of the given runs takes.
+ColumnCount displayWidth(StatusLineRuns const& runs);
+
 std::string serializeToVT(Terminal const& vt, StatusLineSegment const& segment, StatusLineStyling styling);
 
 } // namespace vtbackend
@@ -13,23 +13,34 @@
 
 #include <vtpty/MockPty.h>
 
+#include <crispy/allocations.h>
 #include <crispy/assert.h>
 #include <crispy/escape.h>
+#include <crispy/tracing.h>
 #include <crispy/utils.h>
 
 #include <libunicode/convert.h>
+#include <libunicode/width.h>
 
 #include <gsl/pointers>
 
 #include <sys/types.h>
 
+#include <algorithm>
+#include <bit>
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <format>
+#include <future>
+#include <mutex>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <variant>
+#include <vector>
 
 using crispy::size;
 using std::nullopt;
@@ -52,6 +63,69 @@ namespace // {{{ helpers
 {
     constexpr size_t MaxColorPaletteSaveStackSize = 10;
 
+    // Tells whether the two render buffers only differ in their cursor, such as when it blinks.
+    //
+    // Any grid line damaged in between is taken as a change, so that the cells are only compared
+    // for frames that are most likely equal.
+    bool onlyCursorDiffers(RenderBuffer const& current, RenderBuffer const& previous) noexcept
+    {
+        return current.damage.valid && previous.damage.valid && current.damage.key == previous.damage.key
+               && current.damage.damageStamp == previous.damage.damageStamp && current.cells == previous.cells
+               && current.lines == previous.lines;
+    }
+
+    // Time to wait after the last resize before reflowing the remaining history lines.
+    constexpr auto PendingReflowDelay = std::chrono::milliseconds(500);
+
+    // Time the mouse has to rest while dragging a selection before the selected text gets highlighted.
+    constexpr auto SelectionMatchesDelay = std::chrono::milliseconds(100);
+
+    // Minimal number of cells on the main page to build its render buffer in parallel.
+    constexpr size_t ParallelRenderMinCellCount = 64 * 1024;
+
+    // Minimal number of lines each worker builds when building the render buffer in parallel.
+    constexpr size_t ParallelRenderMinLineCount = 16;
+
+    // Number of history lines spilled to disk that are paged in at a time for searching through them.
+    constexpr auto SpilledHistorySearchLineCount = LineCount(4096);
+
+    /// @returns the number of workers to build the main page's render buffer with.
+    size_t renderWorkerCount(PageSize pageSize) noexcept
+    {
+        auto const lineCount = unbox<size_t>(pageSize.lines);
+        if (lineCount * unbox<size_t>(pageSize.columns) < ParallelRenderMinCellCount)
+            return 1;
+        return std::clamp(size_t { std::thread::hardware_concurrency() },
+                          size_t { 1 },
+                          lineCount / ParallelRenderMinLineCount);
+    }
+
+    /// Appends the render buffer of the main page lines [firstLine, endLine) to @p output,
+    /// rebasing the line ranges of its damage state onto the cells and lines already in there.
+    void appendRenderChunk(RenderBuffer& output,
+                           RenderBuffer const& chunk,
+                           LineOffset firstLine,
+                           LineOffset endLine)
+    {
+        auto const cellBase = output.cells.size();
+        auto const lineBase = output.lines.size();
+        output.cells.appendRange(chunk.cells, 0, chunk.cells.size());
+        output.lines.insert(output.lines.end(), chunk.lines.begin(), chunk.lines.end());
+
+        for (auto line = unbox<size_t>(firstLine); line < unbox<size_t>(endLine); ++line)
+        {
+            auto const& range = chunk.damage.lineRanges[line];
+            output.damage.lineRanges[line] = RenderDamageState::LineRange {
+                .cellsBegin = range.cellsBegin + cellBase,
+                .cellsEnd = range.cellsEnd + cellBase,
+                .linesBegin = range.linesBegin + lineBase,
+                .linesEnd = range.linesEnd + lineBase,
+                .unmoved = range.unmoved,
+                .contentHash = range.contentHash,
+            };
+        }
+    }
+
     void trimSpaceRight(string& value)
     {
         while (!value.empty() && value.back() == ' ')
@@ -59,15 +133,12 @@ namespace // {{{ helpers
     }
 
 #if defined(CONTOUR_PERF_STATS)
-    void logRenderBufferSwap(bool success, uint64_t frameID)
+    void logRenderBufferSwap(uint64_t frameID)
     {
         if (!renderBufferLog)
             return;
 
-        if (success)
-            renderBufferLog()("Render buffer {} swapped.", frameID);
-        else
-            renderBufferLog()("Render buffer {} swapping failed.", frameID);
+        renderBufferLog()("Render buffer {} swapped.", frameID);
     }
 #endif
 
@@ -95,6 +166,55 @@ namespace // {{{ helpers
         return CellLocation { .line = std::max(location.line, minimumLine), .column = location.column };
     }
 
+    /// Destroys the lines released by any terminal, see Terminal::releaseGrids(), on a thread of its own.
+    ///
+    /// The thread is shared by all terminals, and neither stopped nor joined, so that no terminal,
+    /// nor the process exiting, waits for the lines to be destroyed.
+    class GridReleaser
+    {
+      public:
+        static GridReleaser& instance()
+        {
+            // Never destroyed, as the thread may still be using it while the process exits.
+            static auto* const releaser = new GridReleaser();
+            return *releaser;
+        }
+
+        /// Hands over type-erased lines, to be destroyed on the release thread.
+        void release(std::shared_ptr<void> lines)
+        {
+            {
+                auto const _ = std::scoped_lock { _mutex };
+                _pending.emplace_back(std::move(lines));
+            }
+            _available.notify_one();
+        }
+
+      private:
+        GridReleaser()
+        {
+            std::thread([this]() { run(); }).detach();
+        }
+
+        [[noreturn]] void run()
+        {
+            auto lock = std::unique_lock { _mutex };
+            while (true)
+            {
+                _available.wait(lock, [this]() { return !_pending.empty(); });
+                auto released = std::exchange(_pending, {});
+                lock.unlock();
+                released.clear();
+                crispy::trimHeap();
+                lock.lock();
+            }
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _available;
+        std::vector<std::shared_ptr<void>> _pending;
+    };
+
 } // namespace
 // }}}
 
@@ -106,18 +226,28 @@ Terminal::Terminal(Events& eventListener,
     _factorySettings { std::move(factorySettings) },
     _settings { _factorySettings },
     _currentTime { now },
-    _ptyBufferPool { crispy::nextPowerOfTwo(_settings.ptyBufferObjectSize) },
+    _ptyBufferPool { crispy::nextPowerOfTwo(_settings.ptyBufferObjectSize),
+                     _settings.ptyBufferObjectAllocation },
     _currentPtyBuffer { _ptyBufferPool.allocateBufferObject() },
-    _ptyReadBufferSize { crispy::nextPowerOfTwo(_settings.ptyReadBufferSize) },
+    _minPtyReadBufferSize { crispy::nextPowerOfTwo(_settings.ptyReadBufferSize) },
+    _maxPtyReadBufferSize { std::max(_minPtyReadBufferSize,
+                                     std::min(_minPtyReadBufferSize * 16,
+                                              crispy::nextPowerOfTwo(_settings.ptyBufferObjectSize) / 4)) },
+    _ptyReadStats { .readSize = _minPtyReadBufferSize },
     _pty { std::move(pty) },
+    _ptyReader { _settings.ptyReaderThread ? std::make_unique<PtyReader>(*_pty, _maxPtyReadBufferSize)
+                                           : nullptr },
     _lastCursorBlink { now },
-    _primaryScreen { *this,
+    _primaryScreen { _settings.cellLayout,
+                     *this,
                      &_mainScreenMargin,
                      _settings.pageSize,
                      _settings.primaryScreen.allowReflowOnResize,
                      _settings.maxHistoryLineCount,
                      "primary" },
-    _alternateScreen { *this, &_mainScreenMargin, _settings.pageSize, false, LineCount(0), "alternate" },
+    _alternateScreen {
+        _settings.cellLayout, *this, &_mainScreenMargin, _settings.pageSize, false, LineCount(0), "alternate"
+    },
     _hostWritableStatusLineScreen { *this,
                                     &_hostWritableScreenMargin,
                                     PageSize { LineCount(1), _settings.pageSize.columns },
@@ -128,15 +258,16 @@ Terminal::Terminal(Events& eventListener,
         *this,        &_indicatorScreenMargin, PageSize { LineCount(1), _settings.pageSize.columns }, false,
         LineCount(0), "indicator-status-line"
     },
-    _currentScreen { &_primaryScreen },
+    _currentScreen { &_primaryScreen.base() },
     _viewport { *this, std::bind(&Terminal::onViewportChanged, this) },
     _indicatorStatusLineDefinition { parseStatusLineDefinition(_settings.indicatorStatusLine.left,
                                                                _settings.indicatorStatusLine.middle,
                                                                _settings.indicatorStatusLine.right) },
+    _wordDelimiters { _settings.wordDelimiters },
     _selectionHelper { this },
     _extendedSelectionHelper { this },
     _customSelectionHelper { this },
-    _refreshInterval { _settings.refreshRate },
+    _framePacer { _settings.refreshRate, _settings.bulkOutputFrameInterval, _settings.variableRefreshRate },
     _traceHandler { *this },
     _cellPixelSize {},
     _defaultColorPalette { _settings.colorPalette },
@@ -157,16 +288,28 @@ Terminal::Terminal(Events& eventListener,
     _effectiveImageCanvasSize { _settings.maxImageSize },
     _sixelColorPalette { std::make_shared<SixelColorPalette>(_maxSixelColorRegisters,
                                                              _maxSixelColorRegisters) },
-    _imagePool { [this](Image const* image) {
-        discardImage(*image);
-    } },
-    _hyperlinks { .cache = HyperlinkCache { 1024 } },
+    _imagePool { [this](Image const* image) { discardImage(*image); }, _settings.imageMemoryBudget },
+    _hyperlinks { HyperlinkStorage::DefaultCapacity },
     _sequenceBuilder { ModeDependantSequenceHandler { *this }, TerminalInstructionCounter { *this } },
     _parser { std::ref(_sequenceBuilder) },
     _viCommands { *this },
-    _inputHandler { _viCommands, ViMode::Insert }
+    _inputHandler { _viCommands, ViMode::Insert },
+    _ptyWriter { *_pty, PtyWriter::DefaultPasteCapacity, [this]() {
+                    breakLoopAndRefreshRenderBuffer();
+                } }
 {
     _savedColorPalettes.reserve(MaxColorPaletteSaveStackSize);
+    _primaryScreen.visit([&](auto& screen) {
+        screen.grid().setColdHistoryThreshold(_settings.coldHistoryThreshold);
+        screen.grid().setSearchIndexEnabled(_settings.historySearchIndex);
+        screen.grid().setHistoryDeduplicationEnabled(_settings.historyDeduplication);
+        if (_settings.spillHistoryToDisk)
+            screen.grid().setHistorySpillFile(HistorySpillFile::create());
+    });
+    updateSequenceTarget();
+    _inputGenerator.setPixelMouseMoveInterval(_settings.pixelMouseMoveInterval);
+    _predictiveEcho.setThreshold(_settings.predictiveEchoThreshold);
+    _predictiveEchoEnabled = _settings.predictiveEchoThreshold.count() != 0;
 
     // TODO(should be this instead?): hardReset();
     setMode(DECMode::AutoWrap, true);
@@ -185,6 +328,21 @@ void Terminal::onViewportChanged()
     if (_inputHandler.mode() != ViMode::Insert)
         _viCommands.cursorPosition = _viewport.clampCellLocation(_viCommands.cursorPosition);
 
+    // Lines viewed while scrolled back have been unpacked, and lines beyond the history limit paged in,
+    // so pack and spill them again when returning to the main page.
+    _primaryScreen.visit([&](auto& screen) {
+        if (!_viewport.scrolled())
+        {
+            screen.grid().spillPagedInLines();
+            screen.grid().packColdHistory();
+        }
+        else
+        {
+            screen.grid().reflowPendingHistory();
+            screen.grid().unpackColdLines(-_viewport.scrollOffset().as<LineOffset>(), pageSize().lines);
+        }
+    });
+
     _eventListener.onScrollOffsetChanged(_viewport.scrollOffset());
     breakLoopAndRefreshRenderBuffer();
 }
@@ -192,7 +350,7 @@ void Terminal::onViewportChanged()
 void Terminal::setRefreshRate(RefreshRate refreshRate)
 {
     _settings.refreshRate = refreshRate;
-    _refreshInterval = RefreshInterval { refreshRate };
+    _framePacer.setRefreshRate(refreshRate);
 }
 
 void Terminal::setLastMarkRangeOffset(LineOffset value) noexcept
@@ -200,28 +358,60 @@ void Terminal::setLastMarkRangeOffset(LineOffset value) noexcept
     _settings.copyLastMarkRangeOffset = value;
 }
 
-std::optional<vtpty::Pty::ReadResult> Terminal::readFromPty()
+std::optional<std::chrono::milliseconds> Terminal::ptyReadTimeout() const
 {
-    auto const timeout =
 #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
-        (_renderBuffer.state == RenderBufferState::WaitingForRefresh && !_screenDirty)
-            ? std::optional { _refreshInterval.value }
-            : std::chrono::milliseconds(0);
+    return (_renderBuffer.state == RenderBufferState::WaitingForRefresh && !_screenDirty)
+               ? std::optional { std::chrono::ceil<std::chrono::milliseconds>(_framePacer.interval()) }
+               : std::chrono::milliseconds(0);
 #else
-        std::optional<std::chrono::milliseconds> { std::nullopt };
+    return std::nullopt;
 #endif
+}
+
+std::optional<vtpty::Pty::ReadResult> Terminal::readFromPty(std::optional<std::chrono::milliseconds> timeout)
+{
+    CRISPY_TRACE_ZONE("readFromPty", "vt");
 
     // Request a new Buffer Object if the current one cannot sufficiently
-    // store a single text line.
-    if (_currentPtyBuffer->bytesAvailable() < unbox<size_t>(_settings.pageSize.columns))
-    {
-        if (vtpty::ptyInLog)
-            vtpty::ptyInLog()("Only {} bytes left in TBO. Allocating new buffer from pool.",
-                              _currentPtyBuffer->bytesAvailable());
+    // store a single text line, or a good part of a read.
+    auto const minBytesAvailable =
+        std::max(unbox<size_t>(_settings.pageSize.columns), _ptyReadStats.readSize / 4);
+    if (_currentPtyBuffer->bytesAvailable() < minBytesAvailable)
+    {
+        LOGSTORE_LOG(vtpty::ptyInLog,
+                     "Only {} bytes left in TBO. Allocating new buffer from pool.",
+                     _currentPtyBuffer->bytesAvailable());
         _currentPtyBuffer = _ptyBufferPool.allocateBufferObject();
     }
 
-    return _pty->read(*_currentPtyBuffer, timeout, _ptyReadBufferSize);
+    auto const requested = std::min(_ptyReadStats.readSize, _currentPtyBuffer->bytesAvailable());
+    auto result = [&]() {
+        auto const _ = crispy::cpu_time_accumulator { _ptyReadCpuTime };
+        return _pty->read(*_currentPtyBuffer, timeout, _ptyReadStats.readSize);
+    }();
+    if (result && !result->data.empty())
+    {
+        updatePtyReadSize(requested, result->data.size());
+
+        // A read filling the whole buffer most likely left more output pending on the PTY.
+        _framePacer.notePtyBacklog(result->data.size() >= requested);
+    }
+    return result;
+}
+
+void Terminal::updatePtyReadSize(size_t requested, size_t received) noexcept
+{
+    auto& histogram = _ptyReadStats.histogram;
+    ++histogram[std::min(static_cast<size_t>(std::bit_width(received)), histogram.size() - 1)];
+
+    // Reads that fill the whole buffer mean bulk output (e.g. cat), which is processed faster in
+    // larger chunks. Small reads mean interactive use, where smaller chunks get displayed sooner.
+    auto& readSize = _ptyReadStats.readSize;
+    if (received >= requested)
+        readSize = std::min(readSize * 2, _maxPtyReadBufferSize);
+    else if (received < requested / 8)
+        readSize = std::max(readSize / 2, _minPtyReadBufferSize);
 }
 
 void Terminal::setExecutionMode(ExecutionMode mode)
@@ -230,10 +420,25 @@ void Terminal::setExecutionMode(ExecutionMode mode)
     _executionMode = mode;
     _breakCondition.notify_one();
     _pty->wakeupReader();
+    if (_ptyReader)
+        _ptyReader->wakeup();
+}
+
+bool Terminal::processInputOnce(std::optional<std::chrono::milliseconds> timeout)
+{
+    if (!parseInputOnce(timeout))
+        return false;
+
+    // Replies to everything parsed by this batch, such as the answers to the many queries
+    // applications send on startup, are written at once, without a detour through the GUI thread.
+    flushInput();
+    return true;
 }
 
-bool Terminal::processInputOnce()
+bool Terminal::parseInputOnce(std::optional<std::chrono::milliseconds> timeout)
 {
+    CRISPY_TRACE_ZONE("processInputOnce", "vt");
+
     // clang-format off
     switch (_executionMode.load())
     {
@@ -266,7 +471,10 @@ bool Terminal::processInputOnce()
     }
     // clang-format on
 
-    auto const readResult = readFromPty();
+    if (_ptyReader)
+        return processInputFromPtyReader(timeout);
+
+    auto const readResult = readFromPty(timeout);
 
     if (!readResult)
     {
@@ -289,7 +497,64 @@ bool Terminal::processInputOnce()
 
     {
         auto const _ = std::lock_guard { *this };
+        CRISPY_TRACE_ZONE("parseFragment", "vt");
+        CRISPY_ALLOCATION_SCOPE(parserAllocations);
+        auto const cpuTime = crispy::cpu_time_accumulator { _parseCpuTime };
         _parser.parseFragment(buf);
+        noteKeyInputAnswered();
+        verifyPredictedEcho();
+        publishCursorPosition();
+        activeDisplay().publishImagePreview();
+    }
+    _parsedBytes += buf.size();
+    _framePacer.noteOutput(buf.size());
+
+    if (!_modes.enabled(DECMode::BatchedRendering))
+        screenUpdated();
+
+#if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
+    ensureFreshRenderBuffer();
+#endif
+
+    return true;
+}
+
+bool Terminal::processInputFromPtyReader(std::optional<std::chrono::milliseconds> timeout)
+{
+    if (!_ptyReader->wait(timeout))
+    {
+        if (!_ptyReader->closed())
+            return true;
+
+        terminalLog()("PTY closed. Stopping PTY reader.");
+        _pty->close();
+        return false;
+    }
+
+    // Parse everything read so far under a single lock. Read buffers are reused by the reader thread,
+    // so the chunks are copied into the PTY buffer, which the parsed lines may keep referring to.
+    {
+        auto const _ = std::lock_guard { *this };
+        CRISPY_TRACE_ZONE("parseFragment", "vt");
+        CRISPY_ALLOCATION_SCOPE(parserAllocations);
+        auto const cpuTime = crispy::cpu_time_accumulator { _parseCpuTime };
+        _ptyReader->consume([this](PtyReader::Chunk const& chunk) {
+            _usingStdoutFastPipe = chunk.fromStdoutFastPipe;
+            _parsedBytes += chunk.data.size();
+            _framePacer.noteOutput(chunk.data.size());
+            auto data = chunk.data;
+            while (!data.empty())
+            {
+                auto const written = lockedWriteToPtyBuffer(data);
+                data.remove_prefix(written.size());
+                _parser.parseFragment(written);
+            }
+        });
+        _framePacer.notePtyBacklog(_ptyReader->pending());
+        noteKeyInputAnswered();
+        verifyPredictedEcho();
+        publishCursorPosition();
+        activeDisplay().publishImagePreview();
     }
 
     if (!_modes.enabled(DECMode::BatchedRendering))
@@ -313,6 +578,8 @@ void Terminal::breakLoopAndRefreshRenderBuffer()
     //     return;
 
     _pty->wakeupReader();
+    if (_ptyReader)
+        _ptyReader->wakeup();
 }
 
 bool Terminal::refreshRenderBuffer(bool locked)
@@ -324,14 +591,14 @@ bool Terminal::refreshRenderBuffer(bool locked)
 
 bool Terminal::ensureFreshRenderBuffer(bool locked)
 {
-    if (!_renderBufferUpdateEnabled)
+    if (!_renderBufferUpdateEnabled || _hibernated || !_visible)
     {
         // _renderBuffer.state = RenderBufferState::WaitingForRefresh;
         return false;
     }
 
     auto const elapsed = _currentTime - _renderBuffer.lastUpdate;
-    auto const avoidRefresh = elapsed < _refreshInterval.value;
+    auto const avoidRefresh = elapsed < _framePacer.interval();
 
     switch (_renderBuffer.state.load())
     {
@@ -343,29 +610,33 @@ bool Terminal::ensureFreshRenderBuffer(bool locked)
         case RenderBufferState::RefreshBuffersAndTrySwap: {
             auto& backBuffer = _renderBuffer.backBuffer();
             auto const lastCursorPos = backBuffer.cursor;
+            auto const fillStart = std::chrono::steady_clock::now();
             if (!locked)
                 fillRenderBuffer(_renderBuffer.backBuffer(), true);
             else
                 fillRenderBufferInternal(_renderBuffer.backBuffer(), true);
+            _renderBufferFillTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - fillStart)
+                                        .count();
             auto const cursorChanged =
                 lastCursorPos.has_value() != backBuffer.cursor.has_value()
                 || (backBuffer.cursor.has_value() && backBuffer.cursor->position != lastCursorPos->position);
             if (cursorChanged)
                 _eventListener.cursorPositionChanged();
-            _renderBuffer.state = RenderBufferState::TrySwapBuffers;
-            [[fallthrough]];
-        }
-        case RenderBufferState::TrySwapBuffers: {
-            [[maybe_unused]] auto const success = _renderBuffer.swapBuffers(_currentTime);
+            auto const* const previous = std::exchange(_lastRefreshedRenderBuffer, &backBuffer);
+            backBuffer.contentFrameID = previous && onlyCursorDiffers(backBuffer, *previous)
+                                            ? previous->contentFrameID
+                                            : backBuffer.frameID;
+            _renderBuffer.swapBuffers(_currentTime);
+            _framePacer.frameRefreshed();
 
 #if defined(CONTOUR_PERF_STATS)
-            logRenderBufferSwap(success, _lastFrameID);
+            logRenderBufferSwap(_lastFrameID);
 #endif
 
 #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
             // Passively invoked by the terminal thread -> do inform render thread about updates.
-            if (success)
-                _eventListener.renderBufferUpdated();
+            _eventListener.renderBufferUpdated();
 #endif
         }
         break;
@@ -373,6 +644,106 @@ bool Terminal::ensureFreshRenderBuffer(bool locked)
     return true;
 }
 
+void Terminal::hibernate()
+{
+    if (_hibernated.exchange(true))
+        return;
+
+    _renderBuffer.releaseStorage();
+    _previousRenderBuffer = RenderBuffer {};
+    _renderChunks = {};
+
+    compactGrids();
+    _ptyBufferPool.releaseUnusedBuffers();
+
+    terminalLog()("Hibernated. {} history lines compacted, {} of PTY buffers in use.",
+                  _primaryScreen.base().historyLineCount(),
+                  crispy::humanReadableBytes(_ptyBufferPool.statistics().liveBytes));
+}
+
+void Terminal::compactGrids()
+{
+    auto const compact = [](auto& screen) {
+        screen.grid().compact();
+    };
+    _primaryScreen.visit(compact);
+    _alternateScreen.visit(compact);
+}
+
+void Terminal::trimMemory()
+{
+    _renderChunks = {};
+    compactGrids();
+    _ptyBufferPool.releaseUnusedBuffers();
+
+    terminalLog()("Trimmed memory. {} history lines compacted, {} of PTY buffers in use.",
+                  _primaryScreen.base().historyLineCount(),
+                  crispy::humanReadableBytes(_ptyBufferPool.statistics().liveBytes));
+}
+
+void Terminal::discardOffscreenImages()
+{
+    auto const above = -boxed_cast<LineOffset>(_viewport.scrollOffset());
+    auto const discard = [above](auto& screen) {
+        return screen.grid().discardImagesAbove(above);
+    };
+    auto const lineCount = _primaryScreen.visit(discard) + _alternateScreen.visit(discard);
+    _imagePool.enforceMemoryBudget();
+
+    terminalLog()("Discarded the images of {} history lines, {} of images remaining.",
+                  lineCount,
+                  crispy::humanReadableBytes(_imagePool.memoryUsage()));
+}
+
+void Terminal::trimHistory(LineCount keep)
+{
+    auto const trim = [keep](auto& screen) {
+        screen.grid().trimHistory(keep);
+    };
+    _primaryScreen.visit(trim);
+    _alternateScreen.visit(trim);
+
+    if (boxed_cast<LineCount>(_viewport.scrollOffset()) > currentScreen().historyLineCount())
+        _viewport.scrollTo(boxed_cast<ScrollOffset>(currentScreen().historyLineCount()));
+
+    terminalLog()("Trimmed history to {} lines.", keep);
+}
+
+void Terminal::releaseGrids()
+{
+    // The line rings are handed to the release thread type-erased, as their cell type depends on the layout.
+    auto const release = [](auto& screen) {
+        auto lines = screen.grid().releaseLines();
+        auto const lineCount = lines.size();
+        return std::pair { std::shared_ptr<void>(std::make_shared<decltype(lines)>(std::move(lines))),
+                           lineCount };
+    };
+    auto [primaryLines, primaryLineCount] = _primaryScreen.visit(release);
+    auto [alternateLines, alternateLineCount] = _alternateScreen.visit(release);
+    _viewport.forceScrollToBottom();
+    terminalLog()("Releasing {} lines.", primaryLineCount + alternateLineCount);
+
+    GridReleaser::instance().release(std::move(primaryLines));
+    GridReleaser::instance().release(std::move(alternateLines));
+}
+
+void Terminal::revive()
+{
+    if (!_hibernated.exchange(false))
+        return;
+
+    terminalLog()("Revived from hibernation.");
+    breakLoopAndRefreshRenderBuffer();
+}
+
+void Terminal::setVisible(bool visible)
+{
+    if (_visible.exchange(visible) == visible || !visible)
+        return;
+
+    breakLoopAndRefreshRenderBuffer();
+}
+
 PageSize Terminal::TheSelectionHelper::pageSize() const noexcept
 {
     return terminal->pageSize();
@@ -405,11 +776,25 @@ int Terminal::TheSelectionHelper::cellWidth(CellLocation pos) const noexcept
  */
 struct ScopedHyperlinkHover
 {
-    std::shared_ptr<HyperlinkInfo const> href;
+    HyperlinkId id {};
+    HyperlinkInfo const* href = nullptr;
+    std::optional<ColumnRange> detected; // cells of the hovered hyperlink, if detected in the text
 
-    ScopedHyperlinkHover(Terminal const& terminal, ScreenBase const& /*screen*/):
-        href { terminal.tryGetHoveringHyperlink() }
+    ScopedHyperlinkHover(Terminal const& terminal, ScreenBase const& screen)
     {
+        if (auto const gridPosition = terminal.currentMouseGridPosition())
+        {
+            if (auto const hyperlink = screen.detectedHyperlinkAt(*gridPosition))
+            {
+                id = hyperlink->id;
+                detected = ColumnRange { .line = gridPosition->line,
+                                         .fromColumn = hyperlink->start,
+                                         .toColumn = hyperlink->end - ColumnOffset(1) };
+            }
+            else
+                id = screen.hyperlinkIdAt(*gridPosition);
+        }
+        href = terminal.hyperlinks().hyperlinkById(id);
         if (href)
             href->state = HyperlinkState::Hover; // TODO: Left-Ctrl pressed?
     }
@@ -430,25 +815,78 @@ void Terminal::updateInputMethodPreeditString(std::string preeditString)
     screenUpdated();
 }
 
+MemoryUsage Terminal::memoryUsage() const
+{
+    auto const _ = std::shared_lock { *this };
+    auto const& poolStats = _ptyBufferPool.statistics();
+
+    auto const gridMemoryUsage = [](auto const& screen) {
+        return screen.grid().memoryUsage();
+    };
+    auto const sixelImageMemoryUsage = [](auto const& screen) {
+        return screen.sixelImageMemoryUsage();
+    };
+
+    auto result = _primaryScreen.visit(gridMemoryUsage);
+    result += _alternateScreen.visit(gridMemoryUsage);
+    result.hyperlinks = _hyperlinks.memoryUsage();
+    result.images = _imagePool.memoryUsage();
+    result.renderBuffers = _renderBufferMemoryUsage;
+    result.parser = sizeof(_parser) + _sequenceBuilder.memoryUsage() + _kittyGraphics.pendingMemoryUsage()
+                    + _primaryScreen.visit(sixelImageMemoryUsage)
+                    + _alternateScreen.visit(sixelImageMemoryUsage);
+    result.ptyBuffers = poolStats.liveBytes + poolStats.unusedBytes;
+    return result;
+}
+
+Terminal::CpuTimes Terminal::cpuTimes() const noexcept
+{
+    auto const load = [](std::atomic<int64_t> const& value) {
+        return std::chrono::nanoseconds(value.load(std::memory_order_relaxed));
+    };
+    auto const readerCpuTime = _ptyReader ? _ptyReader->readCpuTime() : std::chrono::nanoseconds(0);
+    return CpuTimes {
+        .ptyRead = load(_ptyReadCpuTime) + readerCpuTime,
+        .parse = load(_parseCpuTime),
+        .renderBufferFill = load(_renderBufferFillCpuTime),
+    };
+}
+
 void Terminal::fillRenderBuffer(RenderBuffer& output, bool includeSelection)
 {
     auto const _ = std::lock_guard { *this };
+    CRISPY_TRACE_ZONE("fillRenderBuffer", "vt");
     fillRenderBufferInternal(output, includeSelection);
+
+    // The three buffers handed to the renderer are not accessible from here but the one just filled,
+    // which the others grow alike to, as they are all filled with the same contents over time.
+    _renderBufferMemoryUsage = 3 * output.memoryUsage() + _previousRenderBuffer.memoryUsage();
+    for (auto const& chunk: _renderChunks)
+        _renderBufferMemoryUsage += chunk.memoryUsage();
 }
 
 void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelection)
 {
+    CRISPY_ALLOCATION_SCOPE(renderBufferAllocations);
+    auto const cpuTime = crispy::cpu_time_accumulator { _renderBufferFillCpuTime };
     verifyState();
 
+    // Keep the previous contents of this buffer, so that undamaged lines can be taken over from them.
+    std::swap(output.cells, _previousRenderBuffer.cells);
+    std::swap(output.lines, _previousRenderBuffer.lines);
+    std::swap(output.damage, _previousRenderBuffer.damage);
     output.clear();
+    output.inputTiming = std::exchange(_answeredInput, std::nullopt);
 
     _changes.store(0);
     _screenDirty = false;
     ++_lastFrameID;
 
+    if (_predictiveEcho.expire(_currentTime))
+        _predictiveEchoDeadline = 0;
+
 #if defined(CONTOUR_PERF_STATS)
-    if (terminalLog)
-        terminalLog()("{}: Refreshing render buffer.\n", _lastFrameID.load());
+    LOGSTORE_LOG(terminalLog, "{}: Refreshing render buffer.\n", _lastFrameID.load());
 #endif
 
     auto baseLine = LineOffset(0);
@@ -457,6 +895,7 @@ void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelect
         baseLine += fillRenderBufferStatusLine(output, includeSelection, baseLine).as<LineOffset>();
 
     auto const hoveringHyperlinkGuard = ScopedHyperlinkHover { *this, *_currentScreen };
+    _hoveringDetectedHyperlink = hoveringHyperlinkGuard.detected;
     auto const mainDisplayReverseVideo = isModeEnabled(vtbackend::DECMode::ReverseVideo);
     auto const highlightSearchMatches =
         _search.pattern.empty() ? HighlightSearchMatches::No : HighlightSearchMatches::Yes;
@@ -471,30 +910,105 @@ void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelect
         return _viCommands.cursorPosition;
     }();
 
+    auto const& palette = colorPalette();
+    auto const damageKey = RenderDamageState::Key {
+        .screenType = _currentScreenType,
+        .pageSize = pageSize(),
+        .baseLine = baseLine,
+        .reverseVideo = mainDisplayReverseVideo,
+        .hoveringHyperlink = hoveringHyperlinkGuard.id,
+        .palette = palette.palette,
+        .defaultForeground = palette.defaultForeground,
+        .defaultBackground = palette.defaultBackground,
+        .defaultForegroundBright = palette.defaultForegroundBright,
+        .defaultForegroundDimmed = palette.defaultForegroundDimmed,
+        .useBrightColors = palette.useBrightColors,
+        .volatileState = (includeSelection && selectionAvailable())
+                         || !_search.pattern.empty() || _highlightRange.has_value()
+                         || inputHandler().mode() != ViMode::Insert
+                         || !_inputMethodData.preeditString.empty() || !_predictiveEcho.empty(),
+    };
+
+    // Applications using synchronized output tend to rewrite their whole page with each batch.
+    auto const compareDamagedLines = std::exchange(_synchronizedOutputSinceRefresh, false);
+
+    auto const renderMainPage = [&]<CellConcept Cell>(Screen<Cell> const& screen) -> RenderPassHints {
+        auto const makeBuilder = [&](RenderBuffer& target) {
+            auto builder = RenderBufferBuilder<Cell> { *this,
+                                                       target,
+                                                       baseLine,
+                                                       mainDisplayReverseVideo,
+                                                       HighlightSearchMatches::Yes,
+                                                       _inputMethodData,
+                                                       theCursorPosition,
+                                                       includeSelection };
+            builder.trackDamage(_previousRenderBuffer,
+                                screen.grid(),
+                                damageKey,
+                                screen.cursor().position.line,
+                                _viewport.scrollOffset(),
+                                compareDamagedLines);
+            return builder;
+        };
+
+        // Search matches may span multiple lines and the IME preedit string moves the cursor,
+        // so these are only rendered sequentially.
+        auto const workerCount = _search.pattern.empty() && _inputMethodData.preeditString.empty()
+                                     ? renderWorkerCount(pageSize())
+                                     : size_t { 1 };
+        if (workerCount == 1)
+            return screen.render(makeBuilder(output), _viewport.scrollOffset(), highlightSearchMatches);
+
+        // Each worker renders its own range of lines into its own buffer, only reading terminal state,
+        // and the buffers are concatenated in order afterwards.
+        screen.grid().refreshStaleLines();
+        auto const lineCount = unbox<size_t>(pageSize().lines);
+        auto const chunkSize = (lineCount + workerCount - 1) / workerCount;
+        auto const chunkLines = [&](size_t chunk) {
+            return std::pair { LineOffset::cast_from(std::min(chunk * chunkSize, lineCount)),
+                               LineOffset::cast_from(std::min((chunk + 1) * chunkSize, lineCount)) };
+        };
+
+        _renderChunks.resize(workerCount);
+        auto const renderChunk = [&](size_t chunk) {
+            auto& target = _renderChunks[chunk];
+            target.clear();
+            auto const [firstLine, endLine] = chunkLines(chunk);
+            return screen.renderLines(
+                makeBuilder(target), firstLine, endLine, _viewport.scrollOffset(), highlightSearchMatches);
+        };
+
+        auto workers = std::vector<std::future<RenderPassHints>> {};
+        workers.reserve(workerCount - 1);
+        for (auto chunk = size_t { 1 }; chunk < workerCount; ++chunk)
+            workers.emplace_back(std::async(std::launch::async, renderChunk, chunk));
+        auto hints = renderChunk(0);
+        for (auto& worker: workers)
+            hints.containsBlinkingCells = worker.get().containsBlinkingCells || hints.containsBlinkingCells;
+
+        output.frameID = _renderChunks.front().frameID;
+        output.cursor = _renderChunks.front().cursor;
+        output.damage = _renderChunks.front().damage;
+        output.damage.lineRanges.assign(lineCount, RenderDamageState::LineRange {});
+        for (auto chunk = size_t { 0 }; chunk < workerCount; ++chunk)
+        {
+            auto const [firstLine, endLine] = chunkLines(chunk);
+            appendRenderChunk(output, _renderChunks[chunk], firstLine, endLine);
+        }
+        return hints;
+    };
+
     if (isPrimaryScreen())
-        _lastRenderPassHints =
-            _primaryScreen.render(RenderBufferBuilder<PrimaryScreenCell> { *this,
-                                                                           output,
-                                                                           baseLine,
-                                                                           mainDisplayReverseVideo,
-                                                                           HighlightSearchMatches::Yes,
-                                                                           _inputMethodData,
-                                                                           theCursorPosition,
-                                                                           includeSelection },
-                                  _viewport.scrollOffset(),
-                                  highlightSearchMatches);
+        _lastRenderPassHints = _primaryScreen.visit(renderMainPage);
     else
-        _lastRenderPassHints =
-            _alternateScreen.render(RenderBufferBuilder<AlternateScreenCell> { *this,
-                                                                               output,
-                                                                               baseLine,
-                                                                               mainDisplayReverseVideo,
-                                                                               HighlightSearchMatches::Yes,
-                                                                               _inputMethodData,
-                                                                               theCursorPosition,
-                                                                               includeSelection },
-                                    _viewport.scrollOffset(),
-                                    highlightSearchMatches);
+        _lastRenderPassHints = _alternateScreen.visit(renderMainPage);
+
+    if (!_predictiveEcho.empty())
+        renderPredictedEcho(output, baseLine);
+
+    // Blinking cells change with the blink state, so must not be taken over by the next refresh either.
+    if (_lastRenderPassHints.containsBlinkingCells)
+        output.damage.key.volatileState = true;
 
     if (_settings.statusDisplayPosition == StatusDisplayPosition::Bottom)
     {
@@ -563,6 +1077,16 @@ void Terminal::updateIndicatorStatusLine()
         crispy::unreachable();
     }();
 
+    // The status line is only rewritten if what is to be shown changed, e.g. the clock, the input mode,
+    // or the window title, rather than on each frame.
+    auto state =
+        IndicatorStatusLineState { .content = renderStatusLine(*this, _indicatorStatusLineDefinition),
+                                   .foreground = colors.foreground,
+                                   .background = colors.background,
+                                   .columns = _indicatorStatusScreen.pageSize().columns };
+    if (_indicatorStatusLineState == state)
+        return;
+
     auto const backupForeground = _colorPalette.defaultForeground;
     auto const backupBackground = _colorPalette.defaultBackground;
     _colorPalette.defaultForeground = colors.foreground;
@@ -581,42 +1105,39 @@ void Terminal::updateIndicatorStatusLine()
     _indicatorStatusScreen.cursor().graphicsRendition.backgroundColor = colors.background;
     _indicatorStatusScreen.clearLine();
 
-    using Styling = StatusLineStyling;
-    auto const& definitions = _indicatorStatusLineDefinition;
+    // The runs are written right into the cells, without going through the VT parser.
+    auto const writeRuns = [&](StatusLineRuns const& runs) {
+        for (auto const& run: runs)
+        {
+            _indicatorStatusScreen.cursor().graphicsRendition = GraphicsAttributes {
+                .foregroundColor = run.foregroundColor.value_or(colors.foreground),
+                .backgroundColor = run.backgroundColor.value_or(colors.background),
+                .flags = run.flags,
+            };
+            _indicatorStatusScreen.writeTextFromExternal(run.text);
+        }
+    };
+
+    auto const& content = state.content;
+    auto const columns = state.columns;
 
-    if (!definitions.left.empty())
-    {
-        auto const leftVT = serializeToVT(*this, definitions.left, Styling::Enabled);
-        writeToScreenInternal(_indicatorStatusScreen, leftVT);
-    }
+    writeRuns(content.left);
 
-    if (!definitions.middle.empty() || !definitions.right.empty())
+    // Don't show the middle or right segment if its text is too long.
+    if (auto const middleWidth = displayWidth(content.middle); middleWidth < columns)
     {
-        // Don't show the middle segment if text is too long.
-        auto const middleLength = serializeToVT(*this, definitions.middle, Styling::Disabled).size();
-        auto const center = pageSize().columns / ColumnCount(2) - ColumnCount(1);
-        // size of middleVT segment is less that number of elements in the string due to formatting
-        // and on average we can assume that the middle segment is half the size of the string
         _indicatorStatusScreen.moveCursorToColumn(
-            ColumnOffset::cast_from(center - ColumnOffset::cast_from(middleLength / 4)));
-        auto const middleVT = serializeToVT(*this, definitions.middle, Styling::Enabled);
-        if (unbox<size_t>(center) > static_cast<size_t>(middleLength / 2))
-            writeToScreenInternal(_indicatorStatusScreen, middleVT);
-
-        // Don't show the right part if the left and middle segments are too long.
-        // That is, if the current cursor position is past the beginning of the right segment.
-        // Also don't show if the right text is too long.
-        auto const rightLength = serializeToVT(*this, definitions.right, Styling::Disabled).size();
-        if (ColumnCount::cast_from(rightLength) < _indicatorStatusScreen.pageSize().columns)
-        {
-            _indicatorStatusScreen.moveCursorToColumn(
-                boxed_cast<ColumnOffset>(_indicatorStatusScreen.pageSize().columns)
-                - ColumnOffset::cast_from(rightLength));
+            boxed_cast<ColumnOffset>((columns - middleWidth) / ColumnCount(2)));
+        writeRuns(content.middle);
+    }
 
-            auto const rightVT = serializeToVT(*this, definitions.right, Styling::Enabled);
-            writeToScreenInternal(_indicatorStatusScreen, rightVT);
-        }
+    if (auto const rightWidth = displayWidth(content.right); rightWidth < columns)
+    {
+        _indicatorStatusScreen.moveCursorToColumn(boxed_cast<ColumnOffset>(columns - rightWidth));
+        writeRuns(content.right);
     }
+
+    _indicatorStatusLineState = std::move(state);
 }
 
 Handled Terminal::sendKeyEvent(Key key, Modifiers modifiers, KeyboardEventType eventType, Timestamp now)
@@ -630,11 +1151,17 @@ Handled Terminal::sendKeyEvent(Key key, Modifiers modifiers, KeyboardEventType e
     if (_inputHandler.sendKeyPressEvent(key, modifiers, eventType))
         return Handled { true };
 
-    bool const success = _inputGenerator.generate(key, modifiers, eventType);
+    bool const success = [&]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        return _inputGenerator.generate(key, modifiers, eventType);
+    }();
     if (success)
     {
+        noteKeyInput(now);
+        _framePacer.noteUserInput();
         flushInput();
         _viewport.scrollToBottom();
+        predictEcho(key, modifiers, eventType, now);
     }
     return Handled { success };
 }
@@ -652,15 +1179,126 @@ Handled Terminal::sendCharEvent(
     if (_inputHandler.sendCharPressEvent(ch, modifiers, eventType))
         return Handled { true };
 
-    auto const success = _inputGenerator.generate(ch, physicalKey, modifiers, eventType);
+    auto const success = [&]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        return _inputGenerator.generate(ch, physicalKey, modifiers, eventType);
+    }();
     if (success)
     {
+        noteKeyInput(now);
+        _framePacer.noteUserInput();
         flushInput();
         _viewport.scrollToBottom();
+        predictEcho(ch, modifiers, eventType, now);
     }
     return Handled { success };
 }
 
+// {{{ predictive echo
+void Terminal::setPredictiveEchoThreshold(std::chrono::milliseconds value)
+{
+    _settings.predictiveEchoThreshold = value;
+    _predictiveEcho.setThreshold(value);
+    _predictiveEchoEnabled = value.count() != 0;
+    predictedEchoChanged();
+}
+
+bool Terminal::canPredictEcho() const noexcept
+{
+    // Only the application's own cursor on the main page is predicted to move.
+    return isPrimaryScreen() && _activeStatusDisplay == ActiveStatusDisplay::Main
+           && isModeEnabled(DECMode::VisibleCursor) && _inputHandler.mode() == ViMode::Insert
+           && _inputMethodData.preeditString.empty();
+}
+
+void Terminal::predictEcho(char32_t ch, Modifiers modifiers, KeyboardEventType eventType, Timestamp now)
+{
+    if (!_predictiveEchoEnabled.load() || eventType == KeyboardEventType::Release)
+        return;
+
+    auto const _ = std::lock_guard { *this };
+    auto const printable = ch >= 0x20 && ch != 0x7F && unicode::width(ch) == 1
+                           && (modifiers.none() || modifiers == Modifier::Shift);
+    if (!printable || !canPredictEcho()
+        || !_predictiveEcho.predictText(ch, currentScreen().cursor().position, pageSize().columns, now))
+        _predictiveEcho.interrupt();
+    predictedEchoChanged();
+}
+
+void Terminal::predictEcho(Key key, Modifiers modifiers, KeyboardEventType eventType, Timestamp now)
+{
+    if (!_predictiveEchoEnabled.load() || eventType == KeyboardEventType::Release)
+        return;
+
+    auto const _ = std::lock_guard { *this };
+    auto const columns = key == Key::LeftArrow ? -1 : key == Key::RightArrow ? 1 : 0;
+    if (!columns || !modifiers.none() || !canPredictEcho()
+        || !_predictiveEcho.predictCursorMove(
+            columns, currentScreen().cursor().position, pageSize().columns, now))
+        _predictiveEcho.interrupt();
+    predictedEchoChanged();
+}
+
+void Terminal::verifyPredictedEcho()
+{
+    if (!_predictiveEchoEnabled.load())
+        return;
+
+    auto const changed = [&]() {
+        if (!isPrimaryScreen())
+        {
+            auto const hadPredictions = !_predictiveEcho.empty();
+            _predictiveEcho.reset();
+            return hadPredictions;
+        }
+        return _predictiveEcho.verify(currentScreen(), currentScreen().cursor().position, _currentTime);
+    }();
+    if (changed)
+        predictedEchoChanged();
+}
+
+void Terminal::predictedEchoChanged() noexcept
+{
+    auto const deadline = _predictiveEcho.deadline();
+    _predictiveEchoDeadline =
+        deadline ? std::chrono::duration_cast<std::chrono::nanoseconds>(deadline->time_since_epoch()).count()
+                 : 0;
+    screenUpdated();
+}
+
+void Terminal::renderPredictedEcho(RenderBuffer& output, LineOffset baseLine) const
+{
+    auto const toScreen = [&](CellLocation position) {
+        auto const screenPosition = _viewport.translateGridToScreenCoordinate(position);
+        return CellLocation { .line = baseLine + screenPosition.line, .column = screenPosition.column };
+    };
+
+    // Predictions are drawn underlined, in place of the cells they are predicted for.
+    auto& cells = output.cells;
+    for (auto const& prediction: _predictiveEcho.predictions())
+    {
+        auto const position = toScreen(prediction.position);
+        auto const cell = std::ranges::find(cells.positions, position);
+        if (cell == cells.positions.end())
+            continue;
+        auto const index = static_cast<size_t>(std::distance(cells.positions.begin(), cell));
+        if (cells.widths[index] != 1)
+            continue;
+
+        cells.codepointRanges[index] = RenderCells::CodepointRange {
+            .offset = static_cast<uint32_t>(cells.codepointArena.size()), .count = 1
+        };
+        cells.codepointArena.push_back(prediction.codepoint);
+        auto& attributes = cells.attributes[index];
+        attributes.flags.enable(CellFlag::Underline);
+        attributes.decorationColor = attributes.foregroundColor;
+    }
+
+    if (auto const cursor = _predictiveEcho.cursor(); cursor && output.cursor)
+        output.cursor->position = toScreen(*cursor);
+}
+// }}}
+
 Handled Terminal::sendMousePressEvent(Modifiers modifiers,
                                       MouseButton button,
                                       PixelCoordinate pixelPosition,
@@ -676,10 +1314,11 @@ Handled Terminal::sendMousePressEvent(Modifiers modifiers,
 
     verifyState();
 
-    auto const eventHandledByApp =
-        allowPassMouseEventToApp(modifiers)
-        && _inputGenerator.generateMousePress(
+    auto const eventHandledByApp = allowPassMouseEventToApp(modifiers) && [&]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        return _inputGenerator.generateMousePress(
             modifiers, button, _currentMousePosition, pixelPosition, uiHandledHint);
+    }();
 
     // TODO: Ctrl+(Left)Click's should still be catched by the terminal iff there's a hyperlink
     // under the current position
@@ -703,6 +1342,21 @@ void Terminal::updateSelectionMatches()
     if (!_settings.visualizeSelectedWord)
         return;
 
+    if (_leftMouseButtonPressed)
+    {
+        _selectionMatchesDeadline = _currentTime + SelectionMatchesDelay;
+        return;
+    }
+
+    applySelectionMatches();
+}
+
+void Terminal::applySelectionMatches()
+{
+    _selectionMatchesDeadline.reset();
+    if (!selectionAvailable())
+        return;
+
     auto const text = extractSelectionText();
     auto const text32 = unicode::convert_to<char32_t>(string_view(text.data(), text.size()));
     setNewSearchTerm(text32, true);
@@ -779,7 +1433,7 @@ void Terminal::triggerWordWiseSelectionWithCustomDelimiters(string const& delimi
     };
     if (_inputHandler.mode() != ViMode::Insert)
         _viCommands.cursorPosition = startPos;
-    _customSelectionHelper.wordDelimited = [wordDelimiters = unicode::from_utf8(delimiters),
+    _customSelectionHelper.wordDelimited = [wordDelimiters = WordDelimiters(unicode::from_utf8(delimiters)),
                                             this](CellLocation const& pos) {
         return this->wordDelimited(pos, wordDelimiters);
     };
@@ -885,9 +1539,17 @@ void Terminal::sendMouseMoveEvent(Modifiers modifiers,
     // Do not handle mouse-move events in sub-cell dimensions.
     if (allowPassMouseEventToApp(modifiers))
     {
-        if (_inputGenerator.generateMouseMove(
-                modifiers, relativePos, pixelPosition, uiHandledHint || !selectionAvailable()))
+        auto lock = std::unique_lock { _inputMutex };
+        auto const hadPendingMove = _inputGenerator.pendingMouseMoveDeadline().has_value();
+        auto const generated = _inputGenerator.generateMouseMove(
+            modifiers, relativePos, pixelPosition, uiHandledHint || !selectionAvailable(), _currentTime);
+        auto const pendingMove = _inputGenerator.pendingMouseMoveDeadline().has_value();
+        lock.unlock();
+        if (generated)
             flushInput();
+        else if (!hadPendingMove && pendingMove)
+            // Coalesced moves are reported on tick(), so make sure there is a frame to tick on.
+            renderBufferUpdated();
         if (!isModeEnabled(DECMode::MousePassiveTracking))
             return;
     }
@@ -926,6 +1588,8 @@ Handled Terminal::sendMouseReleaseEvent(Modifiers modifiers,
     if (button == MouseButton::Left)
     {
         _leftMouseButtonPressed = false;
+        if (_selectionMatchesDeadline)
+            applySelectionMatches();
         if (selectionAvailable())
         {
             switch (selector()->state())
@@ -941,9 +1605,11 @@ Handled Terminal::sendMouseReleaseEvent(Modifiers modifiers,
         }
     }
 
-    if (allowPassMouseEventToApp(modifiers)
-        && _inputGenerator.generateMouseRelease(
-            modifiers, button, _currentMousePosition, pixelPosition, uiHandledHint))
+    if (allowPassMouseEventToApp(modifiers) && [&]() {
+            auto const _ = std::scoped_lock { _inputMutex };
+            return _inputGenerator.generateMouseRelease(
+                modifiers, button, _currentMousePosition, pixelPosition, uiHandledHint);
+        }())
     {
         flushInput();
 
@@ -959,7 +1625,11 @@ bool Terminal::sendFocusInEvent()
     _focused = true;
     breakLoopAndRefreshRenderBuffer();
 
-    if (_inputGenerator.generateFocusInEvent())
+    auto const generated = [this]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        return _inputGenerator.generateFocusInEvent();
+    }();
+    if (generated)
     {
         flushInput();
         return true;
@@ -973,7 +1643,11 @@ bool Terminal::sendFocusOutEvent()
     _focused = false;
     breakLoopAndRefreshRenderBuffer();
 
-    if (_inputGenerator.generateFocusOutEvent())
+    auto const generated = [this]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        return _inputGenerator.generateFocusOutEvent();
+    }();
+    if (generated)
     {
         flushInput();
         return true;
@@ -994,8 +1668,70 @@ void Terminal::sendPaste(string_view text)
         return;
     }
 
-    _inputGenerator.generatePaste(text);
+    // Input generated before goes first, even though the paste may be queued behind other pastes.
     flushInput();
+
+    auto const accepted = [&]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        _inputGenerator.generatePaste(text);
+        auto const paste = _inputGenerator.peek();
+        auto const result = _ptyWriter.writePaste(paste, _inputGenerator.bracketedPaste());
+        _inputGenerator.consume(static_cast<int>(paste.size()));
+        return result;
+    }();
+    if (!accepted)
+        _eventListener.bell();
+}
+
+void Terminal::sendPasteStream(PtyWriter::PasteSource source)
+{
+    if (!allowInput())
+        return;
+
+    if (_inputHandler.isEditingSearch())
+    {
+        for (auto chunk = source(); !chunk.empty(); chunk = source())
+            _search.pattern += unicode::convert_to<char32_t>(std::string_view(chunk));
+        screenUpdated();
+        return;
+    }
+
+    inputLog()("Sending streamed paste.");
+
+    // Input generated before goes first, even though the paste may be queued behind other pastes.
+    flushInput();
+
+    auto const bracketedPaste = [this]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        return _inputGenerator.bracketedPaste();
+    }();
+    if (!bracketedPaste)
+    {
+        _ptyWriter.writePaste(std::move(source), false);
+        return;
+    }
+
+    // The stream as a whole, rather than each chunk, is wrapped in bracketed paste markers.
+    enum class Part : uint8_t
+    {
+        Start,
+        Text,
+        Done
+    };
+    auto bracketed = [source = std::move(source), part = Part::Start]() mutable -> std::string {
+        switch (part)
+        {
+            case Part::Start: part = Part::Text; return "\033[200~";
+            case Part::Text:
+                if (auto chunk = source(); !chunk.empty())
+                    return chunk;
+                part = Part::Done;
+                return "\033[201~";
+            case Part::Done: break;
+        }
+        return {};
+    };
+    _ptyWriter.writePaste(std::move(bracketed), true);
 }
 
 void Terminal::sendRawInput(string_view text)
@@ -1005,38 +1741,69 @@ void Terminal::sendRawInput(string_view text)
 
     if (_inputHandler.isEditingSearch())
     {
-        inputLog()("Sending raw input to search input: {}", crispy::escape(text));
+        LOGSTORE_LOG(inputLog, "Sending raw input to search input: {}", crispy::escape(text));
         _search.pattern += unicode::convert_to<char32_t>(text);
         screenUpdated();
         return;
     }
 
-    inputLog()("Sending raw input to stdin: {}", crispy::escape(text));
-    _inputGenerator.generateRaw(text);
+    LOGSTORE_LOG(inputLog, "Sending raw input to stdin: {}", crispy::escape(text));
+    {
+        auto const _ = std::scoped_lock { _inputMutex };
+        _inputGenerator.generateRaw(text);
+    }
     flushInput();
 }
 
 bool Terminal::hasInput() const noexcept
 {
+    auto const _ = std::scoped_lock { _inputMutex };
     return !_inputGenerator.peek().empty();
 }
 
+void Terminal::noteKeyInput(Timestamp now) noexcept
+{
+    auto const time = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    _lastKeyInputTime.store(time, std::memory_order_relaxed);
+    auto expected = int64_t { 0 };
+    _unansweredInputTime.compare_exchange_strong(expected, time);
+}
+
+void Terminal::noteKeyInputAnswered() noexcept
+{
+    auto const inputTime = _unansweredInputTime.exchange(0);
+    if (!inputTime)
+        return;
+
+    auto const timing = InputTiming {
+        .input =
+            Timestamp(std::chrono::duration_cast<Timestamp::duration>(std::chrono::nanoseconds(inputTime))),
+        .answered = std::chrono::steady_clock::now(),
+    };
+    _predictiveEcho.noteLatency(timing.answered - timing.input);
+    if (!_answeredInput)
+        _answeredInput = timing;
+}
+
 void Terminal::flushInput()
 {
+    auto const _ = std::scoped_lock { _inputMutex };
     if (_inputGenerator.peek().empty())
         return;
 
     // XXX Should be the only location that does write to the PTY's stdin to avoid race conditions.
+    // The writer queues whatever the PTY does not accept right away, so this never blocks.
     auto const input = _inputGenerator.peek();
-    auto const rv = _pty->write(input);
-    if (rv > 0)
-        _inputGenerator.consume(rv);
+    _ptyWriter.writeInput(input);
+    _inputGenerator.consume(static_cast<int>(input.size()));
 }
 
 void Terminal::writeToScreen(string_view vtStream)
 {
     {
         auto const l = std::lock_guard { *this };
+        CRISPY_ALLOCATION_SCOPE(parserAllocations);
+        auto const cpuTime = crispy::cpu_time_accumulator { _parseCpuTime };
         while (!vtStream.empty())
         {
             if (_currentPtyBuffer->bytesAvailable() < 64
@@ -1047,6 +1814,9 @@ void Terminal::writeToScreen(string_view vtStream)
             vtStream.remove_prefix(chunk.size());
             _parser.parseFragment(_currentPtyBuffer->writeAtEnd(chunk));
         }
+        verifyPredictedEcho();
+        publishCursorPosition();
+        activeDisplay().publishImagePreview();
     }
 
     if (!_modes.enabled(DECMode::BatchedRendering))
@@ -1071,7 +1841,7 @@ size_t Terminal::maxBulkTextSequenceWidth() const noexcept
     if (!isPrimaryScreen())
         return 0;
 
-    if (!_primaryScreen.currentLine().isTrivialBuffer())
+    if (!_primaryScreen.visit([](auto const& screen) { return screen.currentLine().isTrivialBuffer(); }))
         return 0;
 
     assert(_mainScreenMargin.horizontal.to >= _currentScreen->cursor().position.column);
@@ -1079,59 +1849,9 @@ size_t Terminal::maxBulkTextSequenceWidth() const noexcept
     return unbox<size_t>(_mainScreenMargin.horizontal.to - _currentScreen->cursor().position.column);
 }
 
-// {{{ SimpleSequenceHandler
-// This simple sequence handler is used to write to the screen
-// without any optimizations (and no parser hooking).
-// We use this for rendering the status line.
-struct SimpleSequenceHandler
-{
-    Screen<StatusDisplayCell>& targetScreen;
-
-    void executeControlCode(char controlCode) { targetScreen.executeControlCode(controlCode); }
-
-    void processSequence(Sequence const& seq)
-    {
-        // NB: We might want to check for some VT sequences that should not be processed here.
-        // We might make use of Terminal::activeSequences() here somehow.
-        targetScreen.processSequence(seq);
-    }
-
-    void writeText(char32_t codepoint) { targetScreen.writeText(codepoint); }
-
-    void writeText(std::string_view chars, size_t /*cellCount*/)
-    {
-        // implementation of targetScreen.writeText(chars, cellCount)
-        // is buggy and does not work correctly
-        // so we do not use optimization for
-        // ParserEvents::print(chars,cellCount)
-        // but write char by char
-        // TODO fix targetScreen.writeText(chars, cellCount)
-        for (auto c: chars)
-            targetScreen.writeText(c);
-    }
-
-    void writeTextEnd() { targetScreen.writeTextEnd(); }
-
-    [[nodiscard]] size_t maxBulkTextSequenceWidth() const noexcept
-    {
-        // Returning 0 here, because we do not make use of the performance optimized bulk write above.
-        return 0;
-    }
-};
-// }}}
-
-void Terminal::writeToScreenInternal(Screen<StatusDisplayCell>& screen, std::string_view vtStream)
-{
-    auto sequenceHandler = SimpleSequenceHandler { screen };
-    auto sequenceBuilder = SequenceBuilder { sequenceHandler, NoOpInstructionCounter() };
-    // auto sequenceBuilder = SequenceBuilder { *this, NoOpInstructionCounter() };
-    auto parser = vtparser::Parser { sequenceBuilder };
-
-    parser.parseFragment(vtStream);
-}
-
 void Terminal::writeToScreenInternal(std::string_view vtStream)
 {
+    CRISPY_ALLOCATION_SCOPE(parserAllocations);
     while (!vtStream.empty())
     {
         auto const chunk = lockedWriteToPtyBuffer(vtStream);
@@ -1166,39 +1886,66 @@ void Terminal::updateHoveringHyperlinkState()
         renderBufferUpdated();
 }
 
+void Terminal::publishCursorPosition() noexcept
+{
+    _publishedCursorPosition.store(_currentScreen->cursor().position, std::memory_order_relaxed);
+}
+
 optional<chrono::milliseconds> Terminal::nextRender() const
 {
-    auto nextBlink = chrono::milliseconds::max();
-    if ((isModeEnabled(DECMode::VisibleCursor) && _settings.cursorDisplay == CursorDisplay::Blink)
-        || isBlinkOnScreen())
+    // Only the timers that currently affect the screen are taken into account, and only the earliest
+    // of their deadlines is waited for, such that an idle terminal is not woken up at all.
+    auto nextDeadline = optional<chrono::steady_clock::time_point> {};
+    auto const schedule = [&](chrono::steady_clock::time_point deadline) {
+        nextDeadline = nextDeadline ? std::min(*nextDeadline, deadline) : deadline;
+    };
+
+    if (isModeEnabled(DECMode::VisibleCursor) && _settings.cursorDisplay == CursorDisplay::Blink)
+        schedule(_lastCursorBlink + _settings.cursorBlinkInterval);
+
+    if (isBlinkOnScreen())
     {
-        auto const passedCursor =
-            chrono::duration_cast<chrono::milliseconds>(_currentTime - _lastCursorBlink);
-        auto const passedSlowBlink = chrono::duration_cast<chrono::milliseconds>(_currentTime - _lastBlink);
-        auto const passedRapidBlink =
-            chrono::duration_cast<chrono::milliseconds>(_currentTime - _lastRapidBlink);
-        if (passedCursor <= _settings.cursorBlinkInterval)
-            nextBlink = std::min(nextBlink, _settings.cursorBlinkInterval - passedCursor);
-        if (passedSlowBlink <= _slowBlinker.interval)
-            nextBlink = std::min(nextBlink, _slowBlinker.interval - passedSlowBlink);
-        if (passedRapidBlink <= _rapidBlinker.interval)
-            nextBlink = std::min(nextBlink, _rapidBlinker.interval - passedRapidBlink);
+        schedule(_lastBlink + _slowBlinker.interval);
+        schedule(_lastRapidBlink + _rapidBlinker.interval);
     }
 
+    if (*_primaryScreen.visit([](auto const& screen) { return screen.grid().pendingReflowLineCount(); }))
+        schedule(_lastResize + PendingReflowDelay);
+
+    if (_selectionMatchesDeadline)
+        schedule(*_selectionMatchesDeadline);
+
+    if (auto const deadline = _predictiveEchoDeadline.load())
+        schedule(chrono::steady_clock::time_point(
+            chrono::duration_cast<chrono::steady_clock::duration>(chrono::nanoseconds(deadline))));
+
+    auto const mouseMoveDeadline = [this]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        return _inputGenerator.pendingMouseMoveDeadline();
+    }();
+    if (mouseMoveDeadline)
+        schedule(*mouseMoveDeadline);
+
     if (_statusDisplayType == StatusDisplayType::Indicator)
     {
-        auto const currentSecond =
-            chrono::time_point_cast<chrono::seconds>(chrono::system_clock::now()).time_since_epoch().count()
-            % 60;
-        auto const millisUntilNextMinute =
-            chrono::duration_cast<chrono::milliseconds>(chrono::seconds(60 - currentSecond));
-        nextBlink = std::min(nextBlink, millisUntilNextMinute);
+        // The indicator's clock shows minutes, which are measured on the wall clock.
+        auto const wallClockNow = chrono::system_clock::now();
+        auto const nextMinute = chrono::floor<chrono::minutes>(wallClockNow) + chrono::minutes(1);
+        schedule(_currentTime + (nextMinute - wallClockNow));
     }
 
-    if (nextBlink == chrono::milliseconds::max())
+    if (!nextDeadline)
         return nullopt;
 
-    return nextBlink;
+    // Rounded up, as waking up a fraction of a millisecond early would only cost another wakeup.
+    return std::max(chrono::ceil<chrono::milliseconds>(*nextDeadline - _currentTime),
+                    chrono::milliseconds(0));
+}
+
+chrono::milliseconds Terminal::nextFrameDelay(chrono::steady_clock::time_point now) const
+{
+    auto const dueTime = _renderBuffer.lastUpdate + _framePacer.interval();
+    return std::max(chrono::ceil<chrono::milliseconds>(dueTime - now), chrono::milliseconds(0));
 }
 
 void Terminal::tick(chrono::steady_clock::time_point now) noexcept
@@ -1209,11 +1956,33 @@ void Terminal::tick(chrono::steady_clock::time_point now) noexcept
 
     _currentTime = now;
     updateCursorVisibilityState();
+
+    _primaryScreen.visit([&](auto& screen) {
+        auto& primaryGrid = screen.grid();
+        if (*primaryGrid.pendingReflowLineCount() && now - _lastResize >= PendingReflowDelay)
+            primaryGrid.reflowPendingHistory();
+    });
+    if (_selectionMatchesDeadline && now >= *_selectionMatchesDeadline)
+    {
+        applySelectionMatches();
+        screenUpdated();
+    }
+    // Predictions not confirmed in due time are rolled back by the next render buffer refresh.
+    if (auto const deadline = _predictiveEchoDeadline.load();
+        deadline && chrono::duration_cast<chrono::nanoseconds>(now.time_since_epoch()).count() >= deadline)
+        screenUpdated();
     if (isBlinkOnScreen())
     {
         tie(_rapidBlinker.state, _lastRapidBlink) = nextBlinkState(_rapidBlinker, _lastRapidBlink);
         tie(_slowBlinker.state, _lastBlink) = nextBlinkState(_slowBlinker, _lastBlink);
     }
+
+    auto const mouseMoved = [&]() {
+        auto const _ = std::scoped_lock { _inputMutex };
+        return _inputGenerator.flushPendingMouseMove(now);
+    }();
+    if (mouseMoved)
+        flushInput();
 }
 
 void Terminal::resizeScreen(PageSize totalPageSize, optional<ImageSize> pixels)
@@ -1226,19 +1995,22 @@ void Terminal::resizeScreen(PageSize totalPageSize, optional<ImageSize> pixels)
 
     _factorySettings.pageSize = totalPageSize;
     _settings.pageSize = totalPageSize;
+    _lastResize = _currentTime;
     _currentMousePosition = clampToScreen(_currentMousePosition);
     if (pixels)
         setCellPixelSize(pixels.value() / mainDisplayPageSize);
 
-    // Reset margin to their default.
-    _primaryScreen.margin() = Margin {
+    // Reset margin to their default (shared by the primary and alternate screen).
+    _mainScreenMargin = Margin {
         .vertical = Margin::Vertical { .from = {}, .to = mainDisplayPageSize.lines.as<LineOffset>() - 1 },
         .horizontal =
             Margin::Horizontal { .from = {}, .to = mainDisplayPageSize.columns.as<ColumnOffset>() - 1 }
     };
-    _alternateScreen.margin() = _primaryScreen.margin();
 
     applyPageSizeToCurrentBuffer();
+    publishCursorPosition();
+    _predictiveEcho.reset();
+    _predictiveEchoDeadline = 0;
 
     _pty->resizeScreen(mainDisplayPageSize, pixels);
 
@@ -1294,17 +2066,18 @@ void Terminal::setCursorShape(CursorShape shape)
 void Terminal::setWordDelimiters(string const& wordDelimiters)
 {
     _settings.wordDelimiters = unicode::from_utf8(wordDelimiters);
+    _wordDelimiters = WordDelimiters(_settings.wordDelimiters);
 
-    _selectionHelper.wordDelimited = [wordDelimiters = _settings.wordDelimiters,
-                                      this](CellLocation const& pos) {
-        return this->wordDelimited(pos, wordDelimiters);
+    _selectionHelper.wordDelimited = [this](CellLocation const& pos) {
+        return this->wordDelimited(pos, _wordDelimiters);
     };
 }
 
 void Terminal::setExtendedWordDelimiters(string const& wordDelimiters)
 {
     _settings.extendedWordDelimiters = unicode::from_utf8(wordDelimiters);
-    _extendedSelectionHelper.wordDelimited = [extendedDelimieters = _settings.extendedWordDelimiters,
+    _extendedSelectionHelper.wordDelimited = [extendedDelimieters =
+                                                  WordDelimiters(_settings.extendedWordDelimiters),
                                               this](CellLocation const& pos) {
         return this->wordDelimited(pos, extendedDelimieters);
     };
@@ -1312,63 +2085,316 @@ void Terminal::setExtendedWordDelimiters(string const& wordDelimiters)
 
 namespace
 {
+    /// Writes the text of a selection range by range into a pending chunk.
+    ///
+    /// Only the current line and one pending chunk are held in memory at any time,
+    /// so that extracting a selection spanning the whole scrollback stays bounded.
     template <CellConcept Cell>
-    struct SelectionRenderer
+    struct SelectionTextWriter
     {
-        gsl::not_null<Terminal const*> term;
-        ColumnOffset rightPage {};
-        ColumnOffset lastColumn {};
-        string text {};
+        bool joinWrappedLines = false; // whether wrapped lines continue the line above
+        bool fullLines = false;        // whether the selection ends with a newline
+        string chunk {};
         string currentLine {};
+        bool firstRange = true;
 
-        SelectionRenderer(Terminal const& term, ColumnOffset rightPage): term(&term), rightPage(rightPage) {}
+        SelectionTextWriter(bool joinWrappedLines, bool fullLines):
+            joinWrappedLines(joinWrappedLines), fullLines(fullLines)
+        {
+            chunk.reserve(Terminal::TextExtractionChunkSize);
+        }
+
+        [[nodiscard]] bool chunkFull() const noexcept
+        {
+            return chunk.size() >= Terminal::TextExtractionChunkSize;
+        }
 
-        void operator()(CellLocation pos, Cell const& cell)
+        [[nodiscard]] string takeChunk()
         {
-            auto const isNewLine = pos.column < lastColumn || (pos.column == lastColumn && !text.empty());
-            if (isNewLine && (!term->isLineWrapped(pos.line)))
+            auto result = std::exchange(chunk, string {});
+            chunk.reserve(Terminal::TextExtractionChunkSize);
+            return result;
+        }
+
+        void operator()(Selection::Range const& range, Line<Cell> const& line)
+        {
+            if (!firstRange && !(joinWrappedLines && line.wrapped()))
             {
                 // TODO: handle logical line in word-selection (don't include LF in wrapped lines)
                 trimSpaceRight(currentLine);
-                text += currentLine;
-                text += '\n';
+                chunk += currentLine;
+                chunk += '\n';
                 currentLine.clear();
             }
-            if (cell.empty())
-                currentLine += ' ';
+            firstRange = false;
+
+            if (line.isTrivialBuffer() && isAsciiOnly(line.trivialBuffer()))
+            {
+                // Fast path: every used column maps to exactly one byte of the trivial buffer.
+                auto const& text = line.trivialBuffer().text;
+                for (auto column = unbox<size_t>(range.fromColumn); column <= unbox<size_t>(range.toColumn);
+                     ++column)
+                    currentLine += column < text.size() ? text[column] : ' ';
+            }
             else
-                currentLine += cell.toUtf8();
-            lastColumn = pos.column;
+            {
+                auto const cells = line.cells();
+                for (auto column = unbox<size_t>(range.fromColumn);
+                     column <= unbox<size_t>(range.toColumn) && column < cells.size();
+                     ++column)
+                {
+                    if (cells[column].empty())
+                        currentLine += ' ';
+                    else
+                        currentLine += cells[column].toUtf8();
+                }
+            }
         }
 
-        std::string finish()
+        void finish()
         {
             trimSpaceRight(currentLine);
-            text += currentLine;
-            if (dynamic_cast<FullLineSelection const*>(term->selector()))
-                text += '\n';
-            return std::move(text);
+            chunk += currentLine;
+            if (fullLines)
+                chunk += '\n';
+        }
+
+      private:
+        [[nodiscard]] static bool isAsciiOnly(TrivialLineBuffer const& buffer) noexcept
+        {
+            return buffer.text.size() == unbox<size_t>(buffer.usedColumns);
         }
     };
+
+    template <CellConcept Cell>
+    void writeSelectionText(Terminal const& term,
+                            Grid<Cell> const& grid,
+                            Selection const& selection,
+                            Terminal::TextChunkSink const& sink)
+    {
+        auto writer = SelectionTextWriter<Cell> { term.isPrimaryScreen(),
+                                                  !!dynamic_cast<FullLineSelection const*>(&selection) };
+        for (Selection::Range const& range: selection.ranges())
+        {
+            writer(range, grid.lineAt(range.line));
+            if (writer.chunkFull())
+                sink(writer.takeChunk());
+        }
+        writer.finish();
+        if (!writer.chunk.empty())
+            sink(writer.chunk);
+    }
+
+    /// Yields the text of a selection from a snapshot of its lines, one chunk per invocation,
+    /// and an empty string once all of it has been yielded.
+    template <CellConcept Cell>
+    class SelectionTextSource
+    {
+      public:
+        SelectionTextSource(std::shared_ptr<GridSnapshot<Cell> const> snapshot,
+                            std::vector<Selection::Range> ranges,
+                            SelectionTextWriter<Cell> writer):
+            _snapshot { std::move(snapshot) }, _ranges { std::move(ranges) }, _writer { std::move(writer) }
+        {
+        }
+
+        string operator()()
+        {
+            for (; _next < _ranges.size() && !_writer.chunkFull(); ++_next)
+                _writer(_ranges[_next], _snapshot->lineAt(_ranges[_next].line));
+
+            if (_next == _ranges.size() && !_finished)
+            {
+                _writer.finish();
+                _finished = true;
+            }
+            return _writer.takeChunk();
+        }
+
+      private:
+        std::shared_ptr<GridSnapshot<Cell> const> _snapshot;
+        std::vector<Selection::Range> _ranges;
+        SelectionTextWriter<Cell> _writer;
+        size_t _next = 0;
+        bool _finished = false;
+    };
+
+    template <CellConcept Cell>
+    std::function<string()> makeSelectionTextSource(Grid<Cell> const& grid,
+                                                    std::vector<Selection::Range> ranges,
+                                                    LineCount historyLineCount,
+                                                    SelectionTextWriter<Cell> writer)
+    {
+        auto snapshot = std::make_shared<GridSnapshot<Cell> const>(grid.snapshot(historyLineCount));
+        return SelectionTextSource<Cell>(std::move(snapshot), std::move(ranges), std::move(writer));
+    }
 } // namespace
 
-string Terminal::extractSelectionText() const
+void Terminal::extractSelectionText(TextChunkSink const& sink) const
 {
     if (!_selection || _selection->state() == Selection::State::Waiting)
-        return "";
+        return;
 
+    auto const write = [&](auto const& screen) {
+        writeSelectionText(*this, screen.grid(), *_selection, sink);
+    };
     if (isPrimaryScreen())
+        _primaryScreen.visit(write);
+    else
+        _alternateScreen.visit(write);
+}
+
+Terminal::SelectionTextSnapshot Terminal::selectionTextSnapshot() const
+{
+    if (!_selection || _selection->state() == Selection::State::Waiting)
+        return {};
+
+    auto ranges = _selection->ranges();
+    if (ranges.empty())
+        return {};
+
+    // Only the lines from the topmost selected one down to the page bottom are copied.
+    auto const top = std::ranges::min(ranges, {}, &Selection::Range::line).line;
+    auto const historyLineCount = LineCount::cast_from(-std::min(unbox(top), 0));
+    auto const fullLines = !!dynamic_cast<FullLineSelection const*>(_selection.get());
+
+    auto result = SelectionTextSnapshot { .lineCount = ranges.size(), .nextChunk = {} };
+    auto const takeSnapshot = [&](auto const& screen) {
+        result.nextChunk = makeSelectionTextSource(
+            screen.grid(), std::move(ranges), historyLineCount, { isPrimaryScreen(), fullLines });
+    };
+    if (isPrimaryScreen())
+        _primaryScreen.visit(takeSnapshot);
+    else
+        _alternateScreen.visit(takeSnapshot);
+    return result;
+}
+
+string Terminal::extractSelectionText() const
+{
+    string text;
+    extractSelectionText([&](std::string_view chunk) { text += chunk; });
+    return text;
+}
+
+namespace
+{
+    /// @returns @p buffer without its hyperlinks, whose IDs only refer to this terminal's hyperlink storage.
+    PackedLineBuffer withoutHyperlinks(PackedLineBuffer buffer)
     {
-        auto se = SelectionRenderer<PrimaryScreenCell> { *this, pageSize().columns.as<ColumnOffset>() - 1 };
-        vtbackend::renderSelection(*_selection, [&](CellLocation pos) { se(pos, _primaryScreen.at(pos)); });
-        return se.finish();
+        auto attributed = unpack(buffer);
+        if (std::ranges::none_of(attributed.spans, [](auto const& span) { return *span.hyperlink != 0; }))
+            return buffer;
+        for (auto& span: attributed.spans)
+            span.hyperlink = {};
+        return pack(attributed);
     }
-    else
+} // namespace
+
+SessionSnapshot Terminal::sessionSnapshot()
+{
+    return _primaryScreen.visit([](auto& screen) {
+        // Lines still pending reflow would be saved at whatever width they have been left at.
+        screen.grid().reflowPendingHistory();
+
+        auto const& grid = screen.grid();
+        auto const bottom = boxed_cast<LineOffset>(grid.pageSize().lines) - 1;
+
+        auto snapshot = SessionSnapshot {};
+        snapshot.pageLineCount = grid.pageSize().lines;
+        snapshot.cursor = screen.realCursorPosition();
+        snapshot.lines.reserve(unbox<size_t>(grid.spilledLineCount() + grid.historyLineCount())
+                               + unbox<size_t>(grid.pageSize().lines));
+
+        if (auto const* spillFile = grid.historySpillFile())
+            for (auto i = size_t { 0 }; i < unbox<size_t>(spillFile->lineCount()); ++i)
+                if (auto spilledLine = spillFile->read(i))
+                    snapshot.lines.push_back(SessionSnapshot::SnapshotLine {
+                        .flags = spilledLine->flags,
+                        .buffer = withoutHyperlinks(std::move(spilledLine->buffer)) });
+
+        for (auto line = -boxed_cast<LineOffset>(grid.historyLineCount()); line <= bottom; ++line)
+        {
+            auto const& gridLine = grid.lineAt(line);
+            snapshot.lines.push_back(SessionSnapshot::SnapshotLine {
+                .flags = gridLine.flags(), .buffer = withoutHyperlinks(gridLine.toPackedBuffer()) });
+        }
+
+        return snapshot;
+    });
+}
+
+namespace
+{
+    /// @returns the saved lines reflowed to the page width of @p grid.
+    template <typename GridType>
+    auto restoredLines(GridType const& grid, std::span<SessionSnapshot::SnapshotLine const> savedLines)
+    {
+        using GridLine = std::remove_cvref_t<decltype(grid.lineAt(LineOffset(0)))>;
+        auto lines = std::vector<GridLine> {};
+        lines.reserve(savedLines.size());
+        for (auto const& savedLine: savedLines)
+            lines.emplace_back(savedLine.flags, savedLine.buffer);
+        return grid.reflowedLines(std::move(lines));
+    }
+
+    template <typename GridType, typename GridLine>
+    void pushHistoryLines(GridType& grid, std::span<GridLine> lines)
     {
-        auto se = SelectionRenderer<AlternateScreenCell> { *this, pageSize().columns.as<ColumnOffset>() - 1 };
-        vtbackend::renderSelection(*_selection, [&](CellLocation pos) { se(pos, _alternateScreen.at(pos)); });
-        return se.finish();
+        for (auto& line: lines)
+        {
+            // Let the line scroll off the top of the page, as if it had just been printed there.
+            grid.lineAt(LineOffset(0)) = std::move(line);
+            grid.scrollUp(LineCount(1));
+        }
     }
+} // namespace
+
+void Terminal::restoreSessionSnapshot(SessionSnapshot const& snapshot)
+{
+    _primaryScreen.visit([&](auto& screen) {
+        auto& grid = screen.grid();
+        auto lines = restoredLines(grid, std::span(snapshot.lines).first(snapshot.linesToCursor()));
+        pushHistoryLines(grid, std::span(lines));
+    });
+}
+
+void Terminal::attachSessionSnapshot(SessionSnapshot const& snapshot)
+{
+    _primaryScreen.visit([&](auto& screen) {
+        auto& grid = screen.grid();
+        auto const pageLines = unbox<size_t>(grid.pageSize().lines);
+        auto const savedLines = std::span(snapshot.lines);
+        auto const savedPageLines = std::min(unbox<size_t>(snapshot.pageLineCount), savedLines.size());
+        auto const savedPageBegin = savedLines.size() - savedPageLines;
+        auto const savedCursorEnd =
+            savedPageBegin + std::min(unbox<size_t>(snapshot.cursor.line) + 1, savedPageLines);
+
+        // The lines down to the cursor line and below it are reflowed separately, tracking the cursor line.
+        auto historyLines = restoredLines(grid, savedLines.first(savedPageBegin));
+        auto upperLines =
+            restoredLines(grid, savedLines.subspan(savedPageBegin, savedCursorEnd - savedPageBegin));
+        auto lowerLines = restoredLines(grid, savedLines.subspan(savedCursorEnd));
+        auto const cursorLine = std::max(upperLines.size(), size_t { 1 }) - 1;
+
+        // Lines of a taller page scroll off the top as far as needed to keep the cursor line on the page.
+        auto const shift = cursorLine + 1 > pageLines ? cursorLine + 1 - pageLines : 0;
+        pushHistoryLines(grid, std::span(historyLines));
+        pushHistoryLines(grid, std::span(upperLines).first(shift));
+
+        auto pageLineCount = size_t { 0 };
+        for (auto& line: std::span(upperLines).subspan(shift))
+            grid.lineAt(LineOffset::cast_from(pageLineCount++)) = std::move(line);
+        for (auto& line: lowerLines)
+        {
+            if (pageLineCount == pageLines)
+                break;
+            grid.lineAt(LineOffset::cast_from(pageLineCount++)) = std::move(line);
+        }
+
+        screen.moveCursorTo(LineOffset::cast_from(cursorLine - shift), snapshot.cursor.column);
+    });
+    screenUpdated();
 }
 
 string Terminal::extractLastMarkRange() const
@@ -1379,23 +2405,47 @@ string Terminal::extractLastMarkRange() const
 
     auto const marker1 = optional { bottomLine };
 
-    auto const marker0 = _primaryScreen.findMarkerUpwards(marker1.value());
-    if (!marker0.has_value())
-        return {};
+    return _primaryScreen.visit([&](auto const& screen) -> string {
+        auto const marker0 = screen.findMarkerUpwards(marker1.value());
+        if (!marker0.has_value())
+            return {};
 
-    // +1 each for offset change from 0 to 1 and because we only want to start at the line *after* the mark.
-    auto const firstLine = *marker0 + 1;
-    auto const lastLine = *marker1;
+        // +1 each for offset change from 0 to 1 and because we only want to start at the line *after*
+        // the mark.
+        auto const firstLine = *marker0 + 1;
+        auto const lastLine = *marker1;
 
-    string text;
+        string text;
 
-    for (auto lineNum = firstLine; lineNum <= lastLine; ++lineNum)
-    {
-        text += _primaryScreen.grid().lineAt(lineNum).toUtf8Trimmed();
-        text += '\n';
-    }
+        for (auto lineNum = firstLine; lineNum <= lastLine; ++lineNum)
+        {
+            text += screen.grid().lineAt(lineNum).toUtf8Trimmed();
+            text += '\n';
+        }
 
-    return text;
+        return text;
+    });
+}
+
+string Terminal::extractCommandOutput(size_t n) const
+{
+    return _primaryScreen.visit([&](auto const& screen) -> string {
+        // The most recent command is still running, e.g. the one that triggered the extraction.
+        if (auto const newest = screen.command(0); newest && !newest->complete)
+            ++n;
+
+        auto const command = screen.command(n);
+        if (!command)
+            return {};
+
+        string text;
+        for (auto lineNum = command->outputTop; lineNum <= command->outputBottom; ++lineNum)
+        {
+            text += screen.grid().lineAt(lineNum).toUtf8Trimmed();
+            text += '\n';
+        }
+        return text;
+    });
 }
 
 // {{{ screen events
@@ -1433,12 +2483,6 @@ void Terminal::screenUpdated()
     if (!_renderBufferUpdateEnabled)
         return;
 
-    if (_renderBuffer.state == RenderBufferState::TrySwapBuffers)
-    {
-        _renderBuffer.swapBuffers(_renderBuffer.lastUpdate);
-        return;
-    }
-
     _screenDirty = true;
     _eventListener.screenUpdated();
 }
@@ -1448,12 +2492,6 @@ void Terminal::renderBufferUpdated()
     if (!_renderBufferUpdateEnabled)
         return;
 
-    if (_renderBuffer.state == RenderBufferState::TrySwapBuffers)
-    {
-        _renderBuffer.swapBuffers(_renderBuffer.lastUpdate);
-        return;
-    }
-
     _screenDirty = true;
     _eventListener.renderBufferUpdated();
 }
@@ -1488,17 +2526,46 @@ void Terminal::notify(string_view title, string_view body)
     _eventListener.notify(title, body);
 }
 
+void Terminal::replyStreamed(PtyWriter::PasteSource source)
+{
+    flushInput();
+    _ptyWriter.writePaste(std::move(source), true);
+}
+
+namespace
+{
+    [[nodiscard]] bool syncReplies() noexcept
+    {
+        static auto const enabled = []() {
+            auto const* syncReply = getenv("CONTOUR_SYNC_PTY_OUTPUT");
+            return syncReply && *syncReply != '0';
+        }();
+        return enabled;
+    }
+} // namespace
+
 void Terminal::reply(string_view text)
 {
     // this is invoked from within the terminal thread.
     // most likely that's not the main thread, which will however write
     // the actual input events.
-    // TODO: introduce new mutex to guard terminal writes.
-    _inputGenerator.generateRaw(text);
+    {
+        auto const _ = std::scoped_lock { _inputMutex };
+        _inputGenerator.generateRaw(text);
+    }
+
+    if (syncReplies())
+        flushInput();
+}
 
-    auto const* syncReply = getenv("CONTOUR_SYNC_PTY_OUTPUT");
+void Terminal::replyFormatted(string_view message, std::format_args args)
+{
+    {
+        auto const _ = std::scoped_lock { _inputMutex };
+        _inputGenerator.generateFormatted(message, args);
+    }
 
-    if (syncReply && *syncReply != '0')
+    if (syncReplies())
         flushInput();
 }
 
@@ -1514,11 +2581,13 @@ void Terminal::requestWindowResize(ImageSize size)
 
 void Terminal::setApplicationkeypadMode(bool enabled)
 {
+    auto const _ = std::scoped_lock { _inputMutex };
     _inputGenerator.setApplicationKeypadMode(enabled);
 }
 
 void Terminal::setBracketedPaste(bool enabled)
 {
+    auto const _ = std::scoped_lock { _inputMutex };
     _inputGenerator.setBracketedPaste(enabled);
 }
 
@@ -1538,21 +2607,25 @@ void Terminal::setCursorVisibility(bool /*visible*/)
 
 void Terminal::setGenerateFocusEvents(bool enabled)
 {
+    auto const _ = std::scoped_lock { _inputMutex };
     _inputGenerator.setGenerateFocusEvents(enabled);
 }
 
 void Terminal::setMouseProtocol(MouseProtocol protocol, bool enabled)
 {
+    auto const _ = std::scoped_lock { _inputMutex };
     _inputGenerator.setMouseProtocol(protocol, enabled);
 }
 
 void Terminal::setMouseTransport(MouseTransport transport)
 {
+    auto const _ = std::scoped_lock { _inputMutex };
     _inputGenerator.setMouseTransport(transport);
 }
 
 void Terminal::setMouseWheelMode(InputGenerator::MouseWheelMode mode)
 {
+    auto const _ = std::scoped_lock { _inputMutex };
     _inputGenerator.setMouseWheelMode(mode);
 }
 
@@ -1590,6 +2663,7 @@ void Terminal::setTerminalProfile(string const& configProfileName)
 void Terminal::useApplicationCursorKeys(bool enable)
 {
     auto const keyMode = enable ? KeyMode::Application : KeyMode::Normal;
+    auto const _ = std::scoped_lock { _inputMutex };
     _inputGenerator.setCursorKeysMode(keyMode);
 }
 
@@ -1688,8 +2762,11 @@ void Terminal::setMode(DECMode mode, bool enable)
                 // Enabling reflow enables every line in the main page area.
                 // Disabling reflow only affects currently line and below.
                 auto const startLine = enable ? LineOffset(0) : currentScreen().cursor().position.line;
-                for (auto line = startLine; line < boxed_cast<LineOffset>(_settings.pageSize.lines); ++line)
-                    _primaryScreen.grid().lineAt(line).setWrappable(enable);
+                _primaryScreen.visit([&](auto& screen) {
+                    for (auto line = startLine; line < boxed_cast<LineOffset>(_settings.pageSize.lines);
+                         ++line)
+                        screen.grid().lineAt(line).setWrappable(enable);
+                });
             }
             break;
         case DECMode::DebugLogging:
@@ -1723,11 +2800,15 @@ void Terminal::setMode(DECMode mode, bool enable)
             break;
         case DECMode::MouseExtended: setMouseTransport(MouseTransport::Extended); break;
         case DECMode::MouseURXVT: setMouseTransport(MouseTransport::URXVT); break;
-        case DECMode::MousePassiveTracking:
-            _inputGenerator.setPassiveMouseTracking(enable);
+        case DECMode::MousePassiveTracking: {
+            {
+                auto const _ = std::scoped_lock { _inputMutex };
+                _inputGenerator.setPassiveMouseTracking(enable);
+            }
             setMode(DECMode::MouseSGR, enable);                    // SGR is required.
             setMode(DECMode::MouseProtocolButtonTracking, enable); // ButtonTracking is default
             break;
+        }
         case DECMode::MouseSGRPixels:
             if (enable)
                 setMouseTransport(MouseTransport::SGRPixels);
@@ -1765,6 +2846,14 @@ void Terminal::setMode(DECMode mode, bool enable)
         case DECMode::ExtendedAltScreen:
             if (enable)
             {
+                // The alternate screen is cleared anyway, so if the page has been resized meanwhile,
+                // its lines are discarded rather than reshaped to the new page size.
+                if (!isAlternateScreen())
+                    _alternateScreen.visit([this](auto& screen) {
+                        auto const mainDisplayPageSize = _settings.pageSize - statusLineHeight();
+                        if (screen.pageSize() != mainDisplayPageSize)
+                            screen.discardPageAndResize(mainDisplayPageSize);
+                    });
                 setMode(DECMode::UseAlternateScreen, true);
                 clearScreen();
             }
@@ -1810,10 +2899,13 @@ void Terminal::setLeftRightMargin(optional<ColumnOffset> left, optional<ColumnOf
 
 void Terminal::clearScreen()
 {
+    auto const clear = [](auto& screen) {
+        screen.clearScreen();
+    };
     if (isPrimaryScreen())
-        _primaryScreen.clearScreen();
+        _primaryScreen.visit(clear);
     else
-        _alternateScreen.clearScreen();
+        _alternateScreen.visit(clear);
 }
 
 void Terminal::moveCursorTo(LineOffset line, ColumnOffset column)
@@ -1896,12 +2988,17 @@ void Terminal::hardReset()
     for (auto const& [mode, frozen]: _settings.frozenModes)
         freezeMode(mode, frozen);
 
-    _primaryScreen.hardReset();
-    _alternateScreen.hardReset();
+    auto const hardResetScreen = [](auto& screen) {
+        screen.hardReset();
+    };
+    _primaryScreen.visit(hardResetScreen);
+    _alternateScreen.visit(hardResetScreen);
     _hostWritableStatusLineScreen.hardReset();
     _indicatorStatusScreen.hardReset();
+    _indicatorStatusLineState.reset();
 
     _imagePool.clear();
+    _kittyGraphics.clear();
     _tabs.clear();
 
     resetColorPalette();
@@ -1924,26 +3021,20 @@ void Terminal::hardReset()
 
     auto const mainDisplayPageSize = _settings.pageSize - statusLineHeight();
 
-    _primaryScreen.margin() = Margin {
-        .vertical =
-            Margin::Vertical { .from = {}, .to = boxed_cast<LineOffset>(mainDisplayPageSize.lines) - 1 },
-        .horizontal = Margin::Horizontal { .from = {},
-                                           .to = boxed_cast<ColumnOffset>(mainDisplayPageSize.columns) - 1 },
-    };
-    _primaryScreen.verifyState();
-
-    _alternateScreen.margin() = Margin {
+    // The margin is shared by the primary and alternate screen.
+    _mainScreenMargin = Margin {
         .vertical =
             Margin::Vertical { .from = {}, .to = boxed_cast<LineOffset>(mainDisplayPageSize.lines) - 1 },
         .horizontal = Margin::Horizontal { .from = {},
                                            .to = boxed_cast<ColumnOffset>(mainDisplayPageSize.columns) - 1 },
     };
-    alternateScreen().margin() = _primaryScreen.margin();
+    _primaryScreen.base().verifyState();
     // NB: We do *NOT* verify alternate screen, because the page size would probably fail as it is
     // designed to be adjusted when the given screen is activated.
 
     setStatusDisplay(_factorySettings.statusDisplayType);
 
+    auto const _ = std::scoped_lock { _inputMutex };
     _inputGenerator.reset();
 }
 
@@ -1967,11 +3058,11 @@ void Terminal::setScreen(ScreenType type)
     switch (type)
     {
         case ScreenType::Primary:
-            _currentScreen = &_primaryScreen;
+            _currentScreen = &_primaryScreen.base();
             setMouseWheelMode(InputGenerator::MouseWheelMode::Default);
             break;
         case ScreenType::Alternate:
-            _currentScreen = &_alternateScreen;
+            _currentScreen = &_alternateScreen.base();
             if (isModeEnabled(DECMode::MouseAlternateScroll))
                 setMouseWheelMode(InputGenerator::MouseWheelMode::ApplicationCursorKeys);
             else
@@ -1980,6 +3071,7 @@ void Terminal::setScreen(ScreenType type)
     }
 
     _currentScreenType = type;
+    updateSequenceTarget();
 
     // Ensure correct screen buffer size for the buffer we've just switched to.
     applyPageSizeToCurrentBuffer();
@@ -2000,10 +3092,10 @@ void Terminal::applyPageSizeToMainDisplay(ScreenType screenType)
     switch (screenType)
     {
         case ScreenType::Primary:
-            _primaryScreen.applyPageSizeToMainDisplay(mainDisplayPageSize);
+            _primaryScreen.visit([&](auto& screen) { screen.applyPageSizeToMainDisplay(mainDisplayPageSize); });
             break;
         case ScreenType::Alternate:
-            _alternateScreen.applyPageSizeToMainDisplay(mainDisplayPageSize);
+            _alternateScreen.visit([&](auto& screen) { screen.applyPageSizeToMainDisplay(mainDisplayPageSize); });
             break;
     }
 
@@ -2031,6 +3123,25 @@ void Terminal::discardImage(Image const& image)
     _eventListener.discardImage(image);
 }
 
+void Terminal::decodeImage(std::shared_ptr<Image const> image,
+                           ImageDecoder::Decode decode,
+                           ImageDecoder::Completion onDecoded)
+{
+    _imageDecoder.decode(
+        std::move(image),
+        std::move(decode),
+        [this, onDecoded = std::move(onDecoded)](optional<string> const& error) {
+            auto const _ = std::lock_guard { *this };
+            onDecoded(error);
+            _imagePool.enforceMemoryBudget();
+
+            // The cells showing the image did not change, but are to be rendered anew.
+            _primaryScreen.visit([](auto& screen) { screen.grid().markPageDamaged(); });
+            _alternateScreen.visit([](auto& screen) { screen.grid().markPageDamaged(); });
+            screenUpdated();
+        });
+}
+
 void Terminal::markCellDirty(CellLocation position) noexcept
 {
     if (_activeStatusDisplay != ActiveStatusDisplay::Main)
@@ -2061,15 +3172,15 @@ void Terminal::synchronizedOutput(bool enabled)
 {
     _renderBufferUpdateEnabled = !enabled;
     if (enabled)
+    {
+        _synchronizedOutputSinceRefresh = true;
         return;
+    }
 
     tick(chrono::steady_clock::now());
 
     auto const diff = _currentTime - _renderBuffer.lastUpdate;
-    if (diff < _refreshInterval.value)
-        return;
-
-    if (_renderBuffer.state == RenderBufferState::TrySwapBuffers)
+    if (diff < _framePacer.interval())
         return;
 
     refreshRenderBuffer(true);
@@ -2089,9 +3200,10 @@ void Terminal::onBufferScrolled(LineCount n) noexcept
     if (!_selection)
         return;
 
-    auto const top = -boxed_cast<LineOffset>(_primaryScreen.historyLineCount());
+    auto const historyLineCount = _primaryScreen.base().historyLineCount();
+    auto const top = -boxed_cast<LineOffset>(historyLineCount);
     if (_selection->from().line > top && _selection->to().line > top)
-        _selection->applyScroll(boxed_cast<LineOffset>(n), _primaryScreen.historyLineCount());
+        _selection->applyScroll(boxed_cast<LineOffset>(n), historyLineCount);
     else
         clearSelection();
 }
@@ -2099,12 +3211,25 @@ void Terminal::onBufferScrolled(LineCount n) noexcept
 
 void Terminal::setMaxHistoryLineCount(MaxHistoryLineCount maxHistoryLineCount)
 {
-    _primaryScreen.grid().setMaxHistoryLineCount(maxHistoryLineCount);
+    _primaryScreen.visit([&](auto& screen) { screen.grid().setMaxHistoryLineCount(maxHistoryLineCount); });
 }
 
 LineCount Terminal::maxHistoryLineCount() const noexcept
 {
-    return _primaryScreen.grid().maxHistoryLineCount();
+    return _primaryScreen.visit([](auto const& screen) { return screen.grid().maxHistoryLineCount(); });
+}
+
+LineCount Terminal::spilledHistoryLineCount() const noexcept
+{
+    return _primaryScreen.visit([](auto const& screen) { return screen.grid().spilledLineCount(); });
+}
+
+LineCount Terminal::pageInSpilledHistory(LineCount count)
+{
+    if (!isPrimaryScreen())
+        return LineCount(0);
+
+    return _primaryScreen.visit([&](auto& screen) { return screen.grid().pageInSpilledLines(count); });
 }
 
 void Terminal::setTerminalId(VTType id) noexcept
@@ -2144,10 +3269,10 @@ void Terminal::setActiveStatusDisplay(ActiveStatusDisplay activeDisplay)
             switch (_currentScreenType)
             {
                 case ScreenType::Primary:
-                    _currentScreen = &_primaryScreen;
+                    _currentScreen = &_primaryScreen.base();
                     break;
                 case ScreenType::Alternate:
-                    _currentScreen = &_alternateScreen;
+                    _currentScreen = &_alternateScreen.base();
                     break;
             }
             break;
@@ -2156,9 +3281,26 @@ void Terminal::setActiveStatusDisplay(ActiveStatusDisplay activeDisplay)
             break;
         case ActiveStatusDisplay::IndicatorStatusLine:
             _currentScreen = &_indicatorStatusScreen;
+            // The host is writing into it, which the next update has to overwrite.
+            _indicatorStatusLineState.reset();
             break;
     }
     // clang-format on
+    updateSequenceTarget();
+}
+
+void Terminal::updateSequenceTarget() noexcept
+{
+    switch (_activeStatusDisplay)
+    {
+        case ActiveStatusDisplay::Main: {
+            auto& screen = _currentScreenType == ScreenType::Primary ? _primaryScreen : _alternateScreen;
+            screen.visit([this](auto& concreteScreen) { _sequenceTarget = &concreteScreen; });
+            break;
+        }
+        case ActiveStatusDisplay::StatusLine: _sequenceTarget = &_hostWritableStatusLineScreen; break;
+        case ActiveStatusDisplay::IndicatorStatusLine: _sequenceTarget = &_indicatorStatusScreen; break;
+    }
 }
 
 void Terminal::pushStatusDisplay(StatusDisplayType type)
@@ -2192,6 +3334,17 @@ bool Terminal::setNewSearchTerm(std::u32string text, bool initiatedByDoubleClick
         return false;
 
     _search.pattern = std::move(text);
+    if (_search.pattern.starts_with(RegexSearchPrefix))
+    {
+        _search.mode = SearchMode::Regex;
+        _search.regex = RegexSearchPattern::compile(
+            u32string_view(_search.pattern).substr(RegexSearchPrefix.size()));
+    }
+    else
+    {
+        _search.mode = SearchMode::Literal;
+        _search.regex.reset();
+    }
     return true;
 }
 
@@ -2205,8 +3358,18 @@ optional<CellLocation> Terminal::searchReverse(u32string text, CellLocation sear
 
 optional<CellLocation> Terminal::search(CellLocation searchPosition)
 {
-    auto const searchText = u32string_view(_search.pattern);
-    auto const matchLocation = currentScreen().search(searchText, searchPosition);
+    // Matching text inflates the lines it is matched against.
+    _primaryScreen.visit([](auto& screen) {
+        screen.grid().reflowPendingHistory();
+        screen.grid().touchHistory();
+    });
+    auto const matchLocation = [&]() -> optional<CellLocation> {
+        if (_search.mode == SearchMode::Literal)
+            return currentScreen().search(u32string_view(_search.pattern), searchPosition);
+        if (!_search.regex)
+            return nullopt;
+        return currentScreen().searchRegex(*_search.regex, searchPosition);
+    }();
 
     if (matchLocation)
         viewport().makeVisibleWithinSafeArea(matchLocation.value().line);
@@ -2246,46 +3409,75 @@ std::optional<CellLocation> Terminal::searchPrevMatch(CellLocation cursorPositio
 void Terminal::clearSearch()
 {
     _search.pattern.clear();
+    _search.mode = SearchMode::Literal;
+    _search.regex.reset();
     _search.initiatedByDoubleClick = false;
 }
 
 bool Terminal::wordDelimited(CellLocation position) const noexcept
 {
-    return wordDelimited(position, u32string_view(_settings.wordDelimiters));
+    return wordDelimited(position, _wordDelimiters);
 }
 
-bool Terminal::wordDelimited(CellLocation position, std::u32string_view wordDelimiters) const noexcept
+bool Terminal::wordDelimited(CellLocation position, WordDelimiters const& wordDelimiters) const noexcept
 {
     // Word selection may be off by one
     position.column = std::min(position.column, boxed_cast<ColumnOffset>(pageSize().columns - 1));
 
+    auto const delimited = [&](auto const& screen) {
+        return screen.grid().cellEmptyOrContainsOneOf(position, wordDelimiters);
+    };
     if (isPrimaryScreen())
-        return _primaryScreen.grid().cellEmptyOrContainsOneOf(position, wordDelimiters);
+        return _primaryScreen.visit(delimited);
     else
-        return _alternateScreen.grid().cellEmptyOrContainsOneOf(position, wordDelimiters);
+        return _alternateScreen.visit(delimited);
 }
 
 std::tuple<std::u32string, CellLocationRange> Terminal::extractWordUnderCursor(
     CellLocation position) const noexcept
 {
+    auto const extract = [&](auto const& screen) -> std::tuple<std::u32string, CellLocationRange> {
+        auto const range = screen.grid().wordRangeUnderCursor(position, _wordDelimiters);
+        return { screen.grid().extractText(range), range };
+    };
     if (isPrimaryScreen())
-    {
-        auto const range =
-            _primaryScreen.grid().wordRangeUnderCursor(position, u32string_view(_settings.wordDelimiters));
-        return { _primaryScreen.grid().extractText(range), range };
-    }
+        return _primaryScreen.visit(extract);
     else
-    {
-        auto const range =
-            _alternateScreen.grid().wordRangeUnderCursor(position, u32string_view(_settings.wordDelimiters));
-        return { _alternateScreen.grid().extractText(range), range };
-    }
+        return _alternateScreen.visit(extract);
 }
 
 optional<CellLocation> Terminal::searchReverse(CellLocation searchPosition)
 {
-    auto const searchText = u32string_view(_search.pattern);
-    auto const matchLocation = currentScreen().searchReverse(searchText, searchPosition);
+    // Matching text inflates the lines it is matched against.
+    _primaryScreen.visit([](auto& screen) {
+        screen.grid().reflowPendingHistory();
+        screen.grid().touchHistory();
+    });
+    auto const findMatch = [&](CellLocation position) -> optional<CellLocation> {
+        if (_search.mode == SearchMode::Literal)
+            return currentScreen().searchReverse(u32string_view(_search.pattern), position);
+        if (!_search.regex)
+            return nullopt;
+        return currentScreen().searchRegexReverse(*_search.regex, position);
+    };
+    auto matchLocation = findMatch(searchPosition);
+
+    // Without a match in memory, the search goes on through the history spilled to disk, from the
+    // line that has been the oldest one, which may continue in the lines paged in above it.
+    while (!matchLocation)
+    {
+        auto const oldestLine = -boxed_cast<LineOffset>(currentScreen().historyLineCount());
+        if (!*pageInSpilledHistory(SpilledHistorySearchLineCount))
+            break;
+        _primaryScreen.visit([](auto& screen) {
+            screen.grid().reflowPendingHistory();
+            screen.grid().touchHistory();
+        });
+        matchLocation = findMatch(
+            CellLocation { .line = oldestLine, .column = boxed_cast<ColumnOffset>(pageSize().columns) - 1 });
+    }
+    if (!matchLocation && !_viewport.scrolled())
+        _primaryScreen.visit([](auto& screen) { screen.grid().spillPagedInLines(); });
 
     if (matchLocation)
         viewport().makeVisibleWithinSafeArea(matchLocation.value().line);
@@ -2315,6 +3507,38 @@ bool Terminal::isHighlighted(CellLocation cell) const noexcept // NOLINT(bugpron
                _highlightRange.value());
 }
 
+std::vector<ColumnRange> Terminal::highlightedRanges(LineOffset top, LineOffset bottom) const
+{
+    auto result = std::vector<ColumnRange> {};
+    if (!_highlightRange)
+        return result;
+
+    auto const rightMargin = boxed_cast<ColumnOffset>(pageSize().columns - 1);
+    std::visit(
+        [&](auto&& highlightRange) {
+            using T = std::decay_t<decltype(highlightRange)>;
+            auto const [from, to] = [&]() {
+                if constexpr (std::is_same_v<T, LinearHighlight>)
+                    return highlightRange.from <= highlightRange.to
+                               ? std::pair { highlightRange.from, highlightRange.to }
+                               : std::pair { highlightRange.to, highlightRange.from };
+                else
+                    return std::pair { highlightRange.from, highlightRange.to };
+            }();
+
+            for (auto line = std::max(from.line, top); line <= std::min(to.line, bottom); ++line)
+            {
+                // Rectangular highlights have been stored with ordered points.
+                auto const isLinear = std::is_same_v<T, LinearHighlight>;
+                auto const left = !isLinear || line == from.line ? from.column : ColumnOffset(0);
+                auto const right = !isLinear || line == to.line ? to.column : rightMargin;
+                result.emplace_back(ColumnRange { .line = line, .fromColumn = left, .toColumn = right });
+            }
+        },
+        _highlightRange.value());
+    return result;
+}
+
 void Terminal::onSelectionUpdated()
 {
     if (!isModeEnabled(DECMode::ReportGridCellSelection))
@@ -2405,7 +3629,7 @@ void Terminal::pushColorPalette(size_t slot)
 void Terminal::reportColorPaletteStack()
 {
     // XTREPORTCOLORS
-    reply(std::format("\033[{};{}#Q", _savedColorPalettes.size(), _lastSavedColorPalette));
+    reply("\033[{};{}#Q", _savedColorPalettes.size(), _lastSavedColorPalette);
 }
 
 void Terminal::popColorPalette(size_t slot)
@@ -2472,7 +3696,7 @@ void TraceHandler::flushOne(PendingSequence const& pendingSequence)
 {
     if (auto const* seq = std::get_if<Sequence>(&pendingSequence))
     {
-        if (auto const* functionDefinition = seq->functionDefinition(_terminal->activeSequences()))
+        if (auto const* functionDefinition = seq->functionDefinition(_terminal->supportedSequences()))
             std::cout << std::format("\t{:<20} ; {:<18} ; {}\n",
                                      seq->text(),
                                      functionDefinition->documentation.mnemonic,
@@ -2,20 +2,32 @@
 #pragma once
 
 #include <vtbackend/ColorPalette.h>
+#include <vtbackend/CellLayoutScreen.h>
 #include <vtbackend/Cursor.h>
+#include <vtbackend/FramePacer.h>
 #include <vtbackend/Grid.h>
 #include <vtbackend/Hyperlink.h>
+#include <vtbackend/HyperlinkDetector.h>
+#include <vtbackend/ImageDecoder.h>
 #include <vtbackend/InputGenerator.h>
 #include <vtbackend/InputHandler.h>
+#include <vtbackend/KittyGraphics.h>
+#include <vtbackend/MemoryUsage.h>
+#include <vtbackend/PredictiveEcho.h>
+#include <vtbackend/PtyReader.h>
+#include <vtbackend/PtyWriter.h>
+#include <vtbackend/RegexSearch.h>
 #include <vtbackend/RenderBuffer.h>
 #include <vtbackend/Selector.h>
 #include <vtbackend/Sequence.h>
 #include <vtbackend/SequenceBuilder.h>
+#include <vtbackend/SessionSnapshot.h>
 #include <vtbackend/Settings.h>
 #include <vtbackend/StatusLineBuilder.h>
 #include <vtbackend/ViCommands.h>
 #include <vtbackend/ViInputHandler.h>
 #include <vtbackend/Viewport.h>
+#include <vtbackend/WordDelimiters.h>
 #include <vtbackend/cell/CellConcept.h>
 #include <vtbackend/cell/CellConfig.h>
 #include <vtbackend/logging.h>
@@ -26,11 +38,14 @@
 #include <vtpty/Pty.h>
 
 #include <crispy/BufferObject.h>
+#include <crispy/allocations.h>
 #include <crispy/assert.h>
 #include <crispy/defines.h>
+#include <crispy/thread_cpu_clock.h>
 
 #include <gsl/pointers>
 
+#include <array>
 #include <atomic>
 #include <bitset>
 #include <chrono>
@@ -40,8 +55,11 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <stack>
 #include <string_view>
+#include <variant>
+#include <vector>
 
 namespace vtbackend
 {
@@ -136,9 +154,21 @@ class Modes
 };
 // }}}
 
+enum class SearchMode : uint8_t
+{
+    Literal,
+    Regex,
+};
+
+// Search terms starting with this prefix are regular expressions, as with vim's "very magic" mode.
+constexpr auto RegexSearchPrefix = std::u32string_view(U"\\v");
+
 struct Search
 {
     std::u32string pattern;
+    SearchMode mode = SearchMode::Literal;
+    // The compiled pattern (without prefix) in regex mode, unless it is no valid regular expression (yet).
+    std::optional<RegexSearchPattern> regex;
     ScrollOffset initialScrollOffset {};
     bool initiatedByDoubleClick = false;
 };
@@ -299,6 +329,17 @@ class Terminal
     void setMaxHistoryLineCount(MaxHistoryLineCount maxHistoryLineCount);
     LineCount maxHistoryLineCount() const noexcept;
 
+    /// Number of history lines of the primary screen that have been spilled to disk.
+    [[nodiscard]] LineCount spilledHistoryLineCount() const noexcept;
+
+    /// Pages up to @p count history lines spilled to disk back in while the primary screen is shown,
+    /// e.g. for scrolling, searching or moving the vi cursor beyond the history in memory.
+    ///
+    /// They are spilled again once the viewport returns to the bottom.
+    ///
+    /// @returns the number of lines paged in.
+    LineCount pageInSpilledHistory(LineCount count);
+
     void setTerminalId(VTType id) noexcept;
     VTType terminalId() const noexcept { return _terminalId; }
 
@@ -412,6 +453,16 @@ class Terminal
 
     void setMouseProtocolBypassModifiers(Modifiers value) { _settings.mouseProtocolBypassModifiers = value; }
     void setMouseBlockSelectionModifiers(Modifiers value) { _settings.mouseBlockSelectionModifiers = value; }
+    void setPixelMouseMoveInterval(std::chrono::milliseconds value)
+    {
+        _settings.pixelMouseMoveInterval = value;
+        auto const _ = std::scoped_lock { _inputMutex };
+        _inputGenerator.setPixelMouseMoveInterval(value);
+    }
+    /// Sets the latency of key input from which on typed text is echoed locally ahead of the application.
+    /// This requires the terminal to be locked.
+    void setPredictiveEchoThreshold(std::chrono::milliseconds value);
+    [[nodiscard]] PredictiveEcho const& predictiveEcho() const noexcept { return _predictiveEcho; }
 
     // {{{ input proxy
     using Timestamp = std::chrono::steady_clock::time_point;
@@ -433,6 +484,8 @@ class Terminal
     bool sendFocusInEvent();
     bool sendFocusOutEvent();
     void sendPaste(std::string_view text); // Sends verbatim text in bracketed mode to application.
+    /// Sends text in bracketed mode to the application, streamed in chunks from @p source.
+    void sendPasteStream(PtyWriter::PasteSource source);
     void sendPasteFromClipboard(unsigned count, bool strip)
     {
         _eventListener.pasteFromClipboard(count, strip);
@@ -449,6 +502,15 @@ class Terminal
     bool hasInput() const noexcept;
     void flushInput();
 
+    /// @returns whether pasted text is still being written to the PTY.
+    [[nodiscard]] bool pasteInProgress() const { return _ptyWriter.pasting(); }
+
+    /// @returns the number of bytes of the pastes in progress that have been written to the PTY.
+    [[nodiscard]] size_t pastedBytes() const { return _ptyWriter.pastedBytes(); }
+
+    /// @returns the number of bytes of input, including pastes, that have not been written to the PTY yet.
+    [[nodiscard]] size_t pendingInputBytes() const { return _ptyWriter.pendingBytes(); }
+
     std::string_view peekInput() const noexcept { return _inputGenerator.peek(); }
     // }}}
 
@@ -458,17 +520,22 @@ class Terminal
     /// Writes a given VT-sequence to screen - but without acquiring the lock (must be already acquired).
     void writeToScreenInternal(std::string_view vtStream);
 
-    /// Writes a given VT-sequence to screen - but without acquiring the lock (must be already acquired).
-    /// This version of the function is used to write to the status line and should not be used by the shell.
-    void writeToScreenInternal(Screen<StatusDisplayCell>& screen, std::string_view vtStream);
-
     // viewport management
     [[nodiscard]] Viewport& viewport() noexcept { return _viewport; }
     [[nodiscard]] Viewport const& viewport() const noexcept { return _viewport; }
 
+    [[nodiscard]] FramePacer& framePacer() noexcept { return _framePacer; }
+    [[nodiscard]] FramePacer const& framePacer() const noexcept { return _framePacer; }
+
     // {{{ Screen Render Proxy
+    /// @returns the time from the last tick() until the screen next changes by itself, e.g. due to
+    ///          blinking, or std::nullopt if it does not change until the next input or output.
     std::optional<std::chrono::milliseconds> nextRender() const;
 
+    /// @returns the time from @p now until the next frame is due according to the frame pacer,
+    ///          which is zero if it is due right away.
+    [[nodiscard]] std::chrono::milliseconds nextFrameDelay(std::chrono::steady_clock::time_point now) const;
+
     /// Updates the internal clock to the given time point,
     /// and ensures internal time-dependant state is updated.
     void tick(std::chrono::steady_clock::time_point now) noexcept;
@@ -484,21 +551,17 @@ class Terminal
 
     /// Refreshes the render buffer.
     /// When this function returns, the back buffer is updated
-    /// and it is attempted to swap the back/front buffers.
-    /// but the swap has NOT been invoked yet.
+    /// and published to the render thread.
     ///
     /// @param locked whether or not the Terminal object's lock is already held by the caller.
     ///
-    /// @retval true   front buffer now contains the refreshed render buffer.
-    /// @retval false  back buffer contains the refreshed render buffer,
-    ///                and RenderDoubleBuffer::swapBuffers() must again
-    ///                be successfully invoked to swap back/front buffers
-    ///                in order to access the refreshed render buffer.
+    /// @retval true   the refreshed render buffer has been published.
+    /// @retval false  render buffer updates are currently disabled, or the terminal is hibernated.
     ///
     /// @note The current time must have been updated in order to get the
     ///       correct cursor blinking state drawn.
     ///
-    /// @see RenderDoubleBuffer::swapBuffers()
+    /// @see RenderTripleBuffer::swapBuffers()
     /// @see renderBuffer()
     ///
     bool refreshRenderBuffer(bool locked = false);
@@ -511,14 +574,14 @@ class Terminal
     /// @param now    the current time
     /// @param locked whether or not the Terminal object's lock is already held by the caller.
     ///
-    /// @see RenderDoubleBuffer::swapBuffers()
+    /// @see RenderTripleBuffer::swapBuffers()
     /// @see renderBuffer()
     bool ensureFreshRenderBuffer(bool locked = false);
 
-    /// Aquuires read-access handle to front render buffer.
+    /// Aquuires read-access handle to the most recently published render buffer.
     ///
-    /// This also acquires the reader lock and releases it automatically
-    /// upon RenderBufferRef destruction.
+    /// This never blocks. The handle remains valid until the next call to renderBuffer(),
+    /// and must thus only be used by the render thread.
     ///
     /// @see ensureFreshRenderBuffer()
     /// @see refreshRenderBuffer()
@@ -526,6 +589,55 @@ class Terminal
 
     [[nodiscard]] RenderBufferState renderBufferState() const noexcept { return _renderBuffer.state; }
 
+    /// Frees what is not needed while the terminal is not being shown, i.e. the render buffers
+    /// and unused PTY buffers, and compacts the grids of both screens.
+    ///
+    /// PTY output is still processed while hibernated, but the render buffer is not refreshed
+    /// until the terminal is revived.
+    ///
+    /// Requires the terminal to be locked, and must not be invoked while the render buffer is read.
+    void hibernate();
+
+    /// Ends hibernation and requests the render buffer to be refreshed.
+    void revive();
+
+    [[nodiscard]] bool hibernated() const noexcept { return _hibernated; }
+
+    /// Sets whether the terminal is shown, e.g. in the active tab of a window.
+    ///
+    /// While hidden, PTY output is parsed into the grids as usual, but the render buffer is not
+    /// refreshed, so that none of the intermediate screens of a hidden terminal are built.
+    /// A single refresh catches up with all output once the terminal is shown again.
+    void setVisible(bool visible);
+
+    [[nodiscard]] bool visible() const noexcept { return _visible; }
+
+    /// Frees what is not needed while the terminal is idle, i.e. unused PTY buffers and the
+    /// per-worker render buffers, and compacts the grids of both screens, like hibernate(),
+    /// but keeps the terminal shown.
+    ///
+    /// Requires the terminal to be locked.
+    void trimMemory();
+
+    /// Discards the images of all history lines of both screens that are scrolled out of the viewport.
+    ///
+    /// Requires the terminal to be locked.
+    void discardOffscreenImages();
+
+    /// Drops all but the @p keep most recent history lines of both screens.
+    ///
+    /// Requires the terminal to be locked.
+    void trimHistory(LineCount keep);
+
+    /// Releases the lines of both screens, e.g. once the session has been closed, leaving empty
+    /// pages without history behind.
+    ///
+    /// The lines are destroyed on a thread shared by all terminals, which can take long with a large
+    /// history, without holding the terminal's lock, and without the terminal waiting for it when destroyed.
+    ///
+    /// Requires the terminal to be locked.
+    void releaseGrids();
+
     /// Updates the IME preedit-string to be rendered when IME is composing a new input.
     /// Passing an empty string effectively disables IME rendering.
     void updateInputMethodPreeditString(std::string preeditString);
@@ -534,6 +646,24 @@ class Terminal
     void lock() const { _stateMutex.lock(); }
     void unlock() const { _stateMutex.unlock(); }
 
+    /// Locks the state for reading only, e.g. by std::shared_lock, which queries that neither change
+    /// the state nor any of its caches may use, so that they do not wait for each other.
+    void lock_shared() const { _stateMutex.lock_shared(); }
+    void unlock_shared() const { _stateMutex.unlock_shared(); }
+
+    /// Locks the input generator, which key and mouse input is generated by without the state lock,
+    /// such that it never waits for the input being parsed.
+    ///
+    /// It may be taken while holding the state lock, but not the other way around.
+    [[nodiscard]] std::unique_lock<std::mutex> lockInput() const { return std::unique_lock { _inputMutex }; }
+
+    /// @returns the cursor position of the active screen as of the last input parsed,
+    ///          which unlike currentScreen().cursor() may be queried without holding any lock.
+    [[nodiscard]] CellLocation publishedCursorPosition() const noexcept
+    {
+        return _publishedCursorPosition.load(std::memory_order_relaxed);
+    }
+
     [[nodiscard]] ColorPalette const& colorPalette() const noexcept { return _colorPalette; }
     [[nodiscard]] ColorPalette& colorPalette() noexcept { return _colorPalette; }
     [[nodiscard]] ColorPalette& defaultColorPalette() noexcept { return _defaultColorPalette; }
@@ -587,8 +717,8 @@ class Terminal
     {
         switch (type)
         {
-            case ScreenType::Primary: return _primaryScreen;
-            case ScreenType::Alternate: return _alternateScreen;
+            case ScreenType::Primary: return _primaryScreen.base();
+            case ScreenType::Alternate: return _alternateScreen.base();
         }
         crispy::unreachable();
     }
@@ -598,18 +728,69 @@ class Terminal
         _settings.highlightTimeout = timeout;
     }
 
+    /// @returns the cell layout the primary and alternate screens have been created with.
+    [[nodiscard]] CellLayout cellLayout() const noexcept { return _primaryScreen.layout(); }
+
+    /// Invokes @p visitor with the primary screen, of the cell type of the terminal's cell layout.
+    template <typename Visitor>
+    decltype(auto) visitPrimaryScreen(Visitor&& visitor)
+    {
+        return _primaryScreen.visit(std::forward<Visitor>(visitor));
+    }
+
+    template <typename Visitor>
+    decltype(auto) visitPrimaryScreen(Visitor&& visitor) const
+    {
+        return _primaryScreen.visit(std::forward<Visitor>(visitor));
+    }
+
+    /// Invokes @p visitor with the alternate screen, of the cell type of the terminal's cell layout.
+    template <typename Visitor>
+    decltype(auto) visitAlternateScreen(Visitor&& visitor)
+    {
+        return _alternateScreen.visit(std::forward<Visitor>(visitor));
+    }
+
+    template <typename Visitor>
+    decltype(auto) visitAlternateScreen(Visitor&& visitor) const
+    {
+        return _alternateScreen.visit(std::forward<Visitor>(visitor));
+    }
+
+    [[nodiscard]] ScreenBase const& primaryScreenBase() const noexcept { return _primaryScreen.base(); }
+    [[nodiscard]] ScreenBase& primaryScreenBase() noexcept { return _primaryScreen.base(); }
+
+    // The typed screen accessors require the terminal to use the default cell layout (CellLayout::Compact).
     // clang-format off
-    [[nodiscard]] Screen<PrimaryScreenCell> const& primaryScreen() const noexcept { return _primaryScreen; }
-    [[nodiscard]] Screen<PrimaryScreenCell>& primaryScreen() noexcept { return _primaryScreen; }
-    [[nodiscard]] Screen<AlternateScreenCell> const& alternateScreen() const noexcept { return _alternateScreen; }
-    [[nodiscard]] Screen<AlternateScreenCell>& alternateScreen() noexcept { return _alternateScreen; }
+    [[nodiscard]] Screen<PrimaryScreenCell> const& primaryScreen() const noexcept { return _primaryScreen.as<PrimaryScreenCell>(); }
+    [[nodiscard]] Screen<PrimaryScreenCell>& primaryScreen() noexcept { return _primaryScreen.as<PrimaryScreenCell>(); }
+    [[nodiscard]] Screen<AlternateScreenCell> const& alternateScreen() const noexcept { return _alternateScreen.as<AlternateScreenCell>(); }
+    [[nodiscard]] Screen<AlternateScreenCell>& alternateScreen() noexcept { return _alternateScreen.as<AlternateScreenCell>(); }
     [[nodiscard]] Screen<StatusDisplayCell> const& hostWritableStatusLineDisplay() const noexcept { return _hostWritableStatusLineScreen; }
     [[nodiscard]] Screen<StatusDisplayCell> const& indicatorStatusLineDisplay() const noexcept { return _indicatorStatusScreen; }
     // clang-format on
 
+    /// Saves the scrollback of the primary screen, including any spilled history lines, the main page
+    /// and the cursor position, so that it can be restored into another session later on.
+    ///
+    /// Hyperlinks are not saved, as they are only known to this terminal.
+    [[nodiscard]] SessionSnapshot sessionSnapshot();
+
+    /// Pushes the lines of a previously saved session down to its cursor line into the primary
+    /// screen's history.
+    void restoreSessionSnapshot(SessionSnapshot const& snapshot);
+
+    /// Takes over the primary screen of a running session into this terminal, which has not been written
+    /// to yet: the page lines onto the page, with the cursor where it was, and all others into the history.
+    ///
+    /// This shows the session as it was without having its contents repainted by escape sequences.
+    void attachSessionSnapshot(SessionSnapshot const& snapshot);
+
     [[nodiscard]] bool isLineWrapped(LineOffset lineNumber) const noexcept
     {
-        return isPrimaryScreen() && _primaryScreen.isLineWrapped(lineNumber);
+        return isPrimaryScreen() && _primaryScreen.visit([&](auto const& screen) {
+                   return screen.isLineWrapped(lineNumber);
+               });
     }
 
     [[nodiscard]] CellLocation currentMousePosition() const noexcept { return _currentMousePosition; }
@@ -670,6 +851,10 @@ class Terminal
     Selection* selector() noexcept { return _selection.get(); }
     std::chrono::milliseconds highlightTimeout() const noexcept { return _settings.highlightTimeout; }
 
+    /// Highlights the text matching the selection, if enabled.
+    ///
+    /// While the selection is being dragged, this is deferred until the mouse rested for a moment or the
+    /// button is released, as each update makes the whole page be scanned for matches anew.
     void updateSelectionMatches();
 
     template <typename RenderTarget>
@@ -678,12 +863,14 @@ class Terminal
         if (!_selection)
             return;
 
-        if (isPrimaryScreen())
+        auto const render = [&](auto const& screen) {
             vtbackend::renderSelection(*_selection,
-                                       [&](CellLocation pos) { renderTarget(pos, _primaryScreen.at(pos)); });
+                                       [&](CellLocation pos) { renderTarget(pos, screen.at(pos)); });
+        };
+        if (isPrimaryScreen())
+            _primaryScreen.visit(render);
         else
-            vtbackend::renderSelection(
-                *_selection, [&](CellLocation pos) { renderTarget(pos, _alternateScreen.at(pos)); });
+            _alternateScreen.visit(render);
     }
 
     void clearSelection();
@@ -716,6 +903,11 @@ class Terminal
     }
 
     bool isHighlighted(CellLocation cell) const noexcept;
+
+    /// Returns the highlighted columns within the given grid lines (inclusive),
+    /// one range for each highlighted line, in ascending line order.
+    [[nodiscard]] std::vector<ColumnRange> highlightedRanges(LineOffset top, LineOffset bottom) const;
+
     bool blinkState() const noexcept { return _slowBlinker.state; }
     bool rapidBlinkState() const noexcept { return _rapidBlinker.state; }
 
@@ -729,12 +921,53 @@ class Terminal
     void setVisualizeSelectedWord(bool enabled) noexcept { _settings.visualizeSelectedWord = enabled; }
     // }}}
 
+    /// Receives extracted text piecewise, see extractSelectionText(TextChunkSink const&).
+    using TextChunkSink = std::function<void(std::string_view)>;
+
+    /// Number of bytes accumulated before handing them to a TextChunkSink.
+    static constexpr size_t TextExtractionChunkSize = 64 * 1024;
+
+    /// Streams the UTF-8 text of the current selection into @p sink in chunks of roughly
+    /// TextExtractionChunkSize bytes, without materializing the whole selection at once.
+    void extractSelectionText(TextChunkSink const& sink) const;
+
     [[nodiscard]] std::string extractSelectionText() const;
+
+    /// Text of the selection as of when it has been taken, to be extracted without the terminal lock.
+    struct SelectionTextSnapshot
+    {
+        /// Number of selected lines, e.g. to tell how long extracting the text is going to take.
+        size_t lineCount = 0;
+
+        /// Yields the next chunk of roughly TextExtractionChunkSize bytes of UTF-8 text,
+        /// or an empty string once all of the text has been yielded.
+        ///
+        /// It works on a snapshot of the selected lines and can thus be invoked on any thread,
+        /// while the terminal moves on. It is empty if nothing is selected.
+        std::function<std::string()> nextChunk;
+    };
+
+    /// Snapshots the current selection for its text to be extracted later on, e.g. on a worker thread.
+    [[nodiscard]] SelectionTextSnapshot selectionTextSnapshot() const;
     [[nodiscard]] std::string extractLastMarkRange() const;
 
+    /// Extracts the output of the n-th most recent shell command that has completed,
+    /// as indexed by shell integration, or an empty string if there is none.
+    [[nodiscard]] std::string extractCommandOutput(size_t n = 0) const;
+
     HyperlinkStorage& hyperlinks() noexcept { return _hyperlinks; }
     HyperlinkStorage const& hyperlinks() const noexcept { return _hyperlinks; }
 
+    /// Hyperlinks detected in plain text, such as URLs and paths with line numbers.
+    HyperlinkDetector& hyperlinkDetector() noexcept { return _hyperlinkDetector; }
+
+    /// @returns the grid cells of the detected hyperlink hovered by the mouse, as of the most recent
+    /// render buffer refresh.
+    [[nodiscard]] std::optional<ColumnRange> hoveringDetectedHyperlink() const noexcept
+    {
+        return _hoveringDetectedHyperlink;
+    }
+
     /// Tests whether or not the mouse is currently hovering a hyperlink.
     [[nodiscard]] bool isMouseHoveringHyperlink() const noexcept
     {
@@ -753,7 +986,16 @@ class Terminal
     [[nodiscard]] ExecutionMode executionMode() const noexcept { return _executionMode; }
     void setExecutionMode(ExecutionMode mode);
 
-    bool processInputOnce();
+    /// Reads and processes the next chunk of PTY input, waiting for it for as long as needed.
+    ///
+    /// @returns false once the PTY has been closed.
+    bool processInputOnce() { return processInputOnce(ptyReadTimeout()); }
+
+    /// Reads and processes the next chunk of PTY input, waiting for up to @p timeout
+    /// (or indefinitely) for it to arrive, and then writes any replies it produced to the PTY.
+    ///
+    /// @returns false once the PTY has been closed.
+    bool processInputOnce(std::optional<std::chrono::milliseconds> timeout);
 
     void markScreenDirty() noexcept { _screenDirty = true; }
 
@@ -779,13 +1021,18 @@ class Terminal
     template <typename... Ts>
     void reply(std::string_view message, Ts const&... args)
     {
-#if defined(__APPLE__) || defined(_MSC_VER)
-        reply(std::vformat(message, std::make_format_args(args...)));
-#else
-        reply(std::vformat(message, std::make_format_args(args...)));
-#endif
+        replyFormatted(message, std::make_format_args(args...));
     }
 
+    /// Formats the reply straight into the pending input, without any intermediate string.
+    void replyFormatted(std::string_view message, std::format_args args);
+
+    /// Replies to the application with the chunks yielded by @p source, after all previous replies.
+    ///
+    /// The next chunk is only asked for once the application has read the previous one,
+    /// and the reply is not interleaved with other input once started.
+    void replyStreamed(PtyWriter::PasteSource source);
+
     void requestWindowResize(PageSize);
     void requestWindowResize(ImageSize);
     void setApplicationkeypadMode(bool enabled);
@@ -822,7 +1069,11 @@ class Terminal
         return _currentWorkingDirectory;
     }
 
-    void setCurrentWorkingDirectory(std::string text) { _currentWorkingDirectory = std::move(text); }
+    void setCurrentWorkingDirectory(std::string text)
+    {
+        _currentWorkingDirectory = std::move(text);
+        _hyperlinkDetector.setWorkingDirectory(_currentWorkingDirectory);
+    }
 
     void verifyState();
 
@@ -885,7 +1136,7 @@ class Terminal
     // Tests if the grid cell at the given location does contain a word delimiter.
     [[nodiscard]] bool wordDelimited(CellLocation position) const noexcept;
     [[nodiscard]] bool wordDelimited(CellLocation position,
-                                     std::u32string_view wordDelimiters) const noexcept;
+                                     WordDelimiters const& wordDelimiters) const noexcept;
 
     [[nodiscard]] std::tuple<std::u32string, CellLocationRange> extractWordUnderCursor(
         CellLocation position) const noexcept;
@@ -906,6 +1157,11 @@ class Terminal
         return _supportedVTSequences.activeSequences();
     }
 
+    [[nodiscard]] SupportedSequences const& supportedSequences() const noexcept
+    {
+        return _supportedVTSequences;
+    }
+
     // {{{ VT parser related
 
     [[nodiscard]] size_t maxBulkTextSequenceWidth() const noexcept;
@@ -917,6 +1173,66 @@ class Terminal
 
     [[nodiscard]] bool usingStdoutFastPipe() const noexcept { return _usingStdoutFastPipe; }
 
+    /// Statistics on reading from the PTY.
+    struct PtyReadStats
+    {
+        size_t readSize = 0;                   ///< Current maximum number of bytes read at once.
+        std::array<uint64_t, 24> histogram {}; ///< Number of reads, by the bit width of their size.
+    };
+
+    [[nodiscard]] PtyReadStats const& ptyReadStats() const noexcept { return _ptyReadStats; }
+
+    [[nodiscard]] crispy::buffer_object_pool<char> const& ptyBufferPool() const noexcept
+    {
+        return _ptyBufferPool;
+    }
+
+    /// @returns the total number of bytes read from the PTY and parsed so far.
+    [[nodiscard]] uint64_t parsedBytes() const noexcept { return _parsedBytes.load(); }
+
+    /// @returns the time of the most recent key input, or the steady clock's epoch if there was none.
+    [[nodiscard]] Timestamp lastKeyInputTime() const noexcept
+    {
+        return Timestamp(std::chrono::duration_cast<Timestamp::duration>(
+            std::chrono::nanoseconds(_lastKeyInputTime.load(std::memory_order_relaxed))));
+    }
+
+    /// Number of VT sequences processed so far, indexed by FunctionCategory.
+    using SequenceCounts = std::array<uint64_t, 5>;
+
+    /// @returns the number of VT sequences processed so far, by category.
+    ///
+    /// This requires the terminal to be locked.
+    [[nodiscard]] SequenceCounts const& sequenceCounts() const noexcept { return _sequenceCounts; }
+
+    /// @returns the time it took to fill the most recently refreshed render buffer.
+    [[nodiscard]] std::chrono::nanoseconds renderBufferFillTime() const noexcept
+    {
+        return std::chrono::nanoseconds(_renderBufferFillTime.load());
+    }
+
+    /// CPU time spent on processing the output of the PTY so far.
+    struct CpuTimes
+    {
+        std::chrono::nanoseconds ptyRead {};
+        std::chrono::nanoseconds parse {}; ///< Including applying the parsed output to the screen.
+        std::chrono::nanoseconds renderBufferFill {};
+
+        [[nodiscard]] std::chrono::nanoseconds total() const noexcept
+        {
+            return ptyRead + parse + renderBufferFill;
+        }
+    };
+
+    /// @returns the CPU time spent on processing the output of the PTY so far, which may be
+    ///          invoked from any thread.
+    [[nodiscard]] CpuTimes cpuTimes() const noexcept;
+
+    /// @returns the approximate memory taken by this terminal, excluding what its display takes.
+    ///
+    /// This walks all lines of the screens under the terminal lock, so it should not be invoked too often.
+    [[nodiscard]] MemoryUsage memoryUsage() const;
+
     void hookParser(std::unique_ptr<ParserExtension> parserExtension) noexcept
     {
         _sequenceBuilder.hookParser(std::move(parserExtension));
@@ -933,6 +1249,19 @@ class Terminal
     ImagePool& imagePool() noexcept { return _imagePool; }
     ImagePool const& imagePool() const noexcept { return _imagePool; }
 
+    KittyGraphics& kittyGraphics() noexcept { return _kittyGraphics; }
+    KittyGraphics const& kittyGraphics() const noexcept { return _kittyGraphics; }
+
+    /// Decodes the pixel data of @p image, created by ImagePool::createPending(), on a worker thread.
+    ///
+    /// @p onDecoded is invoked with the terminal locked once done, before the screen gets redrawn.
+    void decodeImage(std::shared_ptr<Image const> image,
+                     ImageDecoder::Decode decode,
+                     ImageDecoder::Completion onDecoded);
+
+    /// Waits for all images being decoded to be done. The terminal must not be locked.
+    void waitForImageDecoding() const { _imageDecoder.waitForIdle(); }
+
     bool syncWindowTitleWithHostWritableStatusDisplay() const noexcept
     {
         return _syncWindowTitleWithHostWritableStatusDisplay;
@@ -970,11 +1299,38 @@ class Terminal
 
   private:
     void mainLoop();
+
+    /// Releases the unused memory of the primary and alternate screen's grids.
+    void compactGrids();
+
+    /// Remembers the time of key input, unless older key input has not been answered yet.
+    void noteKeyInput(Timestamp now) noexcept;
+
+    /// Marks the key input not answered yet, if any, as answered by the PTY output just parsed.
+    /// This requires the terminal to be locked.
+    void noteKeyInputAnswered() noexcept;
+
+    /// Echoes the key input just sent locally, if predicting it is currently possible.
+    void predictEcho(char32_t ch, Modifiers modifiers, KeyboardEventType eventType, Timestamp now);
+    void predictEcho(Key key, Modifiers modifiers, KeyboardEventType eventType, Timestamp now);
+    [[nodiscard]] bool canPredictEcho() const noexcept;
+
+    /// Confirms or rolls back the predicted echo against the PTY output just parsed.
+    /// This requires the terminal to be locked.
+    void verifyPredictedEcho();
+    void predictedEchoChanged() noexcept;
+    void renderPredictedEcho(RenderBuffer& output, LineOffset baseLine) const;
+
     void fillRenderBufferInternal(RenderBuffer& output, bool includeSelection);
     LineCount fillRenderBufferStatusLine(RenderBuffer& output, bool includeSelection, LineOffset base);
     void updateIndicatorStatusLine();
     void updateCursorVisibilityState() const noexcept;
     void updateHoveringHyperlinkState();
+    void publishCursorPosition() noexcept;
+    void applySelectionMatches();
+
+    /// Points the parser's events at the display activeDisplay() yields, whenever that changes.
+    void updateSequenceTarget() noexcept;
 
     struct TheSelectionHelper: public vtbackend::SelectionHelper
     {
@@ -1021,7 +1377,13 @@ class Terminal
     }
 
     // Reads from PTY.
-    [[nodiscard]] std::optional<vtpty::Pty::ReadResult> readFromPty();
+    [[nodiscard]] std::optional<std::chrono::milliseconds> ptyReadTimeout() const;
+    [[nodiscard]] std::optional<vtpty::Pty::ReadResult> readFromPty(
+        std::optional<std::chrono::milliseconds> timeout);
+    [[nodiscard]] bool processInputFromPtyReader(std::optional<std::chrono::milliseconds> timeout);
+    // Reads and processes the next chunk of PTY input, see processInputOnce().
+    [[nodiscard]] bool parseInputOnce(std::optional<std::chrono::milliseconds> timeout);
+    void updatePtyReadSize(size_t requested, size_t received) noexcept;
 
     // Writes partially or all input data to the PTY buffer object and returns a string view to it.
     [[nodiscard]] std::string_view lockedWriteToPtyBuffer(std::string_view data);
@@ -1036,16 +1398,28 @@ class Terminal
     Settings _settings;
 
     // synchronization
-    std::mutex mutable _stateMutex;
+    std::shared_mutex mutable _stateMutex;
+    std::mutex mutable _inputMutex; // guards _inputGenerator, see lockInput()
+    std::atomic<CellLocation> _publishedCursorPosition {};
 
     // terminal clock
     std::chrono::steady_clock::time_point _currentTime;
 
+    // time of the last screen resize, used to defer reflowing history until resizing has settled.
+    std::chrono::steady_clock::time_point _lastResize;
+
+    // time at which the selection being dragged is to be highlighted, see updateSelectionMatches().
+    std::optional<std::chrono::steady_clock::time_point> _selectionMatchesDeadline;
+
     // {{{ PTY and PTY read buffer management
     crispy::buffer_object_pool<char> _ptyBufferPool;
     crispy::buffer_object_ptr<char> _currentPtyBuffer;
-    size_t _ptyReadBufferSize;
+    // The PTY read size adapts to the output between these bounds, see updatePtyReadSize().
+    size_t _minPtyReadBufferSize;
+    size_t _maxPtyReadBufferSize;
+    PtyReadStats _ptyReadStats;
     std::unique_ptr<vtpty::Pty> _pty;
+    std::unique_ptr<PtyReader> _ptyReader; // only set if Settings::ptyReaderThread is enabled
     // }}}
 
     // {{{ mouse related state (helpers for detecting double/tripple clicks)
@@ -1072,18 +1446,34 @@ class Terminal
     // }}}
 
     // {{{ Displays this terminal manages
-    Screen<PrimaryScreenCell> _primaryScreen;
-    Screen<AlternateScreenCell> _alternateScreen;
+    CellLayoutScreen _primaryScreen;
+    CellLayoutScreen _alternateScreen;
     Screen<StatusDisplayCell> _hostWritableStatusLineScreen;
     Screen<StatusDisplayCell> _indicatorStatusScreen;
     gsl::not_null<ScreenBase*> _currentScreen;
+    // The active display by its concrete type, such that the parser's events are dispatched to it
+    // by a switch over the cell types rather than virtual calls (see updateSequenceTarget()).
+    std::variant<Screen<CompactCell>*, Screen<SimpleCell>*> _sequenceTarget;
     Viewport _viewport;
     StatusLineDefinition _indicatorStatusLineDefinition;
 
+    // What has last been written into the indicator status line, and with which colors and width.
+    struct IndicatorStatusLineState
+    {
+        StatusLineContent content;
+        RGBColor foreground;
+        RGBColor background;
+        ColumnCount columns;
+
+        bool operator==(IndicatorStatusLineState const&) const = default;
+    };
+    std::optional<IndicatorStatusLineState> _indicatorStatusLineState;
+
     TabsInfo _guiTabInfoForStatusLine;
 
     // {{{ selection states
     std::unique_ptr<Selection> _selection;
+    WordDelimiters _wordDelimiters; // compiled from _settings.wordDelimiters
     TheSelectionHelper _selectionHelper;
     TheSelectionHelper _extendedSelectionHelper;
     TheSelectionHelper _customSelectionHelper;
@@ -1093,15 +1483,33 @@ class Terminal
     /// Boolean, indicating whether the terminal's screen buffer contains updates to be rendered.
     mutable std::atomic<uint64_t> _changes { 0 };
     bool _screenDirty = false; // TODO: just inc _changes and delete this instead.
-    RefreshInterval _refreshInterval;
-    RenderDoubleBuffer _renderBuffer {};
+    FramePacer _framePacer;
+    RenderTripleBuffer _renderBuffer {};
     std::atomic<uint64_t> _lastFrameID = 0;
+    std::atomic<int64_t> _renderBufferFillTime = 0; // in nanoseconds
+    std::atomic<int64_t> _renderBufferFillCpuTime = 0; // in nanoseconds, in total
     RenderPassHints _lastRenderPassHints {};
+
+    // Contents of the render buffer being refreshed, as of its previous refresh,
+    // to take over undamaged lines from.
+    RenderBuffer _previousRenderBuffer {};
+
+    // The render buffer most recently refreshed, which is not written to until it is the back buffer again.
+    RenderBuffer const* _lastRefreshedRenderBuffer = nullptr;
+
+    // Per-worker buffers the main page is rendered into when building the render buffer in parallel.
+    std::vector<RenderBuffer> _renderChunks {};
+
+    // Estimated memory taken by all render buffers, as of the most recent refresh.
+    size_t _renderBufferMemoryUsage = 0;
     // }}}
 
     InputMethodData _inputMethodData {};
     std::atomic<HyperlinkId> _hoveringHyperlinkId = HyperlinkId {};
     std::atomic<bool> _renderBufferUpdateEnabled = true; // for "Synchronized Updates" feature
+    bool _synchronizedOutputSinceRefresh = false;        // whether a batch started since the last refresh
+    std::atomic<bool> _hibernated = false;
+    std::atomic<bool> _visible = true;
     std::optional<HighlightRange> _highlightRange = std::nullopt;
     SupportedSequences _supportedVTSequences;
 
@@ -1137,6 +1545,7 @@ class Terminal
     ImageSize _effectiveImageCanvasSize;
     std::shared_ptr<SixelColorPalette> _sixelColorPalette;
     ImagePool _imagePool;
+    KittyGraphics _kittyGraphics;
 
     std::vector<ColumnOffset> _tabs;
 
@@ -1157,31 +1566,99 @@ class Terminal
     bool _usePrivateColorRegisters = false;
 
     bool _usingStdoutFastPipe = false;
+    std::atomic<uint64_t> _parsedBytes = 0;
+    std::atomic<int64_t> _ptyReadCpuTime = 0; // in nanoseconds, apart from those of the PTY reader thread
+    std::atomic<int64_t> _parseCpuTime = 0;   // in nanoseconds
+    SequenceCounts _sequenceCounts {};
+
+    // Time of the oldest key input that has not been answered by any PTY output yet, in nanoseconds
+    // since the steady clock's epoch, or 0 if there is none.
+    std::atomic<int64_t> _unansweredInputTime = 0;
+    // Time of the most recent key input, in nanoseconds since the steady clock's epoch.
+    std::atomic<int64_t> _lastKeyInputTime = 0;
+    // Timing of the oldest key input that has been answered, but not shown in a render buffer yet.
+    std::optional<InputTiming> _answeredInput;
+
+    // Typed input echoed locally, guarded by the terminal's lock. The deadline of its oldest
+    // prediction, in nanoseconds since the steady clock's epoch or 0 if there is none, is kept
+    // apart for the timers, which are queried unlocked.
+    PredictiveEcho _predictiveEcho;
+    std::atomic<bool> _predictiveEchoEnabled = false;
+    std::atomic<int64_t> _predictiveEchoDeadline = 0;
 
     // Hyperlink related
     //
     HyperlinkStorage _hyperlinks {};
+    HyperlinkDetector _hyperlinkDetector {};
+    std::optional<ColumnRange> _hoveringDetectedHyperlink {};
 
     std::string _windowTitle {};
     std::stack<std::string> _savedWindowTitles {};
 
+    // Forwards the parser's events to the active display, or to the trace handler when not executing
+    // normally, accounting the allocations made on the way to the screen rather than to the parser.
     struct ModeDependantSequenceHandler
     {
         Terminal& terminal;
+
+        // Invokes @p call with the active display of its concrete type, whose member functions are thus
+        // bound statically, or with the trace handler when not executing normally.
+        template <typename Call>
+        void dispatch(Call&& call)
+        {
+            if (terminal._executionMode.load() != ExecutionMode::Normal) [[unlikely]]
+                call(static_cast<SequenceHandler&>(terminal._traceHandler));
+            else
+                std::visit([&](auto* screen) { call(*screen); }, terminal._sequenceTarget);
+        }
+
         void executeControlCode(char controlCode)
         {
-            terminal.sequenceHandler().executeControlCode(controlCode);
+            CRISPY_ALLOCATION_SCOPE(screenAllocations);
+            ++terminal._sequenceCounts[static_cast<size_t>(FunctionCategory::C0)];
+            dispatch([&](auto& handler) { handler.executeControlCode(controlCode); });
         }
         void processSequence(Sequence const& sequence)
         {
-            terminal.sequenceHandler().processSequence(sequence);
+            CRISPY_ALLOCATION_SCOPE(screenAllocations);
+            ++terminal._sequenceCounts[static_cast<size_t>(sequence.category())];
+            dispatch([&](auto& handler) { handler.processSequence(sequence); });
+        }
+        void processGraphicsRendition(Sequence const& sequence)
+        {
+            CRISPY_ALLOCATION_SCOPE(screenAllocations);
+            ++terminal._sequenceCounts[static_cast<size_t>(FunctionCategory::CSI)];
+            dispatch([&](auto& handler) { handler.processGraphicsRendition(sequence); });
+        }
+        void processApplicationProgramCommand(std::string_view command)
+        {
+            CRISPY_ALLOCATION_SCOPE(screenAllocations);
+            dispatch([&](auto& handler) { handler.processApplicationProgramCommand(command); });
+        }
+        void writeText(char32_t codepoint)
+        {
+            CRISPY_ALLOCATION_SCOPE(screenAllocations);
+            dispatch([&](auto& handler) { handler.writeText(codepoint); });
         }
-        void writeText(char32_t codepoint) { terminal.sequenceHandler().writeText(codepoint); }
         void writeText(std::string_view codepoints, size_t cellCount)
         {
-            terminal.sequenceHandler().writeText(codepoints, cellCount);
+            CRISPY_ALLOCATION_SCOPE(screenAllocations);
+            dispatch([&](auto& handler) { handler.writeText(codepoints, cellCount); });
+        }
+        [[nodiscard]] size_t writeTextLines(std::string_view text)
+        {
+            // The trace handler needs to see the text and control codes one by one.
+            if (terminal._executionMode.load() != ExecutionMode::Normal) [[unlikely]]
+                return 0;
+            CRISPY_ALLOCATION_SCOPE(screenAllocations);
+            return std::visit([&](auto* screen) { return screen->writeTextLines(text); },
+                              terminal._sequenceTarget);
+        }
+        void writeTextEnd()
+        {
+            CRISPY_ALLOCATION_SCOPE(screenAllocations);
+            dispatch([&](auto& handler) { handler.writeTextEnd(); });
         }
-        void writeTextEnd() { terminal.sequenceHandler().writeTextEnd(); }
         [[nodiscard]] size_t maxBulkTextSequenceWidth() const noexcept
         {
             return terminal.maxBulkTextSequenceWidth();
@@ -1205,6 +1682,10 @@ class Terminal
 
     ViCommands _viCommands;
     ViInputHandler _inputHandler;
+
+    // Declared last, so that their threads are stopped before anything their callbacks refer to is destroyed.
+    ImageDecoder _imageDecoder;
+    PtyWriter _ptyWriter;
 };
 
 } // namespace vtbackend
@@ -13,7 +13,11 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <format>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 using namespace std;
@@ -86,6 +90,35 @@ TEST_CASE("Terminal.BlinkingCursor", "[terminal]")
     }
 }
 
+TEST_CASE("Terminal.nextRender", "[terminal]")
+{
+    auto mc = MockTerm { ColumnCount { 6 }, LineCount { 4 } };
+    auto& terminal = mc.terminal;
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+
+    SECTION("idle")
+    {
+        terminal.setCursorDisplay(vtbackend::CursorDisplay::Steady);
+        terminal.tick(ClockBase + 1h);
+        CHECK(!terminal.nextRender().has_value());
+    }
+
+    SECTION("blinking cursor")
+    {
+        terminal.setCursorDisplay(vtbackend::CursorDisplay::Blink);
+        terminal.setCursorBlinkingInterval(500ms);
+        terminal.tick(ClockBase + 100ms);
+        CHECK(terminal.nextRender() == 400ms);
+
+        terminal.tick(ClockBase + 500ms);
+        CHECK(terminal.nextRender() == 500ms);
+
+        // Nothing blinks when the cursor is hidden.
+        mc.writeToScreen("\033[?25l");
+        CHECK(!terminal.nextRender().has_value());
+    }
+}
+
 TEST_CASE("Terminal.DECCARA", "[terminal]")
 {
     auto mock = MockTerm { ColumnCount(5), LineCount(5) };
@@ -175,6 +208,87 @@ TEST_CASE("Terminal.CaptureScreenBuffer")
     // But here we test the full cycle.
 }
 
+TEST_CASE("Terminal.CaptureScreenBuffer.streamed")
+{
+    auto constexpr LineCountToCapture = 10000;
+    auto mock = MockTerm { PageSize { LineCount(5), ColumnCount(20) }, LineCount(LineCountToCapture) };
+
+    auto expected = std::string {};
+    for (int i = 1; i <= LineCountToCapture; ++i)
+    {
+        mock.writeToScreen(std::format("\r\nline {}", i));
+        expected += std::format("line {}\n", i);
+    }
+
+    mock.writeToScreen(std::format("\033[>0;{}t", LineCountToCapture));
+    mock.terminal.flushInput();
+
+    auto const deadline = std::chrono::steady_clock::now() + 10s;
+    while (mock.terminal.pasteInProgress() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(1ms);
+
+    // The capture arrives in bounded chunks, terminated by an empty one.
+    auto const& reply = mock.replyData();
+    auto captured = std::string {};
+    auto chunks = 0;
+    auto terminated = false;
+    for (auto i = reply.find("\033^314;"); i != std::string::npos; i = reply.find("\033^314;", i))
+    {
+        auto const start = i + 6;
+        auto const end = reply.find("\033\\", start);
+        REQUIRE(end != std::string::npos);
+        CHECK(end - start <= 4096 + 32);
+        terminated = end == start;
+        captured += reply.substr(start, end - start);
+        ++chunks;
+        i = end;
+    }
+    CHECK(terminated);
+    CHECK(chunks > 16);
+    CHECK(captured == expected);
+}
+
+TEST_CASE("Terminal.ShellIntegration.commands", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(5), ColumnCount(20) }, LineCount(20) };
+    auto const& screen = mock.terminal.primaryScreen();
+
+    // As written by the shipped shell integration, starting with the end of no command at all.
+    mock.writeToScreen("\033]133;D;0\033\\\033[>M$ ls\r\n\033]133;C\033\\a\r\nb\r\n");
+    mock.writeToScreen("\033]133;D;0\033\\\033[>M$ false\r\n\033]133;C\033\\");
+    mock.writeToScreen("\033]133;D;1\033\\\033[>M$ ");
+    REQUIRE(screen.commandCount() == 3);
+
+    auto const ls = screen.command(2);
+    REQUIRE(ls.has_value());
+    CHECK(ls->prompt == LineOffset(0));
+    CHECK(ls->outputTop == LineOffset(1));
+    CHECK(ls->outputBottom == LineOffset(2));
+    CHECK(ls->exitStatus == 0);
+    CHECK(ls->complete);
+
+    auto const fail = screen.command(1);
+    REQUIRE(fail.has_value());
+    CHECK(fail->prompt == LineOffset(3));
+    CHECK(!fail->hasOutput());
+    CHECK(fail->exitStatus == 1);
+
+    CHECK(!screen.command(0)->complete);
+    CHECK(screen.commandAt(LineOffset(2)) == 2);
+    CHECK(screen.commandAt(LineOffset(4)) == 0);
+
+    // The command still running is skipped.
+    CHECK(mock.terminal.extractCommandOutput(0).empty());
+    CHECK(mock.terminal.extractCommandOutput(1) == "a\nb\n");
+
+    // Records move along with their lines into the history.
+    mock.writeToScreen("\r\n1\r\n2\r\n3");
+    REQUIRE(screen.historyLineCount() == LineCount(3));
+    CHECK(screen.command(2)->prompt == LineOffset(-3));
+    CHECK(screen.commandAt(LineOffset(-1)) == 2);
+    CHECK(mock.terminal.extractCommandOutput(1) == "a\nb\n");
+}
+
 TEST_CASE("Terminal.RIS", "[terminal]")
 {
     using namespace vtbackend;
@@ -196,6 +310,30 @@ TEST_CASE("Terminal.RIS", "[terminal]")
     CHECK(mc.terminal.statusDisplayType() == StatusDisplayType::None);
 }
 
+TEST_CASE("Terminal.IndicatorStatusLine", "[terminal]")
+{
+    using namespace vtbackend;
+
+    auto mc = MockTerm { ColumnCount(20), LineCount(5) };
+    auto const& statusLine = mc.terminal.indicatorStatusLineDisplay();
+    mc.terminal.setWindowTitle("abc");
+    mc.terminal.setStatusLineDefinition(parseStatusLineDefinition("L {Title:Bold}", "|", "right"));
+    CHECK(statusLine.grid().lineText(LineOffset(0)) == "L abc    |     right");
+    CHECK(!statusLine.at(LineOffset(0), ColumnOffset(0)).isFlagEnabled(CellFlag::Bold));
+    CHECK(statusLine.at(LineOffset(0), ColumnOffset(2)).isFlagEnabled(CellFlag::Bold));
+    CHECK(statusLine.at(LineOffset(0), ColumnOffset(15)).foregroundColor()
+          == Color(mc.terminal.colorPalette().indicatorStatusLineInsertMode.foreground));
+
+    // The status line follows the changes of what it shows.
+    mc.terminal.setWindowTitle("wxyz");
+    mc.terminal.setStatusLineDefinition(parseStatusLineDefinition("L {Title:Bold}", "|", "right"));
+    CHECK(statusLine.grid().lineText(LineOffset(0)) == "L wxyz   |     right");
+
+    // Segments too long to be shown are left out.
+    mc.terminal.setStatusLineDefinition(parseStatusLineDefinition("L", "", "01234567890123456789"));
+    CHECK(statusLine.grid().lineText(LineOffset(0)) == "L                   ");
+}
+
 TEST_CASE("Terminal.SynchronizedOutput", "[terminal]")
 {
     constexpr auto BatchOn = "\033[?2026h"sv;
@@ -221,6 +359,96 @@ TEST_CASE("Terminal.SynchronizedOutput", "[terminal]")
     CHECK("Hello  World" == trimmedTextScreenshot(mc));
 }
 
+TEST_CASE("Terminal.render_large_page", "[terminal]")
+{
+    // Large enough for the render buffer to be built by multiple workers, if available.
+    auto constexpr PageLines = 256;
+    auto const now = chrono::steady_clock::now();
+    auto mc = MockTerm { ColumnCount(300), LineCount(PageLines) };
+
+    auto expected = std::vector<std::string>(PageLines);
+    for (int i = 0; i < PageLines; ++i)
+    {
+        // Lines with mixed attributes are no longer trivial and get rendered cell by cell.
+        auto const suffix = i % 3 == 0 ? "\033[1m!"s : ""s;
+        mc.writeToScreen(std::format("\033[{};1H\033[0;{}mline {}{}", i + 1, 31 + i % 7, i, suffix));
+        expected[static_cast<size_t>(i)] = std::format("line {}{}", i, i % 3 == 0 ? "!" : "");
+    }
+
+    auto const checkScreen = [&]() {
+        mc.terminal.tick(now);
+        mc.terminal.ensureFreshRenderBuffer();
+        auto const lines = textScreenshot(mc.terminal);
+        REQUIRE(lines.size() == expected.size());
+        for (size_t i = 0; i < lines.size(); ++i)
+            CHECK(trimRight(lines[i]) == expected[i]);
+    };
+    checkScreen();
+
+    // Undamaged lines are taken over from the previous frame.
+    mc.writeToScreen("\033[100;1H\033[2KUPDATED");
+    expected[99] = "UPDATED";
+    checkScreen();
+    auto const unmoved = [&](int line) {
+        return mc.terminal.renderBuffer().get().damage.lineRanges.at(static_cast<size_t>(line)).unmoved;
+    };
+    CHECK(unmoved(0));
+    CHECK(!unmoved(99));
+    checkScreen();
+
+    // Lines scrolled up are taken over from where they were shown before.
+    mc.writeToScreen(std::format("\033[{};1H\r\nSCROLLED", PageLines));
+    expected.erase(expected.begin());
+    expected.emplace_back("SCROLLED");
+    checkScreen();
+    CHECK(!unmoved(0));
+
+    // And so are lines scrolled into view.
+    REQUIRE(mc.terminal.viewport().scrollUp(LineCount(1)));
+    expected.insert(expected.begin(), "line 0!");
+    expected.pop_back();
+    checkScreen();
+}
+
+TEST_CASE("Terminal.render_synchronized_output", "[terminal]")
+{
+    auto const now = chrono::steady_clock::now();
+    auto mc = MockTerm { ColumnCount(20), LineCount(5) };
+
+    // Writes the whole page within one batch, as applications using synchronized output do.
+    auto const writePage = [&](std::string_view changedLine) {
+        mc.writeToScreen("\033[?2026h");
+        for (int i = 0; i < 4; ++i)
+            mc.writeToScreen(std::format("\033[{};1H\033[2K\033[3{}m{}",
+                                         i + 1,
+                                         i + 1,
+                                         i == 2 ? changedLine : std::format("line {}", i)));
+        mc.writeToScreen("\033[5;1H\033[?2026l");
+        mc.terminal.tick(now);
+        mc.terminal.ensureFreshRenderBuffer();
+    };
+    auto const unmoved = [&](int line) {
+        return mc.terminal.renderBuffer().get().damage.lineRanges.at(static_cast<size_t>(line)).unmoved;
+    };
+
+    writePage("line 2");
+    writePage("line 2");
+
+    // Lines rewritten with the same contents are taken over from the previous frame.
+    CHECK(unmoved(0));
+    CHECK(unmoved(1));
+    CHECK(unmoved(2));
+    CHECK(unmoved(3));
+
+    writePage("CHANGED");
+    CHECK(unmoved(0));
+    CHECK(!unmoved(2));
+    auto const lines = textScreenshot(mc.terminal);
+    REQUIRE(lines.size() == 5);
+    CHECK(trimRight(lines[1]) == "line 1");
+    CHECK(trimRight(lines[2]) == "CHANGED");
+}
+
 TEST_CASE("Terminal.XTPUSHCOLORS_and_XTPOPCOLORS", "[terminal]")
 {
     using namespace vtbackend;
@@ -537,4 +765,316 @@ TEST_CASE("Terminal.TextSelection_wrapped_line", "[terminal]")
     CHECK(mock.terminal.extractSelectionText().empty());
 }
 
+TEST_CASE("Terminal.TextSelection_matches_debounced", "[terminal]")
+{
+    auto mock = MockTerm { ColumnCount(5), LineCount(2) };
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    mock.terminal.tick(ClockBase);
+    mock.writeToScreen("abcde\r\nabcde");
+    REQUIRE(mock.terminal.visualizeSelectedWord());
+
+    using namespace vtbackend;
+    auto constexpr UiHandledHint = false;
+    auto constexpr PixelCoordinate = vtbackend::PixelCoordinate {};
+    auto const moveTo = [&](ColumnOffset column) {
+        mock.terminal.sendMouseMoveEvent(
+            Modifier::None, 0_lineOffset + column, PixelCoordinate, UiHandledHint);
+    };
+
+    moveTo(0_columnOffset);
+    mock.terminal.sendMousePressEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
+    moveTo(1_columnOffset);
+    moveTo(2_columnOffset);
+    CHECK(mock.terminal.search().pattern.empty()); // not while the mouse keeps moving
+
+    mock.terminal.tick(ClockBase + 1s);
+    CHECK(mock.terminal.search().pattern == U"abc");
+
+    moveTo(3_columnOffset);
+    mock.terminal.sendMouseReleaseEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
+    CHECK(mock.terminal.search().pattern == U"abcd");
+}
+
+TEST_CASE("Terminal.TextSelection_streamed", "[terminal]")
+{
+    auto constexpr PageLines = 700;
+    auto mock = MockTerm { ColumnCount(100), LineCount(PageLines) };
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    mock.terminal.tick(ClockBase);
+
+    auto expectedText = std::string {};
+    for (auto const i: crispy::times(PageLines))
+    {
+        auto const line = std::string(99, static_cast<char>('a' + (i % 26)));
+        mock.writeToScreen(i + 1 < PageLines ? line + "\r\n" : line);
+        expectedText += line;
+        if (i + 1 < PageLines)
+            expectedText += '\n';
+    }
+
+    using namespace vtbackend;
+    auto constexpr UiHandledHint = false;
+    auto constexpr PixelCoordinate = vtbackend::PixelCoordinate {};
+
+    mock.terminal.tick(ClockBase + chrono::seconds(1));
+    mock.terminal.sendMouseMoveEvent(
+        Modifier::None, 0_lineOffset + 0_columnOffset, PixelCoordinate, UiHandledHint);
+    mock.terminal.tick(ClockBase + chrono::seconds(2));
+    mock.terminal.sendMousePressEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
+    mock.terminal.tick(ClockBase + chrono::seconds(3));
+    mock.terminal.sendMouseMoveEvent(Modifier::None,
+                                     LineOffset(PageLines - 1) + ColumnOffset(98),
+                                     PixelCoordinate,
+                                     UiHandledHint);
+
+    auto chunks = std::vector<std::string> {};
+    mock.terminal.extractSelectionText([&](std::string_view chunk) { chunks.emplace_back(chunk); });
+
+    // The selection exceeds the chunk size, so it must have been delivered in several pieces.
+    REQUIRE(chunks.size() > 1);
+    auto streamedText = std::string {};
+    for (auto const& chunk: chunks)
+    {
+        CHECK(chunk.size() < Terminal::TextExtractionChunkSize + 100);
+        streamedText += chunk;
+    }
+    CHECK(streamedText == expectedText);
+    CHECK(mock.terminal.extractSelectionText() == expectedText);
+
+    // A snapshot of the selection yields the same text, even once the page has been changed meanwhile.
+    auto const snapshot = mock.terminal.selectionTextSnapshot();
+    CHECK(snapshot.lineCount == PageLines);
+    REQUIRE(snapshot.nextChunk);
+    mock.writeToScreen("\033[2J");
+    auto snapshotText = std::string {};
+    for (auto chunk = snapshot.nextChunk(); !chunk.empty(); chunk = snapshot.nextChunk())
+        snapshotText += chunk;
+    CHECK(snapshotText == expectedText);
+}
+
+TEST_CASE("Terminal.AdaptivePtyReadSize", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(10), ColumnCount(80) }, LineCount(100), 1024 };
+    CHECK(mock.terminal.ptyReadStats().readSize == 1024);
+
+    // Bulk output keeps filling the read buffer, which grows the read size up to its cap.
+    // The output size is chosen such that the last read fills the read buffer as well.
+    mock.writeToScreen(std::string(((1 + 2 + 4 + 8) * 1024) + (15 * 16 * 1024), 'A'));
+    CHECK(mock.terminal.ptyReadStats().readSize == 16 * 1024);
+
+    // Small interactive reads shrink it again.
+    mock.writeToScreen("x");
+    CHECK(mock.terminal.ptyReadStats().readSize == 8 * 1024);
+    for (auto i = 0; i < 8; ++i)
+        mock.writeToScreen("x");
+    CHECK(mock.terminal.ptyReadStats().readSize == 1024);
+
+    auto const& histogram = mock.terminal.ptyReadStats().histogram;
+    CHECK(histogram[1] == 9); // 9 reads of a single byte
+    CHECK(histogram[15] > 0); // reads of 16 KB
+}
+
+TEST_CASE("Terminal.sendPasteStream", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(5), ColumnCount(20) } };
+    mock.writeToScreen("\033[?2004h"); // enable bracketed paste
+
+    auto chunks = std::vector<std::string> { "Hello", ", ", "World" };
+    mock.terminal.sendPasteStream([chunks, i = size_t { 0 }]() mutable -> std::string {
+        return i < chunks.size() ? chunks[i++] : std::string {};
+    });
+
+    auto const deadline = std::chrono::steady_clock::now() + 10s;
+    while (mock.terminal.pasteInProgress() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(1ms);
+
+    // The markers wrap the stream as a whole.
+    CHECK(e(mock.replyData()) == e("\033[200~Hello, World\033[201~"));
+    CHECK(mock.terminal.pastedBytes() == 24);
+}
+
+TEST_CASE("Terminal.hibernate", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    mock.writeToScreen("12345\r\n67890\r\nABCDE\r\nabcde");
+    CHECK(mock.terminal.refreshRenderBuffer());
+
+    {
+        auto const _ = std::scoped_lock { mock.terminal };
+        mock.terminal.hibernate();
+    }
+    CHECK(mock.terminal.hibernated());
+    CHECK(!mock.terminal.primaryScreen().grid().lineAt(LineOffset(-1)).isInflatedBuffer());
+    CHECK(!mock.terminal.primaryScreen().grid().lineAt(LineOffset(0)).isInflatedBuffer());
+
+    // Output is still processed while hibernated, but the render buffer is not refreshed.
+    mock.writeToScreen("\r\nfghij");
+    CHECK_FALSE(mock.terminal.refreshRenderBuffer());
+    CHECK(mock.terminal.primaryScreen().historyLineCount() == LineCount(2));
+
+    mock.terminal.revive();
+    CHECK(!mock.terminal.hibernated());
+    CHECK(mock.terminal.refreshRenderBuffer());
+    CHECK("ABCDE\nabcde\nfghij" == trimmedTextScreenshot(mock));
+}
+
+TEST_CASE("Terminal.input_without_state_lock", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    auto const now = std::chrono::steady_clock::now();
+
+    {
+        // Keys are still typed while the state is locked, e.g. for parsing.
+        auto const _ = std::scoped_lock { mock.terminal };
+        std::thread([&]() { mock.sendCharEvent('x', Modifier {}, now); }).join();
+    }
+
+    auto const deadline = now + 10s;
+    while (mock.replyData().empty() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(1ms);
+    CHECK(mock.replyData() == "x");
+}
+
+TEST_CASE("Terminal.publishedCursorPosition", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    mock.writeToScreen("ab\r\ncde");
+    CHECK(mock.terminal.publishedCursorPosition() == CellLocation { LineOffset(1), ColumnOffset(3) });
+}
+
+TEST_CASE("Terminal.setVisible", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    mock.writeToScreen("12345");
+    REQUIRE(mock.terminal.refreshRenderBuffer());
+    auto const frameID = mock.terminal.renderBuffer().get().frameID;
+
+    // Output is still processed while hidden, but no render buffer is filled for it.
+    mock.terminal.setVisible(false);
+    CHECK_FALSE(mock.terminal.visible());
+    mock.writeToScreen("\r\n67890\r\nABCDE");
+    CHECK_FALSE(mock.terminal.refreshRenderBuffer());
+    CHECK(mock.terminal.renderBuffer().get().frameID == frameID);
+
+    // A single frame catches up once shown again.
+    mock.terminal.setVisible(true);
+    CHECK(mock.terminal.refreshRenderBuffer());
+    CHECK(mock.terminal.renderBuffer().get().frameID == frameID + 1);
+    CHECK("12345\n67890\nABCDE" == trimmedTextScreenshot(mock));
+}
+
+TEST_CASE("Terminal.contentFrameID", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(10) };
+    auto& terminal = mock.terminal;
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+    terminal.setCursorShape(vtbackend::CursorShape::Bar);
+    terminal.setCursorDisplay(vtbackend::CursorDisplay::Blink);
+    terminal.setCursorBlinkingInterval(500ms);
+
+    mock.writeToScreen("12345");
+    terminal.tick(ClockBase);
+    REQUIRE(terminal.refreshRenderBuffer());
+    auto const first = terminal.renderBuffer().get().frameID;
+    CHECK(terminal.renderBuffer().get().contentFrameID == first);
+    CHECK(terminal.renderBuffer().get().cursor.has_value());
+
+    // The cursor blinking does not change the contents.
+    terminal.tick(ClockBase + 500ms);
+    REQUIRE(terminal.refreshRenderBuffer());
+    CHECK(!terminal.renderBuffer().get().cursor.has_value());
+    CHECK(terminal.renderBuffer().get().frameID != first);
+    CHECK(terminal.renderBuffer().get().contentFrameID == first);
+
+    mock.writeToScreen("6");
+    REQUIRE(terminal.refreshRenderBuffer());
+    CHECK(terminal.renderBuffer().get().contentFrameID == terminal.renderBuffer().get().frameID);
+}
+
+TEST_CASE("Terminal.highlightedRanges", "[terminal]")
+{
+    auto mock = MockTerm { PageSize { LineCount(4), ColumnCount(10) }, LineCount(10) };
+    auto& terminal = mock.terminal;
+    auto const at = [](int line, int column) {
+        return vtbackend::CellLocation { .line = LineOffset(line), .column = ColumnOffset(column) };
+    };
+
+    CHECK(terminal.highlightedRanges(LineOffset(0), LineOffset(3)).empty());
+
+    // Linear highlights are given in either direction.
+    terminal.setHighlightRange(vtbackend::LinearHighlight { .from = at(3, 2), .to = at(1, 5) });
+    auto const linear = terminal.highlightedRanges(LineOffset(2), LineOffset(3));
+    REQUIRE(linear.size() == 2);
+    CHECK(linear[0].line == LineOffset(2));
+    CHECK(linear[0].fromColumn == ColumnOffset(0));
+    CHECK(linear[0].toColumn == ColumnOffset(9));
+    CHECK(linear[1].line == LineOffset(3));
+    CHECK(linear[1].fromColumn == ColumnOffset(0));
+    CHECK(linear[1].toColumn == ColumnOffset(2));
+
+    terminal.setHighlightRange(vtbackend::RectangularHighlight { .from = at(2, 6), .to = at(0, 3) });
+    auto const rectangular = terminal.highlightedRanges(LineOffset(0), LineOffset(3));
+    REQUIRE(rectangular.size() == 3);
+    for (auto const& range: rectangular)
+    {
+        CHECK(range.fromColumn == ColumnOffset(3));
+        CHECK(range.toColumn == ColumnOffset(6));
+        auto const cell = vtbackend::CellLocation { .line = range.line, .column = ColumnOffset(4) };
+        CHECK(terminal.isHighlighted(cell));
+    }
+    CHECK(rectangular[0].line == LineOffset(0));
+    CHECK(rectangular[2].line == LineOffset(2));
+}
+
+TEST_CASE("Terminal.CellLayout", "[terminal]")
+{
+    using vtbackend::CellLayout;
+    auto constexpr ClockBase = chrono::steady_clock::time_point();
+
+    auto constexpr IsSimpleScreen = [](auto const& screen) {
+        return is_same_v<remove_cvref_t<decltype(screen)>, vtbackend::Screen<vtbackend::SimpleCell>>;
+    };
+
+    auto mock =
+        MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10), 1024, CellLayout::Simple };
+    CHECK(mock.terminal.cellLayout() == CellLayout::Simple);
+    CHECK(mock.terminal.visitPrimaryScreen(IsSimpleScreen));
+
+    mock.writeToScreen("1\r\n\033[31m2\033[m\r\n3\r\n4\r\n5");
+    mock.terminal.tick(ClockBase + chrono::seconds(1));
+    mock.terminal.ensureFreshRenderBuffer();
+    CHECK("3\n4\n5" == trimmedTextScreenshot(mock));
+    CHECK(mock.terminal.primaryScreenBase().historyLineCount() == LineCount(2));
+    CHECK(mock.terminal.primaryScreenBase().cellTextAt({ LineOffset(-1), ColumnOffset(0) }) == "2");
+
+    // The alternate screen uses the same cell layout.
+    mock.writeToScreen("\033[?1049hA");
+    CHECK(mock.terminal.isAlternateScreen());
+    CHECK(mock.terminal.currentScreen().cellTextAt({ LineOffset(0), ColumnOffset(0) }) == "A");
+    CHECK(mock.terminal.visitAlternateScreen(IsSimpleScreen));
+}
+
+TEST_CASE("Terminal.releaseGrids", "[terminal]")
+{
+    using vtbackend::CellLayout;
+    for (auto const cellLayout: { CellLayout::Compact, CellLayout::Simple })
+    {
+        INFO(std::format("simple cells: {}", cellLayout == CellLayout::Simple));
+        auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10), 1024, cellLayout };
+
+        // Lines may be released again while the ones released first are still being destroyed.
+        for (auto const i: { 1, 2 })
+        {
+            INFO(std::format("release {}", i));
+            mock.writeToScreen("1\r\n2\r\n3\r\n4\r\n5");
+            CHECK(mock.terminal.primaryScreenBase().historyLineCount() != LineCount(0));
+            {
+                auto const _ = std::scoped_lock { mock.terminal };
+                mock.terminal.releaseGrids();
+            }
+            CHECK(mock.terminal.primaryScreenBase().historyLineCount() == LineCount(0));
+        }
+    }
+}
+
 // NOLINTEND(misc-const-correctness)
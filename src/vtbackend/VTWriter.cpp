@@ -1,19 +1,204 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/VTWriter.h>
 
-#include <numeric>
+#include <libunicode/convert.h>
+
+#include <array>
+#include <charconv>
+#include <string_view>
 
 using std::string;
 using std::string_view;
-using std::vector;
 
 namespace vtbackend
 {
 
-// TODO: compare with old sgr value set instead to be more generic in reusing stuff
+namespace
+{
+    /// Cell flags that are expressed via SGR. The others are either no rendition at all
+    /// (character protection) or implied by the text (wide character continuation).
+    constexpr auto SgrFlags = CellFlags { CellFlag::Bold,
+                                          CellFlag::Faint,
+                                          CellFlag::Italic,
+                                          CellFlag::Underline,
+                                          CellFlag::Blinking,
+                                          CellFlag::RapidBlinking,
+                                          CellFlag::Inverse,
+                                          CellFlag::Hidden,
+                                          CellFlag::CrossedOut,
+                                          CellFlag::DoublyUnderlined,
+                                          CellFlag::CurlyUnderlined,
+                                          CellFlag::DottedUnderline,
+                                          CellFlag::DashedUnderline,
+                                          CellFlag::Framed,
+                                          CellFlag::Encircled,
+                                          CellFlag::Overline };
+
+    /// Cell flags that are visible on blank cells, too, preventing those from being erased instead.
+    constexpr auto BlankVisibleFlags = CellFlags { CellFlag::Underline,        CellFlag::DoublyUnderlined,
+                                                   CellFlag::CurlyUnderlined,  CellFlag::DottedUnderline,
+                                                   CellFlag::DashedUnderline,  CellFlag::Inverse,
+                                                   CellFlag::CrossedOut,       CellFlag::Framed,
+                                                   CellFlag::Encircled,        CellFlag::Overline };
+
+    struct FlagEnable
+    {
+        CellFlag flag;
+        string_view parameter;
+    };
+
+    constexpr auto FlagEnables = std::array {
+        FlagEnable { CellFlag::Bold, "1" },
+        FlagEnable { CellFlag::Faint, "2" },
+        FlagEnable { CellFlag::Italic, "3" },
+        FlagEnable { CellFlag::Underline, "4" },
+        FlagEnable { CellFlag::CurlyUnderlined, "4:3" },
+        FlagEnable { CellFlag::DottedUnderline, "4:4" },
+        FlagEnable { CellFlag::DashedUnderline, "4:5" },
+        FlagEnable { CellFlag::Blinking, "5" },
+        FlagEnable { CellFlag::RapidBlinking, "6" },
+        FlagEnable { CellFlag::Inverse, "7" },
+        FlagEnable { CellFlag::Hidden, "8" },
+        FlagEnable { CellFlag::CrossedOut, "9" },
+        FlagEnable { CellFlag::DoublyUnderlined, "21" },
+        FlagEnable { CellFlag::Framed, "51" },
+        FlagEnable { CellFlag::Encircled, "52" },
+        FlagEnable { CellFlag::Overline, "53" },
+    };
+
+    /// SGR parameters that disable a whole group of flags at once.
+    struct FlagGroupDisable
+    {
+        CellFlags flags;
+        string_view parameter;
+    };
+
+    constexpr auto FlagGroupDisables = std::array {
+        FlagGroupDisable { CellFlags { CellFlag::Bold, CellFlag::Faint }, "22" },
+        FlagGroupDisable { CellFlag::Italic, "23" },
+        FlagGroupDisable { CellFlags { CellFlag::Underline,
+                                       CellFlag::DoublyUnderlined,
+                                       CellFlag::CurlyUnderlined,
+                                       CellFlag::DottedUnderline,
+                                       CellFlag::DashedUnderline },
+                           "24" },
+        FlagGroupDisable { CellFlags { CellFlag::Blinking, CellFlag::RapidBlinking }, "25" },
+        FlagGroupDisable { CellFlag::Inverse, "27" },
+        FlagGroupDisable { CellFlag::Hidden, "28" },
+        FlagGroupDisable { CellFlag::CrossedOut, "29" },
+        FlagGroupDisable { CellFlags { CellFlag::Framed, CellFlag::Encircled }, "54" },
+        FlagGroupDisable { CellFlag::Overline, "55" },
+    };
+
+    void appendNumber(string& output, unsigned value)
+    {
+        auto buffer = std::array<char, 16> {};
+        auto const result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+        output.append(buffer.data(), result.ptr);
+    }
+
+    void appendParameter(string& output, string_view parameter)
+    {
+        if (!output.empty())
+            output += ';';
+        output += parameter;
+    }
+
+    void appendParameter(string& output, unsigned value)
+    {
+        if (!output.empty())
+            output += ';';
+        appendNumber(output, value);
+    }
+
+    /// Appends the SGR parameters selecting the given color.
+    ///
+    /// @param base 30 for the foreground, 40 for the background, and 50 for the underline color.
+    void appendColor(string& output, Color color, unsigned base)
+    {
+        switch (color.type())
+        {
+            case ColorType::Default: appendParameter(output, base + 9); break;
+            case ColorType::Indexed:
+                if (static_cast<unsigned>(color.index()) < 8 && base != 50)
+                    appendParameter(output, base + static_cast<unsigned>(color.index()));
+                else
+                {
+                    appendParameter(output, base + 8);
+                    appendParameter(output, 5);
+                    appendParameter(output, static_cast<unsigned>(color.index()));
+                }
+                break;
+            case ColorType::Bright:
+                if (base != 50)
+                    appendParameter(output, base + 60 + static_cast<unsigned>(getBrightColor(color)));
+                else
+                {
+                    appendParameter(output, base + 8);
+                    appendParameter(output, 5);
+                    appendParameter(output, 8 + static_cast<unsigned>(getBrightColor(color)));
+                }
+                break;
+            case ColorType::RGB:
+                appendParameter(output, base + 8);
+                appendParameter(output, 2);
+                appendParameter(output, static_cast<unsigned>(color.rgb().red));
+                appendParameter(output, static_cast<unsigned>(color.rgb().green));
+                appendParameter(output, static_cast<unsigned>(color.rgb().blue));
+                break;
+            case ColorType::Undefined:
+                //.
+                break;
+        }
+    }
+
+    /// Appends the SGR parameters needed to switch the graphics attributes from @p from to @p to.
+    void appendAttributeChanges(string& output, GraphicsAttributes const& from, GraphicsAttributes const& to)
+    {
+        auto flags = from.flags;
+        for (auto const& group: FlagGroupDisables)
+        {
+            if ((flags & group.flags).without(to.flags).any())
+            {
+                appendParameter(output, group.parameter);
+                flags = flags.without(group.flags);
+            }
+        }
+
+        auto const enabledFlags = to.flags.without(flags);
+        for (auto const& enable: FlagEnables)
+            if (enabledFlags.test(enable.flag))
+                appendParameter(output, enable.parameter);
+
+        if (from.foregroundColor != to.foregroundColor)
+            appendColor(output, to.foregroundColor, 30);
+        if (from.backgroundColor != to.backgroundColor)
+            appendColor(output, to.backgroundColor, 40);
+        if (from.underlineColor != to.underlineColor)
+            appendColor(output, to.underlineColor, 50);
+    }
+
+    template <CellConcept Cell>
+    GraphicsAttributes attributesOf(Cell const& cell) noexcept
+    {
+        return GraphicsAttributes {
+            .foregroundColor = cell.foregroundColor(),
+            .backgroundColor = cell.backgroundColor(),
+            .underlineColor = cell.underlineColor(),
+            .flags = cell.flags() & SgrFlags,
+        };
+    }
+
+    template <CellConcept Cell>
+    bool isBlank(Cell const& cell) noexcept
+    {
+        return cell.codepointCount() == 0 || (cell.codepointCount() == 1 && cell.codepoint(0) == ' ');
+    }
+} // namespace
 
 VTWriter::VTWriter(Writer writer): _writer { std::move(writer) }
 {
+    _buffer.reserve(BufferCapacity);
 }
 
 VTWriter::VTWriter(std::ostream& output):
@@ -30,162 +215,80 @@ VTWriter::VTWriter(std::vector<char>& output):
 {
 }
 
+VTWriter::~VTWriter()
+{
+    flush();
+}
+
+void VTWriter::flush()
+{
+    if (_buffer.empty())
+        return;
+
+    _writer(_buffer.data(), _buffer.size());
+    _buffer.clear();
+}
+
 void VTWriter::write(char32_t v)
 {
-    sgrFlush();
     char buf[4];
     auto enc = unicode::encoder<char> {};
     auto count = std::distance(buf, enc(v, buf));
-    write(string_view(buf, static_cast<size_t>(count)));
+    _buffer.append(buf, static_cast<size_t>(count));
+    flushIfFull();
 }
 
 void VTWriter::write(string_view s)
 {
-    sgrFlush();
-    _writer(s.data(), s.size());
+    _buffer += s;
+    flushIfFull();
 }
 
-void VTWriter::sgrFlush()
+void VTWriter::setAttributes(GraphicsAttributes const& attributes)
 {
-    if (_sgr.empty())
+    auto next = attributes;
+    next.flags = next.flags & SgrFlags;
+    if (next == _attributes)
         return;
 
-    auto const f = sgrFlush(_sgr);
-    if (_sgr != _lastSGR)
-        _writer(f.data(), f.size());
-
-    sgrRewind();
-}
-
-string VTWriter::sgrFlush(vector<unsigned> const& sgr)
-{
-    if (sgr.empty())
-        return "";
-
-    auto const params =
-        sgr.size() != 1 || sgr[0] != 0
-            ? accumulate(begin(sgr),
-                         end(sgr),
-                         string {},
-                         [](auto a, auto b) {
-                             return a.empty() ? std::format("{}", b) : std::format("{};{}", a, b);
-                         })
-            : string();
-
-    return std::format("\033[{}m", params);
-}
-
-void VTWriter::sgrAddExplicit(unsigned n)
-{
-    if (n == 0)
-    {
-        _currentForegroundColor = DefaultColor();
-        _currentBackgroundColor = DefaultColor();
-        _currentUnderlineColor = DefaultColor();
-    }
+    // Pick whichever is shorter: changing the current attributes, or starting over from a reset.
+    auto delta = string {};
+    appendAttributeChanges(delta, _attributes, next);
 
-    _sgr.push_back(n);
-}
+    auto fromReset = string {};
+    appendAttributeChanges(fromReset, GraphicsAttributes {}, next);
 
-void VTWriter::sgrAdd(unsigned n)
-{
-    if (n == 0)
+    // A plain "CSI m" resets all attributes.
+    _buffer += "\033[";
+    if (!fromReset.empty())
     {
-        _sgr.clear();
-        _sgr.push_back(n);
-        _currentForegroundColor = DefaultColor();
-        _currentBackgroundColor = DefaultColor();
-        _currentUnderlineColor = DefaultColor();
-    }
-    else
-    {
-        if (_sgr.empty() || _sgr.back() != n)
-            _sgr.push_back(n);
-
-        if (_sgr.size() == MaxParameterCount)
+        if (delta.size() <= fromReset.size() + 2)
+            _buffer += delta;
+        else
         {
-            sgrFlush();
+            _buffer += "0;";
+            _buffer += fromReset;
         }
     }
-}
-
-void VTWriter::sgrRewind()
-{
-    swap(_lastSGR, _sgr);
-    _sgr.clear();
-}
-
-void VTWriter::sgrAdd(GraphicsRendition m)
-{
-    sgrAdd(static_cast<unsigned>(m));
-}
-
-void VTWriter::setForegroundColor(Color color)
-{
-    // if (color == _currentForegroundColor)
-    //     return;
+    _buffer += 'm';
 
-    _currentForegroundColor = color;
-    switch (color.type())
-    {
-        case ColorType::Default:
-            //.
-            sgrAdd(39);
-            break;
-        case ColorType::Indexed:
-            if (static_cast<unsigned>(color.index()) < 8)
-                sgrAdd(30 + static_cast<unsigned>(color.index()));
-            else
-                sgrAdd(38, 5, static_cast<unsigned>(color.index()));
-            break;
-        case ColorType::Bright:
-            //.
-            sgrAdd(90 + static_cast<unsigned>(getBrightColor(color)));
-            break;
-        case ColorType::RGB:
-            // clang-format off
-            sgrAdd(38, 2, static_cast<unsigned>(color.rgb().red),
-                          static_cast<unsigned>(color.rgb().green),
-                          static_cast<unsigned>(color.rgb().blue));
-            // clang-format on
-            break;
-        case ColorType::Undefined: break;
-    }
+    _attributes = next;
 }
 
-void VTWriter::setBackgroundColor(Color color)
+void VTWriter::writeBlanks(size_t count, bool toEndOfLine)
 {
-    // if (color == _currentBackgroundColor)
-    //     return;
-
-    _currentBackgroundColor = color;
-    switch (color.type())
+    if ((_attributes.flags & BlankVisibleFlags).any() || (!toEndOfLine && count < MinBlankRunLength))
+        _buffer.append(count, ' ');
+    else if (toEndOfLine)
+        _buffer += "\033[K";
+    else
     {
-        case ColorType::Default: sgrAdd(49); break;
-        case ColorType::Indexed:
-            if (static_cast<unsigned>(color.index()) < 8)
-                sgrAdd(40 + static_cast<unsigned>(color.index()));
-            else
-            {
-                sgrAdd(48);
-                sgrAdd(5);
-                sgrAdd(static_cast<unsigned>(color.index()));
-            }
-            break;
-        case ColorType::Bright:
-            //.
-            sgrAdd(100 + static_cast<unsigned>(getBrightColor(color)));
-            break;
-        case ColorType::RGB:
-            sgrAdd(48);
-            sgrAdd(2);
-            sgrAdd(static_cast<unsigned>(color.rgb().red));
-            sgrAdd(static_cast<unsigned>(color.rgb().green));
-            sgrAdd(static_cast<unsigned>(color.rgb().blue));
-            break;
-        case ColorType::Undefined:
-            //.
-            break;
+        // Erase the blank cells and move the cursor past them.
+        _buffer += "\033[";
+        appendNumber(_buffer, static_cast<unsigned>(count));
+        _buffer += "X\033[";
+        appendNumber(_buffer, static_cast<unsigned>(count));
+        _buffer += 'C';
     }
 }
 
@@ -195,33 +298,52 @@ void VTWriter::write(Line<Cell> const& line)
     if (line.isTrivialBuffer())
     {
         TrivialLineBuffer const& lineBuffer = line.trivialBuffer();
-        setForegroundColor(lineBuffer.textAttributes.foregroundColor);
-        setBackgroundColor(lineBuffer.textAttributes.backgroundColor);
-        // TODO: hyperlinks, underlineColor and other flags (curly underline etc.)
-        write(line.toUtf8());
-        // TODO: Write fill columns.
+        // TODO: hyperlinks
+        setAttributes(lineBuffer.textAttributes);
+        _buffer.append(lineBuffer.text.data(), lineBuffer.text.size());
+        if (lineBuffer.usedColumns < lineBuffer.displayWidth)
+        {
+            setAttributes(lineBuffer.fillAttributes);
+            writeBlanks(unbox<size_t>(lineBuffer.displayWidth - lineBuffer.usedColumns), true);
+        }
     }
     else
     {
-        for (Cell const& cell: line.inflatedBuffer())
+        auto const& cells = line.inflatedBuffer();
+        auto enc = unicode::encoder<char> {};
+        for (size_t i = 0; i < cells.size();)
         {
-            if (cell.flags() & CellFlag::Bold)
-                sgrAdd(GraphicsRendition::Bold);
-            else
-                sgrAdd(GraphicsRendition::Normal);
-
-            setForegroundColor(cell.foregroundColor());
-            setBackgroundColor(cell.backgroundColor());
-            // TODO: other flags (such as underline), hyperlinks, image fragments.
-
-            if (!cell.codepointCount())
-                write(' ');
-            else
-                write(cell.toUtf8());
+            Cell const& cell = cells[i];
+            if (cell.flags() & CellFlag::WideCharContinuation)
+            {
+                ++i;
+                continue;
+            }
+
+            // TODO: hyperlinks, image fragments.
+            setAttributes(attributesOf(cell));
+
+            if (isBlank(cell))
+            {
+                auto end = i + 1;
+                while (end < cells.size() && isBlank(cells[end]) && attributesOf(cells[end]) == _attributes)
+                    ++end;
+                writeBlanks(end - i, end == cells.size());
+                i = end;
+                continue;
+            }
+
+            for (size_t k = 0; k < cell.codepointCount(); ++k)
+            {
+                char buf[4];
+                auto const count = std::distance(buf, enc(cell.codepoint(k), buf));
+                _buffer.append(buf, static_cast<size_t>(count));
+            }
+            ++i;
         }
     }
 
-    sgrAdd(GraphicsRendition::Reset);
+    flushIfFull();
 }
 
 } // namespace vtbackend
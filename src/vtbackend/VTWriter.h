@@ -2,33 +2,49 @@
 #pragma once
 
 #include <vtbackend/Color.h>
+#include <vtbackend/GraphicsAttributes.h>
 #include <vtbackend/Line.h>
 #include <vtbackend/cell/CellConcept.h>
 #include <vtbackend/primitives.h>
 
-#include <libunicode/convert.h>
-
 #include <format>
 #include <functional>
+#include <iterator>
 #include <ostream>
-#include <sstream>
+#include <string>
 #include <vector>
 
 namespace vtbackend
 {
 
 // Serializes text and SGR attributes into a valid VT stream.
+//
+// The writer remembers the graphics attributes it last emitted and only writes the SGR parameters
+// needed to get from there to the next attributes. Runs of blank cells are not written out as
+// spaces but erased and skipped over. All output is collected in a pre-reserved buffer that is
+// handed to the underlying writer in large chunks, so the generated stream can be re-parsed
+// mostly as bulk text.
 class VTWriter
 {
   public:
     using Writer = std::function<void(char const*, size_t)>;
 
-    static constexpr inline auto MaxParameterCount = 16;
+    /// Number of bytes buffered before they are handed to the underlying writer.
+    static constexpr inline size_t BufferCapacity = 64 * 1024;
+
+    /// Minimal number of blank cells to erase and skip over rather than writing them out as spaces.
+    static constexpr inline size_t MinBlankRunLength = 8;
 
     explicit VTWriter(Writer writer);
     explicit VTWriter(std::ostream& output);
     explicit VTWriter(std::vector<char>& output);
 
+    VTWriter(VTWriter const&) = delete;
+    VTWriter(VTWriter&&) = delete;
+    VTWriter& operator=(VTWriter const&) = delete;
+    VTWriter& operator=(VTWriter&&) = delete;
+    ~VTWriter();
+
     void crlf();
 
     // Writes the given Line<> to the output stream without the trailing newline.
@@ -36,49 +52,40 @@ class VTWriter
     void write(Line<Cell> const& line);
 
     template <typename... T>
-    void write(std::format_string<T...> fmt, T const&... args);
+    void write(std::format_string<T...> fmt, T&&... args);
     void write(std::string_view s);
     void write(char32_t v);
 
-    void sgrFlush();
-    void sgrAdd(unsigned n);
-    void sgrRewind();
-    void sgrAdd(GraphicsRendition m);
-    void setForegroundColor(Color color);
-    void setBackgroundColor(Color color);
+    /// Emits the SGR parameters needed to switch from the current graphics attributes to @p attributes.
+    void setAttributes(GraphicsAttributes const& attributes);
 
-    void sgrAddExplicit(unsigned n);
+    /// Resets the graphics attributes to their defaults, if not already.
+    void resetAttributes() { setAttributes(GraphicsAttributes {}); }
 
-    template <typename... Args>
-    void sgrAdd(unsigned n, Args... values)
-    {
-        if (_sgr.size() + sizeof...(values) > MaxParameterCount)
-            sgrFlush();
+    [[nodiscard]] GraphicsAttributes const& attributes() const noexcept { return _attributes; }
 
-        sgrAddExplicit(n);
-        (sgrAddExplicit(static_cast<unsigned>(values)), ...);
-    }
+    /// Hands all buffered output to the underlying writer.
+    void flush();
 
   private:
-    static std::string sgrFlush(std::vector<unsigned> const& sgr);
+    void flushIfFull()
+    {
+        if (_buffer.size() >= BufferCapacity)
+            flush();
+    }
+
+    void writeBlanks(size_t count, bool toEndOfLine);
 
     Writer _writer;
-    std::vector<unsigned> _sgr;
-    std::stringstream _sstr;
-    std::vector<unsigned> _lastSGR;
-    Color _currentForegroundColor = DefaultColor();
-    Color _currentUnderlineColor = DefaultColor();
-    Color _currentBackgroundColor = DefaultColor();
+    std::string _buffer;
+    GraphicsAttributes _attributes {};
 };
 
 template <typename... Ts>
-inline void VTWriter::write(std::format_string<Ts...> fmt, Ts const&... args)
+inline void VTWriter::write(std::format_string<Ts...> fmt, Ts&&... args)
 {
-#if defined(__APPLE__)
-    write(std::vformat(fmt, std::make_format_args(args...)));
-#else
-    write(std::vformat(fmt, std::make_format_args(std::forward<Ts>(args)...)));
-#endif
+    std::format_to(std::back_inserter(_buffer), fmt, std::forward<Ts>(args)...);
+    flushIfFull();
 }
 
 inline void VTWriter::crlf()
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/VTWriter.h>
+#include <vtbackend/cell/CellConfig.h>
+
+#include <crispy/escape.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace std;
+
+using namespace vtbackend;
+using namespace crispy;
+
+// Default cell type for testing.
+using Cell = PrimaryScreenCell;
+
+namespace
+{
+
+std::string writeToString(auto&& callback)
+{
+    auto output = std::vector<char> {};
+    {
+        auto writer = VTWriter(output);
+        callback(writer);
+    }
+    return { output.begin(), output.end() };
+}
+
+} // namespace
+
+TEST_CASE("VTWriter.setAttributes", "[VTWriter]")
+{
+    auto boldRed = GraphicsAttributes {};
+    boldRed.foregroundColor = IndexedColor::Red;
+    boldRed.flags = CellFlag::Bold;
+
+    auto bold = GraphicsAttributes {};
+    bold.flags = CellFlag::Bold;
+
+    auto const output = writeToString([&](VTWriter& writer) {
+        writer.setAttributes(boldRed);
+        writer.setAttributes(boldRed);
+        writer.setAttributes(bold);
+        writer.setAttributes(bold.with(CellFlag::CurlyUnderlined));
+        writer.resetAttributes();
+    });
+
+    // Only the changes are written, and nothing at all if nothing changed.
+    CHECK(escape(output) == escape("\033[1;31m\033[39m\033[4:3m\033[m"sv));
+}
+
+TEST_CASE("VTWriter.write_line", "[VTWriter]")
+{
+    auto boldRed = GraphicsAttributes {};
+    boldRed.foregroundColor = IndexedColor::Red;
+    boldRed.flags = CellFlag::Bold;
+
+    auto cells = InflatedLineBuffer<Cell>(20, Cell {});
+    cells[0].write(boldRed, U'a', 1);
+    cells[1].write(boldRed, U'b', 1);
+    cells[2].write(boldRed.with(CellFlag::Italic), U'c', 1);
+    cells[14].write(GraphicsAttributes {}, U'd', 1);
+    auto const line = Line<Cell>(LineFlag::None, cells);
+
+    auto const output = writeToString([&](VTWriter& writer) { writer.write(line); });
+
+    // Runs of blank cells are erased and skipped over, and trailing ones erased up to the line end.
+    CHECK(escape(output) == escape("\033[1;31mab\033[3mc\033[m\033[11X\033[11Cd\033[K"sv));
+}
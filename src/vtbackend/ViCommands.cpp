@@ -108,10 +108,13 @@ namespace
 
     CellLocation getRightMostNonEmptyCellLocation(Terminal const& terminal, LineOffset lineOffset) noexcept
     {
+        auto const rightMostNonEmpty = [&](auto const& screen) {
+            return screen.grid().rightMostNonEmptyAt(lineOffset);
+        };
         if (terminal.isPrimaryScreen())
-            return terminal.primaryScreen().grid().rightMostNonEmptyAt(lineOffset);
+            return terminal.visitPrimaryScreen(rightMostNonEmpty);
         else
-            return terminal.alternateScreen().grid().rightMostNonEmptyAt(lineOffset);
+            return terminal.visitAlternateScreen(rightMostNonEmpty);
     }
 
     constexpr std::optional<std::pair<char, bool>> matchingPairOfChar(char32_t input) noexcept
@@ -148,6 +151,18 @@ namespace
         }
     }
 
+    /// @returns the number of lines the given motion may move the cursor up by.
+    LineCount linesUpOf(Terminal const& terminal, ViMotion motion, unsigned count) noexcept
+    {
+        switch (motion)
+        {
+            case ViMotion::FileBegin: return terminal.spilledHistoryLineCount();
+            case ViMotion::LineUp: return LineCount::cast_from(count);
+            case ViMotion::PageUp: return LineCount::cast_from(*terminal.pageSize().lines / 2);
+            default: return LineCount(0);
+        }
+    }
+
     constexpr ViMotion invertCharMove(ViMotion motion) noexcept
     {
         switch (motion)
@@ -188,7 +203,7 @@ void ViCommands::searchDone()
 
 void ViCommands::searchCancel()
 {
-    _terminal->search().pattern.clear();
+    _terminal->clearSearch();
     _terminal->screenUpdated();
 }
 
@@ -490,9 +505,10 @@ CellLocation ViCommands::prev(CellLocation location) const noexcept
     if (location.column.value > 0)
         return { .line = location.line, .column = location.column - 1 };
 
-    auto const topLineOffset = _terminal->isPrimaryScreen()
-                                   ? -boxed_cast<LineOffset>(_terminal->primaryScreen().historyLineCount())
-                                   : LineOffset(0);
+    auto const topLineOffset =
+        _terminal->isPrimaryScreen()
+            ? -boxed_cast<LineOffset>(_terminal->primaryScreenBase().historyLineCount())
+            : LineOffset(0);
     if (location.line > topLineOffset)
     {
         location = getRightMostNonEmptyCellLocation(*_terminal, location.line - 1);
@@ -523,11 +539,16 @@ CellLocation ViCommands::next(CellLocation location) const noexcept
 
 CellLocation ViCommands::findMatchingPairFrom(CellLocation location) const noexcept
 {
-    auto const& cell = _terminal->primaryScreen().at(cursorPosition);
-    if (cell.codepointCount() != 1)
+    auto const codepoint = _terminal->visitPrimaryScreen([&](auto const& screen) -> std::optional<char32_t> {
+        auto const& cell = screen.at(cursorPosition);
+        if (cell.codepointCount() != 1)
+            return std::nullopt;
+        return cell.codepoint(0);
+    });
+    if (!codepoint)
         return location;
 
-    auto const a = cell.codepoint(0);
+    auto const a = *codepoint;
     auto const matchResult = matchingPairOfChar(a);
     if (!matchResult)
         return location;
@@ -541,59 +562,20 @@ CellLocation ViCommands::findMatchingPairFrom(CellLocation location) const noexc
 
 CellLocation ViCommands::findMatchingPairLeft(char32_t left, char32_t right, int initialDepth) const noexcept
 {
-    auto a = cursorPosition;
-    auto depth = initialDepth;
-
-    while (true)
-    {
-        if (compareCellTextAt(a, right))
-        {
-            ++depth;
-            if (depth == 0)
-                break;
-        }
-        else if (compareCellTextAt(a, left))
-        {
-            --depth;
-            if (depth == 0)
-                break;
-        }
-
-        if (auto const prevA = prev(a); prevA != a)
-            a = prevA;
-        else
-            break;
-    }
-    return a;
+    // Scanned by the screen line by line, as walking cell by cell would inflate every line on the way.
+    auto const gridTop = -_terminal->currentScreen().historyLineCount().as<LineOffset>();
+    return _terminal->currentScreen()
+        .findPairLeft(cursorPosition, left, right, initialDepth)
+        .value_or(CellLocation { .line = gridTop, .column = ColumnOffset(0) });
 }
 
 CellLocation ViCommands::findMatchingPairRight(char32_t left, char32_t right, int initialDepth) const noexcept
 {
-    auto depth = initialDepth;
-    auto b = cursorPosition;
-
-    while (true)
-    {
-        if (compareCellTextAt(b, left))
-        {
-            ++depth;
-            if (depth == 0)
-                break;
-        }
-        else if (compareCellTextAt(b, right))
-        {
-            --depth;
-            if (depth == 0)
-                break;
-        }
-
-        if (auto const nextB = next(b); nextB != b)
-            b = nextB;
-        else
-            break;
-    }
-
-    return b;
+    auto const pageBottom = _terminal->pageSize().lines.as<LineOffset>() - 1;
+    auto const rightMargin = _terminal->pageSize().columns.as<ColumnOffset>() - 1;
+    return _terminal->currentScreen()
+        .findPairRight(cursorPosition, left, right, initialDepth)
+        .value_or(CellLocation { .line = pageBottom, .column = rightMargin });
 }
 
 CellLocationRange ViCommands::expandMatchingPair(TextObjectScope scope, char left, char right) const noexcept
@@ -625,18 +607,27 @@ CellLocationRange ViCommands::translateToCellRange(TextObjectScope scope,
         case TextObject::AngleBrackets: return expandMatchingPair(scope, '<', '>');
         case TextObject::BackQuotes: return expandMatchingPair(scope, '`', '`');
         case TextObject::CurlyBrackets: return expandMatchingPair(scope, '{', '}');
+        case TextObject::Command:
+            // Span the output of the command the cursor is at, including its prompt if around.
+            if (auto const index = _terminal->currentScreen().commandAt(cursorPosition.line))
+            {
+                auto const command = _terminal->currentScreen().command(*index);
+                if (!command)
+                    break;
+                a.line = scope == TextObjectScope::Inner ? command->outputTop : command->prompt;
+                b.line = std::max(command->outputBottom, a.line);
+                a.column = ColumnOffset(0);
+                b.column = rightMargin;
+            }
+            break;
         case TextObject::DoubleQuotes: return expandMatchingPair(scope, '"', '"');
         case TextObject::LineMark:
             // Walk the line upwards until we find a marked line.
-            while (a.line > gridTop
-                   && !(_terminal->currentScreen().lineFlagsAt(a.line).contains(LineFlag::Marked)))
-                --a.line;
+            a.line = _terminal->currentScreen().findMarkedLineAbove(a.line + 1).value_or(gridTop);
             if (scope == TextObjectScope::Inner && a != cursorPosition)
                 ++a.line;
             // Walk the line downwards until we find a marked line.
-            while (b.line < gridBottom
-                   && !(_terminal->currentScreen().lineFlagsAt(b.line).contains(LineFlag::Marked)))
-                ++b.line;
+            b.line = _terminal->currentScreen().findMarkedLineBelow(b.line - 1).value_or(gridBottom);
             if (scope == TextObjectScope::Inner && b != cursorPosition)
                 --b.line;
             // Span the range from left most column to right most column.
@@ -870,17 +861,10 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
         case ViMotion::ParagraphBackward: // {
         {
             auto const pageTop = -_terminal->currentScreen().historyLineCount().as<LineOffset>();
-            auto prev = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
-            if (prev.line.value > 0)
-                prev.line--;
-            auto current = prev;
-            while (current.line > pageTop
-                   && (!_terminal->currentScreen().isLineEmpty(current.line)
-                       || _terminal->currentScreen().isLineEmpty(prev.line)))
-            {
-                prev.line = current.line;
-                current.line--;
-            }
+            auto current = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
+            for (; count > 0; --count)
+                current.line =
+                    _terminal->currentScreen().findParagraphBoundaryAbove(current.line).value_or(pageTop);
             return addJumpHistory(snapToCell(current));
         }
         case ViMotion::GlobalCurlyOpenUp: // [[
@@ -897,12 +881,7 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
             auto result = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
             while (count > 0)
             {
-                if (result.line > gridTop
-                    && _terminal->currentScreen().isLineFlagEnabledAt(result.line, LineFlag::Marked))
-                    --result.line;
-                while (result.line > gridTop
-                       && !_terminal->currentScreen().isLineFlagEnabledAt(result.line, LineFlag::Marked))
-                    --result.line;
+                result.line = _terminal->currentScreen().findMarkedLineAbove(result.line).value_or(gridTop);
                 --count;
             }
             return addJumpHistory(result);
@@ -913,32 +892,47 @@ CellLocation ViCommands::translateToCellLocationAndRecord(ViMotion motion, unsig
             auto result = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
             while (count > 0)
             {
-                if (cursorPosition.column == ColumnOffset(0) && result.line < pageBottom)
-                    ++result.line;
-                while (result.line < pageBottom)
-                {
-                    if (_terminal->currentScreen().lineFlagsAt(result.line).contains(LineFlag::Marked))
-                        break;
-                    ++result.line;
-                }
+                // Only skip the current line if the cursor is at its beginning.
+                auto const from = cursorPosition.column == ColumnOffset(0) ? result.line : result.line - 1;
+                result.line = _terminal->currentScreen().findMarkedLineBelow(from).value_or(pageBottom);
                 --count;
             }
             return addJumpHistory(result);
         }
+        case ViMotion::CommandUp: // [c
+        {
+            // Only skip the current command if the cursor is at its prompt already.
+            auto const& screen = _terminal->currentScreen();
+            auto const gridTop = -screen.historyLineCount().as<LineOffset>();
+            auto result = CellLocation { .line = gridTop, .column = ColumnOffset(0) };
+            auto const current = screen.commandAt(cursorPosition.line);
+            auto const currentCommand = current ? screen.command(*current) : std::nullopt;
+            auto const atPrompt = currentCommand && currentCommand->prompt == cursorPosition.line
+                                  && cursorPosition.column == ColumnOffset(0);
+            auto const n = current ? *current + count - (atPrompt ? 0 : 1) : screen.commandCount();
+            if (auto const command = screen.command(n))
+                result.line = command->prompt;
+            return addJumpHistory(result);
+        }
+        case ViMotion::CommandDown: // ]c
+        {
+            auto const& screen = _terminal->currentScreen();
+            auto const pageBottom = _terminal->pageSize().lines.as<LineOffset>() - 1;
+            auto result = CellLocation { .line = pageBottom, .column = ColumnOffset(0) };
+            auto const current = screen.commandAt(cursorPosition.line).value_or(screen.commandCount());
+            if (current >= count)
+                if (auto const command = screen.command(current - count))
+                    result.line = command->prompt;
+            return addJumpHistory(result);
+        }
         case ViMotion::ParagraphForward: // }
         {
             auto const pageBottom = _terminal->pageSize().lines.as<LineOffset>() - 1;
-            auto prev = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
-            if (prev.line < pageBottom)
-                prev.line++;
-            auto current = prev;
-            while (current.line < pageBottom
-                   && (!_terminal->currentScreen().isLineEmpty(current.line)
-                       || _terminal->currentScreen().isLineEmpty(prev.line)))
-            {
-                prev.line = current.line;
-                current.line++;
-            }
+            auto current = CellLocation { .line = cursorPosition.line, .column = ColumnOffset(0) };
+            for (; count > 0; --count)
+                current.line = _terminal->currentScreen()
+                                   .findParagraphBoundaryBelow(current.line)
+                                   .value_or(pageBottom);
             return addJumpHistory(snapToCell(current));
         }
         case ViMotion::ParenthesisMatching: // % TODO
@@ -1153,6 +1147,13 @@ void ViCommands::moveCursor(ViMotion motion, unsigned count, char32_t lastChar)
         _lastChar = lastChar;
     }
 
+    // Moving up beyond the history in memory pages in what has been spilled to disk.
+    auto const historyTop = -boxed_cast<LineOffset>(_terminal->currentScreen().historyLineCount());
+    auto const linesUp = linesUpOf(*_terminal, motion, count);
+    auto const topReached = cursorPosition.line - boxed_cast<LineOffset>(linesUp);
+    if (topReached < historyTop)
+        _terminal->pageInSpilledHistory(boxed_cast<LineCount>(historyTop - topReached));
+
     auto const nextPosition = translateToCellLocationAndRecord(motion, count);
     inputLog()("Move cursor: {} to {}\n", motion, nextPosition);
     moveCursorTo(nextPosition);
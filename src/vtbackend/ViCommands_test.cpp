@@ -152,6 +152,40 @@ TEST_CASE("vi.motions: M", "[vi]")
     CHECK(mock.terminal.normalModeCursorPosition() == 4_lineOffset + 1_columnOffset);
 }
 
+TEST_CASE("vi.motions: paragraphs and %", "[vi]")
+{
+    auto mock =
+        setupMockTerminal("a\r\n\r\nb\r\nc\r\n\r\nd(\r\n)",
+                          vtbackend::PageSize { vtbackend::LineCount(8), vtbackend::ColumnCount(40) });
+
+    SECTION("} and { with count")
+    {
+        mock.sendCharSequence("}");
+        CHECK(mock.terminal.normalModeCursorPosition() == 1_lineOffset + 0_columnOffset);
+
+        mock.sendCharSequence("2}");
+        CHECK(mock.terminal.normalModeCursorPosition() == 7_lineOffset + 0_columnOffset);
+
+        mock.sendCharSequence("{");
+        CHECK(mock.terminal.normalModeCursorPosition() == 4_lineOffset + 0_columnOffset);
+
+        mock.sendCharSequence("2{");
+        CHECK(mock.terminal.normalModeCursorPosition() == 0_lineOffset + 0_columnOffset);
+    }
+
+    SECTION("% across lines")
+    {
+        mock.sendCharSequence("5jl");
+        REQUIRE(mock.terminal.normalModeCursorPosition() == 5_lineOffset + 1_columnOffset);
+
+        mock.sendCharSequence("%");
+        CHECK(mock.terminal.normalModeCursorPosition() == 6_lineOffset + 0_columnOffset);
+
+        mock.sendCharSequence("%");
+        CHECK(mock.terminal.normalModeCursorPosition() == 5_lineOffset + 1_columnOffset);
+    }
+}
+
 TEST_CASE("vi.motion: t{char}", "[vi]")
 {
     auto mock =
@@ -69,7 +69,7 @@ void ViInputHandler::registerAllCommands()
         std::array<std::pair<char, TextObjectScope>, 2> { { std::pair { 'i', TextObjectScope::Inner },
                                                             std::pair { 'a', TextObjectScope::A } } };
 
-    auto constexpr MotionMappings = std::array<std::pair<std::string_view, ViMotion>, 47> { {
+    auto constexpr MotionMappings = std::array<std::pair<std::string_view, ViMotion>, 49> { {
         // clang-format off
         { "$", ViMotion::LineEnd },
         { "%", ViMotion::ParenthesisMatching },
@@ -97,9 +97,11 @@ void ViInputHandler::registerAllCommands()
         { "W", ViMotion::BigWordForward },
         { "[[", ViMotion::GlobalCurlyOpenUp },
         { "[]", ViMotion::GlobalCurlyCloseUp },
+        { "[c", ViMotion::CommandUp },
         { "[m", ViMotion::LineMarkUp },
         { "][", ViMotion::GlobalCurlyCloseDown },
         { "]]", ViMotion::GlobalCurlyOpenDown },
+        { "]c", ViMotion::CommandDown },
         { "]m", ViMotion::LineMarkDown },
         { "^", ViMotion::LineTextBegin },
         { "b", ViMotion::WordBackward },
@@ -121,8 +123,9 @@ void ViInputHandler::registerAllCommands()
         // clang-format on
     } };
 
-    auto constexpr TextObjectMappings = std::array<std::pair<char, TextObject>, 15> { {
+    auto constexpr TextObjectMappings = std::array<std::pair<char, TextObject>, 16> { {
         { '"', TextObject::DoubleQuotes },
+        { 'c', TextObject::Command },
         { 'm', TextObject::LineMark },
         { '(', TextObject::RoundBrackets },
         { ')', TextObject::RoundBrackets },
@@ -170,6 +173,7 @@ void ViInputHandler::registerAllCommands()
     registerCommand(ModeSelect::Normal, "V", [this]() { toggleMode(ViMode::VisualLine); });
     registerCommand(ModeSelect::Normal, "C-V", [this]() { toggleMode(ViMode::VisualBlock); });
     registerCommand(ModeSelect::Normal, "/", [this]() { startSearch(); });
+    registerCommand(ModeSelect::Normal, "?", [this]() { startSearch(); });
     registerCommand(ModeSelect::Normal, "#", [this]() { _executor->reverseSearchCurrentWord(); });
     registerCommand(ModeSelect::Normal, "mm", [this]() { _executor->toggleLineMark(); });
     registerCommand(ModeSelect::Normal, "*", [this]() { _executor->searchCurrentWord(); });
@@ -218,6 +222,7 @@ void ViInputHandler::registerAllCommands()
 
     // visual mode
     registerCommand(ModeSelect::Visual, "/", [this]() { startSearch(); });
+    registerCommand(ModeSelect::Visual, "?", [this]() { startSearch(); });
     registerCommand(ModeSelect::Visual, "y", [this]() {
         _executor->execute(ViOperator::Yank, ViMotion::Selection, count());
     });
@@ -85,6 +85,8 @@ enum class ViMotion : uint8_t
     GlobalCurlyOpenDown,   // ]]
     LineMarkUp,            // [m
     LineMarkDown,          // ]m
+    CommandUp,             // [c
+    CommandDown,           // ]c
     ParenthesisMatching,   // %
     SearchResultBackward,  // N
     SearchResultForward,   // n
@@ -118,6 +120,7 @@ enum class ViOperator : uint8_t
 enum class TextObject : uint8_t
 {
     AngleBrackets = '<',  // i<  a<
+    Command = 'c',        // ic  ac
     CurlyBrackets = '{',  // i{  a{
     DoubleQuotes = '"',   // i"  a"
     LineMark = 'm',       // im  am
@@ -296,6 +299,7 @@ struct std::formatter<vtbackend::TextObject>: formatter<std::string_view>
         {
             case TextObject::AngleBrackets: name = "AngleBrackets"; break;
             case TextObject::BackQuotes: name = "BackQuotes"; break;
+            case TextObject::Command: name = "Command"; break;
             case TextObject::CurlyBrackets: name = "CurlyBrackets"; break;
             case TextObject::DoubleQuotes: name = "DoubleQuotes"; break;
             case TextObject::LineMark: name = "LineMark"; break;
@@ -383,6 +387,8 @@ struct std::formatter<vtbackend::ViMotion>: formatter<std::string_view>
             case ViMotion::GlobalCurlyOpenDown: name = "GlobalCurlyOpenDown"; break;
             case ViMotion::LineMarkUp: name = "LineMarkUp"; break;
             case ViMotion::LineMarkDown: name = "LineMarkDown"; break;
+            case ViMotion::CommandUp: name = "CommandUp"; break;
+            case ViMotion::CommandDown: name = "CommandDown"; break;
         }
         return formatter<string_view>::format(name, ctx);
     }
@@ -13,6 +13,12 @@ namespace vtbackend
 bool Viewport::scrollUp(LineCount numLines)
 {
     viewportLog()("scrollUp");
+
+    // Scrolling beyond the history in memory pages in what has been spilled to disk.
+    auto const wanted = _scrollOffset + numLines.as<ScrollOffset>();
+    if (wanted > boxed_cast<ScrollOffset>(historyLineCount()) && !scrollingDisabled())
+        _terminal->pageInSpilledHistory(boxed_cast<LineCount>(wanted) - historyLineCount());
+
     auto offset =
         std::min(_scrollOffset + numLines.as<ScrollOffset>(), boxed_cast<ScrollOffset>(historyLineCount()));
     return scrollTo(offset);
@@ -28,6 +34,8 @@ bool Viewport::scrollDown(LineCount numLines)
 bool Viewport::scrollToTop()
 {
     viewportLog()("scrollToTop");
+    if (!scrollingDisabled())
+        _terminal->pageInSpilledHistory(_terminal->spilledHistoryLineCount());
     return scrollTo(boxed_cast<ScrollOffset>(historyLineCount()));
 }
 
@@ -119,7 +127,9 @@ bool Viewport::scrollMarkUp()
         return false;
 
     auto const newScrollOffset =
-        _terminal->primaryScreen().findMarkerUpwards(-boxed_cast<LineOffset>(_scrollOffset));
+        _terminal->visitPrimaryScreen([&](auto const& screen) {
+            return screen.findMarkerUpwards(-boxed_cast<LineOffset>(_scrollOffset));
+        });
     if (newScrollOffset.has_value())
         return scrollTo(boxed_cast<ScrollOffset>(-*newScrollOffset));
 
@@ -133,7 +143,9 @@ bool Viewport::scrollMarkDown()
         return false;
 
     auto const newScrollOffset =
-        _terminal->primaryScreen().findMarkerDownwards(-boxed_cast<LineOffset>(_scrollOffset));
+        _terminal->visitPrimaryScreen([&](auto const& screen) {
+            return screen.findMarkerDownwards(-boxed_cast<LineOffset>(_scrollOffset));
+        });
     if (newScrollOffset)
         return scrollTo(boxed_cast<ScrollOffset>(-*newScrollOffset));
     else
@@ -77,6 +77,11 @@ class Viewport
         };
     }
 
+    [[nodiscard]] constexpr LineOffset translateScreenToGridCoordinate(LineOffset p) const noexcept
+    {
+        return p - boxed_cast<LineOffset>(_scrollOffset);
+    }
+
     constexpr CellLocation translateGridToScreenCoordinate(CellLocation p) const noexcept
     {
         return CellLocation {
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <string_view>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Set of codepoints that delimit words, e.g. for word-wise selection.
+ *
+ * ASCII delimiters are kept in a bitset, so that testing the vast majority of cells takes
+ * constant time, and any other delimiters in a sorted vector to search.
+ */
+class WordDelimiters
+{
+  public:
+    WordDelimiters() = default;
+
+    explicit WordDelimiters(std::u32string_view codepoints)
+    {
+        for (auto const codepoint: codepoints)
+        {
+            if (codepoint < AsciiCount)
+                _ascii.set(codepoint);
+            else
+                _nonAscii.push_back(codepoint);
+        }
+        std::ranges::sort(_nonAscii);
+        _nonAscii.erase(std::ranges::unique(_nonAscii).begin(), _nonAscii.end());
+    }
+
+    [[nodiscard]] bool contains(char32_t codepoint) const noexcept
+    {
+        if (codepoint < AsciiCount)
+            return _ascii[codepoint];
+        return !_nonAscii.empty() && std::ranges::binary_search(_nonAscii, codepoint);
+    }
+
+  private:
+    static constexpr char32_t AsciiCount = 128;
+
+    std::bitset<AsciiCount> _ascii;
+    std::vector<char32_t> _nonAscii; // sorted
+};
+
+} // namespace vtbackend
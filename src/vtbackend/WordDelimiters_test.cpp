@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/WordDelimiters.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace std;
+using vtbackend::WordDelimiters;
+
+TEST_CASE("WordDelimiters.empty")
+{
+    auto const delimiters = WordDelimiters {};
+    CHECK_FALSE(delimiters.contains(U' '));
+    CHECK_FALSE(delimiters.contains(U'│'));
+}
+
+TEST_CASE("WordDelimiters.contains")
+{
+    auto const delimiters = WordDelimiters(U" ,;│ │"sv);
+
+    CHECK(delimiters.contains(U' '));
+    CHECK(delimiters.contains(U','));
+    CHECK(delimiters.contains(U';'));
+    CHECK(delimiters.contains(U' '));
+    CHECK(delimiters.contains(U'│'));
+
+    CHECK_FALSE(delimiters.contains(U'a'));
+    CHECK_FALSE(delimiters.contains(U'\x7F'));
+    CHECK_FALSE(delimiters.contains(U'ä'));
+    CHECK_FALSE(delimiters.contains(U'\U0001F600'));
+}
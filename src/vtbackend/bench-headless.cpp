@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/MockTerm.h>
+#include <vtbackend/SequenceBuilder.h>
 #include <vtbackend/Terminal.h>
 #include <vtbackend/cell/CellConfig.h>
 #include <vtbackend/logging.h>
@@ -7,21 +8,381 @@
 #include <vtparser/ParserEvents.h>
 
 #include <vtpty/MockViewPty.h>
+#include <vtpty/PtyRecording.h>
+
+#if !defined(_WIN32)
+    #include <vtpty/StdoutFastPipe.h>
+    #include <vtpty/UnixPty.h>
+
+    #include <sys/resource.h>
+#else
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+
+    #include <psapi.h>
+#endif
 
 #include <crispy/App.h>
 #include <crispy/BufferObject.h>
 #include <crispy/CLI.h>
+#include <crispy/allocations.h>
 #include <crispy/utils.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <format>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <new>
 #include <optional>
 #include <thread>
+#include <vector>
 
 #include <libtermbench/termbench.h>
 
 using namespace std;
 
+// {{{ allocation counting
+namespace
+{
+
+#if !defined(CONTOUR_ALLOCATION_ACCOUNTING)
+// Counts the allocations made through the global operator new, so that the workload benchmarks
+// can report them along with their throughput. Builds accounting allocations per subsystem
+// replace the global operator new already, and are asked instead.
+std::atomic<uint64_t> allocationCount = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<uint64_t> allocatedBytes = 0;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+void* countedAllocate(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+#endif
+
+struct AllocationStats
+{
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+
+    [[nodiscard]] static AllocationStats now() noexcept
+    {
+#if defined(CONTOUR_ALLOCATION_ACCOUNTING)
+        auto const total = crispy::allocations::total();
+        return AllocationStats { .count = total.count, .bytes = total.bytes };
+#else
+        return AllocationStats { .count = allocationCount.load(std::memory_order_relaxed),
+                                 .bytes = allocatedBytes.load(std::memory_order_relaxed) };
+#endif
+    }
+
+    [[nodiscard]] AllocationStats operator-(AllocationStats const& other) const noexcept
+    {
+        return AllocationStats { .count = count - other.count, .bytes = bytes - other.bytes };
+    }
+};
+
+} // namespace
+
+#if !defined(CONTOUR_ALLOCATION_ACCOUNTING)
+// The nothrow variants default to these, and the aligned ones are left alone,
+// as they neither allocate nor free through these.
+void* operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t /*size*/) noexcept
+{
+    std::free(p);
+}
+#endif
+// }}}
+
+// {{{ test results
+namespace
+{
+
+/// @returns the peak resident set size of this process so far, in bytes, or 0 if unknown.
+uint64_t peakResidentSetSize() noexcept
+{
+#if defined(_WIN32)
+    auto counters = PROCESS_MEMORY_COUNTERS {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    auto usage = rusage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    #if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss); // bytes
+    #else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // kilobytes
+    #endif
+#endif
+}
+
+struct SubsystemAllocations
+{
+    std::string_view name;
+    crispy::allocations::counts counts;
+};
+
+/// @returns the allocations accounted to each subsystem so far, none unless they are accounted.
+std::vector<SubsystemAllocations> subsystemAllocations()
+{
+    auto result = std::vector<SubsystemAllocations> {};
+    if constexpr (crispy::allocations::enabled())
+        for (auto const* counter: crispy::allocations::counters())
+            result.push_back({ .name = counter->name(), .counts = counter->read() });
+    return result;
+}
+
+struct TestResult
+{
+    std::string name;
+    uint64_t units;        // bytes written, or lines processed
+    std::string_view unit; // what units counts, empty for bytes
+    std::chrono::nanoseconds elapsed;
+    AllocationStats allocations;
+    uint64_t peakResidentSetSize; // of the whole process, up to the end of the test
+    std::vector<SubsystemAllocations> allocationsBySubsystem {};
+
+    [[nodiscard]] double seconds() const noexcept { return std::chrono::duration<double>(elapsed).count(); }
+
+    [[nodiscard]] double unitsPerSecond() const noexcept
+    {
+        return elapsed.count() > 0 ? static_cast<double>(units) / seconds() : 0.0;
+    }
+
+    [[nodiscard]] double nanosecondsPerUnit() const noexcept
+    {
+        return units != 0 ? static_cast<double>(elapsed.count()) / static_cast<double>(units) : 0.0;
+    }
+};
+
+/// Measures a test from its construction until finish() is called.
+class TestMeasurement
+{
+  public:
+    explicit TestMeasurement(std::string name, std::string_view unit = {}):
+        _name { std::move(name) },
+        _unit { unit },
+        _allocationsBefore { AllocationStats::now() },
+        _subsystemAllocationsBefore { subsystemAllocations() },
+        _startTime { std::chrono::steady_clock::now() }
+    {
+    }
+
+    [[nodiscard]] TestResult finish(uint64_t units) const
+    {
+        using namespace std::chrono;
+        auto const elapsed = duration_cast<nanoseconds>(steady_clock::now() - _startTime);
+        auto allocationsBySubsystem = subsystemAllocations();
+        for (size_t i = 0; i < allocationsBySubsystem.size() && i < _subsystemAllocationsBefore.size(); ++i)
+            allocationsBySubsystem[i].counts =
+                allocationsBySubsystem[i].counts - _subsystemAllocationsBefore[i].counts;
+        return TestResult { .name = _name,
+                            .units = units,
+                            .unit = _unit,
+                            .elapsed = elapsed,
+                            .allocations = AllocationStats::now() - _allocationsBefore,
+                            .peakResidentSetSize = peakResidentSetSize(),
+                            .allocationsBySubsystem = std::move(allocationsBySubsystem) };
+    }
+
+  private:
+    std::string _name;
+    std::string_view _unit;
+    AllocationStats _allocationsBefore;
+    std::vector<SubsystemAllocations> _subsystemAllocationsBefore;
+    std::chrono::steady_clock::time_point _startTime;
+};
+
+void printTestResults(std::vector<TestResult> const& results)
+{
+    for (auto const& result: results)
+    {
+        auto const throughput =
+            result.unit.empty()
+                ? std::format("{}/s",
+                              crispy::humanReadableBytes(static_cast<uint64_t>(result.unitsPerSecond())))
+                : std::format("{:.0f} {}/s", result.unitsPerSecond(), result.unit);
+        std::cout << std::format("{:>16}: {:>8.3f} s, {:>20}, {:>10} allocations ({})\n",
+                                 result.name,
+                                 result.seconds(),
+                                 throughput,
+                                 result.allocations.count,
+                                 crispy::humanReadableBytes(result.allocations.bytes));
+        for (auto const& [name, counts]: result.allocationsBySubsystem)
+            std::cout << std::format("{:>16}  {:>14}: {:>10} allocations ({})\n",
+                                     "",
+                                     name,
+                                     counts.count,
+                                     crispy::humanReadableBytes(counts.bytes));
+    }
+}
+
+/// @returns the results as JSON, one test per line, in the format parseBaseline() reads back.
+std::string testResultsToJson(std::string_view benchmark, std::vector<TestResult> const& results)
+{
+    auto json = std::format("{{\n  \"version\": \"{}\",\n  \"benchmark\": \"{}\",\n  \"tests\": [\n",
+                            CONTOUR_VERSION_STRING,
+                            benchmark);
+    for (auto const& result: results)
+    {
+        json += std::format("    {{\"name\": \"{}\", \"unit\": \"{}\", \"units\": {}, \"seconds\": {:.6f}, "
+                            "\"units_per_second\": {:.3f}, \"mb_per_second\": {:.3f}, \"ns_per_op\": {:.3f}, "
+                            "\"allocations\": {}, \"allocated_bytes\": {}, \"peak_rss\": {}",
+                            result.name,
+                            result.unit.empty() ? "bytes" : result.unit,
+                            result.units,
+                            result.seconds(),
+                            result.unitsPerSecond(),
+                            result.unit.empty() ? result.unitsPerSecond() / (1024 * 1024) : 0.0,
+                            result.nanosecondsPerUnit(),
+                            result.allocations.count,
+                            result.allocations.bytes,
+                            result.peakResidentSetSize);
+        // Kept last, as parseBaseline() only reads up to the first closing brace.
+        if (!result.allocationsBySubsystem.empty())
+        {
+            auto separator = std::string_view { ", \"allocations_by_subsystem\": {" };
+            for (auto const& [name, counts]: result.allocationsBySubsystem)
+            {
+                json += std::format("{}\"{}\": {{\"count\": {}, \"bytes\": {}}}",
+                                    separator,
+                                    name,
+                                    counts.count,
+                                    counts.bytes);
+                separator = ", ";
+            }
+            json += "}";
+        }
+        json += &result != &results.back() ? "},\n" : "}\n";
+    }
+    return json + "  ]\n}\n";
+}
+
+struct BaselineResult
+{
+    std::string name;
+    double unitsPerSecond = 0.0;
+    double allocations = 0.0;
+};
+
+/// @returns the raw value of the given field of a flat JSON object, without quotes.
+std::optional<std::string_view> jsonField(std::string_view object, std::string_view name)
+{
+    auto const key = std::format("\"{}\":", name);
+    auto start = object.find(key);
+    if (start == std::string_view::npos)
+        return std::nullopt;
+    start = object.find_first_not_of(" \"", start + key.size());
+    if (start == std::string_view::npos)
+        return std::nullopt;
+    auto const end = object.find_first_of(",\"}", start);
+    return object.substr(start, end - start);
+}
+
+std::optional<double> jsonNumber(std::string_view object, std::string_view name)
+{
+    auto const field = jsonField(object, name);
+    if (!field || field->empty())
+        return std::nullopt;
+    auto const text = std::string(*field);
+    char* end = nullptr;
+    auto const value = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size())
+        return std::nullopt;
+    return value;
+}
+
+/// Reads back the test results written by testResultsToJson(), not JSON in general.
+std::vector<BaselineResult> parseBaseline(std::string_view json)
+{
+    auto results = std::vector<BaselineResult> {};
+    for (auto start = json.find("{\"name\""); start != std::string_view::npos;
+         start = json.find("{\"name\"", start + 1))
+    {
+        auto const object = json.substr(start, json.find('}', start) - start);
+        auto const name = jsonField(object, "name");
+        auto const unitsPerSecond = jsonNumber(object, "units_per_second");
+        auto const allocations = jsonNumber(object, "allocations");
+        if (name && unitsPerSecond && allocations)
+            results.emplace_back(BaselineResult {
+                .name = std::string(*name), .unitsPerSecond = *unitsPerSecond, .allocations = *allocations });
+    }
+    return results;
+}
+
+/// Compares the results with those of a baseline, printing the differences.
+///
+/// @returns whether none of the tests regressed by more than @p thresholdPercent,
+///          either in throughput or in allocations.
+bool compareWithBaseline(std::vector<TestResult> const& results,
+                         std::vector<BaselineResult> const& baseline,
+                         unsigned thresholdPercent)
+{
+    auto const threshold = static_cast<double>(thresholdPercent) / 100.0;
+    auto const change = [](double value, double baselineValue) {
+        return baselineValue != 0.0 ? (value - baselineValue) / baselineValue : (value != 0.0 ? 1.0 : 0.0);
+    };
+
+    auto regressed = false;
+    for (auto const& result: results)
+    {
+        auto const i = std::ranges::find(baseline, result.name, &BaselineResult::name);
+        if (i == baseline.end())
+        {
+            std::cout << std::format("{:>16}: not in baseline\n", result.name);
+            continue;
+        }
+        auto const throughputChange = change(result.unitsPerSecond(), i->unitsPerSecond);
+        auto const allocationChange = change(static_cast<double>(result.allocations.count), i->allocations);
+        auto const isRegression = throughputChange < -threshold || allocationChange > threshold;
+        regressed = regressed || isRegression;
+        std::cout << std::format("{:>16}: throughput {:>+7.1f}%, allocations {:>+7.1f}%{}\n",
+                                 result.name,
+                                 throughputChange * 100.0,
+                                 allocationChange * 100.0,
+                                 isRegression ? "  REGRESSION" : "");
+    }
+    return !regressed;
+}
+
+} // namespace
+// }}}
+
 namespace
 {
 
@@ -37,6 +398,28 @@ std::string createText(size_t bytes)
     return text;
 }
 
+/// @returns a line of random letters and spaces, without a line break.
+std::string createLine(size_t length)
+{
+    std::string text;
+    text.reserve(length);
+    while (text.size() < length)
+        text += (rand() % 7) != 0 ? char('a' + (rand() % 26)) : ' ';
+    return text;
+}
+
+/// Sequence handler that discards everything, used to measure the VT parser plus SequenceBuilder alone.
+struct NullSequenceHandler
+{
+    void executeControlCode(char /*controlCode*/) {}
+    void processSequence(vtbackend::Sequence const& /*sequence*/) {}
+    void processGraphicsRendition(vtbackend::Sequence const& /*sequence*/) {}
+    void writeText(char32_t /*codepoint*/) {}
+    void writeText(std::string_view /*codepoints*/, size_t /*cellCount*/) {}
+    void writeTextEnd() {}
+    [[nodiscard]] size_t maxBulkTextSequenceWidth() const noexcept { return 80; }
+};
+
 } // namespace
 
 struct BenchOptions
@@ -49,7 +432,7 @@ struct BenchOptions
 };
 
 template <typename Writer>
-int baseBenchmark(Writer&& writer, BenchOptions options, string_view title)
+std::vector<TestResult> baseBenchmark(Writer&& writer, BenchOptions options, string_view title)
 {
     if (!(options.binary || options.longLines || options.manyLines || options.sgr))
     {
@@ -63,12 +446,29 @@ int baseBenchmark(Writer&& writer, BenchOptions options, string_view title)
 
     cout << titleText << '\n' << string(titleText.size(), '=') << '\n';
 
-    auto tbp = termbench::Benchmark { std::forward<Writer>(writer),
-                                      options.testSizeMB,
-                                      termbench::TerminalSize { 80, 24 },
-                                      [&](termbench::Test const& test) {
-                                          cout << std::format("Running test {} ...\n", test.name);
-                                      } };
+    // Each test is measured from its start until the next one starts, counting the bytes it writes.
+    auto results = std::vector<TestResult> {};
+    auto measurement = std::optional<TestMeasurement> {};
+    auto bytesWritten = uint64_t { 0 };
+    auto const finishTest = [&]() {
+        if (measurement)
+            results.emplace_back(measurement->finish(bytesWritten));
+    };
+
+    auto tbp = termbench::Benchmark {
+        [&](char const* a, size_t b) -> bool {
+            bytesWritten += b;
+            return writer(a, b);
+        },
+        options.testSizeMB,
+        termbench::TerminalSize { 80, 24 },
+        [&](termbench::Test const& test) {
+            finishTest();
+            cout << std::format("Running test {} ...\n", test.name);
+            bytesWritten = 0;
+            measurement.emplace(std::string(test.name));
+        }
+    };
 
     if (options.manyLines)
         tbp.add(termbench::tests::many_lines());
@@ -86,16 +486,249 @@ int baseBenchmark(Writer&& writer, BenchOptions options, string_view title)
         tbp.add(termbench::tests::binary());
 
     tbp.runAll();
+    finishTest();
 
     cout << '\n';
     cout << "Results\n";
     cout << "-------\n";
     tbp.summarize(cout);
     cout << '\n';
+    printTestResults(results);
+    cout << '\n';
+
+    return results;
+}
+
+// {{{ workloads
+namespace
+{
+
+using HeadlessTerm = vtbackend::MockTerm<vtpty::MockViewPty>;
+
+/// Output of a real-world application, written over and over again until the test size is reached.
+struct Workload
+{
+    std::string_view name;
+    vtbackend::PageSize pageSize;
+    std::function<std::string()> createChunk;
+    std::function<void(vtbackend::Terminal&)> setup = {};
+};
+
+void writeToTerminal(HeadlessTerm& vt, std::string_view text)
+{
+    auto& pty = dynamic_cast<vtpty::MockViewPty&>(vt.terminal.device());
+    // clang-format off
+    pty.setReadData(text);
+    do vt.terminal.processInputOnce();
+    while (!pty.isClosed() && !pty.stdoutBuffer().empty());
+    // clang-format on
+}
+
+template <typename Run>
+TestResult measure(std::string_view name, std::string_view unit, Run&& run)
+{
+    auto const measurement = TestMeasurement(std::string(name), unit);
+    auto const units = static_cast<uint64_t>(run());
+    return measurement.finish(units);
+}
+
+/// Lines scrolling within DECSTBM margins between a status line at the top and the bottom,
+/// like a pager or a chat client.
+std::string marginScrollingChunk()
+{
+    auto text = std::string("\033[3;22r\033[22;1H");
+    for (int i = 0; i < 256; ++i)
+    {
+        text += std::format("\r\n{:04} {}", i, createLine(60 + size_t(rand() % 15)));
+        if (i % 32 == 0)
+            text += std::format("\0337\033[1;1H\033[7m status {:04} \033[m\033[K\0338", i);
+    }
+    return text + "\033[r";
+}
+
+/// Full-screen repaint by cursor addressing, like vim or htop redrawing their pages.
+std::string fullScreenRepaintChunk()
+{
+    auto text = std::string();
+    for (int frame = 0; frame < 8; ++frame)
+    {
+        text += "\033[H";
+        for (int line = 1; line <= 40; ++line)
+        {
+            text += std::format("\033[{};1H\033[38;5;{}m{:>4} \033[m", line, (frame + line) % 256, line);
+            text += std::format("\033[48;5;{}m{}\033[m\033[K", 232 + (line % 24), createLine(80));
+        }
+        text += "\033[40;1H\033[7m-- INSERT --\033[m\033[K\033[12;30H";
+    }
+    return text;
+}
+
+/// Long colored lines on a wide page, like build logs on a 4K monitor.
+std::string widePageChunk()
+{
+    auto text = std::string();
+    for (int i = 0; i < 64; ++i)
+    {
+        for (int segment = 0; segment < 8; ++segment)
+            text += std::format("\033[3{}m{}", (i + segment) % 8, createLine(20 + size_t(rand() % 60)));
+        text += "\033[m\r\n";
+    }
+    return text;
+}
 
-    return EXIT_SUCCESS;
+/// Mixed CJK, emoji (including modifiers, flags and ZWJ sequences) and ASCII text.
+std::string cjkAndEmojiChunk()
+{
+    static constexpr auto Words = std::array<std::string_view, 10> {
+        "漢字", "ひらがな", "カタカナ", "한국어", "中文文本", //
+        "😀",   "👍🏽",     "🇩🇪",     "👨‍👩‍👧",  "ascii",
+    };
+    auto text = std::string();
+    for (int line = 0; line < 128; ++line)
+    {
+        for (int i = 0; i < 12; ++i)
+        {
+            text += Words[size_t(rand()) % Words.size()];
+            text += ' ';
+        }
+        text += "\r\n";
+    }
+    return text;
+}
+
+/// File names each being a hyperlink, like ls --hyperlink.
+std::string hyperlinkChunk()
+{
+    auto text = std::string();
+    for (int i = 0; i < 512; ++i)
+    {
+        auto const id = rand() % 1000;
+        text += std::format("\033]8;id={0};file://localhost/home/user/project/src/file{0}.cpp\033\\"
+                            "file{0}.cpp\033]8;;\033\\  ",
+                            id);
+        if (i % 4 == 3)
+            text += "\r\n";
+    }
+    return text;
 }
 
+/// Sixel images of 64x48 pixels, each followed by a caption, like img2sixel over a directory.
+std::string sixelChunk()
+{
+    auto text = std::string();
+    for (int image = 0; image < 16; ++image)
+    {
+        text += "\033P0;0;0q\"1;1;64;48";
+        for (int color = 0; color < 4; ++color)
+            text += std::format("#{};2;{};{};{}", color, (image * 7) % 100, color * 30, 100 - (color * 20));
+        for (int row = 0; row < 8; ++row)
+        {
+            for (int color = 0; color < 4; ++color)
+            {
+                auto const fill = "~@NoB{"[size_t(row + color + image) % 6];
+                text += std::format("#{}!{}{}!{}?$", color, 16 * (color + 1), fill, 64 - (16 * (color + 1)));
+            }
+            text += '-';
+        }
+        text += std::format("\033\\\r\nimage {:02}\r\n", image);
+    }
+    return text;
+}
+
+/// Fills the history of the given terminal with lines of varying length, many of them wrapped.
+///
+/// The first line contains the word "needle", so that searching for it scans all of them.
+void fillHistory(HeadlessTerm& vt, size_t lineCount)
+{
+    constexpr auto BatchSize = size_t { 10'000 };
+    writeToTerminal(vt, "needle\r\n");
+    for (auto lines = size_t { 1 }; lines < lineCount;)
+    {
+        auto batch = std::string();
+        for (auto const end = std::min(lines + BatchSize, lineCount); lines < end; ++lines)
+            batch += createLine(20 + (lines % 180)) + "\r\n";
+        writeToTerminal(vt, batch);
+    }
+}
+
+TestResult runWorkload(Workload const& workload,
+                           size_t testSizeBytes,
+                           vtbackend::CellLayout cellLayout)
+{
+    auto vt = HeadlessTerm(workload.pageSize, vtbackend::LineCount(4000), 1'000'000, cellLayout);
+    vt.terminal.setMode(vtbackend::DECMode::AutoWrap, true);
+    if (workload.setup)
+        workload.setup(vt.terminal);
+
+    auto const chunk = workload.createChunk();
+    return measure(workload.name, {}, [&]() {
+        auto bytesWritten = size_t { 0 };
+        while (bytesWritten < testSizeBytes)
+        {
+            writeToTerminal(vt, chunk);
+            bytesWritten += chunk.size();
+        }
+        return bytesWritten;
+    });
+}
+
+/// Resizes a terminal with a large history back and forth, reflowing all of its lines.
+TestResult runReflow(size_t historyLineCount, vtbackend::CellLayout cellLayout)
+{
+    using vtbackend::ColumnCount;
+    using vtbackend::LineCount;
+
+    constexpr auto Resizes = 4;
+    auto const pageSize = vtbackend::PageSize { LineCount(25), ColumnCount(80) };
+    auto vt = HeadlessTerm(pageSize, LineCount::cast_from(historyLineCount), 1'000'000, cellLayout);
+    vt.terminal.setMode(vtbackend::DECMode::AutoWrap, true);
+    fillHistory(vt, historyLineCount);
+
+    return measure("reflow", "lines", [&]() {
+        auto linesReflowed = size_t { 0 };
+        for (auto i = 0; i < Resizes; ++i)
+        {
+            vt.terminal.resizeScreen(
+                vtbackend::PageSize { pageSize.lines, i % 2 == 0 ? ColumnCount(132) : pageSize.columns });
+            vt.terminal.visitPrimaryScreen([&](auto& screen) {
+                screen.grid().reflowPendingHistory();
+                linesReflowed += unbox<size_t>(screen.historyLineCount());
+            });
+        }
+        return linesReflowed;
+    });
+}
+
+/// Searches backwards through a large history for a word in its very first line.
+TestResult runSearch(size_t historyLineCount, vtbackend::CellLayout cellLayout)
+{
+    using vtbackend::ColumnCount;
+    using vtbackend::LineCount;
+
+    constexpr auto Searches = 4;
+    auto const pageSize = vtbackend::PageSize { LineCount(25), ColumnCount(80) };
+    auto vt = HeadlessTerm(pageSize, LineCount::cast_from(historyLineCount), 1'000'000, cellLayout);
+    vt.terminal.setMode(vtbackend::DECMode::AutoWrap, true);
+    fillHistory(vt, historyLineCount);
+
+    auto const bottomRight = vtbackend::CellLocation {
+        .line = boxed_cast<vtbackend::LineOffset>(pageSize.lines) - 1,
+        .column = boxed_cast<vtbackend::ColumnOffset>(pageSize.columns) - 1,
+    };
+    return measure("search", "lines", [&]() {
+        auto linesSearched = size_t { 0 };
+        for (auto i = 0; i < Searches; ++i)
+        {
+            (void) vt.terminal.searchReverse(U"needle", bottomRight);
+            linesSearched += historyLineCount;
+        }
+        return linesSearched;
+    });
+}
+
+} // namespace
+// }}}
+
 namespace CLI = crispy::cli;
 
 class ContourHeadlessBench: public crispy::app
@@ -114,8 +747,11 @@ class ContourHeadlessBench: public crispy::app
             Project { "termbench-pro", "Apache-2.0", "https://github.com/contour-terminal/termbench-pro" },
             Project { "fmt", "MIT", "https://github.com/fmtlib/fmt" });
         link("bench-headless.parser", bind(&ContourHeadlessBench::benchParserOnly, this));
+        link("bench-headless.sequence", bind(&ContourHeadlessBench::benchSequenceBuilder, this));
         link("bench-headless.grid", bind(&ContourHeadlessBench::benchGrid, this));
-        link("bench-headless.pty", bind(&ContourHeadlessBench::benchPTY));
+        link("bench-headless.pty", bind(&ContourHeadlessBench::benchPTY, this));
+        link("bench-headless.workload", bind(&ContourHeadlessBench::benchWorkloads, this));
+        link("bench-headless.replay", bind(&ContourHeadlessBench::benchReplay, this));
         link("bench-headless.meta", bind(&ContourHeadlessBench::showMetaInfo));
 
         char const* logFilterString = getenv("LOG");
@@ -128,13 +764,62 @@ class ContourHeadlessBench: public crispy::app
 
     [[nodiscard]] crispy::cli::command parameterDefinition() const override
     {
-        auto const perfOptions = CLI::option_list {
+        auto const reportOptions = CLI::option_list {
+            CLI::option { "json",
+                          CLI::value { std::string() },
+                          "Writes the results as JSON to the given file.",
+                          "FILE" },
+            CLI::option { "compare",
+                          CLI::value { std::string() },
+                          "Compares the results with those of a JSON file written before, "
+                          "and exits with failure if any test regressed.",
+                          "FILE" },
+            CLI::option { "threshold",
+                          CLI::value { 10u },
+                          "Percentage by which throughput may drop or allocations may grow before "
+                          "a test counts as regressed.",
+                          "PERCENT" },
+        };
+        auto const withReportOptions = [&](CLI::option_list options) {
+            options.insert(options.end(), reportOptions.begin(), reportOptions.end());
+            return options;
+        };
+
+        auto const perfOptions = withReportOptions(CLI::option_list {
             CLI::option { "size", CLI::value { 32u }, "Number of megabyte to process per test.", "MB" },
             CLI::option { "cat", CLI::value { false }, "Enable cat-style short-line ASCII stream test." },
             CLI::option { "long", CLI::value { false }, "Enable long-line ASCII stream test." },
             CLI::option { "sgr", CLI::value { false }, "Enable SGR stream test." },
             CLI::option { "binary", CLI::value { false }, "Enable binary stream test." },
-        };
+        });
+
+        auto gridOptions = perfOptions;
+        gridOptions.emplace_back(CLI::option { "cell-layout",
+                                               CLI::value { std::string("compact") },
+                                               "Cell type the screens store their contents in.",
+                                               "compact|simple" });
+
+        auto const workloadOptions = withReportOptions(CLI::option_list {
+            CLI::option { "size", CLI::value { 16u }, "Number of megabyte to write per output test.", "MB" },
+            CLI::option { "lines",
+                          CLI::value { 1'000'000u },
+                          "Number of history lines for the reflow and search tests.",
+                          "COUNT" },
+            CLI::option { "cell-layout",
+                          CLI::value { std::string("compact") },
+                          "Cell type the screens store their contents in.",
+                          "compact|simple" },
+            CLI::option { "margins", CLI::value { false }, "Enable DECSTBM margin scrolling test." },
+            CLI::option {
+                "repaint", CLI::value { false }, "Enable cursor-addressed full-screen repaint test." },
+            CLI::option { "wide", CLI::value { false }, "Enable wide page (400x120) test." },
+            CLI::option { "cjk", CLI::value { false }, "Enable CJK and emoji text test." },
+            CLI::option { "hyperlinks", CLI::value { false }, "Enable hyperlink-heavy output test." },
+            CLI::option { "sixel", CLI::value { false }, "Enable Sixel image test." },
+            CLI::option {
+                "reflow", CLI::value { false }, "Enable resize with reflow on a large history test." },
+            CLI::option { "search", CLI::value { false }, "Enable search through a large history test." },
+        });
 
         return CLI::command {
             "bench-headless",
@@ -149,12 +834,44 @@ class ContourHeadlessBench: public crispy::app
                                "Shows the license, and project URL of the used projects and Contour." },
                 CLI::command { "grid",
                                "Performs performance tests utilizing the full grid including VT parser.",
-                               perfOptions },
+                               gridOptions },
+                CLI::command { "workload",
+                               "Performs performance tests modeled after real-world terminal workloads, "
+                               "reporting their throughput and allocations.",
+                               workloadOptions },
+                CLI::command {
+                    "replay",
+                    "Replays a PTY recording (see contour terminal record) through the terminal, "
+                    "in the chunks it was recorded in.",
+                    withReportOptions(CLI::option_list {
+                        CLI::option { "file",
+                                      CLI::value { std::string() },
+                                      "PTY recording to replay.",
+                                      "FILE",
+                                      CLI::presence::Required },
+                        CLI::option { "realtime",
+                                      CLI::value { false },
+                                      "Replays the output no faster than it has been recorded." },
+                        CLI::option { "cell-layout",
+                                      CLI::value { std::string("compact") },
+                                      "Cell type the screens store their contents in.",
+                                      "compact|simple" },
+                    }) },
                 CLI::command {
                     "parser", "Performs performance tests utilizing the VT parser only.", perfOptions },
+                CLI::command { "sequence",
+                               "Performs performance tests utilizing the VT parser and sequence builder, "
+                               "including the SGR fast path, but without a screen.",
+                               perfOptions },
                 CLI::command {
                     "pty",
-                    "Performs performance tests utilizing the underlying operating system's PTY only." },
+                    "Performs performance tests utilizing the underlying operating system's PTY only.",
+                    withReportOptions(CLI::option_list {
+                        CLI::option { "fastpipe",
+                                      CLI::value { false },
+                                      "Writes through the stdout fastpipe (using vmsplice where supported) "
+                                      "instead of the PTY slave." },
+                    }) },
             }
         };
     }
@@ -182,16 +899,71 @@ class ContourHeadlessBench: public crispy::app
         return opts;
     }
 
+    /// Writes the results as JSON and compares them with a baseline, as far as requested.
+    int report(string_view kind, std::vector<TestResult> const& results)
+    {
+        auto const prefix = std::format("bench-headless.{}.", kind);
+
+        if (auto const& path = parameters().str(prefix + "json"); !path.empty())
+        {
+            auto file = std::ofstream(path);
+            file << testResultsToJson(kind, results);
+            if (!file)
+            {
+                std::cerr << std::format("Failed to write results to {}\n", path);
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (auto const& path = parameters().str(prefix + "compare"); !path.empty())
+        {
+            auto file = std::ifstream(path);
+            auto const json = std::string(std::istreambuf_iterator<char>(file), {});
+            if (!file)
+            {
+                std::cerr << std::format("Failed to read baseline from {}\n", path);
+                return EXIT_FAILURE;
+            }
+            auto const threshold = parameters().uint(prefix + "threshold");
+            auto const title = std::format("Comparison with {} (threshold: {}%)", path, threshold);
+            cout << title << '\n' << string(title.size(), '-') << '\n';
+            auto const passed = compareWithBaseline(results, parseBaseline(json), threshold);
+            cout << '\n';
+            if (!passed)
+                return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    std::optional<vtbackend::CellLayout> cellLayoutFor(string_view kind)
+    {
+        auto const& cellLayoutName = parameters().str(std::format("bench-headless.{}.cell-layout", kind));
+        if (cellLayoutName == "simple")
+            return vtbackend::CellLayout::Simple;
+        if (cellLayoutName == "compact")
+            return vtbackend::CellLayout::Compact;
+        std::cerr << std::format("Invalid cell layout: {}\n", cellLayoutName);
+        return std::nullopt;
+    }
+
     int benchGrid()
     {
+        auto const& cellLayoutName = parameters().str("bench-headless.grid.cell-layout");
+        auto const cellLayoutOpt = cellLayoutFor("grid");
+        if (!cellLayoutOpt)
+            return EXIT_FAILURE;
+        auto const cellLayout = *cellLayoutOpt;
+
         auto pageSize = vtbackend::PageSize { vtbackend::LineCount(25), vtbackend::ColumnCount(80) };
         size_t const ptyReadBufferSize = 1'000'000;
         auto maxHistoryLineCount = vtbackend::LineCount(4000);
-        auto vt = vtbackend::MockTerm<vtpty::MockViewPty>(pageSize, maxHistoryLineCount, ptyReadBufferSize);
+        auto vt = vtbackend::MockTerm<vtpty::MockViewPty>(
+            pageSize, maxHistoryLineCount, ptyReadBufferSize, cellLayout);
         auto* pty = dynamic_cast<vtpty::MockViewPty*>(&vt.terminal.device());
         vt.terminal.setMode(vtbackend::DECMode::AutoWrap, true);
 
-        auto const rv = baseBenchmark(
+        auto const results = baseBenchmark(
             [&](char const* a, size_t b) -> bool {
                 if (pty->isClosed())
                     return false;
@@ -204,13 +976,151 @@ class ContourHeadlessBench: public crispy::app
                 return true;
             },
             benchOptionsFor("grid"),
-            "terminal with screen buffer");
-        if (rv == EXIT_SUCCESS)
-            cout << std::format("{:>12}: {}\n\n", "history size", *vt.terminal.maxHistoryLineCount());
-        return rv;
+            std::format("terminal with screen buffer ({} cells)", cellLayoutName));
+        cout << std::format("{:>12}: {}\n\n", "history size", *vt.terminal.maxHistoryLineCount());
+        return report("grid", results);
+    }
+
+    int benchWorkloads()
+    {
+        using vtbackend::ColumnCount;
+        using vtbackend::LineCount;
+        using vtbackend::PageSize;
+
+        auto const cellLayout = cellLayoutFor("workload");
+        if (!cellLayout)
+            return EXIT_FAILURE;
+
+        auto const testSizeBytes = size_t { parameters().uint("bench-headless.workload.size") } * 1024 * 1024;
+        auto const historyLineCount = size_t { parameters().uint("bench-headless.workload.lines") };
+
+        auto const workloads = std::vector<Workload> {
+            { .name = "margins",
+              .pageSize = PageSize { LineCount(24), ColumnCount(80) },
+              .createChunk = marginScrollingChunk },
+            { .name = "repaint",
+              .pageSize = PageSize { LineCount(40), ColumnCount(120) },
+              .createChunk = fullScreenRepaintChunk },
+            { .name = "wide",
+              .pageSize = PageSize { LineCount(120), ColumnCount(400) },
+              .createChunk = widePageChunk },
+            { .name = "cjk",
+              .pageSize = PageSize { LineCount(24), ColumnCount(80) },
+              .createChunk = cjkAndEmojiChunk },
+            { .name = "hyperlinks",
+              .pageSize = PageSize { LineCount(24), ColumnCount(80) },
+              .createChunk = hyperlinkChunk },
+            { .name = "sixel",
+              .pageSize = PageSize { LineCount(24), ColumnCount(80) },
+              .createChunk = sixelChunk,
+              .setup =
+                  [](vtbackend::Terminal& terminal) {
+                      using vtbackend::Height;
+                      using vtbackend::Width;
+                      terminal.setCellPixelSize(vtbackend::ImageSize { Width(10), Height(20) });
+                      terminal.setMode(vtbackend::DECMode::NoSixelScrolling, false);
+                  } },
+        };
+
+        auto const enabled = [&](string_view name) {
+            return parameters().boolean(std::format("bench-headless.workload.{}", name));
+        };
+        auto const anyEnabled = std::ranges::any_of(workloads, [&](auto const& w) { return enabled(w.name); })
+                                || enabled("reflow") || enabled("search");
+
+        auto const titleText = std::format("Running workload benchmark (test size: {} MB, history: {} lines)",
+                                           testSizeBytes / (1024 * 1024),
+                                           historyLineCount);
+        cout << titleText << '\n' << string(titleText.size(), '=') << '\n';
+
+        auto results = std::vector<TestResult> {};
+        for (auto const& workload: workloads)
+        {
+            if (anyEnabled && !enabled(workload.name))
+                continue;
+            cout << std::format("Running test {} ...\n", workload.name);
+            results.emplace_back(runWorkload(workload, testSizeBytes, *cellLayout));
+        }
+        if (!anyEnabled || enabled("reflow"))
+        {
+            cout << "Running test reflow ...\n";
+            results.emplace_back(runReflow(historyLineCount, *cellLayout));
+        }
+        if (!anyEnabled || enabled("search"))
+        {
+            cout << "Running test search ...\n";
+            results.emplace_back(runSearch(historyLineCount, *cellLayout));
+        }
+
+        cout << '\n';
+        cout << "Results\n";
+        cout << "-------\n";
+        printTestResults(results);
+        cout << '\n';
+
+        return report("workload", results);
     }
 
-    static int benchPTY()
+    int benchReplay()
+    {
+        auto const cellLayout = cellLayoutFor("replay");
+        if (!cellLayout)
+            return EXIT_FAILURE;
+
+        auto const path = parameters().str("bench-headless.replay.file");
+        auto const realTime = parameters().boolean("bench-headless.replay.realtime");
+        auto recording = std::optional<vtpty::PtyRecording> {};
+        try
+        {
+            recording = vtpty::PtyRecording::load(path);
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+
+        auto const titleText = std::format("Replaying {} ({} events{})",
+                                           path,
+                                           recording->events.size(),
+                                           realTime ? ", in real time" : "");
+        cout << titleText << '\n' << string(titleText.size(), '=') << '\n';
+
+        auto vt = HeadlessTerm(recording->pageSize, vtbackend::LineCount(4000), 1'000'000, *cellLayout);
+        auto const result = measure("replay", {}, [&]() {
+            auto const startTime = std::chrono::steady_clock::now();
+            auto bytesWritten = size_t { 0 };
+            for (auto const& event: recording->events)
+            {
+                switch (event.type)
+                {
+                    case vtpty::PtyRecordingEvent::Type::Output:
+                        if (realTime)
+                            std::this_thread::sleep_until(startTime + event.time);
+                        writeToTerminal(vt, event.data);
+                        bytesWritten += event.data.size();
+                        break;
+                    case vtpty::PtyRecordingEvent::Type::Resize:
+                        vt.terminal.resizeScreen(event.pageSize);
+                        break;
+                    case vtpty::PtyRecordingEvent::Type::Input:
+                        // The application's answers are part of the recorded output already.
+                        break;
+                }
+            }
+            return bytesWritten;
+        });
+
+        cout << '\n';
+        cout << "Results\n";
+        cout << "-------\n";
+        printTestResults({ result });
+        cout << '\n';
+
+        return report("replay", { result });
+    }
+
+    int benchPTY()
     {
         using std::chrono::steady_clock;
         using vtpty::ColumnCount;
@@ -225,14 +1135,33 @@ class ContourHeadlessBench: public crispy::app
         auto constexpr PtyWriteSize = 4096;
         auto constexpr PtyReadSize = 4096;
         auto const benchTime = chrono::seconds(10);
+        auto const fastPipe = parameters().boolean("bench-headless.pty.fastpipe");
 
         // Setup benchmark
         std::string const text = createText(PtyWriteSize);
         unique_ptr<Pty> ptyObject = createPty(PageSize { LineCount(25), ColumnCount(80) }, std::nullopt);
         auto& pty = *ptyObject;
+        pty.start();
         auto& ptySlave = pty.slave();
         (void) ptySlave.configure();
 
+        // The text is never modified, so it may be spliced into the fastpipe over and over again.
+        auto writeText = std::function<void()> { [&]() {
+            (void) ptySlave.write(text);
+        } };
+        if (fastPipe)
+        {
+#if !defined(_WIN32)
+            auto const fd = dynamic_cast<vtpty::UnixPty&>(pty).stdoutFastPipe().writer();
+            writeText = [fd, &text]() {
+                (void) vtpty::writeToStdoutFastPipe(fd, text);
+            };
+#else
+            std::cerr << "The stdout fastpipe is not supported on this platform.\n";
+            return EXIT_FAILURE;
+#endif
+        }
+
         auto bufferObjectPool = crispy::buffer_object_pool<char>(4llu * 1024 * 1024);
         auto bufferObject = bufferObjectPool.allocateBufferObject();
 
@@ -258,12 +1187,13 @@ class ContourHeadlessBench: public crispy::app
 
         // Perform benchmark
         std::cout << std::format("Running PTY benchmark ...\n");
+        auto const measurement = TestMeasurement("pty");
         auto const startTime = steady_clock::now();
         auto stopTime = startTime;
         while (stopTime - startTime < benchTime)
         {
             for (int i = 0; i < WritesPerLoop; ++i)
-                (void) ptySlave.write(text);
+                writeText();
             stopTime = steady_clock::now();
         }
 
@@ -271,6 +1201,9 @@ class ContourHeadlessBench: public crispy::app
 
         // Create summary
         auto const elapsedTime = stopTime - startTime;
+        // Measured up to the end of writing, without waiting for the reader to finish.
+        auto result = measurement.finish(bytesTransferred);
+        result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsedTime);
         auto const msecs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime);
         auto const secs = std::chrono::duration_cast<std::chrono::seconds>(elapsedTime);
         auto const mbPerSecs =
@@ -279,6 +1212,7 @@ class ContourHeadlessBench: public crispy::app
         std::cout << std::format("\n");
         std::cout << std::format("PTY stdout throughput bandwidth test\n");
         std::cout << std::format("====================================\n\n");
+        std::cout << std::format("Write path             : {}\n", fastPipe ? "stdout fastpipe" : "PTY slave");
         std::cout << std::format("Writes per loop        : {}\n", WritesPerLoop);
         std::cout << std::format("PTY write size         : {}\n", PtyWriteSize);
         std::cout << std::format("PTY read size          : {}\n", PtyReadSize);
@@ -293,21 +1227,40 @@ class ContourHeadlessBench: public crispy::app
                                                              / static_cast<long double>(loopIterations))));
         std::cout << std::format("Transfer speed         : {} per second\n",
                                  crispy::humanReadableBytes(static_cast<uint64_t>(mbPerSecs)));
+        std::cout << std::format("Allocations            : {} ({})\n\n",
+                                 result.allocations.count,
+                                 crispy::humanReadableBytes(result.allocations.bytes));
 
-        return EXIT_SUCCESS;
+        return report("pty", { result });
     }
 
     int benchParserOnly()
     {
         auto po = vtparser::NullParserEvents {};
         auto parser = vtparser::Parser<vtparser::ParserEvents> { po };
-        return baseBenchmark(
-            [&](char const* a, size_t b) -> bool {
-                parser.parseFragment(string_view(a, b));
-                return true;
-            },
-            benchOptionsFor("parser"),
-            "Parser only");
+        return report("parser",
+                      baseBenchmark(
+                          [&](char const* a, size_t b) -> bool {
+                              parser.parseFragment(string_view(a, b));
+                              return true;
+                          },
+                          benchOptionsFor("parser"),
+                          "Parser only"));
+    }
+
+    int benchSequenceBuilder()
+    {
+        auto sequenceBuilder =
+            vtbackend::SequenceBuilder { NullSequenceHandler {}, vtbackend::NoOpInstructionCounter {} };
+        auto parser = vtparser::Parser<decltype(sequenceBuilder)> { sequenceBuilder };
+        return report("sequence",
+                      baseBenchmark(
+                          [&](char const* a, size_t b) -> bool {
+                              parser.parseFragment(string_view(a, b));
+                              return true;
+                          },
+                          benchOptionsFor("sequence"),
+                          "Parser and sequence builder"));
     }
 };
 
@@ -74,8 +74,9 @@ concept CellConcept = requires(T t, T const& u) {
     t.setUnderlineColor(Color {});
     { u.underlineColor() } noexcept -> std::same_as<Color>;
 
-    { u.imageFragment() } -> std::same_as<std::shared_ptr<ImageFragment>>;
+    { u.imageFragment() } -> std::same_as<std::shared_ptr<ImageFragment> const&>;
     t.setImageFragment(std::shared_ptr<RasterizedImage> {}, CellLocation {} /*offset*/);
+    t.discardImageFragment();
 
     { u.hyperlink() } -> std::same_as<HyperlinkId>;
     t.setHyperlink(HyperlinkId {});
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/cell/CompactCell.h>
+#include <vtbackend/cell/SimpleCell.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_template_test_macros.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace vtbackend;
+
+namespace
+{
+
+auto constexpr CellCount = size_t { 200 };
+
+GraphicsAttributes coloredAttributes()
+{
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+    sgr.backgroundColor = Color::Indexed(IndexedColor::Blue);
+    return sgr;
+}
+
+// Cells using the rarely used cell data, which CompactCell keeps out of line.
+template <typename Cell>
+std::vector<Cell> cellsWithExtras()
+{
+    auto sgr = coloredAttributes();
+    sgr.underlineColor = RGBColor(0xFF0000);
+    sgr.flags |= CellFlag::CurlyUnderlined;
+
+    auto cells = std::vector<Cell>(CellCount);
+    for (auto& cell: cells)
+    {
+        cell.write(sgr, U'e', 1, HyperlinkId(1));
+        (void) cell.appendCharacter(U'\u0301'); // COMBINING ACUTE ACCENT
+    }
+    return cells;
+}
+
+} // namespace
+
+TEMPLATE_TEST_CASE("Cell.write", "[cell]", SimpleCell, CompactCell)
+{
+    auto cells = std::vector<TestType>(CellCount);
+    auto const sgr = coloredAttributes();
+
+    BENCHMARK("codepoint")
+    {
+        for (auto& cell: cells)
+            cell.write(sgr, U'a', 1);
+        return cells.size();
+    };
+
+    BENCHMARK("codepoint with hyperlink")
+    {
+        for (auto& cell: cells)
+            cell.write(sgr, U'a', 1, HyperlinkId(1));
+        return cells.size();
+    };
+
+    BENCHMARK("text only")
+    {
+        for (auto& cell: cells)
+            cell.writeTextOnly(U'b', 1);
+        return cells.size();
+    };
+}
+
+TEMPLATE_TEST_CASE("Cell.reset", "[cell]", SimpleCell, CompactCell)
+{
+    auto const sgr = coloredAttributes();
+
+    BENCHMARK_ADVANCED("plain")(Catch::Benchmark::Chronometer meter)
+    {
+        auto cells = std::vector<TestType>(CellCount, TestType { sgr });
+        meter.measure([&] {
+            for (auto& cell: cells)
+                cell.reset(sgr);
+            return cells.size();
+        });
+    };
+
+    BENCHMARK_ADVANCED("with extras")(Catch::Benchmark::Chronometer meter)
+    {
+        auto samples = std::vector<std::vector<TestType>>(static_cast<size_t>(meter.runs()),
+                                                          cellsWithExtras<TestType>());
+        meter.measure([&](int i) {
+            for (auto& cell: samples[static_cast<size_t>(i)])
+                cell.reset(sgr);
+            return samples.size();
+        });
+    };
+}
+
+TEMPLATE_TEST_CASE("Cell.copy", "[cell]", SimpleCell, CompactCell)
+{
+    auto target = std::vector<TestType>(CellCount);
+
+    auto const plain = std::vector<TestType>(CellCount, TestType { coloredAttributes() });
+    BENCHMARK("plain")
+    {
+        std::copy(plain.begin(), plain.end(), target.begin());
+        return target.size();
+    };
+
+    auto const withExtras = cellsWithExtras<TestType>();
+    BENCHMARK("with extras")
+    {
+        std::copy(withExtras.begin(), withExtras.end(), target.begin());
+        return target.size();
+    };
+}
@@ -6,6 +6,9 @@ namespace vtbackend
 
 std::u32string CompactCell::codepoints() const
 {
+    if (hasInternedCluster())
+        return std::u32string(internedCluster());
+
     std::u32string s;
     if (_codepoint)
     {
@@ -23,6 +26,9 @@ std::u32string CompactCell::codepoints() const
 
 std::string CompactCell::toUtf8() const
 {
+    if (hasInternedCluster())
+        return unicode::convert_to<char>(internedCluster());
+
     if (!_codepoint)
         return {};
 
@@ -7,6 +7,8 @@
 #include <vtbackend/GraphicsAttributes.h>
 #include <vtbackend/Hyperlink.h>
 #include <vtbackend/Image.h>
+#include <vtbackend/cell/CompactColor.h>
+#include <vtbackend/cell/GraphemeClusterTable.h>
 #include <vtbackend/primitives.h>
 
 #include <crispy/Owned.h>
@@ -17,8 +19,10 @@
 #include <libunicode/convert.h>
 #include <libunicode/width.h>
 
+#include <array>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 
 namespace vtbackend
@@ -38,6 +42,8 @@ struct CellExtra
     ///
     /// Since MOST content in the terminal is US-ASCII, all codepoints except the first one of a grapheme
     /// cluster is stored in CellExtra.
+    ///
+    /// Only used for clusters that could not be interned anymore, see CompactCell.
     std::u32string codepoints = {};
 
     /// Color for underline decoration (such as curly underline).
@@ -49,18 +55,26 @@ struct CellExtra
     /// Holds a reference to an image tile to be rendered (above the text, if any).
     std::shared_ptr<ImageFragment> imageFragment = nullptr;
 
-    /// Cell flags.
-    CellFlags flags = CellFlag::None;
-
-    /// In terminals, the Unicode's East asian Width property is used to determine the
-    /// number of columns, a graphical character is spanning.
-    /// Since most graphical characters in a terminal will be US-ASCII, this width property
-    /// will be only used when NOT being 1.
-    uint8_t width = 1;
+#if defined(LIBTERMINAL_COMPACT_CELL_COLORS)
+    /// Colors of the cell that did not fit into its CompactColor encoding.
+    Color foregroundColor = DefaultColor();
+    Color backgroundColor = DefaultColor();
+#endif
 };
 
 /// Grid cell with character and graphics rendition information.
 ///
+/// Cell flags and width are stored inline, as they are changed by every SGR and wide character,
+/// so that a CellExtra is only allocated for the actually rare data.
+///
+/// If built with LIBTERMINAL_COMPACT_CELL_COLORS, the foreground and background colors are stored
+/// as CompactColor, shrinking each cell by four bytes.
+///
+/// Grapheme clusters of more than one codepoint, such as emoji sequences and combining marks, are
+/// interned into a process-wide table. The cell stores the slot of its cluster in place of its
+/// primary codepoint, beyond the Unicode codepoint range, rather than allocating a CellExtra for it.
+/// Once the table is full, the codepoints following the primary one are kept in CellExtra instead.
+///
 /// TODO(perf): ensure POD'ness so that we can SIMD-copy it.
 /// - Requires moving out CellExtra into Line<T>?
 class CRISPY_PACKED CompactCell
@@ -69,6 +83,10 @@ class CRISPY_PACKED CompactCell
     // NOLINTNEXTLINE(readability-identifier-naming)
     static uint8_t constexpr MaxCodepoints = 7;
 
+    /// Base of the values of the primary codepoint that refer to an interned grapheme cluster.
+    // NOLINTNEXTLINE(readability-identifier-naming)
+    static char32_t constexpr InternedClusterBase = 0x110000;
+
     CompactCell() noexcept;
     CompactCell(CompactCell const& v) noexcept;
     CompactCell& operator=(CompactCell const& v) noexcept;
@@ -107,13 +125,9 @@ class CRISPY_PACKED CompactCell
         return flags().contains(testFlags);
     }
 
-    void resetFlags() noexcept
-    {
-        if (_extra)
-            _extra->flags = CellFlag::None;
-    }
+    void resetFlags() noexcept { _flags = CellFlag::None; }
 
-    void resetFlags(CellFlags flags) noexcept { extra().flags = flags; }
+    void resetFlags(CellFlags flags) noexcept { _flags = flags; }
 
     [[nodiscard]] Color underlineColor() const noexcept;
     void setUnderlineColor(Color color) noexcept;
@@ -122,8 +136,9 @@ class CRISPY_PACKED CompactCell
     [[nodiscard]] Color backgroundColor() const noexcept;
     void setBackgroundColor(Color color) noexcept;
 
-    [[nodiscard]] std::shared_ptr<ImageFragment> imageFragment() const noexcept;
+    [[nodiscard]] std::shared_ptr<ImageFragment> const& imageFragment() const noexcept;
     void setImageFragment(std::shared_ptr<RasterizedImage> rasterizedImage, CellLocation offset);
+    void discardImageFragment() noexcept;
 
     void setCharacter(char32_t codepoint) noexcept;
     [[nodiscard]] int appendCharacter(char32_t codepoint) noexcept;
@@ -134,18 +149,40 @@ class CRISPY_PACKED CompactCell
 
     [[nodiscard]] bool empty() const noexcept;
 
+    /// @returns the number of bytes of extra data this cell holds on the heap, if any.
+    [[nodiscard]] size_t extraMemoryUsage() const noexcept;
+
     void setGraphicsRendition(GraphicsRendition sgr) noexcept;
 
   private:
     [[nodiscard]] CellExtra& extra() noexcept;
 
+    [[nodiscard]] bool hasInternedCluster() const noexcept { return _codepoint >= InternedClusterBase; }
+    [[nodiscard]] std::u32string_view internedCluster() const noexcept
+    {
+        return detail::internedGraphemeCluster(static_cast<uint32_t>(_codepoint - InternedClusterBase));
+    }
+
     template <typename... Args>
     void createExtra(Args... args) noexcept;
 
+    void setColors(Color foreground, Color background) noexcept;
+
     // CompactCell data
     char32_t _codepoint = 0; /// Primary Unicode codepoint to be displayed.
+#if defined(LIBTERMINAL_COMPACT_CELL_COLORS)
+    CompactColor _foregroundColor = CompactColor(DefaultColor());
+    CompactColor _backgroundColor = CompactColor(DefaultColor());
+#else
     Color _foregroundColor = DefaultColor();
     Color _backgroundColor = DefaultColor();
+#endif
+    CellFlags _flags = CellFlag::None;
+
+    /// In terminals, the Unicode's East asian Width property is used to determine the
+    /// number of columns, a graphical character is spanning.
+    uint8_t _width = 1;
+
     crispy::owned<CellExtra> _extra = {};
     // TODO(perf) ^^ use CellExtraId = boxed<int24_t> into pre-alloc'ed vector<CellExtra>.
 };
@@ -164,28 +201,24 @@ inline void CompactCell::createExtra(Args... args) noexcept
     }
 }
 
-inline CompactCell::CompactCell() noexcept
-{
-    setWidth(1);
-}
+inline CompactCell::CompactCell() noexcept = default;
 
 inline CompactCell::CompactCell(GraphicsAttributes attributes, HyperlinkId hyperlink) noexcept:
-    _foregroundColor { attributes.foregroundColor }, _backgroundColor { attributes.backgroundColor }
+    _flags { attributes.flags }
 {
-    setWidth(1);
+    setColors(attributes.foregroundColor, attributes.backgroundColor);
     setHyperlink(hyperlink);
 
-    if (attributes.underlineColor != DefaultColor() || _extra)
+    if (attributes.underlineColor != DefaultColor())
         extra().underlineColor = attributes.underlineColor;
-
-    if (attributes.flags != CellFlag::None || _extra)
-        extra().flags = attributes.flags;
 }
 
 inline CompactCell::CompactCell(CompactCell const& v) noexcept:
     _codepoint { v._codepoint },
     _foregroundColor { v._foregroundColor },
-    _backgroundColor { v._backgroundColor }
+    _backgroundColor { v._backgroundColor },
+    _flags { v._flags },
+    _width { v._width }
 {
     if (v._extra)
         createExtra(*v._extra);
@@ -193,11 +226,18 @@ inline CompactCell::CompactCell(CompactCell const& v) noexcept:
 
 inline CompactCell& CompactCell::operator=(CompactCell const& v) noexcept
 {
+    if (this == &v)
+        return *this;
+
     _codepoint = v._codepoint;
     _foregroundColor = v._foregroundColor;
     _backgroundColor = v._backgroundColor;
+    _flags = v._flags;
+    _width = v._width;
     if (v._extra)
         createExtra(*v._extra);
+    else
+        _extra.reset();
     return *this;
 }
 // }}}
@@ -205,19 +245,19 @@ inline CompactCell& CompactCell::operator=(CompactCell const& v) noexcept
 inline void CompactCell::reset() noexcept
 {
     _codepoint = 0;
-    _foregroundColor = DefaultColor();
-    _backgroundColor = DefaultColor();
+    setColors(DefaultColor(), DefaultColor());
+    _flags = CellFlag::None;
+    _width = 1;
     _extra.reset();
 }
 
 inline void CompactCell::reset(GraphicsAttributes const& attributes) noexcept
 {
     _codepoint = 0;
-    _foregroundColor = attributes.foregroundColor;
-    _backgroundColor = attributes.backgroundColor;
+    _flags = attributes.flags;
+    _width = 1;
     _extra.reset();
-    if (attributes.flags != CellFlag::None)
-        extra().flags = attributes.flags;
+    setColors(attributes.foregroundColor, attributes.backgroundColor);
     if (attributes.underlineColor != DefaultColor())
         extra().underlineColor = attributes.underlineColor;
 }
@@ -233,11 +273,8 @@ inline void CompactCell::write(GraphicsAttributes const& attributes, char32_t ch
         _extra->imageFragment = {};
     }
 
-    _foregroundColor = attributes.foregroundColor;
-    _backgroundColor = attributes.backgroundColor;
-
-    if (attributes.flags != CellFlag::None || _extra)
-        extra().flags = attributes.flags;
+    setColors(attributes.foregroundColor, attributes.backgroundColor);
+    _flags = attributes.flags;
 
     if (attributes.underlineColor != DefaultColor())
         extra().underlineColor = attributes.underlineColor;
@@ -255,16 +292,14 @@ inline void CompactCell::write(GraphicsAttributes const& attributes,
         _extra->imageFragment = {};
     }
 
-    _foregroundColor = attributes.foregroundColor;
-    _backgroundColor = attributes.backgroundColor;
+    setColors(attributes.foregroundColor, attributes.backgroundColor);
+    _flags = attributes.flags;
 
-    if (attributes.flags != CellFlag::None || _extra || attributes.underlineColor != DefaultColor()
-        || !!hyperlink)
+    if (_extra || attributes.underlineColor != DefaultColor() || !!hyperlink)
     {
         CellExtra& ext = extra();
         ext.underlineColor = attributes.underlineColor;
         ext.hyperlink = hyperlink;
-        ext.flags = attributes.flags;
     }
 }
 
@@ -279,14 +314,13 @@ inline void CompactCell::writeTextOnly(char32_t ch, uint8_t width) noexcept
 inline void CompactCell::reset(GraphicsAttributes const& attributes, HyperlinkId hyperlink) noexcept
 {
     _codepoint = 0;
-    _foregroundColor = attributes.foregroundColor;
-    _backgroundColor = attributes.backgroundColor;
+    _flags = attributes.flags;
+    _width = 1;
 
     _extra.reset();
+    setColors(attributes.foregroundColor, attributes.backgroundColor);
     if (attributes.underlineColor != DefaultColor())
         extra().underlineColor = attributes.underlineColor;
-    if (attributes.flags != CellFlag::None)
-        extra().flags = attributes.flags;
     if (hyperlink != HyperlinkId())
         extra().hyperlink = hyperlink;
 }
@@ -294,17 +328,13 @@ inline void CompactCell::reset(GraphicsAttributes const& attributes, HyperlinkId
 // {{{ impl: character
 inline constexpr uint8_t CompactCell::width() const noexcept
 {
-    return !_extra ? 1 : _extra->width;
-    // return static_cast<int>((_codepoint >> 21) & 0x03); //return _width;
+    return _width;
 }
 
 inline void CompactCell::setWidth(uint8_t width) noexcept
 {
     assert(width < MaxCodepoints);
-    // _codepoint = _codepoint | ((width << 21) & 0x03);
-    if (width > 1 || _extra)
-        extra().width = width;
-    // TODO(perf) use u32_unused_bit_mask()
+    _width = width;
 }
 
 inline void CompactCell::setCharacter(char32_t codepoint) noexcept
@@ -325,21 +355,45 @@ inline int CompactCell::appendCharacter(char32_t codepoint) noexcept
 {
     assert(codepoint != 0);
 
-    CellExtra& ext = extra();
-    if (ext.codepoints.size() < MaxCodepoints - 1)
+    static_assert(MaxCodepoints <= detail::MaxInternedClusterSize);
+    auto const count = codepointCount();
+    if (count >= MaxCodepoints)
+        return 0;
+
+    if (_codepoint && (!_extra || _extra->codepoints.empty()))
     {
-        ext.codepoints.push_back(codepoint);
-        if (auto const diff = CellUtil::computeWidthChange(*this, codepoint))
+        auto cluster = std::array<char32_t, MaxCodepoints> {};
+        for (size_t i = 0; i < count; ++i)
+            cluster[i] = this->codepoint(i);
+        cluster[count] = codepoint;
+
+        if (auto const slot = detail::internGraphemeCluster(std::u32string_view(cluster.data(), count + 1)))
+            _codepoint = InternedClusterBase + *slot;
+        else
         {
-            setWidth(static_cast<uint8_t>(static_cast<int>(width()) + diff));
-            return diff;
+            // The cluster table is full, so the codepoints are kept by the cell itself.
+            _codepoint = cluster[0];
+            extra().codepoints.assign(cluster.data() + 1, count);
         }
     }
+    else if (extra().codepoints.size() < MaxCodepoints - 1u)
+        _extra->codepoints.push_back(codepoint);
+    else
+        return 0;
+
+    if (auto const diff = CellUtil::computeWidthChange(*this, codepoint))
+    {
+        setWidth(static_cast<uint8_t>(static_cast<int>(width()) + diff));
+        return diff;
+    }
     return 0;
 }
 
 inline std::size_t CompactCell::codepointCount() const noexcept
 {
+    if (hasInternedCluster())
+        return internedCluster().size();
+
     if (_codepoint)
     {
         if (!_extra)
@@ -352,6 +406,12 @@ inline std::size_t CompactCell::codepointCount() const noexcept
 
 inline char32_t CompactCell::codepoint(size_t i) const noexcept
 {
+    if (hasInternedCluster())
+    {
+        auto const cluster = internedCluster();
+        return i < cluster.size() ? cluster[i] : 0;
+    }
+
     if (i == 0)
         return _codepoint;
 
@@ -376,12 +436,44 @@ inline CellExtra& CompactCell::extra() noexcept
 
 inline CellFlags CompactCell::flags() const noexcept
 {
-    if (!_extra)
-        return CellFlag::None;
-    else
-        return const_cast<CompactCell*>(this)->_extra->flags;
+    return _flags;
+}
+
+#if defined(LIBTERMINAL_COMPACT_CELL_COLORS)
+inline Color CompactCell::foregroundColor() const noexcept
+{
+    if (_foregroundColor.isSpilled())
+        return _extra->foregroundColor;
+    return _foregroundColor.color();
+}
+
+inline void CompactCell::setForegroundColor(Color color) noexcept
+{
+    _foregroundColor = CompactColor(color);
+    if (_foregroundColor.isSpilled())
+        extra().foregroundColor = color;
+}
+
+inline Color CompactCell::backgroundColor() const noexcept
+{
+    if (_backgroundColor.isSpilled())
+        return _extra->backgroundColor;
+    return _backgroundColor.color();
+}
+
+inline void CompactCell::setBackgroundColor(Color color) noexcept
+{
+    _backgroundColor = CompactColor(color);
+    if (_backgroundColor.isSpilled())
+        extra().backgroundColor = color;
 }
 
+inline void CompactCell::setColors(Color foreground, Color background) noexcept
+{
+    setForegroundColor(foreground);
+    setBackgroundColor(background);
+}
+#else
 inline Color CompactCell::foregroundColor() const noexcept
 {
     return _foregroundColor;
@@ -402,6 +494,13 @@ inline void CompactCell::setBackgroundColor(Color color) noexcept
     _backgroundColor = color;
 }
 
+inline void CompactCell::setColors(Color foreground, Color background) noexcept
+{
+    _foregroundColor = foreground;
+    _backgroundColor = background;
+}
+#endif
+
 inline Color CompactCell::underlineColor() const noexcept
 {
     if (!_extra)
@@ -418,12 +517,13 @@ inline void CompactCell::setUnderlineColor(Color color) noexcept
         extra().underlineColor = color;
 }
 
-inline std::shared_ptr<ImageFragment> CompactCell::imageFragment() const noexcept
+inline std::shared_ptr<ImageFragment> const& CompactCell::imageFragment() const noexcept
 {
+    static auto const noImageFragment = std::shared_ptr<ImageFragment> {};
     if (_extra)
         return _extra->imageFragment;
     else
-        return {};
+        return noImageFragment;
 }
 
 inline void CompactCell::setImageFragment(std::shared_ptr<RasterizedImage> rasterizedImage,
@@ -433,6 +533,12 @@ inline void CompactCell::setImageFragment(std::shared_ptr<RasterizedImage> raste
     ext.imageFragment = std::make_shared<ImageFragment>(std::move(rasterizedImage), offset);
 }
 
+inline void CompactCell::discardImageFragment() noexcept
+{
+    if (_extra)
+        _extra->imageFragment = {};
+}
+
 inline HyperlinkId CompactCell::hyperlink() const noexcept
 {
     if (_extra)
@@ -441,6 +547,13 @@ inline HyperlinkId CompactCell::hyperlink() const noexcept
         return HyperlinkId {};
 }
 
+inline size_t CompactCell::extraMemoryUsage() const noexcept
+{
+    if (!_extra)
+        return 0;
+    return sizeof(CellExtra) + _extra->codepoints.capacity() * sizeof(char32_t);
+}
+
 inline void CompactCell::setHyperlink(HyperlinkId hyperlink)
 {
     if (!!hyperlink)
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/cell/CompactColor.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace vtbackend::detail
+{
+
+namespace
+{
+    struct RGBColorTable
+    {
+        std::mutex mutex;
+        std::unordered_map<uint32_t, uint16_t> codes;
+        std::array<RGBColor, CompactColor::RGBCapacity> colors {};
+        std::atomic<size_t> count = 0;
+    };
+
+    RGBColorTable& rgbColorTable() noexcept
+    {
+        static RGBColorTable table;
+        return table;
+    }
+
+    // Most cells written in a row share their colors, so that each thread keeps a small cache
+    // of the colors it interned, in order to not lock the table for each of them.
+    struct CachedCode
+    {
+        uint32_t rgb = 0xFFFFFFFF; // not a valid RGB value, so that empty entries never match
+        uint16_t code = CompactColor::SpilledCode;
+    };
+
+    constexpr size_t CacheSize = 64;
+
+    thread_local std::array<CachedCode, CacheSize> cachedCodes {};
+
+    uint16_t internUncached(uint32_t rgb) noexcept
+    {
+        auto& table = rgbColorTable();
+        auto const lock = std::scoped_lock { table.mutex };
+        try
+        {
+            if (auto const i = table.codes.find(rgb); i != table.codes.end())
+                return i->second;
+
+            auto const slot = table.count.load(std::memory_order_relaxed);
+            if (slot == CompactColor::RGBCapacity)
+                return CompactColor::SpilledCode;
+
+            // The color is written before its code is handed out, and cells are only read by
+            // other threads after synchronizing with the one that wrote them.
+            table.colors[slot] = RGBColor(rgb);
+            auto const code = static_cast<uint16_t>(CompactColor::RGBBase + slot);
+            table.codes.emplace(rgb, code);
+            table.count.store(slot + 1, std::memory_order_relaxed);
+            return code;
+        }
+        catch (std::bad_alloc const&)
+        {
+            return CompactColor::SpilledCode;
+        }
+    }
+} // namespace
+
+uint16_t internRGBColor(RGBColor color) noexcept
+{
+    auto const rgb = color.value();
+    auto& cached = cachedCodes[(rgb * 0x9E3779B1U) >> 26];
+    if (cached.rgb != rgb)
+        cached = CachedCode { .rgb = rgb, .code = internUncached(rgb) };
+    return cached.code;
+}
+
+RGBColor internedRGBColor(uint16_t slot) noexcept
+{
+    return rgbColorTable().colors[slot];
+}
+
+size_t internedRGBColorCount() noexcept
+{
+    return rgbColorTable().count.load(std::memory_order_relaxed);
+}
+
+} // namespace vtbackend::detail
@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Color.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vtbackend
+{
+
+namespace detail
+{
+    /// Interns the given RGB color into the process-wide color table.
+    ///
+    /// @returns the code of the interned color, or CompactColor::SpilledCode if the table is full.
+    [[nodiscard]] uint16_t internRGBColor(RGBColor color) noexcept;
+
+    /// @returns the RGB color interned at the given slot of the process-wide color table.
+    [[nodiscard]] RGBColor internedRGBColor(uint16_t slot) noexcept;
+
+    /// @returns the number of RGB colors interned so far.
+    [[nodiscard]] size_t internedRGBColorCount() noexcept;
+} // namespace detail
+
+/// Color encoded into 16 bits, as stored by CompactCell if built with LIBTERMINAL_COMPACT_CELL_COLORS.
+///
+/// Default, indexed and bright colors are encoded inline, whereas RGB colors are interned into a
+/// process-wide table and referred to by their slot in it.
+///
+/// Interned colors are never evicted, so that cells need not reference-count the colors they use.
+/// Once the table is full, RGB colors not interned yet are encoded as spilled instead,
+/// and must be kept by the cell elsewhere.
+///
+/// Layout:
+///
+///   0x0000            undefined
+///   0x0001            default
+///   0x0002            spilled RGB color
+///   0x0100 | index    indexed
+///   0x0200 | index    bright
+///   0x0400 + slot     interned RGB color
+class CompactColor
+{
+  public:
+    // NOLINTBEGIN(readability-identifier-naming)
+    static constexpr uint16_t UndefinedCode = 0x0000;
+    static constexpr uint16_t DefaultCode = 0x0001;
+    static constexpr uint16_t SpilledCode = 0x0002;
+    static constexpr uint16_t IndexedBase = 0x0100;
+    static constexpr uint16_t BrightBase = 0x0200;
+    static constexpr uint16_t RGBBase = 0x0400;
+
+    /// Maximum number of RGB colors that can be interned.
+    static constexpr size_t RGBCapacity = 0x10000 - RGBBase;
+    // NOLINTEND(readability-identifier-naming)
+
+    constexpr CompactColor() noexcept = default;
+
+    explicit CompactColor(Color color) noexcept: _code { encode(color) } {}
+
+    [[nodiscard]] constexpr uint16_t code() const noexcept { return _code; }
+
+    /// Tests whether this is an RGB color that could not be interned anymore.
+    [[nodiscard]] constexpr bool isSpilled() const noexcept { return _code == SpilledCode; }
+
+    /// @returns the color encoded, which must not be a spilled one.
+    [[nodiscard]] Color color() const noexcept
+    {
+        if (_code >= RGBBase)
+            return Color { detail::internedRGBColor(static_cast<uint16_t>(_code - RGBBase)) };
+        if (_code >= BrightBase)
+            return Color::Bright(static_cast<uint8_t>(_code & 0xFF));
+        if (_code >= IndexedBase)
+            return Color::Indexed(static_cast<uint8_t>(_code & 0xFF));
+        if (_code == DefaultCode)
+            return Color::Default();
+        return Color::Undefined();
+    }
+
+    constexpr bool operator==(CompactColor const&) const noexcept = default;
+
+  private:
+    [[nodiscard]] static uint16_t encode(Color color) noexcept
+    {
+        switch (color.type())
+        {
+            case ColorType::Undefined: return UndefinedCode;
+            case ColorType::Default: return DefaultCode;
+            case ColorType::Bright: return static_cast<uint16_t>(BrightBase | color.index());
+            case ColorType::Indexed: return static_cast<uint16_t>(IndexedBase | color.index());
+            case ColorType::RGB: return detail::internRGBColor(color.rgb());
+        }
+        return UndefinedCode;
+    }
+
+    uint16_t _code = UndefinedCode;
+};
+
+} // namespace vtbackend
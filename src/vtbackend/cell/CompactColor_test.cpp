@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/cell/CompactColor.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace vtbackend;
+
+TEST_CASE("CompactColor.inline", "[CompactColor]")
+{
+    CHECK(CompactColor(Color::Undefined()).color() == Color::Undefined());
+    CHECK(CompactColor(Color::Default()).color() == Color::Default());
+    CHECK(CompactColor(Color(BrightColor::Cyan)).color() == Color(BrightColor::Cyan));
+    for (auto i = 0; i < 256; ++i)
+    {
+        auto const color = Color::Indexed(static_cast<uint8_t>(i));
+        CHECK(CompactColor(color).color() == color);
+        CHECK(CompactColor(color).code() < CompactColor::RGBBase);
+    }
+    CHECK(CompactColor(Color::Indexed(1)) != CompactColor(Color::Bright(1)));
+}
+
+TEST_CASE("CompactColor.RGB", "[CompactColor]")
+{
+    auto const red = Color { RGBColor { 0xFF, 0x10, 0x20 } };
+    auto const green = Color { RGBColor { 0x10, 0xFF, 0x20 } };
+
+    auto const a = CompactColor(red);
+    auto const b = CompactColor(green);
+    REQUIRE(!a.isSpilled());
+    REQUIRE(!b.isSpilled());
+    CHECK(a.code() >= CompactColor::RGBBase);
+    CHECK(a.color() == red);
+    CHECK(b.color() == green);
+    CHECK(a != b);
+
+    // Interning the same color again yields the same code, without growing the table.
+    auto const count = detail::internedRGBColorCount();
+    CHECK(CompactColor(red) == a);
+    CHECK(CompactColor(green) == b);
+    CHECK(detail::internedRGBColorCount() == count);
+}
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/cell/GraphemeClusterTable.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace vtbackend::detail
+{
+
+namespace
+{
+    struct GraphemeCluster
+    {
+        std::array<char32_t, MaxInternedClusterSize> codepoints {};
+        uint8_t size = 0;
+
+        [[nodiscard]] std::u32string_view view() const noexcept { return { codepoints.data(), size }; }
+    };
+
+    struct GraphemeClusterTable
+    {
+        std::mutex mutex;
+        std::unordered_map<std::u32string_view, uint32_t> slots; // viewing into the clusters below
+        std::array<GraphemeCluster, GraphemeClusterCapacity> clusters {};
+        std::atomic<size_t> count = 0;
+    };
+
+    GraphemeClusterTable& graphemeClusterTable() noexcept
+    {
+        static GraphemeClusterTable table;
+        return table;
+    }
+
+    // Emoji and combining marks tend to repeat within the output of an application, so that each
+    // thread keeps a small cache of the clusters it interned, in order to not lock the table for each.
+    constexpr size_t CacheSize = 64;
+    constexpr uint32_t NoSlot = 0xFFFFFFFF;
+
+    thread_local std::array<uint32_t, CacheSize> cachedSlots = [] {
+        auto slots = std::array<uint32_t, CacheSize> {};
+        slots.fill(NoSlot);
+        return slots;
+    }();
+
+    [[nodiscard]] size_t cacheIndex(std::u32string_view codepoints) noexcept
+    {
+        auto hash = uint32_t { 0 };
+        for (char32_t const codepoint: codepoints)
+            hash = (hash ^ static_cast<uint32_t>(codepoint)) * 0x9E3779B1U;
+        return hash >> 26;
+    }
+
+    std::optional<uint32_t> internUncached(std::u32string_view codepoints) noexcept
+    {
+        auto& table = graphemeClusterTable();
+        auto const lock = std::scoped_lock { table.mutex };
+        try
+        {
+            if (auto const i = table.slots.find(codepoints); i != table.slots.end())
+                return i->second;
+
+            auto const slot = table.count.load(std::memory_order_relaxed);
+            if (slot == GraphemeClusterCapacity)
+                return std::nullopt;
+
+            // The cluster is written before its slot is handed out, and cells are only read by
+            // other threads after synchronizing with the one that wrote them.
+            auto& cluster = table.clusters[slot];
+            std::ranges::copy(codepoints, cluster.codepoints.begin());
+            cluster.size = static_cast<uint8_t>(codepoints.size());
+            table.slots.emplace(cluster.view(), static_cast<uint32_t>(slot));
+            table.count.store(slot + 1, std::memory_order_relaxed);
+            return static_cast<uint32_t>(slot);
+        }
+        catch (std::bad_alloc const&)
+        {
+            return std::nullopt;
+        }
+    }
+} // namespace
+
+std::optional<uint32_t> internGraphemeCluster(std::u32string_view codepoints) noexcept
+{
+    if (codepoints.empty() || codepoints.size() > MaxInternedClusterSize)
+        return std::nullopt;
+
+    auto& cached = cachedSlots[cacheIndex(codepoints)];
+    if (cached != NoSlot && internedGraphemeCluster(cached) == codepoints)
+        return cached;
+
+    auto const slot = internUncached(codepoints);
+    if (slot)
+        cached = *slot;
+    return slot;
+}
+
+std::u32string_view internedGraphemeCluster(uint32_t slot) noexcept
+{
+    return graphemeClusterTable().clusters[slot].view();
+}
+
+size_t internedGraphemeClusterCount() noexcept
+{
+    return graphemeClusterTable().count.load(std::memory_order_relaxed);
+}
+
+} // namespace vtbackend::detail
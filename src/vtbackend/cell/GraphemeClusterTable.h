@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace vtbackend::detail
+{
+
+/// Maximum number of codepoints of an interned grapheme cluster.
+constexpr inline size_t MaxInternedClusterSize = 7;
+
+/// Maximum number of grapheme clusters that can be interned.
+constexpr inline size_t GraphemeClusterCapacity = 0x10000;
+
+/// Interns the given grapheme cluster of up to MaxInternedClusterSize codepoints into the
+/// process-wide cluster table, which CompactCell refers to for cells of more than one codepoint.
+///
+/// Interned clusters are never evicted, so that cells need not reference-count the clusters they use.
+///
+/// @returns the slot of the interned cluster, or std::nullopt if the table is full.
+[[nodiscard]] std::optional<uint32_t> internGraphemeCluster(std::u32string_view codepoints) noexcept;
+
+/// @returns the codepoints of the grapheme cluster interned at the given slot.
+[[nodiscard]] std::u32string_view internedGraphemeCluster(uint32_t slot) noexcept;
+
+/// @returns the number of grapheme clusters interned so far.
+[[nodiscard]] size_t internedGraphemeClusterCount() noexcept;
+
+} // namespace vtbackend::detail
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/cell/CompactCell.h>
+#include <vtbackend/cell/GraphemeClusterTable.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string_view>
+
+using namespace vtbackend;
+using namespace std::string_view_literals;
+
+TEST_CASE("GraphemeClusterTable.intern", "[GraphemeClusterTable]")
+{
+    auto const family = U"\U0001F468\u200D\U0001F469\u200D\U0001F467"sv;
+    auto const flag = U"\U0001F1E9\U0001F1EA"sv;
+
+    auto const a = detail::internGraphemeCluster(family);
+    auto const b = detail::internGraphemeCluster(flag);
+    REQUIRE(a.has_value());
+    REQUIRE(b.has_value());
+    CHECK(*a != *b);
+    CHECK(detail::internedGraphemeCluster(*a) == family);
+    CHECK(detail::internedGraphemeCluster(*b) == flag);
+
+    // Interning a cluster once more refers to the same slot.
+    auto const count = detail::internedGraphemeClusterCount();
+    CHECK(detail::internGraphemeCluster(family) == a);
+    CHECK(detail::internGraphemeCluster(std::u32string(flag)) == b);
+    CHECK(detail::internedGraphemeClusterCount() == count);
+
+    CHECK(!detail::internGraphemeCluster(U""sv).has_value());
+    CHECK(!detail::internGraphemeCluster(U"12345678"sv).has_value());
+}
+
+TEST_CASE("GraphemeClusterTable.CompactCell", "[GraphemeClusterTable]")
+{
+    auto cell = CompactCell {};
+    cell.write(GraphicsAttributes {}, U'e', 1);
+    CHECK(cell.appendCharacter(0x0301) == 0);
+    CHECK(cell.codepointCount() == 2);
+    CHECK(cell.codepoint(0) == U'e');
+    CHECK(cell.codepoint(1) == 0x0301);
+    CHECK(cell.codepoint(2) == 0);
+    CHECK(cell.codepoints() == U"e\u0301");
+    CHECK(cell.toUtf8() == "e\xCC\x81");
+
+    // The cluster is kept without any extra data on the heap.
+    CHECK(cell.extraMemoryUsage() == 0);
+
+    // Cells are limited in the number of codepoints they hold.
+    for (auto i = 0; i < 10; ++i)
+        (void) cell.appendCharacter(0x0302);
+    CHECK(cell.codepointCount() == CompactCell::MaxCodepoints);
+
+    // Overwriting the cell drops its cluster.
+    cell.writeTextOnly(U'x', 1);
+    CHECK(cell.codepointCount() == 1);
+    CHECK(cell.codepoints() == U"x");
+}
@@ -68,8 +68,9 @@ class SimpleCell
     [[nodiscard]] Color backgroundColor() const noexcept;
     [[nodiscard]] Color underlineColor() const noexcept;
 
-    [[nodiscard]] std::shared_ptr<ImageFragment> imageFragment() const noexcept;
+    [[nodiscard]] std::shared_ptr<ImageFragment> const& imageFragment() const noexcept;
     void setImageFragment(std::shared_ptr<RasterizedImage> image, CellLocation offset);
+    void discardImageFragment() noexcept;
 
     [[nodiscard]] HyperlinkId hyperlink() const noexcept;
     void setHyperlink(HyperlinkId hyperlink) noexcept;
@@ -243,7 +244,7 @@ inline Color SimpleCell::underlineColor() const noexcept
     return _graphicsAttributes.underlineColor;
 }
 
-inline std::shared_ptr<ImageFragment> SimpleCell::imageFragment() const noexcept
+inline std::shared_ptr<ImageFragment> const& SimpleCell::imageFragment() const noexcept
 {
     return _imageFragment;
 }
@@ -254,6 +255,11 @@ inline void SimpleCell::setImageFragment(std::shared_ptr<RasterizedImage> raster
     _imageFragment = std::make_shared<ImageFragment>(std::move(rasterizedImage), offset);
 }
 
+inline void SimpleCell::discardImageFragment() noexcept
+{
+    _imageFragment = {};
+}
+
 inline HyperlinkId SimpleCell::hyperlink() const noexcept
 {
     return _hyperlink;
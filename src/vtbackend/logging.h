@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <crispy/allocations.h>
 #include <crispy/logstore.h>
 
 namespace vtbackend
@@ -19,4 +20,10 @@ auto const inline vtTraceSequenceLog = logstore::category("vt.trace.sequence", "
 
 auto const inline renderBufferLog = logstore::category("vt.renderbuffer", "Render Buffer Objects");
 
+// Allocations made while parsing, by the screen processing the parsed sequences,
+// and while filling render buffers.
+auto inline parserAllocations = crispy::allocations::counter { "parser" };
+auto inline screenAllocations = crispy::allocations::counter { "screen" };
+auto inline renderBufferAllocations = crispy::allocations::counter { "render_buffer" };
+
 } // namespace vtbackend
@@ -463,6 +463,16 @@ enum class ScreenType : uint8_t
     Alternate = 1,
 };
 
+// Selects the cell type the primary and alternate screens store their contents in.
+enum class CellLayout : uint8_t
+{
+    // CompactCell, keeping rarely used cell data out of line. Favors long histories.
+    Compact = 0,
+
+    // SimpleCell, keeping all cell data inline. Favors contents such as images and hyperlinks.
+    Simple = 1,
+};
+
 // TODO: Maybe make boxed.h into its own C++ github repo?
 // TODO: Differentiate Line/Column types for DECOM enabled/disabled coordinates?
 //
@@ -47,15 +47,17 @@ template <typename S>
 
     vtbackend::CellLocation lastPos = {};
     size_t lastCount = 0;
-    for (vtbackend::RenderCell const& cell: renderBuffer.buffer->cells)
+    auto const& cells = renderBuffer.buffer->cells;
+    for (size_t i = 0; i < cells.size(); ++i)
     {
-        auto const gap = (cell.position.column + static_cast<int>(lastCount) - 1) - lastPos.column;
-        auto& currentLine = lines.at(unbox<size_t>(cell.position.line));
+        auto const position = cells.positions[i];
+        auto const gap = (position.column + static_cast<int>(lastCount) - 1) - lastPos.column;
+        auto& currentLine = lines.at(unbox<size_t>(position.line));
         if (*gap > 0) // Did we jump?
             currentLine.insert(currentLine.end(), unbox<size_t>(gap) - 1, ' ');
 
-        currentLine += unicode::convert_to<char>(std::u32string_view(cell.codepoints));
-        lastPos = cell.position;
+        currentLine += unicode::convert_to<char>(cells.codepoints(i));
+        lastPos = position;
         lastCount = 1;
     }
     for (vtbackend::RenderLine const& line: renderBuffer.buffer->lines)
@@ -113,7 +115,7 @@ void logScreenTextAlways(Screen<T> const& screen, std::string const& headline =
 template <typename T>
 void logScreenTextAlways(MockTerm<T> const& mock, std::string const& headline = "")
 {
-    logScreenTextAlways(mock.terminal.primaryScreen(), headline);
+    mock.terminal.visitPrimaryScreen([&](auto const& screen) { logScreenTextAlways(screen, headline); });
 }
 
 template <typename T>
@@ -130,7 +132,7 @@ void logScreenText(Screen<T> const& screen, std::string const& headline = "")
 
 inline void logScreenText(vtbackend::Terminal const& terminal, std::string const& headline = "")
 {
-    logScreenText(terminal.primaryScreen(), headline);
+    terminal.visitPrimaryScreen([&](auto const& screen) { logScreenText(screen, headline); });
 }
 
 } // namespace vtbackend::test
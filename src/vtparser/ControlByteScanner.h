@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_AMD64)
+    #include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+#endif
+
+namespace vtparser
+{
+
+/// Tests whether or not the given byte is of any interest to the parser beyond plain printable US-ASCII,
+/// that is, any C0 control code (including ESC), DEL, or the start/continuation of a UTF-8 sequence.
+constexpr bool isControlByte(uint8_t ch) noexcept
+{
+    return ch < 0x20 || ch >= 0x7F;
+}
+
+namespace detail
+{
+    constexpr int countTrailingZeros(uint32_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(value);
+#else
+        int count = 0;
+        while (!(value & 1))
+        {
+            value >>= 1;
+            ++count;
+        }
+        return count;
+#endif
+    }
+
+    inline char const* findNextControlByteScalar(char const* begin, char const* end) noexcept
+    {
+        while (begin != end && !isControlByte(static_cast<uint8_t>(*begin)))
+            ++begin;
+        return begin;
+    }
+} // namespace detail
+
+/// Locates the next byte in the range [begin, end) that cannot be processed as plain printable US-ASCII.
+///
+/// This is used to find the end of a pure US-ASCII text run in ground state, such that
+/// the parser can hand it over in bulk without decoding UTF-8 or running grapheme segmentation.
+///
+/// The input is scanned in 32 byte strides (AVX2), 16 byte strides (SSE2, NEON),
+/// or byte-wise if no SIMD instruction set is available.
+///
+/// @returns pointer to the first control byte (C0, DEL, 0x80 and above), or @p end if there is none.
+inline char const* findNextControlByte(char const* begin, char const* end) noexcept
+{
+    auto const* input = begin;
+
+#if defined(__AVX2__)
+    auto const space = _mm256_set1_epi8(0x20);
+    auto const del = _mm256_set1_epi8(0x7F);
+    while (end - input >= 32)
+    {
+        auto const batch = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input));
+        // Signed comparison: bytes >= 0x80 are negative and thus also less than SP.
+        auto const mask = _mm256_or_si256(_mm256_cmpgt_epi8(space, batch), _mm256_cmpeq_epi8(batch, del));
+        if (auto const bits = static_cast<uint32_t>(_mm256_movemask_epi8(mask)); bits != 0)
+            return input + detail::countTrailingZeros(bits);
+        input += 32;
+    }
+#endif
+
+#if defined(__x86_64__) || defined(_M_AMD64)
+    auto const space128 = _mm_set1_epi8(0x20);
+    auto const del128 = _mm_set1_epi8(0x7F);
+    while (end - input >= 16)
+    {
+        auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+        auto const mask = _mm_or_si128(_mm_cmpgt_epi8(space128, batch), _mm_cmpeq_epi8(batch, del128));
+        if (auto const bits = static_cast<uint32_t>(_mm_movemask_epi8(mask)); bits != 0)
+            return input + detail::countTrailingZeros(bits);
+        input += 16;
+    }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    auto const space = vdupq_n_u8(0x20);
+    auto const del = vdupq_n_u8(0x7F);
+    while (end - input >= 16)
+    {
+        auto const batch = vld1q_u8(reinterpret_cast<uint8_t const*>(input));
+        auto const mask = vorrq_u8(vcltq_u8(batch, space), vcgeq_u8(batch, del));
+        if (vmaxvq_u8(mask) != 0)
+            return detail::findNextControlByteScalar(input, input + 16);
+        input += 16;
+    }
+#endif
+
+    return detail::findNextControlByteScalar(input, end);
+}
+
+} // namespace vtparser
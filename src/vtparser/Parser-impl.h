@@ -1,9 +1,11 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
+#include <vtparser/ControlByteScanner.h>
 #include <vtparser/Parser.h>
 
 #include <libunicode/utf8.h>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <string_view>
@@ -367,12 +369,68 @@ auto Parser<EventListener, TraceStateChanges>::parseBulkText(char const* begin,
 {
     auto const* input = begin;
     if (_state != State::Ground)
-        return { ProcessKind::FallbackToFSM, 0 };
+    {
+        if constexpr (BulkControlStringConcept<EventListener>)
+            return parseBulkControlString(begin, end);
+        else
+            return { ProcessKind::FallbackToFSM, 0 };
+    }
+
+    if constexpr (SGRFastPathConcept<EventListener>)
+    {
+        if (*input == '\033')
+        {
+            if (auto const count = parseSGR(input, end); count != 0)
+                return { ProcessKind::ContinueBulk, count };
+        }
+    }
 
     auto const maxCharCount = _eventListener.maxBulkTextSequenceWidth();
     if (!maxCharCount)
         return { ProcessKind::FallbackToFSM, 0 };
 
+    if (_scanState.utf8.expectedLength == 0)
+    {
+        // Fast path for pure US-ASCII text runs, as seen in colored log output (text + SGR + text).
+        // This avoids UTF-8 decoding and grapheme segmentation entirely. The run is only
+        // taken if it is not followed by a non-ASCII byte, because that may be a combining
+        // character that has to be grapheme-clustered together with the last US-ASCII character.
+        auto const limit = std::min(static_cast<size_t>(std::distance(input, end)), maxCharCount);
+        auto const* const asciiEnd = findNextControlByte(input, input + limit);
+        if (asciiEnd != input && (asciiEnd == end || static_cast<uint8_t>(*asciiEnd) < 0x80))
+        {
+            if constexpr (BulkLinesConcept<EventListener>)
+            {
+                if (asciiEnd != end && (*asciiEnd == '\n' || *asciiEnd == '\r'))
+                {
+                    auto const count = _eventListener.printLines(
+                        std::string_view { input, static_cast<size_t>(std::distance(input, end)) });
+                    if (count != 0)
+                    {
+                        // The processed lines end with LF, and the first of them is not empty.
+                        auto const* last = input + count - 1;
+                        while (*last == '\n' || *last == '\r')
+                            --last;
+                        _scanState.lastCodepointHint = static_cast<char32_t>(*last);
+                        _scanState.next = input + count;
+                        return { ProcessKind::ContinueBulk, count };
+                    }
+                }
+            }
+
+            auto const byteCount = static_cast<size_t>(std::distance(input, asciiEnd));
+            _eventListener.print(std::string_view { input, byteCount }, byteCount);
+            _scanState.lastCodepointHint = static_cast<char32_t>(asciiEnd[-1]);
+            _scanState.next = asciiEnd;
+            input = asciiEnd;
+
+            if (input != end && *input == '\n')
+                _eventListener.execute(*input++);
+
+            return { ProcessKind::ContinueBulk, static_cast<size_t>(std::distance(begin, input)) };
+        }
+    }
+
     _scanState.next = nullptr;
     auto const chunk = std::string_view(input, static_cast<size_t>(std::distance(input, end)));
     auto const [cellCount, subStart, subEnd] = unicode::scan_text(_scanState, chunk, maxCharCount);
@@ -411,6 +469,65 @@ auto Parser<EventListener, TraceStateChanges>::parseBulkText(char const* begin,
     return { ProcessKind::ContinueBulk, count };
 }
 
+template <ParserEventsConcept EventListener, bool TraceStateChanges>
+auto Parser<EventListener, TraceStateChanges>::parseBulkControlString(char const* begin, char const* end)
+    -> std::tuple<ProcessKind, size_t>
+{
+    // Only bytes that the FSM would pass on via OSC_Put (resp. Put) without changing state
+    // are consumed here. Anything else, in particular the string terminator, is left to the FSM.
+    auto const* input = begin;
+    switch (_state)
+    {
+        case State::OSC_String:
+            while (input != end && static_cast<uint8_t>(*input) >= 0x20)
+                ++input;
+            if (input != begin)
+                _eventListener.putOSC(std::string_view { begin, static_cast<size_t>(input - begin) });
+            break;
+        case State::DCS_PassThrough:
+            while (input != end && !isControlByte(static_cast<uint8_t>(*input)))
+                ++input;
+            if (input != begin)
+                _eventListener.put(std::string_view { begin, static_cast<size_t>(input - begin) });
+            break;
+        default: break;
+    }
+
+    if (input == begin)
+        return { ProcessKind::FallbackToFSM, 0 };
+
+    return { ProcessKind::ContinueBulk, static_cast<size_t>(input - begin) };
+}
+
+template <ParserEventsConcept EventListener, bool TraceStateChanges>
+size_t Parser<EventListener, TraceStateChanges>::parseSGR(char const* begin, char const* end) noexcept
+{
+    // Recognizes `ESC [ (0-9 | ; | :)* m` if fully contained in the input,
+    // and returns the number of bytes consumed, or 0 if the FSM has to take over.
+    auto constexpr MaxSequenceLength = ptrdiff_t { 64 };
+
+    auto const available = std::min(std::distance(begin, end), MaxSequenceLength);
+    if (available < 3 || begin[1] != '[' || begin[2] == ':') // A leading ':' makes the CSI ignored.
+        return 0;
+
+    auto const* const parametersBegin = begin + 2;
+    auto const* const limit = begin + available;
+    auto const* input = parametersBegin;
+    while (input != limit && ((*input >= '0' && *input <= '9') || *input == ';' || *input == ':'))
+        ++input;
+
+    if (input == limit || *input != 'm')
+        return 0;
+
+    // Mimic the FSM's actions: leaving ground state, dispatching, and re-entering ground state.
+    _eventListener.printEnd();
+    _eventListener.dispatchSGR(
+        std::string_view { parametersBegin, static_cast<size_t>(std::distance(parametersBegin, input)) });
+    _scanState.lastCodepointHint = 0;
+
+    return static_cast<size_t>(std::distance(begin, input + 1));
+}
+
 template <ParserEventsConcept EventListener, bool TraceStateChanges>
 void Parser<EventListener, TraceStateChanges>::printUtf8Byte(char ch)
 {
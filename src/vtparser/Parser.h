@@ -657,6 +657,43 @@ concept ParserEventsConcept = requires(T& handler, T const& immutable) {
     { handler.dispatchPM() } -> std::same_as<void>;
 };
 
+/**
+ * Optional extension to ParserEventsConcept for handling SGR sequences (CSI ... m) directly.
+ *
+ * If an event listener satisfies this concept, the parser recognizes complete SGR sequences
+ * in ground state without going through the state machine and passes the raw parameter
+ * string (only consisting of digits, ';' and ':') to the listener.
+ */
+template <typename T>
+concept SGRFastPathConcept = requires(T& handler) {
+    { handler.dispatchSGR(std::string_view {}) } -> std::same_as<void>;
+};
+
+/**
+ * Optional extension to ParserEventsConcept for receiving OSC and DCS payload bytes in bulk.
+ *
+ * If an event listener satisfies this concept, the parser passes contiguous runs of
+ * payload bytes as one string view (referencing the parser's input) instead of byte-by-byte.
+ */
+template <typename T>
+concept BulkControlStringConcept = requires(T& handler) {
+    { handler.putOSC(std::string_view {}) } -> std::same_as<void>;
+    { handler.put(std::string_view {}) } -> std::same_as<void>;
+};
+
+/**
+ * Optional extension to ParserEventsConcept for writing many short lines of text at once.
+ *
+ * If an event listener satisfies this concept, the parser offers the remaining input to the listener
+ * whenever a US-ASCII text run in ground state ends with LF (or CR LF). The listener may process any
+ * number of complete leading lines (US-ASCII text, each terminated by LF or CR LF), as if printed and
+ * executed one after the other, and returns the number of bytes it processed.
+ */
+template <typename T>
+concept BulkLinesConcept = requires(T& handler) {
+    { handler.printLines(std::string_view {}) } -> std::same_as<size_t>;
+};
+
 /**
  * Terminal Parser.
  *
@@ -705,6 +742,8 @@ class Parser
     };
 
     std::tuple<ProcessKind, size_t> parseBulkText(char const* begin, char const* end) noexcept;
+    size_t parseSGR(char const* begin, char const* end) noexcept;
+    std::tuple<ProcessKind, size_t> parseBulkControlString(char const* begin, char const* end);
     void processOnceViaStateMachine(uint8_t ch);
 
     void handle(ActionClass actionClass, Action action, uint8_t codepoint);
@@ -1,8 +1,11 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <crispy/BufferObject.h>
+
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace vtbackend
 {
@@ -19,25 +22,110 @@ class ParserExtension
 
     virtual void pass(char ch) = 0;
     virtual void finalize() = 0;
+
+    /// Passes a contiguous run of payload bytes at once.
+    ///
+    /// The bytes are only guaranteed to be valid for the duration of this call,
+    /// unless they are explicitly referenced from within the PTY buffer.
+    virtual void pass(std::string_view chars)
+    {
+        for (char const ch: chars)
+            pass(ch);
+    }
+
+    /// @returns the approximate number of bytes of memory held, e.g. by the payload received so far.
+    [[nodiscard]] virtual size_t memoryUsage() const noexcept { return 0; }
 };
 
+/// Collects a DCS payload and passes it on to the given callback when finalized.
+///
+/// If a PTY buffer provider is given, the payload is not copied but referenced
+/// from within the currently active PTY buffer, as long as it is contiguous.
+/// Only payloads spanning multiple PTY buffers (or being passed byte-wise) are materialized.
 class SimpleStringCollector: public ParserExtension
 {
   public:
+    using BufferProvider = std::function<crispy::buffer_object_ptr<char>()>;
+
     explicit SimpleStringCollector(std::function<void(std::string_view)> done): _done { std::move(done) } {}
 
-    void pass(char ch) override { _data.push_back(ch); }
+    SimpleStringCollector(std::function<void(std::string_view)> done, BufferProvider bufferProvider):
+        _done { std::move(done) }, _bufferProvider { std::move(bufferProvider) }
+    {
+    }
+
+    void pass(char ch) override
+    {
+        materialize();
+        _data.push_back(ch);
+    }
+
+    void pass(std::string_view chars) override
+    {
+        if (chars.empty())
+            return;
+
+        if (_data.empty() && tryReference(chars))
+            return;
+
+        materialize();
+        _data.append(chars);
+    }
+
+    [[nodiscard]] size_t memoryUsage() const noexcept override { return _data.capacity(); }
 
     void finalize() override
     {
         if (_done)
-            _done(_data);
+        {
+            if (_fragment.empty())
+                _done(_data);
+            else
+                _done(_fragment.view());
+        }
+        _fragment = {};
         _data.clear();
     }
 
   private:
+    /// Attempts to reference the given bytes within the current PTY buffer without copying.
+    bool tryReference(std::string_view chars)
+    {
+        if (!_bufferProvider)
+            return false;
+
+        auto buffer = _bufferProvider();
+        if (!buffer || chars.data() < buffer->begin() || chars.data() + chars.size() > buffer->end())
+            return false;
+
+        auto const fragmentView = _fragment.view();
+        if (fragmentView.empty())
+            _fragment = buffer->ref(static_cast<size_t>(chars.data() - buffer->data()), chars.size());
+        else if (_fragment.owner() == buffer && fragmentView.data() + fragmentView.size() == chars.data())
+            _fragment.growBy(chars.size());
+        else
+            return false;
+
+        // Protect the referenced bytes from being overwritten by subsequent PTY reads.
+        if (buffer->hotEnd() < chars.data() + chars.size())
+            buffer->advanceHotEndUntil(chars.data() + chars.size());
+
+        return true;
+    }
+
+    /// Copies any referenced bytes into the local string buffer.
+    void materialize()
+    {
+        if (_fragment.empty())
+            return;
+        _data.assign(_fragment.view());
+        _fragment = {};
+    }
+
     std::string _data;
+    crispy::buffer_fragment<char> _fragment;
     std::function<void(std::string_view)> _done;
+    BufferProvider _bufferProvider;
 };
 
 } // namespace vtbackend
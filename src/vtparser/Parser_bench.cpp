@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// Replays recorded VT streams through vtparser::Parser alone, without any Screen or Grid,
+// in order to measure parser throughput separately from the rest of the terminal.
+//
+// Usage: vtparser_bench [--min-seconds N] [CORPUS_FILE ...]
+//
+// Corpus files are raw VT byte streams as written by the application, e.g. recorded via
+// `script -q -c vim /tmp/vim.vt` or `vim ... | tee`. If no corpus is given, a set of
+// synthetic corpora (plain text, SGR heavy, UTF-8, Sixel) is generated instead.
+#include <vtparser/Parser.h>
+#include <vtparser/ParserEvents.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+/// No-op parser event listener that merely counts the events it receives.
+class CountingParserEvents final: public vtparser::NullParserEvents
+{
+  public:
+    size_t events = 0;
+    size_t maxCharCount = 80;
+
+    void print(char32_t) override { ++events; }
+    size_t print(std::string_view, size_t cellCount) override
+    {
+        ++events;
+        maxCharCount -= std::min(cellCount, maxCharCount);
+        if (!maxCharCount)
+            maxCharCount = 80;
+        return maxCharCount;
+    }
+    [[nodiscard]] size_t maxBulkTextSequenceWidth() const noexcept override { return maxCharCount; }
+    void execute(char ch) override
+    {
+        ++events;
+        if (ch == '\n')
+            maxCharCount = 80;
+    }
+    void dispatchESC(char) override { ++events; }
+    void dispatchCSI(char) override { ++events; }
+    void dispatchOSC() override { ++events; }
+    void hook(char) override { ++events; }
+    void unhook() override { ++events; }
+    void dispatchAPC() override { ++events; }
+    void dispatchPM() override { ++events; }
+};
+
+struct Corpus
+{
+    std::string name;
+    std::string data;
+};
+
+std::string repeatUntil(size_t bytes, auto&& generateChunk)
+{
+    std::string text;
+    text.reserve(bytes);
+    for (size_t i = 0; text.size() < bytes; ++i)
+        text += generateChunk(i);
+    return text;
+}
+
+std::vector<Corpus> syntheticCorpora()
+{
+    auto constexpr Size = size_t { 16 * 1024 * 1024 };
+    auto corpora = std::vector<Corpus> {};
+
+    corpora.emplace_back("cat (ASCII)", repeatUntil(Size, [](size_t i) {
+                             return std::format("{:08} The quick brown fox jumps over the lazy dog.\r\n", i);
+                         }));
+
+    corpora.emplace_back("SGR colored lines", repeatUntil(Size, [](size_t i) {
+                             return std::format("\033[38;2;{};{};{}m{:08}\033[m \033[1;32mINFO\033[0m hello\r\n",
+                                                i % 256,
+                                                (i / 3) % 256,
+                                                (i / 7) % 256,
+                                                i);
+                         }));
+
+    corpora.emplace_back("UTF-8 text", repeatUntil(Size, [](size_t i) {
+                             return std::format("{:04} Grüße, Ärger, Übel — 日本語のテキスト ✅\r\n", i % 10000);
+                         }));
+
+    corpora.emplace_back("cursor movement (TUI)", repeatUntil(Size, [](size_t i) {
+                             return std::format("\033[{};{}H\033[K\033[7m{:5}\033[27m\033[?25l", i % 24 + 1, 1, i);
+                         }));
+
+    corpora.emplace_back("Sixel", repeatUntil(Size, [](size_t i) {
+                             return std::format("\033Pq#0;2;0;0;0#1;2;100;100;0#1~~@@vv@@~~@@~~$-{}\033\\",
+                                                std::string(i % 64 + 16, '~'));
+                         }));
+
+    return corpora;
+}
+
+std::string loadFile(std::filesystem::path const& path)
+{
+    auto file = std::ifstream(path, std::ios::binary);
+    if (!file.good())
+        throw std::runtime_error(std::format("Could not open corpus file: {}", path.string()));
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+void runCorpus(Corpus const& corpus, double minSeconds)
+{
+    using clock = std::chrono::steady_clock;
+
+    auto listener = CountingParserEvents {};
+    auto parser = vtparser::Parser<vtparser::ParserEvents>(listener);
+
+    auto iterations = size_t { 0 };
+    auto const start = clock::now();
+    auto elapsed = std::chrono::duration<double>::zero();
+    do
+    {
+        parser.parseFragment(std::string_view(corpus.data));
+        ++iterations;
+        elapsed = clock::now() - start;
+    } while (elapsed.count() < minSeconds);
+
+    auto const seconds = elapsed.count();
+    auto const megaBytes = double(corpus.data.size() * iterations) / (1024.0 * 1024.0);
+    std::cout << std::format("{:<24} {:>10.2f} MB {:>10.2f} MB/s {:>14.0f} events/s\n",
+                             corpus.name,
+                             double(corpus.data.size()) / (1024.0 * 1024.0),
+                             megaBytes / seconds,
+                             double(listener.events) / seconds);
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    auto minSeconds = 1.0;
+    auto corpora = std::vector<Corpus> {};
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            auto const arg = std::string_view(argv[i]);
+            if (arg == "--min-seconds"sv && i + 1 < argc)
+                minSeconds = std::stod(argv[++i]);
+            else if (arg == "--help"sv || arg == "-h"sv)
+            {
+                std::cout << "Usage: " << argv[0] << " [--min-seconds N] [CORPUS_FILE ...]\n";
+                return EXIT_SUCCESS;
+            }
+            else
+                corpora.emplace_back(std::filesystem::path(arg).filename().string(),
+                                     loadFile(std::filesystem::path(arg)));
+        }
+
+        if (corpora.empty())
+            corpora = syntheticCorpora();
+
+        std::cout << std::format("{:<24} {:>13} {:>15} {:>23}\n", "Corpus", "Size", "Throughput", "Events");
+        for (auto const& corpus: corpora)
+            runCorpus(corpus, minSeconds);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
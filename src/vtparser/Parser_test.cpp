@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <vtparser/ControlByteScanner.h>
 #include <vtparser/Parser.h>
 #include <vtparser/ParserEvents.h>
 
@@ -14,6 +15,7 @@ class MockParserEvents final: public vtparser::NullParserEvents
     std::string text;
     std::string apc;
     std::string pm;
+    std::string csi;
     size_t maxCharCount = 80;
 
     void error(string_view const& msg) override { INFO(std::format("Parser error received. {}", msg)); }
@@ -24,6 +26,10 @@ class MockParserEvents final: public vtparser::NullParserEvents
         return maxCharCount -= cellCount;
     }
 
+    [[nodiscard]] size_t maxBulkTextSequenceWidth() const noexcept override { return maxCharCount; }
+
+    void dispatchCSI(char ch) override { csi += ch; }
+
     void startAPC() override { apc += "{"; }
     void putAPC(char ch) override { apc += ch; }
     void dispatchAPC() override { apc += "}"; }
@@ -33,6 +39,34 @@ class MockParserEvents final: public vtparser::NullParserEvents
     void dispatchPM() override { pm += "}"; }
 };
 
+class BulkControlStringEvents final: public vtparser::NullParserEvents
+{
+  public:
+    using NullParserEvents::put;
+    using NullParserEvents::putOSC;
+
+    std::string osc;
+    std::string dcs;
+    size_t oscChunks = 0;
+    size_t dcsChunks = 0;
+
+    void putOSC(char ch) override { osc += ch; }
+    void putOSC(std::string_view chars)
+    {
+        osc += chars;
+        ++oscChunks;
+    }
+
+    void hook(char ch) override { dcs += std::format("{{{}", ch); }
+    void put(char ch) override { dcs += ch; }
+    void put(std::string_view chars)
+    {
+        dcs += chars;
+        ++dcsChunks;
+    }
+    void unhook() override { dcs += "}"; }
+};
+
 TEST_CASE("Parser.utf8_single", "[Parser]")
 {
     MockParserEvents textListener;
@@ -65,3 +99,85 @@ TEST_CASE("Parser.APC")
     REQUIRE(listener.apc == "{Gi=1,a=q;}");
     REQUIRE(listener.text == "ABCDEF");
 }
+
+TEST_CASE("Parser.findNextControlByte")
+{
+    auto const check = [](std::string_view text) -> size_t {
+        return static_cast<size_t>(vtparser::findNextControlByte(text.data(), text.data() + text.size())
+                                   - text.data());
+    };
+
+    CHECK(check("") == 0);
+    CHECK(check("Hello") == 5);
+    CHECK(check("\033[m") == 0);
+
+    // Place each kind of control byte at every offset across the SIMD stride boundaries.
+    for (auto const control: { '\x00', '\x1B', '\x1F', '\x7F', '\x80', '\xC3', '\xFF' })
+    {
+        for (size_t offset = 0; offset < 100; ++offset)
+        {
+            auto text = std::string(100, 'x');
+            text[offset] = control;
+            INFO(std::format("offset {}, control 0x{:02X}", offset, static_cast<uint8_t>(control)));
+            CHECK(check(text) == offset);
+        }
+    }
+}
+
+TEST_CASE("Parser.bulk_text_interleaved_with_SGR")
+{
+    MockParserEvents listener;
+    auto p = vtparser::Parser<vtparser::ParserEvents>(listener);
+    p.parseFragment("INFO \033[32mstarted\033[m and \033[1;31mfailed\033[0m!"sv);
+    CHECK(p.state() == vtparser::State::Ground);
+    CHECK(listener.text == "INFO started and failed!");
+    CHECK(listener.csi == "mmmm");
+    CHECK(p.precedingGraphicCharacter() == U'!');
+}
+
+TEST_CASE("Parser.bulk_text_ASCII_followed_by_combining_character")
+{
+    MockParserEvents listener;
+    auto p = vtparser::Parser<vtparser::ParserEvents>(listener);
+    p.parseFragment("Caf\x65\xCC\x81 au lait"sv); // e + U+0301 (combining acute accent)
+    CHECK(listener.text == "Caf\x65\xCC\x81 au lait");
+}
+
+TEST_CASE("Parser.bulk_text_limited_by_max_char_count")
+{
+    MockParserEvents listener;
+    listener.maxCharCount = 4;
+    auto p = vtparser::Parser<vtparser::ParserEvents>(listener);
+    p.parseFragment("ABCDEFGH"sv);
+    CHECK(listener.text == "ABCDEFGH");
+}
+
+TEST_CASE("Parser.OSC_bulk_payload")
+{
+    BulkControlStringEvents listener;
+    auto p = vtparser::Parser<BulkControlStringEvents>(listener);
+    p.parseFragment("\033]8;;https://example.com/ä\033\\"sv);
+    CHECK(p.state() == vtparser::State::Ground);
+    CHECK(listener.osc == "8;;https://example.com/ä");
+    CHECK(listener.oscChunks == 1);
+
+    // Payload split across fragments, terminated by BEL.
+    listener.osc.clear();
+    listener.oscChunks = 0;
+    p.parseFragment("\033]52;c;SGVs"sv);
+    p.parseFragment("bG8=\x07"sv);
+    CHECK(p.state() == vtparser::State::Ground);
+    CHECK(listener.osc == "52;c;SGVsbG8=");
+    CHECK(listener.oscChunks == 2);
+}
+
+TEST_CASE("Parser.DCS_bulk_payload")
+{
+    BulkControlStringEvents listener;
+    auto p = vtparser::Parser<BulkControlStringEvents>(listener);
+    // C0 controls within the payload are still passed byte-wise via the state machine.
+    p.parseFragment("\033Pq#0;2;0;0;0\n#1!14~\033\\"sv);
+    CHECK(p.state() == vtparser::State::Ground);
+    CHECK(listener.dcs == "{q#0;2;0;0;0\n#1!14~}");
+    CHECK(listener.dcsChunks == 2);
+}
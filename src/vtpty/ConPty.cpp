@@ -3,6 +3,10 @@
 
 #include <crispy/BufferObject.h>
 
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <format>
 #include <utility>
 
 #include <Windows.h>
@@ -33,6 +37,41 @@ string GetLastErrorAsString()
 
     return message;
 }
+
+// Size of the pipe the pseudo console writes its output to, large enough for it not to stall on
+// bulk output while the terminal is still busy parsing the previous read.
+constexpr DWORD OutputPipeBufferSize = 128 * 1024;
+
+/// Creates the pipe the pseudo console writes its output to, whose reading end is returned in @p input.
+///
+/// It is a named pipe, as anonymous pipes do not support the overlapped I/O that reading with a
+/// timeout and waking up the reader depend on.
+bool createOutputPipe(HANDLE& input, HANDLE& output)
+{
+    static auto serial = std::atomic<unsigned> { 0 };
+    auto const name = std::format(R"(\\.\pipe\contour-conpty-{}-{})", GetCurrentProcessId(), serial++);
+
+    input = CreateNamedPipeA(name.c_str(),
+                             PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                             PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                             1,
+                             0,
+                             OutputPipeBufferSize,
+                             0,
+                             nullptr);
+    if (input == INVALID_HANDLE_VALUE)
+        return false;
+
+    output = CreateFileA(
+        name.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (output == INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(input);
+        input = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    return true;
+}
 } // anonymous namespace
 
 namespace vtpty
@@ -60,12 +99,18 @@ ConPty::ConPty(PageSize const& windowSize): _size { windowSize }
     _input = INVALID_HANDLE_VALUE;
     _output = INVALID_HANDLE_VALUE;
     _buffer.resize(10240);
+    _readEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    _wakeupEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    if (!_readEvent || !_wakeupEvent)
+        throw runtime_error { GetLastErrorAsString() };
 }
 
 ConPty::~ConPty()
 {
     ptyLog()("~ConPty()");
     close();
+    CloseHandle(_readEvent);
+    CloseHandle(_wakeupEvent);
 }
 
 bool ConPty::isClosed() const noexcept
@@ -87,7 +132,7 @@ void ConPty::start()
     if (!CreatePipe(&hPipePTYIn, &_output, NULL, 0))
         throw runtime_error { GetLastErrorAsString() };
 
-    if (!CreatePipe(&_input, &hPipePTYOut, NULL, 0))
+    if (!createOutputPipe(_input, hPipePTYOut))
     {
         CloseHandle(hPipePTYIn);
         throw runtime_error { GetLastErrorAsString() };
@@ -141,14 +186,32 @@ std::optional<Pty::ReadResult> ConPty::read(crispy::buffer_object<char>& buffer,
                                             std::optional<std::chrono::milliseconds> timeout,
                                             size_t size)
 {
-    // TODO: wait for timeout time at most AND got woken up upon wakeupReader() invokcation.
-    (void) timeout;
-
+    auto const input = _input;
     auto const n = static_cast<DWORD>(std::min(size, buffer.bytesAvailable()));
 
+    auto overlapped = OVERLAPPED {};
+    overlapped.hEvent = _readEvent;
     DWORD nread {};
-    if (!ReadFile(_input, buffer.hotEnd(), n, &nread, nullptr))
-        return nullopt;
+    if (!ReadFile(input, buffer.hotEnd(), n, &nread, &overlapped))
+    {
+        if (GetLastError() != ERROR_IO_PENDING)
+        {
+            errno = EIO;
+            return nullopt;
+        }
+
+        auto const events = std::array { _readEvent, _wakeupEvent };
+        auto const waitTime = timeout ? static_cast<DWORD>(timeout->count()) : INFINITE;
+        if (WaitForMultipleObjects(2, events.data(), FALSE, waitTime) != WAIT_OBJECT_0)
+            CancelIoEx(input, &overlapped);
+
+        // The read must have completed or been cancelled before returning, as it writes into the buffer.
+        if (!GetOverlappedResult(input, &overlapped, &nread, TRUE))
+        {
+            errno = GetLastError() == ERROR_OPERATION_ABORTED ? EAGAIN : EIO;
+            return nullopt;
+        }
+    }
 
     if (ptyInLog)
         ptyInLog()("{} received: \"{}\"", "master", crispy::escape(buffer.hotEnd(), buffer.hotEnd() + nread));
@@ -158,8 +221,7 @@ std::optional<Pty::ReadResult> ConPty::read(crispy::buffer_object<char>& buffer,
 
 void ConPty::wakeupReader()
 {
-    // TODO: Windows ConPTY does *NOT* support non-blocking / overlapped I/O.
-    // How can we make ReadFile() return early? We could maybe WriteFile() to it?
+    SetEvent(_wakeupEvent);
 }
 
 int ConPty::write(std::string_view data)
@@ -45,6 +45,10 @@ class ConPty: public Pty
     HANDLE _output;
     std::vector<char> _buffer;
     std::unique_ptr<PtySlave> _slave;
+
+    // Reads are overlapped, so that they can be given up on after a timeout or a wakeupReader().
+    HANDLE _readEvent;   // signaled once a read completes
+    HANDLE _wakeupEvent; // signaled by wakeupReader()
 };
 
 } // namespace vtpty
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtpty/FileViewPty.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <format>
+#include <stdexcept>
+
+namespace vtpty
+{
+
+namespace
+{
+    /// @returns the sequences setting up the terminal to show the given file.
+    std::string preludeOf(std::filesystem::path const& path)
+    {
+        auto title = path.filename().string();
+        std::erase_if(title, [](char ch) { return static_cast<unsigned char>(ch) < 0x20 || ch == 0x7F; });
+
+        // Sets the window title to the file's name, and enables LNM for bare line feeds to return.
+        return std::format("\033]2;{}\033\\\033[20h", title);
+    }
+} // namespace
+
+FileViewPty::FileViewPty(std::filesystem::path const& path, PageSize pageSize):
+    _prelude { preludeOf(path) }, _file { path, std::ios::binary }, _pageSize { pageSize }
+{
+    if (!_file)
+        throw std::runtime_error(std::format("Failed to open {}", path.string()));
+}
+
+void FileViewPty::start()
+{
+}
+
+PtySlave& FileViewPty::slave() noexcept
+{
+    return _slave;
+}
+
+void FileViewPty::close()
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _closed = true;
+    _wakeup.notify_all();
+}
+
+void FileViewPty::waitForClosed()
+{
+    auto lock = std::unique_lock { _mutex };
+    _wakeup.wait(lock, [this]() { return _closed; });
+}
+
+bool FileViewPty::isClosed() const noexcept
+{
+    auto const _ = std::scoped_lock { _mutex };
+    return _closed;
+}
+
+size_t FileViewPty::readChunk(char* output, size_t size)
+{
+    if (_preludeOffset < _prelude.size())
+    {
+        auto const chunk = std::string_view(_prelude).substr(_preludeOffset, size);
+        std::ranges::copy(chunk, output);
+        _preludeOffset += chunk.size();
+        return chunk.size();
+    }
+
+    // Reading stops short wherever the file ends by now, having shrunk or not.
+    _file.clear();
+    _file.seekg(static_cast<std::streamoff>(_fileOffset));
+    _file.read(output, static_cast<std::streamsize>(size));
+    auto const count = static_cast<size_t>(std::max(std::streamsize { 0 }, _file.gcount()));
+    if (count < size)
+    {
+        _endOfFile = true;
+        _fileOffset += count;
+        return count;
+    }
+
+    // Cut the chunk after its last line feed, if it has any, to read the rest along with the next one.
+    auto const chunk = std::string_view(output, count);
+    auto const lineEnd = chunk.rfind('\n');
+    auto const chunkSize = lineEnd != std::string_view::npos ? lineEnd + 1 : count;
+    _fileOffset += chunkSize;
+    return chunkSize;
+}
+
+std::optional<Pty::ReadResult> FileViewPty::read(crispy::buffer_object<char>& storage,
+                                                 std::optional<std::chrono::milliseconds> timeout,
+                                                 size_t size)
+{
+    auto lock = std::unique_lock { _mutex };
+    if (_closed)
+        return ReadResult {};
+
+    auto const count = _endOfFile ? 0 : readChunk(storage.hotEnd(), std::min(storage.bytesAvailable(), size));
+    if (count == 0 && _endOfFile)
+    {
+        // The whole file has been read, so there is nothing to wait for but being woken up or closed.
+        auto const ready = [this]() { return _closed || _wakeupRequested; };
+        if (timeout)
+            _wakeup.wait_for(lock, *timeout, ready);
+        else
+            _wakeup.wait(lock, ready);
+
+        _wakeupRequested = false;
+        if (_closed)
+            return ReadResult {};
+        errno = EAGAIN;
+        return std::nullopt;
+    }
+
+    auto const data = storage.advance(count);
+    return ReadResult { .data = std::string_view(data.data(), data.size()), .fromStdoutFastPipe = false };
+}
+
+void FileViewPty::wakeupReader()
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _wakeupRequested = true;
+    _wakeup.notify_all();
+}
+
+int FileViewPty::write(std::string_view buf)
+{
+    // There is nobody to answer to.
+    return static_cast<int>(buf.size());
+}
+
+PageSize FileViewPty::pageSize() const noexcept
+{
+    auto const _ = std::scoped_lock { _mutex };
+    return _pageSize;
+}
+
+void FileViewPty::resizeScreen(PageSize cells, std::optional<ImageSize> pixels)
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _pageSize = cells;
+    _pixelSize = pixels;
+}
+
+} // namespace vtpty
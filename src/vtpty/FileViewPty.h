@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtpty/Pty.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace vtpty
+{
+
+/// PTY showing the contents of a file, such as a log, instead of the output of a process.
+///
+/// The file is read straight into the PTY buffers, neither spawning a process nor going through
+/// a kernel PTY. It is read in chunks ending at line boundaries where possible, so that whole
+/// lines can be written to the screen at once. Line feeds also return the cursor, as they would with
+/// a kernel PTY translating them, and any escape sequences in the file are interpreted like output.
+///
+/// The file is not mapped into memory, so that it may shrink while being shown, as logs being
+/// rotated do, which would make reading the mapping beyond its new end fault. Reading simply ends there.
+///
+/// Input is discarded. Once the whole file has been read, reading waits for the PTY to be closed,
+/// so that the file remains shown rather than the terminal exiting.
+class FileViewPty: public Pty
+{
+  public:
+    /// @throws std::runtime_error if the file cannot be opened.
+    FileViewPty(std::filesystem::path const& path, PageSize pageSize);
+
+    void start() override;
+    PtySlave& slave() noexcept override;
+    void close() override;
+    void waitForClosed() override;
+    [[nodiscard]] bool isClosed() const noexcept override;
+    [[nodiscard]] std::optional<ReadResult> read(crispy::buffer_object<char>& storage,
+                                                 std::optional<std::chrono::milliseconds> timeout,
+                                                 size_t size) override;
+    void wakeupReader() override;
+    [[nodiscard]] int write(std::string_view buf) override;
+    [[nodiscard]] PageSize pageSize() const noexcept override;
+    void resizeScreen(PageSize cells, std::optional<ImageSize> pixels = std::nullopt) override;
+
+  private:
+    /// Reads the next chunk of at most @p size bytes into @p output.
+    ///
+    /// @returns the number of bytes read, 0 at the end of the file.
+    [[nodiscard]] size_t readChunk(char* output, size_t size);
+
+    std::string _prelude;        // sequences read ahead of the file, setting up the terminal to show it
+    size_t _preludeOffset = 0;   // of the next byte of the prelude to be read
+    std::ifstream _file;
+    uint64_t _fileOffset = 0;    // of the next byte of the file to be read
+    bool _endOfFile = false;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wakeup;
+    bool _wakeupRequested = false;
+    bool _closed = false;
+    PageSize _pageSize;
+    std::optional<ImageSize> _pixelSize;
+    PtySlaveDummy _slave;
+};
+
+} // namespace vtpty
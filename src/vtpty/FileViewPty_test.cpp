@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtpty/FileViewPty.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace std::chrono_literals;
+using namespace vtpty;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+fs::path writeFile(std::string const& name, std::string const& contents)
+{
+    auto const path = fs::temp_directory_path() / name;
+    auto output = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    output << contents;
+    return path;
+}
+
+PageSize pageSize()
+{
+    return PageSize { LineCount(25), ColumnCount(80) };
+}
+
+/// Reads everything the PTY has to offer until it would wait.
+std::string readAll(FileViewPty& pty, crispy::buffer_object<char>& storage, size_t chunkSize)
+{
+    auto result = std::string {};
+    while (auto const chunk = pty.read(storage, 0ms, chunkSize))
+    {
+        if (chunk->data.empty())
+            break;
+        result += chunk->data;
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("FileViewPty.reads_prelude_and_file")
+{
+    auto const path = writeFile("contour-file-view-pty-test.log", "first\nsecond\n");
+    auto pty = FileViewPty(path, pageSize());
+    auto storage = crispy::buffer_object<char>::create(4096);
+
+    auto const output = readAll(pty, *storage, 4096);
+    CHECK(output.starts_with("\033]2;contour-file-view-pty-test.log\033\\"));
+    CHECK(output.ends_with("\033[20hfirst\nsecond\n"));
+    fs::remove(path);
+}
+
+TEST_CASE("FileViewPty.chunks_end_at_line_feeds")
+{
+    auto const path = writeFile("contour-file-view-pty-chunks-test.log", "ab\ncd\nef");
+    auto pty = FileViewPty(path, pageSize());
+    auto storage = crispy::buffer_object<char>::create(4096);
+
+    // The prelude comes first, on its own.
+    CHECK(pty.read(*storage, 0ms, 4096)->data.ends_with("\033[20h"));
+
+    CHECK(pty.read(*storage, 0ms, 5)->data == "ab\n");
+    CHECK(pty.read(*storage, 0ms, 5)->data == "cd\n");
+    CHECK(pty.read(*storage, 0ms, 5)->data == "ef");
+    CHECK(!pty.read(*storage, 0ms, 5).has_value());
+    fs::remove(path);
+}
+
+TEST_CASE("FileViewPty.file_shrinking_ends_reading")
+{
+    auto const path = writeFile("contour-file-view-pty-shrink-test.log", std::string(1000, 'x') + "\n");
+    auto pty = FileViewPty(path, pageSize());
+    auto storage = crispy::buffer_object<char>::create(4096);
+
+    CHECK(pty.read(*storage, 0ms, 4096)->data.ends_with("\033[20h"));
+    fs::resize_file(path, 10);
+
+    // Only what is left of the file is read, rather than faulting beyond its end.
+    CHECK(readAll(pty, *storage, 100) == std::string(10, 'x'));
+    CHECK(!pty.read(*storage, 0ms, 100).has_value());
+    fs::remove(path);
+}
+
+TEST_CASE("FileViewPty.waits_at_end_of_file")
+{
+    auto const path = writeFile("contour-file-view-pty-wait-test.log", "");
+    auto pty = FileViewPty(path, pageSize());
+    auto storage = crispy::buffer_object<char>::create(4096);
+    (void) readAll(pty, *storage, 4096);
+
+    pty.wakeupReader();
+    CHECK(!pty.read(*storage, std::nullopt, 4096).has_value());
+
+    pty.close();
+    auto const result = pty.read(*storage, std::nullopt, 4096);
+    REQUIRE(result.has_value());
+    CHECK(result->data.empty());
+    CHECK(pty.isClosed());
+}
+
+TEST_CASE("FileViewPty.missing_file")
+{
+    CHECK_THROWS(FileViewPty(fs::temp_directory_path() / "contour-file-view-pty-missing.log", pageSize()));
+}
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtpty/Process.h>
 #include <vtpty/Pty.h>
+#include <vtpty/StdoutFastPipe.h>
 #include <vtpty/UnixPty.h>
 
 #include <crispy/overloaded.h>
@@ -35,9 +36,18 @@
 
 #include <csignal>
 
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
 
+#if defined(__linux__) && defined(__GLIBC__)
+    #if __GLIBC_PREREQ(2, 34)
+        // posix_spawn() with POSIX_SPAWN_SETSID as well as chdir and closefrom file actions.
+        #define VTPTY_USE_POSIX_SPAWN
+        #include <spawn.h>
+    #endif
+#endif
+
 using namespace std;
 using namespace std::string_view_literals;
 using crispy::trimRight;
@@ -49,9 +59,7 @@ namespace vtpty
 
 namespace
 {
-    constexpr auto StdoutFastPipeFd = 3;
-    constexpr auto StdoutFastPipeFdStr = "3"sv;
-    constexpr auto StdoutFastPipeEnvironmentName = "STDOUT_FASTPIPE"sv;
+    constexpr auto StdoutFastPipeFdStr = "3"sv; // StdoutFastPipeFd
 
     string getLastErrorAsString()
     {
@@ -95,6 +103,7 @@ struct Process::Private
     mutable std::optional<Process::ExitStatus> exitStatus {};
 
     [[nodiscard]] std::optional<ExitStatus> checkStatus(bool waitForExit) const;
+    [[nodiscard]] bool spawn(UnixPty& unixPty);
 };
 
 Process::Process(string const& path,
@@ -119,18 +128,115 @@ bool Process::isFlatpak()
     return check;
 }
 
+#if defined(VTPTY_USE_POSIX_SPAWN)
+/// Spawns the process without fork(), as forking has to copy the page tables of the terminal,
+/// which takes longer the more memory the terminal holds.
+///
+/// It only handles the common case, so that the caller falls back to fork() if it returns false.
+/// This is also the case if the program could not be executed, for fork() to report that
+/// on the terminal and to try the login shell instead.
+bool Process::Private::spawn(UnixPty& unixPty)
+{
+    if (isFlatpak())
+        return false;
+
+    if (!cwd.empty() && !fs::is_directory(cwd))
+        return false;
+
+    // posix_spawnp() searches the PATH of the terminal, rather than the one passed to the process.
+    if (env.contains("PATH"))
+        return false;
+
+    auto const slaveName = unixPty.slaveName();
+    if (slaveName.empty())
+        return false;
+
+    auto const fastPipeWriter = unixPty.stdoutFastPipe().writer();
+
+    auto arguments = vector<string> { path };
+    arguments.insert(arguments.end(), args.begin(), args.end());
+    auto argv = vector<char*> {};
+    for (auto& argument: arguments)
+        argv.push_back(argument.data());
+    argv.push_back(nullptr);
+
+    auto variables = vector<string> {};
+    for (char** variable = environ; *variable; ++variable)
+    {
+        auto const entry = string_view { *variable };
+        auto const name = string { entry.substr(0, entry.find('=')) };
+        if (!env.contains(name) && !(fastPipeWriter != -1 && name == StdoutFastPipeEnvironmentName))
+            variables.emplace_back(entry);
+    }
+    for (auto&& [name, value]: env)
+        variables.emplace_back(std::format("{}={}", name, value));
+    if (fastPipeWriter != -1)
+        variables.emplace_back(std::format("{}={}", StdoutFastPipeEnvironmentName, StdoutFastPipeFdStr));
+    auto envp = vector<char*> {};
+    for (auto& variable: variables)
+        envp.push_back(variable.data());
+    envp.push_back(nullptr);
+
+    // What UnixPty::Slave::login() does in the child, is done by spawn attributes and file actions.
+    (void) pty->slave().configure();
+
+    posix_spawn_file_actions_t actions {};
+    posix_spawn_file_actions_init(&actions);
+    auto const destroyActions = crispy::finally([&]() { posix_spawn_file_actions_destroy(&actions); });
+    // Opening the PTY slave after setsid() makes it the controlling terminal.
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, slaveName.c_str(), O_RDWR, 0);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDERR_FILENO);
+    if (fastPipeWriter != -1)
+        posix_spawn_file_actions_adddup2(&actions, fastPipeWriter, StdoutFastPipeFd);
+    posix_spawn_file_actions_addclosefrom_np(&actions, StdoutFastPipeFd + 1);
+    if (!cwd.empty())
+        posix_spawn_file_actions_addchdir_np(&actions, cwd.c_str());
+
+    posix_spawnattr_t attributes {};
+    posix_spawnattr_init(&attributes);
+    auto const destroyAttributes = crispy::finally([&]() { posix_spawnattr_destroy(&attributes); });
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    for (auto const signo: { SIGCHLD, SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGALRM, SIGPIPE })
+        sigaddset(&signals, signo);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+    posix_spawnattr_setflags(&attributes,
+                             static_cast<short>(POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK
+                                                | POSIX_SPAWN_SETSIGDEF));
+
+    pid_t childPid = -1;
+    if (auto const rc = posix_spawnp(&childPid, argv[0], &actions, &attributes, argv.data(), envp.data());
+        rc != 0)
+    {
+        errorLog()("posix_spawnp() of {} failed, falling back to fork(). {}", path, strerror(rc));
+        return false;
+    }
+
+    pid = childPid;
+    return true;
+}
+#else
+bool Process::Private::spawn(UnixPty& /*unixPty*/)
+{
+    return false;
+}
+#endif
+
 void Process::start()
 {
     _d->pty->start();
 
-    _d->pid = fork();
-
     UnixPipe* stdoutFastPipe = [this]() -> UnixPipe* {
         if (auto* p = dynamic_cast<UnixPty*>(_d->pty.get()))
             return &p->stdoutFastPipe();
         return nullptr;
     }();
 
+    if (auto* unixPty = dynamic_cast<UnixPty*>(_d->pty.get()); !unixPty || !_d->spawn(*unixPty))
+        _d->pid = fork();
+
     switch (_d->pid)
     {
         default: // in parent
@@ -98,13 +98,31 @@ class Pty
     /// @notice This is typically implemented using non-blocking I/O.
     virtual void wakeupReader() = 0;
 
+    /// @returns a file descriptor that becomes readable whenever read() would not block,
+    ///          including after wakeupReader(), so that many PTYs can be waited for at once,
+    ///          or std::nullopt if this PTY can only be waited for by read() itself.
+    [[nodiscard]] virtual std::optional<int> readinessDescriptor() const noexcept { return std::nullopt; }
+
     /// Writes to the PTY device, so the other end can read from it.
     ///
+    /// Implementations may write only part of the data, if the other end is not reading.
+    ///
     /// @param buf      Buffer of data to be written.
     ///
     /// @returns Number of bytes written or -1 on error.
     [[nodiscard]] virtual int write(std::string_view buf) = 0;
 
+    /// Waits for up to @p timeout for the PTY device to accept more data to be written.
+    ///
+    /// @returns true if the PTY device is writable, false on timeout or error.
+    ///
+    /// The default implementation returns immediately, for PTY devices whose write() blocks instead.
+    [[nodiscard]] virtual bool waitForWritable(std::chrono::milliseconds timeout)
+    {
+        (void) timeout;
+        return true;
+    }
+
     /// @returns current underlying window size in characters width and height.
     [[nodiscard]] virtual PageSize pageSize() const noexcept = 0;
 
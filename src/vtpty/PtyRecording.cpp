@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtpty/PtyRecording.h>
+
+#include <format>
+#include <optional>
+#include <stdexcept>
+
+namespace vtpty
+{
+
+namespace
+{
+    constexpr auto Magic = std::string_view { "contour-pty-recording" };
+    constexpr auto FormatVersion = 1;
+
+    [[noreturn]] void throwMalformed(std::filesystem::path const& path, std::string_view reason)
+    {
+        throw std::runtime_error(std::format("Malformed PTY recording {}: {}", path.string(), reason));
+    }
+
+    [[nodiscard]] std::optional<PageSize> pageSizeOf(int lines, int columns) noexcept
+    {
+        if (lines <= 0 || columns <= 0)
+            return std::nullopt;
+        return PageSize { LineCount(lines), ColumnCount(columns) };
+    }
+} // namespace
+
+PtyRecording PtyRecording::load(std::filesystem::path const& path)
+{
+    auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw std::runtime_error(std::format("Failed to open PTY recording {}", path.string()));
+    auto const fileSize = static_cast<int64_t>(file.tellg());
+    file.seekg(0);
+
+    auto magic = std::string {};
+    auto version = 0;
+    auto lines = 0;
+    auto columns = 0;
+    file >> magic >> version >> lines >> columns;
+    if (!file || magic != Magic)
+        throwMalformed(path, "missing header");
+    if (version != FormatVersion)
+        throwMalformed(path, std::format("unsupported version {}", version));
+    file.ignore(1); // newline
+    auto const pageSize = pageSizeOf(lines, columns);
+    if (!pageSize)
+        throwMalformed(path, std::format("invalid page size {}x{}", columns, lines));
+
+    auto recording = PtyRecording { .pageSize = *pageSize, .events = {} };
+    auto type = char {};
+    while (file >> type)
+    {
+        auto time = int64_t {};
+        file >> time;
+        auto event = PtyRecordingEvent { .type = PtyRecordingEvent::Type::Output,
+                                         .time = std::chrono::microseconds(time) };
+        switch (type)
+        {
+            case 'o':
+            case 'i': {
+                event.type = type == 'o' ? PtyRecordingEvent::Type::Output : PtyRecordingEvent::Type::Input;
+                auto size = size_t {};
+                file >> size;
+                file.ignore(1); // newline
+                // The size is checked against what is left of the file before allocating that much.
+                if (!file || size > static_cast<uint64_t>(fileSize - static_cast<int64_t>(file.tellg())))
+                    throwMalformed(path, std::format("truncated event {}", recording.events.size()));
+                event.data.resize(size);
+                file.read(event.data.data(), static_cast<std::streamsize>(size));
+                file.ignore(1); // newline
+                break;
+            }
+            case 'r':
+                event.type = PtyRecordingEvent::Type::Resize;
+                file >> lines >> columns;
+                if (auto const size = pageSizeOf(lines, columns); file && size)
+                    event.pageSize = *size;
+                else if (file)
+                    throwMalformed(path, std::format("invalid page size {}x{}", columns, lines));
+                break;
+            default: throwMalformed(path, std::format("unknown event type '{}'", type));
+        }
+        if (!file)
+            throwMalformed(path, std::format("truncated event {}", recording.events.size()));
+        recording.events.emplace_back(std::move(event));
+    }
+    return recording;
+}
+
+PtyRecorder::PtyRecorder(std::filesystem::path const& path):
+    _file { path, std::ios::binary | std::ios::trunc }, _startTime { std::chrono::steady_clock::now() }
+{
+    if (!_file)
+        throw std::runtime_error(std::format("Failed to create PTY recording {}", path.string()));
+}
+
+void PtyRecorder::start(PageSize pageSize)
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _file << std::format(
+        "{} {} {} {}\n", Magic, FormatVersion, unbox(pageSize.lines), unbox(pageSize.columns));
+    _file.flush();
+    _startTime = std::chrono::steady_clock::now();
+    _started = true;
+}
+
+int64_t PtyRecorder::now() const noexcept
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()
+                                                                 - _startTime)
+        .count();
+}
+
+void PtyRecorder::record(char type, std::string_view data)
+{
+    auto const _ = std::scoped_lock { _mutex };
+    if (!_started)
+        return;
+    _file << std::format("{} {} {}\n", type, now(), data.size());
+    _file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    _file.put('\n');
+    _file.flush(); // so that the recording survives a crash, which is often what is to be reproduced
+}
+
+void PtyRecorder::recordOutput(std::string_view data)
+{
+    record('o', data);
+}
+
+void PtyRecorder::recordInput(std::string_view data)
+{
+    record('i', data);
+}
+
+void PtyRecorder::recordResize(PageSize pageSize)
+{
+    auto const _ = std::scoped_lock { _mutex };
+    if (!_started)
+        return;
+    _file << std::format("r {} {} {}\n", now(), unbox(pageSize.lines), unbox(pageSize.columns));
+    _file.flush();
+}
+
+} // namespace vtpty
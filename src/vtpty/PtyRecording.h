@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtpty/PageSize.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vtpty
+{
+
+/// Something that happened on a recorded PTY, see PtyRecorder.
+struct PtyRecordingEvent
+{
+    enum class Type : uint8_t
+    {
+        Output, ///< Read from the PTY, i.e. written by the application.
+        Input,  ///< Written to the PTY, e.g. typed by the user.
+        Resize, ///< The PTY has been resized.
+    };
+
+    Type type;
+    std::chrono::microseconds time; ///< since the recording started
+    std::string data {};            ///< for output and input
+    PageSize pageSize {};           ///< for resizes
+};
+
+/// PTY session as recorded by a PtyRecorder, to be replayed.
+///
+/// Recordings are stored as text lines, each introducing an event, followed by its payload:
+///
+///     contour-pty-recording 1 <lines> <columns>
+///     o <microseconds> <size>\n<bytes>\n    (output)
+///     i <microseconds> <size>\n<bytes>\n    (input)
+///     r <microseconds> <lines> <columns>\n  (resize)
+struct PtyRecording
+{
+    PageSize pageSize; ///< at the start of the recording
+    std::vector<PtyRecordingEvent> events;
+
+    /// Loads a recording from the given file.
+    ///
+    /// @throws std::runtime_error if the file cannot be read or is not a recording, e.g. one whose
+    ///         events claim more data than the file has left, or whose page sizes are empty.
+    [[nodiscard]] static PtyRecording load(std::filesystem::path const& path);
+};
+
+/// Writes the events of a PTY session into a file, as they happen.
+///
+/// All members may be invoked from any thread.
+class PtyRecorder
+{
+  public:
+    /// @throws std::runtime_error if the file cannot be written.
+    explicit PtyRecorder(std::filesystem::path const& path);
+
+    /// Starts the recording of a PTY of the given size, as it is when its session starts.
+    ///
+    /// Resizes before that are not recorded, as the size passed here already accounts for them.
+    void start(PageSize pageSize);
+
+    void recordOutput(std::string_view data);
+    void recordInput(std::string_view data);
+    void recordResize(PageSize pageSize);
+
+  private:
+    [[nodiscard]] int64_t now() const noexcept;
+    void record(char type, std::string_view data);
+
+    std::mutex _mutex;
+    std::ofstream _file;
+    bool _started = false;
+    std::chrono::steady_clock::time_point _startTime;
+};
+
+} // namespace vtpty
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtpty/PtyRecording.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace std::string_literals;
+using namespace vtpty;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+void writeFile(fs::path const& path, std::string const& contents)
+{
+    auto output = std::ofstream(path, std::ios::binary | std::ios::trunc);
+    output << contents;
+}
+} // namespace
+
+TEST_CASE("PtyRecording.round_trip")
+{
+    auto const path = fs::temp_directory_path() / "contour-pty-recording-test.rec";
+    auto const output = "line\r\n\033[1mbold\033[m\n\0binary"s;
+    {
+        auto recorder = PtyRecorder(path);
+        recorder.recordResize(PageSize { LineCount(1), ColumnCount(1) }); // before the start, not recorded
+        recorder.start(PageSize { LineCount(24), ColumnCount(80) });
+        recorder.recordOutput(output);
+        recorder.recordInput("ls\r");
+        recorder.recordResize(PageSize { LineCount(30), ColumnCount(100) });
+        recorder.recordOutput("");
+    }
+
+    auto const recording = PtyRecording::load(path);
+    CHECK(recording.pageSize == PageSize { LineCount(24), ColumnCount(80) });
+    REQUIRE(recording.events.size() == 4);
+    CHECK(recording.events[0].type == PtyRecordingEvent::Type::Output);
+    CHECK(recording.events[0].data == output);
+    CHECK(recording.events[1].type == PtyRecordingEvent::Type::Input);
+    CHECK(recording.events[1].data == "ls\r");
+    CHECK(recording.events[2].type == PtyRecordingEvent::Type::Resize);
+    CHECK(recording.events[2].pageSize == PageSize { LineCount(30), ColumnCount(100) });
+    CHECK(recording.events[3].type == PtyRecordingEvent::Type::Output);
+    CHECK(recording.events[3].data.empty());
+    for (size_t i = 1; i < recording.events.size(); ++i)
+        CHECK(recording.events[i - 1].time <= recording.events[i].time);
+    fs::remove(path);
+}
+
+TEST_CASE("PtyRecording.malformed")
+{
+    auto const path = fs::temp_directory_path() / "contour-pty-recording-malformed-test.rec";
+
+    writeFile(path, "not a recording\n");
+    CHECK_THROWS(PtyRecording::load(path));
+
+    writeFile(path, "contour-pty-recording 1 0 80\n");
+    CHECK_THROWS(PtyRecording::load(path));
+
+    writeFile(path, "contour-pty-recording 1 24 80\nr 0 -1 80\n");
+    CHECK_THROWS(PtyRecording::load(path));
+
+    // A huge size is rejected rather than allocated.
+    writeFile(path, "contour-pty-recording 1 24 80\no 0 1000000000000\nabc\n");
+    CHECK_THROWS(PtyRecording::load(path));
+
+    writeFile(path, "contour-pty-recording 1 24 80\no 0 4\nabc");
+    CHECK_THROWS(PtyRecording::load(path));
+
+    writeFile(path, "contour-pty-recording 1 24 80\no 0 3\nabc\n");
+    CHECK(PtyRecording::load(path).events.size() == 1);
+    fs::remove(path);
+}
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtpty/RecordingPty.h>
+
+namespace vtpty
+{
+
+RecordingPty::RecordingPty(std::unique_ptr<Pty> pty, std::unique_ptr<PtyRecorder> recorder):
+    _pty { std::move(pty) }, _recorder { std::move(recorder) }
+{
+}
+
+void RecordingPty::start()
+{
+    // The header carries the size the session starts at, rather than the configured one.
+    _recorder->start(_pty->pageSize());
+    _pty->start();
+}
+
+PtySlave& RecordingPty::slave() noexcept
+{
+    return _pty->slave();
+}
+
+void RecordingPty::close()
+{
+    _pty->close();
+}
+
+void RecordingPty::waitForClosed()
+{
+    _pty->waitForClosed();
+}
+
+bool RecordingPty::isClosed() const noexcept
+{
+    return _pty->isClosed();
+}
+
+std::optional<Pty::ReadResult> RecordingPty::read(crispy::buffer_object<char>& storage,
+                                                  std::optional<std::chrono::milliseconds> timeout,
+                                                  size_t size)
+{
+    auto result = _pty->read(storage, timeout, size);
+    if (result && !result->data.empty())
+        _recorder->recordOutput(result->data);
+    return result;
+}
+
+void RecordingPty::wakeupReader()
+{
+    _pty->wakeupReader();
+}
+
+std::optional<int> RecordingPty::readinessDescriptor() const noexcept
+{
+    return _pty->readinessDescriptor();
+}
+
+int RecordingPty::write(std::string_view buf)
+{
+    auto const written = _pty->write(buf);
+    if (written > 0)
+        _recorder->recordInput(buf.substr(0, static_cast<size_t>(written)));
+    return written;
+}
+
+bool RecordingPty::waitForWritable(std::chrono::milliseconds timeout)
+{
+    return _pty->waitForWritable(timeout);
+}
+
+PageSize RecordingPty::pageSize() const noexcept
+{
+    return _pty->pageSize();
+}
+
+void RecordingPty::resizeScreen(PageSize cells, std::optional<ImageSize> pixels)
+{
+    _pty->resizeScreen(cells, pixels);
+    _recorder->recordResize(cells);
+}
+
+} // namespace vtpty
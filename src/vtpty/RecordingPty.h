@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtpty/Pty.h>
+#include <vtpty/PtyRecording.h>
+
+#include <memory>
+
+namespace vtpty
+{
+
+/// PTY recording everything passing through another one, to be replayed by a ReplayPty.
+class RecordingPty: public Pty
+{
+  public:
+    RecordingPty(std::unique_ptr<Pty> pty, std::unique_ptr<PtyRecorder> recorder);
+
+    [[nodiscard]] Pty& recordedPty() noexcept { return *_pty; }
+    [[nodiscard]] Pty const& recordedPty() const noexcept { return *_pty; }
+
+    void start() override;
+    PtySlave& slave() noexcept override;
+    void close() override;
+    void waitForClosed() override;
+    [[nodiscard]] bool isClosed() const noexcept override;
+    [[nodiscard]] std::optional<ReadResult> read(crispy::buffer_object<char>& storage,
+                                                 std::optional<std::chrono::milliseconds> timeout,
+                                                 size_t size) override;
+    void wakeupReader() override;
+    [[nodiscard]] std::optional<int> readinessDescriptor() const noexcept override;
+    [[nodiscard]] int write(std::string_view buf) override;
+    [[nodiscard]] bool waitForWritable(std::chrono::milliseconds timeout) override;
+    [[nodiscard]] PageSize pageSize() const noexcept override;
+    void resizeScreen(PageSize cells, std::optional<ImageSize> pixels = std::nullopt) override;
+
+  private:
+    std::unique_ptr<Pty> _pty;
+    std::unique_ptr<PtyRecorder> _recorder;
+};
+
+/// @returns the given PTY as a @p T, looking through a RecordingPty around it, or nullptr if it is none.
+template <typename T>
+[[nodiscard]] T* ptyAs(Pty& pty) noexcept
+{
+    if (auto* recording = dynamic_cast<RecordingPty*>(&pty))
+        return dynamic_cast<T*>(&recording->recordedPty());
+    return dynamic_cast<T*>(&pty);
+}
+
+template <typename T>
+[[nodiscard]] T const* ptyAs(Pty const& pty) noexcept
+{
+    if (auto const* recording = dynamic_cast<RecordingPty const*>(&pty))
+        return dynamic_cast<T const*>(&recording->recordedPty());
+    return dynamic_cast<T const*>(&pty);
+}
+
+} // namespace vtpty
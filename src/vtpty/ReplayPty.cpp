@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtpty/ReplayPty.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace vtpty
+{
+
+ReplayPty::ReplayPty(PtyRecording recording, Pacing pacing):
+    _recording { std::move(recording) }, _pageSize { _recording.pageSize }, _pacing { pacing }
+{
+    // The size the session started at is replayed like any later resize.
+    _recording.events.insert(_recording.events.begin(),
+                             PtyRecordingEvent { .type = PtyRecordingEvent::Type::Resize,
+                                                 .time = std::chrono::microseconds(0),
+                                                 .pageSize = _recording.pageSize });
+}
+
+void ReplayPty::setResizeHandler(ResizeHandler handler)
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _resizeHandler = std::move(handler);
+}
+
+void ReplayPty::start()
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _startTime = std::chrono::steady_clock::now();
+}
+
+PtySlave& ReplayPty::slave() noexcept
+{
+    return _slave;
+}
+
+void ReplayPty::close()
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _closed = true;
+    _wakeup.notify_all();
+}
+
+void ReplayPty::waitForClosed()
+{
+    auto lock = std::unique_lock { _mutex };
+    _wakeup.wait(lock, [this]() { return _closed; });
+}
+
+bool ReplayPty::isClosed() const noexcept
+{
+    auto const _ = std::scoped_lock { _mutex };
+    return _closed;
+}
+
+bool ReplayPty::seekEvent() noexcept
+{
+    auto const& events = _recording.events;
+    while (_eventIndex < events.size()
+           && (events[_eventIndex].type == PtyRecordingEvent::Type::Input
+               || (events[_eventIndex].type == PtyRecordingEvent::Type::Output
+                   && _dataOffset == events[_eventIndex].data.size())))
+    {
+        ++_eventIndex;
+        _dataOffset = 0;
+    }
+    return _eventIndex < events.size();
+}
+
+std::optional<Pty::ReadResult> ReplayPty::read(crispy::buffer_object<char>& storage,
+                                               std::optional<std::chrono::milliseconds> timeout,
+                                               size_t size)
+{
+    auto lock = std::unique_lock { _mutex };
+    if (_closed || !seekEvent())
+        return ReadResult {}; // end of the recording, read as the PTY having been closed
+
+    auto const& event = _recording.events[_eventIndex];
+    if (_pacing == Pacing::RealTime)
+    {
+        auto const dueTime = _startTime + event.time;
+        auto const ready = [&]() {
+            return _closed || _wakeupRequested || std::chrono::steady_clock::now() >= dueTime;
+        };
+        if (timeout)
+            _wakeup.wait_until(lock, std::min(dueTime, std::chrono::steady_clock::now() + *timeout), ready);
+        else
+            _wakeup.wait_until(lock, dueTime, ready);
+
+        _wakeupRequested = false;
+        if (_closed)
+            return ReadResult {};
+        if (std::chrono::steady_clock::now() < dueTime)
+        {
+            errno = EAGAIN;
+            return std::nullopt;
+        }
+    }
+
+    if (event.type == PtyRecordingEvent::Type::Resize)
+    {
+        // The resize is applied by the handler before any output recorded after it is read.
+        ++_eventIndex;
+        auto const handler = _resizeHandler;
+        lock.unlock();
+        if (handler)
+            handler(event.pageSize);
+        errno = EAGAIN;
+        return std::nullopt;
+    }
+
+    // The pieces start at multiples of the chunk size into the event, wherever previous reads ended.
+    auto const pieceEnd = std::min(event.data.size(), (_dataOffset / ChunkSize + 1) * ChunkSize);
+    auto const n = std::min({ pieceEnd - _dataOffset, storage.bytesAvailable(), size });
+    auto const chunk = storage.writeAtEnd(std::string_view(event.data).substr(_dataOffset, n));
+    _dataOffset += n;
+    return ReadResult { .data = std::string_view(chunk.data(), chunk.size()), .fromStdoutFastPipe = false };
+}
+
+void ReplayPty::wakeupReader()
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _wakeupRequested = true;
+    _wakeup.notify_all();
+}
+
+int ReplayPty::write(std::string_view buf)
+{
+    // The application's answers to any input are part of the recorded output already.
+    return static_cast<int>(buf.size());
+}
+
+PageSize ReplayPty::pageSize() const noexcept
+{
+    auto const _ = std::scoped_lock { _mutex };
+    return _pageSize;
+}
+
+void ReplayPty::resizeScreen(PageSize cells, std::optional<ImageSize> pixels)
+{
+    auto const _ = std::scoped_lock { _mutex };
+    _pageSize = cells;
+    _pixelSize = pixels;
+}
+
+} // namespace vtpty
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtpty/Pty.h>
+#include <vtpty/PtyRecording.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+
+namespace vtpty
+{
+
+/// PTY replaying the output of a recorded session, see RecordingPty.
+///
+/// The output is read in the chunks it was recorded in, cut into pieces of at most ChunkSize bytes,
+/// so that a terminal processes it the same way on every replay, whatever room its buffers have left.
+/// Recorded resizes are handed to the resize handler in between, in the order they happened.
+/// Input is discarded. Once all output has been read, the PTY reads as closed.
+class ReplayPty: public Pty
+{
+  public:
+    enum class Pacing : uint8_t
+    {
+        Fast,     ///< Output is read as fast as it is asked for.
+        RealTime, ///< Output is read no sooner than it has been recorded.
+    };
+
+    /// Maximum number of bytes read at once, which a terminal keeps room for with its default buffer sizes.
+    ///
+    /// A piece is only cut short if a read has less room than that, which makes its replay differ.
+    static constexpr size_t ChunkSize = 1024;
+
+    /// Invoked on the reading thread, without any lock of the PTY held, with the recorded size.
+    using ResizeHandler = std::function<void(PageSize)>;
+
+    ReplayPty(PtyRecording recording, Pacing pacing);
+
+    void setResizeHandler(ResizeHandler handler);
+
+    void start() override;
+    PtySlave& slave() noexcept override;
+    void close() override;
+    void waitForClosed() override;
+    [[nodiscard]] bool isClosed() const noexcept override;
+    [[nodiscard]] std::optional<ReadResult> read(crispy::buffer_object<char>& storage,
+                                                 std::optional<std::chrono::milliseconds> timeout,
+                                                 size_t size) override;
+    void wakeupReader() override;
+    [[nodiscard]] int write(std::string_view buf) override;
+    [[nodiscard]] PageSize pageSize() const noexcept override;
+    void resizeScreen(PageSize cells, std::optional<ImageSize> pixels = std::nullopt) override;
+
+  private:
+    /// Skips to the next resize, or output event with data left to be read.
+    ///
+    /// @returns false if there are no more of them.
+    [[nodiscard]] bool seekEvent() noexcept;
+
+    PtyRecording _recording;
+    PageSize _pageSize;
+    Pacing _pacing;
+    ResizeHandler _resizeHandler;
+    std::chrono::steady_clock::time_point _startTime {};
+    size_t _eventIndex = 0; // event read from next
+    size_t _dataOffset = 0; // offset into the data of that event
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wakeup;
+    bool _wakeupRequested = false;
+    bool _closed = false;
+    std::optional<ImageSize> _pixelSize;
+    PtySlaveDummy _slave;
+};
+
+} // namespace vtpty
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtpty/ReplayPty.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <format>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace vtpty;
+
+namespace
+{
+PtyRecording makeRecording()
+{
+    using Type = PtyRecordingEvent::Type;
+    auto const resized = PageSize { LineCount(30), ColumnCount(100) };
+    return PtyRecording {
+        .pageSize = PageSize { LineCount(24), ColumnCount(80) },
+        .events = {
+            PtyRecordingEvent { .type = Type::Output, .time = 0us, .data = std::string(2500, 'a') },
+            PtyRecordingEvent { .type = Type::Input, .time = 1us, .data = "x" },
+            PtyRecordingEvent { .type = Type::Resize, .time = 2us, .pageSize = resized },
+            PtyRecordingEvent { .type = Type::Output, .time = 3us, .data = "bc" },
+        },
+    };
+}
+
+/// Replays the recording, reading it into buffers of the given size.
+///
+/// @returns the chunks read, and the resizes in between, given as "<lines>x<columns>".
+std::vector<std::string> replay(size_t bufferSize)
+{
+    auto pty = ReplayPty(makeRecording(), ReplayPty::Pacing::Fast);
+    auto result = std::vector<std::string> {};
+    pty.setResizeHandler([&](PageSize pageSize) {
+        result.emplace_back(std::format("{}x{}", unbox(pageSize.lines), unbox(pageSize.columns)));
+    });
+    pty.start();
+
+    auto storage = crispy::buffer_object<char>::create(bufferSize);
+    while (true)
+    {
+        if (storage->bytesAvailable() < ReplayPty::ChunkSize)
+            storage = crispy::buffer_object<char>::create(bufferSize);
+        auto const chunk = pty.read(*storage, 0ms, 4096);
+        if (!chunk)
+            continue; // a resize
+        if (chunk->data.empty())
+            break;
+        result.emplace_back(chunk->data);
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("ReplayPty.chunks_and_resizes")
+{
+    auto const events = replay(4096);
+    REQUIRE(events.size() == 6);
+    CHECK(events[0] == "24x80");
+    CHECK(events[1] == std::string(1024, 'a'));
+    CHECK(events[2] == std::string(1024, 'a'));
+    CHECK(events[3] == std::string(452, 'a'));
+    CHECK(events[4] == "30x100");
+    CHECK(events[5] == "bc");
+}
+
+TEST_CASE("ReplayPty.chunks_independent_of_buffers")
+{
+    CHECK(replay(1500) == replay(1024 * 1024));
+}
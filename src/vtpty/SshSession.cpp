@@ -22,19 +22,24 @@
 #include <crispy/escape.h>
 #include <crispy/utils.h>
 
+#include <algorithm>
+#include <array>
 #include <fstream>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 #include <libssh2.h>
 #include <libssh2_publickey.h>
 
 #if not defined(_WIN32)
     #include <sys/ioctl.h>
-    #include <sys/select.h>
     #include <sys/socket.h>
     #include <sys/types.h>
 
     #include <fcntl.h>
     #include <netdb.h>
+    #include <poll.h>
     #include <termios.h>
     #include <unistd.h>
 
@@ -56,9 +61,6 @@
     #define LIBSSH2_HANDSHAKE_FUNCTION libssh2_session_startup
 #endif
 
-// It would be nice to move to NB IO mode, but I didn't have the time to debug it.
-// #define SSH_SESSION_NB_IO /* BUGGY EZ */
-
 using crispy::file_descriptor;
 
 using namespace std::string_literals;
@@ -212,6 +214,8 @@ std::string SshHostConfig::toString() const
         add(std::format("known hosts: {}", knownHostsFile.string()));
 
     add(std::format("ForwardAgent: {}", forwardAgent ? "Yes" : "No"));
+    add(std::format("Compression: {}", compression ? "Yes" : "No"));
+    add(std::format("ShareConnection: {}", shareConnection ? "Yes" : "No"));
 
     return result;
 }
@@ -235,6 +239,7 @@ std::string SshHostConfig::toConfigString(std::string const& host) const
     if (!knownHostsFile.empty())
         result += std::format("{}KnownHostsFile {}\n", prefix, knownHostsFile.string());
     result += std::format("{}ForwardAgent {}\n", prefix, forwardAgent);
+    result += std::format("{}Compression {}\n", prefix, compression ? "yes" : "no");
     result += std::format("\n");
     return result;
 }
@@ -294,6 +299,8 @@ crispy::result<SshHostConfigMap> loadSshConfig(std::filesystem::path const& conf
                 config.privateKeyFile = value;
             else if (key == "ForwardAgent")
                 config.forwardAgent = (value == "yes");
+            else if (key == "Compression")
+                config.compression = (value == "yes");
             else
                 errorLog()("Unknown SSH config key: {}", key);
             // Add additional options here as needed
@@ -309,14 +316,325 @@ crispy::result<SshHostConfigMap> loadSshConfig()
     return loadSshConfig(configFilePath);
 }
 
+// {{{ SshConnection
+namespace
+{
+    /// An SSH connection, which is shared by all sessions to the same host, port and user once
+    /// authenticated, each of them merely opening another channel, in the spirit of OpenSSH's
+    /// ControlMaster.
+    ///
+    /// The connection is set up in blocking mode. Once the first channel is operational, it switches
+    /// to non-blocking I/O, and a dedicated I/O thread demultiplexes the incoming data into the
+    /// inboxes of all channels, so that reads and writes progress concurrently.
+    struct SshConnection
+    {
+        struct Channel
+        {
+            LIBSSH2_CHANNEL* handle = nullptr;
+            std::string inbox; // data received, starting at inboxOffset
+            size_t inboxOffset = 0;
+            bool eof = false; // no more data will be received
+            int error = LIBSSH2_ERROR_NONE;
+            bool woken = false; // a waiting read() call shall return
+
+            [[nodiscard]] size_t inboxSize() const noexcept { return inbox.size() - inboxOffset; }
+        };
+
+        /// Maximum number of bytes received in advance per channel, after which the I/O thread
+        /// stops reading it, and the channel window eventually throttles the server.
+        static constexpr inline size_t InboxCapacity = 1024 * 1024;
+
+        SshConnection();
+        SshConnection(SshConnection const&) = delete;
+        SshConnection(SshConnection&&) = delete;
+        SshConnection& operator=(SshConnection const&) = delete;
+        SshConnection& operator=(SshConnection&&) = delete;
+        ~SshConnection();
+
+        // The following require the mutex to be locked.
+        [[nodiscard]] bool nonBlocking() const noexcept { return _ioThread.joinable(); }
+        void attach(Channel& channel);
+        void detach(Channel& channel);
+
+        /// Interrupts the I/O thread waiting for the socket, to take changes into account.
+        void wakeup();
+
+        /// Waits for the socket to become readable and/or writable, or, if @p wakeable, until woken up.
+        int poll(bool readable,
+                 bool writable,
+                 std::optional<std::chrono::milliseconds> timeout,
+                 bool wakeable);
+
+        LIBSSH2_SESSION* session = nullptr;
+        LIBSSH2_AGENT* agent = nullptr;
+        socket_handle socket;
+
+        // Serializes all libssh2 calls, and guards all members below.
+        std::mutex mutex;
+        std::condition_variable changed; // notified whenever channels or their inboxes have changed
+        std::vector<Channel*> channels;
+        bool broken = false; // the transport failed, so that it must not be shared any longer
+        bool stopping = false;
+
+      private:
+        void run();
+        [[nodiscard]] bool wantsToRead() const noexcept;
+
+#if !defined(_WIN32)
+        file_descriptor _wakeupReader;
+        file_descriptor _wakeupWriter;
+#endif
+        std::thread _ioThread;
+    };
+
+    SshConnection::SshConnection(): session { libssh2_session_init() }
+    {
+#if !defined(_WIN32)
+        int pfd[2];
+        if (pipe(pfd) == 0)
+        {
+            _wakeupReader = file_descriptor::from_native(pfd[0]);
+            _wakeupWriter = file_descriptor::from_native(pfd[1]);
+            for (int const fd: pfd)
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+        else
+            errorLog()("Failed to create SSH wakeup pipe. {}", strerror(errno));
+#endif
+    }
+
+    SshConnection::~SshConnection()
+    {
+        {
+            auto const lock = std::scoped_lock { mutex };
+            stopping = true;
+        }
+        changed.notify_all();
+        if (_ioThread.joinable())
+        {
+            wakeup();
+            _ioThread.join();
+        }
+
+        if (agent)
+        {
+            libssh2_agent_disconnect(agent);
+            libssh2_agent_free(agent);
+        }
+
+        if (session)
+        {
+            libssh2_session_set_blocking(session, 1);
+            libssh2_session_disconnect(session, "Normal shutdown");
+            libssh2_session_free(session);
+        }
+    }
+
+    void SshConnection::attach(Channel& channel)
+    {
+        channels.push_back(&channel);
+        if (!_ioThread.joinable())
+            _ioThread = std::thread { [this]() {
+                run();
+            } };
+        wakeup();
+    }
+
+    void SshConnection::detach(Channel& channel)
+    {
+        channels.erase(std::remove(channels.begin(), channels.end(), &channel), channels.end());
+    }
+
+    void SshConnection::wakeup()
+    {
+#if !defined(_WIN32)
+        if (_wakeupWriter.is_open())
+            (void) ::write(_wakeupWriter, "x", 1);
+#endif
+        changed.notify_all();
+    }
+
+    int SshConnection::poll(bool readable,
+                            bool writable,
+                            std::optional<std::chrono::milliseconds> timeout,
+                            bool wakeable)
+    {
+        auto const events = static_cast<short>((readable ? POLLIN : 0) | (writable ? POLLOUT : 0));
+        auto const timeoutMs = timeout ? static_cast<int>(timeout->count()) : -1;
+
+#if defined(_WIN32)
+        // There is no wakeup pipe to wait for, so wake up regularly instead.
+        auto pfd = WSAPOLLFD { .fd = socket, .events = events, .revents = 0 };
+        return WSAPoll(&pfd, 1, wakeable && (timeoutMs < 0 || timeoutMs > 50) ? 50 : timeoutMs);
+#else
+        auto pfds = std::array { pollfd { .fd = socket, .events = events, .revents = 0 },
+                                 pollfd { .fd = _wakeupReader, .events = POLLIN, .revents = 0 } };
+        auto const count = wakeable && _wakeupReader.is_open() ? nfds_t { 2 } : nfds_t { 1 };
+        auto const rc = ::poll(pfds.data(), count, timeoutMs);
+        if (rc > 0 && count == 2 && (pfds[1].revents & POLLIN))
+        {
+            // Woken up. Drain the pipe and report it like a timeout.
+            char buf[64];
+            while (::read(_wakeupReader, buf, sizeof(buf)) > 0)
+                ;
+            return 0;
+        }
+        return rc;
+#endif
+    }
+
+    bool SshConnection::wantsToRead() const noexcept
+    {
+        return std::any_of(channels.begin(), channels.end(), [](Channel const* channel) {
+            return !channel->eof && channel->inboxSize() < InboxCapacity;
+        });
+    }
+
+    void SshConnection::run()
+    {
+        auto buffer = std::array<char, 64 * 1024> {};
+        auto lock = std::unique_lock { mutex };
+        while (!stopping)
+        {
+            // Reading any channel processes all packets received so far, queueing them per channel,
+            // so every channel with room in its inbox is drained.
+            for (auto* channel: channels)
+            {
+                while (!channel->eof && channel->inboxSize() < InboxCapacity)
+                {
+                    auto const n = std::min(buffer.size(), InboxCapacity - channel->inboxSize());
+                    auto const rc = libssh2_channel_read(channel->handle, buffer.data(), n);
+                    if (rc > 0)
+                        channel->inbox.append(buffer.data(), static_cast<size_t>(rc));
+                    else if (rc == 0 && libssh2_channel_eof(channel->handle))
+                        channel->eof = true;
+                    else if (rc < 0 && rc != LIBSSH2_ERROR_EAGAIN)
+                    {
+                        errorLog()("Failed to read from SSH channel. {}", libssl2ErrorString(rc));
+                        channel->error = static_cast<int>(rc);
+                        channel->eof = true;
+                        broken = true;
+                    }
+                    else
+                        break;
+                }
+            }
+            changed.notify_all();
+
+            if (!wantsToRead())
+            {
+                // Wait for a reader to make room in its inbox, or for a channel to be attached.
+                changed.wait(lock, [this]() { return stopping || wantsToRead(); });
+                continue;
+            }
+
+            auto const outbound =
+                (libssh2_session_block_directions(session) & LIBSSH2_SESSION_BLOCK_OUTBOUND) != 0;
+            lock.unlock();
+            auto const rc = poll(true, outbound, std::nullopt, true);
+            lock.lock();
+            if (rc < 0 && errno != EINTR)
+            {
+                errorLog()("Failed to wait for SSH socket. {}", strerror(errno));
+                for (auto* channel: channels)
+                {
+                    channel->error = LIBSSH2_ERROR_SOCKET_RECV;
+                    channel->eof = true;
+                }
+                broken = true;
+                changed.notify_all();
+                changed.wait(lock, [this]() { return stopping; });
+            }
+        }
+    }
+
+    /// Authenticated connections by host, port and user.
+    class SshConnectionPool
+    {
+      public:
+        static SshConnectionPool& get()
+        {
+            static auto pool = SshConnectionPool {};
+            return pool;
+        }
+
+        std::shared_ptr<SshConnection> find(SshHostConfig const& config)
+        {
+            auto const lock = std::scoped_lock { _mutex };
+            auto const i = _connections.find(keyOf(config));
+            if (i == _connections.end())
+                return nullptr;
+            auto connection = i->second.lock();
+            if (!connection)
+            {
+                _connections.erase(i);
+                return nullptr;
+            }
+            auto const connectionLock = std::scoped_lock { connection->mutex };
+            if (connection->broken || connection->socket.is_closed())
+                return nullptr;
+            return connection;
+        }
+
+        void add(SshHostConfig const& config, std::shared_ptr<SshConnection> const& connection)
+        {
+            auto const lock = std::scoped_lock { _mutex };
+            auto& entry = _connections[keyOf(config)];
+            if (entry.expired())
+                entry = connection;
+        }
+
+      private:
+        using Key = std::tuple<std::string, int, std::string>;
+
+        static Key keyOf(SshHostConfig const& config)
+        {
+            return { config.hostname, config.port, config.username };
+        }
+
+        std::mutex _mutex;
+        std::map<Key, std::weak_ptr<SshConnection>> _connections;
+    };
+
+    /// Locks a connection and makes it blocking for the duration of channel requests,
+    /// as the connection may already be shared with operational channels.
+    class BlockingSection
+    {
+      public:
+        explicit BlockingSection(SshConnection& connection):
+            _connection { connection }, _lock { connection.mutex }
+        {
+            libssh2_session_set_blocking(_connection.session, 1);
+        }
+
+        BlockingSection(BlockingSection const&) = delete;
+        BlockingSection(BlockingSection&&) = delete;
+        BlockingSection& operator=(BlockingSection const&) = delete;
+        BlockingSection& operator=(BlockingSection&&) = delete;
+
+        ~BlockingSection()
+        {
+            if (!_connection.nonBlocking())
+                return;
+
+            libssh2_session_set_blocking(_connection.session, 0);
+
+            // Packets for other channels may have been received meanwhile.
+            _connection.wakeup();
+        }
+
+      private:
+        SshConnection& _connection;
+        std::scoped_lock<std::mutex> _lock;
+    };
+} // namespace
+// }}}
+
 struct SshSession::Private
 {
-    LIBSSH2_SESSION* sshSession = nullptr;
-    LIBSSH2_CHANNEL* sshChannel = nullptr;
-    LIBSSH2_AGENT* sshAgent = nullptr;
+    std::shared_ptr<SshConnection> connection; // set once started
+    SshConnection::Channel channel;
     bool wantsWaitForSocket = false;
-
-    socket_handle sshSocket;
 };
 
 SshSession::SshSession(SshHostConfig config):
@@ -328,39 +646,22 @@ SshSession::SshSession(SshHostConfig config):
 {
     libssh2_init(0); // TODO: call only once?
 
-#if defined(SSH_SESSION_NB_IO)
-    libssh2_session_set_blocking(_p->sshSession, 0);
-#endif
-
     std::atexit([]() { libssh2_exit(); });
-
-    _p->sshSession = libssh2_session_init();
 }
 
 SshSession::~SshSession()
 {
     close();
 
-    if (_p->sshAgent)
+    if (_p->channel.handle)
     {
-        libssh2_agent_disconnect(_p->sshAgent);
-        libssh2_agent_free(_p->sshAgent);
-        _p->sshAgent = nullptr;
+        auto const _ = BlockingSection { *_p->connection };
+        libssh2_channel_free(_p->channel.handle);
+        _p->channel.handle = nullptr;
     }
 
-    if (_p->sshChannel)
-    {
-        libssh2_channel_send_eof(_p->sshChannel);
-        libssh2_channel_close(_p->sshChannel);
-        _p->sshChannel = nullptr;
-    }
-
-    if (_p->sshSession)
-    {
-        libssh2_session_disconnect(_p->sshSession, "Normal shutdown");
-        libssh2_session_free(_p->sshSession);
-        _p->sshSession = nullptr;
-    }
+    // The connection itself is closed along with the last session that is using it.
+    _p->connection.reset();
 
 #if defined(_WIN32)
     WSACleanup();
@@ -388,7 +689,7 @@ bool SshSession::requestPty()
     // Mode encoding defined here: https://datatracker.ietf.org/doc/html/rfc4250#section-4.5
     auto const modes = ""sv;
     auto const term = _config.env.count("TERM") ? _config.env.at("TERM") : ""s;
-    auto const rc = libssh2_channel_request_pty_ex(_p->sshChannel,
+    auto const rc = libssh2_channel_request_pty_ex(_p->channel.handle,
                                                    term.data(),
                                                    term.size(),
                                                    modes.data(),
@@ -428,8 +729,8 @@ bool SshSession::setEnv()
         if (name == "TERM")
             continue; // passed later via requestPty()
 
-        int const rc =
-            libssh2_channel_setenv_ex(_p->sshChannel, name.data(), name.size(), value.data(), value.size());
+        int const rc = libssh2_channel_setenv_ex(
+            _p->channel.handle, name.data(), name.size(), value.data(), value.size());
         if (rc == LIBSSH2_ERROR_EAGAIN)
         {
             _walkIndex = i;                // remember where we left off
@@ -448,7 +749,7 @@ bool SshSession::setEnv()
 void SshSession::resizeScreen()
 {
     auto const rc =
-        libssh2_channel_request_pty_size_ex(_p->sshChannel,
+        libssh2_channel_request_pty_size_ex(_p->channel.handle,
                                             unbox<int>(_pageSize.columns),
                                             unbox<int>(_pageSize.lines),
                                             _pixels.has_value() ? unbox<int>(_pixels->width) : 0,
@@ -471,13 +772,30 @@ void SshSession::processState()
     waitForSocket();
     while (true)
     {
+        // Channel requests may happen on a connection that is already shared with other sessions.
+        auto blockingSection = std::optional<BlockingSection> {};
+        if (State::OpenChannel <= _state && _state <= State::ResizeScreen && _state != State::Operational)
+            blockingSection.emplace(*_p->connection);
+
         switch (_state)
         {
             case State::Initial:
                 //.
                 return;
             case State::Started:
-                //.
+                if (_config.shareConnection)
+                {
+                    if (auto connection = SshConnectionPool::get().find(_config))
+                    {
+                        _p->connection = std::move(connection);
+                        logInfoWithInject("Sharing the existing connection to {}.", _config.hostname);
+                        setState(State::OpenChannel);
+                        break;
+                    }
+                }
+                _p->connection = std::make_shared<SshConnection>();
+                if (_config.compression)
+                    libssh2_session_flag(_p->connection->session, LIBSSH2_FLAG_COMPRESS, 1);
                 setState(State::Connect);
                 [[fallthrough]];
             case State::Connect:
@@ -486,7 +804,7 @@ void SshSession::processState()
                 setState(State::Handshake);
                 [[fallthrough]];
             case State::Handshake: {
-                int const rc = LIBSSH2_HANDSHAKE_FUNCTION(_p->sshSession, _p->sshSocket);
+                int const rc = LIBSSH2_HANDSHAKE_FUNCTION(_p->connection->session, _p->connection->socket);
                 if (rc == LIBSSH2_ERROR_EAGAIN)
                 {
                     _p->wantsWaitForSocket = true;
@@ -499,6 +817,13 @@ void SshSession::processState()
                     return;
                 }
 
+                if (_config.compression)
+                {
+                    auto const* const method =
+                        libssh2_session_methods(_p->connection->session, LIBSSH2_METHOD_COMP_SC);
+                    logInfo("Negotiated compression: {}", method ? method : "none");
+                }
+
                 setState(State::VerifyHostKey);
                 break;
             }
@@ -545,8 +870,20 @@ void SshSession::processState()
                 break;
             }
             case State::OpenChannel: {
-                _p->sshChannel = libssh2_channel_open_session(_p->sshSession);
-                auto const rc = libssh2_session_last_errno(_p->sshSession);
+                // Authenticated by now, so other sessions to the same host may use this connection.
+                if (_config.shareConnection)
+                    SshConnectionPool::get().add(_config, _p->connection);
+
+                constexpr auto ChannelType = "session"sv;
+                _p->channel.handle = libssh2_channel_open_ex(_p->connection->session,
+                                                         ChannelType.data(),
+                                                         static_cast<unsigned>(ChannelType.size()),
+                                                         _config.windowSize,
+                                                         _config.packetSize,
+                                                         nullptr,
+                                                         0);
+                auto const rc = _p->channel.handle ? LIBSSH2_ERROR_NONE
+                                                   : libssh2_session_last_errno(_p->connection->session);
                 if (rc == LIBSSH2_ERROR_EAGAIN)
                 {
                     _p->wantsWaitForSocket = true;
@@ -559,7 +896,7 @@ void SshSession::processState()
                     setState(State::Failure);
                     return;
                 }
-                assert(_p->sshChannel);
+                assert(_p->channel.handle);
                 setState(State::RequestAuthAgent);
                 [[fallthrough]];
             }
@@ -569,7 +906,7 @@ void SshSession::processState()
                 {
                     // TODO: When having this one working, make sure to update the documentation in
                     //       docs/profiles.md
-                    int const rc = libssh2_channel_request_auth_agent(_p->sshChannel);
+                    int const rc = libssh2_channel_request_auth_agent(_p->channel.handle);
                     if (rc == LIBSSH2_ERROR_EAGAIN)
                     {
                         _p->wantsWaitForSocket = true;
@@ -599,13 +936,14 @@ void SshSession::processState()
                 [[fallthrough]];
             }
             case State::StartShell: {
-                auto const rc = libssh2_channel_shell(_p->sshChannel);
+                auto const rc = libssh2_channel_shell(_p->channel.handle);
                 if (rc != LIBSSH2_ERROR_NONE)
                 {
                     logError("Failed to start shell. {}", libssl2ErrorString(rc));
                     setState(State::Failure);
                     return;
                 }
+                _p->connection->attach(_p->channel); // Switches to non-blocking I/O.
                 auto const _ = std::lock_guard { _injectMutex };
                 setState(State::Operational);
                 _injectCV.notify_all();
@@ -684,20 +1022,27 @@ void SshSession::close()
 {
     setState(State::Closed);
 
-    if (_p->sshChannel)
+    if (!_p->connection)
+        return;
+
+    auto const _ = BlockingSection { *_p->connection };
+    _p->connection->detach(_p->channel);
+    _p->connection->changed.notify_all(); // Wakes up a pending read() call.
+
+    if (_p->channel.handle)
     {
-        libssh2_channel_send_eof(_p->sshChannel);
-        libssh2_channel_close(_p->sshChannel);
-        libssh2_channel_wait_closed(_p->sshChannel);
+        libssh2_channel_send_eof(_p->channel.handle);
+        libssh2_channel_close(_p->channel.handle);
+        libssh2_channel_wait_closed(_p->channel.handle);
     }
 
-    if (_p->sshSocket.is_open())
-        _p->sshSocket.close();
+    // The socket is closed along with the connection, once no session is using it anymore.
 }
 
 bool SshSession::isClosed() const noexcept
 {
-    return _p->sshSocket.is_closed() || _state == State::Closed || _state == State::Failure;
+    return (_p->connection && _p->connection->socket.is_closed()) || _state == State::Closed
+           || _state == State::Failure;
 }
 
 void SshSession::waitForClosed()
@@ -721,6 +1066,7 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
         return ReadResult { .data = std::string_view { storage.hotEnd(), nread },
                             .fromStdoutFastPipe = false };
     }
+    injectLock.unlock(); // Do not hold up injections while waiting for the socket.
 
     if (_state == State::AuthenticatePasswordWaitForInput)
     {
@@ -729,7 +1075,8 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
     }
 
     // Below is for state: Operational
-    processState();
+    if (_state != State::Operational)
+        processState();
 
     if (_state != State::Operational && !isClosed())
     {
@@ -738,26 +1085,59 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
         return std::nullopt;
     }
 
-    waitForSocket(timeout);
-    // auto _ = std::unique_lock { _mutex };
-    auto const rc =
-        libssh2_channel_read(_p->sshChannel, storage.hotEnd(), std::min(storage.bytesAvailable(), size));
-
-    if (rc == LIBSSH2_ERROR_EAGAIN)
+    if (!_p->connection)
     {
-        _p->wantsWaitForSocket = true;
-        errno = EAGAIN;
+        errno = EIO;
         return std::nullopt;
     }
 
-    if (rc < 0)
+    // The connection's I/O thread receives the channel data into its inbox.
+    auto& connection = *_p->connection;
+    auto& channel = _p->channel;
+    auto lock = std::unique_lock { connection.mutex };
+    auto const ready = [&]() {
+        return channel.inboxSize() != 0 || channel.eof || channel.woken || isClosed();
+    };
+    if (timeout)
+        connection.changed.wait_for(lock, *timeout, ready);
+    else
+        connection.changed.wait(lock, ready);
+    channel.woken = false;
+
+    if (channel.inboxSize() == 0)
     {
-        logError("Failed to read from SSH channel. {}", libssl2ErrorString(rc));
-        errno = EIO;
-        return std::nullopt;
+        if (channel.error != LIBSSH2_ERROR_NONE)
+        {
+            logError("Failed to read from SSH channel. {}", libssl2ErrorString(channel.error));
+            errno = EIO;
+            return std::nullopt;
+        }
+        if (!channel.eof && !isClosed())
+        {
+            errno = EAGAIN; // timed out or woken up
+            return std::nullopt;
+        }
     }
 
-    auto const target = std::string_view { (char const*) storage.hotEnd(), static_cast<size_t>(rc) };
+    auto const wasFull = channel.inboxSize() >= SshConnection::InboxCapacity;
+    auto const nread = std::min({ size, storage.bytesAvailable(), channel.inboxSize() });
+    std::copy_n(channel.inbox.data() + channel.inboxOffset, nread, storage.hotEnd());
+    channel.inboxOffset += nread;
+    if (channel.inboxOffset == channel.inbox.size())
+    {
+        channel.inbox.clear();
+        channel.inboxOffset = 0;
+    }
+    else if (channel.inboxOffset >= SshConnection::InboxCapacity)
+    {
+        channel.inbox.erase(0, channel.inboxOffset);
+        channel.inboxOffset = 0;
+    }
+    if (wasFull)
+        connection.wakeup(); // The I/O thread may resume reading this channel.
+    lock.unlock();
+
+    auto const target = std::string_view { storage.hotEnd(), nread };
     auto const isStdFastPipe = false; // can never be, because it's an SSH network connection
     if (ptyInLog)
         ptyInLog()(
@@ -768,11 +1148,14 @@ std::optional<SshSession::ReadResult> SshSession::read(crispy::buffer_object<cha
 
 void SshSession::wakeupReader()
 {
-    // TODO: implement
-    //
-    // wakeupReader() is invoked in TerminalSession's destructor (we could as well just call forceClose()
-    // there, which would first wake-up a potential read()-call, if necessary.
-    // And it's called in Terminal twice, where I am currently not sure that we even still need these calls.
+    if (!_p->connection)
+        return;
+
+    {
+        auto const _ = std::lock_guard { _p->connection->mutex };
+        _p->channel.woken = true;
+    }
+    _p->connection->changed.notify_all();
 }
 
 void SshSession::handlePreAuthenticationPasswordInput(std::string_view buf, State next)
@@ -822,13 +1205,17 @@ int SshSession::write(std::string_view buf)
         return static_cast<int>(buf.size()); // Make the caller believe that we have written all bytes.
     }
 
-    waitForSocket();
-    auto const rv = libssh2_channel_write(_p->sshChannel, buf.data(), buf.size());
+    auto const rv = [&]() {
+        auto const _ = std::lock_guard { _p->connection->mutex };
+        return libssh2_channel_write(_p->channel.handle, buf.data(), buf.size());
+    }();
+
+    // Writing may have received packets for any channel, which the I/O thread needs to pick up.
+    _p->connection->wakeup();
 
     if (rv == LIBSSH2_ERROR_EAGAIN)
     {
-        _p->wantsWaitForSocket = true;
-        errno = EAGAIN;
+        errno = EAGAIN; // See waitForWritable().
         return -1;
     }
 
@@ -853,6 +1240,26 @@ int SshSession::write(std::string_view buf)
     return static_cast<int>(rv);
 }
 
+bool SshSession::waitForWritable(std::chrono::milliseconds timeout)
+{
+    if (!isOperational())
+        return true;
+
+    auto& connection = *_p->connection;
+    auto lock = std::unique_lock { connection.mutex };
+    if (libssh2_channel_window_write(_p->channel.handle) == 0)
+    {
+        // The server's receive window is exhausted. It is reopened by a window adjustment,
+        // which is picked up by the I/O thread.
+        return connection.changed.wait_for(lock, timeout, [&]() {
+            return isClosed() || libssh2_channel_window_write(_p->channel.handle) != 0;
+        });
+    }
+    lock.unlock();
+
+    return connection.poll(false, true, timeout, false) > 0;
+}
+
 PageSize SshSession::pageSize() const noexcept
 {
     return _pageSize;
@@ -889,14 +1296,18 @@ bool SshSession::isOperational() const noexcept
 
 std::optional<SshSession::ExitStatus> SshSession::exitStatus() const
 {
-    auto exitcode = libssh2_channel_get_exit_status(_p->sshChannel);
+    if (!_p->channel.handle)
+        return std::nullopt;
+
+    auto const _ = std::lock_guard { _p->connection->mutex };
+    auto exitcode = libssh2_channel_get_exit_status(_p->channel.handle);
 
     char* exitSignalStr = nullptr;
     char* errorMessage = nullptr;
     char* languageTag = nullptr;
 
     auto const rv = libssh2_channel_get_exit_signal(
-        _p->sshChannel, &exitSignalStr, nullptr, &errorMessage, nullptr, &languageTag, nullptr);
+        _p->channel.handle, &exitSignalStr, nullptr, &errorMessage, nullptr, &languageTag, nullptr);
     if (rv)
     {
         logError("Failed to get exit signal. {}", libssl2ErrorString(rv));
@@ -990,10 +1401,10 @@ bool SshSession::connect(std::string_view host, int port)
                     break;
             }
 
-            _p->sshSocket = socket_handle::from_native(
+            _p->connection->socket = socket_handle::from_native(
                 socket(addrEntry->ai_family, addrEntry->ai_socktype, addrEntry->ai_protocol));
 
-            if (::connect(_p->sshSocket, addrEntry->ai_addr, addrEntry->ai_addrlen) == 0)
+            if (::connect(_p->connection->socket, addrEntry->ai_addr, addrEntry->ai_addrlen) == 0)
             {
                 auto const addrAndPort =
                     port == 22 ? std::string(addrStr) : std::format("{}:{}", addrStr, port);
@@ -1015,7 +1426,7 @@ bool SshSession::connect(std::string_view host, int port)
     }
 
     logError("Failed to connect to {}:{}", host, port);
-    _p->sshSocket.close(); // Explicitly close socket, to indicate that we're not connected
+    _p->connection->socket.close(); // Explicitly close socket, to indicate that we're not connected
     return false;
 }
 
@@ -1027,7 +1438,7 @@ bool SshSession::verifyHostKey()
         return true;
     }
 
-    LIBSSH2_KNOWNHOSTS* knownHosts = libssh2_knownhost_init(_p->sshSession);
+    LIBSSH2_KNOWNHOSTS* knownHosts = libssh2_knownhost_init(_p->connection->session);
     if (!knownHosts)
     {
         logError("Failed to initialize known_hosts file.");
@@ -1047,7 +1458,7 @@ bool SshSession::verifyHostKey()
 
     int hostkeyType = 0;
     size_t hostkeyLength = 0;
-    char const* hostkeyRaw = libssh2_session_hostkey(_p->sshSession, &hostkeyLength, &hostkeyType);
+    char const* hostkeyRaw = libssh2_session_hostkey(_p->connection->session, &hostkeyLength, &hostkeyType);
     int knownhostType = LIBSSH2_KNOWNHOST_KEY_UNKNOWN;
     switch (hostkeyType)
     {
@@ -1127,7 +1538,7 @@ void SshSession::logErrorWithDetails(int libssl2ErrorCode, std::string_view mess
 {
     char* errorMessageBuffer = nullptr;
     int errorMessageLength = 0;
-    libssh2_session_last_error(_p->sshSession, &errorMessageBuffer, &errorMessageLength, 0);
+    libssh2_session_last_error(_p->connection->session, &errorMessageBuffer, &errorMessageLength, 0);
     auto libssl2Message = std::string_view { errorMessageBuffer, static_cast<size_t>(errorMessageLength) };
 
     logError("{}: {}", message, libssl2ErrorString(libssl2ErrorCode));
@@ -1141,60 +1552,21 @@ int SshSession::waitForSocket(std::optional<std::chrono::milliseconds> timeout)
 
     _p->wantsWaitForSocket = false;
 
-#if defined(SSH_SESSION_NB_IO)
-    fd_set fd;
-    fd_set* writefd = nullptr;
-    fd_set* readfd = nullptr;
-
-    auto tv = timeval {};
-    if (timeout)
-    {
-        tv.tv_sec = timeout->count() / 1000;
-        tv.tv_usec = (timeout->count() % 1000) * 1000;
-    }
-
-    // TODO: also watch for break signal, so we can abort waiting for socket
+    assert(_p->connection->session);
 
-    FD_ZERO(&fd);
-    FD_SET(_p->sshSocket, &fd);
-
-    assert(_p->sshSession);
-
-    auto const dir =
-        libssh2_session_block_directions(_p->sshSession); // now make sure we wait in the correct direction
-
-    if (dir & LIBSSH2_SESSION_BLOCK_INBOUND)
-    {
-        readfd = &fd;
-        std::cout << std::format("({}) SshSession: waiting for socket to become readable\n",
-                                 crispy::threadName());
-    }
-
-    if (dir & LIBSSH2_SESSION_BLOCK_OUTBOUND)
-    {
-        writefd = &fd;
-        std::cout << std::format("({}) SshSession: waiting for socket to become readable\n",
-                                 crispy::threadName());
-    }
-
-    auto const rc = ::select((int) (_p->sshSocket + 1), readfd, writefd, nullptr, timeout ? &tv : nullptr);
-    std::cout << std::format("({}) SshSession: select() returned {}{}{}\n",
-                             crispy::threadName(),
-                             rc,
-                             readfd && FD_ISSET(_p->sshSocket, readfd) ? " [readable]" : "",
-                             writefd && FD_ISSET(_p->sshSocket, writefd) ? " [writable]" : "");
-    return rc;
-#else
-    crispy::ignore_unused(timeout);
-    return 0;
-#endif
+    // now make sure we wait in the correct direction
+    auto const dir = libssh2_session_block_directions(_p->connection->session);
+    return _p->connection->poll((dir & LIBSSH2_SESSION_BLOCK_INBOUND) != 0,
+                                (dir & LIBSSH2_SESSION_BLOCK_OUTBOUND) != 0,
+                                timeout,
+                                false);
 }
 
 void SshSession::authenticateWithPrivateKey()
 {
     auto const password = _injectedWrite;
     auto const rc = libssh2_userauth_publickey_fromfile_ex(
-        _p->sshSession,
+        _p->connection->session,
         _config.username.data(),
         _config.username.size(),
         _config.publicKeyFile.empty() ? nullptr : _config.publicKeyFile.string().data(),
@@ -1238,7 +1610,7 @@ void SshSession::authenticateWithPassword()
     auto const password = std::move(_injectedWrite);
     _injectedWrite = {};
 
-    int const rc = libssh2_userauth_password_ex(_p->sshSession,
+    int const rc = libssh2_userauth_password_ex(_p->connection->session,
                                                 _config.username.data(),
                                                 _config.username.size(),
                                                 password.data(),
@@ -1273,23 +1645,23 @@ void SshSession::authenticateWithPassword()
 
 bool SshSession::authenticateWithAgent()
 {
-    if (!_p->sshAgent)
+    if (!_p->connection->agent)
     {
-        _p->sshAgent = libssh2_agent_init(_p->sshSession);
-        if (!_p->sshAgent)
+        _p->connection->agent = libssh2_agent_init(_p->connection->session);
+        if (!_p->connection->agent)
         {
             logError("Failed to initialize SSH agent.");
             return false;
         }
 
-        int rc = libssh2_agent_connect(_p->sshAgent);
+        int rc = libssh2_agent_connect(_p->connection->agent);
         if (rc != LIBSSH2_ERROR_NONE)
         {
             logError("Failed to connect to SSH agent. {}", libssl2ErrorString(rc));
             return false;
         }
 
-        rc = libssh2_agent_list_identities(_p->sshAgent);
+        rc = libssh2_agent_list_identities(_p->connection->agent);
         if (rc != LIBSSH2_ERROR_NONE)
         {
             logError("Failed to list SSH identities. {}", libssl2ErrorString(rc));
@@ -1303,7 +1675,7 @@ bool SshSession::authenticateWithAgent()
     libssh2_agent_publickey* prevIdentity = nullptr;
     int rc = 0;
     int i = 0;
-    while ((rc = libssh2_agent_get_identity(_p->sshAgent, &identity, prevIdentity)) == 0)
+    while ((rc = libssh2_agent_get_identity(_p->connection->agent, &identity, prevIdentity)) == 0)
     {
         prevIdentity = identity;
         if (i < _walkIndex)
@@ -1312,7 +1684,7 @@ bool SshSession::authenticateWithAgent()
             continue;
         }
 
-        rc = libssh2_agent_userauth(_p->sshAgent, _config.username.data(), identity);
+        rc = libssh2_agent_userauth(_p->connection->agent, _config.username.data(), identity);
         if (rc == LIBSSH2_ERROR_EAGAIN)
         {
             _p->wantsWaitForSocket = true;
@@ -21,6 +21,13 @@ struct SshHostConfig
 {
     using Environment = std::map<std::string, std::string>;
 
+    /// Default receive window of the session channel. Throughput is bounded by the window size
+    /// divided by the round-trip time, so this is large enough for fast links with high latency.
+    static constexpr inline unsigned DefaultWindowSize = 16 * 1024 * 1024;
+
+    /// Default maximum packet size of the session channel, which every SSH server must accept.
+    static constexpr inline unsigned DefaultPacketSize = 32 * 1024;
+
     std::string hostname;
     int port = 22;
     std::string username;
@@ -28,6 +35,10 @@ struct SshHostConfig
     std::filesystem::path publicKeyFile;
     std::filesystem::path knownHostsFile;
     bool forwardAgent = false;
+    bool compression = false;
+    bool shareConnection = true;
+    unsigned windowSize = DefaultWindowSize;
+    unsigned packetSize = DefaultPacketSize;
     Environment env;
 
     [[nodiscard]] std::string toString() const;
@@ -40,6 +51,9 @@ crispy::result<SshHostConfigMap> loadSshConfig(std::filesystem::path const& conf
 crispy::result<SshHostConfigMap> loadSshConfig();
 
 /// SSH Login session.
+///
+/// Sessions to the same host, port and user share a single SSH connection, each using a channel
+/// of its own, unless SshHostConfig::shareConnection is disabled.
 class SshSession final: public Pty
 {
   public:
@@ -64,6 +78,7 @@ class SshSession final: public Pty
                                                  size_t size) override;
     void wakeupReader() override;
     [[nodiscard]] int write(std::string_view buf) override;
+    [[nodiscard]] bool waitForWritable(std::chrono::milliseconds timeout) override;
     [[nodiscard]] PageSize pageSize() const noexcept override;
     void resizeScreen(PageSize cells, std::optional<ImageSize> pixels = std::nullopt) override;
 
@@ -152,7 +167,6 @@ class SshSession final: public Pty
     PageSize _pageSize { .lines = LineCount(24), .columns = ColumnCount(80) };
     std::optional<ImageSize> _pixels = std::nullopt;
     std::unique_ptr<PtySlave> _ptySlave;
-    std::mutex _mutex;
 
     struct Private;
     std::unique_ptr<Private, void (*)(Private*)> _p;
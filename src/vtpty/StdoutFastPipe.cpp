@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtpty/StdoutFastPipe.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+    #include <sys/uio.h>
+#endif
+
+namespace vtpty
+{
+
+int stdoutFastPipeFromEnvironment() noexcept
+{
+    auto const* value = std::getenv(StdoutFastPipeEnvironmentName.data());
+    if (!value)
+        return -1;
+
+    auto fd = -1;
+    auto const* end = value + std::strlen(value);
+    if (std::from_chars(value, end, fd).ptr != end || fd < 0)
+        return -1;
+    return fd;
+}
+
+size_t pipeCapacity(int fd) noexcept
+{
+#if defined(F_GETPIPE_SZ)
+    auto const capacity = fcntl(fd, F_GETPIPE_SZ);
+    return capacity > 0 ? static_cast<size_t>(capacity) : 0;
+#else
+    (void) fd;
+    return 0;
+#endif
+}
+
+bool writeToStdoutFastPipe(int fd, std::string_view data) noexcept
+{
+#if defined(__linux__)
+    while (!data.empty())
+    {
+        auto iov = iovec { .iov_base = const_cast<char*>(data.data()), .iov_len = data.size() };
+        auto const rv = vmsplice(fd, &iov, 1, 0);
+        if (rv < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EINVAL || errno == ENOSYS)
+                break; // Not a pipe, or no splicing support. Fall back to writing.
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(rv));
+    }
+#endif
+
+    while (!data.empty())
+    {
+        auto const rv = ::write(fd, data.data(), data.size());
+        if (rv < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(rv));
+    }
+
+    return true;
+}
+
+} // namespace vtpty
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace vtpty
+{
+
+/// Name of the environment variable that tells the child process the file descriptor
+/// of the stdout fastpipe, if there is one.
+constexpr inline std::string_view StdoutFastPipeEnvironmentName = "STDOUT_FASTPIPE";
+
+/// File descriptor of the stdout fastpipe within the child process.
+constexpr inline int StdoutFastPipeFd = 3;
+
+/// Capacity in bytes the terminal requests for the stdout fastpipe, where supported.
+constexpr inline size_t StdoutFastPipeCapacity = 1024 * 1024;
+
+/// @returns the file descriptor of the stdout fastpipe as passed by the terminal, or -1 if there is none.
+[[nodiscard]] int stdoutFastPipeFromEnvironment() noexcept;
+
+/// @returns the capacity of the given pipe in bytes, or 0 if unknown.
+[[nodiscard]] size_t pipeCapacity(int fd) noexcept;
+
+/// Writes all of @p data to the stdout fastpipe @p fd, blocking as necessary.
+///
+/// On Linux, the pages of @p data are spliced into the pipe (vmsplice) rather than copied.
+/// The pipe then refers to the caller's memory, which therefore must not be modified until
+/// the terminal has read it. This is guaranteed once another pipeCapacity() bytes have been
+/// written after it, e.g. when alternating between buffers that are each at least that large.
+///
+/// Where splicing is not available, the data is simply written to the pipe.
+///
+/// @returns true on success, false on error with errno set.
+bool writeToStdoutFastPipe(int fd, std::string_view data) noexcept;
+
+} // namespace vtpty
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtpty/Process.h>
+#include <vtpty/StdoutFastPipe.h>
 #include <vtpty/UnixPty.h>
 #include <vtpty/UnixUtils.h>
 
@@ -35,6 +36,7 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <poll.h>
 #include <pwd.h>
 #include <unistd.h>
 
@@ -219,6 +221,10 @@ void UnixPty::start()
         throw runtime_error { "Failed to configure PTY. "s + strerror(errno) };
 
     util::setFileFlags(_stdoutFastPipe.reader(), O_NONBLOCK);
+#if defined(F_SETPIPE_SZ)
+    // Producers splicing their pages into the pipe can hand over this much at once without blocking.
+    fcntl(_stdoutFastPipe.writer(), F_SETPIPE_SZ, static_cast<int>(StdoutFastPipeCapacity));
+#endif
     ptyLog()("stdout fastpipe: reader {}, writer {}", _stdoutFastPipe.reader(), _stdoutFastPipe.writer());
 
     _readSelector.want_read(_masterFd);
@@ -245,6 +251,18 @@ PtyMasterHandle UnixPty::handle() const noexcept
     return PtyMasterHandle::cast_from(_masterFd.get());
 }
 
+std::string UnixPty::slaveName() const
+{
+    if (!_slave || _slave->isClosed())
+        return {};
+
+    char name[256] {};
+    if (ttyname_r(unbox<int>(_slave->handle()), name, sizeof(name)) != 0)
+        return {};
+
+    return name;
+}
+
 void UnixPty::close()
 {
     auto const _ = std::scoped_lock { _mutex };
@@ -270,6 +288,16 @@ void UnixPty::wakeupReader() noexcept
     _readSelector.wakeup();
 }
 
+optional<int> UnixPty::readinessDescriptor() const noexcept
+{
+#if defined(__linux__)
+    // The epoll instance becomes readable as soon as any of the descriptors it waits for does.
+    return _readSelector.native_handle();
+#else
+    return nullopt;
+#endif
+}
+
 optional<string_view> UnixPty::readSome(int fd, char* target, size_t n) noexcept
 {
     auto const rv = static_cast<int>(::read(fd, target, n));
@@ -280,10 +308,10 @@ optional<string_view> UnixPty::readSome(int fd, char* target, size_t n) noexcept
         return nullopt;
     }
 
-    if (ptyInLog)
-        ptyInLog()("{} received: \"{}\"",
-                   fd == _masterFd ? "master" : "stdout-fastpipe",
-                   crispy::escape(target, target + rv));
+    LOGSTORE_LOG(ptyInLog,
+                 "{} received: \"{}\"",
+                 fd == _masterFd ? "master" : "stdout-fastpipe",
+                 crispy::escape(target, target + rv));
 
     if (rv == 0 && fd == _stdoutFastPipe.reader())
     {
@@ -303,11 +331,34 @@ std::optional<Pty::ReadResult> UnixPty::read(crispy::buffer_object<char>& storag
 {
     assert(_readSelector.size() > 0);
 
+    // Under load, skip the round trip through the read selector while the master most likely
+    // has more data pending.
+    if (_directMasterReads > 0 && _masterFd != -1)
+    {
+        --_directMasterReads;
+        auto const l = scoped_lock { storage };
+        auto const n = std::min(size, storage.bytesAvailable());
+        if (auto x = readSome(_masterFd, storage.hotEnd(), n))
+        {
+            if (x->size() < n)
+                _directMasterReads = 0;
+            return ReadResult { .data = x.value(), .fromStdoutFastPipe = false };
+        }
+        _directMasterReads = 0;
+        if (errno != EAGAIN)
+            return std::nullopt;
+    }
+
     if (auto const fd = _readSelector.wait_one(timeout); fd.has_value())
     {
         auto const l = scoped_lock { storage };
-        if (auto x = readSome(*fd, storage.hotEnd(), std::min(size, storage.bytesAvailable())))
+        auto const n = std::min(size, storage.bytesAvailable());
+        if (auto x = readSome(*fd, storage.hotEnd(), n))
+        {
+            if (*fd == _masterFd)
+                _directMasterReads = x->size() == n ? MaxDirectMasterReads : 0;
             return ReadResult { .data = x.value(), .fromStdoutFastPipe = *fd == _stdoutFastPipe.reader() };
+        }
     }
     else
         errno = EAGAIN;
@@ -336,22 +387,16 @@ int UnixPty::write(std::string_view data)
         // clang-format on
     }
 
-    if (0 <= rv && static_cast<size_t>(rv) < size)
-    {
-        util::setFileBlocking(_masterFd, true);
-        auto const rv2 = ::write(_masterFd, buf + rv, size - rv);
-        util::setFileBlocking(_masterFd, false);
-        if (rv2 >= 0)
-        {
-            if (ptyOutLog)
-                ptyOutLog()("Sending bytes: \"{}\"", crispy::escape(buf + rv, buf + rv + rv2));
-            return static_cast<int>(rv + rv2);
-        }
-    }
-
     return static_cast<int>(rv);
 }
 
+bool UnixPty::waitForWritable(std::chrono::milliseconds timeout)
+{
+    auto pfd = pollfd { .fd = _masterFd, .events = POLLOUT, .revents = 0 };
+    auto const rv = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+    return rv > 0 && (pfd.revents & POLLOUT);
+}
+
 PageSize UnixPty::pageSize() const noexcept
 {
     return _pageSize;
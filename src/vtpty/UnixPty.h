@@ -11,6 +11,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
 
 #if defined(__APPLE__)
     #include <util.h>
@@ -59,15 +60,20 @@ class UnixPty final: public Pty
     void waitForClosed() override;
     [[nodiscard]] bool isClosed() const noexcept override;
     void wakeupReader() noexcept override;
+    [[nodiscard]] std::optional<int> readinessDescriptor() const noexcept override;
     [[nodiscard]] std::optional<ReadResult> read(crispy::buffer_object<char>& storage,
                                                  std::optional<std::chrono::milliseconds> timeout,
                                                  size_t size) override;
     int write(std::string_view data) override;
+    [[nodiscard]] bool waitForWritable(std::chrono::milliseconds timeout) override;
     [[nodiscard]] PageSize pageSize() const noexcept override;
     void resizeScreen(PageSize cells, std::optional<ImageSize> pixels = std::nullopt) override;
 
     UnixPipe& stdoutFastPipe() noexcept { return _stdoutFastPipe; }
 
+    /// @returns the path of the PTY slave device, or an empty string if the slave is not open.
+    [[nodiscard]] std::string slaveName() const;
+
   private:
     std::optional<std::string_view> readSome(int fd, char* target, size_t n) noexcept;
 
@@ -80,6 +86,12 @@ class UnixPty final: public Pty
     std::optional<ImageSize> _pixels;
     std::unique_ptr<Slave> _slave;
     std::mutex _mutex;
+
+    // Number of reads from the master that may still be issued right away, without waiting for the
+    // read selector first. Non-zero while the previous read filled the whole buffer, which under
+    // load means that more data is pending. Bounded so that the stdout fastpipe gets its turn.
+    unsigned _directMasterReads = 0;
+    static constexpr unsigned MaxDirectMasterReads = 16;
 };
 
 } // namespace vtpty
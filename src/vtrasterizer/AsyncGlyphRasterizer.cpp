@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/AsyncGlyphRasterizer.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace vtrasterizer
+{
+
+AsyncGlyphRasterizer::AsyncGlyphRasterizer(Rasterize rasterize, std::function<void()> glyphsRasterized):
+    _rasterize { std::move(rasterize) },
+    _glyphsRasterized { std::move(glyphsRasterized) },
+    _thread { [this]() {
+        run();
+    } }
+{
+}
+
+AsyncGlyphRasterizer::~AsyncGlyphRasterizer()
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        _stopping = true;
+    }
+    _condition.notify_all();
+    _thread.join();
+}
+
+void AsyncGlyphRasterizer::request(crispy::strong_hash const& hash,
+                                   text::glyph_key const& glyph,
+                                   unicode::PresentationStyle presentation)
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        if (!_requested.insert(hash).second)
+            return;
+        _requests.emplace_back(Request { .hash = hash, .glyph = glyph, .presentation = presentation });
+    }
+    _condition.notify_one();
+}
+
+std::vector<AsyncGlyphRasterizer::Result> AsyncGlyphRasterizer::takeResults()
+{
+    auto const lock = std::scoped_lock { _mutex };
+    auto results = std::move(_results);
+    _results.clear();
+
+    // Completed glyphs may be requested again, e.g. once they got evicted from the texture atlas.
+    // Failed ones are not, as they would only fail again.
+    for (auto const& result: results)
+        _requested.erase(result.hash);
+
+    return results;
+}
+
+void AsyncGlyphRasterizer::cancel()
+{
+    {
+        auto const lock = std::scoped_lock { _mutex };
+        _requests.clear();
+        _results.clear();
+        _requested.clear();
+        ++_generation;
+    }
+
+    // Wait for the glyph currently being rasterized, if any.
+    auto const shaperLock = lockShaper();
+}
+
+void AsyncGlyphRasterizer::run()
+{
+    auto requests = std::vector<Request> {};
+    auto glyphs = std::vector<text::glyph_key> {};
+    for (;;)
+    {
+        auto generation = uint64_t { 0 };
+        {
+            auto lock = std::unique_lock { _mutex };
+            _condition.wait(lock, [this]() { return _stopping || !_requests.empty(); });
+            if (_stopping)
+                return;
+            auto const count = std::min(_requests.size(), BatchSize);
+            requests.assign(_requests.begin(), _requests.begin() + static_cast<std::ptrdiff_t>(count));
+            _requests.erase(_requests.begin(), _requests.begin() + static_cast<std::ptrdiff_t>(count));
+            generation = _generation;
+        }
+
+        glyphs.clear();
+        for (auto const& request: requests)
+            glyphs.emplace_back(request.glyph);
+
+        auto bitmaps = std::vector<std::optional<text::rasterized_glyph>> {};
+        {
+            auto const shaperLock = lockShaper();
+
+            // The requests' fonts may be gone if cancel() was called in the meantime.
+            {
+                auto const lock = std::scoped_lock { _mutex };
+                if (generation != _generation)
+                    continue;
+            }
+
+            bitmaps = _rasterize(glyphs);
+        }
+
+        auto rasterized = false;
+        {
+            auto const lock = std::scoped_lock { _mutex };
+            if (generation != _generation)
+                continue;
+            for (size_t i = 0; i < requests.size() && i < bitmaps.size(); ++i)
+            {
+                if (!bitmaps[i])
+                    continue;
+                _results.emplace_back(Result { .hash = requests[i].hash,
+                                               .glyph = requests[i].glyph,
+                                               .presentation = requests[i].presentation,
+                                               .bitmap = std::move(*bitmaps[i]) });
+                rasterized = true;
+            }
+        }
+
+        if (rasterized && _glyphsRasterized)
+            _glyphsRasterized();
+    }
+}
+
+} // namespace vtrasterizer
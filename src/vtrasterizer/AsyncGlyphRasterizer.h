@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <text_shaper/font.h>
+#include <text_shaper/shaper.h>
+
+#include <crispy/StrongHash.h>
+
+#include <libunicode/emoji_segmenter.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace vtrasterizer
+{
+
+/**
+ * Rasterizes glyphs on a background thread, so that rendering a frame never has to wait
+ * for a whole batch of new glyphs (e.g. a screen full of CJK or emoji) to be rasterized.
+ *
+ * The text shaper is not thread-safe, which is why any use of it while this rasterizer exists
+ * must hold the lock returned by lockShaper(). The worker only holds it for one batch of glyphs at a time.
+ */
+class AsyncGlyphRasterizer
+{
+  public:
+    /// Rasterizes a batch of glyphs, yielding the results in the order of the glyphs.
+    using Rasterize = std::function<std::vector<std::optional<text::rasterized_glyph>>(
+        std::vector<text::glyph_key> const&)>;
+
+    /// Number of queued glyphs rasterized at most at once, bounding how long the shaper stays locked.
+    static constexpr inline size_t BatchSize = 32;
+
+    struct Result
+    {
+        crispy::strong_hash hash;
+        text::glyph_key glyph;
+        unicode::PresentationStyle presentation;
+        text::rasterized_glyph bitmap;
+    };
+
+    /// @p rasterize          rasterizes a batch of glyphs, invoked on the worker thread with the shaper
+    ///                       locked.
+    /// @p glyphsRasterized   invoked on the worker thread whenever new results are available.
+    AsyncGlyphRasterizer(Rasterize rasterize, std::function<void()> glyphsRasterized);
+
+    AsyncGlyphRasterizer(AsyncGlyphRasterizer const&) = delete;
+    AsyncGlyphRasterizer(AsyncGlyphRasterizer&&) = delete;
+    AsyncGlyphRasterizer& operator=(AsyncGlyphRasterizer const&) = delete;
+    AsyncGlyphRasterizer& operator=(AsyncGlyphRasterizer&&) = delete;
+    ~AsyncGlyphRasterizer();
+
+    [[nodiscard]] std::unique_lock<std::mutex> lockShaper() { return std::unique_lock { _shaperMutex }; }
+
+    /// Requests the given glyph to be rasterized, unless it has been requested already.
+    void request(crispy::strong_hash const& hash,
+                 text::glyph_key const& glyph,
+                 unicode::PresentationStyle presentation);
+
+    /// @returns all glyphs that have been rasterized since the last call.
+    [[nodiscard]] std::vector<Result> takeResults();
+
+    /// Discards all pending requests and results, and waits for the glyph currently being rasterized.
+    ///
+    /// This must be called before the fonts of the text shaper are changed.
+    void cancel();
+
+  private:
+    struct Request
+    {
+        crispy::strong_hash hash;
+        text::glyph_key glyph;
+        unicode::PresentationStyle presentation;
+    };
+
+    void run();
+
+    Rasterize _rasterize;
+    std::function<void()> _glyphsRasterized;
+
+    std::mutex _shaperMutex;
+
+    // Guards all members below.
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Request> _requests;
+    std::vector<Result> _results;
+    std::unordered_set<crispy::strong_hash> _requested; // pending, completed, and failed requests
+    uint64_t _generation = 0;                           // increased by every cancel()
+    bool _stopping = false;
+
+    std::thread _thread;
+};
+
+} // namespace vtrasterizer
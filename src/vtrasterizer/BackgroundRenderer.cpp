@@ -56,18 +56,105 @@ void BackgroundRenderer::renderLine(vtbackend::RenderLine const& line)
     }
 }
 
-void BackgroundRenderer::renderCell(vtbackend::RenderCell const& cell)
+void BackgroundRenderer::renderCells(vtbackend::RenderCells const& cells)
 {
-    if (cell.attributes.backgroundColor == _defaultColor)
+    auto run = BackgroundRun {};
+
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        auto const backgroundColor = cells.attributes[i].backgroundColor;
+        if (backgroundColor == _defaultColor)
+            continue;
+
+        auto const position = cells.positions[i];
+        auto const extendsRun = run.columns != 0 && position.line == run.start.line
+                                && *position.column == *run.start.column + run.columns
+                                && backgroundColor == run.color;
+        if (extendsRun)
+        {
+            run.columns += cells.widths[i];
+            continue;
+        }
+
+        if (run.columns != 0)
+            addRun(run);
+        run = BackgroundRun { .start = position, .columns = cells.widths[i], .color = backgroundColor };
+    }
+
+    if (run.columns != 0)
+        addRun(run);
+
+    flushRuns();
+}
+
+void BackgroundRenderer::addRun(BackgroundRun const& run)
+{
+    if (run.start.line != _currentLine)
+    {
+        // Runs of the previous line that have not been extended so far cannot be extended anymore.
+        auto const continuesCurrentLine = run.start.line == _currentLine + 1;
+        _currentLine = run.start.line;
+        for (BackgroundRun const& previous: _previousLineRuns)
+            renderRun(previous);
+        _previousLineRuns.clear();
+        _previousLineCursor = 0;
+        if (continuesCurrentLine)
+            std::swap(_previousLineRuns, _currentLineRuns);
+        else
+            for (BackgroundRun const& current: _currentLineRuns)
+                renderRun(current);
+        _currentLineRuns.clear();
+    }
+
+    // Both lines' runs are ordered by column, so the ones left of this run can be rendered already.
+    while (_previousLineCursor < _previousLineRuns.size()
+           && *_previousLineRuns[_previousLineCursor].start.column < *run.start.column)
+    {
+        auto& previous = _previousLineRuns[_previousLineCursor++];
+        renderRun(previous);
+        previous.columns = 0; // rendered already
+    }
+
+    if (_previousLineCursor < _previousLineRuns.size())
+    {
+        auto& above = _previousLineRuns[_previousLineCursor];
+        auto const matches = above.start.column == run.start.column && above.columns == run.columns
+                             && above.color == run.color;
+        if (matches)
+        {
+            ++above.lines;
+            _currentLineRuns.emplace_back(above);
+            above.columns = 0; // moved down into the current line
+            ++_previousLineCursor;
+            return;
+        }
+    }
+
+    _currentLineRuns.emplace_back(run);
+}
+
+void BackgroundRenderer::flushRuns()
+{
+    for (auto const* runs: { &_previousLineRuns, &_currentLineRuns })
+        for (BackgroundRun const& run: *runs)
+            renderRun(run);
+    _previousLineRuns.clear();
+    _currentLineRuns.clear();
+    _previousLineCursor = 0;
+}
+
+void BackgroundRenderer::renderRun(BackgroundRun const& run)
+{
+    if (run.columns == 0)
         return;
 
-    auto const pos = _gridMetrics.mapTopLeft(cell.position);
+    auto const pos = _gridMetrics.mapTopLeft(run.start);
 
     renderTarget().renderRectangle(pos.x,
                                    pos.y,
-                                   _gridMetrics.cellSize.width * vtbackend::Width::cast_from(cell.width),
-                                   _gridMetrics.cellSize.height,
-                                   vtbackend::RGBAColor(cell.attributes.backgroundColor, _opacity));
+                                   _gridMetrics.cellSize.width * vtbackend::Width::cast_from(run.columns),
+                                   _gridMetrics.cellSize.height * vtbackend::Height::cast_from(run.lines),
+                                   vtbackend::RGBAColor(run.color, _opacity));
 }
 
 void BackgroundRenderer::inspect(std::ostream& /*output*/) const
@@ -7,6 +7,7 @@
 #include <vtrasterizer/RenderTarget.h>
 
 #include <memory>
+#include <vector>
 
 namespace vtrasterizer
 {
@@ -30,17 +31,42 @@ class BackgroundRenderer: public Renderable
     // TODO: pass background color directly (instead of whole grid cell),
     // because there is no need to detect bg/fg color more than once per grid cell!
 
-    /// Queues up a render with given background
-    void renderCell(vtbackend::RenderCell const& cell);
+    /// Queues up a render of the non-default backgrounds of the given cells.
+    ///
+    /// Only reads the cells' positions, widths, and attributes.
+    /// Adjacent cells of the same background color are merged into as few rectangles as possible:
+    /// horizontally into runs, and runs spanning the same columns on consecutive lines vertically.
+    void renderCells(vtbackend::RenderCells const& cells);
 
     void renderLine(vtbackend::RenderLine const& line);
 
     void inspect(std::ostream& output) const override;
 
   private:
+    /// Rectangular area of grid cells that share the same background color.
+    struct BackgroundRun
+    {
+        vtbackend::CellLocation start;
+        int columns = 0;
+        int lines = 1;
+        vtbackend::RGBColor color;
+    };
+
+    /// Merges the given single line run into a run of the line above, or starts a new one.
+    void addRun(BackgroundRun const& run);
+    void flushRuns();
+    void renderRun(BackgroundRun const& run);
+
     // private data
     vtbackend::RGBColor const& _defaultColor;
     uint8_t _opacity = 255;
+
+    // Runs that end on the previous line, which may still be extended down into the current line,
+    // and the runs that end on the current line, both ordered by column.
+    vtbackend::LineOffset _currentLine {};
+    std::vector<BackgroundRun> _previousLineRuns;
+    std::vector<BackgroundRun> _currentLineRuns;
+    size_t _previousLineCursor = 0;
 };
 
 } // namespace vtrasterizer
@@ -9,9 +9,13 @@
 #include <range/v3/view/iota.hpp>
 #include <range/v3/view/zip.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <format>
+#include <future>
+#include <thread>
+#include <vector>
 
 using namespace std::string_view_literals;
 
@@ -901,13 +905,105 @@ namespace detail
     } // namespace
 } // namespace detail
 
+namespace
+{
+    // Codepoints that are rasterized into direct mapped tiles, in order of their direct mapping index.
+    constexpr auto DirectMappedRanges = std::array {
+        pair { char32_t { 0x2500 }, char32_t { 0x259F } }, // box drawing, block elements
+        pair { char32_t { 0x23A1 }, char32_t { 0x23A6 } }, // mathematical square brackets
+        pair { char32_t { 0xE0B0 }, char32_t { 0xE0BE } }, // powerline
+    };
+
+    constexpr uint32_t DirectMappedCodepointCount = []() {
+        auto count = uint32_t { 0 };
+        for (auto const& [first, last]: DirectMappedRanges)
+            count += static_cast<uint32_t>(last - first + 1);
+        return count;
+    }();
+
+    constexpr optional<uint32_t> directMappingIndex(char32_t codepoint) noexcept
+    {
+        auto offset = uint32_t { 0 };
+        for (auto const& [first, last]: DirectMappedRanges)
+        {
+            if (first <= codepoint && codepoint <= last)
+                return offset + static_cast<uint32_t>(codepoint - first);
+            offset += static_cast<uint32_t>(last - first + 1);
+        }
+        return nullopt;
+    }
+
+    constexpr char32_t directMappedCodepoint(uint32_t index) noexcept
+    {
+        for (auto const& [first, last]: DirectMappedRanges)
+        {
+            auto const count = static_cast<uint32_t>(last - first + 1);
+            if (index < count)
+                return first + index;
+            index -= count;
+        }
+        return 0;
+    }
+} // namespace
+
 void BoxDrawingRenderer::setRenderTarget(RenderTarget& renderTarget,
                                          DirectMappingAllocator& directMappingAllocator)
 {
     Renderable::setRenderTarget(renderTarget, directMappingAllocator);
+    _directMapping = directMappingAllocator.allocate(DirectMappedCodepointCount);
     clearCache();
 }
 
+void BoxDrawingRenderer::setTextureAtlases(TextureAtlases atlases)
+{
+    Renderable::setTextureAtlases(atlases);
+    if (_directMapping)
+        initializeDirectMapping();
+}
+
+void BoxDrawingRenderer::initializeDirectMapping()
+{
+    Require(hasTextureAtlases());
+    Require(_directMapping.count == DirectMappedCodepointCount);
+
+    // All tiles are alpha masks.
+    auto& monochromeAtlas = textureAtlas(atlas::Format::Red);
+
+    // Rasterizing is independent per codepoint and only reads the grid metrics,
+    // so the batch is split across threads. Uploading is done on this thread.
+    auto tiles = std::vector<optional<TextureAtlas::TileCreateData>>(DirectMappedCodepointCount);
+    auto const rasterize = [&](uint32_t begin, uint32_t end) {
+        for (auto index = begin; index < end; ++index)
+        {
+            auto const codepoint = directMappedCodepoint(index);
+            if (renderable(codepoint))
+                tiles[index] = createTileData(
+                    codepoint, monochromeAtlas.tileLocation(_directMapping.toTileIndex(index)));
+        }
+    };
+
+    auto const threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+    auto const batchSize = (DirectMappedCodepointCount + threadCount - 1) / threadCount;
+    auto workers = std::vector<std::future<void>> {};
+    for (auto begin = batchSize; begin < DirectMappedCodepointCount; begin += batchSize)
+        workers.emplace_back(std::async(std::launch::async,
+                                        rasterize,
+                                        begin,
+                                        std::min(begin + batchSize, DirectMappedCodepointCount)));
+    rasterize(0, std::min(batchSize, DirectMappedCodepointCount));
+    for (auto& worker: workers)
+        worker.get();
+
+    for (uint32_t index = 0; index < DirectMappedCodepointCount; ++index)
+    {
+        auto const tileIndex = _directMapping.toTileIndex(index);
+        if (tiles[index])
+            monochromeAtlas.setDirectMapping(tileIndex, std::move(*tiles[index]));
+        else
+            monochromeAtlas.clearDirectMapping(tileIndex);
+    }
+}
+
 void BoxDrawingRenderer::clearCache()
 {
     // As we're reusing the upper layer's texture atlas, we do not need
@@ -1006,7 +1102,16 @@ auto BoxDrawingRenderer::createTileData(char32_t codepoint, atlas::TileLocation
 
 Renderable::AtlasTileAttributes const* BoxDrawingRenderer::getOrCreateCachedTileAttributes(char32_t codepoint)
 {
-    return textureAtlas().get_or_try_emplace(
+    if (auto const index = directMappingIndex(codepoint); index && _directMapping)
+    {
+        auto const& attributes =
+            textureAtlas(atlas::Format::Red).directMapped(_directMapping.toTileIndex(*index));
+        if (!attributes.bitmapSize.width.value)
+            return nullptr; // not renderable
+        return &attributes;
+    }
+
+    return textureAtlas(atlas::Format::Red).get_or_try_emplace(
         crispy::strong_hash { 31, 13, 8, static_cast<uint32_t>(codepoint) },
         [this, codepoint](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
             return createTileData(codepoint, tileLocation);
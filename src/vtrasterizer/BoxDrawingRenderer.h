@@ -27,6 +27,7 @@ class BoxDrawingRenderer: public Renderable
     explicit BoxDrawingRenderer(GridMetrics const& gridMetrics): Renderable { gridMetrics } {}
 
     void setRenderTarget(RenderTarget& renderTarget, DirectMappingAllocator& directMappingAllocator) override;
+    void setTextureAtlases(TextureAtlases atlases) override;
     void clearCache() override;
 
     [[nodiscard]] static bool renderable(char32_t codepoint) noexcept;
@@ -42,6 +43,9 @@ class BoxDrawingRenderer: public Renderable
     void inspect(std::ostream& output) const override;
 
   private:
+    /// Rasterizes all precomputed codepoints (see directMappingIndex()) into their direct mapped tiles.
+    void initializeDirectMapping();
+
     AtlasTileAttributes const* getOrCreateCachedTileAttributes(char32_t codepoint);
 
     using Renderable::createTileData;
@@ -52,6 +56,11 @@ class BoxDrawingRenderer: public Renderable
                                                                        ImageSize size,
                                                                        int lineThickness);
     [[nodiscard]] std::optional<atlas::Buffer> buildElements(char32_t codepoint);
+
+    // Box drawing and block elements, as well as the other most commonly used codepoints,
+    // are rasterized in one batch whenever the grid metrics change, if direct mapping is enabled.
+    // All other codepoints are rasterized on demand into the texture atlas' LRU.
+    DirectMapping _directMapping {};
 };
 
 } // namespace vtrasterizer
@@ -52,9 +52,9 @@ void CursorRenderer::setRenderTarget(RenderTarget& renderTarget,
     _directMapping = directMappingAllocator.allocate(DirectMappedTilesCount);
 }
 
-void CursorRenderer::setTextureAtlas(TextureAtlas& atlas)
+void CursorRenderer::setTextureAtlases(TextureAtlases atlases)
 {
-    Renderable::setTextureAtlas(atlas);
+    Renderable::setTextureAtlases(atlases);
     initializeDirectMapping();
 }
 
@@ -69,7 +69,10 @@ void CursorRenderer::clearCache()
 
 void CursorRenderer::initializeDirectMapping()
 {
-    Require(_textureAtlas);
+    Require(hasTextureAtlases());
+
+    // All tiles are alpha masks.
+    auto& monochromeAtlas = textureAtlas(atlas::Format::Red);
 
     for (int width = 1; width <= 2; ++width)
     {
@@ -77,7 +80,7 @@ void CursorRenderer::initializeDirectMapping()
         {
             auto const directMappingIndex = toDirectMappingIndex(shape, width, 0);
             auto const tileIndex = _directMapping.toTileIndex(directMappingIndex);
-            auto const tileLocation = _textureAtlas->tileLocation(tileIndex);
+            auto const tileLocation = monochromeAtlas.tileLocation(tileIndex);
             TextureAtlas::TileCreateData const tileData = createTileData(shape, width, tileLocation);
             uint32_t const offsetX = 0;
             auto const tileWidth = _gridMetrics.cellSize.width;
@@ -85,8 +88,8 @@ void CursorRenderer::initializeDirectMapping()
             {
                 auto const directMappingIndex = toDirectMappingIndex(shape, width, slice.sliceIndex);
                 auto const tileIndex = _directMapping.toTileIndex(directMappingIndex);
-                auto const tileLocation = _textureAtlas->tileLocation(tileIndex);
-                _textureAtlas->setDirectMapping(tileIndex, sliceTileData(tileData, slice, tileLocation));
+                auto const tileLocation = monochromeAtlas.tileLocation(tileIndex);
+                monochromeAtlas.setDirectMapping(tileIndex, sliceTileData(tileData, slice, tileLocation));
             }
         }
     }
@@ -172,7 +175,7 @@ void CursorRenderer::render(crispy::point pos, int columnWidth, vtbackend::RGBCo
         auto const directMappingIndex = toDirectMappingIndex(_shape, columnWidth, i);
         auto const tileIndex = _directMapping.toTileIndex(directMappingIndex);
         auto const x = pos.x + (int(i) * unbox<int>(_gridMetrics.cellSize.width));
-        AtlasTileAttributes const& tileAttributes = _textureAtlas->directMapped(tileIndex);
+        AtlasTileAttributes const& tileAttributes = textureAtlas(atlas::Format::Red).directMapped(tileIndex);
         renderTile({ int(x) }, { pos.y }, color, tileAttributes);
     }
 }
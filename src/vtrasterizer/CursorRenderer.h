@@ -19,7 +19,7 @@ class CursorRenderer: public Renderable
     CursorRenderer(GridMetrics const& gridMetrics, vtbackend::CursorShape shape);
 
     void setRenderTarget(RenderTarget& renderTarget, DirectMappingAllocator& directMappingAllocator) override;
-    void setTextureAtlas(TextureAtlas& atlas) override;
+    void setTextureAtlases(TextureAtlases atlases) override;
 
     void clearCache() override;
 
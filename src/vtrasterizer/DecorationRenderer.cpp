@@ -64,9 +64,9 @@ void DecorationRenderer::setRenderTarget(RenderTarget& renderTarget,
     clearCache();
 }
 
-void DecorationRenderer::setTextureAtlas(TextureAtlas& atlas)
+void DecorationRenderer::setTextureAtlases(TextureAtlases atlases)
 {
-    Renderable::setTextureAtlas(atlas);
+    Renderable::setTextureAtlases(atlases);
     initializeDirectMapping();
 }
 
@@ -76,14 +76,17 @@ void DecorationRenderer::clearCache()
 
 void DecorationRenderer::initializeDirectMapping()
 {
-    Require(_textureAtlas);
+    Require(hasTextureAtlases());
+
+    // All tiles are alpha masks.
+    auto& monochromeAtlas = textureAtlas(atlas::Format::Red);
 
     for (Decorator const decoration: each_element<Decorator>())
     {
         auto const tileIndex = _directMapping.toTileIndex(static_cast<uint32_t>(decoration));
-        auto const tileLocation = _textureAtlas->tileLocation(tileIndex);
+        auto const tileLocation = monochromeAtlas.tileLocation(tileIndex);
         TextureAtlas::TileCreateData tileData = createTileData(decoration, tileLocation);
-        _textureAtlas->setDirectMapping(tileIndex, std::move(tileData));
+        monochromeAtlas.setDirectMapping(tileIndex, std::move(tileData));
     }
 }
 
@@ -101,14 +104,18 @@ void DecorationRenderer::renderLine(vtbackend::RenderLine const& line)
                              line.textAttributes.decorationColor);
 }
 
-void DecorationRenderer::renderCell(vtbackend::RenderCell const& cell)
+void DecorationRenderer::renderCells(vtbackend::RenderCells const& cells)
 {
-    for (auto const& mapping: CellFlagDecorationMappings)
-        if (cell.attributes.flags & mapping.first)
-            renderDecoration(mapping.second,
-                             _gridMetrics.mapBottomLeft(cell.position),
-                             vtbackend::ColumnCount(1),
-                             cell.attributes.decorationColor);
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        auto const& attributes = cells.attributes[i];
+        for (auto const& mapping: CellFlagDecorationMappings)
+            if (attributes.flags & mapping.first)
+                renderDecoration(mapping.second,
+                                 _gridMetrics.mapBottomLeft(cells.positions[i]),
+                                 vtbackend::ColumnCount(1),
+                                 attributes.decorationColor);
+    }
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
@@ -299,9 +306,9 @@ void DecorationRenderer::renderDecoration(Decorator decoration,
     for (auto i = vtbackend::ColumnCount(0); i < columnCount; ++i)
     {
         auto const tileIndex = _directMapping.toTileIndex(static_cast<uint32_t>(decoration));
-        auto const tileLocation = _textureAtlas->tileLocation(tileIndex);
+        auto const tileLocation = textureAtlas(atlas::Format::Red).tileLocation(tileIndex);
         auto const tileData = createTileData(decoration, tileLocation);
-        AtlasTileAttributes const& tileAttributes = _textureAtlas->directMapped(tileIndex);
+        AtlasTileAttributes const& tileAttributes = textureAtlas(atlas::Format::Red).directMapped(tileIndex);
         renderTile({ pos.x + (unbox(i) * unbox<int>(_gridMetrics.cellSize.width)) },
                    { pos.y - unbox<int>(tileAttributes.bitmapSize.height) },
                    color,
@@ -25,7 +25,7 @@ class DecorationRenderer: public Renderable
     DecorationRenderer(GridMetrics const& gridMetrics, Decorator hyperlinkNormal, Decorator hyperlinkHover);
 
     void setRenderTarget(RenderTarget& renderTarget, DirectMappingAllocator& directMappingAllocator) override;
-    void setTextureAtlas(TextureAtlas& atlas) override;
+    void setTextureAtlases(TextureAtlases atlases) override;
     void clearCache() override;
     void inspect(std::ostream& output) const override;
 
@@ -35,7 +35,8 @@ class DecorationRenderer: public Renderable
         _hyperlinkHover = hover;
     }
 
-    void renderCell(vtbackend::RenderCell const& cell);
+    /// Queues up the decorations of the given cells, reading only their positions and attributes.
+    void renderCells(vtbackend::RenderCells const& cells);
     void renderLine(vtbackend::RenderLine const& line);
 
     void renderDecoration(Decorator decoration,
@@ -0,0 +1,411 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/GlyphDiskCache.h>
+#include <vtrasterizer/utils.h>
+
+#include <crispy/FNV.h>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+#include <variant>
+
+namespace fs = std::filesystem;
+
+using crispy::strong_hash;
+
+using std::nullopt;
+using std::optional;
+using std::unique_ptr;
+using std::vector;
+
+namespace vtrasterizer
+{
+
+namespace
+{
+    constexpr auto FileMagic = std::array<char, 4> { 'C', 'G', 'D', 'C' };
+    constexpr uint32_t FileVersion = 2;
+
+    // clang-format off
+    enum RecordKind : uint32_t { ShapeResultRecord = 1, RasterizedGlyphRecord = 2 };
+    // clang-format on
+
+    // File layout (all integers in host byte order):
+    //
+    //   header := magic[4] version:u32 fingerprint:u32[4]
+    //   record := kind:u32 payloadSize:u32 checksum:u32 key:u32[4] payload[payloadSize]
+    constexpr size_t FileHeaderSize = 4 + 4 + 16;
+    constexpr size_t RecordHeaderSize = 4 + 4 + 4 + 16;
+
+    template <typename T>
+    void put(vector<uint8_t>& output, T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto const offset = output.size();
+        output.resize(offset + sizeof(T));
+        std::memcpy(output.data() + offset, &value, sizeof(T));
+    }
+
+    template <typename T>
+    T get(uint8_t const* input, size_t& offset) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto value = T {};
+        std::memcpy(&value, input + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    uint32_t checksumOf(gsl::span<uint8_t const> data) noexcept
+    {
+        return crispy::fnv<uint8_t, uint32_t>()(data.data(), data.data() + data.size());
+    }
+
+    // Shaping result payload: one entry per glyph position.
+    struct PackedGlyphPosition
+    {
+        double size;
+        uint32_t fontSlot;
+        uint32_t glyphIndex;
+        int32_t offsetX;
+        int32_t offsetY;
+        int32_t advanceX;
+        int32_t advanceY;
+        uint32_t presentation;
+        uint32_t reserved;
+    };
+
+    // Rasterized glyph payload: this header, followed by the bitmap.
+    struct PackedBitmapHeader
+    {
+        uint32_t width;
+        uint32_t height;
+        int32_t x;
+        int32_t y;
+        uint32_t format;
+    };
+} // namespace
+
+strong_hash GlyphDiskCache::fingerprint(FontDescriptions const& fontDescriptions,
+                                        gsl::span<text::font_source const> sources)
+{
+    auto identity = std::format("{}:{}:{}|", FileVersion, fontDescriptions, fontDescriptions.renderMode);
+    for (text::font_source const& source: sources)
+    {
+        if (auto const* path = std::get_if<text::font_path>(&source))
+        {
+            auto ec = std::error_code {};
+            auto const fileSize = fs::file_size(path->value, ec);
+            auto const lastWriteTime = fs::last_write_time(path->value, ec);
+            identity += std::format("{}#{}:{}:{}|",
+                                    path->value,
+                                    path->collectionIndex,
+                                    ec ? 0 : fileSize,
+                                    ec ? 0 : lastWriteTime.time_since_epoch().count());
+        }
+        else if (auto const* memory = std::get_if<text::font_memory_ref>(&source))
+            identity += std::format("{}:{}|", memory->identifier, memory->data.size());
+    }
+    return strong_hash::compute(identity);
+}
+
+unique_ptr<GlyphDiskCache> GlyphDiskCache::open(fs::path const& directory,
+                                                strong_hash fingerprint,
+                                                FontSlots fonts)
+{
+    auto ec = std::error_code {};
+    fs::create_directories(directory, ec);
+    if (ec)
+    {
+        errorLog()("Could not create glyph cache directory {}: {}", directory.string(), ec.message());
+        return nullptr;
+    }
+
+    auto const filePath = directory / std::format("glyphs-{}.cache", crispy::to_string(fingerprint));
+    auto cache = std::make_unique<GlyphDiskCache>(filePath, fingerprint, fonts);
+    if (!cache->load())
+        return nullptr;
+
+    rendererLog()("Opened glyph cache {} with {} records.", filePath.string(), cache->loadedRecordCount());
+    return cache;
+}
+
+GlyphDiskCache::GlyphDiskCache(fs::path filePath, strong_hash fingerprint, FontSlots fonts):
+    _filePath { std::move(filePath) }, _fingerprint { fingerprint }, _fonts { fonts }
+{
+}
+
+GlyphDiskCache::~GlyphDiskCache()
+{
+    if (_file)
+        std::fclose(_file);
+
+#if !defined(_WIN32)
+    if (_mappedData && _fallbackData.empty())
+        munmap(const_cast<uint8_t*>(_mappedData), _mappedSize);
+#endif
+}
+
+bool GlyphDiskCache::load()
+{
+    auto ec = std::error_code {};
+    auto fileSize = fs::exists(_filePath, ec) ? static_cast<size_t>(fs::file_size(_filePath, ec)) : 0;
+    if (ec || fileSize > MaxFileSize)
+    {
+        // Start over with a fresh cache file rather than failing forever.
+        fs::remove(_filePath, ec);
+        fileSize = 0;
+    }
+
+    if (fileSize != 0)
+    {
+#if !defined(_WIN32)
+        auto const fd = ::open(_filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+        void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+            return false;
+        _mappedData = static_cast<uint8_t const*>(mapping);
+#else
+        auto input = std::ifstream(_filePath, std::ios::binary);
+        _fallbackData.resize(fileSize);
+        auto* const buffer = reinterpret_cast<char*>(_fallbackData.data());
+        if (!input.read(buffer, static_cast<std::streamsize>(fileSize)))
+            return false;
+        _mappedData = _fallbackData.data();
+#endif
+        _mappedSize = fileSize;
+    }
+
+    // Validate the header, or start over if it does not match.
+    auto validSize = size_t { 0 };
+    if (_mappedSize >= FileHeaderSize && std::memcmp(_mappedData, FileMagic.data(), FileMagic.size()) == 0)
+    {
+        auto offset = FileMagic.size();
+        auto const version = get<uint32_t>(_mappedData, offset);
+        auto const fingerprint = get<strong_hash>(_mappedData, offset);
+        if (version == FileVersion && fingerprint == _fingerprint)
+            validSize = offset;
+    }
+
+    // Index all complete records. Checksums are only verified on lookup,
+    // so that opening the cache does not need to touch every payload.
+    if (validSize != 0)
+    {
+        auto offset = validSize;
+        while (offset + RecordHeaderSize <= _mappedSize)
+        {
+            auto const kind = get<uint32_t>(_mappedData, offset);
+            auto const payloadSize = get<uint32_t>(_mappedData, offset);
+            offset += sizeof(uint32_t); // checksum
+            auto const key = get<strong_hash>(_mappedData, offset);
+            if (offset + payloadSize > _mappedSize)
+                break;
+
+            auto const record =
+                Record { .offset = offset - RecordHeaderSize, .size = RecordHeaderSize + payloadSize };
+            if (kind == ShapeResultRecord)
+                _shapeResults.emplace(key, record);
+            else if (kind == RasterizedGlyphRecord)
+                _rasterizedGlyphs.emplace(key, record);
+
+            offset += payloadSize;
+            validSize = offset;
+        }
+    }
+
+    // Drop anything after the last complete record (such as a torn write) before appending to the file.
+    if (validSize < _mappedSize && _mappedSize != 0)
+        fs::resize_file(_filePath, validSize, ec);
+    if (ec)
+        return false;
+
+    _file = std::fopen(_filePath.string().c_str(), "ab");
+    if (!_file)
+        return false;
+    std::setvbuf(_file, nullptr, _IONBF, 0);
+    _fileSize = validSize;
+
+    if (_fileSize == 0)
+    {
+        auto header = vector<uint8_t> {};
+        header.insert(header.end(), FileMagic.begin(), FileMagic.end());
+        put(header, FileVersion);
+        put(header, _fingerprint);
+        if (std::fwrite(header.data(), 1, header.size(), _file) != header.size())
+            return false;
+        _fileSize = header.size();
+    }
+
+    return true;
+}
+
+void GlyphDiskCache::append(uint32_t kind, strong_hash const& key, vector<uint8_t> const& payload)
+{
+    if (!_file || _fileSize + RecordHeaderSize + payload.size() > MaxFileSize)
+        return;
+
+    auto record = vector<uint8_t> {};
+    record.reserve(RecordHeaderSize + payload.size());
+    put(record, kind);
+    put(record, static_cast<uint32_t>(payload.size()));
+    put(record, checksumOf(payload));
+    put(record, key);
+    record.insert(record.end(), payload.begin(), payload.end());
+
+    // A single unbuffered write per record, so that concurrently appending instances do not interleave.
+    if (std::fwrite(record.data(), 1, record.size(), _file) != record.size())
+    {
+        errorLog()("Failed to write to glyph cache {}. Disabling it.", _filePath.string());
+        std::fclose(_file);
+        _file = nullptr;
+        return;
+    }
+    _fileSize += record.size();
+}
+
+optional<uint32_t> GlyphDiskCache::slotOf(text::font_key font) const noexcept
+{
+    for (uint32_t slot = 0; slot < _fonts.size(); ++slot)
+        if (_fonts[slot] == font)
+            return slot;
+    return nullopt;
+}
+
+optional<strong_hash> GlyphDiskCache::glyphRecordKey(text::glyph_key const& glyph) const
+{
+    auto const slot = slotOf(glyph.font);
+    if (!slot)
+        return nullopt;
+    return strong_hash::compute(glyph.size.pt) * strong_hash(0, 0, *slot, glyph.index.value);
+}
+
+optional<text::shape_result> GlyphDiskCache::shapeResult(strong_hash const& key) const
+{
+    auto const i = _shapeResults.find(key);
+    if (i == _shapeResults.end())
+        return nullopt;
+
+    auto offset = i->second.offset + 4 + 4;
+    auto const checksum = get<uint32_t>(_mappedData, offset);
+    auto const data = recordData(i->second).subspan(RecordHeaderSize);
+    if (checksumOf(data) != checksum || data.size() % sizeof(PackedGlyphPosition) != 0)
+        return nullopt;
+
+    auto result = text::shape_result {};
+    result.reserve(data.size() / sizeof(PackedGlyphPosition));
+    for (size_t pos = 0; pos < data.size();)
+    {
+        auto const packed = get<PackedGlyphPosition>(data.data(), pos);
+        if (packed.fontSlot >= _fonts.size())
+            return nullopt;
+
+        result.emplace_back(text::glyph_position {
+            .glyph = text::glyph_key { .size = text::font_size { packed.size },
+                                       .font = _fonts[packed.fontSlot],
+                                       .index = text::glyph_index { packed.glyphIndex } },
+            .offset = crispy::point { packed.offsetX, packed.offsetY },
+            .advance = crispy::point { packed.advanceX, packed.advanceY },
+            .presentation = static_cast<unicode::PresentationStyle>(packed.presentation),
+        });
+    }
+    return result;
+}
+
+void GlyphDiskCache::storeShapeResult(strong_hash const& key, text::shape_result const& result)
+{
+    if (_shapeResults.contains(key))
+        return;
+
+    auto payload = vector<uint8_t> {};
+    payload.reserve(result.size() * sizeof(PackedGlyphPosition));
+    for (text::glyph_position const& gpos: result)
+    {
+        auto const slot = slotOf(gpos.glyph.font);
+        if (!slot)
+            return;
+
+        put(payload,
+            PackedGlyphPosition {
+                .size = gpos.glyph.size.pt,
+                .fontSlot = *slot,
+                .glyphIndex = gpos.glyph.index.value,
+                .offsetX = gpos.offset.x,
+                .offsetY = gpos.offset.y,
+                .advanceX = gpos.advance.x,
+                .advanceY = gpos.advance.y,
+                .presentation = static_cast<uint32_t>(gpos.presentation),
+                .reserved = 0,
+            });
+    }
+
+    append(ShapeResultRecord, key, payload);
+}
+
+optional<text::rasterized_glyph> GlyphDiskCache::rasterizedGlyph(text::glyph_key const& glyph) const
+{
+    auto const key = glyphRecordKey(glyph);
+    if (!key)
+        return nullopt;
+
+    auto const i = _rasterizedGlyphs.find(*key);
+    if (i == _rasterizedGlyphs.end())
+        return nullopt;
+
+    auto offset = i->second.offset + 4 + 4;
+    auto const checksum = get<uint32_t>(_mappedData, offset);
+    auto const data = recordData(i->second).subspan(RecordHeaderSize);
+    if (checksumOf(data) != checksum || data.size() < sizeof(PackedBitmapHeader))
+        return nullopt;
+
+    auto pos = size_t { 0 };
+    auto const header = get<PackedBitmapHeader>(data.data(), pos);
+    auto result = text::rasterized_glyph {
+        .index = glyph.index,
+        .bitmapSize = vtbackend::ImageSize { vtbackend::Width(header.width),
+                                             vtbackend::Height(header.height) },
+        .position = crispy::point { header.x, header.y },
+        .format = static_cast<text::bitmap_format>(header.format),
+        .bitmap = vector<uint8_t>(data.begin() + static_cast<std::ptrdiff_t>(pos), data.end()),
+    };
+    if (header.format > static_cast<uint32_t>(text::bitmap_format::rgba) || !result.valid())
+        return nullopt;
+
+    return result;
+}
+
+void GlyphDiskCache::storeRasterizedGlyph(text::glyph_key const& glyph, text::rasterized_glyph const& bitmap)
+{
+    auto const key = glyphRecordKey(glyph);
+    if (!key || _rasterizedGlyphs.contains(*key))
+        return;
+
+    auto payload = vector<uint8_t> {};
+    payload.reserve(sizeof(PackedBitmapHeader) + bitmap.bitmap.size());
+    put(payload,
+        PackedBitmapHeader {
+            .width = unbox<uint32_t>(bitmap.bitmapSize.width),
+            .height = unbox<uint32_t>(bitmap.bitmapSize.height),
+            .x = bitmap.position.x,
+            .y = bitmap.position.y,
+            .format = static_cast<uint32_t>(bitmap.format),
+        });
+    payload.insert(payload.end(), bitmap.bitmap.begin(), bitmap.bitmap.end());
+
+    append(RasterizedGlyphRecord, *key, payload);
+}
+
+} // namespace vtrasterizer
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtrasterizer/FontDescriptions.h>
+
+#include <text_shaper/font.h>
+#include <text_shaper/font_locator.h>
+#include <text_shaper/shaper.h>
+
+#include <crispy/StrongHash.h>
+
+#include <gsl/span>
+#include <gsl/span_ext>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace vtrasterizer
+{
+
+/**
+ * Persistent on-disk cache of text shaping results and rasterized glyphs.
+ *
+ * A cache file is only valid for the exact fonts, font size, DPI, and render mode
+ * it was filled with, which is why it is named after a fingerprint of all of these.
+ * As font keys are only valid within a single process, glyphs refer to their font
+ * by its slot, i.e. the index of the font key in the FontSlots passed when opening.
+ * Shaping results that involve any other (e.g. fallback) font are not stored.
+ *
+ * Records that exist at the time the file is opened are served from a read-only
+ * memory mapping of the file. New records are appended to the file, each with
+ * a single write, and become visible the next time the file is opened.
+ */
+class GlyphDiskCache
+{
+  public:
+    /// Fonts that glyphs may refer to, e.g. regular, bold, italic, bold italic, and emoji.
+    using FontSlots = std::array<text::font_key, 5>;
+
+    /// Maximum size of a cache file in bytes. Nothing is appended beyond that.
+    static constexpr inline size_t MaxFileSize = 64 * 1024 * 1024;
+
+    /// Computes the fingerprint identifying the cache file for the given font configuration.
+    ///
+    /// @p sources  the sources of the fonts referred to by the font slots.
+    ///
+    /// Font files are identified by their path, size, and time of last modification.
+    [[nodiscard]] static crispy::strong_hash fingerprint(FontDescriptions const& fontDescriptions,
+                                                         gsl::span<text::font_source const> sources);
+
+    /// Opens (or creates) the cache file for the given fingerprint in @p directory.
+    ///
+    /// @returns the opened cache, or nullptr if the cache file could not be opened.
+    [[nodiscard]] static std::unique_ptr<GlyphDiskCache> open(std::filesystem::path const& directory,
+                                                              crispy::strong_hash fingerprint,
+                                                              FontSlots fonts);
+
+    GlyphDiskCache(std::filesystem::path filePath, crispy::strong_hash fingerprint, FontSlots fonts);
+    GlyphDiskCache(GlyphDiskCache const&) = delete;
+    GlyphDiskCache(GlyphDiskCache&&) = delete;
+    GlyphDiskCache& operator=(GlyphDiskCache const&) = delete;
+    GlyphDiskCache& operator=(GlyphDiskCache&&) = delete;
+    ~GlyphDiskCache();
+
+    [[nodiscard]] crispy::strong_hash fingerprint() const noexcept { return _fingerprint; }
+    [[nodiscard]] std::filesystem::path const& filePath() const noexcept { return _filePath; }
+
+    /// @returns the number of records loaded from disk when the cache was opened.
+    [[nodiscard]] size_t loadedRecordCount() const noexcept
+    {
+        return _shapeResults.size() + _rasterizedGlyphs.size();
+    }
+
+    /// Looks up the shaping result stored for the given text and style hash.
+    [[nodiscard]] std::optional<text::shape_result> shapeResult(crispy::strong_hash const& key) const;
+
+    /// Stores the given shaping result, unless it refers to a font that is not in any font slot.
+    void storeShapeResult(crispy::strong_hash const& key, text::shape_result const& result);
+
+    /// Looks up the rasterized bitmap stored for the given glyph.
+    [[nodiscard]] std::optional<text::rasterized_glyph> rasterizedGlyph(text::glyph_key const& glyph) const;
+
+    /// Stores the given rasterized bitmap, unless the glyph's font is not in any font slot.
+    void storeRasterizedGlyph(text::glyph_key const& glyph, text::rasterized_glyph const& bitmap);
+
+  private:
+    struct Record
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    using RecordIndex = std::unordered_map<crispy::strong_hash, Record>;
+
+    [[nodiscard]] bool load();
+    void append(uint32_t kind, crispy::strong_hash const& key, std::vector<uint8_t> const& payload);
+
+    [[nodiscard]] std::optional<uint32_t> slotOf(text::font_key font) const noexcept;
+    [[nodiscard]] std::optional<crispy::strong_hash> glyphRecordKey(text::glyph_key const& glyph) const;
+    [[nodiscard]] gsl::span<uint8_t const> recordData(Record const& record) const noexcept
+    {
+        return { _mappedData + record.offset, record.size };
+    }
+
+    std::filesystem::path _filePath;
+    crispy::strong_hash _fingerprint;
+    FontSlots _fonts;
+
+    // The file contents as of opening the cache.
+    uint8_t const* _mappedData = nullptr;
+    size_t _mappedSize = 0;
+    std::vector<uint8_t> _fallbackData; // used where memory mapping is not available
+
+    RecordIndex _shapeResults;
+    RecordIndex _rasterizedGlyphs;
+
+    std::FILE* _file = nullptr;
+    size_t _fileSize = 0;
+};
+
+} // namespace vtrasterizer
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/GlyphDiskCache.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+
+using namespace vtrasterizer;
+
+using crispy::strong_hash;
+
+namespace
+{
+
+struct TemporaryDirectory
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path()
+                                 / std::format("contour-glyph-cache-test-{}",
+                                               std::chrono::steady_clock::now().time_since_epoch().count());
+
+    TemporaryDirectory() = default;
+    TemporaryDirectory(TemporaryDirectory const&) = delete;
+    TemporaryDirectory(TemporaryDirectory&&) = delete;
+    TemporaryDirectory& operator=(TemporaryDirectory const&) = delete;
+    TemporaryDirectory& operator=(TemporaryDirectory&&) = delete;
+
+    ~TemporaryDirectory()
+    {
+        auto ec = std::error_code {};
+        std::filesystem::remove_all(path, ec);
+    }
+};
+
+GlyphDiskCache::FontSlots makeFonts(unsigned first)
+{
+    return GlyphDiskCache::FontSlots {
+        text::font_key { first },     text::font_key { first + 1 }, text::font_key { first + 2 },
+        text::font_key { first + 3 }, text::font_key { first + 4 },
+    };
+}
+
+auto const Fonts = makeFonts(1);
+
+auto const Fingerprint = strong_hash { 1, 2, 3, 4 };
+
+text::glyph_key glyphKey(unsigned font, unsigned index)
+{
+    return text::glyph_key { .size = text::font_size { 12.0 },
+                             .font = text::font_key { font },
+                             .index = text::glyph_index { index } };
+}
+
+text::rasterized_glyph makeGlyph(unsigned index)
+{
+    return text::rasterized_glyph {
+        .index = text::glyph_index { index },
+        .bitmapSize = vtbackend::ImageSize { vtbackend::Width(2), vtbackend::Height(3) },
+        .position = crispy::point { 1, -2 },
+        .format = text::bitmap_format::alpha_mask,
+        .bitmap = { 1, 2, 3, 4, 5, 6 },
+    };
+}
+
+} // namespace
+
+TEST_CASE("GlyphDiskCache.reopen")
+{
+    auto const directory = TemporaryDirectory {};
+    auto const textKey = strong_hash::compute(std::u32string_view(U"Hello"));
+    auto const shapeResult = text::shape_result {
+        text::glyph_position { .glyph = glyphKey(1, 42), .offset = { 0, 1 }, .advance = { 8, 0 } },
+        text::glyph_position { .glyph = glyphKey(2, 43), .offset = { 2, 3 }, .advance = { 8, 0 } },
+    };
+
+    {
+        auto cache = GlyphDiskCache::open(directory.path, Fingerprint, Fonts);
+        REQUIRE(cache);
+        CHECK(cache->loadedRecordCount() == 0);
+        cache->storeShapeResult(textKey, shapeResult);
+        cache->storeRasterizedGlyph(glyphKey(1, 42), makeGlyph(42));
+
+        // New records only become visible when reopening the cache.
+        CHECK_FALSE(cache->shapeResult(textKey).has_value());
+    }
+
+    // Font keys differ between processes, but their slots remain the same.
+    auto cache = GlyphDiskCache::open(directory.path, Fingerprint, makeFonts(7));
+    REQUIRE(cache);
+    CHECK(cache->loadedRecordCount() == 2);
+
+    auto const loadedShapeResult = cache->shapeResult(textKey);
+    REQUIRE(loadedShapeResult.has_value());
+    REQUIRE(loadedShapeResult->size() == 2);
+    CHECK(loadedShapeResult->at(0).glyph.font.value == 7);
+    CHECK(loadedShapeResult->at(0).glyph.index.value == 42);
+    CHECK(loadedShapeResult->at(0).offset.y == 1);
+    CHECK(loadedShapeResult->at(1).glyph.font.value == 8);
+    CHECK(loadedShapeResult->at(1).offset.x == 2);
+    CHECK(loadedShapeResult->at(1).advance.x == 8);
+
+    auto const loadedGlyph = cache->rasterizedGlyph(glyphKey(7, 42));
+    REQUIRE(loadedGlyph.has_value());
+    CHECK(loadedGlyph->bitmapSize == makeGlyph(42).bitmapSize);
+    CHECK(loadedGlyph->position.y == -2);
+    CHECK(loadedGlyph->bitmap == makeGlyph(42).bitmap);
+
+    CHECK_FALSE(cache->rasterizedGlyph(glyphKey(8, 42)).has_value());
+}
+
+TEST_CASE("GlyphDiskCache.skip_unknown_fonts")
+{
+    auto const directory = TemporaryDirectory {};
+    auto const textKey = strong_hash::compute(std::u32string_view(U"fallback"));
+
+    {
+        auto cache = GlyphDiskCache::open(directory.path, Fingerprint, Fonts);
+        REQUIRE(cache);
+        // Font key 99 stands for a fallback font, which has no slot.
+        cache->storeShapeResult(textKey,
+                                text::shape_result { text::glyph_position { .glyph = glyphKey(99, 1) } });
+        cache->storeRasterizedGlyph(glyphKey(99, 1), makeGlyph(1));
+    }
+
+    auto cache = GlyphDiskCache::open(directory.path, Fingerprint, Fonts);
+    REQUIRE(cache);
+    CHECK(cache->loadedRecordCount() == 0);
+}
+
+TEST_CASE("GlyphDiskCache.truncated_file")
+{
+    auto const directory = TemporaryDirectory {};
+    auto filePath = std::filesystem::path {};
+
+    {
+        auto cache = GlyphDiskCache::open(directory.path, Fingerprint, Fonts);
+        REQUIRE(cache);
+        cache->storeRasterizedGlyph(glyphKey(1, 1), makeGlyph(1));
+        cache->storeRasterizedGlyph(glyphKey(1, 2), makeGlyph(2));
+        filePath = cache->filePath();
+    }
+
+    // Simulate a torn write of the last record.
+    std::filesystem::resize_file(filePath, std::filesystem::file_size(filePath) - 3);
+
+    {
+        auto cache = GlyphDiskCache::open(directory.path, Fingerprint, Fonts);
+        REQUIRE(cache);
+        CHECK(cache->loadedRecordCount() == 1);
+        CHECK(cache->rasterizedGlyph(glyphKey(1, 1)).has_value());
+        CHECK_FALSE(cache->rasterizedGlyph(glyphKey(1, 2)).has_value());
+        cache->storeRasterizedGlyph(glyphKey(1, 2), makeGlyph(2));
+    }
+
+    auto cache = GlyphDiskCache::open(directory.path, Fingerprint, Fonts);
+    REQUIRE(cache);
+    CHECK(cache->loadedRecordCount() == 2);
+    CHECK(cache->rasterizedGlyph(glyphKey(1, 2)).has_value());
+}
@@ -34,19 +34,41 @@ void ImageRenderer::setCellSize(ImageSize cellSize)
     // TODO: recompute rasterized images slices here?
 }
 
-void ImageRenderer::renderImage(crispy::point pos, vtbackend::ImageFragment const& fragment)
+void ImageRenderer::renderImage(crispy::point pos,
+                                vtbackend::RasterizedImage const& image,
+                                vtbackend::CellLocation offset,
+                                vtbackend::ColumnCount columns)
 {
-    // std::cout << std::format("ImageRenderer.renderImage: {}\n", fragment);
-
-    AtlasTileAttributes const* tileAttributes = getOrCreateCachedTileAttributes(fragment);
-    if (!tileAttributes)
+    // Nothing is drawn for images still being decoded, which must not get a tile cached either.
+    if (!image.image().decoded())
         return;
 
-    // clang-format off
-    _pendingRenderTilesAboveText.emplace_back(createRenderTile(atlas::RenderTile::X { pos.x },
-                                                               atlas::RenderTile::Y { pos.y },
-                                                               vtbackend::RGBAColor::White, *tileAttributes));
-    // clang-format on
+    auto const cellWidth = unbox<int>(_gridMetrics.cellSize.width);
+    for (auto column = 0; column < unbox<int>(columns);)
+    {
+        auto const sizeClass = tileSizeClassFor(unbox<int>(columns) - column);
+        auto const tileOffset = vtbackend::CellLocation {
+            .line = offset.line, .column = offset.column + vtbackend::ColumnOffset(column)
+        };
+
+        if (auto const* tileAttributes = getOrCreateCachedTileAttributes(image, tileOffset, sizeClass))
+            _pendingRenderTilesAboveText.emplace_back(
+                createRenderTile(atlas::RenderTile::X { pos.x + (column * cellWidth) },
+                                 atlas::RenderTile::Y { pos.y },
+                                 vtbackend::RGBAColor::White,
+                                 *tileAttributes));
+
+        column += static_cast<int>(atlas::widthFactor(sizeClass));
+    }
+}
+
+atlas::TileSizeClass ImageRenderer::tileSizeClassFor(int columns)
+{
+    for (auto const sizeClass: { atlas::TileSizeClass::ExtraWide, atlas::TileSizeClass::Wide })
+        if (columns >= static_cast<int>(atlas::widthFactor(sizeClass)) && imageAtlas().capacity(sizeClass))
+            return sizeClass;
+
+    return atlas::TileSizeClass::Narrow;
 }
 
 void ImageRenderer::onBeforeRenderingText()
@@ -82,29 +104,29 @@ void ImageRenderer::endFrame()
 }
 
 Renderable::AtlasTileAttributes const* ImageRenderer::getOrCreateCachedTileAttributes(
-    vtbackend::ImageFragment const& fragment)
+    vtbackend::RasterizedImage const& image, vtbackend::CellLocation offset, atlas::TileSizeClass sizeClass)
 {
-    // using crispy::StrongHash;
-    // auto const hash = StrongHash::compute(fragment.rasterizedImage().image().id().value)
-    //                   * fragment.offset().column.value * fragment.offset().line.value
-    //                   * fragment.rasterizedImage().cellSize().width.value
-    //                   * fragment.rasterizedImage().cellSize().height.value;
-    auto const key = ImageFragmentKey { .imageId = fragment.rasterizedImage().image().id(),
-                                        .offset = fragment.offset(),
-                                        .size = fragment.rasterizedImage().cellSize() };
+    // Each tile size class has a cache of its own, so the key need not tell the number of cells.
+    auto const key =
+        ImageFragmentKey { .imageId = image.image().id(), .offset = offset, .size = image.cellSize() };
     auto const hash = crispy::strong_hash::compute(key);
-
-    return textureAtlas().get_or_try_emplace(
-        hash, [&](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
-            return createTileData(tileLocation,
-                                  fragment.data(),
-                                  atlas::Format::RGBA,
-                                  fragment.rasterizedImage().cellSize(),
-                                  _cellSize,
-                                  RenderTileAttributes::X { 0 },
-                                  RenderTileAttributes::Y { 0 },
-                                  FRAGMENT_SELECTOR_IMAGE_BGRA);
-        });
+    auto const columns = atlas::widthFactor(sizeClass);
+    auto const widthFactor = vtbackend::Width::cast_from(columns);
+
+    return imageAtlas().get_or_try_emplace(
+        hash,
+        [&](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
+            return createTileData(
+                tileLocation,
+                image.fragment(offset, vtbackend::ColumnCount::cast_from(columns)),
+                atlas::Format::RGBA,
+                ImageSize { image.cellSize().width * widthFactor, image.cellSize().height },
+                ImageSize { _cellSize.width * widthFactor, _cellSize.height },
+                RenderTileAttributes::X { 0 },
+                RenderTileAttributes::Y { 0 },
+                FRAGMENT_SELECTOR_IMAGE_TILE);
+        },
+        sizeClass);
 }
 
 void ImageRenderer::discardImage(vtbackend::ImageId /*imageId*/)
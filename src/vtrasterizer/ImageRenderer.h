@@ -49,7 +49,15 @@ class ImageRenderer: public Renderable, public TextRendererEvents
     /// Reconfigures the slicing properties of existing images.
     void setCellSize(ImageSize cellSize);
 
-    void renderImage(crispy::point pos, vtbackend::ImageFragment const& fragment);
+    /// Renders the fragments of the given rasterized @p image for the @p columns grid cells
+    /// starting at grid offset @p offset into the image, with the first one at @p pos.
+    ///
+    /// Runs of fragments are drawn as few tiles as the image atlas' tile size classes allow,
+    /// i.e. one tile per up to four cells.
+    void renderImage(crispy::point pos,
+                     vtbackend::RasterizedImage const& image,
+                     vtbackend::CellLocation offset,
+                     vtbackend::ColumnCount columns);
 
     /// notify underlying cache that this fragment is not going to be rendered anymore, maybe freeing up some
     /// GPU caches.
@@ -64,7 +72,11 @@ class ImageRenderer: public Renderable, public TextRendererEvents
     void onAfterRenderingText() override;
 
   private:
-    AtlasTileAttributes const* getOrCreateCachedTileAttributes(vtbackend::ImageFragment const& fragment);
+    [[nodiscard]] atlas::TileSizeClass tileSizeClassFor(int columns);
+
+    AtlasTileAttributes const* getOrCreateCachedTileAttributes(vtbackend::RasterizedImage const& image,
+                                                               vtbackend::CellLocation offset,
+                                                               atlas::TileSizeClass sizeClass);
     std::vector<atlas::RenderTile> _pendingRenderTilesAboveText;
 
     // private data
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/PerformanceHud.h>
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <utility>
+
+using namespace std::chrono;
+
+namespace vtrasterizer
+{
+
+namespace
+{
+    std::string formatDuration(nanoseconds value)
+    {
+        return std::format("{:.2f}ms", static_cast<double>(value.count()) / 1'000'000.0);
+    }
+
+    /// @returns the given percentile of the @p count most recent values of a ring buffer.
+    template <size_t N>
+    nanoseconds percentileOf(std::array<nanoseconds, N> const& history, size_t count, double percentile)
+    {
+        count = std::min(count, N);
+        if (!count)
+            return nanoseconds(0);
+
+        auto values = std::vector<nanoseconds>(history.begin(), std::next(history.begin(), count));
+        auto const rank =
+            std::lround(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count - 1));
+        auto const nth = std::next(values.begin(), rank);
+        std::ranges::nth_element(values, nth);
+        return *nth;
+    }
+
+    double mebibytes(size_t bytes)
+    {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+} // namespace
+
+void PerformanceHud::recordFrame(nanoseconds frameTime) noexcept
+{
+    _frameTimes[_frameCount % FrameHistorySize] = frameTime;
+    ++_frameCount;
+}
+
+nanoseconds PerformanceHud::frameTimePercentile(double percentile) const
+{
+    return percentileOf(_frameTimes, _frameCount, percentile);
+}
+
+void PerformanceHud::recordInputLatency(nanoseconds latency) noexcept
+{
+    _inputLatencies[_inputCount % InputLatencyHistorySize] = latency;
+    ++_inputCount;
+}
+
+nanoseconds PerformanceHud::inputLatencyPercentile(double percentile) const
+{
+    return percentileOf(_inputLatencies, _inputCount, percentile);
+}
+
+void PerformanceHud::update(Sample const& sample, steady_clock::time_point now)
+{
+    // The parse rate is only known from the second sample on.
+    auto const elapsed = duration<double>(now - _lastSampleTime).count();
+    auto const parseRate = !_lines.empty() && elapsed > 0.0
+                               ? static_cast<double>(sample.parsedBytes - _lastParsedBytes) / elapsed / 1e6
+                               : 0.0;
+    _lastSampleTime = now;
+    _lastParsedBytes = sample.parsedBytes;
+
+    auto const frames = _frameCount - std::exchange(_lastFrameCount, _frameCount);
+
+    auto const lookups = sample.glyphCache.hits + sample.glyphCache.misses;
+    auto const hitRate =
+        lookups ? 100.0 * static_cast<double>(sample.glyphCache.hits) / static_cast<double>(lookups) : 100.0;
+    auto const occupancy =
+        sample.atlasTileCapacity ? 100 * sample.atlasTileCount / sample.atlasTileCapacity : size_t { 0 };
+
+    _lines.clear();
+    _lines.emplace_back(std::format("frame  p50 {}  p90 {}  p99 {}",
+                                    formatDuration(frameTimePercentile(50)),
+                                    formatDuration(frameTimePercentile(90)),
+                                    formatDuration(frameTimePercentile(99))));
+    if (_inputCount)
+        _lines.emplace_back(std::format("input  p50 {}  p90 {}  p99 {}",
+                                        formatDuration(inputLatencyPercentile(50)),
+                                        formatDuration(inputLatencyPercentile(90)),
+                                        formatDuration(inputLatencyPercentile(99))));
+    else
+        _lines.emplace_back("input  no key input answered yet");
+    _lines.emplace_back(
+        std::format("parse  {:.1f} MB/s  fill {}", parseRate, formatDuration(sample.renderBufferFillTime)));
+    _lines.emplace_back(std::format("atlas  {}/{} tiles ({}%), {} evictions",
+                                    sample.atlasTileCount,
+                                    sample.atlasTileCapacity,
+                                    occupancy,
+                                    sample.glyphCache.recycles));
+    _lines.emplace_back(std::format("glyphs {:.1f}% hit rate ({} lookups)", hitRate, lookups));
+    _lines.emplace_back(std::format("pty    {} bytes pending", sample.pendingPtyBytes));
+
+    auto const& memory = sample.memoryUsage;
+    _lines.emplace_back(std::format(
+        "memory {:.1f} MiB  gpu {:.1f} MiB", mebibytes(memory.total()), mebibytes(sample.gpuMemoryUsage)));
+    _lines.emplace_back(std::format("  lines {:.1f} trivial, {:.1f} inflated, {:.1f} extras",
+                                    mebibytes(memory.trivialLines),
+                                    mebibytes(memory.inflatedLines),
+                                    mebibytes(memory.cellExtras)));
+    _lines.emplace_back(std::format("  images {:.1f}  render {:.1f}  pty {:.1f}  other {:.1f}",
+                                    mebibytes(memory.images),
+                                    mebibytes(memory.renderBuffers),
+                                    mebibytes(memory.ptyBuffers),
+                                    mebibytes(memory.hyperlinks + memory.parser)));
+
+    // Allocations are shown per frame rendered since the previous sample, and only so from the second
+    // sample of a subsystem on.
+    if (!sample.allocations.empty())
+    {
+        auto line = std::string("allocs/frame");
+        for (size_t i = 0; i < sample.allocations.size(); ++i)
+        {
+            auto const& [name, counts] = sample.allocations[i];
+            auto const previous = i < _lastAllocations.size() ? _lastAllocations[i] : counts;
+            line += std::format("  {} {}", name, frames ? (counts.count - previous.count) / frames : 0);
+        }
+        _lines.emplace_back(std::move(line));
+    }
+    _lastAllocations.clear();
+    for (auto const& subsystem: sample.allocations)
+        _lastAllocations.push_back(subsystem.counts);
+}
+
+vtbackend::ColumnCount PerformanceHud::width() const noexcept
+{
+    auto result = size_t { 0 };
+    for (auto const& line: _lines)
+        result = std::max(result, line.size());
+
+    // One column of padding on either side.
+    return vtbackend::ColumnCount::cast_from(result + 2);
+}
+
+vtbackend::ColumnOffset PerformanceHud::leftColumn(vtbackend::ColumnCount pageColumns) const noexcept
+{
+    return vtbackend::ColumnOffset::cast_from(std::max(0, unbox<int>(pageColumns) - unbox<int>(width())));
+}
+
+void PerformanceHud::render(vtbackend::RenderCells& output,
+                            vtbackend::ColumnCount pageColumns,
+                            vtbackend::RenderAttributes const& attributes) const
+{
+    auto const left = leftColumn(pageColumns);
+    auto const columns = std::min(width(), pageColumns - boxed_cast<vtbackend::ColumnCount>(left));
+    if (columns <= vtbackend::ColumnCount(0))
+        return;
+
+    for (size_t row = 0; row < _lines.size(); ++row)
+    {
+        auto const& text = _lines[row];
+        auto const rowStart = output.size();
+        for (auto column = 0; column < unbox<int>(columns); ++column)
+        {
+            auto const position = vtbackend::CellLocation {
+                .line = vtbackend::LineOffset::cast_from(row),
+                .column = left + vtbackend::ColumnOffset(column),
+            };
+            auto const index = static_cast<size_t>(column - 1);
+            output.append(position, attributes, 1);
+            if (column >= 1 && index < text.size() && text[index] != ' ')
+                output.appendCodepoint(static_cast<char32_t>(text[index]));
+        }
+
+        // The overlay is appended behind the terminal's cells, which it must not be grouped with.
+        output.markGroupStart(rowStart);
+        output.markGroupEnd(output.size() - 1);
+    }
+}
+
+} // namespace vtrasterizer
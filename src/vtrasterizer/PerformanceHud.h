@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/MemoryUsage.h>
+#include <vtbackend/RenderBuffer.h>
+#include <vtbackend/primitives.h>
+
+#include <crispy/StrongLRUHashtable.h>
+#include <crispy/allocations.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vtrasterizer
+{
+
+/**
+ * On-screen overlay of runtime performance statistics, shown in the top right corner of the page.
+ *
+ * Frame times are recorded for every frame, whereas all other statistics are sampled at most
+ * once per SampleInterval, because some of them are costly to gather, and because numbers
+ * changing with every frame would not be readable anyway.
+ *
+ * The overlay consists of plain render cells, so that it is drawn by the very same background
+ * and text renderers as the terminal's contents, and shows up in screenshots, too.
+ */
+class PerformanceHud
+{
+  public:
+    /// Number of most recent frames the frame time percentiles are computed from.
+    static constexpr inline size_t FrameHistorySize = 240;
+
+    /// Number of most recent key inputs the input latency percentiles are computed from.
+    static constexpr inline size_t InputLatencyHistorySize = 64;
+
+    /// Minimum time between two samples of the statistics other than frame times.
+    static constexpr inline std::chrono::milliseconds SampleInterval { 500 };
+
+    /// Allocations made by one subsystem so far.
+    struct SubsystemAllocations
+    {
+        char const* name;
+        crispy::allocations::counts counts;
+    };
+
+    /// Statistics gathered from the terminal and the renderer.
+    struct Sample
+    {
+        uint64_t parsedBytes = 0; ///< Total number of bytes parsed by the terminal so far.
+        std::chrono::nanoseconds renderBufferFillTime {};
+        size_t atlasTileCount = 0;
+        size_t atlasTileCapacity = 0;
+        crispy::lru_hashtable_stats glyphCache {}; ///< Since the previous sample. Recycles are evictions.
+        size_t pendingPtyBytes = 0;                ///< Input not written to the PTY yet.
+        vtbackend::MemoryUsage memoryUsage {};     ///< Approximate memory taken by the terminal.
+        size_t gpuMemoryUsage = 0;                 ///< Texture memory allocated by the renderer, in bytes.
+        std::vector<SubsystemAllocations> allocations {}; ///< Empty unless allocations are accounted.
+    };
+
+    void recordFrame(std::chrono::nanoseconds frameTime) noexcept;
+
+    /// @returns the given percentile (between 0 and 100) of the recorded frame times.
+    [[nodiscard]] std::chrono::nanoseconds frameTimePercentile(double percentile) const;
+
+    /// Records the time from key input until the first frame showing its answer has been presented.
+    void recordInputLatency(std::chrono::nanoseconds latency) noexcept;
+
+    /// @returns the given percentile (between 0 and 100) of the recorded input latencies.
+    [[nodiscard]] std::chrono::nanoseconds inputLatencyPercentile(double percentile) const;
+
+    /// @returns whether the statistics should be sampled again.
+    [[nodiscard]] bool sampleDue(std::chrono::steady_clock::time_point now) const noexcept
+    {
+        return _lines.empty() || now - _lastSampleTime >= SampleInterval;
+    }
+
+    /// Updates the text shown from the given statistics, which have been sampled at @p now.
+    void update(Sample const& sample, std::chrono::steady_clock::time_point now);
+
+    /// @returns the text lines shown, consisting of ASCII characters only.
+    [[nodiscard]] std::vector<std::string> const& lines() const noexcept { return _lines; }
+
+    /// @returns the number of columns the overlay takes, including its padding.
+    [[nodiscard]] vtbackend::ColumnCount width() const noexcept;
+
+    [[nodiscard]] vtbackend::LineCount height() const noexcept
+    {
+        return vtbackend::LineCount::cast_from(_lines.size());
+    }
+
+    /// @returns the leftmost column the overlay covers on a page of the given width.
+    [[nodiscard]] vtbackend::ColumnOffset leftColumn(vtbackend::ColumnCount pageColumns) const noexcept;
+
+    /// Appends the cells of the overlay, placed at the top right of a page of the given width.
+    void render(vtbackend::RenderCells& output,
+                vtbackend::ColumnCount pageColumns,
+                vtbackend::RenderAttributes const& attributes) const;
+
+  private:
+    std::array<std::chrono::nanoseconds, FrameHistorySize> _frameTimes {};
+    size_t _frameCount = 0; // total number of frames recorded
+    std::array<std::chrono::nanoseconds, InputLatencyHistorySize> _inputLatencies {};
+    size_t _inputCount = 0; // total number of input latencies recorded
+
+    std::chrono::steady_clock::time_point _lastSampleTime {};
+    uint64_t _lastParsedBytes = 0;
+    size_t _lastFrameCount = 0;
+    std::vector<crispy::allocations::counts> _lastAllocations;
+    std::vector<std::string> _lines;
+};
+
+} // namespace vtrasterizer
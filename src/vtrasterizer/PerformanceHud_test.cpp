@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/PerformanceHud.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <string>
+
+using namespace vtbackend;
+using namespace vtrasterizer;
+using namespace std::chrono_literals;
+
+TEST_CASE("PerformanceHud.frameTimePercentile")
+{
+    auto hud = PerformanceHud {};
+    CHECK(hud.frameTimePercentile(50) == 0ns);
+
+    for (auto i = 1; i <= 100; ++i)
+        hud.recordFrame(std::chrono::milliseconds(i));
+    CHECK(hud.frameTimePercentile(0) == 1ms);
+    CHECK(hud.frameTimePercentile(50) == 51ms);
+    CHECK(hud.frameTimePercentile(100) == 100ms);
+
+    // Only the most recent frames are taken into account.
+    for (size_t i = 0; i < PerformanceHud::FrameHistorySize; ++i)
+        hud.recordFrame(2ms);
+    CHECK(hud.frameTimePercentile(100) == 2ms);
+}
+
+TEST_CASE("PerformanceHud.inputLatencyPercentile")
+{
+    auto hud = PerformanceHud {};
+    CHECK(hud.inputLatencyPercentile(50) == 0ns);
+
+    for (auto i = 1; i <= 9; ++i)
+        hud.recordInputLatency(std::chrono::milliseconds(i));
+    CHECK(hud.inputLatencyPercentile(0) == 1ms);
+    CHECK(hud.inputLatencyPercentile(50) == 5ms);
+    CHECK(hud.inputLatencyPercentile(100) == 9ms);
+
+    hud.update(PerformanceHud::Sample {}, std::chrono::steady_clock::now());
+    CHECK(hud.lines()[1] == "input  p50 5.00ms  p90 8.00ms  p99 9.00ms");
+}
+
+TEST_CASE("PerformanceHud.update")
+{
+    auto const start = std::chrono::steady_clock::time_point {} + 1h;
+    auto hud = PerformanceHud {};
+    CHECK(hud.sampleDue(start));
+
+    hud.update(PerformanceHud::Sample { .parsedBytes = 1'000'000 }, start);
+    CHECK(hud.lines()[1] == "input  no key input answered yet");
+    CHECK(hud.lines()[2].starts_with("parse  0.0 MB/s"));
+    CHECK_FALSE(hud.sampleDue(start + PerformanceHud::SampleInterval / 2));
+    REQUIRE(hud.sampleDue(start + PerformanceHud::SampleInterval));
+
+    hud.update(PerformanceHud::Sample {
+                   .parsedBytes = 2'000'000,
+                   .atlasTileCount = 25,
+                   .atlasTileCapacity = 100,
+                   .glyphCache = { .hits = 3, .misses = 1, .recycles = 2 },
+                   .pendingPtyBytes = 42,
+                   .memoryUsage = { .trivialLines = 2 * 1024 * 1024, .images = 1024 * 1024 },
+                   .gpuMemoryUsage = 16 * 1024 * 1024,
+               },
+               start + 1s);
+    CHECK(hud.lines()[2].starts_with("parse  1.0 MB/s"));
+    CHECK(hud.lines()[3] == "atlas  25/100 tiles (25%), 2 evictions");
+    CHECK(hud.lines()[4] == "glyphs 75.0% hit rate (4 lookups)");
+    CHECK(hud.lines()[5] == "pty    42 bytes pending");
+    CHECK(hud.lines()[6] == "memory 3.0 MiB  gpu 16.0 MiB");
+    CHECK(hud.lines()[7] == "  lines 2.0 trivial, 0.0 inflated, 0.0 extras");
+    CHECK(hud.lines()[8] == "  images 1.0  render 0.0  pty 0.0  other 0.0");
+    CHECK(hud.lines().size() == 9);
+}
+
+TEST_CASE("PerformanceHud.allocations")
+{
+    auto const start = std::chrono::steady_clock::time_point {} + 1h;
+    auto hud = PerformanceHud {};
+    auto const sample = [](uint64_t parser, uint64_t screen) {
+        return PerformanceHud::Sample { .allocations = {
+                                            { .name = "parser", .counts = { .count = parser } },
+                                            { .name = "screen", .counts = { .count = screen } },
+                                        } };
+    };
+
+    hud.update(sample(100, 1000), start);
+    CHECK(hud.lines().back() == "allocs/frame  parser 0  screen 0");
+
+    for (auto i = 0; i < 10; ++i)
+        hud.recordFrame(1ms);
+    hud.update(sample(150, 1300), start + 1s);
+    CHECK(hud.lines().back() == "allocs/frame  parser 5  screen 30");
+}
+
+TEST_CASE("PerformanceHud.render")
+{
+    auto hud = PerformanceHud {};
+    hud.update(PerformanceHud::Sample {}, std::chrono::steady_clock::now());
+    auto const width = hud.width();
+    REQUIRE(hud.height() == LineCount::cast_from(hud.lines().size()));
+
+    auto cells = RenderCells {};
+    hud.render(cells, width + ColumnCount(10), RenderAttributes {});
+    REQUIRE(cells.size() == unbox<size_t>(width) * hud.lines().size());
+
+    // Right aligned, with one column of padding.
+    CHECK(hud.leftColumn(width + ColumnCount(10)) == ColumnOffset(10));
+    CHECK(cells.positions.front() == CellLocation { .line = LineOffset(0), .column = ColumnOffset(10) });
+    CHECK(cells.codepoints(0).empty());
+    CHECK(cells.codepoints(1) == U"f");
+    CHECK(cells.isGroupStart(0));
+    CHECK(cells.isGroupEnd(unbox<size_t>(width) - 1));
+
+    // Clipped to pages narrower than the HUD.
+    cells.clear();
+    hud.render(cells, ColumnCount(4), RenderAttributes {});
+    CHECK(cells.size() == 4 * hud.lines().size());
+    CHECK(hud.leftColumn(ColumnCount(4)) == ColumnOffset(0));
+}
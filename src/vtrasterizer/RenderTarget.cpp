@@ -28,10 +28,11 @@ auto Renderable::createTileData(atlas::TileLocation tileLocation,
 {
     // clang-format off
     auto tileData = TextureAtlas::TileCreateData {};
-    auto const atlasSize = _textureScheduler->atlasSize();
+    auto const atlasSize = _textureAtlases[atlasIndexOf(fragmentShaderSelector)]->atlasSize();
     Require(!!atlasSize.width);
     Require(!!atlasSize.height);
     Require(bitmap.size() == bitmapSize.area() * atlas::element_count(bitmapFormat));
+    Require(atlasFormatOf(fragmentShaderSelector) == bitmapFormat);
     tileData.bitmap = std::move(bitmap);
     tileData.bitmapSize = bitmapSize;
     tileData.bitmapFormat = bitmapFormat;
@@ -11,6 +11,7 @@
 
 #include <crispy/size.h>
 
+#include <array>
 #include <optional>
 #include <vector>
 
@@ -70,6 +71,7 @@ struct RenderTileAttributes
     // or a simple RGBA texture.
     // See:
     // - FRAGMENT_SELECTOR_IMAGE_BGRA
+    // - FRAGMENT_SELECTOR_IMAGE_TILE
     // - FRAGMENT_SELECTOR_GLYPH_ALPHA
     // - FRAGMENT_SELECTOR_GLYPH_LCD
     uint32_t fragmentShaderSelector = FRAGMENT_SELECTOR_IMAGE_BGRA;
@@ -79,6 +81,43 @@ struct RenderTileAttributes
     ImageSize targetSize {};
 };
 
+/// @returns the format of the texture atlas storing the tiles rendered with the given fragment shader,
+///          which is also what the fragment shader samples them from.
+constexpr atlas::Format atlasFormatOf(uint32_t fragmentShaderSelector) noexcept
+{
+    switch (fragmentShaderSelector)
+    {
+        case FRAGMENT_SELECTOR_GLYPH_LCD:
+        case FRAGMENT_SELECTOR_GLYPH_LCD_SIMPLE: return atlas::Format::RGB;
+        case FRAGMENT_SELECTOR_IMAGE_BGRA:
+        case FRAGMENT_SELECTOR_IMAGE_TILE: return atlas::Format::RGBA;
+        case FRAGMENT_SELECTOR_GLYPH_ALPHA:
+        default: return atlas::Format::Red;
+    }
+}
+
+/// Parts of the view that look different from the previously executed frame.
+struct FrameDamage
+{
+    /// Vertical range of pixels [top, bottom) spanning the full width of the view.
+    struct Band
+    {
+        int top = 0;
+        int bottom = 0;
+    };
+
+    bool full = true;         ///< Whether all of the view is to be repainted, regardless of the bands.
+    std::vector<Band> bands;  ///< Non-overlapping ranges to be repainted, in ascending order.
+};
+
+/// @returns the index of the texture atlas storing the tiles rendered with the given fragment shader.
+constexpr size_t atlasIndexOf(uint32_t fragmentShaderSelector) noexcept
+{
+    if (fragmentShaderSelector == FRAGMENT_SELECTOR_IMAGE_TILE)
+        return atlas::ImageAtlasIndex;
+    return atlas::formatIndex(atlasFormatOf(fragmentShaderSelector));
+}
+
 /**
  * Terminal render target interface, for example OpenGL, DirectX, or software-rasterization.
  *
@@ -111,6 +150,23 @@ class RenderTarget
     /// Schedules taking a screenshot of the current scene and forwards it to the given callback.
     virtual void scheduleScreenshot(ScreenshotCallback callback) = 0;
 
+    /// Marks everything scheduled for rendering so far in this frame as the frame's contents,
+    /// which are kept after executing it, so that later frames may replay them.
+    virtual void retainContents() = 0;
+
+    /// Schedules the most recently retained contents for rendering again, ahead of anything
+    /// else rendered in this frame.
+    ///
+    /// @retval false if no contents are retained, or they no longer apply, e.g. as the atlases
+    ///               or margins changed since. Nothing is scheduled then.
+    [[nodiscard]] virtual bool replayContents() = 0;
+
+    /// Limits repainting the next executed frame to the given damage, while anything outside of
+    /// it keeps the pixels of the previously executed frame. Everything is repainted if not set.
+    ///
+    /// The render commands scheduled are still required to cover the whole frame.
+    virtual void setDamage(FrameDamage const& damage) = 0;
+
     /// Executes all previously scheduled render commands.
     virtual void execute(std::chrono::steady_clock::time_point now) = 0;
 
@@ -136,13 +192,16 @@ class Renderable
     using AtlasTileAttributes = atlas::TileAttributes<RenderTileAttributes>;
     using TileSliceIndex = atlas::TileSliceIndex;
 
+    // Texture atlases, one per format indexed by atlas::formatIndex(), followed by the image atlas.
+    using TextureAtlases = std::array<TextureAtlas*, atlas::AtlasCount>;
+
     explicit Renderable(GridMetrics const& gridMetrics);
     virtual ~Renderable() = default;
 
     virtual void clearCache() {}
 
     virtual void setRenderTarget(RenderTarget& renderTarget, DirectMappingAllocator& directMappingAllocator);
-    virtual void setTextureAtlas(TextureAtlas& atlas) { _textureAtlas = &atlas; }
+    virtual void setTextureAtlases(TextureAtlases atlases) { _textureAtlases = atlases; }
 
     [[nodiscard]] TextureAtlas::TileCreateData createTileData(atlas::TileLocation tileLocation,
                                                               std::vector<uint8_t> bitmap,
@@ -185,12 +244,20 @@ class Renderable
         return *_renderTarget;
     }
 
-    [[nodiscard]] TextureAtlas& textureAtlas() noexcept
+    [[nodiscard]] TextureAtlas& textureAtlas(atlas::Format format) noexcept
     {
-        assert(_textureAtlas);
-        return *_textureAtlas;
+        assert(_textureAtlases[atlas::formatIndex(format)]);
+        return *_textureAtlases[atlas::formatIndex(format)];
     }
 
+    [[nodiscard]] TextureAtlas& imageAtlas() noexcept
+    {
+        assert(_textureAtlases[atlas::ImageAtlasIndex]);
+        return *_textureAtlases[atlas::ImageAtlasIndex];
+    }
+
+    [[nodiscard]] bool hasTextureAtlases() const noexcept { return _textureAtlases[0] != nullptr; }
+
     [[nodiscard]] atlas::AtlasBackend& textureScheduler() noexcept { return *_textureScheduler; }
 
     virtual void inspect(std::ostream& output) const = 0;
@@ -198,7 +265,7 @@ class Renderable
   protected:
     GridMetrics const& _gridMetrics;
     RenderTarget* _renderTarget = nullptr;
-    TextureAtlas* _textureAtlas = nullptr;
+    TextureAtlases _textureAtlases {};
     atlas::DirectMappingAllocator<RenderTileAttributes>* _directMappingAllocator = nullptr;
     atlas::AtlasBackend* _textureScheduler = nullptr;
 };
@@ -7,13 +7,17 @@
 #include <text_shaper/open_shaper.h>
 
 #include <crispy/StrongLRUHashtable.h>
+#include <crispy/allocations.h>
+#include <crispy/tracing.h>
 
 #if defined(_WIN32)
     #include <text_shaper/directwrite_shaper.h>
 #endif
 
+#include <algorithm>
 #include <array>
 #include <memory>
+#include <utility>
 
 using std::array;
 using std::get;
@@ -34,6 +38,8 @@ namespace vtrasterizer
 
 namespace
 {
+    // Maximum number of bands a frame's damage is made up of, see Renderer::updateFrameDamage().
+    constexpr size_t MaxDamageBands = 4;
 
     void loadGridMetricsFromFont(text::font_key font, GridMetrics& gm, text::shaper& textShaper)
     {
@@ -65,6 +71,14 @@ namespace
 
     FontKeys loadFontKeys(FontDescriptions const& fd, text::shaper& shaper)
     {
+        CRISPY_TRACE_ZONE("loadFontKeys", "font");
+
+        // Locate the fonts of all other styles concurrently, while the regular font,
+        // which the grid metrics depend on, is loaded right away.
+        // The shaper always uses the locator of the font descriptions' locator engine.
+        auto const otherFonts = std::array { fd.bold, fd.italic, fd.boldItalic, fd.emoji };
+        createFontLocator(fd.fontLocator).prefetch(otherFonts);
+
         FontKeys output {};
         auto const regularOpt = shaper.load_font(fd.regular, fd.size);
         Require(regularOpt.has_value());
@@ -77,7 +91,10 @@ namespace
         return output;
     }
 
-    unique_ptr<text::shaper> createTextShaper(TextShapingEngine engine, DPI dpi, text::font_locator& locator)
+    unique_ptr<text::shaper> createTextShaper(TextShapingEngine engine,
+                                              DPI dpi,
+                                              text::font_locator& locator,
+                                              std::filesystem::path const& cacheDirectory)
     {
         switch (engine)
         {
@@ -104,7 +121,7 @@ namespace
         }
 
         rendererLog()("Using OpenShaper text shaping engine.");
-        return make_unique<text::open_shaper>(dpi, locator);
+        return make_unique<text::open_shaper>(dpi, locator, cacheDirectory);
     }
 
 } // namespace
@@ -115,6 +132,7 @@ Renderer::Renderer(vtbackend::PageSize pageSize,
                    crispy::strong_hashtable_size atlasHashtableSlotCount,
                    crispy::lru_capacity atlasTileCount,
                    bool atlasDirectMapping,
+                   std::filesystem::path glyphCacheDirectory,
                    Decorator hyperlinkNormal,
                    Decorator hyperlinkHover):
     _atlasHashtableSlotCount { crispy::nextPowerOfTwo(atlasHashtableSlotCount.value) },
@@ -127,7 +145,8 @@ Renderer::Renderer(vtbackend::PageSize pageSize,
     _fontDescriptions { std::move(fontDescriptions) },
     _textShaper { createTextShaper(_fontDescriptions.textShapingEngine,
                                    _fontDescriptions.dpi,
-                                   createFontLocator(_fontDescriptions.fontLocator)) },
+                                   createFontLocator(_fontDescriptions.fontLocator, glyphCacheDirectory),
+                                   glyphCacheDirectory) },
     _fonts { loadFontKeys(_fontDescriptions, *_textShaper) },
     _gridMetrics { loadGridMetrics(_fonts.regular, pageSize, *_textShaper) },
     //.
@@ -138,6 +157,7 @@ Renderer::Renderer(vtbackend::PageSize pageSize,
     _decorationRenderer { _gridMetrics, hyperlinkNormal, hyperlinkHover },
     _cursorRenderer { _gridMetrics, vtbackend::CursorShape::Block }
 {
+    _textRenderer.setGlyphCacheDirectory(std::move(glyphCacheDirectory));
     _textRenderer.updateFontMetrics();
     _imageRenderer.setCellSize(cellSize());
 
@@ -155,6 +175,8 @@ Renderer::Renderer(vtbackend::PageSize pageSize,
 void Renderer::setRenderTarget(RenderTarget& renderTarget)
 {
     _renderTarget = &renderTarget;
+    _retainedContentFrameID = 0;
+    _damageBaseFrameID = 0;
 
     // Reset DirectMappingAllocator (also skipping zero-tile).
     _directMappingAllocator =
@@ -176,29 +198,59 @@ void Renderer::configureTextureAtlas()
 {
     Require(_renderTarget);
 
-    auto const atlasCellSize = _gridMetrics.cellSize;
-    auto atlasProperties =
-        atlas::AtlasProperties { .format = atlas::Format::RGBA,
-                                 .tileSize = atlasCellSize,
-                                 .hashCount = _atlasHashtableSlotCount,
-                                 .tileCount = _atlasTileCount,
-                                 .directMappingCount = _directMappingAllocator.currentlyAllocatedCount };
-
-    Require(atlasProperties.tileCount.value > 0);
-
-    _textureAtlas = make_unique<Renderable::TextureAtlas>(_renderTarget->textureScheduler(), atlasProperties);
-
-    // clang-format off
-    rendererLog()("Configuring texture atlas.\n", atlasProperties);
-    rendererLog()("- Atlas properties     : {}\n", atlasProperties);
-    rendererLog()("- Atlas texture size   : {} pixels\n", _textureAtlas->atlasSize());
-    rendererLog()("- Atlas hashtable      : {} slots\n", _atlasHashtableSlotCount.value);
-    rendererLog()("- Atlas tile count     : {} = {}x * {}y\n", _textureAtlas->capacity(), _textureAtlas->tilesInX(), _textureAtlas->tilesInY());
+    // Each tile format has an atlas of its own, so that tiles only take the bytes per pixel they need:
+    // - Red:  gray-scale anti-aliased glyphs and any other alpha masks (box drawing, decorations, cursor)
+    // - RGB:  LCD subpixel anti-aliased glyphs, rasterized in LCD render mode (and always by DirectWrite)
+    // - RGBA: colored glyphs (emoji)
+    // Images have an RGBA atlas of their own, so that they never evict any glyphs.
+    //
+    // Direct-mapped tile slots are reserved in every atlas, as a direct-mapped glyph's tile
+    // is stored in the atlas of its bitmap format.
+    auto const lcd = _fontDescriptions.renderMode == text::render_mode::lcd
+                     || _fontDescriptions.textShapingEngine == TextShapingEngine::DWrite;
+    auto atlases = Renderable::TextureAtlases {};
+    auto gpuMemoryUsage = size_t { 0 };
+    for (size_t atlasIndex = 0; atlasIndex < atlas::AtlasCount; ++atlasIndex)
+    {
+        auto const format = atlas::atlasFormat(atlasIndex);
+        auto const tileCount =
+            (format != atlas::Format::RGB || lcd) ? _atlasTileCount : crispy::lru_capacity { 1 };
+
+        // Wide and extra wide tiles hold emoji, CJK glyphs, and ligatures without slicing them.
+        // These are rare compared to narrow glyphs, hence only a fraction of the tile count is reserved.
+        auto atlasProperties =
+            atlas::AtlasProperties { .format = format,
+                                     .tileSize = _gridMetrics.cellSize,
+                                     .hashCount = _atlasHashtableSlotCount,
+                                     .tileCount = tileCount,
+                                     .wideTileCount = tileCount.value / 8,
+                                     .extraWideTileCount = tileCount.value / 32,
+                                     .directMappingCount = _directMappingAllocator.currentlyAllocatedCount,
+                                     .atlasIndex = static_cast<uint32_t>(atlasIndex) };
+
+        Require(atlasProperties.tileCount.value > 0);
+
+        auto& textureAtlas = _textureAtlases[atlasIndex];
+        textureAtlas =
+            make_unique<Renderable::TextureAtlas>(_renderTarget->textureScheduler(), atlasProperties);
+        atlases[atlasIndex] = textureAtlas.get();
+        gpuMemoryUsage +=
+            textureAtlas->atlasSize().area() * textureAtlas->layerCount() * atlas::element_count(format);
+
+        // clang-format off
+        rendererLog()("Configuring {} texture atlas.\n", atlasIndex == atlas::ImageAtlasIndex ? "image" : std::format("{}", format));
+        rendererLog()("- Atlas properties     : {}\n", atlasProperties);
+        rendererLog()("- Atlas texture size   : {} pixels x {} layers\n", textureAtlas->atlasSize(), textureAtlas->layerCount());
+        rendererLog()("- Atlas hashtable      : {} slots\n", _atlasHashtableSlotCount.value);
+        rendererLog()("- Atlas tile count     : {} = {}x * {}y * {}l\n", textureAtlas->capacity(), textureAtlas->tilesInX(), textureAtlas->tilesInY(), textureAtlas->layerCount());
+        rendererLog()("- Atlas wide tiles     : {} (2x), {} (4x)\n", textureAtlas->capacity(atlas::TileSizeClass::Wide), textureAtlas->capacity(atlas::TileSizeClass::ExtraWide));
+        // clang-format on
+    }
     rendererLog()("- Atlas direct mapping : {} (for text rendering)", _atlasDirectMapping ? "enabled" : "disabled");
-    // clang-format on
+    _gpuMemoryUsage = gpuMemoryUsage;
 
     for (gsl::not_null<Renderable*> const& renderable: renderables())
-        renderable->setTextureAtlas(*_textureAtlas);
+        renderable->setTextureAtlases(atlases);
 }
 
 void Renderer::discardImage(vtbackend::Image const& image)
@@ -225,6 +277,8 @@ void Renderer::clearCache()
         return;
 
     _renderTarget->clearCache();
+    _retainedContentFrameID = 0;
+    _damageBaseFrameID = 0;
 
     // TODO(?): below functions are actually doing the same again and again and again. delete them (and their
     // functions for that) either that, or only the render target is allowed to clear the actual atlas caches.
@@ -234,6 +288,8 @@ void Renderer::clearCache()
 
 void Renderer::setFonts(FontDescriptions fontDescriptions)
 {
+    _textRenderer.discardPendingRasterization();
+
     if (_fontDescriptions.textShapingEngine == fontDescriptions.textShapingEngine)
     {
         _textShaper->clear_cache();
@@ -244,7 +300,8 @@ void Renderer::setFonts(FontDescriptions fontDescriptions)
     else
         _textShaper = createTextShaper(fontDescriptions.textShapingEngine,
                                        fontDescriptions.dpi,
-                                       createFontLocator(fontDescriptions.fontLocator));
+                                       createFontLocator(fontDescriptions.fontLocator),
+                                       _textRenderer.glyphCacheDirectory());
 
     _fontDescriptions = std::move(fontDescriptions);
     _fonts = loadFontKeys(_fontDescriptions, *_textShaper);
@@ -259,6 +316,7 @@ bool Renderer::setFontSize(text::font_size fontSize)
     if (fontSize.pt > 200.)
         return false;
 
+    _textRenderer.discardPendingRasterization();
     _fontDescriptions.size = fontSize;
     _fonts = loadFontKeys(_fontDescriptions, *_textShaper);
     updateFontMetrics();
@@ -268,6 +326,7 @@ bool Renderer::setFontSize(text::font_size fontSize)
 
 void Renderer::updateFontMetrics()
 {
+    CRISPY_TRACE_ZONE("updateFontMetrics", "font");
     rendererLog()("Updating grid metrics: {}", _gridMetrics);
 
     _gridMetrics = loadGridMetrics(_fonts.regular, _gridMetrics.pageSize, *_textShaper);
@@ -283,6 +342,8 @@ void Renderer::updateFontMetrics()
 
 void Renderer::render(vtbackend::Terminal& terminal, bool pressure)
 {
+    CRISPY_TRACE_ZONE("Renderer::render", "render");
+    auto const frameStart = steady_clock::now();
     auto const statusLineHeight = terminal.statusLineHeight();
     _gridMetrics.pageSize = terminal.pageSize() + statusLineHeight;
 
@@ -295,18 +356,68 @@ void Renderer::render(vtbackend::Terminal& terminal, bool pressure)
     terminal.refreshRenderBuffer();
 #endif // }}}
 
+    if (!_performanceHudVisible)
+        _performanceHud.reset();
+    else
+    {
+        if (!_performanceHud)
+            _performanceHud = make_unique<PerformanceHud>();
+        updatePerformanceHud(terminal, frameStart);
+    }
+
     optional<vtbackend::RenderCursor> cursorOpt;
-    _imageRenderer.beginFrame();
-    _textRenderer.beginFrame();
-    _textRenderer.setPressure(pressure && terminal.isPrimaryScreen());
+    optional<vtbackend::InputTiming> inputTiming;
+    auto frameID = uint64_t { 0 };
+    auto contentsComplete = true;
     {
         vtbackend::RenderBufferRef const renderBuffer = terminal.renderBuffer();
         cursorOpt = renderBuffer.get().cursor;
-        renderCells(renderBuffer.get().cells);
-        renderLines(renderBuffer.get().lines);
+        frameID = renderBuffer.get().frameID;
+        updateFrameDamage(renderBuffer.get());
+        if (frameID > _lastRenderedFrameID)
+        {
+            if (_lastRenderedFrameID != 0)
+                _frameStats.dropped += frameID - _lastRenderedFrameID - 1;
+            _lastRenderedFrameID = frameID;
+            inputTiming = renderBuffer.get().inputTiming;
+        }
+
+        // Frames that only differ in the cursor, e.g. when it blinks, draw it on top of the contents
+        // retained from an earlier frame, instead of rendering all cells all over again.
+        auto const contentFrameID = renderBuffer.get().contentFrameID;
+        if (!_performanceHud && contentFrameID != 0 && contentFrameID == _retainedContentFrameID
+            && _renderTarget->replayContents())
+            ++_frameStats.cursorOnly;
+        else
+        {
+            _imageRenderer.beginFrame();
+            _textRenderer.beginFrame();
+            _textRenderer.setPressure(pressure && terminal.isPrimaryScreen());
+            if (_performanceHud)
+                renderWithPerformanceHud(renderBuffer.get());
+            else
+            {
+                renderCells(renderBuffer.get().cells);
+                renderLines(renderBuffer.get().lines);
+            }
+            _textRenderer.endFrame();
+            _imageRenderer.endFrame();
+
+            // Glyphs still being rasterized in the background are to be drawn by a later frame.
+            _retainedContentFrameID = 0;
+            contentsComplete = !_textRenderer.glyphsLeftOut();
+            if (!_performanceHud && contentsComplete)
+            {
+                _renderTarget->retainContents();
+                _retainedContentFrameID = contentFrameID;
+            }
+        }
     }
-    _textRenderer.endFrame();
-    _imageRenderer.endFrame();
+
+    if (cursorOpt && _performanceHud
+        && cursorOpt->position.line < boxed_cast<vtbackend::LineOffset>(_performanceHud->height())
+        && cursorOpt->position.column >= _performanceHud->leftColumn(_gridMetrics.pageSize.columns))
+        cursorOpt.reset();
 
     if (cursorOpt && cursorOpt.value().shape != vtbackend::CursorShape::Block)
     {
@@ -324,21 +435,203 @@ void Renderer::render(vtbackend::Terminal& terminal, bool pressure)
         _cursorRenderer.render(_gridMetrics.map(cursor.position), cursor.width, cursorColor);
     }
 
+    _renderTarget->setDamage(_frameDamage);
     _renderTarget->execute(terminal.currentTime());
+    _damageBaseFrameID = !_performanceHud && contentsComplete ? frameID : 0;
+
+    ++_frameStats.rendered;
+    terminal.framePacer().recordRenderTime(steady_clock::now() - frameStart);
+    if (inputTiming)
+    {
+        _frameStats.inputAnswerLatency.observe(
+            std::chrono::duration<double>(inputTiming->answered - inputTiming->input).count());
+        // Frames rendered before the earlier one was presented show the earlier input's answer as well.
+        if (!_unpresentedInput)
+            _unpresentedInput = inputTiming;
+    }
+
+    if (_performanceHud)
+        _performanceHud->recordFrame(steady_clock::now() - frameStart);
+
+    if constexpr (crispy::allocations::enabled())
+        traceAllocations();
+}
+
+void Renderer::traceAllocations()
+{
+    // The counts are kept track of while not tracing too, so that the first frame traced
+    // does not show all allocations made before.
+    auto const& counters = crispy::allocations::counters();
+    _tracedAllocations.resize(counters.size());
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        auto const counts = counters[i]->read();
+        crispy::tracing::counter(counters[i]->name(),
+                                 static_cast<double>(counts.count - _tracedAllocations[i].count),
+                                 "allocations");
+        _tracedAllocations[i] = counts;
+    }
+}
+
+void Renderer::framePresented(steady_clock::time_point now)
+{
+    if (!_unpresentedInput)
+        return;
+
+    auto const latency = now - std::exchange(_unpresentedInput, std::nullopt)->input;
+    _frameStats.inputLatency.observe(std::chrono::duration<double>(latency).count());
+    if (_performanceHud)
+        _performanceHud->recordInputLatency(std::chrono::duration_cast<std::chrono::nanoseconds>(latency));
+}
+
+void Renderer::updatePerformanceHud(vtbackend::Terminal& terminal, steady_clock::time_point now)
+{
+    if (!_performanceHud->sampleDue(now))
+        return;
+
+    auto sample = PerformanceHud::Sample {
+        .parsedBytes = terminal.parsedBytes(),
+        .renderBufferFillTime = terminal.renderBufferFillTime(),
+        .pendingPtyBytes = terminal.pendingInputBytes(),
+        .memoryUsage = terminal.memoryUsage(),
+        .gpuMemoryUsage = gpuMemoryUsage(),
+    };
+    if constexpr (crispy::allocations::enabled())
+        for (auto const* counter: crispy::allocations::counters())
+            sample.allocations.push_back({ .name = counter->name(), .counts = counter->read() });
+    auto const usage = fetchAndClearAtlasUsage();
+    sample.atlasTileCount = usage.tileCount;
+    sample.atlasTileCapacity = usage.tileCapacity;
+    sample.glyphCache = usage.cache;
+    _performanceHud->update(sample, now);
+}
+
+Renderable::TextureAtlas::Usage Renderer::fetchAndClearAtlasUsage() noexcept
+{
+    auto result = Renderable::TextureAtlas::Usage {};
+    for (auto const& textureAtlas: _textureAtlases)
+    {
+        if (!textureAtlas)
+            continue;
+        auto const usage = textureAtlas->fetchAndClearUsage();
+        result.tileCount += usage.tileCount;
+        result.tileCapacity += usage.tileCapacity;
+        result.cache.hits += usage.cache.hits;
+        result.cache.misses += usage.cache.misses;
+        result.cache.recycles += usage.cache.recycles;
+    }
+    return result;
+}
+
+void Renderer::renderWithPerformanceHud(vtbackend::RenderBuffer const& renderBuffer)
+{
+    // All backgrounds are drawn before any text, so whatever the HUD covers must be left out entirely,
+    // instead of being drawn over.
+    auto const top = boxed_cast<vtbackend::LineOffset>(_performanceHud->height());
+    auto const left = _performanceHud->leftColumn(_gridMetrics.pageSize.columns);
+
+    auto const& cells = renderBuffer.cells;
+    _performanceHudCells.clear();
+    auto const appendRun = [&](size_t begin, size_t end) {
+        if (begin == end)
+            return;
+        auto const first = _performanceHudCells.size();
+        _performanceHudCells.appendRange(cells, begin, end);
+        _performanceHudCells.markGroupStart(first);
+        _performanceHudCells.markGroupEnd(_performanceHudCells.size() - 1);
+    };
+    auto runBegin = size_t { 0 };
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        if (cells.positions[i].line < top && cells.positions[i].column >= left)
+        {
+            appendRun(runBegin, i);
+            runBegin = i + 1;
+        }
+    }
+    appendRun(runBegin, cells.size());
+
+    auto const attributes = vtbackend::RenderAttributes {
+        .foregroundColor = _colorPalette.defaultBackground,
+        .backgroundColor = _colorPalette.defaultForeground,
+    };
+    _performanceHud->render(_performanceHudCells, _gridMetrics.pageSize.columns, attributes);
+
+    // Trivial lines in the rows of the HUD are cut off where the HUD starts.
+    _performanceHudLines.assign(renderBuffer.lines.begin(), renderBuffer.lines.end());
+    auto const leftColumns = boxed_cast<vtbackend::ColumnCount>(left);
+    for (auto& line: _performanceHudLines)
+    {
+        if (line.lineOffset >= top)
+            continue;
+        line.usedColumns = std::min(line.usedColumns, leftColumns);
+        line.displayWidth = std::min(line.displayWidth, leftColumns);
+        // No character takes more columns than bytes, so this never leaves any text under the HUD,
+        // though it may cut off multi-byte text a little early. It must not split a UTF-8 sequence.
+        auto length = std::min(line.text.size(), unbox<size_t>(leftColumns));
+        while (length > 0 && length < line.text.size()
+               && (static_cast<unsigned char>(line.text[length]) & 0xC0) == 0x80)
+            --length;
+        line.text = line.text.substr(0, length);
+    }
+
+    renderCells(_performanceHudCells);
+    renderLines(_performanceHudLines);
 }
 
-void Renderer::renderCells(vector<vtbackend::RenderCell> const& renderableCells)
+void Renderer::updateFrameDamage(vtbackend::RenderBuffer const& renderBuffer)
 {
-    for (vtbackend::RenderCell const& cell: renderableCells)
+    // Lines can only be left alone if they look exactly as in the frame the render target shows.
+    auto const& damage = renderBuffer.damage;
+    auto const repeated = renderBuffer.frameID == _damageBaseFrameID;
+    _frameDamage.bands.clear();
+    _frameDamage.full = _damageBaseFrameID == 0 || _performanceHud
+                        || (!repeated && (renderBuffer.frameID != _damageBaseFrameID + 1 || !damage.valid));
+    if (_frameDamage.full || repeated)
+        return;
+
+    // Glyphs may reach into the lines next to their own, which are therefore repainted along.
+    auto const cellHeight = unbox<int>(_gridMetrics.cellSize.height);
+    auto const pageTop = _gridMetrics.map(vtbackend::LineOffset(0), vtbackend::ColumnOffset(0)).y;
+    auto const mainPageTop = unbox<int>(damage.key.baseLine);
+    auto const mainPageLines = static_cast<int>(damage.lineRanges.size());
+    auto& bands = _frameDamage.bands;
+    for (auto line = 0; line < unbox<int>(_gridMetrics.pageSize.lines); ++line)
+    {
+        // Status lines are rendered anew with every frame.
+        auto const mainPageLine = line - mainPageTop;
+        if (0 <= mainPageLine && mainPageLine < mainPageLines
+            && damage.lineRanges[static_cast<size_t>(mainPageLine)].unmoved)
+            continue;
+
+        auto const top = pageTop + ((line - 1) * cellHeight);
+        auto const bottom = pageTop + ((line + 2) * cellHeight);
+        if (!bands.empty() && top <= bands.back().bottom)
+            bands.back().bottom = bottom;
+        else
+            bands.push_back(FrameDamage::Band { .top = top, .bottom = bottom });
+    }
+
+    // Each band is painted in a pass of its own, so too many of them are merged into one.
+    if (bands.size() > MaxDamageBands)
     {
-        _backgroundRenderer.renderCell(cell);
-        _decorationRenderer.renderCell(cell);
-        _textRenderer.renderCell(cell);
-        if (cell.image)
-            _imageRenderer.renderImage(_gridMetrics.map(cell.position), *cell.image);
+        bands.front().bottom = bands.back().bottom;
+        bands.resize(1);
     }
 }
 
+void Renderer::renderCells(vtbackend::RenderCells const& renderableCells)
+{
+    _backgroundRenderer.renderCells(renderableCells);
+    _decorationRenderer.renderCells(renderableCells);
+    _textRenderer.renderCells(renderableCells);
+    for (vtbackend::RenderImage const& image: renderableCells.images)
+        _imageRenderer.renderImage(_gridMetrics.map(renderableCells.positions[image.cell]),
+                                   *image.image,
+                                   image.offset,
+                                   vtbackend::ColumnCount::cast_from(image.span));
+}
+
 void Renderer::renderLines(vector<vtbackend::RenderLine> const& renderableLines)
 {
     for (vtbackend::RenderLine const& line: renderableLines)
@@ -351,7 +644,8 @@ void Renderer::renderLines(vector<vtbackend::RenderLine> const& renderableLines)
 
 void Renderer::inspect(std::ostream& textOutput) const
 {
-    _textureAtlas->inspect(textOutput);
+    for (auto const& textureAtlas: _textureAtlases)
+        textureAtlas->inspect(textOutput);
     for (auto const& renderable: renderables())
         renderable->inspect(textOutput);
 }
@@ -11,16 +11,24 @@
 #include <vtrasterizer/Decorator.h>
 #include <vtrasterizer/GridMetrics.h>
 #include <vtrasterizer/ImageRenderer.h>
+#include <vtrasterizer/PerformanceHud.h>
 #include <vtrasterizer/RenderTarget.h>
 #include <vtrasterizer/TextRenderer.h>
 
 #include <crispy/StrongLRUHashtable.h>
+#include <crispy/allocations.h>
+#include <crispy/metrics.h>
 #include <crispy/size.h>
 
 #include <gsl/pointers>
 
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <functional>
 #include <format>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace vtrasterizer
@@ -51,6 +59,8 @@ class Renderer
      * @p projectionMatrix   Projection matrix to apply to the rendered scene when rendering the screen.
      * @p atlasDirectMapping Indicates whether or not direct mapped tiles are allowed.
      * @p atlasTileCount     Number of tiles guaranteed to be available in LRU cache.
+     * @p glyphCacheDirectory Directory to persist shaping results, glyph bitmaps, located
+     *                       font chains, and font coverages in, or empty to not persist them.
      */
     Renderer(vtbackend::PageSize pageSize,
              FontDescriptions fontDescriptions,
@@ -58,6 +68,7 @@ class Renderer
              crispy::strong_hashtable_size atlasHashtableSlotCount,
              crispy::lru_capacity atlasTileCount,
              bool atlasDirectMapping,
+             std::filesystem::path glyphCacheDirectory,
              Decorator hyperlinkNormal,
              Decorator hyperlinkHover);
 
@@ -75,11 +86,20 @@ class Renderer
     [[nodiscard]] FontDescriptions const& fontDescriptions() const noexcept { return _fontDescriptions; }
     void setFonts(FontDescriptions fontDescriptions);
 
+    /// Rasterizes glyphs on a background thread, invoking @p glyphsRasterized whenever
+    /// new glyphs are ready, which should then schedule a redraw.
+    void enableAsyncRasterization(std::function<void()> glyphsRasterized)
+    {
+        _textRenderer.enableAsyncRasterization(std::move(glyphsRasterized));
+    }
+
     [[nodiscard]] GridMetrics const& gridMetrics() const noexcept { return _gridMetrics; }
 
     void setHyperlinkDecoration(Decorator normal, Decorator hover)
     {
         _decorationRenderer.setHyperlinkDecoration(normal, hover);
+        _retainedContentFrameID = 0;
+        _damageBaseFrameID = 0;
     }
 
     void setPageSize(vtbackend::PageSize screenSize) noexcept { _gridMetrics.pageSize = screenSize; }
@@ -104,10 +124,53 @@ class Renderer
      */
     void render(vtbackend::Terminal& terminal, bool pressureHint);
 
+    /// Notes the frame rendered last as presented, i.e. swapped to the screen, which completes
+    /// the input latency of the key input it is the first to show the answer of, if any.
+    ///
+    /// This must be invoked on the thread rendering.
+    void framePresented(std::chrono::steady_clock::time_point now);
+
+    /// Shows or hides the performance HUD, taking effect with the next frame rendered.
+    ///
+    /// This may be invoked from any thread.
+    void setPerformanceHudVisible(bool visible) noexcept { _performanceHudVisible = visible; }
+    [[nodiscard]] bool performanceHudVisible() const noexcept { return _performanceHudVisible; }
+
+    /// Statistics on the frames rendered, which may be read from any thread.
+    struct FrameStats
+    {
+        std::atomic<uint64_t> rendered = 0;
+        /// Render buffers that have been refreshed, but replaced by a newer one before being rendered.
+        std::atomic<uint64_t> dropped = 0;
+        /// Frames rendered that only differed from the previous one in the cursor, see
+        /// vtbackend::RenderBuffer::contentFrameID.
+        std::atomic<uint64_t> cursorOnly = 0;
+        /// Time from key input until PTY output following it has been parsed, in seconds.
+        crispy::metrics::histogram inputAnswerLatency {
+            { 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0 }
+        };
+        /// Time from key input until the first frame showing its answer has been presented, in seconds.
+        crispy::metrics::histogram inputLatency {
+            { 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0 }
+        };
+    };
+
+    [[nodiscard]] FrameStats const& frameStats() const noexcept { return _frameStats; }
+
+    /// @returns the number of bytes of texture memory allocated for the atlases, which may be
+    ///          invoked from any thread.
+    [[nodiscard]] size_t gpuMemoryUsage() const noexcept { return _gpuMemoryUsage.load(); }
+
+    /// @returns the usage of all texture atlases summed up, resetting their lookup and eviction counters.
+    [[nodiscard]] Renderable::TextureAtlas::Usage fetchAndClearAtlasUsage() noexcept;
+
     void discardImage(vtbackend::Image const& image);
 
     void clearCache();
 
+    /// Releases the glyph caches retained for switching back to recently used font sizes and DPIs.
+    void releaseRecentGlyphCaches() noexcept { _textRenderer.releaseRecentGlyphCaches(); }
+
     void inspect(std::ostream& textOutput) const;
 
     std::array<gsl::not_null<Renderable*>, 5> renderables()
@@ -126,9 +189,15 @@ class Renderer
 
   private:
     void configureTextureAtlas();
-    void renderCells(std::vector<vtbackend::RenderCell> const& renderableCells);
+    void renderCells(vtbackend::RenderCells const& renderableCells);
     void renderLines(std::vector<vtbackend::RenderLine> const& renderableLines);
     void executeImageDiscards();
+    void updatePerformanceHud(vtbackend::Terminal& terminal, std::chrono::steady_clock::time_point now);
+
+    /// Traces the allocations of each subsystem made since the previous frame.
+    void traceAllocations();
+    void renderWithPerformanceHud(vtbackend::RenderBuffer const& renderBuffer);
+    void updateFrameDamage(vtbackend::RenderBuffer const& renderBuffer);
 
     crispy::strong_hashtable_size _atlasHashtableSlotCount;
     crispy::lru_capacity _atlasTileCount;
@@ -137,7 +206,8 @@ class Renderer
     RenderTarget* _renderTarget = nullptr;
 
     Renderable::DirectMappingAllocator _directMappingAllocator;
-    std::unique_ptr<Renderable::TextureAtlas> _textureAtlas;
+    // Indexed by atlas index, see atlas::AtlasCount.
+    std::array<std::unique_ptr<Renderable::TextureAtlas>, atlas::AtlasCount> _textureAtlases;
 
     FontDescriptions _fontDescriptions;
     std::unique_ptr<text::shaper> _textShaper;
@@ -155,6 +225,25 @@ class Renderer
     TextRenderer _textRenderer;
     DecorationRenderer _decorationRenderer;
     CursorRenderer _cursorRenderer;
+
+    FrameStats _frameStats;
+    std::atomic<size_t> _gpuMemoryUsage = 0;
+    uint64_t _lastRenderedFrameID = 0;
+    uint64_t _retainedContentFrameID = 0; // contents the render target retained, if not 0
+    uint64_t _damageBaseFrameID = 0;      // frame the render target's pixels fully show, if not 0
+    FrameDamage _frameDamage;
+
+    std::atomic<bool> _performanceHudVisible = false;
+    std::unique_ptr<PerformanceHud> _performanceHud; // only exists while visible
+
+    // What is rendered while the HUD is visible: the HUD, and what it does not cover of the terminal.
+    vtbackend::RenderCells _performanceHudCells;
+    std::vector<vtbackend::RenderLine> _performanceHudLines;
+
+    std::vector<crispy::allocations::counts> _tracedAllocations; // counts at the previous frame
+
+    // Key input shown by a frame rendered, but not presented yet.
+    std::optional<vtbackend::InputTiming> _unpresentedInput;
 };
 
 } // namespace vtrasterizer
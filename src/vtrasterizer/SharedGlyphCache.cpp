@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/SharedGlyphCache.h>
+
+#include <algorithm>
+
+using crispy::strong_hash;
+
+using std::nullopt;
+using std::optional;
+using std::shared_ptr;
+using std::vector;
+
+namespace vtrasterizer
+{
+
+namespace
+{
+    optional<uint32_t> slotOf(SharedGlyphCache::FontSlots const& fonts, text::font_key font) noexcept
+    {
+        for (uint32_t slot = 0; slot < fonts.size(); ++slot)
+            if (fonts[slot] == font)
+                return slot;
+        return nullopt;
+    }
+
+    optional<strong_hash> glyphRecordKey(SharedGlyphCache::FontSlots const& fonts,
+                                         text::glyph_key const& glyph)
+    {
+        auto const slot = slotOf(fonts, glyph.font);
+        if (!slot)
+            return nullopt;
+        return strong_hash::compute(glyph.size.pt) * strong_hash(0, 0, *slot, glyph.index.value);
+    }
+} // namespace
+
+shared_ptr<SharedGlyphCache> SharedGlyphCache::acquire(strong_hash fingerprint)
+{
+    static auto registryMutex = std::mutex {};
+    static auto registry = std::unordered_map<strong_hash, std::weak_ptr<SharedGlyphCache>> {};
+
+    auto const lock = std::scoped_lock { registryMutex };
+    std::erase_if(registry, [](auto const& entry) { return entry.second.expired(); });
+
+    auto& entry = registry[fingerprint];
+    if (auto cache = entry.lock())
+        return cache;
+
+    auto cache = std::make_shared<SharedGlyphCache>(fingerprint);
+    entry = cache;
+    return cache;
+}
+
+SharedGlyphCache::SharedGlyphCache(strong_hash fingerprint):
+    _fingerprint { fingerprint },
+    _shapeResults { crispy::strong_hashtable_size { 2 * ShapeResultCapacity },
+                    crispy::lru_capacity { ShapeResultCapacity } }
+{
+}
+
+size_t SharedGlyphCache::size() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _shapeResults.size() + _rasterizedGlyphs.size();
+}
+
+size_t SharedGlyphCache::bitmapSize() const
+{
+    auto const lock = std::scoped_lock { _mutex };
+    return _bitmapSize;
+}
+
+optional<text::shape_result> SharedGlyphCache::shapeResult(FontSlots const& fonts,
+                                                           strong_hash const& key) const
+{
+    auto result = text::shape_result {};
+    auto const found = _shapeResults.visit(key, [&](vector<SlottedGlyphPosition> const& positions) {
+        result.reserve(positions.size());
+        for (SlottedGlyphPosition const& slotted: positions)
+        {
+            result.emplace_back(slotted.position);
+            result.back().glyph.font = fonts[slotted.fontSlot];
+        }
+    });
+    if (!found)
+        return nullopt;
+    return result;
+}
+
+void SharedGlyphCache::storeShapeResult(FontSlots const& fonts,
+                                        strong_hash const& key,
+                                        text::shape_result const& result)
+{
+    auto slotted = vector<SlottedGlyphPosition> {};
+    slotted.reserve(result.size());
+    for (text::glyph_position const& gpos: result)
+    {
+        auto const slot = slotOf(fonts, gpos.glyph.font);
+        if (!slot)
+            return;
+        slotted.emplace_back(SlottedGlyphPosition { .position = gpos, .fontSlot = *slot });
+    }
+
+    _shapeResults.emplace(key, std::move(slotted));
+}
+
+optional<text::rasterized_glyph> SharedGlyphCache::rasterizedGlyph(FontSlots const& fonts,
+                                                                   text::glyph_key const& glyph) const
+{
+    auto const key = glyphRecordKey(fonts, glyph);
+    if (!key)
+        return nullopt;
+
+    auto const lock = std::scoped_lock { _mutex };
+    auto const i = _rasterizedGlyphs.find(*key);
+    if (i == _rasterizedGlyphs.end())
+        return nullopt;
+    return i->second;
+}
+
+void SharedGlyphCache::storeRasterizedGlyph(FontSlots const& fonts,
+                                            text::glyph_key const& glyph,
+                                            text::rasterized_glyph const& bitmap)
+{
+    auto const key = glyphRecordKey(fonts, glyph);
+    if (!key)
+        return;
+
+    auto const lock = std::scoped_lock { _mutex };
+    if (_bitmapSize + bitmap.bitmap.size() > MaxBitmapSize)
+        return;
+    if (_rasterizedGlyphs.try_emplace(*key, bitmap).second)
+        _bitmapSize += bitmap.bitmap.size();
+}
+
+void RecentGlyphCaches::retain(shared_ptr<SharedGlyphCache> previous, strong_hash current)
+{
+    // The current cache is held by the renderer itself.
+    std::erase_if(_caches, [&](auto const& cache) { return cache->fingerprint() == current; });
+
+    if (previous && previous->fingerprint() != current)
+        _caches.insert(_caches.begin(), std::move(previous));
+
+    if (_caches.size() > Capacity)
+        _caches.resize(Capacity);
+
+    auto retainedBitmapSize = size_t { 0 };
+    auto const overBudget = std::ranges::find_if(_caches, [&](auto const& cache) {
+        retainedBitmapSize += cache->bitmapSize();
+        return retainedBitmapSize > MaxBitmapSize;
+    });
+    _caches.erase(overBudget, _caches.end());
+}
+
+} // namespace vtrasterizer
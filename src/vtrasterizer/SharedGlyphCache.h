@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <text_shaper/font.h>
+#include <text_shaper/shaper.h>
+
+#include <crispy/ConcurrentStrongLRUHashtable.h>
+#include <crispy/StrongHash.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace vtrasterizer
+{
+
+/**
+ * In-memory cache of text shaping results and rasterized glyphs, shared by all renderers
+ * within the process that use the same font configuration, e.g. the displays of all windows and tabs.
+ *
+ * Caches are identified by the same fingerprint as GlyphDiskCache, that is, the fonts, font size,
+ * DPI, and render mode. As every renderer loads its fonts into a text shaper of its own,
+ * glyphs refer to their font by its slot, i.e. the index of the font key in the FontSlots
+ * of the renderer accessing the cache.
+ *
+ * A cache lives for as long as any renderer refers to it. All members may be invoked from any thread.
+ * Shaping results are looked up without a global lock, so that renderers shaping text at the same time
+ * do not wait for each other, and the least recently used ones are evicted once the cache is full.
+ */
+class SharedGlyphCache
+{
+  public:
+    /// Fonts that glyphs may refer to, e.g. regular, bold, italic, bold italic, and emoji.
+    using FontSlots = std::array<text::font_key, 5>;
+
+    /// Maximum number of bytes of bitmap data kept in a cache. Nothing is stored beyond that.
+    static constexpr inline size_t MaxBitmapSize = 64 * 1024 * 1024;
+
+    /// Maximum number of shaping results kept in a cache.
+    static constexpr inline uint32_t ShapeResultCapacity = 16384;
+
+    /// @returns the cache for the given fingerprint, creating it unless some renderer already uses it.
+    [[nodiscard]] static std::shared_ptr<SharedGlyphCache> acquire(crispy::strong_hash fingerprint);
+
+    explicit SharedGlyphCache(crispy::strong_hash fingerprint);
+
+    [[nodiscard]] crispy::strong_hash fingerprint() const noexcept { return _fingerprint; }
+
+    /// @returns the number of shaping results and glyphs in the cache.
+    [[nodiscard]] size_t size() const;
+
+    /// @returns the number of bytes of bitmap data in the cache.
+    [[nodiscard]] size_t bitmapSize() const;
+
+    /// Looks up the shaping result stored for the given text and style hash.
+    [[nodiscard]] std::optional<text::shape_result> shapeResult(FontSlots const& fonts,
+                                                                crispy::strong_hash const& key) const;
+
+    /// Stores the given shaping result, unless it refers to a font that is not in any font slot.
+    void storeShapeResult(FontSlots const& fonts,
+                          crispy::strong_hash const& key,
+                          text::shape_result const& result);
+
+    /// Looks up the rasterized bitmap stored for the given glyph.
+    [[nodiscard]] std::optional<text::rasterized_glyph> rasterizedGlyph(FontSlots const& fonts,
+                                                                        text::glyph_key const& glyph) const;
+
+    /// Stores the given rasterized bitmap, unless the glyph's font is not in any font slot.
+    void storeRasterizedGlyph(FontSlots const& fonts,
+                              text::glyph_key const& glyph,
+                              text::rasterized_glyph const& bitmap);
+
+  private:
+    // A glyph position with the font key replaced by its font slot.
+    struct SlottedGlyphPosition
+    {
+        text::glyph_position position;
+        uint32_t fontSlot;
+    };
+
+    crispy::strong_hash _fingerprint;
+
+    crispy::concurrent_strong_lru_hashtable<std::vector<SlottedGlyphPosition>> _shapeResults;
+
+    mutable std::mutex _mutex; // guards the rasterized glyphs
+    std::unordered_map<crispy::strong_hash, text::rasterized_glyph> _rasterizedGlyphs;
+    size_t _bitmapSize = 0;
+};
+
+/**
+ * Keeps the shared glyph caches of the most recently used font configurations of a renderer alive,
+ * so that switching back to one of them, e.g. by zooming in and out again, or by moving the window
+ * between monitors of different DPI, neither shapes nor rasterizes its glyphs again.
+ */
+class RecentGlyphCaches
+{
+  public:
+    /// Maximum number of font configurations retained besides the current one.
+    static constexpr inline size_t Capacity = 2;
+
+    /// Maximum number of bytes of bitmap data retained besides that of the current cache.
+    static constexpr inline size_t MaxBitmapSize = 64 * 1024 * 1024;
+
+    /// Retains the cache of the font configuration just left, unless it is the current one again.
+    ///
+    /// The least recently used caches are released once there are more than Capacity,
+    /// or once they hold more than MaxBitmapSize bytes of bitmap data altogether.
+    void retain(std::shared_ptr<SharedGlyphCache> previous, crispy::strong_hash current);
+
+    /// Releases all retained caches, e.g. to free memory.
+    void clear() noexcept { _caches.clear(); }
+
+    [[nodiscard]] size_t size() const noexcept { return _caches.size(); }
+
+  private:
+    std::vector<std::shared_ptr<SharedGlyphCache>> _caches; // the most recently used one first
+};
+
+} // namespace vtrasterizer
@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/SharedGlyphCache.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <utility>
+
+using namespace vtrasterizer;
+
+using crispy::strong_hash;
+
+namespace
+{
+
+SharedGlyphCache::FontSlots makeFonts(unsigned first)
+{
+    return SharedGlyphCache::FontSlots {
+        text::font_key { first },     text::font_key { first + 1 }, text::font_key { first + 2 },
+        text::font_key { first + 3 }, text::font_key { first + 4 },
+    };
+}
+
+text::glyph_key glyphKey(unsigned font, unsigned index)
+{
+    return text::glyph_key { .size = text::font_size { 12.0 },
+                             .font = text::font_key { font },
+                             .index = text::glyph_index { index } };
+}
+
+text::rasterized_glyph makeGlyph(unsigned index)
+{
+    return text::rasterized_glyph {
+        .index = text::glyph_index { index },
+        .bitmapSize = vtbackend::ImageSize { vtbackend::Width(2), vtbackend::Height(1) },
+        .position = crispy::point { 0, 1 },
+        .format = text::bitmap_format::alpha_mask,
+        .bitmap = { 1, 2 },
+    };
+}
+
+} // namespace
+
+TEST_CASE("SharedGlyphCache.acquire")
+{
+    auto first = SharedGlyphCache::acquire(strong_hash { 1, 2, 3, 4 });
+    auto second = SharedGlyphCache::acquire(strong_hash { 1, 2, 3, 4 });
+    auto other = SharedGlyphCache::acquire(strong_hash { 4, 3, 2, 1 });
+    CHECK(first == second);
+    CHECK(first != other);
+
+    first->storeRasterizedGlyph(makeFonts(1), glyphKey(1, 42), makeGlyph(42));
+    CHECK(second->size() == 1);
+
+    // The cache is released along with the last renderer using it.
+    first.reset();
+    second.reset();
+    auto const third = SharedGlyphCache::acquire(strong_hash { 1, 2, 3, 4 });
+    CHECK(third->size() == 0);
+}
+
+TEST_CASE("SharedGlyphCache.font_slots")
+{
+    auto cache = SharedGlyphCache { strong_hash { 1, 2, 3, 4 } };
+    auto const textKey = strong_hash::compute(std::u32string_view(U"Hello"));
+    cache.storeShapeResult(makeFonts(1),
+                           textKey,
+                           text::shape_result {
+                               text::glyph_position { .glyph = glyphKey(1, 42), .advance = { 8, 0 } },
+                               text::glyph_position { .glyph = glyphKey(2, 43), .advance = { 8, 0 } },
+                           });
+    cache.storeRasterizedGlyph(makeFonts(1), glyphKey(2, 43), makeGlyph(43));
+
+    // Another renderer's text shaper has loaded the same fonts under different keys.
+    auto const fonts = makeFonts(7);
+    auto const shapeResult = cache.shapeResult(fonts, textKey);
+    REQUIRE(shapeResult.has_value());
+    REQUIRE(shapeResult->size() == 2);
+    CHECK(shapeResult->at(0).glyph.font.value == 7);
+    CHECK(shapeResult->at(1).glyph.font.value == 8);
+    CHECK(shapeResult->at(1).glyph.index.value == 43);
+    CHECK(shapeResult->at(1).advance.x == 8);
+
+    auto const glyph = cache.rasterizedGlyph(fonts, glyphKey(8, 43));
+    REQUIRE(glyph.has_value());
+    CHECK(glyph->bitmap == makeGlyph(43).bitmap);
+    CHECK_FALSE(cache.rasterizedGlyph(fonts, glyphKey(7, 43)).has_value());
+
+    // Glyphs of fonts without a slot, such as fallback fonts, are not shared.
+    cache.storeRasterizedGlyph(fonts, glyphKey(99, 1), makeGlyph(1));
+    cache.storeShapeResult(fonts,
+                           strong_hash { 0, 0, 0, 1 },
+                           text::shape_result { text::glyph_position { .glyph = glyphKey(99, 1) } });
+    CHECK(cache.size() == 2);
+}
+
+TEST_CASE("RecentGlyphCaches.retain")
+{
+    auto const small = strong_hash { 5, 0, 0, 1 };
+    auto const large = strong_hash { 5, 0, 0, 2 };
+    auto const larger = strong_hash { 5, 0, 0, 3 };
+    auto const largest = strong_hash { 5, 0, 0, 4 };
+
+    auto recent = RecentGlyphCaches {};
+    auto current = SharedGlyphCache::acquire(small);
+    current->storeRasterizedGlyph(makeFonts(1), glyphKey(1, 42), makeGlyph(42));
+
+    // Zooming in, and out again, finds the glyphs of the font size left before.
+    auto previous = std::exchange(current, SharedGlyphCache::acquire(large));
+    recent.retain(std::move(previous), large);
+    CHECK(recent.size() == 1);
+
+    previous = std::exchange(current, SharedGlyphCache::acquire(small));
+    recent.retain(std::move(previous), small);
+    CHECK(current->size() == 1);
+    CHECK(recent.size() == 1);
+
+    // Only the most recently used font configurations are retained.
+    for (auto const fingerprint: { larger, largest })
+    {
+        previous = std::exchange(current, SharedGlyphCache::acquire(fingerprint));
+        recent.retain(std::move(previous), fingerprint);
+    }
+    CHECK(recent.size() == RecentGlyphCaches::Capacity);
+
+    previous = std::exchange(current, SharedGlyphCache::acquire(small));
+    recent.retain(std::move(previous), small);
+    CHECK(current->size() == 1);
+
+    previous = std::exchange(current, SharedGlyphCache::acquire(large));
+    recent.retain(std::move(previous), large);
+    CHECK(current->size() == 0);
+
+    recent.clear();
+    CHECK(recent.size() == 0);
+}
@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/SoftwareRenderTarget.h>
+
+#include <algorithm>
+#include <ostream>
+#include <string_view>
+
+using std::array;
+using std::optional;
+using std::vector;
+
+namespace vtrasterizer
+{
+
+namespace
+{
+    constexpr float toFloat(uint8_t value) noexcept
+    {
+        return static_cast<float>(value) / 255.f;
+    }
+
+    constexpr uint8_t toByte(float value) noexcept
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+    }
+
+    /// @returns the color of a tile's texel, as the text shader computes it for the given selector.
+    array<float, 4> shadeTexel(uint32_t fragmentShaderSelector,
+                               uint8_t const* texel,
+                               array<float, 4> const& textColor) noexcept
+    {
+        switch (fragmentShaderSelector)
+        {
+            case FRAGMENT_SELECTOR_IMAGE_BGRA:
+            case FRAGMENT_SELECTOR_IMAGE_TILE:
+                return { toFloat(texel[0]), toFloat(texel[1]), toFloat(texel[2]), toFloat(texel[3]) };
+            case FRAGMENT_SELECTOR_GLYPH_LCD_SIMPLE: {
+                auto const r = toFloat(texel[0]);
+                auto const g = toFloat(texel[1]);
+                auto const b = toFloat(texel[2]);
+                return { r * textColor[0], g * textColor[1], b * textColor[2], (r + g + b) / 3.f };
+            }
+            case FRAGMENT_SELECTOR_GLYPH_LCD: {
+                // As glyphs always start at a full pixel, there is no subpixel shift to apply.
+                auto const r = toFloat(texel[0]);
+                auto const g = toFloat(texel[1]);
+                auto const b = toFloat(texel[2]);
+                auto const rgbMax = std::max({ r, g, b });
+                auto const complement = 1.f - rgbMax;
+                auto const alpha = ((r + g + b) / 3.f * rgbMax + std::min({ r, g, b }) * complement);
+                return { textColor[0] * rgbMax + r * complement,
+                         textColor[1] * rgbMax + g * complement,
+                         textColor[2] * rgbMax + b * complement,
+                         alpha * textColor[3] };
+            }
+            case FRAGMENT_SELECTOR_GLYPH_ALPHA:
+            default: return { textColor[0], textColor[1], textColor[2], toFloat(texel[0]) * textColor[3] };
+        }
+    }
+
+    void appendBigEndian(vector<uint8_t>& output, uint32_t value)
+    {
+        output.push_back(static_cast<uint8_t>(value >> 24));
+        output.push_back(static_cast<uint8_t>(value >> 16));
+        output.push_back(static_cast<uint8_t>(value >> 8));
+        output.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint32_t crc32(uint8_t const* data, size_t size) noexcept
+    {
+        static auto const table = []() {
+            auto result = array<uint32_t, 256> {};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                auto c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                result[i] = c;
+            }
+            return result;
+        }();
+
+        auto crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    void appendChunk(vector<uint8_t>& output, std::string_view type, vector<uint8_t> const& data)
+    {
+        appendBigEndian(output, static_cast<uint32_t>(data.size()));
+        auto const start = output.size();
+        output.insert(output.end(), type.begin(), type.end());
+        output.insert(output.end(), data.begin(), data.end());
+        appendBigEndian(output, crc32(output.data() + start, output.size() - start));
+    }
+
+    /// @returns the given data as zlib stream of uncompressed deflate blocks.
+    vector<uint8_t> storeUncompressed(vector<uint8_t> const& data)
+    {
+        constexpr auto MaxBlockSize = size_t { 65535 };
+
+        auto output = vector<uint8_t> { 0x78, 0x01 };
+        output.reserve(data.size() + (data.size() / MaxBlockSize + 1) * 5 + 6);
+        auto offset = size_t { 0 };
+        do
+        {
+            auto const blockSize = std::min(MaxBlockSize, data.size() - offset);
+            auto const isFinal = offset + blockSize == data.size();
+            output.push_back(isFinal ? 1 : 0);
+            output.push_back(static_cast<uint8_t>(blockSize));
+            output.push_back(static_cast<uint8_t>(blockSize >> 8));
+            output.push_back(static_cast<uint8_t>(~blockSize));
+            output.push_back(static_cast<uint8_t>(~blockSize >> 8));
+            output.insert(output.end(),
+                          data.begin() + static_cast<std::ptrdiff_t>(offset),
+                          data.begin() + static_cast<std::ptrdiff_t>(offset + blockSize));
+            offset += blockSize;
+        } while (offset < data.size());
+
+        auto a = uint32_t { 1 };
+        auto b = uint32_t { 0 };
+        for (auto const byte: data)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        appendBigEndian(output, (b << 16) | a);
+        return output;
+    }
+} // namespace
+
+SoftwareRenderTarget::SoftwareRenderTarget(ImageSize size, RGBAColor clearColor):
+    _size { size }, _clearColor { clearColor }, _frameBuffer(size.area() * 4)
+{
+}
+
+// {{{ AtlasBackend impl
+void SoftwareRenderTarget::configureAtlas(atlas::ConfigureAtlas atlas)
+{
+    auto& textureAtlas = _atlases.at(atlas.properties.atlasIndex);
+    textureAtlas.configuration = atlas;
+    textureAtlas.texels.assign(atlas.size.area() * atlas.layerCount * element_count(atlas.properties.format),
+                               0);
+}
+
+void SoftwareRenderTarget::uploadTile(atlas::UploadTile tile)
+{
+    auto& textureAtlas = _atlases.at(tile.atlasIndex);
+    auto const& configuration = textureAtlas.configuration;
+    auto const texelSize = element_count(configuration.properties.format);
+    if (tile.bitmapFormat != configuration.properties.format)
+        return;
+
+    auto const atlasWidth = unbox<size_t>(configuration.size.width);
+    auto const layerOffset = size_t { tile.location.layer.value } * configuration.size.area();
+    auto const rowSize = unbox<size_t>(tile.bitmapSize.width) * texelSize;
+    auto const alignment = static_cast<size_t>(std::max(tile.rowAlignment, 1));
+    auto const pitch = (rowSize + alignment - 1) / alignment * alignment;
+    auto const width = std::min(unbox<size_t>(tile.bitmapSize.width), atlasWidth - tile.location.x.value);
+    auto const height = std::min(unbox<size_t>(tile.bitmapSize.height),
+                                 unbox<size_t>(configuration.size.height) - tile.location.y.value);
+
+    auto* texels = textureAtlas.texels.data() + (layerOffset * texelSize);
+    for (size_t row = 0; row < height && (row * pitch) + (width * texelSize) <= tile.bitmap.size(); ++row)
+    {
+        auto const targetRow = tile.location.y.value + row;
+        auto const target = ((targetRow * atlasWidth) + tile.location.x.value) * texelSize;
+        std::copy_n(tile.bitmap.data() + (row * pitch), width * texelSize, texels + target);
+    }
+}
+
+void SoftwareRenderTarget::renderTile(atlas::RenderTile tile)
+{
+    _tiles.emplace_back(tile);
+}
+// }}}
+
+// {{{ RenderTarget impl
+void SoftwareRenderTarget::setRenderSize(ImageSize size)
+{
+    if (_size == size)
+        return;
+
+    _size = size;
+    _frameBuffer.assign(size.area() * 4, 0);
+}
+
+void SoftwareRenderTarget::renderRectangle(int x, int y, Width width, Height height, RGBAColor color)
+{
+    _filledRects.emplace_back(
+        FilledRect { .x = x, .y = y, .width = width, .height = height, .color = color });
+}
+
+void SoftwareRenderTarget::scheduleScreenshot(ScreenshotCallback callback)
+{
+    _pendingScreenshotCallback = std::move(callback);
+}
+
+void SoftwareRenderTarget::execute(std::chrono::steady_clock::time_point /*now*/)
+{
+    for (size_t i = 0; i < _frameBuffer.size(); i += 4)
+    {
+        _frameBuffer[i + 0] = _clearColor.red();
+        _frameBuffer[i + 1] = _clearColor.green();
+        _frameBuffer[i + 2] = _clearColor.blue();
+        _frameBuffer[i + 3] = _clearColor.alpha();
+    }
+
+    // Just like the OpenGL renderer, all rectangles are drawn below all tiles.
+    for (auto const& rect: _filledRects)
+        draw(rect);
+    for (auto const& tile: _tiles)
+        draw(tile);
+    _filledRects.clear();
+    _tiles.clear();
+
+    if (_pendingScreenshotCallback)
+    {
+        (*_pendingScreenshotCallback)(_frameBuffer, _size);
+        _pendingScreenshotCallback.reset();
+    }
+}
+
+optional<AtlasTextureScreenshot> SoftwareRenderTarget::readAtlas()
+{
+    // NB: This only reads the first layer of the color (RGBA) texture atlas, just like the OpenGL renderer.
+    auto const atlasIndex = atlas::formatIndex(atlas::Format::RGBA);
+    auto const& textureAtlas = _atlases[atlasIndex];
+    auto const layerSize = textureAtlas.configuration.size.area() * 4;
+    if (textureAtlas.texels.size() < layerSize)
+        return std::nullopt;
+
+    return AtlasTextureScreenshot {
+        .atlasInstanceId = static_cast<int>(atlasIndex),
+        .size = textureAtlas.configuration.size,
+        .format = atlas::Format::RGBA,
+        .buffer = atlas::Buffer(textureAtlas.texels.begin(),
+                                textureAtlas.texels.begin() + static_cast<std::ptrdiff_t>(layerSize)),
+    };
+}
+
+void SoftwareRenderTarget::inspect(std::ostream& output) const
+{
+    output << "SoftwareRenderTarget: " << unbox(_size.width) << "x" << unbox(_size.height) << '\n';
+}
+// }}}
+
+void SoftwareRenderTarget::blend(int x, int y, array<float, 4> color) noexcept
+{
+    if (x < 0 || y < 0 || x >= unbox<int>(_size.width) || y >= unbox<int>(_size.height))
+        return;
+
+    // Same blending as the OpenGL renderer: (SRC_ALPHA, ONE_MINUS_SRC_ALPHA) for the colors,
+    // and (ONE, ONE_MINUS_SRC_ALPHA) for the alpha channel.
+    auto const offset = (static_cast<size_t>(y) * unbox<size_t>(_size.width)) + static_cast<size_t>(x);
+    auto* pixel = _frameBuffer.data() + (offset * 4);
+    auto const alpha = color[3];
+    for (size_t i = 0; i < 3; ++i)
+        pixel[i] = toByte((color[i] * alpha) + (toFloat(pixel[i]) * (1.f - alpha)));
+    pixel[3] = toByte(alpha + (toFloat(pixel[3]) * (1.f - alpha)));
+}
+
+void SoftwareRenderTarget::draw(FilledRect const& rect) noexcept
+{
+    auto const color = atlas::normalize(rect.color);
+    auto const left = std::max(rect.x, 0);
+    auto const top = std::max(rect.y, 0);
+    auto const right = std::min(rect.x + unbox<int>(rect.width), unbox<int>(_size.width));
+    auto const bottom = std::min(rect.y + unbox<int>(rect.height), unbox<int>(_size.height));
+    for (auto y = top; y < bottom; ++y)
+        for (auto x = left; x < right; ++x)
+            blend(x, y, color);
+}
+
+void SoftwareRenderTarget::draw(atlas::RenderTile const& tile) noexcept
+{
+    auto const& textureAtlas = _atlases[atlasIndexOf(tile.fragmentShaderSelector)];
+    auto const& configuration = textureAtlas.configuration;
+    auto const texelSize = element_count(configuration.properties.format);
+    auto const atlasWidth = unbox<size_t>(configuration.size.width);
+    auto const atlasHeight = unbox<size_t>(configuration.size.height);
+    if (textureAtlas.texels.empty() || tile.tileLocation.layer.value >= configuration.layerCount)
+        return;
+
+    auto const sourceWidth = unbox<int>(tile.bitmapSize.width);
+    auto const sourceHeight = unbox<int>(tile.bitmapSize.height);
+    auto const targetWidth = unbox(tile.targetSize.width) ? unbox<int>(tile.targetSize.width) : sourceWidth;
+    auto const targetHeight =
+        unbox(tile.targetSize.height) ? unbox<int>(tile.targetSize.height) : sourceHeight;
+    if (sourceWidth <= 0 || sourceHeight <= 0)
+        return;
+
+    auto const* layer = textureAtlas.texels.data()
+                        + size_t { tile.tileLocation.layer.value } * configuration.size.area() * texelSize;
+    for (auto y = 0; y < targetHeight; ++y)
+    {
+        auto const sourceY = tile.tileLocation.y.value + static_cast<size_t>(y * sourceHeight / targetHeight);
+        if (sourceY >= atlasHeight)
+            break;
+        for (auto x = 0; x < targetWidth; ++x)
+        {
+            auto const sourceX =
+                tile.tileLocation.x.value + static_cast<size_t>(x * sourceWidth / targetWidth);
+            if (sourceX >= atlasWidth)
+                break;
+            auto const* texel = layer + (((sourceY * atlasWidth) + sourceX) * texelSize);
+            auto const color = shadeTexel(tile.fragmentShaderSelector, texel, tile.color);
+            blend(tile.x.value + x, tile.y.value + y, color);
+        }
+    }
+}
+
+vector<uint8_t> encodePng(vector<uint8_t> const& rgbaBuffer, ImageSize size)
+{
+    auto const width = unbox<size_t>(size.width);
+    auto const height = unbox<size_t>(size.height);
+    auto const rowSize = width * 4;
+
+    auto header = vector<uint8_t> {};
+    appendBigEndian(header, static_cast<uint32_t>(width));
+    appendBigEndian(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bit RGBA, deflate, no interlacing
+
+    // Every row starts with the filter type, which is always none.
+    auto scanlines = vector<uint8_t> {};
+    scanlines.reserve(height * (rowSize + 1));
+    for (size_t row = 0; row < height && (row + 1) * rowSize <= rgbaBuffer.size(); ++row)
+    {
+        scanlines.push_back(0);
+        scanlines.insert(scanlines.end(),
+                         rgbaBuffer.begin() + static_cast<std::ptrdiff_t>(row * rowSize),
+                         rgbaBuffer.begin() + static_cast<std::ptrdiff_t>((row + 1) * rowSize));
+    }
+
+    auto output = vector<uint8_t> { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    appendChunk(output, "IHDR", header);
+    appendChunk(output, "IDAT", storeUncompressed(scanlines));
+    appendChunk(output, "IEND", {});
+    return output;
+}
+
+} // namespace vtrasterizer
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtrasterizer/RenderTarget.h>
+#include <vtrasterizer/TextureAtlas.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace vtrasterizer
+{
+
+/**
+ * Render target that rasterizes on the CPU into an RGBA frame buffer in memory,
+ * so that frames can be rendered without any window, GPU, or graphics API, e.g. for
+ * generating screenshots in batch.
+ *
+ * The texture atlases are kept in memory, too, and tiles are composited just like the
+ * text shader of the OpenGL renderer does, sampling them with nearest neighbour filtering.
+ *
+ * Every frame is repainted in full, starting with the clear color, as the render size of
+ * such targets is meant to be set once and contents are never replayed.
+ */
+class SoftwareRenderTarget final: public RenderTarget, public atlas::AtlasBackend
+{
+  public:
+    explicit SoftwareRenderTarget(ImageSize size, RGBAColor clearColor = RGBAColor {});
+
+    /// @returns the pixels of the most recently executed frame, as RGBA rows from top to bottom.
+    [[nodiscard]] std::vector<uint8_t> const& frameBuffer() const noexcept { return _frameBuffer; }
+    [[nodiscard]] ImageSize size() const noexcept { return _size; }
+
+    void setClearColor(RGBAColor color) noexcept { _clearColor = color; }
+
+    // AtlasBackend
+    void configureAtlas(atlas::ConfigureAtlas atlas) override;
+    void uploadTile(atlas::UploadTile tile) override;
+    void renderTile(atlas::RenderTile tile) override;
+
+    // RenderTarget
+    void setRenderSize(ImageSize size) override;
+    // The grid metrics of the renderer already account for the margin in all coordinates.
+    void setMargin(PageMargin /*margin*/) override {}
+    atlas::AtlasBackend& textureScheduler() override { return *this; }
+    void renderRectangle(int x, int y, Width width, Height height, RGBAColor color) override;
+    void scheduleScreenshot(ScreenshotCallback callback) override;
+    void retainContents() override {}
+    [[nodiscard]] bool replayContents() override { return false; }
+    void setDamage(FrameDamage const& /*damage*/) override {}
+    void execute(std::chrono::steady_clock::time_point now) override;
+    void clearCache() override {}
+    std::optional<AtlasTextureScreenshot> readAtlas() override;
+    void inspect(std::ostream& output) const override;
+
+  private:
+    struct Atlas
+    {
+        atlas::ConfigureAtlas configuration;
+        atlas::Buffer texels; // all layers, one after another
+    };
+
+    struct FilledRect
+    {
+        int x;
+        int y;
+        Width width;
+        Height height;
+        RGBAColor color;
+    };
+
+    /// Blends the given color with straight alpha onto the frame buffer's pixel at (x, y).
+    void blend(int x, int y, std::array<float, 4> color) noexcept;
+    void draw(FilledRect const& rect) noexcept;
+    void draw(atlas::RenderTile const& tile) noexcept;
+
+    ImageSize _size;
+    RGBAColor _clearColor;
+    std::array<Atlas, atlas::AtlasCount> _atlases {};
+    std::vector<FilledRect> _filledRects;
+    std::vector<atlas::RenderTile> _tiles;
+    std::vector<uint8_t> _frameBuffer;
+    std::optional<ScreenshotCallback> _pendingScreenshotCallback;
+};
+
+/// Encodes the given RGBA pixels, stored as rows from top to bottom, as PNG image.
+///
+/// The image data is stored without compression, so that no compression library is needed.
+[[nodiscard]] std::vector<uint8_t> encodePng(std::vector<uint8_t> const& rgbaBuffer, ImageSize size);
+
+} // namespace vtrasterizer
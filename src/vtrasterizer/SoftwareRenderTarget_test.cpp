@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/SoftwareRenderTarget.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace vtrasterizer;
+
+using vtbackend::Height;
+using vtbackend::ImageSize;
+using vtbackend::RGBAColor;
+using vtbackend::Width;
+
+namespace
+{
+
+auto const FrameSize = ImageSize { Width(4), Height(3) };
+
+std::array<uint8_t, 4> pixelAt(SoftwareRenderTarget const& target, size_t x, size_t y)
+{
+    auto const offset = ((y * unbox<size_t>(target.size().width)) + x) * 4;
+    auto const& frame = target.frameBuffer();
+    return { frame[offset], frame[offset + 1], frame[offset + 2], frame[offset + 3] };
+}
+
+atlas::ConfigureAtlas makeAtlas(atlas::Format format, size_t atlasIndex)
+{
+    auto const tileSize = ImageSize { Width(2), Height(2) };
+    return atlas::ConfigureAtlas {
+        .size = ImageSize { Width(4), Height(4) },
+        .layerCount = 1,
+        .properties = atlas::AtlasProperties { .format = format,
+                                               .tileSize = tileSize,
+                                               .hashCount = crispy::strong_hashtable_size { 8 },
+                                               .tileCount = crispy::lru_capacity { 4 },
+                                               .directMappingCount = 0,
+                                               .atlasIndex = static_cast<uint32_t>(atlasIndex) },
+    };
+}
+
+} // namespace
+
+TEST_CASE("SoftwareRenderTarget.rectangles")
+{
+    auto target = SoftwareRenderTarget(FrameSize, RGBAColor(0x10, 0x20, 0x30, 0xFF));
+    target.renderRectangle(1, 1, Width(10), Height(10), RGBAColor(0xFF, 0x00, 0x00, 0xFF));
+    target.renderRectangle(3, 0, Width(1), Height(1), RGBAColor(0xFF, 0xFF, 0xFF, 0x80));
+    target.execute(std::chrono::steady_clock::now());
+
+    CHECK(pixelAt(target, 0, 0) == std::array<uint8_t, 4> { 0x10, 0x20, 0x30, 0xFF });
+    CHECK(pixelAt(target, 1, 1) == std::array<uint8_t, 4> { 0xFF, 0x00, 0x00, 0xFF });
+    CHECK(pixelAt(target, 3, 2) == std::array<uint8_t, 4> { 0xFF, 0x00, 0x00, 0xFF });
+    CHECK(pixelAt(target, 3, 0) == std::array<uint8_t, 4> { 0x88, 0x90, 0x98, 0xFF });
+
+    // Every frame starts from the clear color.
+    target.execute(std::chrono::steady_clock::now());
+    CHECK(pixelAt(target, 1, 1) == std::array<uint8_t, 4> { 0x10, 0x20, 0x30, 0xFF });
+}
+
+TEST_CASE("SoftwareRenderTarget.tiles")
+{
+    auto target = SoftwareRenderTarget(FrameSize);
+    auto const atlasIndex = atlasIndexOf(FRAGMENT_SELECTOR_GLYPH_ALPHA);
+    target.configureAtlas(makeAtlas(atlas::Format::Red, atlasIndex));
+
+    // A 2x2 alpha mask, with rows padded to 4 bytes.
+    target.uploadTile(atlas::UploadTile {
+        .location = atlas::TileLocation { atlas::TileLocation::X { 2 }, atlas::TileLocation::Y { 2 } },
+        .bitmap = atlas::Buffer { 0xFF, 0x00, 0, 0, 0x00, 0xFF, 0, 0 },
+        .bitmapSize = ImageSize { Width(2), Height(2) },
+        .bitmapFormat = atlas::Format::Red,
+        .rowAlignment = 4,
+        .atlasIndex = static_cast<uint32_t>(atlasIndex),
+    });
+
+    auto tile = atlas::RenderTile {};
+    tile.x = atlas::RenderTile::X { 1 };
+    tile.y = atlas::RenderTile::Y { 0 };
+    tile.bitmapSize = ImageSize { Width(2), Height(2) };
+    tile.targetSize = ImageSize { Width(2), Height(2) };
+    tile.color = atlas::normalize(RGBAColor(0x00, 0xFF, 0x00, 0xFF));
+    tile.tileLocation = atlas::TileLocation { atlas::TileLocation::X { 2 }, atlas::TileLocation::Y { 2 } };
+    tile.fragmentShaderSelector = FRAGMENT_SELECTOR_GLYPH_ALPHA;
+    target.renderTile(tile);
+
+    auto screenshotSize = ImageSize {};
+    target.scheduleScreenshot(
+        [&](std::vector<uint8_t> const& /*rgbaBuffer*/, ImageSize size) { screenshotSize = size; });
+    target.execute(std::chrono::steady_clock::now());
+
+    CHECK(screenshotSize == FrameSize);
+    CHECK(pixelAt(target, 1, 0) == std::array<uint8_t, 4> { 0x00, 0xFF, 0x00, 0xFF });
+    CHECK(pixelAt(target, 2, 0) == std::array<uint8_t, 4> { 0x00, 0x00, 0x00, 0x00 });
+    CHECK(pixelAt(target, 2, 1) == std::array<uint8_t, 4> { 0x00, 0xFF, 0x00, 0xFF });
+    CHECK(pixelAt(target, 0, 0) == std::array<uint8_t, 4> { 0x00, 0x00, 0x00, 0x00 });
+}
+
+TEST_CASE("SoftwareRenderTarget.encodePng")
+{
+    auto const size = ImageSize { Width(2), Height(1) };
+    auto const png = encodePng(std::vector<uint8_t> { 1, 2, 3, 4, 5, 6, 7, 8 }, size);
+
+    // Signature, IHDR, a single uncompressed IDAT block of 2 * 4 + 1 bytes, and IEND.
+    REQUIRE(png.size() == 8 + (12 + 13) + (12 + 2 + 5 + 9 + 4) + 12);
+    CHECK(std::vector<uint8_t>(png.begin(), png.begin() + 8)
+          == std::vector<uint8_t> { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' });
+    CHECK(png[19] == 2); // width
+    CHECK(png[23] == 1); // height
+    CHECK(std::vector<uint8_t>(png.end() - 4, png.end()) == std::vector<uint8_t> { 0xAE, 0x42, 0x60, 0x82 });
+}
@@ -3,6 +3,7 @@
 
 #include <libunicode/utf8_grapheme_segmenter.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace vtrasterizer
@@ -19,6 +20,11 @@ namespace
                 return 2;
         return baseWidth;
     }
+
+    bool isPrintableAscii(std::string_view text) noexcept
+    {
+        return std::all_of(text.begin(), text.end(), [](char ch) { return ch >= 0x20 && ch <= 0x7E; });
+    }
 } // namespace
 
 TextClusterGrouper::TextClusterGrouper(Events& events): _events { events }
@@ -43,11 +49,30 @@ void TextClusterGrouper::renderLine(std::string_view text,
     if (text.empty())
         return;
 
-    auto graphemeClusterSegmenter = unicode::utf8_grapheme_segmenter(text);
     auto columnOffset = vtbackend::ColumnOffset(0);
 
     _initialPenPosition = vtbackend::CellLocation { .line = lineOffset, .column = columnOffset };
 
+    if (isPrintableAscii(text))
+    {
+        // Fast path: Each US-ASCII character is a grapheme cluster of its own, occupying a single cell.
+        for (char const ch: text)
+        {
+            auto const codepoint = static_cast<char32_t>(ch);
+            renderCell(vtbackend::CellLocation { .line = lineOffset, .column = columnOffset },
+                       std::u32string_view(&codepoint, 1),
+                       style,
+                       foregroundColor);
+            ++columnOffset;
+        }
+
+        if (!_codepoints.empty())
+            flushTextClusterGroup();
+        return;
+    }
+
+    auto graphemeClusterSegmenter = unicode::utf8_grapheme_segmenter(text);
+
     for (auto const& graphemeCluster: graphemeClusterSegmenter)
     {
         auto const gridPosition = vtbackend::CellLocation { .line = lineOffset, .column = columnOffset };
@@ -117,6 +142,7 @@ void TextClusterGrouper::appendCellTextToClusterGroup(std::u32string_view codepo
         for (char32_t const codepoint: codepoints)
         {
             _codepoints.emplace_back(codepoint);
+            _textHash.add(static_cast<uint32_t>(codepoint));
             _clusters.emplace_back(_cellCount);
         }
         _cellCount++;
@@ -133,6 +159,7 @@ void TextClusterGrouper::flushTextClusterGroup()
     if (!_codepoints.empty())
     {
         _events.renderTextGroup(std::u32string_view(_codepoints.data(), _codepoints.size()),
+                                _textHash.finish(),
                                 gsl::span(_clusters.data(), _clusters.size()),
                                 _initialPenPosition,
                                 _style,
@@ -8,6 +8,8 @@
 #include <vtrasterizer/BoxDrawingRenderer.h>
 #include <vtrasterizer/FontDescriptions.h>
 
+#include <crispy/StrongHash.h>
+
 #include <gsl/span>
 #include <gsl/span_ext>
 
@@ -18,6 +20,10 @@ namespace vtrasterizer
 
 /// This class is responsible for grouping the text to be rendered
 /// into clusters of codepoints that share the same text style and color.
+///
+/// Groups also end at blank cells, so that each group is a whitespace-delimited word, and
+/// text shaping results, which are cached by the hash of the group's text and style, are
+/// reused wherever the same word is rendered, independent of its position in the line.
 class TextClusterGrouper
 {
   public:
@@ -25,7 +31,9 @@ class TextClusterGrouper
     {
         virtual ~Events() = default;
 
+        /// @param textHash hash over @p codepoints, as computed by crispy::strong_hash_builder.
         virtual void renderTextGroup(std::u32string_view codepoints,
+                                     crispy::strong_hash textHash,
                                      gsl::span<unsigned> clusters,
                                      vtbackend::CellLocation initialPenPosition,
                                      TextStyle style,
@@ -44,10 +52,6 @@ class TextClusterGrouper
     void forceGroupStart() noexcept { _forceUpdateInitialPenPosition = true; }
     void forceGroupEnd() { flushTextClusterGroup(); }
 
-    /// Renders a given terminal's grid cell that has been
-    /// transformed into a RenderCell.
-    void renderCell(vtbackend::RenderCell const& cell);
-
     void renderCell(vtbackend::CellLocation position,
                     std::u32string_view graphemeCluster,
                     TextStyle style,
@@ -73,6 +77,7 @@ class TextClusterGrouper
     void resetAndMovePenForward(vtbackend::ColumnOffset penIncrementInX) noexcept
     {
         _codepoints.clear();
+        _textHash.reset();
         _clusters.clear();
         _cellCount = 0;
         _initialPenPosition.column += penIncrementInX;
@@ -93,6 +98,9 @@ class TextClusterGrouper
     // uniform unicode properties (script, language, direction).
     std::vector<char32_t> _codepoints;
 
+    // hash over the codepoints, computed while they are appended
+    crispy::strong_hash_builder _textHash;
+
     // cluster indices for each codepoint
     std::vector<unsigned> _clusters;
 
@@ -157,11 +157,13 @@ struct EventRecorder final: public TextClusterGrouper::Events
     std::vector<Event> events;
 
     void renderTextGroup(std::u32string_view codepoints,
+                         crispy::strong_hash textHash,
                          gsl::span<unsigned> clusters,
                          vtbackend::CellLocation initialPenPosition,
                          TextStyle style,
                          vtbackend::RGBColor color) override
     {
+        CHECK(textHash == crispy::strong_hash_builder {}.add(codepoints).finish());
         events.emplace_back(TextClusterGroup { .codepoints = std::u32string(codepoints),
                                                .clusters = to_vector<int>(clusters),
                                                .initialPenPosition = initialPenPosition,
@@ -260,6 +262,40 @@ TEST_CASE("TextClusterGrouper.renderLine.DoubleWhitespace")
     CHECK(clusterGroup2.color == RGBColor { 0xF0, 0x80, 0x40 });
 }
 
+TEST_CASE("TextClusterGrouper.renderLine.NonAscii")
+{
+    // Lines that are not plain US-ASCII are segmented into grapheme clusters,
+    // advancing the pen position by their display width.
+
+    auto recorder = EventRecorder {};
+    auto grouper = TextClusterGrouper(recorder);
+
+    grouper.beginFrame();
+    grouper.renderLine("\xE6\x97\xA5\xE6\x9C\xAC a\xCC\x88!", LineOffset(1), 0x102030_rgb, TextStyle::Bold);
+    grouper.endFrame();
+
+    REQUIRE(recorder.events.size() == 3);
+
+    CHECK(std::get<TextClusterGroup>(recorder.events[0])
+          == TextClusterGroup { .codepoints = U"\u65E5",
+                                .clusters = { 0 },
+                                .initialPenPosition = CellLocation { LineOffset(1), ColumnOffset(0) },
+                                .style = TextStyle::Bold,
+                                .color = 0x102030_rgb });
+    CHECK(std::get<TextClusterGroup>(recorder.events[1])
+          == TextClusterGroup { .codepoints = U"\u672C",
+                                .clusters = { 0 },
+                                .initialPenPosition = CellLocation { LineOffset(1), ColumnOffset(2) },
+                                .style = TextStyle::Bold,
+                                .color = 0x102030_rgb });
+    CHECK(std::get<TextClusterGroup>(recorder.events[2])
+          == TextClusterGroup { .codepoints = U"a\u0308!",
+                                .clusters = { 0, 0, 1 },
+                                .initialPenPosition = CellLocation { LineOffset(1), ColumnOffset(5) },
+                                .style = TextStyle::Bold,
+                                .color = 0x102030_rgb });
+}
+
 TEST_CASE("TextClusterGrouper.SplitAtColorChange")
 {
     auto recorder = EventRecorder {};
@@ -284,3 +320,33 @@ TEST_CASE("TextClusterGrouper.SplitAtColorChange")
                                 .style = TextStyle::Bold,
                                 .color = 0x405060_rgb });
 }
+
+TEST_CASE("TextClusterGrouper.WordsKeepTheirGroupWhenShifted")
+{
+    // Text groups end at blank cells, so that the shaping results cached per group are those of
+    // the words of a line. Typing into one word leaves the groups of the others as they were.
+    auto const render = [](std::string_view line) {
+        auto recorder = EventRecorder {};
+        auto grouper = TextClusterGrouper(recorder);
+        grouper.beginFrame();
+        grouper.renderLine(line, LineOffset(0), 0x102030_rgb, TextStyle::Regular);
+        grouper.endFrame();
+        return recorder.events;
+    };
+
+    auto const before = render("if (a != b) return;");
+    auto const after = render("if (ab != b) return;");
+    REQUIRE(before.size() == 5);
+    REQUIRE(after.size() == 5);
+
+    for (auto const i: { 0u, 2u, 3u, 4u })
+    {
+        INFO("group: " << i);
+        auto const& word = std::get<TextClusterGroup>(before[i]);
+        auto const& shifted = std::get<TextClusterGroup>(after[i]);
+        CHECK(word.codepoints == shifted.codepoints);
+        CHECK(word.clusters == shifted.clusters);
+        CHECK(word.initialPenPosition.column + (i ? 1 : 0) == shifted.initialPenPosition.column);
+    }
+    CHECK(std::get<TextClusterGroup>(after[1]).codepoints == U"(ab"sv);
+}
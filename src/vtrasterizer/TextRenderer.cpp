@@ -39,6 +39,9 @@
 
 ### Dealing with wide glyphs
 
+Glyphs of up to two (or four) cells in width are stored in a single wide (or extra wide) tile,
+which is looked up after the narrow tiles.
+
 When calling getOrCreateRasterizedMetadata(), we will know
 whether the glyph fits the grid or if we need to start iterating over
 N (or N minus 1) following tiles to complete the draw.
@@ -135,8 +138,10 @@ Making use of reserved glyph slots
 #endif
 
 #include <crispy/algorithm.h>
+#include <crispy/allocations.h>
 #include <crispy/assert.h>
 #include <crispy/range.h>
+#include <crispy/tracing.h>
 
 #include <libunicode/convert.h>
 #include <libunicode/utf8_grapheme_segmenter.h>
@@ -145,6 +150,7 @@ Making use of reserved glyph slots
 #include <range/v3/view/enumerate.hpp>
 
 #include <algorithm>
+#include <utility>
 
 using crispy::point;
 using crispy::strong_hash;
@@ -178,7 +184,14 @@ namespace
 {
     constexpr auto FirstReservedChar = char32_t { 0x21 };
     constexpr auto LastReservedChar = char32_t { 0x7E };
-    constexpr auto DirectMappedCharsCount = LastReservedChar - FirstReservedChar + 1;
+    constexpr auto DirectMappedCharsPerStyle = LastReservedChar - FirstReservedChar + 1;
+    constexpr auto DirectMappedCharsCount =
+        DirectMappedCharsPerStyle * TextRenderer::DirectMappedStyleCount;
+
+    // Text styles whose US-ASCII glyphs are direct-mapped, in the order of their slots.
+    constexpr auto DirectMappedStyles = array<TextStyle, TextRenderer::DirectMappedStyleCount> {
+        TextStyle::Regular, TextStyle::Bold, TextStyle::Italic, TextStyle::BoldItalic
+    };
 
     strong_hash hashGlyphKeyAndPresentation(text::glyph_key const& glyphKey,
                                             unicode::PresentationStyle presentation) noexcept
@@ -193,11 +206,6 @@ namespace
         // clang-format on
     }
 
-    strong_hash hashTextAndStyle(u32string_view text, TextStyle style) noexcept
-    {
-        return strong_hash::compute(text) * static_cast<uint32_t>(style);
-    }
-
     text::font_key getFontForStyle(FontKeys const& fonts, TextStyle style)
     {
         switch (style)
@@ -250,12 +258,15 @@ namespace
     }
 } // namespace
 
-text::font_locator& createFontLocator(FontLocatorEngine engine)
+text::font_locator& createFontLocator(FontLocatorEngine engine, std::filesystem::path const& cacheDirectory)
 {
     switch (engine)
     {
         case FontLocatorEngine::Mock: return text::font_locator_provider::get().mock();
-        default: return text::font_locator_provider::get().native();
+        default:
+            if (!cacheDirectory.empty())
+                text::font_locator_provider::get().set_cache_directory(cacheDirectory);
+            return text::font_locator_provider::get().native();
     }
 
     crispy::unreachable();
@@ -287,6 +298,14 @@ void TextRenderer::inspect(ostream& textOutput) const
 {
     textOutput << "TextRenderer:\n";
     _textShapingCache->inspect(textOutput);
+    if (_glyphDiskCache)
+        textOutput << std::format("Glyph disk cache: {} ({} records loaded)\n",
+                                  _glyphDiskCache->filePath().string(),
+                                  _glyphDiskCache->loadedRecordCount());
+    if (_sharedGlyphCache)
+        textOutput << std::format("Shared glyph cache: {} records, {} renderers\n",
+                                  _sharedGlyphCache->size(),
+                                  _sharedGlyphCache.use_count());
     _boxDrawingRenderer.inspect(textOutput);
 }
 
@@ -299,18 +318,128 @@ void TextRenderer::setRenderTarget(
     clearCache();
 }
 
-void TextRenderer::setTextureAtlas(TextureAtlas& atlas)
+void TextRenderer::setTextureAtlases(TextureAtlases atlases)
 {
-    Renderable::setTextureAtlas(atlas);
-    _boxDrawingRenderer.setTextureAtlas(atlas);
+    Renderable::setTextureAtlases(atlases);
+    _boxDrawingRenderer.setTextureAtlases(atlases);
 
     if (_directMapping)
         initializeDirectMapping();
 }
 
+void TextRenderer::setGlyphCacheDirectory(std::filesystem::path directory)
+{
+    _glyphCacheDirectory = std::move(directory);
+    updateGlyphCaches();
+}
+
+void TextRenderer::updateGlyphCaches()
+{
+    _fontSlots = GlyphDiskCache::FontSlots {
+        _fonts.regular, _fonts.bold, _fonts.italic, _fonts.boldItalic, _fonts.emoji,
+    };
+
+    auto sources = vector<text::font_source> {};
+    for (text::font_key const font: _fontSlots)
+    {
+        auto source = _textShaper.source(font);
+        if (!source)
+        {
+            // Without knowing where a font comes from, cache entries cannot be told apart.
+            _sharedGlyphCache.reset();
+            _recentGlyphCaches.clear();
+            _glyphDiskCache.reset();
+            return;
+        }
+        sources.emplace_back(std::move(*source));
+    }
+
+    auto const fingerprint = GlyphDiskCache::fingerprint(_fontDescriptions, sources);
+    if (!_sharedGlyphCache || _sharedGlyphCache->fingerprint() != fingerprint)
+    {
+        // The caches of recently left font configurations are still alive, and hence acquired again.
+        auto previous = std::exchange(_sharedGlyphCache, SharedGlyphCache::acquire(fingerprint));
+        _recentGlyphCaches.retain(std::move(previous), fingerprint);
+    }
+
+    if (_glyphCacheDirectory.empty())
+    {
+        _glyphDiskCache.reset();
+        return;
+    }
+
+    if (_glyphDiskCache && _glyphDiskCache->fingerprint() == fingerprint)
+        return;
+
+    _glyphDiskCache.reset();
+    _glyphDiskCache = GlyphDiskCache::open(_glyphCacheDirectory, fingerprint, _fontSlots);
+}
+
+optional<text::rasterized_glyph> TextRenderer::cachedRasterizedGlyph(text::glyph_key const& glyphKey)
+{
+    if (_sharedGlyphCache)
+        if (auto glyph = _sharedGlyphCache->rasterizedGlyph(_fontSlots, glyphKey))
+            return glyph;
+
+    if (!_glyphDiskCache)
+        return nullopt;
+
+    auto glyph = _glyphDiskCache->rasterizedGlyph(glyphKey);
+    if (glyph && _sharedGlyphCache)
+        _sharedGlyphCache->storeRasterizedGlyph(_fontSlots, glyphKey, *glyph);
+    return glyph;
+}
+
+void TextRenderer::storeRasterizedGlyph(text::glyph_key const& glyphKey, text::rasterized_glyph const& glyph)
+{
+    if (_sharedGlyphCache)
+        _sharedGlyphCache->storeRasterizedGlyph(_fontSlots, glyphKey, glyph);
+    if (_glyphDiskCache)
+        _glyphDiskCache->storeRasterizedGlyph(glyphKey, glyph);
+}
+
+void TextRenderer::enableAsyncRasterization(std::function<void()> glyphsRasterized)
+{
+    _asyncRasterizer = make_unique<AsyncGlyphRasterizer>(
+        [this](std::vector<text::glyph_key> const& glyphKeys) {
+            return _textShaper.rasterize_many(glyphKeys, _fontDescriptions.renderMode);
+        },
+        std::move(glyphsRasterized));
+}
+
+void TextRenderer::discardPendingRasterization()
+{
+    if (_asyncRasterizer)
+        _asyncRasterizer->cancel();
+}
+
+std::unique_lock<std::mutex> TextRenderer::lockShaper()
+{
+    if (_asyncRasterizer)
+        return _asyncRasterizer->lockShaper();
+    return {};
+}
+
+void TextRenderer::uploadAsyncRasterizedGlyphs()
+{
+    if (!_asyncRasterizer || !hasTextureAtlases())
+        return;
+
+    for (auto& result: _asyncRasterizer->takeResults())
+    {
+        storeRasterizedGlyph(result.glyph, result.bitmap);
+
+        [[maybe_unused]] auto const* attributes =
+            emplaceRasterizedGlyph(result.hash, std::move(result.bitmap), result.presentation);
+    }
+}
+
 void TextRenderer::clearCache()
 {
-    if (_textureAtlas && _directMapping)
+    discardPendingRasterization();
+    updateGlyphCaches();
+
+    if (hasTextureAtlases() && _directMapping)
         initializeDirectMapping();
 
     _textShapingCache->clear();
@@ -318,9 +447,15 @@ void TextRenderer::clearCache()
     _boxDrawingRenderer.clearCache();
 }
 
+void TextRenderer::releaseRecentGlyphCaches() noexcept
+{
+    _recentGlyphCaches.clear();
+}
+
 void TextRenderer::restrictToTileSize(TextureAtlas::TileCreateData& tileCreateData)
 {
-    if (tileCreateData.bitmapSize.width <= _textureAtlas->tileSize().width)
+    auto& glyphAtlas = textureAtlas(tileCreateData.bitmapFormat);
+    if (tileCreateData.bitmapSize.width <= glyphAtlas.tileSize().width)
         return;
     // Shrink the image's width by recreating it.
     // TODO: In the longer term it would be nice to simply touch the pitch value in order to shrink.
@@ -328,7 +463,7 @@ void TextRenderer::restrictToTileSize(TextureAtlas::TileCreateData& tileCreateDa
 
     auto const colorComponentCount = atlas::element_count(tileCreateData.bitmapFormat);
 
-    auto const targetSize = ImageSize { _textureAtlas->tileSize().width, tileCreateData.bitmapSize.height };
+    auto const targetSize = ImageSize { glyphAtlas.tileSize().width, tileCreateData.bitmapSize.height };
     auto const targetPitch = unbox<uintptr_t>(targetSize.width) * colorComponentCount;
     auto const sourcePitch = unbox<uintptr_t>(tileCreateData.bitmapSize.width) * colorComponentCount;
 
@@ -357,53 +492,149 @@ void TextRenderer::restrictToTileSize(TextureAtlas::TileCreateData& tileCreateDa
     tileCreateData.bitmap = std::move(slicedBitmap);
 
     // NB: Also adjust the normalized width to not render the empty space.
-    auto const atlasSize = _textureScheduler->atlasSize();
+    auto const atlasSize = glyphAtlas.atlasSize();
     tileCreateData.metadata.normalizedLocation.width =
         unbox<float>(tileCreateData.bitmapSize.width) / unbox<float>(atlasSize.width);
 }
 
 void TextRenderer::initializeDirectMapping()
 {
-    Require(_textureAtlas);
+    Require(hasTextureAtlases());
     Require(_directMapping.count == DirectMappedCharsCount);
 
-    _directMappedGlyphKeyToTileIndex.clear();
-    _directMappedGlyphKeyToTileIndex.resize(LastReservedChar + 1);
+    // A glyph's tile may end up in the atlas of another format than before,
+    // e.g. after changing the render mode.
+    for (uint32_t slot = 0; slot < _directMapping.count; ++slot)
+        for (auto const format: atlas::Formats)
+            textureAtlas(format).clearDirectMapping(_directMapping.toTileIndex(slot));
+
+    for (size_t styleIndex = 0; styleIndex < DirectMappedStyleCount; ++styleIndex)
+    {
+        auto const font = getFontForStyle(_fonts, DirectMappedStyles[styleIndex]);
+        auto& glyphKeyToTileIndex = _directMappedGlyphKeyToTileIndex[styleIndex];
+        auto& asciiGlyphs = _directMappedAsciiGlyphs[styleIndex];
+        _directMappedFonts[styleIndex] = font;
+        glyphKeyToTileIndex.clear();
+        asciiGlyphs.clear();
+
+        // Styles without a font of their own share the slots of the style they fall back to.
+        auto const previousFonts = gsl::span(_directMappedFonts).first(styleIndex);
+        auto const previousFont = std::find(previousFonts.begin(), previousFonts.end(), font);
+        if (previousFont != previousFonts.end())
+        {
+            asciiGlyphs = _directMappedAsciiGlyphs[static_cast<size_t>(previousFont - previousFonts.begin())];
+            continue;
+        }
+
+        glyphKeyToTileIndex.resize(LastReservedChar + 1);
+
+        auto const hasLigatures = [&]() {
+            auto const shaperLock = lockShaper();
+            return _textShaper.has_ligatures(font);
+        }();
+        if (!hasLigatures)
+            asciiGlyphs.reserve(DirectMappedCharsPerStyle);
+
+        for (char32_t codepoint = FirstReservedChar; codepoint <= LastReservedChar; ++codepoint)
+        {
+            auto gposOpt = [&]() {
+                auto const shaperLock = lockShaper();
+                return _textShaper.shape(font, codepoint);
+            }();
+            if (gposOpt)
+            {
+                text::glyph_key const& glyph = gposOpt.value().glyph;
+                if (glyph.index.value >= glyphKeyToTileIndex.size())
+                    glyphKeyToTileIndex.resize(glyph.index.value + (LastReservedChar - codepoint + 1));
+                auto const slot = (styleIndex * DirectMappedCharsPerStyle) + codepoint - FirstReservedChar;
+                auto const tileIndex = _directMapping.toTileIndex(static_cast<uint32_t>(slot));
+                glyphKeyToTileIndex[glyph.index.value] = tileIndex;
+
+                // Rasterize upfront, so that rendering these glyphs never needs to touch the tile cache.
+                rasterizeDirectMapped(tileIndex, glyph);
+
+                if (!hasLigatures)
+                    asciiGlyphs.emplace_back(*gposOpt);
+            }
+        }
+
+        // Text shaping is still needed if any character is missing from the font and thus falls back.
+        if (asciiGlyphs.size() != DirectMappedCharsPerStyle
+            || std::any_of(asciiGlyphs.begin(), asciiGlyphs.end(), [&](text::glyph_position const& gpos) {
+                   return gpos.glyph.font != font;
+               }))
+            asciiGlyphs.clear();
+    }
+}
+
+bool TextRenderer::tryRenderAsciiTextGroup(std::u32string_view codepoints,
+                                           vtbackend::CellLocation initialPenPosition,
+                                           TextStyle style,
+                                           vtbackend::RGBColor color)
+{
+    auto const styleIndex = static_cast<size_t>(
+        std::find(DirectMappedStyles.begin(), DirectMappedStyles.end(), style) - DirectMappedStyles.begin());
+    if (styleIndex >= DirectMappedStyleCount)
+        return false;
 
-    for (char32_t codepoint = FirstReservedChar; codepoint <= LastReservedChar; ++codepoint)
+    auto const& asciiGlyphs = _directMappedAsciiGlyphs[styleIndex];
+    if (asciiGlyphs.empty())
+        return false;
+
+    auto const isAscii = std::all_of(codepoints.begin(), codepoints.end(), [](char32_t codepoint) {
+        return FirstReservedChar <= codepoint && codepoint <= LastReservedChar;
+    });
+    if (!isAscii)
+        return false;
+
+    crispy::point pen = _gridMetrics.mapBottomLeft(initialPenPosition);
+    for (char32_t const codepoint: codepoints)
     {
-        if (optional<text::glyph_position> gposOpt = _textShaper.shape(_fonts.regular, codepoint))
+        text::glyph_position const& glyphPosition = asciiGlyphs[codepoint - FirstReservedChar];
+        if (auto const* attributes = ensureRasterizedIfDirectMapped(glyphPosition.glyph))
         {
-            text::glyph_key const& glyph = gposOpt.value().glyph;
-            if (glyph.index.value >= _directMappedGlyphKeyToTileIndex.size())
-                _directMappedGlyphKeyToTileIndex.resize(glyph.index.value
-                                                        + (LastReservedChar - codepoint + 1));
-            _directMappedGlyphKeyToTileIndex[glyph.index.value] =
-                _directMapping.toTileIndex(codepoint - FirstReservedChar);
+            auto const pen1 = applyGlyphPositionToPen(pen, *attributes, glyphPosition);
+            renderRasterizedGlyph(pen1, color, *attributes);
         }
+        pen.x += unbox<decltype(pen.x)>(_gridMetrics.cellSize.width);
     }
+
+    return true;
 }
 
 Renderable::AtlasTileAttributes const* TextRenderer::ensureRasterizedIfDirectMapped(
     text::glyph_key const& glyph)
 {
-    if (!isGlyphDirectMapped(glyph))
+    auto const tileIndex = directMappedTileIndex(glyph);
+    if (!tileIndex)
         return nullptr;
 
-    auto const tileIndex = _directMappedGlyphKeyToTileIndex[glyph.index.value];
+    // The glyph's tile is in the atlas of its bitmap format, which is most likely the first one.
+    for (auto const format: atlas::Formats)
+        if (textureAtlas(format).directMapped(tileIndex).bitmapSize.width.value)
+            // TODO: Find a better way to test if the glyph was rasterized&uploaded already.
+            // like: if (atlas.isDirectMappingSet(tileIndex)) ...
+            return &textureAtlas(format).directMapped(tileIndex);
 
-    if (_textureAtlas->directMapped(tileIndex).bitmapSize.width.value)
-        // TODO: Find a better way to test if the glyph was rasterized&uploaded already.
-        // like: if (_textureAtlas->isDirectMappingSet(tileIndex)) ...
-        return &_textureAtlas->directMapped(tileIndex);
+    return rasterizeDirectMapped(tileIndex, glyph);
+}
+
+Renderable::AtlasTileAttributes const* TextRenderer::rasterizeDirectMapped(uint32_t tileIndex,
+                                                                           text::glyph_key const& glyph)
+{
+    auto bitmap = rasterizeGlyph(glyph);
+    if (!bitmap)
+        return nullptr;
 
-    auto const tileLocation = _textureAtlas->tileLocation(tileIndex);
-    auto tileCreateData = createRasterizedGlyph(tileLocation, glyph, unicode::PresentationStyle::Text);
+    auto& glyphAtlas = textureAtlas(toAtlasFormat(bitmap->format));
+    auto const tileLocation = glyphAtlas.tileLocation(tileIndex);
+    auto tileCreateData = createRasterizedGlyph(
+        tileLocation, prepareRasterizedGlyph(std::move(*bitmap), unicode::PresentationStyle::Text));
     if (!tileCreateData)
         return nullptr;
 
     restrictToTileSize(*tileCreateData);
-    Require(tileCreateData->bitmapSize.width <= textureAtlas().tileSize().width);
+    Require(tileCreateData->bitmapSize.width <= glyphAtlas.tileSize().width);
 
     // std::cout << std::format("Initialize direct mapping {} ({}) for {}; {}; {}\n",
     //            tileIndex,
@@ -412,8 +643,8 @@ Renderable::AtlasTileAttributes const* TextRenderer::ensureRasterizedIfDirectMap
     //            tileCreateData->bitmapSize,
     //            tileCreateData->metadata);
 
-    _textureAtlas->setDirectMapping(tileIndex, std::move(*tileCreateData));
-    return &_textureAtlas->directMapped(tileIndex);
+    glyphAtlas.setDirectMapping(tileIndex, std::move(*tileCreateData));
+    return &glyphAtlas.directMapped(tileIndex);
 }
 
 void TextRenderer::updateFontMetrics()
@@ -426,36 +657,44 @@ void TextRenderer::updateFontMetrics()
 
 void TextRenderer::beginFrame()
 {
+    CRISPY_ALLOCATION_SCOPE(textRendererAllocations);
+    uploadAsyncRasterizedGlyphs();
+    _glyphsLeftOut = false;
     _textClusterGrouper.beginFrame();
 }
 
 void TextRenderer::renderLine(vtbackend::RenderLine const& renderLine)
 {
+    CRISPY_ALLOCATION_SCOPE(textRendererAllocations);
     _textClusterGrouper.renderLine(renderLine.text,
                                    renderLine.lineOffset,
                                    renderLine.textAttributes.foregroundColor,
                                    makeTextStyle(renderLine.textAttributes.flags));
 }
 
-void TextRenderer::renderCell(vtbackend::RenderCell const& cell)
+void TextRenderer::renderCells(vtbackend::RenderCells const& cells)
 {
-    // std::cout << std::format("renderCell: {} {} {} {} {}\n",
-    //            cell.position,
-    //            unicode::convert_to<char>(u32string_view(cell.codepoints)),
-    //            _forceUpdateInitialPenPosition ? "forcedRestart" : "-",
-    //            cell.groupStart ? "groupStart" : "-",
-    //            cell.groupEnd ? "groupEnd" : "-");
-
-    if (cell.groupStart)
-        _textClusterGrouper.forceGroupStart();
-
-    _textClusterGrouper.renderCell(cell.position,
-                                   cell.codepoints,
-                                   makeTextStyle(cell.attributes.flags),
-                                   cell.attributes.foregroundColor);
-
-    if (cell.groupEnd)
-        _textClusterGrouper.forceGroupEnd();
+    CRISPY_ALLOCATION_SCOPE(textRendererAllocations);
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        // std::cout << std::format("renderCell: {} {} {} {} {}\n",
+        //            cells.positions[i],
+        //            unicode::convert_to<char>(cells.codepoints(i)),
+        //            _forceUpdateInitialPenPosition ? "forcedRestart" : "-",
+        //            cells.isGroupStart(i) ? "groupStart" : "-",
+        //            cells.isGroupEnd(i) ? "groupEnd" : "-");
+
+        if (cells.isGroupStart(i))
+            _textClusterGrouper.forceGroupStart();
+
+        _textClusterGrouper.renderCell(cells.positions[i],
+                                       cells.codepoints(i),
+                                       makeTextStyle(cells.attributes[i].flags),
+                                       cells.attributes[i].foregroundColor);
+
+        if (cells.isGroupEnd(i))
+            _textClusterGrouper.forceGroupEnd();
+    }
 }
 
 void TextRenderer::renderCell(vtbackend::CellLocation position,
@@ -463,11 +702,13 @@ void TextRenderer::renderCell(vtbackend::CellLocation position,
                               TextStyle textStyle,
                               vtbackend::RGBColor foregroundColor)
 {
+    CRISPY_ALLOCATION_SCOPE(textRendererAllocations);
     _textClusterGrouper.renderCell(position, graphemeCluster, textStyle, foregroundColor);
 }
 
 void TextRenderer::endFrame()
 {
+    CRISPY_ALLOCATION_SCOPE(textRendererAllocations);
     _textClusterGrouper.endFrame();
 }
 
@@ -544,6 +785,7 @@ bool TextRenderer::renderBoxDrawingCell(vtbackend::CellLocation position,
 }
 
 void TextRenderer::renderTextGroup(std::u32string_view codepoints,
+                                   strong_hash textHash,
                                    gsl::span<unsigned> clusters,
                                    vtbackend::CellLocation initialPenPosition,
                                    TextStyle style,
@@ -552,12 +794,16 @@ void TextRenderer::renderTextGroup(std::u32string_view codepoints,
     if (codepoints.empty())
         return;
 
+    CRISPY_TRACE_ZONE("renderTextGroup", "render");
     _textRendererEvents.onBeforeRenderingText();
     auto _ = crispy::finally { [&]() noexcept {
         _textRendererEvents.onAfterRenderingText();
     } };
 
-    auto const hash = hashTextAndStyle(codepoints, style);
+    if (tryRenderAsciiTextGroup(codepoints, initialPenPosition, style, color))
+        return;
+
+    auto const hash = textHash * static_cast<uint32_t>(style);
     text::shape_result const& glyphPositions =
         getOrCreateCachedGlyphPositions(hash, codepoints, clusters, style);
     crispy::point pen = _gridMetrics.mapBottomLeft(initialPenPosition);
@@ -582,14 +828,15 @@ void TextRenderer::renderTextGroup(std::u32string_view codepoints,
             auto const pen1 = applyGlyphPositionToPen(pen, *attributes, glyphPosition);
             renderRasterizedGlyph(pen1, color, *attributes);
 
-            auto xOffset = unbox(textureAtlas().tileSize().width);
-            while (AtlasTileAttributes const* subAttribs = textureAtlas().try_get(hash * xOffset))
+            auto& glyphAtlas = textureAtlas(atlasFormatOf(attributes->metadata.fragmentShaderSelector));
+            auto xOffset = unbox(glyphAtlas.tileSize().width);
+            while (AtlasTileAttributes const* subAttribs = glyphAtlas.try_get(hash * xOffset))
             {
                 renderTile(atlas::RenderTile::X { pen1.x + int(xOffset) },
                            atlas::RenderTile::Y { pen1.y },
                            color,
                            *subAttribs);
-                xOffset += unbox(textureAtlas().tileSize().width);
+                xOffset += unbox(glyphAtlas.tileSize().width);
             }
         }
 
@@ -610,32 +857,85 @@ void TextRenderer::renderTextGroup(std::u32string_view codepoints,
 Renderable::AtlasTileAttributes const* TextRenderer::getOrCreateRasterizedMetadata(
     strong_hash const& hash, text::glyph_key const& glyphKey, unicode::PresentationStyle presentationStyle)
 {
+    if (auto const* attributes = tryGetRasterizedMetadata(hash))
+        return attributes;
+
+    auto bitmap = optional<text::rasterized_glyph> {};
+    if (!_asyncRasterizer)
+        bitmap = rasterizeGlyph(glyphKey);
+    else
+        bitmap = cachedRasterizedGlyph(glyphKey);
+
+    if (!bitmap)
+    {
+        // Leave the glyph out of this frame rather than waiting for it to be rasterized.
+        if (_asyncRasterizer)
+        {
+            _asyncRasterizer->request(hash, glyphKey, presentationStyle);
+            _glyphsLeftOut = true;
+        }
+        return nullptr;
+    }
+
+    return emplaceRasterizedGlyph(hash, std::move(*bitmap), presentationStyle);
+}
+
+Renderable::AtlasTileAttributes const* TextRenderer::tryGetRasterizedMetadata(strong_hash const& hash)
+{
+    for (auto const format: atlas::Formats)
+        for (auto const sizeClass:
+             { atlas::TileSizeClass::Narrow, atlas::TileSizeClass::Wide, atlas::TileSizeClass::ExtraWide })
+            if (auto const* attributes = textureAtlas(format).try_get(hash, sizeClass))
+                return attributes;
+    return nullptr;
+}
+
+Renderable::AtlasTileAttributes const* TextRenderer::emplaceRasterizedGlyph(
+    strong_hash const& hash, text::rasterized_glyph glyph, unicode::PresentationStyle presentation)
+{
+    glyph = prepareRasterizedGlyph(std::move(glyph), presentation);
+    auto& glyphAtlas = textureAtlas(toAtlasFormat(glyph.format));
+    auto const sizeClass = tileSizeClassFor(glyphAtlas, glyph.bitmapSize.width);
+
     // clang-format off
-    return textureAtlas().get_or_try_emplace(
+    return glyphAtlas.get_or_try_emplace(
         hash,
         [&](atlas::TileLocation tileLocation)
         -> optional<TextureAtlas::TileCreateData>
         {
-            return createSlicedRasterizedGlyph(tileLocation, glyphKey, presentationStyle, hash);
-        }
+            return createSlicedRasterizedGlyph(glyphAtlas, tileLocation, sizeClass, std::move(glyph), hash);
+        },
+        sizeClass
     );
     // clang-format on
 }
 
-auto TextRenderer::createSlicedRasterizedGlyph(atlas::TileLocation tileLocation,
-                                               text::glyph_key const& glyphKey,
-                                               unicode::PresentationStyle presentation,
+atlas::TileSizeClass TextRenderer::tileSizeClassFor(TextureAtlas const& glyphAtlas,
+                                                    vtbackend::Width bitmapWidth)
+{
+    for (auto const sizeClass:
+         { atlas::TileSizeClass::Narrow, atlas::TileSizeClass::Wide, atlas::TileSizeClass::ExtraWide })
+        if (bitmapWidth <= glyphAtlas.tileSize(sizeClass).width && glyphAtlas.capacity(sizeClass))
+            return sizeClass;
+
+    return atlas::TileSizeClass::Narrow;
+}
+
+auto TextRenderer::createSlicedRasterizedGlyph(TextureAtlas& glyphAtlas,
+                                               atlas::TileLocation tileLocation,
+                                               atlas::TileSizeClass sizeClass,
+                                               text::rasterized_glyph glyph,
                                                strong_hash const& hash)
     -> optional<TextureAtlas::TileCreateData>
 {
-    auto result = createRasterizedGlyph(tileLocation, glyphKey, presentation);
+    auto result = createRasterizedGlyph(tileLocation, std::move(glyph));
     if (!result)
         return result;
 
     auto& createData = *result;
 
-    if (unbox<int>(createData.bitmapSize.width) <= unbox<int>(textureAtlas().tileSize().width))
-        // standard (narrow) rasterization
+    if (unbox<int>(createData.bitmapSize.width) <= unbox<int>(glyphAtlas.tileSize(sizeClass).width))
+        // standard rasterization into a single (possibly wide) tile
         return result;
 
     // Now, slice wide glyph into smaller fitting tiles,
@@ -650,7 +950,7 @@ auto TextRenderer::createSlicedRasterizedGlyph(atlas::TileLocation tileLocation,
     for (uintptr_t xOffset = tileWidth; xOffset < unbox<uintptr_t>(createData.bitmapSize.width); xOffset +=
                                                                                                  tileWidth)
     {
-        textureAtlas().emplace(
+        glyphAtlas.emplace(
             hash * uint32_t(xOffset),
             [this, xOffset, tileWidth, &createData, colorComponentCount, bitmapFormat, pitch](
                 atlas::TileLocation tileLocation) {
@@ -681,7 +981,7 @@ auto TextRenderer::createSlicedRasterizedGlyph(atlas::TileLocation tileLocation,
 
     // Construct head-tile
     // cut off bitmap to first tile
-    auto const headWidth = textureAtlas().tileSize().width;
+    auto const headWidth = glyphAtlas.tileSize().width;
     auto const headSize = ImageSize { headWidth, createData.bitmapSize.height };
     auto const headPitch = unbox<uintptr_t>(headWidth) * colorComponentCount;
     auto headBitmap = vector<uint8_t>(headSize.area() * colorComponentCount);
@@ -699,16 +999,9 @@ auto TextRenderer::createSlicedRasterizedGlyph(atlas::TileLocation tileLocation,
                             createData.metadata.fragmentShaderSelector) };
 }
 
-auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation,
-                                         text::glyph_key const& glyphKey,
-                                         unicode::PresentationStyle presentation)
-    -> optional<TextureAtlas::TileCreateData>
+text::rasterized_glyph TextRenderer::prepareRasterizedGlyph(text::rasterized_glyph glyph,
+                                                            unicode::PresentationStyle presentation)
 {
-    auto theGlyphOpt = _textShaper.rasterize(glyphKey, _fontDescriptions.renderMode);
-    if (!theGlyphOpt.has_value())
-        return nullopt;
-
-    text::rasterized_glyph& glyph = theGlyphOpt.value();
     Require(glyph.bitmap.size()
             == text::pixel_size(glyph.format) * unbox<size_t>(glyph.bitmapSize.width)
                    * unbox<size_t>(glyph.bitmapSize.height));
@@ -800,7 +1093,7 @@ auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation,
                         glyph,
                         boundingBox,
                         numCells,
-                        glyphKey.index,
+                        glyph.index,
                         _fontDescriptions.renderMode,
                         [=](){ auto s = std::ostringstream(); s << presentation; return s.str(); }(),
                         yOverflow,
@@ -808,6 +1101,12 @@ auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation,
         // clang-format on
     }
 
+    return glyph;
+}
+
+auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation, text::rasterized_glyph glyph)
+    -> optional<TextureAtlas::TileCreateData>
+{
     return { createTileData(tileLocation,
                             std::move(glyph.bitmap),
                             toAtlasFormat(glyph.format),
@@ -817,13 +1116,42 @@ auto TextRenderer::createRasterizedGlyph(atlas::TileLocation tileLocation,
                             toFragmentShaderSelector(glyph.format)) };
 }
 
+optional<text::rasterized_glyph> TextRenderer::rasterizeGlyph(text::glyph_key const& glyphKey)
+{
+    if (auto glyph = cachedRasterizedGlyph(glyphKey))
+        return glyph;
+
+    auto glyph = [&]() {
+        auto const shaperLock = lockShaper();
+        return _textShaper.rasterize(glyphKey, _fontDescriptions.renderMode);
+    }();
+    if (glyph)
+        storeRasterizedGlyph(glyphKey, *glyph);
+    return glyph;
+}
+
 text::shape_result const& TextRenderer::getOrCreateCachedGlyphPositions(strong_hash hash,
                                                                         u32string_view codepoints,
                                                                         gsl::span<unsigned> clusters,
                                                                         TextStyle style)
 {
-    return _textShapingCache->get_or_emplace(hash, [this, codepoints, clusters, style](auto) {
-        return createTextShapedGlyphPositions(codepoints, clusters, style);
+    return _textShapingCache->get_or_emplace(hash, [this, hash, codepoints, clusters, style](auto) {
+        if (_sharedGlyphCache)
+            if (auto glyphPositions = _sharedGlyphCache->shapeResult(_fontSlots, hash))
+                return std::move(*glyphPositions);
+
+        auto glyphPositions = [&]() {
+            if (_glyphDiskCache)
+                if (auto cached = _glyphDiskCache->shapeResult(hash))
+                    return std::move(*cached);
+            auto created = createTextShapedGlyphPositions(codepoints, clusters, style);
+            if (_glyphDiskCache)
+                _glyphDiskCache->storeShapeResult(hash, created);
+            return created;
+        }();
+        if (_sharedGlyphCache)
+            _sharedGlyphCache->storeShapeResult(_fontSlots, hash, glyphPositions);
+        return glyphPositions;
     });
 }
 
@@ -866,12 +1194,15 @@ text::shape_result TextRenderer::shapeTextRun(unicode::run_segmenter::range cons
 
     text::shape_result glyphPosition;
     glyphPosition.reserve(clusters.size());
-    _textShaper.shape(font,
-                      codepoints,
-                      clusters,
-                      script,            // get<unicode::Script>(run.properties),
-                      presentationStyle, // get<unicode::PresentationStyle>(run.properties),
-                      glyphPosition);
+    {
+        auto const shaperLock = lockShaper();
+        _textShaper.shape(font,
+                          codepoints,
+                          clusters,
+                          script,            // get<unicode::Script>(run.properties),
+                          presentationStyle, // get<unicode::PresentationStyle>(run.properties),
+                          glyphPosition);
+    }
 
     if (rasterizerLog && !glyphPosition.empty())
     {
@@ -5,9 +5,12 @@
 #include <vtbackend/RenderBuffer.h>
 #include <vtbackend/Screen.h>
 
+#include <vtrasterizer/AsyncGlyphRasterizer.h>
 #include <vtrasterizer/BoxDrawingRenderer.h>
 #include <vtrasterizer/FontDescriptions.h>
+#include <vtrasterizer/GlyphDiskCache.h>
 #include <vtrasterizer/RenderTarget.h>
+#include <vtrasterizer/SharedGlyphCache.h>
 #include <vtrasterizer/TextClusterGrouper.h>
 #include <vtrasterizer/TextureAtlas.h>
 
@@ -26,12 +29,19 @@
 #include <gsl/span>
 #include <gsl/span_ext>
 
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace vtrasterizer
 {
 
-text::font_locator& createFontLocator(FontLocatorEngine engine);
+/// @p cacheDirectory  directory the font locator may persist its caches in, if not empty.
+text::font_locator& createFontLocator(FontLocatorEngine engine,
+                                      std::filesystem::path const& cacheDirectory = {});
 
 struct FontKeys
 {
@@ -54,6 +64,9 @@ struct TextRendererEvents
 class TextRenderer: public Renderable, public TextClusterGrouper::Events
 {
   public:
+    /// Number of text styles (regular, bold, italic, bold italic) whose US-ASCII glyphs are direct-mapped.
+    static constexpr size_t DirectMappedStyleCount = 4;
+
     TextRenderer(GridMetrics const& gridMetrics,
                  text::shaper& textShaper,
                  FontDescriptions& fontDescriptions,
@@ -61,12 +74,33 @@ class TextRenderer: public Renderable, public TextClusterGrouper::Events
                  TextRendererEvents& eventHandler);
 
     void setRenderTarget(RenderTarget& renderTarget, DirectMappingAllocator& directMappingAllocator) override;
-    void setTextureAtlas(TextureAtlas& atlas) override;
+    void setTextureAtlases(TextureAtlases atlases) override;
 
     void inspect(std::ostream& textOutput) const override;
 
     void clearCache() override;
 
+    /// Releases the glyph caches retained for the font configurations used before the current one.
+    void releaseRecentGlyphCaches() noexcept;
+
+    /// Enables the persistent glyph cache in the given directory, or disables it if empty.
+    void setGlyphCacheDirectory(std::filesystem::path directory);
+    [[nodiscard]] std::filesystem::path const& glyphCacheDirectory() const noexcept
+    {
+        return _glyphCacheDirectory;
+    }
+
+    /// Rasterizes glyphs that are not in the texture atlas yet on a background thread.
+    ///
+    /// Such glyphs are left out of the frame they are first needed in, and @p glyphsRasterized
+    /// is invoked (on the background thread) once they are ready to be drawn in the next frame.
+    void enableAsyncRasterization(std::function<void()> glyphsRasterized);
+
+    /// Discards all glyphs still waiting to be rasterized in the background.
+    ///
+    /// Must be called before the fonts of the text shaper are changed.
+    void discardPendingRasterization();
+
     void updateFontMetrics();
 
     void setPressure(bool pressure) noexcept { _pressure = pressure; }
@@ -74,9 +108,9 @@ class TextRenderer: public Renderable, public TextClusterGrouper::Events
     /// Must be invoked before a new terminal frame is rendered.
     void beginFrame();
 
-    /// Renders a given terminal's grid cell that has been
-    /// transformed into a RenderCell.
-    void renderCell(vtbackend::RenderCell const& cell);
+    /// Renders the given terminal's grid cells that have been transformed into RenderCells,
+    /// reading only their positions, codepoints, attributes, and text group marks.
+    void renderCells(vtbackend::RenderCells const& cells);
 
     void renderCell(vtbackend::CellLocation position,
                     std::u32string_view graphemeCluster,
@@ -88,10 +122,32 @@ class TextRenderer: public Renderable, public TextClusterGrouper::Events
     /// Must be invoked when rendering the terminal's text has finished for this frame.
     void endFrame();
 
+    /// Tells whether any glyphs have been left out of the current frame, as they were still to be
+    /// rasterized in the background.
+    [[nodiscard]] bool glyphsLeftOut() const noexcept { return _glyphsLeftOut; }
+
   private:
     void initializeDirectMapping();
 
+    /// (Re-)acquires the shared glyph cache and (re-)opens the glyph disk cache
+    /// matching the currently loaded fonts.
+    void updateGlyphCaches();
+
+    /// Looks up the given glyph in the shared glyph cache, and then in the glyph disk cache.
+    [[nodiscard]] std::optional<text::rasterized_glyph> cachedRasterizedGlyph(
+        text::glyph_key const& glyphKey);
+
+    /// Stores the given glyph in the shared glyph cache and the glyph disk cache.
+    void storeRasterizedGlyph(text::glyph_key const& glyphKey, text::rasterized_glyph const& glyph);
+
+    /// Locks the text shaper against concurrent use by the background rasterizer, if enabled.
+    [[nodiscard]] std::unique_lock<std::mutex> lockShaper();
+
+    /// Puts the glyphs rasterized in the background so far into the texture atlas.
+    void uploadAsyncRasterizedGlyphs();
+
     void renderTextGroup(std::u32string_view codepoints,
+                         crispy::strong_hash textHash,
                          gsl::span<unsigned> clusters,
                          vtbackend::CellLocation initialPenPosition,
                          TextStyle style,
@@ -118,20 +174,40 @@ class TextRenderer: public Renderable, public TextClusterGrouper::Events
                                                              text::glyph_key const& glyphKey,
                                                              unicode::PresentationStyle presentationStyle);
 
+    /// Looks up the head tile of the given glyph in the tiles of all size classes.
+    AtlasTileAttributes const* tryGetRasterizedMetadata(crispy::strong_hash const& hash);
+
+    /// Puts the given rasterized glyph into the tile(s) of the smallest size class it fits into,
+    /// in the texture atlas of its bitmap format.
+    AtlasTileAttributes const* emplaceRasterizedGlyph(crispy::strong_hash const& hash,
+                                                      text::rasterized_glyph glyph,
+                                                      unicode::PresentationStyle presentation);
+
+    /// @returns the smallest tile size class that can hold a bitmap of the given width,
+    ///          or the narrow one if the bitmap has to be sliced into multiple tiles.
+    static atlas::TileSizeClass tileSizeClassFor(TextureAtlas const& glyphAtlas,
+                                                 vtbackend::Width bitmapWidth);
+
     /**
-     * Creates (and rasterizes) a single glyph and returns its
+     * Creates the tile(s) of a single prepared rasterized glyph and returns its
      * render tile attributes required for the render step.
      */
     std::optional<TextureAtlas::TileCreateData> createSlicedRasterizedGlyph(
+        TextureAtlas& glyphAtlas,
         atlas::TileLocation tileLocation,
-        text::glyph_key const& glyphKey,
-        unicode::PresentationStyle presentation,
+        atlas::TileSizeClass sizeClass,
+        text::rasterized_glyph glyph,
         crispy::strong_hash const& hash);
 
-    std::optional<TextureAtlas::TileCreateData> createRasterizedGlyph(
-        atlas::TileLocation tileLocation,
-        text::glyph_key const& glyphKey,
-        unicode::PresentationStyle presentation);
+    /// Scales, positions, and crops the given rasterized glyph to fit the grid cell(s).
+    text::rasterized_glyph prepareRasterizedGlyph(text::rasterized_glyph glyph,
+                                                  unicode::PresentationStyle presentation);
+
+    std::optional<TextureAtlas::TileCreateData> createRasterizedGlyph(atlas::TileLocation tileLocation,
+                                                                      text::rasterized_glyph glyph);
+
+    /// Rasterizes the given glyph, or loads its bitmap from the glyph disk cache.
+    std::optional<text::rasterized_glyph> rasterizeGlyph(text::glyph_key const& glyphKey);
 
     void restrictToTileSize(TextureAtlas::TileCreateData& tileCreateData);
 
@@ -161,20 +237,57 @@ class TextRenderer: public Renderable, public TextClusterGrouper::Events
     // TODO: make unique_ptr, get owned, export cref for other users in Renderer impl.
     text::shaper& _textShaper;
 
+    // Persists shaping results and glyph bitmaps across font changes and restarts, if enabled.
+    std::filesystem::path _glyphCacheDirectory;
+    std::unique_ptr<GlyphDiskCache> _glyphDiskCache;
+
+    // Shares shaping results and glyph bitmaps with all other renderers using the same fonts,
+    // which refer to the fonts of the text shaper by these slots.
+    GlyphDiskCache::FontSlots _fontSlots {};
+    std::shared_ptr<SharedGlyphCache> _sharedGlyphCache;
+    RecentGlyphCaches _recentGlyphCaches;
+
+    std::unique_ptr<AsyncGlyphRasterizer> _asyncRasterizer;
+    bool _glyphsLeftOut = false; // within the current frame
+
+    // The US-ASCII glyphs of the regular, bold, italic, and bold italic fonts are direct-mapped,
+    // so that they are never evicted from the texture atlas.
     DirectMapping _directMapping {};
 
-    // Maps from glyph index to tile index.
-    std::vector<uint32_t> _directMappedGlyphKeyToTileIndex {};
+    // Fonts of the direct-mapped text styles, and for each, maps from glyph index to tile index.
+    std::array<text::font_key, DirectMappedStyleCount> _directMappedFonts {};
+    std::array<std::vector<uint32_t>, DirectMappedStyleCount> _directMappedGlyphKeyToTileIndex {};
 
-    [[nodiscard]] bool isGlyphDirectMapped(text::glyph_key const& glyph) const noexcept
+    /// @returns the tile index the given glyph is direct-mapped to, or 0 if it is not direct-mapped.
+    [[nodiscard]] uint32_t directMappedTileIndex(text::glyph_key const& glyph) const noexcept
     {
-        return _directMapping                  // Is direct mapping enabled?
-               && glyph.font == _fonts.regular // Only regular font is direct-mapped for now.
-               && glyph.index.value < _directMappedGlyphKeyToTileIndex.size()
-               && _directMappedGlyphKeyToTileIndex[glyph.index.value] != 0;
+        if (!_directMapping)
+            return 0;
+
+        for (size_t style = 0; style < DirectMappedStyleCount; ++style)
+        {
+            auto const& glyphKeyToTileIndex = _directMappedGlyphKeyToTileIndex[style];
+            if (glyph.font == _directMappedFonts[style] && glyph.index.value < glyphKeyToTileIndex.size())
+                return glyphKeyToTileIndex[glyph.index.value];
+        }
+        return 0;
     }
 
+    // For each direct-mapped text style whose font has no ligatures, the glyphs of its US-ASCII
+    // characters, so that text in these is rendered without text shaping. Empty otherwise.
+    std::array<std::vector<text::glyph_position>, DirectMappedStyleCount> _directMappedAsciiGlyphs {};
+
+    /// Renders the given text group codepoint by codepoint, if it only consists of
+    /// direct-mapped US-ASCII glyphs that do not need text shaping.
+    ///
+    /// @returns false if the text group must be shaped instead.
+    bool tryRenderAsciiTextGroup(std::u32string_view codepoints,
+                                 vtbackend::CellLocation initialPenPosition,
+                                 TextStyle style,
+                                 vtbackend::RGBColor color);
+
     AtlasTileAttributes const* ensureRasterizedIfDirectMapped(text::glyph_key const& glyphKey);
+    AtlasTileAttributes const* rasterizeDirectMapped(uint32_t tileIndex, text::glyph_key const& glyphKey);
 
     // sub-renderer
     //
@@ -8,6 +8,9 @@
 #include <crispy/StrongLRUHashtable.h>
 #include <crispy/assert.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstdint>
 #include <format>
 #include <variant> // monostate
@@ -32,6 +35,36 @@ constexpr uint32_t element_count(Format format) noexcept
     return static_cast<uint32_t>(format);
 }
 
+// Number of texture atlases, one per Format, each storing only tiles of its own format.
+constexpr size_t FormatCount = 3;
+
+constexpr std::array<Format, FormatCount> Formats { Format::Red, Format::RGB, Format::RGBA };
+
+/// @returns the index of the given format in Formats.
+constexpr size_t formatIndex(Format format) noexcept
+{
+    switch (format)
+    {
+        case Format::Red: return 0;
+        case Format::RGB: return 1;
+        case Format::RGBA: return 2;
+    }
+    return 0;
+}
+
+// Index of the texture atlas dedicated to images, following the atlases of each Format.
+// Images have an RGBA atlas of their own, so that large images never evict any glyphs.
+constexpr size_t ImageAtlasIndex = FormatCount;
+
+// Number of texture atlases, i.e. one per Format plus the image atlas.
+constexpr size_t AtlasCount = FormatCount + 1;
+
+/// @returns the format of the tiles stored in the texture atlas of the given index.
+constexpr Format atlasFormat(size_t atlasIndex) noexcept
+{
+    return atlasIndex < FormatCount ? Formats[atlasIndex] : Format::RGBA;
+}
+
 // -----------------------------------------------------------------------
 // informational data structures
 
@@ -60,6 +93,7 @@ struct TileLocation
     // clang-format off
     struct X { uint16_t value; };
     struct Y { uint16_t value; };
+    struct Layer { uint16_t value; };
     // struct RelativeX { float value; };
     // struct RelativeY { float value; };
     // struct RelativeWidth { float value; };
@@ -72,7 +106,10 @@ struct TileLocation
     // Y-offset of the tile into the texture atlas.
     Y y {};
 
-    constexpr TileLocation(X ax, Y ay) noexcept: x { ax }, y { ay } {}
+    // Layer of the texture atlas the tile is stored in.
+    Layer layer {};
+
+    constexpr TileLocation(X ax, Y ay, Layer alayer = {}) noexcept: x { ax }, y { ay }, layer { alayer } {}
 
     constexpr TileLocation() noexcept = default;
     constexpr TileLocation(TileLocation const&) noexcept = default;
@@ -89,6 +126,22 @@ struct NormalizedTileLocation
     float height {};
 };
 
+/// Size classes of tiles, by their width in multiples of AtlasProperties::tileSize.
+///
+/// Bitmaps wider than a (narrow) tile, such as emoji, CJK glyphs, or ligatures,
+/// can be stored in a single wider tile rather than being sliced into multiple narrow ones.
+enum class TileSizeClass : uint8_t
+{
+    Narrow = 1,
+    Wide = 2,
+    ExtraWide = 4,
+};
+
+constexpr uint32_t widthFactor(TileSizeClass sizeClass) noexcept
+{
+    return static_cast<uint32_t>(sizeClass);
+}
+
 // An texture atlas is holding fixed sized tiles in a grid.
 //
 // The tiles are identified using a 32-bit Integer (AtlasTileID) that can
@@ -110,11 +163,27 @@ struct AtlasProperties
     // Number of tiles the texture atlas must be able to store at least.
     crispy::lru_capacity tileCount {};
 
+    // Number of wide (twice the tile width) and extra wide (four times the tile width) tiles
+    // the texture atlas must be able to store at least, unless a layer is too narrow to hold any.
+    //
+    // These are stored in rows of their own at the end of the atlas, each size class with its own LRU cache.
+    uint32_t wideTileCount = 0;
+    uint32_t extraWideTileCount = 0;
+
     // Number of direct-mapped tile slots.
     //
     // This can be for example [A-Za-z0-9], characters that are most often
     // used and least likely part of a ligature.
     uint32_t directMappingCount {};
+
+    // Identifies the texture atlas towards the backend, see AtlasCount.
+    uint32_t atlasIndex = 0;
+
+    // Maximum width and height in pixels of a single layer of the texture atlas.
+    //
+    // Tiles that do not fit into a single layer of at most that size are spread
+    // over multiple equally sized layers.
+    uint32_t maxLayerSize = 4096;
 };
 
 // -----------------------------------------------------------------------
@@ -123,9 +192,12 @@ struct AtlasProperties
 // Command structure to (re-)construct a texture atlas.
 struct ConfigureAtlas
 {
-    // Texture atlas size in pixels.
+    // Size in pixels of each layer of the texture atlas.
     vtbackend::ImageSize size {};
 
+    // Number of layers of the texture atlas.
+    uint32_t layerCount = 1;
+
     AtlasProperties properties {};
 };
 
@@ -137,6 +209,7 @@ struct UploadTile
     vtbackend::ImageSize bitmapSize;
     Format bitmapFormat;
     int rowAlignment = 1; // byte-alignment per row
+    uint32_t atlasIndex = 0; // AtlasProperties::atlasIndex of the atlas to upload into
 };
 
 // Command structure for rendering a tile from a texture atlas.
@@ -188,10 +261,11 @@ class AtlasBackend
   public:
     virtual ~AtlasBackend() = default;
 
-    [[nodiscard]] virtual vtbackend::ImageSize atlasSize() const noexcept = 0;
-
     /// Creates a new texture atlas, effectively destroying any prior existing one
-    /// as there  can be only one atlas.
+    /// of the same format, as there can be only one atlas per format.
+    ///
+    /// The atlas consists of one or more equally sized layers (e.g. a 2D texture array),
+    /// addressed by the layer of each TileLocation.
     virtual void configureAtlas(ConfigureAtlas atlas) = 0;
 
     /// Uploads given texture to the atlas.
@@ -214,7 +288,12 @@ struct TileAttributes
  * Manages the tiles of a single texture atlas.
  *
  * Atlas items are LRU-cached and the possibly passed metadata is
- * going to be destroyed at the time of cache eviction.
+ * going to be destroyed at the time of cache eviction. The tile slot of an
+ * evicted item is reused for the item replacing it, so the atlas never
+ * grows beyond the tiles it was configured with.
+ *
+ * If the configured tiles do not fit into a single texture of at most
+ * AtlasProperties::maxLayerSize, they are spread over multiple layers.
  *
  * The total number of of cachable tiles should be at least as large
  * as the terminal's cell count per page.
@@ -237,11 +316,25 @@ class TextureAtlas
 
     [[nodiscard]] AtlasBackend& backend() noexcept { return _backend; }
 
+    /// @returns the size in pixels of each layer of the atlas.
     [[nodiscard]] vtbackend::ImageSize atlasSize() const noexcept { return _atlasSize; }
+    [[nodiscard]] uint32_t layerCount() const noexcept { return _layerCount; }
     [[nodiscard]] vtbackend::ImageSize tileSize() const noexcept { return _atlasProperties.tileSize; }
 
+    // Retrieves the format of all tiles stored in this atlas.
+    [[nodiscard]] Format format() const noexcept { return _atlasProperties.format; }
+
+    /// @returns the size in pixels of the tiles of the given size class.
+    [[nodiscard]] vtbackend::ImageSize tileSize(TileSizeClass sizeClass) const noexcept
+    {
+        return vtbackend::ImageSize { _atlasProperties.tileSize.width
+                                          * vtbackend::Width::cast_from(widthFactor(sizeClass)),
+                                      _atlasProperties.tileSize.height };
+    }
+
     // Tests in LRU-cache if the tile
-    [[nodiscard]] constexpr bool contains(crispy::strong_hash const& id) const noexcept;
+    [[nodiscard]] constexpr bool contains(crispy::strong_hash const& id,
+                                          TileSizeClass sizeClass = TileSizeClass::Narrow) const noexcept;
 
     // Return type for in-place tile-construction callback.
     struct TileCreateData
@@ -267,21 +360,29 @@ class TextureAtlas
 
     /// Always returns either the existing item by the given key, if found,
     /// or a newly created one by invoking constructValue().
+    ///
+    /// Each tile size class has a cache of its own, which must not be empty (see capacity()).
     template <typename CreateTileDataFn>
     [[nodiscard]] TileAttributes<Metadata>& get_or_emplace(crispy::strong_hash const& key,
-                                                           CreateTileDataFn constructValue);
+                                                           CreateTileDataFn constructValue,
+                                                           TileSizeClass sizeClass = TileSizeClass::Narrow);
 
-    [[nodiscard]] TileAttributes<Metadata> const* try_get(crispy::strong_hash const& key);
+    [[nodiscard]] TileAttributes<Metadata> const* try_get(crispy::strong_hash const& key,
+                                                          TileSizeClass sizeClass = TileSizeClass::Narrow);
 
     template <typename CreateTileDataFn>
-    [[nodiscard]] TileAttributes<Metadata> const* get_or_try_emplace(crispy::strong_hash const& key,
-                                                                     CreateTileDataFn constructValue);
+    [[nodiscard]] TileAttributes<Metadata> const* get_or_try_emplace(
+        crispy::strong_hash const& key,
+        CreateTileDataFn constructValue,
+        TileSizeClass sizeClass = TileSizeClass::Narrow);
 
     /// Explicitly create or overwrites a tile for the given hash key.
     template <typename CreateTileDataFn>
-    void emplace(crispy::strong_hash const& key, CreateTileDataFn constructValue);
+    void emplace(crispy::strong_hash const& key,
+                 CreateTileDataFn constructValue,
+                 TileSizeClass sizeClass = TileSizeClass::Narrow);
 
-    void remove(crispy::strong_hash key);
+    void remove(crispy::strong_hash key, TileSizeClass sizeClass = TileSizeClass::Narrow);
 
     // Uploads tile data to a direct-mapped slot in the texture atlas
     // bypassing the LRU cache.
@@ -294,13 +395,35 @@ class TextureAtlas
     // The index must be between 0 and number of direct-mapped tiles minus 1.
     [[nodiscard]] TileAttributes<Metadata> const& directMapped(uint32_t index) const;
 
+    // Marks a direct-mapped tile slot as unused, e.g. because its tile moved to another atlas.
+    void clearDirectMapping(uint32_t index);
+
     [[nodiscard]] bool isDirectMappingEnabled() const noexcept { return !_directMapping.empty(); }
 
     [[nodiscard]] TileLocation tileLocation(uint32_t tileIndex) const { return _tileLocations[tileIndex]; }
 
-    // Retrieves the number of total tiles that can be stored.
+    // Retrieves the number of total (narrow) tiles that can be stored.
     [[nodiscard]] size_t capacity() const noexcept { return _tileLocations.size(); }
 
+    // Retrieves the number of tiles of the given wide size class that can be stored.
+    [[nodiscard]] size_t capacity(TileSizeClass sizeClass) const noexcept
+    {
+        if (sizeClass == TileSizeClass::Narrow)
+            return capacity();
+        return wideTiles(sizeClass).tileLocations.size();
+    }
+
+    // Usage of the tile caches, summed over all tile size classes.
+    struct Usage
+    {
+        size_t tileCount = 0;                 // number of tiles currently stored
+        size_t tileCapacity = 0;              // number of tiles that can be stored at most
+        crispy::lru_hashtable_stats cache {}; // lookups and evictions since the previous call
+    };
+
+    // Retrieves the current usage, resetting the lookup and eviction counters of the tile caches.
+    [[nodiscard]] Usage fetchAndClearUsage() noexcept;
+
     void inspect(std::ostream& output) const;
 
     [[nodiscard]] uint32_t tilesInX() const noexcept { return _tilesInX; }
@@ -310,9 +433,37 @@ class TextureAtlas
     using TileCache = crispy::strong_lru_hashtable<TileAttributes<Metadata>>;
     using TileCachePtr = typename TileCache::ptr;
 
+    // Tiles of a wide size class, stored in the last rows of the atlas.
+    struct WideTiles
+    {
+        uint32_t rowCount = 0;
+        TileCachePtr tileCache;                  // null if no such tiles are stored
+        std::vector<TileLocation> tileLocations; // by LRU entry index minus one
+    };
+
+    [[nodiscard]] WideTiles& wideTiles(TileSizeClass sizeClass) noexcept
+    {
+        return _wideTiles[sizeClass == TileSizeClass::Wide ? 0 : 1];
+    }
+
+    [[nodiscard]] WideTiles const& wideTiles(TileSizeClass sizeClass) const noexcept
+    {
+        return _wideTiles[sizeClass == TileSizeClass::Wide ? 0 : 1];
+    }
+
+    [[nodiscard]] TileCache& tileCache(TileSizeClass sizeClass) noexcept
+    {
+        if (sizeClass == TileSizeClass::Narrow)
+            return *_tileCache;
+        auto& tiles = wideTiles(sizeClass);
+        Require(tiles.tileCache);
+        return *tiles.tileCache;
+    }
+
     template <typename CreateTileDataFn>
     std::optional<TileAttributes<Metadata>> constructTile(CreateTileDataFn createTileData,
-                                                          uint32_t entryIndex);
+                                                          uint32_t entryIndex,
+                                                          TileSizeClass sizeClass);
 
     AtlasBackend& _backend;
     AtlasProperties _atlasProperties;
@@ -320,6 +471,11 @@ class TextureAtlas
     uint32_t _tilesInX;
     uint32_t _tilesInY;
 
+    // Wide and extra wide tiles, in this order.
+    std::array<WideTiles, 2> _wideTiles;
+
+    uint32_t _layerCount;
+
     // The number of entries of this cache must at most match the number
     // of tiles that can be stored into the atlas.
     TileCachePtr _tileCache;
@@ -446,20 +602,56 @@ constexpr auto sliced(vtbackend::Width tileWidth, uint32_t offsetX, vtbackend::I
 
 // {{{ implementation
 
+/// @returns the total number of (narrow) tiles the atlas must provide, including the reserved zero-tile.
+inline uint32_t requiredAtlasTileCount(AtlasProperties const& atlasProperties) noexcept
+{
+    return crispy::nextPowerOfTwo(1 + atlasProperties.tileCount.value + atlasProperties.directMappingCount);
+}
+
+/// @returns the number of atlas rows needed for the tiles of the given wide size class,
+///          or 0 if a row of at most @p tilesInX narrow tiles cannot hold a single one.
+inline uint32_t requiredTileRowCount(AtlasProperties const& atlasProperties,
+                                     uint32_t tilesInX,
+                                     TileSizeClass sizeClass) noexcept
+{
+    auto const tilesPerRow = tilesInX / widthFactor(sizeClass);
+    auto const tileCount = sizeClass == TileSizeClass::Wide ? atlasProperties.wideTileCount
+                                                            : atlasProperties.extraWideTileCount;
+    if (tilesPerRow == 0 || tileCount == 0)
+        return 0;
+    return (tileCount + tilesPerRow - 1) / tilesPerRow;
+}
+
+/// @returns the largest power of two not exceeding the given value.
+constexpr uint32_t previousPowerOfTwo(uint32_t value) noexcept
+{
+    auto result = uint32_t { 1 };
+    while (result <= value / 2)
+        result *= 2;
+    return result;
+}
+
+/// @returns the size in pixels of each layer of the texture atlas.
 inline vtbackend::ImageSize computeAtlasSize(AtlasProperties const& atlasProperties) noexcept
 {
     using std::ceil;
     using std::sqrt;
 
-    // clang-format off
-    auto const totalTileCount = crispy::nextPowerOfTwo(1 + atlasProperties.tileCount.value + atlasProperties.directMappingCount);
-    //auto const totalTileCount = atlasProperties.tileCount.value + atlasProperties.directMappingCount;
+    // The layer size must at least fit a single tile.
+    auto const maxLayerSize = [&](uint32_t tileEdge) {
+        return std::max(previousPowerOfTwo(atlasProperties.maxLayerSize), crispy::nextPowerOfTwo(tileEdge));
+    };
+
+    auto const totalTileCount =
+        requiredAtlasTileCount(atlasProperties)
+        + (widthFactor(TileSizeClass::Wide) * atlasProperties.wideTileCount)
+        + (widthFactor(TileSizeClass::ExtraWide) * atlasProperties.extraWideTileCount);
     auto const squareEdgeCount = static_cast<uint32_t>(ceil(sqrt(totalTileCount)));
-    auto const width = vtbackend::Width::cast_from(crispy::nextPowerOfTwo(static_cast<uint32_t>(
-        squareEdgeCount * unbox(atlasProperties.tileSize.width))));
-    auto const height = vtbackend::Height::cast_from(crispy::nextPowerOfTwo(static_cast<uint32_t>(
-        squareEdgeCount * unbox(atlasProperties.tileSize.height))));
-    // clang-format on
+    auto const layerEdge = [&](uint32_t tileEdge) {
+        return std::min(crispy::nextPowerOfTwo(squareEdgeCount * tileEdge), maxLayerSize(tileEdge));
+    };
+    auto const width = vtbackend::Width::cast_from(layerEdge(unbox(atlasProperties.tileSize.width)));
+    auto const height = vtbackend::Height::cast_from(layerEdge(unbox(atlasProperties.tileSize.height)));
 
     // std::cout << std::format("computeAtlasSize: tiles {}+{}={} -> texture size {}x{} (tile size {})\n",
     //            atlasProperties.tileCount,
@@ -489,18 +681,32 @@ TextureAtlas<Metadata>::TextureAtlas(AtlasBackend& backend, AtlasProperties atla
         Require(tilesInY != 0);
         return tilesInY;
     }() },
+    _wideTiles { [&]() {
+        auto tiles = std::array<WideTiles, 2> {};
+        tiles[0].rowCount = requiredTileRowCount(_atlasProperties, _tilesInX, TileSizeClass::Wide);
+        tiles[1].rowCount = requiredTileRowCount(_atlasProperties, _tilesInX, TileSizeClass::ExtraWide);
+        return tiles;
+    }() },
+    _layerCount { [&]() {
+        auto const narrowRowCount = (requiredAtlasTileCount(_atlasProperties) + _tilesInX - 1) / _tilesInX;
+        auto const rowCount = narrowRowCount + _wideTiles[0].rowCount + _wideTiles[1].rowCount;
+        return (rowCount + _tilesInY - 1) / _tilesInY;
+    }() },
     _tileCache { TileCache::create(
         atlasProperties.hashCount,
-        crispy::lru_capacity { // The LRU entry capacity is the number of total tiles availabe,
+        crispy::lru_capacity { // The LRU entry capacity is the number of total narrow tiles availabe,
                                // minus the number of reserved tiles for direct-mapping, and
                                // minus one for the LRU-sentinel entry (which is why entryIndex
                                // is between 1 and capacity inclusive)
-                               _tilesInX * _tilesInY - _atlasProperties.directMappingCount - 1 },
+                               ((_tilesInY * _layerCount) - _wideTiles[0].rowCount - _wideTiles[1].rowCount)
+                                   * _tilesInX
+                               - _atlasProperties.directMappingCount - 1 },
         "LRU cache for texture atlas") },
-    _tileLocations { static_cast<size_t>(_tilesInX * _tilesInY) }
+    _tileLocations { static_cast<size_t>(
+        ((_tilesInY * _layerCount) - _wideTiles[0].rowCount - _wideTiles[1].rowCount) * _tilesInX) }
 {
     Require(_atlasProperties.tileCount.value <= _tileCache->capacity());
-    Require(_atlasProperties.directMappingCount + _atlasProperties.tileCount.value <= _tilesInX * _tilesInY);
+    Require(_atlasProperties.directMappingCount + _atlasProperties.tileCount.value < _tileLocations.size());
 
     // std::cout << std::format("TextureAtlas: tiles {}x{} (locations: {} >= {}) texture {}; props {}\n",
     //            _tilesInX,
@@ -514,53 +720,98 @@ TextureAtlas<Metadata>::TextureAtlas(AtlasBackend& backend, AtlasProperties atla
 
     auto data = ConfigureAtlas {};
     data.size = _atlasSize;
+    data.layerCount = _layerCount;
     data.properties = _atlasProperties;
     _backend.configureAtlas(data);
 
     // The StrongLRUHashtable's passed entryIndex can be used
     // to construct the texture atlas' tile coordinates.
+    auto const tilesPerLayer = _tilesInX * _tilesInY;
     for (uint32_t tileIndex = 0; tileIndex < static_cast<uint32_t>(_tileLocations.size()); ++tileIndex)
     {
+        auto const layerTileIndex = tileIndex % tilesPerLayer;
+
         auto const xBase =
-            static_cast<uint16_t>((tileIndex % _tilesInX) * _atlasProperties.tileSize.width.value);
+            static_cast<uint16_t>((layerTileIndex % _tilesInX) * _atlasProperties.tileSize.width.value);
 
         auto const yBase =
-            static_cast<uint16_t>((tileIndex / _tilesInX) * unbox(_atlasProperties.tileSize.height));
+            static_cast<uint16_t>((layerTileIndex / _tilesInX) * unbox(_atlasProperties.tileSize.height));
+
+        auto const layer = static_cast<uint16_t>(tileIndex / tilesPerLayer);
+
+        _tileLocations[tileIndex] = TileLocation({ xBase }, { yBase }, { layer });
+    }
+
+    // The rows following the narrow tiles' ones hold the wide tiles, and then the extra wide tiles.
+    auto row = static_cast<uint32_t>(_tileLocations.size()) / _tilesInX;
+    for (auto const sizeClass: { TileSizeClass::Wide, TileSizeClass::ExtraWide })
+    {
+        auto& tiles = wideTiles(sizeClass);
+        if (!tiles.rowCount)
+            continue;
 
-        _tileLocations[tileIndex] = TileLocation({ xBase }, { yBase });
+        auto const tilesPerRow = _tilesInX / widthFactor(sizeClass);
+        auto const tileWidth = unbox(tileSize(sizeClass).width);
+        for (auto const rowEnd = row + tiles.rowCount; row < rowEnd; ++row)
+        {
+            auto const yBase =
+                static_cast<uint16_t>((row % _tilesInY) * unbox(_atlasProperties.tileSize.height));
+            auto const layer = static_cast<uint16_t>(row / _tilesInY);
+            for (uint32_t i = 0; i < tilesPerRow; ++i)
+                tiles.tileLocations.emplace_back(TileLocation({ static_cast<uint16_t>(i * tileWidth) },
+                                                              { yBase },
+                                                              { layer }));
+        }
+
+        auto const capacity = static_cast<uint32_t>(tiles.tileLocations.size());
+        tiles.tileCache =
+            TileCache::create(crispy::strong_hashtable_size { crispy::nextPowerOfTwo(capacity) },
+                              crispy::lru_capacity { capacity },
+                              "LRU cache for wide tiles of texture atlas");
     }
 
     _directMapping.resize(_atlasProperties.directMappingCount);
 }
 
 template <typename Metadata>
-constexpr bool TextureAtlas<Metadata>::contains(crispy::strong_hash const& id) const noexcept
+constexpr bool TextureAtlas<Metadata>::contains(crispy::strong_hash const& id,
+                                                TileSizeClass sizeClass) const noexcept
 {
-    return _tileCache->contains(id);
+    if (sizeClass == TileSizeClass::Narrow)
+        return _tileCache->contains(id);
+    auto const& tiles = wideTiles(sizeClass);
+    return tiles.tileCache && tiles.tileCache->contains(id);
 }
 
 template <typename Metadata>
 template <typename CreateTileDataFn>
 auto TextureAtlas<Metadata>::constructTile(CreateTileDataFn createTileData,
-                                           uint32_t entryIndex) -> std::optional<TileAttributes<Metadata>>
+                                           uint32_t entryIndex,
+                                           TileSizeClass sizeClass) -> std::optional<TileAttributes<Metadata>>
 {
-    Require(1 <= entryIndex && entryIndex <= _tileCache->capacity());
-    auto const tileIndex = _atlasProperties.directMappingCount + entryIndex;
-    Require(tileIndex < _tileLocations.size());
-    auto const tileLocation = _tileLocations[tileIndex];
-    Require(tileLocation.x.value != 0 || tileLocation.y.value != 0);
+    Require(1 <= entryIndex && entryIndex <= tileCache(sizeClass).capacity());
+    auto const tileLocation = [&]() {
+        if (sizeClass != TileSizeClass::Narrow)
+            return wideTiles(sizeClass).tileLocations[entryIndex - 1];
+        auto const tileIndex = _atlasProperties.directMappingCount + entryIndex;
+        Require(tileIndex < _tileLocations.size());
+        return _tileLocations[tileIndex];
+    }();
+    Require(tileLocation.x.value != 0 || tileLocation.y.value != 0 || tileLocation.layer.value != 0);
 
     std::optional<TileCreateData> tileCreateDataOpt = createTileData(tileLocation);
     if (!tileCreateDataOpt)
         return std::nullopt;
 
     TileCreateData& tileCreateData = *tileCreateDataOpt;
+    Require(tileCreateData.bitmapFormat == _atlasProperties.format);
 
     auto tileUpload = UploadTile {};
     tileUpload.location = tileLocation;
     tileUpload.bitmapSize = tileCreateData.bitmapSize;
     tileUpload.bitmapFormat = tileCreateData.bitmapFormat;
     tileUpload.bitmap = std::move(tileCreateData.bitmap);
+    tileUpload.atlasIndex = _atlasProperties.atlasIndex;
     _backend.uploadTile(std::move(tileUpload));
 
     auto instance = TileAttributes<Metadata> {};
@@ -574,37 +825,43 @@ auto TextureAtlas<Metadata>::constructTile(CreateTileDataFn createTileData,
 template <typename Metadata>
 template <typename CreateTileDataFn>
 TileAttributes<Metadata>& TextureAtlas<Metadata>::get_or_emplace(crispy::strong_hash const& key,
-                                                                 CreateTileDataFn constructValue)
+                                                                 CreateTileDataFn constructValue,
+                                                                 TileSizeClass sizeClass)
 {
-    return _tileCache->get_or_emplace(key,
-                                      [&](uint32_t entryIndex) -> std::optional<TileAttributes<Metadata>> {
-                                          return constructTile(std::move(constructValue), entryIndex);
-                                      });
+    return tileCache(sizeClass).get_or_emplace(
+        key, [&](uint32_t entryIndex) -> std::optional<TileAttributes<Metadata>> {
+            return constructTile(std::move(constructValue), entryIndex, sizeClass);
+        });
 }
 
 template <typename Metadata>
-TileAttributes<Metadata> const* TextureAtlas<Metadata>::try_get(crispy::strong_hash const& key)
+TileAttributes<Metadata> const* TextureAtlas<Metadata>::try_get(crispy::strong_hash const& key,
+                                                                TileSizeClass sizeClass)
 {
-    return _tileCache->try_get(key);
+    if (sizeClass != TileSizeClass::Narrow && !wideTiles(sizeClass).tileCache)
+        return nullptr;
+    return tileCache(sizeClass).try_get(key);
 }
 
 template <typename Metadata>
 template <typename CreateTileDataFn>
 [[nodiscard]] TileAttributes<Metadata> const* TextureAtlas<Metadata>::get_or_try_emplace(
-    crispy::strong_hash const& key, CreateTileDataFn constructValue)
+    crispy::strong_hash const& key, CreateTileDataFn constructValue, TileSizeClass sizeClass)
 {
-    return _tileCache->get_or_try_emplace(
+    return tileCache(sizeClass).get_or_try_emplace(
         key, [&](uint32_t entryIndex) -> std::optional<TileAttributes<Metadata>> {
-            return constructTile(std::move(constructValue), entryIndex);
+            return constructTile(std::move(constructValue), entryIndex, sizeClass);
         });
 }
 
 template <typename Metadata>
 template <typename CreateTileDataFn>
-void TextureAtlas<Metadata>::emplace(crispy::strong_hash const& key, CreateTileDataFn constructValue)
+void TextureAtlas<Metadata>::emplace(crispy::strong_hash const& key,
+                                     CreateTileDataFn constructValue,
+                                     TileSizeClass sizeClass)
 {
     // clang-format off
-    _tileCache->emplace(
+    tileCache(sizeClass).emplace(
         key,
         [&](uint32_t entryIndex) -> TileAttributes<Metadata>
         {
@@ -614,7 +871,8 @@ void TextureAtlas<Metadata>::emplace(crispy::strong_hash const& key, CreateTileD
                 {
                     return { constructValue(location) };
                 },
-                entryIndex
+                entryIndex,
+                sizeClass
             ).value();
         }
     );
@@ -622,9 +880,11 @@ void TextureAtlas<Metadata>::emplace(crispy::strong_hash const& key, CreateTileD
 }
 
 template <typename Metadata>
-void TextureAtlas<Metadata>::remove(crispy::strong_hash key)
+void TextureAtlas<Metadata>::remove(crispy::strong_hash key, TileSizeClass sizeClass)
 {
-    _tileCache->remove(key);
+    if (sizeClass != TileSizeClass::Narrow && !wideTiles(sizeClass).tileCache)
+        return;
+    tileCache(sizeClass).remove(key);
 }
 
 template <typename Metadata>
@@ -632,6 +892,9 @@ void TextureAtlas<Metadata>::reset(AtlasProperties atlasProperties)
 {
     _atlasProperties = atlasProperties;
     _tileCache->clear();
+    for (auto& tiles: _wideTiles)
+        if (tiles.tileCache)
+            tiles.tileCache->clear();
 }
 
 template <typename Metadata>
@@ -641,10 +904,18 @@ TileAttributes<Metadata> const& TextureAtlas<Metadata>::directMapped(uint32_t in
     return _directMapping[index];
 }
 
+template <typename Metadata>
+void TextureAtlas<Metadata>::clearDirectMapping(uint32_t index)
+{
+    Require(index < _directMapping.size());
+    _directMapping[index] = {};
+}
+
 template <typename Metadata>
 void TextureAtlas<Metadata>::setDirectMapping(uint32_t tileIndex, TileCreateData tileCreateData)
 {
     Require(tileIndex < _directMapping.size());
+    Require(tileCreateData.bitmapFormat == _atlasProperties.format);
 
     auto const tileLocation = _tileLocations[tileIndex];
 
@@ -653,6 +924,7 @@ void TextureAtlas<Metadata>::setDirectMapping(uint32_t tileIndex, TileCreateData
     tileUpload.bitmapSize = tileCreateData.bitmapSize;
     tileUpload.bitmapFormat = tileCreateData.bitmapFormat;
     tileUpload.bitmap = std::move(tileCreateData.bitmap);
+    tileUpload.atlasIndex = _atlasProperties.atlasIndex;
     _backend.uploadTile(std::move(tileUpload));
 
     auto instance = TileAttributes<Metadata> {};
@@ -663,16 +935,40 @@ void TextureAtlas<Metadata>::setDirectMapping(uint32_t tileIndex, TileCreateData
     _directMapping[tileIndex] = std::move(instance);
 }
 
+template <typename Metadata>
+auto TextureAtlas<Metadata>::fetchAndClearUsage() noexcept -> Usage
+{
+    auto usage = Usage {};
+    auto const add = [&](TileCache& cache, size_t tileCapacity) {
+        auto const stats = cache.fetchAndClearStats();
+        usage.tileCount += cache.size();
+        usage.tileCapacity += tileCapacity;
+        usage.cache.hits += stats.hits;
+        usage.cache.misses += stats.misses;
+        usage.cache.recycles += stats.recycles;
+    };
+    add(*_tileCache, capacity());
+    for (auto& tiles: _wideTiles)
+        if (tiles.tileCache)
+            add(*tiles.tileCache, tiles.tileLocations.size());
+    return usage;
+}
+
 template <typename Metadata>
 void TextureAtlas<Metadata>::inspect(std::ostream& output) const
 {
     output << std::format("TextureAtlas\n");
     output << std::format("------------------------\n");
-    output << std::format("atlas size     : {}\n", _atlasSize);
+    output << std::format("atlas size     : {} x {} layers\n", _atlasSize, _layerCount);
     output << std::format("tile size      : {}\n", _atlasProperties.tileSize);
     output << std::format("direct mapped  : {}\n", _atlasProperties.directMappingCount);
+    output << std::format("wide tiles     : {}\n", _wideTiles[0].tileLocations.size());
+    output << std::format("extra wide     : {}\n", _wideTiles[1].tileLocations.size());
     output << '\n';
     _tileCache->inspect(output);
+    for (auto const& tiles: _wideTiles)
+        if (tiles.tileCache)
+            tiles.tileCache->inspect(output);
 }
 
 // }}}
@@ -701,7 +997,8 @@ struct std::formatter<vtrasterizer::atlas::TileLocation>: std::formatter<std::st
 {
     auto format(vtrasterizer::atlas::TileLocation value, auto& ctx) const
     {
-        return formatter<std::string>::format(std::format("Tile {}x+{}y", value.x.value, value.y.value), ctx);
+        return formatter<std::string>::format(
+            std::format("Tile {}x+{}y@{}", value.x.value, value.y.value, value.layer.value), ctx);
     }
 };
 
@@ -720,11 +1017,16 @@ struct std::formatter<vtrasterizer::atlas::AtlasProperties>: std::formatter<std:
 {
     auto format(vtrasterizer::atlas::AtlasProperties const& value, auto& ctx) const
     {
-        return formatter<std::string>::format(std::format("tile size {}, format {}, direct-mapped {}",
-                                                          value.tileSize,
-                                                          value.format,
-                                                          value.directMappingCount),
-                                              ctx);
+        return formatter<std::string>::format(
+            std::format("tile size {}, format {}, direct-mapped {}, wide {}, extra wide {}, "
+                        "max layer size {}",
+                        value.tileSize,
+                        value.format,
+                        value.directMappingCount,
+                        value.wideTileCount,
+                        value.extraWideTileCount,
+                        value.maxLayerSize),
+            ctx);
     }
 };
 // }}}
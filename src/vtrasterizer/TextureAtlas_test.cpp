@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/TextureAtlas.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <optional>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using namespace vtrasterizer;
+using namespace vtrasterizer::atlas;
+
+using crispy::strong_hash;
+
+namespace
+{
+
+struct MockBackend: public AtlasBackend
+{
+    ConfigureAtlas configured {};
+    std::vector<UploadTile> uploads;
+
+    void configureAtlas(ConfigureAtlas atlas) override { configured = atlas; }
+    void uploadTile(UploadTile tile) override { uploads.emplace_back(std::move(tile)); }
+    void renderTile(RenderTile /*tile*/) override {}
+};
+
+using Atlas = TextureAtlas<int>;
+
+auto const TileSize = vtbackend::ImageSize { vtbackend::Width(10), vtbackend::Height(20) };
+
+AtlasProperties makeProperties()
+{
+    return AtlasProperties { .format = Format::RGBA,
+                             .tileSize = TileSize,
+                             .hashCount = crispy::strong_hashtable_size { 64 },
+                             .tileCount = crispy::lru_capacity { 60 },
+                             .wideTileCount = 8,
+                             .extraWideTileCount = 4,
+                             .directMappingCount = 0 };
+}
+
+auto createTile(vtbackend::Width width)
+{
+    return [width](TileLocation /*location*/) -> std::optional<Atlas::TileCreateData> {
+        auto const size = vtbackend::ImageSize { width, TileSize.height };
+        return Atlas::TileCreateData { Buffer(size.area() * 4), Format::RGBA, size, 0 };
+    };
+}
+
+} // namespace
+
+TEST_CASE("TextureAtlas.wide_tiles")
+{
+    auto backend = MockBackend {};
+    auto atlas = Atlas(backend, makeProperties());
+
+    REQUIRE(atlas.capacity(TileSizeClass::Wide) >= 8);
+    REQUIRE(atlas.capacity(TileSizeClass::ExtraWide) >= 4);
+    CHECK(atlas.tileSize(TileSizeClass::ExtraWide).width == vtbackend::Width(40));
+
+    auto locations = std::set<std::tuple<uint16_t, uint16_t, uint16_t>> {};
+    auto const emplace = [&](strong_hash const& key, vtbackend::Width width, TileSizeClass sizeClass) {
+        auto const* attributes = atlas.get_or_try_emplace(key, createTile(width), sizeClass);
+        REQUIRE(attributes);
+        auto const location = attributes->location;
+        CHECK(location.x.value % unbox(atlas.tileSize(sizeClass).width) == 0);
+        CHECK(unbox<uint32_t>(atlas.tileSize(sizeClass).width) + location.x.value
+              <= unbox<uint32_t>(atlas.atlasSize().width));
+        CHECK(location.layer.value < atlas.layerCount());
+        CHECK(locations.emplace(location.x.value, location.y.value, location.layer.value).second);
+    };
+
+    for (uint32_t i = 1; i <= 60; ++i)
+        emplace(strong_hash { 0, 0, 1, i }, vtbackend::Width(10), TileSizeClass::Narrow);
+    for (uint32_t i = 1; i <= 8; ++i)
+        emplace(strong_hash { 0, 0, 2, i }, vtbackend::Width(20), TileSizeClass::Wide);
+    for (uint32_t i = 1; i <= 4; ++i)
+        emplace(strong_hash { 0, 0, 4, i }, vtbackend::Width(40), TileSizeClass::ExtraWide);
+
+    // Each size class has a cache of its own.
+    CHECK(atlas.try_get(strong_hash { 0, 0, 2, 1 }, TileSizeClass::Wide));
+    CHECK_FALSE(atlas.try_get(strong_hash { 0, 0, 2, 1 }));
+    CHECK(backend.uploads.size() == 72);
+
+    atlas.reset(makeProperties());
+    CHECK_FALSE(atlas.contains(strong_hash { 0, 0, 2, 1 }, TileSizeClass::Wide));
+}
+
+TEST_CASE("TextureAtlas.wide_tiles_disabled")
+{
+    auto backend = MockBackend {};
+    auto properties = makeProperties();
+    properties.wideTileCount = 0;
+    properties.extraWideTileCount = 0;
+    auto atlas = Atlas(backend, properties);
+
+    CHECK(atlas.capacity(TileSizeClass::Wide) == 0);
+    CHECK(atlas.capacity(TileSizeClass::ExtraWide) == 0);
+    CHECK_FALSE(atlas.contains(strong_hash { 0, 0, 0, 1 }, TileSizeClass::Wide));
+    CHECK_FALSE(atlas.try_get(strong_hash { 0, 0, 0, 1 }, TileSizeClass::Wide));
+}
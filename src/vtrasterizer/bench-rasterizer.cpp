@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// Renders termbench-like workloads through vtrasterizer::Renderer alone, against a render target that
+// merely counts what it is asked to draw, in order to measure the text, background, and decoration
+// renderers without any GPU involved.
+//
+// Usage: bench-rasterizer [--min-seconds N] [--font FAMILY] [--font-size PT]
+//
+// Each frame writes one page of the workload into a MockTerm, whose render buffer is then rendered.
+// Only rendering is timed, and the time spent filling the render buffer is reported separately.
+#include <vtbackend/MockTerm.h>
+#include <vtbackend/primitives.h>
+
+#include <vtrasterizer/Renderer.h>
+
+#include <vtpty/MockPty.h>
+
+#include <crispy/allocations.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::string_view_literals;
+
+#if !defined(CONTOUR_ALLOCATION_ACCOUNTING)
+namespace
+{
+
+std::atomic<size_t> allocationCount = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+} // namespace
+
+// Counts all heap allocations, so that allocations per frame can be reported. Builds accounting
+// allocations per subsystem replace the global operator new already, and are asked instead.
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (void* p = std::malloc(size ? size : 1)) // NOLINT(cppcoreguidelines-no-malloc)
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p); // NOLINT(cppcoreguidelines-no-malloc)
+}
+
+void operator delete(void* p, std::size_t /*size*/) noexcept
+{
+    std::free(p); // NOLINT(cppcoreguidelines-no-malloc)
+}
+#endif
+
+namespace
+{
+
+/// @returns the number of heap allocations made so far.
+size_t allocationsSoFar() noexcept
+{
+#if defined(CONTOUR_ALLOCATION_ACCOUNTING)
+    return static_cast<size_t>(crispy::allocations::total().count);
+#else
+    return allocationCount.load();
+#endif
+}
+
+} // namespace
+
+namespace
+{
+
+namespace atlas = vtrasterizer::atlas;
+
+/// Render target that draws nothing, but counts the commands it receives.
+class CountingRenderTarget final: public vtrasterizer::RenderTarget, public atlas::AtlasBackend
+{
+  public:
+    size_t configuredAtlases = 0;
+    size_t uploadedTiles = 0;
+    size_t uploadedBytes = 0;
+    size_t renderedTiles = 0;
+    size_t renderedRects = 0;
+    size_t executedFrames = 0;
+
+    // AtlasBackend
+    void configureAtlas(atlas::ConfigureAtlas /*atlas*/) override { ++configuredAtlases; }
+    void uploadTile(atlas::UploadTile tile) override
+    {
+        ++uploadedTiles;
+        uploadedBytes += tile.bitmap.size();
+    }
+    void renderTile(atlas::RenderTile /*tile*/) override { ++renderedTiles; }
+
+    // RenderTarget
+    void setRenderSize(ImageSize /*size*/) override {}
+    void setMargin(vtrasterizer::PageMargin /*margin*/) override {}
+    atlas::AtlasBackend& textureScheduler() override { return *this; }
+    void renderRectangle(int /*x*/, int /*y*/, Width, Height, RGBAColor /*color*/) override
+    {
+        ++renderedRects;
+    }
+    void scheduleScreenshot(ScreenshotCallback /*callback*/) override {}
+    void retainContents() override {}
+    // Every frame is rendered in full, just as if its contents differed from the previous one.
+    [[nodiscard]] bool replayContents() override { return false; }
+    void setDamage(vtrasterizer::FrameDamage const& /*damage*/) override {}
+    void execute(std::chrono::steady_clock::time_point /*now*/) override { ++executedFrames; }
+    void clearCache() override {}
+    std::optional<vtrasterizer::AtlasTextureScreenshot> readAtlas() override { return std::nullopt; }
+    void inspect(std::ostream& /*output*/) const override {}
+};
+
+struct Workload
+{
+    std::string name;
+    std::function<std::string(size_t lineNumber)> line; // one line of output, including its line break
+};
+
+std::vector<Workload> workloads()
+{
+    auto result = std::vector<Workload> {};
+
+    result.emplace_back("ASCII", [](size_t i) {
+        return std::format("{:08} The quick brown fox jumps over the lazy dog. 0123456789 ~!@#$%^&*()\r\n",
+                           i);
+    });
+
+    result.emplace_back("CJK", [](size_t i) {
+        return std::format("{:04} 日本語のテキストと漢字、中文字符和한국어 텍스트가 섞인 줄입니다\r\n", i % 10000);
+    });
+
+    result.emplace_back("emoji", [](size_t i) {
+        return std::format("{:04} 😀 🚀 🎉 👍🏽 👨‍👩‍👧 ❤️ 🇩🇪 ✅ 🔥 🐧 ☕ 🌈\r\n", i % 10000);
+    });
+
+    result.emplace_back("ligatures", [](size_t i) {
+        return std::format("{:04} if (a != b && c <= d || e >= f) {{ x => y; p -> q; a === b; }} // <|>\r\n",
+                           i % 10000);
+    });
+
+    result.emplace_back("box drawing", [](size_t i) {
+        return std::format("┌─────┬─────┐ │ {:04} │ ░▒▓█ │ ├─────┼─────┤ ╔══╦══╗ ║▀▄║ └─────┴─────┘\r\n",
+                           i % 10000);
+    });
+
+    result.emplace_back("SGR and decorations", [](size_t i) {
+        return std::format("\033[48;5;{}m\033[38;5;{}m{:04}\033[m \033[4munderline\033[m "
+                           "\033[4:3mcurly\033[m \033[9mstrike\033[m \033[7mreverse\033[m "
+                           "\033[1;3mbold italic\033[m\r\n",
+                           i % 256,
+                           (i / 3) % 256,
+                           i % 10000);
+    });
+
+    return result;
+}
+
+vtrasterizer::FontDescriptions fontDescriptions(std::string const& family, double size)
+{
+    auto const makeFont = [&](text::font_weight weight, text::font_slant slant) {
+        return text::font_description { .familyName = family, .weight = weight, .slant = slant };
+    };
+    return vtrasterizer::FontDescriptions {
+        .size = text::font_size { size },
+        .regular = makeFont(text::font_weight::normal, text::font_slant::normal),
+        .bold = makeFont(text::font_weight::bold, text::font_slant::normal),
+        .italic = makeFont(text::font_weight::normal, text::font_slant::italic),
+        .boldItalic = makeFont(text::font_weight::bold, text::font_slant::italic),
+        .emoji = text::font_description { .familyName = "emoji" },
+        .renderMode = text::render_mode::gray,
+    };
+}
+
+void runWorkload(Workload const& workload, vtrasterizer::FontDescriptions const& fonts, double minSeconds)
+{
+    using clock = std::chrono::steady_clock;
+
+    auto const pageSize = vtbackend::PageSize { vtbackend::LineCount(40), vtbackend::ColumnCount(120) };
+    auto mock = vtbackend::MockTerm<vtpty::MockPty>(pageSize, vtbackend::LineCount(0), 64 * 1024);
+
+    auto target = CountingRenderTarget {};
+    auto renderer = vtrasterizer::Renderer(pageSize,
+                                           fonts,
+                                           mock.terminal.colorPalette(),
+                                           crispy::strong_hashtable_size { 4096 },
+                                           crispy::lru_capacity { 4000 },
+                                           false,
+                                           std::filesystem::path {},
+                                           vtrasterizer::Decorator::DottedUnderline,
+                                           vtrasterizer::Decorator::Underline);
+    renderer.setRenderTarget(target);
+
+    auto frames = size_t { 0 };
+    auto allocations = size_t { 0 };
+    auto renderTime = clock::duration::zero();
+    auto fillTime = std::chrono::nanoseconds::zero();
+    auto hits = size_t { 0 };
+    auto misses = size_t { 0 };
+    auto lineNumber = size_t { 0 };
+    do
+    {
+        auto page = std::string {};
+        for (auto i = 0; i < unbox<int>(pageSize.lines); ++i)
+            page += workload.line(lineNumber++);
+        mock.writeToScreen(page);
+
+        auto const allocationsBefore = allocationsSoFar();
+        auto const start = clock::now();
+        renderer.render(mock.terminal, false);
+        renderTime += clock::now() - start;
+        allocations += allocationsSoFar() - allocationsBefore;
+        fillTime += mock.terminal.renderBufferFillTime();
+
+        auto const usage = renderer.fetchAndClearAtlasUsage();
+        hits += usage.cache.hits;
+        misses += usage.cache.misses;
+        ++frames;
+    } while (std::chrono::duration<double>(renderTime).count() < minSeconds);
+
+    // The render buffer is filled from within Renderer::render(), which is not what is measured here.
+    auto const cellsPerFrame = unbox<size_t>(pageSize.lines) * unbox<size_t>(pageSize.columns);
+    auto const cellCount = static_cast<double>(frames * cellsPerFrame);
+    auto const rasterizerTime = std::chrono::duration<double, std::nano>(renderTime - fillTime).count();
+    auto const lookups = hits + misses;
+    auto const perFrame = [&](size_t count) {
+        return static_cast<double>(count) / static_cast<double>(frames);
+    };
+    auto const hitRate = lookups ? 100.0 * static_cast<double>(hits) / static_cast<double>(lookups) : 100.0;
+    std::cout << std::format("{:<20} {:>8} {:>10.1f} {:>10.1f} {:>8.2f}% {:>10.1f} {:>10.1f} {:>10.1f} "
+                             "{:>10.1f}\n",
+                             workload.name,
+                             frames,
+                             rasterizerTime / cellCount,
+                             static_cast<double>(fillTime.count()) / cellCount,
+                             hitRate,
+                             perFrame(misses),
+                             perFrame(target.uploadedTiles),
+                             perFrame(target.renderedTiles + target.renderedRects),
+                             perFrame(allocations));
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    auto minSeconds = 1.0;
+    auto fontFamily = std::string { "monospace" };
+    auto fontSize = 12.0;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            auto const arg = std::string_view(argv[i]);
+            if (arg == "--min-seconds"sv && i + 1 < argc)
+                minSeconds = std::stod(argv[++i]);
+            else if (arg == "--font"sv && i + 1 < argc)
+                fontFamily = argv[++i];
+            else if (arg == "--font-size"sv && i + 1 < argc)
+                fontSize = std::stod(argv[++i]);
+            else
+            {
+                std::cout << "Usage: " << argv[0] << " [--min-seconds N] [--font FAMILY] [--font-size PT]\n";
+                return arg == "--help"sv || arg == "-h"sv ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        }
+
+        auto const fonts = fontDescriptions(fontFamily, fontSize);
+        std::cout << std::format("{:<20} {:>8} {:>10} {:>10} {:>9} {:>10} {:>10} {:>10} {:>10}\n",
+                                 "Workload",
+                                 "Frames",
+                                 "ns/cell",
+                                 "fill/cell",
+                                 "Hit rate",
+                                 "Misses/f",
+                                 "Uploads/f",
+                                 "Draws/f",
+                                 "Allocs/f");
+        for (auto const& workload: workloads())
+            runWorkload(workload, fonts, minSeconds);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
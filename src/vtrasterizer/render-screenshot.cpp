@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: Apache-2.0
+//
+// Renders VT streams, such as the screenshot.vt files written by contour, to PNG images
+// through vtrasterizer::Renderer alone, onto a SoftwareRenderTarget, without any window or GPU involved.
+//
+// Usage: render-screenshot [--jobs N] [--columns N] [--lines N] [--font FAMILY] [--font-size PT]
+//                          [--output-dir DIR] FILE...
+//
+// Each file is replayed into a terminal of its own, whose page is rendered into FILE.png (or into DIR).
+// Files are rendered by as many threads in parallel, each with a renderer of its own that is reused
+// for all files it renders. All renderers share their shaped and rasterized glyphs, as they use
+// the same fonts.
+#include <vtbackend/MockTerm.h>
+#include <vtbackend/primitives.h>
+
+#include <vtrasterizer/Renderer.h>
+#include <vtrasterizer/SoftwareRenderTarget.h>
+
+#include <vtpty/MockPty.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std::string_view_literals;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+struct Options
+{
+    unsigned jobs = std::max(std::thread::hardware_concurrency(), 1u);
+    vtbackend::PageSize pageSize { vtbackend::LineCount(25), vtbackend::ColumnCount(80) };
+    std::string fontFamily = "monospace";
+    double fontSize = 12.0;
+    std::optional<fs::path> outputDirectory;
+    std::vector<fs::path> inputs;
+};
+
+vtrasterizer::FontDescriptions fontDescriptions(std::string const& family, double size)
+{
+    auto const makeFont = [&](text::font_weight weight, text::font_slant slant) {
+        return text::font_description { .familyName = family, .weight = weight, .slant = slant };
+    };
+    return vtrasterizer::FontDescriptions {
+        .size = text::font_size { size },
+        .regular = makeFont(text::font_weight::normal, text::font_slant::normal),
+        .bold = makeFont(text::font_weight::bold, text::font_slant::normal),
+        .italic = makeFont(text::font_weight::normal, text::font_slant::italic),
+        .boldItalic = makeFont(text::font_weight::bold, text::font_slant::italic),
+        .emoji = text::font_description { .familyName = "emoji" },
+        .renderMode = text::render_mode::gray,
+    };
+}
+
+fs::path outputPathOf(fs::path const& input, Options const& options)
+{
+    auto output = options.outputDirectory ? *options.outputDirectory / input.filename() : input;
+    output.replace_extension(".png");
+    return output;
+}
+
+/// Renders the VT streams of the given files, one after another, with a renderer of its own.
+class ScreenshotRenderer
+{
+  public:
+    explicit ScreenshotRenderer(Options const& options):
+        _options { options },
+        _palette {},
+        _renderer { options.pageSize,
+                    fontDescriptions(options.fontFamily, options.fontSize),
+                    _palette,
+                    crispy::strong_hashtable_size { 4096 },
+                    crispy::lru_capacity { 4000 },
+                    false,
+                    fs::path {},
+                    vtrasterizer::Decorator::DottedUnderline,
+                    vtrasterizer::Decorator::Underline },
+        _target { renderSize() }
+    {
+        _renderer.setRenderTarget(_target);
+    }
+
+    /// @returns an error message if the file could not be rendered.
+    std::optional<std::string> render(fs::path const& input)
+    {
+        auto file = std::ifstream(input, std::ios::binary);
+        if (!file.good())
+            return std::format("Cannot open {}.", input.string());
+        auto const contents = std::string(std::istreambuf_iterator<char>(file), {});
+
+        auto mock =
+            vtbackend::MockTerm<vtpty::MockPty>(_options.pageSize, vtbackend::LineCount(0), 64 * 1024);
+        mock.writeToScreen(contents);
+
+        _target.setClearColor(vtbackend::RGBAColor(mock.terminal.colorPalette().defaultBackground));
+        _renderer.render(mock.terminal, false);
+
+        auto const output = outputPathOf(input, _options);
+        auto const png = vtrasterizer::encodePng(_target.frameBuffer(), _target.size());
+        auto stream = std::ofstream(output, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<char const*>(png.data()), static_cast<std::streamsize>(png.size()));
+        if (!stream.good())
+            return std::format("Cannot write {}.", output.string());
+        return std::nullopt;
+    }
+
+  private:
+    [[nodiscard]] vtbackend::ImageSize renderSize() const noexcept
+    {
+        auto const cellSize = _renderer.cellSize();
+        return vtbackend::ImageSize {
+            vtbackend::Width::cast_from(unbox(cellSize.width) * unbox(_options.pageSize.columns)),
+            vtbackend::Height::cast_from(unbox(cellSize.height) * unbox(_options.pageSize.lines)),
+        };
+    }
+
+    Options const& _options;
+    vtbackend::ColorPalette _palette;
+    vtrasterizer::Renderer _renderer;
+    vtrasterizer::SoftwareRenderTarget _target;
+};
+
+/// @returns the number of files that could not be rendered.
+size_t renderAll(Options const& options)
+{
+    auto nextInput = std::atomic<size_t> { 0 };
+    auto failures = std::atomic<size_t> { 0 };
+    auto outputMutex = std::mutex {};
+
+    auto const work = [&]() {
+        auto renderer = ScreenshotRenderer(options);
+        for (auto i = nextInput++; i < options.inputs.size(); i = nextInput++)
+        {
+            auto const error = renderer.render(options.inputs[i]);
+            auto const lock = std::lock_guard { outputMutex };
+            if (error)
+            {
+                ++failures;
+                std::cerr << *error << '\n';
+            }
+            else
+                std::cout << outputPathOf(options.inputs[i], options).string() << '\n';
+        }
+    };
+
+    auto const threadCount = std::min<size_t>(options.jobs, options.inputs.size());
+    auto threads = std::vector<std::thread> {};
+    threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+        threads.emplace_back(work);
+    for (auto& thread: threads)
+        thread.join();
+
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char const* argv[])
+{
+    auto options = Options {};
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            auto const arg = std::string_view(argv[i]);
+            if (arg == "--jobs"sv && i + 1 < argc)
+                options.jobs = std::max(static_cast<unsigned>(std::stoul(argv[++i])), 1u);
+            else if (arg == "--columns"sv && i + 1 < argc)
+                options.pageSize.columns = vtbackend::ColumnCount(std::stoi(argv[++i]));
+            else if (arg == "--lines"sv && i + 1 < argc)
+                options.pageSize.lines = vtbackend::LineCount(std::stoi(argv[++i]));
+            else if (arg == "--font"sv && i + 1 < argc)
+                options.fontFamily = argv[++i];
+            else if (arg == "--font-size"sv && i + 1 < argc)
+                options.fontSize = std::stod(argv[++i]);
+            else if (arg == "--output-dir"sv && i + 1 < argc)
+                options.outputDirectory = fs::path(argv[++i]);
+            else if (!arg.starts_with('-'))
+                options.inputs.emplace_back(arg);
+            else
+            {
+                std::cout << "Usage: " << argv[0]
+                          << " [--jobs N] [--columns N] [--lines N] [--font FAMILY] [--font-size PT]"
+                             " [--output-dir DIR] FILE...\n";
+                return arg == "--help"sv || arg == "-h"sv ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        }
+
+        if (options.outputDirectory)
+            fs::create_directories(*options.outputDirectory);
+
+        return renderAll(options) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
@@ -17,5 +17,8 @@
 // Render an LCD-subpixel antialiased glyph (advanced algorithm)
 #define FRAGMENT_SELECTOR_GLYPH_LCD 3
 
+// Render a raw BGRA image tile (e.g. Sixel graphics), sampled from the image atlas.
+#define FRAGMENT_SELECTOR_IMAGE_TILE 4
+
 // NOLINTEND(modernize-macro-to-enum)
 // NOLINTEND(cppcoreguidelines-macro-to-enum)
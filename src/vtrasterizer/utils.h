@@ -5,6 +5,7 @@
 
 #include <vtrasterizer/TextureAtlas.h>
 
+#include <crispy/allocations.h>
 #include <crispy/logstore.h>
 
 namespace vtrasterizer
@@ -14,6 +15,9 @@ auto const inline rendererLog =
     logstore::category("vt.renderer", "Logs general information about VT renderer.");
 auto const inline rasterizerLog = logstore::category("vt.rasterizer", "Logs details about text rendering.");
 
+// Allocations made while shaping and rasterizing text.
+auto inline textRendererAllocations = crispy::allocations::counter { "text_renderer" };
+
 std::vector<uint8_t> downsampleRGBA(std::vector<uint8_t> const& bitmap,
                                     vtbackend::ImageSize size,
                                     vtbackend::ImageSize newSize);